@@ -0,0 +1,261 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#pragma once
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_record.h>
+#include <citrusleaf/cf_clock.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "mock_server.h"
+
+//==========================================================
+// Constants
+//
+
+// Latency histogram tracks microsecond values up to 2^40 with 64 sub-buckets per power of
+// two (1.6% precision).
+#define BENCH_HIST_LINEAR 128
+#define BENCH_HIST_SUB 64
+#define BENCH_HIST_SIZE (BENCH_HIST_LINEAR + 34 * BENCH_HIST_SUB)
+
+#define BENCH_BIN "bin"
+#define BENCH_LIST_BIN "list"
+#define BENCH_MAP_BIN "map"
+#define BENCH_INDEX "bench_bin_idx"
+#define BENCH_MOCK_NODES_MAX 64
+
+//==========================================================
+// Types
+//
+
+typedef enum {
+	BENCH_INSERT,
+	BENCH_READ_UPDATE,
+	BENCH_BATCH_READ,
+	BENCH_BATCH_WRITE,
+	BENCH_OPERATE,
+	BENCH_SCAN,
+	BENCH_QUERY
+} bench_workload;
+
+typedef enum {
+	BENCH_SYNC,
+	BENCH_ASYNC,
+	BENCH_PIPELINE
+} bench_mode;
+
+typedef enum {
+	BENCH_DIST_UNIFORM,
+	BENCH_DIST_ZIPF
+} bench_dist;
+
+typedef enum {
+	BENCH_BIN_INTEGER,
+	BENCH_BIN_STRING,
+	BENCH_BIN_BYTES
+} bench_bin_type;
+
+typedef enum {
+	BENCH_OP_READ,
+	BENCH_OP_WRITE,
+	BENCH_OP_BATCH,
+	BENCH_OP_OPERATE,
+	BENCH_OP_SCAN,
+	BENCH_OP_MAX
+} bench_op;
+
+typedef struct {
+	uint64_t counts[BENCH_HIST_SIZE];
+	uint64_t total;
+	uint64_t sum;
+	uint64_t max;
+} bench_histogram;
+
+// Statistics written by one thread (sync) or one event loop (async).
+typedef struct {
+	bench_histogram hist[BENCH_OP_MAX];
+	uint64_t timeouts[BENCH_OP_MAX];
+	uint64_t errors[BENCH_OP_MAX];
+	uint64_t records;
+} bench_slot;
+
+typedef struct {
+	uint64_t n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+	double half_pow_theta;
+} bench_zipf;
+
+typedef struct {
+	uint64_t s[2];
+} bench_random;
+
+typedef struct {
+	// Connection.
+	char host[256];
+	int port;
+	char user[64];
+	char password[64];
+	char ns[32];
+	char set[64];
+
+	// Workload.
+	bench_workload workload;
+	bench_mode mode;
+	uint32_t read_pct;
+	uint32_t batch_size;
+	uint32_t query_range;
+	uint64_t start_key;
+	uint64_t keys;
+	bench_dist dist;
+	bench_zipf zipf;
+	bench_bin_type bin_type;
+	uint32_t size_min;
+	uint32_t size_max;
+
+	// Load.
+	uint32_t threads;
+	uint32_t duration;
+	uint64_t throttle;
+	uint32_t event_loops;
+	uint32_t async_max_commands;
+	uint32_t conns_per_node;
+	uint32_t socket_timeout;
+	uint32_t total_timeout;
+	uint32_t max_retries;
+
+	// Mock cluster.
+	uint32_t mock_nodes;
+	uint32_t mock_latency_us;
+	mock_fault mock_faults[BENCH_MOCK_NODES_MAX];
+
+	// Output.
+	const char* hdr_prefix;
+	bool latency;
+
+	// Run state.
+	aerospike as;
+	bench_slot** slots;
+	uint32_t slots_size;
+	uint32_t inflight;
+	volatile bool running;
+} bench_config;
+
+//==========================================================
+// Functions
+//
+
+void
+bench_histogram_add(bench_histogram* h, uint64_t us);
+
+void
+bench_histogram_merge(bench_histogram* trg, const bench_histogram* src);
+
+void
+bench_histogram_diff(bench_histogram* trg, const bench_histogram* cur, const bench_histogram* prev);
+
+uint64_t
+bench_histogram_percentile(const bench_histogram* h, double pct);
+
+void
+bench_histogram_print_hdr(FILE* fp, const bench_histogram* h);
+
+void
+bench_random_init(bench_random* r, uint64_t seed);
+
+uint64_t
+bench_random_next(bench_random* r);
+
+void
+bench_zipf_init(bench_zipf* z, uint64_t n, double theta);
+
+uint64_t
+bench_key_next(bench_config* cfg, bench_random* r);
+
+uint32_t
+bench_size_next(bench_config* cfg, bench_random* r);
+
+void
+bench_throttle(uint64_t* next_ns, uint64_t interval_ns);
+
+char*
+bench_value_buffer_create(bench_config* cfg);
+
+uint32_t
+bench_record_set(bench_config* cfg, bench_random* r, as_record* rec, char* buf, uint64_t key);
+
+uint32_t
+bench_ops_write(bench_config* cfg, bench_random* r, as_operations* ops, char* buf, uint64_t key,
+	bool copy);
+
+void
+bench_value_done(bench_config* cfg, char* buf, uint32_t size);
+
+void
+bench_ops_operate(as_operations* ops, uint64_t key);
+
+int
+bench_run(bench_config* cfg);
+
+void
+bench_run_sync(bench_config* cfg, uint32_t index);
+
+void
+bench_run_async(bench_config* cfg, uint32_t index);
+
+const char*
+bench_op_name(bench_op op);
+
+//==========================================================
+// Inlines
+//
+
+static inline void
+bench_slot_add(bench_slot* slot, bench_op op, as_status status, uint64_t begin_ns)
+{
+	// Reads of keys that were not inserted still measure a server round trip.
+	if (status == AEROSPIKE_OK || status == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+		bench_histogram_add(&slot->hist[op], (cf_getns() - begin_ns) / 1000);
+	}
+	else if (status == AEROSPIKE_ERR_TIMEOUT) {
+		slot->timeouts[op]++;
+	}
+	else {
+		slot->errors[op]++;
+	}
+}
+
+static inline void
+bench_key_range(bench_config* cfg, uint32_t index, uint32_t n, uint64_t* begin, uint64_t* end)
+{
+	// Split insert key range between n workers.
+	*begin = cfg->start_key + cfg->keys * index / n;
+	*end = cfg->start_key + cfg->keys * (index + 1) / n;
+}
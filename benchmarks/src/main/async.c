@@ -0,0 +1,352 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <stdlib.h>
+#include <time.h>
+
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_query.h>
+#include <aerospike/aerospike_scan.h>
+#include <aerospike/as_atomic.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	bench_config* cfg;
+	bench_slot* slot;
+	bench_random rnd;
+	char* buf;
+	as_pipe_listener pipe;
+} bench_async;
+
+//==========================================================
+// Globals
+//
+
+static bench_config* g_cfg;
+
+//==========================================================
+// Listeners
+//
+
+// Command begin time and operation are packed into the listener user data, so commands
+// do not allocate benchmark state.
+static inline void*
+bench_udata(bench_op op)
+{
+	return (void*)(uintptr_t)((cf_getns() << 3) | op);
+}
+
+static void
+bench_async_done(void* udata, as_status status, as_event_loop* event_loop)
+{
+	uint64_t v = (uint64_t)(uintptr_t)udata;
+	bench_slot_add(g_cfg->slots[event_loop->index], (bench_op)(v & 7), status, v >> 3);
+	as_decr_uint32(&g_cfg->inflight);
+}
+
+static void
+bench_write_listener(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	bench_async_done(udata, err ? err->code : AEROSPIKE_OK, event_loop);
+}
+
+static void
+bench_record_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	bench_async_done(udata, err ? err->code : AEROSPIKE_OK, event_loop);
+}
+
+static void
+bench_batch_listener(as_error* err, as_batch_records* records, void* udata,
+	as_event_loop* event_loop)
+{
+	as_vector* list = &records->list;
+
+	if (list->size > 0) {
+		as_batch_base_record* r = as_vector_get(list, 0);
+
+		if (r->type == AS_BATCH_WRITE) {
+			// Writes share one operations list.
+			as_operations_destroy(((as_batch_write_record*)r)->ops);
+		}
+	}
+	as_batch_records_destroy(records);
+	bench_async_done(udata, err ? err->code : AEROSPIKE_OK, event_loop);
+}
+
+static bool
+bench_scan_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	if (rec) {
+		g_cfg->slots[event_loop->index]->records++;
+		return true;
+	}
+	bench_async_done(udata, err ? err->code : AEROSPIKE_OK, event_loop);
+	return false;
+}
+
+static void
+bench_pipe_listener(void* udata, as_event_loop* event_loop)
+{
+}
+
+//==========================================================
+// Static Functions
+//
+
+static as_status
+bench_async_write(bench_async* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	uint32_t size = bench_record_set(cfg, &b->rnd, &rec, b->buf, k);
+
+	// The command is serialized before the call returns.
+	as_error err;
+	as_status status = aerospike_key_put_async(&cfg->as, &err, NULL, &key, &rec,
+		bench_write_listener, bench_udata(BENCH_OP_WRITE), NULL, b->pipe);
+
+	bench_value_done(cfg, b->buf, size);
+	as_record_destroy(&rec);
+	return status;
+}
+
+static as_status
+bench_async_read(bench_async* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_error err;
+	return aerospike_key_get_async(&cfg->as, &err, NULL, &key, bench_record_listener,
+		bench_udata(BENCH_OP_READ), NULL, b->pipe);
+}
+
+static as_status
+bench_async_batch(bench_async* b, bool write)
+{
+	bench_config* cfg = b->cfg;
+	as_batch_records* records = as_batch_records_create(cfg->batch_size);
+	as_operations* ops = NULL;
+	uint32_t size = 0;
+
+	if (write) {
+		ops = as_operations_new(1);
+		size = bench_ops_write(cfg, &b->rnd, ops, b->buf, bench_random_next(&b->rnd), true);
+	}
+
+	for (uint32_t i = 0; i < cfg->batch_size; i++) {
+		uint64_t k = bench_key_next(cfg, &b->rnd);
+
+		if (write) {
+			as_batch_write_record* r = as_batch_write_reserve(records);
+			as_key_init_int64(&r->key, cfg->ns, cfg->set, (int64_t)k);
+			r->ops = ops;
+		}
+		else {
+			as_batch_read_record* r = as_batch_read_reserve(records);
+			as_key_init_int64(&r->key, cfg->ns, cfg->set, (int64_t)k);
+			r->read_all_bins = true;
+		}
+	}
+
+	as_error err;
+	as_status status = write ?
+		aerospike_batch_write_async(&cfg->as, &err, NULL, records, bench_batch_listener,
+			bench_udata(BENCH_OP_BATCH), NULL) :
+		aerospike_batch_read_async(&cfg->as, &err, NULL, records, bench_batch_listener,
+			bench_udata(BENCH_OP_BATCH), NULL);
+
+	if (write) {
+		bench_value_done(cfg, b->buf, size);
+	}
+
+	if (status != AEROSPIKE_OK) {
+		// Records are not destroyed when the command was not started.
+		as_operations_destroy(ops);
+		as_batch_records_destroy(records);
+	}
+	return status;
+}
+
+static as_status
+bench_async_operate(bench_async* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_operations ops;
+	as_operations_inita(&ops, 3);
+	bench_ops_operate(&ops, k);
+
+	as_error err;
+	as_status status = aerospike_key_operate_async(&cfg->as, &err, NULL, &key, &ops,
+		bench_record_listener, bench_udata(BENCH_OP_OPERATE), NULL, b->pipe);
+
+	as_operations_destroy(&ops);
+	return status;
+}
+
+static as_status
+bench_async_scan(bench_async* b)
+{
+	bench_config* cfg = b->cfg;
+	as_scan scan;
+	as_scan_init(&scan, cfg->ns, cfg->set);
+
+	as_error err;
+	as_status status = aerospike_scan_async(&cfg->as, &err, NULL, &scan, NULL,
+		bench_scan_listener, bench_udata(BENCH_OP_SCAN), NULL);
+
+	as_scan_destroy(&scan);
+	return status;
+}
+
+static as_status
+bench_async_query(bench_async* b)
+{
+	bench_config* cfg = b->cfg;
+	int64_t min = (int64_t)bench_key_next(cfg, &b->rnd);
+
+	as_query query;
+	as_query_init(&query, cfg->ns, cfg->set);
+	as_query_where_inita(&query, 1);
+	as_query_where(&query, BENCH_BIN, as_integer_range(min, min + cfg->query_range - 1));
+
+	as_error err;
+	as_status status = aerospike_query_async(&cfg->as, &err, NULL, &query, bench_scan_listener,
+		bench_udata(BENCH_OP_SCAN), NULL);
+
+	as_query_destroy(&query);
+	return status;
+}
+
+static bench_op
+bench_async_issue(bench_async* b, bench_workload workload, uint64_t k, as_status* status)
+{
+	switch (workload) {
+		default:
+		case BENCH_INSERT:
+			*status = bench_async_write(b, k);
+			return BENCH_OP_WRITE;
+
+		case BENCH_READ_UPDATE:
+			k = bench_key_next(b->cfg, &b->rnd);
+
+			if (bench_random_next(&b->rnd) % 100 < b->cfg->read_pct) {
+				*status = bench_async_read(b, k);
+				return BENCH_OP_READ;
+			}
+			*status = bench_async_write(b, k);
+			return BENCH_OP_WRITE;
+
+		case BENCH_BATCH_READ:
+			*status = bench_async_batch(b, false);
+			return BENCH_OP_BATCH;
+
+		case BENCH_BATCH_WRITE:
+			*status = bench_async_batch(b, true);
+			return BENCH_OP_BATCH;
+
+		case BENCH_OPERATE:
+			*status = bench_async_operate(b, bench_key_next(b->cfg, &b->rnd));
+			return BENCH_OP_OPERATE;
+
+		case BENCH_SCAN:
+			*status = bench_async_scan(b);
+			return BENCH_OP_SCAN;
+
+		case BENCH_QUERY:
+			*status = bench_async_query(b);
+			return BENCH_OP_SCAN;
+	}
+}
+
+//==========================================================
+// Public API
+//
+
+void
+bench_run_async(bench_config* cfg, uint32_t index)
+{
+	g_cfg = cfg;
+
+	// Event loop listeners record into the first event_loops slots.  Commands that fail
+	// before reaching an event loop are recorded in the issuing thread's slot.
+	bench_async b;
+	b.cfg = cfg;
+	b.slot = cfg->slots[cfg->event_loops + index];
+	b.buf = bench_value_buffer_create(cfg);
+	b.pipe = cfg->mode == BENCH_PIPELINE ? bench_pipe_listener : NULL;
+	bench_random_init(&b.rnd, cf_getns() ^ ((uint64_t)index << 32));
+
+	uint64_t interval = cfg->throttle ? cfg->threads * 1000000000ULL / cfg->throttle : 0;
+	uint64_t next = 0;
+	uint64_t k = 0;
+	uint64_t end = UINT64_MAX;
+
+	if (cfg->workload == BENCH_INSERT) {
+		bench_key_range(cfg, index, cfg->threads, &k, &end);
+	}
+
+	struct timespec wait = {0, 50000};
+
+	while (cfg->running && k < end) {
+		bench_throttle(&next, interval);
+
+		// Bound commands in flight across all issuing threads.
+		while (as_load_uint32(&cfg->inflight) >= cfg->async_max_commands) {
+			if (! cfg->running) {
+				free(b.buf);
+				return;
+			}
+			nanosleep(&wait, NULL);
+		}
+
+		as_incr_uint32(&cfg->inflight);
+
+		uint64_t begin = cf_getns();
+		as_status status;
+		bench_op op = bench_async_issue(&b, cfg->workload, k, &status);
+
+		if (status != AEROSPIKE_OK) {
+			bench_slot_add(b.slot, op, status, begin);
+			as_decr_uint32(&cfg->inflight);
+		}
+
+		if (cfg->workload == BENCH_INSERT) {
+			k++;
+		}
+	}
+	free(b.buf);
+}
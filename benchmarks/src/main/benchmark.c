@@ -0,0 +1,419 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <aerospike/aerospike_index.h>
+#include <aerospike/as_atomic.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	bench_config* cfg;
+	uint32_t index;
+} bench_worker;
+
+//==========================================================
+// Constants
+//
+
+static const char* op_names[] = {"read", "write", "batch", "operate", "scan"};
+
+//==========================================================
+// Static Functions
+//
+
+static bool
+bench_connect(bench_config* cfg)
+{
+	as_config config;
+	as_config_init(&config);
+
+	if (! as_config_add_hosts(&config, cfg->host, (uint16_t)cfg->port)) {
+		fprintf(stderr, "Invalid host(s) %s\n", cfg->host);
+		return false;
+	}
+
+	if (cfg->user[0]) {
+		as_config_set_user(&config, cfg->user, cfg->password);
+	}
+
+	if (cfg->conns_per_node) {
+		config.max_conns_per_node = cfg->conns_per_node;
+		config.async_max_conns_per_node = cfg->conns_per_node;
+		config.pipe_max_conns_per_node = cfg->conns_per_node;
+	}
+
+	as_policies* p = &config.policies;
+	as_policy_base* bases[] = {&p->read.base, &p->write.base, &p->operate.base, &p->batch.base,
+		&p->scan.base, &p->query.base};
+
+	for (uint32_t i = 0; i < sizeof(bases) / sizeof(bases[0]); i++) {
+		bases[i]->socket_timeout = cfg->socket_timeout;
+		bases[i]->total_timeout = cfg->total_timeout;
+		bases[i]->max_retries = cfg->max_retries;
+	}
+
+	aerospike_init(&cfg->as, &config);
+
+	as_error err;
+
+	if (aerospike_connect(&cfg->as, &err) != AEROSPIKE_OK) {
+		fprintf(stderr, "Connect failed: %d %s\n", err.code, err.message);
+		aerospike_destroy(&cfg->as);
+		return false;
+	}
+	return true;
+}
+
+static bool
+bench_create_index(bench_config* cfg)
+{
+	as_error err;
+	as_index_task task;
+
+	as_status status = aerospike_index_create(&cfg->as, &err, &task, NULL, cfg->ns, cfg->set,
+		BENCH_BIN, BENCH_INDEX, AS_INDEX_NUMERIC);
+
+	if (status == AEROSPIKE_ERR_INDEX_FOUND) {
+		return true;
+	}
+
+	if (status != AEROSPIKE_OK || aerospike_index_create_wait(&err, &task, 0) != AEROSPIKE_OK) {
+		fprintf(stderr, "Create index failed: %d %s\n", err.code, err.message);
+		return false;
+	}
+	return true;
+}
+
+static void*
+bench_worker_run(void* udata)
+{
+	bench_worker* w = udata;
+
+	if (w->cfg->mode == BENCH_SYNC) {
+		bench_run_sync(w->cfg, w->index);
+	}
+	else {
+		bench_run_async(w->cfg, w->index);
+	}
+	return NULL;
+}
+
+static void
+bench_slots_merge(bench_config* cfg, bench_slot* trg)
+{
+	// Slots are read while workers write them.  Counts may lag by a few commands.
+	memset(trg, 0, sizeof(bench_slot));
+
+	for (uint32_t i = 0; i < cfg->slots_size; i++) {
+		bench_slot* s = cfg->slots[i];
+
+		for (uint32_t op = 0; op < BENCH_OP_MAX; op++) {
+			bench_histogram_merge(&trg->hist[op], &s->hist[op]);
+			trg->timeouts[op] += s->timeouts[op];
+			trg->errors[op] += s->errors[op];
+		}
+		trg->records += s->records;
+	}
+}
+
+static void
+bench_print_latency(const char* label, bench_op op, const bench_histogram* h)
+{
+	printf("  %-8s %-8s p50=%" PRIu64 "us p90=%" PRIu64 "us p99=%" PRIu64 "us p99.9=%" PRIu64
+		"us max=%" PRIu64 "us\n", label, bench_op_name(op), bench_histogram_percentile(h, 50.0),
+		bench_histogram_percentile(h, 90.0), bench_histogram_percentile(h, 99.0),
+		bench_histogram_percentile(h, 99.9), h->max);
+}
+
+static void
+bench_report(bench_config* cfg, const bench_slot* cur, const bench_slot* prev, uint32_t seconds)
+{
+	bench_histogram* diff = malloc(sizeof(bench_histogram));
+	printf("%us:", seconds);
+
+	for (uint32_t op = 0; op < BENCH_OP_MAX; op++) {
+		uint64_t count = cur->hist[op].total + cur->timeouts[op] + cur->errors[op];
+
+		if (count == 0) {
+			continue;
+		}
+		printf(" %s(tps=%" PRIu64 " timeouts=%" PRIu64 " errors=%" PRIu64 ")", bench_op_name(op),
+			cur->hist[op].total - prev->hist[op].total, cur->timeouts[op] - prev->timeouts[op],
+			cur->errors[op] - prev->errors[op]);
+	}
+
+	if (cfg->workload == BENCH_SCAN || cfg->workload == BENCH_QUERY) {
+		printf(" records=%" PRIu64, cur->records - prev->records);
+	}
+	printf("\n");
+
+	if (cfg->latency) {
+		for (uint32_t op = 0; op < BENCH_OP_MAX; op++) {
+			if (cur->hist[op].total == prev->hist[op].total) {
+				continue;
+			}
+			bench_histogram_diff(diff, &cur->hist[op], &prev->hist[op]);
+			bench_print_latency("interval", op, diff);
+		}
+	}
+	fflush(stdout);
+	free(diff);
+}
+
+static double
+bench_cpu_seconds(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+static void
+bench_summary(bench_config* cfg, const bench_slot* total, double seconds, double cpu)
+{
+	printf("Summary (%.1fs):\n", seconds);
+
+	uint64_t count = 0;
+
+	for (uint32_t op = 0; op < BENCH_OP_MAX; op++) {
+		const bench_histogram* h = &total->hist[op];
+		count += h->total + total->timeouts[op] + total->errors[op];
+
+		if (h->total + total->timeouts[op] + total->errors[op] == 0) {
+			continue;
+		}
+		printf("  %-8s count=%" PRIu64 " tps=%.0f timeouts=%" PRIu64 " errors=%" PRIu64 "\n",
+			bench_op_name(op), h->total, h->total / seconds, total->timeouts[op],
+			total->errors[op]);
+		bench_print_latency("total", op, h);
+
+		if (cfg->hdr_prefix) {
+			char path[1024];
+			snprintf(path, sizeof(path), "%s-%s.hgrm", cfg->hdr_prefix, bench_op_name(op));
+			FILE* fp = fopen(path, "w");
+
+			if (! fp) {
+				fprintf(stderr, "Failed to open %s\n", path);
+				continue;
+			}
+			bench_histogram_print_hdr(fp, h);
+			fclose(fp);
+		}
+	}
+
+	// Process CPU time includes mock nodes when they run in this process.
+	printf("  cpu      seconds=%.2f us/op=%.2f\n", cpu, count ? cpu * 1000000.0 / count : 0.0);
+}
+
+//==========================================================
+// Public API
+//
+
+const char*
+bench_op_name(bench_op op)
+{
+	return op < BENCH_OP_MAX ? op_names[op] : "unknown";
+}
+
+int
+bench_run(bench_config* cfg)
+{
+	if (cfg->dist == BENCH_DIST_ZIPF) {
+		bench_zipf_init(&cfg->zipf, cfg->keys, cfg->zipf.theta);
+	}
+
+	// Mock nodes answer from this process, so the run measures client overhead only.
+	mock_cluster* mock = NULL;
+
+	if (cfg->mock_nodes) {
+		mock_config mc;
+		mock_config_init(&mc);
+		mc.n_nodes = cfg->mock_nodes;
+		mc.latency_us = cfg->mock_latency_us;
+		mc.value_size = cfg->bin_type == BENCH_BIN_INTEGER ? 0 : cfg->size_max;
+		as_strncpy(mc.ns, cfg->ns, sizeof(mc.ns));
+
+		mock = mock_cluster_start(&mc);
+
+		if (! mock) {
+			fprintf(stderr, "Start mock nodes failed\n");
+			return -1;
+		}
+		strcpy(cfg->host, "127.0.0.1");
+		cfg->port = mock_cluster_port(mock, 0);
+
+		for (uint32_t i = 0; i < cfg->mock_nodes; i++) {
+			mock_cluster_set_fault(mock, i, &cfg->mock_faults[i]);
+		}
+	}
+
+	if (cfg->mode != BENCH_SYNC && ! as_event_create_loops(cfg->event_loops)) {
+		fprintf(stderr, "Create event loops failed. Build with EVENT_LIB for async mode.\n");
+
+		if (mock) {
+			mock_cluster_stop(mock);
+		}
+		return -1;
+	}
+
+	if (! bench_connect(cfg)) {
+		if (cfg->mode != BENCH_SYNC) {
+			as_event_close_loops();
+		}
+
+		if (mock) {
+			mock_cluster_stop(mock);
+		}
+		return -1;
+	}
+
+	if (cfg->workload == BENCH_QUERY && ! bench_create_index(cfg)) {
+		as_error err;
+		aerospike_close(&cfg->as, &err);
+		aerospike_destroy(&cfg->as);
+
+		if (cfg->mode != BENCH_SYNC) {
+			as_event_close_loops();
+		}
+
+		if (mock) {
+			mock_cluster_stop(mock);
+		}
+		return -1;
+	}
+
+	// Sync workers own one slot each.  Async event loops own one slot each and issuing
+	// threads own one slot each for commands that fail before reaching an event loop.
+	cfg->slots_size = cfg->mode == BENCH_SYNC ? cfg->threads : cfg->event_loops + cfg->threads;
+	cfg->slots = malloc(sizeof(bench_slot*) * cfg->slots_size);
+
+	for (uint32_t i = 0; i < cfg->slots_size; i++) {
+		cfg->slots[i] = calloc(1, sizeof(bench_slot));
+	}
+
+	cfg->inflight = 0;
+	cfg->running = true;
+
+	pthread_t* threads = malloc(sizeof(pthread_t) * cfg->threads);
+	bench_worker* workers = malloc(sizeof(bench_worker) * cfg->threads);
+
+	uint64_t begin = cf_getms();
+	double cpu_begin = bench_cpu_seconds();
+
+	for (uint32_t i = 0; i < cfg->threads; i++) {
+		workers[i].cfg = cfg;
+		workers[i].index = i;
+		pthread_create(&threads[i], NULL, bench_worker_run, &workers[i]);
+	}
+
+	bench_slot* cur = malloc(sizeof(bench_slot));
+	bench_slot* prev = calloc(1, sizeof(bench_slot));
+	uint32_t seconds = 0;
+
+	// Report once per second until the duration expires or an insert workload wrote all
+	// keys.  A zero duration runs until all keys are written or forever.
+	while (true) {
+		struct timespec ts = {1, 0};
+		nanosleep(&ts, NULL);
+		seconds++;
+
+		bench_slots_merge(cfg, cur);
+		bench_report(cfg, cur, prev, seconds);
+
+		bench_slot* tmp = prev;
+		prev = cur;
+		cur = tmp;
+
+		if (cfg->duration && seconds >= cfg->duration) {
+			break;
+		}
+
+		if (cfg->workload == BENCH_INSERT) {
+			uint64_t written = prev->hist[BENCH_OP_WRITE].total +
+				prev->timeouts[BENCH_OP_WRITE] + prev->errors[BENCH_OP_WRITE];
+
+			if (written >= cfg->keys) {
+				break;
+			}
+		}
+	}
+
+	cfg->running = false;
+
+	for (uint32_t i = 0; i < cfg->threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	// Wait for async commands in flight.
+	while (as_load_uint32(&cfg->inflight) > 0) {
+		struct timespec ts = {0, 1000000};
+		nanosleep(&ts, NULL);
+	}
+
+	double elapsed = (cf_getms() - begin) / 1000.0;
+	double cpu = bench_cpu_seconds() - cpu_begin;
+	bench_slots_merge(cfg, cur);
+	bench_summary(cfg, cur, elapsed, cpu);
+
+	uint64_t issued = 0;
+
+	for (uint32_t op = 0; op < BENCH_OP_MAX; op++) {
+		issued += cur->hist[op].total + cur->timeouts[op] + cur->errors[op];
+	}
+
+	free(cur);
+	free(prev);
+	free(workers);
+	free(threads);
+
+	as_error err;
+	aerospike_close(&cfg->as, &err);
+
+	if (cfg->mode != BENCH_SYNC) {
+		as_event_close_loops();
+	}
+	aerospike_destroy(&cfg->as);
+
+	if (mock) {
+		// Batches count one command per node.
+		uint64_t commands = mock_cluster_commands(mock);
+		printf("Mock requests: %" PRIu64 " commands: %" PRIu64 " amplification: %.3f\n",
+			mock_cluster_requests(mock), commands, issued ? (double)commands / issued : 0.0);
+		mock_cluster_stop(mock);
+	}
+
+	for (uint32_t i = 0; i < cfg->slots_size; i++) {
+		free(cfg->slots[i]);
+	}
+	free(cfg->slots);
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Histogram
+//
+
+static inline uint32_t
+bench_histogram_index(uint64_t v)
+{
+	if (v < BENCH_HIST_LINEAR) {
+		return (uint32_t)v;
+	}
+
+	// Keep the top 7 bits of the value.
+	uint32_t msb = 63 - (uint32_t)__builtin_clzll(v);
+	uint32_t shift = msb - 6;
+
+	if (shift > 34) {
+		return BENCH_HIST_SIZE - 1;
+	}
+	return BENCH_HIST_LINEAR + (shift - 1) * BENCH_HIST_SUB + (uint32_t)((v >> shift) - BENCH_HIST_SUB);
+}
+
+static inline uint64_t
+bench_histogram_value(uint32_t index)
+{
+	// Highest value that maps to index.
+	if (index < BENCH_HIST_LINEAR) {
+		return index;
+	}
+
+	uint32_t i = index - BENCH_HIST_LINEAR;
+	uint32_t shift = i / BENCH_HIST_SUB + 1;
+	uint64_t sub = i % BENCH_HIST_SUB + BENCH_HIST_SUB;
+	return ((sub + 1) << shift) - 1;
+}
+
+void
+bench_histogram_add(bench_histogram* h, uint64_t us)
+{
+	h->counts[bench_histogram_index(us)]++;
+	h->total++;
+	h->sum += us;
+
+	if (us > h->max) {
+		h->max = us;
+	}
+}
+
+void
+bench_histogram_merge(bench_histogram* trg, const bench_histogram* src)
+{
+	for (uint32_t i = 0; i < BENCH_HIST_SIZE; i++) {
+		trg->counts[i] += src->counts[i];
+	}
+	trg->total += src->total;
+	trg->sum += src->sum;
+
+	if (src->max > trg->max) {
+		trg->max = src->max;
+	}
+}
+
+void
+bench_histogram_diff(bench_histogram* trg, const bench_histogram* cur, const bench_histogram* prev)
+{
+	trg->max = 0;
+
+	for (uint32_t i = 0; i < BENCH_HIST_SIZE; i++) {
+		trg->counts[i] = cur->counts[i] - prev->counts[i];
+
+		if (trg->counts[i]) {
+			trg->max = bench_histogram_value(i);
+		}
+	}
+	trg->total = cur->total - prev->total;
+	trg->sum = cur->sum - prev->sum;
+}
+
+uint64_t
+bench_histogram_percentile(const bench_histogram* h, double pct)
+{
+	if (h->total == 0) {
+		return 0;
+	}
+
+	uint64_t limit = (uint64_t)ceil(h->total * pct / 100.0);
+	uint64_t count = 0;
+
+	if (limit == 0) {
+		limit = 1;
+	}
+
+	for (uint32_t i = 0; i < BENCH_HIST_SIZE; i++) {
+		count += h->counts[i];
+
+		if (count >= limit) {
+			uint64_t v = bench_histogram_value(i);
+			return v < h->max ? v : h->max;
+		}
+	}
+	return h->max;
+}
+
+void
+bench_histogram_print_hdr(FILE* fp, const bench_histogram* h)
+{
+	// HdrHistogram percentile distribution format (.hgrm), values in microseconds.
+	fprintf(fp, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount",
+		"1/(1-Percentile)");
+
+	uint64_t count = 0;
+	double mean = h->total ? (double)h->sum / h->total : 0.0;
+	double var = 0.0;
+
+	for (uint32_t i = 0; i < BENCH_HIST_SIZE; i++) {
+		if (! h->counts[i]) {
+			continue;
+		}
+
+		count += h->counts[i];
+		uint64_t v = bench_histogram_value(i);
+		double d = (double)v - mean;
+		var += d * d * h->counts[i];
+
+		double p = (double)count / h->total;
+
+		if (p < 1.0) {
+			fprintf(fp, "%12.3f %2.12f %10" PRIu64 " %14.2f\n", (double)v, p, count,
+				1.0 / (1.0 - p));
+		}
+		else {
+			fprintf(fp, "%12.3f %2.12f %10" PRIu64 "\n", (double)h->max, p, count);
+		}
+	}
+
+	double stddev = h->total ? sqrt(var / h->total) : 0.0;
+	fprintf(fp, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean, stddev);
+	fprintf(fp, "#[Max     = %12.3f, Total count    = %12" PRIu64 "]\n", (double)h->max,
+		h->total);
+	fprintf(fp, "#[Buckets = %12u, SubBuckets     = %12u]\n", BENCH_HIST_SIZE, BENCH_HIST_SUB);
+}
@@ -0,0 +1,461 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Constants
+//
+
+static const char short_opts[] = "h:p:U:P:n:s:k:K:w:o:z:d:g:aW:c:T:r:L";
+
+// Long options without a short option.
+#define OPT_PIPELINE 1000
+#define OPT_KEYS_DIST 1001
+#define OPT_CONNS 1002
+#define OPT_HDR 1003
+#define OPT_MOCK 1004
+#define OPT_MOCK_LATENCY 1005
+#define OPT_MOCK_FAULT 1006
+
+static const struct option long_opts[] = {
+	{"hosts",              required_argument, 0, 'h'},
+	{"port",               required_argument, 0, 'p'},
+	{"user",               required_argument, 0, 'U'},
+	{"password",           required_argument, 0, 'P'},
+	{"namespace",          required_argument, 0, 'n'},
+	{"set",                required_argument, 0, 's'},
+	{"keys",               required_argument, 0, 'k'},
+	{"start-key",          required_argument, 0, 'K'},
+	{"workload",           required_argument, 0, 'w'},
+	{"object",             required_argument, 0, 'o'},
+	{"keys-dist",          required_argument, 0, OPT_KEYS_DIST},
+	{"threads",            required_argument, 0, 'z'},
+	{"duration",           required_argument, 0, 'd'},
+	{"throughput",         required_argument, 0, 'g'},
+	{"async",              no_argument,       0, 'a'},
+	{"pipeline",           no_argument,       0, OPT_PIPELINE},
+	{"event-loops",        required_argument, 0, 'W'},
+	{"async-max-commands", required_argument, 0, 'c'},
+	{"conns-per-node",     required_argument, 0, OPT_CONNS},
+	{"timeout",            required_argument, 0, 'T'},
+	{"max-retries",        required_argument, 0, 'r'},
+	{"mock",               required_argument, 0, OPT_MOCK},
+	{"mock-latency",       required_argument, 0, OPT_MOCK_LATENCY},
+	{"mock-fault",         required_argument, 0, OPT_MOCK_FAULT},
+	{"hdr-output",         required_argument, 0, OPT_HDR},
+	{"latency",            no_argument,       0, 'L'},
+	{"help",               no_argument,       0, 'u'},
+	{0, 0, 0, 0}
+};
+
+//==========================================================
+// Static Functions
+//
+
+static void
+usage(const char* program)
+{
+	fprintf(stderr, "Usage: %s [options]\n", program);
+	fprintf(stderr,
+		"  -h, --hosts <host>             Seed host(s). Default: 127.0.0.1\n"
+		"  -p, --port <port>              Default port. Default: 3000\n"
+		"  -U, --user <user>              User name\n"
+		"  -P, --password <password>      Password\n"
+		"  -n, --namespace <ns>           Default: test\n"
+		"  -s, --set <set>                Default: testset\n"
+		"  -k, --keys <count>             Key space size. Default: 100000\n"
+		"  -K, --start-key <key>          First key. Default: 0\n"
+		"  -w, --workload <type>          I | RU,<read pct> | BR,<batch size> | BW,<batch size>\n"
+		"                                 | OP | SCAN | QUERY,<range>. Default: RU,50\n"
+		"  -o, --object <type>            I | S:<size>[-<max>] | B:<size>[-<max>]. Default: I\n"
+		"      --keys-dist <dist>         uniform | zipf[,<theta>]. Default: uniform\n"
+		"  -z, --threads <count>          Sync worker or async issuing threads. Default: 16\n"
+		"  -d, --duration <seconds>       Zero runs until inserts finish or forever. Default: 10\n"
+		"  -g, --throughput <tps>         Total command rate limit. Default: 0 (unlimited)\n"
+		"  -a, --async                    Use async commands\n"
+		"      --pipeline                 Use async pipelined key commands\n"
+		"  -W, --event-loops <count>      Default: 1\n"
+		"  -c, --async-max-commands <n>   Async commands in flight. Default: 200\n"
+		"      --conns-per-node <n>       Max connections per node\n"
+		"  -T, --timeout <ms>             Socket and total timeout. Default: 1000\n"
+		"  -r, --max-retries <n>          Default: 1\n"
+		"      --mock <nodes>             Run against in-process mock nodes instead of a server\n"
+		"      --mock-latency <us>        Mock node response latency. Default: 0\n"
+		"      --mock-fault <node|all>:<fault>=<value>[,...]\n"
+		"                                 Inject mock node faults: delay=<us>, stall=<ms>,\n"
+		"                                 stall-period=<ms>, drop=<rate>, reset=<rate>,\n"
+		"                                 partial=<rate>, partial-delay=<us>. Repeatable\n"
+		"      --hdr-output <prefix>      Write <prefix>-<op>.hgrm latency distributions\n"
+		"  -L, --latency                  Print interval latency percentiles\n");
+}
+
+static bool
+parse_copy(char* trg, size_t size, const char* src, const char* name)
+{
+	if (strlen(src) >= size) {
+		fprintf(stderr, "%s exceeds max length\n", name);
+		return false;
+	}
+	strcpy(trg, src);
+	return true;
+}
+
+static bool
+parse_workload(bench_config* cfg, const char* s)
+{
+	const char* arg = strchr(s, ',');
+	size_t len = arg ? (size_t)(arg - s) : strlen(s);
+
+	if (arg) {
+		arg++;
+	}
+
+	if (len == 1 && s[0] == 'I') {
+		cfg->workload = BENCH_INSERT;
+	}
+	else if (len == 2 && strncmp(s, "RU", 2) == 0) {
+		cfg->workload = BENCH_READ_UPDATE;
+		cfg->read_pct = arg ? (uint32_t)atoi(arg) : 50;
+
+		if (cfg->read_pct > 100) {
+			return false;
+		}
+	}
+	else if (len == 2 && (strncmp(s, "BR", 2) == 0 || strncmp(s, "BW", 2) == 0)) {
+		cfg->workload = s[1] == 'R' ? BENCH_BATCH_READ : BENCH_BATCH_WRITE;
+		cfg->batch_size = arg ? (uint32_t)atoi(arg) : 100;
+
+		if (cfg->batch_size == 0) {
+			return false;
+		}
+	}
+	else if (len == 2 && strncmp(s, "OP", 2) == 0) {
+		cfg->workload = BENCH_OPERATE;
+	}
+	else if (len == 4 && strncmp(s, "SCAN", 4) == 0) {
+		cfg->workload = BENCH_SCAN;
+	}
+	else if (len == 5 && strncmp(s, "QUERY", 5) == 0) {
+		cfg->workload = BENCH_QUERY;
+		cfg->query_range = arg ? (uint32_t)atoi(arg) : 100;
+
+		if (cfg->query_range == 0) {
+			return false;
+		}
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+static bool
+parse_object(bench_config* cfg, const char* s)
+{
+	if (strcmp(s, "I") == 0) {
+		cfg->bin_type = BENCH_BIN_INTEGER;
+		return true;
+	}
+
+	if ((s[0] != 'S' && s[0] != 'B') || s[1] != ':') {
+		return false;
+	}
+
+	cfg->bin_type = s[0] == 'S' ? BENCH_BIN_STRING : BENCH_BIN_BYTES;
+
+	char* end;
+	cfg->size_min = (uint32_t)strtoul(s + 2, &end, 10);
+	cfg->size_max = *end == '-' ? (uint32_t)strtoul(end + 1, NULL, 10) : cfg->size_min;
+	return cfg->size_min > 0 && cfg->size_max >= cfg->size_min;
+}
+
+static bool
+parse_dist(bench_config* cfg, const char* s)
+{
+	if (strcmp(s, "uniform") == 0) {
+		cfg->dist = BENCH_DIST_UNIFORM;
+		return true;
+	}
+
+	if (strncmp(s, "zipf", 4) != 0) {
+		return false;
+	}
+
+	cfg->dist = BENCH_DIST_ZIPF;
+	cfg->zipf.theta = s[4] == ',' ? atof(s + 5) : 0.99;
+	return cfg->zipf.theta > 0.0 && cfg->zipf.theta < 1.0;
+}
+
+static bool
+parse_fault_value(mock_fault* fault, const char* name, size_t len, const char* value)
+{
+	if (len == 5 && strncmp(name, "delay", len) == 0) {
+		fault->delay_us = (uint32_t)atoi(value);
+	}
+	else if (len == 5 && strncmp(name, "stall", len) == 0) {
+		fault->stall_ms = (uint32_t)atoi(value);
+	}
+	else if (len == 12 && strncmp(name, "stall-period", len) == 0) {
+		fault->stall_period_ms = (uint32_t)atoi(value);
+	}
+	else if (len == 4 && strncmp(name, "drop", len) == 0) {
+		fault->drop_rate = atof(value);
+	}
+	else if (len == 5 && strncmp(name, "reset", len) == 0) {
+		fault->reset_rate = atof(value);
+	}
+	else if (len == 7 && strncmp(name, "partial", len) == 0) {
+		fault->partial_rate = atof(value);
+	}
+	else if (len == 13 && strncmp(name, "partial-delay", len) == 0) {
+		fault->partial_delay_us = (uint32_t)atoi(value);
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+static bool
+parse_mock_fault(bench_config* cfg, const char* s)
+{
+	// <node|all>:<name>=<value>[,<name>=<value>...]
+	const char* p = strchr(s, ':');
+
+	if (! p) {
+		return false;
+	}
+
+	uint32_t begin = 0;
+	uint32_t end = BENCH_MOCK_NODES_MAX;
+
+	if (strncmp(s, "all:", 4) != 0) {
+		begin = (uint32_t)atoi(s);
+
+		if (begin >= BENCH_MOCK_NODES_MAX) {
+			return false;
+		}
+		end = begin + 1;
+	}
+
+	mock_fault fault = cfg->mock_faults[begin];
+	p++;
+
+	while (*p) {
+		const char* eq = strchr(p, '=');
+
+		if (! eq) {
+			return false;
+		}
+
+		if (! parse_fault_value(&fault, p, eq - p, eq + 1)) {
+			return false;
+		}
+
+		p = strchr(eq, ',');
+
+		if (! p) {
+			break;
+		}
+		p++;
+	}
+
+	for (uint32_t i = begin; i < end; i++) {
+		cfg->mock_faults[i] = fault;
+	}
+	return true;
+}
+
+static void
+config_defaults(bench_config* cfg)
+{
+	memset(cfg, 0, sizeof(bench_config));
+	strcpy(cfg->host, "127.0.0.1");
+	cfg->port = 3000;
+	strcpy(cfg->ns, "test");
+	strcpy(cfg->set, "testset");
+	cfg->workload = BENCH_READ_UPDATE;
+	cfg->mode = BENCH_SYNC;
+	cfg->read_pct = 50;
+	cfg->keys = 100000;
+	cfg->dist = BENCH_DIST_UNIFORM;
+	cfg->bin_type = BENCH_BIN_INTEGER;
+	cfg->threads = 16;
+	cfg->duration = 10;
+	cfg->event_loops = 1;
+	cfg->async_max_commands = 200;
+	cfg->socket_timeout = 1000;
+	cfg->total_timeout = 1000;
+	cfg->max_retries = 1;
+
+	for (uint32_t i = 0; i < BENCH_MOCK_NODES_MAX; i++) {
+		mock_fault_init(&cfg->mock_faults[i]);
+	}
+}
+
+//==========================================================
+// Main
+//
+
+int
+main(int argc, char* argv[])
+{
+	bench_config cfg;
+	config_defaults(&cfg);
+
+	int c;
+
+	while ((c = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+		bool valid = true;
+
+		switch (c) {
+			case 'h':
+				valid = parse_copy(cfg.host, sizeof(cfg.host), optarg, "host");
+				break;
+
+			case 'p':
+				cfg.port = atoi(optarg);
+				break;
+
+			case 'U':
+				valid = parse_copy(cfg.user, sizeof(cfg.user), optarg, "user");
+				break;
+
+			case 'P':
+				valid = parse_copy(cfg.password, sizeof(cfg.password), optarg, "password");
+				break;
+
+			case 'n':
+				valid = parse_copy(cfg.ns, sizeof(cfg.ns), optarg, "namespace");
+				break;
+
+			case 's':
+				valid = parse_copy(cfg.set, sizeof(cfg.set), optarg, "set");
+				break;
+
+			case 'k':
+				cfg.keys = strtoull(optarg, NULL, 10);
+				valid = cfg.keys > 0;
+				break;
+
+			case 'K':
+				cfg.start_key = strtoull(optarg, NULL, 10);
+				break;
+
+			case 'w':
+				valid = parse_workload(&cfg, optarg);
+				break;
+
+			case 'o':
+				valid = parse_object(&cfg, optarg);
+				break;
+
+			case OPT_KEYS_DIST:
+				valid = parse_dist(&cfg, optarg);
+				break;
+
+			case 'z':
+				cfg.threads = (uint32_t)atoi(optarg);
+				valid = cfg.threads > 0;
+				break;
+
+			case 'd':
+				cfg.duration = (uint32_t)atoi(optarg);
+				break;
+
+			case 'g':
+				cfg.throttle = strtoull(optarg, NULL, 10);
+				break;
+
+			case 'a':
+				cfg.mode = BENCH_ASYNC;
+				break;
+
+			case OPT_PIPELINE:
+				cfg.mode = BENCH_PIPELINE;
+				break;
+
+			case 'W':
+				cfg.event_loops = (uint32_t)atoi(optarg);
+				valid = cfg.event_loops > 0;
+				break;
+
+			case 'c':
+				cfg.async_max_commands = (uint32_t)atoi(optarg);
+				valid = cfg.async_max_commands > 0;
+				break;
+
+			case OPT_CONNS:
+				cfg.conns_per_node = (uint32_t)atoi(optarg);
+				break;
+
+			case 'T':
+				cfg.socket_timeout = (uint32_t)atoi(optarg);
+				cfg.total_timeout = cfg.socket_timeout;
+				break;
+
+			case 'r':
+				cfg.max_retries = (uint32_t)atoi(optarg);
+				break;
+
+			case OPT_MOCK:
+				cfg.mock_nodes = (uint32_t)atoi(optarg);
+				valid = cfg.mock_nodes <= BENCH_MOCK_NODES_MAX;
+				break;
+
+			case OPT_MOCK_LATENCY:
+				cfg.mock_latency_us = (uint32_t)atoi(optarg);
+				break;
+
+			case OPT_MOCK_FAULT:
+				valid = parse_mock_fault(&cfg, optarg);
+				break;
+
+			case OPT_HDR:
+				cfg.hdr_prefix = optarg;
+				break;
+
+			case 'L':
+				cfg.latency = true;
+				break;
+
+			default:
+				usage(argv[0]);
+				return c == 'u' ? 0 : -1;
+		}
+
+		if (! valid) {
+			fprintf(stderr, "Invalid option value: %s\n", optarg);
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (cfg.workload == BENCH_INSERT && cfg.keys < cfg.threads) {
+		cfg.threads = (uint32_t)cfg.keys;
+	}
+	return bench_run(&cfg);
+}
@@ -0,0 +1,268 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <stdlib.h>
+
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_query.h>
+#include <aerospike/aerospike_scan.h>
+#include <aerospike/as_atomic.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	bench_config* cfg;
+	bench_slot* slot;
+	bench_random rnd;
+	char* buf;
+	uint64_t records;
+} bench_sync;
+
+//==========================================================
+// Static Functions
+//
+
+static void
+bench_sync_write(bench_sync* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	uint32_t size = bench_record_set(cfg, &b->rnd, &rec, b->buf, k);
+
+	as_error err;
+	uint64_t begin = cf_getns();
+	as_status status = aerospike_key_put(&cfg->as, &err, NULL, &key, &rec);
+	bench_slot_add(b->slot, BENCH_OP_WRITE, status, begin);
+
+	bench_value_done(cfg, b->buf, size);
+	as_record_destroy(&rec);
+}
+
+static void
+bench_sync_read(bench_sync* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_record* rec = NULL;
+	as_error err;
+	uint64_t begin = cf_getns();
+	as_status status = aerospike_key_get(&cfg->as, &err, NULL, &key, &rec);
+	bench_slot_add(b->slot, BENCH_OP_READ, status, begin);
+	as_record_destroy(rec);
+}
+
+static void
+bench_sync_batch(bench_sync* b, bool write)
+{
+	bench_config* cfg = b->cfg;
+	as_batch_records records;
+	as_batch_records_inita(&records, cfg->batch_size);
+
+	// All writes in the batch share one operations list.
+	as_operations ops;
+	uint32_t size = 0;
+
+	if (write) {
+		as_operations_inita(&ops, 1);
+		size = bench_ops_write(cfg, &b->rnd, &ops, b->buf, bench_random_next(&b->rnd),
+			false);
+	}
+
+	for (uint32_t i = 0; i < cfg->batch_size; i++) {
+		uint64_t k = bench_key_next(cfg, &b->rnd);
+
+		if (write) {
+			as_batch_write_record* r = as_batch_write_reserve(&records);
+			as_key_init_int64(&r->key, cfg->ns, cfg->set, (int64_t)k);
+			r->ops = &ops;
+		}
+		else {
+			as_batch_read_record* r = as_batch_read_reserve(&records);
+			as_key_init_int64(&r->key, cfg->ns, cfg->set, (int64_t)k);
+			r->read_all_bins = true;
+		}
+	}
+
+	as_error err;
+	uint64_t begin = cf_getns();
+	as_status status = write ?
+		aerospike_batch_write(&cfg->as, &err, NULL, &records) :
+		aerospike_batch_read(&cfg->as, &err, NULL, &records);
+	bench_slot_add(b->slot, BENCH_OP_BATCH, status, begin);
+
+	as_batch_records_destroy(&records);
+
+	if (write) {
+		bench_value_done(cfg, b->buf, size);
+		as_operations_destroy(&ops);
+	}
+}
+
+static void
+bench_sync_operate(bench_sync* b, uint64_t k)
+{
+	bench_config* cfg = b->cfg;
+	as_key key;
+	as_key_init_int64(&key, cfg->ns, cfg->set, (int64_t)k);
+
+	as_operations ops;
+	as_operations_inita(&ops, 3);
+	bench_ops_operate(&ops, k);
+
+	as_record* rec = NULL;
+	as_error err;
+	uint64_t begin = cf_getns();
+	as_status status = aerospike_key_operate(&cfg->as, &err, NULL, &key, &ops, &rec);
+	bench_slot_add(b->slot, BENCH_OP_OPERATE, status, begin);
+
+	as_record_destroy(rec);
+	as_operations_destroy(&ops);
+}
+
+static bool
+bench_sync_count(const as_val* val, void* udata)
+{
+	if (val) {
+		// Callbacks may run in parallel threads.
+		as_incr_uint64(&((bench_sync*)udata)->records);
+	}
+	return true;
+}
+
+static void
+bench_sync_scan(bench_sync* b)
+{
+	bench_config* cfg = b->cfg;
+	as_scan scan;
+	as_scan_init(&scan, cfg->ns, cfg->set);
+
+	as_error err;
+	b->records = 0;
+	uint64_t begin = cf_getns();
+	as_status status = aerospike_scan_foreach(&cfg->as, &err, NULL, &scan, bench_sync_count, b);
+	bench_slot_add(b->slot, BENCH_OP_SCAN, status, begin);
+	b->slot->records += b->records;
+
+	as_scan_destroy(&scan);
+}
+
+static void
+bench_sync_query(bench_sync* b)
+{
+	bench_config* cfg = b->cfg;
+	int64_t min = (int64_t)bench_key_next(cfg, &b->rnd);
+
+	as_query query;
+	as_query_init(&query, cfg->ns, cfg->set);
+	as_query_where_inita(&query, 1);
+	as_query_where(&query, BENCH_BIN, as_integer_range(min, min + cfg->query_range - 1));
+
+	as_error err;
+	b->records = 0;
+	uint64_t begin = cf_getns();
+	as_status status = aerospike_query_foreach(&cfg->as, &err, NULL, &query, bench_sync_count, b);
+	bench_slot_add(b->slot, BENCH_OP_SCAN, status, begin);
+	b->slot->records += b->records;
+
+	as_query_destroy(&query);
+}
+
+//==========================================================
+// Public API
+//
+
+void
+bench_run_sync(bench_config* cfg, uint32_t index)
+{
+	bench_sync b;
+	b.cfg = cfg;
+	b.slot = cfg->slots[index];
+	b.buf = bench_value_buffer_create(cfg);
+	b.records = 0;
+	bench_random_init(&b.rnd, cf_getns() ^ ((uint64_t)index << 32));
+
+	uint64_t interval = cfg->throttle ? cfg->threads * 1000000000ULL / cfg->throttle : 0;
+	uint64_t next = 0;
+
+	if (cfg->workload == BENCH_INSERT) {
+		uint64_t k;
+		uint64_t end;
+		bench_key_range(cfg, index, cfg->threads, &k, &end);
+
+		while (cfg->running && k < end) {
+			bench_throttle(&next, interval);
+			bench_sync_write(&b, k++);
+		}
+		free(b.buf);
+		return;
+	}
+
+	while (cfg->running) {
+		bench_throttle(&next, interval);
+
+		switch (cfg->workload) {
+			default:
+			case BENCH_READ_UPDATE: {
+				uint64_t k = bench_key_next(cfg, &b.rnd);
+
+				if (bench_random_next(&b.rnd) % 100 < cfg->read_pct) {
+					bench_sync_read(&b, k);
+				}
+				else {
+					bench_sync_write(&b, k);
+				}
+				break;
+			}
+
+			case BENCH_BATCH_READ:
+				bench_sync_batch(&b, false);
+				break;
+
+			case BENCH_BATCH_WRITE:
+				bench_sync_batch(&b, true);
+				break;
+
+			case BENCH_OPERATE:
+				bench_sync_operate(&b, bench_key_next(cfg, &b.rnd));
+				break;
+
+			case BENCH_SCAN:
+				bench_sync_scan(&b);
+				break;
+
+			case BENCH_QUERY:
+				bench_sync_query(&b);
+				break;
+		}
+	}
+	free(b.buf);
+}
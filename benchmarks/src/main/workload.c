@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <aerospike/as_list_operations.h>
+#include <aerospike/as_map_operations.h>
+#include <citrusleaf/cf_clock.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Random
+//
+
+static inline uint64_t
+bench_splitmix(uint64_t* x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void
+bench_random_init(bench_random* r, uint64_t seed)
+{
+	r->s[0] = bench_splitmix(&seed);
+	r->s[1] = bench_splitmix(&seed);
+}
+
+uint64_t
+bench_random_next(bench_random* r)
+{
+	// xorshift128+
+	uint64_t s1 = r->s[0];
+	const uint64_t s0 = r->s[1];
+	r->s[0] = s0;
+	s1 ^= s1 << 23;
+	r->s[1] = s1 ^ s0 ^ (s1 >> 17) ^ (s0 >> 26);
+	return r->s[1] + s0;
+}
+
+static inline double
+bench_random_double(bench_random* r)
+{
+	return (bench_random_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//==========================================================
+// Key and Size Distributions
+//
+
+void
+bench_zipf_init(bench_zipf* z, uint64_t n, double theta)
+{
+	// Gray et al, "Quickly Generating Billion-Record Synthetic Databases".
+	double zetan = 0.0;
+
+	for (uint64_t i = 1; i <= n; i++) {
+		zetan += 1.0 / pow((double)i, theta);
+	}
+
+	double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+
+	z->n = n;
+	z->theta = theta;
+	z->alpha = 1.0 / (1.0 - theta);
+	z->zetan = zetan;
+	z->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+	z->half_pow_theta = 1.0 + pow(0.5, theta);
+}
+
+static uint64_t
+bench_zipf_next(const bench_zipf* z, bench_random* r)
+{
+	double u = bench_random_double(r);
+	double uz = u * z->zetan;
+
+	if (uz < 1.0) {
+		return 0;
+	}
+
+	if (uz < z->half_pow_theta) {
+		return 1;
+	}
+
+	uint64_t v = (uint64_t)(z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+	return v < z->n ? v : z->n - 1;
+}
+
+uint64_t
+bench_key_next(bench_config* cfg, bench_random* r)
+{
+	if (cfg->dist == BENCH_DIST_ZIPF) {
+		return cfg->start_key + bench_zipf_next(&cfg->zipf, r);
+	}
+	return cfg->start_key + bench_random_next(r) % cfg->keys;
+}
+
+uint32_t
+bench_size_next(bench_config* cfg, bench_random* r)
+{
+	if (cfg->size_max <= cfg->size_min) {
+		return cfg->size_min;
+	}
+	return cfg->size_min + (uint32_t)(bench_random_next(r) % (cfg->size_max - cfg->size_min + 1));
+}
+
+//==========================================================
+// Rate Limiting
+//
+
+void
+bench_throttle(uint64_t* next_ns, uint64_t interval_ns)
+{
+	if (interval_ns == 0) {
+		return;
+	}
+
+	uint64_t now = cf_getns();
+
+	if (*next_ns == 0 || now > *next_ns + 1000000000) {
+		// Do not burst more than one second of commands after a stall.
+		*next_ns = now;
+	}
+
+	if (*next_ns > now) {
+		uint64_t wait = *next_ns - now;
+		struct timespec ts = {(time_t)(wait / 1000000000), (long)(wait % 1000000000)};
+		nanosleep(&ts, NULL);
+	}
+	*next_ns += interval_ns;
+}
+
+//==========================================================
+// Values
+//
+
+char*
+bench_value_buffer_create(bench_config* cfg)
+{
+	// String and blob values point into this buffer, so values are not allocated per
+	// command.  String values are terminated in place and restored by bench_value_done().
+	char* buf = malloc(cfg->size_max + 1);
+
+	for (uint32_t i = 0; i <= cfg->size_max; i++) {
+		buf[i] = 'A' + (char)(i % 26);
+	}
+	return buf;
+}
+
+uint32_t
+bench_record_set(bench_config* cfg, bench_random* r, as_record* rec, char* buf, uint64_t key)
+{
+	switch (cfg->bin_type) {
+		default:
+		case BENCH_BIN_INTEGER:
+			as_record_set_int64(rec, BENCH_BIN, (int64_t)key);
+			return 0;
+
+		case BENCH_BIN_STRING: {
+			uint32_t size = bench_size_next(cfg, r);
+			buf[size] = 0;
+			as_record_set_str(rec, BENCH_BIN, buf);
+			return size;
+		}
+
+		case BENCH_BIN_BYTES: {
+			uint32_t size = bench_size_next(cfg, r);
+			as_record_set_raw(rec, BENCH_BIN, (uint8_t*)buf, size);
+			return size;
+		}
+	}
+}
+
+uint32_t
+bench_ops_write(bench_config* cfg, bench_random* r, as_operations* ops, char* buf, uint64_t key,
+	bool copy)
+{
+	// Copy values when the operations outlive the caller's buffer, which is the case for
+	// async batch retries.
+	switch (cfg->bin_type) {
+		default:
+		case BENCH_BIN_INTEGER:
+			as_operations_add_write_int64(ops, BENCH_BIN, (int64_t)key);
+			return 0;
+
+		case BENCH_BIN_STRING: {
+			uint32_t size = bench_size_next(cfg, r);
+			buf[size] = 0;
+
+			if (copy) {
+				as_operations_add_write_strp(ops, BENCH_BIN, strdup(buf), true);
+			}
+			else {
+				as_operations_add_write_str(ops, BENCH_BIN, buf);
+			}
+			return size;
+		}
+
+		case BENCH_BIN_BYTES: {
+			uint32_t size = bench_size_next(cfg, r);
+
+			if (copy) {
+				uint8_t* bytes = malloc(size);
+				memcpy(bytes, buf, size);
+				as_operations_add_write_rawp(ops, BENCH_BIN, bytes, size, true);
+			}
+			else {
+				as_operations_add_write_raw(ops, BENCH_BIN, (uint8_t*)buf, size);
+			}
+			return size;
+		}
+	}
+}
+
+void
+bench_value_done(bench_config* cfg, char* buf, uint32_t size)
+{
+	if (cfg->bin_type == BENCH_BIN_STRING) {
+		buf[size] = 'A' + (char)(size % 26);
+	}
+}
+
+void
+bench_ops_operate(as_operations* ops, uint64_t key)
+{
+	// Append to a list bounded to the last 100 items and increment a map counter.
+	as_integer v;
+	as_integer_init(&v, (int64_t)key);
+	as_operations_list_append(ops, BENCH_LIST_BIN, NULL, NULL, (as_val*)&v);
+	as_operations_list_trim(ops, BENCH_LIST_BIN, NULL, -100, 100);
+
+	// Values are packed and released when the operation is added.
+	as_integer mkey;
+	as_integer_init(&mkey, (int64_t)(key % 16));
+	as_integer one;
+	as_integer_init(&one, 1);
+	as_operations_map_increment(ops, BENCH_MAP_BIN, NULL, NULL, (as_val*)&mkey, (as_val*)&one);
+}
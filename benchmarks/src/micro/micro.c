@@ -0,0 +1,425 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_exp.h>
+#include <aerospike/as_hashmap.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_list_operations.h>
+#include <aerospike/as_map_operations.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_stringmap.h>
+#include <citrusleaf/cf_clock.h>
+
+//==========================================================
+// Allocation Counters
+//
+
+// Count heap allocations by overriding the glibc allocator entry points. Other platforms
+// report ns/op only. Micro benchmarks run in one thread.
+#if defined(__GLIBC__)
+#define MICRO_ALLOC_STATS
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+extern void __libc_free(void* p);
+
+static uint64_t g_allocs; // not atomic by design
+static uint64_t g_alloc_bytes; // not atomic by design
+
+void*
+malloc(size_t size)
+{
+	g_allocs++;
+	g_alloc_bytes += size;
+	return __libc_malloc(size);
+}
+
+void*
+calloc(size_t n, size_t size)
+{
+	g_allocs++;
+	g_alloc_bytes += n * size;
+	return __libc_calloc(n, size);
+}
+
+void*
+realloc(void* p, size_t size)
+{
+	g_allocs++;
+	g_alloc_bytes += size;
+	return __libc_realloc(p, size);
+}
+
+void
+free(void* p)
+{
+	__libc_free(p);
+}
+#else
+static uint64_t g_allocs;
+static uint64_t g_alloc_bytes;
+#endif
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	const char* name;
+	void (*run)(uint64_t i);
+} micro_case;
+
+//==========================================================
+// Fixtures
+//
+
+#define MICRO_BATCH_SIZE 100
+
+size_t
+as_batch_records_serialize(
+	const as_policy_batch* policy, as_vector* records, as_vector* offsets, bool batch_any,
+	uint8_t* buf, size_t capacity, as_error* err
+	);
+
+static as_record g_rec;
+static uint8_t g_buf[1024 * 1024];
+static uint8_t g_bins[4096];
+static char g_str[101];
+static as_batch_records g_batch_read;
+static as_batch_records g_batch_write;
+static as_operations g_batch_ops;
+static as_vector g_offsets;
+static as_policy_batch g_batch_policy;
+
+// Volatile sink keeps the compiler from removing benchmark bodies.
+static volatile uint64_t g_sink;
+
+static void
+micro_setup(void)
+{
+	memset(g_str, 'x', sizeof(g_str) - 1);
+
+	as_arraylist* list = as_arraylist_new(16, 0);
+	as_hashmap* map = as_hashmap_new(16);
+
+	for (int64_t i = 0; i < 16; i++) {
+		as_arraylist_append_int64(list, i * 1000);
+
+		char k[8];
+		sprintf(k, "k%" PRId64, i);
+		as_stringmap_set_int64((as_map*)map, k, i);
+	}
+
+	as_record_init(&g_rec, 4);
+	as_record_set_int64(&g_rec, "int", 123456789);
+	as_record_set_str(&g_rec, "str", g_str);
+	as_record_set_list(&g_rec, "list", (as_list*)list);
+	as_record_set_map(&g_rec, "map", (as_map*)map);
+
+	// Response bins in wire format for the parse benchmark.
+	as_queue buffers;
+	as_queue_init(&buffers, sizeof(as_buffer), 4);
+	uint8_t* p = g_bins;
+
+	for (uint32_t i = 0; i < g_rec.bins.size; i++) {
+		as_command_bin_size(&g_rec.bins.entries[i], &buffers);
+	}
+
+	for (uint32_t i = 0; i < g_rec.bins.size; i++) {
+		p = as_command_write_bin(p, AS_OPERATOR_READ, &g_rec.bins.entries[i], &buffers);
+	}
+	as_queue_destroy(&buffers);
+
+	as_batch_records_init(&g_batch_read, MICRO_BATCH_SIZE);
+	as_batch_records_init(&g_batch_write, MICRO_BATCH_SIZE);
+	as_operations_init(&g_batch_ops, 2);
+	as_operations_add_write_int64(&g_batch_ops, "int", 1);
+	as_operations_add_write_str(&g_batch_ops, "str", g_str);
+	as_vector_init(&g_offsets, sizeof(uint32_t), MICRO_BATCH_SIZE);
+
+	for (uint32_t i = 0; i < MICRO_BATCH_SIZE; i++) {
+		as_batch_read_record* r = as_batch_read_reserve(&g_batch_read);
+		as_key_init_int64(&r->key, "test", "micro", i);
+		r->read_all_bins = true;
+
+		as_batch_write_record* w = as_batch_write_reserve(&g_batch_write);
+		as_key_init_int64(&w->key, "test", "micro", i);
+		w->ops = &g_batch_ops;
+
+		as_vector_append(&g_offsets, &i);
+	}
+	as_policy_batch_init(&g_batch_policy);
+}
+
+static void
+micro_teardown(void)
+{
+	as_batch_records_destroy(&g_batch_read);
+	as_batch_records_destroy(&g_batch_write);
+	as_operations_destroy(&g_batch_ops);
+	as_vector_destroy(&g_offsets);
+	as_record_destroy(&g_rec);
+}
+
+//==========================================================
+// Benchmarks
+//
+
+static void
+bench_value_size_list(uint64_t i)
+{
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), 1);
+	g_sink += as_command_value_size((as_val*)g_rec.bins.entries[2].valuep, &buffers);
+	as_buffers_destroy(&buffers);
+}
+
+static inline void
+bench_write_bin(uint32_t index)
+{
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), 1);
+	as_bin* bin = &g_rec.bins.entries[index];
+	g_sink += as_command_bin_size(bin, &buffers);
+	uint8_t* p = as_command_write_bin(g_buf, AS_OPERATOR_WRITE, bin, &buffers);
+	g_sink += (uint64_t)(p - g_buf);
+	as_queue_destroy(&buffers);
+}
+
+static void
+bench_write_bin_int(uint64_t i)
+{
+	bench_write_bin(0);
+}
+
+static void
+bench_write_bin_str(uint64_t i)
+{
+	bench_write_bin(1);
+}
+
+static void
+bench_write_bin_list(uint64_t i)
+{
+	bench_write_bin(2);
+}
+
+static void
+bench_write_bin_map(uint64_t i)
+{
+	bench_write_bin(3);
+}
+
+static void
+bench_parse_bins(uint64_t i)
+{
+	as_record rec;
+	as_record_inita(&rec, 4);
+
+	as_error err;
+	uint8_t* p = g_bins;
+	as_command_parse_bins(&p, &err, &rec, 4, true, false);
+	g_sink += (uint64_t)(p - g_bins);
+	as_record_destroy(&rec);
+}
+
+static void
+bench_batch_read(uint64_t i)
+{
+	as_error err;
+	g_sink += as_batch_records_serialize(&g_batch_policy, &g_batch_read.list, &g_offsets, true,
+		g_buf, sizeof(g_buf), &err);
+}
+
+static void
+bench_batch_write(uint64_t i)
+{
+	as_error err;
+	g_sink += as_batch_records_serialize(&g_batch_policy, &g_batch_write.list, &g_offsets, true,
+		g_buf, sizeof(g_buf), &err);
+}
+
+static void
+bench_list_ops(uint64_t i)
+{
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+
+	as_integer v;
+	as_integer_init(&v, (int64_t)i);
+	as_operations_list_append(&ops, "list", NULL, NULL, (as_val*)&v);
+	as_operations_list_get_by_index(&ops, "list", NULL, -1, AS_LIST_RETURN_VALUE);
+	g_sink += ops.binops.size;
+	as_operations_destroy(&ops);
+}
+
+static void
+bench_map_ops(uint64_t i)
+{
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+
+	as_string k;
+	as_string_init(&k, "k1", false);
+	as_integer v;
+	as_integer_init(&v, (int64_t)i);
+	as_operations_map_put(&ops, "map", NULL, NULL, (as_val*)&k, (as_val*)&v);
+
+	as_string k2;
+	as_string_init(&k2, "k2", false);
+	as_operations_map_get_by_key(&ops, "map", NULL, (as_val*)&k2, AS_MAP_RETURN_VALUE);
+	g_sink += ops.binops.size;
+	as_operations_destroy(&ops);
+}
+
+static void
+bench_exp_compile(uint64_t i)
+{
+	as_exp_build(exp,
+		as_exp_and(
+			as_exp_cmp_gt(as_exp_bin_int("int"), as_exp_int(100)),
+			as_exp_cmp_eq(as_exp_bin_str("str"), as_exp_str("abc")),
+			as_exp_cmp_lt(as_exp_list_size(NULL, as_exp_bin_list("list")), as_exp_int(10))));
+
+	g_sink += exp->packed_sz;
+	as_exp_destroy(exp);
+}
+
+static void
+bench_digest(uint64_t i)
+{
+	as_key key;
+	as_key_init_int64(&key, "test", "micro", (int64_t)i);
+	g_sink += as_key_digest(&key)->value[0];
+}
+
+static const micro_case micro_cases[] = {
+	{"value_size_list16", bench_value_size_list},
+	{"write_bin_int", bench_write_bin_int},
+	{"write_bin_str100", bench_write_bin_str},
+	{"write_bin_list16", bench_write_bin_list},
+	{"write_bin_map16", bench_write_bin_map},
+	{"parse_bins_4", bench_parse_bins},
+	{"batch_read_100", bench_batch_read},
+	{"batch_write_100", bench_batch_write},
+	{"list_ops_2", bench_list_ops},
+	{"map_ops_2", bench_map_ops},
+	{"exp_compile", bench_exp_compile},
+	{"digest", bench_digest}
+};
+
+//==========================================================
+// Harness
+//
+
+static void
+micro_run(const micro_case* mc, uint64_t min_ns)
+{
+	// Warm up, then double iterations until the run takes at least min_ns.
+	for (uint64_t i = 0; i < 1000; i++) {
+		mc->run(i);
+	}
+
+	uint64_t iterations = 1000;
+	uint64_t elapsed;
+	uint64_t allocs;
+	uint64_t bytes;
+
+	while (true) {
+		uint64_t allocs_begin = g_allocs;
+		uint64_t bytes_begin = g_alloc_bytes;
+		uint64_t begin = cf_getns();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			mc->run(i);
+		}
+
+		elapsed = cf_getns() - begin;
+		allocs = g_allocs - allocs_begin;
+		bytes = g_alloc_bytes - bytes_begin;
+
+		if (elapsed >= min_ns) {
+			break;
+		}
+		iterations *= 2;
+	}
+
+#if defined(MICRO_ALLOC_STATS)
+	printf("%-20s %12" PRIu64 " %10.1f %10.2f %12.1f\n", mc->name, iterations,
+		(double)elapsed / iterations, (double)allocs / iterations, (double)bytes / iterations);
+#else
+	(void)allocs;
+	(void)bytes;
+	printf("%-20s %12" PRIu64 " %10.1f %10s %12s\n", mc->name, iterations,
+		(double)elapsed / iterations, "-", "-");
+#endif
+}
+
+int
+main(int argc, char* argv[])
+{
+	uint64_t min_ms = 200;
+	const char* filter = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "t:f:")) != -1) {
+		switch (c) {
+			case 't':
+				min_ms = strtoull(optarg, NULL, 10);
+				break;
+
+			case 'f':
+				filter = optarg;
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-t <min ms per benchmark>] [-f <name filter>]\n",
+					argv[0]);
+				return -1;
+		}
+	}
+
+	micro_setup();
+
+	printf("%-20s %12s %10s %10s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op",
+		"bytes/op");
+
+	for (uint32_t i = 0; i < sizeof(micro_cases) / sizeof(micro_cases[0]); i++) {
+		if (filter && ! strstr(micro_cases[i].name, filter)) {
+			continue;
+		}
+		micro_run(&micro_cases[i], min_ms * 1000000);
+	}
+
+	micro_teardown();
+	return 0;
+}
@@ -0,0 +1,260 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_conn_pool.h>
+#include <citrusleaf/cf_clock.h>
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	uint32_t threads;
+	uint32_t size;
+	uint32_t duration_ms;
+	uint32_t trim_interval_us;
+} pool_config;
+
+typedef struct {
+	as_conn_pool* pool;
+	uint64_t ops;
+	uint64_t misses;
+	uint64_t max_ns;
+} pool_worker;
+
+typedef struct {
+	as_conn_pool* pool;
+	const pool_config* cfg;
+	uint64_t trims;
+	uint64_t trimmed;
+} pool_tender;
+
+//==========================================================
+// Globals
+//
+
+static uint32_t g_stop;
+
+//==========================================================
+// Static Functions
+//
+
+static void*
+pool_borrow(void* udata)
+{
+	// Borrow the most recently used connection and return it, like a sync command.
+	pool_worker* w = udata;
+	as_socket sock;
+
+	while (! as_load_uint32(&g_stop)) {
+		uint64_t begin = cf_getns();
+
+		if (! as_conn_pool_pop_head(w->pool, &sock)) {
+			// A real command would open a new connection here.
+			w->misses++;
+			continue;
+		}
+
+		sock.last_used = cf_getns();
+		as_conn_pool_push_head(w->pool, &sock);
+
+		uint64_t elapsed = sock.last_used - begin;
+
+		if (elapsed > w->max_ns) {
+			w->max_ns = elapsed;
+		}
+		w->ops++;
+	}
+	return NULL;
+}
+
+static void*
+pool_tend(void* udata)
+{
+	// Trim idle connections and reopen them at the tail, like the tend thread balancing a
+	// pool that is kept at its minimum size.
+	pool_tender* t = udata;
+	as_socket socks[AS_CONN_TRIM_MAX];
+	as_socket sock;
+
+	while (! as_load_uint32(&g_stop)) {
+		uint32_t n = as_conn_pool_trim(t->pool, 0, socks, AS_CONN_TRIM_MAX);
+
+		for (uint32_t i = 0; i < n; i++) {
+			as_conn_pool_push_tail(t->pool, &socks[i]);
+		}
+
+		if (as_conn_pool_pop_tail(t->pool, &sock)) {
+			as_conn_pool_push_tail(t->pool, &sock);
+		}
+
+		t->trims++;
+		t->trimmed += n;
+
+		if (t->cfg->trim_interval_us) {
+			struct timespec ts = {
+				.tv_sec = 0,
+				.tv_nsec = (long)t->cfg->trim_interval_us * 1000
+			};
+			nanosleep(&ts, NULL);
+		}
+	}
+	return NULL;
+}
+
+static void
+pool_run(const pool_config* cfg, bool lock_free)
+{
+	as_conn_pool pool;
+	as_conn_pool_init(&pool, sizeof(as_socket), 0, cfg->size, lock_free);
+
+	as_socket sock;
+
+	for (uint32_t i = 0; i < cfg->size; i++) {
+		memset(&sock, 0, sizeof(as_socket));
+		sock.fd = -1;
+		sock.last_used = cf_getns();
+		as_conn_pool_push_head(&pool, &sock);
+	}
+
+	pool_worker* workers = calloc(cfg->threads, sizeof(pool_worker));
+	pthread_t* threads = calloc(cfg->threads, sizeof(pthread_t));
+	pool_tender tender = {.pool = &pool, .cfg = cfg};
+	pthread_t tend_thread;
+
+	as_store_uint32(&g_stop, 0);
+
+	uint64_t begin = cf_getns();
+
+	for (uint32_t i = 0; i < cfg->threads; i++) {
+		workers[i].pool = &pool;
+		pthread_create(&threads[i], NULL, pool_borrow, &workers[i]);
+	}
+	pthread_create(&tend_thread, NULL, pool_tend, &tender);
+
+	struct timespec ts = {
+		.tv_sec = cfg->duration_ms / 1000,
+		.tv_nsec = (long)(cfg->duration_ms % 1000) * 1000000
+	};
+	nanosleep(&ts, NULL);
+	as_store_uint32(&g_stop, 1);
+
+	uint64_t ops = 0;
+	uint64_t misses = 0;
+	uint64_t max_ns = 0;
+
+	for (uint32_t i = 0; i < cfg->threads; i++) {
+		pthread_join(threads[i], NULL);
+		ops += workers[i].ops;
+		misses += workers[i].misses;
+
+		if (workers[i].max_ns > max_ns) {
+			max_ns = workers[i].max_ns;
+		}
+	}
+	pthread_join(tend_thread, NULL);
+
+	double seconds = (double)(cf_getns() - begin) / 1000000000.0;
+
+	printf("%-10s %8u %14.0f %12" PRIu64 " %10.1f %10" PRIu64 " %10" PRIu64 "\n",
+		lock_free ? "lock-free" : "mutex", cfg->threads, ops / seconds, misses,
+		max_ns / 1000.0, tender.trims, tender.trimmed);
+
+	// Drain placeholder connections so the pool does not close them.
+	while (as_conn_pool_pop_head(&pool, &sock)) {
+	}
+	as_conn_pool_destroy(&pool);
+	free(threads);
+	free(workers);
+}
+
+static void
+usage(const char* program)
+{
+	fprintf(stderr, "Usage: %s [options]\n", program);
+	fprintf(stderr,
+		"  -t <threads>     Borrowing threads. Default: 16\n"
+		"  -s <size>        Connections in pool. Default: 100\n"
+		"  -d <ms>          Duration per pool. Default: 2000\n"
+		"  -i <us>          Tend trim interval in microseconds, 0 to trim continuously.\n"
+		"                   Default: 1000\n");
+}
+
+//==========================================================
+// Main
+//
+
+int
+main(int argc, char* argv[])
+{
+	pool_config cfg = {
+		.threads = 16,
+		.size = 100,
+		.duration_ms = 2000,
+		.trim_interval_us = 1000
+	};
+	int c;
+
+	while ((c = getopt(argc, argv, "t:s:d:i:")) != -1) {
+		switch (c) {
+			case 't':
+				cfg.threads = (uint32_t)atoi(optarg);
+				break;
+
+			case 's':
+				cfg.size = (uint32_t)atoi(optarg);
+				break;
+
+			case 'd':
+				cfg.duration_ms = (uint32_t)atoi(optarg);
+				break;
+
+			case 'i':
+				cfg.trim_interval_us = (uint32_t)atoi(optarg);
+				break;
+
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (cfg.threads == 0 || cfg.size == 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	printf("%-10s %8s %14s %12s %10s %10s %10s\n", "pool", "threads", "ops/sec", "misses",
+		"max us", "trims", "trimmed");
+
+	pool_run(&cfg, false);
+	pool_run(&cfg, true);
+	return 0;
+}
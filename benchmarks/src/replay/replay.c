@@ -0,0 +1,491 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_capture.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_record.h>
+#include <citrusleaf/cf_clock.h>
+
+#include "benchmark.h"
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	aerospike* as;
+	as_capture_entry* entries;
+	uint32_t n_entries;
+	uint32_t next;
+	double speed;
+	const char* ns;
+	uint64_t start_ns;
+	uint8_t* zeros;
+} replay_ctx;
+
+typedef struct {
+	replay_ctx* ctx;
+	pthread_t thread;
+	bench_histogram hist[AS_CAPTURE_TYPE_MAX];
+	uint64_t errors[AS_CAPTURE_TYPE_MAX];
+	uint64_t skipped[AS_CAPTURE_TYPE_MAX];
+	uint64_t late;
+} replay_worker;
+
+//==========================================================
+// Static Data
+//
+
+static const char* replay_type_names[AS_CAPTURE_TYPE_MAX] = {
+	"read", "exists", "write", "delete", "operate", "udf", "batch", "scan", "query", "other"
+};
+
+// Values are not captured, so writes use zeroed payloads of the captured size.
+#define REPLAY_VALUE_MAX (1024 * 1024)
+
+//==========================================================
+// Load
+//
+
+static int
+replay_entry_cmp(const void* a, const void* b)
+{
+	uint64_t x = ((const as_capture_entry*)a)->rec.issue_us;
+	uint64_t y = ((const as_capture_entry*)b)->rec.issue_us;
+	return (x > y) - (x < y);
+}
+
+static bool
+replay_load(const char* path, as_capture_header* header, as_capture_entry** entries,
+	uint32_t* n_entries
+	)
+{
+	FILE* fp = fopen(path, "rb");
+
+	if (! fp) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return false;
+	}
+
+	if (fread(header, sizeof(as_capture_header), 1, fp) != 1 ||
+		memcmp(header->magic, AS_CAPTURE_MAGIC, sizeof(header->magic)) != 0) {
+		fprintf(stderr, "%s is not a capture file\n", path);
+		fclose(fp);
+		return false;
+	}
+
+	uint32_t capacity = 1024;
+	uint32_t n = 0;
+	as_capture_entry* list = malloc(sizeof(as_capture_entry) * capacity);
+	as_capture_entry e;
+
+	while (fread(&e.rec, sizeof(as_capture_record), 1, fp) == 1) {
+		memset(e.ns, 0, sizeof(e.ns));
+		memset(e.set, 0, sizeof(e.set));
+
+		if (e.rec.ns_len >= sizeof(e.ns) || e.rec.set_len >= sizeof(e.set) ||
+			e.rec.n_shapes > AS_CAPTURE_MAX_OPS ||
+			fread(e.ns, e.rec.ns_len, 1, fp) != (e.rec.ns_len ? 1 : 0) ||
+			fread(e.set, e.rec.set_len, 1, fp) != (e.rec.set_len ? 1 : 0) ||
+			fread(e.ops, sizeof(as_capture_op), e.rec.n_shapes, fp) != e.rec.n_shapes) {
+			fprintf(stderr, "Truncated capture record %u ignored\n", n);
+			break;
+		}
+
+		if (n == capacity) {
+			capacity *= 2;
+			list = realloc(list, sizeof(as_capture_entry) * capacity);
+		}
+		list[n++] = e;
+	}
+	fclose(fp);
+
+	// Records are written in completion order.
+	qsort(list, n, sizeof(as_capture_entry), replay_entry_cmp);
+	*entries = list;
+	*n_entries = n;
+	return true;
+}
+
+//==========================================================
+// Replay
+//
+
+static uint32_t
+replay_value_size(const as_capture_op* op)
+{
+	return op->value_size < REPLAY_VALUE_MAX ? op->value_size : REPLAY_VALUE_MAX;
+}
+
+static uint16_t
+replay_build_ops(replay_ctx* ctx, as_capture_entry* e, as_operations* ops)
+{
+	for (uint32_t i = 0; i < e->rec.n_shapes; i++) {
+		as_capture_op* op = &e->ops[i];
+		char name[sizeof(op->name) + 1];
+		memcpy(name, op->name, op->name_len);
+		name[op->name_len] = 0;
+
+		switch (op->op) {
+			case 1:
+				if (op->name_len) {
+					as_operations_add_read(ops, name);
+				}
+				break;
+
+			case 2:
+				if (op->particle_type == AS_BYTES_INTEGER) {
+					as_operations_add_write_int64(ops, name, 0);
+				}
+				else if (op->particle_type == AS_BYTES_DOUBLE) {
+					as_operations_add_write_double(ops, name, 0.0);
+				}
+				else {
+					as_operations_add_write_rawp(ops, name, ctx->zeros, replay_value_size(op),
+						false);
+				}
+				break;
+
+			case 5:
+				as_operations_add_incr(ops, name, 1);
+				break;
+
+			case 9:
+				as_operations_add_append_rawp(ops, name, ctx->zeros, replay_value_size(op), false);
+				break;
+
+			case 10:
+				as_operations_add_prepend_rawp(ops, name, ctx->zeros, replay_value_size(op),
+					false);
+				break;
+
+			case 11:
+				as_operations_add_touch(ops);
+				break;
+
+			default:
+				// CDT, expression, bit and HLL operations need their captured payloads.
+				break;
+		}
+	}
+	return ops->binops.size;
+}
+
+static bool
+replay_issue(replay_ctx* ctx, as_capture_entry* e, as_error* err, as_status* status)
+{
+	as_key key;
+	as_key_init_digest(&key, ctx->ns ? ctx->ns : e->ns, e->set, e->rec.digest);
+
+	as_record* rec = NULL;
+
+	switch (e->rec.type) {
+		case AS_CAPTURE_READ:
+			if (e->rec.n_shapes == 0) {
+				*status = aerospike_key_get(ctx->as, err, NULL, &key, &rec);
+			}
+			else {
+				char names[AS_CAPTURE_MAX_OPS][sizeof(e->ops[0].name) + 1];
+				const char* bins[AS_CAPTURE_MAX_OPS + 1];
+
+				for (uint32_t i = 0; i < e->rec.n_shapes; i++) {
+					memcpy(names[i], e->ops[i].name, e->ops[i].name_len);
+					names[i][e->ops[i].name_len] = 0;
+					bins[i] = names[i];
+				}
+				bins[e->rec.n_shapes] = NULL;
+				*status = aerospike_key_select(ctx->as, err, NULL, &key, bins, &rec);
+			}
+			break;
+
+		case AS_CAPTURE_EXISTS:
+			*status = aerospike_key_exists(ctx->as, err, NULL, &key, &rec);
+			break;
+
+		case AS_CAPTURE_WRITE:
+		case AS_CAPTURE_OPERATE: {
+			as_operations ops;
+			as_operations_inita(&ops, e->rec.n_shapes);
+
+			if (replay_build_ops(ctx, e, &ops) == 0) {
+				as_operations_destroy(&ops);
+				as_key_destroy(&key);
+				return false;
+			}
+			*status = aerospike_key_operate(ctx->as, err, NULL, &key, &ops, &rec);
+			as_operations_destroy(&ops);
+			break;
+		}
+
+		case AS_CAPTURE_DELETE:
+			*status = aerospike_key_remove(ctx->as, err, NULL, &key);
+			break;
+
+		default:
+			as_key_destroy(&key);
+			return false;
+	}
+
+	as_record_destroy(rec);
+	as_key_destroy(&key);
+	return true;
+}
+
+static void*
+replay_worker_run(void* udata)
+{
+	replay_worker* w = udata;
+	replay_ctx* ctx = w->ctx;
+	as_error err;
+
+	while (true) {
+		uint32_t i = as_faa_uint32(&ctx->next, 1);
+
+		if (i >= ctx->n_entries) {
+			break;
+		}
+
+		as_capture_entry* e = &ctx->entries[i];
+		uint32_t type = e->rec.type < AS_CAPTURE_TYPE_MAX ? e->rec.type : AS_CAPTURE_OTHER;
+
+		if (! (e->rec.flags & AS_CAPTURE_FLAGS_DIGEST)) {
+			w->skipped[type]++;
+			continue;
+		}
+
+		// Wait for the scheduled issue time.  Commands that start more than a millisecond
+		// late mean the thread count is too low for the requested speed.
+		uint64_t due_ns = ctx->start_ns + (uint64_t)(e->rec.issue_us * 1000 / ctx->speed);
+		uint64_t now_ns = cf_getns();
+
+		if (due_ns > now_ns) {
+			usleep((useconds_t)((due_ns - now_ns) / 1000));
+		}
+		else if (now_ns - due_ns > 1000 * 1000) {
+			w->late++;
+		}
+
+		uint64_t begin_ns = cf_getns();
+		as_status status = AEROSPIKE_OK;
+
+		if (! replay_issue(ctx, e, &err, &status)) {
+			w->skipped[type]++;
+			continue;
+		}
+
+		bench_histogram_add(&w->hist[type], (cf_getns() - begin_ns) / 1000);
+
+		if (status != AEROSPIKE_OK && status != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+			w->errors[type]++;
+		}
+	}
+	return NULL;
+}
+
+//==========================================================
+// Report
+//
+
+static void
+replay_report(replay_worker* workers, uint32_t n_threads, as_capture_entry* entries,
+	uint32_t n_entries, double elapsed_ms
+	)
+{
+	bench_histogram* replay = calloc(AS_CAPTURE_TYPE_MAX, sizeof(bench_histogram));
+	bench_histogram* captured = calloc(AS_CAPTURE_TYPE_MAX, sizeof(bench_histogram));
+	uint64_t errors[AS_CAPTURE_TYPE_MAX] = {0};
+	uint64_t skipped[AS_CAPTURE_TYPE_MAX] = {0};
+	uint64_t late = 0;
+
+	for (uint32_t i = 0; i < n_entries; i++) {
+		uint32_t type = entries[i].rec.type < AS_CAPTURE_TYPE_MAX ?
+			entries[i].rec.type : AS_CAPTURE_OTHER;
+		bench_histogram_add(&captured[type], entries[i].rec.latency_us);
+	}
+
+	for (uint32_t t = 0; t < n_threads; t++) {
+		for (uint32_t i = 0; i < AS_CAPTURE_TYPE_MAX; i++) {
+			bench_histogram_merge(&replay[i], &workers[t].hist[i]);
+			errors[i] += workers[t].errors[i];
+			skipped[i] += workers[t].skipped[i];
+		}
+		late += workers[t].late;
+	}
+
+	printf("replayed %u commands in %.1f ms, %" PRIu64 " started late\n", n_entries,
+		elapsed_ms, late);
+	printf("%-8s %10s %8s %8s %8s %8s %8s %8s %8s %10s %10s\n", "type", "count", "errors",
+		"skipped", "p50_us", "p90_us", "p99_us", "p999_us", "max_us", "cap_p50_us",
+		"cap_p99_us");
+
+	for (uint32_t i = 0; i < AS_CAPTURE_TYPE_MAX; i++) {
+		if (captured[i].total == 0) {
+			continue;
+		}
+
+		bench_histogram* h = &replay[i];
+		printf("%-8s %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8"
+			PRIu64 " %8" PRIu64 " %8" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+			replay_type_names[i], h->total, errors[i], skipped[i],
+			bench_histogram_percentile(h, 50.0), bench_histogram_percentile(h, 90.0),
+			bench_histogram_percentile(h, 99.0), bench_histogram_percentile(h, 99.9), h->max,
+			bench_histogram_percentile(&captured[i], 50.0),
+			bench_histogram_percentile(&captured[i], 99.0));
+	}
+	free(replay);
+	free(captured);
+}
+
+//==========================================================
+// Main
+//
+
+static void
+usage(const char* program)
+{
+	fprintf(stderr, "Usage: %s -f <file> [options]\n", program);
+	fprintf(stderr,
+		"  -f <file>   Capture file written by aerospike_capture_start()\n"
+		"  -h <host>   Seed host (default 127.0.0.1)\n"
+		"  -p <port>   Seed port (default 3000)\n"
+		"  -x <speed>  Replay speed multiplier (default 1.0)\n"
+		"  -c <n>      Replay threads (default 16)\n"
+		"  -n <ns>     Replay into this namespace instead of the captured one\n");
+}
+
+int
+main(int argc, char* argv[])
+{
+	const char* path = NULL;
+	const char* host = "127.0.0.1";
+	const char* ns = NULL;
+	int port = 3000;
+	double speed = 1.0;
+	uint32_t n_threads = 16;
+	int c;
+
+	while ((c = getopt(argc, argv, "f:h:p:x:c:n:")) != -1) {
+		switch (c) {
+			case 'f':
+				path = optarg;
+				break;
+
+			case 'h':
+				host = optarg;
+				break;
+
+			case 'p':
+				port = atoi(optarg);
+				break;
+
+			case 'x':
+				speed = atof(optarg);
+				break;
+
+			case 'c':
+				n_threads = (uint32_t)atoi(optarg);
+				break;
+
+			case 'n':
+				ns = optarg;
+				break;
+
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (! path || speed <= 0.0 || n_threads == 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	as_capture_header header;
+	as_capture_entry* entries;
+	uint32_t n_entries;
+
+	if (! replay_load(path, &header, &entries, &n_entries)) {
+		return -1;
+	}
+
+	printf("%u commands sampled 1 in %u, replaying at %.2fx with %u threads\n", n_entries,
+		header.sample_rate, speed, n_threads);
+
+	as_config config;
+	as_config_init(&config);
+	as_config_add_host(&config, host, (uint16_t)port);
+
+	aerospike as;
+	aerospike_init(&as, &config);
+
+	as_error err;
+
+	if (aerospike_connect(&as, &err) != AEROSPIKE_OK) {
+		fprintf(stderr, "Connect failed: %d %s\n", err.code, err.message);
+		aerospike_destroy(&as);
+		free(entries);
+		return -1;
+	}
+
+	replay_ctx ctx = {
+		.as = &as,
+		.entries = entries,
+		.n_entries = n_entries,
+		.next = 0,
+		.speed = speed,
+		.ns = ns,
+		.zeros = calloc(1, REPLAY_VALUE_MAX)
+	};
+
+	replay_worker* workers = calloc(n_threads, sizeof(replay_worker));
+	ctx.start_ns = cf_getns();
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		workers[i].ctx = &ctx;
+		pthread_create(&workers[i].thread, NULL, replay_worker_run, &workers[i]);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+
+	double elapsed_ms = (double)(cf_getns() - ctx.start_ns) / 1000000.0;
+	replay_report(workers, n_threads, entries, n_entries, elapsed_ms);
+
+	aerospike_close(&as, &err);
+	aerospike_destroy(&as);
+	free(workers);
+	free(ctx.zeros);
+	free(entries);
+	return 0;
+}
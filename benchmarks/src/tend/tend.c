@@ -0,0 +1,354 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_memory.h>
+#include <aerospike/as_partition.h>
+#include <citrusleaf/cf_clock.h>
+
+#include "mock_server.h"
+
+//==========================================================
+// Types
+//
+
+typedef struct {
+	uint32_t nodes;
+	uint32_t namespaces;
+	uint32_t threads_per_node;
+	uint32_t tends;
+	uint32_t migrate;
+	uint64_t routes;
+} tend_config;
+
+typedef void (*tend_change_fn)(mock_cluster* mock, const tend_config* cfg, uint32_t round);
+
+typedef struct {
+	const char* name;
+	tend_change_fn change;
+} tend_scenario;
+
+//==========================================================
+// Forward Declarations
+//
+
+as_status
+as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings);
+
+//==========================================================
+// Scenarios
+//
+
+static void
+tend_steady(mock_cluster* mock, const tend_config* cfg, uint32_t round)
+{
+	(void)mock;
+	(void)cfg;
+	(void)round;
+}
+
+static void
+tend_migrate(mock_cluster* mock, const tend_config* cfg, uint32_t round)
+{
+	(void)round;
+	mock_cluster_migrate(mock, cfg->migrate);
+}
+
+static void
+tend_churn(mock_cluster* mock, const tend_config* cfg, uint32_t round)
+{
+	// Take one node down, then bring it back on the next round.
+	mock_cluster_set_node_down(mock, (round / 2) % cfg->nodes, round % 2 == 0);
+}
+
+static const tend_scenario tend_scenarios[] = {
+	{"steady", tend_steady},
+	{"migrate", tend_migrate},
+	{"churn", tend_churn},
+};
+
+//==========================================================
+// Static Functions
+//
+
+static double
+tend_cpu_seconds(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+static int
+tend_compare(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static uint32_t
+tend_node_count(as_cluster* cluster)
+{
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t size = nodes->size;
+	as_nodes_release(nodes);
+	return size;
+}
+
+static void
+tend_ns_name(uint32_t index, char* ns, size_t size)
+{
+	// Same names as the mock partition maps.
+	if (index == 0) {
+		snprintf(ns, size, "test");
+	}
+	else {
+		snprintf(ns, size, "test%u", index);
+	}
+}
+
+static void
+tend_route(aerospike* as, const tend_config* cfg, double* ns_per_key, uint64_t* misses)
+{
+	// Keys are spread over all namespaces. Digests are computed up front, so only the
+	// partition table lookup and node selection are measured.
+	const uint32_t n_keys = 4096;
+	as_key* keys = malloc(sizeof(as_key) * n_keys);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		char ns[32];
+		tend_ns_name(i % cfg->namespaces, ns, sizeof(ns));
+		as_key_init_int64(&keys[i], ns, "tend", i);
+		as_key_digest(&keys[i]);
+	}
+
+	as_error err;
+	uint64_t miss = 0;
+	uint64_t begin = cf_getns();
+
+	for (uint64_t i = 0; i < cfg->routes; i++) {
+		as_key* key = &keys[i % n_keys];
+		as_partition_info pi;
+
+		if (as_partition_info_init(&pi, as->cluster, &err, key) != AEROSPIKE_OK) {
+			miss++;
+			continue;
+		}
+
+		as_node* node = as_partition_get_node(as->cluster, pi.ns, pi.partition, NULL,
+			AS_POLICY_REPLICA_SEQUENCE, true);
+
+		if (! node) {
+			miss++;
+		}
+	}
+
+	uint64_t elapsed = cf_getns() - begin;
+	*ns_per_key = cfg->routes ? (double)elapsed / cfg->routes : 0.0;
+	*misses = miss;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_destroy(&keys[i]);
+	}
+	free(keys);
+}
+
+static void
+tend_run(aerospike* as, mock_cluster* mock, const tend_config* cfg, const tend_scenario* s)
+{
+	uint64_t* times = malloc(sizeof(uint64_t) * cfg->tends);
+	uint64_t total = 0;
+	double cpu = 0.0;
+	uint32_t failures = 0;
+
+	for (uint32_t r = 0; r < cfg->tends; r++) {
+		// Topology changes are not measured.
+		s->change(mock, cfg, r);
+
+		as_error err;
+		double cpu_begin = tend_cpu_seconds();
+		uint64_t begin = cf_getns();
+
+		if (as_cluster_tend(as->cluster, &err, false) != AEROSPIKE_OK) {
+			failures++;
+		}
+
+		times[r] = cf_getns() - begin;
+		cpu += tend_cpu_seconds() - cpu_begin;
+		total += times[r];
+	}
+
+	qsort(times, cfg->tends, sizeof(uint64_t), tend_compare);
+
+	as_memory_usage usage[AS_MEMORY_MAX];
+	as_memory_get_usage(usage);
+
+	double route_ns;
+	uint64_t misses;
+	tend_route(as, cfg, &route_ns, &misses);
+
+	printf("%-8s %8.3f %8.3f %8.3f %10.3f %10" PRIu64 " %10" PRIu64 " %6u %8.1f %8" PRIu64
+		" %8u\n", s->name, total / 1e6 / cfg->tends, times[cfg->tends / 2] / 1e6,
+		times[cfg->tends - 1] / 1e6, cpu * 1000.0 / cfg->tends,
+		usage[AS_MEMORY_TEND].current / 1024, usage[AS_MEMORY_TEND].peak / 1024,
+		tend_node_count(as->cluster), route_ns, misses, failures);
+
+	free(times);
+}
+
+static void
+usage(const char* program)
+{
+	fprintf(stderr, "Usage: %s [options]\n", program);
+	fprintf(stderr,
+		"  -n <nodes>       Mock nodes. Default: 100\n"
+		"  -N <namespaces>  Namespaces. Default: 16\n"
+		"  -T <threads>     I/O threads per mock node. Default: 1\n"
+		"  -t <tends>       Tends per scenario. Default: 20\n"
+		"  -m <partitions>  Partitions migrated per tend in the migrate scenario. Default: 256\n"
+		"  -r <routes>      Keys routed after each scenario. Default: 10000000\n"
+		"  -s <scenario>    Run only steady, migrate or churn\n");
+}
+
+//==========================================================
+// Main
+//
+
+int
+main(int argc, char* argv[])
+{
+	tend_config cfg = {
+		.nodes = 100,
+		.namespaces = 16,
+		.threads_per_node = 1,
+		.tends = 20,
+		.migrate = 256,
+		.routes = 10000000
+	};
+	const char* only = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:N:T:t:m:r:s:")) != -1) {
+		switch (c) {
+			case 'n':
+				cfg.nodes = (uint32_t)atoi(optarg);
+				break;
+
+			case 'N':
+				cfg.namespaces = (uint32_t)atoi(optarg);
+				break;
+
+			case 'T':
+				cfg.threads_per_node = (uint32_t)atoi(optarg);
+				break;
+
+			case 't':
+				cfg.tends = (uint32_t)atoi(optarg);
+				break;
+
+			case 'm':
+				cfg.migrate = (uint32_t)atoi(optarg);
+				break;
+
+			case 'r':
+				cfg.routes = strtoull(optarg, NULL, 10);
+				break;
+
+			case 's':
+				only = optarg;
+				break;
+
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (cfg.nodes == 0 || cfg.namespaces == 0 || cfg.threads_per_node == 0 || cfg.tends == 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	mock_config mc;
+	mock_config_init(&mc);
+	mc.n_nodes = cfg.nodes;
+	mc.n_namespaces = cfg.namespaces;
+	mc.threads_per_node = cfg.threads_per_node;
+
+	mock_cluster* mock = mock_cluster_start(&mc);
+
+	if (! mock) {
+		fprintf(stderr, "Start mock nodes failed\n");
+		return -1;
+	}
+
+	// Tends are run from this thread, so the tend thread is kept idle.
+	as_config config;
+	as_config_init(&config);
+	as_config_add_host(&config, "127.0.0.1", mock_cluster_port(mock, 0));
+	config.tender_interval = 3600 * 1000;
+
+	aerospike as;
+	aerospike_init(&as, &config);
+
+	as_error err;
+	uint64_t begin = cf_getns();
+
+	if (aerospike_connect(&as, &err) != AEROSPIKE_OK) {
+		fprintf(stderr, "Connect failed: %d %s\n", err.code, err.message);
+		aerospike_destroy(&as);
+		mock_cluster_stop(mock);
+		return -1;
+	}
+
+	// Discover peers of peers.
+	for (uint32_t i = 0; i < 10 && tend_node_count(as.cluster) < cfg.nodes; i++) {
+		as_cluster_tend(as.cluster, &err, false);
+	}
+
+	printf("%u nodes, %u namespaces: initial tend %.3f ms\n", cfg.nodes, cfg.namespaces,
+		(cf_getns() - begin) / 1e6);
+	printf("%-8s %8s %8s %8s %10s %10s %10s %6s %8s %8s %8s\n", "scenario", "avg_ms", "p50_ms",
+		"max_ms", "cpu_ms", "tend_kb", "peak_kb", "nodes", "route_ns", "misses", "failures");
+
+	for (uint32_t i = 0; i < sizeof(tend_scenarios) / sizeof(tend_scenarios[0]); i++) {
+		if (only && strcmp(only, tend_scenarios[i].name) != 0) {
+			continue;
+		}
+		tend_run(&as, mock, &cfg, &tend_scenarios[i]);
+	}
+
+	aerospike_close(&as, &err);
+	aerospike_destroy(&as);
+	mock_cluster_stop(mock);
+	return 0;
+}
@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * Copyright 2008-2022 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_monitor.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+#include <citrusleaf/cf_clock.h>
+
+#include "example_utils.h"
+
+//==========================================================
+// Constants
+//
+
+#define SUBMIT_THREADS 8
+#define SUBMIT_LOOPS 4
+#define COMMANDS_PER_THREAD 25000
+
+//==========================================================
+// Globals
+//
+
+static aerospike as;
+static as_monitor monitor;
+static uint32_t completed = 0;
+static uint32_t failed = 0;
+static uint64_t submit_end = 0;
+
+//==========================================================
+// Forward Declarations
+//
+
+bool create_event_loops();
+void* submit_worker(void* udata);
+void read_listener(as_error* err, as_record* record, void* udata, as_event_loop* event_loop);
+
+//==========================================================
+// Async Submission Rate Example
+//
+// Measures how fast application threads can hand commands to the event loops.
+// Every command is queued from a thread that is not an event loop thread, so each one
+// crosses the event loop submission queue.
+//
+
+int
+main(int argc, char* argv[])
+{
+	// Parse command line arguments.
+	if (! example_get_opts(argc, argv, EXAMPLE_BASIC_OPTS)) {
+		exit(-1);
+	}
+
+	// Initialize monitor.
+	as_monitor_init(&monitor);
+	as_monitor_begin(&monitor);
+
+	if (! create_event_loops()) {
+		return 0;
+	}
+
+	// Connect to the aerospike database cluster.
+	example_connect_to_aerospike(&as);
+
+	// Start clean and write the record that will be read.
+	example_remove_test_record(&as);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "test-bin", 1);
+
+	as_error err;
+
+	if (aerospike_key_put(&as, &err, NULL, &g_key, &rec) != AEROSPIKE_OK) {
+		LOG("aerospike_key_put() returned %d - %s", err.code, err.message);
+		example_cleanup(&as);
+		as_event_close_loops();
+		exit(-1);
+	}
+
+	pthread_t threads[SUBMIT_THREADS];
+	uint64_t begin = cf_getns();
+
+	for (uint32_t i = 0; i < SUBMIT_THREADS; i++) {
+		pthread_create(&threads[i], NULL, submit_worker, NULL);
+	}
+
+	for (uint32_t i = 0; i < SUBMIT_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	// Wait till commands have completed before shutting down.
+	as_monitor_wait(&monitor);
+
+	uint64_t end = cf_getns();
+	uint32_t total = SUBMIT_THREADS * COMMANDS_PER_THREAD;
+	double submit_secs = (double)(as_load_uint64(&submit_end) - begin) / 1e9;
+	double total_secs = (double)(end - begin) / 1e9;
+
+	LOG("threads=%u event_loops=%u commands=%u failed=%u", SUBMIT_THREADS, SUBMIT_LOOPS,
+		total, as_load_uint32(&failed));
+	LOG("submit rate: %.0f commands/sec", total / submit_secs);
+	LOG("completion rate: %.0f commands/sec", total / total_secs);
+
+	// Cleanup and shutdown.
+	example_remove_test_record(&as);
+	example_cleanup(&as);
+	as_event_close_loops();
+	return 0;
+}
+
+bool
+create_event_loops()
+{
+#if AS_EVENT_LIB_DEFINED
+	as_policy_event p;
+	as_policy_event_init(&p);
+
+	// Limit sockets per event loop.  Commands that can't be executed immediately are placed
+	// on the delay queue, so submissions are not throttled by the server round trip.
+	p.max_commands_in_process = 100;
+
+	as_error err;
+
+	if (as_create_event_loops(&err, &p, SUBMIT_LOOPS, NULL) == AEROSPIKE_OK) {
+		return true;
+	}
+	LOG("Failed to create event loops: %s", err.message);
+	return false;
+#endif
+	LOG("Event library not defined. Skip async example.");
+	return false;
+}
+
+void*
+submit_worker(void* udata)
+{
+	as_error err;
+
+	for (uint32_t i = 0; i < COMMANDS_PER_THREAD; i++) {
+		if (aerospike_key_get_async(&as, &err, NULL, &g_key, read_listener, NULL, NULL,
+				NULL) != AEROSPIKE_OK) {
+			read_listener(&err, NULL, NULL, NULL);
+		}
+	}
+
+	// The last submitter to finish defines the end of the submission phase.
+	uint64_t now = cf_getns();
+	uint64_t prev = as_load_uint64(&submit_end);
+
+	while (now > prev && ! as_cas_uint64(&submit_end, prev, now)) {
+		prev = as_load_uint64(&submit_end);
+	}
+	return NULL;
+}
+
+void
+read_listener(as_error* err, as_record* record, void* udata, as_event_loop* event_loop)
+{
+	if (err) {
+		as_incr_uint32(&failed);
+	}
+
+	// Listeners run on several event loops, so the counter must be atomic.
+	if (as_faa_uint32(&completed, 1) + 1 == SUBMIT_THREADS * COMMANDS_PER_THREAD) {
+		as_monitor_notify(&monitor);
+	}
+}
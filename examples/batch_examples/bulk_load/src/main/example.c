@@ -0,0 +1,173 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_bulk.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+#include "example_utils.h"
+
+//------------------------------------
+// Types
+//------------------------------------
+
+typedef struct source_s {
+	pthread_mutex_t lock;
+	FILE* file;
+	uint32_t next;
+} source;
+
+//------------------------------------
+// Forward Declarations
+//------------------------------------
+
+bool produce_record(uint32_t producer_id, void* udata, as_key* key, as_record* rec);
+
+//------------------------------------
+// Constants
+//------------------------------------
+
+static const char REJECT_FILE[] = "bulk_rejects.txt";
+
+int
+main(int argc, char* argv[])
+{
+	// Parse command line arguments.
+	if (! example_get_opts(argc, argv, EXAMPLE_MULTI_KEY_OPTS)) {
+		exit(-1);
+	}
+
+	// An optional file argument holds one "key,value" line per record. Otherwise g_n_keys
+	// records are generated.
+	source src;
+	pthread_mutex_init(&src.lock, NULL);
+	src.file = NULL;
+	src.next = 0;
+
+	if (optind < argc) {
+		src.file = fopen(argv[optind], "r");
+
+		if (! src.file) {
+			LOG("can't open %s", argv[optind]);
+			exit(-1);
+		}
+	}
+
+	// Connect to the aerospike database cluster.
+	aerospike as;
+	example_connect_to_aerospike(&as);
+
+	// Start clean.
+	example_remove_test_records(&as);
+
+	as_bulk_config config;
+	as_bulk_config_init(&config);
+	config.n_producers = 4;
+	config.reject_path = REJECT_FILE;
+
+	as_error err;
+	as_bulk_stats stats;
+
+	if (aerospike_bulk_load(&as, &err, &config, produce_record, &src, &stats) !=
+			AEROSPIKE_OK) {
+		LOG("aerospike_bulk_load() returned %d - %s", err.code, err.message);
+	}
+	else {
+		LOG("produced %" PRIu64 " written %" PRIu64 " rejected %" PRIu64 " commands %"
+			PRIu64 " throttles %" PRIu64, stats.produced, stats.written, stats.rejected,
+			stats.commands, stats.throttles);
+
+		if (stats.rejected > 0) {
+			LOG("rejected records were appended to %s", REJECT_FILE);
+		}
+	}
+
+	if (src.file) {
+		fclose(src.file);
+	}
+	pthread_mutex_destroy(&src.lock);
+
+	// Cleanup and disconnect from the database cluster.
+	if (! src.file) {
+		example_remove_test_records(&as);
+	}
+	example_cleanup(&as);
+
+	LOG("bulk load example successfully completed");
+
+	return 0;
+}
+
+bool
+produce_record(uint32_t producer_id, void* udata, as_key* key, as_record* rec)
+{
+	source* src = (source*)udata;
+	char line[1024];
+
+	// Only reading the next line is serialized. Parsing runs in parallel.
+	pthread_mutex_lock(&src->lock);
+
+	bool more;
+	uint32_t n = src->next++;
+
+	if (src->file) {
+		more = fgets(line, sizeof(line), src->file) != NULL;
+	}
+	else {
+		more = n < g_n_keys;
+	}
+
+	pthread_mutex_unlock(&src->lock);
+
+	if (! more) {
+		return false;
+	}
+
+	if (! src->file) {
+		as_key_init_int64(key, g_namespace, g_set, (int64_t)n);
+		as_record_init(rec, 2);
+		as_record_set_int64(rec, "test-bin-1", (int64_t)n);
+		as_record_set_int64(rec, "producer", (int64_t)producer_id);
+		return true;
+	}
+
+	line[strcspn(line, "\r\n")] = 0;
+
+	char* value = strchr(line, ',');
+
+	if (value) {
+		*value++ = 0;
+	}
+
+	// The loader owns keys and records, so copy strings from the line buffer.
+	as_key_init_strp(key, g_namespace, g_set, strdup(line), true);
+	as_record_init(rec, 1);
+
+	if (value) {
+		as_record_set_strp(rec, "value", strdup(value), true);
+	}
+	else {
+		as_record_set_nil(rec, "value");
+	}
+	return true;
+}
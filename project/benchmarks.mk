@@ -0,0 +1,90 @@
+###############################################################################
+##  OBJECTS                                                                  ##
+###############################################################################
+
+SOURCE_BENCH = benchmarks/src
+TARGET_BENCH = $(TARGET_BASE)/benchmarks
+
+BENCH_SOURCE = $(wildcard $(SOURCE_BENCH)/main/*.c)
+
+BENCH_OBJECT = $(patsubst $(SOURCE_BENCH)/main/%.c,$(TARGET_BENCH)/%.o,$(BENCH_SOURCE))
+BENCH_OBJECT += $(TARGET_BENCH)/mock_server.o
+
+MICRO_SOURCE = $(wildcard $(SOURCE_BENCH)/micro/*.c)
+
+MICRO_OBJECT = $(patsubst $(SOURCE_BENCH)/micro/%.c,$(TARGET_BENCH)/micro/%.o,$(MICRO_SOURCE))
+
+TEND_SOURCE = $(wildcard $(SOURCE_BENCH)/tend/*.c)
+
+TEND_OBJECT = $(patsubst $(SOURCE_BENCH)/tend/%.c,$(TARGET_BENCH)/tend/%.o,$(TEND_SOURCE))
+TEND_OBJECT += $(TARGET_BENCH)/mock_server.o
+
+REPLAY_SOURCE = $(wildcard $(SOURCE_BENCH)/replay/*.c)
+
+REPLAY_OBJECT = $(patsubst $(SOURCE_BENCH)/replay/%.c,$(TARGET_BENCH)/replay/%.o,$(REPLAY_SOURCE))
+REPLAY_OBJECT += $(TARGET_BENCH)/histogram.o
+
+POOL_SOURCE = $(wildcard $(SOURCE_BENCH)/pool/*.c)
+
+POOL_OBJECT = $(patsubst $(SOURCE_BENCH)/pool/%.c,$(TARGET_BENCH)/pool/%.o,$(POOL_SOURCE))
+
+###############################################################################
+##  FLAGS                                                                    ##
+###############################################################################
+
+BENCH_CFLAGS = -I$(TARGET_INCL) -I$(SOURCE_BENCH)/include -I$(SOURCE_TEST)/util
+
+###############################################################################
+##  TARGETS                                                                  ##
+###############################################################################
+
+.PHONY: benchmarks
+benchmarks: $(TARGET_BENCH)/benchmark $(TARGET_BENCH)/micro/microbench $(TARGET_BENCH)/tend/tendbench $(TARGET_BENCH)/replay/replaybench $(TARGET_BENCH)/pool/poolbench
+
+.PHONY: microbench
+microbench: $(TARGET_BENCH)/micro/microbench
+	$(TARGET_BENCH)/micro/microbench
+
+.PHONY: benchmarks-clean
+benchmarks-clean:
+	@rm -rf $(TARGET_BENCH)
+
+$(TARGET_BENCH)/%.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/%.o: $(SOURCE_BENCH)/main/%.c $(wildcard $(SOURCE_BENCH)/include/*.h) | prepare
+	$(object)
+
+# The mock server is shared with the unit tests.
+$(TARGET_BENCH)/mock_server.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/mock_server.o: $(SOURCE_TEST)/util/mock_server.c $(SOURCE_TEST)/util/mock_server.h | prepare
+	$(object)
+
+$(TARGET_BENCH)/benchmark: $(BENCH_OBJECT) $(TARGET_LIB)/libaerospike.a | build prepare
+	$(executable) $(TEST_LDFLAGS)
+
+$(TARGET_BENCH)/micro/%.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/micro/%.o: $(SOURCE_BENCH)/micro/%.c | prepare
+	$(object)
+
+$(TARGET_BENCH)/micro/microbench: $(MICRO_OBJECT) $(TARGET_LIB)/libaerospike.a | build prepare
+	$(executable) $(TEST_LDFLAGS)
+
+$(TARGET_BENCH)/tend/%.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/tend/%.o: $(SOURCE_BENCH)/tend/%.c $(SOURCE_TEST)/util/mock_server.h | prepare
+	$(object)
+
+$(TARGET_BENCH)/tend/tendbench: $(TEND_OBJECT) $(TARGET_LIB)/libaerospike.a | build prepare
+	$(executable) $(TEST_LDFLAGS)
+
+$(TARGET_BENCH)/replay/%.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/replay/%.o: $(SOURCE_BENCH)/replay/%.c $(wildcard $(SOURCE_BENCH)/include/*.h) | prepare
+	$(object)
+
+$(TARGET_BENCH)/replay/replaybench: $(REPLAY_OBJECT) $(TARGET_LIB)/libaerospike.a | build prepare
+	$(executable) $(TEST_LDFLAGS)
+
+$(TARGET_BENCH)/pool/%.o: CFLAGS = $(BENCH_CFLAGS)
+$(TARGET_BENCH)/pool/%.o: $(SOURCE_BENCH)/pool/%.c | prepare
+	$(object)
+
+$(TARGET_BENCH)/pool/poolbench: $(POOL_OBJECT) $(TARGET_LIB)/libaerospike.a | build prepare
+	$(executable) $(TEST_LDFLAGS)
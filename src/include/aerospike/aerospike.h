@@ -256,6 +256,14 @@ aerospike_new(as_config* config);
 AS_EXTERN void
 aerospike_init_lua(as_config_lua* config);	
 
+/**
+ * @private
+ * Configure lua with the lua config of the first connected cluster if lua has not been
+ * initialized.  Called before client side lua runs.
+ */
+void
+aerospike_init_lua_deferred(void);
+
 /**
  * Destroy the aerospike instance and associated resources.
  *
@@ -397,6 +405,60 @@ aerospike_set_xdr_filter(
 	const char* filter_b64
 	);
 
+/**
+ * Change min_conns_per_node and max_conns_per_node of a connected client.  Sync connection
+ * pools are resized in place by the tend thread in the next cluster tend, so no connection
+ * is dropped while in use.  Idle connections above the new limits are closed and in use
+ * connections above the new limits are closed when they are returned.  Not supported with
+ * lock_free_conn_pools.  With use_shm, the host wide connection limit is not changed.
+ *
+ * @param as 			Aerospike instance.
+ * @param err			If an error occurs, this will be populated.
+ * @param min_conns		New minimum sync connections per node.
+ * @param max_conns		New maximum sync connections per node.
+ *
+ * @returns AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @relates aerospike
+ */
+AS_EXTERN as_status
+aerospike_set_conns_per_node(aerospike* as, as_error* err, uint32_t min_conns, uint32_t max_conns);
+
+/**
+ * Change async_min_conns_per_node and async_max_conns_per_node of a connected client.
+ * Each event loop applies the new limits to its connection pools in the next cluster tend.
+ * Connections above the new limits are closed when they are idle or returned.
+ *
+ * @param as 			Aerospike instance.
+ * @param err			If an error occurs, this will be populated.
+ * @param min_conns		New minimum async connections per node.
+ * @param max_conns		New maximum async connections per node.
+ *
+ * @returns AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @relates aerospike
+ */
+AS_EXTERN as_status
+aerospike_set_async_conns_per_node(
+	aerospike* as, as_error* err, uint32_t min_conns, uint32_t max_conns
+	);
+
+/**
+ * Change thread_pool_size of a connected client.  Threads are added or removed from the
+ * pool in place and queued tasks are not lost.  Not supported with thread_pool_work_stealing
+ * or shared_thread_pool.
+ *
+ * @param as 			Aerospike instance.
+ * @param err			If an error occurs, this will be populated.
+ * @param size			New number of threads.
+ *
+ * @returns AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @relates aerospike
+ */
+AS_EXTERN as_status
+aerospike_set_thread_pool_size(aerospike* as, as_error* err, uint32_t size);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
@@ -26,6 +26,7 @@
 
 #include <aerospike/aerospike.h>
 #include <aerospike/as_batch.h>
+#include <aerospike/as_binding.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_key.h>
@@ -249,6 +250,18 @@ typedef union {
  */
 typedef struct as_batch_records_s {
 	as_vector list;
+
+	/**
+	 * @private
+	 * Arena chunks that hold record bins when as_policy_batch.arena is true.
+	 */
+	struct as_arena_chunk_s* arena;
+
+	/**
+	 * @private
+	 * Was created on heap by as_batch_records_create().
+	 */
+	bool _free;
 } as_batch_records;
 
 /**
@@ -260,6 +273,173 @@ typedef struct as_batch_records_s {
  */
 typedef as_batch_records as_batch_read_records;
 
+/**
+ * Batch records with cached routes and serialized node commands.  Repeated executions skip
+ * digest computation, node mapping and command serialization.  When the partition map
+ * generation changed since the last execution, keys are mapped again and only the commands
+ * of nodes whose key set changed are serialized again.
+ *
+ * Create with aerospike_batch_prepare().  The batch records and policy filter expressions must
+ * not be modified or freed while the prepared batch exists.  Record results are reset on
+ * each execution.
+ *
+ * @ingroup batch_operations
+ */
+typedef struct as_batch_prepared_s {
+	/**
+	 * @private
+	 * Copy of the batch policy.
+	 */
+	as_policy_batch policy;
+
+	/**
+	 * @private
+	 */
+	as_batch_records* records;
+
+	/**
+	 * @private
+	 * Cached commands per node.
+	 */
+	as_vector nodes;
+
+	/**
+	 * @private
+	 * Offsets and status of records that could not be mapped to a node.
+	 */
+	as_vector failed;
+
+	/**
+	 * @private
+	 * Partition map generation of the cached routes.
+	 */
+	uint32_t partition_gen;
+
+	/**
+	 * @private
+	 */
+	as_policy_replica replica_sc;
+
+	/**
+	 * @private
+	 */
+	bool has_write;
+
+	/**
+	 * Nodes whose commands were serialized when the routes were last built.
+	 */
+	uint32_t rebuilt_nodes;
+} as_batch_prepared;
+
+/**
+ * Compact batch of raw digests that share one namespace and set.  Digests are stored
+ * contiguously, so no as_key is created per record.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_batch_digests batch = {
+ *     .ns = "ns",
+ *     .set = "set",
+ *     .digests = digests,
+ *     .n_digests = n
+ * };
+ * ~~~~~~~~~~
+ *
+ * @ingroup batch_operations
+ */
+typedef struct as_batch_digests_s {
+	/**
+	 * Namespace of all digests.
+	 */
+	const char* ns;
+
+	/**
+	 * Set name of all digests.  Use an empty string for the null set.
+	 */
+	const char* set;
+
+	/**
+	 * Array of n_digests contiguous digests.
+	 */
+	const as_digest_value* digests;
+
+	/**
+	 * Number of digests.
+	 */
+	uint32_t n_digests;
+} as_batch_digests;
+
+/**
+ * Result of one digest in a compact batch.  Results are stored in a flat array in the same
+ * order as the batch digests.
+ *
+ * @ingroup batch_operations
+ */
+typedef struct as_batch_digest_result_s {
+	/**
+	 * Record result after batch command has completed.  Use as_batch_digest_results_destroy()
+	 * to release record bins.
+	 */
+	as_record record;
+
+	/**
+	 * Result code for this returned record.
+	 */
+	as_status result;
+} as_batch_digest_result;
+
+/**
+ * Compact results of a batch write or remove.  Each key costs 5 bytes instead of a full
+ * as_batch_result, so the same status can be reused for many large batches.  Arrays are
+ * indexed by key offset in the batch.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_batch_status bs;
+ * as_batch_status_init(&bs, 100000);
+ *
+ * as_status status = aerospike_batch_write_status(as, &err, NULL, NULL, &batch, &ops, &bs);
+ *
+ * for (uint32_t i = 0; i < bs.n_errors; i++) {
+ *     uint32_t offset = bs.errors[i];
+ *     // retry key at offset unless bs.in_doubt[offset]
+ * }
+ * as_batch_status_destroy(&bs);
+ * ~~~~~~~~~~
+ *
+ * @ingroup batch_operations
+ */
+typedef struct as_batch_status_s {
+	/**
+	 * Result code of each key.  Keys that were never sent keep AEROSPIKE_NO_RESPONSE.
+	 */
+	int32_t* results;
+
+	/**
+	 * True if the write of the key may have completed even though an error was returned.
+	 */
+	uint8_t* in_doubt;
+
+	/**
+	 * Offsets of keys whose result is not AEROSPIKE_OK, in ascending order.  Includes keys
+	 * that were not found, which do not cause AEROSPIKE_BATCH_FAILED.
+	 */
+	uint32_t* errors;
+
+	/**
+	 * Number of entries in errors.
+	 */
+	uint32_t n_errors;
+
+	/**
+	 * Number of keys in the last batch.
+	 */
+	uint32_t n_keys;
+
+	/**
+	 * Maximum number of keys.
+	 */
+	uint32_t capacity;
+} as_batch_status;
+
 /**
  * This listener will be called with the results of batch commands for all keys.
  *
@@ -305,6 +485,34 @@ typedef as_batch_listener aerospike_batch_read_callback;
 typedef void (*as_async_batch_listener)(as_error* err, as_batch_records* records, void* udata,
 	as_event_loop* event_loop);
 
+/**
+ * Streaming batch record listener.  This function is called once for each record as soon as
+ * the record's node response is parsed.  The record's bins are destroyed after the listener
+ * returns, so bins must be copied to be used later.  When policy concurrent is true, the
+ * listener may be called from multiple threads at the same time.
+ *
+ * @param record		Batch record with result code and returned bins.
+ * @param index			Index of the record in the batch records list.
+ * @param udata 		User data that is forwarded from the stream function.
+ * @ingroup batch_operations
+ */
+typedef void (*as_batch_record_listener)(as_batch_base_record* record, uint32_t index,
+	void* udata);
+
+/**
+ * Asynchronous streaming batch record listener.  This function is called in the event loop
+ * thread once for each record as soon as the record's node response is parsed.  The record's
+ * bins are destroyed after the listener returns, so bins must be copied to be used later.
+ *
+ * @param record		Batch record with result code and returned bins.
+ * @param index			Index of the record in the batch records list.
+ * @param udata 		User data that is forwarded from asynchronous command function.
+ * @param event_loop	Event loop that this command was executed on.
+ * @ingroup batch_operations
+ */
+typedef void (*as_async_batch_record_listener)(as_batch_base_record* record, uint32_t index,
+	void* udata, as_event_loop* event_loop);
+
 //---------------------------------
 // Functions
 //---------------------------------
@@ -322,7 +530,9 @@ typedef void (*as_async_batch_listener)(as_error* err, as_batch_records* records
  * @ingroup batch_operations
  */
 #define as_batch_records_inita(__records, __capacity) \
-	as_vector_inita(&((__records)->list), sizeof(as_batch_record), __capacity);
+	as_vector_inita(&((__records)->list), sizeof(as_batch_record), __capacity);\
+	(__records)->arena = NULL;\
+	(__records)->_free = false;
 
 /**
  * Initialize batch records with specified capacity on the stack using alloca().
@@ -332,7 +542,7 @@ typedef void (*as_async_batch_listener)(as_error* err, as_batch_records* records
  * @ingroup batch_operations
  */
 #define as_batch_read_inita(__records, __capacity) \
-	as_vector_inita(&((__records)->list), sizeof(as_batch_record), __capacity);
+	as_batch_records_inita(__records, __capacity)
 
 /**
  * Initialize batch records with specified capacity on the heap.
@@ -350,6 +560,8 @@ static inline void
 as_batch_records_init(as_batch_records* records, uint32_t capacity)
 {
 	as_vector_init(&records->list, sizeof(as_batch_record), capacity);
+	records->arena = NULL;
+	records->_free = false;
 }
 
 /**
@@ -362,7 +574,7 @@ as_batch_records_init(as_batch_records* records, uint32_t capacity)
 static inline void
 as_batch_read_init(as_batch_records* records, uint32_t capacity)
 {
-	as_vector_init(&records->list, sizeof(as_batch_record), capacity);
+	as_batch_records_init(records, capacity);
 }
 
 /**
@@ -377,11 +589,8 @@ as_batch_read_init(as_batch_records* records, uint32_t capacity)
  * @relates as_batch_records
  * @ingroup batch_operations
  */
-static inline as_batch_records*
-as_batch_records_create(uint32_t capacity)
-{
-	return (as_batch_records*)as_vector_create(sizeof(as_batch_record), capacity);
-}
+AS_EXTERN as_batch_records*
+as_batch_records_create(uint32_t capacity);
 
 /**
  * Create batch records on heap with specified list capacity on the heap.
@@ -393,7 +602,7 @@ as_batch_records_create(uint32_t capacity)
 static inline as_batch_records*
 as_batch_read_create(uint32_t capacity)
 {
-	return (as_batch_records*)as_vector_create(sizeof(as_batch_record), capacity);
+	return as_batch_records_create(capacity);
 }
 
 /**
@@ -591,6 +800,92 @@ aerospike_batch_read_async(
 	as_async_batch_listener listener, void* udata, as_event_loop* event_loop
 	);
 
+/**
+ * Read multiple records for specified batch keys and stream each record to a listener as
+ * soon as its node responds.  Record bins are destroyed after each listener call, so the
+ * memory held by returned records does not grow with the batch size.  After the call,
+ * each batch record still contains its result code and in_doubt flag.
+ *
+ * ~~~~~~~~~~{.c}
+ * void my_listener(as_batch_base_record* record, uint32_t index, void* udata)
+ * {
+ * 	   if (record->result == AEROSPIKE_OK) {
+ * 	       // Process record->record
+ * 	   }
+ * }
+ *
+ * as_status status = aerospike_batch_read_stream(as, &err, NULL, &records, my_listener, NULL);
+ * ~~~~~~~~~~
+ *
+ * @param as		Aerospike cluster instance.
+ * @param err		Error detail structure that is populated if an error occurs.
+ * @param policy	Batch policy configuration parameters, pass in NULL for default.
+ * @param records	List of keys and records to retrieve.
+ * @param listener	User function called for each record.
+ * @param udata		User data forwarded to listener.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_read_stream(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_batch_record_listener listener, void* udata
+	);
+
+/**
+ * Read multiple records for specified batch keys and decode the binding's bins straight
+ * into an array of user structs. Record i is decoded into objs + i * stride and its status
+ * is written to bind_status[i]. No as_record or as_val objects are created. After the call,
+ * each batch record contains its result code and in_doubt flag, and its record has no bins.
+ * Set each read record's bin_names to the binding's bins so other bins are not returned.
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param records		List of keys and read records.
+ * @param binding		Struct fields that bins are decoded into.
+ * @param objs			Array of user structs. One per batch record.
+ * @param stride		Size of each user struct in bytes.
+ * @param bind_status	Array of per record statuses. May be NULL.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_read_bound(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	const as_binding* binding, void* objs, size_t stride, as_binding_status* bind_status
+	);
+
+/**
+ * Asynchronously read multiple records for specified batch keys and stream each record to
+ * record_listener as soon as its node responds.  Record bins are destroyed after each
+ * record_listener call.  listener is called once when the batch completes, with records
+ * that contain only result codes.
+ *
+ * @param as				Aerospike cluster instance.
+ * @param err				Error detail structure that is populated if an error occurs.
+ * @param policy			Batch policy configuration parameters, pass in NULL for default.
+ * @param records			List of keys and records to retrieve. Must create using
+ *							as_batch_records_create() because the async method returns
+ *							immediately after queueing command.
+ * @param record_listener	User function called for each record.
+ * @param listener 			User function called when the batch completes.
+ * @param udata 			User data forwarded to both listeners.
+ * @param event_loop 		Event loop assigned to run this command. If NULL, an event loop will
+ *							be chosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if async command succesfully queued. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_read_stream_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_async_batch_record_listener record_listener, as_async_batch_listener listener, void* udata,
+	as_event_loop* event_loop
+	);
+
 /**
  * Read/Write multiple records for specified batch keys in one batch call.
  * This method allows different sub-commands for each key in the batch.
@@ -716,6 +1011,66 @@ aerospike_batch_write_async(
 	as_async_batch_listener listener, void* udata, as_event_loop* event_loop
 	);
 
+/**
+ * Map batch records to nodes and serialize the command for each node once, so the same
+ * batch can be executed repeatedly with aerospike_batch_prepared_execute().  Records may be
+ * any mix of read, write, apply and remove records.
+ *
+ * Replicas are selected when routes are built.  Routes are only rebuilt when the partition
+ * map changes.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_batch_prepared* prepared;
+ *
+ * if (aerospike_batch_prepare(&as, &err, NULL, &records, &prepared) == AEROSPIKE_OK) {
+ *     while (running) {
+ *         aerospike_batch_prepared_execute(&as, &err, prepared);
+ *         // process records
+ *     }
+ *     as_batch_prepared_destroy(prepared);
+ * }
+ * as_batch_records_destroy(&records);
+ * ~~~~~~~~~~
+ *
+ * @param as		Aerospike cluster instance.
+ * @param err		Error detail structure that is populated if an error occurs.
+ * @param policy	Batch policy configuration parameters, pass in NULL for default.
+ * @param records	List of batch sub-commands.  Must outlive the prepared batch.
+ * @param prepared	Prepared batch populated on success.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_prepare(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_batch_prepared** prepared
+	);
+
+/**
+ * Execute prepared batch.  Results are stored in the prepared batch records like
+ * aerospike_batch_read() and aerospike_batch_write().  Node commands always run with
+ * synchronous sockets, even if as_policy_batch.multiplex is set.  Must not be called
+ * concurrently for the same prepared batch.
+ *
+ * @param as		Aerospike cluster instance.
+ * @param err		Error detail structure that is populated if an error occurs.
+ * @param prepared	Prepared batch.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_prepared_execute(aerospike* as, as_error* err, as_batch_prepared* prepared);
+
+/**
+ * Destroy prepared batch.  The batch records are not destroyed.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN void
+as_batch_prepared_destroy(as_batch_prepared* prepared);
+
 /**
  * Look up multiple records by key, then return all bins.
  *
@@ -784,6 +1139,83 @@ aerospike_batch_get_bins(
 	const char** bins, uint32_t n_bins, as_batch_listener listener, void* udata
 	);
 
+/**
+ * Look up multiple records by raw digest in one shared namespace and set. Keys are read
+ * straight from the contiguous digest array and results are written to a caller supplied
+ * flat array, so memory per key stays small for very large batches. Requires server
+ * version 6.0+.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_batch_digest_result* results = malloc(sizeof(as_batch_digest_result) * batch.n_digests);
+ *
+ * as_status status = aerospike_batch_get_digests(as, &err, NULL, &batch, NULL, 0, results);
+ * // process results
+ * as_batch_digest_results_destroy(results, batch.n_digests);
+ * free(results);
+ * ~~~~~~~~~~
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param batch			The batch of digests to read.
+ * @param bins			Bin filters shared by all digests. Pass NULL to read all bins.
+ * @param n_bins		The number of bin filters.
+ * @param results		Array of at least batch->n_digests results. Filled in the same order as
+ *						the digests. Results must be destroyed with
+ *						as_batch_digest_results_destroy() even when an error is returned.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_get_digests(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch_digests* batch,
+	const char** bins, uint32_t n_bins, as_batch_digest_result* results
+	);
+
+/**
+ * Look up multiple records by key views.  Views only reference caller owned namespace, set
+ * and key memory, so no as_key is created per record.  Only digests are built by the client.
+ * Consecutive views with the same namespace and set are sent as one digest batch
+ * (see aerospike_batch_get_digests()).  Requires server version 6.0+.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_batch_digest_result* results = malloc(sizeof(as_batch_digest_result) * n);
+ *
+ * as_status status = aerospike_batch_get_views(as, &err, NULL, views, n, NULL, 0, results);
+ * // process results
+ * as_batch_digest_results_destroy(results, n);
+ * free(results);
+ * ~~~~~~~~~~
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param views			Array of key views to read.
+ * @param n_views		Number of key views.
+ * @param bins			Bin filters shared by all keys. Pass NULL to read all bins.
+ * @param n_bins		The number of bin filters.
+ * @param results		Array of at least n_views results. Filled in the same order as the views.
+ *						Results must be destroyed with as_batch_digest_results_destroy() even
+ *						when an error is returned.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_get_views(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_key_view* views,
+	uint32_t n_views, const char** bins, uint32_t n_bins, as_batch_digest_result* results
+	);
+
+/**
+ * Destroy records in a flat digest result array.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN void
+as_batch_digest_results_destroy(as_batch_digest_result* results, uint32_t n);
+
 /**
  * Look up multiple records by key, then return results from specified read operations.
  *
@@ -983,6 +1415,87 @@ aerospike_batch_remove(
 	as_batch_listener listener, void* udata
 	);
 
+/**
+ * Allocate status arrays for batches of up to capacity keys.
+ *
+ * @relates as_batch_status
+ */
+AS_EXTERN void
+as_batch_status_init(as_batch_status* bs, uint32_t capacity);
+
+/**
+ * Free status arrays.
+ *
+ * @relates as_batch_status
+ */
+AS_EXTERN void
+as_batch_status_destroy(as_batch_status* bs);
+
+/**
+ * Perform read/write operations on multiple keys and store only the result code of each key.
+ * Records returned by the server are never parsed.  Requires server version 6.0+
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param policy_write	Write policy configuration parameters, pass in NULL for default.
+ * @param batch			List of keys.  Must not exceed bs->capacity.
+ * @param ops			Read/Write operations.
+ * @param bs			Status that is populated with the result of each key.
+ *
+ * @return AEROSPIKE_OK if successful. AEROSPIKE_BATCH_FAILED if one or more keys failed.
+ * Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_write_status(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, const as_batch* batch,
+	as_operations* ops, as_batch_status* bs
+	);
+
+/**
+ * Remove multiple records and store only the result code of each key.
+ * Requires server version 6.0+
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param policy_remove	Remove policy configuration parameters, pass in NULL for default.
+ * @param batch			List of keys.  Must not exceed bs->capacity.
+ * @param bs			Status that is populated with the result of each key.
+ *
+ * @return AEROSPIKE_OK if successful. AEROSPIKE_BATCH_FAILED if one or more keys failed.
+ * Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_remove_status(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_remove* policy_remove, const as_batch* batch, as_batch_status* bs
+	);
+
+/**
+ * Test whether multiple records exist and store the answer as one bit per key.  Bit i
+ * (bitmap[i / 8] & (1 << (i % 8))) is set when key i exists.  The bitmap must hold
+ * (batch->keys.size + 7) / 8 bytes.
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Batch policy configuration parameters, pass in NULL for default.
+ * @param batch			List of keys.
+ * @param bitmap		Caller supplied bitmap.
+ *
+ * @return AEROSPIKE_OK if successful. AEROSPIKE_BATCH_FAILED if a key failed for a reason
+ * other than not found. Otherwise an error.
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_exists_bitmap(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
+	uint8_t* bitmap
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
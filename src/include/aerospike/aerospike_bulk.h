@@ -0,0 +1,243 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup bulk_operations Bulk Load Operations
+ * @ingroup client_operations
+ *
+ * Multi-threaded loader for writing large numbers of records.
+ */
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_policy.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//---------------------------------
+// Types
+//---------------------------------
+
+/**
+ * Produce the next record to load.  Called concurrently by as_bulk_config.n_producers
+ * threads, each with its own producer_id in [0, n_producers).
+ *
+ * Initialize key and rec with as_key_init_*() and as_record_init() and return true, or
+ * return false when the producer has no more records.  The loader takes ownership of key and
+ * rec and destroys them after the write, so bin values must not reference memory owned by
+ * the producer.  Use copying or heap setters like as_record_set_strp(rec, bin, strdup(str), true).
+ *
+ * @ingroup bulk_operations
+ */
+typedef bool (*as_bulk_producer)(uint32_t producer_id, void* udata, as_key* key, as_record* rec);
+
+/**
+ * Called for each record that could not be written.  Called from loader threads, possibly
+ * concurrently.  key and rec are only valid during the call.
+ *
+ * @ingroup bulk_operations
+ */
+typedef void (*as_bulk_reject_listener)(
+	const as_key* key, const as_record* rec, const as_error* err, void* udata
+	);
+
+/**
+ * Bulk loader configuration.  Initialize with as_bulk_config_init().
+ *
+ * Records flow through three stages.  Producer threads create records and route them to
+ * the sink of the master node of the record's partition.  Each sink has a bounded queue, so
+ * producers block when a node falls behind.  Sink workers take up to batch_size records
+ * from their queue and write them with one batch write command, or with single puts if
+ * batch_size is 1.
+ *
+ * Each sink limits its commands in flight between min_in_flight and max_in_flight.  The
+ * limit grows by one after limit commands completed below target_latency_ms and is halved
+ * when a command exceeds the target or the server reports overload.
+ *
+ * @ingroup bulk_operations
+ */
+typedef struct as_bulk_config_s {
+	/**
+	 * Policy of batch write commands.  The base policy is also used for single puts.
+	 */
+	as_policy_batch batch_policy;
+
+	/**
+	 * Policy of each record in a batch write.  Also used for single puts.
+	 */
+	as_policy_batch_write write_policy;
+
+	/**
+	 * Producer threads.
+	 * Default: 1
+	 */
+	uint32_t n_producers;
+
+	/**
+	 * Maximum records per batch write command.  1 writes each record with a single put.
+	 * Default: 100
+	 */
+	uint32_t batch_size;
+
+	/**
+	 * Maximum milliseconds a sink worker waits to fill a batch after the first record.
+	 * Default: 5
+	 */
+	uint32_t linger_ms;
+
+	/**
+	 * Maximum records queued per node.
+	 * Default: 10000
+	 */
+	uint32_t queue_size;
+
+	/**
+	 * Minimum commands in flight per node.
+	 * Default: 1
+	 */
+	uint32_t min_in_flight;
+
+	/**
+	 * Maximum commands in flight per node.  A worker thread is started for each.
+	 * Default: 16
+	 */
+	uint32_t max_in_flight;
+
+	/**
+	 * Command latency above which the in-flight limit is reduced.
+	 * Default: 50
+	 */
+	uint32_t target_latency_ms;
+
+	/**
+	 * Append rejected records to this file, one line per record with tab separated
+	 * namespace, set, key, status code and error message.  Keys without a user key are
+	 * written as digest hex.  NULL disables the reject file.
+	 * Default: NULL
+	 */
+	const char* reject_path;
+
+	/**
+	 * Called for each rejected record.  NULL disables.
+	 * Default: NULL
+	 */
+	as_bulk_reject_listener reject_listener;
+
+	/**
+	 * Passed to reject_listener.
+	 */
+	void* reject_udata;
+} as_bulk_config;
+
+/**
+ * Bulk load counters.
+ *
+ * @ingroup bulk_operations
+ */
+typedef struct as_bulk_stats_s {
+	/**
+	 * Records returned by producers.
+	 */
+	uint64_t produced;
+
+	/**
+	 * Records written successfully.
+	 */
+	uint64_t written;
+
+	/**
+	 * Records that failed and were reported as rejects.
+	 */
+	uint64_t rejected;
+
+	/**
+	 * Batch write or put commands sent.
+	 */
+	uint64_t commands;
+
+	/**
+	 * Times a node's in-flight limit was reduced.
+	 */
+	uint64_t throttles;
+} as_bulk_stats;
+
+//---------------------------------
+// Functions
+//---------------------------------
+
+/**
+ * Initialize bulk loader configuration with default values.
+ *
+ * @ingroup bulk_operations
+ */
+AS_EXTERN void
+as_bulk_config_init(as_bulk_config* config);
+
+/**
+ * Load records returned by producer until all producers are done.  Returns after every
+ * record was written or rejected.  Record failures do not fail the load.  They are counted
+ * in stats and reported to the reject file and listener.
+ *
+ * ~~~~~~~~~~{.c}
+ * bool producer(uint32_t id, void* udata, as_key* key, as_record* rec)
+ * {
+ *     int64_t i = next_line(udata, id);
+ *     if (i < 0) {
+ *         return false;
+ *     }
+ *     as_key_init_int64(key, "test", "demo", i);
+ *     as_record_init(rec, 1);
+ *     as_record_set_int64(rec, "a", i);
+ *     return true;
+ * }
+ *
+ * as_bulk_config config;
+ * as_bulk_config_init(&config);
+ * config.n_producers = 4;
+ * config.reject_path = "rejects.txt";
+ *
+ * as_bulk_stats stats;
+ * if (aerospike_bulk_load(&as, &err, &config, producer, ctx, &stats) != AEROSPIKE_OK) {
+ *     fprintf(stderr, "error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as		The aerospike instance to use for this operation.
+ * @param err		The as_error to be populated if an error occurs.
+ * @param config	Loader configuration, pass in NULL for default.
+ * @param producer	Record producer.
+ * @param udata		User-defined data passed to producer.
+ * @param stats		Counters populated when the load returns.  May be NULL.
+ *
+ * @return AEROSPIKE_OK if the load ran to completion.  Otherwise an error.
+ * @ingroup bulk_operations
+ */
+AS_EXTERN as_status
+aerospike_bulk_load(
+	aerospike* as, as_error* err, const as_bulk_config* config, as_bulk_producer producer,
+	void* udata, as_bulk_stats* stats
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
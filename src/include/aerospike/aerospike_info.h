@@ -55,6 +55,57 @@ extern "C" {
  */
 typedef bool (*aerospike_info_foreach_callback)(const as_error* err, const as_node* node, const char* req, char* res, void* udata);
 
+/**
+ * Response of one node to aerospike_info_all() or aerospike_info_all_async().
+ *
+ * @ingroup info_operations
+ */
+typedef struct as_info_node_result_s {
+	/**
+	 * The node which provided the response.  The node is reserved until the callback returns.
+	 */
+	as_node* node;
+
+	/**
+	 * The response to the info request.  NULL if the request failed on this node.  The caller
+	 * should not free this string.
+	 */
+	char* response;
+
+	/**
+	 * The status and possible error information for this node.
+	 */
+	as_error err;
+} as_info_node_result;
+
+/**
+ * Callback for aerospike_info_all().  Called once with the results of all nodes.
+ *
+ * @param results		The node results.
+ * @param n_results		The number of node results.
+ * @param udata			The udata provided to aerospike_info_all().
+ *
+ * @ingroup info_operations
+ */
+typedef void (*aerospike_info_all_callback)(
+	as_info_node_result* results, uint32_t n_results, void* udata
+	);
+
+/**
+ * Listener for aerospike_info_all_async().  Called once after the last node responded or
+ * timed out.
+ *
+ * @param results		The node results.
+ * @param n_results		The number of node results.
+ * @param udata			The udata provided to aerospike_info_all_async().
+ * @param event_loop	Event loop of the last node command.
+ *
+ * @ingroup info_operations
+ */
+typedef void (*aerospike_info_all_listener)(
+	as_info_node_result* results, uint32_t n_results, void* udata, as_event_loop* event_loop
+	);
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -273,6 +324,85 @@ aerospike_info_foreach(
 	aerospike_info_foreach_callback callback, void* udata
 	);
 
+/**
+ * Send an info request to all nodes in parallel on the sync thread pool and call the callback
+ * once with all node results.  policy->timeout applies to each node independently.  A node
+ * failure is reported in that node's result and does not fail the call.
+ *
+ * ~~~~~~~~~~{.c}
+ * void callback(as_info_node_result* results, uint32_t n_results, void* udata)
+ * {
+ *     for (uint32_t i = 0; i < n_results; i++) {
+ *         if (results[i].err.code == AEROSPIKE_OK) {
+ *             // handle results[i].response
+ *         }
+ *     }
+ * }
+ *
+ * if (aerospike_info_all(&as, &err, NULL, "statistics", callback, NULL) != AEROSPIKE_OK) {
+ * 	   // handle error
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param req			The info request to send.
+ * @param callback		The function to call with the node results.
+ * @param udata			User-data to send to the callback.
+ *
+ * @return AEROSPIKE_OK if the request was sent to all nodes. Otherwise an error.
+ *
+ * @ingroup info_operations
+ */
+AS_EXTERN as_status
+aerospike_info_all(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* req,
+	aerospike_info_all_callback callback, void* udata
+	);
+
+/**
+ * Asynchronously send an info request to all nodes at the same time and call the listener
+ * once after every node responded or timed out.  policy->timeout applies to each node
+ * independently.  A node failure is reported in that node's result.
+ *
+ * The listener is usually called in an event loop thread.  It is called in the calling thread
+ * if no node command could be started.
+ *
+ * ~~~~~~~~~~{.c}
+ * void listener(as_info_node_result* results, uint32_t n_results, void* udata,
+ *     as_event_loop* event_loop)
+ * {
+ *     for (uint32_t i = 0; i < n_results; i++) {
+ *         if (results[i].err.code == AEROSPIKE_OK) {
+ *             // handle results[i].response
+ *         }
+ *     }
+ * }
+ *
+ * aerospike_info_all_async(&as, &err, NULL, "statistics", listener, NULL, NULL);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The info policy. If NULL, the default info policy will be used.
+ * @param req			The info request to send.
+ * @param listener		User function to be called with the node results.
+ * @param udata			User data to be forwarded to user callback.
+ * @param event_loop 	Event loop assigned to run the node commands. If NULL, event loops
+ *						will be chosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if the listener will be called. Otherwise an error and the listener
+ * will not be called.
+ *
+ * @ingroup info_operations
+ */
+AS_EXTERN as_status
+aerospike_info_all_async(
+	aerospike* as, as_error* err, as_policy_info* policy, const char* req,
+	aerospike_info_all_listener listener, void* udata, as_event_loop* event_loop
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
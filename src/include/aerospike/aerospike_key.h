@@ -29,11 +29,14 @@
  */
 
 #include <aerospike/aerospike.h>
+#include <aerospike/as_async_write_group.h>
+#include <aerospike/as_binding.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_operations.h>
+#include <aerospike/as_partition.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_status.h>
@@ -43,6 +46,182 @@
 extern "C" {
 #endif
 
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Operations that are serialized once and then run against many keys.
+ * The filter expression, bin names, values and CDT operations are packed into
+ * wire format by as_prepared_operate_init().  Each call only writes the key
+ * fields, ttl and generation.
+ *
+ * Initialize with as_prepared_operate_init() and release with
+ * as_prepared_operate_destroy().
+ *
+ * @ingroup key_operations
+ */
+typedef struct as_prepared_operate_s {
+	/**
+	 * Policy copied at prepare time.
+	 */
+	as_policy_operate policy;
+
+	/**
+	 * Serialized filter expression field and operations.
+	 */
+	uint8_t* buf;
+
+	/**
+	 * Size of buf.
+	 */
+	uint32_t size;
+
+	/**
+	 * Number of fields in buf (filter expression).
+	 */
+	uint16_t n_fields;
+
+	/**
+	 * Number of operations in buf.
+	 */
+	uint16_t n_operations;
+
+	/**
+	 * Wire protocol attributes derived from operations.
+	 */
+	uint8_t read_attr;
+	uint8_t write_attr;
+	uint8_t info_attr;
+
+} as_prepared_operate;
+
+/**
+ * Read command context that is reused across aerospike_key_get_session() calls from one
+ * thread.  The policy, its filter expression and the message header are serialized once by
+ * as_session_ctx_init().  The partition of the last key is remembered, so repeated reads
+ * of the same key skip the partition lookup.
+ *
+ * A context must not be shared by threads that use it at the same time.  Initialize with
+ * as_session_ctx_init() and release with as_session_ctx_destroy().
+ *
+ * @ingroup key_operations
+ */
+typedef struct as_session_ctx_s {
+	/**
+	 * Policy copied at init time.
+	 */
+	as_policy_read policy;
+
+	/**
+	 * Serialized filter expression field.
+	 */
+	uint8_t* filter;
+
+	/**
+	 * Size of filter.
+	 */
+	uint32_t filter_size;
+
+	/**
+	 * Number of fields in filter.
+	 */
+	uint16_t n_fields;
+
+	/**
+	 * @private
+	 * Message header that follows the proto header.  Field count is patched per key.
+	 */
+	uint8_t header[22];
+
+	/**
+	 * @private
+	 * Cluster of the last key.  NULL if no key was resolved yet.
+	 */
+	struct as_cluster_s* cluster;
+
+	/**
+	 * @private
+	 * Partition of the last key.
+	 */
+	as_partition_info pi;
+
+	/**
+	 * @private
+	 * Digest and namespace of the last key.
+	 */
+	as_digest_value digest;
+	as_namespace ns;
+
+} as_session_ctx;
+
+/**
+ * Called with consecutive chunks of a streamed bin value.  The chunk is only valid during
+ * the call.  Return false to abort the read.
+ *
+ * @ingroup key_operations
+ */
+typedef bool (*as_stream_listener)(const uint8_t* chunk, uint32_t size, void* udata);
+
+/**
+ * Destination and result of aerospike_key_get_stream().
+ *
+ * @ingroup key_operations
+ */
+typedef struct as_stream_bin_s {
+	/**
+	 * Caller owned buffer that receives the bin value.  If NULL, the value is passed to
+	 * listener in chunks.
+	 */
+	uint8_t* buf;
+
+	/**
+	 * Size of buf.
+	 */
+	uint32_t capacity;
+
+	/**
+	 * Chunk listener used when buf is NULL.
+	 */
+	as_stream_listener listener;
+
+	/**
+	 * User data passed to listener.
+	 */
+	void* udata;
+
+	/**
+	 * Populated with the bin value size.
+	 */
+	uint32_t size;
+
+	/**
+	 * Populated with the record generation.
+	 */
+	uint32_t gen;
+
+	/**
+	 * Populated with the record time to live.
+	 */
+	uint32_t ttl;
+
+	/**
+	 * Populated with the bin particle type, for example AS_BYTES_BLOB or AS_BYTES_STRING.
+	 */
+	uint8_t type;
+
+	/**
+	 * Populated with true if the record has the bin.
+	 */
+	bool found;
+
+	/**
+	 * @private
+	 * Bin name.
+	 */
+	const char* bin;
+} as_stream_bin;
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -81,6 +260,161 @@ aerospike_key_get(
 	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key, as_record** rec
 	);
 
+/**
+ * Initialize reusable read context.  The policy filter expression may be destroyed after
+ * this call.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_session_ctx ctx;
+ * as_session_ctx_init(&as, &ctx, NULL);
+ *
+ * as_error err;
+ * as_error_init(&err);
+ *
+ * for (int i = 0; i < 1000; i++) {
+ *     as_key key;
+ *     as_key_init_int64(&key, "ns", "set", i);
+ *
+ *     as_record* rec = NULL;
+ *     if (aerospike_key_get_session(&as, &err, &ctx, &key, &rec) == AEROSPIKE_OK) {
+ *         as_record_destroy(rec);
+ *     }
+ * }
+ * as_session_ctx_destroy(&ctx);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance.
+ * @param ctx			The context to initialize.
+ * @param policy		The policy to use for commands. If NULL, then the default policy will be used.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN void
+as_session_ctx_init(aerospike* as, as_session_ctx* ctx, const as_policy_read* policy);
+
+/**
+ * Release resources held by the read context.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN void
+as_session_ctx_destroy(as_session_ctx* ctx);
+
+/**
+ * Look up a record by key and return all bins, using a context initialized by
+ * as_session_ctx_init().  Behaves like aerospike_key_get() with the context's policy, except
+ * that err is only reset when it holds an error, so err must be initialized before the first
+ * call and then reused.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param ctx			The read context.
+ * @param key			The key of the record.
+ * @param rec 			The record to be populated with the data from request. Same rules as
+ *						aerospike_key_get().
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_get_session(
+	aerospike* as, as_error* err, as_session_ctx* ctx, const as_key* key, as_record** rec
+	);
+
+/**
+ * Look up multiple records by key and return all bins.  Unlike a batch read, each key is sent
+ * as a separate command on its own connection.  All commands are sent before any response is
+ * read, and responses are parsed as they arrive, so the calling thread waits about as long as
+ * the slowest node instead of the sum of all round trips.
+ *
+ * Commands that fail with a retryable error are retried one at a time.  The record cache,
+ * negative cache and hedged reads are not used.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_key keys[2];
+ * as_key_init(&keys[0], "ns", "set", "key1");
+ * as_key_init(&keys[1], "ns", "set", "key2");
+ *
+ * as_record* recs[2] = {NULL, NULL};
+ * as_status statuses[2];
+ *
+ * if (aerospike_key_get_many(&as, &err, NULL, keys, 2, recs, statuses) != AEROSPIKE_OK) {
+ *     printf("error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ *
+ * for (uint32_t i = 0; i < 2; i++) {
+ *     if (statuses[i] == AEROSPIKE_OK) {
+ *         as_record_destroy(recs[i]);
+ *     }
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated with the first error that is not
+ *						AEROSPIKE_ERR_RECORD_NOT_FOUND.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param keys			The keys of the records.
+ * @param n_keys		Number of keys.
+ * @param records		Array of n_keys record pointers.  Each pointer follows the same rules as
+ *						rec in aerospike_key_get() and is only populated when its status is
+ *						AEROSPIKE_OK.
+ * @param statuses		Array of n_keys statuses.  Populated with the result of each key.
+ *
+ * @return AEROSPIKE_OK if every record was found or not found. Otherwise the first other error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_get_many(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* keys,
+	uint32_t n_keys, as_record** records, as_status* statuses
+	);
+
+/**
+ * Store multiple records by pipelining single record writes.  Commands are sent over one
+ * connection per node, and up to window commands are written ahead before waiting for the
+ * oldest response, so a bulk load costs about n_keys / window round trips per node instead
+ * of n_keys.  Responses are read in the order commands were sent.
+ *
+ * Commands that fail with a retryable error are retried one at a time.  If a connection
+ * fails, commands already sent on it are retried and may be in doubt.  Compression and
+ * gather writes are not used.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_key keys[1000];
+ * as_record* recs[1000];
+ * as_status statuses[1000];
+ *
+ * // populate keys and recs
+ *
+ * if (aerospike_key_put_many(&as, &err, NULL, keys, 1000, recs, 64, statuses) != AEROSPIKE_OK) {
+ *     printf("error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated with the first error that is not
+ *						AEROSPIKE_ERR_RECORD_NOT_FOUND.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param keys			The keys of the records.
+ * @param n_keys		Number of keys.
+ * @param records		Array of n_keys records to store.
+ * @param window		Maximum outstanding commands per node connection.  Pass 0 for the default
+ *						of 32.  Large records should use a smaller window, because the client
+ *						does not read responses while it is blocked writing a command.
+ * @param statuses		Array of n_keys statuses.  Populated with the result of each key.
+ *
+ * @return AEROSPIKE_OK if every record was stored or not found. Otherwise the first other error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_put_many(
+	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* keys,
+	uint32_t n_keys, as_record** records, uint32_t window, as_status* statuses
+	);
+
 /**
  * Asynchronously look up a record by key and return all bins.
  *
@@ -163,6 +497,67 @@ aerospike_key_select(
 	const char* bins[], as_record** rec
 	);
 
+/**
+ * Read one bin of a record without buffering the response.  The message header and fields
+ * are read first, then the bin value is received from the socket straight into stream->buf,
+ * or in chunks passed to stream->listener.  Peak client memory for large blobs is the
+ * caller's buffer instead of the response plus a copy of the value.
+ *
+ * The record cache, negative cache and hedged reads are not used.  Once a chunk has been
+ * passed to the listener, the command is not retried.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_stream_bin stream = {
+ *     .buf = buf,
+ *     .capacity = sizeof(buf)
+ * };
+ *
+ * if (aerospike_key_get_stream(&as, &err, NULL, &key, "blob", &stream) == AEROSPIKE_OK &&
+ *     stream.found) {
+ *     // stream.size bytes are in buf.
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key			The key of the record.
+ * @param bin			The bin to read.
+ * @param stream		Destination of the bin value.  Also populated with the record metadata.
+ *
+ * @return AEROSPIKE_OK if successful. AEROSPIKE_ERR_CLIENT if the value does not fit in
+ * stream->buf. AEROSPIKE_ERR_CLIENT_ABORT if the listener aborted. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_get_stream(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const char* bin, as_stream_bin* stream
+	);
+
+/**
+ * Lookup a record by key and decode the binding's bins straight into a user struct.
+ * No as_record or as_val objects are created. See as_binding.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key			The key of the record.
+ * @param binding		Bins to read and the struct fields they are decoded into.
+ * @param obj			User struct that receives the bin values.
+ * @param bind_status	Missing, mismatched and truncated fields. May be NULL.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_get_bound(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const as_binding* binding, void* obj, as_binding_status* bind_status
+	);
+
 /**
  * Asynchronously lookup a record by key, then return specified bins.
  *
@@ -447,6 +842,59 @@ aerospike_key_remove_async(
 	as_pipe_listener pipe_listener
 	);
 
+/**
+ * Asynchronously store a record without a per-command listener.  The result is only counted
+ * in the write group.  See as_async_write_group.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_status status = aerospike_key_put_group_async(&as, &err, NULL, &key, &rec, group, NULL,
+ *     NULL);
+ * ~~~~~~~~~~
+ *
+ * @param as				The aerospike instance to use for this operation.
+ * @param err				The as_error to be populated if an error occurs.
+ * @param policy			The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key				The key of the record.
+ * @param rec				The record containing the data to be written.
+ * @param group				The write group that counts the result.
+ * @param event_loop		Event loop assigned to run this command. If NULL, an event loop will be chosen by round-robin.
+ * @param pipe_listener		Enables command pipelining, if not NULL. See aerospike_key_put_async().
+ *
+ * @return AEROSPIKE_OK if async command successfully queued. Otherwise an error, which is
+ * also counted as a failed write of the group.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_put_group_async(
+	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* key, as_record* rec,
+	as_async_write_group* group, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	);
+
+/**
+ * Asynchronously remove a record without a per-command listener.  The result is only counted
+ * in the write group.  AEROSPIKE_ERR_RECORD_NOT_FOUND counts as a failed write.  See
+ * as_async_write_group.
+ *
+ * @param as				The aerospike instance to use for this operation.
+ * @param err				The as_error to be populated if an error occurs.
+ * @param policy			The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key				The key of the record.
+ * @param group				The write group that counts the result.
+ * @param event_loop		Event loop assigned to run this command. If NULL, an event loop will be chosen by round-robin.
+ * @param pipe_listener		Enables command pipelining, if not NULL. See aerospike_key_put_async().
+ *
+ * @return AEROSPIKE_OK if async command successfully queued. Otherwise an error, which is
+ * also counted as a failed write of the group.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_remove_group_async(
+	aerospike* as, as_error* err, const as_policy_remove* policy, const as_key* key,
+	as_async_write_group* group, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	);
+
 /**
  * Lookup a record by key, then perform specified operations.
  *
@@ -539,6 +987,102 @@ aerospike_key_operate_async(
 	as_async_record_listener listener, void* udata, as_event_loop* event_loop, as_pipe_listener pipe_listener
 	);
 
+/**
+ * Serialize operations once so they can be run against many keys with
+ * aerospike_key_operate_prepared() or aerospike_key_operate_prepared_async().
+ * The operations and policy filter expression may be destroyed after this call.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_operations ops;
+ * as_operations_inita(&ops, 2);
+ * as_operations_add_incr(&ops, "bin1", 1);
+ * as_operations_add_read(&ops, "bin1");
+ *
+ * as_prepared_operate prep;
+ * as_prepared_operate_init(&as, &err, &prep, NULL, &ops);
+ * as_operations_destroy(&ops);
+ *
+ * for (int i = 0; i < 1000; i++) {
+ *     as_key key;
+ *     as_key_init_int64(&key, "ns", "set", i);
+ *
+ *     as_record* rec = NULL;
+ *     aerospike_key_operate_prepared(&as, &err, &prep, &key, AS_RECORD_DEFAULT_TTL, 0, &rec);
+ *     as_record_destroy(rec);
+ * }
+ * as_prepared_operate_destroy(&prep);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param prep			The prepared operations to initialize.
+ * @param policy		The policy to use for commands. If NULL, then the default policy will be used.
+ * @param ops			The operations to prepare.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+as_prepared_operate_init(
+	aerospike* as, as_error* err, as_prepared_operate* prep, const as_policy_operate* policy,
+	const as_operations* ops
+	);
+
+/**
+ * Release prepared operations.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN void
+as_prepared_operate_destroy(as_prepared_operate* prep);
+
+/**
+ * Perform prepared operations on a record.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param prep			Operations initialized by as_prepared_operate_init().
+ * @param key			The key of the record.
+ * @param ttl			Record time to live in seconds. See as_operations.ttl.
+ * @param gen			Expected generation when the prepared policy uses generation checks.
+ * @param rec			The record to be populated with the data from AS_OPERATOR_READ operations.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_operate_prepared(
+	aerospike* as, as_error* err, const as_prepared_operate* prep, const as_key* key,
+	uint32_t ttl, uint16_t gen, as_record** rec
+	);
+
+/**
+ * Asynchronously perform prepared operations on a record.
+ *
+ * @param as				The aerospike instance to use for this operation.
+ * @param err				The as_error to be populated if an error occurs.
+ * @param prep				Operations initialized by as_prepared_operate_init().
+ * @param key				The key of the record.
+ * @param ttl				Record time to live in seconds. See as_operations.ttl.
+ * @param gen				Expected generation when the prepared policy uses generation checks.
+ * @param listener			User function to be called with command results.
+ * @param udata				User data to be forwarded to user callback.
+ * @param event_loop		Event loop assigned to run this command. If NULL, an event loop will be chosen by round-robin.
+ * @param pipe_listener		Enables command pipelining, if not NULL.
+ *
+ * @return AEROSPIKE_OK if async command successfully queued. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_operate_prepared_async(
+	aerospike* as, as_error* err, const as_prepared_operate* prep, const as_key* key,
+	uint32_t ttl, uint16_t gen, as_async_record_listener listener, void* udata,
+	as_event_loop* event_loop, as_pipe_listener pipe_listener
+	);
+
 /**
  * Lookup a record by key, then apply the UDF.
  *
@@ -636,6 +1180,33 @@ aerospike_key_apply_async(
 	as_pipe_listener pipe_listener
 	);
 
+/**
+ * Resolve namespace to a small integer ID. Keys that carry the ID (see
+ * as_key_set_namespace_id()) find the namespace partition table by index instead of
+ * comparing namespace names. The ID is valid for the life of the cluster instance.
+ *
+ * ~~~~~~~~~~{.c}
+ * uint32_t ns_id;
+ *
+ * if (aerospike_namespace_id(&as, &err, "test", &ns_id) == AEROSPIKE_OK) {
+ *     as_key key;
+ *     as_key_init_int64(&key, "test", "demo", 1);
+ *     as_key_set_namespace_id(&key, ns_id);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance that owns the namespace.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param ns			Namespace name.
+ * @param ns_id			The namespace ID.
+ *
+ * @return AEROSPIKE_OK if the namespace exists. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_namespace_id(aerospike* as, as_error* err, const char* ns, uint32_t* ns_id);
+
 /**
  * @cond SKIP_DOXYGEN
  * doxygen skips this section till endcond
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_node.h>
+#include <aerospike/as_status.h>
+
+/**
+ * @defgroup partition_route Partition Routing
+ *
+ * Map record digests to the nodes that currently own them, so applications can group work
+ * by node before sending batches.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Current owners of a record's partition.
+ * @ingroup partition_route
+ */
+typedef struct as_partition_route_s {
+	/**
+	 * Master node or NULL if the master is unknown or inactive.  The node is reserved and
+	 * must be released with as_partition_routes_release().
+	 */
+	as_node* master;
+
+	/**
+	 * First replica node or NULL if the partition has no active replica.  The node is
+	 * reserved and must be released with as_partition_routes_release().
+	 */
+	as_node* replica;
+
+	/**
+	 * Partition ID.
+	 */
+	uint32_t partition_id;
+} as_partition_route;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Return partition map generation.  The generation changes when nodes are added or removed
+ * or a node's partition map changes.  Routes retrieved with a generation that no longer
+ * matches may be stale.
+ *
+ * @param as		The aerospike instance.
+ *
+ * @ingroup partition_route
+ */
+AS_EXTERN uint32_t
+aerospike_partition_generation(aerospike* as);
+
+/**
+ * Look up the partition and current owner nodes of each digest in a namespace.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_partition_route routes[100];
+ * uint32_t gen;
+ *
+ * if (aerospike_partition_routes(&as, &err, "test", digests, 100, routes, &gen) == AEROSPIKE_OK) {
+ *     // Group digests by routes[i].master.
+ *     as_partition_routes_release(routes, 100);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance.
+ * @param err			If an error occurs, the err will be populated.
+ * @param ns			The namespace.
+ * @param digests		Record digests.
+ * @param n_digests		Number of digests.
+ * @param routes		Array of n_digests routes to populate.
+ * @param generation	Partition map generation read before the lookup.  May be NULL.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error and no nodes are reserved.
+ *
+ * @ingroup partition_route
+ */
+AS_EXTERN as_status
+aerospike_partition_routes(
+	aerospike* as, as_error* err, const char* ns, const as_digest_value* digests,
+	uint32_t n_digests, as_partition_route* routes, uint32_t* generation
+	);
+
+/**
+ * Look up the partition and current owner nodes of a single digest in a namespace.
+ * Release the route with as_partition_routes_release() when done.
+ *
+ * @ingroup partition_route
+ */
+static inline as_status
+aerospike_partition_route(
+	aerospike* as, as_error* err, const char* ns, const as_digest_value digest,
+	as_partition_route* route, uint32_t* generation
+	)
+{
+	return aerospike_partition_routes(as, err, ns, (const as_digest_value*)digest, 1, route,
+		generation);
+}
+
+/**
+ * Release nodes reserved by aerospike_partition_routes().
+ *
+ * @param routes		Routes populated by aerospike_partition_routes().
+ * @param n_routes		Number of routes.
+ *
+ * @ingroup partition_route
+ */
+AS_EXTERN void
+as_partition_routes_release(as_partition_route* routes, uint32_t n_routes);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
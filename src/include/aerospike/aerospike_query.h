@@ -83,6 +83,7 @@
 #include <aerospike/as_policy.h>
 #include <aerospike/as_query.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_record_raw.h>
 #include <aerospike/as_status.h>
 #include <aerospike/as_stream.h>
 
@@ -116,6 +117,19 @@ extern "C" {
  */
 typedef bool (*aerospike_query_foreach_callback)(const as_val* val, void* udata);
 
+/**
+ * Raw query user callback used by aerospike_query_foreach_raw(). Records are passed
+ * without decoding bins. When all records have been returned, the callback is called
+ * with a NULL record.
+ *
+ * @param rec 			The raw record. Only valid until the callback returns.
+ * @param udata 		User-data provided to the calling function.
+ *
+ * @return `true` to continue to the next record. Otherwise, iteration will end.
+ * @ingroup query_operations
+ */
+typedef bool (*aerospike_query_foreach_raw_callback)(const as_record_raw* rec, void* udata);
+
 /**
  * Asynchronous query user callback.  This function is called for each record returned.
  * This function is also called once when the query completes or an error has occurred.
@@ -173,6 +187,29 @@ aerospike_query_foreach(
 	aerospike_query_foreach_callback callback, void* udata
 	);
 
+/**
+ * Execute a query like aerospike_query_foreach(), but pass records to the callback
+ * without decoding bins. Bin names and values reference the response buffer, so
+ * no memory is allocated per record. Aggregation queries are not supported.
+ *
+ * The callback code must be thread-safe.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param query			The query to execute against the cluster.
+ * @param callback		The callback function to call for each result value.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success, otherwise an error.
+ * @ingroup query_operations
+ */
+AS_EXTERN as_status
+aerospike_query_foreach_raw(
+	aerospike* as, as_error* err, const as_policy_query* policy, as_query* query,
+	aerospike_query_foreach_raw_callback callback, void* udata
+	);
+
 /**
  * Query records with a partition filter. Multiple threads will likely be calling the callback
  * in parallel. Therefore, your callback implementation should be thread safe.
@@ -379,6 +416,36 @@ aerospike_query_wait(
 	return aerospike_job_wait(as, err, policy, module, query_id, interval_ms);
 }
 
+/**
+ * Asynchronously wait for a background query to be completed by servers.  Nodes are polled in
+ * parallel and the poll interval grows while the query runs.  See aerospike_job_wait_async().
+ *
+ * @param as			Aerospike cluster instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Info configuration parameters, pass in null for default.
+ * @param query			The query that was executed against the cluster.
+ * @param query_id		The id for the query job, which can be used for obtaining query status.
+ * @param interval_ms	First polling interval in milliseconds. If zero, 1000 ms is used.
+ * @param listener		User function to be called when the query completes.
+ * @param udata			User data to be forwarded to user callback.
+ * @param event_loop	Event loop assigned to run this wait. If NULL, an event loop will be
+ *						chosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if the wait was started, otherwise an error.
+ * @ingroup query_operations
+ */
+static inline as_status
+aerospike_query_wait_async(
+	aerospike* as, as_error* err, const as_policy_info* policy, const as_query* query,
+	uint64_t query_id, uint32_t interval_ms, as_async_write_listener listener, void* udata,
+	as_event_loop* event_loop
+	)
+{
+	const char* module = (query->where.size > 0)? "query" : "scan";
+	return aerospike_job_wait_async(as, err, policy, module, query_id, interval_ms, listener,
+		udata, event_loop);
+}
+
 /**
  * Check the progress of a background query running on the database.
  *
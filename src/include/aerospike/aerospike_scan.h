@@ -99,7 +99,9 @@
 #include <aerospike/as_partition_filter.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_record_raw.h>
 #include <aerospike/as_scan.h>
+#include <aerospike/as_scan_lease.h>
 #include <aerospike/as_status.h>
 #include <aerospike/as_val.h>
 
@@ -135,6 +137,20 @@ extern "C" {
  */
 typedef bool (*aerospike_scan_foreach_callback)(const as_val* val, void* udata);
 
+/**
+ * Raw scan user callback used by aerospike_scan_foreach_raw(). Records are passed
+ * without decoding bins. When all records have been scanned, the callback is called
+ * with a NULL record.
+ *
+ * @param rec 			The raw record. Only valid until the callback returns.
+ * @param udata 		User-data provided to the calling function.
+ *
+ * @return `true` to continue to the next record. Otherwise, the scan will end.
+ *
+ * @ingroup scan_operations
+ */
+typedef bool (*aerospike_scan_foreach_raw_callback)(const as_record_raw* rec, void* udata);
+
 /**
  * Asynchronous scan user callback.  This function is called for each record returned.
  * This function is also called once when the scan completes or an error has occurred.
@@ -219,6 +235,28 @@ aerospike_scan_wait(
 	uint32_t interval_ms
 	);
 
+/**
+ * Asynchronously wait for a background scan to be completed by servers.  Nodes are polled in
+ * parallel and the poll interval grows while the scan runs.  See aerospike_job_wait_async().
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan_id		The id for the scan job.
+ * @param interval_ms	The first polling interval in milliseconds. If zero, 1000 ms is used.
+ * @param listener		User function to be called when the scan completes.
+ * @param udata			User data to be forwarded to user callback.
+ * @param event_loop	Event loop assigned to run this wait. If NULL, an event loop will be
+ *						chosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if the wait was started. Otherwise an error occurred.
+ */
+AS_EXTERN as_status
+aerospike_scan_wait_async(
+	aerospike* as, as_error* err, const as_policy_info* policy, uint64_t scan_id,
+	uint32_t interval_ms, as_async_write_listener listener, void* udata, as_event_loop* event_loop
+	);
+
 /**
  * Check the progress of a background scan running on the database. The status
  * of the scan running on the datatabse will be populated into an as_scan_info.
@@ -285,6 +323,34 @@ aerospike_scan_foreach(
 	aerospike_scan_foreach_callback callback, void* udata
 	);
 
+/**
+ * Scan records like aerospike_scan_foreach(), but pass records to the callback
+ * without decoding bins. Bin names and values reference the response buffer, so
+ * no memory is allocated per record. Use as_record_raw_iterator to read bins and
+ * as_bin_raw_to_val() to decode selected bins.
+ *
+ * Multiplexed scans (as_policy_scan.multiplex) run on the calling thread's connections
+ * when a raw callback is used.
+ *
+ * If "scan.concurrent" is true (default false), the callback code must be thread-safe.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param callback		The function to be called for each record scanned.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_foreach_raw(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	aerospike_scan_foreach_raw_callback callback, void* udata
+	);
+
 /**
  * Scan the records in the specified namespace and set for a single node.
  *
@@ -367,6 +433,66 @@ aerospike_scan_partitions(
 	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
 	);
 
+/**
+ * Scan records in specified namespace, set and partition filter like
+ * aerospike_scan_partitions(), but pass records to the callback without decoding bins.
+ * See aerospike_scan_foreach_raw().
+ *
+ * If "scan.concurrent" is true (default false), the callback code must be thread-safe.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param pf			Partition filter.
+ * @param callback		The function to be called for each record scanned.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_partitions_raw(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_raw_callback callback, void* udata
+	);
+
+/**
+ * Run this worker's share of one logical scan that is split over many workers.  The worker
+ * repeatedly leases a chunk of partitions from the store, scans it and releases it, until
+ * the store has no chunks left.  Fast workers therefore take over work from slow ones.
+ *
+ * A lease is renewed while records arrive.  If a worker stops renewing (crash or stall),
+ * its lease expires and another worker resumes the chunk from the digest cursors saved at
+ * the last release.  Records returned after those cursors may be delivered twice.  If
+ * the callback returns false, the current chunk is released with its cursors and this
+ * worker stops, while other workers continue.
+ *
+ * The callback is called with a NULL value once after this worker is finished.
+ * scan.parts_all must not be set and policy max_records is not supported.  If
+ * "scan.concurrent" is true (default false), the callback code must be thread-safe.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param store			Lease store shared by all workers.
+ * @param lease_ms		Lease duration in milliseconds.
+ * @param callback		The function to be called for each record scanned.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_leased(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_scan_lease_store* store, uint32_t lease_ms, aerospike_scan_foreach_callback callback,
+	void* udata
+	);
+
 /**
  * Asynchronously scan the records in the specified namespace and set in the cluster.
  *
@@ -17,7 +17,11 @@
 #pragma once
 
 #include <aerospike/aerospike.h>
+#include <aerospike/as_hot_keys.h>
+#include <aerospike/as_latency.h>
+#include <aerospike/as_memory.h>
 #include <aerospike/as_node.h>
+#include <string.h>
 
 /**
  * @defgroup cluster_stats Cluster Statistics
@@ -60,6 +64,28 @@ typedef struct as_conn_stats_s {
 	 */
 	uint32_t closed;
 
+	/**
+	 * Total number of node connections opened with kernel TLS (kTLS) offload since node
+	 * creation.  Only tracked for sync connections.
+	 */
+	uint32_t ktls;
+
+	/**
+	 * Connections closed because they were idle too long.  Only tracked for sync connections.
+	 */
+	uint32_t closed_idle;
+
+	/**
+	 * Connections closed after an error.  Only tracked for sync connections.
+	 */
+	uint32_t closed_error;
+
+	/**
+	 * Connections closed to trim pools down to their size limits.  Only tracked for sync
+	 * connections.
+	 */
+	uint32_t closed_balance;
+
 } as_conn_stats;
 
 /**
@@ -92,6 +118,23 @@ typedef struct as_node_stats_s {
 	 */
 	uint32_t error_count;
 
+	/**
+	 * Command latency histograms by command type since node creation. See
+	 * AS_LATENCY_BUCKETS for bucket ranges. All zero unless as_config.latency_stats is set.
+	 */
+	uint64_t latency[AS_LATENCY_TYPE_MAX][AS_LATENCY_BUCKETS];
+
+	/**
+	 * Sync connection latency histograms by connection phase since node creation. All zero
+	 * unless as_config.latency_stats is set.
+	 */
+	uint64_t conn_latency[AS_CONN_LATENCY_MAX][AS_LATENCY_BUCKETS];
+
+	/**
+	 * Command and byte counters since node creation.
+	 */
+	as_command_counters counters;
+
 } as_node_stats;
 
 /**
@@ -111,6 +154,39 @@ typedef struct as_event_loop_stats_s {
 	 */
 	uint32_t queue_size;
 
+	/**
+	 * Number of commands created in the event loop thread that reused a cached allocation.
+	 */
+	uint64_t slab_hits;
+
+	/**
+	 * Number of commands that were allocated from the heap because no cached allocation was
+	 * available or the command was created outside the event loop thread.
+	 */
+	uint64_t slab_misses;
+
+	/**
+	 * Bytes currently held in this event loop's command allocation cache.
+	 */
+	uint64_t slab_resident;
+
+	/**
+	 * Command and byte counters of commands run on this event loop.
+	 */
+	as_command_counters counters;
+
+	/**
+	 * Event loop lag histogram. See AS_LATENCY_BUCKETS for bucket ranges. All zero unless
+	 * as_policy_event.lag_interval_ms is set.
+	 */
+	uint64_t lag[AS_LATENCY_BUCKETS];
+
+	/**
+	 * Listener callback duration histogram. See AS_LATENCY_BUCKETS for bucket ranges. All
+	 * zero unless as_policy_event.callback_stats or slow_callback_us is set.
+	 */
+	uint64_t callbacks[AS_LATENCY_BUCKETS];
+
 } as_event_loop_stats;
 
 /**
@@ -144,6 +220,68 @@ typedef struct as_cluster_stats_s {
 	 */
 	uint32_t thread_pool_queued_tasks;
 
+	/**
+	 * Number of sync batch/scan/query tasks that have started since cluster creation.
+	 */
+	uint64_t thread_pool_wait_count;
+
+	/**
+	 * Total microseconds that started sync batch/scan/query tasks waited in the thread pool
+	 * queue. Divide by thread_pool_wait_count for the average queue wait.
+	 */
+	uint64_t thread_pool_wait_us;
+
+	/**
+	 * Retries that were not attempted because the cluster wide retry budget was exhausted.
+	 * Always zero when as_config.retry_budget_percent is zero.
+	 */
+	uint64_t retry_budget_rejects;
+
+	/**
+	 * Retries currently available in the retry budget.
+	 */
+	uint32_t retry_budget_tokens;
+
+	/**
+	 * Milliseconds from cluster creation until the first cluster tend completed.  Zero while
+	 * an as_config.connect_async cluster is still connecting.
+	 */
+	uint64_t startup_ms;
+
+	/**
+	 * Most frequently accessed keys in descending count order.  Only the first hot_keys_size
+	 * entries are valid.  Empty when as_config.hot_key_sample_rate is zero.
+	 */
+	as_hot_key hot_keys[AS_HOT_KEYS_TOP];
+
+	/**
+	 * Most frequently accessed partitions in descending count order.  Entry digests are
+	 * zero.  Only the first hot_partitions_size entries are valid.
+	 */
+	as_hot_key hot_partitions[AS_HOT_KEYS_TOP];
+
+	/**
+	 * Number of valid hot_keys entries.
+	 */
+	uint32_t hot_keys_size;
+
+	/**
+	 * Number of valid hot_partitions entries.
+	 */
+	uint32_t hot_partitions_size;
+
+	/**
+	 * Process wide heap memory by client subsystem, indexed by as_memory_tag.  All zero when
+	 * the client was built with AS_NO_MEMORY_STATS.
+	 */
+	as_memory_usage memory[AS_MEMORY_MAX];
+
+	/**
+	 * @private
+	 * Allocated entries of nodes. Used by aerospike_cluster_stats_update().
+	 */
+	uint32_t nodes_capacity;
+
 } as_cluster_stats;
 
 struct as_cluster_s;
@@ -162,6 +300,21 @@ struct as_cluster_s;
  */
 AS_EXTERN void
 aerospike_cluster_stats(struct as_cluster_s* cluster, as_cluster_stats* stats);
+
+/**
+ * Refresh aerospike cluster statistics in place.  Node references from the previous
+ * refresh are released and the node and event loop arrays are reused.  Arrays are only
+ * reallocated when the cluster has more nodes than before, so periodic refreshes
+ * normally do not allocate.  stats must either be zeroed before the first refresh or
+ * be filled by aerospike_cluster_stats().  Call aerospike_stats_destroy() when done.
+ *
+ * @param cluster	The aerospike cluster.
+ * @param stats		The statistics summary to refresh.
+ *
+ * @ingroup cluster_stats
+ */
+AS_EXTERN void
+aerospike_cluster_stats_update(struct as_cluster_s* cluster, as_cluster_stats* stats);
 	
 /**
  * Retrieve aerospike client instance statistics.
@@ -231,6 +384,12 @@ aerospike_event_loop_stats(as_event_loop* event_loop, as_event_loop_stats* stats
 	// Warning: cross-thread references without a lock.
 	stats->process_size = as_event_loop_get_process_size(event_loop);
 	stats->queue_size = as_event_loop_get_queue_size(event_loop);
+	stats->slab_hits = event_loop->slab.hits;
+	stats->slab_misses = event_loop->slab.misses + event_loop->slab.remote;
+	stats->slab_resident = event_loop->slab.resident;
+	stats->counters = event_loop->counters;
+	memcpy(stats->lag, event_loop->lag_hist, sizeof(stats->lag));
+	memcpy(stats->callbacks, event_loop->callback_hist, sizeof(stats->callbacks));
 }
 
 /**
@@ -242,6 +401,24 @@ aerospike_event_loop_stats(as_event_loop* event_loop, as_event_loop_stats* stats
 AS_EXTERN char*
 aerospike_stats_to_string(as_cluster_stats* stats);
 
+/**
+ * Render cluster statistics in Prometheus/OpenMetrics text exposition format into a caller
+ * buffer.  Metric names start with "aerospike_client_".  Histograms use microsecond bucket
+ * bounds and have no _sum series.  The output is null terminated and truncated if it does
+ * not fit.  No memory is allocated.
+ *
+ * @param stats		The cluster statistics summary.
+ * @param buf		Output buffer.
+ * @param size		Output buffer size in bytes.
+ *
+ * @return Length of the full output excluding the null terminator.  The output was
+ * truncated if the return value is greater than or equal to size.
+ *
+ * @ingroup cluster_stats
+ */
+AS_EXTERN size_t
+aerospike_stats_to_prometheus(as_cluster_stats* stats, char* buf, size_t size);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
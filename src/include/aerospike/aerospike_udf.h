@@ -227,6 +227,45 @@ aerospike_udf_remove_wait(
 	const char* filename, uint32_t interval_ms
 	);
 
+/**
+ * Make sure a UDF file with the given content is registered on all nodes.  The content hash
+ * is compared with the hash in each node's "udf-list" response.  The file is uploaded and
+ * waited for only if a node does not have the same content.  Content that was verified this
+ * way is remembered by the client, so later calls with the same file and content return
+ * without contacting the server.  aerospike_udf_remove() forgets the file.
+ *
+ * Use this function instead of aerospike_udf_put() and aerospike_udf_put_wait() when many
+ * client processes register the same modules at startup.
+ *
+ * ~~~~~~~~~~{.c}
+ * bool uploaded;
+ *
+ * if (aerospike_udf_ensure(&as, &err, NULL, "my.lua", AS_UDF_TYPE_LUA, &content, 0,
+ *         &uploaded) != AEROSPIKE_OK) {
+ *     fprintf(stderr, "error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param filename		The name of the UDF file.
+ * @param type			The type of UDF file.
+ * @param content		The content of the UDF file.
+ * @param interval_ms	The polling interval in milliseconds when waiting for an upload. If zero,
+ *						1000 ms is used.
+ * @param uploaded		If not NULL, set to true if the file was uploaded.
+ *
+ * @return AEROSPIKE_OK if the file is registered on all nodes. Otherwise an error occurred.
+ *
+ * @ingroup udf_operations
+ */
+AS_EXTERN as_status
+aerospike_udf_ensure(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* filename,
+	as_udf_type type, as_bytes* content, uint32_t interval_ms, bool* uploaded
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Combine two partial aggregation results into one. The function takes ownership of
+ * v1 and v2 and returns the combined result, which may be v1 or v2. Return NULL to
+ * abort the query with AEROSPIKE_ERR_UDF.
+ *
+ * The function is called from multiple node threads, but never concurrently for the
+ * same query.
+ *
+ * @ingroup query_operations
+ */
+typedef as_val* (*as_aggregate_merge_fn)(as_val* v1, as_val* v2, void* udata);
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Register a native client side stage for a stream UDF. When aerospike_query_foreach()
+ * runs an aggregation query with the given module and function, the server side stages
+ * still run in Lua on the server nodes, but the partial results returned by the nodes
+ * are combined with merge instead of the client Lua stage. The user callback receives the
+ * combined result followed by NULL. If no node returns a value, only NULL is received.
+ *
+ * The stream must end in a reduce() that is equivalent to merge. Registering the same
+ * module and function again replaces the previous merge function.
+ *
+ * ~~~~~~~~~~{.c}
+ * static as_val*
+ * sum_merge(as_val* v1, as_val* v2, void* udata)
+ * {
+ *     int64_t sum = as_integer_get((as_integer*)v1) + as_integer_get((as_integer*)v2);
+ *     as_val_destroy(v1);
+ *     as_val_destroy(v2);
+ *     return (as_val*)as_integer_new(sum);
+ * }
+ *
+ * as_aggregate_register("stream_udf", "sum", sum_merge, NULL);
+ * ~~~~~~~~~~
+ *
+ * @param module		UDF module name.
+ * @param function		UDF function name.
+ * @param merge			Native merge function.
+ * @param udata			User data passed to merge.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN void
+as_aggregate_register(
+	const char* module, const char* function, as_aggregate_merge_fn merge, void* udata
+	);
+
+/**
+ * Remove native client side stage for module and function. Aggregation queries started
+ * afterwards use the client Lua stage again.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN void
+as_aggregate_unregister(const char* module, const char* function);
+
+/**
+ * @private
+ * Find native merge function for module and function. Return false if not registered.
+ */
+bool
+as_aggregate_find(
+	const char* module, const char* function, as_aggregate_merge_fn* merge, void** udata
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <citrusleaf/alloc.h>
+
+#if !defined(_MSC_VER)
+#include <stdlib.h>
+#else
+#include <malloc.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Custom allocator callbacks used for the client's command, response and event loop buffers.
+ *
+ * malloc, calloc, realloc and free must either all be set, or all be NULL to use cf_malloc()
+ * and friends.  free_sized and aligned_alloc are optional.  Memory returned by aligned_alloc
+ * is released with free.
+ *
+ * Records, values and other memory handed to the caller are still allocated with cf_malloc(),
+ * because they may be released by aerospike-common.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_allocator_s {
+	/**
+	 * Allocate size bytes.
+	 */
+	void* (*malloc)(size_t size);
+
+	/**
+	 * Allocate n zeroed elements of size bytes.
+	 */
+	void* (*calloc)(size_t n, size_t size);
+
+	/**
+	 * Resize allocation.
+	 */
+	void* (*realloc)(void* ptr, size_t size);
+
+	/**
+	 * Free allocation.
+	 */
+	void (*free)(void* ptr);
+
+	/**
+	 * Optional free that is passed the size of the allocation, so allocators like jemalloc
+	 * can skip the size lookup.  The size is the size originally passed to malloc.
+	 */
+	void (*free_sized)(void* ptr, size_t size);
+
+	/**
+	 * Optional allocation of size bytes aligned to alignment, which is a power of 2.
+	 */
+	void* (*aligned_alloc)(size_t alignment, size_t size);
+} as_allocator;
+
+/******************************************************************************
+ * GLOBAL VARIABLES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Installed allocator.  All callbacks are NULL by default.
+ */
+extern as_allocator as_allocator_hooks;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Install custom allocator callbacks.  Pass NULL to restore the default allocator.
+ *
+ * This setting is process wide.  It must be called before the first client is created and
+ * must not be changed while any client exists, because memory allocated by one allocator
+ * would be released by another.
+ *
+ * @return false if some of malloc, calloc, realloc and free are missing.
+ */
+AS_EXTERN bool
+as_allocator_set(const as_allocator* allocator);
+
+/**
+ * @private
+ * Allocate size bytes.
+ */
+static inline void*
+as_alloc_malloc(size_t size)
+{
+	if (as_allocator_hooks.malloc) {
+		return as_allocator_hooks.malloc(size);
+	}
+	return cf_malloc(size);
+}
+
+/**
+ * @private
+ * Allocate n zeroed elements of size bytes.
+ */
+static inline void*
+as_alloc_calloc(size_t n, size_t size)
+{
+	if (as_allocator_hooks.calloc) {
+		return as_allocator_hooks.calloc(n, size);
+	}
+	return cf_calloc(n, size);
+}
+
+/**
+ * @private
+ * Resize allocation.
+ */
+static inline void*
+as_alloc_realloc(void* ptr, size_t size)
+{
+	if (as_allocator_hooks.realloc) {
+		return as_allocator_hooks.realloc(ptr, size);
+	}
+	return cf_realloc(ptr, size);
+}
+
+/**
+ * @private
+ * Free allocation.
+ */
+static inline void
+as_alloc_free(void* ptr)
+{
+	if (as_allocator_hooks.free) {
+		as_allocator_hooks.free(ptr);
+		return;
+	}
+	cf_free(ptr);
+}
+
+/**
+ * @private
+ * Free allocation of size bytes.
+ */
+static inline void
+as_alloc_free_sized(void* ptr, size_t size)
+{
+	if (as_allocator_hooks.free_sized) {
+		as_allocator_hooks.free_sized(ptr, size);
+		return;
+	}
+	as_alloc_free(ptr);
+}
+
+/**
+ * @private
+ * Allocate size bytes aligned to alignment, which is a power of 2 and a multiple of
+ * sizeof(void*).  Release with as_alloc_aligned_free().
+ */
+static inline void*
+as_alloc_aligned(size_t alignment, size_t size)
+{
+	if (as_allocator_hooks.aligned_alloc) {
+		return as_allocator_hooks.aligned_alloc(alignment, size);
+	}
+
+#if defined(_MSC_VER)
+	return _aligned_malloc(size, alignment);
+#else
+	void* ptr;
+	return (posix_memalign(&ptr, alignment, size) == 0) ? ptr : NULL;
+#endif
+}
+
+/**
+ * @private
+ * Free allocation returned by as_alloc_aligned().
+ */
+static inline void
+as_alloc_aligned_free(void* ptr)
+{
+	if (as_allocator_hooks.aligned_alloc) {
+		as_allocator_hooks.free(ptr);
+		return;
+	}
+
+#if defined(_MSC_VER)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Arena chunk.  Chunks are linked into a list that is freed at once.  Memory is taken from
+ * the chunk by one thread at a time, but chunks may be pushed onto a list concurrently.
+ */
+typedef struct as_arena_chunk_s {
+	/**
+	 * Next chunk in list.
+	 */
+	struct as_arena_chunk_s* next;
+
+	/**
+	 * Bytes available in data.
+	 */
+	uint32_t capacity;
+
+	/**
+	 * Bytes used in data.
+	 */
+	uint32_t offset;
+
+	/**
+	 * Chunk memory.
+	 */
+	uint8_t data[];
+} as_arena_chunk;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create chunk with capacity bytes.  Returns NULL on allocation failure.
+ */
+as_arena_chunk*
+as_arena_chunk_create(uint32_t capacity);
+
+/**
+ * @private
+ * Push chunk onto list.  Safe to call from multiple threads.
+ */
+void
+as_arena_push(as_arena_chunk** head, as_arena_chunk* chunk);
+
+/**
+ * @private
+ * Free all chunks in list.  Return bytes freed, so callers can account arena memory.
+ */
+size_t
+as_arena_destroy(as_arena_chunk* head);
+
+/**
+ * @private
+ * Take 8 byte aligned memory from chunk.  Returns NULL if the chunk is full.
+ */
+static inline void*
+as_arena_alloc(as_arena_chunk* chunk, uint32_t size)
+{
+	uint32_t offset = (chunk->offset + 7) & ~7;
+
+	if (size > chunk->capacity || offset > chunk->capacity - size) {
+		return NULL;
+	}
+	chunk->offset = offset + size;
+	return chunk->data + offset;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_arena.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Deserialize msgpack list or map into a value tree whose nodes and scalar contents are
+ * allocated from arena chunks.  Only hash map buckets are allocated on the heap.  Chunks are
+ * pushed onto arena, which must be freed after the value is destroyed.  Values can not be
+ * reserved beyond the lifetime of the arena.
+ *
+ * Returns 0 on success.  Returns non-zero if the value uses msgpack extensions that are
+ * not supported here, in which case the caller should use the regular deserializer.
+ */
+int
+as_arena_unpack_val(as_arena_chunk** arena, const uint8_t* buf, uint32_t size, as_val** value);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
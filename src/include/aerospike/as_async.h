@@ -40,6 +40,9 @@ extern "C" {
 #define AS_ASYNC_TYPE_SCAN_PARTITION 7
 #define AS_ASYNC_TYPE_QUERY_PARTITION 8
 #define AS_ASYNC_TYPE_CONNECTOR 9
+#define AS_ASYNC_TYPE_WHEEL 10
+#define AS_ASYNC_TYPE_AUTO_BATCH 11
+#define AS_ASYNC_TYPE_LAG 12
 
 #define AS_AUTHENTICATION_MAX_SIZE 158
 
@@ -86,18 +89,22 @@ as_async_write_command_create(
 	// Allocate enough memory to cover: struct size + write buffer size + auth max buffer size
 	// Then, round up memory size in 1KB increments.
 	size_t s = (sizeof(as_async_write_command) + size + AS_AUTHENTICATION_MAX_SIZE + 1023) & ~1023;
-	as_event_command* cmd = (as_event_command*)cf_malloc(s);
+	as_event_loop* loop = as_event_assign(event_loop);
+	uint8_t slab_class;
+	as_event_command* cmd = (as_event_command*)as_event_slab_alloc(loop, &s, &slab_class);
 	as_async_write_command* wcmd = (as_async_write_command*)cmd;
 	cmd->total_deadline = policy->total_timeout;
 	cmd->socket_timeout = policy->socket_timeout;
 	cmd->max_retries = policy->max_retries;
 	cmd->iteration = 0;
 	cmd->replica = replica;
-	cmd->event_loop = as_event_assign(event_loop);
+	cmd->event_loop = loop;
 	cmd->cluster = cluster;
 	cmd->node = NULL;
 	cmd->ns = ns;
 	cmd->partition = partition;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
 	cmd->udata = udata;
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
@@ -107,7 +114,9 @@ as_async_write_command_create(
 	cmd->proto_type = AS_MESSAGE_TYPE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
-	cmd->flags2 = 0;
+	cmd->flags2 = (slab_class != AS_EVENT_SLAB_NONE) ? AS_ASYNC_FLAGS2_SLAB : 0;
+	cmd->priority = (uint8_t)policy->priority;
+	cmd->slab_class = slab_class;
 	wcmd->listener = listener;
 	return cmd;
 }
@@ -124,18 +133,22 @@ as_async_record_command_create(
 	// Then, round up memory size in 4KB increments to reduce fragmentation and to allow socket
 	// read to reuse buffer for small socket write sizes.
 	size_t s = (sizeof(as_async_record_command) + size + AS_AUTHENTICATION_MAX_SIZE + 4095) & ~4095;
-	as_event_command* cmd = (as_event_command*)cf_malloc(s);
+	as_event_loop* loop = as_event_assign(event_loop);
+	uint8_t slab_class;
+	as_event_command* cmd = (as_event_command*)as_event_slab_alloc(loop, &s, &slab_class);
 	as_async_record_command* rcmd = (as_async_record_command*)cmd;
 	cmd->total_deadline = policy->total_timeout;
 	cmd->socket_timeout = policy->socket_timeout;
 	cmd->max_retries = policy->max_retries;
 	cmd->iteration = 0;
 	cmd->replica = replica;
-	cmd->event_loop = as_event_assign(event_loop);
+	cmd->event_loop = loop;
 	cmd->cluster = cluster;
 	cmd->node = NULL;
 	cmd->ns = ns;
 	cmd->partition = partition;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
 	cmd->udata = udata;
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
@@ -145,7 +158,9 @@ as_async_record_command_create(
 	cmd->proto_type = AS_MESSAGE_TYPE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
-	cmd->flags2 = 0;
+	cmd->flags2 = (slab_class != AS_EVENT_SLAB_NONE) ? AS_ASYNC_FLAGS2_SLAB : 0;
+	cmd->priority = (uint8_t)policy->priority;
+	cmd->slab_class = slab_class;
 	if (deserialize) {
 		cmd->flags2 |= AS_ASYNC_FLAGS2_DESERIALIZE;
 	}
@@ -168,18 +183,22 @@ as_async_value_command_create(
 	// Then, round up memory size in 4KB increments to reduce fragmentation and to allow socket
 	// read to reuse buffer for small socket write sizes.
 	size_t s = (sizeof(as_async_value_command) + size + AS_AUTHENTICATION_MAX_SIZE + 4095) & ~4095;
-	as_event_command* cmd = (as_event_command*)cf_malloc(s);
+	as_event_loop* loop = as_event_assign(event_loop);
+	uint8_t slab_class;
+	as_event_command* cmd = (as_event_command*)as_event_slab_alloc(loop, &s, &slab_class);
 	as_async_value_command* vcmd = (as_async_value_command*)cmd;
 	cmd->total_deadline = policy->total_timeout;
 	cmd->socket_timeout = policy->socket_timeout;
 	cmd->max_retries = policy->max_retries;
 	cmd->iteration = 0;
 	cmd->replica = replica;
-	cmd->event_loop = as_event_assign(event_loop);
+	cmd->event_loop = loop;
 	cmd->cluster = cluster;
 	cmd->node = NULL;
 	cmd->ns = ns;
 	cmd->partition = partition;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
 	cmd->udata = udata;
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
@@ -189,7 +208,9 @@ as_async_value_command_create(
 	cmd->proto_type = AS_MESSAGE_TYPE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
-	cmd->flags2 = 0;
+	cmd->flags2 = (slab_class != AS_EVENT_SLAB_NONE) ? AS_ASYNC_FLAGS2_SLAB : 0;
+	cmd->priority = (uint8_t)policy->priority;
+	cmd->slab_class = slab_class;
 	vcmd->listener = listener;
 	return cmd;
 }
@@ -203,18 +224,22 @@ as_async_info_command_create(
 	// Allocate enough memory to cover: struct size + write buffer size + auth max buffer size
 	// Then, round up memory size in 1KB increments.
 	size_t s = (sizeof(as_async_info_command) + size + AS_AUTHENTICATION_MAX_SIZE + 1023) & ~1023;
-	as_event_command* cmd = (as_event_command*)cf_malloc(s);
+	as_event_loop* loop = as_event_assign(event_loop);
+	uint8_t slab_class;
+	as_event_command* cmd = (as_event_command*)as_event_slab_alloc(loop, &s, &slab_class);
 	as_async_info_command* icmd = (as_async_info_command*)cmd;
 	cmd->total_deadline = policy->timeout;
 	cmd->socket_timeout = policy->timeout;
 	cmd->max_retries = 1;
 	cmd->iteration = 0;
 	cmd->replica = AS_POLICY_REPLICA_MASTER;
-	cmd->event_loop = as_event_assign(event_loop);
+	cmd->event_loop = loop;
 	cmd->cluster = node->cluster;
 	cmd->node = node;
 	cmd->ns = NULL;
 	cmd->partition = NULL;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
 	cmd->udata = udata;
 	cmd->parse_results = as_event_command_parse_info;
 	cmd->pipe_listener = NULL;
@@ -224,7 +249,9 @@ as_async_info_command_create(
 	cmd->proto_type = AS_INFO_MESSAGE_TYPE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = AS_ASYNC_FLAGS_MASTER;
-	cmd->flags2 = 0;
+	cmd->flags2 = (slab_class != AS_EVENT_SLAB_NONE) ? AS_ASYNC_FLAGS2_SLAB : 0;
+	cmd->priority = AS_POLICY_PRIORITY_NORMAL;
+	cmd->slab_class = slab_class;
 	icmd->listener = listener;
 	return cmd;
 }
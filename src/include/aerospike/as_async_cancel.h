@@ -0,0 +1,151 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_event_loop;
+struct as_event_executor;
+struct as_node_s;
+
+/**
+ * Cancellation handle for async scans and queries.
+ *
+ * as_async_cancel_request() stops the scan/query that currently uses the handle. The client
+ * sends a query-abort info command with the scan/query transaction id to every node that
+ * runs a node command, so server threads are freed at once. Records that are still in
+ * flight are discarded and the listener is called once with AEROSPIKE_ERR_CLIENT_ABORT
+ * after all node commands ended.
+ *
+ * Queries with a filter against servers without partition query support are only cancelled
+ * on the client.  Batch commands have no server task to abort and are not supported.
+ *
+ * A handle can be used by one async scan or query at a time. Assign the handle to
+ * as_policy_scan.cancel or as_policy_query.cancel before starting the scan/query.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_async_cancel* cancel = as_async_cancel_create();
+ *
+ * as_policy_scan p;
+ * as_policy_scan_init(&p);
+ * p.cancel = cancel;
+ *
+ * aerospike_scan_async(&as, &err, &p, &scan, NULL, listener, NULL, NULL);
+ *
+ * // In any thread.
+ * as_async_cancel_request(cancel);
+ *
+ * // After the listener received the end of scan.
+ * as_async_cancel_destroy(cancel);
+ * ~~~~~~~~~~
+ *
+ * @ingroup async_events
+ */
+typedef struct as_async_cancel_s {
+	/**
+	 * @private
+	 * Executor of the scan/query that currently uses the handle. Only accessed in the
+	 * executor's event loop.
+	 */
+	struct as_event_executor* executor;
+
+	/**
+	 * @private
+	 * Event loop of the scan/query that last used the handle.
+	 */
+	struct as_event_loop* event_loop;
+
+	/**
+	 * @private
+	 * Send server abort for the executor.  NULL if the server task can't be aborted.
+	 */
+	void (*abort_fn)(struct as_event_executor* executor);
+
+	/**
+	 * @private
+	 * Set when cancel has been requested.
+	 */
+	uint32_t cancelled;
+
+	/**
+	 * @private
+	 * Reference count.  The application, active executors and scheduled cancels each
+	 * hold a reference.
+	 */
+	uint32_t refs;
+} as_async_cancel;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Create cancellation handle.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN as_async_cancel*
+as_async_cancel_create(void);
+
+/**
+ * Release handle reference held by the application. The handle is freed when scans/queries
+ * that used it no longer reference it.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_cancel_destroy(as_async_cancel* cancel);
+
+/**
+ * Cancel the scan/query that uses the handle.  A scan/query that starts after this call is
+ * cancelled as soon as it starts.  Can be called from any thread and more than once.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_cancel_request(as_async_cancel* cancel);
+
+/**
+ * Return true if cancel has been requested.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN bool
+as_async_cancel_requested(as_async_cancel* cancel);
+
+/**
+ * @private
+ * Send abort info command for the scan/query transaction id to each node.  module is
+ * "scan" or "query" and is only used for servers without partition query support.
+ */
+void
+as_async_cancel_abort_nodes(
+	struct as_event_loop* event_loop, const char* module, uint64_t task_id,
+	struct as_node_s** nodes, uint32_t n_nodes
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_event_loop;
+struct as_event_executor;
+
+/**
+ * Credit based flow control for async scans and queries.
+ *
+ * Each record passed to the async record listener counts as buffered until the application
+ * calls as_async_flow_release() for it. When the buffered count reaches high_watermark,
+ * the client stops reading node connections of the scan/query after the current response
+ * block, so TCP backpressure reaches the server. Reading resumes when the buffered count
+ * drops to low_watermark.
+ *
+ * A flow can be used by one async scan or query at a time. Assign the flow to
+ * as_policy_scan.flow or as_policy_query.flow before starting the scan/query.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_async_flow* flow = as_async_flow_create(1000, 10000);
+ *
+ * as_policy_scan p;
+ * as_policy_scan_init(&p);
+ * p.flow = flow;
+ *
+ * aerospike_scan_async(&as, &err, &p, &scan, NULL, listener, flow, NULL);
+ *
+ * // In consumer thread, after each queued record has been processed.
+ * as_async_flow_release(flow, 1);
+ *
+ * // After the listener received the end of scan and the consumer is done.
+ * as_async_flow_destroy(flow);
+ * ~~~~~~~~~~
+ *
+ * Flow control is not available for TLS connections with libuv and for the io_uring
+ * event loop. Records are delivered without limit in those configurations.
+ *
+ * @ingroup async_events
+ */
+typedef struct as_async_flow_s {
+	/**
+	 * @private
+	 * Executor of the scan/query that currently uses the flow. Only accessed in the
+	 * executor's event loop.
+	 */
+	struct as_event_executor* executor;
+
+	/**
+	 * @private
+	 * Event loop of the scan/query that last used the flow.
+	 */
+	struct as_event_loop* event_loop;
+
+	/**
+	 * Resume reading when buffered record count drops to this value.
+	 */
+	uint32_t low_watermark;
+
+	/**
+	 * Pause reading when buffered record count reaches this value.
+	 */
+	uint32_t high_watermark;
+
+	/**
+	 * @private
+	 * Records passed to the listener and not released yet.
+	 */
+	uint32_t buffered;
+
+	/**
+	 * @private
+	 * Set when at least one node command is paused and no resume has been scheduled.
+	 */
+	uint32_t paused;
+
+	/**
+	 * @private
+	 * Reference count.  The application, active executors and scheduled resumes each
+	 * hold a reference.
+	 */
+	uint32_t refs;
+} as_async_flow;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Create flow control with given watermarks. low_watermark must be less than
+ * high_watermark.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN as_async_flow*
+as_async_flow_create(uint32_t low_watermark, uint32_t high_watermark);
+
+/**
+ * Release flow reference held by the application. The flow is freed when scans/queries
+ * that used it no longer reference it.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_flow_destroy(as_async_flow* flow);
+
+/**
+ * Mark n_records delivered records as consumed. Paused node commands are resumed in their
+ * event loop when the buffered count drops to low_watermark. Can be called from any thread.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_flow_release(as_async_flow* flow, uint32_t n_records);
+
+/**
+ * Return records passed to the listener and not released yet.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN uint32_t
+as_async_flow_buffered(as_async_flow* flow);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
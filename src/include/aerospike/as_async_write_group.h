@@ -0,0 +1,213 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_event_loop;
+
+/**
+ * Aggregate result of an async write group.
+ *
+ * @ingroup async_events
+ */
+typedef struct as_async_write_group_result_s {
+	/**
+	 * Writes that succeeded since the group was created.
+	 */
+	uint64_t succeeded;
+
+	/**
+	 * Writes that failed since the group was created.
+	 */
+	uint64_t failed;
+
+	/**
+	 * First errors since the previous flush, up to the group's max_errors.
+	 */
+	as_error* errors;
+
+	/**
+	 * Number of errors in the errors array.
+	 */
+	uint32_t n_errors;
+} as_async_write_group_result;
+
+struct as_async_write_group_s;
+
+/**
+ * Called once after as_async_write_group_flush() when no write of the group is in flight.
+ * The result is only valid during the call.
+ *
+ * @ingroup async_events
+ */
+typedef void (*as_async_write_group_listener)(
+	struct as_async_write_group_s* group, as_async_write_group_result* result, void* udata,
+	struct as_event_loop* event_loop
+	);
+
+/**
+ * Shared completion state for fire-and-forget async writes.
+ *
+ * Writes started with aerospike_key_put_group_async() or aerospike_key_remove_group_async()
+ * have no per-command listener.  Each completion only updates the group's counters and, on
+ * failure, keeps a sample of the error.  The group listener is called once per flush, after
+ * all writes of the group completed.
+ *
+ * ~~~~~~~~~~{.c}
+ * void group_listener(as_async_write_group* group, as_async_write_group_result* result,
+ *     void* udata, as_event_loop* event_loop)
+ * {
+ *     printf("ok=%" PRIu64 " failed=%" PRIu64 "\n", result->succeeded, result->failed);
+ * }
+ *
+ * as_async_write_group* group = as_async_write_group_create(10, group_listener, NULL);
+ *
+ * for (uint32_t i = 0; i < n; i++) {
+ *     aerospike_key_put_group_async(&as, &err, NULL, &keys[i], &recs[i], group, NULL, NULL);
+ * }
+ * as_async_write_group_flush(group);
+ *
+ * // After the group listener was called.
+ * as_async_write_group_destroy(group);
+ * ~~~~~~~~~~
+ *
+ * @ingroup async_events
+ */
+typedef struct as_async_write_group_s {
+	/**
+	 * @private
+	 * Protects the error samples.
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @private
+	 * Error samples since the previous flush.
+	 */
+	as_error* errors;
+
+	/**
+	 * @private
+	 */
+	as_async_write_group_listener listener;
+
+	/**
+	 * @private
+	 */
+	void* udata;
+
+	/**
+	 * @private
+	 * Writes in flight.  A flush holds one extra count while it is being set up.
+	 */
+	uint64_t pending;
+
+	/**
+	 * @private
+	 */
+	uint64_t succeeded;
+
+	/**
+	 * @private
+	 */
+	uint64_t failed;
+
+	/**
+	 * Maximum error samples kept between flushes.
+	 */
+	uint32_t max_errors;
+
+	/**
+	 * @private
+	 */
+	uint32_t n_errors;
+
+	/**
+	 * @private
+	 * Set while a flush waits for in flight writes.
+	 */
+	uint32_t flushing;
+} as_async_write_group;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Create write group that keeps up to max_errors error samples between flushes.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN as_async_write_group*
+as_async_write_group_create(
+	uint32_t max_errors, as_async_write_group_listener listener, void* udata
+	);
+
+/**
+ * Destroy write group.  Must not be called while writes of the group are in flight.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_write_group_destroy(as_async_write_group* group);
+
+/**
+ * Call the group listener once after all writes that are in flight completed.  Writes
+ * started before the listener is called are also waited for.  The listener is called in the
+ * calling thread if no write is in flight.  Do not call again before the listener was called.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_async_write_group_flush(as_async_write_group* group);
+
+/**
+ * Return writes of the group that are in flight.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN uint64_t
+as_async_write_group_pending(as_async_write_group* group);
+
+/**
+ * @private
+ * Account for a write that is about to start.
+ */
+void
+as_async_write_group_begin(as_async_write_group* group);
+
+/**
+ * @private
+ * Write listener of commands that belong to a group.  Also called with the start error when
+ * a write could not be started.
+ */
+void
+as_async_write_group_complete(as_error* err, void* udata, struct as_event_loop* event_loop);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
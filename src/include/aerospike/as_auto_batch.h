@@ -0,0 +1,83 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/as_event_internal.h>
+#include <aerospike/as_listener.h>
+#include <aerospike/as_policy.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Listener of one merged read.  Entries are stored in the same order as the batch records.
+ */
+typedef struct as_auto_batch_entry_s {
+	as_async_record_listener listener;
+	void* udata;
+} as_auto_batch_entry;
+
+/**
+ * @private
+ * Per event loop collector of async single key reads.  Reads with matching policies are
+ * appended to the current batch until the window timer fires or the batch is full.  Only
+ * accessed in the event loop thread.
+ */
+typedef struct as_auto_batch_s {
+	// Must be first field, so the auto batch can be freed from the driver's timer handle.
+	as_event_command driver;
+	aerospike* as;
+	as_policy_read policy;
+	as_batch_records* records;
+	as_auto_batch_entry* entries;
+	bool armed;
+} as_auto_batch;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Queue async single key read on the event loop's auto batch.  bins is NULL to read all bins.
+ * The key digest must already be computed.
+ */
+as_status
+as_auto_batch_read(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const char* bins[], uint32_t n_bins, as_async_record_listener listener, void* udata,
+	as_event_loop* event_loop
+	);
+
+/**
+ * @private
+ * Free reads that were never sent.  Listeners are not called.
+ */
+void
+as_auto_batch_release(as_auto_batch* ab);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
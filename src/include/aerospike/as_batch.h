@@ -215,6 +215,21 @@ as_batch_keyat(const as_batch* batch, uint32_t i)
 	return (batch != NULL && batch->keys.entries != NULL && batch->keys.size > i) ? &batch->keys.entries[i] : NULL;
 }
 
+/**
+ * Set namespace ID returned by aerospike_namespace_id() on all keys in the batch.
+ * Call after the keys are initialized.
+ *
+ * @relates as_batch
+ * @ingroup batch_object
+ */
+static inline void
+as_batch_set_namespace_id(as_batch* batch, uint32_t ns_id)
+{
+	for (uint32_t i = 0; i < batch->keys.size; i++) {
+		batch->keys.entries[i].ns_id = ns_id;
+	}
+}
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
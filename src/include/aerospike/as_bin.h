@@ -52,6 +52,31 @@ extern "C" {
  */
 typedef char as_bin_name[AS_BIN_NAME_MAX_SIZE];
 
+/**
+ * Interned bin name.  Create with as_bin_handle_intern() once and pass the handle to
+ * as_record_set_handle(), as_record_get_handle() and the as_operations handle functions,
+ * so bin names are not measured and compared one character at a time on every command.
+ * Equal names always return the same handle.  Handles are never freed.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_bin_handle_s {
+	/**
+	 * Bin name padded with null bytes to AS_BIN_NAME_MAX_SIZE.
+	 */
+	as_bin_name name;
+
+	/**
+	 * Hash of the bin name.
+	 */
+	uint32_t hash;
+
+	/**
+	 * Length of the bin name.
+	 */
+	uint8_t len;
+} as_bin_handle;
+
 /**
  * Bin Value
  */
@@ -123,8 +148,35 @@ typedef struct as_bins_s {
 	 */
 	bool _free;
 
+	/**
+	 * @private
+	 * If true, then entries are stored in a shared as_bin_block that as_record_destroy()
+	 * will release.
+	 */
+	bool _block;
+
 } as_bins;
 
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Return the interned handle of a bin name.  Safe to call from multiple threads.
+ *
+ * ~~~~~~~~~~{.c}
+ * const as_bin_handle* bin = as_bin_handle_intern("bin1");
+ * ~~~~~~~~~~
+ *
+ * @param name 	The bin name.
+ *
+ * @return The handle or NULL if the name is longer than AS_BIN_NAME_MAX_LEN.
+ *
+ * @relates as_bin_handle
+ */
+AS_EXTERN const as_bin_handle*
+as_bin_handle_intern(const char* name);
+
 /******************************************************************************
  * INLINE FUNCTIONS
  *****************************************************************************/
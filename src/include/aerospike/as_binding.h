@@ -0,0 +1,195 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_bin.h>
+#include <aerospike/as_record_raw.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Maximum number of fields in a binding.
+ */
+#define AS_BINDING_MAX_FIELDS 64
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Destination type of a bound bin.
+ *
+ * @ingroup client_objects
+ */
+typedef enum as_binding_type_e {
+	/**
+	 * int64_t. Bin must be an integer.
+	 */
+	AS_BINDING_INT64,
+
+	/**
+	 * double. Bin must be a double.
+	 */
+	AS_BINDING_DOUBLE,
+
+	/**
+	 * bool. Bin must be a boolean.
+	 */
+	AS_BINDING_BOOL,
+
+	/**
+	 * Null terminated string. If size is zero, the field is a char* that is set to a
+	 * string allocated with cf_malloc(). Otherwise, the field is a char array of size bytes.
+	 */
+	AS_BINDING_STR,
+
+	/**
+	 * Byte array. If size is zero, the field is a uint8_t* that is set to a buffer
+	 * allocated with cf_malloc(). Otherwise, the field is a uint8_t array of size bytes.
+	 * The number of bytes is written as uint32_t at len_offset.
+	 */
+	AS_BINDING_BYTES
+} as_binding_type;
+
+/**
+ * Mapping from one bin to a field of a user struct.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_binding_field_s {
+	as_bin_name name;
+	uint8_t name_len;
+	as_binding_type type;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t len_offset;
+} as_binding_field;
+
+/**
+ * Descriptor that decodes record bins straight into a user struct, without creating
+ * as_record or as_val objects. Create the binding once and use it from any thread.
+ *
+ * ~~~~~~~~~~{.c}
+ * typedef struct {
+ *     int64_t count;
+ *     double score;
+ *     char name[32];
+ * } user;
+ *
+ * as_binding b;
+ * as_binding_init(&b);
+ * as_binding_add(&b, "count", AS_BINDING_INT64, offsetof(user, count), 0);
+ * as_binding_add(&b, "score", AS_BINDING_DOUBLE, offsetof(user, score), 0);
+ * as_binding_add(&b, "name", AS_BINDING_STR, offsetof(user, name), sizeof(((user*)0)->name));
+ *
+ * user u;
+ * as_binding_status bs;
+ * aerospike_key_get_bound(&as, &err, NULL, &key, &b, &u, &bs);
+ *
+ * if (bs.missing & (1ULL << 1)) {
+ *     // score bin does not exist.
+ * }
+ * ~~~~~~~~~~
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_binding_s {
+	uint32_t n_fields;
+	as_binding_field fields[AS_BINDING_MAX_FIELDS];
+} as_binding;
+
+/**
+ * Result of decoding one record. Bit i refers to the i'th field added to the binding.
+ * Fields that are missing or mismatched are not written.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_binding_status_s {
+	/**
+	 * Bin was not returned.
+	 */
+	uint64_t missing;
+
+	/**
+	 * Bin type does not match the field type.
+	 */
+	uint64_t mismatch;
+
+	/**
+	 * String or byte array was cut to the field size.
+	 */
+	uint64_t truncated;
+} as_binding_status;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize empty binding.
+ *
+ * @ingroup client_objects
+ */
+static inline void
+as_binding_init(as_binding* binding)
+{
+	binding->n_fields = 0;
+}
+
+/**
+ * Add field. For AS_BINDING_BYTES use as_binding_add_bytes(). Return false if the bin name
+ * is too long or the binding is full.
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN bool
+as_binding_add(
+	as_binding* binding, const char* name, as_binding_type type, uint32_t offset, uint32_t size
+	);
+
+/**
+ * Add byte array field. The number of bytes is written as uint32_t at len_offset.
+ * Return false if the bin name is too long or the binding is full.
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN bool
+as_binding_add_bytes(
+	as_binding* binding, const char* name, uint32_t offset, uint32_t size, uint32_t len_offset
+	);
+
+/**
+ * Decode bins of a raw record into obj. Can be called from raw scan/query callbacks.
+ * The status may be NULL.
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN void
+as_binding_decode(
+	const as_binding* binding, const as_record_raw* rec, void* obj, as_binding_status* status
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Smallest pooled buffer size class (32KB). Smaller command buffers live on the stack.
+ */
+#define AS_BUFFER_POOL_MIN_SHIFT 15
+
+/**
+ * @private
+ * Largest pooled buffer size class (8MB). Larger buffers are always allocated on the heap.
+ */
+#define AS_BUFFER_POOL_MAX_SHIFT 23
+
+/**
+ * @private
+ * Number of buffer size classes.
+ */
+#define AS_BUFFER_POOL_CLASSES (AS_BUFFER_POOL_MAX_SHIFT - AS_BUFFER_POOL_MIN_SHIFT + 1)
+
+/**
+ * @private
+ * Maximum number of cached buffers per size class per thread.
+ */
+#define AS_BUFFER_POOL_CLASS_SLOTS 4
+
+/**
+ * @private
+ * Transparent huge page size and alignment of mapped buffers (2MB).
+ */
+#define AS_BUFFER_POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Enable per-thread reuse of large sync command buffers.
+ *
+ * Sync commands that do not fit in a stack buffer (16KB) normally allocate and free a heap
+ * buffer on every call. When enabled, each thread keeps released buffers in power of two
+ * size classes (32KB to 8MB) and reuses them on subsequent commands.
+ *
+ * @param max_bytes		Maximum bytes of idle buffers each thread may keep cached.  Buffers
+ *						released beyond this high-water mark are freed.  Zero disables the
+ *						pool, which is the default.
+ *
+ * This setting is process wide and may be changed at any time.  Lowering the limit trims
+ * each thread's cache the next time that thread releases a buffer.
+ */
+AS_EXTERN void
+as_buffer_pool_set_max(uint32_t max_bytes);
+
+/**
+ * Return maximum bytes of idle buffers each thread may keep cached.
+ */
+AS_EXTERN uint32_t
+as_buffer_pool_get_max(void);
+
+/**
+ * Map large command buffers directly as huge page aligned regions.
+ *
+ * Buffers of at least min_bytes are allocated with mmap(), aligned to 2MB and advised with
+ * MADV_HUGEPAGE, so large scan, query and batch buffers use transparent huge pages instead
+ * of faulting in 4KB pages on first touch.  When prefault is true, the pages are also
+ * faulted in before the buffer is returned, which moves page fault cost off the command's
+ * latency path when combined with as_buffer_pool_set_max() reuse.
+ *
+ * @param min_bytes		Minimum buffer size to map.  Values below 2MB are raised to 2MB.
+ *						Zero disables mapping, which is the default.
+ * @param prefault		Fault in mapped pages when the buffer is allocated.
+ *
+ * This setting is process wide and only affects buffers allocated after the call.  It is
+ * ignored on platforms without mmap().
+ */
+AS_EXTERN void
+as_buffer_pool_set_huge_pages(uint32_t min_bytes, bool prefault);
+
+/**
+ * Free all buffers cached by the calling thread. Cached buffers are also freed automatically
+ * when a thread exits.
+ */
+AS_EXTERN void
+as_buffer_pool_release_thread(void);
+
+/**
+ * @private
+ * Borrow a heap buffer of at least the given size.  The buffer must be returned with
+ * as_buffer_pool_put().
+ */
+uint8_t*
+as_buffer_pool_get(size_t size);
+
+/**
+ * @private
+ * Return buffer obtained from as_buffer_pool_get().
+ */
+void
+as_buffer_pool_put(uint8_t* buf);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_std.h>
+#include <aerospike/as_trace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * First bytes of a capture file.
+ * @ingroup as_config_object
+ */
+#define AS_CAPTURE_MAGIC "ASCAPTR1"
+
+/**
+ * Maximum operations recorded per command.  as_capture_record.n_ops holds the full count.
+ * @ingroup as_config_object
+ */
+#define AS_CAPTURE_MAX_OPS 32
+
+/**
+ * Record is an async command.
+ * @ingroup as_config_object
+ */
+#define AS_CAPTURE_FLAGS_ASYNC 1
+
+/**
+ * Record has a digest.
+ * @ingroup as_config_object
+ */
+#define AS_CAPTURE_FLAGS_DIGEST 2
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Captured command type.
+ * @ingroup as_config_object
+ */
+typedef enum as_capture_type_e {
+	AS_CAPTURE_READ,
+	AS_CAPTURE_EXISTS,
+	AS_CAPTURE_WRITE,
+	AS_CAPTURE_DELETE,
+	AS_CAPTURE_OPERATE,
+	AS_CAPTURE_UDF,
+	AS_CAPTURE_BATCH,
+	AS_CAPTURE_SCAN,
+	AS_CAPTURE_QUERY,
+	AS_CAPTURE_OTHER,
+	AS_CAPTURE_TYPE_MAX
+} as_capture_type;
+
+/**
+ * Capture file header.  Values are in host byte order.
+ * @ingroup as_config_object
+ */
+typedef struct as_capture_header_s {
+	char magic[8];
+	uint32_t sample_rate;
+	uint32_t unused;
+	uint64_t start_ms; // cf_clock_getabsolute() milliseconds when capture started.
+} as_capture_header;
+
+/**
+ * Shape of one captured operation.  The bin name is truncated to 15 bytes.
+ * @ingroup as_config_object
+ */
+typedef struct as_capture_op_s {
+	uint32_t value_size;
+	uint8_t op; // Wire protocol operation type.
+	uint8_t particle_type;
+	uint8_t name_len;
+	char name[15];
+} as_capture_op;
+
+/**
+ * Fixed part of one captured command.  Followed by ns_len namespace bytes, set_len set bytes
+ * and n_shapes as_capture_op entries.  Records are written when commands complete, so they
+ * are ordered by completion and not by issue_us.
+ * @ingroup as_config_object
+ */
+typedef struct as_capture_record_s {
+	uint64_t issue_us;   // Microseconds since capture start when the command was issued.
+	uint32_t latency_us; // Issue to completion.
+	uint32_t bytes_out;  // Request bytes of all attempts.
+	uint32_t bytes_in;   // Response bytes of the last attempt.
+	int32_t status;
+	uint16_t n_ops;
+	uint8_t n_shapes;
+	uint8_t type;        // as_capture_type
+	uint8_t flags;       // AS_CAPTURE_FLAGS_*
+	uint8_t ns_len;
+	uint8_t set_len;
+	uint8_t info1;
+	uint8_t info2;
+	uint8_t info3;
+	uint8_t digest[20];
+} as_capture_record;
+
+/**
+ * @private
+ * Sampled command capture state owned by the cluster.
+ */
+typedef struct as_capture_s as_capture;
+
+/**
+ * @private
+ * Captured command built when the command is issued and written when it completes.
+ */
+typedef struct as_capture_entry_s {
+	as_capture_record rec;
+	char ns[32];
+	char set[64];
+	as_capture_op ops[AS_CAPTURE_MAX_OPS];
+} as_capture_entry;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Start writing one out of every sample_rate sync and async commands to a capture file.
+ * The file is created or truncated.  Each record holds the command type, namespace, set,
+ * digest, operation shapes, request and response sizes, latency and issue time, but no bin
+ * values.  Use the benchmark replay tool to issue the captured traffic again.
+ *
+ * @param as			The aerospike instance.
+ * @param err			The error is populated if the return value is not AEROSPIKE_OK.
+ * @param path			Capture file path.
+ * @param sample_rate	Capture one out of every sample_rate commands.  Must be at least 1.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup as_config_object
+ */
+AS_EXTERN as_status
+aerospike_capture_start(aerospike* as, as_error* err, const char* path, uint32_t sample_rate);
+
+/**
+ * Stop capture and close the capture file.  Commands that were sampled but are still in
+ * flight are not written.  Does nothing if capture is not running.
+ *
+ * @param as			The aerospike instance.
+ * @ingroup as_config_object
+ */
+AS_EXTERN void
+aerospike_capture_stop(aerospike* as);
+
+/**
+ * @private
+ * Create stopped capture state.
+ */
+as_capture*
+as_capture_create(void);
+
+/**
+ * @private
+ * Stop capture and destroy state.
+ */
+void
+as_capture_destroy(as_capture* capture);
+
+/**
+ * @private
+ * Return if the next command should be captured.
+ */
+bool
+as_capture_sample(as_capture* capture);
+
+/**
+ * @private
+ * Build capture entry from the uncompressed command buffer.  Return NULL when the buffer is
+ * compressed or capture was stopped.
+ */
+as_capture_entry*
+as_capture_begin(as_capture* capture, const uint8_t* buf, size_t size, bool async);
+
+/**
+ * @private
+ * Complete entry from the finished trace span, write it and free it.
+ */
+void
+as_capture_end(as_capture* capture, as_capture_entry* entry, as_trace_span* span);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -69,6 +69,31 @@ typedef struct as_cdt_ctx_item {
  */
 typedef struct as_cdt_ctx {
 	as_vector list;
+
+	/**
+	 * @private
+	 * Context levels packed by as_cdt_ctx_freeze().
+	 */
+	uint8_t* packed;
+
+	/**
+	 * @private
+	 * Size of packed levels.
+	 */
+	uint32_t packed_size;
+
+	/**
+	 * @private
+	 * Number of levels when the context was frozen.  Packed levels are ignored if levels
+	 * were added later.
+	 */
+	uint32_t packed_levels;
+
+	/**
+	 * @private
+	 * Context was created by as_cdt_ctx_create().
+	 */
+	bool _free;
 } as_cdt_ctx;
 
 /******************************************************************************
@@ -94,7 +119,12 @@ typedef struct as_cdt_ctx {
  * @relates as_operations
  * @ingroup as_operations_object
  */
-#define as_cdt_ctx_inita(__ctx, __cap) as_vector_inita(&(__ctx)->list, sizeof(as_cdt_ctx_item), __cap)
+#define as_cdt_ctx_inita(__ctx, __cap) \
+	as_vector_inita(&(__ctx)->list, sizeof(as_cdt_ctx_item), __cap);\
+	(__ctx)->packed = NULL;\
+	(__ctx)->packed_size = 0;\
+	(__ctx)->packed_levels = 0;\
+	(__ctx)->_free = false
 
 /******************************************************************************
  * FUNCTIONS
@@ -111,6 +141,10 @@ static inline void
 as_cdt_ctx_init(as_cdt_ctx* ctx, uint32_t capacity)
 {
 	as_vector_init(&ctx->list, sizeof(as_cdt_ctx_item), capacity);
+	ctx->packed = NULL;
+	ctx->packed_size = 0;
+	ctx->packed_levels = 0;
+	ctx->_free = false;
 }
 
 /**
@@ -120,11 +154,8 @@ as_cdt_ctx_init(as_cdt_ctx* ctx, uint32_t capacity)
  * @relates as_operations
  * @ingroup as_operations_object
  */
-static inline as_cdt_ctx*
-as_cdt_ctx_create(uint32_t capacity)
-{
-	return (as_cdt_ctx*)as_vector_create(sizeof(as_cdt_ctx_item), capacity);
-}
+AS_EXTERN as_cdt_ctx*
+as_cdt_ctx_create(uint32_t capacity);
 
 /**
  * Destroy nested CDT context list and as_val based context items that were allocated on the heap.
@@ -135,6 +166,33 @@ as_cdt_ctx_create(uint32_t capacity)
 AS_EXTERN void
 as_cdt_ctx_destroy(as_cdt_ctx* ctx);
 
+/**
+ * Pack context levels once, so operations and expressions that use the same context copy
+ * the packed bytes instead of packing every level again.  Call after all levels have been
+ * added.  The context must not be modified while frozen, except for adding more levels
+ * which discards the packed form until as_cdt_ctx_freeze() is called again.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_cdt_ctx ctx;
+ * as_cdt_ctx_inita(&ctx, 2);
+ * as_cdt_ctx_add_map_key(&ctx, (as_val*)as_string_new("a", false));
+ * as_cdt_ctx_add_list_index(&ctx, -1);
+ * as_cdt_ctx_freeze(&ctx);
+ *
+ * as_operations_list_append(&ops, "bin", &ctx, NULL, (as_val*)as_integer_new(1));
+ * as_operations_list_size(&ops, "bin", &ctx);
+ * ...
+ * as_cdt_ctx_destroy(&ctx);
+ * ~~~~~~~~~~
+ *
+ * @return true if successful, false if a context value could not be packed.
+ *
+ * @relates as_operations
+ * @ingroup as_operations_object
+ */
+AS_EXTERN bool
+as_cdt_ctx_freeze(as_cdt_ctx* ctx);
+
 /**
  * Lookup list by index offset.
  *
@@ -32,9 +32,9 @@ extern "C" {
 	{0};\
 	while (true) {
 
-#define as_cdt_end(pk) \
+#define as_cdt_end(pk, ops) \
 		if (!(pk)->buffer) {\
-			(pk)->buffer = cf_malloc((pk)->offset);\
+			(pk)->buffer = as_cdt_alloc(ops, (pk)->offset);\
 			(pk)->capacity = (pk)->offset;\
 			(pk)->offset = 0;\
 			(pk)->head = NULL;\
@@ -48,6 +48,13 @@ extern "C" {
  * FUNCTIONS
  *****************************************************************************/
 
+/**
+ * Take memory for packed operation arguments from the operations arena.  The memory is
+ * freed by as_operations_destroy().
+ */
+uint8_t*
+as_cdt_alloc(as_operations* ops, uint32_t size);
+
 void
 as_cdt_pack_header(as_packer* pk, as_cdt_ctx* ctx, uint16_t command, uint32_t count);
 
@@ -57,6 +64,21 @@ as_cdt_pack_header_flag(as_packer* pk, as_cdt_ctx* ctx, uint16_t command, uint32
 void
 as_cdt_pack_ctx(as_packer* pk, as_cdt_ctx* ctx);
 
+/**
+ * Pack list of context level type/value pairs.  Frozen contexts are copied.
+ */
+int
+as_cdt_pack_ctx_levels(as_packer* pk, const as_cdt_ctx* ctx);
+
+/**
+ * Return true if packed levels from as_cdt_ctx_freeze() are current.
+ */
+static inline bool
+as_cdt_ctx_frozen(const as_cdt_ctx* ctx)
+{
+	return ctx->packed && ctx->packed_levels == ctx->list.size;
+}
+
 bool
 as_cdt_add_packed(as_packer* pk, as_operations* ops, const char* name, as_operator op_type);
 
@@ -21,7 +21,9 @@
 #include <aerospike/as_node.h>
 #include <aerospike/as_partition.h>
 #include <aerospike/as_policy.h>
+#include <aerospike/as_task_gate.h>
 #include <aerospike/as_thread_pool.h>
+#include <aerospike/as_work_pool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -69,6 +71,12 @@ typedef struct as_event_state_s {
 	 * Is cluster closed for this event loop.
 	 */
 	bool closed;
+
+	/**
+	 * Has cluster close started for this event loop.  Commands that poll periodically
+	 * check this flag to stop early, because close waits for pending commands.
+	 */
+	bool closing;
 } as_event_state;
 
 /**
@@ -93,8 +101,24 @@ typedef struct as_gc_item_s {
 	 * Release function.
 	 */
 	as_release_fn release_fn;
+
+	/**
+	 * @private
+	 * Epoch in which data was unlinked. Zero until the next garbage collection.
+	 */
+	uint64_t epoch;
 } as_gc_item;
 
+/**
+ * @private
+ * Adaptive tend schedule of one cluster.
+ */
+typedef struct as_tend_state_s {
+	uint32_t interval;
+	uint32_t elapsed;
+	uint32_t route_errors;
+} as_tend_state;
+
 /**
  * Cluster of server nodes.
  */
@@ -116,6 +140,12 @@ typedef struct as_cluster_s {
 	 * Nodes to be garbage collected.
 	 */
 	as_vector* /* <as_gc_item> */ gc;
+
+	/**
+	 * @private
+	 * Lock for gc.  Tend pool threads add items while the tend thread collects.
+	 */
+	pthread_mutex_t gc_lock;
 	
 	/**
 	 * @private
@@ -146,6 +176,12 @@ typedef struct as_cluster_s {
 	 * Expected cluster name for all nodes.  May be null.
 	 */
 	char* cluster_name;
+
+	/**
+	 * @private
+	 * Topology snapshot file.  May be null.
+	 */
+	char* topology_file;
 	
 	/**
 	 * Cluster event function that will be called when nodes are added/removed from the cluster.
@@ -190,12 +226,63 @@ typedef struct as_cluster_s {
 	 * Pool of threads used to query server nodes in parallel for batch, scan and query.
 	 */
 	as_thread_pool thread_pool;
+
+	/**
+	 * @private
+	 * Work stealing pool that replaces thread_pool threads when enabled.
+	 */
+	as_work_pool work_pool;
+
+	/**
+	 * @private
+	 * Divides thread_pool between concurrent sync batch, scan and query calls.
+	 */
+	as_task_gate task_gate;
+
+	/**
+	 * @private
+	 * Pool of threads that send tend info requests to nodes in parallel. Kept apart from
+	 * thread_pool, so long running batch/scan/query tasks never delay tending.
+	 */
+	as_thread_pool tend_pool;
+
+	/**
+	 * @private
+	 * Pool of threads that connect and complete TLS handshakes for async connection pools,
+	 * so handshakes do not stall event loop threads.
+	 */
+	as_thread_pool tls_pool;
 		
 	/**
 	 * @private
 	 * Cluster tend thread.
 	 */
 	pthread_t tend_thread;
+
+	/**
+	 * @private
+	 * Pool that sends tend info requests in parallel.  Points to tend_pool or to the pool
+	 * of the shared tend thread.
+	 */
+	as_thread_pool* tend_workers;
+
+	/**
+	 * @private
+	 * Next cluster tended by the shared tend thread.
+	 */
+	struct as_cluster_s* shared_tend_next;
+
+	/**
+	 * @private
+	 * Time in milliseconds when the shared tend thread next checks this cluster.
+	 */
+	uint64_t shared_tend_ms;
+
+	/**
+	 * @private
+	 * Adaptive tend schedule.
+	 */
+	as_tend_state tend_state;
 	
 	/**
 	 * @private
@@ -218,6 +305,61 @@ typedef struct as_cluster_s {
 	 */
 	pthread_cond_t tend_cond;
 
+	/**
+	 * @private
+	 * Lock for login_cond.
+	 */
+	pthread_mutex_t login_lock;
+
+	/**
+	 * @private
+	 * Signaled by the tend thread after each node login attempt.
+	 */
+	pthread_cond_t login_cond;
+
+	/**
+	 * @private
+	 * Lock for udf_registered.
+	 */
+	pthread_mutex_t udf_lock;
+
+	/**
+	 * @private
+	 * UDF modules that aerospike_udf_ensure() verified are registered on all nodes, with
+	 * their content hashes.  Created on first use.
+	 */
+	as_vector* udf_registered;
+
+	/**
+	 * @private
+	 * Resolved hostname cache.  NULL if dns_cache_ttl is zero.
+	 */
+	struct as_dns_cache_s* dns_cache;
+
+	/**
+	 * @private
+	 * Client-side record cache.  NULL if record_cache_max is zero.
+	 */
+	struct as_record_cache_s* record_cache;
+
+	/**
+	 * @private
+	 * Recently not found keys.  NULL if negative_cache_max is zero.
+	 */
+	struct as_negative_cache_s* negative_cache;
+
+	/**
+	 * @private
+	 * Single record reads in flight that identical reads can join.
+	 */
+	struct as_read_coalesce_s* read_coalesce;
+
+	/**
+	 * @private
+	 * Compression ratio per namespace and set.  NULL if compress_skip_ratio is zero.
+	 */
+	struct as_compress_ratio_s* compress_ratio;
+
 	/**
 	 * @private
 	 * Maximum socket idle to validate connections in transactions.
@@ -254,18 +396,186 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t error_rate_window;
 
+	/**
+	 * @private
+	 * Maximum error windows a node circuit breaker stays open.  Zero disables the breaker.
+	 */
+	uint32_t error_rate_backoff_max;
+
+	/**
+	 * @private
+	 * One of every error_rate_probe_interval commands is sent to a half-open node.
+	 */
+	uint32_t error_rate_probe_interval;
+
+	/**
+	 * @private
+	 * Send reads to another replica instead of failing when the node breaker is not closed.
+	 */
+	bool error_rate_read_replica;
+
+	/**
+	 * @private
+	 * Retry budget tokens in thousandths of a retry.
+	 */
+	uint64_t retry_tokens;
+
+	/**
+	 * @private
+	 * Maximum retry_tokens.
+	 */
+	uint64_t retry_tokens_max;
+
+	/**
+	 * @private
+	 * Retry tokens added per completed command.  Zero if the retry budget is disabled.
+	 */
+	uint32_t retry_tokens_per_command;
+
+	/**
+	 * @private
+	 * Retries that were not attempted because the retry budget was exhausted.
+	 */
+	uint64_t retry_budget_rejects;
+
+	/**
+	 * @private
+	 * Adaptive socket timeout is this multiple of node p99 latency. Zero if disabled.
+	 */
+	uint32_t adaptive_timeout_factor;
+
+	/**
+	 * @private
+	 * Minimum adaptive socket timeout in milliseconds.
+	 */
+	uint32_t adaptive_timeout_min;
+
+	/**
+	 * @private
+	 * Max new connections per node per second.
+	 */
+	uint32_t max_conn_open_rate;
+
+	/**
+	 * @private
+	 * Record per node latency histograms.
+	 */
+	bool latency_stats;
+
+	/**
+	 * @private
+	 * Periodic metrics callback.
+	 */
+	as_metrics_callback metrics_callback;
+
+	/**
+	 * @private
+	 * Metrics user data.
+	 */
+	void* metrics_udata;
+
+	/**
+	 * @private
+	 * Milliseconds between metrics callbacks.
+	 */
+	uint64_t metrics_interval_ms;
+
+	/**
+	 * @private
+	 * Time of next metrics callback in milliseconds.
+	 */
+	uint64_t metrics_next_ms;
+
+	/**
+	 * @private
+	 * Reused metrics snapshot. Only accessed by the tend thread.
+	 */
+	struct as_cluster_stats_s* metrics;
+
+	/**
+	 * @private
+	 * Sampled command tracing hooks.
+	 */
+	as_trace_hooks trace;
+
+	/**
+	 * @private
+	 * Command trace sampling counter.  Not atomic by design.
+	 */
+	uint32_t trace_iter;
+
+	/**
+	 * @private
+	 * Hot key sketches.  NULL if hot_key_sample_rate is zero.
+	 */
+	struct as_hot_keys_s* hot_keys;
+
+	/**
+	 * @private
+	 * Hot key sampling rate.
+	 */
+	uint32_t hot_key_sample_rate;
+
+	/**
+	 * @private
+	 * Hot key sampling counter.  Not atomic by design.
+	 */
+	uint32_t hot_key_iter;
+
+	/**
+	 * @private
+	 * Command traffic capture.  Idle until aerospike_capture_start() is called.
+	 */
+	struct as_capture_s* capture;
+
 	/**
 	 * @private
 	 * Milliseconds between cluster tends.
 	 */
 	uint32_t tend_interval;
 
+	/**
+	 * @private
+	 * Maximum milliseconds between adaptive cluster tends. Zero if tend interval is fixed.
+	 */
+	uint32_t tend_interval_max;
+
+	/**
+	 * @private
+	 * Commands that could not find a node or timed out. Only counted for adaptive tending.
+	 */
+	uint32_t route_errors;
+
 	/**
 	 * @private
 	 * Cluster tend counter.
 	 */
 	uint32_t tend_count;
 
+	/**
+	 * @private
+	 * Cluster creation time in milliseconds.
+	 */
+	uint64_t create_ms;
+
+	/**
+	 * @private
+	 * Milliseconds from cluster creation until the first tend completed.
+	 */
+	uint64_t startup_ms;
+
+	/**
+	 * @private
+	 * Waits for the first tend of an asynchronously connected cluster.  Uses tend_lock.
+	 */
+	pthread_cond_t connect_cond;
+
+	/**
+	 * @private
+	 * True until the first tend of an asynchronously connected cluster completes.
+	 */
+	uint8_t connecting;
+
 	/**
 	 * @private
 	 * Minimum sync connections per node.
@@ -290,11 +600,35 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t async_max_conns_per_node;
 
+	/**
+	 * @private
+	 * Incremented when sync connection limits are changed at runtime.
+	 */
+	uint32_t conn_limits_gen;
+
+	/**
+	 * @private
+	 * Adaptive async connection pre-warming headroom percent.
+	 */
+	uint32_t async_conn_prewarm;
+
+	/**
+	 * @private
+	 * Maximum async command bytes in flight per node.
+	 */
+	uint32_t async_max_bytes_per_node;
+
 	/**
 	 * @private
 	 * Maximum pipeline connections per node.
 	 */
 	uint32_t pipe_max_conns_per_node;
+
+	/**
+	 * @private
+	 * Adaptive pipeline depth.
+	 */
+	uint32_t pipe_max_depth;
 	
 	/**
 	 * @private
@@ -302,6 +636,48 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t conn_pools_per_node;
 
+	/**
+	 * @private
+	 * Use lock free synchronous connection pools.
+	 */
+	bool lock_free_conn_pools;
+
+	/**
+	 * @private
+	 * Sync connection pool selection.
+	 */
+	as_conn_pool_affinity conn_pool_affinity;
+
+	/**
+	 * @private
+	 * SO_BUSY_POLL microseconds for new sync connections.
+	 */
+	uint32_t socket_busy_poll;
+
+	/**
+	 * @private
+	 * Read-ahead buffer size for new sync connections.
+	 */
+	uint32_t socket_read_buffer;
+
+	/**
+	 * @private
+	 * Socket options for new regular sync connections.
+	 */
+	as_socket_profile point_socket_profile;
+
+	/**
+	 * @private
+	 * Socket options for new scan and query sync connections.
+	 */
+	as_socket_profile bulk_socket_profile;
+
+	/**
+	 * @private
+	 * Max sync connections per node in the scan and query pool.  Zero disables that pool.
+	 */
+	uint32_t bulk_max_conns_per_node;
+
 	/**
 	 * @private
 	 * Initial connection timeout in milliseconds.
@@ -314,6 +690,12 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t login_timeout_ms;
 
+	/**
+	 * @private
+	 * Milliseconds before session expiration that the tend thread refreshes the session.
+	 */
+	uint32_t session_refresh_ms;
+
 	/**
 	 * @private
 	 * Random node index.
@@ -326,6 +708,13 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t invalid_node_count;
 
+	/**
+	 * @private
+	 * Partition map generation.  Incremented when nodes or partition maps changed in a
+	 * cluster tend.  Shared memory clusters use as_cluster_shm partition_gen instead.
+	 */
+	uint32_t partition_gen;
+
 	/**
 	 * @private
 	 * Assign tend thread to this specific CPU ID.
@@ -356,6 +745,42 @@ typedef struct as_cluster_s {
 	 */
 	bool rack_aware;
 
+	/**
+	 * @private
+	 * Sync commands protect nodes with thread epochs instead of reference counts.
+	 */
+	bool epoch_reclaim;
+
+	/**
+	 * @private
+	 * Format server result code messages on demand.
+	 */
+	bool lazy_error_messages;
+
+	/**
+	 * @private
+	 * Nodes or partition maps changed since the topology snapshot was written.
+	 */
+	bool topology_changed;
+
+	/**
+	 * @private
+	 * Cluster was restored from a topology snapshot and has not been tended yet.
+	 */
+	bool warm_start;
+
+	/**
+	 * @private
+	 * Nodes or partition maps changed in the last cluster tend.
+	 */
+	bool tend_changed;
+
+	/**
+	 * @private
+	 * Is cluster tended by the shared tend thread.
+	 */
+	bool shared_tend;
+
 	/**
 	 * @private
 	 * Is authentication enabled
@@ -391,6 +816,46 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster);
 void
 as_cluster_destroy(as_cluster* cluster);
 
+/**
+ * @private
+ * Change sync connection limits of all current and future nodes.
+ */
+as_status
+as_cluster_set_conns_per_node(
+	as_cluster* cluster, as_error* err, uint32_t min_conns, uint32_t max_conns
+	);
+
+/**
+ * @private
+ * Change async connection limits.  Event loops apply them in the next cluster tend.
+ */
+as_status
+as_cluster_set_async_conns_per_node(
+	as_cluster* cluster, as_error* err, uint32_t min_conns, uint32_t max_conns
+	);
+
+/**
+ * @private
+ * Change number of threads in the sync batch/scan/query thread pool.
+ */
+as_status
+as_cluster_set_thread_pool_size(as_cluster* cluster, as_error* err, uint32_t size);
+
+/**
+ * @private
+ * Wake up the thread that tends this cluster, so the next tend iteration starts early.
+ */
+void
+as_cluster_wake_tend(as_cluster* cluster);
+
+/**
+ * @private
+ * Put reference counted data on the garbage collector stack.  Safe to call from tend
+ * pool threads.
+ */
+void
+as_cluster_add_gc(as_cluster* cluster, void* data, as_release_fn release_fn);
+
 /**
  * Is cluster connected to any server nodes.
  */
@@ -464,6 +929,14 @@ as_cluster_remove_seed(as_cluster* cluster, const char* hostname, uint16_t port)
 void
 as_cluster_change_password(as_cluster* cluster, const char* user, const char* password, const char* password_hash);
 
+/**
+ * @private
+ * Wait until the first tend of a cluster created with as_config.connect_async completes.
+ * Return immediately for other clusters.
+ */
+void
+as_cluster_wait_connected(as_cluster* cluster);
+
 /**
  * @private
  * Get random node in the cluster.
@@ -525,6 +998,13 @@ as_partition_get_node(
 	}
 }
 
+/**
+ * @private
+ * Publish that node exceeded max_error_rate to other processes sharing cluster memory.
+ */
+void
+as_shm_node_error_rate_exceeded(as_cluster* cluster, as_node* node);
+
 /**
  * @private
  * Increment node's error count.
@@ -532,8 +1012,14 @@ as_partition_get_node(
 static inline void
 as_node_incr_error_count(as_node* node)
 {
-	if (node->cluster->max_error_rate > 0) {
-		as_incr_uint32(&node->error_count);
+	as_cluster* cluster = node->cluster;
+	uint32_t max = cluster->max_error_rate;
+
+	if (max > 0) {
+		// Only the command that crosses the limit publishes it.
+		if (as_faa_uint32(&node->error_count, 1) == max && cluster->shm_info) {
+			as_shm_node_error_rate_exceeded(cluster, node);
+		}
 	}
 }
 
@@ -545,6 +1031,26 @@ static inline void
 as_node_reset_error_count(as_node* node)
 {
 	as_store_uint32(&node->error_count, 0);
+	as_store_uint8(&node->error_rate_exceeded, 0);
+}
+
+/**
+ * @private
+ * End node's error window.  Move circuit breaker to its next state and reset error count.
+ * Only called by tend thread.
+ */
+void
+as_node_error_window_end(as_node* node);
+
+/**
+ * @private
+ * Errors allowed per window while a node breaker is half-open.  The error rate limit is scaled
+ * by the fraction of commands that are sent as probes.
+ */
+static inline uint32_t
+as_cluster_probe_max_errors(as_cluster* cluster)
+{
+	return cluster->max_error_rate / cluster->error_rate_probe_interval;
 }
 
 /**
@@ -565,7 +1071,136 @@ static inline bool
 as_node_valid_error_count(as_node* node)
 {
 	uint32_t max = node->cluster->max_error_rate;
-	return max == 0 || max >= as_load_uint32(&node->error_count);
+	return max == 0 || (max >= as_load_uint32(&node->error_count) &&
+		! as_load_uint8(&node->error_rate_exceeded) &&
+		as_load_uint8(&node->breaker_state) == AS_NODE_BREAKER_CLOSED);
+}
+
+/**
+ * @private
+ * Return if a database command may be sent to the node.  Unlike as_node_valid_error_count(),
+ * a half-open node admits one of every error_rate_probe_interval commands as a probe.
+ */
+static inline bool
+as_node_breaker_allow(as_node* node)
+{
+	as_cluster* cluster = node->cluster;
+	uint32_t max = cluster->max_error_rate;
+
+	if (max == 0) {
+		return true;
+	}
+
+	switch (as_load_uint8(&node->breaker_state)) {
+		case AS_NODE_BREAKER_CLOSED:
+			return max >= as_load_uint32(&node->error_count) &&
+				! as_load_uint8(&node->error_rate_exceeded);
+
+		case AS_NODE_BREAKER_HALF_OPEN:
+			return as_load_uint32(&node->error_count) <= as_cluster_probe_max_errors(cluster) &&
+				as_faa_uint32(&node->breaker_probes, 1) % cluster->error_rate_probe_interval == 0;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * @private
+ * Return if the next command should be traced.
+ */
+static inline bool
+as_cluster_trace_sample(as_cluster* cluster)
+{
+	uint32_t rate = cluster->trace.sample_rate;
+	return rate > 0 && cluster->trace_iter++ % rate == 0; // not atomic by design
+}
+
+/**
+ * @private
+ * Return if the next command should be sampled for hot key tracking.
+ */
+static inline bool
+as_cluster_hot_key_sample(as_cluster* cluster)
+{
+	uint32_t rate = cluster->hot_key_sample_rate;
+	return rate > 0 && cluster->hot_key_iter++ % rate == 0; // not atomic by design
+}
+
+/**
+ * @private
+ * Report a command routing error, so the adaptive tender refreshes partition maps soon.
+ */
+static inline void
+as_cluster_incr_route_errors(as_cluster* cluster)
+{
+	if (cluster->tend_interval_max > 0) {
+		as_incr_uint32(&cluster->route_errors);
+	}
+}
+
+/**
+ * @private
+ * Return socket timeout in milliseconds for the next attempt of a single record command to
+ * the node.  max is the configured timeout and is returned when adaptive timeouts are
+ * disabled or the node has no latency estimate yet.
+ */
+static inline uint32_t
+as_node_adaptive_timeout(as_node* node, uint32_t max)
+{
+	uint32_t p99 = node->timeout_hist ? as_load_uint32(&node->timeout_p99_us) : 0;
+
+	if (p99 == 0 || max == 0) {
+		return max;
+	}
+
+	as_cluster* cluster = node->cluster;
+	uint64_t timeout = ((uint64_t)p99 * cluster->adaptive_timeout_factor + 999) / 1000;
+
+	if (timeout < cluster->adaptive_timeout_min) {
+		timeout = cluster->adaptive_timeout_min;
+	}
+	return (timeout < max) ? (uint32_t)timeout : max;
+}
+
+/**
+ * @private
+ * Add retry budget tokens for a command that received a response.
+ */
+static inline void
+as_cluster_retry_deposit(as_cluster* cluster)
+{
+	uint32_t tokens = cluster->retry_tokens_per_command;
+
+	// Bucket may overshoot max by concurrent deposits, which is harmless.
+	if (tokens > 0 && as_load_uint64(&cluster->retry_tokens) < cluster->retry_tokens_max) {
+		as_faa_uint64(&cluster->retry_tokens, tokens);
+	}
+}
+
+/**
+ * @private
+ * Take one retry from the retry budget.  Return false if the budget is exhausted.
+ */
+static inline bool
+as_cluster_retry_acquire(as_cluster* cluster)
+{
+	if (cluster->retry_tokens_per_command == 0) {
+		return true;
+	}
+
+	while (true) {
+		uint64_t tokens = as_load_uint64(&cluster->retry_tokens);
+
+		if (tokens < 1000) {
+			as_incr_uint64(&cluster->retry_budget_rejects);
+			return false;
+		}
+
+		if (as_cas_uint64(&cluster->retry_tokens, tokens, tokens - 1000)) {
+			return true;
+		}
+	}
 }
 
 /**
@@ -576,6 +1211,7 @@ static inline void
 as_node_close_conn_error(as_node* node, as_socket* sock, as_conn_pool* pool)
 {
 	as_node_close_connection(node, sock, pool);
+	as_incr_uint32(&node->sync_conns_closed_error);
 	as_node_incr_error_count(node);
 }
 
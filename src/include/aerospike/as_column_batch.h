@@ -0,0 +1,285 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike_query.h>
+#include <aerospike/aerospike_scan.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Column value type. Bins with a different particle type are stored as null.
+ *
+ * @ingroup client_objects
+ */
+typedef enum as_column_type_e {
+	/**
+	 * Fixed width int64_t values.
+	 */
+	AS_COLUMN_INT64,
+
+	/**
+	 * Fixed width double values.
+	 */
+	AS_COLUMN_DOUBLE,
+
+	/**
+	 * Variable width UTF-8 strings without null terminator.
+	 */
+	AS_COLUMN_STRING,
+
+	/**
+	 * Variable width byte arrays.
+	 */
+	AS_COLUMN_BLOB
+} as_column_type;
+
+/**
+ * Caller-provided column buffers. The layout matches Arrow primitive and binary
+ * arrays, so buffers can be handed to columnar engines without conversion.
+ *
+ * Fixed width columns use values. Variable width columns use offsets and data, where
+ * row i is data[offsets[i]..offsets[i+1]).
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_column_s {
+	/**
+	 * Bin name.
+	 */
+	const char* name;
+
+	/**
+	 * Column value type.
+	 */
+	as_column_type type;
+
+	/**
+	 * Validity bitmap with at least (capacity + 7) / 8 bytes. Bit i (LSB first) is set
+	 * when row i has a value. May be NULL, in which case null rows hold zero or an
+	 * empty value.
+	 */
+	uint8_t* validity;
+
+	/**
+	 * int64_t or double array with capacity entries. Fixed width columns only.
+	 */
+	void* values;
+
+	/**
+	 * Offsets with capacity + 1 entries. Variable width columns only.
+	 */
+	uint32_t* offsets;
+
+	/**
+	 * Value bytes. Variable width columns only.
+	 */
+	uint8_t* data;
+
+	/**
+	 * Size of data in bytes. A chunk is delivered early when the next record's value
+	 * does not fit.
+	 */
+	uint32_t data_capacity;
+
+	/**
+	 * @private
+	 */
+	uint32_t name_len;
+} as_column;
+
+struct as_column_batch_s;
+
+/**
+ * Column chunk callback. Called with batch->size rows filled. Chunks are delivered
+ * one at a time, but possibly from different threads. Column buffers are reused for
+ * the next chunk after the callback returns.
+ *
+ * @return true to continue, false to abort the scan/query.
+ *
+ * @ingroup client_objects
+ */
+typedef bool (*as_column_batch_callback)(const struct as_column_batch_s* batch, void* udata);
+
+/**
+ * Column sink for aerospike_scan_columns() and aerospike_query_columns(). Bin values
+ * are written directly from the response buffer into the columns, so no as_record
+ * or as_val is created per record.
+ *
+ * ~~~~~~~~~~{.c}
+ * int64_t ages[1024];
+ * uint8_t age_valid[128];
+ * uint32_t name_offsets[1025];
+ * uint8_t name_data[64 * 1024];
+ *
+ * as_column columns[2] = {
+ *     { .name = "age", .type = AS_COLUMN_INT64, .validity = age_valid, .values = ages },
+ *     { .name = "name", .type = AS_COLUMN_STRING, .offsets = name_offsets,
+ *       .data = name_data, .data_capacity = sizeof(name_data) }
+ * };
+ *
+ * as_column_batch batch;
+ *
+ * if (as_column_batch_init(&batch, &err, columns, 2, 1024) == AEROSPIKE_OK) {
+ *     aerospike_scan_columns(&as, &err, NULL, &scan, &batch, chunk_callback, NULL);
+ *     as_column_batch_destroy(&batch);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_column_batch_s {
+	/**
+	 * Columns.
+	 */
+	as_column* columns;
+
+	/**
+	 * Number of columns.
+	 */
+	uint32_t n_columns;
+
+	/**
+	 * Maximum rows per chunk.
+	 */
+	uint32_t capacity;
+
+	/**
+	 * Rows in the current chunk.
+	 */
+	uint32_t size;
+
+	/**
+	 * @private
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @private
+	 */
+	as_column_batch_callback callback;
+
+	/**
+	 * @private
+	 */
+	void* udata;
+
+	/**
+	 * @private
+	 * Sink error that aborted the scan/query.
+	 */
+	as_error err;
+} as_column_batch;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize column sink. Columns and their buffers are owned by the caller and must
+ * remain valid until the sink is destroyed.
+ *
+ * @param batch			Column sink.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param columns		Column array.
+ * @param n_columns		Number of columns.
+ * @param capacity		Rows per chunk. Fixed width and offset buffers must hold this many rows.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN as_status
+as_column_batch_init(
+	as_column_batch* batch, as_error* err, as_column* columns, uint32_t n_columns,
+	uint32_t capacity
+	);
+
+/**
+ * Release column sink resources. Column buffers are not freed.
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN void
+as_column_batch_destroy(as_column_batch* batch);
+
+/**
+ * Is row set in column?
+ *
+ * @ingroup client_objects
+ */
+static inline bool
+as_column_is_valid(const as_column* col, uint32_t row)
+{
+	return col->validity ? (col->validity[row >> 3] >> (row & 7)) & 1 : true;
+}
+
+/**
+ * Scan records into column chunks. The callback is called each time batch->capacity
+ * rows are filled and once more for the last partial chunk when the scan completes.
+ * Bins without a matching column are skipped.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param batch			Column sink.
+ * @param callback		The function to be called for each filled chunk.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_columns(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_column_batch* batch, as_column_batch_callback callback, void* udata
+	);
+
+/**
+ * Query records into column chunks. See aerospike_scan_columns(). Aggregation queries
+ * are not supported.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param query			The query to execute against the cluster.
+ * @param batch			Column sink.
+ * @param callback		The function to be called for each filled chunk.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN as_status
+aerospike_query_columns(
+	aerospike* as, as_error* err, const as_policy_query* policy, as_query* query,
+	as_column_batch* batch, as_column_batch_callback callback, void* udata
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
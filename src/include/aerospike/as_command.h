@@ -16,15 +16,20 @@
  */
 #pragma once 
 
+#include <aerospike/as_arena.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_buffer.h>
+#include <aerospike/as_buffer_pool.h>
 #include <aerospike/as_cluster.h>
+#include <aerospike/as_compress_ratio.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_proto.h>
 #include <aerospike/as_random.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_record_raw.h>
 #include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +43,18 @@ extern "C" {
 #define AS_COMMAND_FLAGS_READ 1
 #define AS_COMMAND_FLAGS_BATCH 2
 #define AS_COMMAND_FLAGS_LINEARIZE 4
+#define AS_COMMAND_FLAGS_ZERO_COPY 8
+#define AS_COMMAND_FLAGS_GATHER 16
+#define AS_COMMAND_FLAGS_HEDGE 32
+#define AS_COMMAND_FLAGS_SCAN 64
+#define AS_COMMAND_FLAGS_QUERY 128
+#define AS_COMMAND_FLAGS_STREAM 256
+
+// Maximum commands waiting on one poll set. Windows select() is limited to 64 sockets.
+#define AS_COMMAND_MUX_MAX 64
+
+// Default outstanding commands per connection in as_command_execute_pipeline().
+#define AS_COMMAND_PIPELINE_WINDOW 32
 
 // Field IDs
 #define AS_FIELD_NAMESPACE 0
@@ -136,14 +153,28 @@ local_free(void* memory)
 /**
  * @private
  * Allocate command buffer on stack or heap depending on given size.
+ * Heap buffers are borrowed from the calling thread's buffer pool when enabled.
  */
-#define as_command_buffer_init(_sz) (_sz > AS_STACK_BUF_SIZE) ? (uint8_t*)local_malloc(_sz) : (uint8_t*)alloca(_sz)
+#define as_command_buffer_init(_sz) (_sz > AS_STACK_BUF_SIZE) ? as_buffer_pool_get(_sz) : (uint8_t*)alloca(_sz)
 
 /**
  * @private
  * Free command buffer.
  */
-#define as_command_buffer_free(_buf, _sz) if (_sz > AS_STACK_BUF_SIZE) {local_free(_buf);}
+#define as_command_buffer_free(_buf, _sz) if (_sz > AS_STACK_BUF_SIZE) {as_buffer_pool_put(_buf);}
+
+/**
+ * @private
+ * Allocate response buffer. Zero copy commands always use the heap, so the parsed record
+ * can take ownership of the buffer.
+ */
+#define as_command_response_init(_cmd, _sz) ((_cmd)->flags & AS_COMMAND_FLAGS_ZERO_COPY) ? (uint8_t*)cf_malloc(_sz) : as_command_buffer_init(_sz)
+
+/**
+ * @private
+ * Free response buffer.
+ */
+#define as_command_response_free(_cmd, _buf, _sz) if ((_cmd)->flags & AS_COMMAND_FLAGS_ZERO_COPY) {cf_free(_buf);} else {as_command_buffer_free(_buf, _sz);}
 
 /******************************************************************************
  * TYPES
@@ -157,6 +188,17 @@ typedef size_t (*as_write_fn) (void* udata, uint8_t* buf);
 
 struct as_command_s;
 
+/**
+ * @private
+ * Bin value that is sent directly from user memory instead of being copied into the
+ * command buffer.
+ */
+typedef struct as_command_gather_s {
+	const uint8_t* data;
+	uint32_t size;
+	uint32_t offset; // Command buffer offset where value is inserted.
+} as_command_gather;
+
 /**
  * @private
  * Parse results callback used in as_command_execute().
@@ -179,6 +221,12 @@ typedef struct as_command_s {
 	void* udata;
 	uint8_t* buf;
 	size_t buf_size;
+	uint8_t* response; // Zero copy response buffer that may be adopted by parsed record.
+	as_trace_span* trace; // Only set when command is sampled for tracing.
+	as_command_gather* gathers; // Only used when AS_COMMAND_FLAGS_GATHER is set.
+	uint32_t n_gathers;
+	uint32_t hedge_delay; // Only used when AS_COMMAND_FLAGS_HEDGE is set.
+	uint32_t hedge_max;
 	uint32_t partition_id;
 	as_policy_replica replica;
 	uint64_t deadline_ms;
@@ -187,7 +235,7 @@ typedef struct as_command_s {
 	uint32_t max_retries;
 	uint32_t iteration;
 	uint32_t sent;
-	uint8_t flags;
+	uint16_t flags;
 	bool master;
 	bool master_sc;   // Used in batch only.
 	bool split_retry; // Used in batch only.
@@ -200,8 +248,32 @@ typedef struct as_command_s {
 typedef struct as_command_parse_result_data_s {
 	as_record** record;
 	bool deserialize;
+	bool lazy;
+	bool arena;
 } as_command_parse_result_data;
 
+/**
+ * @private
+ * Data used in as_command_parse_bound().
+ */
+typedef struct as_command_parse_bound_data_s {
+	const struct as_binding_s* binding;
+	void* obj;
+	struct as_binding_status_s* status;
+} as_command_parse_bound_data;
+
+/**
+ * @private
+ * Record reused for every record of a scan/query node command.  The bins array and the
+ * string value buffer only grow.  Other values reference the response buffer.
+ */
+typedef struct as_record_reuse_s {
+	as_record rec;
+	uint8_t* buf;
+	uint32_t capacity;
+	uint32_t offset;
+} as_record_reuse;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -221,6 +293,27 @@ as_buffers_destroy(as_queue* buffers)
 	as_queue_destroy(buffers);
 }
 
+/**
+ * @private
+ * Return latency histogram type of command flags.
+ */
+static inline as_latency_type
+as_command_latency_type(uint16_t flags)
+{
+	if (flags & AS_COMMAND_FLAGS_BATCH) {
+		return AS_LATENCY_TYPE_BATCH;
+	}
+
+	if (flags & AS_COMMAND_FLAGS_SCAN) {
+		return AS_LATENCY_TYPE_SCAN;
+	}
+
+	if (flags & AS_COMMAND_FLAGS_QUERY) {
+		return AS_LATENCY_TYPE_QUERY;
+	}
+	return (flags & AS_COMMAND_FLAGS_READ)? AS_LATENCY_TYPE_READ : AS_LATENCY_TYPE_WRITE;
+}
+
 /**
  * @private
  * Calculate size of user key.
@@ -272,6 +365,31 @@ as_command_bin_size(const as_bin* bin, as_queue* buffers)
 	return strlen(bin->name) + as_command_value_size((as_val*)bin->valuep, buffers) + 8;
 }
 
+/**
+ * @private
+ * Return bin value size if the value should be sent directly from user memory
+ * (scatter/gather).  Return zero if the value should be copied into the command buffer.
+ * Only string and blob values at or above the threshold qualify.
+ */
+static inline uint32_t
+as_command_bin_gather_size(const as_bin* bin, uint32_t threshold)
+{
+	as_val* val = (as_val*)bin->valuep;
+	uint32_t size;
+
+	switch (val->type) {
+		case AS_STRING:
+			size = (uint32_t)as_string_len(as_string_fromval(val));
+			break;
+		case AS_BYTES:
+			size = as_bytes_fromval(val)->size;
+			break;
+		default:
+			return 0;
+	}
+	return (threshold > 0 && size >= threshold)? size : 0;
+}
+
 /**
  * @private
  * Calculate size of bin name. Return error is bin name greater than AS_BIN_NAME_MAX_LEN characters.
@@ -498,6 +616,16 @@ as_command_write_bin(
 	uint8_t* begin, as_operator operation_type, const as_bin* bin, as_queue* buffers
 	);
 
+/**
+ * @private
+ * Write bin header and bin name, but not the bin value.  The string or blob value is
+ * recorded in gather and sent directly from user memory.
+ */
+uint8_t*
+as_command_write_bin_gather(
+	uint8_t* begin, as_operator operation_type, const as_bin* bin, as_command_gather* gather
+	);
+
 /**
  * @private
  * Finish writing command.
@@ -511,6 +639,20 @@ as_command_write_end(uint8_t* begin, uint8_t* end)
 	return len;
 }
 
+/**
+ * @private
+ * Finish writing command whose bin values are partially sent from user memory.
+ * The proto length includes gather_size, but the returned command buffer length does not.
+ */
+static inline size_t
+as_command_gather_write_end(uint8_t* begin, uint8_t* end, uint64_t gather_size)
+{
+	uint64_t len = end - begin;
+	uint64_t proto = (len + gather_size - 8) | ((uint64_t)AS_PROTO_VERSION << 56) | ((uint64_t)AS_MESSAGE_TYPE << 48);
+	*(uint64_t*)begin = cf_swap_to_be64(proto);
+	return len;
+}
+
 /**
  * @private
  * Finish writing compressed command.
@@ -539,6 +681,31 @@ as_command_compress_max_size(size_t cmd_sz);
 as_status
 as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd, size_t* compressed_size);
 
+/**
+ * @private
+ * Return true if a command of the namespace and set should be compressed, based on the
+ * recently achieved compression ratio.  See as_config.compress_skip_ratio.
+ */
+static inline bool
+as_command_compress_use(as_cluster* cluster, const char* ns, const char* set)
+{
+	return ! cluster->compress_ratio || as_compress_ratio_use(cluster->compress_ratio, ns, set);
+}
+
+/**
+ * @private
+ * Record achieved compression ratio of a command of the namespace and set.
+ */
+static inline void
+as_command_compress_add(
+	as_cluster* cluster, const char* ns, const char* set, size_t size, size_t comp_size
+	)
+{
+	if (cluster->compress_ratio) {
+		as_compress_ratio_add(cluster->compress_ratio, ns, set, size, comp_size);
+	}
+}
+
 /**
  * @private
  * Return timeout to be sent to server for single record transactions.
@@ -581,11 +748,13 @@ as_command_start_timer(as_command* cmd)
 
 /**
  * @private
- * Write buffer and send command to the server.
+ * Write buffer and send command to the server.  Commands larger than comp_threshold are
+ * compressed unless recent commands of the set did not compress well.
  */
 as_status
 as_command_send(
-	as_command* cmd, as_error* err, uint32_t comp_threshold, as_write_fn write_fn, void* udata
+	as_command* cmd, as_error* err, uint32_t comp_threshold, const char* set,
+	as_write_fn write_fn, void* udata
 	);
 
 /**
@@ -595,6 +764,73 @@ as_command_send(
 as_status
 as_command_execute(as_command* cmd, as_error* err);
 
+/**
+ * @private
+ * Send single record commands on their own connections before reading any response, then
+ * parse responses in the order they arrive.  Commands are processed in groups of
+ * AS_COMMAND_MUX_MAX.  Commands that can't be sent or fail with a retryable error are
+ * retried one at a time by as_command_execute().  Hedged, gathered and node bound commands
+ * always use as_command_execute().
+ *
+ * Store each command's status in statuses.  Return AEROSPIKE_OK if every command
+ * succeeded or did not find its record.  Otherwise, return the first other error and copy
+ * its details to err.
+ */
+as_status
+as_command_execute_many(as_command* cmds, uint32_t n_cmds, as_status* statuses, as_error* err);
+
+/**
+ * @private
+ * Send single record commands over one connection per node, keeping up to window commands
+ * outstanding on each connection.  Responses are read in send order.  Commands that can't be
+ * routed or whose connection fails are run by as_command_execute(), and commands that were
+ * already sent on a failed connection are retried.  Hedged, gathered and node bound commands
+ * always use as_command_execute().
+ *
+ * Store each command's status in statuses.  Return value and err follow
+ * as_command_execute_many().
+ */
+as_status
+as_command_execute_pipeline(
+	as_command* cmds, uint32_t n_cmds, uint32_t window, as_status* statuses, as_error* err
+	);
+
+/**
+ * @private
+ * Initialize trace span of sampled command.  Namespace, digest and partition are read from
+ * the uncompressed command buffer when present.  ns is used when the buffer has no namespace
+ * field and may be NULL.
+ */
+void
+as_command_trace_init(
+	as_trace_span* span, as_cluster* cluster, const char* ns, const uint8_t* buf, size_t size,
+	bool async
+	);
+
+/**
+ * @private
+ * Add completed single record command to the cluster's hot key sketches.  Commands without
+ * a digest are ignored.
+ */
+void
+as_command_trace_hot_key(as_cluster* cluster, as_trace_span* span);
+
+/**
+ * @private
+ * Start next attempt of traced command on node.
+ */
+static inline void
+as_command_trace_attempt(as_trace_span* span, const char* node_name)
+{
+	span->attempts++;
+	span->begin_ns = cf_getns();
+	span->connect_ns = 0;
+	span->send_ns = 0;
+	span->first_byte_ns = 0;
+	span->bytes_in = 0;
+	memcpy(span->node_name, node_name, sizeof(span->node_name));
+}
+
 /**
  * @private
  * Parse header of server response.
@@ -609,6 +845,14 @@ as_command_parse_header(as_error* err, as_command* cmd, as_node* node, uint8_t*
 as_status
 as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size);
 
+/**
+ * @private
+ * Parse server record into the as_stream_bin udata.  Used for streaming reads when the
+ * response was not read directly from the socket.
+ */
+as_status
+as_command_parse_stream(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size);
+
 /**
  * @private
  * Parse server success or failure result.
@@ -616,6 +860,13 @@ as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t*
 as_status
 as_command_parse_success_failure(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size);
 
+/**
+ * @private
+ * Parse single record response into a user struct with the binding in cmd->udata.
+ */
+as_status
+as_command_parse_bound(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size);
+
 /**
  * @private
  * Parse server success or failure bins.
@@ -625,10 +876,51 @@ as_command_parse_success_failure_bins(uint8_t** pp, as_error* err, as_msg* msg,
 
 /**
  * @private
- * Parse bins received from the server.
+ * Parse bins received from the server.  If zero_copy is true, blob and raw list/map
+ * bin values reference the response buffer instead of being copied.  The caller must
+ * keep the response buffer alive until the record is destroyed.
+ */
+as_status
+as_command_parse_bins(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize, bool zero_copy
+	);
+
+/**
+ * @private
+ * Parse bins received from the server and copy their values to the arena chunk.  The chunk
+ * must have room for the record's wire size.  Only deserialized lists/maps are allocated
+ * separately.
  */
 as_status
-as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize);
+as_command_parse_bins_arena(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize,
+	as_arena_chunk* chunk
+	);
+
+/**
+ * @private
+ * Initialize reused record.
+ */
+void
+as_record_reuse_init(as_record_reuse* reuse);
+
+/**
+ * @private
+ * Destroy reused record and its buffers.
+ */
+void
+as_record_reuse_destroy(as_record_reuse* reuse);
+
+/**
+ * @private
+ * Release values of the previous record and parse key and bins into the reused record.
+ * Values are only valid until the next record is parsed or the response buffer is released.
+ */
+as_status
+as_command_parse_record_reuse(
+	uint8_t** pp, as_error* err, as_msg* msg, as_record_reuse* reuse, bool deserialize,
+	uint64_t* bval
+	);
 
 /**
  * @private
@@ -658,6 +950,28 @@ as_command_ignore_bins(uint8_t* p, uint32_t n_bins);
 uint8_t*
 as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval);
 
+/**
+ * @private
+ * Parse only digest and bval fields received from server.  Other fields are skipped.
+ */
+uint8_t*
+as_command_parse_digest(uint8_t* p, uint32_t n_fields, as_digest* digest, uint64_t* bval);
+
+/**
+ * @private
+ * Set raw record header, digest and bin location without decoding bins.  Return position
+ * after the record.
+ */
+uint8_t*
+as_command_parse_record_raw(uint8_t* p, as_msg* msg, as_record_raw* rec, uint64_t* bval);
+
+/**
+ * @private
+ * Decode particle value into a heap allocated value.
+ */
+void
+as_command_parse_value(uint8_t* p, uint8_t type, uint32_t value_size, as_val** value);
+
 /**
  * @private
  * Return random task id if not specified.
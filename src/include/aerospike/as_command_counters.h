@@ -0,0 +1,121 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of command counter shards per node. Threads are spread across shards, so
+ * threads rarely increment the same cache line.
+ */
+#define AS_COMMAND_COUNTER_SHARDS 8
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Monotonic database command counters. Compressed byte counts are also included in
+ * bytes_out and bytes_in.
+ * @ingroup cluster_stats
+ */
+typedef struct as_command_counters_s {
+	/**
+	 * Command attempts sent, including retries.
+	 */
+	uint64_t commands;
+
+	/**
+	 * Command retries.
+	 */
+	uint64_t retries;
+
+	/**
+	 * Command attempts that hit the socket timeout (client side).
+	 */
+	uint64_t socket_timeouts;
+
+	/**
+	 * Commands that failed because the total timeout expired.
+	 */
+	uint64_t total_timeouts;
+
+	/**
+	 * Bytes sent to the server.
+	 */
+	uint64_t bytes_out;
+
+	/**
+	 * Bytes received from the server.
+	 */
+	uint64_t bytes_in;
+
+	/**
+	 * Bytes of compressed commands sent to the server.
+	 */
+	uint64_t compressed_out;
+
+	/**
+	 * Uncompressed size of compressed commands sent to the server.
+	 */
+	uint64_t uncompressed_out;
+
+	/**
+	 * Bytes of compressed responses received from the server.
+	 */
+	uint64_t compressed_in;
+
+	/**
+	 * Uncompressed size of compressed responses received from the server.
+	 */
+	uint64_t uncompressed_in;
+
+	/**
+	 * Async commands rejected because the event loop's delay queue was full. Only counted
+	 * per event loop.
+	 */
+	uint64_t delay_queue_rejects;
+
+	/**
+	 * Async commands rejected with AEROSPIKE_ERR_ASYNC_OVERLOAD by admission control. Only
+	 * counted per event loop.
+	 */
+	uint64_t overload_rejects;
+
+} as_command_counters;
+
+/**
+ * @private
+ * Command counter shard padded to separate cache lines.
+ */
+typedef struct as_command_counter_shard_s {
+	as_command_counters counters;
+	uint8_t pad[128 - sizeof(as_command_counters)];
+} as_command_counter_shard;
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
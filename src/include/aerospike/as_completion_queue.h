@@ -0,0 +1,197 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Opaque queue of async command completions.  Commands post completions to the queue instead
+ * of running application code on the event loop threads.  Application threads collect
+ * completions in batches with as_completion_queue_poll() or as_completion_queue_wait().
+ *
+ * Event loops post into a lock-free ring.  If the ring is full, completions are kept in an
+ * overflow list, so event loops never block and completions are never dropped.
+ *
+ * @ingroup async_events
+ */
+typedef struct as_completion_queue_s as_completion_queue;
+
+/**
+ * Async command completion.
+ *
+ * @ingroup async_events
+ */
+typedef struct as_completion_s {
+	/**
+	 * User data from the command's as_completion_tag.
+	 */
+	void* udata;
+
+	/**
+	 * Command result.  The caller owns the result and must destroy it.
+	 *
+	 * - as_completion_queue_write_listener(): Always NULL.
+	 * - as_completion_queue_record_listener(): as_record* on success. Destroy with
+	 *   as_record_destroy().  The command policy's async_heap_rec must be true.
+	 * - as_completion_queue_value_listener(): as_val* on success. Destroy with as_val_destroy().
+	 */
+	void* result;
+
+	/**
+	 * Command status.
+	 */
+	as_status status;
+
+	/**
+	 * Is it possible that the write completed even though an error was returned.
+	 */
+	bool in_doubt;
+} as_completion;
+
+/**
+ * Routes an async command completion to a completion queue.  Pass a pointer to the tag as the
+ * command's udata and one of the as_completion_queue listeners as the command's listener.
+ * The tag must stay valid until the command completes.
+ *
+ * @ingroup async_events
+ */
+typedef struct as_completion_tag_s {
+	/**
+	 * Queue that receives the completion.
+	 */
+	as_completion_queue* queue;
+
+	/**
+	 * User data returned in as_completion.udata.
+	 */
+	void* udata;
+} as_completion_tag;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Create completion queue.  Capacity of the lock-free ring is rounded up to a power of 2.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_completion_queue* cq = as_completion_queue_create(4096);
+ *
+ * as_completion_tag tag = {.queue = cq, .udata = my_request};
+ * aerospike_key_put_async(&as, &err, NULL, &key, &rec, as_completion_queue_write_listener,
+ *     &tag, NULL, NULL);
+ *
+ * as_completion completions[64];
+ * uint32_t n = as_completion_queue_wait(cq, completions, 64, 1, 1000);
+ * ~~~~~~~~~~
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN as_completion_queue*
+as_completion_queue_create(uint32_t capacity);
+
+/**
+ * Destroy completion queue.  All commands that post to the queue must have completed.
+ * Results of completions that were never collected are not destroyed.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_completion_queue_destroy(as_completion_queue* cq);
+
+/**
+ * Post completion to the queue.  Safe to call from any thread.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_completion_queue_push(as_completion_queue* cq, const as_completion* completion);
+
+/**
+ * Collect up to max completions without blocking.  Return number of completions collected.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN uint32_t
+as_completion_queue_poll(as_completion_queue* cq, as_completion* completions, uint32_t max);
+
+/**
+ * Block until at least min completions are available or timeout_ms expires, then collect up
+ * to max completions.  Event loops only wake waiting threads when enough completions are
+ * available, so larger min values batch wakeups.  If timeout_ms is zero, wait forever.
+ * Return number of completions collected, which can be less than min on timeout.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN uint32_t
+as_completion_queue_wait(
+	as_completion_queue* cq, as_completion* completions, uint32_t max, uint32_t min,
+	uint32_t timeout_ms
+	);
+
+/**
+ * Return approximate number of completions in the queue.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN uint32_t
+as_completion_queue_size(as_completion_queue* cq);
+
+/**
+ * Write listener that posts completions.  The udata must be an as_completion_tag*.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_completion_queue_write_listener(as_error* err, void* udata, as_event_loop* event_loop);
+
+/**
+ * Record listener that posts completions.  The udata must be an as_completion_tag* and the
+ * command policy's async_heap_rec must be true, so the record outlives the listener.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_completion_queue_record_listener(
+	as_error* err, as_record* record, void* udata, as_event_loop* event_loop
+	);
+
+/**
+ * Value listener that posts completions.  The udata must be an as_completion_tag*.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_completion_queue_value_listener(
+	as_error* err, as_val* val, void* udata, as_event_loop* event_loop
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
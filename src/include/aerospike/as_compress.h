@@ -0,0 +1,160 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Compression codec used for compressed proto messages.
+ */
+typedef enum as_compress_codec_e {
+	/**
+	 * zlib deflate. This is the only codec defined by the compressed message
+	 * type (AS_COMPRESSED_MESSAGE_TYPE) and is supported by all servers.
+	 */
+	AS_COMPRESS_ZLIB
+} as_compress_codec;
+
+/**
+ * Compression stream context statistics.  Each thread keeps its own deflate and inflate
+ * stream contexts which are reset and reused across commands.  Async commands are
+ * compressed/decompressed on event loop threads, so each event loop reuses its own contexts.
+ */
+typedef struct as_compress_stats_s {
+	/**
+	 * Number of deflate (compress) contexts created.
+	 */
+	uint64_t deflate_created;
+
+	/**
+	 * Number of times an existing deflate context was reset and reused.
+	 */
+	uint64_t deflate_reused;
+
+	/**
+	 * Number of inflate (decompress) contexts created.
+	 */
+	uint64_t inflate_created;
+
+	/**
+	 * Number of times an existing inflate context was reset and reused.
+	 */
+	uint64_t inflate_reused;
+
+} as_compress_stats;
+
+/**
+ * @private
+ * Codec implementation.
+ */
+typedef struct as_compress_ops_s {
+	const char* name;
+	size_t (*bound)(size_t src_sz);
+	int (*compress)(uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz);
+	int (*decompress)(uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz);
+} as_compress_ops;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Retrieve process wide compression context statistics.
+ */
+AS_EXTERN void
+as_compress_get_stats(as_compress_stats* stats);
+
+/**
+ * Free compression contexts held by the calling thread. Contexts are also freed
+ * automatically when a thread exits.
+ */
+AS_EXTERN void
+as_compress_release_thread(void);
+
+/**
+ * @private
+ * Return codec implementation.
+ */
+const as_compress_ops*
+as_compress_get_ops(as_compress_codec codec);
+
+/**
+ * @private
+ * Return maximum compressed size of a buffer of the given size.
+ */
+static inline size_t
+as_compress_bound(as_compress_codec codec, size_t src_sz)
+{
+	return as_compress_get_ops(codec)->bound(src_sz);
+}
+
+/**
+ * @private
+ * Compress src into trg. On input, trg_sz is the trg capacity. On output, trg_sz is the
+ * compressed size.
+ */
+as_status
+as_compress(
+	as_error* err, as_compress_codec codec, uint8_t* trg, size_t* trg_sz, const uint8_t* src,
+	size_t src_sz
+	);
+
+/**
+ * @private
+ * Decompress src into trg. On input, trg_sz is the trg capacity. On output, trg_sz is the
+ * decompressed size.
+ */
+as_status
+as_decompress(
+	as_error* err, as_compress_codec codec, uint8_t* trg, size_t* trg_sz, const uint8_t* src,
+	size_t src_sz
+	);
+
+/**
+ * @private
+ * Compress src into trg with a zlib preset dictionary. trg_sz is used like as_compress().
+ */
+as_status
+as_compress_with_dict(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz,
+	const uint8_t* dict, size_t dict_sz
+	);
+
+/**
+ * @private
+ * Decompress src into trg with the zlib preset dictionary used to compress it. trg_sz is
+ * used like as_decompress().
+ */
+as_status
+as_decompress_with_dict(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz,
+	const uint8_t* dict, size_t dict_sz
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_policy.h>
+#include <aerospike/as_scan.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Maximum number of registered dictionaries.
+ */
+#define AS_COMPRESS_DICT_MAX 64
+
+/**
+ * Maximum useful dictionary size.  Deflate only references the last 32 KB of a dictionary.
+ */
+#define AS_COMPRESS_DICT_MAX_SIZE (32 * 1024)
+
+/**
+ * Size of the header that precedes dictionary compressed data: 4 byte dictionary ID and
+ * 4 byte uncompressed size, both big endian.
+ */
+#define AS_COMPRESS_DICT_HEADER_SIZE 8
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Register a zlib preset dictionary under an ID.  The dictionary is copied.  The ID is
+ * stored in the header of every value compressed with it, so it must keep referring to the
+ * same dictionary for as long as such values exist.
+ *
+ * Dictionary compression is applied to bin values by the application.  Command compression
+ * (as_policy_base.compress) stays plain zlib, because the server must be able to inflate it.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_compress_dict_register(&err, 1, dict, dict_size);
+ *
+ * uint8_t* buf = malloc(as_compress_dict_bound(size));
+ * size_t buf_size = as_compress_dict_bound(size);
+ * as_compress_dict_compress(&err, 1, buf, &buf_size, json, size);
+ * as_record_set_raw(&rec, "doc", buf, (uint32_t)buf_size);
+ * ~~~~~~~~~~
+ *
+ * @param err		Error message that is populated on error.
+ * @param id		Dictionary ID.  Must not be zero.
+ * @param dict		Dictionary bytes.
+ * @param size		Dictionary size.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ */
+AS_EXTERN as_status
+as_compress_dict_register(as_error* err, uint32_t id, const uint8_t* dict, uint32_t size);
+
+/**
+ * Remove dictionary.  Compress and decompress calls that already hold the dictionary finish
+ * with it.
+ */
+AS_EXTERN void
+as_compress_dict_unregister(uint32_t id);
+
+/**
+ * Return maximum size of src_sz bytes compressed by as_compress_dict_compress().
+ */
+AS_EXTERN size_t
+as_compress_dict_bound(size_t src_sz);
+
+/**
+ * Compress src with a registered dictionary.  On input, trg_sz is the trg capacity, which
+ * must be at least as_compress_dict_bound(src_sz).  On output, trg_sz is the compressed size
+ * including the header.
+ */
+AS_EXTERN as_status
+as_compress_dict_compress(
+	as_error* err, uint32_t id, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz
+	);
+
+/**
+ * Read the uncompressed size and dictionary ID from the header of dictionary compressed
+ * data.
+ */
+AS_EXTERN as_status
+as_compress_dict_info(
+	as_error* err, const uint8_t* src, size_t src_sz, uint32_t* id, size_t* size
+	);
+
+/**
+ * Decompress data produced by as_compress_dict_compress().  The dictionary is found by the
+ * ID in the header.  On input, trg_sz is the trg capacity.  On output, trg_sz is the
+ * decompressed size.
+ */
+AS_EXTERN as_status
+as_compress_dict_decompress(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz
+	);
+
+/**
+ * Build a dictionary from sample values.  Segments that repeat across samples are counted
+ * and the most frequent ones are concatenated, with the most frequent at the end where
+ * deflate encodes matches most cheaply.  Remaining space is filled with sample data.
+ *
+ * @param samples	Sample values.
+ * @param sizes		Size of each sample.
+ * @param n_samples	Number of samples.
+ * @param dict		Populated with the dictionary.
+ * @param capacity	Size of dict.  Only AS_COMPRESS_DICT_MAX_SIZE bytes are used.
+ *
+ * @return Dictionary size.
+ */
+AS_EXTERN uint32_t
+as_compress_dict_train(
+	const uint8_t** samples, const size_t* sizes, uint32_t n_samples, uint8_t* dict,
+	uint32_t capacity
+	);
+
+/**
+ * Sample string and blob values of one bin with a scan and build a dictionary from them.
+ * The scan stops after max_samples values.
+ *
+ * @param as			Aerospike instance.
+ * @param err			Error message that is populated on error.
+ * @param policy		Scan policy. If NULL, then the default policy will be used.
+ * @param scan			Scan of the namespace and set to sample.
+ * @param bin			Bin to sample.
+ * @param max_samples	Maximum number of values to sample.
+ * @param dict			Populated with the dictionary.
+ * @param capacity		Size of dict.
+ * @param dict_size		Populated with the dictionary size.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ */
+AS_EXTERN as_status
+as_compress_dict_train_scan(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	const char* bin, uint32_t max_samples, uint8_t* dict, uint32_t capacity,
+	uint32_t* dict_size
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of namespace/set ratio slots.  Must be a power of 2.
+ */
+#define AS_COMPRESS_RATIO_SLOTS 256
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Recently achieved command compression ratio per namespace and set.  Sets are hashed into
+ * a fixed number of slots, so sets that collide share a ratio.  Slots are updated without
+ * locks.  A lost update only delays the ratio by one command.
+ */
+typedef struct as_compress_ratio_s as_compress_ratio;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create stats that skip compression when commands compress to more than max_ratio percent
+ * of their size.  One of every sample_interval skipped commands is compressed to update the
+ * ratio.
+ */
+as_compress_ratio*
+as_compress_ratio_create(uint32_t max_ratio, uint32_t sample_interval);
+
+/**
+ * @private
+ * Destroy stats.
+ */
+void
+as_compress_ratio_destroy(as_compress_ratio* stats);
+
+/**
+ * @private
+ * Return true if the next command of the namespace and set should be compressed.
+ */
+bool
+as_compress_ratio_use(as_compress_ratio* stats, const char* ns, const char* set);
+
+/**
+ * @private
+ * Record the compressed size of a command of the namespace and set.
+ */
+void
+as_compress_ratio_add(
+	as_compress_ratio* stats, const char* ns, const char* set, size_t size, size_t comp_size
+	);
+
+/**
+ * @private
+ * Return recent compression ratio of the namespace and set in percent, or zero if no command
+ * was compressed yet.
+ */
+uint32_t
+as_compress_ratio_get(as_compress_ratio* stats, const char* ns, const char* set);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
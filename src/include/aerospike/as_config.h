@@ -20,6 +20,7 @@
 #include <aerospike/as_host.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_password.h>
+#include <aerospike/as_trace.h>
 #include <aerospike/as_vector.h>
 
 #ifdef __cplusplus
@@ -55,6 +56,11 @@ extern "C" {
  */
 #define AS_CONFIG_PATH_MAX_LEN 	(AS_CONFIG_PATH_MAX_SIZE - 1)
 
+/**
+ * The size of the lua warm up function list.
+ */
+#define AS_CONFIG_LUA_WARM_MAX_SIZE 256
+
 /**
  * Max clear text password size.
  */
@@ -117,6 +123,54 @@ typedef enum as_auth_mode_e {
 	AS_AUTH_PKI
 } as_auth_mode;
 
+/**
+ * Sync connection pool selection when conn_pools_per_node is greater than one.
+ *
+ * @ingroup as_config_object
+ */
+typedef enum as_conn_pool_affinity_e {
+	/**
+	 * Rotate through pools on each command. This is the default.
+	 */
+	AS_CONN_POOL_AFFINITY_NONE,
+
+	/**
+	 * Each calling thread is assigned a preferred pool on first use.
+	 */
+	AS_CONN_POOL_AFFINITY_THREAD,
+
+	/**
+	 * Preferred pool is chosen from the cpu the calling thread is running on.  Falls back
+	 * to AS_CONN_POOL_AFFINITY_THREAD on platforms without sched_getcpu().
+	 */
+	AS_CONN_POOL_AFFINITY_CPU
+} as_conn_pool_affinity;
+
+/**
+ * Kernel socket options applied to new synchronous connections.  Zero values leave the
+ * system defaults.
+ *
+ * @ingroup as_config_object
+ */
+typedef struct as_socket_profile_s {
+	/**
+	 * SO_RCVBUF in bytes.
+	 */
+	uint32_t recv_buffer_size;
+
+	/**
+	 * SO_SNDBUF in bytes.
+	 */
+	uint32_t send_buffer_size;
+
+	/**
+	 * Acknowledge received data immediately instead of delaying the ACK (TCP_QUICKACK,
+	 * Linux only).  Linux clears this option as the connection runs, so it is set again
+	 * after each read.
+	 */
+	bool quickack;
+} as_socket_profile;
+
 /**
  * Cluster event notification type.
  *
@@ -136,7 +190,19 @@ typedef enum as_cluster_event_type_e {
 	/**
 	 * There are no active nodes in the cluster.
 	 */
-	AS_CLUSTER_DISCONNECTED = 2
+	AS_CLUSTER_DISCONNECTED = 2,
+
+	/**
+	 * Seed node was validated. Seeds are tried in parallel when tend_thread_pool_size
+	 * is greater than zero, so this is the first seed node that responded with peers.
+	 */
+	AS_CLUSTER_SEED_NODE = 3,
+
+	/**
+	 * Initial cluster tend completed. All nodes have been added and partition maps have
+	 * been retrieved. Commands can be run from this point on.
+	 */
+	AS_CLUSTER_CONNECTED = 4
 } as_cluster_event_type;
 
 /**
@@ -164,6 +230,12 @@ typedef struct as_cluster_event_s {
 	 * Cluster event notification type.
 	 */
 	as_cluster_event_type type;
+
+	/**
+	 * Milliseconds since the cluster was created. Startup events (AS_CLUSTER_SEED_NODE,
+	 * AS_CLUSTER_ADD_NODE and AS_CLUSTER_CONNECTED) form a timeline of cluster bootstrap.
+	 */
+	uint64_t elapsed_ms;
 } as_cluster_event;
 
 /**
@@ -175,6 +247,17 @@ typedef struct as_cluster_event_s {
  */
 typedef void (*as_cluster_event_callback) (as_cluster_event* event);
 
+struct as_cluster_stats_s;
+
+/**
+ * Periodic metrics callback function.  The snapshot is owned and reused by the client.
+ * It is only valid during the callback and must not be destroyed.  The callback runs
+ * in the cluster tend thread, so it should return quickly.
+ *
+ * @ingroup as_config_object
+ */
+typedef void (*as_metrics_callback) (struct as_cluster_stats_s* stats, void* udata);
+
 /**
  * lua module config
  *
@@ -194,6 +277,21 @@ typedef struct as_config_lua_s {
 	 */
 	char user_path[AS_CONFIG_PATH_MAX_SIZE];
 
+	/**
+	 * Comma separated list of "module.function" stream UDFs that are run on an empty
+	 * stream when lua is initialized by the first aerospike_connect().  Each function is
+	 * run in warm_states concurrent calls, so that many lua states with the module loaded
+	 * and the function compiled are in the cache before the first aggregation query.
+	 * Requires cache_enabled.  Default: empty (no warm up).
+	 */
+	char warm_functions[AS_CONFIG_LUA_WARM_MAX_SIZE];
+
+	/**
+	 * Number of lua states created per warm up function.  Zero uses the number of CPUs.
+	 * Default: 0
+	 */
+	uint32_t warm_states;
+
 } as_config_lua;
 
 /**
@@ -319,6 +417,32 @@ typedef struct as_config_tls_s {
 	 */
 	bool for_login_only;
 
+	/**
+	 * Enable kernel TLS (kTLS) offload after the TLS handshake.  The kernel then encrypts
+	 * and decrypts records, which removes user-space crypto from the client.  Sync commands
+	 * on offloaded connections send with the plain socket (or io_uring) write path.  Reads
+	 * still go through OpenSSL so TLS control records are handled, but decryption happens
+	 * in the kernel.
+	 *
+	 * Requires OpenSSL 3.0+ built with kTLS support and a kernel with the tls module loaded.
+	 * Connections fall back to user-space TLS when the kernel or negotiated cipher is not
+	 * supported.  The number of offloaded connections is reported in aerospike_stats.
+	 *
+	 * Default: false
+	 */
+	bool enable_ktls;
+
+	/**
+	 * Cache TLS sessions (session tickets or TLS 1.3 PSK) for each node address and
+	 * tls_name, and resume them when new sync connections are opened.  Resumed handshakes
+	 * skip certificate exchange and verification, which reduces cpu and latency when many
+	 * connections are opened at once (client startup, node restarts, idle connection trims).
+	 * The server must have session resumption enabled.
+	 *
+	 * Default: false
+	 */
+	bool session_cache;
+
 } as_config_tls;
 
 /**
@@ -427,6 +551,21 @@ typedef struct as_config_s {
 	 * Default: NULL
 	 */
 	char* cluster_name;
+
+	/**
+	 * Topology snapshot file for warm start. If not null, the cluster tend thread writes
+	 * nodes and partition maps to this file whenever they change. On the next cluster
+	 * creation, nodes and partition maps are restored from the file, so commands can be
+	 * routed immediately instead of after seed discovery and partition map retrieval.
+	 * The restored view is verified by the first cluster tend in the background, and
+	 * seeds are used when no restored node responds.
+	 *
+	 * The file is ignored when it was written for a different cluster_name or when
+	 * shared memory is used. Use as_config_set_topology_file() to set this field.
+	 *
+	 * Default: NULL
+	 */
+	char* topology_file;
 	
 	/**
 	 * Cluster event function that will be called when nodes are added/removed from the cluster.
@@ -511,6 +650,45 @@ typedef struct as_config_s {
 	 */
 	uint32_t async_max_conns_per_node;
 
+	/**
+	 * Adaptive async connection pre-warming headroom percent.  When greater than zero, each
+	 * event loop tracks peak async connection demand per node between cluster tends and keeps
+	 * enough connections open to cover that peak, its most recent growth and this percent of
+	 * extra headroom.  New connections are then opened in the background before a load ramp
+	 * reaches them, instead of inline on the command path.  When demand drops, the target
+	 * decays by one eighth per tend and idle connections above the target are closed once
+	 * they exceed max_socket_idle.  The target is bounded by async_min_conns_per_node and
+	 * async_max_conns_per_node.
+	 *
+	 * Default: 0 (disabled)
+	 */
+	uint32_t async_conn_prewarm;
+
+	/**
+	 * Maximum bytes of async commands in flight to each node, summed over all event loops.
+	 * A command's bytes are counted from the time it is assigned a node until it completes
+	 * or is retried on another node.  New commands that would exceed the limit are rejected
+	 * immediately with AEROSPIKE_ERR_ASYNC_OVERLOAD, so an overloaded node does not collect
+	 * large commands that will only time out.  A command is always admitted when no other
+	 * bytes are in flight to the node.
+	 *
+	 * Default: 0 (no limit)
+	 */
+	uint32_t async_max_bytes_per_node;
+
+	/**
+	 * Number of threads that open TLS connections for async connection pools.  When greater
+	 * than zero and TLS is enabled, connections created in the background to maintain
+	 * async_min_conns_per_node or async_conn_prewarm are connected, handshaked and
+	 * authenticated on these threads and then handed to the event loop, so expensive
+	 * handshakes do not delay commands already running on that loop.  Commands that find
+	 * the pool empty still connect on the event loop.  Only supported with libev and
+	 * libevent.  Ignored otherwise.
+	 *
+	 * Default: 0 (handshake on event loop)
+	 */
+	uint32_t async_tls_threads;
+
 	/**
 	 * Maximum number of pipeline connections allowed for each node.
 	 * This limit will be enforced at the node/event loop level.  If the value is 100 and 2 event
@@ -521,6 +699,23 @@ typedef struct as_config_s {
 	 * Default: 64
 	 */
 	uint32_t pipe_max_conns_per_node;
+
+	/**
+	 * Adaptive pipeline depth.  Commands are always sent on the pooled pipeline connection
+	 * with the fewest commands waiting for a response, and a response that takes a long time
+	 * only holds up the commands queued behind it on that connection.
+	 *
+	 * When zero, new pipeline connections are opened until pipe_max_conns_per_node is reached
+	 * before pooled connections are reused.  When greater than zero, a pooled connection is
+	 * reused while its queue holds fewer than pipe_max_depth commands, and a new connection is
+	 * opened only when every pooled connection is at that depth.  Idle pipeline connections
+	 * that have not been used within max_socket_idle are then closed, one per command, so the
+	 * pipeline connection count follows the observed queueing.  When pipe_max_conns_per_node
+	 * is reached, commands use the shortest queue even if it is deeper than pipe_max_depth.
+	 *
+	 * Default: 0
+	 */
+	uint32_t pipe_max_depth;
 	
 	/**
 	 * Number of synchronous connection pools used for each node.  Machines with 8 cpu cores or
@@ -533,6 +728,77 @@ typedef struct as_config_s {
 	 */
 	uint32_t conn_pools_per_node;
 
+	/**
+	 * Use lock free stacks instead of mutex protected queues for synchronous connection pools.
+	 * Transaction threads then borrow and return connections with a single compare-and-swap,
+	 * which can reduce contention on machines with a large number of cpu cores.  Connections
+	 * are still reused in most recently used order.
+	 *
+	 * Default: false
+	 */
+	bool lock_free_conn_pools;
+
+	/**
+	 * Sync connection pool selection when conn_pools_per_node is greater than one.
+	 * With thread or cpu affinity, a command first borrows an idle connection from its
+	 * preferred pool and only takes idle connections from other pools when the preferred pool
+	 * is empty.  This keeps sockets and their kernel buffers hot on the same core and reduces
+	 * cross-core traffic on pool locks.
+	 *
+	 * Default: AS_CONN_POOL_AFFINITY_NONE
+	 */
+	as_conn_pool_affinity conn_pool_affinity;
+
+	/**
+	 * SO_BUSY_POLL value in microseconds set on new synchronous connections (Linux only).
+	 * When set, the kernel polls the network device queue while a command waits for its
+	 * response instead of sleeping until the next interrupt.  This reduces latency at the
+	 * cost of cpu.  Usually combined with as_policy_base.read_spin_us on latency critical
+	 * policies.  Zero leaves the system default.
+	 *
+	 * Default: 0
+	 */
+	uint32_t socket_busy_poll;
+
+	/**
+	 * Read-ahead buffer size in bytes for each non-TLS synchronous connection.  Response
+	 * headers and small bodies are then received up to this many bytes at a time and
+	 * following reads are served from the buffer.  This roughly halves receive system calls
+	 * for single record commands and greatly reduces them for scan, query and batch
+	 * responses.  Reads at least this large bypass the buffer.  The buffer is allocated
+	 * for each connection, so memory usage is this size times the number of connections.
+	 * A typical value is 65536.
+	 *
+	 * Default: 0 (no read-ahead)
+	 */
+	uint32_t socket_read_buffer;
+
+	/**
+	 * Socket options for synchronous connections used by single record, batch, info and
+	 * admin commands.  Latency sensitive reads usually want the small system default
+	 * buffers with quickack enabled.
+	 */
+	as_socket_profile point_socket_profile;
+
+	/**
+	 * Socket options for synchronous connections used by scan and query commands.  Only
+	 * applies when bulk_max_conns_per_node is greater than zero.  Record streams usually
+	 * want large receive buffers (for example 4 MB) so the server is not throttled by the
+	 * receive window.
+	 */
+	as_socket_profile bulk_socket_profile;
+
+	/**
+	 * Maximum synchronous connections per node reserved for scan and query commands.
+	 * When set, scans and queries use a separate connection pool created with
+	 * bulk_socket_profile, so long record streams do not take connections (or their
+	 * tuning) from latency sensitive commands.  These connections are not counted in
+	 * max_conns_per_node.
+	 *
+	 * Default: 0 (scans and queries share the regular pools)
+	 */
+	uint32_t bulk_max_conns_per_node;
+
 	/**
 	 * Initial host connection timeout in milliseconds.  The timeout when opening a connection
 	 * to the server host for the first time.
@@ -546,6 +812,87 @@ typedef struct as_config_s {
 	 */
 	uint32_t login_timeout_ms;
 
+	/**
+	 * Milliseconds before the server expires a session token that the tend thread logs in
+	 * again.  The new token is swapped in atomically, so new connections never see an expired
+	 * token and never wait on a login.  Limited to half the session TTL.
+	 * Default: 120000
+	 */
+	uint32_t session_refresh_ms;
+
+	/**
+	 * Seconds that resolved seed and peer hostname addresses are cached.  An expired entry is
+	 * still used while a background thread resolves the hostname again, so the tend thread
+	 * blocks on DNS only the first time a hostname is resolved.  Numeric addresses are not
+	 * cached.  If zero, hostnames are resolved on every lookup.
+	 *
+	 * Default: 0
+	 */
+	uint32_t dns_cache_ttl;
+
+	/**
+	 * Maximum number of records held by the client-side record cache.  Reads use the cache
+	 * when as_policy_read.cache is set.  Local writes through this client remove the
+	 * written record from the cache.  Changes made by other clients are only seen after
+	 * record_cache_ttl_ms, unless reads use AS_POLICY_CACHE_VALIDATE.  If zero, the cache is
+	 * disabled.
+	 *
+	 * Default: 0
+	 */
+	uint32_t record_cache_max;
+
+	/**
+	 * Milliseconds a cached record may be returned without asking the server.
+	 *
+	 * Default: 1000
+	 */
+	uint32_t record_cache_ttl_ms;
+
+	/**
+	 * Number of recently not found keys remembered by the negative cache.  Reads use the
+	 * cache when as_policy_read.negative_cache is set.  Local writes through this client
+	 * remove the key from the cache.  Records created by other clients are only seen after
+	 * negative_cache_ttl_ms.  If zero, the negative cache is disabled.
+	 *
+	 * Default: 0
+	 */
+	uint32_t negative_cache_max;
+
+	/**
+	 * Maximum milliseconds a key is remembered as not found.  Keys are remembered for at
+	 * least half this time.
+	 *
+	 * Default: 1000
+	 */
+	uint32_t negative_cache_ttl_ms;
+
+	/**
+	 * Probability that the negative cache reports a key as not found that was never
+	 * looked up.  Lower rates use larger filter entries.
+	 *
+	 * Default: 0.001
+	 */
+	double negative_cache_fpr;
+
+	/**
+	 * Skip compression (as_policy_base.compress) of put, operate and apply commands to a
+	 * namespace and set whose recent commands compressed to more than this percentage of their
+	 * original size, so incompressible data does not cost compression CPU.  One of every
+	 * compress_sample_interval skipped commands is still compressed, so the tracked ratio
+	 * follows changes in the data.  If zero, commands are always compressed.
+	 *
+	 * Default: 0
+	 */
+	uint32_t compress_skip_ratio;
+
+	/**
+	 * Number of commands that skip compression for every command that is compressed to
+	 * measure the ratio again.  See compress_skip_ratio.
+	 *
+	 * Default: 100
+	 */
+	uint32_t compress_sample_interval;
+
 	/**
 	 * Maximum socket idle in seconds.  Connection pools will discard sockets that have been 
 	 * idle longer than the maximum.
@@ -579,6 +926,13 @@ typedef struct as_config_s {
 	 * The application should backoff or reduce the transaction load until AEROSPIKE_MAX_ERROR_RATE
 	 * stops being returned.
 	 *
+	 * Each node has a circuit breaker driven by error windows.  When max_error_rate is exceeded,
+	 * the breaker opens and all commands to the node are rejected for a number of windows that
+	 * doubles on every consecutive failure up to error_rate_backoff_max.  The breaker then
+	 * becomes half-open and admits one of every error_rate_probe_interval commands.  If the
+	 * probes stay under max_error_rate / error_rate_probe_interval errors for one window, the
+	 * breaker closes.  Otherwise, it opens again.
+	 *
 	 * Default: 0
 	 */
 	uint32_t max_error_rate;
@@ -586,19 +940,173 @@ typedef struct as_config_s {
 	/**
 	 * The number of cluster tend iterations that defines the window for max_error_rate.
 	 * One tend iteration is defined as tender_interval plus the time to tend all nodes.
-	 * At the end of the window, the error count is reset to zero and backoff state is removed
-	 * on all nodes.
+	 * At the end of the window, the error count is reset to zero and the node circuit breaker
+	 * moves to its next state.
 	 *
 	 * Default: 1
 	 */
 	uint32_t error_rate_window;
 
+	/**
+	 * Maximum number of error windows a node circuit breaker stays open before probing the
+	 * node again.  If zero, the breaker is disabled and the node is fully available again at
+	 * the end of every error window.
+	 *
+	 * Default: 32
+	 */
+	uint32_t error_rate_backoff_max;
+
+	/**
+	 * One of every error_rate_probe_interval commands is sent to a node whose circuit breaker is
+	 * half-open.  The rest are rejected with AEROSPIKE_MAX_ERROR_RATE.
+	 *
+	 * Default: 10
+	 */
+	uint32_t error_rate_probe_interval;
+
+	/**
+	 * If true, reads that are allowed to use a replica (replica policy is not
+	 * AS_POLICY_REPLICA_MASTER and read mode is not linearize) are sent to another replica
+	 * instead of failing with AEROSPIKE_MAX_ERROR_RATE when the node circuit breaker is open.
+	 *
+	 * Default: false
+	 */
+	bool error_rate_read_replica;
+
+	/**
+	 * Cluster wide retry budget as a percentage of completed commands.  Every command that
+	 * receives a response adds retry_budget_percent / 100 tokens to a bucket shared by sync and
+	 * async commands, and every retry takes one token.  When the bucket is empty, commands fail
+	 * with the last error instead of retrying, so a slow node does not multiply load on the rest
+	 * of the cluster.  If retry_budget_percent is zero, retries are only limited by max_retries.
+	 *
+	 * Default: 0
+	 */
+	uint32_t retry_budget_percent;
+
+	/**
+	 * Maximum tokens in the retry budget bucket, which is also the number of retries allowed
+	 * in a burst.  The bucket starts full.
+	 *
+	 * Default: 100
+	 */
+	uint32_t retry_budget_max;
+
+	/**
+	 * Enable latency adaptive socket timeouts for single record commands when greater than
+	 * zero.  The client keeps a 99th percentile latency estimate per node, computed by the
+	 * cluster tend thread, and sets each attempt's socket timeout to adaptive_timeout_factor
+	 * times that estimate.  The adaptive timeout is clamped between adaptive_timeout_min and
+	 * the configured socket timeout (or total timeout when the socket timeout is zero or
+	 * larger), so a stuck command is retried sooner while slow but healthy nodes still
+	 * receive the full estimate.  Nodes use their configured timeouts until
+	 * AS_NODE_TIMEOUT_MIN_SAMPLES commands have been measured.
+	 *
+	 * Default: 0 (disabled)
+	 */
+	uint32_t adaptive_timeout_factor;
+
+	/**
+	 * Minimum adaptive socket timeout in milliseconds.
+	 *
+	 * Default: 10
+	 */
+	uint32_t adaptive_timeout_min;
+
+	/**
+	 * Maximum number of new connections per node per second, summed over sync and async
+	 * connections.  When a node restarts, every thread and event loop opens connections at once.
+	 * This limit spreads that storm out.  Commands that would exceed the limit are retried
+	 * with AEROSPIKE_ERR_NO_MORE_CONNECTIONS, like commands that would exceed max_conns_per_node.
+	 * If max_conn_open_rate is zero, there is no limit.
+	 *
+	 * Default: 0
+	 */
+	uint32_t max_conn_open_rate;
+
+	/**
+	 * Record per node latency histograms of database commands by command type (read,
+	 * write, batch, scan and query). Histograms are returned in as_node_stats by
+	 * aerospike_cluster_stats(). Recording costs two clock reads and one counter
+	 * increment per command.
+	 *
+	 * Default: false
+	 */
+	bool latency_stats;
+
+	/**
+	 * Metrics function that the cluster tend thread calls every metrics_interval seconds
+	 * with a snapshot of cluster statistics.  The snapshot's memory is reused between
+	 * calls, so periodic metrics do not allocate unless nodes are added.  See
+	 * aerospike_stats_to_prometheus() to render the snapshot.
+	 *
+	 * Default: NULL (no callback will be made)
+	 */
+	as_metrics_callback metrics_callback;
+
+	/**
+	 * Metrics user data that will be passed back to metrics_callback.
+	 *
+	 * Default: NULL
+	 */
+	void* metrics_udata;
+
+	/**
+	 * Seconds between metrics_callback calls.  The callback is called on the first cluster
+	 * tend after the interval has elapsed.
+	 *
+	 * Default: 10
+	 */
+	uint32_t metrics_interval;
+
+	/**
+	 * Sampled command tracing hooks.  Sampled sync, async and batch node commands report
+	 * their node, attempts, bytes, status and per phase timestamps in as_trace_span.
+	 * See as_config_set_trace_hooks().
+	 *
+	 * Default: all NULL, sample_rate 0 (tracing disabled)
+	 */
+	as_trace_hooks trace;
+
+	/**
+	 * Sample one out of every hot_key_sample_rate single record commands to estimate the
+	 * most frequently accessed keys and partitions per namespace.  Sampled commands are
+	 * counted with their bytes sent and received and reported by aerospike_stats().
+	 * Zero disables sampling.
+	 *
+	 * Default: 0
+	 */
+	uint32_t hot_key_sample_rate;
+
+	/**
+	 * Number of keys and number of partitions tracked by hot key sampling.  Keys that are
+	 * accessed by more than 1 / hot_key_capacity of sampled commands are always tracked.
+	 *
+	 * Default: 128
+	 */
+	uint32_t hot_key_capacity;
+
 	/**
 	 * Polling interval in milliseconds for cluster tender
 	 * Default: 1000
 	 */
 	uint32_t tender_interval;
 
+	/**
+	 * Maximum polling interval in milliseconds for adaptive cluster tending. If greater than
+	 * tender_interval, the tender runs every tender_interval while node partition or rebalance
+	 * generations are changing, nodes are added or removed, or commands fail to find a node
+	 * or time out. The interval then doubles after each stable tend until it reaches
+	 * tender_interval_max.
+	 *
+	 * Since error_rate_window is counted in tend iterations, the window lengthens with the
+	 * interval. Adaptive tending is disabled when shared memory is enabled, because other
+	 * processes use the tend timestamp to detect a dead tend owner.
+	 *
+	 * Default: 0 (fixed tender_interval)
+	 */
+	uint32_t tender_interval_max;
+
 	/**
 	 * Number of threads stored in underlying thread pool used by synchronous batch/scan/query commands.
 	 * These commands are often sent to multiple server nodes in parallel threads.  A thread pool 
@@ -612,12 +1120,86 @@ typedef struct as_config_s {
 	 */
 	uint32_t thread_pool_size;
 
+	/**
+	 * Share the thread pool adaptively between concurrent synchronous batch/scan/query calls.
+	 * Each call may always run its fair share of pool threads (thread_pool_size divided by
+	 * the number of calls using the pool). A call only runs more tasks than its share when
+	 * pool threads are idle and its own tasks are not waiting in the pool queue. Otherwise,
+	 * remaining node tasks are queued as earlier tasks of the same call complete.
+	 *
+	 * If false, every node task of a concurrent call is queued immediately.
+	 *
+	 * Default: false
+	 */
+	bool thread_pool_adaptive;
+
+	/**
+	 * Run synchronous batch/scan/query and aggregation tasks on a work stealing pool of
+	 * thread_pool_size threads instead of the default thread pool. Each pool thread has its
+	 * own task queue and idle threads steal tasks from busy threads, so queuing many node
+	 * tasks at once does not contend on a single shared queue.
+	 *
+	 * Default: false
+	 */
+	bool thread_pool_work_stealing;
+
+	/**
+	 * Microseconds an idle work stealing pool thread spins waiting for new tasks before it
+	 * parks. Spinning lowers task start latency at the cost of CPU while idle. Only used when
+	 * thread_pool_work_stealing is true.
+	 *
+	 * Default: 0 (park immediately)
+	 */
+	uint32_t thread_pool_spin_us;
+
+	/**
+	 * Assign work stealing pool threads to consecutive CPU IDs starting at this ID.
+	 * Only used when thread_pool_work_stealing is true.
+	 *
+	 * Default: -1 (Any CPU).
+	 */
+	int thread_pool_cpu;
+
 	/**
 	 * Assign tend thread to this specific CPU ID.
 	 * Default: -1 (Any CPU).
 	 */
 	int tend_thread_cpu;
 
+	/**
+	 * Number of threads that send cluster tend info requests to nodes in parallel. The tend
+	 * thread processes responses as they arrive, so a tend iteration takes about as long as
+	 * the slowest node instead of the sum of all nodes. If zero, the tend thread requests
+	 * info from one node at a time.
+	 *
+	 * Default: 8
+	 */
+	uint32_t tend_thread_pool_size;
+
+	/**
+	 * Tend this cluster from one tend thread shared by every client that enables this option,
+	 * instead of a dedicated tend thread per client.  Applications that connect to many
+	 * clusters from one process then run a single tend thread and tend pool.  Each cluster
+	 * keeps its own tend_interval.  The shared tend pool is sized by tend_thread_pool_size
+	 * of the first client that starts the shared tend thread and tend_thread_cpu is ignored.
+	 * Not supported with use_shm.
+	 *
+	 * Default: false
+	 */
+	bool shared_tend_thread;
+
+	/**
+	 * Externally owned thread pool that runs synchronous batch/scan/query and aggregation
+	 * tasks instead of a pool created for this client.  Several clients may share one pool.
+	 * When set, thread_pool_size and thread_pool_work_stealing are ignored.  The pool must be
+	 * initialized before aerospike_connect() and destroyed after aerospike_close() of every
+	 * client that uses it.  When TLS is enabled, set the pool's fini_fn to
+	 * as_tls_thread_cleanup.
+	 *
+	 * Default: NULL
+	 */
+	struct as_thread_pool_s* shared_thread_pool;
+
 	/**
 	 * Client policies
 	 */
@@ -628,6 +1210,10 @@ typedef struct as_config_s {
 	 * This config has been left here to avoid breaking the API.
 	 *
 	 * The global lua config will only be changed once on first cluster initialization.
+	 * Lua itself is configured when client side lua (query aggregation) is first used, so
+	 * processes that never aggregate do not pay for it.  If warm_functions is set, lua is
+	 * configured during aerospike_connect() instead.
+	 *
 	 * A better method for initializing lua configuration is to leave this field alone and
 	 * instead call aerospike_init_lua():
 	 *
@@ -667,6 +1253,17 @@ typedef struct as_config_s {
 	 * client will automatically connect when Aerospike server becomes available.
 	 */
 	bool fail_if_not_connected;
+
+	/**
+	 * Return from aerospike_connect() without waiting for the first cluster tend.  The tend
+	 * thread discovers nodes and partition maps in the background.  Commands issued before
+	 * the first tend completes wait for it instead of failing with "Cluster is empty" or
+	 * "Invalid namespace".  Seed failures are logged instead of returned, as if
+	 * fail_if_not_connected were false.  Not used with shared memory clusters.
+	 *
+	 * Default: false
+	 */
+	bool connect_async;
 	
 	/**
 	 * Flag to signify if "services-alternate" should be used instead of "services"
@@ -674,6 +1271,32 @@ typedef struct as_config_s {
 	 */
 	bool use_services_alternate;
 
+	/**
+	 * Protect nodes used by sync single record commands with a per-thread epoch instead
+	 * of incrementing and decrementing the node's reference count. The cluster tend thread
+	 * frees removed nodes only after all threads that could still reference them have
+	 * left their epoch. This avoids reference count cache line contention on popular nodes
+	 * when many threads run commands concurrently.
+	 *
+	 * Async commands, batch, scan and query always use reference counts.
+	 *
+	 * Default: false
+	 */
+	bool epoch_reclaim;
+
+	/**
+	 * Defer formatting of error messages for result codes returned by the server (for example
+	 * AEROSPIKE_ERR_RECORD_NOT_FOUND and AEROSPIKE_FILTERED_OUT). as_error then only records
+	 * the result code and node address, and as_error.lazy is set. Call as_error_message() to
+	 * format the message on demand. as_error.message stays empty until then.
+	 *
+	 * Enable this when expected server results are frequent, such as reads with a high miss
+	 * rate. Client errors such as timeouts are always formatted.
+	 *
+	 * Default: false
+	 */
+	bool lazy_error_messages;
+
 	/**
 	 * Track server rack data.  This field is useful when directing read commands to 
 	 * the server node that contains the key and exists on the same rack as the client.
@@ -751,6 +1374,30 @@ typedef struct as_config_s {
 	 * Default: 30
 	 */
 	uint32_t shm_takeover_threshold_sec;
+
+	/**
+	 * Back the shared memory segment with huge pages (Linux SHM_HUGETLB), so partition
+	 * lookups from many processes use fewer TLB entries. Huge pages must be reserved
+	 * by the OS (vm.nr_hugepages) and the process must be allowed to use them
+	 * (vm.hugetlb_shm_group). Standard pages are used if the huge page segment can not be
+	 * created. Ignored on other platforms and by processes that attach to an existing
+	 * segment.
+	 *
+	 * Default: false
+	 */
+	bool shm_huge_pages;
+
+	/**
+	 * Maximum sync connections per server node across all processes sharing the shared
+	 * memory segment. Processes publish their connection counts every tend, refuse new
+	 * connections that would exceed this limit and close idle connections when other
+	 * processes are refused. Each process is still limited by max_conns_per_node.
+	 * Counts are approximate, because they are exchanged at tend intervals.
+	 *
+	 * Zero means no host limit.
+	 * Default: 0
+	 */
+	uint32_t shm_max_conns_per_node;
 } as_config;
 
 /******************************************************************************
@@ -854,6 +1501,17 @@ as_config_set_cluster_name(as_config* config, const char* cluster_name)
 	as_config_set_string(&config->cluster_name, cluster_name);
 }
 
+/**
+ * Set topology snapshot file.
+ *
+ * @relates as_config
+ */
+static inline void
+as_config_set_topology_file(as_config* config, const char* path)
+{
+	as_config_set_string(&config->topology_file, path);
+}
+
 /**
  * Set cluster event callback and user data.
  *
@@ -866,6 +1524,37 @@ as_config_set_cluster_event_callback(as_config* config, as_cluster_event_callbac
 	config->event_callback_udata = udata;
 }
 
+/**
+ * Set periodic metrics callback, user data and interval in seconds.
+ *
+ * @relates as_config
+ */
+static inline void
+as_config_set_metrics_callback(
+	as_config* config, as_metrics_callback callback, void* udata, uint32_t interval
+	)
+{
+	config->metrics_callback = callback;
+	config->metrics_udata = udata;
+	config->metrics_interval = interval;
+}
+
+/**
+ * Set sampled command tracing hooks.  One out of every sample_rate commands is traced.
+ *
+ * @relates as_config
+ */
+static inline void
+as_config_set_trace_hooks(
+	as_config* config, as_trace_fn begin, as_trace_fn end, void* udata, uint32_t sample_rate
+	)
+{
+	config->trace.begin = begin;
+	config->trace.end = end;
+	config->trace.udata = udata;
+	config->trace.sample_rate = sample_rate;
+}
+
 /**
  * Initialize global lua configuration to defaults.
  *
@@ -876,6 +1565,8 @@ as_config_lua_init(as_config_lua* lua)
 {
 	lua->cache_enabled = false;
 	strcpy(lua->user_path, AS_CONFIG_LUA_USER_PATH);
+	lua->warm_functions[0] = 0;
+	lua->warm_states = 0;
 }
 
 /**
@@ -28,6 +28,37 @@ extern "C" {
  * TYPES
  *****************************************************************************/
 
+/**
+ * @private
+ * Maximum idle connections closed per pool on each balance pass.  Larger excesses are
+ * trimmed over several passes.
+ */
+#define AS_CONN_TRIM_MAX 32
+
+/**
+ * @private
+ * Lock free connection stack slot.
+ */
+typedef struct as_conn_slot_s {
+	as_socket sock;
+	uint64_t next;
+} as_conn_slot;
+
+/**
+ * @private
+ * Lock free (Treiber) stack of connections.  Stack heads and slot links hold a slot index in
+ * the low 32 bits and a modification tag in the high 32 bits to prevent ABA.  Slots are
+ * preallocated, so a slot is either on the connection stack or on the free stack.
+ */
+typedef struct as_conn_stack_s {
+	uint64_t head;
+	uint64_t free;
+	as_conn_slot* slots;
+	uint32_t size;
+	uint32_t total;
+	uint32_t capacity;
+} as_conn_stack;
+
 /**
  * @private
  * Sync connection pool.
@@ -43,12 +74,78 @@ typedef struct as_conn_pool_s {
 	 */
 	as_queue queue;
 
+	/**
+	 * Lock free stack. If not NULL, used instead of lock and queue.
+	 */
+	as_conn_stack* stack;
+
 	/**
 	 * Minimum number of connections.
 	 */
 	uint32_t min_size;
 } as_conn_pool;
 
+/******************************************************************************
+ * LOCK FREE STACK FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create lock free connection stack.
+ */
+as_conn_stack*
+as_conn_stack_create(uint32_t capacity);
+
+/**
+ * @private
+ * Close all connections and destroy stack.
+ */
+void
+as_conn_stack_destroy(as_conn_stack* stack);
+
+/**
+ * @private
+ * Pop most recently used connection.
+ */
+bool
+as_conn_stack_pop_head(as_conn_stack* stack, as_socket* sock);
+
+/**
+ * @private
+ * Pop least recently used connection.  The stack stays linked while it is searched, but
+ * only one thread may remove or add connections at the tail, so this should only be called
+ * by the tend thread when trimming idle connections.
+ */
+bool
+as_conn_stack_pop_tail(as_conn_stack* stack, as_socket* sock);
+
+/**
+ * @private
+ * Push connection as most recently used if stack is not full.
+ */
+bool
+as_conn_stack_push_head(as_conn_stack* stack, as_socket* sock);
+
+/**
+ * @private
+ * Push connection as least recently used if stack is not full.  Like as_conn_stack_pop_tail(),
+ * this should only be called by the tend thread.
+ */
+bool
+as_conn_stack_push_tail(as_conn_stack* stack, as_socket* sock);
+
+/**
+ * @private
+ * Remove up to max (at most AS_CONN_TRIM_MAX) least recently used connections that have been
+ * idle longer than max_socket_idle_ns and copy them to socks, least recently used first.  The
+ * stack is walked once in place.  Return number of connections removed.  Like
+ * as_conn_stack_pop_tail(), this should only be called by the tend thread.
+ */
+uint32_t
+as_conn_stack_trim(
+	as_conn_stack* stack, uint64_t max_socket_idle_ns, as_socket* socks, uint32_t max
+	);
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -58,10 +155,18 @@ typedef struct as_conn_pool_s {
  * Initialize a connection pool.
  */
 static inline void
-as_conn_pool_init(as_conn_pool* pool, uint32_t item_size, uint32_t min_size, uint32_t max_size)
+as_conn_pool_init(
+	as_conn_pool* pool, uint32_t item_size, uint32_t min_size, uint32_t max_size, bool lock_free
+	)
 {
-	pthread_mutex_init(&pool->lock, NULL);
-	as_queue_init(&pool->queue, item_size, max_size);
+	if (lock_free) {
+		pool->stack = as_conn_stack_create(max_size);
+	}
+	else {
+		pool->stack = NULL;
+		pthread_mutex_init(&pool->lock, NULL);
+		as_queue_init(&pool->queue, item_size, max_size);
+	}
 	pool->min_size = min_size;
 }
 
@@ -72,6 +177,10 @@ as_conn_pool_init(as_conn_pool* pool, uint32_t item_size, uint32_t min_size, uin
 static inline bool
 as_conn_pool_pop_head(as_conn_pool* pool, as_socket* sock)
 {
+	if (pool->stack) {
+		return as_conn_stack_pop_head(pool->stack, sock);
+	}
+
 	pthread_mutex_lock(&pool->lock);
 	bool status = as_queue_pop(&pool->queue, sock);
 	pthread_mutex_unlock(&pool->lock);
@@ -85,6 +194,10 @@ as_conn_pool_pop_head(as_conn_pool* pool, as_socket* sock)
 static inline bool
 as_conn_pool_pop_tail(as_conn_pool* pool, as_socket* sock)
 {
+	if (pool->stack) {
+		return as_conn_stack_pop_tail(pool->stack, sock);
+	}
+
 	pthread_mutex_lock(&pool->lock);
 	bool status = as_queue_pop_tail(&pool->queue, sock);
 	pthread_mutex_unlock(&pool->lock);
@@ -98,6 +211,10 @@ as_conn_pool_pop_tail(as_conn_pool* pool, as_socket* sock)
 static inline bool
 as_conn_pool_push_head(as_conn_pool* pool, as_socket* sock)
 {
+	if (pool->stack) {
+		return as_conn_stack_push_head(pool->stack, sock);
+	}
+
 	pthread_mutex_lock(&pool->lock);
 	bool status = as_queue_push_head_limit(&pool->queue, sock);
 	pthread_mutex_unlock(&pool->lock);
@@ -111,12 +228,46 @@ as_conn_pool_push_head(as_conn_pool* pool, as_socket* sock)
 static inline bool
 as_conn_pool_push_tail(as_conn_pool* pool, as_socket* sock)
 {
+	if (pool->stack) {
+		return as_conn_stack_push_tail(pool->stack, sock);
+	}
+
 	pthread_mutex_lock(&pool->lock);
 	bool status = as_queue_push_limit(&pool->queue, sock);
 	pthread_mutex_unlock(&pool->lock);
 	return status;
 }
 
+/**
+ * @private
+ * Remove up to max least recently used connections that have been idle longer than
+ * max_socket_idle_ns and copy them to socks, so they are closed outside the pool lock.
+ * Connections are kept in last used order, so this stops at the first current connection.
+ * Return number of connections removed.
+ */
+static inline uint32_t
+as_conn_pool_trim(
+	as_conn_pool* pool, uint64_t max_socket_idle_ns, as_socket* socks, uint32_t max
+	)
+{
+	if (pool->stack) {
+		return as_conn_stack_trim(pool->stack, max_socket_idle_ns, socks, max);
+	}
+
+	as_queue* q = &pool->queue;
+	uint32_t n = 0;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (n < max && ! as_queue_empty(q) && ! as_socket_current_trim(
+		((as_socket*)as_queue_get(q, (q->tail - 1) % q->capacity))->last_used, max_socket_idle_ns)) {
+		as_queue_pop_tail(q, &socks[n++]);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	return n;
+}
+
 /**
  * @private
  * Increment connection total.
@@ -125,6 +276,9 @@ as_conn_pool_push_tail(as_conn_pool* pool, as_socket* sock)
 static inline bool
 as_conn_pool_incr(as_conn_pool* pool)
 {
+	if (pool->stack) {
+		return as_faa_uint32(&pool->stack->total, 1) < pool->stack->capacity;
+	}
 	return as_faa_uint32(&pool->queue.total, 1) < pool->queue.capacity;
 }
 
@@ -135,9 +289,40 @@ as_conn_pool_incr(as_conn_pool* pool)
 static inline void
 as_conn_pool_decr(as_conn_pool* pool)
 {
+	if (pool->stack) {
+		as_decr_uint32(&pool->stack->total);
+		return;
+	}
 	as_decr_uint32(&pool->queue.total);
 }
 
+/**
+ * @private
+ * Return connection total.
+ */
+static inline uint32_t
+as_conn_pool_total(as_conn_pool* pool)
+{
+	return pool->stack ? as_load_uint32(&pool->stack->total) : as_load_uint32(&pool->queue.total);
+}
+
+/**
+ * @private
+ * Return number of connections residing in pool.
+ */
+static inline uint32_t
+as_conn_pool_size(as_conn_pool* pool)
+{
+	if (pool->stack) {
+		return as_load_uint32(&pool->stack->size);
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	uint32_t size = as_queue_size(&pool->queue);
+	pthread_mutex_unlock(&pool->lock);
+	return size;
+}
+
 /**
  * @private
  * Return number of connections that might be closed.
@@ -145,7 +330,7 @@ as_conn_pool_decr(as_conn_pool* pool)
 static inline int
 as_conn_pool_excess(as_conn_pool* pool)
 {
-	return as_load_uint32(&pool->queue.total) - pool->min_size;
+	return as_conn_pool_total(pool) - pool->min_size;
 }
 
 /**
@@ -155,6 +340,11 @@ as_conn_pool_excess(as_conn_pool* pool)
 static inline void
 as_conn_pool_destroy(as_conn_pool* pool)
 {
+	if (pool->stack) {
+		as_conn_stack_destroy(pool->stack);
+		return;
+	}
+
 	as_socket sock;
 
 	pthread_mutex_lock(&pool->lock);
@@ -0,0 +1,532 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @file as_coroutine.hpp
+ *
+ * Optional C++20 awaitables for the async API. Each awaitable starts the same async command
+ * as the C API when awaited and resumes the awaiting coroutine from the command listener.
+ * The awaitable lives in the coroutine frame, so no allocation is done beyond what the C
+ * command itself does. The coroutine return type is left to the application.
+ *
+ * ~~~~~~~~~~{.cpp}
+ * namespace ac = as_coro;
+ *
+ * my_task
+ * read_and_write(aerospike* as, as_key* key)
+ * {
+ *     as_error err;
+ *     as_record* rec = NULL;
+ *
+ *     if (co_await ac::key_get(as, &err, NULL, key, &rec) != AEROSPIKE_OK) {
+ *         co_return;
+ *     }
+ *
+ *     as_record_set_int64(rec, "b", as_record_get_int64(rec, "a", 0) + 1);
+ *     co_await ac::key_put(as, &err, NULL, key, rec);
+ *     as_record_destroy(rec);
+ * }
+ * ~~~~~~~~~~
+ *
+ * co_await returns the command status and err is populated on failure. Records returned by
+ * key_get(), key_select(), key_exists() and key_operate() are allocated on the heap and must
+ * be destroyed by the caller.
+ *
+ * By default the coroutine is resumed inline in the event loop thread that completed the
+ * command, like a C listener. Code that runs after co_await must then follow the same rules
+ * as listener code and must not block. Pass an executor to resume on another thread.
+ *
+ * Key and batch commands can not be cancelled once started. Scans and queries can be aborted
+ * by returning false from the record callback or from another thread with as_async_cancel
+ * set in the scan or query policy.
+ */
+
+#if !defined(__cplusplus) || (__cplusplus < 202002L && (!defined(_MSVC_LANG) || _MSVC_LANG < 202002L))
+#error "as_coroutine.hpp requires C++20"
+#endif
+
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_query.h>
+#include <aerospike/aerospike_scan.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_policy.h>
+
+#include <coroutine>
+#include <utility>
+
+namespace as_coro {
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Where awaiting coroutines are resumed. post() is called in the event loop thread and must
+ * arrange for handle.resume() to be called exactly once, typically by queueing the handle
+ * to an application thread pool. If post is NULL, the coroutine is resumed inline in the
+ * event loop thread.
+ */
+struct executor {
+	void (*post)(void* ctx, std::coroutine_handle<> handle) = nullptr;
+	void* ctx = nullptr;
+};
+
+namespace detail {
+
+/**
+ * @private
+ * Common awaitable state. The command listener must not access the awaitable after
+ * resume(), because the coroutine may destroy it.
+ */
+struct awaitable_base {
+	aerospike* as;
+	as_error* err;
+	as_event_loop* event_loop;
+	executor exec;
+	std::coroutine_handle<> handle = {};
+	as_status status = AEROSPIKE_OK;
+
+	bool
+	await_ready() const noexcept
+	{
+		return false;
+	}
+
+	as_status
+	await_resume() const noexcept
+	{
+		return status;
+	}
+
+	template<typename S>
+	bool
+	start(std::coroutine_handle<> h, S&& fn) noexcept
+	{
+		handle = h;
+
+		// The listener may run in another thread before fn returns, so only the status of a
+		// command that failed to start may be stored.
+		as_status s = fn();
+
+		if (s != AEROSPIKE_OK) {
+			status = s;
+			return false;
+		}
+		return true;
+	}
+
+	void
+	resume(as_error* e) noexcept
+	{
+		if (e) {
+			as_error_copy(err, e);
+			status = e->code;
+		}
+		else {
+			status = AEROSPIKE_OK;
+		}
+
+		std::coroutine_handle<> h = handle;
+		executor x = exec;
+
+		if (x.post) {
+			x.post(x.ctx, h);
+		}
+		else {
+			h.resume();
+		}
+	}
+};
+
+/**
+ * @private
+ * Command that completes with as_async_write_listener.
+ */
+struct write_awaitable : awaitable_base {
+	static void
+	listener(as_error* e, void* udata, as_event_loop* event_loop)
+	{
+		static_cast<write_awaitable*>(udata)->resume(e);
+	}
+};
+
+/**
+ * @private
+ * Command that completes with as_async_record_listener. The record must be on the heap.
+ */
+struct record_awaitable : awaitable_base {
+	as_record** rec;
+
+	static void
+	listener(as_error* e, as_record* record, void* udata, as_event_loop* event_loop)
+	{
+		record_awaitable* self = static_cast<record_awaitable*>(udata);
+		*self->rec = record;
+		self->resume(e);
+	}
+};
+
+/**
+ * @private
+ * Command that completes with as_async_batch_listener. Results are stored in the caller's
+ * batch records.
+ */
+struct batch_awaitable : awaitable_base {
+	const as_policy_batch* policy;
+	as_batch_records* records;
+
+	static void
+	listener(as_error* e, as_batch_records* records, void* udata, as_event_loop* event_loop)
+	{
+		static_cast<batch_awaitable*>(udata)->resume(e);
+	}
+};
+
+/**
+ * @private
+ * Scan or query that calls fn for each record and resumes when the stream ends.
+ */
+template<typename F>
+struct stream_awaitable : awaitable_base {
+	F fn;
+
+	static bool
+	listener(as_error* e, as_record* record, void* udata, as_event_loop* event_loop)
+	{
+		stream_awaitable* self = static_cast<stream_awaitable*>(udata);
+
+		if (e || ! record) {
+			self->resume(e);
+			return false;
+		}
+
+		if (! self->fn(record)) {
+			// The listener is not called again after returning false.
+			self->resume(nullptr);
+			return false;
+		}
+		return true;
+	}
+};
+
+} // namespace detail
+
+/**
+ * Read policy copy that returns records on the heap.
+ */
+inline as_policy_read
+heap_policy(aerospike* as, const as_policy_read* policy)
+{
+	as_policy_read p = policy ? *policy : as->config.policies.read;
+	p.async_heap_rec = true;
+	return p;
+}
+
+/**
+ * Operate policy copy that returns records on the heap.
+ */
+inline as_policy_operate
+heap_policy(aerospike* as, const as_policy_operate* policy)
+{
+	as_policy_operate p = policy ? *policy : as->config.policies.operate;
+	p.async_heap_rec = true;
+	return p;
+}
+
+/******************************************************************************
+ * KEY COMMANDS
+ *****************************************************************************/
+
+/**
+ * Awaitable aerospike_key_get_async(). On success, rec is set to a heap record.
+ */
+struct key_get : detail::record_awaitable {
+	as_policy_read policy;
+	const as_key* key;
+
+	key_get(
+		aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+		as_record** rec, executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::record_awaitable{{as, err, event_loop, exec}, rec},
+		  policy(heap_policy(as, policy)), key(key)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_get_async(as, err, &policy, key, listener, this, event_loop,
+				nullptr);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_key_select_async(). On success, rec is set to a heap record.
+ */
+struct key_select : detail::record_awaitable {
+	as_policy_read policy;
+	const as_key* key;
+	const char** bins;
+
+	key_select(
+		aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+		const char* bins[], as_record** rec, executor exec = {},
+		as_event_loop* event_loop = nullptr
+		)
+		: detail::record_awaitable{{as, err, event_loop, exec}, rec},
+		  policy(heap_policy(as, policy)), key(key), bins(bins)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_select_async(as, err, &policy, key, bins, listener, this,
+				event_loop, nullptr);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_key_exists_async(). On success, rec is set to a heap record that
+ * only contains metadata.
+ */
+struct key_exists : detail::record_awaitable {
+	as_policy_read policy;
+	const as_key* key;
+
+	key_exists(
+		aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+		as_record** rec, executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::record_awaitable{{as, err, event_loop, exec}, rec},
+		  policy(heap_policy(as, policy)), key(key)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_exists_async(as, err, &policy, key, listener, this, event_loop,
+				nullptr);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_key_put_async().
+ */
+struct key_put : detail::write_awaitable {
+	const as_policy_write* policy;
+	const as_key* key;
+	as_record* rec;
+
+	key_put(
+		aerospike* as, as_error* err, const as_policy_write* policy, const as_key* key,
+		as_record* rec, executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::write_awaitable{{as, err, event_loop, exec}}, policy(policy), key(key),
+		  rec(rec)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_put_async(as, err, policy, key, rec, listener, this, event_loop,
+				nullptr);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_key_remove_async().
+ */
+struct key_remove : detail::write_awaitable {
+	const as_policy_remove* policy;
+	const as_key* key;
+
+	key_remove(
+		aerospike* as, as_error* err, const as_policy_remove* policy, const as_key* key,
+		executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::write_awaitable{{as, err, event_loop, exec}}, policy(policy), key(key)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_remove_async(as, err, policy, key, listener, this, event_loop,
+				nullptr);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_key_operate_async(). On success, rec is set to a heap record.
+ */
+struct key_operate : detail::record_awaitable {
+	as_policy_operate policy;
+	const as_key* key;
+	const as_operations* ops;
+
+	key_operate(
+		aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
+		const as_operations* ops, as_record** rec, executor exec = {},
+		as_event_loop* event_loop = nullptr
+		)
+		: detail::record_awaitable{{as, err, event_loop, exec}, rec},
+		  policy(heap_policy(as, policy)), key(key), ops(ops)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_key_operate_async(as, err, &policy, key, ops, listener, this,
+				event_loop, nullptr);
+		});
+	}
+};
+
+/******************************************************************************
+ * BATCH COMMANDS
+ *****************************************************************************/
+
+/**
+ * Awaitable aerospike_batch_read_async(). Per record results are stored in records, which
+ * remain owned by the caller.
+ */
+struct batch_read : detail::batch_awaitable {
+	batch_read(
+		aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+		executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::batch_awaitable{{as, err, event_loop, exec}, policy, records}
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_batch_read_async(as, err, policy, records, listener, this,
+				event_loop);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_batch_write_async(). Per record results are stored in records, which
+ * remain owned by the caller.
+ */
+struct batch_write : detail::batch_awaitable {
+	batch_write(
+		aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+		executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::batch_awaitable{{as, err, event_loop, exec}, policy, records}
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return start(h, [this] {
+			return aerospike_batch_write_async(as, err, policy, records, listener, this,
+				event_loop);
+		});
+	}
+};
+
+/******************************************************************************
+ * SCAN AND QUERY
+ *****************************************************************************/
+
+/**
+ * Awaitable aerospike_scan_async(). fn is called in an event loop thread with each record
+ * and returns false to end the scan. Records are destroyed after fn returns. The coroutine
+ * resumes after the last record.
+ */
+template<typename F>
+struct scan : detail::stream_awaitable<F> {
+	const as_policy_scan* policy;
+	as_scan* sc;
+	uint64_t* scan_id;
+
+	scan(
+		aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* sc, F fn,
+		uint64_t* scan_id = nullptr, executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::stream_awaitable<F>{{as, err, event_loop, exec}, std::move(fn)},
+		  policy(policy), sc(sc), scan_id(scan_id)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return this->start(h, [this] {
+			return aerospike_scan_async(this->as, this->err, policy, sc, scan_id,
+				detail::stream_awaitable<F>::listener, this, this->event_loop);
+		});
+	}
+};
+
+/**
+ * Awaitable aerospike_query_async(). fn is called in an event loop thread with each record
+ * and returns false to end the query. Records are destroyed after fn returns. The coroutine
+ * resumes after the last record.
+ */
+template<typename F>
+struct query : detail::stream_awaitable<F> {
+	const as_policy_query* policy;
+	as_query* q;
+
+	query(
+		aerospike* as, as_error* err, const as_policy_query* policy, as_query* q, F fn,
+		executor exec = {}, as_event_loop* event_loop = nullptr
+		)
+		: detail::stream_awaitable<F>{{as, err, event_loop, exec}, std::move(fn)},
+		  policy(policy), q(q)
+	{
+	}
+
+	bool
+	await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		return this->start(h, [this] {
+			return aerospike_query_async(this->as, this->err, policy, q,
+				detail::stream_awaitable<F>::listener, this, this->event_loop);
+		});
+	}
+};
+
+} // namespace as_coro
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Enter epoch critical section on the calling thread. Nodes and cluster data structures
+ * read inside the section are not garbage collected until the section exits. Sections
+ * may be nested. Only per-thread memory is written, so popular nodes do not suffer
+ * reference count cache line contention.
+ */
+void
+as_epoch_enter(void);
+
+/**
+ * @private
+ * Exit epoch critical section on the calling thread.
+ */
+void
+as_epoch_exit(void);
+
+/**
+ * @private
+ * Advance global epoch and return the previous epoch. Data structures unlinked before
+ * this call should be tagged with the returned epoch. Called by the cluster tend thread.
+ */
+uint64_t
+as_epoch_advance(void);
+
+/**
+ * @private
+ * Return oldest epoch of threads currently in a critical section, or UINT64_MAX if no
+ * thread is in a critical section. Data tagged with an epoch less than this value is
+ * no longer referenced by any thread.
+ */
+uint64_t
+as_epoch_min_active(void);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -46,6 +46,12 @@ extern "C" {
  */
 #define AS_ERROR_MESSAGE_MAX_LEN 	(AS_ERROR_MESSAGE_MAX_SIZE - 1)
 
+/**
+ * @private
+ * The size of as_error.lazy_address
+ */
+#define AS_ERROR_LAZY_ADDRESS_SIZE	64
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -128,6 +134,19 @@ typedef struct as_error_s {
 	 */
 	bool in_doubt;
 
+	/**
+	 * Is message formatted on demand. When true, message is empty and as_error_message()
+	 * must be called to read the message. Only set for server result codes when
+	 * as_config.lazy_error_messages is enabled.
+	 */
+	bool lazy;
+
+	/**
+	 * @private
+	 * Node address of a message that is formatted on demand.
+	 */
+	char lazy_address[AS_ERROR_LAZY_ADDRESS_SIZE];
+
 } as_error;
 
 /******************************************************************************
@@ -150,6 +169,13 @@ typedef struct as_error_s {
 #define as_error_set_message(__err, __code, __msg) \
 	as_error_setall( __err, __code, __msg, __func__, __FILE__, __LINE__ );
 
+/**
+ * @private
+ * as_error_update_status(err, status, as_node_get_address_string(node), cluster->lazy_error_messages);
+ */
+#define as_error_update_status(__err, __code, __address, __lazy) \
+	as_error_set_status(__err, __code, __address, __lazy, __func__, __FILE__, __LINE__)
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -173,6 +199,7 @@ as_error_init(as_error* err)
 	err->file = NULL;
 	err->line = 0;
 	err->in_doubt = false;
+	err->lazy = false;
 	return err;
 }
 
@@ -195,6 +222,7 @@ as_error_reset(as_error* err)
 	err->file = NULL;
 	err->line = 0;
 	err->in_doubt = false;
+	err->lazy = false;
 	return err->code;
 }
 
@@ -213,6 +241,7 @@ as_error_setall(as_error* err, as_status code, const char * message, const char
 	err->func = func;
 	err->file = file;
 	err->line = line;
+	err->lazy = false;
 	return err->code;
 }
 
@@ -237,6 +266,7 @@ as_error_setallv(as_error* err, as_status code, const char * func, const char *
 	err->func = func;
 	err->file = file;
 	err->line = line;
+	err->lazy = false;
 	return err->code;
 }
 
@@ -256,6 +286,7 @@ as_error_set(as_error* err, as_status code, const char * fmt, ...)
 		va_end(ap);   
 	}
 	err->code = code;
+	err->lazy = false;
 	return err->code;
 }
 
@@ -287,6 +318,46 @@ as_error_copy(as_error * trg, const as_error * src)
 	trg->file = src->file;
 	trg->line = src->line;
 	trg->in_doubt = src->in_doubt;
+	trg->lazy = src->lazy;
+
+	if (src->lazy) {
+		strcpy(trg->lazy_address, src->lazy_address);
+	}
+}
+
+/**
+ * Return error message. Formats the message first when it was deferred (as_error.lazy).
+ * Use this function instead of reading as_error.message directly when
+ * as_config.lazy_error_messages is enabled.
+ *
+ * @relates as_error
+ */
+AS_EXTERN const char*
+as_error_message(as_error* err);
+
+/**
+ * @private
+ * Set server result code error with the address of the node that returned it. When lazy is
+ * true, only the address is copied and the message is formatted by as_error_message().
+ */
+static inline as_status
+as_error_set_status(
+	as_error* err, as_status code, const char* address, bool lazy, const char* func,
+	const char* file, uint32_t line
+	)
+{
+	err->code = code;
+	err->message[0] = '\0';
+	err->func = func;
+	err->file = file;
+	err->line = line;
+	as_strncpy(err->lazy_address, address ? address : "", AS_ERROR_LAZY_ADDRESS_SIZE);
+	err->lazy = true;
+
+	if (! lazy) {
+		as_error_message(err);
+	}
+	return err->code;
 }
 
 /**
@@ -297,6 +368,7 @@ as_error_copy(as_error * trg, const as_error * src)
 static inline void
 as_error_append(as_error* err, const char* str)
 {
+	as_error_message(err);
 	strncat(err->message, str, sizeof(err->message) - strlen(err->message) - 1);
 }
 
@@ -16,7 +16,11 @@
  */
 #pragma once
 
+#include <aerospike/as_command_counters.h>
 #include <aerospike/as_error.h>
+#include <aerospike/as_latency.h>
+#include <aerospike/as_mpsc_queue.h>
+#include <aerospike/as_policy.h>
 #include <aerospike/as_queue.h>
 #include <pthread.h>
 
@@ -26,7 +30,7 @@
  * Generic asynchronous events abstraction.  Designed to support multiple event libraries.
  * Only one library is supported per build.
  */
-#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBUV) || defined(AS_USE_LIBEVENT)
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBUV) || defined(AS_USE_LIBEVENT) || defined(AS_USE_LIBURING)
 #define AS_EVENT_LIB_DEFINED 1
 #endif
 
@@ -37,6 +41,8 @@
 #elif defined(AS_USE_LIBEVENT)
 #include <event2/event_struct.h>
 #include <aerospike/as_vector.h>
+#elif defined(AS_USE_LIBURING)
+struct as_uring_loop_s;
 #else
 #endif
 
@@ -47,6 +53,80 @@ extern "C" {
 /******************************************************************************
  * TYPES
  *****************************************************************************/
+
+/**
+ * Strategy used to choose an event loop when an async command is started without one.
+ *
+ * @ingroup async_events
+ */
+typedef enum as_event_loop_select_e {
+	/**
+	 * Rotate through event loops.  This is the default.
+	 */
+	AS_EVENT_LOOP_SELECT_ROUND_ROBIN,
+
+	/**
+	 * Sample two random event loops and choose the one with the least commands in process,
+	 * queued for submission or waiting in the delay queue.
+	 */
+	AS_EVENT_LOOP_SELECT_LEAST_LOADED,
+
+	/**
+	 * Choose the least loaded event loop on a thread's first command, then keep using that
+	 * event loop for all commands started by the same thread.
+	 */
+	AS_EVENT_LOOP_SELECT_THREAD_AFFINITY
+} as_event_loop_select;
+
+/**
+ * @private
+ * Number of command allocation size classes (1KB, 2KB, 4KB, 8KB and 16KB).
+ */
+#define AS_EVENT_SLAB_CLASSES 5
+
+/**
+ * @private
+ * Per event loop cache of freed command allocations.  Free lists are only accessed in the
+ * event loop thread.  Statistics are read without a lock.
+ */
+typedef struct as_event_slab_s {
+	void* free[AS_EVENT_SLAB_CLASSES];
+	uint32_t size[AS_EVENT_SLAB_CLASSES];
+	uint32_t max_size;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t remote;
+	uint64_t resident;
+} as_event_slab;
+
+/**
+ * @private
+ * Number of read buffer size classes (16KB doubling to 8MB).
+ */
+#define AS_EVENT_BUFFER_CLASSES 10
+
+/**
+ * @private
+ * Per event loop pool of freed read buffers that were too large for a command's embedded
+ * buffer.  Free lists are only accessed in the event loop thread.
+ */
+typedef struct as_event_buffer_pool_s {
+	void* free[AS_EVENT_BUFFER_CLASSES];
+	uint64_t max_resident;
+	uint64_t resident;
+} as_event_buffer_pool;
+
+/**
+ * @private
+ * Intrusive list of delayed commands with the same priority.  Commands link through their
+ * own delay_prev/delay_next fields, so a command can be removed from the middle of the
+ * list when it times out.
+ */
+typedef struct as_event_delay_lane_s {
+	struct as_event_command* head;
+	struct as_event_command* tail;
+	uint32_t size;
+} as_event_delay_lane;
 	
 /**
  * Asynchronous event loop configuration.
@@ -90,12 +170,165 @@ typedef struct as_policy_event {
 	uint32_t max_commands_in_queue;
 
 	/**
-	 * Initial capacity of each event loop's delay queue.  The delay queue can resize beyond this
-	 * initial capacity.
+	 * Reject async commands that would have to wait in the delay queue longer than their
+	 * remaining total timeout.  Each event loop estimates the wait from the average interval
+	 * between recent delay queue removals and the number of commands already queued on all
+	 * priority lanes.  Rejected commands fail immediately with AEROSPIKE_ERR_ASYNC_OVERLOAD
+	 * instead of expiring in the queue.  Commands without a total timeout are always queued.
+	 * Only used when max_commands_in_process is greater than zero.
 	 *
-	 * Default: 256 (if delay queue is used)
+	 * Default: false
+	 */
+	bool deadline_admission;
+
+	/**
+	 * Serve each delay queue priority lane in earliest deadline first order instead of
+	 * arrival order.  Commands with the nearest total timeout deadline start first, and
+	 * commands whose deadline has already passed when their turn comes are failed with
+	 * AEROSPIKE_ERR_TIMEOUT without being sent.  Commands without a total timeout are queued
+	 * behind all commands with one.  Priority lanes are still served in weighted round-robin
+	 * order.  Only used when max_commands_in_process is greater than zero.
+	 *
+	 * Default: false
+	 */
+	bool deadline_order;
+
+	/**
+	 * Initial capacity of each event loop's delay queue.
+	 *
+	 * This field is no longer used.  Delayed commands are linked directly into per priority
+	 * lists, so the delay queue does not preallocate or resize.
+	 *
+	 * Default: 256
 	 */
 	uint32_t queue_initial_capacity;
+
+	/**
+	 * Maximum number of freed single record command allocations cached per size class in each
+	 * event loop.  Commands created in the event loop thread (usually from a listener callback)
+	 * reuse cached allocations instead of going to the heap.  Commands created in other threads
+	 * are still allocated from the heap, but are cached when they complete.
+	 *
+	 * Each event loop caches at most command_cache_size * 31KB.  If zero, commands are not
+	 * cached.
+	 *
+	 * Default: 64
+	 */
+	uint32_t command_cache_size;
+
+	/**
+	 * Maximum bytes of freed read buffers retained in each event loop.  Responses that do not
+	 * fit in a command's embedded buffer are read into a buffer rounded up to the next power
+	 * of two (16KB to 8MB).  Freed buffers are kept for later responses up to this limit, so
+	 * streaming batch, scan and query results do not allocate for each response block.
+	 * Responses larger than 8MB are always allocated from the heap.  If zero, read buffers
+	 * are not retained.
+	 *
+	 * Default: 16MB
+	 */
+	uint32_t read_buffer_cache_size;
+
+	/**
+	 * Use a per event loop timer wheel with one millisecond ticks for command socket and total
+	 * timeouts instead of one event library timer per command.  Starting and stopping a wheel
+	 * timer is O(1) and timeouts that share a tick expire together.  This reduces timer
+	 * overhead when each event loop has many commands in flight.
+	 *
+	 * Default: false
+	 */
+	bool timer_wheel;
+
+	/**
+	 * Maximum microseconds that async single key reads with as_policy_read.auto_batch enabled
+	 * wait to be merged with other reads before the batch is sent.  Event library timers have
+	 * millisecond resolution, so the window is truncated to whole milliseconds.  Windows under
+	 * one millisecond send the batch on the next event loop iteration, which merges all reads
+	 * issued during the current iteration (for example, from one listener callback).
+	 *
+	 * Default: 100
+	 */
+	uint32_t auto_batch_window_us;
+
+	/**
+	 * Maximum number of async single key reads merged into one batch.  The batch is sent
+	 * immediately when this many reads are waiting.  Must be greater than zero.
+	 *
+	 * Default: 100
+	 */
+	uint32_t auto_batch_max_keys;
+
+	/**
+	 * Interval in milliseconds of a repeating timer that measures event loop lag, the delay
+	 * between the timer's scheduled and actual wakeup.  Lag is caused by listener callbacks or
+	 * other work that blocks the event loop thread.  The timer starts when the event loop runs
+	 * its first command.  Lag is reported in as_event_loop_stats.lag.  If zero, lag is not
+	 * measured.
+	 *
+	 * Default: 0
+	 */
+	uint32_t lag_interval_ms;
+
+	/**
+	 * Measure time spent in async listener callbacks.  Durations are reported in
+	 * as_event_loop_stats.callbacks.
+	 *
+	 * Default: false
+	 */
+	bool callback_stats;
+
+	/**
+	 * Log a warning with the command type when an async listener callback runs for at least
+	 * this many microseconds.  Setting a threshold also measures callbacks as if
+	 * callback_stats were set.  If zero, slow callbacks are not logged.
+	 *
+	 * Default: 0
+	 */
+	uint32_t slow_callback_us;
+
+	/**
+	 * Microseconds each event loop thread created by as_create_event_loops() keeps polling
+	 * for socket events without blocking after its last activity.  The thread only blocks in
+	 * the kernel once no command has started and no bytes were received for this long.  This
+	 * trades a fully busy CPU per event loop for lower wakeup latency, so it should only be
+	 * used when event loops are pinned to dedicated cores (see cpus).  The io_uring backend
+	 * also requests a kernel submission polling thread (SQPOLL) that idles after the same
+	 * budget, falling back to normal submission when the kernel does not allow it.  Ignored
+	 * for external event loops.
+	 *
+	 * Default: 0 (block when idle)
+	 */
+	uint32_t busy_poll_us;
+
+	/**
+	 * SO_BUSY_POLL value in microseconds set on async connections of these event loops
+	 * (Linux only).  The kernel then polls the device queue for the socket instead of waiting
+	 * for an interrupt.  See as_config.socket_busy_poll for sync connections.
+	 *
+	 * Default: 0 (not set)
+	 */
+	uint32_t socket_busy_poll;
+
+	/**
+	 * CPU ids that threads created by as_create_event_loops() are pinned to.  Event loop i is
+	 * pinned to cpus[i % cpus_size], so one CPU per loop or a shorter list that is reused
+	 * round-robin can be specified.  A negative id leaves that loop's thread unpinned.
+	 *
+	 * A pinned event loop thread allocates its command, read buffer and connection memory
+	 * after it is pinned, so the operating system's default first touch policy places that
+	 * memory on the NUMA node of the loop's CPU.  Pinning has no effect on external event
+	 * loops.  The array is copied into the event loops, so it only needs to be valid during
+	 * as_create_event_loops().
+	 *
+	 * Default: NULL (not pinned)
+	 */
+	const int* cpus;
+
+	/**
+	 * Number of entries in cpus.
+	 *
+	 * Default: 0
+	 */
+	uint32_t cpus_size;
 } as_policy_event;
 
 /**
@@ -116,15 +349,24 @@ typedef struct as_event_loop {
 	struct event wakeup;
 	struct event trim;
 	as_vector clusters;
+#elif defined(AS_USE_LIBURING)
+	struct as_uring_loop_s* loop;
+	int wakeup;
 #else
 	void* loop;
 #endif
 		
 	struct as_event_loop* next;
-	pthread_mutex_t lock;
-	as_queue queue;
-	as_queue delay_queue;
+	as_mpsc_queue queue;
+	as_event_delay_lane delay_queue[AS_POLICY_PRIORITY_MAX];
 	as_queue pipe_cb_queue;
+	as_event_slab slab;
+	as_event_buffer_pool buffer_pool;
+	struct as_event_wheel_s* wheel;
+	struct as_auto_batch_s* auto_batch;
+	struct as_event_lag_s* lag;
+	// Pipeline connections whose writes are deferred while pipeline listeners run.
+	struct as_pipe_connection* pipe_gather;
 	pthread_t thread;
 	uint32_t index;
 	uint32_t max_commands_in_queue;
@@ -133,8 +375,39 @@ typedef struct as_event_loop {
 	// Count of consecutive errors occurring before event loop registration.
 	// Used to prevent deep recursion.
 	uint32_t errors;
+	// Set by the first command queued after the event loop starts draining its queue.
+	// Later commands skip the wakeup until the queue is drained again.
+	uint32_t wakeup_pending;
+	// Total commands on all delay queue lanes.
+	uint32_t delay_size;
+	// Position in the weighted delay queue lane schedule.
+	uint32_t delay_cursor;
+	// Moving average of nanoseconds between delay queue removals while commands were still
+	// queued.  Zero until measured.  Only maintained when deadline_admission is set.
+	uint64_t delay_interval_ns;
+	// Time of the last delay queue removal.
+	uint64_t delay_pop_ns;
+	uint32_t auto_batch_window_ms;
+	uint32_t auto_batch_max_keys;
+	// Command and byte counters. Only modified in the event loop thread.
+	as_command_counters counters;
+	// Event loop lag and listener callback duration histograms (log2 microseconds).
+	uint64_t lag_hist[AS_LATENCY_BUCKETS];
+	uint64_t callback_hist[AS_LATENCY_BUCKETS];
+	uint32_t slow_callback_us;
+	// Idle microseconds spent polling without blocking. Zero when disabled or after the
+	// event loop is closed.
+	uint32_t busy_poll_us;
+	uint32_t socket_busy_poll;
+	bool callback_stats;
+	// CPU that the event loop thread is pinned to or -1 if not pinned.
+	int cpu;
 	bool using_delay_queue;
 	bool pipe_cb_calling;
+	bool deadline_admission;
+	bool deadline_order;
+	// Commands were still queued after the last delay queue removal.
+	bool delay_backlog;
 } as_event_loop;
 
 /******************************************************************************
@@ -160,7 +433,21 @@ as_policy_event_init(as_policy_event* policy)
 {
 	policy->max_commands_in_process = 0;
 	policy->max_commands_in_queue = 0;
+	policy->deadline_admission = false;
+	policy->deadline_order = false;
 	policy->queue_initial_capacity = 256;
+	policy->command_cache_size = 64;
+	policy->read_buffer_cache_size = 16 * 1024 * 1024;
+	policy->timer_wheel = false;
+	policy->auto_batch_window_us = 100;
+	policy->auto_batch_max_keys = 100;
+	policy->lag_interval_ms = 0;
+	policy->callback_stats = false;
+	policy->slow_callback_us = 0;
+	policy->busy_poll_us = 0;
+	policy->socket_busy_poll = 0;
+	policy->cpus = NULL;
+	policy->cpus_size = 0;
 }
 
 /**
@@ -386,6 +673,28 @@ as_event_loop_get()
 	return event_loop;
 }
 	
+/**
+ * Retrieve the less loaded of two randomly chosen event loops.  Load is the approximate
+ * number of commands in process, queued for submission and in the delay queue.
+ *
+ * @return			Client's generic event loop abstraction that is used in client async commands.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN as_event_loop*
+as_event_loop_get_least_loaded(void);
+
+/**
+ * Set how an event loop is chosen when async commands are started with a NULL event loop.
+ * This setting is process wide.
+ *
+ * @param mode		Event loop selection mode.  Default: AS_EVENT_LOOP_SELECT_ROUND_ROBIN
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN void
+as_event_set_loop_select(as_event_loop_select mode);
+
 /**
  * Return the approximate number of commands currently being processed on
  * the event loop.  The value is approximate because the call may be from a
@@ -411,7 +720,20 @@ as_event_loop_get_process_size(as_event_loop* event_loop)
 static inline uint32_t
 as_event_loop_get_queue_size(as_event_loop* event_loop)
 {
-	return as_queue_size(&event_loop->delay_queue);
+	return event_loop->delay_size;
+}
+
+/**
+ * Return the CPU id that this event loop's thread is pinned to or -1 if the thread is not
+ * pinned.  Applications can use this to run their own work for an event loop on the same CPU
+ * (or NUMA node) as the loop.
+ *
+ * @ingroup async_events
+ */
+static inline int
+as_event_loop_get_cpu(as_event_loop* event_loop)
+{
+	return event_loop->cpu;
 }
 
 /**
@@ -17,6 +17,9 @@
 #pragma once
 
 #include <aerospike/as_admin.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_async_cancel.h>
+#include <aerospike/as_async_flow.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_queue.h>
@@ -32,6 +35,8 @@
 struct as_uv_tls;
 #elif defined(AS_USE_LIBEVENT)
 #include <event2/event.h>
+#elif defined(AS_USE_LIBURING)
+#include <stddef.h>
 #else
 #endif
 
@@ -56,6 +61,8 @@ extern "C" {
 #define AS_ASYNC_STATE_COMMAND_READ_BODY 10
 #define AS_ASYNC_STATE_QUEUE_ERROR 11
 #define AS_ASYNC_STATE_RETRY 12
+#define AS_ASYNC_STATE_COMMAND_READ_PAUSED 13
+#define AS_ASYNC_STATE_SLEEP 14
 
 #define AS_ASYNC_FLAGS_MASTER 1
 #define AS_ASYNC_FLAGS_READ 2
@@ -68,6 +75,15 @@ extern "C" {
 
 #define AS_ASYNC_FLAGS2_DESERIALIZE 1
 #define AS_ASYNC_FLAGS2_HEAP_REC 2
+#define AS_ASYNC_FLAGS2_ZERO_COPY 4
+#define AS_ASYNC_FLAGS2_SENDING 8
+#define AS_ASYNC_FLAGS2_RELEASE 16
+#define AS_ASYNC_FLAGS2_WRITE_PENDING 32
+#define AS_ASYNC_FLAGS2_SLAB 64
+#define AS_ASYNC_FLAGS2_WHEEL 128
+
+#define AS_EVENT_SLAB_NONE 0xFF
+#define AS_ASYNC_FLAGS2_URING (AS_ASYNC_FLAGS2_SENDING | AS_ASYNC_FLAGS2_RELEASE | AS_ASYNC_FLAGS2_WRITE_PENDING)
 
 #define AS_ASYNC_AUTH_RETURN_CODE 1
 
@@ -76,10 +92,21 @@ extern "C" {
 #define AS_EVENT_CONNECTION_ERROR 2
 
 #define AS_EVENT_QUEUE_INITIAL_CAPACITY 256
+
+// Timer wheel slot count (power of 2).  Each slot is one millisecond.
+#define AS_EVENT_WHEEL_SLOTS 1024
 	
 struct as_event_command;
 struct as_event_executor;
 
+#if defined(AS_USE_LIBURING)
+typedef struct {
+	uint64_t deadline;
+	uint64_t repeat;
+	uint32_t index;
+} as_uring_timer;
+#endif
+
 typedef struct {
 #if defined(AS_USE_LIBEV)
 	struct ev_io watcher;
@@ -96,8 +123,26 @@ typedef struct {
 #elif defined(AS_USE_LIBEVENT)
 	struct event watcher;
 	as_socket socket;
+#elif defined(AS_USE_LIBURING)
+	as_socket socket;
+	as_event_loop* event_loop;
+	// Command whose write buffer is referenced by an in-flight send.
+	struct as_event_command* sender;
+	// Number of submitted operations that still reference this connection.
+	uint32_t inflight;
+	// Number of one-shot poll requests in flight.
+	uint32_t polls;
+	// Fixed file index or -1 when the raw fd is used.
+	int fixed;
+	bool recv_armed;
+	bool invalid;
+	bool closed;
 #else
 #endif
+	// Pipeline only.  Bytes of the gathered commands sent by the connection's current writer
+	// or NULL when the writer sends only its own command.
+	uint8_t* gather;
+	uint32_t gather_len;
 	int watching;
 	bool pipeline;
 } as_event_connection;
@@ -123,6 +168,8 @@ typedef struct as_event_command {
 	uv_timer_t timer;
 #elif defined(AS_USE_LIBEVENT)
 	struct event timer;
+#elif defined(AS_USE_LIBURING)
+	as_uring_timer timer;
 #else
 #endif
 	uint64_t total_deadline;
@@ -141,6 +188,21 @@ typedef struct as_event_command {
 	as_event_parse_results_fn parse_results;
 	as_pipe_listener pipe_listener;
 	cf_ll_element pipe_link;
+	struct as_event_command* wheel_prev;
+	struct as_event_command* wheel_next;
+	uint64_t wheel_expire;
+	uint32_t wheel_repeat;
+	uint32_t wheel_slot;
+	// Start of the current attempt in nanoseconds when node latency is measured.  Zero otherwise.
+	uint64_t latency_begin;
+	// Start of the current attempt in nanoseconds when node has latency histograms.  Zero otherwise.
+	uint64_t stats_begin;
+	// Trace span allocated when command is sampled for tracing.  NULL otherwise.
+	as_trace_span* trace;
+	// Delay queue links.  Also used for the executor's paused command list, because running
+	// commands are never in the delay queue.
+	struct as_event_command* delay_prev;
+	struct as_event_command* delay_next;
 	
 	uint8_t* buf;
 	uint32_t command_sent_counter;
@@ -156,6 +218,10 @@ typedef struct as_event_command {
 	uint8_t state;
 	uint8_t flags;
 	uint8_t flags2;
+	uint8_t slab_class;
+	uint8_t priority;
+	// write_len is counted in the node's async in-flight bytes.
+	bool node_bytes;
 } as_event_command;
 
 typedef struct {
@@ -163,10 +229,39 @@ typedef struct {
 	void* udata;
 } as_event_commander;
 
+/**
+ * Hashed timer wheel with one millisecond ticks.  Timeouts longer than the wheel span stay in
+ * their slot until the tick that matches their expiration.  One backend timer (driver) runs
+ * the wheel while it has timers.
+ */
+typedef struct as_event_wheel_s {
+	// Must be first field, so the wheel can be freed from the driver's timer handle.
+	as_event_command driver;
+	as_event_command* slots[AS_EVENT_WHEEL_SLOTS];
+	as_event_command* expired;
+	uint64_t tick;
+	uint32_t size;
+	bool running;
+} as_event_wheel;
+
+/**
+ * Repeating timer that measures event loop lag.
+ */
+typedef struct as_event_lag_s {
+	// Must be first field, so the lag timer can be freed from the driver's timer handle.
+	as_event_command driver;
+	uint64_t expected_ns;
+	uint32_t interval_ms;
+	bool running;
+} as_event_lag;
+
 typedef struct as_event_executor {
 	pthread_mutex_t lock;
 	struct as_event_command** commands;
 	as_event_loop* event_loop;
+	as_async_flow* flow;
+	as_async_cancel* cancel;
+	struct as_event_command* paused;
 	as_event_executor_complete_fn complete_fn;
 	void* udata;
 	as_error* err;
@@ -178,18 +273,31 @@ typedef struct as_event_executor {
 	uint32_t queued;
 	bool notify;
 	bool valid;
+	bool spread;
 } as_event_executor;
 
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+extern as_event_loop_select as_event_loop_select_mode;
+
 /******************************************************************************
  * COMMON FUNCTIONS
  *****************************************************************************/
 
+as_event_loop*
+as_event_loop_select_next(void);
+
 as_status
 as_event_command_execute(as_event_command* cmd, as_error* err);
 
 void
 as_event_command_schedule(as_event_command* cmd);
 
+void
+as_event_command_schedule_delay(as_event_command* cmd, uint32_t delay_ms);
+
 bool
 as_event_proto_parse(as_event_command* cmd, as_proto* proto);
 
@@ -223,12 +331,63 @@ as_event_batch_complete(as_event_command* cmd);
 void
 as_event_executor_error(as_event_executor* executor, as_error* err, uint32_t command_count);
 
+bool
+as_event_can_block(void);
+
 void
 as_event_executor_cancel(as_event_executor* executor, uint32_t queued_count);
 
+void
+as_event_executor_abort(as_event_executor* executor, as_error* err);
+
 void
 as_event_executor_complete(as_event_executor* executor);
 
+typedef void (*as_async_abort_fn)(as_event_executor* executor);
+
+static inline as_event_loop*
+as_event_executor_loop(as_event_executor* executor, uint32_t i)
+{
+	// Spread executors run command i on the i-th event loop after the assigned loop.
+	if (! executor->spread) {
+		return executor->event_loop;
+	}
+	return &as_event_loops[(executor->event_loop->index + i) % as_event_loop_size];
+}
+
+void
+as_async_cancel_executor(as_event_executor* executor);
+
+static inline bool
+as_event_executor_cancelled(as_event_executor* executor)
+{
+	// Lets commands stop before the scheduled cancel runs in the event loop.
+	return executor->cancel && executor->valid && as_load_uint32(&executor->cancel->cancelled);
+}
+
+void
+as_async_cancel_attach(
+	as_async_cancel* cancel, as_event_executor* executor, as_async_abort_fn abort_fn
+	);
+
+void
+as_async_cancel_detach(as_async_cancel* cancel, as_event_executor* executor);
+
+void
+as_async_flow_attach(as_async_flow* flow, as_event_executor* executor);
+
+void
+as_async_flow_detach(as_async_flow* flow, as_event_executor* executor);
+
+void
+as_async_flow_pause(as_event_command* cmd);
+
+void
+as_async_flow_remove(as_event_command* cmd);
+
+void
+as_async_flow_wakeup(as_async_flow* flow);
+
 void
 as_event_error_callback(as_event_command* cmd, as_error* err);
 
@@ -268,6 +427,80 @@ as_event_create_connections(as_node* node, as_async_conn_pool* pools);
 void
 as_event_close_cluster(as_cluster* cluster);
 
+/**
+ * Run commands queued by as_event_execute() in the event loop thread.
+ * Return false if the stop signal was received and the event loop should be closed.
+ */
+bool
+as_event_process_queue(as_event_loop* event_loop);
+
+/**
+ * Create event loop thread and pin it to the event loop's cpu when one is assigned.
+ */
+bool
+as_event_thread_create(as_event_loop* event_loop, void* (*worker)(void*), void* udata);
+
+/**
+ * Allocate command memory.  Size is rounded up to the size class of the returned allocation
+ * and slab_class is set to that class.  slab_class is AS_EVENT_SLAB_NONE if the allocation
+ * must not be returned with as_event_slab_free().
+ */
+void*
+as_event_slab_alloc(as_event_loop* event_loop, size_t* size, uint8_t* slab_class);
+
+/**
+ * Cache freed command memory if called in the event loop thread.  Otherwise, free memory.
+ */
+void
+as_event_slab_free(as_event_loop* event_loop, void* ptr, uint8_t slab_class);
+
+void
+as_event_slab_destroy(as_event_slab* slab);
+
+/**
+ * Allocate read buffer.  Size is rounded up to the capacity of the returned buffer.
+ */
+uint8_t*
+as_event_buffer_alloc(as_event_loop* event_loop, size_t* size);
+
+/**
+ * Return read buffer to the event loop's pool if called in the event loop thread and the pool
+ * has room.  Otherwise, free buffer.  capacity must be the size returned by
+ * as_event_buffer_alloc().
+ */
+void
+as_event_buffer_free(as_event_loop* event_loop, uint8_t* buf, size_t capacity);
+
+void
+as_event_buffer_pool_destroy(as_event_buffer_pool* pool);
+
+void
+as_event_wheel_add(as_event_wheel* wheel, as_event_command* cmd, uint64_t timeout, uint64_t repeat);
+
+void
+as_event_wheel_remove(as_event_wheel* wheel, as_event_command* cmd);
+
+void
+as_event_wheel_tick(as_event_wheel* wheel);
+
+void
+as_event_wheel_destroy(as_event_loop* event_loop);
+
+void
+as_event_lag_start(as_event_loop* event_loop);
+
+void
+as_event_lag_destroy(as_event_loop* event_loop);
+
+/**
+ * Send the auto batch when its window timer fires.
+ */
+void
+as_auto_batch_expire(as_event_loop* event_loop);
+
+void
+as_auto_batch_destroy(as_event_loop* event_loop);
+
 /******************************************************************************
  * IMPLEMENTATION SPECIFIC FUNCTIONS
  *****************************************************************************/
@@ -288,9 +521,31 @@ as_event_execute(as_event_loop* event_loop, as_event_executable executable, void
 void
 as_event_command_write_start(as_event_command* cmd);
 
+/**
+ * Stop reading command's connection.  Return false if the event backend or connection type
+ * does not support pausing reads.
+ */
+bool
+as_event_command_read_pause(as_event_command* cmd);
+
+/**
+ * Continue reading command's connection from the next response block header.
+ */
+void
+as_event_command_read_resume(as_event_command* cmd);
+
 void
 as_event_connect(as_event_command* cmd, as_async_conn_pool* pool);
 
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+/**
+ * Take ownership of socket that was connected and authenticated on a helper thread.
+ * The connection's watcher is initialized, but not started.
+ */
+void
+as_event_adopt_connection(as_event_loop* event_loop, as_event_connection* conn, as_socket* sock);
+#endif
+
 void
 as_event_node_destroy(as_node* node);
 
@@ -335,7 +590,7 @@ as_event_set_conn_last_used(as_event_connection* conn)
 }
 
 static inline void
-as_event_timer_once(as_event_command* cmd, uint64_t timeout)
+as_event_lib_timer_once(as_event_command* cmd, uint64_t timeout)
 {
 	ev_timer_init(&cmd->timer, as_ev_timer_cb, (double)timeout / 1000.0, 0.0);
 	cmd->timer.data = cmd;
@@ -344,7 +599,7 @@ as_event_timer_once(as_event_command* cmd, uint64_t timeout)
 }
 
 static inline void
-as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
+as_event_lib_timer_repeat(as_event_command* cmd, uint64_t repeat)
 {
 	ev_init(&cmd->timer, as_ev_repeat_cb);
 	cmd->timer.repeat = (double)repeat / 1000.0;
@@ -354,13 +609,13 @@ as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
 }
 
 static inline void
-as_event_timer_again(as_event_command* cmd)
+as_event_lib_timer_again(as_event_command* cmd)
 {
 	ev_timer_again(cmd->event_loop->loop, &cmd->timer);
 }
 
 static inline void
-as_event_timer_stop(as_event_command* cmd)
+as_event_lib_timer_stop(as_event_command* cmd)
 {
 	if (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER) {
 		ev_timer_stop(cmd->event_loop->loop, &cmd->timer);
@@ -427,7 +682,7 @@ as_event_set_conn_last_used(as_event_connection* conn)
 }
 
 static inline void
-as_event_timer_once(as_event_command* cmd, uint64_t timeout)
+as_event_lib_timer_once(as_event_command* cmd, uint64_t timeout)
 {
 	if (!(cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
 		uv_timer_init(cmd->event_loop->loop, &cmd->timer);
@@ -438,7 +693,7 @@ as_event_timer_once(as_event_command* cmd, uint64_t timeout)
 }
 
 static inline void
-as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
+as_event_lib_timer_repeat(as_event_command* cmd, uint64_t repeat)
 {
 	if (!(cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
 		uv_timer_init(cmd->event_loop->loop, &cmd->timer);
@@ -449,13 +704,13 @@ as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
 }
 
 static inline void
-as_event_timer_again(as_event_command* cmd)
+as_event_lib_timer_again(as_event_command* cmd)
 {
 	// libuv socket timers automatically repeat.
 }
 
 static inline void
-as_event_timer_stop(as_event_command* cmd)
+as_event_lib_timer_stop(as_event_command* cmd)
 {
 	if (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER) {
 		uv_timer_stop(&cmd->timer);
@@ -533,7 +788,7 @@ as_event_set_conn_last_used(as_event_connection* conn)
 }
 
 static inline void
-as_event_timer_once(as_event_command* cmd, uint64_t timeout)
+as_event_lib_timer_once(as_event_command* cmd, uint64_t timeout)
 {
 	evtimer_assign(&cmd->timer, cmd->event_loop->loop, as_libevent_timer_cb, cmd);
 	struct timeval tv;
@@ -544,7 +799,7 @@ as_event_timer_once(as_event_command* cmd, uint64_t timeout)
 }
 
 static inline void
-as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
+as_event_lib_timer_repeat(as_event_command* cmd, uint64_t repeat)
 {
 	event_assign(&cmd->timer, cmd->event_loop->loop, -1, EV_PERSIST, as_libevent_repeat_cb, cmd);
 	struct timeval tv;
@@ -555,13 +810,13 @@ as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
 }
 
 static inline void
-as_event_timer_again(as_event_command* cmd)
+as_event_lib_timer_again(as_event_command* cmd)
 {
 	// libevent socket timers automatically repeat.
 }
 
 static inline void
-as_event_timer_stop(as_event_command* cmd)
+as_event_lib_timer_stop(as_event_command* cmd)
 {
 	if (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER) {
 		evtimer_del(&cmd->timer);
@@ -587,6 +842,88 @@ as_event_command_release(as_event_command* cmd)
 	as_event_command_free(cmd);
 }
 
+/******************************************************************************
+ * LIBURING INLINE FUNCTIONS
+ *****************************************************************************/
+
+#elif defined(AS_USE_LIBURING)
+
+void as_uring_timer_start(as_event_command* cmd, uint64_t timeout, uint64_t repeat);
+void as_uring_timer_stop(as_event_command* cmd);
+void as_event_close_connection(as_event_connection* conn);
+void as_event_command_release(as_event_command* cmd);
+
+static inline bool
+as_event_conn_current_trim(as_event_connection* conn, uint64_t max_socket_idle_ns)
+{
+	return as_socket_current_trim(conn->socket.last_used, max_socket_idle_ns);
+}
+
+static inline bool
+as_event_conn_current_tran(as_event_connection* conn, uint64_t max_socket_idle_ns)
+{
+	return as_socket_current_tran(conn->socket.last_used, max_socket_idle_ns);
+}
+
+static inline int
+as_event_conn_validate(as_event_connection* conn)
+{
+	if (conn->socket.ctx) {
+		return as_socket_validate_fd(conn->socket.fd);
+	}
+
+	// Multishot receive is always armed on plain connections, so unexpected data or
+	// a peer close has already been recorded.
+	return conn->invalid ? -1 : 0;
+}
+
+static inline void
+as_event_set_conn_last_used(as_event_connection* conn)
+{
+	conn->socket.last_used = cf_getns();
+}
+
+static inline void
+as_event_lib_timer_once(as_event_command* cmd, uint64_t timeout)
+{
+	as_uring_timer_start(cmd, timeout, 0);
+	cmd->flags |= AS_ASYNC_FLAGS_HAS_TIMER;
+}
+
+static inline void
+as_event_lib_timer_repeat(as_event_command* cmd, uint64_t repeat)
+{
+	as_uring_timer_start(cmd, repeat, repeat);
+	cmd->flags |= AS_ASYNC_FLAGS_HAS_TIMER | AS_ASYNC_FLAGS_USING_SOCKET_TIMER;
+}
+
+static inline void
+as_event_lib_timer_again(as_event_command* cmd)
+{
+	as_uring_timer_start(cmd, cmd->timer.repeat, cmd->timer.repeat);
+}
+
+static inline void
+as_event_lib_timer_stop(as_event_command* cmd)
+{
+	if (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER) {
+		as_uring_timer_stop(cmd);
+	}
+}
+
+static inline void
+as_event_stop_watcher(as_event_command* cmd, as_event_connection* conn)
+{
+	// Receive stays armed while the connection is open. Only mark connection idle.
+	conn->watching = 0;
+}
+
+static inline void
+as_event_stop_read(as_event_connection* conn)
+{
+	// This method only needed for libuv pipelined connections.
+}
+
 /******************************************************************************
  * EVENT_LIB NOT DEFINED INLINE FUNCTIONS
  *****************************************************************************/
@@ -622,22 +959,22 @@ as_event_set_conn_last_used(as_event_connection* conn)
 }
 
 static inline void
-as_event_timer_once(as_event_command* cmd, uint64_t timeout)
+as_event_lib_timer_once(as_event_command* cmd, uint64_t timeout)
 {
 }
 
 static inline void
-as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
+as_event_lib_timer_repeat(as_event_command* cmd, uint64_t repeat)
 {
 }
 
 static inline void
-as_event_timer_again(as_event_command* cmd)
+as_event_lib_timer_again(as_event_command* cmd)
 {
 }
 
 static inline void
-as_event_timer_stop(as_event_command* cmd)
+as_event_lib_timer_stop(as_event_command* cmd)
 {
 }
 
@@ -662,11 +999,59 @@ as_event_command_release(as_event_command* cmd)
  * COMMON INLINE FUNCTIONS
  *****************************************************************************/
 
+static inline void
+as_event_timer_once(as_event_command* cmd, uint64_t timeout)
+{
+	as_event_wheel* wheel = cmd->event_loop->wheel;
+
+	// Zero timeouts defer work to the next loop iteration and stay on the backend timer.
+	if (wheel && timeout > 0) {
+		as_event_wheel_add(wheel, cmd, timeout, 0);
+		return;
+	}
+	as_event_lib_timer_once(cmd, timeout);
+}
+
+static inline void
+as_event_timer_repeat(as_event_command* cmd, uint64_t repeat)
+{
+	as_event_wheel* wheel = cmd->event_loop->wheel;
+
+	if (wheel && repeat > 0) {
+		as_event_wheel_add(wheel, cmd, repeat, repeat);
+		cmd->flags |= AS_ASYNC_FLAGS_USING_SOCKET_TIMER;
+		return;
+	}
+	as_event_lib_timer_repeat(cmd, repeat);
+}
+
+static inline void
+as_event_timer_again(as_event_command* cmd)
+{
+	// Wheel socket timers are rearmed when they fire.
+	if (! (cmd->flags2 & AS_ASYNC_FLAGS2_WHEEL)) {
+		as_event_lib_timer_again(cmd);
+	}
+}
+
+static inline void
+as_event_timer_stop(as_event_command* cmd)
+{
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_WHEEL) {
+		as_event_wheel_remove(cmd->event_loop->wheel, cmd);
+	}
+	as_event_lib_timer_stop(cmd);
+}
+
 static inline as_event_loop*
 as_event_assign(as_event_loop* event_loop)
 {
-	// Assign event loop using round robin distribution if not specified.
-	return event_loop ? event_loop : as_event_loop_get();
+	// Assign event loop using configured selection mode if not specified.
+	if (event_loop) {
+		return event_loop;
+	}
+	return (as_event_loop_select_mode == AS_EVENT_LOOP_SELECT_ROUND_ROBIN) ?
+		as_event_loop_get() : as_event_loop_select_next();
 }
 
 static inline void
@@ -704,11 +1089,32 @@ as_event_set_auth_parse_header(as_event_command* cmd)
 	return true;
 }
 
+static inline uint8_t*
+as_event_write_buffer(as_event_command* cmd)
+{
+	// A pipeline writer sends the commands gathered on its connection in one write.
+	as_event_connection* conn = cmd->conn;
+	return (conn->pipeline && conn->gather)? conn->gather : (uint8_t*)cmd + cmd->write_offset;
+}
+
 static inline void
 as_event_set_write(as_event_command* cmd)
 {
-	cmd->len = cmd->write_len;
+	as_event_connection* conn = cmd->conn;
+	cmd->len = (conn->pipeline && conn->gather)? conn->gather_len : cmd->write_len;
 	cmd->pos = 0;
+
+	if (cmd->trace) {
+		cmd->trace->connect_ns = cf_getns();
+	}
+}
+
+static inline void
+as_event_trace_sent(as_event_command* cmd)
+{
+	if (cmd->trace) {
+		cmd->trace->send_ns = cf_getns();
+	}
 }
 
 static inline void
@@ -719,6 +1125,29 @@ as_async_conn_pool_init(as_async_conn_pool* pool, uint32_t min_size, uint32_t ma
 	pool->limit = max_size;
 	pool->opened = 0;
 	pool->closed = 0;
+	pool->peak = 0;
+	pool->last_peak = 0;
+	pool->target = 0;
+	pool->connecting = 0;
+}
+
+static inline uint32_t
+as_async_conn_pool_in_use(as_async_conn_pool* pool)
+{
+	// Only idle connections are in the queue.  Connections opened by the background connector
+	// are not demand.
+	return pool->queue.total - as_queue_size(&pool->queue) - pool->connecting;
+}
+
+static inline void
+as_async_conn_pool_track_demand(as_async_conn_pool* pool)
+{
+	// Called after a command takes a connection.
+	uint32_t in_use = as_async_conn_pool_in_use(pool);
+
+	if (in_use > pool->peak) {
+		pool->peak = in_use;
+	}
 }
 
 static inline bool
@@ -806,21 +1235,201 @@ as_event_socket_retry(as_event_command* cmd)
 	return as_event_command_retry(cmd, false);
 }
 
+static inline void
+as_event_command_read_buffer(as_event_command* cmd, size_t size)
+{
+	// Replace read buffer that is too small for the next response block.
+	if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
+		as_event_buffer_free(cmd->event_loop, cmd->buf, cmd->read_capacity);
+	}
+	cmd->buf = as_event_buffer_alloc(cmd->event_loop, &size);
+	cmd->read_capacity = (uint32_t)size;
+	cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+}
+
+static inline void
+as_event_command_dealloc(as_event_command* cmd)
+{
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_SLAB) {
+		as_event_slab_free(cmd->event_loop, cmd, cmd->slab_class);
+	}
+	else {
+		as_alloc_free(cmd);
+	}
+}
+
 static inline void
 as_event_command_destroy(as_event_command* cmd)
 {
 	// Use this function to free batch/scan/query commands that were never started.
 	as_node_release(cmd->node);
-	cf_free(cmd);
+	as_event_command_dealloc(cmd);
+}
+
+static inline bool
+as_event_queue_command(as_event_loop* event_loop, as_event_executable executable, void* udata)
+{
+	as_event_commander qcmd = {.executable = executable, .udata = udata};
+	return as_mpsc_queue_push(&event_loop->queue, &qcmd);
+}
+
+static inline bool
+as_event_wakeup_needed(as_event_loop* event_loop)
+{
+	// Only the first command queued since the last drain sends a wakeup.
+	return as_fas_uint32(&event_loop->wakeup_pending, 1) == 0;
+}
+
+static inline void
+as_event_delay_push(as_event_loop* event_loop, as_event_command* cmd)
+{
+	if (cmd->priority >= AS_POLICY_PRIORITY_MAX) {
+		cmd->priority = AS_POLICY_PRIORITY_NORMAL;
+	}
+
+	as_event_delay_lane* lane = &event_loop->delay_queue[cmd->priority];
+	as_event_command* prev = lane->tail;
+
+	if (event_loop->deadline_order && cmd->total_deadline > 0) {
+		// Keep lane sorted by deadline with commands that have no deadline last.  Timeouts
+		// are usually similar, so the walk from the tail rarely passes more than a few
+		// commands.
+		while (prev && (prev->total_deadline == 0 || prev->total_deadline > cmd->total_deadline)) {
+			prev = prev->delay_prev;
+		}
+	}
+
+	as_event_command* next = prev ? prev->delay_next : lane->head;
+
+	cmd->delay_prev = prev;
+	cmd->delay_next = next;
+
+	if (prev) {
+		prev->delay_next = cmd;
+	}
+	else {
+		lane->head = cmd;
+	}
+
+	if (next) {
+		next->delay_prev = cmd;
+	}
+	else {
+		lane->tail = cmd;
+	}
+	lane->size++;
+	event_loop->delay_size++;
+}
+
+static inline void
+as_event_delay_remove(as_event_loop* event_loop, as_event_command* cmd)
+{
+	as_event_delay_lane* lane = &event_loop->delay_queue[cmd->priority];
+
+	if (cmd->delay_prev) {
+		cmd->delay_prev->delay_next = cmd->delay_next;
+	}
+	else {
+		lane->head = cmd->delay_next;
+	}
+
+	if (cmd->delay_next) {
+		cmd->delay_next->delay_prev = cmd->delay_prev;
+	}
+	else {
+		lane->tail = cmd->delay_prev;
+	}
+	cmd->delay_prev = NULL;
+	cmd->delay_next = NULL;
+	lane->size--;
+	event_loop->delay_size--;
+}
+
+static inline bool
+as_event_busy_poll(as_event_loop* event_loop, uint64_t* activity, uint64_t* idle_begin)
+{
+	// Return true if the event loop thread should poll again without blocking.  Counters are
+	// only modified in the event loop thread, so they are a cheap activity signal.
+	uint64_t a = event_loop->counters.commands + event_loop->counters.bytes_in;
+	uint64_t now = cf_getns();
+
+	if (a != *activity) {
+		*activity = a;
+		*idle_begin = now;
+		return true;
+	}
+	return now - *idle_begin < (uint64_t)event_loop->busy_poll_us * 1000;
+}
+
+static inline void
+as_event_set_busy_poll(as_event_loop* event_loop, as_socket_fd fd)
+{
+	// Failure only means the connection is served without busy polling.
+	if (event_loop->socket_busy_poll > 0) {
+		as_socket_set_busy_poll(fd, event_loop->socket_busy_poll);
+	}
+}
+
+static inline as_event_command*
+as_event_delay_pop(as_event_loop* event_loop)
+{
+	// Weighted round-robin: interactive 4, normal 2, bulk 1.  Empty lanes are skipped, so a
+	// lane gets the full event loop when the other lanes are idle.
+	static const uint8_t schedule[] = {
+		AS_POLICY_PRIORITY_INTERACTIVE, AS_POLICY_PRIORITY_NORMAL,
+		AS_POLICY_PRIORITY_INTERACTIVE, AS_POLICY_PRIORITY_BULK,
+		AS_POLICY_PRIORITY_INTERACTIVE, AS_POLICY_PRIORITY_NORMAL,
+		AS_POLICY_PRIORITY_INTERACTIVE
+	};
+	const uint32_t schedule_size = sizeof(schedule) / sizeof(schedule[0]);
+
+	if (event_loop->delay_size == 0) {
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < schedule_size; i++) {
+		uint32_t pos = (event_loop->delay_cursor + i) % schedule_size;
+		as_event_command* cmd = event_loop->delay_queue[schedule[pos]].head;
+
+		if (cmd) {
+			event_loop->delay_cursor = (pos + 1) % schedule_size;
+			as_event_delay_remove(event_loop, cmd);
+			return cmd;
+		}
+	}
+	return NULL;
+}
+
+static inline void
+as_event_flow_record(as_event_executor* executor)
+{
+	if (executor->flow) {
+		as_incr_uint32(&executor->flow->buffered);
+	}
+}
+
+static inline void
+as_event_flow_check(as_event_command* cmd, as_event_executor* executor)
+{
+	// Called after a scan/query response block has been parsed and the command expects
+	// more blocks.
+	as_async_flow* flow = executor->flow;
+
+	if (flow && as_load_uint32(&flow->buffered) >= flow->high_watermark) {
+		as_async_flow_pause(cmd);
+	}
 }
 
 static inline void
 as_event_loop_destroy(as_event_loop* event_loop)
 {
-	as_queue_destroy(&event_loop->queue);
-	as_queue_destroy(&event_loop->delay_queue);
+	as_mpsc_queue_destroy(&event_loop->queue);
 	as_queue_destroy(&event_loop->pipe_cb_queue);
-	pthread_mutex_destroy(&event_loop->lock);
+	as_event_slab_destroy(&event_loop->slab);
+	as_event_buffer_pool_destroy(&event_loop->buffer_pool);
+	as_event_wheel_destroy(event_loop);
+	as_event_lag_destroy(event_loop);
+	as_auto_batch_destroy(event_loop);
 }
 
 #ifdef __cplusplus
@@ -141,6 +141,8 @@ typedef enum {
 	_AS_EXP_CODE_VAL_BYTES,
 	_AS_EXP_CODE_VAL_RAWSTR,
 	_AS_EXP_CODE_VAL_RTYPE,
+	_AS_EXP_CODE_VAL_PARAM_INT,
+	_AS_EXP_CODE_VAL_PARAM_FLOAT,
 
 	_AS_EXP_CODE_CALL_VOP_START,
 	_AS_EXP_CODE_CDT_LIST_CRMOD,
@@ -204,7 +206,99 @@ typedef struct {
 	} v;
 } as_exp_entry;
 
+/**
+ * Literal value that replaces a parameter placeholder in as_exp_compile_cached().
+ * Set int_val for as_exp_param_int() and float_val for as_exp_param_float().
+ *
+ * @ingroup expression
+ */
+typedef union {
+	int64_t int_val;
+	double float_val;
+} as_exp_param;
+
 AS_EXTERN as_exp* as_exp_compile(as_exp_entry* table, uint32_t n);
+
+/**
+ * Compile expression through a process wide cache keyed by the content of the entry table.
+ * Parameter placeholders are excluded from the key and are patched with params[index] in a
+ * copy of the cached expression. An expression without placeholders is shared with the cache.
+ * Geojson values created by the table are destroyed as in as_exp_compile().
+ *
+ * The returned expression is reference counted and must be released with as_exp_release().
+ * Returns NULL if the table does not compile or a placeholder index is not less than n_params.
+ *
+ * @ingroup expression
+ */
+AS_EXTERN as_exp*
+as_exp_compile_cached(
+	as_exp_entry* table, uint32_t n, const as_exp_param* params, uint32_t n_params
+	);
+
+/**
+ * Release expression returned by as_exp_compile_cached().
+ *
+ * @ingroup expression
+ */
+AS_EXTERN void as_exp_release(as_exp* exp);
+
+/**
+ * Expression compiled once with parameter placeholders. Values are bound per command with
+ * as_exp_bind() or as_exp_rebind().
+ *
+ * @ingroup expression
+ */
+typedef struct as_exp_template_s as_exp_template;
+
+/**
+ * Compile expression that contains as_exp_param_int() or as_exp_param_float() placeholders.
+ * The template must be destroyed with as_exp_template_destroy().
+ * Returns NULL if the table does not compile.
+ *
+ * @ingroup expression
+ */
+AS_EXTERN as_exp_template* as_exp_compile_template(as_exp_entry* table, uint32_t n);
+
+/**
+ * Copy template expression and write params[index] into each placeholder. The returned
+ * expression must be destroyed with as_exp_destroy().
+ * Returns NULL if a placeholder index is not less than n_params.
+ *
+ * @ingroup expression
+ */
+AS_EXTERN as_exp*
+as_exp_bind(const as_exp_template* tmpl, const as_exp_param* params, uint32_t n_params);
+
+/**
+ * Overwrite the placeholders of an expression returned by as_exp_bind() for the same template.
+ * Only the 8 byte placeholder values are written. The expression must not be in use by a
+ * command while it is rebound.
+ * Returns false if exp does not match the template or a placeholder index is not less than
+ * n_params.
+ *
+ * @ingroup expression
+ */
+AS_EXTERN bool
+as_exp_rebind(
+	const as_exp_template* tmpl, as_exp* exp, const as_exp_param* params, uint32_t n_params
+	);
+
+/**
+ * Destroy template.
+ *
+ * @ingroup expression
+ */
+AS_EXTERN void as_exp_template_destroy(as_exp_template* tmpl);
+
+/**
+ * Release the cache's references to compiled expressions. Expressions still held by callers
+ * remain valid until they are released. Must not be called concurrently with
+ * as_exp_compile_cached().
+ *
+ * @ingroup expression
+ */
+AS_EXTERN void as_exp_cache_clear(void);
+
 AS_EXTERN char* as_exp_compile_b64(as_exp* exp);
 AS_EXTERN void as_exp_destroy(as_exp* exp);
 AS_EXTERN void as_exp_destroy_b64(char* b64);
@@ -272,6 +366,27 @@ AS_EXTERN int64_t as_exp_get_map_type(as_exp_type type, as_map_return_type rtype
  */
 #define as_exp_float(__val) {.op=_AS_EXP_CODE_VAL_FLOAT, .v.float_val=__val}
 
+/**
+ * Create 64 bit signed integer parameter placeholder for as_exp_compile_cached() and
+ * as_exp_compile_template().
+ * The placeholder is always packed in 9 bytes so cached copies can be patched in place.
+ * as_exp_compile() packs the placeholder as zero.
+ *
+ * @param __index		index of the value in the params array.
+ * @ingroup expression
+ */
+#define as_exp_param_int(__index) {.op=_AS_EXP_CODE_VAL_PARAM_INT, .sz=__index}
+
+/**
+ * Create 64 bit floating point parameter placeholder for as_exp_compile_cached() and
+ * as_exp_compile_template().
+ * as_exp_compile() packs the placeholder as zero.
+ *
+ * @param __index		index of the value in the params array.
+ * @ingroup expression
+ */
+#define as_exp_param_float(__index) {.op=_AS_EXP_CODE_VAL_PARAM_FLOAT, .sz=__index}
+
 /**
  * Create string value.
  *
@@ -297,6 +412,16 @@ AS_EXTERN int64_t as_exp_get_map_type(as_exp_type type, as_map_return_type rtype
  */
 #define as_exp_geo(__val) {.op=_AS_EXP_CODE_VAL_GEO, .v.val=(as_val*)as_geojson_new(__val, false)}
 
+/**
+ * Create geojson value from a prepared as_geo_region.  Unlike as_exp_geo(), no value is
+ * allocated and the region is only read, so one region can build expressions on many
+ * threads.
+ *
+ * @param __region		as_geo_region pointer.
+ * @ingroup expression
+ */
+#define as_exp_geo_region(__region) {.op=_AS_EXP_CODE_AS_VAL, .v.val=(as_val*)&(__region)->geojson}
+
 /**
  * Create value from an as_val.
  *
@@ -3378,6 +3503,57 @@ AS_EXTERN int64_t as_exp_get_map_type(as_exp_type type, as_map_return_type rtype
 			as_exp_destroy(temp); \
 		} while (false)
 
+/**
+ * Declare and build an expression variable through the compiled expression cache.
+ *
+ * ~~~~~~~~~~{.c}
+ * // a == ?
+ * as_exp_param params[1] = {{.int_val = 10}};
+ * as_exp_build_cached(expression, params, 1,
+ *     as_exp_cmp_eq(as_exp_bin_int("a"), as_exp_param_int(0)));
+ * ...
+ * as_exp_release(expression);
+ * ~~~~~~~~~~
+ *
+ * @param __name			Name of the variable to hold the expression
+ * @param __params			Parameter values. May be NULL if there are no placeholders.
+ * @param __n_params		Number of parameter values
+ * @ingroup expression
+ */
+#define as_exp_build_cached(__name, __params, __n_params, ...) \
+		as_exp* __name; \
+		do { \
+			as_exp_entry __table__[] = { __VA_ARGS__ }; \
+			__name = as_exp_compile_cached(__table__, sizeof(__table__) / sizeof(as_exp_entry), \
+				__params, __n_params); \
+		} while (false)
+
+/**
+ * Declare and build an expression template variable.
+ *
+ * ~~~~~~~~~~{.c}
+ * // ts > ?
+ * as_exp_build_template(tmpl,
+ *     as_exp_cmp_gt(as_exp_bin_int("ts"), as_exp_param_int(0)));
+ * ...
+ * as_exp_param params[1] = {{.int_val = now}};
+ * as_exp* filter = as_exp_bind(tmpl, params, 1);
+ * ...
+ * as_exp_destroy(filter);
+ * as_exp_template_destroy(tmpl);
+ * ~~~~~~~~~~
+ *
+ * @param __name			Name of the variable to hold the template
+ * @ingroup expression
+ */
+#define as_exp_build_template(__name, ...) \
+		as_exp_template* __name; \
+		do { \
+			as_exp_entry __table__[] = { __VA_ARGS__ }; \
+			__name = as_exp_compile_template(__table__, \
+				sizeof(__table__) / sizeof(as_exp_entry)); \
+		} while (false)
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
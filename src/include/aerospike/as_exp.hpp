@@ -0,0 +1,706 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @file as_exp.hpp
+ *
+ * Optional C++17 builders that pack constant expressions and fixed CDT operations at
+ * compile time. The results are handed to the C API without allocation.
+ *
+ * ~~~~~~~~~~{.cpp}
+ * namespace ae = aerospike::cexp;
+ *
+ * // a == 10 && ts > ?
+ * static constexpr auto filter_tmpl = ae::build(
+ *     ae::and_(
+ *         ae::cmp_eq(ae::bin_int("a"), ae::int_val(10)),
+ *         ae::cmp_gt(ae::bin_int("ts"), ae::param_int(0))));
+ *
+ * auto filter = filter_tmpl;
+ * filter.bind_int(0, now);
+ *
+ * as_policy_read p;
+ * as_policy_read_init(&p);
+ * p.base.filter_exp = filter.get();
+ *
+ * static constexpr auto size_op = ae::list_size();
+ * ae::add(&ops, "list", size_op);
+ * ~~~~~~~~~~
+ *
+ * Parameter placeholders have the same fixed width format as as_exp_param_int() and
+ * as_exp_param_float(). Floating point literals require C++20 std::bit_cast.
+ */
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L))
+#error "as_exp.hpp requires C++17"
+#endif
+
+#include <aerospike/as_bin.h>
+#include <aerospike/as_exp.h>
+#include <aerospike/as_operations.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__has_include)
+#if __has_include(<bit>)
+#include <bit>
+#endif
+#endif
+
+namespace aerospike {
+namespace cexp {
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Packed msgpack bytes of an expression or value. N is the maximum size and S is the maximum
+ * number of parameter placeholders.
+ */
+template<std::size_t N, std::size_t S = 0>
+struct node {
+	static constexpr std::size_t capacity = N;
+	static constexpr std::size_t max_slots = S;
+
+	std::uint8_t data[N > 0 ? N : 1] = {};
+	std::uint32_t size = 0;
+	std::uint32_t slot_offset[S + 1] = {};
+	std::uint32_t slot_index[S + 1] = {};
+	std::uint32_t n_slots = 0;
+
+	constexpr void
+	push(std::uint8_t b)
+	{
+		data[size++] = b;
+	}
+
+	constexpr void
+	push_be(std::uint64_t v, std::uint32_t n_bytes)
+	{
+		for (std::uint32_t i = n_bytes; i > 0; i--) {
+			push(static_cast<std::uint8_t>(v >> ((i - 1) * 8)));
+		}
+	}
+
+	template<std::size_t N2, std::size_t S2>
+	constexpr void
+	append(const node<N2, S2>& other)
+	{
+		for (std::uint32_t i = 0; i < other.n_slots; i++) {
+			slot_offset[n_slots] = size + other.slot_offset[i];
+			slot_index[n_slots] = other.slot_index[i];
+			n_slots++;
+		}
+
+		for (std::uint32_t i = 0; i < other.size; i++) {
+			push(other.data[i]);
+		}
+	}
+};
+
+/**
+ * Expression with the same layout prefix as as_exp. Copy the object to bind parameter values
+ * per command.
+ */
+template<std::size_t N, std::size_t S>
+struct packed_exp {
+	std::uint32_t packed_sz = 0;
+	std::uint8_t packed[N > 0 ? N : 1] = {};
+	std::uint32_t slot_offset[S + 1] = {};
+	std::uint32_t slot_index[S + 1] = {};
+	std::uint32_t n_slots = 0;
+
+	/**
+	 * Expression to assign to policy filter_exp. Valid while this object exists.
+	 */
+	as_exp*
+	get() const noexcept
+	{
+		return reinterpret_cast<as_exp*>(const_cast<packed_exp*>(this));
+	}
+
+	/**
+	 * Write integer value into placeholders created by param_int(index).
+	 */
+	void
+	bind_int(std::uint32_t index, std::int64_t value) noexcept
+	{
+		bind_bits(index, static_cast<std::uint64_t>(value));
+	}
+
+	/**
+	 * Write floating point value into placeholders created by param_float(index).
+	 */
+	void
+	bind_float(std::uint32_t index, double value) noexcept
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		bind_bits(index, bits);
+	}
+
+	void
+	bind_bits(std::uint32_t index, std::uint64_t bits) noexcept
+	{
+		for (std::uint32_t i = 0; i < n_slots; i++) {
+			if (slot_index[i] == index) {
+				std::uint8_t* p = packed + slot_offset[i];
+
+				for (std::uint32_t j = 0; j < 8; j++) {
+					p[j] = static_cast<std::uint8_t>(bits >> (56 - j * 8));
+				}
+			}
+		}
+	}
+};
+
+typedef packed_exp<1, 0> packed_exp_layout;
+
+static_assert(offsetof(packed_exp_layout, packed) == sizeof(as_exp),
+	"packed_exp must match as_exp layout");
+
+/**
+ * CDT, map or bit operation packed in the server's operation format.
+ */
+template<std::size_t N>
+struct packed_op {
+	as_operator op_type = AS_OPERATOR_READ;
+	std::uint32_t size = 0;
+	std::uint8_t data[N > 0 ? N : 1] = {};
+};
+
+/******************************************************************************
+ * PACKING
+ *****************************************************************************/
+
+namespace detail {
+
+constexpr node<9>
+pack_uint(std::uint64_t v)
+{
+	node<9> r;
+
+	if (v < 128) {
+		r.push(static_cast<std::uint8_t>(v));
+	}
+	else if (v < 256) {
+		r.push(0xcc);
+		r.push_be(v, 1);
+	}
+	else if (v < 65536) {
+		r.push(0xcd);
+		r.push_be(v, 2);
+	}
+	else if (v < 4294967296ULL) {
+		r.push(0xce);
+		r.push_be(v, 4);
+	}
+	else {
+		r.push(0xcf);
+		r.push_be(v, 8);
+	}
+	return r;
+}
+
+constexpr node<9>
+pack_int(std::int64_t v)
+{
+	if (v >= 0) {
+		return pack_uint(static_cast<std::uint64_t>(v));
+	}
+
+	node<9> r;
+	std::uint64_t u = static_cast<std::uint64_t>(v);
+
+	if (v >= -32) {
+		r.push(static_cast<std::uint8_t>(u));
+	}
+	else if (v >= INT8_MIN) {
+		r.push(0xd0);
+		r.push_be(u, 1);
+	}
+	else if (v >= INT16_MIN) {
+		r.push(0xd1);
+		r.push_be(u, 2);
+	}
+	else if (v >= INT32_MIN) {
+		r.push(0xd2);
+		r.push_be(u, 4);
+	}
+	else {
+		r.push(0xd3);
+		r.push_be(u, 8);
+	}
+	return r;
+}
+
+constexpr node<5>
+pack_list_header(std::uint32_t n)
+{
+	node<5> r;
+
+	if (n < 16) {
+		r.push(static_cast<std::uint8_t>(0x90 | n));
+	}
+	else if (n < 65536) {
+		r.push(0xdc);
+		r.push_be(n, 2);
+	}
+	else {
+		r.push(0xdd);
+		r.push_be(n, 4);
+	}
+	return r;
+}
+
+// Same string header choices as as_pack_str(), which does not use str8.
+template<std::size_t L>
+constexpr node<L + 6>
+pack_str(const char (&s)[L], bool with_type)
+{
+	node<L + 6> r;
+	std::uint32_t len = static_cast<std::uint32_t>(L - 1) + (with_type ? 1 : 0);
+
+	if (len < 32) {
+		r.push(static_cast<std::uint8_t>(0xa0 | len));
+	}
+	else if (len < 65536) {
+		r.push(0xda);
+		r.push_be(len, 2);
+	}
+	else {
+		r.push(0xdb);
+		r.push_be(len, 4);
+	}
+
+	if (with_type) {
+		r.push(AS_BYTES_STRING);
+	}
+
+	for (std::size_t i = 0; i + 1 < L; i++) {
+		r.push(static_cast<std::uint8_t>(s[i]));
+	}
+	return r;
+}
+
+template<class... T>
+constexpr auto
+concat(const T&... parts)
+{
+	node<(std::size_t(0) + ... + T::capacity), (std::size_t(0) + ... + T::max_slots)> r;
+	(r.append(parts), ...);
+	return r;
+}
+
+// Expression call: [op, args...]
+template<class... T>
+constexpr auto
+op(std::int64_t code, const T&... args)
+{
+	return concat(pack_list_header(1 + sizeof...(args)), pack_int(code), args...);
+}
+
+template<std::size_t L>
+constexpr auto
+bin(std::int64_t type, const char (&name)[L])
+{
+	static_assert(L <= AS_BIN_NAME_MAX_SIZE, "bin name too long");
+	return op(_AS_EXP_CODE_BIN, pack_int(type), pack_str(name, false));
+}
+
+// Operation without context: 16 bit big endian command followed by the argument list.
+template<class... T>
+constexpr auto
+cdt(as_operator op_type, std::uint16_t command, const T&... args)
+{
+	static_assert((std::size_t(0) + ... + T::max_slots) == 0,
+		"operations do not support parameter placeholders");
+
+	node<2 + 5 + (std::size_t(0) + ... + T::capacity)> body;
+	body.push_be(command, 2);
+
+	// Operations without arguments have no argument list.
+	if constexpr (sizeof...(args) > 0) {
+		body.append(pack_list_header(sizeof...(args)));
+		(body.append(args), ...);
+	}
+
+	packed_op<decltype(body)::capacity> r;
+	r.op_type = op_type;
+
+	for (std::uint32_t i = 0; i < body.size; i++) {
+		r.data[r.size++] = body.data[i];
+	}
+	return r;
+}
+
+} // namespace detail
+
+/******************************************************************************
+ * BUILD
+ *****************************************************************************/
+
+/**
+ * Convert packed node into an expression that can be handed to the C API.
+ */
+template<std::size_t N, std::size_t S>
+constexpr packed_exp<N, S>
+build(const node<N, S>& n)
+{
+	packed_exp<N, S> r;
+	r.packed_sz = n.size;
+
+	for (std::uint32_t i = 0; i < n.size; i++) {
+		r.packed[i] = n.data[i];
+	}
+
+	for (std::uint32_t i = 0; i < n.n_slots; i++) {
+		r.slot_offset[i] = n.slot_offset[i];
+		r.slot_index[i] = n.slot_index[i];
+	}
+	r.n_slots = n.n_slots;
+	return r;
+}
+
+/******************************************************************************
+ * VALUES
+ *****************************************************************************/
+
+constexpr auto
+int_val(std::int64_t v)
+{
+	return detail::pack_int(v);
+}
+
+constexpr auto
+uint_val(std::uint64_t v)
+{
+	return detail::pack_uint(v);
+}
+
+constexpr auto
+bool_val(bool v)
+{
+	node<1> r;
+	r.push(v ? 0xc3 : 0xc2);
+	return r;
+}
+
+constexpr auto
+nil()
+{
+	node<1> r;
+	r.push(0xc0);
+	return r;
+}
+
+template<std::size_t L>
+constexpr auto
+str_val(const char (&s)[L])
+{
+	return detail::pack_str(s, true);
+}
+
+#if defined(__cpp_lib_bit_cast)
+constexpr auto
+float_val(double v)
+{
+	node<9> r;
+	r.push(0xcb);
+	r.push_be(std::bit_cast<std::uint64_t>(v), 8);
+	return r;
+}
+#endif
+
+/**
+ * Fixed width integer placeholder. Bind with packed_exp::bind_int().
+ */
+constexpr auto
+param_int(std::uint32_t index)
+{
+	node<9, 1> r;
+	r.slot_offset[0] = 1;
+	r.slot_index[0] = index;
+	r.n_slots = 1;
+	r.push(0xd3);
+	r.push_be(0, 8);
+	return r;
+}
+
+/**
+ * Fixed width floating point placeholder. Bind with packed_exp::bind_float().
+ */
+constexpr auto
+param_float(std::uint32_t index)
+{
+	node<9, 1> r;
+	r.slot_offset[0] = 1;
+	r.slot_index[0] = index;
+	r.n_slots = 1;
+	r.push(0xcb);
+	r.push_be(0, 8);
+	return r;
+}
+
+/******************************************************************************
+ * RECORD AND BIN EXPRESSIONS
+ *****************************************************************************/
+
+template<std::size_t L>
+constexpr auto
+bin_int(const char (&name)[L])
+{
+	return detail::bin(AS_EXP_TYPE_INT, name);
+}
+
+template<std::size_t L>
+constexpr auto
+bin_float(const char (&name)[L])
+{
+	return detail::bin(AS_EXP_TYPE_FLOAT, name);
+}
+
+template<std::size_t L>
+constexpr auto
+bin_str(const char (&name)[L])
+{
+	return detail::bin(AS_EXP_TYPE_STR, name);
+}
+
+template<std::size_t L>
+constexpr auto
+bin_bool(const char (&name)[L])
+{
+	return detail::bin(AS_EXP_TYPE_BOOL, name);
+}
+
+template<std::size_t L>
+constexpr auto
+bin_type(const char (&name)[L])
+{
+	static_assert(L <= AS_BIN_NAME_MAX_SIZE, "bin name too long");
+	return detail::op(_AS_EXP_CODE_BIN_TYPE, detail::pack_str(name, false));
+}
+
+template<std::size_t L>
+constexpr auto
+bin_exists(const char (&name)[L])
+{
+	return detail::op(_AS_EXP_CODE_CMP_NE, bin_type(name), int_val(AS_BYTES_UNDEF));
+}
+
+constexpr auto
+key_int()
+{
+	return detail::op(_AS_EXP_CODE_KEY, int_val(AS_EXP_TYPE_INT));
+}
+
+constexpr auto
+key_str()
+{
+	return detail::op(_AS_EXP_CODE_KEY, int_val(AS_EXP_TYPE_STR));
+}
+
+constexpr auto
+key_exist()
+{
+	return detail::op(_AS_EXP_CODE_KEY_EXIST);
+}
+
+constexpr auto
+set_name()
+{
+	return detail::op(_AS_EXP_CODE_SET_NAME);
+}
+
+constexpr auto
+device_size()
+{
+	return detail::op(_AS_EXP_CODE_DEVICE_SIZE);
+}
+
+constexpr auto
+last_update()
+{
+	return detail::op(_AS_EXP_CODE_LAST_UPDATE);
+}
+
+constexpr auto
+since_update()
+{
+	return detail::op(_AS_EXP_CODE_SINCE_UPDATE);
+}
+
+constexpr auto
+void_time()
+{
+	return detail::op(_AS_EXP_CODE_VOID_TIME);
+}
+
+constexpr auto
+ttl()
+{
+	return detail::op(_AS_EXP_CODE_TTL);
+}
+
+constexpr auto
+is_tombstone()
+{
+	return detail::op(_AS_EXP_CODE_IS_TOMBSTONE);
+}
+
+constexpr auto
+digest_modulo(std::int64_t mod)
+{
+	return detail::op(_AS_EXP_CODE_DIGEST_MODULO, int_val(mod));
+}
+
+/******************************************************************************
+ * COMPARISON AND LOGICAL EXPRESSIONS
+ *****************************************************************************/
+
+template<class L, class R>
+constexpr auto
+cmp_eq(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_EQ, left, right);
+}
+
+template<class L, class R>
+constexpr auto
+cmp_ne(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_NE, left, right);
+}
+
+template<class L, class R>
+constexpr auto
+cmp_gt(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_GT, left, right);
+}
+
+template<class L, class R>
+constexpr auto
+cmp_ge(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_GE, left, right);
+}
+
+template<class L, class R>
+constexpr auto
+cmp_lt(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_LT, left, right);
+}
+
+template<class L, class R>
+constexpr auto
+cmp_le(const L& left, const R& right)
+{
+	return detail::op(_AS_EXP_CODE_CMP_LE, left, right);
+}
+
+template<class... T>
+constexpr auto
+and_(const T&... exps)
+{
+	return detail::op(_AS_EXP_CODE_AND, exps...);
+}
+
+template<class... T>
+constexpr auto
+or_(const T&... exps)
+{
+	return detail::op(_AS_EXP_CODE_OR, exps...);
+}
+
+template<class T>
+constexpr auto
+not_(const T& exp)
+{
+	return detail::op(_AS_EXP_CODE_NOT, exp);
+}
+
+/******************************************************************************
+ * OPERATIONS
+ *****************************************************************************/
+
+// Command codes of as_list_operations.c and as_map_operations.c.
+constexpr std::uint16_t LIST_APPEND = 1;
+constexpr std::uint16_t LIST_SIZE = 16;
+constexpr std::uint16_t LIST_GET = 17;
+constexpr std::uint16_t LIST_GET_BY_INDEX = 19;
+constexpr std::uint16_t MAP_SIZE = 96;
+constexpr std::uint16_t MAP_GET_BY_KEY = 97;
+
+template<class V>
+constexpr auto
+list_append(const V& value)
+{
+	return detail::cdt(AS_OPERATOR_CDT_MODIFY, LIST_APPEND, value);
+}
+
+constexpr auto
+list_size()
+{
+	return detail::cdt(AS_OPERATOR_CDT_READ, LIST_SIZE);
+}
+
+constexpr auto
+list_get(std::int64_t index)
+{
+	return detail::cdt(AS_OPERATOR_CDT_READ, LIST_GET, int_val(index));
+}
+
+constexpr auto
+list_get_by_index(std::int64_t index, as_list_return_type return_type)
+{
+	return detail::cdt(AS_OPERATOR_CDT_READ, LIST_GET_BY_INDEX,
+		uint_val(static_cast<std::uint64_t>(return_type)), int_val(index));
+}
+
+constexpr auto
+map_size()
+{
+	return detail::cdt(AS_OPERATOR_MAP_READ, MAP_SIZE);
+}
+
+template<class K>
+constexpr auto
+map_get_by_key(const K& key, as_map_return_type return_type)
+{
+	return detail::cdt(AS_OPERATOR_MAP_READ, MAP_GET_BY_KEY,
+		int_val(static_cast<std::int64_t>(return_type)), key);
+}
+
+/**
+ * Append packed operation to operations. The operation must outlive ops.
+ */
+template<std::size_t N>
+inline bool
+add(as_operations* ops, const char* name, const packed_op<N>& op)
+{
+	return as_operations_add_packed(ops, name, op.op_type, op.data, op.size);
+}
+
+} // namespace cexp
+} // namespace aerospike
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup exp_eval Client-side Expression Evaluation
+ * @ingroup expression
+ *
+ * Evaluate compiled expressions against records already held by the client, such as
+ * records served from the record cache or returned by a scan.  The evaluator covers
+ * comparisons, boolean logic, arithmetic, integer bit operations, cond/let/var, bin and
+ * record metadata reads, list size/get by index and map size/get by key.
+ *
+ * Operations that need server state (regex, geo, last update time, storage size, bit and
+ * hll modules, CDT modify and most CDT reads) return AEROSPIKE_ERR_UNSUPPORTED_FEATURE.
+ * The caller should then send the expression to the server instead.  The same status is
+ * returned when client and server semantics could differ, like comparing values of
+ * different types or reading the key of a record that was returned without it.
+ */
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_exp.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Evaluate expression against a record.  On success, result is set to a new reference that
+ * must be released with as_val_destroy(), or NULL when the expression evaluates to unknown
+ * (for example, a referenced bin does not exist or has a different type).
+ *
+ * ~~~~~~~~~~{.c}
+ * as_val* val;
+ * if (as_exp_eval(&err, exp, rec, &val) == AEROSPIKE_OK && val) {
+ *     ...
+ *     as_val_destroy(val);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param err		Error detail.
+ * @param exp		Compiled expression.
+ * @param rec		Record to evaluate.
+ * @param result	Expression result or NULL if unknown.
+ *
+ * @return AEROSPIKE_OK on success, AEROSPIKE_ERR_UNSUPPORTED_FEATURE if the expression must
+ * be evaluated by the server, AEROSPIKE_ERR_PARAM if the expression is invalid.
+ *
+ * @ingroup exp_eval
+ */
+AS_EXTERN as_status
+as_exp_eval(as_error* err, const as_exp* exp, const as_record* rec, as_val** result);
+
+/**
+ * Evaluate filter expression against a record.  Like the server, a filter that evaluates
+ * to unknown does not match.
+ *
+ * ~~~~~~~~~~{.c}
+ * bool match;
+ * as_status status = as_exp_eval_filter(&err, policy.base.filter_exp, rec, &match);
+ *
+ * if (status == AEROSPIKE_ERR_UNSUPPORTED_FEATURE) {
+ *     // Read record with the filter from the server.
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param err		Error detail.
+ * @param exp		Compiled filter expression.
+ * @param rec		Record to evaluate.
+ * @param match		True if the record passes the filter.
+ *
+ * @return AEROSPIKE_OK on success, AEROSPIKE_ERR_UNSUPPORTED_FEATURE if the expression must
+ * be evaluated by the server, AEROSPIKE_ERR_PARAM if the expression is invalid or does not
+ * return a boolean.
+ *
+ * @ingroup exp_eval
+ */
+AS_EXTERN as_status
+as_exp_eval_filter(as_error* err, const as_exp* exp, const as_record* rec, bool* match);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
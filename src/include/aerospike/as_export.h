@@ -0,0 +1,188 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup export_operations Export Operations
+ * @ingroup scan_operations
+ *
+ * Parallel scan export to files. The partition range is split between writers. Each
+ * writer runs its own partition scan on a dedicated thread and streams records to its
+ * own file, so writers never share a lock.
+ *
+ * Files are named "<dir>/export-<writer>.dat" and contain:
+ *
+ *     header:  magic "ASEX"(4) version(1) flags(1) reserved(2)
+ *     block:   stored_size(4) raw_size(4) data[stored_size]
+ *     record:  size(4) digest(20) gen(2) ttl(4) n_bins(2) bins
+ *
+ * Integers are big endian. Blocks are zlib compressed when flags has bit 0 set. Bins
+ * are stored in wire format and can be read with as_record_raw_iterator.
+ *
+ * After each block, the writer updates "<dir>/export-<writer>.manifest" with the file
+ * size and the last digest of each partition, so an interrupted export can be resumed.
+ */
+
+#include <aerospike/aerospike_scan.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Export configuration.
+ *
+ * @ingroup export_operations
+ */
+typedef struct as_export_config_s {
+	/**
+	 * Existing output directory.
+	 */
+	const char* dir;
+
+	/**
+	 * Number of writers. Each writer scans an equal partition range into its own file.
+	 * Zero uses one writer per cluster node.
+	 *
+	 * Default: 0
+	 */
+	uint32_t n_writers;
+
+	/**
+	 * Block size in bytes, rounded up to a multiple of 4KB. Blocks are written with one
+	 * aligned write each. Records larger than a block get a block of their own.
+	 *
+	 * Default: 1MB
+	 */
+	uint32_t block_size;
+
+	/**
+	 * Compress blocks with zlib.
+	 *
+	 * Default: false
+	 */
+	bool compress;
+
+	/**
+	 * Continue an interrupted export in dir. Writers with a completed manifest are
+	 * skipped. Other writers truncate their file to the manifest size and scan from the
+	 * last exported digest of each partition. Writers without a manifest start over.
+	 *
+	 * Default: false
+	 */
+	bool resume;
+} as_export_config;
+
+/**
+ * Export statistics.
+ *
+ * @ingroup export_operations
+ */
+typedef struct as_export_stats_s {
+	/**
+	 * Records in all files, including records exported before resume.
+	 */
+	uint64_t records;
+
+	/**
+	 * Bytes in all files, including bytes exported before resume.
+	 */
+	uint64_t bytes;
+} as_export_stats;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize export configuration to default values.
+ *
+ * @ingroup export_operations
+ */
+static inline void
+as_export_config_init(as_export_config* config, const char* dir)
+{
+	config->dir = dir;
+	config->n_writers = 0;
+	config->block_size = 1024 * 1024;
+	config->compress = false;
+	config->resume = false;
+}
+
+/**
+ * Export records of a scan to files. The scan must not use apply_each or ops. The
+ * policy's checkpoint_file and parse_threads are ignored, because writers keep their
+ * own manifests. The policy's max_records applies to each writer.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_scan scan;
+ * as_scan_init(&scan, "test", "demo");
+ *
+ * as_export_config config;
+ * as_export_config_init(&config, "/data/export");
+ * config.compress = true;
+ *
+ * as_export_stats stats;
+ *
+ * if (aerospike_scan_export(&as, &err, NULL, &scan, &config, &stats) != AEROSPIKE_OK) {
+ *     // Run again with config.resume = true to continue.
+ * }
+ * as_scan_destroy(&scan);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for writer scans. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param config		Export configuration.
+ * @param stats			Export statistics. May be NULL.
+ *
+ * @return AEROSPIKE_OK if all writers completed. Otherwise the first writer error.
+ *
+ * @ingroup export_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_export(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	const as_export_config* config, as_export_stats* stats
+	);
+
+/**
+ * Read records of an export file. The callback is called for each record and with a
+ * NULL record after the last record. Records are only valid until the callback returns.
+ *
+ * @param path			Export file.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param callback		The function to be called for each record.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup export_operations
+ */
+AS_EXTERN as_status
+as_export_read(
+	const char* path, as_error* err, aerospike_scan_foreach_raw_callback callback, void* udata
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
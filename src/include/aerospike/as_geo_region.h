@@ -0,0 +1,104 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_geojson.h>
+#include <aerospike/as_status.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * GeoJSON region that is validated and serialized once, so it can be reused by many
+ * geospatial queries and expressions.  The region is immutable after
+ * as_geo_region_init() and may be shared between threads until as_geo_region_destroy()
+ * is called.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_geo_region region;
+ *
+ * if (as_geo_region_init(&region, &err, "{\"type\":\"AeroCircle\",\"coordinates\":[[-122.0, 37.5], 1000]}") != AEROSPIKE_OK) {
+ *     return err.code;
+ * }
+ *
+ * as_query_where(&query, "loc", as_geo_within_region(&region));
+ * ~~~~~~~~~~
+ *
+ * @ingroup query_object
+ */
+typedef struct as_geo_region_s {
+	/**
+	 * GeoJSON value that references the region's copy of the json string.
+	 * Read only.  Never destroy this value.
+	 */
+	as_geojson geojson;
+
+	/**
+	 * @private
+	 * Serialized query filter range: particle type, begin length, json, end length, json.
+	 */
+	uint8_t* range;
+
+	/**
+	 * @private
+	 * Size of serialized query filter range.
+	 */
+	uint32_t range_size;
+
+	/**
+	 * Length of json string.
+	 */
+	uint32_t len;
+} as_geo_region;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Validate GeoJSON and initialize region with a copy of it.  The region type must be
+ * Point, Polygon, MultiPolygon or AeroCircle.  Validation is structural only, so the
+ * server may still reject coordinates that are out of range.
+ *
+ * @param region	Region to initialize.
+ * @param err		Error detail on failure.
+ * @param json		GeoJSON string.
+ *
+ * @return AEROSPIKE_OK on success or AEROSPIKE_ERR_GEO_INVALID_GEOJSON.
+ * @relates as_geo_region
+ */
+AS_EXTERN as_status
+as_geo_region_init(as_geo_region* region, as_error* err, const char* json);
+
+/**
+ * Release region resources.  Queries and expressions that reference the region must no
+ * longer be in use.  Compiled expressions hold their own copy and are not affected.
+ *
+ * @relates as_geo_region
+ */
+AS_EXTERN void
+as_geo_region_destroy(as_geo_region* region);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup hll_local HyperLogLog Client Estimates
+ * @ingroup hll_operations
+ *
+ * Estimate HLL cardinalities locally from HLL bin values that were already read, for example
+ * with one batch read of many keys. Results approximate the server's HLL read operations
+ * without a server round trip per bin.
+ *
+ * All HLL values passed to one call must have the same index and min hash bit counts.
+ * Values with different bit counts must be folded on the server first. See
+ * as_operations_hll_fold().
+ *
+ * ~~~~~~~~~~{.c}
+ * const as_bytes* hlls[2];
+ * hlls[0] = as_record_get_bytes(batch_rec1, "hll");
+ * hlls[1] = as_record_get_bytes(batch_rec2, "hll");
+ *
+ * uint64_t count;
+ * if (as_hll_union_count(&err, hlls, 2, &count) != AEROSPIKE_OK) {
+ *     // Handle error.
+ * }
+ * ~~~~~~~~~~
+ */
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_bytes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Estimate the number of distinct values added to an HLL value.
+ *
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param hll			HLL bin value.
+ * @param count			Estimated count.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup hll_local
+ */
+AS_EXTERN as_status
+as_hll_count(as_error* err, const as_bytes* hll, uint64_t* count);
+
+/**
+ * Estimate the number of distinct values in the union of HLL values. Registers are merged
+ * 16 at a time on platforms with SSE2 or NEON.
+ *
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param hlls			HLL bin values.
+ * @param n_hlls		Number of HLL bin values.
+ * @param count			Estimated count.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup hll_local
+ */
+AS_EXTERN as_status
+as_hll_union_count(as_error* err, const as_bytes** hlls, uint32_t n_hlls, uint64_t* count);
+
+/**
+ * Estimate the number of distinct values in the intersection of HLL values. HLL values with
+ * min hash bits support any number of values. Without min hash bits, exactly two values are
+ * required and the estimate is derived from the union count.
+ *
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param hlls			HLL bin values.
+ * @param n_hlls		Number of HLL bin values.
+ * @param count			Estimated count.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup hll_local
+ */
+AS_EXTERN as_status
+as_hll_intersect_count(as_error* err, const as_bytes** hlls, uint32_t n_hlls, uint64_t* count);
+
+/**
+ * Estimate the similarity (Jaccard index) of HLL values. The similarity is between 0.0 and
+ * 1.0. Same requirements as as_hll_intersect_count().
+ *
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param hlls			HLL bin values.
+ * @param n_hlls		Number of HLL bin values.
+ * @param similarity	Estimated similarity.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ * @ingroup hll_local
+ */
+AS_EXTERN as_status
+as_hll_similarity(as_error* err, const as_bytes** hlls, uint32_t n_hlls, double* similarity);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
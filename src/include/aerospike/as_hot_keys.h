@@ -0,0 +1,131 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_key.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Maximum number of hot keys and hot partitions reported in as_cluster_stats.
+ * @ingroup cluster_stats
+ */
+#define AS_HOT_KEYS_TOP 10
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Estimated load of a frequently accessed key.  Counts are estimated from sampled single
+ * record commands and decay by half every minute, so they describe recent load.
+ * @ingroup cluster_stats
+ */
+typedef struct as_hot_key_s {
+	/**
+	 * Namespace.
+	 */
+	as_namespace ns;
+
+	/**
+	 * Key digest.
+	 */
+	as_digest_value digest;
+
+	/**
+	 * Partition id of the key.
+	 */
+	uint32_t partition_id;
+
+	/**
+	 * Estimated commands.  May be overestimated by up to error.
+	 */
+	uint64_t count;
+
+	/**
+	 * Maximum overestimation of count.
+	 */
+	uint64_t error;
+
+	/**
+	 * Estimated bytes sent and received.
+	 */
+	uint64_t bytes;
+} as_hot_key;
+
+/**
+ * @private
+ * Sampled heavy hitter sketches for keys and partitions.  Each sketch is a space-saving
+ * summary with a fixed number of counters, so memory does not grow with the key space.
+ */
+typedef struct as_hot_keys_s as_hot_keys;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create sketches with capacity counters each.  sample_rate is the number of commands
+ * represented by one sample.
+ */
+as_hot_keys*
+as_hot_keys_create(uint32_t capacity, uint32_t sample_rate);
+
+/**
+ * @private
+ * Destroy sketches.
+ */
+void
+as_hot_keys_destroy(as_hot_keys* hk);
+
+/**
+ * @private
+ * Add sampled single record command.
+ */
+void
+as_hot_keys_add(
+	as_hot_keys* hk, const char* ns, const uint8_t* digest, uint32_t partition_id,
+	uint64_t bytes
+	);
+
+/**
+ * @private
+ * Copy up to max most frequently accessed keys in descending count order.  Return number
+ * of keys copied.
+ */
+uint32_t
+as_hot_keys_top(as_hot_keys* hk, as_hot_key* keys, uint32_t max);
+
+/**
+ * @private
+ * Copy up to max most frequently accessed partitions in descending count order.  Digests of
+ * the returned entries are zero.  Return number of partitions copied.
+ */
+uint32_t
+as_hot_keys_top_partitions(as_hot_keys* hk, as_hot_key* partitions, uint32_t max);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -19,6 +19,7 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_cluster.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,38 @@ typedef struct as_name_value_s {
 	char* value;
 } as_name_value;
 
+/**
+ * Slice of an info response buffer.  The slice is not null terminated.
+ */
+typedef struct as_info_slice_s {
+	const char* ptr;
+	uint32_t len;
+} as_info_slice;
+
+/**
+ * Zero-copy reader of an info response with one "name\tvalue\n" line per command.
+ * Names and values are returned as slices into the response, which is not modified.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_info_reader reader;
+ * as_info_reader_init(&reader, response, strlen(response));
+ *
+ * as_info_slice name;
+ * as_info_slice value;
+ *
+ * while (as_info_reader_next(&reader, &name, &value)) {
+ *     if (as_info_slice_eq(&name, "partition-generation")) {
+ *         uint64_t gen;
+ *         as_info_slice_to_uint64(&value, &gen);
+ *     }
+ * }
+ * ~~~~~~~~~~
+ */
+typedef struct as_info_reader_s {
+	const char* p;
+	const char* end;
+} as_info_reader;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -61,6 +94,17 @@ as_info_command_node_async(
 	as_async_info_listener listener, void* udata, as_event_loop* event_loop
 	);
 
+/**
+ * @private
+ * Asynchronously send info command to specific node after a delay.  Must be called in the
+ * event loop thread.  The node must be reserved and is released when the command completes.
+ */
+void
+as_info_command_node_async_delay(
+	const as_policy_info* policy, as_node* node, const char* command,
+	as_async_info_listener listener, void* udata, as_event_loop* event_loop, uint32_t delay_ms
+	);
+
 /**
  * @private
  * Send info command to random node. The values must be freed by the caller on success.
@@ -123,6 +167,47 @@ as_info_parse_single_response(char *values, char **value);
 void
 as_info_parse_multi_response(char* buf, as_vector* /* <as_name_value> */ values);
 
+/**
+ * Initialize reader for info response of len bytes.
+ */
+static inline void
+as_info_reader_init(as_info_reader* reader, const char* buf, size_t len)
+{
+	reader->p = buf;
+	reader->end = buf + len;
+}
+
+/**
+ * Read next command name and value.  A command returned without a value has an empty value.
+ * Return false when the response is exhausted.
+ */
+AS_EXTERN bool
+as_info_reader_next(as_info_reader* reader, as_info_slice* name, as_info_slice* value);
+
+/**
+ * Split the next token delimited by delim off the front of slice, for example one
+ * "key=value" pair of a ';' delimited value.  Return false when the slice is exhausted.
+ */
+AS_EXTERN bool
+as_info_slice_next(as_info_slice* slice, char delim, as_info_slice* token);
+
+/**
+ * Parse unsigned decimal slice.  Return false if the slice is empty, contains other
+ * characters or overflows.
+ */
+AS_EXTERN bool
+as_info_slice_to_uint64(const as_info_slice* slice, uint64_t* value);
+
+/**
+ * Does slice equal null terminated string.
+ */
+static inline bool
+as_info_slice_eq(const as_info_slice* slice, const char* str)
+{
+	size_t len = strlen(str);
+	return slice->len == len && memcmp(slice->ptr, str, len) == 0;
+}
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
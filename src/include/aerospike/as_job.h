@@ -17,6 +17,7 @@
 #pragma once 
 
 #include <aerospike/aerospike.h>
+#include <aerospike/as_listener.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -93,6 +94,43 @@ aerospike_job_wait(
 	aerospike* as, as_error* err, const as_policy_info* policy, const char* module, uint64_t job_id,
 	uint32_t interval_ms
 	);
+
+/**
+ * Asynchronously wait for a background job to be completed by servers.  All nodes are polled
+ * in parallel on the event loop.  The first poll is sent after interval_ms and the interval
+ * doubles after each poll that finds the job still running, up to 16 times interval_ms.
+ * The listener is called once when the job has completed on all nodes or an error occurs.
+ *
+ * ~~~~~~~~~~{.c}
+ * void my_listener(as_error* err, void* udata, as_event_loop* event_loop)
+ * {
+ *     if (err) {
+ *         printf("Job wait failed: %d %s\n", err->code, err->message);
+ *     }
+ * }
+ *
+ * uint64_t job_id = 1234;
+ * aerospike_job_wait_async(&as, &err, NULL, "scan", job_id, 0, my_listener, NULL, NULL);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param module		Background module. Values: scan | query
+ * @param job_id		Job ID.
+ * @param interval_ms	First polling interval in milliseconds. If zero, 1000 ms is used.
+ * @param listener		User function to be called when the job completes.
+ * @param udata			User data to be forwarded to user callback.
+ * @param event_loop	Event loop assigned to run this wait. If NULL, an event loop will be
+ *						chosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if the wait was started. Otherwise an error occurred.
+ */
+AS_EXTERN as_status
+aerospike_job_wait_async(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* module, uint64_t job_id,
+	uint32_t interval_ms, as_async_write_listener listener, void* udata, as_event_loop* event_loop
+	);
 	
 /**
  * Check the progress of a background job running on the database. The status
@@ -228,12 +228,74 @@ typedef struct as_key_s {
 	 */
 	as_digest digest;
 
+	/**
+	 * Namespace ID returned by aerospike_namespace_id(), or zero to look up the partition
+	 * table by namespace name. An ID that does not match ns falls back to the name lookup.
+	 */
+	uint32_t ns_id;
+
 } as_key;
 
+/**
+ * Key that only references caller owned namespace, set and key value.  Nothing is copied
+ * when a view is built, so large batches of keys can be read straight from application
+ * memory.  The referenced memory must stay valid until the command that uses the view
+ * returns.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_string s;
+ * as_string_init(&s, "key1", false);
+ *
+ * as_key_view view = {
+ *     .ns = "ns",
+ *     .set = "set",
+ *     .valuep = (as_key_value*)&s
+ * };
+ * ~~~~~~~~~~
+ *
+ * @ingroup as_key_object
+ */
+typedef struct as_key_view_s {
+	/**
+	 * The namespace the key belongs to.
+	 */
+	const char* ns;
+
+	/**
+	 * The set the key belongs to.  Use an empty string for the null set.
+	 */
+	const char* set;
+
+	/**
+	 * The key value.  May be NULL when digest is set.
+	 */
+	const as_key_value* valuep;
+
+	/**
+	 * Precomputed digest of AS_DIGEST_VALUE_SIZE bytes.  If NULL, the digest is computed
+	 * from set and valuep.
+	 */
+	const uint8_t* digest;
+
+} as_key_view;
+
 /******************************************************************************
  * as_key FUNCTIONS
  *****************************************************************************/
 
+/**
+ * Set namespace ID returned by aerospike_namespace_id(), so commands with this key
+ * find the namespace partition table by index.
+ *
+ * @relates as_key
+ * @ingroup as_key_object
+ */
+static inline void
+as_key_set_namespace_id(as_key* key, uint32_t ns_id)
+{
+	key->ns_id = ns_id;
+}
+
 /**
  * Initialize a stack allocated as_key to a NULL-terminated string value.
  *
@@ -689,6 +751,49 @@ as_key_digest(as_key* key);
 AS_EXTERN as_status
 as_key_set_digest(as_error* err, as_key* key);
 
+/**
+ * Set the digest values of multiple keys.  Digests are computed several keys at a time,
+ * using SIMD lanes where the platform supports them, which is faster than calling
+ * as_key_set_digest() on each key.  Keys that already have a digest are skipped.
+ * Keys must be integer, string or blob.  Otherwise, an error is returned.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_key keys[100];
+ * ...
+ * as_key_set_digests(&err, keys, 100, sizeof(as_key));
+ * ~~~~~~~~~~
+ *
+ * @param err		Error message that is populated on error.
+ * @param keys		Pointer to the first key.
+ * @param n_keys	Number of keys.
+ * @param stride	Byte distance between consecutive keys. Use sizeof(as_key) for an
+ *					array of keys, or the element size when keys are embedded in larger
+ *					structures.
+ *
+ * @return Status code.
+ *
+ * @relates as_key
+ * @ingroup as_key_object
+ */
+AS_EXTERN as_status
+as_key_set_digests(as_error* err, as_key* keys, uint32_t n_keys, size_t stride);
+
+/**
+ * Copy or compute the digest of a key view.  Key values must be integer, string or blob.
+ * Otherwise, an error is returned.
+ *
+ * @param err		Error message that is populated on error.
+ * @param view		The key view.
+ * @param digest	Populated with the digest.
+ *
+ * @return Status code.
+ *
+ * @relates as_key_view
+ * @ingroup as_key_object
+ */
+AS_EXTERN as_status
+as_key_view_digest(as_error* err, const as_key_view* view, as_digest_value digest);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
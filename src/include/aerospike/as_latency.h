@@ -0,0 +1,173 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Number of latency histogram buckets. Bucket 0 counts commands that completed in less
+ * than one microsecond. Bucket i counts commands that completed in [2^(i-1), 2^i)
+ * microseconds. The last bucket also counts all slower commands.
+ * @ingroup cluster_stats
+ */
+#define AS_LATENCY_BUCKETS 24
+
+/**
+ * @private
+ * Number of histogram shards per node. Threads are spread across shards, so threads
+ * rarely increment the same counters.
+ */
+#define AS_LATENCY_SHARDS 8
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Command categories of latency histograms.
+ * @ingroup cluster_stats
+ */
+typedef enum as_latency_type_e {
+	AS_LATENCY_TYPE_READ,
+	AS_LATENCY_TYPE_WRITE,
+	AS_LATENCY_TYPE_BATCH,
+	AS_LATENCY_TYPE_SCAN,
+	AS_LATENCY_TYPE_QUERY,
+	AS_LATENCY_TYPE_MAX
+} as_latency_type;
+
+/**
+ * Connection phases of latency histograms. Only sync connections are measured.
+ * @ingroup cluster_stats
+ */
+typedef enum as_conn_latency_type_e {
+	/**
+	 * Time to get a connection for a command, including creating a new connection when the
+	 * pool has no idle connection.
+	 */
+	AS_CONN_LATENCY_ACQUIRE,
+
+	/**
+	 * Time until a new socket's TCP connect completes.
+	 */
+	AS_CONN_LATENCY_CONNECT,
+
+	/**
+	 * TLS handshake time of a new connection.
+	 */
+	AS_CONN_LATENCY_TLS,
+
+	/**
+	 * Authentication time of a new connection.
+	 */
+	AS_CONN_LATENCY_LOGIN,
+
+	AS_CONN_LATENCY_MAX
+} as_conn_latency_type;
+
+/**
+ * @private
+ * One shard of a node's latency histograms.
+ */
+typedef struct as_latency_shard_s {
+	uint64_t buckets[AS_LATENCY_TYPE_MAX][AS_LATENCY_BUCKETS];
+	uint64_t conn[AS_CONN_LATENCY_MAX][AS_LATENCY_BUCKETS];
+} as_latency_shard;
+
+/**
+ * @private
+ * One shard of a node's adaptive timeout histogram.
+ */
+typedef struct as_timeout_shard_s {
+	uint64_t buckets[AS_LATENCY_BUCKETS];
+} as_timeout_shard;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Return histogram bucket of elapsed microseconds.
+ */
+static inline uint32_t
+as_latency_bucket(uint64_t us)
+{
+	uint32_t bucket = 0;
+
+	while (us && bucket < AS_LATENCY_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+/**
+ * Return latency type name.
+ * @ingroup cluster_stats
+ */
+static inline const char*
+as_latency_type_name(as_latency_type type)
+{
+	switch (type) {
+		case AS_LATENCY_TYPE_READ:
+			return "read";
+		case AS_LATENCY_TYPE_WRITE:
+			return "write";
+		case AS_LATENCY_TYPE_BATCH:
+			return "batch";
+		case AS_LATENCY_TYPE_SCAN:
+			return "scan";
+		case AS_LATENCY_TYPE_QUERY:
+			return "query";
+		default:
+			return "unknown";
+	}
+}
+
+/**
+ * Return connection latency type name.
+ * @ingroup cluster_stats
+ */
+static inline const char*
+as_conn_latency_type_name(as_conn_latency_type type)
+{
+	switch (type) {
+		case AS_CONN_LATENCY_ACQUIRE:
+			return "acquire";
+		case AS_CONN_LATENCY_CONNECT:
+			return "connect";
+		case AS_CONN_LATENCY_TLS:
+			return "tls";
+		case AS_CONN_LATENCY_LOGIN:
+			return "login";
+		default:
+			return "unknown";
+	}
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -19,6 +19,7 @@
 #include <aerospike/as_address.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_status.h>
+#include <citrusleaf/alloc.h>
 
 #if !defined(_MSC_VER)
 #include <netdb.h>
@@ -39,10 +40,19 @@ extern "C" {
 typedef struct as_sockaddr_iterator_s {
 	struct addrinfo* addresses;
 	struct addrinfo* current;
+	struct sockaddr_storage* cached;
+	uint32_t cached_size;
+	uint32_t cached_index;
 	uint16_t port_be;
 	bool hostname_is_alias;
 } as_address_iterator;
 
+/**
+ * @private
+ * Resolved hostname cache.
+ */
+typedef struct as_dns_cache_s as_dns_cache;
+
 struct as_cluster_s;
 struct as_node_info_s;
 struct as_host_s;
@@ -53,10 +63,28 @@ struct as_host_s;
 
 /**
  * @private
- * Lookup hostname and initialize address iterator.
+ * Create resolved hostname cache with entry time to live in milliseconds.
+ */
+as_dns_cache*
+as_dns_cache_create(uint32_t ttl_ms);
+
+/**
+ * @private
+ * Release cache.  Background resolutions that are still running hold their own reference.
+ */
+void
+as_dns_cache_release(as_dns_cache* cache);
+
+/**
+ * @private
+ * Lookup hostname and initialize address iterator.  If cache is not NULL, hostnames are
+ * resolved through the cache.
  */
 as_status
-as_lookup_host(as_address_iterator* iter, as_error* err, const char* hostname, uint16_t port);
+as_lookup_host(
+	as_dns_cache* cache, as_address_iterator* iter, as_error* err, const char* hostname,
+	uint16_t port
+	);
 	
 /**
  * @private
@@ -65,12 +93,21 @@ as_lookup_host(as_address_iterator* iter, as_error* err, const char* hostname, u
 static inline bool
 as_lookup_next(as_address_iterator* iter, struct sockaddr** addr)
 {
-	if (! iter->current) {
-		return false;
+	struct sockaddr* sa;
+
+	if (iter->cached) {
+		if (iter->cached_index >= iter->cached_size) {
+			return false;
+		}
+		sa = (struct sockaddr*)&iter->cached[iter->cached_index++];
+	}
+	else {
+		if (! iter->current) {
+			return false;
+		}
+		sa = iter->current->ai_addr;
+		iter->current = iter->current->ai_next;
 	}
-	
-	struct sockaddr* sa = iter->current->ai_addr;
-	iter->current = iter->current->ai_next;
 	
 	if (sa->sa_family == AF_INET) {
 		((struct sockaddr_in*)sa)->sin_port = iter->port_be;
@@ -89,7 +126,12 @@ as_lookup_next(as_address_iterator* iter, struct sockaddr** addr)
 static inline void
 as_lookup_end(as_address_iterator* iter)
 {
-	freeaddrinfo(iter->addresses);
+	if (iter->cached) {
+		cf_free(iter->cached);
+	}
+	else {
+		freeaddrinfo(iter->addresses);
+	}
 }
 
 /**
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_config.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_result.h>
+#include <aerospike/as_stream.h>
+#include <aerospike/as_udf_context.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Client lua state pool statistics.
+ *
+ * @ingroup as_config_object
+ */
+typedef struct as_lua_pool_stats_s {
+	/**
+	 * Lua states created per warm up function at aerospike_connect().
+	 */
+	uint32_t warm_states;
+
+	/**
+	 * Warm up calls that failed.  The lua error is logged.
+	 */
+	uint32_t warm_errors;
+
+	/**
+	 * Client side lua stream stages that started while no more than warm_states stages
+	 * were running, so a warmed state was available in the cache.
+	 */
+	uint64_t hits;
+
+	/**
+	 * Client side lua stream stages that started while all warmed states were in use and a
+	 * new lua state may have been created.
+	 */
+	uint64_t misses;
+} as_lua_pool_stats;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Return client lua state pool statistics.
+ *
+ * @ingroup as_config_object
+ */
+AS_EXTERN void
+as_lua_pool_get_stats(as_lua_pool_stats* stats);
+
+/**
+ * @private
+ * Run warm up functions in config.  Called once after lua is configured.
+ */
+void
+as_lua_pool_warm(as_config_lua* config);
+
+/**
+ * @private
+ * Run client side lua stream stage and track pool statistics.
+ */
+int
+as_lua_pool_apply_stream(
+	as_udf_context* ctx, const char* filename, const char* function, as_stream* istream,
+	as_list* args, as_stream* ostream, as_result* res
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
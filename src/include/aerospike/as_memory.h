@@ -0,0 +1,155 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Client subsystems whose heap memory is accounted.  Accounting is compiled out when
+ * AS_NO_MEMORY_STATS is defined.
+ * @ingroup cluster_stats
+ */
+typedef enum as_memory_tag_e {
+	/**
+	 * Sync command and response buffers that do not fit on the stack, including idle buffers
+	 * cached by as_buffer_pool.
+	 */
+	AS_MEMORY_COMMAND,
+
+	/**
+	 * Async command slabs and response buffers, including idle event loop pools.
+	 */
+	AS_MEMORY_EVENT,
+
+	/**
+	 * Uncompressed async batch buffers kept for retries.
+	 */
+	AS_MEMORY_BATCH,
+
+	/**
+	 * Records reused by scan/query node commands.
+	 */
+	AS_MEMORY_QUERY,
+
+	/**
+	 * Partition tables and node partition bitmaps maintained by the tend thread.
+	 */
+	AS_MEMORY_TEND,
+
+	/**
+	 * Client-side record cache responses and negative cache filters.
+	 */
+	AS_MEMORY_CACHE,
+
+	AS_MEMORY_MAX
+} as_memory_tag;
+
+/**
+ * Heap memory of a subsystem.
+ * @ingroup cluster_stats
+ */
+typedef struct as_memory_usage_s {
+	/**
+	 * Bytes currently allocated.
+	 */
+	uint64_t current;
+
+	/**
+	 * Highest value of current since the process started.
+	 */
+	uint64_t peak;
+} as_memory_usage;
+
+/**
+ * @private
+ * Memory usage padded to a cache line, so tags do not share cache lines.
+ */
+typedef struct as_memory_counter_s {
+	as_memory_usage usage;
+	uint8_t pad[64 - sizeof(as_memory_usage)];
+} as_memory_counter;
+
+/******************************************************************************
+ * GLOBAL VARIABLES
+ *****************************************************************************/
+
+extern as_memory_counter as_memory_counters[AS_MEMORY_MAX];
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Return name of memory tag.
+ */
+AS_EXTERN const char*
+as_memory_tag_name(as_memory_tag tag);
+
+/**
+ * Copy current and peak bytes of all tags to usage, which must hold AS_MEMORY_MAX entries.
+ */
+AS_EXTERN void
+as_memory_get_usage(as_memory_usage* usage);
+
+/**
+ * @private
+ * Account allocation of size bytes.
+ */
+static inline void
+as_memory_add(as_memory_tag tag, size_t size)
+{
+#if !defined(AS_NO_MEMORY_STATS)
+	as_memory_usage* u = &as_memory_counters[tag].usage;
+	uint64_t current = as_aaf_uint64(&u->current, size);
+	uint64_t peak = as_load_uint64(&u->peak);
+
+	while (current > peak && ! as_cas_uint64(&u->peak, peak, current)) {
+		peak = as_load_uint64(&u->peak);
+	}
+#else
+	(void)tag;
+	(void)size;
+#endif
+}
+
+/**
+ * @private
+ * Account release of size bytes.
+ */
+static inline void
+as_memory_sub(as_memory_tag tag, size_t size)
+{
+#if !defined(AS_NO_MEMORY_STATS)
+	as_add_uint64(&as_memory_counters[tag].usage.current, -(int64_t)size);
+#else
+	(void)tag;
+	(void)size;
+#endif
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Multiple producer, single consumer queue node.
+ */
+typedef struct as_mpsc_node_s {
+	struct as_mpsc_node_s* next;
+	uint8_t data[];
+} as_mpsc_node;
+
+/**
+ * @private
+ * Unbounded lock free multiple producer, single consumer queue.  Producers append with one
+ * atomic exchange on the tail.  The consumer owns the head, which is always a consumed
+ * (stub) node, so push and pop never contend on the same pointer.
+ *
+ * A producer that has swapped the tail but not yet linked its node temporarily hides
+ * later nodes from the consumer.  Pop returns false in that case and the consumer must
+ * rely on the producer's subsequent wakeup.
+ */
+typedef struct as_mpsc_queue_s {
+	as_mpsc_node* head;
+	as_mpsc_node* tail;
+	uint32_t item_size;
+	uint32_t size;
+} as_mpsc_queue;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Initialize queue with fixed size items.
+ */
+void
+as_mpsc_queue_init(as_mpsc_queue* queue, uint32_t item_size);
+
+/**
+ * @private
+ * Free all nodes.  No producers or consumer may be active.
+ */
+void
+as_mpsc_queue_destroy(as_mpsc_queue* queue);
+
+/**
+ * @private
+ * Append item to queue.  Safe to call from any thread.
+ */
+bool
+as_mpsc_queue_push(as_mpsc_queue* queue, const void* ptr);
+
+/**
+ * @private
+ * Remove oldest item from queue.  Only the consumer thread may call this function.
+ */
+bool
+as_mpsc_queue_pop(as_mpsc_queue* queue, void* ptr);
+
+/**
+ * @private
+ * Return approximate number of items in queue.
+ */
+static inline uint32_t
+as_mpsc_queue_size(as_mpsc_queue* queue)
+{
+	return as_load_uint32(&queue->size);
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * View of a string or blob list element.  The value is not null terminated and points into
+ * memory owned by the record it was read from.
+ */
+typedef struct as_bytes_view_s {
+	/**
+	 * Element bytes.
+	 */
+	const uint8_t* value;
+
+	/**
+	 * Number of bytes in value.
+	 */
+	uint32_t size;
+
+	/**
+	 * Element type. AS_BYTES_STRING for strings.
+	 */
+	as_bytes_type type;
+} as_bytes_view;
+
+/**
+ * @private
+ * Result of decoding a msgpack list into an array.
+ */
+typedef enum as_msgpack_array_status_e {
+	/**
+	 * All elements were decoded.
+	 */
+	AS_MSGPACK_ARRAY_OK,
+
+	/**
+	 * The list has more elements than the array capacity.  Nothing was decoded.
+	 */
+	AS_MSGPACK_ARRAY_CAPACITY,
+
+	/**
+	 * The value is not a list of the requested element type.
+	 */
+	AS_MSGPACK_ARRAY_TYPE
+} as_msgpack_array_status;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Decode msgpack list of integers into values.  size is set to the number of list elements.
+ */
+as_msgpack_array_status
+as_msgpack_unpack_int64_array(
+	const uint8_t* buf, uint32_t buf_size, int64_t* values, uint32_t capacity, uint32_t* size
+	);
+
+/**
+ * @private
+ * Decode msgpack list of doubles into values.  size is set to the number of list elements.
+ */
+as_msgpack_array_status
+as_msgpack_unpack_double_array(
+	const uint8_t* buf, uint32_t buf_size, double* values, uint32_t capacity, uint32_t* size
+	);
+
+/**
+ * @private
+ * Decode msgpack list of strings and blobs into views of buf.  size is set to the number of
+ * list elements.
+ */
+as_msgpack_array_status
+as_msgpack_unpack_bytes_array(
+	const uint8_t* buf, uint32_t buf_size, as_bytes_view* values, uint32_t capacity,
+	uint32_t* size
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
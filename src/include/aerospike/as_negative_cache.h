@@ -0,0 +1,103 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of independently locked filter shards.  Must be a power of 2.
+ */
+#define AS_NEGATIVE_CACHE_SHARDS 16
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Filter of keys that were recently not found, keyed by namespace and digest.  Each shard
+ * holds two generations of cuckoo filters.  The older generation is dropped every ttl / 2,
+ * so keys are remembered for between ttl / 2 and ttl.  Unlike a bloom filter, keys can be
+ * removed when they are written.
+ */
+typedef struct as_negative_cache_s as_negative_cache;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create filter sized for capacity keys per generation with the given false positive rate.
+ */
+as_negative_cache*
+as_negative_cache_create(uint32_t capacity, uint32_t ttl_ms, double fpr);
+
+/**
+ * @private
+ * Destroy filter.
+ */
+void
+as_negative_cache_destroy(as_negative_cache* cache);
+
+/**
+ * @private
+ * Return version of the shard that holds the key.  Pass the version returned before a
+ * read is sent to as_negative_cache_add(), so misses that raced with a local write are
+ * not remembered.
+ */
+uint64_t
+as_negative_cache_version(as_negative_cache* cache, const char* ns, const uint8_t* digest);
+
+/**
+ * @private
+ * Return true if the key was recently not found.  May return true for keys that were
+ * never added at the configured false positive rate.
+ */
+bool
+as_negative_cache_contains(as_negative_cache* cache, const char* ns, const uint8_t* digest);
+
+/**
+ * @private
+ * Remember key that was not found.  The key is not added if the shard version changed
+ * since version was read.
+ */
+void
+as_negative_cache_add(
+	as_negative_cache* cache, const char* ns, const uint8_t* digest, uint64_t version
+	);
+
+/**
+ * @private
+ * Forget key because it is being written.  Also invalidates reads of the same shard that
+ * are in flight.
+ */
+void
+as_negative_cache_remove(as_negative_cache* cache, const char* ns, const uint8_t* digest);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
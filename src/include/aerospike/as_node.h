@@ -17,10 +17,12 @@
 #pragma once
 
 #include <aerospike/as_atomic.h>
+#include <aerospike/as_command_counters.h>
 #include <aerospike/as_config.h>
 #include <aerospike/as_conn_pool.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_event.h>
+#include <aerospike/as_latency.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_partition.h>
 #include <aerospike/as_queue.h>
@@ -60,6 +62,14 @@ extern "C" {
 #define AS_ADDRESS4_MAX 4
 #define AS_ADDRESS6_MAX 8
 
+// Minimum commands per node before adaptive timeouts are computed.
+#define AS_NODE_TIMEOUT_MIN_SAMPLES 100
+
+// Node circuit breaker states. See as_config.error_rate_backoff_max.
+#define AS_NODE_BREAKER_CLOSED 0
+#define AS_NODE_BREAKER_OPEN 1
+#define AS_NODE_BREAKER_HALF_OPEN 2
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -146,6 +156,16 @@ typedef struct as_racks_s {
 
 } as_racks;
 
+/**
+ * @private
+ * Info response buffer that is reused across tend iterations. It grows to the largest
+ * response and is only freed with the node.
+ */
+typedef struct as_tend_buffer_s {
+	uint8_t* data;
+	uint32_t capacity;
+} as_tend_buffer;
+
 /**
  * @private
  * Session info.
@@ -166,6 +186,12 @@ typedef struct as_session_s {
 	 */
 	uint64_t expiration;
 
+	/**
+	 * Time when the tend thread replaces this session with a new one. Commands keep using
+	 * this session until the new one is stored. Zero if the session does not expire.
+	 */
+	uint64_t refresh;
+
 	/**
 	 * Session token for this node.
 	 */
@@ -203,6 +229,26 @@ typedef struct as_async_conn_pool_s {
 	 */
 	uint32_t closed;
 
+	/**
+	 * Peak connections in use since the last connection balance.
+	 */
+	uint32_t peak;
+
+	/**
+	 * Peak connections in use at the previous connection balance.
+	 */
+	uint32_t last_peak;
+
+	/**
+	 * Adaptive pre-warm connection target.
+	 */
+	uint32_t target;
+
+	/**
+	 * Background connector connections that are still opening.
+	 */
+	uint32_t connecting;
+
 } as_async_conn_pool;
 
 struct as_cluster_s;
@@ -266,6 +312,23 @@ typedef struct as_node_s {
 	 */
 	as_vector /* <as_alias> */ aliases;
 
+	/**
+	 * Partition bitmaps last applied from this node. Only accessed by tend thread.
+	 */
+	as_vector /* <as_partition_bitmap*> */ partition_bitmaps;
+
+	/**
+	 * Response buffer for node, peers and partitions info requests on the tend connection.
+	 * Only accessed by the thread tending this node.
+	 */
+	as_tend_buffer tend_buf;
+
+	/**
+	 * Response buffer for racks info requests, which are held with the partitions response.
+	 * Only accessed by the thread tending this node.
+	 */
+	as_tend_buffer racks_buf;
+
 	/**
 	 * Cluster from which this node resides.
 	 */
@@ -275,6 +338,12 @@ typedef struct as_node_s {
 	 * Pools of current, cached sockets.
 	 */
 	as_conn_pool* sync_conn_pools;
+
+	/**
+	 * Pool of sync connections reserved for scan and query commands.  Only used when
+	 * cluster bulk_max_conns_per_node is greater than zero.
+	 */
+	as_conn_pool bulk_conn_pool;
 	
 	/**
 	 * Array of connection pools used in async commands.  There is one pool per node/event loop.
@@ -307,6 +376,12 @@ typedef struct as_node_s {
 	 */
 	uint32_t conn_iter;
 
+	/**
+	 * Cluster conn_limits_gen that sync connection pools are sized for.  Only accessed by
+	 * the tend thread.
+	 */
+	uint32_t conn_limits_gen;
+
 	/**
 	 * Total sync connections opened.
 	 */
@@ -317,11 +392,120 @@ typedef struct as_node_s {
 	 */
 	uint32_t sync_conns_closed;
 
+	/**
+	 * Sync connections closed because they were idle too long.
+	 */
+	uint32_t sync_conns_closed_idle;
+
+	/**
+	 * Sync connections closed after an error.
+	 */
+	uint32_t sync_conns_closed_error;
+
+	/**
+	 * Sync connections closed to trim pools down to their size limits.
+	 */
+	uint32_t sync_conns_closed_balance;
+
+	/**
+	 * Total sync connections opened with kernel TLS offload.
+	 */
+	uint32_t sync_conns_ktls;
+
 	/**
 	 * Error count for this node's error_rate_window.
 	 */
 	uint32_t error_count;
 
+	/**
+	 * Has another process sharing cluster memory exceeded max_error_rate for this node in
+	 * the current error window.
+	 */
+	uint8_t error_rate_exceeded;
+
+	/**
+	 * Circuit breaker state. Only written by tend thread.
+	 */
+	uint8_t breaker_state;
+
+	/**
+	 * Error windows the breaker stays open the next time it opens. Only accessed by tend
+	 * thread.
+	 */
+	uint32_t breaker_backoff;
+
+	/**
+	 * Error windows left before an open breaker becomes half-open. Only accessed by tend
+	 * thread.
+	 */
+	uint32_t breaker_remaining;
+
+	/**
+	 * Commands considered for a probe while the breaker is half-open.
+	 */
+	uint32_t breaker_probes;
+
+	/**
+	 * Sync connections this process added to the node's shared memory connection count.
+	 * Only accessed by tend thread.
+	 */
+	uint32_t conns_published;
+
+	/**
+	 * Idle sync connections this process added to the node's shared memory idle count.
+	 * Only accessed by tend thread.
+	 */
+	uint32_t idle_published;
+
+	/**
+	 * Hedged reads currently outstanding against this node.
+	 */
+	uint32_t hedge_count;
+
+	/**
+	 * Bytes of async commands currently in flight to this node.
+	 */
+	uint64_t async_bytes;
+
+	/**
+	 * Moving average of command latency in microseconds. Zero if no command has been
+	 * measured. Only commands using AS_POLICY_REPLICA_LOWEST_LATENCY are measured.
+	 */
+	uint32_t latency_us;
+
+	/**
+	 * Measured commands currently outstanding against this node.
+	 */
+	uint32_t latency_in_flight;
+
+	/**
+	 * Command latency histogram shards. NULL when latency_stats is disabled.
+	 */
+	as_latency_shard* latency;
+
+	/**
+	 * Single record command latency histogram shards used for adaptive timeouts.
+	 * NULL when adaptive_timeout_factor is zero.
+	 */
+	as_timeout_shard* timeout_hist;
+
+	/**
+	 * Sum of timeout_hist buckets when timeout_p99_us was last computed. Only accessed by
+	 * tend thread.
+	 */
+	uint64_t timeout_prev[AS_LATENCY_BUCKETS];
+
+	/**
+	 * Smoothed 99th percentile of single record command latency in microseconds. Zero if not
+	 * enough commands have been measured.
+	 */
+	uint32_t timeout_p99_us;
+
+	/**
+	 * Command and byte counter shards.
+	 */
+	as_command_counter_shard* counters;
+
 	/**
 	 * Server's generation count for peers.
 	 */
@@ -352,6 +536,22 @@ typedef struct as_node_s {
 	 */
 	uint32_t index;
 	
+	/**
+	 * Number of completed login attempts. Connections that wait for a pending login watch
+	 * this value.
+	 */
+	uint32_t login_count;
+
+	/**
+	 * Second of the current max_conn_open_rate window.
+	 */
+	uint32_t conn_open_window;
+
+	/**
+	 * Connections opened in the current max_conn_open_rate window.
+	 */
+	uint32_t conn_open_count;
+
 	/**
 	 * Should user login to avoid session expiration.
 	 */
@@ -361,6 +561,13 @@ typedef struct as_node_s {
 	 * Is node currently active.
 	 */
 	uint8_t active;
+
+	/**
+	 * Set when a command failed to open a connection to the node. Replica routing avoids
+	 * suspect nodes when another replica is usable, so commands stop paying their own connect
+	 * failure before the next tend removes the node. Cleared when tend reaches the node.
+	 */
+	uint8_t suspect;
 	
 	/**
 	 * Did partition change in current cluster tend.
@@ -436,6 +643,14 @@ as_node_destroy(as_node* node);
 void
 as_node_create_min_connections(as_node* node);
 
+/**
+ * @private
+ * Open and authenticate tend connection if not already open. Nodes restored from a
+ * topology snapshot are created without a tend connection.
+ */
+as_status
+as_node_create_tend_connection(as_error* err, as_node* node);
+
 /**
  * @private
  * Set node to inactive.
@@ -517,6 +732,14 @@ as_node_get_address_string(as_node* node)
 as_status
 as_node_authenticate_connection(struct as_cluster_s* cluster, uint64_t deadline_ms);
 
+/**
+ * @private
+ * Open and authenticate a blocking socket to be handed to an event loop's async pool.
+ * Called from a helper thread, so the TLS handshake does not run on the event loop.
+ */
+as_status
+as_node_create_async_socket(as_error* err, as_node* node, uint64_t deadline_ms, as_socket* sock);
+
 /**
  * @private
  * Get a connection to the given node from pool and validate.  Return 0 on success.
@@ -524,6 +747,16 @@ as_node_authenticate_connection(struct as_cluster_s* cluster, uint64_t deadline_
 as_status
 as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock);
 
+/**
+ * @private
+ * Get a connection for a scan or query command.  Uses the node's scan and query pool when
+ * configured and the regular pools otherwise.  Return 0 on success.
+ */
+as_status
+as_node_get_bulk_connection(
+	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock
+	);
+
 /**
  * @private
  * Close a node's connection and update node/pool statistics.
@@ -573,6 +806,22 @@ as_node_put_connection(as_node* node, as_socket* sock)
 void
 as_node_balance_connections(as_node* node);
 
+/**
+ * @private
+ * Return total and idle sync connections in node's pools.
+ */
+void
+as_node_sync_conns(as_node* node, uint32_t* total, uint32_t* idle);
+
+
+/**
+ * @private
+ * Close up to count of node's oldest idle sync connections, without going below each
+ * pool's minimum size. Return number of connections closed.
+ */
+uint32_t
+as_node_release_idle_connections(as_node* node, uint32_t count);
+
 /**
  * @private
  * Are hosts equal.
@@ -601,6 +850,14 @@ as_node_info_destroy(as_node_info* node_info)
 void
 as_node_signal_login(as_node* node);
 
+/**
+ * @private
+ * Reserve one new connection in the node's max_conn_open_rate window. Return false if the
+ * rate would be exceeded.
+ */
+bool
+as_node_reserve_conn_open(as_node* node);
+
 /**
  * @private
  * Does node contain rack.
@@ -608,6 +865,115 @@ as_node_signal_login(as_node* node);
 bool
 as_node_has_rack(as_node* node, const char* ns, int rack_id);
 
+/**
+ * @private
+ * Choose the replica with the lowest expected latency. The other replica is chosen
+ * occasionally, so its latency stays current.
+ */
+as_node*
+as_node_lowest_latency(as_node* n1, as_node* n2);
+
+/**
+ * @private
+ * Record latency of a command that started at begin_ns in node's histograms.
+ * The node must have histograms.
+ */
+void
+as_node_record_latency(as_node* node, as_latency_type type, uint64_t begin_ns);
+
+/**
+ * @private
+ * Record latency of a connection phase that started at begin_ns in node's histograms.
+ * The node must have histograms.
+ */
+void
+as_node_record_conn_latency(as_node* node, as_conn_latency_type type, uint64_t begin_ns);
+
+/**
+ * @private
+ * Mark node suspect after a command failed to connect to it.
+ */
+void
+as_node_set_suspect(as_node* node);
+
+/**
+ * @private
+ * Return if replica routing should avoid the node. The node must not be NULL.
+ */
+static inline bool
+as_node_avoid(as_node* node)
+{
+	return ! as_load_uint8(&node->active) || as_load_uint8(&node->suspect);
+}
+
+/**
+ * @private
+ * Record latency of a single record command that started at begin_ns for adaptive timeouts.
+ * The node must have timeout_hist.
+ */
+void
+as_node_record_timeout_latency(as_node* node, uint64_t begin_ns);
+
+/**
+ * @private
+ * Recompute timeout_p99_us from commands recorded since the last computation.
+ * Only called by tend thread.
+ */
+void
+as_node_update_timeout(as_node* node);
+
+/**
+ * @private
+ * Return node's command counter shard for the calling thread.
+ */
+as_command_counters*
+as_node_get_counters(as_node* node);
+
+/**
+ * @private
+ * Start latency measurement of a command.
+ */
+static inline void
+as_node_latency_begin(as_node* node)
+{
+	as_incr_uint32(&node->latency_in_flight);
+}
+
+/**
+ * @private
+ * End latency measurement of a command. Failures are counted as a slow sample, so the
+ * node is avoided until it recovers.
+ */
+static inline void
+as_node_latency_end(as_node* node, uint64_t begin_ns, bool failed)
+{
+	as_decr_uint32(&node->latency_in_flight);
+
+	uint64_t sample = (cf_getns() - begin_ns) / 1000;
+	uint32_t avg = as_load_uint32(&node->latency_us);
+
+	if (failed) {
+		uint64_t penalty = (avg * 2 > 1000)? avg * 2 : 1000;
+
+		if (sample < penalty) {
+			sample = penalty;
+		}
+	}
+
+	if (sample > UINT32_MAX / 2) {
+		sample = UINT32_MAX / 2;
+	}
+
+	// Concurrent updates may lose a sample, which does not matter for an average.
+	if (avg == 0) {
+		avg = (uint32_t)sample;
+	}
+	else {
+		avg = (uint32_t)((int64_t)avg + ((int64_t)sample - (int64_t)avg) / 8);
+	}
+	as_store_uint32(&node->latency_us, avg ? avg : 1);
+}
+
 /**
  * @private
  * Release existing session.
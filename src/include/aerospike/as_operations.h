@@ -274,6 +274,13 @@ typedef struct as_operations_s {
 	 */
 	bool _free;
 
+	/**
+	 * @private
+	 * Arena chunks that hold packed CDT, bit, HLL and expression operation arguments.
+	 * Freed by as_operations_destroy().
+	 */
+	struct as_arena_chunk_s* _arena;
+
 } as_operations;
 
 /******************************************************************************
@@ -305,7 +312,8 @@ typedef struct as_operations_s {
 	(__ops)->binops._free = false;\
 	(__ops)->ttl = 0;\
 	(__ops)->gen = 0;\
-	(__ops)->_free = false;
+	(__ops)->_free = false;\
+	(__ops)->_arena = NULL;
 
 /******************************************************************************
  * FUNCTIONS
@@ -536,6 +544,27 @@ as_operations_add_write_raw(as_operations* ops, const as_bin_name name, const ui
 	return as_operations_add_write_rawp(ops, name, value, size, false);
 }
 
+/**
+ * Add a CDT, map, bit or hll operation whose arguments are already packed in the server's
+ * operation format, for example at compile time by as_exp.hpp. The buffer is not copied.
+ *
+ * @param ops			The `as_operations` to append the operation to.
+ * @param name 			The name of the bin to perform the operation on.
+ * @param op_type		The operator, e.g. AS_OPERATOR_CDT_READ.
+ * @param packed 		The packed operation. Must last for the lifetime of the operations.
+ * @param size 			The size of the packed operation.
+ *
+ * @return true on success. Otherwise an error occurred.
+ *
+ * @relates as_operations
+ * @ingroup as_operations_object
+ */
+AS_EXTERN bool
+as_operations_add_packed(
+	as_operations* ops, const as_bin_name name, as_operator op_type, const uint8_t* packed,
+	uint32_t size
+	);
+
 /**
  * Add a `AS_OPERATOR_READ` bin operation.
  *
@@ -550,6 +579,37 @@ as_operations_add_write_raw(as_operations* ops, const as_bin_name name, const ui
 AS_EXTERN bool
 as_operations_add_read(as_operations* ops, const as_bin_name name);
 
+/**
+ * Add a `AS_OPERATOR_WRITE` bin operation on a bin with an interned name.
+ *
+ * @param ops			The `as_operations` to append the operation to.
+ * @param handle		The interned name of the bin. See as_bin_handle_intern().
+ * @param value 		The value to be used in the operation.
+ *
+ * @return true on success. Otherwise an error occurred.
+ *
+ * @relates as_operations
+ * @ingroup as_operations_object
+ */
+AS_EXTERN bool
+as_operations_add_write_handle(
+	as_operations* ops, const as_bin_handle* handle, as_bin_value* value
+	);
+
+/**
+ * Add a `AS_OPERATOR_READ` bin operation on a bin with an interned name.
+ *
+ * @param ops			The `as_operations` to append the operation to.
+ * @param handle		The interned name of the bin. See as_bin_handle_intern().
+ *
+ * @return true on success. Otherwise an error occurred.
+ *
+ * @relates as_operations
+ * @ingroup as_operations_object
+ */
+AS_EXTERN bool
+as_operations_add_read_handle(as_operations* ops, const as_bin_handle* handle);
+
 /**
  * Add a `AS_OPERATOR_INCR` bin operation with (required) int64_t value.
  *
@@ -19,6 +19,7 @@
 #include <aerospike/as_atomic.h>
 #include <aerospike/as_std.h>
 #include <aerospike/as_status.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -108,6 +109,34 @@ as_partition_tables_destroy(as_partition_tables* tables);
  */
 as_partition_table*
 as_partition_tables_get(as_partition_tables* tables, const char* ns);
+
+/**
+ * @private
+ * Get partition table given namespace ID, falling back to namespace name when the ID
+ * is zero or does not match. Tables are never removed, so an index stays valid.
+ */
+static inline as_partition_table*
+as_partition_tables_get_id(as_partition_tables* tables, uint32_t ns_id, const char* ns)
+{
+	if (ns_id > 0 && ns_id <= as_load_uint32(&tables->size)) {
+		as_partition_table* table = tables->tables[ns_id - 1];
+
+		// IDs from another cluster or namespace fall back to the name lookup.
+		if (strcmp(table->ns, ns) == 0) {
+			return table;
+		}
+	}
+	return as_partition_tables_get(tables, ns);
+}
+
+/**
+ * @private
+ * Resolve namespace to ID (partition table index + 1).
+ */
+as_status
+as_partition_namespace_id(
+	struct as_cluster_s* cluster, struct as_error_s* err, const char* ns, uint32_t* ns_id
+	);
 	
 /**
  * @private
@@ -130,6 +159,16 @@ as_partition_info_init(
 	const struct as_key_s* key
 	);
 
+/**
+ * @private
+ * Add partition table restored from a topology snapshot. Partitions reference nodes and
+ * regimes are ignored. Called before the cluster is tended.
+ */
+bool
+as_partition_tables_restore(
+	struct as_cluster_s* cluster, const char* ns, bool sc_mode, const as_partition* partitions
+	);
+
 /**
  * @private
  * Log all partition maps in the cluster.
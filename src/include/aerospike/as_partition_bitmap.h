@@ -0,0 +1,149 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_vector.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of 64 bit words in a decoded partition bitmap.
+ */
+#define AS_PARTITION_BITMAP_WORDS(_n_partitions) (((_n_partitions) + 63) / 64)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Partition bitmap that a node last reported for one namespace and replica level.
+ * Only accessed by the tend thread.
+ */
+typedef struct as_partition_bitmap_s {
+	/**
+	 * Partition table the bitmap was applied to. Only used for pointer comparison.
+	 */
+	const void* table;
+
+	/**
+	 * Hash of the encoded bitmap. Zero if other nodes took partitions of this bitmap
+	 * after it was applied.
+	 */
+	uint64_t hash;
+
+	/**
+	 * Regime of the applied bitmap.
+	 */
+	uint32_t regime;
+
+	/**
+	 * Number of words.
+	 */
+	uint32_t n_words;
+
+	/**
+	 * Is bitmap for master partitions.
+	 */
+	bool master;
+
+	/**
+	 * Has bitmap been applied.
+	 */
+	bool applied;
+
+	/**
+	 * Decoded bitmap. See as_partition_bitmap_decode().
+	 */
+	uint64_t words[];
+} as_partition_bitmap;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Decode base64 partition bitmap into host order words. Partition i is bit (63 - i % 64)
+ * of words[i / 64]. Words beyond the encoded bitmap are zeroed. On platforms with SSE2
+ * or NEON, 16 characters are translated at a time. Characters are not validated.
+ */
+void
+as_partition_bitmap_decode(const char* b64, uint32_t len, uint64_t* words, uint32_t n_words);
+
+/**
+ * @private
+ * Hash encoded bitmap. Never returns zero.
+ */
+uint64_t
+as_partition_bitmap_hash(const char* b64, uint32_t len);
+
+/**
+ * @private
+ * Find bitmap for table and replica level in vector of as_partition_bitmap pointers.
+ * Create bitmap that has not been applied if not found.
+ */
+as_partition_bitmap*
+as_partition_bitmap_get(as_vector* bitmaps, const void* table, bool master, uint32_t n_words);
+
+/**
+ * @private
+ * Remove partition from applied bitmap, because another node took it. The partition is
+ * updated again if the bitmap's node still claims it.
+ */
+void
+as_partition_bitmap_clear(as_vector* bitmaps, const void* table, bool master, uint32_t index);
+
+/**
+ * @private
+ * Free bitmaps and destroy vector.
+ */
+void
+as_partition_bitmaps_destroy(as_vector* bitmaps);
+
+/**
+ * @private
+ * Return offset of the first partition set in a decoded bitmap word. The word must not be
+ * zero.
+ */
+static inline uint32_t
+as_partition_bitmap_first(uint64_t bits)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, bits);
+	return 63 - (uint32_t)index;
+#else
+	return (uint32_t)__builtin_clzll(bits);
+#endif
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
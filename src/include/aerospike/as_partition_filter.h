@@ -18,6 +18,7 @@
 
 #include <aerospike/as_std.h>
 #include <aerospike/as_atomic.h>
+#include <aerospike/as_error.h>
 #include <aerospike/as_key.h>
 #include <citrusleaf/alloc.h>
 
@@ -168,6 +169,72 @@ as_partitions_status_release(as_partitions_status* parts_all)
 	}
 }
 
+/**
+ * Serialize status of all partitions into a compact, platform independent byte array.
+ * The byte array can be stored and passed to as_partitions_status_from_bytes() to resume
+ * a scan/query in another process. bytes must be freed with cf_free().
+ *
+ * @param parts_all		Completion status of all partitions.
+ * @param bytes			Serialized status. Output.
+ * @param bytes_size	Size of serialized status. Output.
+ */
+AS_EXTERN void
+as_partitions_status_to_bytes(
+	const as_partitions_status* parts_all, uint8_t** bytes, uint32_t* bytes_size
+	);
+
+/**
+ * Deserialize status of all partitions created by as_partitions_status_to_bytes().
+ * Return NULL if bytes are not a valid serialized status. The returned status must be
+ * released with as_partitions_status_release().
+ *
+ * @param bytes			Serialized status.
+ * @param bytes_size	Size of serialized status.
+ */
+AS_EXTERN as_partitions_status*
+as_partitions_status_from_bytes(const uint8_t* bytes, uint32_t bytes_size);
+
+/**
+ * Return maximum size of as_partitions_status_to_bytes() output for part_count partitions.
+ * @param part_count	Number of partitions.
+ */
+AS_EXTERN uint32_t
+as_partitions_status_bytes_max(uint32_t part_count);
+
+/**
+ * Write serialized status of all partitions to a file. The file is replaced atomically,
+ * so a crash during the write leaves the previous file intact.
+ *
+ * @param parts_all		Completion status of all partitions.
+ * @param path			File path.
+ * @param err			Error detail.
+ */
+AS_EXTERN as_status
+as_partitions_status_save(const as_partitions_status* parts_all, const char* path, as_error* err);
+
+/**
+ * Read status of all partitions from a file written by as_partitions_status_save() or by
+ * a scan/query checkpoint. Pass the result to as_partition_filter_set_partitions() to
+ * resume the scan/query. The status must be released with as_partitions_status_release().
+ *
+ * ~~~~~~~~~~{.c}
+ * as_partitions_status* parts_all;
+ *
+ * if (as_partitions_status_load(&parts_all, "/var/tmp/export.ckpt", &err) == AEROSPIKE_OK) {
+ *     as_partition_filter pf;
+ *     as_partition_filter_set_partitions(&pf, parts_all);
+ *     aerospike_scan_partitions(&as, &err, &p, &scan, &pf, callback, NULL);
+ *     as_partitions_status_release(parts_all);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param parts_all		Completion status of all partitions. Output.
+ * @param path			File path.
+ * @param err			Error detail.
+ */
+AS_EXTERN as_status
+as_partitions_status_load(as_partitions_status** parts_all, const char* path, as_error* err);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
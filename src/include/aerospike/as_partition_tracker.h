@@ -17,6 +17,7 @@
 #pragma once
 
 #include <aerospike/as_std.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_partition.h>
 #include <aerospike/as_partition_filter.h>
 #include <aerospike/as_vector.h>
@@ -26,6 +27,16 @@
 extern "C" {
 #endif
 
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Bitmap words needed for the maximum partition count (4096).
+ */
+#define AS_PARTITION_TRACKER_WORDS 64
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -45,8 +56,26 @@ typedef struct as_node_partitions_s {
 	uint64_t record_count;
 	uint64_t record_max;
 	uint32_t parts_unavailable;
+	uint32_t full_next;
+	uint32_t partial_next;
 } as_node_partitions;
 
+/**
+ * @private
+ * Automatic checkpoint of scan/query partition status.  Digest cursors are written under a
+ * per-partition sequence count, so a checkpoint can copy them while node commands are running.
+ */
+typedef struct as_partition_checkpoint_s {
+	char* path;
+	uint32_t* seqs;
+	uint64_t count;
+	uint64_t next_count;
+	uint64_t deadline;
+	uint32_t records;
+	uint32_t interval;
+	uint32_t busy;
+} as_partition_checkpoint;
+
 /**
  * @private
  * Scan/Query partition tracker.
@@ -58,6 +87,7 @@ typedef struct as_partition_tracker_s {
 	struct as_node_s* node_filter;
 	as_vector node_parts;
 	as_vector* errors;
+	as_partition_checkpoint* checkpoint;
 	uint64_t max_records;
 	uint32_t parts_capacity;
 	uint32_t sleep_between_retries;
@@ -66,6 +96,10 @@ typedef struct as_partition_tracker_s {
 	uint32_t max_retries;
 	uint32_t iteration;
 	uint64_t deadline;
+
+	// Partitions to assign in the next iteration, indexed by offset from part_begin.
+	// Partition retry flags in parts_all are only updated when the tracker is destroyed.
+	uint64_t retry_bits[AS_PARTITION_TRACKER_WORDS];
 } as_partition_tracker;
 
 /******************************************************************************
@@ -96,13 +130,58 @@ as_partition_tracker_assign(
 	as_partition_tracker* pt, struct as_cluster_s* cluster, const char* ns, struct as_error_s* err
 	);
 
+/**
+ * @private
+ * Enable checkpoints to path.  A checkpoint is also written every records delivered records
+ * and every interval milliseconds when these are greater than zero.
+ */
+void
+as_partition_tracker_checkpoint_init(
+	as_partition_tracker* pt, const char* path, uint32_t records, uint32_t interval
+	);
+
+/**
+ * @private
+ * Set partition digest cursor while checkpoints are enabled.
+ */
+void
+as_partition_tracker_checkpoint_set(
+	as_partition_tracker* pt, as_partition_status* p, as_digest* digest, uint64_t bval
+	);
+
+/**
+ * @private
+ * Write checkpoint file.  If final is false, all partitions are marked for retry, so a
+ * resumed scan/query continues every partition from its digest cursor.
+ */
+as_status
+as_partition_tracker_checkpoint_write(
+	as_partition_tracker* pt, bool final, struct as_error_s* err
+	);
+
+/**
+ * @private
+ * Mark partition at offset index for retry.  Node threads may mark partitions in the
+ * same bitmap word concurrently.
+ */
+static inline void
+as_partition_tracker_set_retry(as_partition_tracker* pt, uint32_t index)
+{
+	uint64_t* word = &pt->retry_bits[index >> 6];
+	uint64_t bit = 1ULL << (index & 63);
+	uint64_t old;
+
+	do {
+		old = as_load_uint64(word);
+	} while (! as_cas_uint64(word, old, old | bit));
+}
+
 static inline void
 as_partition_tracker_part_unavailable(
 	as_partition_tracker* pt, as_node_partitions* np, uint32_t part_id
 	)
 {
-	as_partitions_status* ps = pt->parts_all;
-	ps->parts[part_id - ps->part_begin].retry = true;
+	as_partition_tracker_set_retry(pt, part_id - pt->parts_all->part_begin);
 	np->parts_unavailable++;
 }
 
@@ -113,7 +192,14 @@ as_partition_tracker_set_digest(
 {
 	uint32_t part_id = as_partition_getid(digest->value, n_partitions);
 	as_partitions_status* ps = pt->parts_all;
-	ps->parts[part_id - ps->part_begin].digest = *digest;
+	as_partition_status* p = &ps->parts[part_id - ps->part_begin];
+
+	if (pt->checkpoint) {
+		as_partition_tracker_checkpoint_set(pt, p, digest, p->bval);
+	}
+	else {
+		p->digest = *digest;
+	}
 	np->record_count++;
 }
 
@@ -126,8 +212,14 @@ as_partition_tracker_set_last(
 	uint32_t part_id = as_partition_getid(digest->value, n_partitions);
 	as_partitions_status* ps = pt->parts_all;
 	as_partition_status* p = &ps->parts[part_id - ps->part_begin];
-	p->digest = *digest;
-	p->bval = bval;
+
+	if (pt->checkpoint) {
+		as_partition_tracker_checkpoint_set(pt, p, digest, bval);
+	}
+	else {
+		p->digest = *digest;
+		p->bval = bval;
+	}
 	np->record_count++;
 }
 
@@ -155,6 +247,51 @@ as_partition_tracker_should_retry(
 	as_partition_tracker* pt, as_node_partitions* np, as_status status
 	);
 
+/**
+ * @private
+ * Initialize partition chunk for node commands of np.
+ */
+void
+as_partition_tracker_chunk_init(
+	as_partition_tracker* pt, as_node_partitions* chunk, as_node_partitions* np
+	);
+
+/**
+ * @private
+ * Move up to chunk_size partitions that have not been issued yet from np to chunk.  When np
+ * has no partitions left, take partitions from the node with the most partitions left if np's
+ * node is their replica and the namespace is not in strong consistency mode.  Return false if
+ * no partitions are left.
+ */
+bool
+as_partition_tracker_next_chunk(
+	as_partition_tracker* pt, struct as_cluster_s* cluster, const char* ns, as_node_partitions* np,
+	as_node_partitions* chunk, uint32_t chunk_size
+	);
+
+/**
+ * @private
+ * Add record and unavailable partition counts of completed chunk to np.  Several streams
+ * may complete chunks of the same node concurrently.
+ */
+static inline void
+as_partition_tracker_chunk_done(
+	as_partition_tracker* pt, as_node_partitions* np, as_node_partitions* chunk
+	)
+{
+	pthread_mutex_lock(&pt->lock);
+	np->record_count += chunk->record_count;
+	np->parts_unavailable += chunk->parts_unavailable;
+	pthread_mutex_unlock(&pt->lock);
+}
+
+/**
+ * @private
+ * Release partition chunk.
+ */
+void
+as_partition_tracker_chunk_destroy(as_node_partitions* chunk);
+
 void
 as_partition_tracker_destroy(as_partition_tracker* pt);
 
@@ -40,13 +40,24 @@
 #include <unistd.h>
 #endif
 
+/**
+ * Maximum bytes of pipelined commands gathered into one socket write.
+ */
+#define AS_PIPE_GATHER_SIZE (16 * 1024)
+
 typedef struct as_pipe_connection {
 	as_event_connection base;
 	as_event_command* writer;
 	cf_ll readers;
+	// Commands sent in the same write as writer.  They become readers when the write completes.
+	cf_ll gathered;
+	// Next connection on the event loop's deferred write list.
+	struct as_pipe_connection* gather_next;
 	bool canceling;
 	bool canceled;
 	bool in_pool;
+	bool gathering;
+	uint8_t gather_space[AS_PIPE_GATHER_SIZE];
 } as_pipe_connection;
 
 extern int
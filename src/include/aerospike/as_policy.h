@@ -138,6 +138,8 @@ extern "C" {
  *****************************************************************************/
 
 struct as_exp;
+struct as_async_cancel_s;
+struct as_async_flow_s;
 
 /**
  * Retry Policy
@@ -299,7 +301,15 @@ typedef enum as_policy_replica_e {
 	 * as_config.rack_aware, as_config.rack_id or as_config.rack_ids, and server rack 
 	 * configuration must also be set to enable this functionality.
 	 */
-	AS_POLICY_REPLICA_PREFER_RACK
+	AS_POLICY_REPLICA_PREFER_RACK,
+
+	/**
+	 * For reads, try the node containing master or replicated partition with the lowest
+	 * recent latency, weighted by the commands currently outstanding on that node. Nodes
+	 * with recent failures are avoided until their latency recovers. Use SEQUENCE for writes.
+	 * Currently restricted to master and one prole.
+	 */
+	AS_POLICY_REPLICA_LOWEST_LATENCY
 
 } as_policy_replica;
 
@@ -360,6 +370,34 @@ typedef enum as_policy_read_mode_sc_e {
 
 } as_policy_read_mode_sc;
 
+/**
+ * Client-side record cache usage of single record reads.  The cache is enabled with
+ * as_config.record_cache_max.
+ *
+ * @ingroup client_policies
+ */
+typedef enum as_policy_cache_e {
+
+	/**
+	 * Always read from the server and do not cache the record.
+	 */
+	AS_POLICY_CACHE_NONE,
+
+	/**
+	 * Return the cached record if it was read less than as_config.record_cache_ttl_ms
+	 * milliseconds ago.  Otherwise, read the record from the server and cache it.
+	 */
+	AS_POLICY_CACHE_TTL,
+
+	/**
+	 * Like AS_POLICY_CACHE_TTL, but also send a header only read for a cached record and
+	 * return the cached bins only if the server generation matches.  Changes by other
+	 * clients are then seen immediately, while bin values are still not transferred.
+	 */
+	AS_POLICY_CACHE_VALIDATE,
+
+} as_policy_cache;
+
 /**
  * Commit Level
  *
@@ -383,6 +421,38 @@ typedef enum as_policy_commit_level_e {
 
 } as_policy_commit_level;
 
+/**
+ * Async delay queue priority.
+ *
+ * When an event loop has reached max_commands_in_process, new commands wait on a
+ * delay queue.  Each priority has its own delay queue and waiting commands are started
+ * from the queues in weighted round-robin order (interactive 4, normal 2, bulk 1).
+ * Commands are only reordered while waiting on the delay queue.  This field has no effect
+ * on sync commands or when max_commands_in_process is zero.
+ *
+ * @ingroup client_policies
+ */
+typedef enum as_policy_priority_e {
+
+	/**
+	 * Default priority.
+	 */
+	AS_POLICY_PRIORITY_NORMAL,
+
+	/**
+	 * Latency sensitive commands that should be started ahead of other waiting commands.
+	 */
+	AS_POLICY_PRIORITY_INTERACTIVE,
+
+	/**
+	 * Throughput oriented commands that can wait while other commands are started.
+	 */
+	AS_POLICY_PRIORITY_BULK,
+
+} as_policy_priority;
+
+#define AS_POLICY_PRIORITY_MAX 3
+
 /**
  * Generic policy fields shared among all policies.
  *
@@ -499,6 +569,24 @@ typedef struct as_policy_base_s {
 	 */
 	bool compress;
 
+	/**
+	 * Microseconds to spin on non-blocking socket receives while waiting for a sync
+	 * response before sleeping in poll.  Spinning avoids the wakeup latency of poll when
+	 * the server responds quickly (same rack, sub-100us), but burns cpu on the calling
+	 * thread for up to this long on every command.  Only enable on latency critical
+	 * policies.  Ignored for TLS connections, io_uring socket I/O and async commands.
+	 *
+	 * Default: 0 (do not spin)
+	 */
+	uint32_t read_spin_us;
+
+	/**
+	 * Async delay queue priority.  See as_policy_priority.
+	 *
+	 * Default: AS_POLICY_PRIORITY_NORMAL
+	 */
+	as_policy_priority priority;
+
 } as_policy_base;
 
 /**
@@ -535,6 +623,26 @@ typedef struct as_policy_read_s {
 	 */
 	as_policy_read_mode_sc read_mode_sc;
 
+	/**
+	 * Milliseconds to wait for the first node's response before sending the same read to the
+	 * next replica (hedged read).  The first response wins and the other connection is closed.
+	 * Applies to sync reads on AP namespaces when replica is not AS_POLICY_REPLICA_MASTER.
+	 * The hedge is skipped when the remaining total timeout is not greater than this delay.
+	 * This field is ignored for async commands.
+	 *
+	 * Default: 0 (do not hedge)
+	 */
+	uint32_t hedge_delay;
+
+	/**
+	 * Maximum number of hedged reads that may be outstanding against a single node.
+	 * Reads that would exceed this budget wait on the original node instead, so a slow
+	 * node does not cause the read load on its replicas to double.
+	 *
+	 * Default: 16
+	 */
+	uint32_t hedge_max;
+
 	/**
 	 * Should raw bytes representing a list or map be deserialized to as_list or as_map.
 	 * Set to false for backup programs that just need access to raw bytes.
@@ -553,6 +661,106 @@ typedef struct as_policy_read_s {
 	 */
 	bool async_heap_rec;
 
+	/**
+	 * Should blob and raw (not deserialized) list/map bin values reference the server response
+	 * buffer instead of being copied into separate heap allocations. The record then owns the
+	 * response buffer until as_record_destroy() is called. String and geojson bin values are
+	 * always copied. This field is ignored for async commands.
+	 *
+	 * Default: false
+	 */
+	bool zero_copy;
+
+	/**
+	 * Should list and map bin values be deserialized on first access instead of when the
+	 * response is parsed. The record keeps each list/map bin as raw bytes until the bin is read
+	 * with as_record_get() (or a typed getter), as_record_iterator_next() or
+	 * as_record_foreach(). Wide records where only a few bins are read then skip most of the
+	 * deserialization cost. Reading a bin modifies the record, so a record must not be read by
+	 * multiple threads at once. Ignored when deserialize is false and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool lazy_deserialize;
+
+	/**
+	 * Should list and map bin values be deserialized into memory owned by the record. Nested
+	 * lists, maps and their elements are then allocated from a few large chunks that are freed
+	 * at once by as_record_destroy(), instead of one heap allocation per element. Values must
+	 * not be modified or reserved beyond the lifetime of the record. Values that use msgpack
+	 * extensions are deserialized normally. Ignored when deserialize is false, when
+	 * lazy_deserialize is true and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool arena_deserialize;
+
+	/**
+	 * Merge async single key reads (aerospike_key_get_async() and aerospike_key_select_async())
+	 * on the same event loop into batch commands.  Reads are collected for
+	 * as_policy_event.auto_batch_window_us or until as_policy_event.auto_batch_max_keys reads
+	 * are waiting, then sent as one batch read.  Each read's listener is still called with its
+	 * own record or error.  Only reads with the same policy values are merged.
+	 *
+	 * Reads with a pipe_listener, filter_exp or async_heap_rec are never merged.  This field is
+	 * ignored for sync commands.
+	 *
+	 * Default: false
+	 */
+	bool auto_batch;
+
+	/**
+	 * Client-side record cache usage.  Applies to aerospike_key_get() and
+	 * aerospike_key_select().  Only aerospike_key_get() responses are cached.
+	 * aerospike_key_select() is served from a cached full record.  A filter_exp is applied
+	 * to cached records with as_exp_eval_filter() and the record is read from the server
+	 * when the filter can not be evaluated by the client.  This field is ignored for async
+	 * commands and when as_config.record_cache_max is zero.
+	 *
+	 * Default: AS_POLICY_CACHE_NONE
+	 */
+	as_policy_cache cache;
+
+	/**
+	 * Should aerospike_key_exists(), aerospike_key_get() and aerospike_key_select() return
+	 * AEROSPIKE_ERR_RECORD_NOT_FOUND without contacting the server when the key was
+	 * recently not found by this client.  Misses of these reads are then remembered.  Reads
+	 * with filter_exp do not use the negative cache.  This field is ignored for async
+	 * commands and when as_config.negative_cache_max is zero.
+	 *
+	 * Default: false
+	 */
+	bool negative_cache;
+
+	/**
+	 * Should concurrent identical reads share one server command.  Applies to
+	 * aerospike_key_get(), aerospike_key_select() and their async versions when neither
+	 * pipe_listener nor auto_batch is used.  While a read is in flight, later reads of the same key with the same
+	 * bins and policy values wait for its response instead of sending their own command.
+	 * Each caller still receives its own record, parsed from a copy of the shared response.
+	 *
+	 * A read that joins a flight receives the response to a command that was sent before
+	 * the read was called, so it may miss a write that completed in between.
+	 *
+	 * Default: false
+	 */
+	bool coalesce;
+
+	/**
+	 * Run sync reads on a client event loop instead of the calling thread.  The read uses the
+	 * async connection pools and the calling thread blocks until the command completes, so
+	 * many application threads can share a small number of async connections instead of
+	 * holding one sync connection each.
+	 *
+	 * Only used by aerospike_key_get(), aerospike_key_select() and aerospike_key_exists()
+	 * when event loops have been created, the caller does not supply the record (*rec is
+	 * NULL) and neither cache nor negative_cache apply.  Ignored when called from an event
+	 * loop thread and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
 } as_policy_read;
 	
 /**
@@ -598,6 +806,15 @@ typedef struct as_policy_write_s {
 	 */
 	uint32_t compression_threshold;
 
+	/**
+	 * Minimum string or blob bin value size that is sent directly from the record's memory
+	 * using scatter/gather socket writes instead of being copied into the command buffer.
+	 * Only applies to synchronous puts that are not compressed.  Zero disables gather writes.
+	 *
+	 * Default: 0
+	 */
+	uint32_t gather_threshold;
+
 	/**
 	 * If the transaction results in a record deletion, leave a tombstone for the record.
 	 * This prevents deleted records from reappearing after node failures.
@@ -607,6 +824,17 @@ typedef struct as_policy_write_s {
 	 */
 	bool durable_delete;
 
+	/**
+	 * Run sync writes on a client event loop instead of the calling thread.  The command
+	 * uses the async connection pools and the calling thread blocks until it completes.
+	 *
+	 * Only used by aerospike_key_put() when event loops have been created.  Ignored when called
+	 * from an event loop thread and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
 } as_policy_write;
 
 /**
@@ -741,6 +969,18 @@ typedef struct as_policy_operate_s {
 	 */
 	bool async_heap_rec;
 
+	/**
+	 * Run sync operations on a client event loop instead of the calling thread.  The command
+	 * uses the async connection pools and the calling thread blocks until it completes.
+	 *
+	 * Only used by aerospike_key_operate() when event loops have been created and the caller
+	 * does not supply the record (*rec is NULL).  Ignored when called
+	 * from an event loop thread and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
 } as_policy_operate;
 
 /**
@@ -790,6 +1030,17 @@ typedef struct as_policy_remove_s {
 	 */
 	bool durable_delete;
 
+	/**
+	 * Run sync removes on a client event loop instead of the calling thread.  The command
+	 * uses the async connection pools and the calling thread blocks until it completes.
+	 *
+	 * Only used by aerospike_key_remove() when event loops have been created.  Ignored when called
+	 * from an event loop thread and for async commands.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
 } as_policy_remove;
 
 /**
@@ -821,6 +1072,26 @@ typedef struct as_policy_batch_s {
 	 */
 	as_policy_read_mode_sc read_mode_sc;
 
+	/**
+	 * Maximum number of keys sent in one batch command. Keys mapped to the same node are
+	 * split evenly into multiple commands when this limit is exceeded. Sync sub-commands
+	 * run in parallel when concurrent is true. Async sub-commands always run in parallel.
+	 * Zero means no limit.
+	 *
+	 * Default: 0
+	 */
+	uint32_t max_keys_per_command;
+
+	/**
+	 * Maximum estimated size in bytes of one batch command. Keys mapped to the same node are
+	 * split evenly into multiple commands when the node's estimated command size exceeds
+	 * this limit. Enabling this limit requires an extra sizing pass over each node's keys.
+	 * Zero means no limit.
+	 *
+	 * Default: 0
+	 */
+	uint32_t max_bytes_per_command;
+
 	/**
 	 * Determine if batch commands to each server are run in parallel threads.
 	 *
@@ -841,6 +1112,19 @@ typedef struct as_policy_batch_s {
 	 */
 	bool concurrent;
 
+	/**
+	 * Run concurrent sync batch node commands on a client event loop instead of one thread
+	 * pool thread per node. All node sockets are driven by the event loop and the calling
+	 * thread blocks until every node completes. The thread pool does not need to be sized
+	 * to the cluster.
+	 *
+	 * Only used when concurrent is true and event loops have been created. Ignored when
+	 * called from an event loop thread.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
 	/**
 	 * Allow batch to be processed immediately in the server's receiving thread for in-memory
 	 * namespaces. If false, the batch will always be processed in separate service threads.
@@ -909,6 +1193,59 @@ typedef struct as_policy_batch_s {
 	 */
 	bool deserialize;
 
+	/**
+	 * Allocate bins and bin values of successful as_batch_records results from arena chunks
+	 * owned by the as_batch_records instead of allocating each value separately. One chunk is
+	 * allocated per response block and as_batch_records_destroy() frees all chunks at once.
+	 *
+	 * Arena memory is held until as_batch_records_destroy(), including memory of records that
+	 * were parsed more than once because of retries. Lists and maps are still allocated
+	 * separately when deserialize is true. Ignored when a batch record listener is used and
+	 * by batch APIs that do not return as_batch_records.
+	 *
+	 * Default: false
+	 */
+	bool arena;
+
+	/**
+	 * Records created from the same response block share bin storage whose reference count
+	 * is updated when each record is created and destroyed.  When true, that reference count
+	 * is updated without atomic instructions.  Records of one batch must then be destroyed
+	 * by one thread at a time, which is the case when as_batch_records_destroy() is called.
+	 * Call as_record_share() on a record before handing it to another thread that may
+	 * destroy it while other records of the batch are destroyed.
+	 *
+	 * Reference counts of bin values are maintained by the values themselves and remain
+	 * atomic.  Ignored when arena is true, because arena records do not share bin storage.
+	 *
+	 * Default: false
+	 */
+	bool thread_confined;
+
+	/**
+	 * Split reads of each partition between the master and prole nodes by key digest, so
+	 * large read-only batches load all replicas instead of only the masters.  Keys are still
+	 * grouped into one command per node.  Overrides replica for reads on AP namespaces.
+	 * Writes and reads on SC namespaces are not affected.  On retry, each key alternates to
+	 * the other replica.
+	 *
+	 * Default: false
+	 */
+	bool replica_spread;
+
+	/**
+	 * Allow records of batches that write to be reordered within each node command.  Records
+	 * that share the same operations, bin names, policy or UDF are then sent next to each
+	 * other, so their operations are only sent once.  Read-only batches are always grouped
+	 * this way, because their results do not depend on command order.
+	 *
+	 * The server applies records in command order, so only enable when no two records in
+	 * the batch access the same key.
+	 *
+	 * Default: false
+	 */
+	bool reorder_writes;
+
 } as_policy_batch;
 
 /**
@@ -1119,6 +1456,90 @@ typedef struct as_policy_query_s {
 	 */
 	uint32_t info_timeout;
 
+	/**
+	 * Number of threads that decode records and run the user callback. If greater than zero,
+	 * socket reader threads only copy response blocks into a bounded set of buffers, so a slow
+	 * callback does not stall the socket until those buffers are full. Records of the same
+	 * partition are delivered in order by the same thread, but the callback is called from
+	 * multiple threads at the same time. Zero decodes records in the socket reader thread.
+	 *
+	 * Default: 0
+	 */
+	uint32_t parse_threads;
+
+	/**
+	 * Number of threads that run the client side stage of a stream UDF aggregation in
+	 * aerospike_query_foreach().  If greater than one, node results are spread over up to this
+	 * many partial reducers (at most one per node), each with a bounded input queue, and the
+	 * partial results are combined in a merge tree.  The client side stage then runs more
+	 * than once on the same data, so the stream must end in a reduce() that is associative
+	 * and commutative, with no map() or filter() after it.
+	 *
+	 * Default: 0
+	 */
+	uint32_t aggregate_threads;
+
+	/**
+	 * Async flow control for aerospike_query_async() and aerospike_query_partitions_async().
+	 * When set, node connections stop reading while high_watermark records are buffered
+	 * by the application.  See as_async_flow.  Ignored by sync queries.
+	 *
+	 * Default: NULL
+	 */
+	struct as_async_flow_s* flow;
+
+	/**
+	 * Cancellation handle for aerospike_query_async() and aerospike_query_partitions_async().
+	 * See as_async_cancel.  Ignored by sync queries.
+	 *
+	 * Default: NULL
+	 */
+	struct as_async_cancel_s* cancel;
+
+	/**
+	 * Partition scheduling chunk size for aerospike_query_partitions() and query requests that
+	 * run against all nodes.  If greater than zero, each node command covers at most this
+	 * many partitions and the node's next chunk is sent when the previous chunk completes.
+	 * A node that runs out of partitions takes unsent partitions from the node with the most
+	 * partitions left when it is their replica and the namespace is not in strong consistency
+	 * mode, so the query does not wait on the slowest node.  Ignored when max_records is set
+	 * or query nodes are not run in parallel.  Zero sends all of a node's partitions in one command.
+	 *
+	 * Default: 0
+	 */
+	uint32_t partition_chunk;
+
+	/**
+	 * Checkpoint file for aerospike_scan_partitions() and scan requests that use partition
+	 * tracking.  If set, partition status with the last digest (and bval) of each partition
+	 * is written to this file, so an interrupted scan can be resumed with
+	 * as_partitions_status_load() and as_partition_filter_set_partitions().  A checkpoint is
+	 * written at the end of the scan and, when enabled, every checkpoint_records records and
+	 * every checkpoint_interval ms.  Records delivered after the last checkpoint are returned
+	 * again on resume.  Ignored by async scans.
+	 *
+	 * Default: NULL
+	 */
+	const char* checkpoint_file;
+
+	/**
+	 * Write checkpoint_file after this many records were delivered.  The node thread that
+	 * delivers the record writes the checkpoint.  Zero disables record count checkpoints.
+	 * Ignored when parse_threads is greater than zero, because record cursors are advanced
+	 * before parse threads deliver the records.
+	 *
+	 * Default: 0
+	 */
+	uint32_t checkpoint_records;
+
+	/**
+	 * Write checkpoint_file when this many milliseconds passed since the last checkpoint.
+	 * Zero disables time based checkpoints.  Ignored when parse_threads is greater than zero.
+	 *
+	 * Default: 0
+	 */
+	uint32_t checkpoint_interval;
+
 	/**
 	 * Terminate query if cluster is in migration state. If the server supports partition
 	 * queries or the query filter is null (scan), this field is ignored.
@@ -1145,6 +1566,41 @@ typedef struct as_policy_query_s {
 	 */
 	bool short_query;
 
+	/**
+	 * Should blob and raw (not deserialized) list/map bin values reference the server response
+	 * buffer instead of being copied into separate heap allocations. These bin values are only
+	 * valid until the record callback returns, so the callback must copy any value it retains.
+	 * String and geojson bin values are always copied.
+	 *
+	 * Default: false
+	 */
+	bool zero_copy;
+
+	/**
+	 * Should each node command reuse one record for all records passed to the callback.
+	 * The record's bins array and a string value buffer are retained and only grow, and
+	 * blob and raw list/map bin values reference the server response buffer. The record and
+	 * its values are only valid until the callback returns, so the callback must copy
+	 * anything it retains. Ignored for async commands and when parse_threads is set.
+	 *
+	 * Default: false
+	 */
+	bool reuse_record;
+
+	/**
+	 * Spread the node commands of an async query across all event loops instead of running
+	 * them on the single event loop assigned to the query. Each node command runs on its own
+	 * event loop, so the record listener is called from multiple event loop threads at the
+	 * same time and must be thread-safe. The event_loop argument passed with each record is
+	 * the assigned event loop, not the thread's loop. The final listener call (NULL record)
+	 * always runs on the assigned event loop after every record listener call has returned.
+	 *
+	 * Ignored for sync commands, when flow is set, and when there is only one event loop.
+	 *
+	 * Default: false
+	 */
+	bool spread_loops;
+
 } as_policy_query;
 
 /**
@@ -1177,6 +1633,90 @@ typedef struct as_policy_scan_s {
 	 */
 	uint32_t records_per_second;
 
+	/**
+	 * Number of threads that decode records and run the user callback. If greater than zero,
+	 * socket reader threads only copy response blocks into a bounded set of buffers, so a slow
+	 * callback does not stall the socket until those buffers are full. Records of the same
+	 * partition are delivered in order by the same thread, but the callback is called from
+	 * multiple threads at the same time. Zero decodes records in the socket reader thread.
+	 *
+	 * Default: 0
+	 */
+	uint32_t parse_threads;
+
+	/**
+	 * Async flow control for aerospike_scan_async() and aerospike_scan_partitions_async().
+	 * When set, node connections stop reading while high_watermark records are buffered
+	 * by the application.  See as_async_flow.  Ignored by sync scans.
+	 *
+	 * Default: NULL
+	 */
+	struct as_async_flow_s* flow;
+
+	/**
+	 * Cancellation handle for aerospike_scan_async() and aerospike_scan_partitions_async().
+	 * See as_async_cancel.  Ignored by sync scans.
+	 *
+	 * Default: NULL
+	 */
+	struct as_async_cancel_s* cancel;
+
+	/**
+	 * Partition scheduling chunk size for aerospike_scan_partitions() and scan requests that
+	 * run against all nodes.  If greater than zero, each node command covers at most this
+	 * many partitions and the node's next chunk is sent when the previous chunk completes.
+	 * A node that runs out of partitions takes unsent partitions from the node with the most
+	 * partitions left when it is their replica and the namespace is not in strong consistency
+	 * mode, so the scan does not wait on the slowest node.  Ignored when max_records is set
+	 * or scan nodes are not run in parallel.  Zero sends all of a node's partitions in one command.
+	 *
+	 * Default: 0
+	 */
+	uint32_t partition_chunk;
+
+	/**
+	 * Number of connections and worker threads used to scan each node's partitions in
+	 * aerospike_scan_partitions() and scan requests that run against all nodes.  A node's
+	 * partitions are split into streams_per_node groups that are scanned in parallel, so one
+	 * connection and parse thread do not cap the throughput of a single node.  When
+	 * partition_chunk is zero, each group holds an equal share of the node's partitions.
+	 * Ignored when max_records is set, when the scan is not concurrent and by async scans.
+	 *
+	 * Default: 1
+	 */
+	uint32_t streams_per_node;
+
+	/**
+	 * Checkpoint file for aerospike_query_partitions() and query requests that use partition
+	 * tracking.  If set, partition status with the last digest (and bval) of each partition
+	 * is written to this file, so an interrupted query can be resumed with
+	 * as_partitions_status_load() and as_partition_filter_set_partitions().  A checkpoint is
+	 * written at the end of the query and, when enabled, every checkpoint_records records and
+	 * every checkpoint_interval ms.  Records delivered after the last checkpoint are returned
+	 * again on resume.  Ignored by async querys.
+	 *
+	 * Default: NULL
+	 */
+	const char* checkpoint_file;
+
+	/**
+	 * Write checkpoint_file after this many records were delivered.  The node thread that
+	 * delivers the record writes the checkpoint.  Zero disables record count checkpoints.
+	 * Ignored when parse_threads is greater than zero, because record cursors are advanced
+	 * before parse threads deliver the records.
+	 *
+	 * Default: 0
+	 */
+	uint32_t checkpoint_records;
+
+	/**
+	 * Write checkpoint_file when this many milliseconds passed since the last checkpoint.
+	 * Zero disables time based checkpoints.  Ignored when parse_threads is greater than zero.
+	 *
+	 * Default: 0
+	 */
+	uint32_t checkpoint_interval;
+
 	/**
 	 * If the transaction results in a record deletion, leave a tombstone for the record.
 	 * This prevents deleted records from reappearing after node failures.
@@ -1186,6 +1726,53 @@ typedef struct as_policy_scan_s {
 	 */
 	bool durable_delete;
 
+	/**
+	 * Should blob and raw (not deserialized) list/map bin values reference the server response
+	 * buffer instead of being copied into separate heap allocations. These bin values are only
+	 * valid until the record callback returns, so the callback must copy any value it retains.
+	 * String and geojson bin values are always copied.
+	 *
+	 * Default: false
+	 */
+	bool zero_copy;
+
+	/**
+	 * Should each node command reuse one record for all records passed to the callback.
+	 * The record's bins array and a string value buffer are retained and only grow, and
+	 * blob and raw list/map bin values reference the server response buffer. The record and
+	 * its values are only valid until the callback returns, so the callback must copy
+	 * anything it retains. Ignored for async commands and when parse_threads is set.
+	 *
+	 * Default: false
+	 */
+	bool reuse_record;
+
+	/**
+	 * Run concurrent sync scan node commands on a client event loop instead of one thread
+	 * pool thread per node. The calling thread blocks until the scan completes. Records are
+	 * passed to the callback from the event loop thread, one record at a time.
+	 *
+	 * Only used by aerospike_scan_foreach() when as_scan.concurrent is true and event loops
+	 * have been created. Ignored when called from an event loop thread.
+	 *
+	 * Default: false
+	 */
+	bool multiplex;
+
+	/**
+	 * Spread the node commands of an async scan across all event loops instead of running
+	 * them on the single event loop assigned to the scan. Each node command runs on its own
+	 * event loop, so the record listener is called from multiple event loop threads at the
+	 * same time and must be thread-safe. The event_loop argument passed with each record is
+	 * the assigned event loop, not the thread's loop. The final listener call (NULL record)
+	 * always runs on the assigned event loop after every record listener call has returned.
+	 *
+	 * Ignored for sync commands, when flow is set, and when there is only one event loop.
+	 *
+	 * Default: false
+	 */
+	bool spread_loops;
+
 } as_policy_scan;
 
 /**
@@ -1323,6 +1910,8 @@ as_policy_base_read_init(as_policy_base* p)
 	p->sleep_between_retries = 0;
 	p->filter_exp = NULL;
 	p->compress = false;
+	p->read_spin_us = 0;
+	p->priority = AS_POLICY_PRIORITY_NORMAL;
 }
 
 /**
@@ -1337,6 +1926,8 @@ as_policy_base_write_init(as_policy_base* p)
 	p->sleep_between_retries = 0;
 	p->filter_exp = NULL;
 	p->compress = false;
+	p->read_spin_us = 0;
+	p->priority = AS_POLICY_PRIORITY_NORMAL;
 }
 
 /**
@@ -1364,6 +1955,8 @@ as_policy_base_query_init(as_policy_base* p)
 	p->sleep_between_retries = 0;
 	p->filter_exp = NULL;
 	p->compress = false;
+	p->read_spin_us = 0;
+	p->priority = AS_POLICY_PRIORITY_NORMAL;
 }
 
 /**
@@ -1382,8 +1975,18 @@ as_policy_read_init(as_policy_read* p)
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->read_mode_ap = AS_POLICY_READ_MODE_AP_DEFAULT;
 	p->read_mode_sc = AS_POLICY_READ_MODE_SC_DEFAULT;
+	p->hedge_delay = 0;
+	p->hedge_max = 16;
 	p->deserialize = true;
 	p->async_heap_rec = false;
+	p->zero_copy = false;
+	p->lazy_deserialize = false;
+	p->arena_deserialize = false;
+	p->auto_batch = false;
+	p->cache = AS_POLICY_CACHE_NONE;
+	p->negative_cache = false;
+	p->coalesce = false;
+	p->multiplex = false;
 	return p;
 }
 
@@ -1419,7 +2022,9 @@ as_policy_write_init(as_policy_write* p)
 	p->gen = AS_POLICY_GEN_DEFAULT;
 	p->exists = AS_POLICY_EXISTS_DEFAULT;
 	p->compression_threshold = AS_POLICY_COMPRESSION_THRESHOLD_DEFAULT;
+	p->gather_threshold = 0;
 	p->durable_delete = false;
+	p->multiplex = false;
 	return p;
 }
 
@@ -1459,6 +2064,7 @@ as_policy_operate_init(as_policy_operate* p)
 	p->deserialize = true;
 	p->durable_delete = false;
 	p->async_heap_rec = false;
+	p->multiplex = false;
 	return p;
 }
 
@@ -1494,6 +2100,7 @@ as_policy_remove_init(as_policy_remove* p)
 	p->gen = AS_POLICY_GEN_DEFAULT;
 	p->generation = 0;
 	p->durable_delete = false;
+	p->multiplex = false;
 	return p;
 }
 
@@ -1560,12 +2167,19 @@ as_policy_batch_init(as_policy_batch* p)
 	p->replica = AS_POLICY_REPLICA_SEQUENCE;
 	p->read_mode_ap = AS_POLICY_READ_MODE_AP_DEFAULT;
 	p->read_mode_sc = AS_POLICY_READ_MODE_SC_DEFAULT;
+	p->max_keys_per_command = 0;
+	p->max_bytes_per_command = 0;
 	p->concurrent = false;
+	p->multiplex = false;
 	p->allow_inline = true;
 	p->allow_inline_ssd = false;
 	p->respond_all_keys = true;
 	p->send_set_name = true;
 	p->deserialize = true;
+	p->arena = false;
+	p->thread_confined = false;
+	p->replica_spread = false;
+	p->reorder_writes = false;
 	return p;
 }
 
@@ -1673,7 +2287,19 @@ as_policy_scan_init(as_policy_scan* p)
 	as_policy_base_query_init(&p->base);
 	p->max_records = 0;
 	p->records_per_second = 0;
+	p->parse_threads = 0;
+	p->flow = NULL;
+	p->cancel = NULL;
+	p->partition_chunk = 0;
+	p->streams_per_node = 1;
+	p->checkpoint_file = NULL;
+	p->checkpoint_records = 0;
+	p->checkpoint_interval = 0;
 	p->durable_delete = false;
+	p->zero_copy = false;
+	p->reuse_record = false;
+	p->multiplex = false;
+	p->spread_loops = false;
 	return p;
 }
 
@@ -1704,9 +2330,20 @@ as_policy_query_init(as_policy_query* p)
 {
 	as_policy_base_query_init(&p->base);
 	p->info_timeout = 10000;
+	p->parse_threads = 0;
+	p->aggregate_threads = 0;
+	p->flow = NULL;
+	p->cancel = NULL;
+	p->partition_chunk = 0;
+	p->checkpoint_file = NULL;
+	p->checkpoint_records = 0;
+	p->checkpoint_interval = 0;
 	p->fail_on_cluster_change = false;
 	p->deserialize = true;
 	p->short_query = false;
+	p->zero_copy = false;
+	p->reuse_record = false;
+	p->spread_loops = false;
 	return p;
 }
 
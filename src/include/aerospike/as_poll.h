@@ -100,6 +100,102 @@ as_poll_socket(as_poll* poll, as_socket_fd fd, uint32_t timeout, bool read)
 	return rv;
 }
 
+// Wait for either socket to become readable. Poll must be initialized with the larger fd.
+// Return bit 0 set if fd1 is readable and bit 1 set if fd2 is readable.
+static inline int
+as_poll_sockets_read(as_poll* poll, as_socket_fd fd1, as_socket_fd fd2, uint32_t timeout)
+{
+	memset(poll->set, 0, poll->size);
+	FD_SET(fd1 % FD_SETSIZE, &poll->set[fd1 / FD_SETSIZE]);
+	FD_SET(fd2 % FD_SETSIZE, &poll->set[fd2 / FD_SETSIZE]);
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	as_socket_fd max = (fd1 > fd2)? fd1 : fd2;
+	int rv = select(max + 1, poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	if (FD_ISSET(fd1 % FD_SETSIZE, &poll->set[fd1 / FD_SETSIZE])) {
+		rv |= 1;
+	}
+
+	if (FD_ISSET(fd2 % FD_SETSIZE, &poll->set[fd2 / FD_SETSIZE])) {
+		rv |= 2;
+	}
+	return rv;
+}
+
+// Wait for any socket fds[i] with wait[i] set to become readable. Poll must be initialized
+// with the largest fd. Set ready[i] for each readable socket and return the number of readable
+// sockets.
+static inline int
+as_poll_sockets_read_many(
+	as_poll* poll, const as_socket_fd* fds, const bool* wait, bool* ready, uint32_t n,
+	uint32_t timeout
+	)
+{
+	memset(poll->set, 0, poll->size);
+
+	as_socket_fd max = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_socket_fd fd = fds[i];
+
+		if (wait[i]) {
+			FD_SET(fd % FD_SETSIZE, &poll->set[fd / FD_SETSIZE]);
+
+			if (fd > max) {
+				max = fd;
+			}
+		}
+	}
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	int rv = select(max + 1, poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_socket_fd fd = fds[i];
+		ready[i] = wait[i] && FD_ISSET(fd % FD_SETSIZE, &poll->set[fd / FD_SETSIZE]);
+
+		if (ready[i]) {
+			rv++;
+		}
+	}
+	return rv;
+}
+
 static inline void
 as_poll_destroy(as_poll* poll)
 {
@@ -148,6 +244,91 @@ as_poll_socket(as_poll* poll, as_socket_fd fd, uint32_t timeout, bool read)
 	return rv;
 }
 
+// Wait for either socket to become readable.
+// Return bit 0 set if fd1 is readable and bit 1 set if fd2 is readable.
+static inline int
+as_poll_sockets_read(as_poll* poll, as_socket_fd fd1, as_socket_fd fd2, uint32_t timeout)
+{
+	FD_ZERO(&poll->set);
+	FD_SET(fd1, &poll->set);
+	FD_SET(fd2, &poll->set);
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	int rv = select(0, &poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	if (FD_ISSET(fd1, &poll->set)) {
+		rv |= 1;
+	}
+
+	if (FD_ISSET(fd2, &poll->set)) {
+		rv |= 2;
+	}
+	return rv;
+}
+
+// Wait for any socket fds[i] with wait[i] set to become readable.
+// Set ready[i] for each readable socket and return the number of readable sockets.
+static inline int
+as_poll_sockets_read_many(
+	as_poll* poll, const as_socket_fd* fds, const bool* wait, bool* ready, uint32_t n,
+	uint32_t timeout
+	)
+{
+	FD_ZERO(&poll->set);
+
+	for (uint32_t i = 0; i < n; i++) {
+		if (wait[i]) {
+			FD_SET(fds[i], &poll->set);
+		}
+	}
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	int rv = select(0, &poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		ready[i] = wait[i] && FD_ISSET(fds[i], &poll->set);
+
+		if (ready[i]) {
+			rv++;
+		}
+	}
+	return rv;
+}
+
 #define as_poll_destroy(_poll)
 
 #endif
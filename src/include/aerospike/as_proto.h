@@ -39,6 +39,9 @@ extern "C" {
 #define AS_COMPRESSED_MESSAGE_TYPE 4
 #define PROTO_SIZE_MAX (128 * 1024 * 1024)
 
+// Records indexed without heap allocation.
+#define AS_MSG_INDEX_INLINE 128
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -121,6 +124,17 @@ typedef struct as_proto_msg_s {
 
 #endif
 
+// Record boundaries of a multi-record response block. Headers of indexed records have been
+// swapped to host byte order. Destroy the index after as_msg_index_build(), even on error.
+typedef struct as_msg_index_s {
+	as_msg** msgs;
+	uint32_t size;
+	uint32_t capacity;
+	uint32_t n_records;	// Records with bins before the last message.
+	uint32_t n_bins;	// Bins of those records.
+	as_msg* inline_msgs[AS_MSG_INDEX_INLINE];
+} as_msg_index;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -134,6 +148,8 @@ as_status as_proto_size_error(as_error* err, size_t size);
 as_status as_compressed_size_error(as_error* err, size_t size);
 as_status as_proto_parse(as_error* err, as_proto* proto);
 as_status as_proto_decompress(as_error* err, uint8_t* trg, size_t trg_sz, uint8_t* src, size_t src_sz);
+as_status as_msg_index_build(as_error* err, as_msg_index* index, uint8_t* buf, size_t size);
+void as_msg_index_destroy(as_msg_index* index);
 
 static inline as_status
 as_proto_parse_type(as_error* err, as_proto* proto, uint8_t expected_type)
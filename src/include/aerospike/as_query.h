@@ -107,12 +107,35 @@ extern "C" {
 
 #define as_geo_contains(__val) AS_PREDICATE_RANGE, AS_INDEX_TYPE_DEFAULT, AS_INDEX_GEO2DSPHERE, __val
 
+/**
+ * Macro for setting a geospatial predicate on a prepared as_geo_region.  The region is
+ * not copied and must remain valid until the query is destroyed.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_query_where(query, "loc", as_geo_within_region(&region));
+ * ~~~~~~~~~~
+ *
+ * @relates as_query
+ * @ingroup query_object
+ */
+#define as_geo_within_region(__region) AS_PREDICATE_GEO_REGION, AS_INDEX_TYPE_DEFAULT, AS_INDEX_GEO2DSPHERE, (struct as_geo_region_s*)(__region)
+
+/**
+ * Macro for setting a geospatial predicate on a prepared as_geo_region.  The region is
+ * not copied and must remain valid until the query is destroyed.
+ *
+ * @relates as_query
+ * @ingroup query_object
+ */
+#define as_geo_contains_region(__region) AS_PREDICATE_GEO_REGION, AS_INDEX_TYPE_DEFAULT, AS_INDEX_GEO2DSPHERE, (struct as_geo_region_s*)(__region)
+
 
 /******************************************************************************
  * TYPES 	
  *****************************************************************************/
 
 struct as_operations_s;
+struct as_geo_region_s;
 
 /**
  * Union of supported predicates
@@ -146,6 +169,11 @@ typedef union as_predicate_value_u {
 
 	} integer_range;
 
+	/**
+	 * Prepared geospatial region
+	 */
+	struct as_geo_region_s* geo_region;
+
 } as_predicate_value;
 
 /**
@@ -159,7 +187,13 @@ typedef enum as_predicate_type_e {
 	 */
 	AS_PREDICATE_EQUAL,
 
-	AS_PREDICATE_RANGE
+	AS_PREDICATE_RANGE,
+
+	/**
+	 * Geospatial predicate on a prepared region.
+	 * Requires as_predicate_value.geo_region to be set.
+	 */
+	AS_PREDICATE_GEO_REGION
 } as_predicate_type;
 
 /**
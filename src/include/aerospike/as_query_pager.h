@@ -0,0 +1,187 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/aerospike_query.h>
+#include <aerospike/as_partition_filter.h>
+#include <aerospike/as_vector.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Paginated partition query that fetches the next page in a background thread while the
+ * application processes the current page. At most one page of records is buffered.
+ *
+ * The query must set max_records (page size). The pager owns the query's pagination state,
+ * so the query must not be used by other commands until the pager is destroyed.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_query query;
+ * as_query_init(&query, "test", "demo");
+ * query.max_records = 1000;
+ *
+ * as_query_pager pager;
+ *
+ * if (as_query_pager_init(&pager, &as, &err, NULL, &query, NULL) == AEROSPIKE_OK) {
+ *     while (! as_query_pager_done(&pager)) {
+ *         if (as_query_pager_next(&pager, &err, callback, NULL) != AEROSPIKE_OK) {
+ *             break;
+ *         }
+ *     }
+ *     as_query_pager_destroy(&pager);
+ * }
+ * as_query_destroy(&query);
+ * ~~~~~~~~~~
+ *
+ * @ingroup query_operations
+ */
+typedef struct as_query_pager_s {
+	/**
+	 * @private
+	 */
+	aerospike* as;
+
+	/**
+	 * @private
+	 */
+	as_query* query;
+
+	/**
+	 * @private
+	 * Records of the page being fetched.
+	 */
+	as_vector records;
+
+	/**
+	 * @private
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @private
+	 */
+	pthread_t thread;
+
+	/**
+	 * @private
+	 */
+	as_policy_query policy;
+
+	/**
+	 * @private
+	 */
+	as_partition_filter pf;
+
+	/**
+	 * @private
+	 * Error of the page being fetched.
+	 */
+	as_error err;
+
+	/**
+	 * @private
+	 */
+	as_status status;
+
+	/**
+	 * @private
+	 * Set while a page fetch thread has not been joined.
+	 */
+	bool running;
+
+	/**
+	 * @private
+	 * Set when the last page has been delivered.
+	 */
+	bool done;
+} as_query_pager;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize query pager. If pf is NULL, all partitions are queried. Fetching starts on
+ * the first call to as_query_pager_next().
+ *
+ * @param pager			Query pager.
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for page queries. If NULL, then the default policy will be used.
+ * @param query			The query with max_records set to the page size.
+ * @param pf			Partition filter or NULL.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN as_status
+as_query_pager_init(
+	as_query_pager* pager, aerospike* as, as_error* err, const as_policy_query* policy,
+	as_query* query, const as_partition_filter* pf
+	);
+
+/**
+ * Deliver the next page to callback, then start fetching the following page in the
+ * background. If the page has not been prefetched, wait for it. The callback is called
+ * with a NULL value after the last record of the page and is always called from the
+ * calling thread.
+ *
+ * @param pager			Query pager.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param callback		The function to be called for each record of the page.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred and the page can be
+ * requested again.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN as_status
+as_query_pager_next(
+	as_query_pager* pager, as_error* err, aerospike_query_foreach_callback callback, void* udata
+	);
+
+/**
+ * Wait for a running page fetch and free buffered records.
+ *
+ * @ingroup query_operations
+ */
+AS_EXTERN void
+as_query_pager_destroy(as_query_pager* pager);
+
+/**
+ * Has the last page been delivered?
+ *
+ * @ingroup query_operations
+ */
+static inline bool
+as_query_pager_done(as_query_pager* pager)
+{
+	return pager->done;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
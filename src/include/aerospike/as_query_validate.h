@@ -27,6 +27,7 @@ extern "C" {
  *****************************************************************************/
 
 struct as_node_s;
+struct as_nodes_s;
 struct as_event_executor;
 struct as_event_command;
 struct as_event_loop;
@@ -45,6 +46,17 @@ as_query_validate_begin(
 	uint64_t* cluster_key
 	);
 
+/**
+ * @private
+ * Verify migrations are not occurring on all nodes and obtain cluster key.  Requests are sent
+ * to all nodes before responses are read, and every node must report the same cluster key.
+ */
+as_status
+as_query_validate_begin_nodes(
+	as_error* err, struct as_nodes_s* nodes, const as_namespace ns, uint32_t timeout,
+	uint64_t* cluster_key
+	);
+
 /**
  * @private
  * Verify migrations are not occurring and expected cluster key has not changed.
@@ -57,7 +69,8 @@ as_query_validate(
 
 /**
  * @private
- * Verify migrations are not occurring and obtain cluster key in async mode.
+ * Verify migrations are not occurring and obtain cluster key from all nodes in parallel in
+ * async mode.  Then execute query.
  */
 as_status
 as_query_validate_begin_async(
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of independently locked flight table shards.  Must be a power of 2.
+ */
+#define AS_READ_COALESCE_SHARDS 16
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Table of single record reads that are in flight, keyed by the encoded read command.  The
+ * command bytes include the digest, requested bins and every policy value sent to the
+ * server, so only reads that would receive the same response are coalesced.
+ */
+typedef struct as_read_coalesce_s as_read_coalesce;
+
+/**
+ * @private
+ * Read in flight.  The first caller (leader) sends the command and later identical callers
+ * (followers) receive a copy of the leader's response.  Responses are kept as the raw message
+ * received from the server and parsed again by every follower, so records are never shared.
+ */
+typedef struct as_read_flight_s as_read_flight;
+
+/**
+ * @private
+ * Follower callback.  buf is a copy of the leader's response that the callback must free with
+ * cf_free(), or NULL when no response was received.  In that case, status and err hold the
+ * leader's error.  Called from the thread that completed the flight.
+ */
+typedef void (*as_read_flight_listener)(
+	as_error* err, as_status status, uint8_t* buf, uint32_t size, void* udata
+	);
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create empty flight table.
+ */
+as_read_coalesce*
+as_read_coalesce_create(void);
+
+/**
+ * @private
+ * Destroy flight table.  All flights must have completed.
+ */
+void
+as_read_coalesce_destroy(as_read_coalesce* rc);
+
+/**
+ * @private
+ * Join the flight of an identical read or start a new one.  Set leader to true when the
+ * caller started the flight and must send the command and call as_read_flight_complete().
+ * Otherwise, the caller must call as_read_flight_wait() or as_read_flight_listen().
+ */
+as_read_flight*
+as_read_coalesce_join(as_read_coalesce* rc, const uint8_t* cmd, size_t size, bool* leader);
+
+/**
+ * @private
+ * Leader only.  Keep a copy of the response before it is parsed.
+ */
+void
+as_read_flight_set_response(as_read_flight* flight, const uint8_t* buf, size_t size);
+
+/**
+ * @private
+ * Leader only.  Remove flight from the table, so new reads start a new flight, and pass the
+ * response or error to all followers.
+ */
+void
+as_read_flight_complete(as_read_flight* flight, as_error* err, as_status status);
+
+/**
+ * @private
+ * Follower only.  Block until the leader completes or timeout_ms expires.  A timeout_ms of
+ * zero waits without limit.  If a response was received, set buf to a copy that the caller
+ * must parse and free with cf_free().  Otherwise, set buf to NULL and return the leader's
+ * error, or AEROSPIKE_ERR_TIMEOUT when the wait expired first.
+ */
+as_status
+as_read_flight_wait(
+	as_read_flight* flight, as_error* err, uint32_t timeout_ms, uint8_t** buf, uint32_t* size
+	);
+
+/**
+ * @private
+ * Follower only.  Call listener when the leader completes.  The listener is called
+ * immediately when the leader has already completed.
+ */
+void
+as_read_flight_listen(as_read_flight* flight, as_read_flight_listener listener, void* udata);
+
+/**
+ * @private
+ * Return number of reads in flight.
+ */
+uint32_t
+as_read_coalesce_size(as_read_coalesce* rc);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -22,6 +22,7 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_msgpack_array.h>
 #include <aerospike/as_rec.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_geojson.h>
@@ -205,8 +206,47 @@ typedef struct as_record_s {
 	 */
 	as_bins bins;
 
+	/**
+	 * @private
+	 * Response buffer referenced by zero copy bin values.
+	 * Freed when the record is destroyed.
+	 */
+	void* buffer;
+
+	/**
+	 * @private
+	 * Raw list/map bin values are deserialized on first access.
+	 * See as_policy_read.lazy_deserialize.
+	 */
+	bool lazy;
+
+	/**
+	 * @private
+	 * Arena chunks that hold deserialized list/map bin values.
+	 * Freed when the record is destroyed.  See as_policy_read.arena_deserialize.
+	 */
+	struct as_arena_chunk_s* arena;
+
 } as_record;
 
+/**
+ * @private
+ * Bin storage shared by many records, so records created in bulk from one response do not
+ * allocate their bins one at a time.  Each record's bins are preceded by a pointer back to
+ * the block.  The block is freed when the creator and all records released it.
+ */
+typedef struct as_bin_block_s {
+	uint32_t ref_count;
+	uint32_t capacity;
+	uint32_t size;
+
+	/**
+	 * All records of the block are created and destroyed by one thread at a time, so the
+	 * reference count is not updated atomically.  Cleared by as_record_share().
+	 */
+	bool confined;
+} as_bin_block;
+
 /**
  * When the record is given a TTL value of ZERO, it will adopt the TTL value
  * that is the default TTL value for the namespace (defined in the config file).
@@ -315,6 +355,48 @@ as_record_init(as_record* rec, uint16_t nbins);
 AS_EXTERN void
 as_record_destroy(as_record* rec);
 
+/**
+ * Allow the record to be destroyed by another thread while records returned by the same
+ * batch are destroyed by this thread.  Only required when as_policy_batch.thread_confined
+ * is true.  Call before handing the record to the other thread.
+ *
+ * @param rec The record to share.
+ *
+ * @relates as_record
+ */
+AS_EXTERN void
+as_record_share(as_record* rec);
+
+/**
+ * @private
+ * Create bin block with room for n_bins bins in up to n_records records.
+ */
+AS_EXTERN as_bin_block*
+as_bin_block_create(uint32_t n_records, uint32_t n_bins);
+
+/**
+ * @private
+ * Release reference to bin block.
+ */
+AS_EXTERN void
+as_bin_block_release(as_bin_block* block);
+
+/**
+ * @private
+ * Initialize record with bins taken from block.  Fall back to as_record_init() when the block
+ * is NULL or full.
+ */
+AS_EXTERN as_record*
+as_record_init_block(as_record* rec, as_bin_block* block, uint16_t nbins);
+
+/**
+ * @private
+ * Free or release bin storage without destroying bin values.  The record has no bins
+ * afterwards.
+ */
+AS_EXTERN void
+as_record_free_entries(as_record* rec);
+
 /**
  * Get the number of bins in the record.
  *
@@ -703,6 +785,26 @@ as_record_set_map(as_record* rec, const as_bin_name name, as_map * value);
 AS_EXTERN bool
 as_record_set_nil(as_record* rec, const as_bin_name name);
 
+/**
+ * Set the value of the bin with an interned name.  The name is not measured or compared
+ * one character at a time.
+ *
+ * ~~~~~~~~~~{.c}
+ * const as_bin_handle* bin = as_bin_handle_intern("bin");
+ * as_record_set_handle(rec, bin, (as_bin_value*)as_integer_new(123));
+ * ~~~~~~~~~~
+ *
+ * @param rec		The record containing the bin.
+ * @param handle	The interned name of the bin. See as_bin_handle_intern().
+ * @param value		The value of the bin.
+ *
+ * @return true on success, false on failure.
+ *
+ * @relates as_record
+ */
+AS_EXTERN bool
+as_record_set_handle(as_record* rec, const as_bin_handle* handle, as_bin_value* value);
+
 /**
  * Get specified bin's value.
  *
@@ -720,6 +822,31 @@ as_record_set_nil(as_record* rec, const as_bin_name name);
 AS_EXTERN as_bin_value*
 as_record_get(const as_record* rec, const as_bin_name name);
 
+/**
+ * @private
+ * Return bin value. Deserialize raw list/map value first if the record is lazy.
+ */
+AS_EXTERN as_bin_value*
+as_record_bin_value(const as_record* rec, as_bin* bin);
+
+/**
+ * Get the value of the bin with an interned name.
+ *
+ * ~~~~~~~~~~{.c}
+ * const as_bin_handle* bin = as_bin_handle_intern("bin");
+ * as_val * value = (as_val*)as_record_get_handle(rec, bin);
+ * ~~~~~~~~~~
+ *
+ * @param rec		The record containing the bin.
+ * @param handle	The interned name of the bin. See as_bin_handle_intern().
+ *
+ * @return the value if it exists, otherwise NULL.
+ *
+ * @relates as_record
+ */
+AS_EXTERN as_bin_value*
+as_record_get_handle(const as_record* rec, const as_bin_handle* handle);
+
 /**
  * Get specified bin's value as a bool.
  *
@@ -926,6 +1053,63 @@ as_record_get_list(const as_record* rec, const as_bin_name name);
 AS_EXTERN as_map*
 as_record_get_map(const as_record* rec, const as_bin_name name);
 
+/**
+ * Copy list bin of integers into a caller supplied array.  If the list has not been
+ * deserialized (see as_policy_read.lazy_deserialize and as_policy_read.deserialize), it is
+ * decoded directly from the raw bytes without creating list element values.
+ *
+ * ~~~~~~~~~~{.c}
+ * int64_t values[100];
+ * uint32_t size;
+ *
+ * if (as_record_get_int64_array(rec, "bin", values, 100, &size)) {
+ *     // Use values[0] .. values[size - 1].
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param rec		The record containing the bin.
+ * @param name		The name of the bin.
+ * @param values	Array that receives the list elements.
+ * @param capacity	Number of elements the array can hold.
+ * @param size		Number of elements in the list.
+ *
+ * @return true if all elements were copied.  Return false if the bin does not exist, is not
+ * a list or contains other types.  Also return false when the list has more than capacity
+ * elements, in which case size is set so the call can be repeated with a larger array.
+ *
+ * @relates as_record
+ */
+AS_EXTERN bool
+as_record_get_int64_array(
+	const as_record* rec, const as_bin_name name, int64_t* values, uint32_t capacity,
+	uint32_t* size
+	);
+
+/**
+ * Copy list bin of doubles into a caller supplied array.
+ * See as_record_get_int64_array().
+ *
+ * @relates as_record
+ */
+AS_EXTERN bool
+as_record_get_double_array(
+	const as_record* rec, const as_bin_name name, double* values, uint32_t capacity,
+	uint32_t* size
+	);
+
+/**
+ * Fill caller supplied array with views of a list bin of strings or blobs.
+ * See as_record_get_int64_array().  Views point into the record and are valid until the
+ * record is destroyed or the bin value is retrieved with as_record_get().
+ *
+ * @relates as_record
+ */
+AS_EXTERN bool
+as_record_get_bytes_array(
+	const as_record* rec, const as_bin_name name, as_bytes_view* values, uint32_t capacity,
+	uint32_t* size
+	);
+
 /**
  * Get the value returned by a UDF apply in a batch.
  * The result may be null.
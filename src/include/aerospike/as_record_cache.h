@@ -0,0 +1,120 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of independently locked cache shards.  Must be a power of 2.
+ */
+#define AS_RECORD_CACHE_SHARDS 16
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Bounded in-process cache of full record read responses, keyed by namespace and digest.
+ * Responses are stored as the raw message received from the server and parsed again on
+ * every hit, so cached records are never shared with the caller.
+ */
+typedef struct as_record_cache_s as_record_cache;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create cache holding at most max_records records for at most ttl_ms milliseconds each.
+ */
+as_record_cache*
+as_record_cache_create(uint32_t max_records, uint32_t ttl_ms);
+
+/**
+ * @private
+ * Destroy cache and free all records.
+ */
+void
+as_record_cache_destroy(as_record_cache* cache);
+
+/**
+ * @private
+ * Return version of the shard that holds the digest.  Pass the version returned before a
+ * read is sent to as_record_cache_put(), so responses that raced with a local write are
+ * not cached.
+ */
+uint64_t
+as_record_cache_version(as_record_cache* cache, const uint8_t* digest);
+
+/**
+ * @private
+ * Copy cached response into a new heap buffer that the caller must free with cf_free().
+ * Return false if the record is not cached or has expired.
+ */
+bool
+as_record_cache_get(
+	as_record_cache* cache, const char* ns, const uint8_t* digest, uint8_t** buf,
+	uint32_t* size, uint32_t* gen
+	);
+
+/**
+ * @private
+ * Cache a copy of the response.  The response is dropped if the shard version changed
+ * since version was read.
+ */
+void
+as_record_cache_put(
+	as_record_cache* cache, const char* ns, const uint8_t* digest, const uint8_t* buf,
+	uint32_t size, uint32_t gen, uint64_t version
+	);
+
+/**
+ * @private
+ * Reset the time to live of a cached record after its generation was validated.
+ */
+void
+as_record_cache_touch(as_record_cache* cache, const char* ns, const uint8_t* digest);
+
+/**
+ * @private
+ * Remove record because it was written or no longer exists.  Also invalidates reads of the
+ * same shard that are in flight.
+ */
+void
+as_record_cache_remove(as_record_cache* cache, const char* ns, const uint8_t* digest);
+
+/**
+ * @private
+ * Return number of cached records.
+ */
+uint32_t
+as_record_cache_size(as_record_cache* cache);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
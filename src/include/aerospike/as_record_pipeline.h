@@ -0,0 +1,156 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_proto.h>
+#include <aerospike/as_std.h>
+#include <citrusleaf/cf_queue.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Raw message blocks available to socket reader threads per parse thread.
+ */
+#define AS_RECORD_PIPELINE_BLOCKS_PER_THREAD 4
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Decode one record message and run the user callback.  p points to the message fields.
+ */
+typedef as_status (*as_record_pipeline_parse_fn)(void* udata, as_msg* msg, uint8_t* p, as_error* err);
+
+/**
+ * @private
+ * Copy of one raw response block.  The block returns to the free list when the reader and
+ * every queued record in the block are done with it.
+ */
+typedef struct as_record_pipeline_block_s {
+	uint8_t* buf;
+	size_t capacity;
+	uint32_t refs;
+} as_record_pipeline_block;
+
+/**
+ * @private
+ * Scan/query record pipeline.  Socket reader threads copy response blocks into a bounded set
+ * of blocks and queue each record to the parse thread that owns the record's partition, so
+ * records of the same partition are delivered in order.  Parse threads decode records and
+ * run the user callback.
+ */
+typedef struct as_record_pipeline_s {
+	as_record_pipeline_parse_fn parse_fn;
+	void* udata;
+	pthread_t* threads;
+	cf_queue** queues;
+	as_record_pipeline_block* blocks;
+	as_record_pipeline_block** free_blocks;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	as_error err;
+	as_status status;
+	uint32_t n_threads;
+	uint32_t n_blocks;
+	uint32_t n_free;
+	uint32_t error;
+} as_record_pipeline;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Start parse threads.  Returns zero on success.
+ */
+int
+as_record_pipeline_init(
+	as_record_pipeline* pl, uint32_t n_threads, as_record_pipeline_parse_fn parse_fn, void* udata
+	);
+
+/**
+ * @private
+ * Stop parse threads and free resources.  All blocks must have been released.
+ */
+void
+as_record_pipeline_destroy(as_record_pipeline* pl);
+
+/**
+ * @private
+ * Wait for a free block and copy a raw response block into it.  The caller holds one
+ * reference until as_record_pipeline_release().
+ */
+as_record_pipeline_block*
+as_record_pipeline_copy(as_record_pipeline* pl, const uint8_t* buf, size_t size);
+
+/**
+ * @private
+ * Queue record message in block to the parse thread that owns the record's partition.
+ */
+void
+as_record_pipeline_push(
+	as_record_pipeline* pl, as_record_pipeline_block* block, as_msg* msg, uint32_t part_id
+	);
+
+/**
+ * @private
+ * Release one block reference.
+ */
+void
+as_record_pipeline_release(as_record_pipeline* pl, as_record_pipeline_block* block);
+
+/**
+ * @private
+ * Wait until all queued records have been parsed.
+ */
+void
+as_record_pipeline_drain(as_record_pipeline* pl);
+
+/**
+ * @private
+ * Return status of the first failed record parse or callback abort.  If the status has an
+ * error message, it is copied to err.
+ */
+as_status
+as_record_pipeline_status(as_record_pipeline* pl, as_error* err);
+
+/**
+ * @private
+ * Return if a record parse failed or the user callback aborted.
+ */
+static inline bool
+as_record_pipeline_failed(as_record_pipeline* pl)
+{
+	return as_load_uint32(&pl->error) != 0;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
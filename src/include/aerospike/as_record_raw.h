@@ -0,0 +1,191 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_key.h>
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+#include <citrusleaf/cf_byte_order.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Record returned by raw scan/query callbacks. Bins are not decoded. The record and
+ * its bins reference the response buffer and are only valid until the callback returns.
+ *
+ * ~~~~~~~~~~{.c}
+ * bool callback(const as_record_raw* rec, void* udata)
+ * {
+ *     if (! rec) {
+ *         // Scan complete.
+ *         return true;
+ *     }
+ *
+ *     as_record_raw_iterator it;
+ *     as_record_raw_iterator_init(&it, rec);
+ *
+ *     as_bin_raw bin;
+ *
+ *     while (as_record_raw_iterator_next(&it, &bin)) {
+ *         // bin.type is the wire particle type (as_bytes_type).
+ *         write_field(udata, bin.name, bin.name_len, bin.type, bin.value, bin.value_size);
+ *     }
+ *     return true;
+ * }
+ * ~~~~~~~~~~
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_record_raw_s {
+	/**
+	 * Record digest.
+	 */
+	as_digest digest;
+
+	/**
+	 * Record generation.
+	 */
+	uint16_t gen;
+
+	/**
+	 * Record time to live in seconds.
+	 */
+	uint32_t ttl;
+
+	/**
+	 * Number of bins.
+	 */
+	uint16_t n_bins;
+
+	/**
+	 * @private
+	 * Start of bin wire fields in the response buffer.
+	 */
+	const uint8_t* bins;
+} as_record_raw;
+
+/**
+ * Undecoded bin of a raw record.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_bin_raw_s {
+	/**
+	 * Bin name. Not null terminated.
+	 */
+	const char* name;
+
+	/**
+	 * Bin name length.
+	 */
+	uint8_t name_len;
+
+	/**
+	 * Wire particle type (as_bytes_type).
+	 */
+	uint8_t type;
+
+	/**
+	 * Value bytes in wire format. Integers and doubles are big endian and lists/maps
+	 * are msgpack.
+	 */
+	const uint8_t* value;
+
+	/**
+	 * Value size in bytes.
+	 */
+	uint32_t value_size;
+} as_bin_raw;
+
+/**
+ * Iterator over bins of a raw record.
+ *
+ * @ingroup client_objects
+ */
+typedef struct as_record_raw_iterator_s {
+	/**
+	 * @private
+	 */
+	const uint8_t* p;
+
+	/**
+	 * @private
+	 */
+	uint16_t remaining;
+} as_record_raw_iterator;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize iterator over bins of a raw record.
+ *
+ * @ingroup client_objects
+ */
+static inline void
+as_record_raw_iterator_init(as_record_raw_iterator* it, const as_record_raw* rec)
+{
+	it->p = rec->bins;
+	it->remaining = rec->n_bins;
+}
+
+/**
+ * Read next bin. Return false when all bins have been read.
+ *
+ * @ingroup client_objects
+ */
+static inline bool
+as_record_raw_iterator_next(as_record_raw_iterator* it, as_bin_raw* bin)
+{
+	if (it->remaining == 0) {
+		return false;
+	}
+
+	// Layout: op_size(4) op(1) type(1) version(1) name_len(1) name value
+	const uint8_t* p = it->p;
+	uint32_t op_size = cf_swap_from_be32(*(uint32_t*)p);
+
+	bin->type = p[5];
+	bin->name_len = p[7];
+	bin->name = (const char*)p + 8;
+	bin->value = p + 8 + bin->name_len;
+	bin->value_size = op_size - (bin->name_len + 4);
+
+	it->p = p + op_size + 4;
+	it->remaining--;
+	return true;
+}
+
+/**
+ * Decode raw bin value. The returned value is allocated on the heap and must be
+ * destroyed with as_val_destroy().
+ *
+ * @ingroup client_objects
+ */
+AS_EXTERN as_val*
+as_bin_raw_to_val(const as_bin_raw* bin);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
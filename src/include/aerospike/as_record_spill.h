@@ -0,0 +1,258 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup spill_operations Record Spill
+ * @ingroup client_objects
+ *
+ * Append-only record collector for result sets that may not fit in memory. Records are
+ * kept in a heap buffer until memory_limit is reached. The buffer is then moved to a
+ * temporary file that is memory mapped and grows as records are added, so resident
+ * memory is bounded by the page cache instead of the result size. The file is unlinked
+ * as soon as it is created and disappears when the collector is destroyed or the
+ * process exits.
+ *
+ * Records use the export record format with big endian integers:
+ *
+ *     record:  size(4) digest(20) gen(2) ttl(4) n_bins(2) bins
+ *
+ * Bins are stored in wire format and can be read with as_record_raw_iterator.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_record_spill spill;
+ * as_record_spill_init(&spill, "/tmp", 64 * 1024 * 1024);
+ *
+ * if (aerospike_scan_foreach_raw(&as, &err, NULL, &scan, as_record_spill_scan_callback,
+ *     &spill) == AEROSPIKE_OK && spill.err.code == AEROSPIKE_OK) {
+ *     as_record_spill_iterator it;
+ *     as_record_spill_iterator_init(&it, &spill);
+ *
+ *     as_record_raw rec;
+ *
+ *     while (as_record_spill_iterator_next(&it, &rec)) {
+ *         // Read bins with as_record_raw_iterator.
+ *     }
+ * }
+ * as_record_spill_destroy(&spill);
+ * ~~~~~~~~~~
+ *
+ * Memory mapped spilling is not supported on Windows, where records stay in memory.
+ */
+
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_record_raw.h>
+#include <pthread.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Size of the record header that precedes bins.
+ */
+#define AS_RECORD_SPILL_HEADER_SIZE (4 + AS_DIGEST_VALUE_SIZE + 8)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Record collector that spills to a memory mapped temporary file.
+ *
+ * @ingroup spill_operations
+ */
+typedef struct as_record_spill_s {
+	/**
+	 * First error encountered by the scan callback or batch listener. Later records are
+	 * dropped once an error occurs.
+	 */
+	as_error err;
+
+	/**
+	 * Number of records added.
+	 */
+	uint64_t n_records;
+
+	/**
+	 * Size of all records in bytes.
+	 */
+	uint64_t size;
+
+	/**
+	 * True when records have been moved to the temporary file.
+	 */
+	bool spilled;
+
+	/**
+	 * @private
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @private
+	 */
+	uint8_t* data;
+
+	/**
+	 * @private
+	 */
+	uint64_t capacity;
+
+	/**
+	 * @private
+	 */
+	uint64_t memory_limit;
+
+	/**
+	 * @private
+	 */
+	int fd;
+
+	/**
+	 * @private
+	 */
+	char dir[256];
+} as_record_spill;
+
+/**
+ * Sequential iterator over spilled records.
+ *
+ * @ingroup spill_operations
+ */
+typedef struct as_record_spill_iterator_s {
+	/**
+	 * @private
+	 */
+	const uint8_t* p;
+
+	/**
+	 * @private
+	 */
+	const uint8_t* end;
+} as_record_spill_iterator;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize collector. Records are kept in memory up to memory_limit bytes and then
+ * moved to a temporary file in dir. If dir is NULL, the TMPDIR environment variable or
+ * "/tmp" is used.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN void
+as_record_spill_init(as_record_spill* spill, const char* dir, uint64_t memory_limit);
+
+/**
+ * Release memory and remove temporary file.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN void
+as_record_spill_destroy(as_record_spill* spill);
+
+/**
+ * Append raw record. Thread-safe.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN as_status
+as_record_spill_add_raw(as_record_spill* spill, as_error* err, const as_record_raw* rec);
+
+/**
+ * Encode record bins in wire format and append record. The digest is taken from the
+ * record key. Thread-safe.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN as_status
+as_record_spill_add(as_record_spill* spill, as_error* err, as_record* rec);
+
+/**
+ * aerospike_scan_foreach_raw() and aerospike_query_foreach_raw() callback that appends
+ * records to the collector passed as udata. Aborts the scan and sets spill->err when a
+ * record can't be added.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN bool
+as_record_spill_scan_callback(const as_record_raw* rec, void* udata);
+
+/**
+ * aerospike_batch_read_stream() listener that appends found records to the collector
+ * passed as udata. Sets spill->err when a record can't be added.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN void
+as_record_spill_batch_listener(as_batch_base_record* record, uint32_t index, void* udata);
+
+/**
+ * Initialize iterator over records added so far. Records must not be added while
+ * iterating, because the mapping may move when the file grows.
+ *
+ * @ingroup spill_operations
+ */
+AS_EXTERN void
+as_record_spill_iterator_init(as_record_spill_iterator* it, as_record_spill* spill);
+
+/**
+ * Read next record. Record bins reference the collector's memory and remain valid until
+ * the collector is destroyed or more records are added. Return false when all records
+ * have been read.
+ *
+ * @ingroup spill_operations
+ */
+static inline bool
+as_record_spill_iterator_next(as_record_spill_iterator* it, as_record_raw* rec)
+{
+	if (it->p >= it->end) {
+		return false;
+	}
+
+	const uint8_t* p = it->p;
+	uint32_t size = cf_swap_from_be32(*(uint32_t*)p);
+	p += sizeof(uint32_t);
+
+	memcpy(rec->digest.value, p, AS_DIGEST_VALUE_SIZE);
+	rec->digest.init = true;
+	p += AS_DIGEST_VALUE_SIZE;
+	rec->gen = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+	rec->ttl = cf_swap_from_be32(*(uint32_t*)p);
+	p += sizeof(uint32_t);
+	rec->n_bins = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+	rec->bins = p;
+
+	it->p += size + 4;
+	return true;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of segments that are concatenated to form one message.
+ */
+#define AS_RIPEMD160_SEGMENTS 3
+
+/**
+ * @private
+ * RIPEMD-160 digest size in bytes.
+ */
+#define AS_RIPEMD160_SIZE 20
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Message to hash.  The message is the concatenation of its segments, so callers do
+ * not need to copy a key's set name and value into one buffer.
+ */
+typedef struct as_ripemd160_msg_s {
+	const uint8_t* seg[AS_RIPEMD160_SEGMENTS];
+	size_t len[AS_RIPEMD160_SEGMENTS];
+	uint8_t* out;
+} as_ripemd160_msg;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Compute RIPEMD-160 digests of multiple messages.  On platforms with SSE2 or NEON,
+ * four messages are hashed in parallel lanes.  Otherwise, messages are hashed one
+ * at a time.
+ */
+void
+as_ripemd160_multi(as_ripemd160_msg* msgs, uint32_t n_msgs);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Result of a lease request.
+ *
+ * @ingroup scan_operations
+ */
+typedef enum as_scan_lease_result_e {
+	/**
+	 * A chunk of partitions was leased to the caller.
+	 */
+	AS_SCAN_LEASE_GRANTED,
+
+	/**
+	 * All remaining chunks are leased to other workers.  Ask again later, because those
+	 * leases may expire.
+	 */
+	AS_SCAN_LEASE_WAIT,
+
+	/**
+	 * All chunks are done.
+	 */
+	AS_SCAN_LEASE_DONE
+} as_scan_lease_result;
+
+/**
+ * Chunk of partitions leased to one worker of a coordinated scan.
+ *
+ * @ingroup scan_operations
+ */
+typedef struct as_scan_lease_s {
+	/**
+	 * Identifies this grant of the chunk.  The store rejects renew and release calls with a
+	 * token from an older grant, so a worker that lost its lease can't overwrite progress
+	 * made by the worker that took the chunk over.
+	 */
+	uint64_t token;
+
+	/**
+	 * Chunk index.
+	 */
+	uint32_t chunk;
+
+	/**
+	 * First partition id of the chunk.
+	 */
+	uint16_t part_begin;
+
+	/**
+	 * Number of partitions in the chunk.
+	 */
+	uint16_t part_count;
+
+	/**
+	 * Digest cursors saved by the previous holder of the chunk, serialized by
+	 * as_partitions_status_to_bytes().  NULL when the chunk was never started.  Allocated
+	 * with cf_malloc() by the store and freed by the caller.
+	 */
+	uint8_t* cursor;
+
+	/**
+	 * Size of cursor in bytes.
+	 */
+	uint32_t cursor_size;
+} as_scan_lease;
+
+/**
+ * Store that hands out chunks of partitions to the workers of one logical scan.  Workers
+ * may run in different processes or on different hosts as long as they share the store.
+ * All callbacks must be safe to call from multiple threads.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_scan_lease_store store;
+ *
+ * if (as_scan_lease_store_shm(&err, &store, 0xE7B0, 64) == AEROSPIKE_OK) {
+ *     aerospike_scan_leased(&as, &err, NULL, &scan, &store, 30000, callback, NULL);
+ *     as_scan_lease_store_destroy(&store);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @ingroup scan_operations
+ */
+typedef struct as_scan_lease_store_s {
+	/**
+	 * Lease an available chunk for lease_ms milliseconds.  Chunks whose lease expired
+	 * without being released are available again.
+	 */
+	as_scan_lease_result (*acquire)(void* udata, uint32_t lease_ms, as_scan_lease* lease);
+
+	/**
+	 * Extend lease by lease_ms milliseconds from now.  Return false if the lease was lost.
+	 */
+	bool (*renew)(void* udata, const as_scan_lease* lease, uint32_t lease_ms);
+
+	/**
+	 * Give up lease.  If done is true, the chunk is never leased again.  Otherwise the
+	 * chunk is available immediately and cursor is handed to the next worker.  Return
+	 * false if the lease was lost.
+	 */
+	bool (*release)(
+		void* udata, const as_scan_lease* lease, const uint8_t* cursor, uint32_t cursor_size,
+		bool done
+		);
+
+	/**
+	 * Free store resources held by this process.  Optional.
+	 */
+	void (*destroy)(void* udata);
+
+	/**
+	 * Store specific data passed to callbacks.
+	 */
+	void* udata;
+} as_scan_lease_store;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Create or attach to a lease store in a shared memory segment, so worker processes on
+ * the same host share one scan.  All workers must pass the same key and chunk_size.  The
+ * segment is removed when the last attached process calls as_scan_lease_store_destroy().
+ * A new scan requires a new key or a prior removal of the segment.
+ *
+ * @param err			Error detail.
+ * @param store			Store to initialize.
+ * @param key			Shared memory key.
+ * @param chunk_size	Partitions per lease (1 - 4096).
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+as_scan_lease_store_shm(as_error* err, as_scan_lease_store* store, int key, uint32_t chunk_size);
+
+/**
+ * Destroy lease store.
+ *
+ * @ingroup scan_operations
+ */
+static inline void
+as_scan_lease_store_destroy(as_scan_lease_store* store)
+{
+	if (store->destroy) {
+		store->destroy(store->udata);
+	}
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
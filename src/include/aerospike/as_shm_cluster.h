@@ -32,7 +32,7 @@ extern "C" {
 
 /**
  * @private
- * Shared memory representation of node. 424 bytes.
+ * Shared memory representation of node. 448 bytes.
  */
 typedef struct as_node_shm_s {
 	/**
@@ -43,9 +43,10 @@ typedef struct as_node_shm_s {
 		
 	/**
 	 * @private
-	 * Lightweight node read/write lock.
+	 * Node sequence lock. Odd while the tend master is updating the node.
+	 * See as_shm_read_begin().
 	 */
-	as_swlock lock;
+	uint32_t seq;
 	
 	/**
 	 * @private
@@ -82,12 +83,50 @@ typedef struct as_node_shm_s {
 	 * Is node currently active.
 	 */
 	uint8_t active;
-	
+
+	/**
+	 * @private
+	 * Has any process exceeded max_error_rate for this node in the current error window.
+	 */
+	uint8_t error_rate_exceeded;
+
+	/**
+	 * @private
+	 * Pad to 4 byte boundary.
+	 */
+	char pad[2];
+
+	/**
+	 * @private
+	 * Command latency moving average in microseconds, blended across processes.
+	 */
+	uint32_t latency_us;
+
+	/**
+	 * @private
+	 * Sync connections open to node, summed across processes for the current connection
+	 * window.
+	 */
+	uint32_t conns_total;
+
+	/**
+	 * @private
+	 * Idle sync connections in process pools, summed across processes for the current
+	 * connection window.
+	 */
+	uint32_t conns_idle;
+
+	/**
+	 * @private
+	 * Connection opens refused by shm_max_conns_per_node in the current connection window.
+	 */
+	uint32_t conns_refused;
+
 	/**
 	 * @private
 	 * Pad to 8 byte boundary.
 	 */
-	char pad[3];
+	uint32_t pad2;
 } as_node_shm;
 
 /**
@@ -115,14 +154,15 @@ typedef struct as_partition_shm_s {
 
 	/**
 	 * @private
-	 * Pad to 8 byte boundary.
+	 * Partition sequence lock. Odd while the tend master is updating the partition.
+	 * See as_shm_read_begin().
 	 */
-	uint32_t pad;
+	uint32_t seq;
 } as_partition_shm;
 
 /**
  * @private
- * Shared memory representation of map of namespace to data partitions. 40 bytes + partitions size.
+ * Shared memory representation of map of namespace to data partitions. 64 bytes + partitions size.
  */
 typedef struct as_partition_table_shm_s {
 	/**
@@ -139,9 +179,9 @@ typedef struct as_partition_table_shm_s {
 
 	/**
 	 * @private
-	 * Pad to 8 byte boundary.
+	 * Pad to cache line boundary, so partitions start on a cache line.
 	 */
-	char pad[7];
+	char pad[31];
 
 	/**
 	 * @private
@@ -150,6 +190,49 @@ typedef struct as_partition_table_shm_s {
 	as_partition_shm partitions[];
 } as_partition_table_shm;
 
+/**
+ * @private
+ * TLS session shared by all processes, keyed by hash of tls_name and node address.
+ * Stored after the partition tables when the TLS session cache is enabled.
+ */
+typedef struct as_tls_session_shm_s {
+	/**
+	 * @private
+	 * Spin lock held while the session is copied.
+	 */
+	uint8_t lock;
+
+	/**
+	 * @private
+	 * Pad to 4 byte boundary.
+	 */
+	char pad[3];
+
+	/**
+	 * @private
+	 * Size of DER encoded session.  Zero means empty slot.
+	 */
+	uint32_t size;
+
+	/**
+	 * @private
+	 * Hash of session key.
+	 */
+	uint64_t key_hash;
+
+	/**
+	 * @private
+	 * Milliseconds timestamp when the session was stored.
+	 */
+	uint64_t updated;
+
+	/**
+	 * @private
+	 * DER encoded session.
+	 */
+	uint8_t data[AS_TLS_SESSION_MAX];
+} as_tls_session_shm;
+
 /**
  * @private
  * Shared memory cluster map. The map contains fixed arrays of nodes and partition tables.
@@ -249,6 +332,27 @@ typedef struct as_cluster_shm_s {
 	 */
 	uint32_t rebalance_gen;
 
+	/**
+	 * @private
+	 * Error window generation count. Incremented by the tend master every
+	 * error_rate_window tend iterations.
+	 */
+	uint32_t error_window;
+
+	/**
+	 * @private
+	 * Connection window generation count. Incremented by the tend master when it resets
+	 * node connection counts, so counts of exited processes expire.
+	 */
+	uint32_t conns_window;
+
+	/**
+	 * @private
+	 * Partition map generation. Incremented by the tend master when nodes or partition
+	 * maps changed in a cluster tend.
+	 */
+	uint32_t partition_gen;
+
 	/*
 	 * @private
 	 * Dynamically allocated node array.
@@ -298,6 +402,36 @@ typedef struct as_shm_info_s {
 	 * Is this process responsible for performing cluster tending.
 	 */
 	volatile bool is_tend_master;
+
+	/**
+	 * @private
+	 * Shared memory error window that local node error counts belong to.
+	 */
+	uint32_t error_window;
+
+	/**
+	 * @private
+	 * Shared memory connection window that published node connection counts belong to.
+	 */
+	uint32_t conns_window;
+
+	/**
+	 * @private
+	 * Maximum sync connections per node across all processes. Zero means no host limit.
+	 */
+	uint32_t max_conns_per_node;
+
+	/**
+	 * @private
+	 * Shared memory offset to TLS sessions.
+	 */
+	uint32_t tls_sessions_offset;
+
+	/**
+	 * @private
+	 * Number of shared TLS session slots.  Zero when sessions are not shared.
+	 */
+	uint32_t tls_sessions_size;
 } as_shm_info;
 
 /******************************************************************************
@@ -346,6 +480,31 @@ as_shm_node_replace_racks(as_cluster_shm* cluster_shm, as_node* node, as_racks*
 as_partition_table_shm*
 as_shm_find_partition_table(as_cluster_shm* cluster_shm, const char* ns);
 
+/**
+ * @private
+ * Exchange node health with other processes. Error windows follow the tend master and a
+ * node that exceeded max_error_rate in any process is rejected by all processes. Called
+ * by the tend thread of every process.
+ */
+void
+as_shm_update_health(struct as_cluster_s* cluster);
+
+/**
+ * @private
+ * Publish this process's node connection counts and close idle connections when other
+ * processes are refused connections by the host limit. Called by the tend thread of every
+ * process.
+ */
+void
+as_shm_update_conns(struct as_cluster_s* cluster);
+
+/**
+ * @private
+ * Return if opening another sync connection to node stays within shm_max_conns_per_node.
+ */
+bool
+as_shm_reserve_connection(struct as_cluster_s* cluster, as_node* node);
+
 /**
  * @private
  * Update shared memory partition tables for given namespace.
@@ -356,6 +515,78 @@ as_shm_update_partitions(
 	bool master, uint32_t regime
 	);
 
+/**
+ * @private
+ * Begin reading shared memory protected by a sequence lock. Readers never write to
+ * shared memory, so reads in one process do not contend with reads in other processes.
+ * Fields must be read between as_shm_read_begin() and as_shm_read_retry() and the read
+ * must be repeated while as_shm_read_retry() returns true.
+ */
+static inline uint32_t
+as_shm_read_begin(uint32_t* seq)
+{
+	uint32_t s;
+
+	// Wait for writer to finish.
+	while ((s = as_load_uint32(seq)) & 1) {
+		as_pause();
+	}
+
+	// Do not let field reads move ahead of the sequence read.
+	as_fence_acquire();
+	return s;
+}
+
+/**
+ * @private
+ * Return true if the writer changed the fields read since as_shm_read_begin().
+ */
+static inline bool
+as_shm_read_retry(uint32_t* seq, uint32_t begin)
+{
+	as_fence_acquire();
+	return as_load_uint32(seq) != begin;
+}
+
+/**
+ * @private
+ * Begin updating shared memory protected by a sequence lock. Only the tend master
+ * process writes to shared memory.
+ */
+static inline void
+as_shm_write_begin(uint32_t* seq)
+{
+	as_store_uint32(seq, *seq + 1);
+	as_fence_store();
+}
+
+/**
+ * @private
+ * End update started by as_shm_write_begin().
+ */
+static inline void
+as_shm_write_end(uint32_t* seq)
+{
+	as_fence_store();
+	as_store_uint32(seq, *seq + 1);
+}
+
+/**
+ * @private
+ * Read partition master and prole node indexes consistently.
+ */
+static inline void
+as_partition_shm_read(as_partition_shm* p, uint32_t* master, uint32_t* prole)
+{
+	uint32_t seq;
+
+	do {
+		seq = as_shm_read_begin(&p->seq);
+		*master = as_load_uint32(&p->master);
+		*prole = as_load_uint32(&p->prole);
+	} while (as_shm_read_retry(&p->seq, seq));
+}
+
 /**
  * @private
  * Get shared memory partition tables array.
@@ -388,6 +619,25 @@ as_shm_next_partition_table(as_cluster_shm* cluster_shm, as_partition_table_shm*
 	return (as_partition_table_shm*) ((char*)table + cluster_shm->partition_table_byte_size);
 }
 
+/**
+ * @private
+ * Find partition table given namespace ID, falling back to namespace name when the ID
+ * is zero or does not match.
+ */
+static inline as_partition_table_shm*
+as_shm_find_partition_table_id(as_cluster_shm* cluster_shm, uint32_t ns_id, const char* ns)
+{
+	if (ns_id > 0 && ns_id <= cluster_shm->partition_tables_size) {
+		as_partition_table_shm* table = as_shm_get_partition_table(cluster_shm,
+			as_shm_get_partition_tables(cluster_shm), ns_id - 1);
+
+		if (strcmp(table->ns, ns) == 0) {
+			return table;
+		}
+	}
+	return as_shm_find_partition_table(cluster_shm, ns);
+}
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
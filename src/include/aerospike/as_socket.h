@@ -55,8 +55,22 @@ extern "C" {
 #endif
 
 struct ssl_ctx_st;
+struct ssl_st;
 struct evp_pkey_st;
 
+/**
+ * @private
+ * Maximum DER encoded TLS session size passed to a shared session store.  Larger sessions
+ * are only cached in the process that negotiated them.
+ */
+#define AS_TLS_SESSION_MAX 2048
+
+/**
+ * @private
+ * Maximum SSL objects of closed connections kept for reuse by new connections.
+ */
+#define AS_TLS_SSL_POOL_MAX 64
+
 /**
  * This structure holds TLS context which can be shared (read-only)
  * by all the connections to a specific cluster.
@@ -67,12 +81,33 @@ typedef struct as_tls_context_s {
 	struct evp_pkey_st* pkey;
 	void* cert_blacklist;
 	bool log_session_info;
+	void* sessions;
 	bool for_login_only;
+	bool ktls;
+	bool session_cache;
+	// Optional session store shared with other processes.  Sessions are passed in DER form.
+	bool (*session_load)(void* udata, const char* key, uint8_t* buf, uint32_t* size);
+	void (*session_save)(void* udata, const char* key, const uint8_t* buf, uint32_t size);
+	void* session_udata;
+	// SSL objects reset after their connection closed.  Protected by lock.
+	struct ssl_st* ssl_pool[AS_TLS_SSL_POOL_MAX];
+	uint32_t ssl_pool_size;
+	// Incremented by each config reload.  SSL objects created before a reload are not pooled.
+	uint32_t ssl_generation;
 } as_tls_context;
 
 struct as_conn_pool_s;
 struct as_node_s;
 
+/**
+ * @private
+ * Buffer segment used in scatter/gather socket writes.
+ */
+typedef struct as_socket_iov_s {
+	const uint8_t* data;
+	size_t len;
+} as_socket_iov;
+
 /**
  * Socket fields for both regular and TLS sockets.
  */
@@ -90,6 +125,12 @@ typedef struct as_socket_s {
 	as_tls_context* ctx;
 	const char* tls_name;
 	struct ssl_st* ssl;
+	uint8_t* rbuf; // Optional read-ahead buffer. Only used by non-TLS sync sockets.
+	uint32_t rbuf_size;
+	uint32_t rbuf_pos;
+	uint32_t rbuf_len;
+	bool ktls; // Kernel encrypts TLS records sent on this socket.
+	bool quickack; // Set TCP_QUICKACK again after each read.
 } as_socket;
 
 /**
@@ -136,6 +177,33 @@ as_socket_create_fd(int family, as_socket_fd* fdp);
 int
 as_socket_create(as_socket* sock, int family, as_tls_context* ctx, const char* tls_name);
 
+/**
+ * @private
+ * Allocate read-ahead buffer.  Reads smaller than the buffer receive up to buffer size bytes
+ * at a time and later reads are served from the buffer.  Ignored for TLS sockets.
+ */
+void
+as_socket_set_read_buffer(as_socket* sock, uint32_t size);
+
+/**
+ * @private
+ * Set SO_BUSY_POLL (and SO_PREFER_BUSY_POLL when available) in microseconds, so blocking
+ * waits on this socket poll the device queue instead of sleeping until an interrupt.
+ * Return false if not supported on this platform or the option could not be set.
+ */
+bool
+as_socket_set_busy_poll(as_socket_fd fd, uint32_t busy_poll_us);
+
+/**
+ * @private
+ * Set kernel receive and send buffer sizes and TCP_QUICKACK.  Zero sizes leave the system
+ * defaults.  Failures are ignored because these options are only tuning hints.
+ */
+void
+as_socket_set_profile(
+	as_socket* sock, uint32_t recv_buffer_size, uint32_t send_buffer_size, bool quickack
+	);
+
 /**
  * @private
  * Wrap existing fd in a socket.
@@ -242,6 +310,30 @@ as_socket_write_deadline(
 	uint32_t socket_timeout, uint64_t deadline
 	);
 
+/**
+ * @private
+ * Write socket data with future deadline in milliseconds.  When io_uring socket I/O is
+ * active, the start of the response is received in the same system call and returned by
+ * the next as_socket_read_deadline() on this socket.  The caller must not poll the socket
+ * for the response.
+ */
+as_status
+as_socket_write_prefetch_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t *buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	);
+
+/**
+ * @private
+ * Write multiple buffers to socket with one system call per poll event (scatter/gather)
+ * and future deadline in milliseconds.  If deadline is zero, do not set deadline.
+ */
+as_status
+as_socket_writev_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, const as_socket_iov* iov,
+	uint32_t iov_count, uint32_t socket_timeout, uint64_t deadline
+	);
+
 /**
  * @private
  * Read socket data with future deadline in milliseconds.
@@ -253,6 +345,18 @@ as_socket_read_deadline(
 	uint32_t socket_timeout, uint64_t deadline
 	);
 
+/**
+ * @private
+ * Read socket data with future deadline in milliseconds.  First spin on non-blocking
+ * receives for up to spin_us microseconds before waiting in poll for the remainder.
+ * If spin_us is zero, this is the same as as_socket_read_deadline().
+ */
+as_status
+as_socket_read_spin_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t *buf, size_t buf_len,
+	uint32_t spin_us, uint32_t socket_timeout, uint64_t deadline
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_socket.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Size of per-thread buffer that receives the start of a response in the same system call
+ * that sends the request.
+ */
+#define AS_SOCKET_URING_PREFETCH_SIZE (16 * 1024)
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Use io_uring for synchronous (non-TLS) socket reads and writes.
+ *
+ * Each thread that performs sync socket I/O lazily creates its own small ring.  Every send
+ * and receive is linked to a timeout request, so a socket operation with a timeout costs
+ * one system call instead of a poll followed by a send or receive.  Single record commands
+ * also receive the start of the response in the same system call that sends the request.
+ *
+ * This setting is process wide and disabled by default.  Threads that fail to create a ring
+ * silently fall back to poll based I/O.
+ *
+ * @param enable	Enable or disable io_uring socket I/O.
+ * @return			false if the client was built without liburing support.
+ */
+AS_EXTERN bool
+as_socket_uring_enable(bool enable);
+
+/**
+ * Return if io_uring socket I/O is enabled.
+ */
+AS_EXTERN bool
+as_socket_uring_enabled(void);
+
+/**
+ * Destroy the calling thread's ring and prefetch buffer.  They are also destroyed
+ * automatically when a thread exits.
+ */
+AS_EXTERN void
+as_socket_uring_release_thread(void);
+
+/**
+ * @private
+ * Return if the calling thread should route non-TLS socket I/O through io_uring.
+ */
+bool
+as_socket_uring_active(void);
+
+/**
+ * @private
+ * Write socket data using io_uring.
+ */
+as_status
+as_socket_uring_write(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	);
+
+/**
+ * @private
+ * Write socket data and receive the start of the response into the calling thread's
+ * prefetch buffer with one io_uring submission.
+ */
+as_status
+as_socket_uring_write_prefetch(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	);
+
+/**
+ * @private
+ * Read socket data using io_uring.  Prefetched data for this socket is consumed first.
+ */
+as_status
+as_socket_uring_read(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	);
+
+/**
+ * @private
+ * Discard prefetched data for a socket that is being closed.
+ */
+void
+as_socket_uring_discard(as_socket_fd fd);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
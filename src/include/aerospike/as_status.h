@@ -32,6 +32,13 @@ typedef enum as_status_e {
 	/***************************************************************************
 	 * Client Errors
 	 **************************************************************************/
+	/**
+	 * Async command was rejected by admission control, because its total timeout could not
+	 * be met in the event loop's delay queue or the node's async in-flight byte limit was
+	 * reached.
+	 */
+	AEROSPIKE_ERR_ASYNC_OVERLOAD = -17,
+
 	/**
 	 * One or more keys failed in a batch.
 	 */
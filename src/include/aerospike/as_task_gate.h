@@ -0,0 +1,159 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_thread_pool.h>
+#include <aerospike/as_work_pool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Queue wait in microseconds above which an adaptive call stops borrowing idle threads
+ * beyond its fair share.
+ */
+#define AS_TASK_GATE_MAX_WAIT_US 1000
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Divides the sync thread pool between concurrent batch, scan and query calls and records
+ * how long tasks wait in the pool queue.  Tasks run on work_pool when it is enabled.
+ */
+typedef struct as_task_gate_s {
+	as_thread_pool* pool;
+	as_work_pool* work_pool;
+	uint64_t wait_count;
+	uint64_t wait_us;
+	uint32_t callers;
+	uint32_t tasks;
+	bool adaptive;
+} as_task_gate;
+
+/**
+ * @private
+ * Tasks queued by one batch, scan or query call.  Only the calling thread updates queued
+ * and completed.
+ */
+typedef struct as_task_caller_s {
+	as_task_gate* gate;
+	uint32_t queued;
+	uint32_t completed;
+	uint32_t last_wait_us;
+} as_task_caller;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Initialize task gate for cluster thread pool.  work_pool may be NULL.
+ */
+void
+as_task_gate_init(
+	as_task_gate* gate, as_thread_pool* pool, as_work_pool* work_pool, bool adaptive
+	);
+
+/**
+ * @private
+ * Queue task that is not tracked by a caller on the active pool.  Returns zero on success.
+ */
+int
+as_task_gate_queue(as_task_gate* gate, as_task_fn task_fn, void* task);
+
+/**
+ * @private
+ * Return number of tasks waiting in the active pool queue.
+ */
+uint32_t
+as_task_gate_queued(as_task_gate* gate);
+
+/**
+ * @private
+ * Return number of threads in the active pool.
+ */
+static inline uint32_t
+as_task_gate_threads(as_task_gate* gate)
+{
+	return gate->work_pool ? gate->work_pool->thread_size : gate->pool->thread_size;
+}
+
+/**
+ * @private
+ * Register a call that will queue tasks on the thread pool.
+ */
+void
+as_task_caller_init(as_task_caller* caller, as_task_gate* gate);
+
+/**
+ * @private
+ * Unregister call.  All queued tasks must have completed.
+ */
+void
+as_task_caller_destroy(as_task_caller* caller);
+
+/**
+ * @private
+ * Return if the call may queue another task now.  In adaptive mode, a call may always run
+ * its fair share of pool threads and only borrows idle threads when its own tasks are not
+ * waiting in the pool queue.  If false, the caller should wait for one of its tasks to
+ * complete and then call as_task_caller_complete().
+ */
+bool
+as_task_caller_admit(as_task_caller* caller);
+
+/**
+ * @private
+ * Queue task on the thread pool.  Returns zero on success.
+ */
+int
+as_task_caller_queue(as_task_caller* caller, as_task_fn task_fn, void* task);
+
+/**
+ * @private
+ * Record completion of one task queued by this call.
+ */
+static inline void
+as_task_caller_complete(as_task_caller* caller)
+{
+	caller->completed++;
+}
+
+/**
+ * @private
+ * Return number of tasks queued by this call that have not completed.
+ */
+static inline uint32_t
+as_task_caller_pending(as_task_caller* caller)
+{
+	return caller->queued - caller->completed;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
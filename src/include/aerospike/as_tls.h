@@ -40,15 +40,19 @@ as_status as_tls_config_reload(as_config_tls* tlscfg, as_tls_context* ctx, as_er
 
 int as_tls_wrap(as_tls_context* ctx, as_socket* sock, const char* tls_name);
 
+struct ssl_st;
+void as_tls_release(as_tls_context* ctx, struct ssl_st* ssl);
+
 void as_tls_set_name(as_socket* sock, const char* tls_name);
 
-struct ssl_st;
 void as_tls_set_context_name(struct ssl_st* ssl, as_tls_context* ctx, const char* tls_name);
 
 int as_tls_connect_once(as_socket* sock);
 
 int as_tls_connect(as_socket* sock, uint64_t deadline);
 
+void as_tls_resume_session(as_socket* sock, struct sockaddr* addr);
+
 int as_tls_read_pending(as_socket* sock);
 
 int as_tls_read_once(as_socket* sock, void* buf, size_t num);
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct as_cluster_s;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Write cluster nodes and partition maps to the cluster's topology file. Called by the
+ * tend thread after the topology changed.
+ */
+as_status
+as_topology_save(struct as_cluster_s* cluster, as_error* err);
+
+/**
+ * @private
+ * Read topology file, create its nodes without connections and restore partition maps
+ * that reference them. Created nodes are appended to nodes and must be added to the
+ * cluster by the caller. Called before the cluster is tended.
+ */
+as_status
+as_topology_load(struct as_cluster_s* cluster, as_error* err, as_vector* /* <as_node*> */ nodes);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_status.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Trace of one sampled database command.  Timestamps are cf_getns() nanoseconds and
+ * are zero when the phase was not reached.  Phase timestamps describe the last attempt.
+ *
+ * @ingroup as_config_object
+ */
+typedef struct as_trace_span_s {
+	/**
+	 * Namespace.  Empty for commands that are not bound to a namespace.
+	 */
+	char ns[32];
+
+	/**
+	 * Key digest.  Only valid when has_digest is true.
+	 */
+	uint8_t digest[20];
+
+	/**
+	 * Last node the command was sent to.  Empty if the command was not sent.
+	 */
+	char node_name[20];
+
+	/**
+	 * Partition id of single record commands.
+	 */
+	uint32_t partition_id;
+
+	/**
+	 * Number of attempts, including retries.
+	 */
+	uint32_t attempts;
+
+	/**
+	 * Bytes sent per attempt.
+	 */
+	uint64_t bytes_out;
+
+	/**
+	 * Bytes received on the last attempt.
+	 */
+	uint64_t bytes_in;
+
+	/**
+	 * Time the command was issued.  For async commands, the command may then wait in the
+	 * event loop queue until begin_ns.
+	 */
+	uint64_t queue_ns;
+
+	/**
+	 * Start of the last attempt.
+	 */
+	uint64_t begin_ns;
+
+	/**
+	 * Connection acquired (including connect, TLS and login for new connections).
+	 */
+	uint64_t connect_ns;
+
+	/**
+	 * Command fully written to the socket.
+	 */
+	uint64_t send_ns;
+
+	/**
+	 * First response header received.
+	 */
+	uint64_t first_byte_ns;
+
+	/**
+	 * Response parsed or command failed.
+	 */
+	uint64_t end_ns;
+
+	/**
+	 * Value that may be set by the begin hook and read by the end hook.
+	 */
+	void* udata;
+
+	/**
+	 * Final command status.
+	 */
+	as_status status;
+
+	/**
+	 * Is digest valid.
+	 */
+	bool has_digest;
+
+	/**
+	 * Is async command.
+	 */
+	bool async;
+
+	/**
+	 * @private
+	 * Call trace hooks.  Spans are also created for commands sampled for hot key tracking.
+	 */
+	bool hooks;
+
+	/**
+	 * @private
+	 * Add completed command to hot key sketches.
+	 */
+	bool hot_key;
+
+	/**
+	 * @private
+	 * Command capture entry.  NULL if the command was not sampled for capture.
+	 */
+	struct as_capture_entry_s* capture;
+} as_trace_span;
+
+/**
+ * Trace hook.  The begin hook is called in the thread that issued the command.  The end hook
+ * is called in the thread that completed the command, which is an event loop thread for async
+ * commands.  Hooks must not block.
+ *
+ * @ingroup as_config_object
+ */
+typedef void (*as_trace_fn) (as_trace_span* span, void* udata);
+
+/**
+ * Sampled command tracing hooks.  Sampling is decided when the command is issued with one
+ * counter increment, so unsampled commands pay no other cost.
+ *
+ * @ingroup as_config_object
+ */
+typedef struct as_trace_hooks_s {
+	/**
+	 * Called before the first attempt of a sampled command.  May be NULL.
+	 */
+	as_trace_fn begin;
+
+	/**
+	 * Called after a sampled command completed.  May be NULL.
+	 */
+	as_trace_fn end;
+
+	/**
+	 * User data that will be passed back to the hooks.
+	 */
+	void* udata;
+
+	/**
+	 * Trace one out of every sample_rate commands.  Zero disables tracing.
+	 *
+	 * Default: 0
+	 */
+	uint32_t sample_rate;
+} as_trace_hooks;
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_thread_pool.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Task stored in a worker deque.
+ */
+typedef struct as_work_item_s {
+	as_task_fn task_fn;
+	void* task;
+} as_work_item;
+
+/**
+ * @private
+ * Growable ring buffer of tasks owned by one worker.  The owner takes tasks from the head
+ * and other workers steal from the tail.
+ */
+typedef struct as_work_deque_s {
+	pthread_mutex_t lock;
+	as_work_item* items;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t size;
+} as_work_deque;
+
+struct as_work_pool_s;
+
+/**
+ * @private
+ * Work stealing pool thread.
+ */
+typedef struct as_work_worker_s {
+	struct as_work_pool_s* pool;
+	pthread_t thread;
+	as_work_deque deque;
+	uint32_t index;
+} as_work_worker;
+
+/**
+ * @private
+ * Thread pool with a task deque per thread.  Idle threads steal tasks from other threads,
+ * spin for a configurable time and then park until new tasks are queued.  Tasks queued by
+ * threads outside the pool are distributed round-robin between worker deques.
+ */
+typedef struct as_work_pool_s {
+	as_work_worker* workers;
+	pthread_mutex_t park_lock;
+	pthread_cond_t park_cond;
+	as_fini_fn fini_fn;
+	uint32_t thread_size;
+	uint32_t spin_us;
+	uint32_t next;
+	uint32_t pending;
+	uint32_t sleepers;
+	uint8_t shutdown;
+} as_work_pool;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Create work stealing pool threads.  If cpu is non-negative, thread i is assigned to
+ * cpu + i.  Returns zero on success.
+ */
+int
+as_work_pool_init(
+	as_work_pool* pool, uint32_t thread_size, uint32_t spin_us, int cpu, as_fini_fn fini_fn
+	);
+
+/**
+ * @private
+ * Queue task on the pool.  Same semantics as as_thread_pool_queue_task():
+ * returns zero on success, -1 if the pool has no threads and -2 if the pool is shutting down.
+ */
+int
+as_work_pool_queue_task(as_work_pool* pool, as_task_fn task_fn, void* task);
+
+/**
+ * @private
+ * Run all queued tasks, stop pool threads and free resources.  Calling destroy on a
+ * zeroed pool is a no-op.
+ */
+void
+as_work_pool_destroy(as_work_pool* pool);
+
+/**
+ * @private
+ * Return number of tasks queued but not yet started.
+ */
+uint32_t
+as_work_pool_queued(as_work_pool* pool);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup write_buffer Write Buffer
+ * @ingroup batch_operations
+ *
+ * Write-behind buffer that groups single record writes by node and sends them as batch
+ * writes.  Writes are accepted from any thread.  A node's writes are sent when the node has
+ * max_node_records writes waiting or when its oldest write has waited flush_interval_ms.
+ * Writes of one key are applied in the order they are buffered.  A write of a key that is
+ * already waiting sends the node's waiting writes first.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_write_buffer_policy p;
+ * as_write_buffer_policy_init(&p);
+ *
+ * as_write_buffer* wb = as_write_buffer_create(&as, &err, &p);
+ *
+ * as_record* rec = as_record_new(1);
+ * as_record_set_int64(rec, "a", 1);
+ * as_write_buffer_put(wb, &err, &key, rec, my_listener, NULL);
+ * ...
+ * as_write_buffer_destroy(wb);
+ * ~~~~~~~~~~
+ *
+ * Touches that only refresh record TTL are coalesced by digest while they wait, so a key
+ * that is read many times within the flush interval is touched once.  Session stores
+ * typically create a separate buffer for touches with a longer flush_interval_ms, and
+ * read through as_write_buffer_get_touch().
+ *
+ * ~~~~~~~~~~{.c}
+ * as_write_buffer_policy p;
+ * as_write_buffer_policy_init(&p);
+ * p.flush_interval_ms = 1000;
+ *
+ * as_write_buffer* touches = as_write_buffer_create(&as, &err, &p);
+ *
+ * as_record* rec = NULL;
+ * as_write_buffer_get_touch(touches, &err, NULL, &key, &rec, 3600);
+ * ...
+ * as_write_buffer_destroy(touches);
+ * ~~~~~~~~~~
+ */
+
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_policy.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_vector.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Write completion listener.  Called once per buffered write after its batch completes.
+ * The listener runs in the thread that sent the batch, which may be the thread of another
+ * writer or the buffer's flush thread.  Listeners must not add writes to the same buffer,
+ * because the write could block the thread that frees buffer space.
+ *
+ * @param err			Error structure that is populated if the write failed. NULL on success.
+ * @param udata 		User data that is forwarded from the write call.
+ *
+ * @ingroup write_buffer
+ */
+typedef void (*as_write_buffer_listener)(as_error* err, void* udata);
+
+/**
+ * Write buffer configuration.
+ *
+ * @ingroup write_buffer
+ */
+typedef struct as_write_buffer_policy_s {
+	/**
+	 * Batch policy used to send buffered writes.
+	 *
+	 * Default: as_policy_batch_parent_write_init()
+	 */
+	as_policy_batch batch;
+
+	/**
+	 * Send a node's buffered writes when this many writes are waiting for the node.
+	 *
+	 * Default: 100
+	 */
+	uint32_t max_node_records;
+
+	/**
+	 * Maximum estimated bytes of writes that are buffered or in flight.  Writers block
+	 * until earlier batches complete when this limit is reached.
+	 *
+	 * Default: 16MB
+	 */
+	uint32_t max_bytes;
+
+	/**
+	 * Send a node's buffered writes when its oldest write has waited this many milliseconds.
+	 *
+	 * Default: 10
+	 */
+	uint32_t flush_interval_ms;
+} as_write_buffer_policy;
+
+/**
+ * @private
+ * Listener and owned write data of one buffered write.  Entries are stored in the same order
+ * as the batch records.
+ */
+typedef struct as_write_buffer_entry_s {
+	as_write_buffer_listener listener;
+	void* udata;
+	as_record* rec;
+	uint32_t bytes;
+	bool touch;
+} as_write_buffer_entry;
+
+/**
+ * @private
+ * Writes waiting for one node.
+ */
+typedef struct as_write_buffer_node_s {
+	struct as_node_s* node;
+	as_batch_records* records;
+	as_write_buffer_entry* entries;
+	uint32_t* key_slots; // Index + 1 of waiting writes, hashed by digest.
+	uint64_t first_ms;
+} as_write_buffer_node;
+
+/**
+ * Write-behind buffer.
+ *
+ * @ingroup write_buffer
+ */
+typedef struct as_write_buffer_s {
+	aerospike* as;
+	as_write_buffer_policy policy;
+	as_vector nodes;
+	pthread_mutex_t lock;
+	pthread_cond_t space_cond;
+	pthread_cond_t flush_cond;
+	pthread_t flush_thread;
+	uint64_t bytes;
+	bool valid;
+} as_write_buffer;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize write buffer policy to default values.
+ *
+ * @ingroup write_buffer
+ */
+static inline void
+as_write_buffer_policy_init(as_write_buffer_policy* p)
+{
+	as_policy_batch_parent_write_init(&p->batch);
+	p->max_node_records = 100;
+	p->max_bytes = 16 * 1024 * 1024;
+	p->flush_interval_ms = 10;
+}
+
+/**
+ * Create write buffer and start its flush thread.
+ *
+ * @param as			Connected aerospike instance.
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param policy		Write buffer policy. Pass NULL for defaults.
+ * @return Write buffer or NULL on error.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN as_write_buffer*
+as_write_buffer_create(aerospike* as, as_error* err, const as_write_buffer_policy* policy);
+
+/**
+ * Buffer a record put.  Ownership of rec transfers to the write buffer, which calls
+ * as_record_destroy() after the listener completes.  rec must be heap allocated with
+ * as_record_new() and its bin values must remain valid until then.
+ *
+ * @param wb			Write buffer.
+ * @param err			Error detail structure that is populated if the write is not accepted.
+ * @param key			Record key.  The key is copied.
+ * @param rec			Heap allocated record to write.
+ * @param listener		Called when the write completes.
+ * @param udata			User data forwarded to listener.
+ * @return AEROSPIKE_OK if the write was accepted.  Otherwise, the listener is not called and
+ * rec is still owned by the caller.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN as_status
+as_write_buffer_put(
+	as_write_buffer* wb, as_error* err, const as_key* key, as_record* rec,
+	as_write_buffer_listener listener, void* udata
+	);
+
+/**
+ * Buffer a record operate.  Ownership of ops transfers to the write buffer, which calls
+ * as_operations_destroy() after the listener completes.  ops must be heap allocated with
+ * as_operations_new().  Results of read operations are not returned.
+ *
+ * @param wb			Write buffer.
+ * @param err			Error detail structure that is populated if the write is not accepted.
+ * @param key			Record key.  The key is copied.
+ * @param ops			Heap allocated operations to apply.
+ * @param listener		Called when the write completes.
+ * @param udata			User data forwarded to listener.
+ * @return AEROSPIKE_OK if the write was accepted.  Otherwise, the listener is not called and
+ * ops is still owned by the caller.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN as_status
+as_write_buffer_operate(
+	as_write_buffer* wb, as_error* err, const as_key* key, as_operations* ops,
+	as_write_buffer_listener listener, void* udata
+	);
+
+/**
+ * Buffer a touch that sets the record's TTL.  If a touch of the same key is already waiting
+ * for the node and no other write of the key was buffered after it, that touch is reused
+ * with the new TTL, no command is added and the call does not wait for space.  Touch
+ * results are not reported.  Touches of records that do not exist are ignored by the server.
+ *
+ * @param wb			Write buffer.
+ * @param err			Error detail structure that is populated if the touch is not accepted.
+ * @param key			Record key.  The key is copied.
+ * @param ttl			Record TTL in seconds.  See as_operations.ttl.
+ * @return AEROSPIKE_OK if the touch was accepted or coalesced.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN as_status
+as_write_buffer_touch(as_write_buffer* wb, as_error* err, const as_key* key, uint32_t ttl);
+
+/**
+ * Read a record with aerospike_key_get() and, if it is found, buffer a touch of the record
+ * with as_write_buffer_touch().  This replaces a get followed by a synchronous touch with a
+ * single round trip plus a share of a batch.
+ *
+ * @param wb			Write buffer that receives the touch.
+ * @param err			Error detail structure that is populated if the read fails.
+ * @param policy		Read policy. Pass NULL for defaults.
+ * @param key			Record key.
+ * @param rec			The record to be populated with the data from request.
+ * @param ttl			Record TTL in seconds for the delayed touch.
+ * @return Status of the read.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN as_status
+as_write_buffer_get_touch(
+	as_write_buffer* wb, as_error* err, const as_policy_read* policy, const as_key* key,
+	as_record** rec, uint32_t ttl
+	);
+
+/**
+ * Send all buffered writes now and wait until every write has completed.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN void
+as_write_buffer_flush(as_write_buffer* wb);
+
+/**
+ * Send all buffered writes, wait for completion, stop the flush thread and free the buffer.
+ *
+ * @ingroup write_buffer
+ */
+AS_EXTERN void
+as_write_buffer_destroy(as_write_buffer* wb);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -55,6 +55,15 @@ as_bin_init(as_bin* bin, const as_bin_name name, as_bin_value* value)
 	return as_bin_defaults(bin, name, value);
 }
 
+as_bin*
+as_bin_init_handle(as_bin* bin, const as_bin_handle* handle, as_bin_value* value)
+{
+	memcpy(bin->name, handle->name, AS_BIN_NAME_MAX_SIZE);
+	((as_val *) &bin->value)->type = AS_UNKNOWN;
+	bin->valuep = value;
+	return bin;
+}
+
 as_bin*
 as_bin_init_bool(as_bin* bin, const as_bin_name name, bool value)
 {
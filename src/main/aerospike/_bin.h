@@ -71,6 +71,19 @@
 as_bin*
 as_bin_init(as_bin* bin, const as_bin_name name, as_bin_value* value);
 
+/**
+ * Intializes an `as_bin` with an interned name and a value.  The padded name is copied
+ * at full width.
+ *
+ * @param bin 		The `as_bin` to initialize.
+ * @param handle	The interned name of the bin.
+ * @param value		The value of the bin.
+ *
+ * @return The initialized `as_bin`.
+ */
+as_bin*
+as_bin_init_handle(as_bin* bin, const as_bin_handle* handle, as_bin_value* value);
+
 /**
  * Initialize a stack allocated `as_bin` to a bool value.
  *
@@ -15,6 +15,7 @@
  * the License.
  */
 #include <aerospike/aerospike.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_config.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_info.h>
@@ -22,6 +23,7 @@
 #include <aerospike/as_module.h>
 #include <aerospike/as_string_builder.h>
 #include <aerospike/as_tls.h>
+#include <aerospike/as_lua_pool.h>
 #include <aerospike/mod_lua.h>
 #include <aerospike/mod_lua_config.h>
 #include <citrusleaf/alloc.h>
@@ -37,7 +39,9 @@ pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
 
 extern uint32_t as_event_loop_capacity;
 extern bool as_event_single_thread;
-static bool lua_initialized = false;
+static uint8_t lua_initialized = 0;
+static as_config_lua lua_deferred;
+static bool lua_deferred_set = false;
 
 #if defined(_MSC_VER) || defined(AS_USE_LIBEVENT)
 static bool library_initialized = false;
@@ -147,7 +151,26 @@ aerospike_init_lua(as_config_lua* config)
     as_strncpy(lua.user_path, config->user_path, sizeof(lua.user_path));
     
     as_module_configure(&mod_lua, &lua);
-	lua_initialized = true;
+	as_lua_pool_warm(config);
+	as_store_uint8(&lua_initialized, 1);
+}
+
+void
+aerospike_init_lua_deferred(void)
+{
+	if (as_load_uint8(&lua_initialized)) {
+		return;
+	}
+
+	pthread_mutex_lock(&init_lock);
+
+	if (! lua_initialized) {
+		if (! lua_deferred_set) {
+			as_config_lua_init(&lua_deferred);
+		}
+		aerospike_init_lua(&lua_deferred);
+	}
+	pthread_mutex_unlock(&init_lock);
 }
 
 /**
@@ -216,10 +239,20 @@ aerospike_connect(aerospike* as, as_error* err)
 	}
 	
 #if !defined USE_XDR
-	// Only change global lua configuration once.
-	if (!lua_initialized) {
-		aerospike_init_lua(&as->config.lua);
+	// Only change global lua configuration once.  Lua is configured on first client side
+	// lua use unless warm up functions must run now.
+	pthread_mutex_lock(&init_lock);
+
+	if (! lua_initialized) {
+		if (config->lua.warm_functions[0]) {
+			aerospike_init_lua(&config->lua);
+		}
+		else if (! lua_deferred_set) {
+			memcpy(&lua_deferred, &config->lua, sizeof(as_config_lua));
+			lua_deferred_set = true;
+		}
 	}
+	pthread_mutex_unlock(&init_lock);
 #endif
 
 	// Create the cluster object.
@@ -371,3 +404,46 @@ aerospike_set_xdr_filter(
 	return status;
 }
 
+as_status
+aerospike_set_conns_per_node(aerospike* as, as_error* err, uint32_t min_conns, uint32_t max_conns)
+{
+	as_error_reset(err);
+
+	as_status status = as_cluster_set_conns_per_node(as->cluster, err, min_conns, max_conns);
+
+	if (status == AEROSPIKE_OK) {
+		as->config.min_conns_per_node = min_conns;
+		as->config.max_conns_per_node = max_conns;
+	}
+	return status;
+}
+
+as_status
+aerospike_set_async_conns_per_node(
+	aerospike* as, as_error* err, uint32_t min_conns, uint32_t max_conns
+	)
+{
+	as_error_reset(err);
+
+	as_status status = as_cluster_set_async_conns_per_node(as->cluster, err, min_conns,
+		max_conns);
+
+	if (status == AEROSPIKE_OK) {
+		as->config.async_min_conns_per_node = min_conns;
+		as->config.async_max_conns_per_node = max_conns;
+	}
+	return status;
+}
+
+as_status
+aerospike_set_thread_pool_size(aerospike* as, as_error* err, uint32_t size)
+{
+	as_error_reset(err);
+
+	as_status status = as_cluster_set_thread_pool_size(as->cluster, err, size);
+
+	if (status == AEROSPIKE_OK) {
+		as->config.thread_pool_size = size;
+	}
+	return status;
+}
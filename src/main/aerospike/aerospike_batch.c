@@ -16,6 +16,8 @@
  */
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_partition.h>
+#include <aerospike/as_arena.h>
 #include <aerospike/as_async.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
@@ -23,6 +25,8 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_memory.h>
+#include <aerospike/as_monitor.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_policy.h>
@@ -46,6 +50,15 @@
  #define BATCH_TYPE_RECORDS 0
  #define BATCH_TYPE_KEYS 1
  #define BATCH_TYPE_KEYS_NO_CALLBACK 2
+ #define BATCH_TYPE_DIGESTS 3
+ #define BATCH_TYPE_KEYS_STATUS 4
+
+// Minimum records in a multi-node async batch before node commands are serialized in
+// parallel on the cluster thread pool.
+ #define BATCH_ASYNC_PARALLEL_RECORDS 1000
+
+// Minimum keys in a batch before partition to node routes are cached for the batch call.
+ #define BATCH_ROUTE_CACHE_KEYS 256
 
 //---------------------------------
 // Types
@@ -71,14 +84,26 @@ typedef struct {
 	bool send_key;
 } as_batch_attr;
 
+typedef struct {
+	const char* ns;
+	as_node** nodes;
+	uint32_t n_partitions;
+	uint32_t n_slots;
+	bool spread;
+} as_batch_route_cache;
+
 typedef struct as_batch_node_s {
 	as_node* node;
 	as_vector offsets;
+	const uint8_t* buf; // Serialized command of a prepared batch or NULL.
+	size_t buf_size;
 } as_batch_node;
 
 typedef struct as_batch_task_s {
 	as_node* node;
 	as_vector offsets;
+	const uint8_t* buf;
+	size_t buf_size;
 	as_cluster* cluster;
 	const as_policy_batch* policy;
 	as_error* err;
@@ -91,9 +116,20 @@ typedef struct as_batch_task_s {
 	bool has_write;
 } as_batch_task;
 
+typedef struct {
+	as_batch_record_listener listener;
+	void* udata;
+	const as_binding* binding;
+	uint8_t* objs;
+	size_t stride;
+	as_binding_status* bind_status;
+} as_batch_stream;
+
 typedef struct as_batch_task_records_s {
 	as_batch_task base;
 	as_vector* records;
+	as_arena_chunk** arena;
+	const as_batch_stream* stream;
 } as_batch_task_records;
 
 typedef struct as_batch_task_keys_s {
@@ -106,8 +142,19 @@ typedef struct as_batch_task_keys_s {
 	void* udata;
 	as_batch_base_record* rec;
 	as_batch_attr* attr;
+	as_batch_status* status; // Compact write/remove results or NULL.
+	uint8_t* bitmap;  // Compact exists results or NULL.
 } as_batch_task_keys;
 
+typedef struct as_batch_task_digests_s {
+	as_batch_task base;
+	const as_batch_digests* batch;
+	as_batch_digest_result* results;
+	as_key* key;
+	as_batch_read_record* rec;
+	as_batch_attr* attr;
+} as_batch_task_digests;
+
 typedef struct as_batch_complete_task_s {
 	as_node* node;
 	as_status result;
@@ -117,13 +164,37 @@ typedef struct {
 	as_event_executor executor;
 	as_batch_records* records;
 	as_async_batch_listener listener;
+	as_async_batch_record_listener record_listener;
+	as_arena_chunk** arena;
 	as_policy_replica replica;
 	as_policy_replica replica_sc;
 	as_policy_read_mode_sc read_mode_sc;
+	bool replica_spread;
 	bool has_write;
 	bool error_row;
+	bool blocking;
+	bool confined;
 } as_async_batch_executor;
 
+typedef struct {
+	as_monitor monitor;
+	const as_batch_stream* stream;
+	as_error* err;
+	as_status status;
+} as_batch_mux;
+
+typedef struct {
+	as_cluster* cluster;
+	const as_policy_batch* policy;
+	as_vector* records;
+	as_batch_node* batch_node;
+	as_async_batch_executor* executor;
+	as_error* err;
+	uint32_t* error_mutex;
+	cf_queue* complete_q;
+	uint8_t flags;
+} as_batch_task_async;
+
 typedef struct as_async_batch_command {
 	as_event_command command;
 	uint8_t* ubuf;
@@ -139,6 +210,23 @@ typedef struct {
 	bool can_repeat;
 } as_batch_retry_node;
 
+typedef struct {
+	as_vector offsets;
+	uint8_t* buf;
+	size_t size;
+} as_batch_prepared_command;
+
+typedef struct {
+	as_node* node;
+	as_vector routed; // Offsets mapped to node before grouping and splitting.
+	as_vector commands;
+} as_batch_prepared_node;
+
+typedef struct {
+	uint32_t offset;
+	as_status status;
+} as_batch_prepared_failure;
+
 typedef struct {
 	uint8_t* begin;
 	uint8_t* copy;
@@ -189,13 +277,28 @@ as_batch_parse_fields(uint8_t* p, uint32_t n_fields)
 }
 
 static inline as_status
-as_batch_parse_record(uint8_t** pp, as_error* err, as_msg* msg, as_record* rec, bool deserialize)
+as_batch_parse_record(
+	uint8_t** pp, as_error* err, as_msg* msg, as_record* rec, as_bin_block* block,
+	as_arena_chunk* chunk, bool deserialize
+	)
 {
-	as_record_init(rec, msg->n_ops);
-	rec->gen = msg->generation;
-	rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+	as_status status;
 
-	as_status status = as_command_parse_bins(pp, err, rec, msg->n_ops, deserialize);
+	if (chunk) {
+		// The chunk was sized for all records of the response block.
+		as_record_init(rec, 0);
+		rec->bins.entries = as_arena_alloc(chunk, sizeof(as_bin) * msg->n_ops);
+		rec->bins.capacity = msg->n_ops;
+		rec->gen = msg->generation;
+		rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+		status = as_command_parse_bins_arena(pp, err, rec, msg->n_ops, deserialize, chunk);
+	}
+	else {
+		as_record_init_block(rec, block, msg->n_ops);
+		rec->gen = msg->generation;
+		rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+		status = as_command_parse_bins(pp, err, rec, msg->n_ops, deserialize, false);
+	}
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(rec);
@@ -204,6 +307,85 @@ as_batch_parse_record(uint8_t** pp, as_error* err, as_msg* msg, as_record* rec,
 	return AEROSPIKE_OK;
 }
 
+static inline as_status
+as_batch_skip_record(uint8_t** pp, as_error* err, as_msg* msg, bool deserialize)
+{
+	if (msg->result_code != AEROSPIKE_OK && msg->result_code != AEROSPIKE_ERR_UDF) {
+		return AEROSPIKE_OK;
+	}
+
+	as_record rec;
+	as_status status = as_batch_parse_record(pp, err, msg, &rec, NULL, NULL, deserialize);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+	as_record_destroy(&rec);
+	return AEROSPIKE_OK;
+}
+
+static inline void
+as_batch_bitmap_set(uint8_t* bitmap, uint32_t offset)
+{
+	// Node commands run in parallel and may set bits in the same byte.
+	uint8_t* p = &bitmap[offset >> 3];
+	uint8_t bit = (uint8_t)(1 << (offset & 7));
+	uint8_t old;
+
+	do {
+		old = as_load_uint8(p);
+	} while (! as_cas_uint8(p, old, (uint8_t)(old | bit)));
+}
+
+static inline as_status
+as_batch_key_result(as_batch_task_keys* btk, uint32_t offset)
+{
+	if (btk->results) {
+		return btk->results[offset].result;
+	}
+
+	if (btk->status) {
+		return btk->status->results[offset];
+	}
+
+	// Results are not tracked. Retrying keys that already responded is harmless.
+	return AEROSPIKE_NO_RESPONSE;
+}
+
+static inline void
+as_batch_key_set_result(as_batch_task_keys* btk, uint32_t offset, as_status result)
+{
+	if (btk->results) {
+		btk->results[offset].result = result;
+	}
+	else if (btk->status) {
+		btk->status->results[offset] = result;
+	}
+}
+
+static inline void
+as_batch_parse_bound(uint8_t** pp, as_msg* msg, const as_batch_stream* stream, uint32_t offset)
+{
+	as_record_raw rec;
+	rec.digest.init = false;
+	rec.gen = msg->generation;
+	rec.ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+	rec.n_bins = msg->n_ops;
+	rec.bins = *pp;
+
+	as_binding_decode(stream->binding, &rec, stream->objs + stream->stride * offset,
+		stream->bind_status ? &stream->bind_status[offset] : NULL);
+	*pp = as_command_ignore_bins(*pp, msg->n_ops);
+}
+
+static inline void
+as_batch_stream_release(as_batch_base_record* rec)
+{
+	// Bins are only valid during the stream listener call.
+	as_record_destroy(&rec->record);
+	as_record_init(&rec->record, 0);
+}
+
 static void
 as_batch_complete_async(as_event_executor* executor)
 {
@@ -231,6 +413,7 @@ static inline void
 as_batch_destroy_ubuf(as_async_batch_command* bc)
 {
 	if (bc->ubuf) {
+		as_memory_sub(AS_MEMORY_BATCH, bc->ubuf_size);
 		cf_free(bc->ubuf);
 		bc->ubuf = NULL;
 	}
@@ -242,8 +425,90 @@ as_batch_in_doubt(bool has_write, uint32_t sent)
 	return has_write && sent > 1;
 }
 
+static void
+as_batch_count_bins(uint8_t* p, uint8_t* end, uint32_t* n_records, uint32_t* n_bins)
+{
+	// Count records and bins in the response block, so their bins are allocated at once.
+	// Headers are still in network byte order.
+	uint32_t records = 0;
+	uint32_t bins = 0;
+
+	while (p + sizeof(as_msg) <= end) {
+		as_msg* msg = (as_msg*)p;
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			break;
+		}
+
+		uint16_t n_fields = cf_swap_from_be16(msg->n_fields);
+		uint16_t n_ops = cf_swap_from_be16(msg->n_ops);
+
+		if (n_ops > 0) {
+			records++;
+			bins += n_ops;
+		}
+		p = as_command_ignore_bins(as_command_ignore_fields(p + sizeof(as_msg), n_fields), n_ops);
+	}
+	*n_records = records;
+	*n_bins = bins;
+}
+
+static inline as_bin_block*
+as_batch_bin_block_alloc(uint32_t n_records, uint32_t n_bins, bool confined)
+{
+	if (n_records <= 1) {
+		return NULL;
+	}
+
+	as_bin_block* block = as_bin_block_create(n_records, n_bins);
+
+	if (block) {
+		block->confined = confined;
+	}
+	return block;
+}
+
+static as_bin_block*
+as_batch_bin_block_create(uint8_t* p, uint8_t* end, bool confined)
+{
+	uint32_t n_records;
+	uint32_t n_bins;
+	as_batch_count_bins(p, end, &n_records, &n_bins);
+	return as_batch_bin_block_alloc(n_records, n_bins, confined);
+}
+
+static as_arena_chunk*
+as_batch_arena_chunk_alloc(
+	uint32_t n_records, uint32_t n_bins, size_t size, as_arena_chunk** arena
+	)
+{
+	if (n_records == 0) {
+		return NULL;
+	}
+
+	// Copied values never exceed the wire size of their records. Each record's bins may
+	// need up to 7 bytes of alignment padding.
+	uint32_t capacity = (uint32_t)(sizeof(as_bin) * n_bins + 8 * n_records + size);
+	as_arena_chunk* chunk = as_arena_chunk_create(capacity);
+
+	if (chunk) {
+		as_memory_add(AS_MEMORY_BATCH, sizeof(as_arena_chunk) + chunk->capacity);
+		as_arena_push(arena, chunk);
+	}
+	return chunk;
+}
+
+static as_arena_chunk*
+as_batch_arena_chunk_create(uint8_t* p, uint8_t* end, as_arena_chunk** arena)
+{
+	uint32_t n_records;
+	uint32_t n_bins;
+	as_batch_count_bins(p, end, &n_records, &n_bins);
+	return as_batch_arena_chunk_alloc(n_records, n_bins, end - p, arena);
+}
+
 static bool
-as_batch_async_parse_records(as_event_command* cmd)
+as_batch_async_parse_block(as_event_command* cmd, as_bin_block* block, as_arena_chunk* chunk)
 {
 	as_error err;
 	uint8_t* p = cmd->buf + cmd->pos;
@@ -279,10 +544,21 @@ as_batch_async_parse_records(as_event_command* cmd)
 		p = as_batch_parse_fields(p, msg->n_fields);
 		
 		as_batch_base_record* rec = as_vector_get(records, offset);
+
+		if (executor->record_listener && rec->result != AEROSPIKE_NO_RESPONSE) {
+			// Record was already streamed before this command was retried.
+			if (as_batch_skip_record(&p, &err, msg, cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE)
+				!= AEROSPIKE_OK) {
+				as_event_response_error(cmd, &err);
+				return true;
+			}
+			continue;
+		}
+
 		rec->result = msg->result_code;
 
 		if (msg->result_code == AEROSPIKE_OK) {
-			as_status status = as_batch_parse_record(&p, &err, msg, &rec->record,
+			as_status status = as_batch_parse_record(&p, &err, msg, &rec->record, block, chunk,
 													 cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
 
 			if (status != AEROSPIKE_OK) {
@@ -295,7 +571,7 @@ as_batch_async_parse_records(as_event_command* cmd)
 			executor->error_row = true;
 
 			// AEROSPIKE_ERR_UDF results in "FAILURE" bin that contains an error message.
-			as_status status = as_batch_parse_record(&p, &err, msg, &rec->record,
+			as_status status = as_batch_parse_record(&p, &err, msg, &rec->record, block, chunk,
 													 cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
 
 			if (status != AEROSPIKE_OK) {
@@ -307,23 +583,50 @@ as_batch_async_parse_records(as_event_command* cmd)
 			rec->in_doubt = as_batch_in_doubt(rec->has_write, cmd->command_sent_counter);
 			executor->error_row = true;
 		}
+
+		if (executor->record_listener) {
+			executor->record_listener(rec, offset, executor->executor.udata, cmd->event_loop);
+			as_batch_stream_release(rec);
+		}
 	}
 	return false;
 }
 
+static bool
+as_batch_async_parse_records(as_event_command* cmd)
+{
+	as_async_batch_executor* executor = cmd->udata;  // udata is overloaded to contain executor.
+
+	if (executor->arena) {
+		// Arena chunks are owned by the batch records.
+		as_arena_chunk* chunk = as_batch_arena_chunk_create(cmd->buf + cmd->pos,
+			cmd->buf + cmd->len, executor->arena);
+		return as_batch_async_parse_block(cmd, NULL, chunk);
+	}
+
+	as_bin_block* block = as_batch_bin_block_create(cmd->buf + cmd->pos, cmd->buf + cmd->len,
+		executor->confined);
+	bool rv = as_batch_async_parse_block(cmd, block, NULL);
+
+	// Records hold their own block references.
+	if (block) {
+		as_bin_block_release(block);
+	}
+	return rv;
+}
+
 static as_status
-as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+as_batch_parse_block(
+	as_error* err, as_command* cmd, as_msg_index* index, as_bin_block* block,
+	as_arena_chunk* chunk
+	)
 {
 	as_batch_task* task = cmd->udata;
 	bool deserialize = task->policy->deserialize;
 
-	uint8_t* p = buf;
-	uint8_t* end = buf + size;
-
-	while (p < end) {
-		as_msg* msg = (as_msg*)p;
-		as_msg_swap_header_from_be(msg);
-		p += sizeof(as_msg);
+	for (uint32_t i = 0; i < index->size; i++) {
+		as_msg* msg = index->msgs[i];
+		uint8_t* p = msg->data;
 		
 		if (msg->info3 & AS_MSG_INFO3_LAST) {
 			if (msg->result_code != AEROSPIKE_OK) {
@@ -346,10 +649,25 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 			case BATCH_TYPE_RECORDS: {
 				as_batch_task_records* btr = (as_batch_task_records*)task;
 				as_batch_base_record* rec = as_vector_get(btr->records, offset);
+
+				if (btr->stream && rec->result != AEROSPIKE_NO_RESPONSE) {
+					// Record was already streamed before this command was retried.
+					as_status status = as_batch_skip_record(&p, err, msg, deserialize);
+
+					if (status != AEROSPIKE_OK) {
+						return status;
+					}
+					break;
+				}
+
 				rec->result = msg->result_code;
 
-				if (msg->result_code == AEROSPIKE_OK) {
-					as_status status = as_batch_parse_record(&p, err, msg, &rec->record, deserialize);
+				if (msg->result_code == AEROSPIKE_OK && btr->stream && btr->stream->binding) {
+					as_batch_parse_bound(&p, msg, btr->stream, offset);
+				}
+				else if (msg->result_code == AEROSPIKE_OK) {
+					as_status status = as_batch_parse_record(&p, err, msg, &rec->record, block,
+						chunk, deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -360,7 +678,8 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 					*task->error_row = true;
 
 					// AEROSPIKE_ERR_UDF results in "FAILURE" bin that contains an error message.
-					as_status status = as_batch_parse_record(&p, err, msg, &rec->record, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &rec->record, block,
+						chunk, deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -370,6 +689,13 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 					rec->in_doubt = as_batch_in_doubt(rec->has_write, cmd->sent);
 					*task->error_row = true;
 				}
+
+				if (btr->stream) {
+					if (btr->stream->listener) {
+						btr->stream->listener(rec, offset, btr->stream->udata);
+					}
+					as_batch_stream_release(rec);
+				}
 				break;
 			}
 
@@ -379,7 +705,8 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 				res->result = msg->result_code;
 
 				if (msg->result_code == AEROSPIKE_OK) {
-					as_status status = as_batch_parse_record(&p, err, msg, &res->record, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &res->record, block,
+						NULL, deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -388,7 +715,8 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 				else if (msg->result_code == AEROSPIKE_ERR_UDF) {
 					res->in_doubt = as_batch_in_doubt(task->has_write, cmd->sent);
 					*task->error_row = true;
-					as_status status = as_batch_parse_record(&p, err, msg, &res->record, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &res->record, block,
+						NULL, deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -401,11 +729,54 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 				break;
 			}
 
+			case BATCH_TYPE_DIGESTS: {
+				as_batch_task_digests* btd = (as_batch_task_digests*)task;
+				as_batch_digest_result* res = &btd->results[offset];
+				res->result = msg->result_code;
+
+				if (msg->result_code == AEROSPIKE_OK) {
+					as_status status = as_batch_parse_record(&p, err, msg, &res->record, block,
+						NULL, deserialize);
+
+					if (status != AEROSPIKE_OK) {
+						return status;
+					}
+				}
+				else if (as_batch_set_error_row(msg->result_code)) {
+					*task->error_row = true;
+				}
+				break;
+			}
+
+			case BATCH_TYPE_KEYS_STATUS: {
+				// Bins are never parsed. Records are located by the message index.
+				as_batch_task_keys* btk = (as_batch_task_keys*)task;
+
+				if (btk->bitmap) {
+					if (msg->result_code == AEROSPIKE_OK) {
+						as_batch_bitmap_set(btk->bitmap, offset);
+					}
+					else if (as_batch_set_error_row(msg->result_code)) {
+						*task->error_row = true;
+					}
+					break;
+				}
+
+				btk->status->results[offset] = msg->result_code;
+
+				if (msg->result_code != AEROSPIKE_OK && as_batch_set_error_row(msg->result_code)) {
+					btk->status->in_doubt[offset] = as_batch_in_doubt(task->has_write, cmd->sent);
+					*task->error_row = true;
+				}
+				break;
+			}
+
 			case BATCH_TYPE_KEYS_NO_CALLBACK: {
 				as_record rec;
 
 				if (msg->result_code == AEROSPIKE_OK) {
-					as_status status = as_batch_parse_record(&p, err, msg, &rec, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &rec, NULL, NULL,
+						deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -413,7 +784,8 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 				}
 				else if (msg->result_code == AEROSPIKE_ERR_UDF) {
 					*task->error_row = true;
-					as_status status = as_batch_parse_record(&p, err, msg, &rec, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &rec, NULL, NULL,
+						deserialize);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -430,6 +802,42 @@ as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_batch_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+{
+	as_batch_task* task = cmd->udata;
+
+	// Index records first. The index also counts records and bins for the bin block.
+	as_msg_index index;
+	as_status status = as_msg_index_build(err, &index, buf, size);
+
+	if (status != AEROSPIKE_OK) {
+		as_msg_index_destroy(&index);
+		return status;
+	}
+
+	if (task->type == BATCH_TYPE_RECORDS && ((as_batch_task_records*)task)->arena) {
+		// Arena chunks are owned by the batch records.
+		as_arena_chunk* chunk = as_batch_arena_chunk_alloc(index.n_records, index.n_bins, size,
+			((as_batch_task_records*)task)->arena);
+		status = as_batch_parse_block(err, cmd, &index, NULL, chunk);
+		as_msg_index_destroy(&index);
+		return status;
+	}
+
+	// Status results never hold bins.
+	as_bin_block* block = (task->type == BATCH_TYPE_KEYS_STATUS) ? NULL :
+		as_batch_bin_block_alloc(index.n_records, index.n_bins, task->policy->thread_confined);
+	status = as_batch_parse_block(err, cmd, &index, block, NULL);
+	as_msg_index_destroy(&index);
+
+	// Records hold their own block references.
+	if (block) {
+		as_bin_block_release(block);
+	}
+	return status;
+}
+
 static inline uint8_t
 as_batch_get_flags(const as_policy_batch* policy) {
 	uint8_t flags = (policy->allow_inline)? 1 : 0;
@@ -1484,7 +1892,8 @@ as_batch_get_replica_sc(const as_policy_batch* policy)
 			return AS_POLICY_REPLICA_MASTER;
 
 		case AS_POLICY_READ_MODE_SC_LINEARIZE:
-			return (policy->replica != AS_POLICY_REPLICA_PREFER_RACK) ?
+			return (policy->replica != AS_POLICY_REPLICA_PREFER_RACK &&
+					policy->replica != AS_POLICY_REPLICA_LOWEST_LATENCY) ?
 					policy->replica : AS_POLICY_REPLICA_SEQUENCE;
 
 		default:
@@ -1510,6 +1919,10 @@ as_batch_get_node(
 		replica = replica_sc;
 		master = master_sc;
 	}
+	else if (has_write && replica == AS_POLICY_REPLICA_LOWEST_LATENCY) {
+		// Writes must always go to master node via sequence algorithm.
+		replica = AS_POLICY_REPLICA_SEQUENCE;
+	}
 
 	as_node* node = as_partition_get_node(cluster, pi.ns, pi.partition, prev_node, replica, master);
 
@@ -1522,6 +1935,95 @@ as_batch_get_node(
 	return AEROSPIKE_OK;
 }
 
+static inline bool
+as_batch_spread_master(const as_key* key, bool master)
+{
+	// Partition id is taken from the first 12 bits, so this bit splits keys of each partition
+	// evenly. Retries still alternate between master and prole.
+	return (key->digest.value[2] & 1) ? ! master : master;
+}
+
+static inline void
+as_batch_route_cache_init(
+	as_batch_route_cache* cache, as_cluster* cluster, const as_policy_batch* policy,
+	const char* ns, uint32_t n_keys
+	)
+{
+	// Cache routes of the first namespace only. Keys in other namespaces use a normal lookup.
+	cache->ns = ns;
+	cache->n_partitions = cluster->n_partitions;
+	cache->spread = policy->replica_spread;
+
+	// Read and write routes can differ in SC mode, so cache both. Spread reads also need
+	// the prole route.
+	cache->n_slots = cache->spread ? 3 : 2;
+
+	if (n_keys >= BATCH_ROUTE_CACHE_KEYS && cache->n_partitions > 0) {
+		cache->nodes = cf_calloc((size_t)cache->n_partitions * cache->n_slots, sizeof(as_node*));
+	}
+	else {
+		cache->nodes = NULL;
+	}
+}
+
+static inline void
+as_batch_route_cache_destroy(as_batch_route_cache* cache)
+{
+	cf_free(cache->nodes);
+}
+
+static inline as_status
+as_batch_get_node_cached(
+	as_batch_route_cache* cache, as_cluster* cluster, const as_key* key, as_policy_replica replica,
+	as_policy_replica replica_sc, bool has_write, as_node** node_pp
+	)
+{
+	bool master = true;
+	uint32_t slot = has_write;
+
+	if (cache->spread && ! has_write) {
+		replica = AS_POLICY_REPLICA_SEQUENCE;
+		master = as_batch_spread_master(key, true);
+		slot = master ? 0 : 2;
+	}
+
+	if (! cache->nodes || strcmp(key->ns, cache->ns) != 0) {
+		return as_batch_get_node(cluster, key, replica, replica_sc, master, true, has_write, NULL,
+			node_pp);
+	}
+
+	uint32_t index = as_partition_getid(key->digest.value, cache->n_partitions) * cache->n_slots +
+		slot;
+	as_node* node = cache->nodes[index];
+
+	if (node) {
+		*node_pp = node;
+		return AEROSPIKE_OK;
+	}
+
+	as_status status = as_batch_get_node(cluster, key, replica, replica_sc, master, true,
+		has_write, NULL, node_pp);
+
+	if (status == AEROSPIKE_OK) {
+		cache->nodes[index] = *node_pp;
+	}
+	return status;
+}
+
+static inline as_status
+as_batch_get_retry_node(
+	as_cluster* cluster, const as_key* key, as_policy_replica replica, as_policy_replica replica_sc,
+	bool spread, bool master, bool master_sc, bool has_write, as_node* prev_node, as_node** node_pp
+	)
+{
+	if (spread && ! has_write) {
+		replica = AS_POLICY_REPLICA_SEQUENCE;
+		master = as_batch_spread_master(key, master);
+	}
+	return as_batch_get_node(cluster, key, replica, replica_sc, master, master_sc, has_write,
+		prev_node, node_pp);
+}
+
 static inline void
 as_batch_command_init(
 	as_command* cmd, as_batch_task* task, const as_policy_batch* policy, uint8_t* buf, size_t size,
@@ -1580,18 +2082,52 @@ as_batch_builder_destroy(as_batch_builder* bb)
 	as_buffers_destroy(bb->buffers);
 }
 
-static void
-as_batch_set_doubt_records(as_batch_task_records* btr, as_error* err)
+// Serialize batch records command into buf without a cluster. Return command size or zero
+// on error. Used by the serialization micro benchmarks.
+size_t
+as_batch_records_serialize(
+	const as_policy_batch* policy, as_vector* records, as_vector* offsets, bool batch_any,
+	uint8_t* buf, size_t capacity, as_error* err
+	)
 {
-	uint32_t offsets_size = btr->base.offsets.size;
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), 8);
 
-	for (uint32_t i = 0; i < offsets_size; i++) {
-		uint32_t offset = *(uint32_t*)as_vector_get(&btr->base.offsets, i);
-		as_batch_base_record* rec = as_vector_get(btr->records, offset);
+	as_batch_builder bb = {
+		.filter_exp = policy->base.filter_exp,
+		.buffers = &buffers,
+		.batch_any = batch_any
+	};
 
-		if (rec->result == AEROSPIKE_NO_RESPONSE && rec->has_write) {
-			rec->in_doubt = err->in_doubt;
-		}
+	if (as_batch_records_size(records, offsets, &bb, err) != AEROSPIKE_OK) {
+		as_batch_builder_destroy(&bb);
+		return 0;
+	}
+
+	if (bb.size > capacity) {
+		as_batch_builder_destroy(&bb);
+		as_error_update(err, AEROSPIKE_ERR_CLIENT, "Batch command size %zu exceeds %zu",
+			bb.size, capacity);
+		return 0;
+	}
+
+	size_t size = as_batch_records_write(policy, records, offsets, &bb, buf);
+	as_batch_builder_destroy(&bb);
+	return size;
+}
+
+static void
+as_batch_set_doubt_records(as_batch_task_records* btr, as_error* err)
+{
+	uint32_t offsets_size = btr->base.offsets.size;
+
+	for (uint32_t i = 0; i < offsets_size; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(&btr->base.offsets, i);
+		as_batch_base_record* rec = as_vector_get(btr->records, offset);
+
+		if (rec->result == AEROSPIKE_NO_RESPONSE && rec->has_write) {
+			rec->in_doubt = err->in_doubt;
+		}
 	}
 }
 
@@ -1602,6 +2138,14 @@ as_batch_set_doubt_keys(as_batch_task_keys* btk, as_error* err)
 
 	for (uint32_t i = 0; i < offsets_size; i++) {
 		uint32_t offset = *(uint32_t*)as_vector_get(&btk->base.offsets, i);
+
+		if (btk->status) {
+			if (btk->status->results[offset] == AEROSPIKE_NO_RESPONSE) {
+				btk->status->in_doubt[offset] = err->in_doubt;
+			}
+			continue;
+		}
+
 		as_batch_result* res = &btk->results[offset];
 
 		if (res->result == AEROSPIKE_NO_RESPONSE) {
@@ -1610,12 +2154,37 @@ as_batch_set_doubt_keys(as_batch_task_keys* btk, as_error* err)
 	}
 }
 
+static as_status
+as_batch_execute_command(
+	as_batch_task_records* btr, as_error* err, as_command* parent, uint8_t* buf, size_t size
+	)
+{
+	as_command cmd;
+	as_batch_command_init(&cmd, &btr->base, btr->base.policy, buf, size, parent);
+
+	as_status status = as_command_execute(&cmd, err);
+
+	// Set in_doubt for keys associated this batch command when
+	// the command was not retried and split. If a split retry occurred,
+	// those new subcommands have already set in_doubt on the affected
+	// subset of keys.
+	if (status != AEROSPIKE_OK && !cmd.split_retry) {
+		as_batch_set_doubt_records(btr, err);
+	}
+	return status;
+}
+
 static as_status
 as_batch_execute_records(as_batch_task_records* btr, as_error* err, as_command* parent)
 {
 	as_batch_task* task = &btr->base;
 	const as_policy_batch* policy = task->policy;
 
+	if (task->buf) {
+		// Prepared batch command is never modified by the send.
+		return as_batch_execute_command(btr, err, parent, (uint8_t*)task->buf, task->buf_size);
+	}
+
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), 8);
 
@@ -1656,19 +2225,7 @@ as_batch_execute_records(as_batch_task_records* btr, as_error* err, as_command*
 		size = comp_size;
 	}
 
-	as_command cmd;
-	as_batch_command_init(&cmd, task, policy, buf, size, parent);
-
-	status = as_command_execute(&cmd, err);
-
-	// Set in_doubt for keys associated this batch command when
-	// the command was not retried and split. If a split retry occurred,
-	// those new subcommands have already set in_doubt on the affected
-	// subset of keys.
-	if (status != AEROSPIKE_OK && !cmd.split_retry) {
-		as_batch_set_doubt_records(btr, err);
-	}
-
+	status = as_batch_execute_command(btr, err, parent, buf, size);
 	as_command_buffer_free(buf, capacity);
 	return status;
 }
@@ -1867,7 +2424,8 @@ as_batch_execute_keys(as_batch_task_keys* btk, as_error* err, as_command* parent
 	// the command was not retried and split. If a split retry occurred,
 	// those new subcommands have already set in_doubt on the affected
 	// subset of keys.
-	if (btk->listener && status != AEROSPIKE_OK && !cmd.split_retry && btk->rec->has_write) {
+	if ((btk->listener || btk->status) && status != AEROSPIKE_OK && !cmd.split_retry &&
+		btk->rec->has_write) {
 		as_batch_set_doubt_keys(btk, err);
 	}
 
@@ -1875,6 +2433,129 @@ as_batch_execute_keys(as_batch_task_keys* btk, as_error* err, as_command* parent
 	return status;
 }
 
+static as_status
+as_batch_digests_size(
+	as_batch_task_digests* btd, as_vector* offsets, as_batch_builder* bb, as_error* err
+	)
+{
+	as_batch_init_size(bb);
+
+	if (! bb->batch_any) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+									"Batch digests not supported on older servers");
+	}
+
+	// Every digest shares one namespace/set, so only the first digest has a full message.
+	uint32_t n_offsets = offsets->size;
+	bb->size += (AS_DIGEST_VALUE_SIZE + sizeof(uint32_t) + 1) * n_offsets - 1;
+	return as_batch_record_size(btd->key, (as_batch_base_record*)btd->rec, bb, err);
+}
+
+static size_t
+as_batch_digests_write(
+	const as_policy_batch* policy, as_batch_task_digests* btd, as_vector* offsets,
+	as_batch_builder* bb, uint8_t* cmd
+	)
+{
+	uint32_t n_offsets = offsets->size;
+	uint8_t* p = as_batch_header_write_new(cmd, policy, n_offsets, bb);
+
+	uint8_t* batch_field = p;
+	p = as_command_write_field_header(p, AS_FIELD_BATCH_INDEX, 0);
+	*(uint32_t*)p = cf_swap_to_be32(n_offsets);
+	p += sizeof(uint32_t);
+	*p++ = as_batch_get_flags(policy);
+
+	const as_digest_value* digests = btd->batch->digests;
+	as_batch_read_record* rec = btd->rec;
+
+	for (uint32_t i = 0; i < n_offsets; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(offsets, i);
+		*(uint32_t*)p = cf_swap_to_be32(offset);
+		p += sizeof(uint32_t);
+
+		memcpy(p, digests[offset], AS_DIGEST_VALUE_SIZE);
+		p += AS_DIGEST_VALUE_SIZE;
+
+		if (i > 0) {
+			*p++ = BATCH_MSG_REPEAT;
+		}
+		else if (rec->bin_names) {
+			p = as_batch_write_bin_names(p, btd->key, btd->attr, NULL,
+				(const char**)rec->bin_names, rec->n_bin_names);
+		}
+		else {
+			p = as_batch_write_read(p, btd->key, btd->attr, NULL, 0);
+		}
+	}
+	return as_batch_trailer_write(cmd, p, batch_field);
+}
+
+static as_status
+as_batch_execute_digests(as_batch_task_digests* btd, as_error* err, as_command* parent)
+{
+	as_batch_task* task = &btd->base;
+	const as_policy_batch* policy = task->policy;
+
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), 8);
+
+	as_batch_builder bb = {
+		.filter_exp = policy->base.filter_exp,
+		.buffers = &buffers
+	};
+
+	as_batch_builder_set_node(&bb, task->node);
+
+	as_status status = as_batch_digests_size(btd, &task->offsets, &bb, err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_builder_destroy(&bb);
+		return status;
+	}
+
+	size_t capacity = bb.size;
+	uint8_t* buf = as_command_buffer_init(capacity);
+	size_t size = as_batch_digests_write(policy, btd, &task->offsets, &bb, buf);
+	as_batch_builder_destroy(&bb);
+
+	if (policy->base.compress && size > AS_COMPRESS_THRESHOLD) {
+		// Compress command.
+		size_t comp_capacity = as_command_compress_max_size(size);
+		size_t comp_size = comp_capacity;
+		uint8_t* comp_buf = as_command_buffer_init(comp_capacity);
+		status = as_command_compress(err, buf, size, comp_buf, &comp_size);
+		as_command_buffer_free(buf, capacity);
+
+		if (status != AEROSPIKE_OK) {
+			as_command_buffer_free(comp_buf, comp_capacity);
+			return status;
+		}
+		capacity = comp_capacity;
+		buf = comp_buf;
+		size = comp_size;
+	}
+
+	as_command cmd;
+	as_batch_command_init(&cmd, task, policy, buf, size, parent);
+
+	status = as_command_execute(&cmd, err);
+	as_command_buffer_free(buf, capacity);
+	return status;
+}
+
+static inline void
+as_batch_wait_task(cf_queue* complete_q, as_task_caller* caller, as_status* status)
+{
+	as_batch_complete_task complete;
+	cf_queue_pop(complete_q, &complete, CF_QUEUE_FOREVER);
+	as_task_caller_complete(caller);
+
+	if (complete.result != AEROSPIKE_OK && *status == AEROSPIKE_OK) {
+		*status = complete.result;
+	}
+}
+
 static void
 as_batch_worker(void* data)
 {
@@ -1890,6 +2571,10 @@ as_batch_worker(void* data)
 		// Execute batch referenced in aerospike_batch_read().
 		complete_task.result = as_batch_execute_records((as_batch_task_records*)task, &err, NULL);
 	}
+	else if (task->type == BATCH_TYPE_DIGESTS) {
+		// Execute batch referenced in aerospike_batch_get_digests().
+		complete_task.result = as_batch_execute_digests((as_batch_task_digests*)task, &err, NULL);
+	}
 	else {
 		// Execute batch referenced in aerospike_batch_get(), aerospike_batch_get_bins()
 		// and aerospike_batch_exists().
@@ -1961,116 +2646,678 @@ as_batch_release_nodes_after_async(as_vector* batch_nodes)
 	as_vector_destroy(batch_nodes);
 }
 
-static as_status
-as_batch_keys_execute(
-	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
-	as_batch_base_record* rec, as_batch_attr* attr, as_batch_listener listener, void* udata
+static void
+as_batch_split_node(
+	const as_policy_batch* policy, as_vector* batch_nodes, uint32_t index, size_t size
 	)
 {
-	uint32_t n_keys = batch->keys.size;
-	
-	if (n_keys == 0) {
-		if (listener) {
-			listener(0, 0, udata);
+	as_batch_node* batch_node = as_vector_get(batch_nodes, index);
+	uint32_t n_offsets = batch_node->offsets.size;
+	uint32_t max_keys = policy->max_keys_per_command;
+	uint32_t max_bytes = policy->max_bytes_per_command;
+	uint32_t n_commands = 1;
+
+	if (max_keys > 0 && n_offsets > max_keys) {
+		n_commands = (n_offsets + max_keys - 1) / max_keys;
+	}
+
+	if (max_bytes > 0 && size > max_bytes) {
+		uint32_t n = (uint32_t)((size + max_bytes - 1) / max_bytes);
+
+		if (n > n_commands) {
+			n_commands = n;
 		}
-		return AEROSPIKE_OK;
 	}
-	
-	as_cluster* cluster = as->cluster;
-	as_nodes* nodes = as_nodes_reserve(cluster);
-	uint32_t n_nodes = nodes->size;
-	as_nodes_release(nodes);
 
-	if (n_nodes == 0) {
-		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
+	if (n_commands > n_offsets) {
+		n_commands = n_offsets;
 	}
-	
-	// Allocate results array on stack.  May be an issue for huge batch.
-	as_batch_result* results = (listener)? (as_batch_result*)alloca(sizeof(as_batch_read) * n_keys) : 0;
 
-	as_vector batch_nodes;
-	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
+	if (n_commands <= 1) {
+		return;
+	}
 
-	char* ns = batch->keys.entries[0].ns;
-	as_status status = AEROSPIKE_OK;
-	
-	// Create initial key capacity for each node as average + 25%.
-	uint32_t offsets_capacity = n_keys / n_nodes;
-	offsets_capacity += offsets_capacity >> 2;
+	// Spread keys evenly. The original batch node keeps the first group of keys.
+	as_node* node = batch_node->node;
+	uint32_t per_command = n_offsets / n_commands;
+	uint32_t remainder = n_offsets % n_commands;
+	uint32_t first_size = per_command + (remainder > 0 ? 1 : 0);
+	uint32_t start = first_size;
 
-	// The minimum key capacity is 10.
-	if (offsets_capacity < 10) {
-		offsets_capacity = 10;
-	}
+	for (uint32_t i = 1; i < n_commands; i++) {
+		uint32_t count = per_command + (i < remainder ? 1 : 0);
 
-	as_policy_replica replica = policy->replica;
-	as_policy_replica replica_sc = as_batch_get_replica_sc(policy);
-	bool error_row = false;
+		as_batch_node* sub = as_vector_reserve(batch_nodes);
 
-	// Map keys to server nodes.
-	for (uint32_t i = 0; i < n_keys; i++) {
-		as_key* key = &batch->keys.entries[i];
-		
-		if (listener) {
-			as_batch_result* result = &results[i];
-			result->key = key;
-			result->result = AEROSPIKE_NO_RESPONSE;
-			result->in_doubt = false;
-			as_record_init(&result->record, 0);
-		}
-		
-		status = as_key_set_digest(err, key);
-		
-		if (status != AEROSPIKE_OK) {
-			as_batch_release_nodes(&batch_nodes);
-			return status;
-		}
+		// Reserve may have moved the batch node list.
+		batch_node = as_vector_get(batch_nodes, index);
 
-		as_node* node;
-		status = as_batch_get_node(cluster, key, replica, replica_sc, true, true, rec->has_write,
-			NULL, &node);
+		as_node_reserve(node);
+		sub->node = node;
+		as_vector_init(&sub->offsets, sizeof(uint32_t), count);
 
-		if (status != AEROSPIKE_OK) {
-			rec->result = status;
-			error_row = true;
-			continue;
+		for (uint32_t j = 0; j < count; j++) {
+			as_vector_append(&sub->offsets, as_vector_get(&batch_node->offsets, start + j));
 		}
+		start += count;
+	}
+	batch_node->offsets.size = first_size;
+}
 
-		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
-		
-		if (! batch_node) {
-			// Add batch node.
-			as_node_reserve(node);
-			batch_node = as_vector_reserve(&batch_nodes);
-			batch_node->node = node;  // Transfer node
+typedef struct {
+	uint64_t hash;
+	uint32_t offset;
+} as_batch_group_entry;
 
-			if (n_keys <= 5000) {
-				// All keys and offsets should fit on stack.
-				as_vector_inita(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
-			}
-			else {
-				// Allocate vector on heap to avoid stack overflow.
-				as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
-			}
-		}
-		as_vector_append(&batch_node->offsets, &i);
+static inline uint64_t
+as_batch_group_mix(uint64_t h, uint64_t v)
+{
+	h ^= v;
+	h *= 0x100000001b3ULL;
+	return h ^ (h >> 29);
+}
+
+static uint64_t
+as_batch_group_hash(as_batch_base_record* rec)
+{
+	// Hash the fields compared by as_batch_equals(), so records that can be sent with the
+	// repeat flag always hash the same.
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for (const char* p = rec->key.ns; *p; p++) {
+		h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
 	}
 
-	// Fatal if no key requests were generated on initialization.
-	if (batch_nodes.size == 0) {
-		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
+	for (const char* p = rec->key.set; *p; p++) {
+		h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
 	}
 
-	uint8_t type;
+	h = as_batch_group_mix(h, rec->type);
 
-	if (listener) {
-		type = BATCH_TYPE_KEYS;
-	}
-	else {
-		type = BATCH_TYPE_KEYS_NO_CALLBACK;
+	switch (rec->type) {
+	case AS_BATCH_READ: {
+		as_batch_read_record* r = (as_batch_read_record*)rec;
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->bin_names);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->ops);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->policy);
+		h = as_batch_group_mix(h, r->read_all_bins);
+		break;
 	}
 
-	uint32_t error_mutex = 0;
+	case AS_BATCH_WRITE: {
+		as_batch_write_record* r = (as_batch_write_record*)rec;
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->ops);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->policy);
+		break;
+	}
+
+	case AS_BATCH_APPLY: {
+		as_batch_apply_record* r = (as_batch_apply_record*)rec;
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->module);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->function);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->arglist);
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->policy);
+		break;
+	}
+
+	case AS_BATCH_REMOVE: {
+		as_batch_remove_record* r = (as_batch_remove_record*)rec;
+		h = as_batch_group_mix(h, (uint64_t)(uintptr_t)r->policy);
+		break;
+	}
+
+	default:
+		break;
+	}
+	return h;
+}
+
+static int
+as_batch_group_compare(const void* v1, const void* v2)
+{
+	const as_batch_group_entry* e1 = v1;
+	const as_batch_group_entry* e2 = v2;
+
+	if (e1->hash != e2->hash) {
+		return (e1->hash < e2->hash) ? -1 : 1;
+	}
+
+	// Keep original order within a group.
+	return (e1->offset < e2->offset) ? -1 : (e1->offset > e2->offset);
+}
+
+static void
+as_batch_records_group(
+	const as_policy_batch* policy, bool has_write, as_vector* records, as_vector* batch_nodes
+	)
+{
+	// The server applies records in command order, so writes may only be reordered when
+	// the user allows it.
+	if (has_write && ! policy->reorder_writes) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < batch_nodes->size; i++) {
+		as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+		uint32_t n_offsets = batch_node->offsets.size;
+
+		if (n_offsets < 3) {
+			continue;
+		}
+
+		as_batch_group_entry* entries = cf_malloc(sizeof(as_batch_group_entry) * n_offsets);
+		uint32_t runs = 1;
+
+		for (uint32_t j = 0; j < n_offsets; j++) {
+			uint32_t offset = *(uint32_t*)as_vector_get(&batch_node->offsets, j);
+			entries[j].hash = as_batch_group_hash(as_vector_get(records, offset));
+			entries[j].offset = offset;
+
+			if (j > 0 && entries[j].hash != entries[j - 1].hash) {
+				runs++;
+			}
+		}
+
+		// Records with the same operations are usually already adjacent.
+		if (runs > 1) {
+			qsort(entries, n_offsets, sizeof(as_batch_group_entry), as_batch_group_compare);
+
+			for (uint32_t j = 0; j < n_offsets; j++) {
+				*(uint32_t*)as_vector_get(&batch_node->offsets, j) = entries[j].offset;
+			}
+		}
+		cf_free(entries);
+	}
+}
+
+static as_status
+as_batch_records_split(
+	const as_policy_batch* policy, as_vector* records, as_vector* batch_nodes, as_error* err
+	)
+{
+	if (policy->max_keys_per_command == 0 && policy->max_bytes_per_command == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	// Only split the original batch nodes.
+	uint32_t n_batch_nodes = batch_nodes->size;
+
+	for (uint32_t i = 0; i < n_batch_nodes; i++) {
+		size_t size = 0;
+
+		if (policy->max_bytes_per_command > 0) {
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+
+			as_queue buffers;
+			as_queue_inita(&buffers, sizeof(as_buffer), 8);
+
+			as_batch_builder bb = {
+				.filter_exp = policy->base.filter_exp,
+				.buffers = &buffers
+			};
+
+			as_batch_builder_set_node(&bb, batch_node->node);
+
+			as_status status = as_batch_records_size(records, &batch_node->offsets, &bb, err);
+			as_batch_builder_destroy(&bb);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+			size = bb.size;
+		}
+		as_batch_split_node(policy, batch_nodes, i, size);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_batch_keys_split(
+	const as_policy_batch* policy, as_key* keys, as_batch_base_record* rec,
+	as_vector* batch_nodes, as_error* err
+	)
+{
+	if (policy->max_keys_per_command == 0 && policy->max_bytes_per_command == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	// Only split the original batch nodes.
+	uint32_t n_batch_nodes = batch_nodes->size;
+
+	for (uint32_t i = 0; i < n_batch_nodes; i++) {
+		size_t size = 0;
+
+		if (policy->max_bytes_per_command > 0) {
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+
+			as_queue buffers;
+			as_queue_inita(&buffers, sizeof(as_buffer), 8);
+
+			as_batch_builder bb = {
+				.filter_exp = policy->base.filter_exp,
+				.buffers = &buffers
+			};
+
+			as_batch_builder_set_node(&bb, batch_node->node);
+
+			as_status status = as_batch_keys_size(keys, &batch_node->offsets, rec, &bb, err);
+			as_batch_builder_destroy(&bb);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+			size = bb.size;
+		}
+		as_batch_split_node(policy, batch_nodes, i, size);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_batch_digests_split(as_batch_task_digests* btd, as_vector* batch_nodes, as_error* err)
+{
+	const as_policy_batch* policy = btd->base.policy;
+
+	if (policy->max_keys_per_command == 0 && policy->max_bytes_per_command == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	// Only split the original batch nodes.
+	uint32_t n_batch_nodes = batch_nodes->size;
+
+	for (uint32_t i = 0; i < n_batch_nodes; i++) {
+		size_t size = 0;
+
+		if (policy->max_bytes_per_command > 0) {
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+
+			as_queue buffers;
+			as_queue_inita(&buffers, sizeof(as_buffer), 8);
+
+			as_batch_builder bb = {
+				.filter_exp = policy->base.filter_exp,
+				.buffers = &buffers
+			};
+
+			as_batch_builder_set_node(&bb, batch_node->node);
+
+			as_status status = as_batch_digests_size(btd, &batch_node->offsets, &bb, err);
+			as_batch_builder_destroy(&bb);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+			size = bb.size;
+		}
+		as_batch_split_node(policy, batch_nodes, i, size);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_batch_digests_execute(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch_digests* batch,
+	as_batch_read_record* rec, as_batch_attr* attr, as_batch_digest_result* results
+	)
+{
+	uint32_t n_keys = batch->n_digests;
+
+	// Initialize results first, so they can always be destroyed.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_batch_digest_result* res = &results[i];
+		res->result = AEROSPIKE_NO_RESPONSE;
+		as_record_init(&res->record, 0);
+	}
+
+	if (n_keys == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+	as_nodes_release(nodes);
+
+	if (n_nodes == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
+	}
+
+	// Shared namespace/set for all digests. The digest field is only used to map nodes.
+	as_key key;
+	as_key_init_digest(&key, batch->ns, batch->set, batch->digests[0]);
+
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
+
+	// Create initial key capacity for each node as average + 25%.
+	uint32_t offsets_capacity = n_keys / n_nodes;
+	offsets_capacity += offsets_capacity >> 2;
+
+	// The minimum key capacity is 10.
+	if (offsets_capacity < 10) {
+		offsets_capacity = 10;
+	}
+
+	as_policy_replica replica = policy->replica;
+	as_policy_replica replica_sc = as_batch_get_replica_sc(policy);
+	as_status status = AEROSPIKE_OK;
+	bool error_row = false;
+
+	as_batch_route_cache cache;
+	as_batch_route_cache_init(&cache, cluster, policy, batch->ns, n_keys);
+
+	// Map digests to server nodes.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_batch_digest_result* res = &results[i];
+		memcpy(key.digest.value, batch->digests[i], AS_DIGEST_VALUE_SIZE);
+
+		as_node* node;
+		status = as_batch_get_node_cached(&cache, cluster, &key, replica, replica_sc, false, &node);
+
+		if (status != AEROSPIKE_OK) {
+			res->result = status;
+			error_row = true;
+			continue;
+		}
+
+		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
+
+		if (! batch_node) {
+			// Add batch node.
+			as_node_reserve(node);
+			batch_node = as_vector_reserve(&batch_nodes);
+			batch_node->node = node;  // Transfer node
+
+			// Allocate vector on heap to avoid stack overflow.
+			as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
+		}
+		as_vector_append(&batch_node->offsets, &i);
+	}
+	as_batch_route_cache_destroy(&cache);
+
+	// Fatal if no key requests were generated on initialization.
+	if (batch_nodes.size == 0) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
+	}
+
+	uint32_t error_mutex = 0;
+
+	// Initialize task.
+	as_batch_task_digests btd;
+	memset(&btd, 0, sizeof(as_batch_task_digests));
+	btd.base.cluster = cluster;
+	btd.base.policy = policy;
+	btd.base.err = err;
+	btd.base.error_mutex = &error_mutex;
+	btd.base.error_row = &error_row;
+	btd.base.n_keys = n_keys;
+	btd.base.replica_sc = replica_sc;
+	btd.base.type = BATCH_TYPE_DIGESTS;
+	btd.base.has_write = false;
+	btd.batch = batch;
+	btd.results = results;
+	btd.key = &key;
+	btd.rec = rec;
+	btd.attr = attr;
+
+	status = as_batch_digests_split(&btd, &batch_nodes, err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_release_nodes(&batch_nodes);
+		return status;
+	}
+
+	if (policy->concurrent && batch_nodes.size > 1) {
+		// Run batch requests in parallel in separate threads.
+		btd.base.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+
+		as_task_caller caller;
+		as_task_caller_init(&caller, &cluster->task_gate);
+
+		// Run task for each node.
+		for (uint32_t i = 0; i < batch_nodes.size; i++) {
+			// Stack allocate task for each node.  It should be fine since the task
+			// only needs to be valid within this function.
+			as_batch_task_digests* btd_node = alloca(sizeof(as_batch_task_digests));
+			memcpy(btd_node, &btd, sizeof(as_batch_task_digests));
+
+			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+			btd_node->base.node = batch_node->node;
+			memcpy(&btd_node->base.offsets, &batch_node->offsets, sizeof(as_vector));
+
+			// Wait for one of this call's tasks when its share of the thread pool is in use.
+			while (! as_task_caller_admit(&caller)) {
+				as_batch_wait_task(btd.base.complete_q, &caller, &status);
+			}
+
+			int rc = as_task_caller_queue(&caller, as_batch_worker, btd_node);
+
+			if (rc) {
+				// Thread could not be added.
+				if (as_fas_uint32(btd.base.error_mutex, 1) == 0) {
+					status = as_error_update(btd.base.err, AEROSPIKE_ERR_CLIENT,
+											 "Failed to add batch thread: %d", rc);
+				}
+			}
+		}
+
+		// Wait for tasks to complete.
+		while (as_task_caller_pending(&caller) > 0) {
+			as_batch_wait_task(btd.base.complete_q, &caller, &status);
+		}
+		as_task_caller_destroy(&caller);
+
+		// Release temporary queue.
+		cf_queue_destroy(btd.base.complete_q);
+	}
+	else {
+		// Run batch requests sequentially in same thread.
+		for (uint32_t i = 0; i < batch_nodes.size; i++) {
+			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+
+			btd.base.node = batch_node->node;
+			memcpy(&btd.base.offsets, &batch_node->offsets, sizeof(as_vector));
+
+			as_status s = as_batch_execute_digests(&btd, err, NULL);
+
+			if (s != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+				status = s;
+
+				if (! policy->respond_all_keys) {
+					break;
+				}
+			}
+		}
+	}
+
+	// Release each node.
+	as_batch_release_nodes(&batch_nodes);
+
+	if (status == AEROSPIKE_OK && error_row) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
+			"One or more batch sub-commands failed");
+	}
+	return status;
+}
+
+static void
+as_batch_status_errors(as_batch_status* bs)
+{
+	cf_free(bs->errors);
+	bs->errors = NULL;
+
+	uint32_t n_errors = 0;
+
+	for (uint32_t i = 0; i < bs->n_keys; i++) {
+		if (bs->results[i] != AEROSPIKE_OK) {
+			n_errors++;
+		}
+	}
+	bs->n_errors = n_errors;
+
+	if (n_errors == 0) {
+		return;
+	}
+
+	bs->errors = cf_malloc(sizeof(uint32_t) * n_errors);
+	n_errors = 0;
+
+	for (uint32_t i = 0; i < bs->n_keys; i++) {
+		if (bs->results[i] != AEROSPIKE_OK) {
+			bs->errors[n_errors++] = i;
+		}
+	}
+}
+
+static as_status
+as_batch_keys_run(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
+	as_batch_base_record* rec, as_batch_attr* attr, as_batch_listener listener, void* udata,
+	as_batch_status* bs, uint8_t* bitmap
+	)
+{
+	uint32_t n_keys = batch->keys.size;
+
+	if (bs) {
+		if (n_keys > bs->capacity) {
+			return as_error_update(err, AEROSPIKE_ERR_PARAM,
+				"Batch size %u exceeds status capacity %u", n_keys, bs->capacity);
+		}
+
+		// Keys that never reach a node keep AEROSPIKE_NO_RESPONSE.
+		for (uint32_t i = 0; i < n_keys; i++) {
+			bs->results[i] = AEROSPIKE_NO_RESPONSE;
+		}
+		memset(bs->in_doubt, 0, n_keys);
+		bs->n_keys = n_keys;
+		bs->n_errors = 0;
+	}
+
+	if (bitmap) {
+		memset(bitmap, 0, (n_keys + 7) / 8);
+	}
+	
+	if (n_keys == 0) {
+		if (listener) {
+			listener(0, 0, udata);
+		}
+		return AEROSPIKE_OK;
+	}
+	
+	as_cluster* cluster = as->cluster;
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+	as_nodes_release(nodes);
+
+	if (n_nodes == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
+	}
+	
+	// Allocate results array on stack.  May be an issue for huge batch.
+	as_batch_result* results = (listener)? (as_batch_result*)alloca(sizeof(as_batch_read) * n_keys) : 0;
+
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
+
+	char* ns = batch->keys.entries[0].ns;
+	as_status status = AEROSPIKE_OK;
+	
+	// Create initial key capacity for each node as average + 25%.
+	uint32_t offsets_capacity = n_keys / n_nodes;
+	offsets_capacity += offsets_capacity >> 2;
+
+	// The minimum key capacity is 10.
+	if (offsets_capacity < 10) {
+		offsets_capacity = 10;
+	}
+
+	as_policy_replica replica = policy->replica;
+	as_policy_replica replica_sc = as_batch_get_replica_sc(policy);
+	bool error_row = false;
+
+	// Compute all digests up front so keys can be hashed in parallel lanes.
+	status = as_key_set_digests(err, batch->keys.entries, n_keys, sizeof(as_key));
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_release_nodes(&batch_nodes);
+		return status;
+	}
+
+	as_batch_route_cache cache;
+	as_batch_route_cache_init(&cache, cluster, policy, ns, n_keys);
+
+	// Map keys to server nodes.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key* key = &batch->keys.entries[i];
+		
+		if (listener) {
+			as_batch_result* result = &results[i];
+			result->key = key;
+			result->result = AEROSPIKE_NO_RESPONSE;
+			result->in_doubt = false;
+			as_record_init(&result->record, 0);
+		}
+
+		as_node* node;
+		status = as_batch_get_node_cached(&cache, cluster, key, replica, replica_sc,
+			rec->has_write, &node);
+
+		if (status != AEROSPIKE_OK) {
+			rec->result = status;
+
+			if (bs) {
+				bs->results[i] = status;
+			}
+			error_row = true;
+			continue;
+		}
+
+		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
+		
+		if (! batch_node) {
+			// Add batch node.
+			as_node_reserve(node);
+			batch_node = as_vector_reserve(&batch_nodes);
+			batch_node->node = node;  // Transfer node
+
+			if (n_keys <= 5000) {
+				// All keys and offsets should fit on stack.
+				as_vector_inita(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
+			}
+			else {
+				// Allocate vector on heap to avoid stack overflow.
+				as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
+			}
+		}
+		as_vector_append(&batch_node->offsets, &i);
+	}
+	as_batch_route_cache_destroy(&cache);
+
+	// Fatal if no key requests were generated on initialization.
+	if (batch_nodes.size == 0) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
+	}
+
+	status = as_batch_keys_split(policy, batch->keys.entries, rec, &batch_nodes, err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_release_nodes(&batch_nodes);
+		return status;
+	}
+
+	uint8_t type;
+
+	if (listener) {
+		type = BATCH_TYPE_KEYS;
+	}
+	else if (bs || bitmap) {
+		type = BATCH_TYPE_KEYS_STATUS;
+	}
+	else {
+		type = BATCH_TYPE_KEYS_NO_CALLBACK;
+	}
+
+	uint32_t error_mutex = 0;
 
 	// Initialize task.
 	as_batch_task_keys btk;
@@ -2092,262 +3339,744 @@ as_batch_keys_execute(
 	btk.udata = udata;
 	btk.rec = rec;
 	btk.attr = attr;
+	btk.status = bs;
+	btk.bitmap = bitmap;
+
+	if (policy->concurrent && batch_nodes.size > 1) {
+		// Run batch requests in parallel in separate threads.
+		btk.base.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+		
+		as_task_caller caller;
+		as_task_caller_init(&caller, &cluster->task_gate);
+		
+		// Run task for each node.
+		for (uint32_t i = 0; i < batch_nodes.size; i++) {
+			// Stack allocate task for each node.  It should be fine since the task
+			// only needs to be valid within this function.
+			as_batch_task_keys* btk_node = alloca(sizeof(as_batch_task_keys));
+			memcpy(btk_node, &btk, sizeof(as_batch_task_keys));
+			
+			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+			btk_node->base.node = batch_node->node;
+			memcpy(&btk_node->base.offsets, &batch_node->offsets, sizeof(as_vector));
+
+			// Wait for one of this call's tasks when its share of the thread pool is in use.
+			while (! as_task_caller_admit(&caller)) {
+				as_batch_wait_task(btk.base.complete_q, &caller, &status);
+			}
+
+			int rc = as_task_caller_queue(&caller, as_batch_worker, btk_node);
+			
+			if (rc) {
+				// Thread could not be added.
+				if (as_fas_uint32(btk.base.error_mutex, 1) == 0) {
+					status = as_error_update(btk.base.err, AEROSPIKE_ERR_CLIENT,
+											 "Failed to add batch thread: %d", rc);
+				}
+			}
+		}
+		
+		// Wait for tasks to complete.
+		while (as_task_caller_pending(&caller) > 0) {
+			as_batch_wait_task(btk.base.complete_q, &caller, &status);
+		}
+		as_task_caller_destroy(&caller);
+		
+		// Release temporary queue.
+		cf_queue_destroy(btk.base.complete_q);
+	}
+	else {
+		// Run batch requests sequentially in same thread.
+		as_error e;
+
+		for (uint32_t i = 0; status == AEROSPIKE_OK && i < batch_nodes.size; i++) {
+			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+			
+			btk.base.node = batch_node->node;
+			memcpy(&btk.base.offsets, &batch_node->offsets, sizeof(as_vector));
+			as_error_init(&e);
+
+			as_status s = as_batch_execute_keys(&btk, err, NULL);
+
+			if (s != AEROSPIKE_OK) {
+				if (policy->respond_all_keys) {
+					if (status == AEROSPIKE_OK) {
+						as_error_copy(err, &e);
+						status = s;
+					}
+				}
+				else {
+					as_error_copy(err, &e);
+					status = s;
+					break;
+				}
+			}
+		}
+	}
+
+	// Release each node.
+	as_batch_release_nodes(&batch_nodes);
+
+	// Call user defined function with results.
+	if (listener) {
+		listener(btk.results, n_keys, udata);
+		
+		// Destroy records. User is responsible for destroying keys with as_batch_destroy().
+		for (uint32_t i = 0; i < n_keys; i++) {
+			as_batch_result* br = &btk.results[i];
+			as_record_destroy(&br->record);
+		}
+	}
+
+	if (bs) {
+		as_batch_status_errors(bs);
+	}
+
+	if (status == AEROSPIKE_OK && error_row) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
+			"One or more batch sub-commands failed");
+	}
+	return status;
+}
+
+static inline as_status
+as_batch_keys_execute(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
+	as_batch_base_record* rec, as_batch_attr* attr, as_batch_listener listener, void* udata
+	)
+{
+	return as_batch_keys_run(as, err, policy, batch, rec, attr, listener, udata, NULL, NULL);
+}
+
+static as_status
+as_batch_execute_sync(
+	as_cluster* cluster, as_error* err, const as_policy_batch* policy, bool has_write,
+	as_policy_replica replica_sc, as_vector* records, as_arena_chunk** arena, uint32_t n_keys,
+	as_vector* batch_nodes, as_command* parent, bool* error_row, const as_batch_stream* stream
+	)
+{
+	as_status status = AEROSPIKE_OK;
+	uint32_t error_mutex = 0;
+	uint32_t n_batch_nodes = batch_nodes->size;
+
+	// Initialize task.
+	as_batch_task_records btr;
+	memset(&btr, 0, sizeof(as_batch_task_records));
+	btr.base.cluster = cluster;
+	btr.base.policy = policy;
+	btr.base.err = err;
+	btr.base.error_mutex = &error_mutex;
+	btr.base.error_row = error_row;
+	btr.base.n_keys = n_keys;
+	btr.base.replica_sc = replica_sc;
+	btr.base.type = BATCH_TYPE_RECORDS;
+	btr.base.has_write = has_write;
+	btr.records = records;
+	btr.arena = arena;
+	btr.stream = stream;
+
+	if (policy->concurrent && n_batch_nodes > 1 && parent == NULL) {
+		// Run batch requests in parallel in separate threads.
+		btr.base.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+		
+		as_task_caller caller;
+		as_task_caller_init(&caller, &cluster->task_gate);
+		
+		// Run task for each node.
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			// Stack allocate task for each node.  It should be fine since the task
+			// only needs to be valid within this function.
+			as_batch_task_records* btr_node = alloca(sizeof(as_batch_task_records));
+			memcpy(btr_node, &btr, sizeof(as_batch_task_records));
+			
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+			btr_node->base.node = batch_node->node;
+			memcpy(&btr_node->base.offsets, &batch_node->offsets, sizeof(as_vector));
+			btr_node->base.buf = batch_node->buf;
+			btr_node->base.buf_size = batch_node->buf_size;
+
+			// Wait for one of this call's tasks when its share of the thread pool is in use.
+			while (! as_task_caller_admit(&caller)) {
+				as_batch_wait_task(btr.base.complete_q, &caller, &status);
+			}
+
+			int rc = as_task_caller_queue(&caller, as_batch_worker, btr_node);
+
+			if (rc) {
+				// Thread could not be added.
+				if (as_fas_uint32(btr.base.error_mutex, 1) == 0) {
+					status = as_error_update(btr.base.err, AEROSPIKE_ERR_CLIENT,
+											 "Failed to add batch thread: %d", rc);
+				}
+			}
+		}
+		
+		// Wait for tasks to complete.
+		while (as_task_caller_pending(&caller) > 0) {
+			as_batch_wait_task(btr.base.complete_q, &caller, &status);
+		}
+		as_task_caller_destroy(&caller);
+		
+		// Release temporary queue.
+		cf_queue_destroy(btr.base.complete_q);
+	}
+	else {
+		// Run batch requests sequentially in same thread.
+		as_error e;
+
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+
+			btr.base.node = batch_node->node;
+			memcpy(&btr.base.offsets, &batch_node->offsets, sizeof(as_vector));
+			btr.base.buf = batch_node->buf;
+			btr.base.buf_size = batch_node->buf_size;
+			as_error_init(&e);
+
+			as_status s = as_batch_execute_records(&btr, &e, parent);
+
+			if (s != AEROSPIKE_OK) {
+				if (policy->respond_all_keys) {
+					if (status == AEROSPIKE_OK) {
+						as_error_copy(err, &e);
+						status = s;
+					}
+				}
+				else {
+					as_error_copy(err, &e);
+					status = s;
+					break;
+				}
+			}
+		}
+	}
+	
+	// Release each node.
+	as_batch_release_nodes(batch_nodes);
+	return status;
+}
+
+static inline as_async_batch_command*
+as_batch_command_create(
+	as_cluster* cluster, const as_policy_batch* policy, as_node* node,
+	as_async_batch_executor* executor, size_t size, uint8_t flags, uint8_t* ubuf, uint32_t ubuf_size
+	)
+{
+	// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
+	// fragmentation and to allow socket read to reuse buffer.
+	size_t s = (sizeof(as_async_batch_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
+
+	as_async_batch_command* bc = as_alloc_malloc(s);
+	bc->ubuf = ubuf;
+	bc->ubuf_size = ubuf_size;
+
+	if (ubuf) {
+		as_memory_add(AS_MEMORY_BATCH, ubuf_size);
+	}
+
+	as_event_command* cmd = &bc->command;
+	cmd->total_deadline = policy->base.total_timeout;
+	cmd->socket_timeout = policy->base.socket_timeout;
+	cmd->max_retries = policy->base.max_retries;
+	cmd->iteration = 0;
+	cmd->replica = policy->replica;
+	cmd->event_loop = executor->executor.event_loop;
+	cmd->cluster = cluster;
+	cmd->node = node;
+	cmd->ns = NULL;
+	cmd->partition = NULL;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
+	cmd->udata = executor;  // Overload udata to be the executor.
+	cmd->parse_results = as_batch_async_parse_records;
+	cmd->pipe_listener = NULL;
+	cmd->buf = ((as_async_batch_command*)cmd)->space;
+	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_batch_command));
+	cmd->type = AS_ASYNC_TYPE_BATCH;
+	cmd->proto_type = AS_MESSAGE_TYPE;
+	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
+	cmd->flags = flags;
+	cmd->flags2 = policy->deserialize ? AS_ASYNC_FLAGS2_DESERIALIZE : 0;
+	cmd->priority = (uint8_t)policy->base.priority;
+	return bc;
+}
+
+static as_status
+as_batch_execute_node_async(
+	as_cluster* cluster, as_error* err, const as_policy_batch* policy, as_vector* records,
+	as_batch_node* batch_node, as_async_batch_executor* executor, uint8_t flags
+	)
+{
+	// Each node has its own builder, so nodes can be serialized in parallel.
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), 8);
+
+	as_batch_builder bb = {
+		.filter_exp = policy->base.filter_exp,
+		.buffers = &buffers
+	};
+
+	as_batch_builder_set_node(&bb, batch_node->node);
+
+	// Estimate buffer size.
+	as_status status = as_batch_records_size(records, &batch_node->offsets, &bb, err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_builder_destroy(&bb);
+		as_node_release(batch_node->node);
+		return status;
+	}
 
-	if (policy->concurrent && batch_nodes.size > 1) {
-		// Run batch requests in parallel in separate threads.
-		btk.base.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
-		
-		uint32_t n_wait_nodes = 0;
-		
-		// Run task for each node.
-		for (uint32_t i = 0; i < batch_nodes.size; i++) {
-			// Stack allocate task for each node.  It should be fine since the task
-			// only needs to be valid within this function.
-			as_batch_task_keys* btk_node = alloca(sizeof(as_batch_task_keys));
-			memcpy(btk_node, &btk, sizeof(as_batch_task_keys));
-			
-			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
-			btk_node->base.node = batch_node->node;
-			memcpy(&btk_node->base.offsets, &batch_node->offsets, sizeof(as_vector));
+	if (! (policy->base.compress && bb.size > AS_COMPRESS_THRESHOLD)) {
+		// Send uncompressed command.
+		as_async_batch_command* bc = as_batch_command_create(cluster, policy, batch_node->node,
+			executor, bb.size, flags, NULL, 0);
 
-			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_batch_worker, btk_node);
-			
-			if (rc == 0) {
-				n_wait_nodes++;
-			}
-			else {
-				// Thread could not be added.
-				if (as_fas_uint32(btk.base.error_mutex, 1) == 0) {
-					status = as_error_update(btk.base.err, AEROSPIKE_ERR_CLIENT,
-											 "Failed to add batch thread: %d", rc);
-				}
+		as_event_command* cmd = &bc->command;
+
+		cmd->write_len = (uint32_t)as_batch_records_write(policy, records, &batch_node->offsets,
+			&bb, cmd->buf);
+
+		as_batch_builder_destroy(&bb);
+
+		// Node is released in as_event_command_execute() on failure.
+		return as_event_command_execute(cmd, err);
+	}
+
+	// Send compressed command.
+	// First write uncompressed buffer.
+	size_t capacity = bb.size;
+	uint8_t* ubuf = cf_malloc(capacity);
+	size_t size = as_batch_records_write(policy, records, &batch_node->offsets, &bb, ubuf);
+	as_batch_builder_destroy(&bb);
+
+	// Allocate command with compressed upper bound.
+	size_t comp_size = as_command_compress_max_size(size);
+
+	as_async_batch_command* bc = as_batch_command_create(cluster, policy, batch_node->node,
+		executor, comp_size, flags, ubuf, (uint32_t)size);
+
+	as_event_command* cmd = &bc->command;
+
+	// Compress buffer and execute.
+	status = as_command_compress(err, ubuf, size, cmd->buf, &comp_size);
+
+	if (status != AEROSPIKE_OK) {
+		as_node_release(batch_node->node);
+		as_batch_destroy_ubuf(bc);
+		as_alloc_free(cmd);
+		return status;
+	}
+	cmd->write_len = (uint32_t)comp_size;
+	return as_event_command_execute(cmd, err);
+}
+
+static void
+as_batch_worker_async(void* data)
+{
+	as_batch_task_async* task = (as_batch_task_async*)data;
+
+	as_batch_complete_task complete_task;
+	complete_task.node = task->batch_node->node;
+
+	as_error err;
+	as_error_init(&err);
+
+	complete_task.result = as_batch_execute_node_async(task->cluster, &err, task->policy,
+		task->records, task->batch_node, task->executor, task->flags);
+
+	if (complete_task.result != AEROSPIKE_OK) {
+		// Copy error to main error only once.
+		if (as_fas_uint32(task->error_mutex, 1) == 0) {
+			as_error_copy(task->err, &err);
+		}
+	}
+	cf_queue_push(task->complete_q, &complete_task);
+}
+
+static as_status
+as_batch_execute_async(
+	as_cluster* cluster, as_error* err, const as_policy_batch* policy, as_policy_replica replica_sc,
+	as_vector* records, as_vector* batch_nodes, as_async_batch_executor* executor
+	)
+{
+	uint32_t n_batch_nodes = batch_nodes->size;
+	as_event_executor* exec = &executor->executor;
+	exec->max_concurrent = exec->max = exec->queued = n_batch_nodes;
+	executor->replica_sc = replica_sc;
+
+	// Note: Do not set flags to AS_ASYNC_FLAGS_LINEARIZE because AP and SC replicas
+	// are tracked separately for batch (AS_ASYNC_FLAGS_MASTER and AS_ASYNC_FLAGS_MASTER_SC).
+	// SC master/replica switch is done in as_batch_retry_async().
+	uint8_t flags = AS_ASYNC_FLAGS_MASTER | AS_ASYNC_FLAGS_MASTER_SC;
+
+	if (! executor->has_write) {
+		flags |= AS_ASYNC_FLAGS_READ;
+	}
+
+	as_status status = AEROSPIKE_OK;
+
+	// The parallel path waits for the thread pool, so it is only used when the calling
+	// thread is allowed to block. Event loop callbacks serialize nodes serially.
+	if (n_batch_nodes > 1 && records->size >= BATCH_ASYNC_PARALLEL_RECORDS &&
+		as_event_can_block()) {
+		// Serialize and send each node's command in a separate thread. Each command
+		// starts as soon as its own buffer is written.
+		uint32_t error_mutex = 0;
+		cf_queue* complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+
+		// Stack allocate tasks. They only need to be valid within this function.
+		as_batch_task_async* tasks = alloca(sizeof(as_batch_task_async) * n_batch_nodes);
+
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			as_batch_task_async* task = &tasks[i];
+			task->cluster = cluster;
+			task->policy = policy;
+			task->records = records;
+			task->batch_node = as_vector_get(batch_nodes, i);
+			task->executor = executor;
+			task->err = err;
+			task->error_mutex = &error_mutex;
+			task->complete_q = complete_q;
+			task->flags = flags;
+
+			if (as_task_gate_queue(&cluster->task_gate, as_batch_worker_async, task) != 0) {
+				// Thread could not be added. Serialize node in this thread.
+				as_batch_worker_async(task);
 			}
 		}
-		
-		// Wait for tasks to complete.
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
+
+		// Wait for all nodes to be serialized. Every node is either transferred to its
+		// command or released when its task fails.
+		uint32_t n_queued = 0;
+
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
 			as_batch_complete_task complete;
-			cf_queue_pop(btk.base.complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+			cf_queue_pop(complete_q, &complete, CF_QUEUE_FOREVER);
+
+			if (complete.result == AEROSPIKE_OK) {
+				n_queued++;
+			}
+			else if (status == AEROSPIKE_OK) {
 				status = complete.result;
 			}
 		}
-		
-		// Release temporary queue.
-		cf_queue_destroy(btk.base.complete_q);
+		cf_queue_destroy(complete_q);
+
+		if (status != AEROSPIKE_OK) {
+			if (executor->blocking) {
+				// The blocked sync caller is notified when queued commands complete.
+				as_event_executor_error(exec, err, n_batch_nodes - n_queued);
+				status = AEROSPIKE_OK;
+			}
+			else {
+				as_event_executor_cancel(exec, n_queued);
+			}
+		}
 	}
 	else {
-		// Run batch requests sequentially in same thread.
-		as_error e;
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
 
-		for (uint32_t i = 0; status == AEROSPIKE_OK && i < batch_nodes.size; i++) {
-			as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
-			
-			btk.base.node = batch_node->node;
-			memcpy(&btk.base.offsets, &batch_node->offsets, sizeof(as_vector));
-			as_error_init(&e);
+			status = as_batch_execute_node_async(cluster, err, policy, records, batch_node,
+				executor, flags);
 
-			as_status s = as_batch_execute_keys(&btk, err, NULL);
+			if (status != AEROSPIKE_OK) {
+				// Current node was released, so start at current node + 1.
+				as_batch_release_nodes_cancel_async(batch_nodes, i + 1);
 
-			if (s != AEROSPIKE_OK) {
-				if (policy->respond_all_keys) {
-					if (status == AEROSPIKE_OK) {
-						as_error_copy(err, &e);
-						status = s;
-					}
+				if (executor->blocking) {
+					// The blocked sync caller is notified when queued commands complete.
+					as_event_executor_error(exec, err, n_batch_nodes - i);
+					status = AEROSPIKE_OK;
 				}
 				else {
-					as_error_copy(err, &e);
-					status = s;
-					break;
+					as_event_executor_cancel(exec, i);
 				}
+				break;
 			}
 		}
 	}
+	as_batch_release_nodes_after_async(batch_nodes);
+	return status;
+}
 
-	// Release each node.
-	as_batch_release_nodes(&batch_nodes);
-
-	// Call user defined function with results.
-	if (listener) {
-		listener(btk.results, n_keys, udata);
-		
-		// Destroy records. User is responsible for destroying keys with as_batch_destroy().
-		for (uint32_t i = 0; i < n_keys; i++) {
-			as_batch_result* br = &btk.results[i];
-			as_record_destroy(&br->record);
-		}
+static void
+as_batch_records_cleanup(
+	as_async_batch_executor* async_executor, as_vector* batch_nodes
+	)
+{
+	if (batch_nodes) {
+		as_batch_release_nodes(batch_nodes);
 	}
 
-	if (status == AEROSPIKE_OK && error_row) {
-		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
-			"One or more batch sub-commands failed");
+	if (async_executor) {
+		// Destroy batch async resources.
+		// Assume no async commands have been queued.
+		cf_free(async_executor);
 	}
-	return status;
 }
 
 static as_status
-as_batch_execute_sync(
-	as_cluster* cluster, as_error* err, const as_policy_batch* policy, bool has_write,
-	as_policy_replica replica_sc, as_vector* records, uint32_t n_keys, as_vector* batch_nodes,
-	as_command* parent, bool* error_row
+as_batch_records_execute(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_async_batch_executor* async_executor, bool has_write, const as_batch_stream* stream
 	)
 {
+	as_vector* list = &records->list;
+	uint32_t n_keys = records->list.size;
+	
+	if (n_keys == 0) {
+		return AEROSPIKE_OK;
+	}
+	
+	as_cluster* cluster = as->cluster;
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+	as_nodes_release(nodes);
+	
+	if (n_nodes == 0) {
+		as_batch_records_cleanup(async_executor, NULL);
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
+	}
+	
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
+
 	as_status status = AEROSPIKE_OK;
-	uint32_t error_mutex = 0;
-	uint32_t n_batch_nodes = batch_nodes->size;
+	
+	// Create initial key capacity for each node as average + 25%.
+	uint32_t offsets_capacity = n_keys / n_nodes;
+	offsets_capacity += offsets_capacity >> 2;
+	
+	// The minimum key capacity is 10.
+	if (offsets_capacity < 10) {
+		offsets_capacity = 10;
+	}
+	
+	as_policy_replica replica = policy->replica;
+	as_policy_replica replica_sc = as_batch_get_replica_sc(policy);
+	bool error_row = false;
 
-	// Initialize task.
-	as_batch_task_records btr;
-	memset(&btr, 0, sizeof(as_batch_task_records));
-	btr.base.cluster = cluster;
-	btr.base.policy = policy;
-	btr.base.err = err;
-	btr.base.error_mutex = &error_mutex;
-	btr.base.error_row = error_row;
-	btr.base.n_keys = n_keys;
-	btr.base.replica_sc = replica_sc;
-	btr.base.type = BATCH_TYPE_RECORDS;
-	btr.base.has_write = has_write;
-	btr.records = records;
+	// Compute all digests up front so keys can be hashed in parallel lanes.
+	as_batch_base_record* first = as_vector_get(list, 0);
+	status = as_key_set_digests(err, &first->key, n_keys, list->item_size);
 
-	if (policy->concurrent && n_batch_nodes > 1 && parent == NULL) {
-		// Run batch requests in parallel in separate threads.
-		btr.base.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+	if (status != AEROSPIKE_OK) {
+		as_batch_records_cleanup(async_executor, &batch_nodes);
+		return status;
+	}
+
+	as_batch_route_cache cache;
+	as_batch_route_cache_init(&cache, cluster, policy, first->key.ns, n_keys);
+
+	// Map keys to server nodes.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_batch_base_record* rec = as_vector_get(list, i);
+		as_key* key = &rec->key;
 		
-		uint32_t n_wait_nodes = 0;
+		rec->result = AEROSPIKE_NO_RESPONSE;
+		as_record_init(&rec->record, 0);
 		
-		// Run task for each node.
-		for (uint32_t i = 0; i < n_batch_nodes; i++) {
-			// Stack allocate task for each node.  It should be fine since the task
-			// only needs to be valid within this function.
-			as_batch_task_records* btr_node = alloca(sizeof(as_batch_task_records));
-			memcpy(btr_node, &btr, sizeof(as_batch_task_records));
-			
-			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
-			btr_node->base.node = batch_node->node;
-			memcpy(&btr_node->base.offsets, &batch_node->offsets, sizeof(as_vector));
+		as_node* node;
+		status = as_batch_get_node_cached(&cache, cluster, key, replica, replica_sc,
+			rec->has_write, &node);
 
-			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_batch_worker, btr_node);
+		if (status != AEROSPIKE_OK) {
+			rec->result = status;
+			error_row = true;
+			continue;
+		}
 
-			if (rc == 0) {
-				n_wait_nodes++;
+		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
+		
+		if (! batch_node) {
+			// Add batch node.
+			as_node_reserve(node);
+			batch_node = as_vector_reserve(&batch_nodes);
+			batch_node->node = node;  // Transfer node
+			
+			if (n_keys <= 5000) {
+				// All keys and offsets should fit on stack.
+				as_vector_inita(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
 			}
 			else {
-				// Thread could not be added.
-				if (as_fas_uint32(btr.base.error_mutex, 1) == 0) {
-					status = as_error_update(btr.base.err, AEROSPIKE_ERR_CLIENT,
-											 "Failed to add batch thread: %d", rc);
-				}
+				// Allocate vector on heap to avoid stack overflow.
+				as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
 			}
 		}
-		
-		// Wait for tasks to complete.
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
-			as_batch_complete_task complete;
-			cf_queue_pop(btr.base.complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-				status = complete.result;
-			}
+		as_vector_append(&batch_node->offsets, &i);
+	}
+	as_batch_route_cache_destroy(&cache);
+
+	// Fatal if no key requests were generated on initialization.
+	if (batch_nodes.size == 0) {
+		if (async_executor) {
+			// Destroy batch async resources.
+			cf_free(async_executor);
 		}
-		
-		// Release temporary queue.
-		cf_queue_destroy(btr.base.complete_q);
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
 	}
-	else {
-		// Run batch requests sequentially in same thread.
-		as_error e;
 
-		for (uint32_t i = 0; i < n_batch_nodes; i++) {
-			as_batch_node* batch_node = as_vector_get(batch_nodes, i);
+	as_batch_records_group(policy, has_write, list, &batch_nodes);
 
-			btr.base.node = batch_node->node;
-			memcpy(&btr.base.offsets, &batch_node->offsets, sizeof(as_vector));
-			as_error_init(&e);
+	status = as_batch_records_split(policy, list, &batch_nodes, err);
 
-			as_status s = as_batch_execute_records(&btr, &e, parent);
+	if (status != AEROSPIKE_OK) {
+		as_batch_records_cleanup(async_executor, &batch_nodes);
+		return status;
+	}
 
-			if (s != AEROSPIKE_OK) {
-				if (policy->respond_all_keys) {
-					if (status == AEROSPIKE_OK) {
-						as_error_copy(err, &e);
-						status = s;
-					}
-				}
-				else {
-					as_error_copy(err, &e);
-					status = s;
-					break;
-				}
-			}
+	if (async_executor) {
+		async_executor->error_row = error_row;
+		return as_batch_execute_async(cluster, err, policy, replica_sc, list, &batch_nodes,
+			async_executor);
+	}
+	else {
+		// Streamed records are released after each listener call, so they do not use the arena.
+		as_arena_chunk** arena = (policy->arena && ! stream) ? &records->arena : NULL;
+
+		status = as_batch_execute_sync(cluster, err, policy, has_write, replica_sc, list, arena,
+			n_keys, &batch_nodes, NULL, &error_row, stream);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (error_row) {
+			return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
+				"One or more batch sub-commands failed");
 		}
+		return AEROSPIKE_OK;
+	}
+}
+
+static as_status
+as_batch_records_execute_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_async_batch_record_listener record_listener, as_async_batch_listener listener, void* udata,
+	as_event_loop* event_loop, bool has_write, bool blocking
+	)
+{
+	// Check for empty batch.
+	if (records->list.size == 0) {
+		listener(0, records, udata, event_loop);
+		return AEROSPIKE_OK;
 	}
 	
-	// Release each node.
-	as_batch_release_nodes(batch_nodes);
-	return status;
+	// Batch will be split up into a command for each node.
+	// Allocate batch data shared by each command.
+	as_async_batch_executor* be = cf_malloc(sizeof(as_async_batch_executor));
+	be->records = records;
+	be->listener = listener;
+	be->record_listener = record_listener;
+	be->arena = (policy->arena && ! record_listener) ? &records->arena : NULL;
+	be->replica = policy->replica;
+	be->replica_spread = policy->replica_spread;
+	// replica_sc is set later in as_batch_execute_async().
+	// be->replica_sc = as_batch_get_replica_sc(policy);
+	be->read_mode_sc = policy->read_mode_sc;
+	be->has_write = has_write;
+	be->error_row = false;
+	be->blocking = blocking;
+	be->confined = policy->thread_confined;
+
+	as_event_executor* exec = &be->executor;
+	pthread_mutex_init(&exec->lock, NULL);
+	exec->commands = 0;
+	exec->event_loop = as_event_assign(event_loop);
+	exec->flow = NULL;
+	exec->cancel = NULL;
+	exec->paused = NULL;
+	exec->complete_fn = as_batch_complete_async;
+	exec->udata = udata;
+	exec->err = NULL;
+	exec->ns = NULL;
+	exec->cluster_key = 0;
+	exec->max_concurrent = 0;
+	exec->max = 0;
+	exec->count = 0;
+	exec->queued = 0;
+	exec->notify = true;
+	exec->valid = true;
+	exec->spread = false;
+
+	return as_batch_records_execute(as, err, policy, records, be, has_write, NULL);
 }
 
-static inline as_async_batch_command*
-as_batch_command_create(
-	as_cluster* cluster, const as_policy_batch* policy, as_node* node,
-	as_async_batch_executor* executor, size_t size, uint8_t flags, uint8_t* ubuf, uint32_t ubuf_size
+static void
+as_batch_mux_record_listener(
+	as_batch_base_record* record, uint32_t index, void* udata, as_event_loop* event_loop
 	)
 {
-	// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
-	// fragmentation and to allow socket read to reuse buffer.
-	size_t s = (sizeof(as_async_batch_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
+	as_batch_mux* mux = udata;
+	mux->stream->listener(record, index, mux->stream->udata);
+}
 
-	as_async_batch_command* bc = cf_malloc(s);
-	bc->ubuf = ubuf;
-	bc->ubuf_size = ubuf_size;
+static void
+as_batch_mux_listener(
+	as_error* err, as_batch_records* records, void* udata, as_event_loop* event_loop
+	)
+{
+	as_batch_mux* mux = udata;
 
-	as_event_command* cmd = &bc->command;
-	cmd->total_deadline = policy->base.total_timeout;
-	cmd->socket_timeout = policy->base.socket_timeout;
-	cmd->max_retries = policy->base.max_retries;
-	cmd->iteration = 0;
-	cmd->replica = policy->replica;
-	cmd->event_loop = executor->executor.event_loop;
-	cmd->cluster = cluster;
-	cmd->node = node;
-	cmd->ns = NULL;
-	cmd->partition = NULL;
-	cmd->udata = executor;  // Overload udata to be the executor.
-	cmd->parse_results = as_batch_async_parse_records;
-	cmd->pipe_listener = NULL;
-	cmd->buf = ((as_async_batch_command*)cmd)->space;
-	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_batch_command));
-	cmd->type = AS_ASYNC_TYPE_BATCH;
-	cmd->proto_type = AS_MESSAGE_TYPE;
-	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
-	cmd->flags = flags;
-	cmd->flags2 = policy->deserialize ? AS_ASYNC_FLAGS2_DESERIALIZE : 0;
-	return bc;
+	if (err) {
+		// Start errors are reported with the caller's error structure.
+		if (err != mux->err) {
+			as_error_copy(mux->err, err);
+		}
+		mux->status = err->code;
+	}
+	as_monitor_notify(&mux->monitor);
 }
 
 static as_status
-as_batch_execute_async(
-	as_cluster* cluster, as_error* err, const as_policy_batch* policy, as_policy_replica replica_sc,
-	as_vector* records, as_vector* batch_nodes, as_async_batch_executor* executor
+as_batch_records_execute_sync(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	bool has_write, const as_batch_stream* stream
 	)
 {
-	uint32_t n_batch_nodes = batch_nodes->size;
-	as_event_executor* exec = &executor->executor;
-	exec->max_concurrent = exec->max = exec->queued = n_batch_nodes;
-	executor->replica_sc = replica_sc;
+	if (! (policy->concurrent && policy->multiplex && as_event_can_block())) {
+		return as_batch_records_execute(as, err, policy, records, NULL, has_write, stream);
+	}
 
-	// Note: Do not set flags to AS_ASYNC_FLAGS_LINEARIZE because AP and SC replicas
-	// are tracked separately for batch (AS_ASYNC_FLAGS_MASTER and AS_ASYNC_FLAGS_MASTER_SC).
-	// SC master/replica switch is done in as_batch_retry_async().
-	uint8_t flags = AS_ASYNC_FLAGS_MASTER | AS_ASYNC_FLAGS_MASTER_SC;
+	// Drive all node commands on an event loop and block until the last node completes.
+	as_batch_mux mux;
+	as_monitor_init(&mux.monitor);
+	mux.stream = stream;
+	mux.err = err;
+	mux.status = AEROSPIKE_OK;
 
-	if (! executor->has_write) {
-		flags |= AS_ASYNC_FLAGS_READ;
+	as_status status = as_batch_records_execute_async(as, err, policy, records,
+		stream ? as_batch_mux_record_listener : NULL, as_batch_mux_listener, &mux, NULL,
+		has_write, true);
+
+	if (status == AEROSPIKE_OK) {
+		as_monitor_wait(&mux.monitor);
+		status = mux.status;
 	}
+	as_monitor_destroy(&mux.monitor);
+	return status;
+}
 
+//---------------------------------
+// Prepared Functions
+//---------------------------------
+
+static inline void
+as_batch_offsets_copy(as_vector* dst, const as_vector* src)
+{
+	as_vector_init(dst, sizeof(uint32_t), src->size > 0 ? src->size : 1);
+	memcpy(dst->list, src->list, src->size * sizeof(uint32_t));
+	dst->size = src->size;
+}
+
+static as_status
+as_batch_prepared_serialize(
+	const as_policy_batch* policy, as_vector* records, as_node* node,
+	as_batch_prepared_command* pc, as_error* err
+	)
+{
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), 8);
 
@@ -2356,248 +4085,222 @@ as_batch_execute_async(
 		.buffers = &buffers
 	};
 
-	as_status status = AEROSPIKE_OK;
+	as_batch_builder_set_node(&bb, node);
 
-	for (uint32_t i = 0; i < n_batch_nodes; i++) {
-		as_batch_node* batch_node = as_vector_get(batch_nodes, i);
-		as_batch_builder_set_node(&bb, batch_node->node);
+	as_status status = as_batch_records_size(records, &pc->offsets, &bb, err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_builder_destroy(&bb);
+		return status;
+	}
+
+	// Prepared commands outlive this call, so they are not taken from the buffer pool.
+	uint8_t* buf = cf_malloc(bb.size);
+	size_t size = as_batch_records_write(policy, records, &pc->offsets, &bb, buf);
+	as_batch_builder_destroy(&bb);
 
-		// Estimate buffer size.
-		status = as_batch_records_size(records, &batch_node->offsets, &bb, err);
+	if (policy->base.compress && size > AS_COMPRESS_THRESHOLD) {
+		size_t comp_size = as_command_compress_max_size(size);
+		uint8_t* comp_buf = cf_malloc(comp_size);
+		status = as_command_compress(err, buf, size, comp_buf, &comp_size);
+		cf_free(buf);
 
 		if (status != AEROSPIKE_OK) {
-			as_event_executor_cancel(exec, i);
-			as_batch_release_nodes_cancel_async(batch_nodes, i);
-			break;
+			cf_free(comp_buf);
+			return status;
 		}
+		buf = comp_buf;
+		size = comp_size;
+	}
 
-		if (! (policy->base.compress && bb.size > AS_COMPRESS_THRESHOLD)) {
-			// Send uncompressed command.
-			as_async_batch_command* bc = as_batch_command_create(cluster, policy, batch_node->node,
-				executor, bb.size, flags, NULL, 0);
+	pc->buf = buf;
+	pc->size = size;
+	return AEROSPIKE_OK;
+}
 
-			as_event_command* cmd = &bc->command;
+static void
+as_batch_prepared_node_destroy(as_batch_prepared_node* pn)
+{
+	for (uint32_t i = 0; i < pn->commands.size; i++) {
+		as_batch_prepared_command* pc = as_vector_get(&pn->commands, i);
+		as_vector_destroy(&pc->offsets);
+		cf_free(pc->buf);
+	}
+	as_vector_destroy(&pn->commands);
+	as_vector_destroy(&pn->routed);
+	as_node_release(pn->node);
+}
 
-			cmd->write_len = (uint32_t)as_batch_records_write(policy, records, &batch_node->offsets,
-				&bb, cmd->buf);
+static as_status
+as_batch_prepared_node_build(
+	as_batch_prepared* bp, as_batch_node* batch_node, as_batch_prepared_node* pn, as_error* err
+	)
+{
+	// Take the batch node's reservation and offsets.
+	as_vector* list = &bp->records->list;
+	pn->node = batch_node->node;
+	pn->routed = batch_node->offsets;
 
-			status = as_event_command_execute(cmd, err);
-		}
-		else {
-			// Send compressed command.
-			// First write uncompressed buffer.
-			size_t capacity = bb.size;
-			uint8_t* ubuf = cf_malloc(capacity);
-			size_t size = as_batch_records_write(policy, records, &batch_node->offsets, &bb, ubuf);
+	// Group and split a copy like a normal batch, then serialize each command.
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), 4);
 
-			// Allocate command with compressed upper bound.
-			size_t comp_size = as_command_compress_max_size(size);
+	as_batch_node* bn = as_vector_reserve(&batch_nodes);
+	as_node_reserve(pn->node);
+	bn->node = pn->node;
+	as_batch_offsets_copy(&bn->offsets, &pn->routed);
 
-			as_async_batch_command* bc = as_batch_command_create(cluster, policy, batch_node->node,
-				executor, comp_size, flags, ubuf, (uint32_t)size);
+	as_batch_records_group(&bp->policy, bp->has_write, list, &batch_nodes);
 
-			as_event_command* cmd = &bc->command;
+	as_status status = as_batch_records_split(&bp->policy, list, &batch_nodes, err);
 
-			// Compress buffer and execute.
-			status = as_command_compress(err, ubuf, size, cmd->buf, &comp_size);
+	as_vector_init(&pn->commands, sizeof(as_batch_prepared_command), batch_nodes.size);
 
-			if (status != AEROSPIKE_OK) {
-				as_event_executor_cancel(exec, i);
-				// Current node not released, so start at current node.
-				as_batch_release_nodes_cancel_async(batch_nodes, i);
-				cf_free(ubuf);
-				cf_free(cmd);
-				break;
-			}
-			cmd->write_len = (uint32_t)comp_size;
-			status = as_event_command_execute(cmd, err);
-		}
+	for (uint32_t i = 0; i < batch_nodes.size && status == AEROSPIKE_OK; i++) {
+		bn = as_vector_get(&batch_nodes, i);
 
-		if (status != AEROSPIKE_OK) {
-			as_event_executor_cancel(exec, i);
-			// Current node was released in as_event_command_execute(), so start at current node + 1.
-			as_batch_release_nodes_cancel_async(batch_nodes, i + 1);
-			break;
-		}
+		as_batch_prepared_command* pc = as_vector_reserve(&pn->commands);
+		as_batch_offsets_copy(&pc->offsets, &bn->offsets);
+		status = as_batch_prepared_serialize(&bp->policy, list, pn->node, pc, err);
 	}
-	as_batch_builder_destroy(&bb);
-	as_batch_release_nodes_after_async(batch_nodes);
+
+	as_batch_release_nodes(&batch_nodes);
 	return status;
 }
 
-static void
-as_batch_records_cleanup(
-	as_async_batch_executor* async_executor, as_vector* batch_nodes
-	)
+static as_batch_prepared_node*
+as_batch_prepared_node_find(as_vector* nodes, as_batch_node* batch_node)
 {
-	if (batch_nodes) {
-		as_batch_release_nodes(batch_nodes);
-	}
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_batch_prepared_node* pn = as_vector_get(nodes, i);
 
-	if (async_executor) {
-		// Destroy batch async resources.
-		// Assume no async commands have been queued.
-		cf_free(async_executor);
+		if (pn->node == batch_node->node && pn->routed.size == batch_node->offsets.size &&
+			memcmp(pn->routed.list, batch_node->offsets.list,
+				batch_node->offsets.size * sizeof(uint32_t)) == 0) {
+			return pn;
+		}
 	}
+	return NULL;
 }
 
-static as_status
-as_batch_records_execute(
-	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
-	as_async_batch_executor* async_executor, bool has_write
-	)
-{
-	as_vector* list = &records->list;
-	uint32_t n_keys = records->list.size;
-	
-	if (n_keys == 0) {
-		return AEROSPIKE_OK;
-	}
-	
-	as_cluster* cluster = as->cluster;
-	as_nodes* nodes = as_nodes_reserve(cluster);
-	uint32_t n_nodes = nodes->size;
-	as_nodes_release(nodes);
-	
-	if (n_nodes == 0) {
-		as_batch_records_cleanup(async_executor, NULL);
-		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
-	}
-	
-	as_vector batch_nodes;
-	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
-
-	as_status status = AEROSPIKE_OK;
-	
+static void
+as_batch_prepared_route(
+	as_batch_prepared* bp, as_cluster* cluster, uint32_t n_nodes, as_vector* batch_nodes
+	)
+{
+	as_vector* list = &bp->records->list;
+	uint32_t n_keys = list->size;
+
 	// Create initial key capacity for each node as average + 25%.
 	uint32_t offsets_capacity = n_keys / n_nodes;
 	offsets_capacity += offsets_capacity >> 2;
-	
-	// The minimum key capacity is 10.
+
 	if (offsets_capacity < 10) {
 		offsets_capacity = 10;
 	}
-	
-	as_policy_replica replica = policy->replica;
-	as_policy_replica replica_sc = as_batch_get_replica_sc(policy);
-	bool error_row = false;
 
-	// Map keys to server nodes.
+	as_batch_base_record* first = as_vector_get(list, 0);
+	as_batch_route_cache cache;
+	as_batch_route_cache_init(&cache, cluster, &bp->policy, first->key.ns, n_keys);
+	bp->failed.size = 0;
+
 	for (uint32_t i = 0; i < n_keys; i++) {
 		as_batch_base_record* rec = as_vector_get(list, i);
-		as_key* key = &rec->key;
-		
-		rec->result = AEROSPIKE_NO_RESPONSE;
-		as_record_init(&rec->record, 0);
-		
-		status = as_key_set_digest(err, key);
-		
-		if (status != AEROSPIKE_OK) {
-			as_batch_records_cleanup(async_executor, &batch_nodes);
-			return status;
-		}
-		
+
 		as_node* node;
-		status = as_batch_get_node(cluster, key, replica, replica_sc, true, true, rec->has_write,
-			NULL, &node);
+		as_status status = as_batch_get_node_cached(&cache, cluster, &rec->key,
+			bp->policy.replica, bp->replica_sc, rec->has_write, &node);
 
 		if (status != AEROSPIKE_OK) {
-			rec->result = status;
-			error_row = true;
+			as_batch_prepared_failure* failure = as_vector_reserve(&bp->failed);
+			failure->offset = i;
+			failure->status = status;
 			continue;
 		}
 
-		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
-		
+		as_batch_node* batch_node = as_batch_node_find(batch_nodes, node);
+
 		if (! batch_node) {
-			// Add batch node.
 			as_node_reserve(node);
-			batch_node = as_vector_reserve(&batch_nodes);
+			batch_node = as_vector_reserve(batch_nodes);
 			batch_node->node = node;  // Transfer node
-			
-			if (n_keys <= 5000) {
-				// All keys and offsets should fit on stack.
-				as_vector_inita(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
-			}
-			else {
-				// Allocate vector on heap to avoid stack overflow.
-				as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
-			}
+			as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
 		}
 		as_vector_append(&batch_node->offsets, &i);
 	}
+	as_batch_route_cache_destroy(&cache);
+}
 
-	// Fatal if no key requests were generated on initialization.
-	if (batch_nodes.size == 0) {
-		if (async_executor) {
-			// Destroy batch async resources.
-			cf_free(async_executor);
-		}
-		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
-	}
+static as_status
+as_batch_prepared_refresh(
+	as_batch_prepared* bp, as_cluster* cluster, uint32_t partition_gen, as_error* err
+	)
+{
+	as_nodes* cluster_nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = cluster_nodes->size;
+	as_nodes_release(cluster_nodes);
 
-	if (async_executor) {
-		async_executor->error_row = error_row;
-		return as_batch_execute_async(cluster, err, policy, replica_sc, list, &batch_nodes,
-			async_executor);
+	if (n_nodes == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
 	}
-	else {
-		status = as_batch_execute_sync(cluster, err, policy, has_write, replica_sc, list, n_keys,
-			&batch_nodes, NULL, &error_row);
 
-		if (status != AEROSPIKE_OK) {
-			return status;
+	as_vector batch_nodes;
+	as_vector_init(&batch_nodes, sizeof(as_batch_node), n_nodes);
+	as_batch_prepared_route(bp, cluster, n_nodes, &batch_nodes);
+
+	as_vector nodes;
+	as_vector_init(&nodes, sizeof(as_batch_prepared_node), batch_nodes.size + 1);
+
+	as_status status = AEROSPIKE_OK;
+	bp->rebuilt_nodes = 0;
+
+	for (uint32_t i = 0; i < batch_nodes.size; i++) {
+		as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+		as_batch_prepared_node* prev = as_batch_prepared_node_find(&bp->nodes, batch_node);
+
+		if (prev) {
+			// Same keys map to same node, so the serialized commands are still valid.
+			*(as_batch_prepared_node*)as_vector_reserve(&nodes) = *prev;
+			prev->node = NULL;
+			as_node_release(batch_node->node);
+			as_vector_destroy(&batch_node->offsets);
+			continue;
 		}
 
-		if (error_row) {
-			return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
-				"One or more batch sub-commands failed");
+		if (status != AEROSPIKE_OK) {
+			as_node_release(batch_node->node);
+			as_vector_destroy(&batch_node->offsets);
+			continue;
 		}
-		return AEROSPIKE_OK;
-	}
-}
 
-static as_status
-as_batch_records_execute_async(
-	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
-	as_async_batch_listener listener, void* udata, as_event_loop* event_loop, bool has_write
-	)
-{
-	// Check for empty batch.
-	if (records->list.size == 0) {
-		listener(0, records, udata, event_loop);
-		return AEROSPIKE_OK;
+		as_batch_prepared_node* pn = as_vector_reserve(&nodes);
+		status = as_batch_prepared_node_build(bp, batch_node, pn, err);
+		bp->rebuilt_nodes++;
 	}
-	
-	// Batch will be split up into a command for each node.
-	// Allocate batch data shared by each command.
-	as_async_batch_executor* be = cf_malloc(sizeof(as_async_batch_executor));
-	be->records = records;
-	be->listener = listener;
-	be->replica = policy->replica;
-	// replica_sc is set later in as_batch_execute_async().
-	// be->replica_sc = as_batch_get_replica_sc(policy);
-	be->read_mode_sc = policy->read_mode_sc;
-	be->has_write = has_write;
-	be->error_row = false;
+	as_vector_destroy(&batch_nodes);
 
-	as_event_executor* exec = &be->executor;
-	pthread_mutex_init(&exec->lock, NULL);
-	exec->commands = 0;
-	exec->event_loop = as_event_assign(event_loop);
-	exec->complete_fn = as_batch_complete_async;
-	exec->udata = udata;
-	exec->err = NULL;
-	exec->ns = NULL;
-	exec->cluster_key = 0;
-	exec->max_concurrent = 0;
-	exec->max = 0;
-	exec->count = 0;
-	exec->queued = 0;
-	exec->notify = true;
-	exec->valid = true;
+	// Free commands of nodes whose keys moved.
+	for (uint32_t i = 0; i < bp->nodes.size; i++) {
+		as_batch_prepared_node* pn = as_vector_get(&bp->nodes, i);
+
+		if (pn->node) {
+			as_batch_prepared_node_destroy(pn);
+		}
+	}
+	as_vector_destroy(&bp->nodes);
 
-	return as_batch_records_execute(as, err, policy, records, be, has_write);
+	if (status != AEROSPIKE_OK) {
+		// The generation is not updated, so the next execution builds all routes again.
+		for (uint32_t i = 0; i < nodes.size; i++) {
+			as_batch_prepared_node_destroy(as_vector_get(&nodes, i));
+		}
+		nodes.size = 0;
+	}
+	else {
+		bp->partition_gen = partition_gen;
+	}
+	bp->nodes = nodes;
+	return status;
 }
 
 //---------------------------------
@@ -2647,8 +4350,9 @@ as_batch_retry_records(as_batch_task_records* btr, as_command* parent, as_error*
 		as_key* key = &rec->key;
 
 		as_node* node;
-		as_status status = as_batch_get_node(cluster, key, replica, replica_sc, parent->master,
-			parent->master_sc, rec->has_write, parent->node, &node);
+		as_status status = as_batch_get_retry_node(cluster, key, replica, replica_sc,
+			task->policy->replica_spread, parent->master, parent->master_sc, rec->has_write,
+			parent->node, &node);
 
 		if (status != AEROSPIKE_OK) {
 			rec->result = status;
@@ -2686,7 +4390,7 @@ as_batch_retry_records(as_batch_task_records* btr, as_command* parent, as_error*
 	parent->split_retry = true;
 
 	return as_batch_execute_sync(cluster, err, task->policy, task->has_write, task->replica_sc,
-		list, task->n_keys, &batch_nodes, parent, task->error_row);
+		list, btr->arena, task->n_keys, &batch_nodes, parent, task->error_row, btr->stream);
 }
 
 static as_status
@@ -2723,16 +4427,110 @@ as_batch_retry_keys(as_batch_task_keys* btk, as_command* parent, as_error* err)
 	for (uint32_t i = 0; i < offsets_size; i++) {
 		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
 		as_key* key = &btk->batch->keys.entries[offset];
-		as_batch_result* res = &btk->results[offset];
+
+		if (as_batch_key_result(btk, offset) != AEROSPIKE_NO_RESPONSE) {
+			// Do not retry keys that already have a response.
+			continue;
+		}
+
+		as_node* node;
+		status = as_batch_get_retry_node(cluster, key, task->policy->replica, task->replica_sc,
+			task->policy->replica_spread, parent->master, parent->master_sc, rec->has_write,
+			parent->node, &node);
+
+		if (status != AEROSPIKE_OK) {
+			as_batch_key_set_result(btk, offset, status);
+			*task->error_row = true;
+			continue;
+		}
+
+		as_batch_node* batch_node = as_batch_node_find(&batch_nodes, node);
+
+		if (! batch_node) {
+			// Add batch node.
+			as_node_reserve(node);
+			batch_node = as_vector_reserve(&batch_nodes);
+			batch_node->node = node;  // Transfer node
+
+			// Allocate vector on heap to avoid stack overflow.
+			as_vector_init(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
+		}
+		as_vector_append(&batch_node->offsets, &offset);
+	}
+
+	if (batch_nodes.size == 1) {
+		as_batch_node* batch_node = as_vector_get(&batch_nodes, 0);
+
+		if (batch_node->node == task->node) {
+			// Batch node is the same.
+			as_batch_release_nodes(&batch_nodes);
+			return AEROSPIKE_USE_NORMAL_RETRY;
+		}
+	}
+	parent->split_retry = true;
+
+	// Run batch retries sequentially in same thread.
+	for (uint32_t i = 0; status == AEROSPIKE_OK && i < batch_nodes.size; i++) {
+		as_batch_node* batch_node = as_vector_get(&batch_nodes, i);
+
+		task->node = batch_node->node;
+		memcpy(&task->offsets, &batch_node->offsets, sizeof(as_vector));
+		status = as_batch_execute_keys(btk, err, parent);
+	}
+
+	// Release each node.
+	as_batch_release_nodes(&batch_nodes);
+	return status;
+}
+
+static as_status
+as_batch_retry_digests(as_batch_task_digests* btd, as_command* parent, as_error* err)
+{
+	as_batch_task* task = &btd->base;
+	as_cluster* cluster = task->cluster;
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+	as_nodes_release(nodes);
+
+	if (n_nodes == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, cluster_empty_error);
+	}
+
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_nodes);
+
+	as_status status = AEROSPIKE_OK;
+
+	// Create initial key capacity for each node as average + 25%.
+	uint32_t offsets_size = task->offsets.size;
+	uint32_t offsets_capacity = offsets_size / n_nodes;
+	offsets_capacity += offsets_capacity >> 2;
+
+	// The minimum key capacity is 10.
+	if (offsets_capacity < 10) {
+		offsets_capacity = 10;
+	}
+
+	// Template key is shared with other tasks, so map nodes with a local copy.
+	as_key key;
+	as_key_init_digest(&key, btd->key->ns, btd->key->set, btd->key->digest.value);
+
+	// Map digests to server nodes.
+	for (uint32_t i = 0; i < offsets_size; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
+		as_batch_digest_result* res = &btd->results[offset];
 
 		if (res->result != AEROSPIKE_NO_RESPONSE) {
 			// Do not retry keys that already have a response.
 			continue;
 		}
 
+		memcpy(key.digest.value, btd->batch->digests[offset], AS_DIGEST_VALUE_SIZE);
+
 		as_node* node;
-		status = as_batch_get_node(cluster, key, task->policy->replica, task->replica_sc,
-			parent->master, parent->master_sc, rec->has_write, parent->node, &node);
+		status = as_batch_get_retry_node(cluster, &key, task->policy->replica, task->replica_sc,
+			task->policy->replica_spread, parent->master, parent->master_sc, false, parent->node,
+			&node);
 
 		if (status != AEROSPIKE_OK) {
 			res->result = status;
@@ -2754,6 +4552,10 @@ as_batch_retry_keys(as_batch_task_keys* btk, as_command* parent, as_error* err)
 		as_vector_append(&batch_node->offsets, &offset);
 	}
 
+	if (batch_nodes.size == 0) {
+		return AEROSPIKE_USE_NORMAL_RETRY;
+	}
+
 	if (batch_nodes.size == 1) {
 		as_batch_node* batch_node = as_vector_get(&batch_nodes, 0);
 
@@ -2771,7 +4573,7 @@ as_batch_retry_keys(as_batch_task_keys* btk, as_command* parent, as_error* err)
 
 		task->node = batch_node->node;
 		memcpy(&task->offsets, &batch_node->offsets, sizeof(as_vector));
-		status = as_batch_execute_keys(btk, err, parent);
+		status = as_batch_execute_digests(btd, err, parent);
 	}
 
 	// Release each node.
@@ -2788,7 +4590,8 @@ as_batch_retry(as_command* parent, as_error* err)
 	const as_policy_batch* policy = task->policy;
 	as_policy_replica replica = policy->replica;
 
-	if (!(replica == AS_POLICY_REPLICA_SEQUENCE || replica == AS_POLICY_REPLICA_PREFER_RACK)) {
+	if (!(replica == AS_POLICY_REPLICA_SEQUENCE || replica == AS_POLICY_REPLICA_PREFER_RACK ||
+		  replica == AS_POLICY_REPLICA_LOWEST_LATENCY)) {
 		// Node assignment will not change.
 		return AEROSPIKE_USE_NORMAL_RETRY;
 	}
@@ -2801,6 +4604,9 @@ as_batch_retry(as_command* parent, as_error* err)
 	if (task->type == BATCH_TYPE_RECORDS) {
 		return as_batch_retry_records((as_batch_task_records*)task, parent, err);
 	}
+	else if (task->type == BATCH_TYPE_DIGESTS) {
+		return as_batch_retry_digests((as_batch_task_digests*)task, parent, err);
+	}
 	else {
 		return as_batch_retry_keys((as_batch_task_keys*)task, parent, err);
 	}
@@ -2816,10 +4622,14 @@ as_batch_retry_command_create(
 	// fragmentation and to allow socket read to reuse buffer.
 	size_t s = (sizeof(as_async_batch_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
 
-	as_async_batch_command* bc = cf_malloc(s);
+	as_async_batch_command* bc = as_alloc_malloc(s);
 	bc->ubuf = ubuf;
 	bc->ubuf_size = ubuf_size;
 
+	if (ubuf) {
+		as_memory_add(AS_MEMORY_BATCH, ubuf_size);
+	}
+
 	as_event_command* cmd = &bc->command;
 	cmd->total_deadline = deadline;
 	cmd->socket_timeout = parent->socket_timeout;
@@ -2831,6 +4641,8 @@ as_batch_retry_command_create(
 	cmd->node = node;
 	cmd->ns = NULL;
 	cmd->partition = NULL;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
 	cmd->udata = parent->udata;  // Overload udata to be the executor.
 	cmd->parse_results = parent->parse_results;
 	cmd->pipe_listener = parent->pipe_listener;
@@ -2842,7 +4654,8 @@ as_batch_retry_command_create(
 	cmd->proto_type = AS_MESSAGE_TYPE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
-	cmd->flags2 = parent->flags2;
+	cmd->flags2 = parent->flags2 & ~AS_ASYNC_FLAGS2_URING;
+	cmd->priority = parent->priority;
 	return bc;
 }
 
@@ -2989,7 +4802,8 @@ as_batch_retry_async(as_event_command* parent, bool timeout)
 	as_async_batch_executor* be = parent->udata; // udata is overloaded to contain executor.
 
 	if (!(parent->replica == AS_POLICY_REPLICA_SEQUENCE ||
-		  parent->replica == AS_POLICY_REPLICA_PREFER_RACK)) {
+		  parent->replica == AS_POLICY_REPLICA_PREFER_RACK ||
+		  parent->replica == AS_POLICY_REPLICA_LOWEST_LATENCY)) {
 		return 1;  // Go through normal retry.
 	}
 
@@ -3078,9 +4892,9 @@ as_batch_retry_async(as_event_command* parent, bool timeout)
 		as_key* key = &rec->key;
 		as_node* node;
 
-		as_status status = as_batch_get_node(cluster, key, replica, replica_sc,
-			parent->flags & AS_ASYNC_FLAGS_MASTER, parent->flags & AS_ASYNC_FLAGS_MASTER_SC,
-			rec->has_write, parent->node, &node);
+		as_status status = as_batch_get_retry_node(cluster, key, replica, replica_sc,
+			be->replica_spread, parent->flags & AS_ASYNC_FLAGS_MASTER,
+			parent->flags & AS_ASYNC_FLAGS_MASTER_SC, rec->has_write, parent->node, &node);
 
 		if (status != AEROSPIKE_OK) {
 			rec->result = status;
@@ -3198,8 +5012,8 @@ as_batch_retry_async(as_event_command* parent, bool timeout)
 				as_event_executor_error(e, &err, bnodes.size - i);
 				// Current node not released, so start at current node.
 				as_batch_retry_release_nodes_cancel_async(&bnodes, i);
-				cf_free(ubuf);
-				cf_free(bc);
+				as_batch_destroy_ubuf(bc);
+				as_alloc_free(bc);
 				break;
 			}
 			cmd->write_len = (uint32_t)comp_size;
@@ -3264,13 +5078,64 @@ as_async_batch_error(as_event_command* cmd, as_error* err)
 	as_batch_destroy_ubuf(bc);
 }
 
-//---------------------------------
-// Public Functions
-//---------------------------------
+//---------------------------------
+// Public Functions
+//---------------------------------
+
+as_status
+aerospike_batch_read(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.batch;
+	}
+
+	return as_batch_records_execute_sync(as, err, policy, records, false, NULL);
+}
+
+as_status
+aerospike_batch_read_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_async_batch_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_error_reset(err);
+	
+	if (! policy) {
+		policy = &as->config.policies.batch;
+	}
+
+	return as_batch_records_execute_async(as, err, policy, records, NULL, listener, udata,
+		event_loop, false, false);
+}
+
+as_status
+aerospike_batch_read_stream(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_batch_record_listener listener, void* udata
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.batch;
+	}
+
+	as_batch_stream stream = {
+		.listener = listener,
+		.udata = udata
+	};
+
+	return as_batch_records_execute_sync(as, err, policy, records, false, &stream);
+}
 
 as_status
-aerospike_batch_read(
-	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records
+aerospike_batch_read_bound(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	const as_binding* binding, void* objs, size_t stride, as_binding_status* bind_status
 	)
 {
 	as_error_reset(err);
@@ -3279,23 +5144,34 @@ aerospike_batch_read(
 		policy = &as->config.policies.batch;
 	}
 
-	return as_batch_records_execute(as, err, policy, records, NULL, false);
+	as_batch_stream stream = {
+		.listener = NULL,
+		.udata = NULL,
+		.binding = binding,
+		.objs = objs,
+		.stride = stride,
+		.bind_status = bind_status
+	};
+
+	// Records are decoded in the sync parser, so multiplexed execution is not used.
+	return as_batch_records_execute(as, err, policy, records, NULL, false, &stream);
 }
 
 as_status
-aerospike_batch_read_async(
+aerospike_batch_read_stream_async(
 	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
-	as_async_batch_listener listener, void* udata, as_event_loop* event_loop
+	as_async_batch_record_listener record_listener, as_async_batch_listener listener, void* udata,
+	as_event_loop* event_loop
 	)
 {
 	as_error_reset(err);
-	
+
 	if (! policy) {
 		policy = &as->config.policies.batch;
 	}
 
-	return as_batch_records_execute_async(as, err, policy, records, listener, udata, event_loop,
-		false);
+	return as_batch_records_execute_async(as, err, policy, records, record_listener, listener,
+		udata, event_loop, false, false);
 }
 
 as_status
@@ -3309,7 +5185,7 @@ aerospike_batch_write(
 		policy = &as->config.policies.batch_parent_write;
 	}
 
-	return as_batch_records_execute(as, err, policy, records, NULL, true);
+	return as_batch_records_execute_sync(as, err, policy, records, true, NULL);
 }
 
 as_status
@@ -3324,8 +5200,177 @@ aerospike_batch_write_async(
 		policy = &as->config.policies.batch_parent_write;
 	}
 
-	return as_batch_records_execute_async(as, err, policy, records, listener, udata, event_loop,
-		true);
+	return as_batch_records_execute_async(as, err, policy, records, NULL, listener, udata,
+		event_loop, true, false);
+}
+
+as_status
+aerospike_batch_prepare(
+	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_records* records,
+	as_batch_prepared** prepared
+	)
+{
+	as_error_reset(err);
+
+	as_vector* list = &records->list;
+	uint32_t n_keys = list->size;
+
+	if (n_keys == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Batch records are empty");
+	}
+
+	bool has_write = false;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_batch_base_record* rec = as_vector_get(list, i);
+		rec->result = AEROSPIKE_NO_RESPONSE;
+		as_record_init(&rec->record, 0);
+		has_write = has_write || rec->has_write;
+	}
+
+	if (! policy) {
+		policy = has_write ? &as->config.policies.batch_parent_write : &as->config.policies.batch;
+	}
+
+	// Digests are computed once for all executions.
+	as_batch_base_record* first = as_vector_get(list, 0);
+	as_status status = as_key_set_digests(err, &first->key, n_keys, list->item_size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_batch_prepared* bp = cf_malloc(sizeof(as_batch_prepared));
+	bp->policy = *policy;
+	bp->records = records;
+	as_vector_init(&bp->nodes, sizeof(as_batch_prepared_node), 8);
+	as_vector_init(&bp->failed, sizeof(as_batch_prepared_failure), 4);
+	bp->partition_gen = 0;
+	bp->replica_sc = as_batch_get_replica_sc(policy);
+	bp->has_write = has_write;
+	bp->rebuilt_nodes = 0;
+
+	status = as_batch_prepared_refresh(bp, as->cluster, aerospike_partition_generation(as), err);
+
+	if (status != AEROSPIKE_OK) {
+		as_batch_prepared_destroy(bp);
+		return status;
+	}
+
+	*prepared = bp;
+	return AEROSPIKE_OK;
+}
+
+as_status
+aerospike_batch_prepared_execute(aerospike* as, as_error* err, as_batch_prepared* prepared)
+{
+	as_error_reset(err);
+
+	as_cluster* cluster = as->cluster;
+
+	// Read generation before routes are built, so changes during the build are seen by the
+	// next execution.
+	uint32_t partition_gen = aerospike_partition_generation(as);
+
+	if (partition_gen != prepared->partition_gen) {
+		as_status status = as_batch_prepared_refresh(prepared, cluster, partition_gen, err);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+
+	as_batch_records* records = prepared->records;
+	as_vector* list = &records->list;
+	uint32_t n_keys = list->size;
+
+	// Reset results of the previous execution.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_batch_base_record* rec = as_vector_get(list, i);
+		as_record_destroy(&rec->record);
+		as_record_init(&rec->record, 0);
+		rec->result = AEROSPIKE_NO_RESPONSE;
+		rec->in_doubt = false;
+	}
+
+	if (records->arena) {
+		as_memory_sub(AS_MEMORY_BATCH, as_arena_destroy(records->arena));
+		records->arena = NULL;
+	}
+
+	bool error_row = false;
+
+	for (uint32_t i = 0; i < prepared->failed.size; i++) {
+		as_batch_prepared_failure* failure = as_vector_get(&prepared->failed, i);
+		as_batch_base_record* rec = as_vector_get(list, failure->offset);
+		rec->result = failure->status;
+		error_row = true;
+	}
+
+	uint32_t n_commands = 0;
+
+	for (uint32_t i = 0; i < prepared->nodes.size; i++) {
+		as_batch_prepared_node* pn = as_vector_get(&prepared->nodes, i);
+		n_commands += pn->commands.size;
+	}
+
+	if (n_commands == 0) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED, "Nodes not found");
+	}
+
+	// Executed batch nodes are released, so they refer to copies of the cached offsets.
+	as_vector batch_nodes;
+	as_vector_inita(&batch_nodes, sizeof(as_batch_node), n_commands);
+
+	for (uint32_t i = 0; i < prepared->nodes.size; i++) {
+		as_batch_prepared_node* pn = as_vector_get(&prepared->nodes, i);
+
+		for (uint32_t j = 0; j < pn->commands.size; j++) {
+			as_batch_prepared_command* pc = as_vector_get(&pn->commands, j);
+			as_batch_node* batch_node = as_vector_reserve(&batch_nodes);
+
+			as_node_reserve(pn->node);
+			batch_node->node = pn->node;
+			as_batch_offsets_copy(&batch_node->offsets, &pc->offsets);
+			batch_node->buf = pc->buf;
+			batch_node->buf_size = pc->size;
+		}
+	}
+
+	as_arena_chunk** arena = prepared->policy.arena ? &records->arena : NULL;
+
+	as_status status = as_batch_execute_sync(cluster, err, &prepared->policy, prepared->has_write,
+		prepared->replica_sc, list, arena, n_keys, &batch_nodes, NULL, &error_row, NULL);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (error_row) {
+		return as_error_set_message(err, AEROSPIKE_BATCH_FAILED,
+			"One or more batch sub-commands failed");
+	}
+	return AEROSPIKE_OK;
+}
+
+void
+as_batch_prepared_destroy(as_batch_prepared* prepared)
+{
+	for (uint32_t i = 0; i < prepared->nodes.size; i++) {
+		as_batch_prepared_node_destroy(as_vector_get(&prepared->nodes, i));
+	}
+	as_vector_destroy(&prepared->nodes);
+	as_vector_destroy(&prepared->failed);
+	cf_free(prepared);
+}
+
+as_batch_records*
+as_batch_records_create(uint32_t capacity)
+{
+	as_batch_records* records = cf_malloc(sizeof(as_batch_records));
+	as_batch_records_init(records, capacity);
+	records->_free = true;
+	return records;
 }
 
 void
@@ -3336,10 +5381,18 @@ as_batch_records_destroy(as_batch_records* records)
 	for (uint32_t i = 0; i < list->size; i++) {
 		as_batch_base_record* record = as_vector_get(list, i);
 		
+		// Arena bins and values do not own memory, so only deserialized values are freed.
 		as_key_destroy(&record->key);
 		as_record_destroy(&record->record);
 	}
 	as_vector_destroy(list);
+
+	// One free per response block instead of one per bin value.
+	as_memory_sub(AS_MEMORY_BATCH, as_arena_destroy(records->arena));
+
+	if (records->_free) {
+		cf_free(records);
+	}
 }
 
 as_status
@@ -3393,6 +5446,114 @@ aerospike_batch_get_bins(
 		listener, udata);
 }
 
+as_status
+aerospike_batch_get_digests(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch_digests* batch,
+	const char** bins, uint32_t n_bins, as_batch_digest_result* results
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.batch;
+	}
+
+	as_batch_read_record rec = {
+		.type = AS_BATCH_READ,
+		// Cast to maintain backwards compatibility. Field is not really modified.
+		.bin_names = (char**)bins,
+		.n_bin_names = n_bins,
+		.read_all_bins = bins == NULL
+	};
+
+	as_batch_attr attr;
+	as_batch_attr_read_header(&attr, policy);
+
+	if (! bins) {
+		attr.read_attr |= AS_MSG_INFO1_GET_ALL;
+	}
+
+	return as_batch_digests_execute(as, err, policy, batch, &rec, &attr, results);
+}
+
+static inline bool
+as_batch_view_same_set(const as_key_view* a, const as_key_view* b)
+{
+	// Views built from the same strings usually share pointers.
+	return (a->ns == b->ns || strcmp(a->ns, b->ns) == 0) &&
+		(a->set == b->set || strcmp(a->set, b->set) == 0);
+}
+
+as_status
+aerospike_batch_get_views(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_key_view* views,
+	uint32_t n_views, const char** bins, uint32_t n_bins, as_batch_digest_result* results
+	)
+{
+	as_error_reset(err);
+
+	// Initialize results first, so they can always be destroyed.
+	for (uint32_t i = 0; i < n_views; i++) {
+		as_batch_digest_result* res = &results[i];
+		res->result = AEROSPIKE_NO_RESPONSE;
+		as_record_init(&res->record, 0);
+	}
+
+	if (n_views == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	as_digest_value* digests = cf_malloc(sizeof(as_digest_value) * n_views);
+	as_status status = AEROSPIKE_OK;
+
+	for (uint32_t i = 0; i < n_views; i++) {
+		status = as_key_view_digest(err, &views[i], digests[i]);
+
+		if (status != AEROSPIKE_OK) {
+			cf_free(digests);
+			return status;
+		}
+	}
+
+	// Digest batches share one namespace and set, so run each group of consecutive views.
+	uint32_t begin = 0;
+
+	while (begin < n_views) {
+		const as_key_view* first = &views[begin];
+		uint32_t end = begin + 1;
+
+		while (end < n_views && as_batch_view_same_set(first, &views[end])) {
+			end++;
+		}
+
+		as_batch_digests batch = {
+			.ns = first->ns,
+			.set = first->set,
+			.digests = &digests[begin],
+			.n_digests = end - begin
+		};
+
+		status = aerospike_batch_get_digests(as, err, policy, &batch, bins, n_bins,
+			&results[begin]);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+		begin = end;
+	}
+
+	cf_free(digests);
+	return status;
+}
+
+void
+as_batch_digest_results_destroy(as_batch_digest_result* results, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		as_record_destroy(&results[i].record);
+	}
+}
+
 as_status
 aerospike_batch_get_ops(
 	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
@@ -3535,3 +5696,106 @@ aerospike_batch_remove(
 	return as_batch_keys_execute(as, err, policy, batch, (as_batch_base_record*)&rec, &attr,
 		listener, udata);
 }
+
+void
+as_batch_status_init(as_batch_status* bs, uint32_t capacity)
+{
+	bs->results = cf_malloc(sizeof(int32_t) * capacity);
+	bs->in_doubt = cf_malloc(capacity);
+	bs->errors = NULL;
+	bs->n_errors = 0;
+	bs->n_keys = 0;
+	bs->capacity = capacity;
+}
+
+void
+as_batch_status_destroy(as_batch_status* bs)
+{
+	cf_free(bs->results);
+	cf_free(bs->in_doubt);
+	cf_free(bs->errors);
+}
+
+as_status
+aerospike_batch_write_status(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, const as_batch* batch,
+	as_operations* ops, as_batch_status* bs
+	)
+{
+	as_error_reset(err);
+	
+	if (! policy) {
+		policy = &as->config.policies.batch_parent_write;
+	}
+	
+	if (! policy_write) {
+		policy_write = &as->config.policies.batch_write;
+	}
+
+	as_batch_write_record rec = {
+		.type = AS_BATCH_WRITE,
+		.has_write = true,
+		.policy = policy_write,
+		.ops = ops
+	};
+
+	as_batch_attr attr;
+	as_batch_attr_write_row(&attr, policy_write, ops);
+
+	return as_batch_keys_run(as, err, policy, batch, (as_batch_base_record*)&rec, &attr,
+		NULL, NULL, bs, NULL);
+}
+
+as_status
+aerospike_batch_remove_status(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_remove* policy_remove, const as_batch* batch, as_batch_status* bs
+	)
+{
+	as_error_reset(err);
+	
+	if (! policy) {
+		policy = &as->config.policies.batch_parent_write;
+	}
+	
+	if (! policy_remove) {
+		policy_remove = &as->config.policies.batch_remove;
+	}
+
+	as_batch_remove_record rec = {
+		.type = AS_BATCH_REMOVE,
+		.has_write = true,
+		.policy = policy_remove
+	};
+
+	as_batch_attr attr;
+	as_batch_attr_remove_row(&attr, policy_remove);
+
+	return as_batch_keys_run(as, err, policy, batch, (as_batch_base_record*)&rec, &attr,
+		NULL, NULL, bs, NULL);
+}
+
+as_status
+aerospike_batch_exists_bitmap(
+	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
+	uint8_t* bitmap
+	)
+{
+	as_error_reset(err);
+	
+	if (! policy) {
+		policy = &as->config.policies.batch;
+	}
+	
+	as_batch_read_record rec = {
+		.type = AS_BATCH_READ
+	};
+
+	as_batch_attr attr;
+	as_batch_attr_read_header(&attr, policy);
+	attr.read_attr |= AS_MSG_INFO1_GET_NOBINDATA;
+
+	return as_batch_keys_run(as, err, policy, batch, (as_batch_base_record*)&rec, &attr,
+		NULL, NULL, NULL, bitmap);
+}
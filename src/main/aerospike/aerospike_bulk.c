@@ -0,0 +1,624 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike_bulk.h>
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_bulk_item_s {
+	as_key key;
+	as_record rec;
+} as_bulk_item;
+
+struct as_bulk_loader_s;
+
+typedef struct as_bulk_sink_s {
+	struct as_bulk_loader_s* bl;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;     // Signaled when records are queued or a permit is released.
+	pthread_cond_t not_full;  // Signaled when records are taken.
+	as_bulk_item** items;     // Ring buffer of queued records.
+	pthread_t* threads;
+	uint64_t throttle_at;     // The limit is reduced at most once per command round trip.
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t count;
+	uint32_t in_flight;
+	uint32_t limit;
+	uint32_t successes;
+	uint32_t n_threads;
+	bool closed;
+} as_bulk_sink;
+
+typedef struct as_bulk_loader_s {
+	aerospike* as;
+	as_bulk_config config;
+	as_policy_write put_policy;
+	as_bulk_producer producer;
+	void* udata;
+	as_nodes* nodes;
+	as_bulk_sink* sinks;      // One per node, followed by one for unmapped partitions.
+	uint32_t n_sinks;
+	FILE* reject_file;
+	pthread_mutex_t reject_lock;
+	as_bulk_stats stats;
+} as_bulk_loader;
+
+typedef struct as_bulk_producer_task_s {
+	as_bulk_loader* bl;
+	uint32_t id;
+} as_bulk_producer_task;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline void
+as_bulk_item_destroy(as_bulk_item* item)
+{
+	as_key_destroy(&item->key);
+	as_record_destroy(&item->rec);
+	cf_free(item);
+}
+
+static void
+as_bulk_reject_write(FILE* f, const as_key* key, const as_error* err)
+{
+	fprintf(f, "%s\t%s\t", key->ns, key->set);
+
+	as_val* val = (as_val*)key->valuep;
+
+	switch (val ? as_val_type(val) : AS_UNDEF) {
+		case AS_INTEGER:
+			fprintf(f, "%" PRId64, as_integer_get((as_integer*)val));
+			break;
+
+		case AS_STRING:
+			fputs(as_string_get((as_string*)val), f);
+			break;
+
+		default:
+			// Bytes may contain separators, so they are identified by digest like keys
+			// without a user key.
+			for (uint32_t i = 0; i < AS_DIGEST_VALUE_SIZE; i++) {
+				fprintf(f, "%02x", key->digest.value[i]);
+			}
+			break;
+	}
+	fprintf(f, "\t%d\t%s\n", err->code, err->message);
+}
+
+static void
+as_bulk_reject(as_bulk_loader* bl, as_bulk_item* item, const as_error* err)
+{
+	as_incr_uint64(&bl->stats.rejected);
+
+	if (bl->reject_file) {
+		pthread_mutex_lock(&bl->reject_lock);
+		as_bulk_reject_write(bl->reject_file, &item->key, err);
+		pthread_mutex_unlock(&bl->reject_lock);
+	}
+
+	if (bl->config.reject_listener) {
+		bl->config.reject_listener(&item->key, &item->rec, err, bl->config.reject_udata);
+	}
+}
+
+static inline bool
+as_bulk_overload(as_status status)
+{
+	switch (status) {
+		case AEROSPIKE_ERR_TIMEOUT:
+		case AEROSPIKE_ERR_DEVICE_OVERLOAD:
+		case AEROSPIKE_ERR_RECORD_BUSY:
+		case AEROSPIKE_ERR_NO_MORE_CONNECTIONS:
+		case AEROSPIKE_MAX_ERROR_RATE:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static uint32_t
+as_bulk_route(as_bulk_loader* bl, const as_key* key)
+{
+	as_cluster* cluster = bl->as->cluster;
+	as_error err;
+	as_partition_info pi;
+
+	if (as_partition_info_init(&pi, cluster, &err, key) == AEROSPIKE_OK) {
+		// Write commands always go to the master.
+		as_node* node = as_partition_get_node(cluster, pi.ns, pi.partition, NULL,
+			AS_POLICY_REPLICA_SEQUENCE, true);
+
+		for (uint32_t i = 0; i < bl->nodes->size; i++) {
+			if (bl->nodes->array[i] == node) {
+				return i;
+			}
+		}
+	}
+	// Nodes that joined after the load started, unknown namespaces and partitions without a
+	// master share the last sink.  The command itself reports records that can't be written.
+	return bl->n_sinks - 1;
+}
+
+static void
+as_bulk_push(as_bulk_sink* sink, as_bulk_item* item)
+{
+	pthread_mutex_lock(&sink->lock);
+
+	while (sink->count == sink->capacity) {
+		pthread_cond_wait(&sink->not_full, &sink->lock);
+	}
+
+	sink->items[(sink->head + sink->count) % sink->capacity] = item;
+	sink->count++;
+
+	if (sink->count >= sink->bl->config.batch_size) {
+		// Also wake workers that linger for a full batch.
+		pthread_cond_broadcast(&sink->ready);
+	}
+	else {
+		pthread_cond_signal(&sink->ready);
+	}
+	pthread_mutex_unlock(&sink->lock);
+}
+
+static uint32_t
+as_bulk_take(as_bulk_sink* sink, as_bulk_item** items, uint32_t max)
+{
+	// Must hold sink lock.
+	uint32_t n = (sink->count < max) ? sink->count : max;
+
+	for (uint32_t i = 0; i < n; i++) {
+		items[i] = sink->items[sink->head];
+		sink->head = (sink->head + 1) % sink->capacity;
+	}
+	sink->count -= n;
+
+	if (n > 0) {
+		pthread_cond_broadcast(&sink->not_full);
+	}
+	return n;
+}
+
+static uint32_t
+as_bulk_next(as_bulk_loader* bl, as_bulk_sink* sink, as_bulk_item** items)
+{
+	uint32_t max = bl->config.batch_size;
+
+	pthread_mutex_lock(&sink->lock);
+
+	while (! (sink->count > 0 && sink->in_flight < sink->limit)) {
+		if (sink->count == 0 && sink->closed) {
+			pthread_mutex_unlock(&sink->lock);
+			return 0;
+		}
+		pthread_cond_wait(&sink->ready, &sink->lock);
+	}
+
+	sink->in_flight++;
+
+	uint32_t n = as_bulk_take(sink, items, max);
+
+	if (n < max && bl->config.linger_ms > 0 && ! sink->closed) {
+		// Wait a little for a fuller batch.
+		struct timespec delta;
+		struct timespec abstime;
+		cf_clock_set_timespec_ms(bl->config.linger_ms, &delta);
+		cf_clock_current_add(&delta, &abstime);
+
+		while (sink->count < max - n && ! sink->closed) {
+			if (pthread_cond_timedwait(&sink->ready, &sink->lock, &abstime) != 0) {
+				break;
+			}
+		}
+		n += as_bulk_take(sink, items + n, max - n);
+	}
+
+	pthread_mutex_unlock(&sink->lock);
+	return n;
+}
+
+static void
+as_bulk_adapt(as_bulk_loader* bl, as_bulk_sink* sink, uint64_t latency, bool overload)
+{
+	uint64_t now = cf_getms();
+
+	pthread_mutex_lock(&sink->lock);
+	sink->in_flight--;
+
+	if (overload || latency > bl->config.target_latency_ms) {
+		// Multiplicative decrease.  Commands that were already in flight when the limit was
+		// reduced report the same congestion, so wait one round trip before reducing again.
+		if (now >= sink->throttle_at) {
+			uint32_t limit = sink->limit / 2;
+			sink->limit = (limit > bl->config.min_in_flight) ? limit : bl->config.min_in_flight;
+			sink->throttle_at = now + latency;
+			as_incr_uint64(&bl->stats.throttles);
+		}
+		sink->successes = 0;
+	}
+	else if (++sink->successes >= sink->limit) {
+		// Additive increase once per window of limit commands.
+		sink->successes = 0;
+
+		if (sink->limit < bl->config.max_in_flight) {
+			sink->limit++;
+		}
+	}
+
+	pthread_cond_broadcast(&sink->ready);
+	pthread_mutex_unlock(&sink->lock);
+}
+
+static bool
+as_bulk_put(as_bulk_loader* bl, as_bulk_item* item)
+{
+	as_error err;
+	as_status status = aerospike_key_put(bl->as, &err, &bl->put_policy, &item->key, &item->rec);
+
+	if (status == AEROSPIKE_OK) {
+		as_incr_uint64(&bl->stats.written);
+	}
+	else {
+		as_bulk_reject(bl, item, &err);
+	}
+	return as_bulk_overload(status);
+}
+
+static bool
+as_bulk_batch_write(as_bulk_loader* bl, as_bulk_item** items, uint32_t n)
+{
+	as_batch_records* records = as_batch_records_create(n);
+	as_operations* ops = cf_malloc(sizeof(as_operations) * n);
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_bulk_item* item = items[i];
+		as_record* rec = &item->rec;
+		as_operations* op = &ops[i];
+
+		as_operations_init(op, rec->bins.size);
+		op->ttl = rec->ttl;
+		op->gen = rec->gen;
+
+		for (uint16_t j = 0; j < rec->bins.size; j++) {
+			as_bin* bin = &rec->bins.entries[j];
+			as_operations_add_write(op, bin->name, (as_bin_value*)as_val_reserve(bin->valuep));
+		}
+
+		// The batch record references the producer's key value and digest.
+		as_batch_write_record* r = as_batch_write_reserve(records);
+		as_key* key = &item->key;
+
+		if (key->valuep) {
+			as_key_init_value(&r->key, key->ns, key->set,
+				(as_key_value*)as_val_reserve((as_val*)key->valuep));
+		}
+		else {
+			as_key_init_digest(&r->key, key->ns, key->set, key->digest.value);
+		}
+		r->key.digest = key->digest;
+		r->key.ns_id = key->ns_id;
+		r->policy = &bl->config.write_policy;
+		r->ops = op;
+	}
+
+	as_error err;
+	as_status status = aerospike_batch_write(bl->as, &err, &bl->config.batch_policy, records);
+
+	// AEROSPIKE_BATCH_FAILED only means that some records failed.  Other errors also apply to
+	// records that did not receive a response.
+	bool command_ok = status == AEROSPIKE_OK || status == AEROSPIKE_BATCH_FAILED;
+	bool overload = ! command_ok && as_bulk_overload(status);
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_batch_write_record* r = as_vector_get(&records->list, i);
+
+		if (r->result == AEROSPIKE_OK) {
+			as_incr_uint64(&bl->stats.written);
+			continue;
+		}
+
+		if (command_ok || r->result != AEROSPIKE_NO_RESPONSE) {
+			as_error rerr;
+			as_error_set_message(&rerr, r->result, as_error_string(r->result));
+			as_bulk_reject(bl, items[i], &rerr);
+			overload = overload || as_bulk_overload(r->result);
+		}
+		else {
+			as_bulk_reject(bl, items[i], &err);
+		}
+	}
+
+	// Operations reference the record bins, so destroy them first.
+	for (uint32_t i = 0; i < n; i++) {
+		as_operations_destroy(&ops[i]);
+	}
+	cf_free(ops);
+	as_batch_records_destroy(records);
+	return overload;
+}
+
+static void*
+as_bulk_sink_worker(void* udata)
+{
+	as_bulk_sink* sink = udata;
+	as_bulk_loader* bl = sink->bl;
+
+	as_bulk_item** items = cf_malloc(sizeof(as_bulk_item*) * bl->config.batch_size);
+	uint32_t n;
+
+	while ((n = as_bulk_next(bl, sink, items)) > 0) {
+		uint64_t begin = cf_getms();
+		bool overload;
+
+		if (bl->config.batch_size == 1) {
+			overload = as_bulk_put(bl, items[0]);
+		}
+		else {
+			overload = as_bulk_batch_write(bl, items, n);
+		}
+		as_incr_uint64(&bl->stats.commands);
+		as_bulk_adapt(bl, sink, cf_getms() - begin, overload);
+
+		for (uint32_t i = 0; i < n; i++) {
+			as_bulk_item_destroy(items[i]);
+		}
+	}
+	cf_free(items);
+	return NULL;
+}
+
+static void*
+as_bulk_producer_worker(void* udata)
+{
+	as_bulk_producer_task* task = udata;
+	as_bulk_loader* bl = task->bl;
+
+	while (true) {
+		as_bulk_item* item = cf_malloc(sizeof(as_bulk_item));
+
+		if (! bl->producer(task->id, bl->udata, &item->key, &item->rec)) {
+			cf_free(item);
+			break;
+		}
+		as_incr_uint64(&bl->stats.produced);
+
+		as_error err;
+
+		if (as_key_set_digest(&err, &item->key) != AEROSPIKE_OK) {
+			as_bulk_reject(bl, item, &err);
+			as_bulk_item_destroy(item);
+			continue;
+		}
+		as_bulk_push(&bl->sinks[as_bulk_route(bl, &item->key)], item);
+	}
+	return NULL;
+}
+
+static bool
+as_bulk_sink_start(as_bulk_loader* bl, as_bulk_sink* sink)
+{
+	as_bulk_config* config = &bl->config;
+
+	sink->bl = bl;
+	pthread_mutex_init(&sink->lock, NULL);
+	pthread_cond_init(&sink->ready, NULL);
+	pthread_cond_init(&sink->not_full, NULL);
+	sink->items = cf_malloc(sizeof(as_bulk_item*) * config->queue_size);
+	sink->threads = cf_malloc(sizeof(pthread_t) * config->max_in_flight);
+	sink->throttle_at = 0;
+	sink->capacity = config->queue_size;
+	sink->head = 0;
+	sink->count = 0;
+	sink->in_flight = 0;
+	sink->limit = config->min_in_flight;
+	sink->successes = 0;
+	sink->n_threads = 0;
+	sink->closed = false;
+
+	for (uint32_t i = 0; i < config->max_in_flight; i++) {
+		if (pthread_create(&sink->threads[i], NULL, as_bulk_sink_worker, sink) != 0) {
+			return false;
+		}
+		sink->n_threads++;
+	}
+	return true;
+}
+
+static void
+as_bulk_sink_stop(as_bulk_sink* sink)
+{
+	// Workers exit after the queue is drained.
+	pthread_mutex_lock(&sink->lock);
+	sink->closed = true;
+	pthread_cond_broadcast(&sink->ready);
+	pthread_mutex_unlock(&sink->lock);
+
+	for (uint32_t i = 0; i < sink->n_threads; i++) {
+		pthread_join(sink->threads[i], NULL);
+	}
+
+	cf_free(sink->threads);
+	cf_free(sink->items);
+	pthread_cond_destroy(&sink->not_full);
+	pthread_cond_destroy(&sink->ready);
+	pthread_mutex_destroy(&sink->lock);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_bulk_config_init(as_bulk_config* config)
+{
+	as_policy_batch_init(&config->batch_policy);
+	as_policy_batch_write_init(&config->write_policy);
+	config->n_producers = 1;
+	config->batch_size = 100;
+	config->linger_ms = 5;
+	config->queue_size = 10000;
+	config->min_in_flight = 1;
+	config->max_in_flight = 16;
+	config->target_latency_ms = 50;
+	config->reject_path = NULL;
+	config->reject_listener = NULL;
+	config->reject_udata = NULL;
+}
+
+as_status
+aerospike_bulk_load(
+	aerospike* as, as_error* err, const as_bulk_config* config, as_bulk_producer producer,
+	void* udata, as_bulk_stats* stats
+	)
+{
+	as_error_reset(err);
+
+	as_bulk_loader bl;
+
+	if (config) {
+		bl.config = *config;
+	}
+	else {
+		as_bulk_config_init(&bl.config);
+	}
+
+	config = &bl.config;
+
+	if (config->n_producers == 0 || config->batch_size == 0 || config->queue_size == 0 ||
+		config->min_in_flight == 0 || config->max_in_flight < config->min_in_flight) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Invalid bulk load config");
+	}
+
+	bl.as = as;
+	bl.producer = producer;
+	bl.udata = udata;
+	memset(&bl.stats, 0, sizeof(bl.stats));
+
+	// Single puts use the batch policies.
+	as_policy_write_init(&bl.put_policy);
+	bl.put_policy.base = config->batch_policy.base;
+	bl.put_policy.base.filter_exp = config->write_policy.filter_exp ?
+		config->write_policy.filter_exp : config->batch_policy.base.filter_exp;
+	bl.put_policy.replica = config->batch_policy.replica;
+	bl.put_policy.key = config->write_policy.key;
+	bl.put_policy.commit_level = config->write_policy.commit_level;
+	bl.put_policy.gen = config->write_policy.gen;
+	bl.put_policy.exists = config->write_policy.exists;
+	bl.put_policy.durable_delete = config->write_policy.durable_delete;
+
+	bl.reject_file = NULL;
+
+	if (config->reject_path) {
+		bl.reject_file = fopen(config->reject_path, "a");
+
+		if (! bl.reject_file) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open reject file %s",
+				config->reject_path);
+		}
+	}
+	pthread_mutex_init(&bl.reject_lock, NULL);
+
+	// Records are grouped by the nodes known when the load starts.
+	bl.nodes = as_nodes_reserve(as->cluster);
+
+	if (bl.nodes->size == 0) {
+		as_nodes_release(bl.nodes);
+		pthread_mutex_destroy(&bl.reject_lock);
+
+		if (bl.reject_file) {
+			fclose(bl.reject_file);
+		}
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Cluster is empty");
+	}
+
+	bl.n_sinks = bl.nodes->size + 1;
+	bl.sinks = cf_malloc(sizeof(as_bulk_sink) * bl.n_sinks);
+
+	as_status status = AEROSPIKE_OK;
+	uint32_t n_sinks = 0;
+
+	while (n_sinks < bl.n_sinks) {
+		if (! as_bulk_sink_start(&bl, &bl.sinks[n_sinks++])) {
+			status = as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Failed to create thread");
+			break;
+		}
+	}
+
+	if (status == AEROSPIKE_OK) {
+		pthread_t* threads = cf_malloc(sizeof(pthread_t) * config->n_producers);
+		as_bulk_producer_task* tasks = cf_malloc(sizeof(as_bulk_producer_task) *
+			config->n_producers);
+		uint32_t n_threads = 0;
+
+		for (uint32_t i = 0; i < config->n_producers; i++) {
+			tasks[i].bl = &bl;
+			tasks[i].id = i;
+
+			if (pthread_create(&threads[i], NULL, as_bulk_producer_worker, &tasks[i]) != 0) {
+				// Producers that started still run to completion.
+				status = as_error_set_message(err, AEROSPIKE_ERR_CLIENT,
+					"Failed to create thread");
+				break;
+			}
+			n_threads++;
+		}
+
+		for (uint32_t i = 0; i < n_threads; i++) {
+			pthread_join(threads[i], NULL);
+		}
+		cf_free(tasks);
+		cf_free(threads);
+	}
+
+	for (uint32_t i = 0; i < n_sinks; i++) {
+		as_bulk_sink_stop(&bl.sinks[i]);
+	}
+	cf_free(bl.sinks);
+	as_nodes_release(bl.nodes);
+	pthread_mutex_destroy(&bl.reject_lock);
+
+	if (bl.reject_file) {
+		fclose(bl.reject_file);
+	}
+
+	as_log_debug("Bulk load produced=%" PRIu64 " written=%" PRIu64 " rejected=%" PRIu64,
+		bl.stats.produced, bl.stats.written, bl.stats.rejected);
+
+	if (stats) {
+		*stats = bl.stats;
+	}
+	return status;
+}
@@ -16,6 +16,7 @@
  */
 #include <aerospike/aerospike_info.h>
 #include <aerospike/as_admin.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
@@ -26,7 +27,9 @@
 #include <aerospike/as_policy.h>
 #include <aerospike/as_proto.h>
 #include <aerospike/as_socket.h>
+#include <aerospike/as_task_gate.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_queue.h>
 
 /******************************************************************************
  * FUNCTIONS
@@ -61,7 +64,7 @@ aerospike_info_host(
 	}
 		
 	as_address_iterator iter;
-	as_status status = as_lookup_host(&iter, err, hostname, port);
+	as_status status = as_lookup_host(as->cluster->dns_cache, &iter, err, hostname, port);
 	
 	if (status) {
 		return status;
@@ -184,3 +187,219 @@ aerospike_info_foreach(
 	as_nodes_release(nodes);
 	return status;
 }
+
+/******************************************************************************
+ * INFO ALL
+ *****************************************************************************/
+
+typedef struct {
+	as_node* node;
+	as_info_node_result* result;
+	const char* req;
+	cf_queue* complete_q;
+	uint64_t deadline;
+	bool send_as_is;
+} as_info_all_task;
+
+static void
+as_info_all_worker(void* data)
+{
+	as_info_all_task* task = data;
+	as_info_node_result* result = task->result;
+
+	as_info_command_node(&result->err, task->node, (char*)task->req, task->send_as_is,
+		task->deadline, &result->response);
+
+	uint32_t complete = 1;
+	cf_queue_push(task->complete_q, &complete);
+}
+
+static inline void
+as_info_all_wait(cf_queue* complete_q, as_task_caller* caller)
+{
+	uint32_t complete;
+	cf_queue_pop(complete_q, &complete, CF_QUEUE_FOREVER);
+	as_task_caller_complete(caller);
+}
+
+as_status
+aerospike_info_all(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* req,
+	aerospike_info_all_callback callback, void* udata
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.info;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_nodes* nodes;
+	as_status status = as_cluster_reserve_all_nodes(cluster, err, &nodes);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint32_t n_nodes = nodes->size;
+	as_info_node_result* results = cf_malloc(sizeof(as_info_node_result) * n_nodes);
+	as_info_all_task* tasks = cf_malloc(sizeof(as_info_all_task) * n_nodes);
+
+	// Each node gets the full timeout.
+	uint64_t deadline = as_socket_deadline(policy->timeout);
+	cf_queue* complete_q = cf_queue_create(sizeof(uint32_t), true);
+	as_task_caller caller;
+	as_task_caller_init(&caller, &cluster->task_gate);
+
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		as_info_node_result* result = &results[i];
+		result->node = nodes->array[i];
+		result->response = NULL;
+		as_error_init(&result->err);
+
+		as_info_all_task* task = &tasks[i];
+		task->node = nodes->array[i];
+		task->result = result;
+		task->req = req;
+		task->complete_q = complete_q;
+		task->deadline = deadline;
+		task->send_as_is = policy->send_as_is;
+
+		// Wait for one of this call's tasks when its share of the thread pool is in use.
+		while (! as_task_caller_admit(&caller)) {
+			as_info_all_wait(complete_q, &caller);
+		}
+
+		if (as_task_caller_queue(&caller, as_info_all_worker, task) != 0) {
+			// Thread could not be added.  Run in this thread instead.
+			as_info_command_node(&result->err, task->node, (char*)req, policy->send_as_is,
+				deadline, &result->response);
+		}
+	}
+
+	// Wait for tasks to complete.
+	while (as_task_caller_pending(&caller) > 0) {
+		as_info_all_wait(complete_q, &caller);
+	}
+	as_task_caller_destroy(&caller);
+	cf_queue_destroy(complete_q);
+
+	callback(results, n_nodes, udata);
+
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		cf_free(results[i].response);
+	}
+	cf_free(tasks);
+	cf_free(results);
+	as_cluster_release_all_nodes(nodes);
+	return AEROSPIKE_OK;
+}
+
+typedef struct as_info_all_state_s as_info_all_state;
+
+typedef struct {
+	as_info_all_state* state;
+	uint32_t index;
+} as_info_all_ref;
+
+struct as_info_all_state_s {
+	aerospike_info_all_listener listener;
+	void* udata;
+	as_nodes* nodes;
+	as_info_all_ref* refs;
+	uint32_t pending;
+	uint32_t n_results;
+	as_info_node_result results[];
+};
+
+static void
+as_info_all_complete(as_info_all_state* state, as_event_loop* event_loop)
+{
+	// The last node response calls the listener.
+	if (as_aaf_uint32(&state->pending, -1) != 0) {
+		return;
+	}
+
+	state->listener(state->results, state->n_results, state->udata, event_loop);
+
+	for (uint32_t i = 0; i < state->n_results; i++) {
+		cf_free(state->results[i].response);
+	}
+	as_cluster_release_all_nodes(state->nodes);
+	cf_free(state);
+}
+
+static void
+as_info_all_node_listener(as_error* err, char* response, void* udata, as_event_loop* event_loop)
+{
+	as_info_all_ref* ref = udata;
+	as_info_node_result* result = &ref->state->results[ref->index];
+
+	if (err) {
+		as_error_copy(&result->err, err);
+	}
+	else {
+		// The async info command frees its response after the listener returns.
+		result->response = cf_strdup(response);
+	}
+	as_info_all_complete(ref->state, event_loop);
+}
+
+as_status
+aerospike_info_all_async(
+	aerospike* as, as_error* err, as_policy_info* policy, const char* req,
+	aerospike_info_all_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.info;
+	}
+
+	as_nodes* nodes;
+	as_status status = as_cluster_reserve_all_nodes(as->cluster, err, &nodes);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint32_t n_nodes = nodes->size;
+	size_t results_size = sizeof(as_info_node_result) * n_nodes;
+	as_info_all_state* state = cf_malloc(sizeof(as_info_all_state) + results_size +
+		sizeof(as_info_all_ref) * n_nodes);
+
+	state->listener = listener;
+	state->udata = udata;
+	state->nodes = nodes;
+	state->refs = (as_info_all_ref*)((uint8_t*)state->results + results_size);
+	state->n_results = n_nodes;
+
+	// Hold one extra count while commands are started, so the listener can not run and free
+	// the state before the loop below is done.
+	state->pending = n_nodes + 1;
+
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		as_info_node_result* result = &state->results[i];
+		result->node = nodes->array[i];
+		result->response = NULL;
+		as_error_init(&result->err);
+		state->refs[i].state = state;
+		state->refs[i].index = i;
+	}
+
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		as_error node_err;
+		status = as_info_command_node_async(as, &node_err, policy, nodes->array[i], req,
+			as_info_all_node_listener, &state->refs[i], event_loop);
+
+		if (status != AEROSPIKE_OK) {
+			// Node listener will not be called.
+			as_error_copy(&state->results[i].err, &node_err);
+			as_aaf_uint32(&state->pending, -1);
+		}
+	}
+	as_info_all_complete(state, event_loop);
+	return AEROSPIKE_OK;
+}
@@ -17,25 +17,34 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/as_async.h>
+#include <aerospike/as_auto_batch.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_buffer.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_event.h>
+#include <aerospike/as_event_internal.h>
 #include <aerospike/as_exp.h>
+#include <aerospike/as_exp_eval.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_log.h>
+#include <aerospike/as_monitor.h>
 #include <aerospike/as_msgpack.h>
+#include <aerospike/as_negative_cache.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_partition.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_random.h>
+#include <aerospike/as_read_coalesce.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_record_cache.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_shm_cluster.h>
 #include <aerospike/as_status.h>
+#include <aerospike/as_string.h>
 #include <citrusleaf/cf_clock.h>
+#include <string.h>
 
 /******************************************************************************
  * TYPES
@@ -46,6 +55,40 @@ typedef struct as_read_info_s {
 	uint8_t flags;
 } as_read_info;
 
+typedef struct as_cache_read_s {
+	as_command_parse_result_data data;
+	as_record_cache* cache;
+	as_read_flight* flight;
+	const as_key* key;
+	uint64_t version;
+} as_cache_read;
+
+typedef struct as_key_flight_leader_s {
+	as_async_record_listener listener;
+	void* udata;
+	as_read_flight* flight;
+} as_key_flight_leader;
+
+typedef struct as_key_flight_follower_s {
+	as_async_record_listener listener;
+	void* udata;
+	as_event_loop* event_loop;
+	as_cluster* cluster;
+	uint8_t* buf;
+	as_error err;
+	uint32_t size;
+	as_status status;
+	bool deserialize;
+	bool heap_rec;
+} as_key_flight_follower;
+
+typedef struct as_key_mux_s {
+	as_monitor monitor;
+	as_error* err;
+	as_record* record;
+	as_status status;
+} as_key_mux;
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -63,6 +106,50 @@ as_key_partition_init(as_cluster* cluster, as_error* err, const as_key* key, as_
 	return as_partition_info_init(pi, cluster, err, key);
 }
 
+static inline as_status
+as_key_partition_init_session(
+	as_cluster* cluster, as_error* err, as_session_ctx* ctx, const as_key* key,
+	as_partition_info* pi
+	)
+{
+	// Callers reuse err, so it only needs a reset after a failure.
+	if (err->code != AEROSPIKE_OK) {
+		as_error_reset(err);
+	}
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	// Partition tables live as long as the cluster, so the last partition stays valid.
+	if (ctx->cluster == cluster &&
+		memcmp(ctx->digest, key->digest.value, AS_DIGEST_VALUE_SIZE) == 0 &&
+		strcmp(ctx->ns, key->ns) == 0) {
+		*pi = ctx->pi;
+		return AEROSPIKE_OK;
+	}
+
+	status = as_partition_info_init(pi, cluster, err, key);
+
+	if (status == AEROSPIKE_OK) {
+		ctx->cluster = cluster;
+		ctx->pi = *pi;
+		memcpy(ctx->digest, key->digest.value, AS_DIGEST_VALUE_SIZE);
+		as_strncpy(ctx->ns, key->ns, sizeof(ctx->ns));
+	}
+	return status;
+}
+
+static inline bool
+as_key_can_auto_batch(const as_policy_read* policy, as_pipe_listener pipe_listener)
+{
+	// Pipelined, filtered and heap record reads keep their own single key command.
+	return policy->auto_batch && ! pipe_listener && ! policy->base.filter_exp &&
+		! policy->async_heap_rec;
+}
+
 static inline void
 as_command_init_read(
 	as_command* cmd, as_cluster* cluster, const as_policy_base* policy, as_policy_replica replica,
@@ -88,7 +175,8 @@ as_command_init_read(
 				break;
 
 			case AS_POLICY_READ_MODE_SC_LINEARIZE:
-				cmd->replica = (replica != AS_POLICY_REPLICA_PREFER_RACK) ?
+				cmd->replica = (replica != AS_POLICY_REPLICA_PREFER_RACK &&
+								replica != AS_POLICY_REPLICA_LOWEST_LATENCY) ?
 								replica : AS_POLICY_REPLICA_SEQUENCE;
 				cmd->flags = AS_COMMAND_FLAGS_READ | AS_COMMAND_FLAGS_LINEARIZE;
 				break;
@@ -109,13 +197,25 @@ static inline as_status
 as_command_execute_read(
 	as_cluster* cluster, as_error* err, const as_policy_base* policy, as_policy_replica replica,
 	as_policy_read_mode_sc read_mode_sc, uint8_t* buf, size_t size, as_partition_info* pi,
-	const as_parse_results_fn fn, void* udata
+	const as_parse_results_fn fn, void* udata, uint32_t hedge_delay, uint32_t hedge_max,
+	bool zero_copy
 	)
 {
 	as_command cmd;
 	as_command_init_read(&cmd, cluster, policy, replica, read_mode_sc, size, pi,
 						 fn, udata);
 
+	if (zero_copy) {
+		cmd.flags |= AS_COMMAND_FLAGS_ZERO_COPY;
+	}
+
+	// Hedge AP reads only. SC reads must stay on the node chosen by the read mode.
+	if (hedge_delay > 0 && ! pi->sc_mode && replica != AS_POLICY_REPLICA_MASTER) {
+		cmd.flags |= AS_COMMAND_FLAGS_HEDGE;
+		cmd.hedge_delay = hedge_delay;
+		cmd.hedge_max = hedge_max;
+	}
+
 	cmd.buf = buf;
 	as_command_start_timer(&cmd);
 	return as_command_execute(&cmd, err);
@@ -140,6 +240,7 @@ as_command_init_write(
 
 	switch (replica) {
 		case AS_POLICY_REPLICA_PREFER_RACK:
+		case AS_POLICY_REPLICA_LOWEST_LATENCY:
 			// Writes must always go to master node via sequence algorithm.
 			cmd->replica = AS_POLICY_REPLICA_SEQUENCE;
 			break;
@@ -168,7 +269,8 @@ as_event_command_init_read(
 				break;
 
 			case AS_POLICY_READ_MODE_SC_LINEARIZE:
-				ri->replica = (replica != AS_POLICY_REPLICA_PREFER_RACK) ?
+				ri->replica = (replica != AS_POLICY_REPLICA_PREFER_RACK &&
+							   replica != AS_POLICY_REPLICA_LOWEST_LATENCY) ?
 							   replica : AS_POLICY_REPLICA_SEQUENCE;
 				ri->flags = AS_ASYNC_FLAGS_MASTER | AS_ASYNC_FLAGS_READ | AS_ASYNC_FLAGS_LINEARIZE;
 				break;
@@ -205,21 +307,538 @@ as_command_write_filter(const as_policy_base* policy, uint32_t filter_size, uint
 }
 
 /******************************************************************************
- * GET
+ * RECORD CACHE
  *****************************************************************************/
 
-as_status
-aerospike_key_get(
-	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key, as_record** rec
+static inline as_record_cache*
+as_key_cache_get(as_cluster* cluster, const as_policy_read* policy)
+{
+	// Filtered reads use the cache too. Cache hits are filtered by the client and fall back
+	// to the server when the filter can not be evaluated locally.
+	if (policy->cache == AS_POLICY_CACHE_NONE) {
+		return NULL;
+	}
+	return cluster->record_cache;
+}
+
+static inline void
+as_key_cache_remove(as_cluster* cluster, const as_key* key)
+{
+	// Writes remove the record before the command is sent and sync writes remove it again
+	// after the response, so reads that raced with the write are not cached.
+	if (cluster->record_cache) {
+		as_record_cache_remove(cluster->record_cache, key->ns, key->digest.value);
+	}
+
+	if (cluster->negative_cache) {
+		as_negative_cache_remove(cluster->negative_cache, key->ns, key->digest.value);
+	}
+}
+
+static inline as_negative_cache*
+as_key_negative_get(as_cluster* cluster, const as_policy_read* policy)
+{
+	if (! policy->negative_cache || policy->base.filter_exp) {
+		return NULL;
+	}
+	return cluster->negative_cache;
+}
+
+static inline bool
+as_key_negative_hit(
+	as_cluster* cluster, as_negative_cache* neg, as_error* err, const as_key* key,
+	uint64_t* version
 	)
 {
-	if (! policy) {
-		policy = &as->config.policies.read;
+	if (as_negative_cache_contains(neg, key->ns, key->digest.value)) {
+		as_error_update_status(err, AEROSPIKE_ERR_RECORD_NOT_FOUND, NULL,
+							   cluster->lazy_error_messages);
+		return true;
+	}
+	*version = as_negative_cache_version(neg, key->ns, key->digest.value);
+	return false;
+}
+
+static inline void
+as_key_negative_miss(
+	as_negative_cache* neg, const as_key* key, as_status status, uint64_t version
+	)
+{
+	if (neg && status == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+		as_negative_cache_add(neg, key->ns, key->digest.value, version);
+	}
+}
+
+static inline bool
+as_key_can_multiplex(bool multiplex, as_record** rec)
+{
+	// Records supplied by the caller can not be filled from an async listener.
+	return multiplex && ! (rec && *rec) && as_event_can_block();
+}
+
+static inline bool
+as_key_read_can_multiplex(as_cluster* cluster, const as_policy_read* policy, as_record** rec)
+{
+	// Record and negative caches are only consulted by sync reads.
+	return as_key_can_multiplex(policy->multiplex, rec) && ! as_key_cache_get(cluster, policy) &&
+		! as_key_negative_get(cluster, policy);
+}
+
+static inline void
+as_key_mux_init(as_key_mux* mux, as_error* err)
+{
+	as_monitor_init(&mux->monitor);
+	mux->err = err;
+	mux->record = NULL;
+	mux->status = AEROSPIKE_OK;
+}
+
+static void
+as_key_mux_notify(as_key_mux* mux, as_error* err, as_record* rec)
+{
+	if (err) {
+		as_error_copy(mux->err, err);
+		mux->status = err->code;
+	}
+	mux->record = rec;
+	as_monitor_notify(&mux->monitor);
+}
+
+static void
+as_key_mux_write_listener(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	as_key_mux_notify(udata, err, NULL);
+}
+
+static void
+as_key_mux_record_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	as_key_mux_notify(udata, err, rec);
+}
+
+static as_status
+as_key_mux_wait(as_key_mux* mux, as_status status, as_record** rec)
+{
+	// Listener is not called when the command could not be started.
+	if (status == AEROSPIKE_OK) {
+		as_monitor_wait(&mux->monitor);
+		status = mux->status;
+	}
+	as_monitor_destroy(&mux->monitor);
+
+	if (rec) {
+		*rec = mux->record;
+	}
+	else if (mux->record) {
+		as_record_destroy(mux->record);
+	}
+	return status;
+}
+
+static as_status
+as_command_parse_result_cache(
+	as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size
+	)
+{
+	as_cache_read* cr = cmd->udata;
+
+	if (cr->flight) {
+		// Identical reads that joined this one parse their own copy of the response.
+		as_read_flight_set_response(cr->flight, buf, size);
+	}
+
+	uint8_t* copy = NULL;
+
+	if (cr->cache) {
+		// Keep the response as received, because parsing converts the header in place and
+		// zero copy records take ownership of the buffer.
+		copy = cf_malloc(size);
+		memcpy(copy, buf, size);
+	}
+
+	cmd->udata = &cr->data;
+	as_status status = as_command_parse_result(err, cmd, node, buf, size);
+	cmd->udata = cr;
+
+	if (copy) {
+		if (status == AEROSPIKE_OK) {
+			as_msg* msg = (as_msg*)copy;
+			uint32_t gen = cf_swap_from_be32(msg->generation);
+			as_record_cache_put(cr->cache, cr->key->ns, cr->key->digest.value, copy,
+				(uint32_t)size, gen, cr->version);
+		}
+		cf_free(copy);
+	}
+	return status;
+}
+
+static as_status
+as_command_parse_generation(
+	as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size
+	)
+{
+	as_msg* msg = (as_msg*)buf;
+	as_status status = as_msg_parse(err, msg, size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (msg->result_code) {
+		return as_error_update_status(err, msg->result_code, NULL,
+									  cmd->cluster->lazy_error_messages);
+	}
+
+	*(uint32_t*)cmd->udata = msg->generation;
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_key_read_generation(
+	as_cluster* cluster, as_error* err, const as_policy_read* policy, const as_key* key,
+	as_partition_info* pi, uint32_t* gen
+	)
+{
+	uint16_t n_fields;
+	size_t size = as_command_key_size(policy->key, key, &n_fields);
+
+	uint8_t* buf = as_command_buffer_init(size);
+	uint8_t* p = as_command_write_header_read_header(buf, &policy->base, policy->read_mode_ap,
+		policy->read_mode_sc, n_fields, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_NOBINDATA);
+
+	p = as_command_write_key(p, policy->key, key);
+	size = as_command_write_end(buf, p);
+
+	as_status status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
+		policy->read_mode_sc, buf, size, pi, as_command_parse_generation, gen,
+		policy->hedge_delay, policy->hedge_max, false);
+
+	as_command_buffer_free(buf, size);
+	return status;
+}
+
+static as_status
+as_key_cache_parse(
+	as_cluster* cluster, as_error* err, bool zero_copy, as_command_parse_result_data* data,
+	uint8_t* buf, uint32_t size
+	)
+{
+	// Parse the cached or shared copy exactly like a server response.
+	as_command cmd;
+	memset(&cmd, 0, sizeof(as_command));
+	cmd.cluster = cluster;
+	cmd.udata = data;
+
+	if (zero_copy) {
+		// Record takes ownership of the copy.
+		cmd.flags = AS_COMMAND_FLAGS_ZERO_COPY;
+		cmd.response = buf;
+	}
+
+	as_status status = as_command_parse_result(err, &cmd, NULL, buf, size);
+
+	if (! zero_copy || cmd.response) {
+		cf_free(buf);
+	}
+	return status;
+}
+
+static bool
+as_key_cache_filter(
+	as_cluster* cluster, const as_exp* filter, const as_key* key, const uint8_t* buf,
+	uint32_t size, bool* match
+	)
+{
+	// Parsing converts the header in place, so evaluate against a parsed copy.
+	uint8_t* copy = cf_malloc(size);
+	memcpy(copy, buf, size);
+
+	as_record* rec = NULL;
+	as_command_parse_result_data data;
+	data.record = &rec;
+	data.deserialize = true;
+	data.lazy = false;
+	data.arena = false;
+
+	as_command cmd;
+	memset(&cmd, 0, sizeof(as_command));
+	cmd.cluster = cluster;
+	cmd.udata = &data;
+
+	as_error err;
+	as_status status = as_command_parse_result(&err, &cmd, NULL, copy, size);
+	cf_free(copy);
+
+	if (status == AEROSPIKE_OK) {
+		// Responses do not include the set, but the digest was computed from it.
+		as_strncpy(rec->key.set, key->set, sizeof(rec->key.set));
+		status = as_exp_eval_filter(&err, filter, rec, match);
+	}
+
+	if (rec) {
+		as_record_destroy(rec);
+	}
+	return status == AEROSPIKE_OK;
+}
+
+static bool
+as_key_cache_read(
+	as_cluster* cluster, as_record_cache* cache, as_error* err, const as_policy_read* policy,
+	const as_key* key, as_partition_info* pi, as_command_parse_result_data* data,
+	as_status* status
+	)
+{
+	uint8_t* buf;
+	uint32_t size;
+	uint32_t gen;
+
+	if (! as_record_cache_get(cache, key->ns, key->digest.value, &buf, &size, &gen)) {
+		return false;
+	}
+
+	bool match = true;
+
+	if (policy->base.filter_exp &&
+		! as_key_cache_filter(cluster, policy->base.filter_exp, key, buf, size, &match)) {
+		// Filter must be evaluated by the server.
+		cf_free(buf);
+		return false;
+	}
+
+	if (policy->cache == AS_POLICY_CACHE_VALIDATE) {
+		uint32_t server_gen;
+		*status = as_key_read_generation(cluster, err, policy, key, pi, &server_gen);
+
+		if (*status != AEROSPIKE_OK) {
+			if (*status == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+				as_record_cache_remove(cache, key->ns, key->digest.value);
+			}
+			// Never fall back to possibly stale bins.
+			cf_free(buf);
+			return true;
+		}
+
+		if (server_gen != gen) {
+			// Record changed. Read it again.
+			as_record_cache_remove(cache, key->ns, key->digest.value);
+			cf_free(buf);
+			return false;
+		}
+		as_record_cache_touch(cache, key->ns, key->digest.value);
+	}
+
+	if (! match) {
+		cf_free(buf);
+		*status = as_error_update_status(err, AEROSPIKE_FILTERED_OUT, NULL,
+										 cluster->lazy_error_messages);
+		return true;
+	}
+
+	*status = as_key_cache_parse(cluster, err, policy->zero_copy, data, buf, size);
+	return true;
+}
+
+static bool
+as_key_flight_join(
+	as_cluster* cluster, as_error* err, const as_policy_read* policy, uint8_t* buf, size_t size,
+	as_cache_read* cr, as_status* status
+	)
+{
+	cr->flight = NULL;
+
+	if (! policy->coalesce) {
+		return false;
+	}
+
+	bool leader;
+	as_read_flight* flight = as_read_coalesce_join(cluster->read_coalesce, buf, size, &leader);
+
+	if (leader) {
+		cr->flight = flight;
+		return false;
+	}
+
+	// Identical read is in flight. Wait for its response instead of sending the command.
+	as_command_buffer_free(buf, size);
+
+	uint8_t* response;
+	uint32_t response_size;
+	*status = as_read_flight_wait(flight, err, policy->base.total_timeout, &response,
+		&response_size);
+
+	if (response) {
+		*status = as_key_cache_parse(cluster, err, policy->zero_copy, &cr->data, response,
+			response_size);
+	}
+	return true;
+}
+
+static bool
+as_key_flight_parse(as_event_command* cmd)
+{
+	// Keep the response as received, because parsing converts the header in place.
+	as_key_flight_leader* fl = cmd->udata;
+	as_read_flight_set_response(fl->flight, cmd->buf + cmd->pos, cmd->len - cmd->pos);
+	return as_event_command_parse_result(cmd);
+}
+
+static void
+as_key_flight_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	as_key_flight_leader* fl = udata;
+	as_read_flight_complete(fl->flight, err, err ? err->code : AEROSPIKE_OK);
+	fl->listener(err, rec, fl->udata, event_loop);
+	cf_free(fl);
+}
+
+static void
+as_key_flight_deliver(as_event_loop* event_loop, as_key_flight_follower* ff)
+{
+	as_record* rec = NULL;
+	as_status status = ff->status;
+
+	if (ff->buf) {
+		as_command_parse_result_data data;
+		data.record = &rec;
+		data.deserialize = ff->deserialize;
+		data.lazy = false;
+		data.arena = false;
+		status = as_key_cache_parse(ff->cluster, &ff->err, false, &data, ff->buf, ff->size);
+	}
+
+	if (status == AEROSPIKE_OK) {
+		ff->listener(NULL, rec, ff->udata, event_loop);
+
+		if (! ff->heap_rec) {
+			as_record_destroy(rec);
+		}
+	}
+	else {
+		if (rec) {
+			as_record_destroy(rec);
+		}
+		ff->listener(&ff->err, NULL, ff->udata, event_loop);
+	}
+	cf_free(ff);
+}
+
+static void
+as_key_flight_notify(as_error* err, as_status status, uint8_t* buf, uint32_t size, void* udata)
+{
+	// Called by the thread that completed the flight. Run listener in the follower's loop.
+	as_key_flight_follower* ff = udata;
+	ff->buf = buf;
+	ff->size = size;
+	ff->status = status;
+	as_error_copy(&ff->err, err);
+
+	if (! as_event_execute(ff->event_loop, (as_event_executable)as_key_flight_deliver, ff)) {
+		// Follower already returned success, so the listener must still be called once.
+		cf_free(ff->buf);
+		as_error_set_message(&ff->err, AEROSPIKE_ERR_CLIENT, "Failed to queue command");
+		ff->listener(&ff->err, NULL, ff->udata, ff->event_loop);
+		cf_free(ff);
+	}
+}
+
+static as_status
+as_key_flight_execute(
+	as_cluster* cluster, as_error* err, const as_policy_read* policy, as_event_command* cmd,
+	as_pipe_listener pipe_listener
+	)
+{
+	if (! policy->coalesce || pipe_listener) {
+		return as_event_command_execute(cmd, err);
+	}
+
+	as_async_record_command* rcmd = (as_async_record_command*)cmd;
+	bool leader;
+	as_read_flight* flight = as_read_coalesce_join(cluster->read_coalesce, cmd->buf,
+		cmd->write_len, &leader);
+
+	if (! leader) {
+		// Identical read is in flight. Wait for its response instead of sending the command.
+		as_key_flight_follower* ff = cf_malloc(sizeof(as_key_flight_follower));
+		ff->listener = rcmd->listener;
+		ff->udata = cmd->udata;
+		ff->event_loop = cmd->event_loop;
+		ff->cluster = cluster;
+		ff->deserialize = policy->deserialize;
+		ff->heap_rec = policy->async_heap_rec;
+		as_event_command_dealloc(cmd);
+		as_read_flight_listen(flight, as_key_flight_notify, ff);
+		return AEROSPIKE_OK;
+	}
+
+	as_key_flight_leader* fl = cf_malloc(sizeof(as_key_flight_leader));
+	fl->listener = rcmd->listener;
+	fl->udata = cmd->udata;
+	fl->flight = flight;
+	rcmd->listener = as_key_flight_listener;
+	cmd->udata = fl;
+	cmd->parse_results = as_key_flight_parse;
+
+	as_status status = as_event_command_execute(cmd, err);
+
+	if (status != AEROSPIKE_OK) {
+		// Listener is not called when the command could not be queued.
+		as_read_flight_complete(flight, err, status);
+		cf_free(fl);
+	}
+	return status;
+}
+
+static void
+as_record_select_bins(as_record* rec, const char* bins[])
+{
+	as_bin* entries = rec->bins.entries;
+	uint16_t n = 0;
+
+	for (uint16_t i = 0; i < rec->bins.size; i++) {
+		as_bin* bin = &entries[i];
+		bool keep = false;
+
+		for (uint32_t j = 0; bins[j] != NULL && bins[j][0] != '\0'; j++) {
+			if (strcmp(bin->name, bins[j]) == 0) {
+				keep = true;
+				break;
+			}
+		}
+
+		if (! keep) {
+			as_val_destroy((as_val*)bin->valuep);
+			continue;
+		}
+
+		if (n != i) {
+			as_bin* trg = &entries[n];
+			bool embedded = ((as_bin_value*)bin->valuep == &bin->value);
+			*trg = *bin;
+
+			if (embedded) {
+				trg->valuep = &trg->value;
+			}
+		}
+		n++;
 	}
+	rec->bins.size = n;
+}
 
+/******************************************************************************
+ * GET
+ *****************************************************************************/
+
+static as_status
+as_key_get(
+	aerospike* as, as_error* err, const as_policy_read* policy, as_session_ctx* ctx,
+	const as_key* key, as_record** rec
+	)
+{
 	as_cluster* cluster = as->cluster;
 	as_partition_info pi;
-	as_status status = as_key_partition_init(cluster, err, key, &pi);
+	as_status status = ctx ?
+		as_key_partition_init_session(cluster, err, ctx, key, &pi) :
+		as_key_partition_init(cluster, err, key, &pi);
 
 	if (status != AEROSPIKE_OK) {
 		return status;
@@ -227,26 +846,268 @@ aerospike_key_get(
 
 	uint16_t n_fields;
 	size_t size = as_command_key_size(policy->key, key, &n_fields);
-	uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
+	uint32_t filter_size;
+
+	if (ctx) {
+		filter_size = ctx->filter_size;
+		n_fields += ctx->n_fields;
+	}
+	else {
+		filter_size = as_command_filter_size(&policy->base, &n_fields);
+	}
 	size += filter_size;
 
+	as_cache_read cr;
+	cr.data.record = rec;
+	cr.data.deserialize = policy->deserialize;
+	cr.data.lazy = policy->deserialize && policy->lazy_deserialize;
+	cr.data.arena = policy->deserialize && policy->arena_deserialize;
+	cr.cache = as_key_cache_get(cluster, policy);
+
+	if (cr.cache) {
+		if (as_key_cache_read(cluster, cr.cache, err, policy, key, &pi, &cr.data, &status)) {
+			return status;
+		}
+		cr.key = key;
+		cr.version = as_record_cache_version(cr.cache, key->digest.value);
+	}
+
+	as_negative_cache* neg = as_key_negative_get(cluster, policy);
+	uint64_t neg_version = 0;
+
+	if (neg && as_key_negative_hit(cluster, neg, err, key, &neg_version)) {
+		return AEROSPIKE_ERR_RECORD_NOT_FOUND;
+	}
+
 	uint8_t* buf = as_command_buffer_init(size);
+	uint8_t* p;
+
+	if (ctx) {
+		memcpy(buf + 8, ctx->header, sizeof(ctx->header));
+		*(uint16_t*)&buf[26] = cf_swap_to_be16(n_fields);
+		p = as_command_write_key(buf + AS_HEADER_SIZE, policy->key, key);
+		memcpy(p, ctx->filter, filter_size);
+		p += filter_size;
+	}
+	else {
+		uint32_t timeout = as_command_server_timeout(&policy->base);
+		p = as_command_write_header_read(buf, &policy->base, policy->read_mode_ap,
+			policy->read_mode_sc, timeout, n_fields, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL,
+			0);
+		p = as_command_write_key(p, policy->key, key);
+		p = as_command_write_filter(&policy->base, filter_size, p);
+	}
+	size = as_command_write_end(buf, p);
+
+	if (as_key_flight_join(cluster, err, policy, buf, size, &cr, &status)) {
+		return status;
+	}
+
+	if (cr.cache || cr.flight) {
+		status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
+					policy->read_mode_sc, buf, size, &pi, as_command_parse_result_cache, &cr,
+					policy->hedge_delay, policy->hedge_max, policy->zero_copy);
+	}
+	else {
+		status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
+					policy->read_mode_sc, buf, size, &pi, as_command_parse_result, &cr.data,
+					policy->hedge_delay, policy->hedge_max, policy->zero_copy);
+	}
+
+	as_command_buffer_free(buf, size);
+
+	if (cr.flight) {
+		as_read_flight_complete(cr.flight, err, status);
+	}
+	as_key_negative_miss(neg, key, status, neg_version);
+	return status;
+}
+
+static as_status
+as_key_read_mux(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const char* bins[], bool exists, as_record** rec
+	)
+{
+	as_policy_read p = *policy;
+	p.async_heap_rec = true;
+
+	as_key_mux mux;
+	as_key_mux_init(&mux, err);
+
+	as_status status;
+
+	if (exists) {
+		status = aerospike_key_exists_async(as, err, &p, key, as_key_mux_record_listener, &mux,
+			NULL, NULL);
+	}
+	else if (bins) {
+		status = aerospike_key_select_async(as, err, &p, key, bins, as_key_mux_record_listener,
+			&mux, NULL, NULL);
+	}
+	else {
+		status = aerospike_key_get_async(as, err, &p, key, as_key_mux_record_listener, &mux,
+			NULL, NULL);
+	}
+	return as_key_mux_wait(&mux, status, rec);
+}
+
+as_status
+aerospike_key_get(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key, as_record** rec
+	)
+{
+	if (! policy) {
+		policy = &as->config.policies.read;
+	}
+
+	if (as_key_read_can_multiplex(as->cluster, policy, rec)) {
+		return as_key_read_mux(as, err, policy, key, NULL, false, rec);
+	}
+	return as_key_get(as, err, policy, NULL, key, rec);
+}
+
+void
+as_session_ctx_init(aerospike* as, as_session_ctx* ctx, const as_policy_read* policy)
+{
+	as_policy_read_copy(policy ? policy : &as->config.policies.read, &ctx->policy);
+	policy = &ctx->policy;
+
+	ctx->n_fields = 0;
+	ctx->filter_size = as_command_filter_size(&policy->base, &ctx->n_fields);
+	ctx->filter = NULL;
+
+	if (ctx->filter_size > 0) {
+		ctx->filter = cf_malloc(ctx->filter_size);
+		as_command_write_filter(&policy->base, ctx->filter_size, ctx->filter);
+
+		// The expression has been serialized, so do not reference caller's filter.
+		// Filtered reads must still bypass the caches.
+		ctx->policy.base.filter_exp = NULL;
+		ctx->policy.cache = AS_POLICY_CACHE_NONE;
+		ctx->policy.negative_cache = false;
+	}
+
+	uint8_t header[AS_HEADER_SIZE];
 	uint32_t timeout = as_command_server_timeout(&policy->base);
-	uint8_t* p = as_command_write_header_read(buf, &policy->base, policy->read_mode_ap,
-		policy->read_mode_sc, timeout, n_fields, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL, 0);
+	as_command_write_header_read(header, &policy->base, policy->read_mode_ap,
+		policy->read_mode_sc, timeout, 0, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL, 0);
+	memcpy(ctx->header, header + 8, sizeof(ctx->header));
 
-	p = as_command_write_key(p, policy->key, key);
-	p = as_command_write_filter(&policy->base, filter_size, p);
-	size = as_command_write_end(buf, p);
+	ctx->cluster = NULL;
+}
 
+void
+as_session_ctx_destroy(as_session_ctx* ctx)
+{
+	cf_free(ctx->filter);
+	ctx->filter = NULL;
+	ctx->filter_size = 0;
+	ctx->cluster = NULL;
+}
+
+as_status
+aerospike_key_get_session(
+	aerospike* as, as_error* err, as_session_ctx* ctx, const as_key* key, as_record** rec
+	)
+{
+	return as_key_get(as, err, &ctx->policy, ctx, key, rec);
+}
+
+typedef struct as_get_many_s {
+	as_command cmd;
+	as_partition_info pi;
 	as_command_parse_result_data data;
-	data.record = rec;
-	data.deserialize = policy->deserialize;
+	uint8_t* buf;
+	size_t size;
+	uint32_t index;
+} as_get_many;
 
-	status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
-				policy->read_mode_sc, buf, size, &pi, as_command_parse_result, &data);
+as_status
+aerospike_key_get_many(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* keys,
+	uint32_t n_keys, as_record** records, as_status* statuses
+	)
+{
+	if (! policy) {
+		policy = &as->config.policies.read;
+	}
 
-	as_command_buffer_free(buf, size);
+	as_cluster* cluster = as->cluster;
+	as_get_many* gets = cf_malloc(sizeof(as_get_many) * n_keys);
+	as_command* cmds = cf_malloc(sizeof(as_command) * n_keys);
+	uint32_t n_cmds = 0;
+	as_status status = AEROSPIKE_OK;
+	as_error e;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		const as_key* key = &keys[i];
+		as_get_many* g = &gets[n_cmds];
+
+		statuses[i] = as_key_partition_init(cluster, &e, key, &g->pi);
+
+		if (statuses[i] != AEROSPIKE_OK) {
+			if (status == AEROSPIKE_OK) {
+				as_error_copy(err, &e);
+				status = statuses[i];
+			}
+			continue;
+		}
+
+		uint16_t n_fields;
+		size_t size = as_command_key_size(policy->key, key, &n_fields);
+		uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
+		size += filter_size;
+
+		// Buffers are held until all commands complete, so they are not allocated on the stack.
+		g->buf = cf_malloc(size);
+		uint32_t timeout = as_command_server_timeout(&policy->base);
+		uint8_t* p = as_command_write_header_read(g->buf, &policy->base, policy->read_mode_ap,
+			policy->read_mode_sc, timeout, n_fields, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL,
+			0);
+
+		p = as_command_write_key(p, policy->key, key);
+		p = as_command_write_filter(&policy->base, filter_size, p);
+		g->size = as_command_write_end(g->buf, p);
+		g->index = i;
+
+		g->data.record = &records[i];
+		g->data.deserialize = policy->deserialize;
+		g->data.lazy = policy->deserialize && policy->lazy_deserialize;
+		g->data.arena = policy->deserialize && policy->arena_deserialize;
+
+		as_command* cmd = &cmds[n_cmds++];
+		as_command_init_read(cmd, cluster, &policy->base, policy->replica, policy->read_mode_sc,
+			g->size, &g->pi, as_command_parse_result, &g->data);
+
+		if (policy->zero_copy) {
+			cmd->flags |= AS_COMMAND_FLAGS_ZERO_COPY;
+		}
+		cmd->buf = g->buf;
+		as_command_start_timer(cmd);
+	}
+
+	as_status* cmd_statuses = cf_malloc(sizeof(as_status) * (n_cmds + 1));
+	as_status rv = as_command_execute_many(cmds, n_cmds, cmd_statuses, &e);
+
+	if (status == AEROSPIKE_OK && rv != AEROSPIKE_OK) {
+		as_error_copy(err, &e);
+		status = rv;
+	}
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_get_many* g = &gets[i];
+		statuses[g->index] = cmd_statuses[i];
+		cf_free(g->buf);
+	}
+
+	cf_free(cmd_statuses);
+	cf_free(cmds);
+	cf_free(gets);
+
+	if (status == AEROSPIKE_OK) {
+		as_error_reset(err);
+	}
 	return status;
 }
 
@@ -269,6 +1130,10 @@ aerospike_key_get_async(
 		return status;
 	}
 
+	if (as_key_can_auto_batch(policy, pipe_listener)) {
+		return as_auto_batch_read(as, err, policy, key, NULL, 0, listener, udata, event_loop);
+	}
+
 	as_read_info ri;
 	as_event_command_init_read(policy->replica, policy->read_mode_sc, pi.sc_mode, &ri);
 
@@ -289,7 +1154,7 @@ aerospike_key_get_async(
 	p = as_command_write_key(p, policy->key, key);
 	p = as_command_write_filter(&policy->base, filter_size, p);
 	cmd->write_len = (uint32_t)as_command_write_end(cmd->buf, p);
-	return as_event_command_execute(cmd, err);
+	return as_key_flight_execute(cluster, err, policy, cmd, pipe_listener);
 }
 
 /******************************************************************************
@@ -307,6 +1172,11 @@ aerospike_key_select(
 	}
 	
 	as_cluster* cluster = as->cluster;
+
+	if (as_key_read_can_multiplex(cluster, policy, rec)) {
+		return as_key_read_mux(as, err, policy, key, bins, false, rec);
+	}
+
 	as_partition_info pi;
 	as_status status = as_key_partition_init(cluster, err, key, &pi);
 
@@ -329,6 +1199,30 @@ aerospike_key_select(
 		}
 	}
 
+	as_record_cache* cache = as_key_cache_get(cluster, policy);
+
+	if (cache) {
+		as_command_parse_result_data data;
+		data.record = rec;
+		data.deserialize = policy->deserialize;
+		data.lazy = policy->deserialize && policy->lazy_deserialize;
+		data.arena = policy->deserialize && policy->arena_deserialize;
+
+		if (as_key_cache_read(cluster, cache, err, policy, key, &pi, &data, &status)) {
+			if (status == AEROSPIKE_OK) {
+				as_record_select_bins(*rec, bins);
+			}
+			return status;
+		}
+	}
+
+	as_negative_cache* neg = as_key_negative_get(cluster, policy);
+	uint64_t neg_version = 0;
+
+	if (neg && as_key_negative_hit(cluster, neg, err, key, &neg_version)) {
+		return AEROSPIKE_ERR_RECORD_NOT_FOUND;
+	}
+
 	uint8_t* buf = as_command_buffer_init(size);
 	uint32_t timeout = as_command_server_timeout(&policy->base);
 	uint8_t* p = as_command_write_header_read(buf, &policy->base, policy->read_mode_ap,
@@ -342,12 +1236,153 @@ aerospike_key_select(
 	}
 	size = as_command_write_end(buf, p);
 
-	as_command_parse_result_data data;
-	data.record = rec;
-	data.deserialize = policy->deserialize;
+	as_cache_read cr;
+	cr.data.record = rec;
+	cr.data.deserialize = policy->deserialize;
+	cr.data.lazy = policy->deserialize && policy->lazy_deserialize;
+	cr.data.arena = policy->deserialize && policy->arena_deserialize;
+	cr.cache = NULL;
+
+	if (as_key_flight_join(cluster, err, policy, buf, size, &cr, &status)) {
+		return status;
+	}
+
+	if (cr.flight) {
+		status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
+					policy->read_mode_sc, buf, size, &pi, as_command_parse_result_cache, &cr,
+					policy->hedge_delay, policy->hedge_max, policy->zero_copy);
+	}
+	else {
+		status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
+					policy->read_mode_sc, buf, size, &pi, as_command_parse_result, &cr.data,
+					policy->hedge_delay, policy->hedge_max, policy->zero_copy);
+	}
+
+	as_command_buffer_free(buf, size);
+
+	if (cr.flight) {
+		as_read_flight_complete(cr.flight, err, status);
+	}
+	as_key_negative_miss(neg, key, status, neg_version);
+	return status;
+}
+
+as_status
+aerospike_key_get_stream(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const char* bin, as_stream_bin* stream
+	)
+{
+	if (! policy) {
+		policy = &as->config.policies.read;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_partition_info pi;
+	as_status status = as_key_partition_init(cluster, err, key, &pi);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint16_t n_fields;
+	size_t size = as_command_key_size(policy->key, key, &n_fields);
+	uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
+	size += filter_size;
+
+	status = as_command_bin_name_size(err, bin, &size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	stream->bin = bin;
+	stream->size = 0;
+	stream->gen = 0;
+	stream->ttl = 0;
+	stream->type = 0;
+	stream->found = false;
+
+	uint8_t* buf = as_command_buffer_init(size);
+	uint32_t timeout = as_command_server_timeout(&policy->base);
+	uint8_t* p = as_command_write_header_read(buf, &policy->base, policy->read_mode_ap,
+				policy->read_mode_sc, timeout, n_fields, 1, AS_MSG_INFO1_READ, 0);
+
+	// Compressed responses must be inflated in memory, so do not ask for one.
+	buf[9] &= ~AS_MSG_INFO1_COMPRESS_RESPONSE;
+
+	p = as_command_write_key(p, policy->key, key);
+	p = as_command_write_filter(&policy->base, filter_size, p);
+	p = as_command_write_bin_name(p, bin);
+	size = as_command_write_end(buf, p);
+
+	as_command cmd;
+	as_command_init_read(&cmd, cluster, &policy->base, policy->replica, policy->read_mode_sc,
+						 size, &pi, as_command_parse_stream, stream);
+	cmd.flags |= AS_COMMAND_FLAGS_STREAM;
+	cmd.buf = buf;
+	as_command_start_timer(&cmd);
+	status = as_command_execute(&cmd, err);
+
+	as_command_buffer_free(buf, size);
+	return status;
+}
+
+as_status
+aerospike_key_get_bound(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const as_binding* binding, void* obj, as_binding_status* bind_status
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.read;
+	}
+
+	if (binding->n_fields == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Binding has no fields");
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_partition_info pi;
+	as_status status = as_key_partition_init(cluster, err, key, &pi);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint16_t n_fields;
+	size_t size = as_command_key_size(policy->key, key, &n_fields);
+	uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
+	size += filter_size;
+
+	// Only the bound bins are requested. Names were validated by as_binding_add().
+	for (uint32_t i = 0; i < binding->n_fields; i++) {
+		size += binding->fields[i].name_len + AS_OPERATION_HEADER_SIZE;
+	}
+
+	uint8_t* buf = as_command_buffer_init(size);
+	uint32_t timeout = as_command_server_timeout(&policy->base);
+	uint8_t* p = as_command_write_header_read(buf, &policy->base, policy->read_mode_ap,
+				policy->read_mode_sc, timeout, n_fields, binding->n_fields, AS_MSG_INFO1_READ, 0);
+
+	p = as_command_write_key(p, policy->key, key);
+	p = as_command_write_filter(&policy->base, filter_size, p);
+
+	for (uint32_t i = 0; i < binding->n_fields; i++) {
+		p = as_command_write_bin_name(p, binding->fields[i].name);
+	}
+	size = as_command_write_end(buf, p);
+
+	as_command_parse_bound_data data;
+	data.binding = binding;
+	data.obj = obj;
+	data.status = bind_status;
 
 	status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
-				policy->read_mode_sc, buf, size, &pi, as_command_parse_result, &data);
+				policy->read_mode_sc, buf, size, &pi, as_command_parse_bound, &data,
+				policy->hedge_delay, policy->hedge_max, false);
 
 	as_command_buffer_free(buf, size);
 	return status;
@@ -389,6 +1424,10 @@ aerospike_key_select_async(
 		}
 	}
 
+	if (as_key_can_auto_batch(policy, pipe_listener)) {
+		return as_auto_batch_read(as, err, policy, key, bins, nvalues, listener, udata, event_loop);
+	}
+
 	as_event_command* cmd = as_async_record_command_create(
 		cluster, &policy->base, ri.replica, pi.ns, pi.partition, policy->deserialize,
 		policy->async_heap_rec, ri.flags, listener, udata, event_loop, pipe_listener,
@@ -405,7 +1444,7 @@ aerospike_key_select_async(
 		p = as_command_write_bin_name(p, bins[i]);
 	}
 	cmd->write_len = (uint32_t)as_command_write_end(cmd->buf, p);
-	return as_event_command_execute(cmd, err);
+	return as_key_flight_execute(cluster, err, policy, cmd, pipe_listener);
 }
 
 /******************************************************************************
@@ -422,6 +1461,11 @@ aerospike_key_exists(
 	}
 
 	as_cluster* cluster = as->cluster;
+
+	if (as_key_read_can_multiplex(cluster, policy, rec)) {
+		return as_key_read_mux(as, err, policy, key, NULL, true, rec);
+	}
+
 	as_partition_info pi;
 	as_status status = as_key_partition_init(cluster, err, key, &pi);
 
@@ -434,6 +1478,16 @@ aerospike_key_exists(
 	uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
 	size += filter_size;
 
+	as_negative_cache* neg = as_key_negative_get(cluster, policy);
+	uint64_t neg_version = 0;
+
+	if (neg && as_key_negative_hit(cluster, neg, err, key, &neg_version)) {
+		if (rec) {
+			*rec = NULL;
+		}
+		return AEROSPIKE_ERR_RECORD_NOT_FOUND;
+	}
+
 	uint8_t* buf = as_command_buffer_init(size);
 	uint8_t* p = as_command_write_header_read_header(buf, &policy->base, policy->read_mode_ap,
 		policy->read_mode_sc, n_fields, 0, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_NOBINDATA);
@@ -443,9 +1497,11 @@ aerospike_key_exists(
 	size = as_command_write_end(buf, p);
 
 	status = as_command_execute_read(cluster, err, &policy->base, policy->replica,
-				policy->read_mode_sc, buf, size, &pi, as_command_parse_header, rec);
+				policy->read_mode_sc, buf, size, &pi, as_command_parse_header, rec,
+				policy->hedge_delay, policy->hedge_max, false);
 
 	as_command_buffer_free(buf, size);
+	as_key_negative_miss(neg, key, status, neg_version);
 
 	if (status != AEROSPIKE_OK && rec) {
 		*rec = NULL;
@@ -503,6 +1559,10 @@ typedef struct as_put_s {
 	const as_key* key;
 	as_record* rec;
 	as_queue* buffers;
+	as_command_gather* gathers;
+	uint64_t gather_size;
+	uint32_t gather_threshold;
+	uint32_t n_gathers;
 	uint32_t filter_size;
 	uint16_t n_fields;
 	uint16_t n_bins;
@@ -510,13 +1570,18 @@ typedef struct as_put_s {
 
 static size_t
 as_put_init(
-	as_put* put, const as_policy_write* policy, const as_key* key, as_record* rec, as_queue* buffers
+	as_put* put, const as_policy_write* policy, const as_key* key, as_record* rec, as_queue* buffers,
+	as_command_gather* gathers, uint32_t gather_threshold
 	)
 {
 	put->policy = policy;
 	put->key = key;
 	put->rec = rec;
 	put->buffers = buffers;
+	put->gathers = gathers;
+	put->gather_size = 0;
+	put->gather_threshold = gathers ? gather_threshold : 0;
+	put->n_gathers = 0;
 
 	size_t size = as_command_key_size(policy->key, key, &put->n_fields);
 
@@ -529,7 +1594,17 @@ as_put_init(
 	as_bin* bins = rec->bins.entries;
 
 	for (uint16_t i = 0; i < n_bins; i++) {
-		size += as_command_bin_size(&bins[i], buffers);
+		uint32_t gather_size = as_command_bin_gather_size(&bins[i], put->gather_threshold);
+
+		if (gather_size > 0) {
+			// Value is sent from record memory, so only reserve space for header and name.
+			size += strlen(bins[i].name) + 8;
+			put->gather_size += gather_size;
+			put->n_gathers++;
+		}
+		else {
+			size += as_command_bin_size(&bins[i], buffers);
+		}
 	}
 	return size;
 }
@@ -552,6 +1627,23 @@ as_put_write(void* udata, uint8_t* buf)
 	uint16_t n_bins = put->n_bins;
 	as_queue* buffers = put->buffers;
 
+	if (put->n_gathers > 0) {
+		uint32_t g = 0;
+
+		for (uint16_t i = 0; i < n_bins; i++) {
+			if (as_command_bin_gather_size(&bins[i], put->gather_threshold) > 0) {
+				as_command_gather* gather = &put->gathers[g++];
+				p = as_command_write_bin_gather(p, AS_OPERATOR_WRITE, &bins[i], gather);
+				gather->offset = (uint32_t)(p - buf);
+			}
+			else {
+				p = as_command_write_bin(p, AS_OPERATOR_WRITE, &bins[i], buffers);
+			}
+		}
+		as_buffers_destroy(buffers);
+		return as_command_gather_write_end(buf, p, put->gather_size);
+	}
+
 	for (uint16_t i = 0; i < n_bins; i++) {
 		p = as_command_write_bin(p, AS_OPERATOR_WRITE, &bins[i], buffers);
 	}
@@ -569,6 +1661,19 @@ aerospike_key_put(
 	}
 	
 	as_cluster* cluster = as->cluster;
+
+	if (as_key_can_multiplex(policy->multiplex, NULL)) {
+		as_key_mux mux;
+		as_key_mux_init(&mux, err);
+
+		as_status status = aerospike_key_put_async(as, err, policy, key, rec,
+			as_key_mux_write_listener, &mux, NULL, NULL);
+
+		status = as_key_mux_wait(&mux, status, NULL);
+		as_key_cache_remove(cluster, key);
+		return status;
+	}
+
 	as_partition_info pi;
 	as_status status = as_key_partition_init(cluster, err, key, &pi);
 
@@ -576,12 +1681,11 @@ aerospike_key_put(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), rec->bins.size);
 
-	as_put put;
-	size_t size = as_put_init(&put, policy, key, rec, &buffers);
-
 	// Support new compress while still being compatible with old XDR compression_threshold.
 	uint32_t compression_threshold = policy->compression_threshold;
 
@@ -589,11 +1693,111 @@ aerospike_key_put(
 		compression_threshold = AS_COMPRESS_THRESHOLD;
 	}
 
+	// Gather writes send values from record memory, so they can not be combined with
+	// compression which requires the entire command in one buffer.
+	as_command_gather* gathers = NULL;
+
+	if (policy->gather_threshold > 0 && compression_threshold == 0) {
+		gathers = alloca(sizeof(as_command_gather) * rec->bins.size);
+	}
+
+	as_put put;
+	size_t size = as_put_init(&put, policy, key, rec, &buffers, gathers, policy->gather_threshold);
+
 	as_command cmd;
 	as_command_init_write(&cmd, cluster, &policy->base, policy->replica, size, &pi,
 						  as_command_parse_header, NULL);
 
-	status = as_command_send(&cmd, err, compression_threshold, as_put_write, &put);
+	if (put.n_gathers > 0) {
+		cmd.flags |= AS_COMMAND_FLAGS_GATHER;
+		cmd.gathers = gathers;
+		cmd.n_gathers = put.n_gathers;
+	}
+
+	status = as_command_send(&cmd, err, compression_threshold, key->set, as_put_write, &put);
+	as_key_cache_remove(cluster, key);
+	return status;
+}
+
+typedef struct as_put_many_s {
+	as_partition_info pi;
+	uint8_t* buf;
+	uint32_t index;
+} as_put_many;
+
+as_status
+aerospike_key_put_many(
+	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* keys,
+	uint32_t n_keys, as_record** records, uint32_t window, as_status* statuses
+	)
+{
+	if (! policy) {
+		policy = &as->config.policies.write;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_put_many* puts = cf_malloc(sizeof(as_put_many) * n_keys);
+	as_command* cmds = cf_malloc(sizeof(as_command) * n_keys);
+	uint32_t n_cmds = 0;
+	as_status status = AEROSPIKE_OK;
+	as_error e;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		const as_key* key = &keys[i];
+		as_put_many* pm = &puts[n_cmds];
+
+		statuses[i] = as_key_partition_init(cluster, &e, key, &pm->pi);
+
+		if (statuses[i] != AEROSPIKE_OK) {
+			if (status == AEROSPIKE_OK) {
+				as_error_copy(err, &e);
+				status = statuses[i];
+			}
+			continue;
+		}
+
+		as_key_cache_remove(cluster, key);
+
+		// Buffers are held until all commands complete, so they are not allocated on the stack.
+		as_record* rec = records[i];
+		as_queue buffers;
+		as_queue_init(&buffers, sizeof(as_buffer), rec->bins.size);
+
+		as_put put;
+		size_t size = as_put_init(&put, policy, key, rec, &buffers, NULL, 0);
+		pm->buf = cf_malloc(size);
+		size = as_put_write(&put, pm->buf);
+		pm->index = i;
+
+		as_command* cmd = &cmds[n_cmds++];
+		as_command_init_write(cmd, cluster, &policy->base, policy->replica, size, &pm->pi,
+			as_command_parse_header, NULL);
+		cmd->buf = pm->buf;
+		as_command_start_timer(cmd);
+	}
+
+	as_status* cmd_statuses = cf_malloc(sizeof(as_status) * (n_cmds + 1));
+	as_status rv = as_command_execute_pipeline(cmds, n_cmds, window, cmd_statuses, &e);
+
+	if (status == AEROSPIKE_OK && rv != AEROSPIKE_OK) {
+		as_error_copy(err, &e);
+		status = rv;
+	}
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_put_many* pm = &puts[i];
+		statuses[pm->index] = cmd_statuses[i];
+		as_key_cache_remove(cluster, &keys[pm->index]);
+		cf_free(pm->buf);
+	}
+
+	cf_free(cmd_statuses);
+	cf_free(cmds);
+	cf_free(puts);
+
+	if (status == AEROSPIKE_OK) {
+		as_error_reset(err);
+	}
 	return status;
 }
 
@@ -616,11 +1820,13 @@ aerospike_key_put_async_ex(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), rec->bins.size);
 
 	as_put put;
-	size_t size = as_put_init(&put, policy, key, rec, &buffers);
+	size_t size = as_put_init(&put, policy, key, rec, &buffers, NULL, 0);
 
 	// Support new compress while still being compatible with old XDR compression_threshold.
 	uint32_t compression_threshold = policy->compression_threshold;
@@ -629,7 +1835,8 @@ aerospike_key_put_async_ex(
 		compression_threshold = AS_COMPRESS_THRESHOLD;
 	}
 
-	if (compression_threshold == 0 || (size <= compression_threshold)) {
+	if (compression_threshold == 0 || (size <= compression_threshold) ||
+		! as_command_compress_use(cluster, pi.ns, key->set)) {
 		// Send uncompressed command.
 		as_event_command* cmd = as_async_write_command_create(
 				cluster, &policy->base, policy->replica, pi.ns, pi.partition, AS_ASYNC_FLAGS_MASTER,
@@ -665,6 +1872,7 @@ aerospike_key_put_async_ex(
 		as_command_buffer_free(buf, capacity);
 		
 		if (status == AEROSPIKE_OK) {
+			as_command_compress_add(cluster, pi.ns, key->set, size, comp_size);
 			cmd->write_len = (uint32_t)comp_size;
 
 			if (length != NULL) {
@@ -678,7 +1886,7 @@ aerospike_key_put_async_ex(
 			return as_event_command_execute(cmd, err);
 		}
 		else {
-			cf_free(cmd);
+			as_event_command_dealloc(cmd);
 			return status;
 		}
 	}
@@ -693,6 +1901,24 @@ aerospike_key_put_async(
 	return aerospike_key_put_async_ex(as, err, policy, key, rec, listener, udata, event_loop, pipe_listener, NULL, NULL);
 }
 
+as_status
+aerospike_key_put_group_async(
+	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* key, as_record* rec,
+	as_async_write_group* group, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	)
+{
+	as_async_write_group_begin(group);
+
+	as_status status = aerospike_key_put_async_ex(as, err, policy, key, rec,
+		as_async_write_group_complete, group, event_loop, pipe_listener, NULL, NULL);
+
+	if (status != AEROSPIKE_OK) {
+		// Listener will not be called.
+		as_async_write_group_complete(err, group, NULL);
+	}
+	return status;
+}
+
 /******************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -707,6 +1933,19 @@ aerospike_key_remove(
 	}
 	
 	as_cluster* cluster = as->cluster;
+
+	if (as_key_can_multiplex(policy->multiplex, NULL)) {
+		as_key_mux mux;
+		as_key_mux_init(&mux, err);
+
+		as_status status = aerospike_key_remove_async(as, err, policy, key,
+			as_key_mux_write_listener, &mux, NULL, NULL);
+
+		status = as_key_mux_wait(&mux, status, NULL);
+		as_key_cache_remove(cluster, key);
+		return status;
+	}
+
 	as_partition_info pi;
 	as_status status = as_key_partition_init(cluster, err, key, &pi);
 
@@ -714,6 +1953,8 @@ aerospike_key_remove(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	uint16_t n_fields;
 	size_t size = as_command_key_size(policy->key, key, &n_fields);
 	uint32_t filter_size = as_command_filter_size(&policy->base, &n_fields);
@@ -735,6 +1976,7 @@ aerospike_key_remove(
 	cmd.buf = buf;
 	as_command_start_timer(&cmd);
 	status = as_command_execute(&cmd, err);
+	as_key_cache_remove(cluster, key);
 
 	as_command_buffer_free(buf, size);
 	return status;
@@ -758,6 +2000,8 @@ aerospike_key_remove_async_ex(
 	if (status != AEROSPIKE_OK) {
 		return status;
 	}
+
+	as_key_cache_remove(cluster, key);
 	
 	uint16_t n_fields;
 	size_t size = as_command_key_size(policy->key, key, &n_fields);
@@ -793,6 +2037,24 @@ aerospike_key_remove_async(
 	return aerospike_key_remove_async_ex(as, err, policy, key, listener, udata, event_loop, pipe_listener, NULL);
 }
 
+as_status
+aerospike_key_remove_group_async(
+	aerospike* as, as_error* err, const as_policy_remove* policy, const as_key* key,
+	as_async_write_group* group, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	)
+{
+	as_async_write_group_begin(group);
+
+	as_status status = aerospike_key_remove_async_ex(as, err, policy, key,
+		as_async_write_group_complete, group, event_loop, pipe_listener, NULL);
+
+	if (status != AEROSPIKE_OK) {
+		// Listener will not be called.
+		as_async_write_group_complete(err, group, NULL);
+	}
+	return status;
+}
+
 /******************************************************************************
  * OPERATE
  *****************************************************************************/
@@ -935,6 +2197,23 @@ aerospike_key_operate(
 	}
 
 	as_cluster* cluster = as->cluster;
+	const as_policy_operate* mux_policy = policy ? policy : &as->config.policies.operate;
+
+	if (as_key_can_multiplex(mux_policy->multiplex, rec)) {
+		as_policy_operate p = *mux_policy;
+		p.async_heap_rec = true;
+
+		as_key_mux mux;
+		as_key_mux_init(&mux, err);
+
+		as_status status = aerospike_key_operate_async(as, err, &p, key, ops,
+			as_key_mux_record_listener, &mux, NULL, NULL);
+
+		status = as_key_mux_wait(&mux, status, rec);
+		as_key_cache_remove(cluster, key);
+		return status;
+	}
+
 	as_partition_info pi;
 	as_status status = as_key_partition_init(cluster, err, key, &pi);
 
@@ -942,6 +2221,8 @@ aerospike_key_operate(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), n_operations);
 
@@ -953,6 +2234,8 @@ aerospike_key_operate(
 	as_command_parse_result_data data;
 	data.record = rec;
 	data.deserialize = policy->deserialize;
+	data.lazy = false;
+	data.arena = false;
 
 	as_command cmd;
 
@@ -967,7 +2250,8 @@ aerospike_key_operate(
 
 	uint32_t compression_threshold = policy->base.compress ? AS_COMPRESS_THRESHOLD : 0;
 
-	status = as_command_send(&cmd, err, compression_threshold, as_operate_write, &oper);
+	status = as_command_send(&cmd, err, compression_threshold, key->set, as_operate_write, &oper);
+	as_key_cache_remove(cluster, key);
 
 	return status;
 }
@@ -993,6 +2277,8 @@ aerospike_key_operate_async(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	as_queue buffers;
 	as_queue_inita(&buffers, sizeof(as_buffer), n_operations);
 
@@ -1003,7 +2289,8 @@ aerospike_key_operate_async(
 
 	as_event_command* cmd;
 
-	if (! (policy->base.compress && size > AS_COMPRESS_THRESHOLD)) {
+	if (! (policy->base.compress && size > AS_COMPRESS_THRESHOLD &&
+		as_command_compress_use(cluster, pi.ns, key->set))) {
 		// Send uncompressed command.
 		if (oper.write_attr & AS_MSG_INFO2_WRITE) {
 			cmd = as_async_record_command_create(
@@ -1054,9 +2341,250 @@ aerospike_key_operate_async(
 		as_command_buffer_free(buf, capacity);
 
 		if (status != AEROSPIKE_OK) {
-			cf_free(cmd);
+			as_event_command_dealloc(cmd);
+			return status;
+		}
+		as_command_compress_add(cluster, pi.ns, key->set, size, comp_size);
+
+		cmd->write_len = (uint32_t)comp_size;
+	}
+	return as_event_command_execute(cmd, err);
+}
+
+/******************************************************************************
+ * PREPARED OPERATE
+ *****************************************************************************/
+
+typedef struct as_operate_prepared_s {
+	const as_prepared_operate* prep;
+	const as_key* key;
+	uint32_t ttl;
+	uint16_t gen;
+	uint16_t n_fields;
+} as_operate_prepared;
+
+static size_t
+as_operate_prepared_init(
+	as_operate_prepared* oper, const as_prepared_operate* prep, const as_key* key, uint32_t ttl,
+	uint16_t gen
+	)
+{
+	oper->prep = prep;
+	oper->key = key;
+	oper->ttl = ttl;
+	oper->gen = gen;
+
+	size_t size = as_command_key_size(prep->policy.key, key, &oper->n_fields);
+	oper->n_fields += prep->n_fields;
+	return size + prep->size;
+}
+
+static size_t
+as_operate_prepared_write(void* udata, uint8_t* buf)
+{
+	as_operate_prepared* oper = udata;
+	const as_prepared_operate* prep = oper->prep;
+	const as_policy_operate* policy = &prep->policy;
+
+	uint8_t* p = as_command_write_header_write(buf, &policy->base, policy->commit_level,
+		policy->exists, policy->gen, oper->gen, oper->ttl, oper->n_fields, prep->n_operations,
+		policy->durable_delete, prep->read_attr, prep->write_attr, prep->info_attr);
+
+	p = as_command_write_key(p, policy->key, oper->key);
+
+	// Filter expression field follows key fields, so the prepared tail can be copied as is.
+	memcpy(p, prep->buf, prep->size);
+	p += prep->size;
+	return as_command_write_end(buf, p);
+}
+
+as_status
+as_prepared_operate_init(
+	aerospike* as, as_error* err, as_prepared_operate* prep, const as_policy_operate* policy,
+	const as_operations* ops
+	)
+{
+	uint32_t n_operations = ops->binops.size;
+
+	if (n_operations == 0) {
+		as_error_reset(err);
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "No operations defined");
+	}
+
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), n_operations);
+
+	size_t size = as_operate_set_attr(ops, &buffers, &prep->read_attr, &prep->write_attr);
+	prep->info_attr = 0;
+
+	if (policy) {
+		as_policy_operate_copy(policy, &prep->policy);
+	}
+	else {
+		as_policy_operate_copy(&as->config.policies.operate, &prep->policy);
+
+		if (! (prep->write_attr & AS_MSG_INFO2_WRITE)) {
+			// Read operations should retry by default.
+			prep->policy.base.max_retries = 2;
+		}
+	}
+
+	policy = &prep->policy;
+
+	as_command_set_attr_read(policy->read_mode_ap, policy->read_mode_sc, policy->base.compress,
+							 &prep->read_attr, &prep->info_attr);
+
+	prep->n_fields = 0;
+	uint32_t filter_size = as_command_filter_size(&policy->base, &prep->n_fields);
+	size += filter_size;
+
+	prep->buf = cf_malloc(size);
+	prep->n_operations = (uint16_t)n_operations;
+
+	uint8_t* p = as_command_write_filter(&policy->base, filter_size, prep->buf);
+
+	for (uint32_t i = 0; i < n_operations; i++) {
+		as_binop* op = &ops->binops.entries[i];
+		p = as_command_write_bin(p, op->op, &op->bin, &buffers);
+	}
+	as_buffers_destroy(&buffers);
+
+	prep->size = (uint32_t)(p - prep->buf);
+
+	// The expression has been serialized, so do not reference caller's filter.
+	prep->policy.base.filter_exp = NULL;
+	return AEROSPIKE_OK;
+}
+
+void
+as_prepared_operate_destroy(as_prepared_operate* prep)
+{
+	cf_free(prep->buf);
+	prep->buf = NULL;
+	prep->size = 0;
+}
+
+as_status
+aerospike_key_operate_prepared(
+	aerospike* as, as_error* err, const as_prepared_operate* prep, const as_key* key,
+	uint32_t ttl, uint16_t gen, as_record** rec
+	)
+{
+	as_cluster* cluster = as->cluster;
+	as_partition_info pi;
+	as_status status = as_key_partition_init(cluster, err, key, &pi);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_key_cache_remove(cluster, key);
+
+	const as_policy_operate* policy = &prep->policy;
+	as_operate_prepared oper;
+	size_t size = as_operate_prepared_init(&oper, prep, key, ttl, gen);
+
+	as_command_parse_result_data data;
+	data.record = rec;
+	data.deserialize = policy->deserialize;
+	data.lazy = false;
+	data.arena = false;
+
+	as_command cmd;
+
+	if (prep->write_attr & AS_MSG_INFO2_WRITE) {
+		as_command_init_write(&cmd, cluster, &policy->base, policy->replica, size, &pi,
+							  as_command_parse_result, &data);
+	}
+	else {
+		as_command_init_read(&cmd, cluster, &policy->base, policy->replica, policy->read_mode_sc,
+							 size, &pi, as_command_parse_result, &data);
+	}
+
+	uint32_t compression_threshold = policy->base.compress ? AS_COMPRESS_THRESHOLD : 0;
+
+	status = as_command_send(&cmd, err, compression_threshold, key->set, as_operate_prepared_write,
+		&oper);
+	as_key_cache_remove(cluster, key);
+	return status;
+}
+
+static inline as_event_command*
+as_operate_prepared_command_create(
+	aerospike* as, const as_prepared_operate* prep, as_partition_info* pi,
+	as_async_record_listener listener, void* udata, as_event_loop* event_loop,
+	as_pipe_listener pipe_listener, size_t size
+	)
+{
+	const as_policy_operate* policy = &prep->policy;
+
+	if (prep->write_attr & AS_MSG_INFO2_WRITE) {
+		return as_async_record_command_create(
+			as->cluster, &policy->base, policy->replica, pi->ns, pi->partition, policy->deserialize,
+			policy->async_heap_rec, AS_ASYNC_FLAGS_MASTER, listener, udata, event_loop,
+			pipe_listener, size, as_event_command_parse_result);
+	}
+
+	as_read_info ri;
+	as_event_command_init_read(policy->replica, policy->read_mode_sc, pi->sc_mode, &ri);
+
+	return as_async_record_command_create(
+		as->cluster, &policy->base, ri.replica, pi->ns, pi->partition, policy->deserialize,
+		policy->async_heap_rec, ri.flags, listener, udata, event_loop, pipe_listener, size,
+		as_event_command_parse_result);
+}
+
+as_status
+aerospike_key_operate_prepared_async(
+	aerospike* as, as_error* err, const as_prepared_operate* prep, const as_key* key,
+	uint32_t ttl, uint16_t gen, as_async_record_listener listener, void* udata,
+	as_event_loop* event_loop, as_pipe_listener pipe_listener
+	)
+{
+	as_cluster* cluster = as->cluster;
+	as_partition_info pi;
+	as_status status = as_key_partition_init(cluster, err, key, &pi);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_key_cache_remove(cluster, key);
+
+	const as_policy_operate* policy = &prep->policy;
+	as_operate_prepared oper;
+	size_t size = as_operate_prepared_init(&oper, prep, key, ttl, gen);
+
+	as_event_command* cmd;
+
+	if (! (policy->base.compress && size > AS_COMPRESS_THRESHOLD &&
+		as_command_compress_use(cluster, pi.ns, key->set))) {
+		// Send uncompressed command.
+		cmd = as_operate_prepared_command_create(as, prep, &pi, listener, udata, event_loop,
+			pipe_listener, size);
+		cmd->write_len = (uint32_t)as_operate_prepared_write(&oper, cmd->buf);
+	}
+	else {
+		// Send compressed command.
+		// First write uncompressed buffer.
+		size_t capacity = size;
+		uint8_t* buf = as_command_buffer_init(capacity);
+		size = as_operate_prepared_write(&oper, buf);
+
+		// Allocate command with compressed upper bound.
+		size_t comp_size = as_command_compress_max_size(size);
+		cmd = as_operate_prepared_command_create(as, prep, &pi, listener, udata, event_loop,
+			pipe_listener, comp_size);
+
+		// Compress buffer and execute.
+		status = as_command_compress(err, buf, size, cmd->buf, &comp_size);
+		as_command_buffer_free(buf, capacity);
+
+		if (status != AEROSPIKE_OK) {
+			as_event_command_dealloc(cmd);
 			return status;
 		}
+		as_command_compress_add(cluster, pi.ns, key->set, size, comp_size);
 
 		cmd->write_len = (uint32_t)comp_size;
 	}
@@ -1145,6 +2673,8 @@ aerospike_key_apply(
 		return status;
 	}
 
+	as_key_cache_remove(cluster, key);
+
 	as_apply ap;
 	size_t size = as_apply_init(&ap, policy, key, module, function, arglist);
 
@@ -1154,7 +2684,8 @@ aerospike_key_apply(
 
 	uint32_t compression_threshold = policy->base.compress ? AS_COMPRESS_THRESHOLD : 0;
 
-	status = as_command_send(&cmd, err, compression_threshold, as_apply_write, &ap);
+	status = as_command_send(&cmd, err, compression_threshold, key->set, as_apply_write, &ap);
+	as_key_cache_remove(cluster, key);
 
 	as_buffer_destroy(&ap.args);
 	as_serializer_destroy(&ap.ser);
@@ -1180,11 +2711,14 @@ aerospike_key_apply_async(
 	if (status != AEROSPIKE_OK) {
 		return status;
 	}
+
+	as_key_cache_remove(cluster, key);
 	
 	as_apply ap;
 	size_t size = as_apply_init(&ap, policy, key, module, function, arglist);
 
-	if (! (policy->base.compress && size > AS_COMPRESS_THRESHOLD)) {
+	if (! (policy->base.compress && size > AS_COMPRESS_THRESHOLD &&
+		as_command_compress_use(cluster, pi.ns, key->set))) {
 		// Send uncompressed command.
 		as_event_command* cmd = as_async_value_command_create(cluster, &policy->base,
 			policy->replica, pi.ns, pi.partition, AS_ASYNC_FLAGS_MASTER, listener, udata,
@@ -1218,11 +2752,19 @@ aerospike_key_apply_async(
 		as_command_buffer_free(buf, capacity);
 
 		if (status != AEROSPIKE_OK) {
-			cf_free(cmd);
+			as_event_command_dealloc(cmd);
 			return status;
 		}
+		as_command_compress_add(cluster, pi.ns, key->set, size, comp_size);
 
 		cmd->write_len = (uint32_t)comp_size;
 		return as_event_command_execute(cmd, err);
 	}
 }
+
+as_status
+aerospike_namespace_id(aerospike* as, as_error* err, const char* ns, uint32_t* ns_id)
+{
+	as_error_reset(err);
+	return as_partition_namespace_id(as->cluster, err, ns, ns_id);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike_partition.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_shm_cluster.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline as_node*
+as_route_reserve(as_node* node)
+{
+	// Make volatile reference so changes to tend thread will be reflected in this thread.
+	if (node && as_load_uint8(&node->active)) {
+		as_node_reserve(node);
+		return node;
+	}
+	return NULL;
+}
+
+static inline as_node*
+as_route_shm_reserve(as_node** local_nodes, uint32_t node_index)
+{
+	// node_index starts at one (zero indicates unset).
+	if (node_index == 0) {
+		return NULL;
+	}
+	return as_route_reserve((as_node*)as_load_ptr(&local_nodes[node_index - 1]));
+}
+
+static as_status
+as_route_table_not_found(as_cluster* cluster, as_error* err, const char* ns)
+{
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+	as_nodes_release(nodes);
+
+	if (n_nodes == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Cluster is empty");
+	}
+	return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid namespace: %s", ns);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+uint32_t
+aerospike_partition_generation(aerospike* as)
+{
+	as_cluster* cluster = as->cluster;
+
+	if (cluster->shm_info) {
+		return as_load_uint32(&cluster->shm_info->cluster_shm->partition_gen);
+	}
+	return as_load_uint32(&cluster->partition_gen);
+}
+
+as_status
+aerospike_partition_routes(
+	aerospike* as, as_error* err, const char* ns, const as_digest_value* digests,
+	uint32_t n_digests, as_partition_route* routes, uint32_t* generation
+	)
+{
+	as_error_reset(err);
+
+	as_cluster* cluster = as->cluster;
+
+	// Read generation first, so a concurrent map change is detected on the next check.
+	if (generation) {
+		*generation = aerospike_partition_generation(as);
+	}
+
+	if (cluster->shm_info) {
+		as_cluster_shm* cluster_shm = cluster->shm_info->cluster_shm;
+		as_node** local_nodes = cluster->shm_info->local_nodes;
+		as_partition_table_shm* table = as_shm_find_partition_table_id(cluster_shm, 0, ns);
+
+		if (! table) {
+			return as_route_table_not_found(cluster, err, ns);
+		}
+
+		uint32_t n_partitions = cluster_shm->n_partitions;
+
+		for (uint32_t i = 0; i < n_digests; i++) {
+			as_partition_route* route = &routes[i];
+			route->partition_id = as_partition_getid(digests[i], n_partitions);
+
+			uint32_t master;
+			uint32_t prole;
+			as_partition_shm_read(&table->partitions[route->partition_id], &master, &prole);
+			route->master = as_route_shm_reserve(local_nodes, master);
+			route->replica = as_route_shm_reserve(local_nodes, prole);
+		}
+	}
+	else {
+		as_partition_table* table = as_partition_tables_get(&cluster->partition_tables, ns);
+
+		if (! table) {
+			return as_route_table_not_found(cluster, err, ns);
+		}
+
+		uint32_t n_partitions = cluster->n_partitions;
+
+		for (uint32_t i = 0; i < n_digests; i++) {
+			as_partition_route* route = &routes[i];
+			route->partition_id = as_partition_getid(digests[i], n_partitions);
+
+			as_partition* p = &table->partitions[route->partition_id];
+			route->master = as_route_reserve((as_node*)as_load_ptr(&p->master));
+			route->replica = as_route_reserve((as_node*)as_load_ptr(&p->prole));
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+void
+as_partition_routes_release(as_partition_route* routes, uint32_t n_routes)
+{
+	for (uint32_t i = 0; i < n_routes; i++) {
+		as_partition_route* route = &routes[i];
+
+		if (route->master) {
+			as_node_release(route->master);
+		}
+
+		if (route->replica) {
+			as_node_release(route->replica);
+		}
+	}
+}
@@ -17,17 +17,21 @@
 #include <aerospike/aerospike_query.h>
 #include <aerospike/aerospike_scan.h>
 #include <aerospike/as_aerospike.h>
+#include <aerospike/as_aggregate.h>
 #include <aerospike/as_async.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_exp.h>
+#include <aerospike/as_geo_region.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_lua_pool.h>
 #include <aerospike/as_module.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_partition_tracker.h>
 #include <aerospike/as_policy.h>
+#include <aerospike/as_record_pipeline.h>
 #include <aerospike/as_query.h>
 #include <aerospike/as_query_validate.h>
 #include <aerospike/as_random.h>
@@ -47,11 +51,28 @@
 #define QUERY_FOREGROUND 1
 #define QUERY_BACKGROUND 2
 
+// Aggregate values queued per partial reducer before node threads block.
+#define QUERY_REDUCE_QUEUE_MAX 5000
+
+// Partial results merged by each reducer in the merge tree.
+#define QUERY_REDUCE_FAN_IN 4
+
+// Aggregate values handed to the aggregation stream at once by each node thread.
+#define QUERY_AGGR_BATCH_MAX 256
+
 typedef struct as_query_user_callback_s {
 	aerospike_query_foreach_callback callback;
 	void* udata;
 } as_query_user_callback;
 
+// Aggregate values queued as one item.  A NULL batch marks the end of the stream.
+typedef struct as_query_batch_s {
+	uint32_t size;
+	as_val* vals[];
+} as_query_batch;
+
+typedef as_stream_status (*as_query_batch_fn)(as_query_batch* batch, void* udata);
+
 typedef struct as_query_task_s {
 	as_node* node;
 	as_node_partitions* np;
@@ -62,18 +83,23 @@ typedef struct as_query_task_s {
 	const as_policy_write* write_policy;
 	const as_query* query;
 	aerospike_query_foreach_callback callback;
+	aerospike_query_foreach_raw_callback raw_callback;
+	as_query_batch_fn batch_callback;
+	as_query_batch* batch;
 	void* udata;
 	as_error* err;
 	uint32_t* error_mutex;
 	cf_queue* input_queue;
 	cf_queue* complete_q;
+	as_record_pipeline* pipeline;
+	as_record_reuse* reuse;
 	uint64_t task_id;
 	uint64_t cluster_key;
+	uint32_t chunk_size;
 
 	uint8_t* cmd;
 	size_t cmd_size;
 	uint8_t query_type;
-	bool first;
 } as_query_task;
 
 typedef struct as_query_task_aggr_s {
@@ -85,6 +111,47 @@ typedef struct as_query_task_aggr_s {
 	cf_queue* complete_q;
 } as_query_task_aggr;
 
+typedef struct as_query_input_s {
+	cf_queue* queue;
+	as_query_batch* batch; // Owned by the reader.
+	uint32_t offset;
+} as_query_input;
+
+typedef struct as_query_reducer_s {
+	as_stream input;
+	as_stream partial;
+	as_stream* output;
+	const as_query* query;
+	uint32_t* error_mutex;
+	as_error* err;
+	cf_queue* queue;
+	cf_queue* partials;
+	as_query_batch* batch; // Owned by the reducer thread.
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	uint32_t capacity;
+	uint32_t queued;
+	uint32_t offset;
+	as_status status;
+	bool closed;
+} as_query_reducer;
+
+typedef struct as_query_native_aggr_s {
+	as_aggregate_merge_fn merge;
+	void* udata;
+	as_val* result;
+	pthread_mutex_t lock;
+	bool failed;
+} as_query_native_aggr;
+
+typedef struct as_query_reducers_s {
+	as_stream input;
+	as_query_reducer* array;
+	uint32_t size;
+	uint32_t next;
+} as_query_reducers;
+
 typedef struct as_query_complete_task_s {
 	as_node* node;
 	uint64_t task_id;
@@ -103,7 +170,9 @@ typedef struct as_async_query_executor {
 	uint32_t task_id_offset;
 	uint32_t info_timeout;
 	uint16_t n_fields;
+	uint8_t priority;
 	bool deserialize;
+	bool zero_copy;
 	bool has_where;
 } as_async_query_executor;
 
@@ -165,6 +234,44 @@ static const as_aerospike_hooks query_aerospike_hooks = {
 	.log = as_query_aerospike_log,
 };
 
+static inline as_query_batch*
+as_query_batch_create(uint32_t capacity)
+{
+	as_query_batch* batch = cf_malloc(sizeof(as_query_batch) + sizeof(as_val*) * capacity);
+	batch->size = 0;
+	return batch;
+}
+
+static void
+as_query_batch_destroy(as_query_batch* batch, uint32_t offset)
+{
+	for (uint32_t i = offset; i < batch->size; i++) {
+		as_val_destroy(batch->vals[i]);
+	}
+	cf_free(batch);
+}
+
+static inline as_query_batch*
+as_query_batch_single(as_val* val)
+{
+	if (! val) {
+		return NULL;
+	}
+
+	as_query_batch* batch = as_query_batch_create(1);
+	batch->vals[batch->size++] = val;
+	return batch;
+}
+
+static bool
+as_query_batch_flush(as_query_task* task)
+{
+	// The batch callback takes ownership, even on failure.
+	as_query_batch* batch = task->batch;
+	task->batch = NULL;
+	return task->batch_callback(batch, task->udata) == AS_STREAM_OK;
+}
+
 // This is a no-op. the queue and its contents are destroyed at end of aerospike_query_foreach().
 static int
 as_input_stream_destroy(as_stream *s)
@@ -175,20 +282,45 @@ as_input_stream_destroy(as_stream *s)
 static as_val*
 as_input_stream_read(const as_stream* s)
 {
-	as_val* val = NULL;
-	cf_queue_pop(as_stream_source(s), &val, CF_QUEUE_FOREVER);
-	return val;
+	// Only take the queue when the current batch is exhausted.
+	as_query_input* input = as_stream_source(s);
+
+	while (! input->batch || input->offset == input->batch->size) {
+		if (input->batch) {
+			cf_free(input->batch);
+			input->batch = NULL;
+		}
+
+		cf_queue_pop(input->queue, &input->batch, CF_QUEUE_FOREVER);
+		input->offset = 0;
+
+		if (! input->batch) {
+			return NULL;
+		}
+	}
+	return input->batch->vals[input->offset++];
+}
+
+static as_stream_status
+as_input_batch_write(as_query_batch* batch, void* udata)
+{
+	as_query_input* input = as_stream_source((as_stream*)udata);
+
+	if (cf_queue_push(input->queue, &batch) != CF_QUEUE_OK) {
+		as_log_error("Write to client side stream failed.");
+
+		if (batch) {
+			as_query_batch_destroy(batch, 0);
+		}
+		return AS_STREAM_ERR;
+	}
+	return AS_STREAM_OK;
 }
 
 static as_stream_status
 as_input_stream_write(const as_stream* s, as_val* val)
 {
-    if (cf_queue_push(as_stream_source(s), &val) != CF_QUEUE_OK) {
-        as_log_error("Write to client side stream failed.");
-        as_val_destroy(val);
-        return AS_STREAM_ERR;
-    }
-    return AS_STREAM_OK;
+	return as_input_batch_write(as_query_batch_single(val), (void*)s);
 }
 
 static const as_stream_hooks input_stream_hooks = {
@@ -318,7 +450,8 @@ as_query_parse_record_async(
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key, &bval);
 
 	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops,
-		qc->command.flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
+		qc->command.flags2 & AS_ASYNC_FLAGS2_DESERIALIZE,
+		qc->command.flags2 & AS_ASYNC_FLAGS2_ZERO_COPY);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -333,6 +466,8 @@ as_query_parse_record_async(
 		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT_ABORT, "");
 	}
 
+	as_event_flow_record(&qe->executor);
+
 	if (qc->np) {
 		as_partition_tracker_set_last(qe->pt, qc->np, &rec.key.digest, bval,
 			qc->command.cluster->n_partitions);
@@ -392,6 +527,10 @@ as_query_parse_records_async(as_event_command* cmd)
 			return true;
 		}
 
+		if (as_event_executor_cancelled(&qe->executor)) {
+			as_async_cancel_executor(&qe->executor);
+		}
+
 		if (! qe->executor.valid) {
 			as_error_set_message(&err, AEROSPIKE_ERR_CLIENT_ABORT, "");
 			as_event_response_error(cmd, &err);
@@ -403,13 +542,56 @@ as_query_parse_records_async(as_event_command* cmd)
 			return true;
 		}
 	}
+	as_event_flow_check(cmd, &qe->executor);
 	return false;
 }
 
+static as_status
+as_query_parse_record_raw(uint8_t** pp, as_msg* msg, as_query_task* task)
+{
+	// Bins stay in the response buffer, so nothing is allocated per record.
+	as_record_raw rec;
+	uint64_t bval = 0;
+	*pp = as_command_parse_record_raw(*pp, msg, &rec, &bval);
+
+	if (! task->raw_callback(&rec, task->udata)) {
+		return AEROSPIKE_ERR_CLIENT_ABORT;
+	}
+
+	if (task->pt) {
+		as_partition_tracker_set_last(task->pt, task->np, &rec.digest, bval,
+			task->cluster->n_partitions);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_query_parse_record_reuse(uint8_t** pp, as_msg* msg, as_query_task* task, as_error* err)
+{
+	as_record* rec = &task->reuse->rec;
+	uint64_t bval = 0;
+	as_status status = as_command_parse_record_reuse(pp, err, msg, task->reuse,
+		task->query_policy->deserialize, &bval);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (task->callback && ! task->callback((as_val*)rec, task->udata)) {
+		return AEROSPIKE_ERR_CLIENT_ABORT;
+	}
+
+	if (task->pt) {
+		as_partition_tracker_set_last(task->pt, task->np, &rec->key.digest, bval,
+			task->cluster->n_partitions);
+	}
+	return AEROSPIKE_OK;
+}
+
 static as_status
 as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error* err)
 {
-	if (task->input_queue) {
+	if (task->query_type == QUERY_FOREGROUND && task->query->apply.function[0]) {
 		// Parse aggregate return values.
 		as_val* val = 0;
 		as_status status = as_command_parse_success_failure_bins(pp, err, msg, &val);
@@ -418,7 +600,17 @@ as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error*
 			return status;
 		}
 		
-		if (task->callback) {
+		if (task->batch_callback) {
+			if (! task->batch) {
+				task->batch = as_query_batch_create(QUERY_AGGR_BATCH_MAX);
+			}
+			task->batch->vals[task->batch->size++] = val;
+
+			if (task->batch->size == QUERY_AGGR_BATCH_MAX && ! as_query_batch_flush(task)) {
+				return AEROSPIKE_ERR_CLIENT_ABORT;
+			}
+		}
+		else if (task->callback) {
 			bool rv = task->callback(val, task->udata);
 
 			if (! rv) {
@@ -438,6 +630,14 @@ as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error*
 										"Server does not support background query with operations");
 		}
 
+		if (task->raw_callback) {
+			return as_query_parse_record_raw(pp, msg, task);
+		}
+
+		if (task->reuse) {
+			return as_query_parse_record_reuse(pp, msg, task, err);
+		}
+
 		// Parse normal record values.
 		as_record rec;
 		as_record_inita(&rec, msg->n_ops);
@@ -448,7 +648,8 @@ as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error*
 		uint64_t bval = 0;
 		*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key, &bval);
 
-		as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->query_policy->deserialize);
+		as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops,
+			task->query_policy->deserialize, task->query_policy->zero_copy);
 
 		if (status != AEROSPIKE_OK) {
 			as_record_destroy(&rec);
@@ -474,17 +675,94 @@ as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error*
 }
 
 static as_status
-as_query_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+as_query_parse_record_pipeline(void* udata, as_msg* msg, uint8_t* p, as_error* err)
+{
+	// Parse task does not reference the partition tracker. The socket reader thread
+	// already recorded the record digest.
+	return as_query_parse_record(&p, msg, udata, err);
+}
+
+static as_status
+as_query_parse_records_pipeline(as_error* err, as_query_task* task, uint8_t* buf, size_t size)
+{
+	as_record_pipeline* pl = task->pipeline;
+	as_record_pipeline_block* block = as_record_pipeline_copy(pl, buf, size);
+	uint32_t n_partitions = task->cluster->n_partitions;
+	as_msg_index index;
+	as_status status = as_msg_index_build(err, &index, block->buf, size);
+
+	for (uint32_t i = 0; status == AEROSPIKE_OK && i < index.size; i++) {
+		as_msg* msg = index.msgs[i];
+		uint8_t* p = msg->data;
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			if (msg->result_code != AEROSPIKE_OK) {
+				// The server returned a fatal error.
+				status = as_error_set_message(err, msg->result_code,
+											  as_error_string(msg->result_code));
+			}
+			else {
+				status = AEROSPIKE_NO_MORE_RECORDS;
+			}
+			break;
+		}
+
+		if (task->pt) {
+			if (msg->info3 & AS_MSG_INFO3_PARTITION_DONE) {
+				if (msg->result_code != AEROSPIKE_OK) {
+					as_partition_tracker_part_unavailable(task->pt, task->np, msg->generation);
+				}
+				continue;
+			}
+		}
+
+		if (msg->result_code != AEROSPIKE_OK) {
+			if (msg->result_code == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+				// Non-fatal error.
+				status = AEROSPIKE_NO_MORE_RECORDS;
+			}
+			else {
+				status = as_error_set_message(err, msg->result_code,
+											  as_error_string(msg->result_code));
+			}
+			break;
+		}
+
+		// Only find record boundary and digest here. Bins are parsed in the parse thread.
+		as_digest digest;
+		uint64_t bval = 0;
+		as_command_parse_digest(p, msg->n_fields, &digest, &bval);
+
+		if (task->pt) {
+			as_partition_tracker_set_last(task->pt, task->np, &digest, bval, n_partitions);
+		}
+
+		as_record_pipeline_push(pl, block, msg, as_partition_getid(digest.value, n_partitions));
+
+		if (as_record_pipeline_failed(pl)) {
+			status = as_record_pipeline_status(pl, err);
+			break;
+		}
+
+		if (as_load_uint32(task->error_mutex)) {
+			err->code = AEROSPIKE_ERR_QUERY_ABORTED;
+			status = err->code;
+			break;
+		}
+	}
+	as_msg_index_destroy(&index);
+	as_record_pipeline_release(pl, block);
+	return status;
+}
+
+static as_status
+as_query_parse_index(as_error* err, as_query_task* task, as_msg_index* index)
 {
-	as_query_task* task = cmd->udata;
-	uint8_t* p = buf;
-	uint8_t* end = buf + size;
 	as_status status;
 
-	while (p < end) {
-		as_msg* msg = (as_msg*)p;
-		as_msg_swap_header_from_be(msg);
-		p += sizeof(as_msg);
+	for (uint32_t i = 0; i < index->size; i++) {
+		as_msg* msg = index->msgs[i];
+		uint8_t* p = msg->data;
 
 		if (msg->info3 & AS_MSG_INFO3_LAST) {
 			if (msg->result_code != AEROSPIKE_OK) {
@@ -530,6 +808,38 @@ as_query_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* b
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_query_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+{
+	as_query_task* task = cmd->udata;
+
+	if (task->pipeline) {
+		return as_query_parse_records_pipeline(err, task, buf, size);
+	}
+
+	as_msg_index index;
+	as_status status = as_msg_index_build(err, &index, buf, size);
+
+	if (status == AEROSPIKE_OK) {
+		status = as_query_parse_index(err, task, &index);
+	}
+	as_msg_index_destroy(&index);
+
+	if (task->batch) {
+		// Hand aggregate values parsed from this response to the stream.
+		if (status == AEROSPIKE_OK || status == AEROSPIKE_NO_MORE_RECORDS) {
+			if (! as_query_batch_flush(task)) {
+				status = AEROSPIKE_ERR_CLIENT_ABORT;
+			}
+		}
+		else {
+			as_query_batch_destroy(task->batch, 0);
+			task->batch = NULL;
+		}
+	}
+	return status;
+}
+
 static uint8_t*
 as_query_write_range_string(uint8_t* p, char* begin, char* end)
 {
@@ -685,6 +995,9 @@ as_query_command_size(
 					filter_size += (uint32_t)strlen(pred->value.string) * 2;
 				}
 				break;
+			case AS_PREDICATE_GEO_REGION:
+				filter_size += pred->value.geo_region->len * 2;
+				break;
 		}
 		size += filter_size;
 		n_fields++;
@@ -883,6 +1196,12 @@ as_query_command_init(
 					p = as_query_write_range_geojson(p, pred->value.string, pred->value.string);
 				}
 				break;
+			case AS_PREDICATE_GEO_REGION: {
+				as_geo_region* region = pred->value.geo_region;
+				memcpy(p, region->range, region->range_size);
+				p += region->range_size;
+				break;
+			}
 		}
 
 		if (! qb->is_new) {
@@ -984,6 +1303,25 @@ as_query_command_init(
 	return as_command_write_end(cmd, p);
 }
 
+static as_status
+as_query_command_run(as_query_task* task, as_command* cmd, as_error* err)
+{
+	as_record_reuse reuse;
+
+	if (task->query_policy && task->query_policy->reuse_record && ! task->pipeline) {
+		as_record_reuse_init(&reuse);
+		task->reuse = &reuse;
+	}
+
+	as_status status = as_command_execute(cmd, err);
+
+	if (task->reuse) {
+		as_record_reuse_destroy(task->reuse);
+		task->reuse = NULL;
+	}
+	return status;
+}
+
 static as_status
 as_query_command_execute_old(as_query_task* task)
 {
@@ -992,19 +1330,6 @@ as_query_command_execute_old(as_query_task* task)
 
 	as_status status;
 
-	if (task->cluster_key && ! task->first) {
-		uint32_t timeout = task->query_policy? task->query_policy->info_timeout : 10000;
-		status = as_query_validate(&err, task->node, task->query->ns, timeout, task->cluster_key);
-
-		if (status) {
-			// Set main error only once.
-			if (as_fas_uint32(task->error_mutex, 1) == 0) {
-				as_error_copy(task->err, &err);
-			}
-			return status;
-		}
-	}
-
 	const as_policy_base* policy;
 	uint8_t flags;
 
@@ -1029,14 +1354,14 @@ as_query_command_execute_old(as_query_task* task)
 	cmd.buf_size = task->cmd_size;
 	cmd.partition_id = 0; // Not referenced when node set.
 	cmd.replica = AS_POLICY_REPLICA_MASTER;
-	cmd.flags = flags;
+	cmd.flags = flags | AS_COMMAND_FLAGS_QUERY;
 
 	as_command_start_timer(&cmd);
 
 	// Individual query node commands must not retry.
 	cmd.max_retries = 0;
 
-	status = as_command_execute(&cmd, &err);
+	status = as_query_command_run(task, &cmd, &err);
 
 	if (status) {
 		// Set main error only once.
@@ -1115,14 +1440,14 @@ as_query_command_execute_new(as_query_task* task)
 	cmd.buf_size = size;
 	cmd.partition_id = 0; // Not referenced when node set.
 	cmd.replica = AS_POLICY_REPLICA_MASTER;
-	cmd.flags = flags;
+	cmd.flags = flags | AS_COMMAND_FLAGS_QUERY;
 
 	as_command_start_timer(&cmd);
 
 	// Individual query node commands must not retry.
 	cmd.max_retries = 0;
 
-	as_status status = as_command_execute(&cmd, &err);
+	as_status status = as_query_command_run(task, &cmd, &err);
 
 	// Free command memory.
 	as_command_buffer_free(buf, size);
@@ -1143,6 +1468,42 @@ as_query_command_execute_new(as_query_task* task)
 	return status;
 }
 
+static as_status
+as_query_command_execute_chunks(as_query_task* task)
+{
+	as_node_partitions* np = task->np;
+	as_node_partitions chunk;
+	as_partition_tracker_chunk_init(task->pt, &chunk, np);
+
+	as_status status = AEROSPIKE_OK;
+
+	while (as_partition_tracker_next_chunk(task->pt, task->cluster, task->query->ns, np, &chunk,
+		task->chunk_size)) {
+		task->np = &chunk;
+		status = as_query_command_execute_new(task);
+		task->np = np;
+		as_partition_tracker_chunk_done(task->pt, np, &chunk);
+
+		if (status != AEROSPIKE_OK || as_load_uint32(task->error_mutex)) {
+			break;
+		}
+	}
+	as_partition_tracker_chunk_destroy(&chunk);
+	return status;
+}
+
+static inline void
+as_query_wait_task(cf_queue* complete_q, as_task_caller* caller, as_status* status)
+{
+	as_query_complete_task complete;
+	cf_queue_pop(complete_q, &complete, CF_QUEUE_FOREVER);
+	as_task_caller_complete(caller);
+
+	if (complete.result != AEROSPIKE_OK && *status == AEROSPIKE_OK) {
+		*status = complete.result;
+	}
+}
+
 static void
 as_query_worker_old(void* data)
 {
@@ -1172,7 +1533,8 @@ as_query_worker_new(void* data)
 	complete_task.task_id = task->task_id;
 
 	if (as_load_uint32(task->error_mutex) == 0) {
-		complete_task.result = as_query_command_execute_new(task);
+		complete_task.result = task->chunk_size > 0 ?
+			as_query_command_execute_chunks(task) : as_query_command_execute_new(task);
 	}
 	else {
 		complete_task.result = AEROSPIKE_ERR_QUERY_ABORTED;
@@ -1187,8 +1549,9 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 	as_status status = AEROSPIKE_OK;
 
 	if (task->query_policy && task->query_policy->fail_on_cluster_change) {
-		status = as_query_validate_begin(task->err, nodes->array[0], query->ns,
-										 task->query_policy->info_timeout, &task->cluster_key);
+		// Validate all nodes at once, so node tasks do not need to validate before they start.
+		status = as_query_validate_begin_nodes(task->err, nodes, query->ns,
+			task->query_policy->info_timeout, &task->cluster_key);
 
 		if (status) {
 			return status;
@@ -1219,8 +1582,9 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 	task->cmd_size = size;
 	task->complete_q = cf_queue_create(sizeof(as_query_complete_task), true);
 
-	uint32_t n_wait_nodes = nodes->size;
-	uint32_t thread_pool_size = task->cluster->thread_pool.thread_size;
+	uint32_t thread_pool_size = as_task_gate_threads(&task->cluster->task_gate);
+	as_task_caller caller;
+	as_task_caller_init(&caller, &task->cluster->task_gate);
 
 	// Run tasks in parallel.
 	for (uint32_t i = 0; i < nodes->size; i++) {
@@ -1232,16 +1596,18 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 		
 		// If the thread pool size is > 0 farm out the tasks to the pool, otherwise run in current thread.
 		if (thread_pool_size > 0) {
-			int rc = as_thread_pool_queue_task(&task->cluster->thread_pool, as_query_worker_old, task_node);
+			// Wait for one of this query's tasks when its share of the thread pool is in use.
+			while (! as_task_caller_admit(&caller)) {
+				as_query_wait_task(task->complete_q, &caller, &status);
+			}
+
+			int rc = as_task_caller_queue(&caller, as_query_worker_old, task_node);
 			
 			if (rc) {
 				// Thread could not be added. Abort entire query.
 				if (as_fas_uint32(task->error_mutex, 1) == 0) {
 					status = as_error_update(task->err, AEROSPIKE_ERR_CLIENT, "Failed to add query thread: %d", rc);
 	 			}
-				
-				// Reset node count to threads that were run.
-				n_wait_nodes = i;
 				break;
 			}
 		} else {
@@ -1249,20 +1615,13 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 				break;
 			}
 		}
-		task->first = false;
 	}
 
 	// Wait for tasks to complete.
-	if (thread_pool_size > 0) {
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
-			as_query_complete_task complete;
-			cf_queue_pop(task->complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-				status = complete.result;
-			}
-		}
+	while (as_task_caller_pending(&caller) > 0) {
+		as_query_wait_task(task->complete_q, &caller, &status);
 	}
+	as_task_caller_destroy(&caller);
 	
 	// If user aborts query, command is considered successful.
 	if (status == AEROSPIKE_ERR_CLIENT_ABORT) {
@@ -1273,6 +1632,9 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 	if (task->callback) {
 		task->callback(NULL, task->udata);
 	}
+	else if (task->raw_callback) {
+		task->raw_callback(NULL, task->udata);
+	}
 	
 	// Release temporary queue.
 	cf_queue_destroy(task->complete_q);
@@ -1283,6 +1645,35 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes)
 	return status;
 }
 
+static as_status
+as_query_aggregate_error(uint32_t* error_mutex, as_error* err, as_status status, as_result* res)
+{
+	// Aggregation failed. Abort entire query.
+	if (as_fas_uint32(error_mutex, 1) == 0) {
+		char* rs = as_module_err_string(status);
+
+		if (res->value) {
+			switch (as_val_type(res->value)) {
+				case AS_STRING: {
+					as_string* lua_s = as_string_fromval(res->value);
+					char* lua_err  = (char*)as_string_tostring(lua_s);
+					status = as_error_update(err, AEROSPIKE_ERR_UDF, "%s : %s", rs, lua_err);
+					break;
+				}
+
+				default:
+					status = as_error_update(err, AEROSPIKE_ERR_UDF, "%s : Unknown stack as_val type", rs);
+					break;
+			}
+		}
+		else {
+			status = as_error_set_message(err, AEROSPIKE_ERR_UDF, rs);
+		}
+		cf_free(rs);
+	}
+	return status;
+}
+
 static void
 as_query_aggregate(void* data)
 {
@@ -1308,82 +1699,564 @@ as_query_aggregate(void* data)
 	as_result res;
 	as_result_init(&res);
 	
-	as_status status = as_module_apply_stream(&mod_lua, &ctx, query->apply.module, query->apply.function, task->input_stream, query->apply.arglist, &output_stream, &res);
+	as_status status = as_lua_pool_apply_stream(&ctx, query->apply.module, query->apply.function, task->input_stream, query->apply.arglist, &output_stream, &res);
 	
 	if (status) {
-		// Aggregation failed. Abort entire query.
-		if (as_fas_uint32(task->error_mutex, 1) == 0) {
-			char* rs = as_module_err_string(status);
-			
-			if (res.value) {
-				switch (as_val_type(res.value)) {
-					case AS_STRING: {
-						as_string* lua_s = as_string_fromval(res.value);
-						char* lua_err  = (char*)as_string_tostring(lua_s);
-						status = as_error_update(task->err, AEROSPIKE_ERR_UDF, "%s : %s", rs, lua_err);
-						break;
-					}
-						
-					default:
-						status = as_error_update(task->err, AEROSPIKE_ERR_UDF, "%s : Unknown stack as_val type", rs);
-						break;
-				}
-			}
-			else {
-				status = as_error_set_message(task->err, AEROSPIKE_ERR_UDF, rs);
-			}
-			cf_free(rs);
-		}
+		status = as_query_aggregate_error(task->error_mutex, task->err, status, &res);
 	}
 	as_result_destroy(&res);
 	cf_queue_push(task->complete_q, &status);
 }
 
-static as_status
-as_query_partitions(
-	as_cluster* cluster, as_error* err, const as_policy_query* policy, const as_query* query,
-	as_partition_tracker* pt, aerospike_query_foreach_callback callback, void* udata)
+static as_stream_status
+as_query_reducer_push(as_query_reducer* r, as_query_batch* batch, bool bounded)
 {
-	as_status status;
+	pthread_mutex_lock(&r->lock);
 
-	while (true) {
-		uint64_t task_id = as_random_get_uint64();
-		status = as_partition_tracker_assign(pt, cluster, query->ns, err);
+	// Block node threads while the reducer is behind.
+	while (bounded && ! r->closed && r->queued >= r->capacity) {
+		pthread_cond_wait(&r->cond, &r->lock);
+	}
 
-		if (status != AEROSPIKE_OK) {
-			return status;
+	if (r->closed) {
+		pthread_mutex_unlock(&r->lock);
+
+		if (batch) {
+			as_query_batch_destroy(batch, 0);
 		}
+		return AS_STREAM_ERR;
+	}
 
-		uint32_t n_nodes = pt->node_parts.size;
+	cf_queue_push(r->queue, &batch);
+	r->queued += batch ? batch->size : 0;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+	return AS_STREAM_OK;
+}
 
-		// Initialize task.
-		uint32_t error_mutex = 0;
+static as_val*
+as_query_reducer_read(const as_stream* s)
+{
+	// Only take the lock when the current batch is exhausted.
+	as_query_reducer* r = as_stream_source(s);
 
-		as_query_task task = {
-			.node = NULL,
-			.np = NULL,
-			.pt = pt,
-			.cluster = cluster,
-			.query_policy = policy,
-			.write_policy = NULL,
+	while (! r->batch || r->offset == r->batch->size) {
+		if (r->batch) {
+			cf_free(r->batch);
+			r->batch = NULL;
+		}
+
+		pthread_mutex_lock(&r->lock);
+
+		while (cf_queue_pop(r->queue, &r->batch, CF_QUEUE_NOWAIT) != CF_QUEUE_OK) {
+			pthread_cond_wait(&r->cond, &r->lock);
+		}
+
+		if (r->batch) {
+			r->queued -= r->batch->size;
+		}
+		pthread_cond_broadcast(&r->cond);
+		pthread_mutex_unlock(&r->lock);
+		r->offset = 0;
+
+		if (! r->batch) {
+			return NULL;
+		}
+	}
+	return r->batch->vals[r->offset++];
+}
+
+static as_stream_status
+as_query_reducer_write(const as_stream* s, as_val* val)
+{
+	return as_query_reducer_push(as_stream_source(s), as_query_batch_single(val), true);
+}
+
+static const as_stream_hooks reducer_input_hooks = {
+	.destroy  = as_input_stream_destroy,
+	.read     = as_query_reducer_read,
+	.write    = as_query_reducer_write
+};
+
+static as_stream_status
+as_query_reducer_write_partial(const as_stream* s, as_val* val)
+{
+	// End of stream is written on the merged output only.
+	if (val) {
+		as_query_reducer* r = as_stream_source(s);
+		cf_queue_push(r->partials, &val);
+	}
+	return AS_STREAM_OK;
+}
+
+static const as_stream_hooks reducer_partial_hooks = {
+	.destroy  = as_output_stream_destroy,
+	.read     = NULL,
+	.write    = as_query_reducer_write_partial
+};
+
+static as_stream_status
+as_query_reducers_write(const as_stream* s, as_val* val)
+{
+	as_query_reducers* rs = as_stream_source(s);
+
+	if (! val) {
+		// End of all node streams.
+		for (uint32_t i = 0; i < rs->size; i++) {
+			as_query_reducer_push(&rs->array[i], NULL, false);
+		}
+		return AS_STREAM_OK;
+	}
+
+	// Spread values round robin, so a large node does not overload one reducer.
+	as_query_reducer* r = &rs->array[as_faa_uint32(&rs->next, 1) % rs->size];
+	return as_query_reducer_push(r, as_query_batch_single(val), true);
+}
+
+static as_stream_status
+as_query_reducers_write_batch(as_query_batch* batch, void* udata)
+{
+	// Batches are spread round robin, so a large node does not overload one reducer.
+	as_query_reducers* rs = as_stream_source((as_stream*)udata);
+	as_query_reducer* r = &rs->array[as_faa_uint32(&rs->next, 1) % rs->size];
+	return as_query_reducer_push(r, batch, true);
+}
+
+static const as_stream_hooks reducers_input_hooks = {
+	.destroy  = as_input_stream_destroy,
+	.read     = NULL,
+	.write    = as_query_reducers_write
+};
+
+static void
+as_query_reducer_init(
+	as_query_reducer* r, as_query_task* task, as_stream* output, uint32_t capacity
+	)
+{
+	as_stream_init(&r->input, r, &reducer_input_hooks);
+	as_stream_init(&r->partial, r, &reducer_partial_hooks);
+	r->output = output ? output : &r->partial;
+	r->query = task->query;
+	r->error_mutex = task->error_mutex;
+	r->err = task->err;
+	r->queue = cf_queue_create(sizeof(as_query_batch*), false);
+	r->partials = cf_queue_create(sizeof(as_val*), false);
+	r->batch = NULL;
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->cond, NULL);
+	r->capacity = capacity;
+	r->queued = 0;
+	r->offset = 0;
+	r->status = AEROSPIKE_OK;
+	r->closed = false;
+}
+
+static void
+as_query_reducer_destroy(as_query_reducer* r)
+{
+	as_query_batch* batch;
+
+	while (cf_queue_pop(r->queue, &batch, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+		if (batch) {
+			as_query_batch_destroy(batch, 0);
+		}
+	}
+	cf_queue_destroy(r->queue);
+
+	if (r->batch) {
+		as_query_batch_destroy(r->batch, r->offset);
+	}
+
+	if (r->partials) {
+		as_val* val;
+
+		while (cf_queue_pop(r->partials, &val, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			as_val_destroy(val);
+		}
+		cf_queue_destroy(r->partials);
+	}
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->lock);
+}
+
+static void*
+as_query_reducer_run(void* data)
+{
+	as_query_reducer* r = data;
+	const as_query* query = r->query;
+
+	as_aerospike as;
+	as_aerospike_init(&as, NULL, &query_aerospike_hooks);
+
+	as_udf_context ctx = {
+		.as = &as,
+		.timer = NULL,
+		.memtracker = NULL
+	};
+
+	as_result res;
+	as_result_init(&res);
+
+	as_status status = as_lua_pool_apply_stream(&ctx, query->apply.module,
+		query->apply.function, &r->input, query->apply.arglist, r->output, &res);
+
+	if (status) {
+		status = as_query_aggregate_error(r->error_mutex, r->err, status, &res);
+	}
+	as_result_destroy(&res);
+	r->status = status;
+
+	// Unblock node threads that still write to this reducer.
+	pthread_mutex_lock(&r->lock);
+	r->closed = true;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+static as_status
+as_query_reduce_merge(
+	as_query_task* task, cf_queue** level, uint32_t n, as_query_user_callback* callback_data
+	)
+{
+	// Values read by as_stream_write() are owned by the writer, so the user callback
+	// receives values from the last merge stage only.
+	as_stream output_stream;
+	as_stream_init(&output_stream, callback_data, &output_stream_hooks);
+
+	as_status status = AEROSPIKE_OK;
+	cf_queue** next = cf_malloc(sizeof(cf_queue*) * n);
+
+	while (true) {
+		uint32_t n_groups = (n + QUERY_REDUCE_FAN_IN - 1) / QUERY_REDUCE_FAN_IN;
+		bool last = n_groups == 1;
+		as_query_reducer* group = cf_malloc(sizeof(as_query_reducer) * n_groups);
+
+		for (uint32_t i = 0; i < n_groups; i++) {
+			as_query_reducer* r = &group[i];
+			as_query_reducer_init(r, task, last ? &output_stream : NULL, 0);
+
+			uint32_t end = (i + 1) * QUERY_REDUCE_FAN_IN;
+
+			if (end > n) {
+				end = n;
+			}
+
+			// Partial results are already in memory, so merge input is not bounded.
+			for (uint32_t j = i * QUERY_REDUCE_FAN_IN; j < end; j++) {
+				uint32_t size = (uint32_t)cf_queue_sz(level[j]);
+
+				if (size == 0) {
+					continue;
+				}
+
+				as_query_batch* batch = as_query_batch_create(size);
+
+				while (cf_queue_pop(level[j], &batch->vals[batch->size], CF_QUEUE_NOWAIT) ==
+					CF_QUEUE_OK) {
+					batch->size++;
+				}
+				cf_queue_push(r->queue, &batch);
+			}
+
+			as_query_batch* batch = NULL;
+			cf_queue_push(r->queue, &batch);
+		}
+
+		// Merge groups in parallel.  The caller thread runs the last group.
+		bool* started = alloca(sizeof(bool) * n_groups);
+
+		for (uint32_t i = 0; i + 1 < n_groups; i++) {
+			started[i] = pthread_create(&group[i].thread, NULL, as_query_reducer_run,
+				&group[i]) == 0;
+
+			if (! started[i]) {
+				as_query_reducer_run(&group[i]);
+			}
+		}
+		as_query_reducer_run(&group[n_groups - 1]);
+
+		for (uint32_t i = 0; i < n_groups; i++) {
+			if (i + 1 < n_groups && started[i]) {
+				pthread_join(group[i].thread, NULL);
+			}
+
+			if (group[i].status != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+				status = group[i].status;
+			}
+		}
+
+		for (uint32_t i = 0; i < n; i++) {
+			cf_queue_destroy(level[i]);
+		}
+
+		for (uint32_t i = 0; i < n_groups; i++) {
+			next[i] = group[i].partials;
+			group[i].partials = NULL;
+			as_query_reducer_destroy(&group[i]);
+		}
+		cf_free(group);
+
+		cf_queue** tmp = level;
+		level = next;
+		next = tmp;
+		n = n_groups;
+
+		if (last || status != AEROSPIKE_OK) {
+			break;
+		}
+	}
+
+	// Release partial results left after an error.
+	for (uint32_t i = 0; i < n; i++) {
+		as_val* val;
+
+		while (cf_queue_pop(level[i], &val, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			as_val_destroy(val);
+		}
+		cf_queue_destroy(level[i]);
+	}
+	cf_free(next);
+	cf_free(level);
+	return status;
+}
+
+static bool
+as_query_native_callback(const as_val* v, void* udata)
+{
+	if (! v) {
+		// End of node streams.
+		return true;
+	}
+
+	as_query_native_aggr* na = udata;
+	as_val* val = (as_val*)v;
+
+	pthread_mutex_lock(&na->lock);
+
+	if (na->failed) {
+		pthread_mutex_unlock(&na->lock);
+		as_val_destroy(val);
+		return false;
+	}
+
+	if (na->result) {
+		na->result = na->merge(na->result, val, na->udata);
+		na->failed = na->result == NULL;
+	}
+	else {
+		na->result = val;
+	}
+
+	bool rv = ! na->failed;
+	pthread_mutex_unlock(&na->lock);
+	return rv;
+}
+
+static as_status
+as_query_aggregate_native(
+	as_query_task* task, const as_query* query, as_nodes* nodes, as_aggregate_merge_fn merge,
+	void* merge_udata, aerospike_query_foreach_callback callback, void* udata
+	)
+{
+	as_query_native_aggr na;
+	na.merge = merge;
+	na.udata = merge_udata;
+	na.result = NULL;
+	na.failed = false;
+	pthread_mutex_init(&na.lock, NULL);
+
+	// Node threads merge returned values directly.  No client Lua stage is run.
+	task->callback = as_query_native_callback;
+	task->udata = &na;
+
+	as_status status = as_query_execute(task, query, nodes);
+
+	if (na.failed) {
+		status = as_error_update(task->err, AEROSPIKE_ERR_UDF, "Native merge failed: %s.%s",
+			query->apply.module, query->apply.function);
+	}
+
+	if (status == AEROSPIKE_OK) {
+		if (na.result) {
+			callback(na.result, udata);
+		}
+		callback(NULL, udata);
+	}
+	as_val_destroy(na.result);
+	pthread_mutex_destroy(&na.lock);
+	return status;
+}
+
+static as_status
+as_query_aggregate_parallel(
+	as_query_task* task, const as_query* query, as_nodes* nodes, uint32_t n_reducers,
+	as_query_user_callback* callback_data
+	)
+{
+	as_query_reducers rs;
+	rs.array = cf_malloc(sizeof(as_query_reducer) * n_reducers);
+	rs.size = 0;
+	rs.next = 0;
+	as_stream_init(&rs.input, &rs, &reducers_input_hooks);
+
+	as_status status = AEROSPIKE_OK;
+
+	// Partial reducers run on their own threads, because they block on node results and
+	// must not hold thread pool threads needed by node queries.
+	for (uint32_t i = 0; i < n_reducers; i++) {
+		as_query_reducer* r = &rs.array[i];
+		as_query_reducer_init(r, task, NULL, QUERY_REDUCE_QUEUE_MAX);
+
+		int rc = pthread_create(&r->thread, NULL, as_query_reducer_run, r);
+
+		if (rc) {
+			as_query_reducer_destroy(r);
+
+			if (as_fas_uint32(task->error_mutex, 1) == 0) {
+				status = as_error_update(task->err, AEROSPIKE_ERR_CLIENT,
+					"Failed to add aggregate thread: %d", rc);
+			}
+			break;
+		}
+		rs.size++;
+	}
+
+	if (status == AEROSPIKE_OK) {
+		task->callback = as_query_aggregate_callback;
+		task->batch_callback = as_query_reducers_write_batch;
+		task->udata = &rs.input;
+		status = as_query_execute(task, query, nodes);
+	}
+	else if (rs.size > 0) {
+		as_stream_write(&rs.input, NULL);
+	}
+
+	for (uint32_t i = 0; i < rs.size; i++) {
+		as_query_reducer* r = &rs.array[i];
+		pthread_join(r->thread, NULL);
+
+		if (r->status != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+			status = r->status;
+		}
+	}
+
+	if (status == AEROSPIKE_OK) {
+		cf_queue** level = cf_malloc(sizeof(cf_queue*) * rs.size);
+
+		for (uint32_t i = 0; i < rs.size; i++) {
+			level[i] = rs.array[i].partials;
+			rs.array[i].partials = NULL;
+		}
+		status = as_query_reduce_merge(task, level, rs.size, callback_data);
+	}
+
+	for (uint32_t i = 0; i < rs.size; i++) {
+		as_query_reducer_destroy(&rs.array[i]);
+	}
+	cf_free(rs.array);
+	return status;
+}
+
+static void
+as_query_checkpoint(as_partition_tracker* pt)
+{
+	// Intermediate checkpoint failures do not fail the query.
+	as_error err;
+	as_error_init(&err);
+
+	if (as_partition_tracker_checkpoint_write(pt, false, &err) != AEROSPIKE_OK) {
+		as_log_warn("Query checkpoint failed: %s", err.message);
+	}
+}
+
+static as_status
+as_query_partitions(
+	as_cluster* cluster, as_error* err, const as_policy_query* policy, const as_query* query,
+	as_partition_tracker* pt, aerospike_query_foreach_callback callback,
+	aerospike_query_foreach_raw_callback raw_callback, void* udata)
+{
+	as_status status;
+	as_record_pipeline pipeline;
+	as_record_pipeline* pl = NULL;
+	as_query_task parse_task;
+
+	if (policy->parse_threads > 0) {
+		// Parse task runs user callback without updating the partition tracker.
+		memset(&parse_task, 0, sizeof(as_query_task));
+		parse_task.cluster = cluster;
+		parse_task.query_policy = policy;
+		parse_task.query = query;
+		parse_task.callback = callback;
+		parse_task.raw_callback = raw_callback;
+		parse_task.udata = udata;
+		parse_task.query_type = QUERY_FOREGROUND;
+
+		int rc = as_record_pipeline_init(&pipeline, policy->parse_threads,
+			as_query_parse_record_pipeline, &parse_task);
+
+		if (rc) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+				"Failed to create query parse threads: %d", rc);
+		}
+		pl = &pipeline;
+	}
+
+	if (policy->checkpoint_file) {
+		// Parse threads deliver records after their cursors are set, so only checkpoint
+		// between iterations.
+		as_partition_tracker_checkpoint_init(pt, policy->checkpoint_file,
+			pl ? 0 : policy->checkpoint_records, pl ? 0 : policy->checkpoint_interval);
+	}
+
+	while (true) {
+		uint64_t task_id = as_random_get_uint64();
+		status = as_partition_tracker_assign(pt, cluster, query->ns, err);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+
+		uint32_t n_nodes = pt->node_parts.size;
+
+		// Initialize task.
+		uint32_t error_mutex = 0;
+
+		as_query_task task = {
+			.node = NULL,
+			.np = NULL,
+			.pt = pt,
+			.cluster = cluster,
+			.query_policy = policy,
+			.write_policy = NULL,
 			.query = query,
 			.callback = callback,
+			.raw_callback = raw_callback,
+			.batch_callback = NULL,
+			.batch = NULL,
 			.udata = udata,
 			.err = err,
 			.error_mutex = &error_mutex,
 			.input_queue = NULL,
 			.complete_q = NULL,
+			.pipeline = pl,
+			.reuse = NULL,
 			.task_id = task_id,
 			.cluster_key = 0,
+			.chunk_size = 0,
 			.cmd = NULL,
 			.cmd_size = 0,
-			.query_type = QUERY_FOREGROUND,
-			.first = true
+			.query_type = QUERY_FOREGROUND
 		};
 
 		if (n_nodes > 1) {
-			uint32_t n_wait_nodes = n_nodes;
+			if (pt->max_records == 0) {
+				task.chunk_size = policy->partition_chunk;
+			}
+
 			task.complete_q = cf_queue_create(sizeof(as_query_complete_task), true);
+			as_task_caller caller;
+			as_task_caller_init(&caller, &cluster->task_gate);
 
 			// Run node queries in parallel.
 			for (uint32_t i = 0; i < n_nodes; i++) {
@@ -1395,29 +2268,27 @@ as_query_partitions(
 				task_node->np = as_vector_get(&pt->node_parts, i);
 				task_node->node = task_node->np->node;
 
-				int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_query_worker_new, task_node);
+				// Wait for one of this query's tasks when its share of the thread pool is in use.
+				while (! as_task_caller_admit(&caller)) {
+					as_query_wait_task(task.complete_q, &caller, &status);
+				}
+
+				int rc = as_task_caller_queue(&caller, as_query_worker_new, task_node);
 				
 				if (rc) {
 					// Thread could not be added. Abort entire query.
 					if (as_fas_uint32(task.error_mutex, 1) == 0) {
 						status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add query thread: %d", rc);
 					}
-					
-					// Reset node count to threads that were run.
-					n_wait_nodes = i;
 					break;
 				}
 			}
 
 			// Wait for tasks to complete.
-			for (uint32_t i = 0; i < n_wait_nodes; i++) {
-				as_query_complete_task complete;
-				cf_queue_pop(task.complete_q, &complete, CF_QUEUE_FOREVER);
-				
-				if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-					status = complete.result;
-				}
+			while (as_task_caller_pending(&caller) > 0) {
+				as_query_wait_task(task.complete_q, &caller, &status);
 			}
+			as_task_caller_destroy(&caller);
 			
 			// Release temporary queue.
 			cf_queue_destroy(task.complete_q);
@@ -1433,6 +2304,15 @@ as_query_partitions(
 			}
 		}
 
+		if (pl) {
+			// Partition status is complete only after queued records are delivered.
+			as_record_pipeline_drain(pl);
+
+			if (status == AEROSPIKE_OK) {
+				status = as_record_pipeline_status(pl, err);
+			}
+		}
+
 		// If user aborts query, command is considered successful.
 		if (status == AEROSPIKE_ERR_CLIENT_ABORT) {
 			status = AEROSPIKE_OK;
@@ -1440,7 +2320,7 @@ as_query_partitions(
 		}
 
 		if (status != AEROSPIKE_OK) {
-			return status;
+			break;
 		}
 
 		status = as_partition_tracker_is_complete(pt, cluster, err);
@@ -1450,14 +2330,36 @@ as_query_partitions(
 			break;
 		}
 
+		if (pt->checkpoint) {
+			as_query_checkpoint(pt);
+		}
+
 		if (pt->sleep_between_retries > 0) {
 			// Sleep before trying again.
 			as_sleep(pt->sleep_between_retries);
 		}
 	}
 
+	if (pl) {
+		as_record_pipeline_destroy(pl);
+	}
+
+	if (pt->checkpoint) {
+		if (status == AEROSPIKE_OK) {
+			status = as_partition_tracker_checkpoint_write(pt, true, err);
+		}
+		else {
+			as_query_checkpoint(pt);
+		}
+	}
+
 	if (status == AEROSPIKE_OK) {
-		callback(NULL, udata);
+		if (raw_callback) {
+			raw_callback(NULL, udata);
+		}
+		else {
+			callback(NULL, udata);
+		}
 	}
 	return status;
 }
@@ -1504,7 +2406,7 @@ as_query_partition_execute_async(
 		// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
 		// fragmentation and to allow socket read to reuse buffer.
 		size_t s = (sizeof(as_async_query_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
-		as_async_query_command* qcmd = cf_malloc(s);
+		as_async_query_command* qcmd = as_alloc_malloc(s);
 		qcmd->np = np;
 
 		as_event_command* cmd = (as_event_command*)qcmd;
@@ -1572,7 +2474,7 @@ as_query_partition_execute_async(
 		cmd->max_retries = 0;
 		cmd->iteration = 0;
 		cmd->replica = AS_POLICY_REPLICA_MASTER;
-		cmd->event_loop = ee->event_loop;
+		cmd->event_loop = as_event_executor_loop(ee, i);
 		cmd->cluster = qe->cluster;
 		cmd->node = np->node;
 		// Reserve node because as_event_command_free() will release node
@@ -1580,6 +2482,8 @@ as_query_partition_execute_async(
 		as_node_reserve(cmd->node);
 		cmd->ns = NULL;
 		cmd->partition = NULL;
+		cmd->latency_begin = 0;
+		cmd->stats_begin = 0;
 		cmd->udata = qe;  // Overload udata to be the executor.
 		cmd->parse_results = as_query_parse_records_async;
 		cmd->pipe_listener = NULL;
@@ -1590,6 +2494,11 @@ as_query_partition_execute_async(
 		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 		cmd->flags = AS_ASYNC_FLAGS_MASTER;
 		cmd->flags2 = qe->deserialize ? AS_ASYNC_FLAGS2_DESERIALIZE : 0;
+		cmd->priority = qe->priority;
+
+		if (qe->zero_copy) {
+			cmd->flags2 |= AS_ASYNC_FLAGS2_ZERO_COPY;
+		}
 		ee->commands[i] = cmd;
 	}
 
@@ -1621,6 +2530,23 @@ as_query_partition_execute_async(
 	return AEROSPIKE_OK;
 }
 
+static void
+as_query_partition_abort_async(as_event_executor* ee)
+{
+	as_async_query_executor* qe = (as_async_query_executor*)ee;
+	as_vector* list = &qe->pt->node_parts;
+	as_node** nodes = alloca(sizeof(as_node*) * list->size);
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_node_partitions* np = as_vector_get(list, i);
+		nodes[i] = np->node;
+	}
+
+	// Retries store the task id without byte swap, so read it the way the server does.
+	uint64_t task_id = cf_swap_from_be64(*(uint64_t*)(qe->cmd_buf + qe->task_id_offset));
+	as_async_cancel_abort_nodes(ee->event_loop, "query", task_id, nodes, list->size);
+}
+
 static as_status
 as_query_partition_async(
 	as_cluster* cluster, as_error* err, const as_policy_query* policy, const as_query* query,
@@ -1666,7 +2592,9 @@ as_query_partition_async(
 	qe->task_id_offset = qb.task_id_offset;
 	qe->info_timeout = policy->info_timeout;
 	qe->n_fields = qb.n_fields;
+	qe->priority = (uint8_t)policy->base.priority;
 	qe->deserialize = policy->deserialize;
+	qe->zero_copy = policy->zero_copy;
 	qe->has_where = query->where.size > 0;
 
 	uint32_t n_nodes = pt->node_parts.size;
@@ -1681,11 +2609,23 @@ as_query_partition_async(
 	ee->udata = udata;
 	ee->err = NULL;
 	ee->ns = cf_strdup(query->ns);
+	ee->flow = NULL;
+	ee->cancel = NULL;
+	ee->paused = NULL;
 	ee->cluster_key = 0;
 	ee->count = 0;
 	ee->queued = 0;
 	ee->notify = true;
 	ee->valid = true;
+	ee->spread = policy->spread_loops && ! policy->flow && as_event_loop_size > 1;
+
+	if (policy->flow) {
+		as_async_flow_attach(policy->flow, ee);
+	}
+
+	if (policy->cancel) {
+		as_async_cancel_attach(policy->cancel, ee, as_query_partition_abort_async);
+	}
 
 	return as_query_partition_execute_async(qe, pt, err);
 }
@@ -1704,7 +2644,9 @@ as_query_partition_retry_async(as_async_query_executor* qe_old, as_error* err)
 	qe->task_id_offset = qe_old->task_id_offset;
 	qe->info_timeout = qe_old->info_timeout;
 	qe->n_fields = qe_old->n_fields;
+	qe->priority = qe_old->priority;
 	qe->deserialize = qe_old->deserialize;
+	qe->zero_copy = qe_old->zero_copy;
 	qe->has_where = qe_old->has_where;
 
 	// Must change task_id each round. Otherwise, server rejects command.
@@ -1725,11 +2667,23 @@ as_query_partition_retry_async(as_async_query_executor* qe_old, as_error* err)
 	ee->err = NULL;
 	ee->ns = ee_old->ns;
 	ee_old->ns = NULL;
+	ee->flow = NULL;
+	ee->cancel = NULL;
+	ee->paused = NULL;
 	ee->cluster_key = 0;
 	ee->count = 0;
 	ee->queued = 0;
 	ee->notify = true;
 	ee->valid = true;
+	ee->spread = ee_old->spread;
+
+	if (ee_old->flow) {
+		as_async_flow_attach(ee_old->flow, ee);
+	}
+
+	if (ee_old->cancel) {
+		as_async_cancel_attach(ee_old->cancel, ee, as_query_partition_abort_async);
+	}
 
 	return as_query_partition_execute_async(qe, qe->pt, err);
 }
@@ -1744,6 +2698,10 @@ convert_query_to_scan(
 	memcpy(&scan_policy->base, &query_policy->base, sizeof(as_policy_base));
 	scan_policy->max_records = query->max_records;
 	scan_policy->records_per_second = query->records_per_second;
+	scan_policy->zero_copy = query_policy->zero_copy;
+	scan_policy->reuse_record = query_policy->reuse_record;
+	scan_policy->cancel = query_policy->cancel;
+	scan_policy->spread_loops = query_policy->spread_loops;
 
 	as_scan_init(scan, query->ns, query->set);
 	scan->select.entries = query->select.entries;
@@ -1808,7 +2766,7 @@ aerospike_query_foreach(
 		as_partition_tracker_init_nodes(&pt, cluster, &policy->base, query->max_records,
 			&query->parts_all, query->paginate, n_nodes);
 
-		status = as_query_partitions(cluster, err, policy, query, &pt, callback, udata);
+		status = as_query_partitions(cluster, err, policy, query, &pt, callback, NULL, udata);
 
 		if (status != AEROSPIKE_OK) {
 			as_partition_error(query->parts_all);
@@ -1847,6 +2805,9 @@ aerospike_query_foreach(
 		.write_policy = NULL,
 		.query = query,
 		.callback = NULL,
+		.raw_callback = NULL,
+		.batch_callback = NULL,
+		.batch = NULL,
 		.udata = NULL,
 		.err = err,
 		.error_mutex = &error_mutex,
@@ -1856,19 +2817,44 @@ aerospike_query_foreach(
 		.cluster_key = 0,
 		.cmd = NULL,
 		.cmd_size = 0,
-		.query_type = QUERY_FOREGROUND,
-		.first = true
+		.query_type = QUERY_FOREGROUND
 	};
 		
-	if (query->apply.function[0]) {
+	uint32_t n_reducers = policy->aggregate_threads < nodes->size ?
+		policy->aggregate_threads : nodes->size;
+
+	as_aggregate_merge_fn merge;
+	void* merge_udata;
+
+	if (query->apply.function[0] &&
+		as_aggregate_find(query->apply.module, query->apply.function, &merge, &merge_udata)) {
+		// Query with native client side stage.
+		status = as_query_aggregate_native(&task, query, nodes, merge, merge_udata, callback,
+			udata);
+	}
+	else if (query->apply.function[0] && n_reducers > 1) {
+		// Query with partial reduce per node share and merge tree.
+		as_query_user_callback callback_data;
+		callback_data.callback = callback;
+		callback_data.udata = udata;
+
+		status = as_query_aggregate_parallel(&task, query, nodes, n_reducers, &callback_data);
+	}
+	else if (query->apply.function[0]) {
 		// Query with aggregation.
-		task.input_queue = cf_queue_create(sizeof(void*), true);
-		
-		// Stream for results from each node
+		task.input_queue = cf_queue_create(sizeof(as_query_batch*), true);
+
+		// Stream for results from each node.  Node threads queue batches of values.
+		as_query_input input;
+		input.queue = task.input_queue;
+		input.batch = NULL;
+		input.offset = 0;
+
 		as_stream input_stream;
-		as_stream_init(&input_stream, task.input_queue, &input_stream_hooks);
+		as_stream_init(&input_stream, &input, &input_stream_hooks);
 		
 		task.callback = as_query_aggregate_callback;
+		task.batch_callback = as_input_batch_write;
 		task.udata = &input_stream;
 		
 		as_query_user_callback callback_data;
@@ -1884,7 +2870,7 @@ aerospike_query_foreach(
 		task_aggr.complete_q = cf_queue_create(sizeof(as_status), true);
 		
 		// Run lua aggregation in separate thread.
-		int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_query_aggregate, &task_aggr);
+		int rc = as_task_gate_queue(&cluster->task_gate, as_query_aggregate, &task_aggr);
 		
 		if (rc == 0) {
 			status = as_query_execute(&task, query, nodes);
@@ -1904,11 +2890,18 @@ aerospike_query_foreach(
 		cf_queue_destroy(task_aggr.complete_q);
 		
 		// Empty input queue.
-		as_val* val = NULL;
-		while (cf_queue_pop(task.input_queue, &val, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
-			as_val_destroy(val);
+		as_query_batch* batch = NULL;
+
+		while (cf_queue_pop(task.input_queue, &batch, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			if (batch) {
+				as_query_batch_destroy(batch, 0);
+			}
 		}
 		cf_queue_destroy(task.input_queue);
+
+		if (input.batch) {
+			as_query_batch_destroy(input.batch, input.offset);
+		}
 	}
 	else {
 		// Normal query without aggregation.
@@ -1922,6 +2915,95 @@ aerospike_query_foreach(
 	return status;
 }
 
+as_status
+aerospike_query_foreach_raw(
+	aerospike* as, as_error* err, const as_policy_query* policy, as_query* query,
+	aerospike_query_foreach_raw_callback callback, void* udata)
+{
+	if (query->apply.function[0] || query->ops) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Aggregation or background queries do not support raw callbacks");
+	}
+
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.query;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_status status;
+
+	if (cluster->has_partition_query) {
+		// Partition query.
+		uint32_t n_nodes;
+		status = as_cluster_validate_size(cluster, err, &n_nodes);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		as_partition_tracker pt;
+		as_partition_tracker_init_nodes(&pt, cluster, &policy->base, query->max_records,
+			&query->parts_all, query->paginate, n_nodes);
+
+		status = as_query_partitions(cluster, err, policy, query, &pt, NULL, callback, udata);
+
+		if (status != AEROSPIKE_OK) {
+			as_partition_error(query->parts_all);
+		}
+		as_partition_tracker_destroy(&pt);
+		return status;
+	}
+
+	// Old foreground query. Convert to a scan when filter doesn't exist.
+	if (query->where.size == 0) {
+		as_policy_scan scan_policy;
+		as_scan scan;
+		convert_query_to_scan(policy, query, &scan_policy, &scan);
+
+		return aerospike_scan_foreach_raw(as, err, &scan_policy, &scan, callback, udata);
+	}
+
+	as_nodes* nodes;
+	status = as_cluster_reserve_all_nodes(cluster, err, &nodes);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint32_t error_mutex = 0;
+
+	as_query_task task = {
+		.node = NULL,
+		.np = NULL,
+		.pt = NULL,
+		.cluster = cluster,
+		.query_policy = policy,
+		.write_policy = NULL,
+		.query = query,
+		.callback = NULL,
+		.raw_callback = callback,
+		.batch_callback = NULL,
+		.batch = NULL,
+		.udata = udata,
+		.err = err,
+		.error_mutex = &error_mutex,
+		.input_queue = NULL,
+		.complete_q = NULL,
+		.task_id = as_random_get_uint64(),
+		.cluster_key = 0,
+		.cmd = NULL,
+		.cmd_size = 0,
+		.query_type = QUERY_FOREGROUND
+	};
+
+	status = as_query_execute(&task, query, nodes);
+
+	as_cluster_release_all_nodes(nodes);
+	return status;
+}
+
 as_status
 aerospike_query_partitions(
 	aerospike* as, as_error* err, const as_policy_query* policy, as_query* query,
@@ -1965,7 +3047,7 @@ aerospike_query_partitions(
 		return status;
 	}
 
-	status = as_query_partitions(cluster, err, policy, query, &pt, callback, udata);
+	status = as_query_partitions(cluster, err, policy, query, &pt, callback, NULL, udata);
 
 	if (status != AEROSPIKE_OK) {
 		as_partition_error(query->parts_all);
@@ -2037,6 +3119,9 @@ aerospike_query_async(
 	exec->udata = udata;
 	exec->err = NULL;
 	exec->ns = NULL;
+	exec->flow = NULL;
+	exec->cancel = NULL;
+	exec->paused = NULL;
 	exec->cluster_key = 0;
 	exec->max_concurrent = nodes->size;
 	exec->max = nodes->size;
@@ -2044,6 +3129,16 @@ aerospike_query_async(
 	exec->queued = 0;
 	exec->notify = true;
 	exec->valid = true;
+	exec->spread = false;
+
+	if (policy->flow) {
+		as_async_flow_attach(policy->flow, exec);
+	}
+
+	if (policy->cancel) {
+		// Old query commands do not keep their task id, so only the client stops.
+		as_async_cancel_attach(policy->cancel, exec, NULL);
+	}
 	executor->listener = listener;
 	executor->info_timeout = policy->info_timeout;
 
@@ -2067,7 +3162,7 @@ aerospike_query_async(
 
 	// Create all query commands.
 	for (uint32_t i = 0; i < nodes->size; i++) {
-		as_async_query_command* qcmd = cf_malloc(s);
+		as_async_query_command* qcmd = as_alloc_malloc(s);
 		qcmd->np = NULL;
 
 		as_event_command* cmd = &qcmd->command;
@@ -2081,6 +3176,8 @@ aerospike_query_async(
 		cmd->node = nodes->array[i];
 		cmd->ns = NULL;
 		cmd->partition = NULL;
+		cmd->latency_begin = 0;
+		cmd->stats_begin = 0;
 		cmd->udata = executor;  // Overload udata to be the executor.
 		cmd->parse_results = as_query_parse_records_async;
 		cmd->pipe_listener = NULL;
@@ -2092,6 +3189,11 @@ aerospike_query_async(
 		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 		cmd->flags = AS_ASYNC_FLAGS_MASTER;
 		cmd->flags2 = policy->deserialize ? AS_ASYNC_FLAGS2_DESERIALIZE : 0;
+		cmd->priority = (uint8_t)policy->base.priority;
+
+		if (policy->zero_copy) {
+			cmd->flags2 |= AS_ASYNC_FLAGS2_ZERO_COPY;
+		}
 		memcpy(cmd->buf, cmd_buf, size);
 		exec->commands[i] = cmd;
 	}
@@ -2211,6 +3313,9 @@ aerospike_query_background(
 		.write_policy = policy,
 		.query = query,
 		.callback = NULL,
+		.raw_callback = NULL,
+		.batch_callback = NULL,
+		.batch = NULL,
 		.udata = NULL,
 		.err = err,
 		.error_mutex = &error_mutex,
@@ -2220,8 +3325,7 @@ aerospike_query_background(
 		.cluster_key = 0,
 		.cmd = NULL,
 		.cmd_size = 0,
-		.query_type = QUERY_BACKGROUND,
-		.first = true
+		.query_type = QUERY_BACKGROUND
 	};
 
 	status = as_query_execute(&task, query, nodes);
@@ -22,11 +22,14 @@
 #include <aerospike/as_job.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_monitor.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_partition_tracker.h>
 #include <aerospike/as_query_validate.h>
 #include <aerospike/as_random.h>
+#include <aerospike/as_record_pipeline.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_sleep.h>
 #include <aerospike/as_socket.h>
@@ -34,6 +37,14 @@
 #include <citrusleaf/cf_clock.h>
 #include <citrusleaf/cf_queue.h>
 
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_SCAN_LEASE_RUNNING 0
+#define AS_SCAN_LEASE_ABORTED 1
+#define AS_SCAN_LEASE_LOST 2
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -47,12 +58,16 @@ typedef struct as_scan_task_s {
 	const as_policy_scan* policy;
 	const as_scan* scan;
 	aerospike_scan_foreach_callback callback;
+	aerospike_scan_foreach_raw_callback raw_callback;
 	void* udata;
 	as_error* err;
 	cf_queue* complete_q;
 	uint32_t* error_mutex;
+	as_record_pipeline* pipeline;
+	as_record_reuse* reuse;
 	uint64_t task_id;
 	uint64_t cluster_key;
+	uint32_t chunk_size;
 	bool first;
 } as_scan_task;
 
@@ -73,10 +88,21 @@ typedef struct as_async_scan_executor {
 	uint32_t cmd_size_post;
 	uint32_t task_id_offset;
 	uint16_t n_fields;
+	uint8_t priority;
 	bool concurrent;
 	bool deserialize_list_map;
+	bool zero_copy;
+	bool blocking;
 } as_async_scan_executor;
 
+typedef struct as_scan_mux_s {
+	as_monitor monitor;
+	aerospike_scan_foreach_callback callback;
+	void* udata;
+	as_error* err;
+	as_status status;
+} as_scan_mux;
+
 typedef struct as_async_scan_command {
 	as_event_command command;
 	as_node_partitions* np;
@@ -97,6 +123,16 @@ typedef struct as_scan_builder {
 	uint16_t n_fields;
 } as_scan_builder;
 
+typedef struct as_scan_lease_task_s {
+	aerospike_scan_foreach_callback callback;
+	void* udata;
+	as_scan_lease_store* store;
+	as_scan_lease* lease;
+	uint64_t renew_at;
+	uint32_t lease_ms;
+	uint8_t state;
+} as_scan_lease_task;
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -120,14 +156,16 @@ as_scan_partition_executor_destroy(as_async_scan_executor* se)
 static void
 as_scan_partition_notify(as_async_scan_executor* se, as_error* err)
 {
-	if (err) {
+	// A blocking sync scan treats user abort as success.
+	if (err && ! (se->blocking && err->code == AEROSPIKE_ERR_CLIENT_ABORT)) {
 		as_partition_error(se->pt->parts_all);
 	}
 
 	as_scan_partition_executor_destroy(se);
 
-	// If scan callback already returned false, do not re-notify user.
-	if (se->executor.notify) {
+	// If scan callback already returned false, do not re-notify user. A blocking sync
+	// scan is always notified because its caller waits for completion.
+	if (se->executor.notify || se->blocking) {
 		se->listener(err, NULL, se->executor.udata, se->executor.event_loop);
 	}
 }
@@ -186,7 +224,8 @@ as_scan_parse_record_async(
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key, &bval);
 
 	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops,
-											 sc->command.flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
+											 sc->command.flags2 & AS_ASYNC_FLAGS2_DESERIALIZE,
+											 sc->command.flags2 & AS_ASYNC_FLAGS2_ZERO_COPY);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -201,6 +240,8 @@ as_scan_parse_record_async(
 		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT_ABORT, "");
 	}
 
+	as_event_flow_record(&se->executor);
+
 	if (sc->np) {
 		as_partition_tracker_set_digest(se->pt, sc->np, &rec.key.digest, sc->command.cluster->n_partitions);
 	}
@@ -259,6 +300,10 @@ as_scan_parse_records_async(as_event_command* cmd)
 			return true;
 		}
 
+		if (as_event_executor_cancelled(&se->executor)) {
+			as_async_cancel_executor(&se->executor);
+		}
+
 		if (! se->executor.valid) {
 			as_error_set_message(&err, AEROSPIKE_ERR_CLIENT_ABORT, "");
 			as_event_response_error(cmd, &err);
@@ -270,12 +315,61 @@ as_scan_parse_records_async(as_event_command* cmd)
 			return true;
 		}
 	}
+	as_event_flow_check(cmd, &se->executor);
 	return false;
 }
 
+static as_status
+as_scan_parse_record_raw(uint8_t** pp, as_msg* msg, as_scan_task* task)
+{
+	// Bins stay in the response buffer, so nothing is allocated per record.
+	as_record_raw rec;
+	uint64_t bval = 0;
+	*pp = as_command_parse_record_raw(*pp, msg, &rec, &bval);
+
+	if (! task->raw_callback(&rec, task->udata)) {
+		return AEROSPIKE_ERR_CLIENT_ABORT;
+	}
+
+	if (task->pt) {
+		as_partition_tracker_set_digest(task->pt, task->np, &rec.digest, task->cluster->n_partitions);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_scan_parse_record_reuse(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* err)
+{
+	as_record* rec = &task->reuse->rec;
+	uint64_t bval = 0;
+	as_status status = as_command_parse_record_reuse(pp, err, msg, task->reuse,
+		task->scan->deserialize_list_map, &bval);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (task->callback && ! task->callback((as_val*)rec, task->udata)) {
+		return AEROSPIKE_ERR_CLIENT_ABORT;
+	}
+
+	if (task->pt) {
+		as_partition_tracker_set_digest(task->pt, task->np, &rec->key.digest, task->cluster->n_partitions);
+	}
+	return AEROSPIKE_OK;
+}
+
 static as_status
 as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* err)
 {
+	if (task->raw_callback) {
+		return as_scan_parse_record_raw(pp, msg, task);
+	}
+
+	if (task->reuse) {
+		return as_scan_parse_record_reuse(pp, msg, task, err);
+	}
+
 	as_record rec;
 	as_record_inita(&rec, msg->n_ops);
 	
@@ -285,7 +379,8 @@ as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* er
 	uint64_t bval = 0;
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key, &bval);
 
-	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->scan->deserialize_list_map);
+	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops,
+											 task->scan->deserialize_list_map, task->policy->zero_copy);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -309,17 +404,94 @@ as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* er
 }
 
 static as_status
-as_scan_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+as_scan_parse_record_pipeline(void* udata, as_msg* msg, uint8_t* p, as_error* err)
+{
+	// Parse task does not reference the partition tracker. The socket reader thread
+	// already recorded the record digest.
+	return as_scan_parse_record(&p, msg, udata, err);
+}
+
+static as_status
+as_scan_parse_records_pipeline(as_error* err, as_scan_task* task, uint8_t* buf, size_t size)
+{
+	as_record_pipeline* pl = task->pipeline;
+	as_record_pipeline_block* block = as_record_pipeline_copy(pl, buf, size);
+	uint32_t n_partitions = task->cluster->n_partitions;
+	as_msg_index index;
+	as_status status = as_msg_index_build(err, &index, block->buf, size);
+
+	for (uint32_t i = 0; status == AEROSPIKE_OK && i < index.size; i++) {
+		as_msg* msg = index.msgs[i];
+		uint8_t* p = msg->data;
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			if (msg->result_code != AEROSPIKE_OK) {
+				// The server returned a fatal error.
+				status = as_error_set_message(err, msg->result_code,
+											  as_error_string(msg->result_code));
+			}
+			else {
+				status = AEROSPIKE_NO_MORE_RECORDS;
+			}
+			break;
+		}
+
+		if (task->pt) {
+			if (msg->info3 & AS_MSG_INFO3_PARTITION_DONE) {
+				if (msg->result_code != AEROSPIKE_OK) {
+					as_partition_tracker_part_unavailable(task->pt, task->np, msg->generation);
+				}
+				continue;
+			}
+		}
+
+		if (msg->result_code != AEROSPIKE_OK) {
+			if (msg->result_code == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+				// Non-fatal error.
+				status = AEROSPIKE_NO_MORE_RECORDS;
+			}
+			else {
+				status = as_error_set_message(err, msg->result_code,
+											  as_error_string(msg->result_code));
+			}
+			break;
+		}
+
+		// Only find record boundary and digest here. Bins are parsed in the parse thread.
+		as_digest digest;
+		uint64_t bval = 0;
+		as_command_parse_digest(p, msg->n_fields, &digest, &bval);
+
+		if (task->pt) {
+			as_partition_tracker_set_digest(task->pt, task->np, &digest, n_partitions);
+		}
+
+		as_record_pipeline_push(pl, block, msg, as_partition_getid(digest.value, n_partitions));
+
+		if (as_record_pipeline_failed(pl)) {
+			status = as_record_pipeline_status(pl, err);
+			break;
+		}
+
+		if (as_load_uint32(task->error_mutex)) {
+			err->code = AEROSPIKE_ERR_SCAN_ABORTED;
+			status = err->code;
+			break;
+		}
+	}
+	as_msg_index_destroy(&index);
+	as_record_pipeline_release(pl, block);
+	return status;
+}
+
+static as_status
+as_scan_parse_index(as_error* err, as_scan_task* task, as_msg_index* index)
 {
-	as_scan_task* task = cmd->udata;
-	uint8_t* p = buf;
-	uint8_t* end = buf + size;
 	as_status status;
-	
-	while (p < end) {
-		as_msg* msg = (as_msg*)p;
-		as_msg_swap_header_from_be(msg);
-		p += sizeof(as_msg);
+
+	for (uint32_t i = 0; i < index->size; i++) {
+		as_msg* msg = index->msgs[i];
+		uint8_t* p = msg->data;
 		
 		if (msg->info3 & AS_MSG_INFO3_LAST) {
 			if (msg->result_code != AEROSPIKE_OK) {
@@ -365,6 +537,25 @@ as_scan_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* bu
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_scan_parse_records(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+{
+	as_scan_task* task = cmd->udata;
+
+	if (task->pipeline) {
+		return as_scan_parse_records_pipeline(err, task, buf, size);
+	}
+
+	as_msg_index index;
+	as_status status = as_msg_index_build(err, &index, buf, size);
+
+	if (status == AEROSPIKE_OK) {
+		status = as_scan_parse_index(err, task, &index);
+	}
+	as_msg_index_destroy(&index);
+	return status;
+}
+
 static size_t
 as_scan_command_size(const as_policy_scan* policy, const as_scan* scan, as_scan_builder* sb)
 {
@@ -640,7 +831,7 @@ as_scan_command_execute(as_scan_task* task)
 	cmd.buf_size = size;
 	cmd.partition_id = 0; // Not referenced when node set.
 	cmd.replica = AS_POLICY_REPLICA_MASTER;
-	cmd.flags = AS_COMMAND_FLAGS_READ;
+	cmd.flags = AS_COMMAND_FLAGS_READ | AS_COMMAND_FLAGS_SCAN;
 
 	as_command_start_timer(&cmd);
 
@@ -648,8 +839,20 @@ as_scan_command_execute(as_scan_task* task)
 	// the caller, as_scan_partitions().
 	cmd.max_retries = 0;
 
+	as_record_reuse reuse;
+
+	if (task->policy->reuse_record && ! task->pipeline) {
+		as_record_reuse_init(&reuse);
+		task->reuse = &reuse;
+	}
+
 	status = as_command_execute(&cmd, &err);
 
+	if (task->reuse) {
+		as_record_reuse_destroy(task->reuse);
+		task->reuse = NULL;
+	}
+
 	// Free command memory.
 	as_command_buffer_free(buf, size);
 
@@ -682,6 +885,42 @@ as_scan_command_execute(as_scan_task* task)
 	return status;
 }
 
+static as_status
+as_scan_command_execute_chunks(as_scan_task* task)
+{
+	as_node_partitions* np = task->np;
+	as_node_partitions chunk;
+	as_partition_tracker_chunk_init(task->pt, &chunk, np);
+
+	as_status status = AEROSPIKE_OK;
+
+	while (as_partition_tracker_next_chunk(task->pt, task->cluster, task->scan->ns, np, &chunk,
+		task->chunk_size)) {
+		task->np = &chunk;
+		status = as_scan_command_execute(task);
+		task->np = np;
+		as_partition_tracker_chunk_done(task->pt, np, &chunk);
+
+		if (status != AEROSPIKE_OK || as_load_uint32(task->error_mutex)) {
+			break;
+		}
+	}
+	as_partition_tracker_chunk_destroy(&chunk);
+	return status;
+}
+
+static inline void
+as_scan_wait_task(cf_queue* complete_q, as_task_caller* caller, as_status* status)
+{
+	as_scan_complete_task complete;
+	cf_queue_pop(complete_q, &complete, CF_QUEUE_FOREVER);
+	as_task_caller_complete(caller);
+
+	if (complete.result != AEROSPIKE_OK && *status == AEROSPIKE_OK) {
+		*status = complete.result;
+	}
+}
+
 static void
 as_scan_worker(void* data)
 {
@@ -692,7 +931,8 @@ as_scan_worker(void* data)
 	complete_task.task_id = task->task_id;
 
 	if (as_load_uint32(task->error_mutex) == 0) {
-		complete_task.result = as_scan_command_execute(task);
+		complete_task.result = task->chunk_size > 0 ?
+			as_scan_command_execute_chunks(task) : as_scan_command_execute(task);
 	}
 	else {
 		complete_task.result = AEROSPIKE_ERR_SCAN_ABORTED;
@@ -739,16 +979,21 @@ as_scan_generic(
 	task.policy = policy;
 	task.scan = scan;
 	task.callback = callback;
+	task.raw_callback = NULL;
 	task.udata = udata;
 	task.err = err;
 	task.error_mutex = &error_mutex;
+	task.pipeline = NULL;
+	task.reuse = NULL;
 	task.task_id = task_id;
 	task.cluster_key = cluster_key;
+	task.chunk_size = 0;
 	task.first = true;
 
 	if (scan->concurrent) {
-		uint32_t n_wait_nodes = nodes->size;
 		task.complete_q = cf_queue_create(sizeof(as_scan_complete_task), true);
+		as_task_caller caller;
+		as_task_caller_init(&caller, &cluster->task_gate);
 
 		// Run node scans in parallel.
 		for (uint32_t i = 0; i < nodes->size; i++) {
@@ -758,30 +1003,28 @@ as_scan_generic(
 			memcpy(task_node, &task, sizeof(as_scan_task));
 			task_node->node = nodes->array[i];
 
-			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_scan_worker, task_node);
+			// Wait for one of this scan's tasks when its share of the thread pool is in use.
+			while (! as_task_caller_admit(&caller)) {
+				as_scan_wait_task(task.complete_q, &caller, &status);
+			}
+
+			int rc = as_task_caller_queue(&caller, as_scan_worker, task_node);
 			
 			if (rc) {
 				// Thread could not be added. Abort entire scan.
 				if (as_fas_uint32(task.error_mutex, 1) == 0) {
 					status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add scan thread: %d", rc);
 				}
-				
-				// Reset node count to threads that were run.
-				n_wait_nodes = i;
 				break;
 			}
 			task.first = false;
 		}
 
 		// Wait for tasks to complete.
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
-			as_scan_complete_task complete;
-			cf_queue_pop(task.complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-				status = complete.result;
-			}
+		while (as_task_caller_pending(&caller) > 0) {
+			as_scan_wait_task(task.complete_q, &caller, &status);
 		}
+		as_task_caller_destroy(&caller);
 		
 		// Release temporary queue.
 		cf_queue_destroy(task.complete_q);
@@ -825,19 +1068,62 @@ as_scan_partitions_validate(
 	return as_cluster_validate_size(cluster, err, n_nodes);
 }
 
+static void
+as_scan_checkpoint(as_partition_tracker* pt)
+{
+	// Intermediate checkpoint failures do not fail the scan.
+	as_error err;
+	as_error_init(&err);
+
+	if (as_partition_tracker_checkpoint_write(pt, false, &err) != AEROSPIKE_OK) {
+		as_log_warn("Scan checkpoint failed: %s", err.message);
+	}
+}
+
 static as_status
 as_scan_partitions(
 	as_cluster* cluster, as_error* err, const as_policy_scan* policy, const as_scan* scan,
-	as_partition_tracker* pt, aerospike_scan_foreach_callback callback, void* udata)
+	as_partition_tracker* pt, aerospike_scan_foreach_callback callback,
+	aerospike_scan_foreach_raw_callback raw_callback, void* udata)
 {
 	as_status status;
+	as_record_pipeline pipeline;
+	as_record_pipeline* pl = NULL;
+	as_scan_task parse_task;
+
+	if (policy->parse_threads > 0) {
+		// Parse task runs user callback without updating the partition tracker.
+		memset(&parse_task, 0, sizeof(as_scan_task));
+		parse_task.cluster = cluster;
+		parse_task.policy = policy;
+		parse_task.scan = scan;
+		parse_task.callback = callback;
+		parse_task.raw_callback = raw_callback;
+		parse_task.udata = udata;
+
+		int rc = as_record_pipeline_init(&pipeline, policy->parse_threads,
+			as_scan_parse_record_pipeline, &parse_task);
+
+		if (rc) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+				"Failed to create scan parse threads: %d", rc);
+		}
+		pl = &pipeline;
+	}
+
+	if (policy->checkpoint_file) {
+		// Parse threads deliver records after their cursors are set, so only checkpoint
+		// between iterations.
+		as_partition_tracker_checkpoint_init(pt, policy->checkpoint_file,
+			pl ? 0 : policy->checkpoint_records, pl ? 0 : policy->checkpoint_interval);
+	}
 
 	while (true) {
 		uint64_t task_id = as_random_get_uint64();
 		status = as_partition_tracker_assign(pt, cluster, scan->ns, err);
 
 		if (status != AEROSPIKE_OK) {
-			return status;
+			break;
 		}
 
 		uint32_t n_nodes = pt->node_parts.size;
@@ -850,50 +1136,79 @@ as_scan_partitions(
 		task.policy = policy;
 		task.scan = scan;
 		task.callback = callback;
+		task.raw_callback = raw_callback;
 		task.udata = udata;
 		task.err = err;
 		task.error_mutex = &error_mutex;
+		task.pipeline = pl;
+		task.reuse = NULL;
 		task.task_id = task_id;
 		task.cluster_key = 0;
+		task.chunk_size = 0;
 		task.first = false;
 
-		if (scan->concurrent && n_nodes > 1) {
-			uint32_t n_wait_nodes = n_nodes;
+		uint32_t streams = (pt->max_records == 0 && policy->streams_per_node > 1) ?
+			policy->streams_per_node : 1;
+
+		if (scan->concurrent && (n_nodes > 1 || streams > 1)) {
+			if (pt->max_records == 0) {
+				task.chunk_size = policy->partition_chunk;
+			}
+
 			task.complete_q = cf_queue_create(sizeof(as_scan_complete_task), true);
+			as_task_caller caller;
+			as_task_caller_init(&caller, &cluster->task_gate);
+			int rc = 0;
 
 			// Run node scans in parallel.
-			for (uint32_t i = 0; i < n_nodes; i++) {
-				// Stack allocate task for each node.  It should be fine since the task
-				// only needs to be valid within this function.
-				as_scan_task* task_node = alloca(sizeof(as_scan_task));
-				memcpy(task_node, &task, sizeof(as_scan_task));
+			for (uint32_t i = 0; i < n_nodes && rc == 0; i++) {
+				as_node_partitions* np = as_vector_get(&pt->node_parts, i);
+				uint32_t chunk_size = task.chunk_size;
 
-				task_node->np = as_vector_get(&pt->node_parts, i);
-				task_node->node = task_node->np->node;
+				if (streams > 1 && chunk_size == 0) {
+					// Split node's partitions evenly between its streams.
+					uint32_t n_parts = np->parts_full.size + np->parts_partial.size;
+					chunk_size = (n_parts + streams - 1) / streams;
 
-				int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_scan_worker, task_node);
-				
-				if (rc) {
-					// Thread could not be added. Abort entire scan.
-					if (as_fas_uint32(task.error_mutex, 1) == 0) {
-						status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add scan thread: %d", rc);
+					if (chunk_size == 0) {
+						chunk_size = 1;
+					}
+				}
+
+				// Streams of the same node take chunks from the node's partitions.
+				for (uint32_t s = 0; s < streams; s++) {
+					// Stack allocate task for each stream.  It should be fine since the task
+					// only needs to be valid within this function.
+					as_scan_task* task_node = alloca(sizeof(as_scan_task));
+					memcpy(task_node, &task, sizeof(as_scan_task));
+
+					task_node->np = np;
+					task_node->node = np->node;
+					task_node->chunk_size = chunk_size;
+
+					// Wait for one of this scan's tasks when its share of the thread pool is
+					// in use.
+					while (! as_task_caller_admit(&caller)) {
+						as_scan_wait_task(task.complete_q, &caller, &status);
+					}
+
+					rc = as_task_caller_queue(&caller, as_scan_worker, task_node);
+
+					if (rc) {
+						// Thread could not be added. Abort entire scan.
+						if (as_fas_uint32(task.error_mutex, 1) == 0) {
+							status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add scan thread: %d", rc);
+						}
+						break;
 					}
-					
-					// Reset node count to threads that were run.
-					n_wait_nodes = i;
-					break;
 				}
 			}
 
 			// Wait for tasks to complete.
-			for (uint32_t i = 0; i < n_wait_nodes; i++) {
-				as_scan_complete_task complete;
-				cf_queue_pop(task.complete_q, &complete, CF_QUEUE_FOREVER);
-				
-				if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-					status = complete.result;
-				}
+			while (as_task_caller_pending(&caller) > 0) {
+				as_scan_wait_task(task.complete_q, &caller, &status);
 			}
+			as_task_caller_destroy(&caller);
 			
 			// Release temporary queue.
 			cf_queue_destroy(task.complete_q);
@@ -909,6 +1224,15 @@ as_scan_partitions(
 			}
 		}
 
+		if (pl) {
+			// Partition status is complete only after queued records are delivered.
+			as_record_pipeline_drain(pl);
+
+			if (status == AEROSPIKE_OK) {
+				status = as_record_pipeline_status(pl, err);
+			}
+		}
+
 		// If user aborts query, command is considered successful.
 		if (status == AEROSPIKE_ERR_CLIENT_ABORT) {
 			status = AEROSPIKE_OK;
@@ -916,7 +1240,7 @@ as_scan_partitions(
 		}
 
 		if (status != AEROSPIKE_OK) {
-			return status;
+			break;
 		}
 
 		status = as_partition_tracker_is_complete(pt, cluster, err);
@@ -926,14 +1250,36 @@ as_scan_partitions(
 			break;
 		}
 
+		if (pt->checkpoint) {
+			as_scan_checkpoint(pt);
+		}
+
 		if (pt->sleep_between_retries > 0) {
 			// Sleep before trying again.
 			as_sleep(pt->sleep_between_retries);
 		}
 	}
 
+	if (pl) {
+		as_record_pipeline_destroy(pl);
+	}
+
+	if (pt->checkpoint) {
+		if (status == AEROSPIKE_OK) {
+			status = as_partition_tracker_checkpoint_write(pt, true, err);
+		}
+		else {
+			as_scan_checkpoint(pt);
+		}
+	}
+
 	if (status == AEROSPIKE_OK) {
-		callback(NULL, udata);
+		if (raw_callback) {
+			raw_callback(NULL, udata);
+		}
+		else {
+			callback(NULL, udata);
+		}
 	}
 	return status;
 }
@@ -969,7 +1315,7 @@ as_scan_partition_execute_async(as_async_scan_executor* se, as_partition_tracker
 		// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
 		// fragmentation and to allow socket read to reuse buffer.
 		size_t s = (sizeof(as_async_scan_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
-		as_async_scan_command* scmd = cf_malloc(s);
+		as_async_scan_command* scmd = as_alloc_malloc(s);
 		scmd->np = np;
 
 		as_event_command* cmd = (as_event_command*)scmd;
@@ -1024,7 +1370,7 @@ as_scan_partition_execute_async(as_async_scan_executor* se, as_partition_tracker
 		cmd->max_retries = 0;
 		cmd->iteration = 0;
 		cmd->replica = AS_POLICY_REPLICA_MASTER;
-		cmd->event_loop = ee->event_loop;
+		cmd->event_loop = as_event_executor_loop(ee, i);
 		cmd->cluster = se->cluster;
 		cmd->node = np->node;
 		// Reserve node because as_event_command_free() will release node
@@ -1032,6 +1378,8 @@ as_scan_partition_execute_async(as_async_scan_executor* se, as_partition_tracker
 		as_node_reserve(cmd->node);
 		cmd->ns = NULL;
 		cmd->partition = NULL;
+		cmd->latency_begin = 0;
+		cmd->stats_begin = 0;
 		cmd->udata = se;  // Overload udata to be the executor.
 		cmd->parse_results = as_scan_parse_records_async;
 		cmd->pipe_listener = NULL;
@@ -1042,6 +1390,11 @@ as_scan_partition_execute_async(as_async_scan_executor* se, as_partition_tracker
 		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 		cmd->flags = AS_ASYNC_FLAGS_MASTER;
 		cmd->flags2 = se->deserialize_list_map ? AS_ASYNC_FLAGS2_DESERIALIZE : 0;
+		cmd->priority = se->priority;
+
+		if (se->zero_copy) {
+			cmd->flags2 |= AS_ASYNC_FLAGS2_ZERO_COPY;
+		}
 		ee->commands[i] = cmd;
 	}
 
@@ -1058,21 +1411,38 @@ as_scan_partition_execute_async(as_async_scan_executor* se, as_partition_tracker
 			// as_event_executor_destroy() will release nodes that were not queued.
 			// as_event_executor_cancel() or as_event_executor_error() will eventually
 			// call as_event_executor_destroy().
-			if (pt->iteration == 1) {
+			if (pt->iteration == 1 && ! se->blocking) {
 				// On first iteration, cleanup and do not call listener.
 				as_scan_partition_executor_destroy(se);
 				as_event_executor_cancel(ee, i);
+				return status;
 			}
-			else {
-				// On retry, caller will cleanup and call listener.
-				as_event_executor_error(ee, err, n_nodes - i);
-			}
-			return status;
+
+			// On retry or blocking sync scan, caller will cleanup and call listener.
+			as_event_executor_error(ee, err, n_nodes - i);
+			return AEROSPIKE_OK;
 		}
 	}
 	return AEROSPIKE_OK;
 }
 
+static void
+as_scan_partition_abort_async(as_event_executor* ee)
+{
+	as_async_scan_executor* se = (as_async_scan_executor*)ee;
+	as_vector* list = &se->pt->node_parts;
+	as_node** nodes = alloca(sizeof(as_node*) * list->size);
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_node_partitions* np = as_vector_get(list, i);
+		nodes[i] = np->node;
+	}
+
+	// Retries store the task id without byte swap, so read it the way the server does.
+	uint64_t task_id = cf_swap_from_be64(*(uint64_t*)(se->cmd_buf + se->task_id_offset));
+	as_async_cancel_abort_nodes(ee->event_loop, "scan", task_id, nodes, list->size);
+}
+
 static as_status
 as_scan_partition_retry_async(as_async_scan_executor* se_old, as_error* err)
 {
@@ -1086,8 +1456,11 @@ as_scan_partition_retry_async(as_async_scan_executor* se_old, as_error* err)
 	se->cmd_size_post = se_old->cmd_size_post;
 	se->task_id_offset = se_old->task_id_offset;
 	se->n_fields = se_old->n_fields;
+	se->priority = se_old->priority;
 	se->concurrent = se_old->concurrent;
 	se->deserialize_list_map = se_old->deserialize_list_map;
+	se->zero_copy = se_old->zero_copy;
+	se->blocking = se_old->blocking;
 
 	// Must change task_id each round. Otherwise, server rejects command.
 	uint64_t task_id = as_random_get_uint64();
@@ -1107,11 +1480,23 @@ as_scan_partition_retry_async(as_async_scan_executor* se_old, as_error* err)
 	ee->err = NULL;
 	ee->ns = ee_old->ns;
 	ee_old->ns = NULL;
+	ee->flow = NULL;
+	ee->cancel = NULL;
+	ee->paused = NULL;
 	ee->cluster_key = 0;
 	ee->count = 0;
 	ee->queued = 0;
 	ee->notify = true;
 	ee->valid = true;
+	ee->spread = ee_old->spread;
+
+	if (ee_old->flow) {
+		as_async_flow_attach(ee_old->flow, ee);
+	}
+
+	if (ee_old->cancel) {
+		as_async_cancel_attach(ee_old->cancel, ee, as_scan_partition_abort_async);
+	}
 
 	return as_scan_partition_execute_async(se, se->pt, err);
 }
@@ -1120,7 +1505,7 @@ static as_status
 as_scan_partition_async(
 	as_cluster* cluster, as_error* err, const as_policy_scan* policy, const as_scan* scan,
 	as_partition_tracker* pt, as_async_scan_listener listener, void* udata,
-	as_event_loop* event_loop
+	as_event_loop* event_loop, bool blocking
 	)
 {
 	pt->sleep_between_retries = 0;
@@ -1161,8 +1546,11 @@ as_scan_partition_async(
 	se->cmd_size_post = sb.cmd_size_post;
 	se->task_id_offset = sb.task_id_offset;
 	se->n_fields = sb.n_fields;
+	se->priority = (uint8_t)policy->base.priority;
 	se->concurrent = scan->concurrent;
 	se->deserialize_list_map = scan->deserialize_list_map;
+	se->zero_copy = policy->zero_copy;
+	se->blocking = blocking;
 
 	uint32_t n_nodes = pt->node_parts.size;
 
@@ -1176,15 +1564,87 @@ as_scan_partition_async(
 	ee->udata = udata;
 	ee->err = NULL;
 	ee->ns = cf_strdup(scan->ns);
+	ee->flow = NULL;
+	ee->cancel = NULL;
+	ee->paused = NULL;
 	ee->cluster_key = 0;
 	ee->count = 0;
 	ee->queued = 0;
 	ee->notify = true;
 	ee->valid = true;
+	// Blocking sync scans deliver records one at a time, so they stay on one event loop.
+	ee->spread = policy->spread_loops && ! policy->flow && ! blocking &&
+		as_event_loop_size > 1;
+
+	if (policy->flow && ! blocking) {
+		// Blocking sync scans do not release records, so flow control does not apply.
+		as_async_flow_attach(policy->flow, ee);
+	}
+
+	if (policy->cancel && ! blocking) {
+		as_async_cancel_attach(policy->cancel, ee, as_scan_partition_abort_async);
+	}
 
 	return as_scan_partition_execute_async(se, pt, err);
 }
 
+static bool
+as_scan_mux_listener(as_error* err, as_record* record, void* udata, as_event_loop* event_loop)
+{
+	as_scan_mux* mux = udata;
+
+	if (record) {
+		return mux->callback((as_val*)record, mux->udata);
+	}
+
+	// If user aborts scan, command is considered successful.
+	if (err && err->code != AEROSPIKE_ERR_CLIENT_ABORT) {
+		// Start errors are reported with the caller's error structure.
+		if (err != mux->err) {
+			as_error_copy(mux->err, err);
+		}
+		mux->status = err->code;
+	}
+	else {
+		mux->callback(NULL, mux->udata);
+	}
+	as_monitor_notify(&mux->monitor);
+	return true;
+}
+
+static as_status
+as_scan_foreach_mux(
+	as_cluster* cluster, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	uint32_t n_nodes, aerospike_scan_foreach_callback callback, void* udata
+	)
+{
+	as_partition_tracker* pt = cf_malloc(sizeof(as_partition_tracker));
+	as_partition_tracker_init_nodes(pt, cluster, &policy->base, policy->max_records,
+		&scan->parts_all, scan->paginate, n_nodes);
+
+	// Drive all node scans on an event loop and block until the scan completes.
+	as_scan_mux mux;
+	as_monitor_init(&mux.monitor);
+	mux.callback = callback;
+	mux.udata = udata;
+	mux.err = err;
+	mux.status = AEROSPIKE_OK;
+
+	as_status status = as_scan_partition_async(cluster, err, policy, scan, pt,
+		as_scan_mux_listener, &mux, NULL, true);
+
+	if (status == AEROSPIKE_OK) {
+		as_monitor_wait(&mux.monitor);
+		status = mux.status;
+	}
+	as_monitor_destroy(&mux.monitor);
+
+	if (status != AEROSPIKE_OK) {
+		as_partition_error(scan->parts_all);
+	}
+	return status;
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -1219,6 +1679,16 @@ aerospike_scan_wait(
 	return aerospike_job_wait(as, err, policy, "scan", scan_id, interval_ms);
 }
 
+as_status
+aerospike_scan_wait_async(
+	aerospike* as, as_error* err, const as_policy_info* policy, uint64_t scan_id,
+	uint32_t interval_ms, as_async_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	return aerospike_job_wait_async(as, err, policy, "scan", scan_id, interval_ms, listener,
+		udata, event_loop);
+}
+
 as_status
 aerospike_scan_info(
 	aerospike* as, as_error* err, const as_policy_info* policy, uint64_t scan_id, as_scan_info* info
@@ -1265,11 +1735,48 @@ aerospike_scan_foreach(
 		return status;
 	}
 
+	if (scan->concurrent && policy->multiplex && n_nodes > 1 && as_event_can_block()) {
+		return as_scan_foreach_mux(cluster, err, policy, scan, n_nodes, callback, udata);
+	}
+
 	as_partition_tracker pt;
 	as_partition_tracker_init_nodes(&pt, cluster, &policy->base, policy->max_records,
 		&scan->parts_all, scan->paginate, n_nodes);
 
-	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, udata);
+	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, NULL, udata);
+
+	if (status != AEROSPIKE_OK) {
+		as_partition_error(scan->parts_all);
+	}
+	as_partition_tracker_destroy(&pt);
+	return status;
+}
+
+as_status
+aerospike_scan_foreach_raw(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	aerospike_scan_foreach_raw_callback callback, void* udata
+	)
+{
+	if (! policy) {
+		policy = &as->config.policies.scan;
+	}
+
+	as_cluster* cluster = as->cluster;
+	uint32_t n_nodes;
+	as_status status = as_scan_partitions_validate(cluster, err, policy, scan, &n_nodes);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	// Multiplexed scans decode records in the async parser, so node scans always use
+	// the sync parser here.
+	as_partition_tracker pt;
+	as_partition_tracker_init_nodes(&pt, cluster, &policy->base, policy->max_records,
+		&scan->parts_all, scan->paginate, n_nodes);
+
+	status = as_scan_partitions(cluster, err, policy, scan, &pt, NULL, callback, udata);
 
 	if (status != AEROSPIKE_OK) {
 		as_partition_error(scan->parts_all);
@@ -1308,7 +1815,7 @@ aerospike_scan_node(
 	as_partition_tracker_init_node(&pt, cluster, &policy->base, policy->max_records,
 		&scan->parts_all, scan->paginate, node);
 
-	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, udata);
+	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, NULL, udata);
 
 	if (status != AEROSPIKE_OK) {
 		as_partition_error(scan->parts_all);
@@ -1318,10 +1825,11 @@ aerospike_scan_node(
 	return status;
 }
 
-as_status
-aerospike_scan_partitions(
+static as_status
+as_scan_partitions_filter(
 	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
-	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
+	as_partition_filter* pf, aerospike_scan_foreach_callback callback,
+	aerospike_scan_foreach_raw_callback raw_callback, void* udata
 	)
 {
 	as_cluster* cluster = as->cluster;
@@ -1349,7 +1857,7 @@ aerospike_scan_partitions(
 		return status;
 	}
 
-	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, udata);
+	status = as_scan_partitions(cluster, err, policy, scan, &pt, callback, raw_callback, udata);
 
 	if (status != AEROSPIKE_OK) {
 		as_partition_error(scan->parts_all);
@@ -1358,6 +1866,188 @@ aerospike_scan_partitions(
 	return status;
 }
 
+as_status
+aerospike_scan_partitions(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
+	)
+{
+	return as_scan_partitions_filter(as, err, policy, scan, pf, callback, NULL, udata);
+}
+
+as_status
+aerospike_scan_partitions_raw(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_raw_callback callback, void* udata
+	)
+{
+	return as_scan_partitions_filter(as, err, policy, scan, pf, NULL, callback, udata);
+}
+
+static bool
+as_scan_lease_callback(const as_val* val, void* udata)
+{
+	as_scan_lease_task* task = udata;
+
+	if (! val) {
+		// End of chunk. The user callback is notified once after all chunks.
+		return true;
+	}
+
+	if (as_load_uint8(&task->state) != AS_SCAN_LEASE_RUNNING) {
+		return false;
+	}
+
+	uint64_t now = cf_getms();
+	uint64_t renew_at = as_load_uint64(&task->renew_at);
+
+	// Only one thread renews when the scan is concurrent.
+	if (now >= renew_at && as_cas_uint64(&task->renew_at, renew_at, now + task->lease_ms / 3)) {
+		if (! task->store->renew(task->store->udata, task->lease, task->lease_ms)) {
+			as_store_uint8(&task->state, AS_SCAN_LEASE_LOST);
+			return false;
+		}
+	}
+
+	if (! task->callback(val, task->udata)) {
+		as_store_uint8(&task->state, AS_SCAN_LEASE_ABORTED);
+		return false;
+	}
+	return true;
+}
+
+as_status
+aerospike_scan_leased(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_scan_lease_store* store, uint32_t lease_ms, aerospike_scan_foreach_callback callback,
+	void* udata
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.scan;
+	}
+
+	if (lease_ms == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "lease_ms must be positive");
+	}
+
+	if (policy->max_records > 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"max_records is not supported in leased scans");
+	}
+
+	if (scan->parts_all) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"scan.parts_all is not supported in leased scans");
+	}
+
+	// Pagination keeps the partition status of each chunk in scan->parts_all, so the
+	// cursors can be handed to the next worker.
+	bool paginate = scan->paginate;
+	scan->paginate = true;
+
+	uint32_t wait_ms = lease_ms / 10;
+
+	if (wait_ms == 0) {
+		wait_ms = 1;
+	}
+	else if (wait_ms > 1000) {
+		wait_ms = 1000;
+	}
+
+	as_status status = AEROSPIKE_OK;
+
+	while (true) {
+		as_scan_lease lease;
+		as_scan_lease_result rv = store->acquire(store->udata, lease_ms, &lease);
+
+		if (rv == AS_SCAN_LEASE_DONE) {
+			break;
+		}
+
+		if (rv == AS_SCAN_LEASE_WAIT) {
+			// Other workers hold the remaining chunks. Poll until they finish or their
+			// leases expire.
+			as_sleep(wait_ms);
+			continue;
+		}
+
+		as_partitions_status* resume = NULL;
+
+		if (lease.cursor) {
+			resume = as_partitions_status_from_bytes(lease.cursor, lease.cursor_size);
+			cf_free(lease.cursor);
+
+			if (resume && (resume->part_begin != lease.part_begin ||
+				resume->part_count != lease.part_count)) {
+				as_partitions_status_release(resume);
+				resume = NULL;
+			}
+		}
+
+		as_partition_filter pf;
+
+		if (resume) {
+			as_partition_filter_set_partitions(&pf, resume);
+		}
+		else {
+			// Chunk was never started or its cursor is not usable. Scan the whole chunk.
+			as_partition_filter_set_range(&pf, lease.part_begin, lease.part_count);
+		}
+
+		as_scan_lease_task task = {
+			.callback = callback,
+			.udata = udata,
+			.store = store,
+			.lease = &lease,
+			.renew_at = cf_getms() + lease_ms / 3,
+			.lease_ms = lease_ms,
+			.state = AS_SCAN_LEASE_RUNNING
+		};
+
+		status = as_scan_partitions_filter(as, err, policy, scan, &pf, as_scan_lease_callback,
+			NULL, &task);
+
+		if (resume) {
+			as_partitions_status_release(resume);
+		}
+
+		as_partitions_status* parts_all = scan->parts_all;
+		scan->parts_all = NULL;
+
+		if (task.state != AS_SCAN_LEASE_LOST) {
+			// A lost chunk belongs to the worker that took it over.
+			bool done = status == AEROSPIKE_OK && task.state == AS_SCAN_LEASE_RUNNING &&
+				parts_all && parts_all->done;
+			uint8_t* bytes = NULL;
+			uint32_t bytes_size = 0;
+
+			if (! done && parts_all) {
+				as_partitions_status_to_bytes(parts_all, &bytes, &bytes_size);
+			}
+			store->release(store->udata, &lease, bytes, bytes_size, done);
+			cf_free(bytes);
+		}
+
+		if (parts_all) {
+			as_partitions_status_release(parts_all);
+		}
+
+		if (status != AEROSPIKE_OK || task.state == AS_SCAN_LEASE_ABORTED) {
+			break;
+		}
+	}
+
+	scan->paginate = paginate;
+
+	if (status == AEROSPIKE_OK) {
+		callback(NULL, udata);
+	}
+	return status;
+}
+
 as_status
 aerospike_scan_async(
 	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
@@ -1386,7 +2076,8 @@ aerospike_scan_async(
 	as_partition_tracker_init_nodes(pt, cluster, &policy->base, policy->max_records,
 		&scan->parts_all, scan->paginate, n_nodes);
 
-	return as_scan_partition_async(cluster, err, policy, scan, pt, listener, udata, event_loop);
+	return as_scan_partition_async(cluster, err, policy, scan, pt, listener, udata, event_loop,
+		false);
 }
 
 as_status
@@ -1420,7 +2111,7 @@ aerospike_scan_node_async(
 		&scan->parts_all, scan->paginate, node);
 
 	status = as_scan_partition_async(cluster, err, policy, scan, pt, listener, udata,
-									 event_loop);
+									 event_loop, false);
 
 	if (status != AEROSPIKE_OK) {
 		as_node_release(node);
@@ -1459,5 +2150,6 @@ aerospike_scan_partitions_async(
 		cf_free(pt);
 		return status;
 	}
-	return as_scan_partition_async(cluster, err, policy, scan, pt, listener, udata, event_loop);
+	return as_scan_partition_async(cluster, err, policy, scan, pt, listener, udata, event_loop,
+		false);
 }
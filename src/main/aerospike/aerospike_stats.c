@@ -18,6 +18,11 @@
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_node.h>
 #include <aerospike/as_string_builder.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 /******************************************************************************
  * GLOBALS
@@ -38,6 +43,10 @@ as_sum_init(as_conn_stats* stats)
 	stats->in_use = 0;
 	stats->opened = 0;
 	stats->closed = 0;
+	stats->ktls = 0;
+	stats->closed_idle = 0;
+	stats->closed_error = 0;
+	stats->closed_balance = 0;
 }
 
 static inline void
@@ -77,6 +86,141 @@ as_conn_stats_tostring(as_string_builder* sb, const char* title, as_conn_stats*
 	as_string_builder_append_char(sb, ')');
 }
 
+static void
+as_histogram_tostring(as_string_builder* sb, const char* name, const char* label, uint64_t* buckets)
+{
+	// Only show histograms with samples and buckets that are not empty. Buckets are
+	// labeled by their lower bound in microseconds.
+	bool first = true;
+
+	for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+		if (buckets[b] == 0) {
+			continue;
+		}
+
+		if (first) {
+			as_string_builder_append(sb, name);
+			as_string_builder_append(sb, label);
+			first = false;
+		}
+		else {
+			as_string_builder_append_char(sb, ',');
+		}
+		as_string_builder_append_uint64(sb, (b == 0)? 0 : (uint64_t)1 << (b - 1));
+		as_string_builder_append_char(sb, ':');
+		as_string_builder_append_uint64(sb, buckets[b]);
+	}
+
+	if (! first) {
+		as_string_builder_append_newline(sb);
+	}
+}
+
+static void
+as_latency_tostring(as_string_builder* sb, as_node_stats* node_stats)
+{
+	for (uint32_t t = 0; t < AS_LATENCY_TYPE_MAX; t++) {
+		as_histogram_tostring(sb, as_latency_type_name((as_latency_type)t),
+			" latency(minUs:count): ", node_stats->latency[t]);
+	}
+
+	for (uint32_t t = 0; t < AS_CONN_LATENCY_MAX; t++) {
+		as_histogram_tostring(sb, as_conn_latency_type_name((as_conn_latency_type)t),
+			" conn latency(minUs:count): ", node_stats->conn_latency[t]);
+	}
+}
+
+static void
+as_digest_tohex(const uint8_t* digest, char* hex)
+{
+	static const char digits[] = "0123456789abcdef";
+
+	for (uint32_t i = 0; i < AS_DIGEST_VALUE_SIZE; i++) {
+		hex[i * 2] = digits[digest[i] >> 4];
+		hex[i * 2 + 1] = digits[digest[i] & 0xf];
+	}
+	hex[AS_DIGEST_VALUE_SIZE * 2] = 0;
+}
+
+static void
+as_hot_keys_tostring(
+	as_string_builder* sb, const char* title, as_hot_key* keys, uint32_t size, bool digest
+	)
+{
+	as_string_builder_append(sb, title);
+
+	for (uint32_t i = 0; i < size; i++) {
+		as_hot_key* hk = &keys[i];
+
+		if (i > 0) {
+			as_string_builder_append_char(sb, ' ');
+		}
+		as_string_builder_append(sb, hk->ns);
+		as_string_builder_append_char(sb, ':');
+
+		if (digest) {
+			char hex[AS_DIGEST_VALUE_SIZE * 2 + 1];
+			as_digest_tohex(hk->digest, hex);
+			as_string_builder_append(sb, hex);
+		}
+		else {
+			as_string_builder_append_uint(sb, hk->partition_id);
+		}
+		as_string_builder_append_char(sb, ',');
+		as_string_builder_append_uint64(sb, hk->count);
+		as_string_builder_append_char(sb, ',');
+		as_string_builder_append_uint64(sb, hk->error);
+		as_string_builder_append_char(sb, ',');
+		as_string_builder_append_uint64(sb, hk->bytes);
+	}
+	as_string_builder_append_newline(sb);
+}
+
+static void
+as_counters_sum(as_command_counters* sum, as_command_counters* c)
+{
+	sum->commands += as_load_uint64(&c->commands);
+	sum->retries += as_load_uint64(&c->retries);
+	sum->socket_timeouts += as_load_uint64(&c->socket_timeouts);
+	sum->total_timeouts += as_load_uint64(&c->total_timeouts);
+	sum->bytes_out += as_load_uint64(&c->bytes_out);
+	sum->bytes_in += as_load_uint64(&c->bytes_in);
+	sum->compressed_out += as_load_uint64(&c->compressed_out);
+	sum->uncompressed_out += as_load_uint64(&c->uncompressed_out);
+	sum->compressed_in += as_load_uint64(&c->compressed_in);
+	sum->uncompressed_in += as_load_uint64(&c->uncompressed_in);
+	sum->delay_queue_rejects += as_load_uint64(&c->delay_queue_rejects);
+	sum->overload_rejects += as_load_uint64(&c->overload_rejects);
+}
+
+static void
+as_counters_tostring(as_string_builder* sb, as_command_counters* c)
+{
+	as_string_builder_append(sb, "commands(sent,retries,socketTimeouts,totalTimeouts): ");
+	as_string_builder_append_uint64(sb, c->commands);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->retries);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->socket_timeouts);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->total_timeouts);
+	as_string_builder_append_newline(sb);
+	as_string_builder_append(sb,
+		"bytes(out,in,compressedOut,uncompressedOut,compressedIn,uncompressedIn): ");
+	as_string_builder_append_uint64(sb, c->bytes_out);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->bytes_in);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->compressed_out);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->uncompressed_out);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->compressed_in);
+	as_string_builder_append_char(sb, ',');
+	as_string_builder_append_uint64(sb, c->uncompressed_in);
+	as_string_builder_append_newline(sb);
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -84,9 +228,30 @@ as_conn_stats_tostring(as_string_builder* sb, const char* title, as_conn_stats*
 void
 aerospike_cluster_stats(as_cluster* cluster, as_cluster_stats* stats)
 {
+	stats->nodes = NULL;
+	stats->nodes_size = 0;
+	stats->nodes_capacity = 0;
+	stats->event_loops = NULL;
+	stats->event_loops_size = 0;
+	aerospike_cluster_stats_update(cluster, stats);
+}
+
+void
+aerospike_cluster_stats_update(as_cluster* cluster, as_cluster_stats* stats)
+{
+	// Release nodes of previous refresh.
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		aerospike_node_stats_destroy(&stats->nodes[i]);
+	}
+
 	// Node stats.
 	as_nodes* nodes = as_nodes_reserve(cluster);
-	stats->nodes = cf_malloc(sizeof(as_node_stats) * nodes->size);
+
+	if (! stats->nodes || nodes->size > stats->nodes_capacity) {
+		cf_free(stats->nodes);
+		stats->nodes = cf_malloc(sizeof(as_node_stats) * nodes->size);
+		stats->nodes_capacity = nodes->size;
+	}
 	stats->nodes_size = nodes->size;
 
 	for (uint32_t i = 0; i < nodes->size; i++) {
@@ -94,10 +259,12 @@ aerospike_cluster_stats(as_cluster* cluster, as_cluster_stats* stats)
 	}
 	as_nodes_release(nodes);
 
-	// Event loop stats.
+	// Event loop stats. The event loop count is fixed once event loops are created.
 	if (as_event_loop_capacity > 0) {
+		if (! stats->event_loops) {
+			stats->event_loops = cf_malloc(sizeof(as_event_loop_stats) * as_event_loop_size);
+		}
 		stats->event_loops_size = as_event_loop_size;
-		stats->event_loops = cf_malloc(sizeof(as_event_loop_stats) * stats->event_loops_size);
 
 		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
 			aerospike_event_loop_stats(&as_event_loops[i], &stats->event_loops[i]);
@@ -105,11 +272,27 @@ aerospike_cluster_stats(as_cluster* cluster, as_cluster_stats* stats)
 	}
 	else {
 		stats->event_loops_size = 0;
-		stats->event_loops = NULL;
 	}
 
 	// cf_queue applies locks, so we are safe here.
-	stats->thread_pool_queued_tasks = cf_queue_sz(cluster->thread_pool.dispatch_queue);
+	stats->thread_pool_queued_tasks = as_task_gate_queued(&cluster->task_gate);
+	stats->thread_pool_wait_count = as_load_uint64(&cluster->task_gate.wait_count);
+	stats->thread_pool_wait_us = as_load_uint64(&cluster->task_gate.wait_us);
+	stats->retry_budget_rejects = as_load_uint64(&cluster->retry_budget_rejects);
+	stats->retry_budget_tokens = (uint32_t)(as_load_uint64(&cluster->retry_tokens) / 1000);
+	stats->startup_ms = as_load_uint8(&cluster->connecting) ? 0 : cluster->startup_ms;
+
+	if (cluster->hot_keys) {
+		stats->hot_keys_size = as_hot_keys_top(cluster->hot_keys, stats->hot_keys,
+			AS_HOT_KEYS_TOP);
+		stats->hot_partitions_size = as_hot_keys_top_partitions(cluster->hot_keys,
+			stats->hot_partitions, AS_HOT_KEYS_TOP);
+	}
+	else {
+		stats->hot_keys_size = 0;
+		stats->hot_partitions_size = 0;
+	}
+	as_memory_get_usage(stats->memory);
 }
 
 void
@@ -134,6 +317,34 @@ aerospike_node_stats(as_node* node, as_node_stats* stats)
 	as_node_reserve(node); // Released in aerospike_node_stats_destroy()
 	stats->node = node;
 	stats->error_count = as_node_get_error_count(node);
+	memset(stats->latency, 0, sizeof(stats->latency));
+	memset(stats->conn_latency, 0, sizeof(stats->conn_latency));
+
+	if (node->latency) {
+		// Sum histogram shards.
+		for (uint32_t s = 0; s < AS_LATENCY_SHARDS; s++) {
+			as_latency_shard* shard = &node->latency[s];
+
+			for (uint32_t t = 0; t < AS_LATENCY_TYPE_MAX; t++) {
+				for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+					stats->latency[t][b] += as_load_uint64(&shard->buckets[t][b]);
+				}
+			}
+
+			for (uint32_t t = 0; t < AS_CONN_LATENCY_MAX; t++) {
+				for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+					stats->conn_latency[t][b] += as_load_uint64(&shard->conn[t][b]);
+				}
+			}
+		}
+	}
+
+	// Sum counter shards.
+	memset(&stats->counters, 0, sizeof(stats->counters));
+
+	for (uint32_t s = 0; s < AS_COMMAND_COUNTER_SHARDS; s++) {
+		as_counters_sum(&stats->counters, &node->counters[s].counters);
+	}
 
 	as_sum_init(&stats->sync);
 	as_sum_init(&stats->async);
@@ -145,16 +356,27 @@ aerospike_node_stats(as_node* node, as_node_stats* stats)
 	for (uint32_t i = 0; i < max; i++) {
 		as_conn_pool* pool = &node->sync_conn_pools[i];
 
-		pthread_mutex_lock(&pool->lock);
-		uint32_t in_pool = as_queue_size(&pool->queue);
-		uint32_t total = pool->queue.total;
-		pthread_mutex_unlock(&pool->lock);
+		uint32_t in_pool = as_conn_pool_size(pool);
+		uint32_t total = as_conn_pool_total(pool);
+
+		stats->sync.in_pool += in_pool;
+		stats->sync.in_use += total - in_pool;
+	}
+
+	if (node->cluster->bulk_max_conns_per_node > 0) {
+		// Scan and query connections are reported with the other sync connections.
+		uint32_t in_pool = as_conn_pool_size(&node->bulk_conn_pool);
+		uint32_t total = as_conn_pool_total(&node->bulk_conn_pool);
 
 		stats->sync.in_pool += in_pool;
 		stats->sync.in_use += total - in_pool;
 	}
 	stats->sync.opened = node->sync_conns_opened;
 	stats->sync.closed = node->sync_conns_closed;
+	stats->sync.ktls = node->sync_conns_ktls;
+	stats->sync.closed_idle = node->sync_conns_closed_idle;
+	stats->sync.closed_error = node->sync_conns_closed_error;
+	stats->sync.closed_balance = node->sync_conns_closed_balance;
 
 	// Async connection summary.
 	if (as_event_loop_capacity > 0) {
@@ -186,6 +408,22 @@ aerospike_stats_to_string(as_cluster_stats* stats)
 		as_string_builder_append(&sb, "error count: ");
 		as_string_builder_append_uint(&sb, node_stats->error_count);
 		as_string_builder_append_newline(&sb);
+
+		as_string_builder_append(&sb, "sync closed(idle,error,balance): ");
+		as_string_builder_append_uint(&sb, node_stats->sync.closed_idle);
+		as_string_builder_append_char(&sb, ',');
+		as_string_builder_append_uint(&sb, node_stats->sync.closed_error);
+		as_string_builder_append_char(&sb, ',');
+		as_string_builder_append_uint(&sb, node_stats->sync.closed_balance);
+		as_string_builder_append_newline(&sb);
+
+		if (node_stats->sync.ktls > 0) {
+			as_string_builder_append(&sb, "ktls sync opened: ");
+			as_string_builder_append_uint(&sb, node_stats->sync.ktls);
+			as_string_builder_append_newline(&sb);
+		}
+		as_counters_tostring(&sb, &node_stats->counters);
+		as_latency_tostring(&sb, node_stats);
 	}
 
 	if (stats->event_loops) {
@@ -204,6 +442,426 @@ aerospike_stats_to_string(as_cluster_stats* stats)
 			as_string_builder_append_char(&sb, ')');
 		}
 		as_string_builder_append_newline(&sb);
+		as_string_builder_append(&sb, "event loop slabs(hits,misses,resident): ");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_event_loop_stats* ev_stats = &stats->event_loops[i];
+
+			if (i > 0) {
+				as_string_builder_append_char(&sb, ',');
+			}
+			as_string_builder_append_char(&sb, '(');
+			as_string_builder_append_uint64(&sb, ev_stats->slab_hits);
+			as_string_builder_append_char(&sb, ',');
+			as_string_builder_append_uint64(&sb, ev_stats->slab_misses);
+			as_string_builder_append_char(&sb, ',');
+			as_string_builder_append_uint64(&sb, ev_stats->slab_resident);
+			as_string_builder_append_char(&sb, ')');
+		}
+		as_string_builder_append_newline(&sb);
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_event_loop_stats* ev_stats = &stats->event_loops[i];
+			as_string_builder_append(&sb, "event loop ");
+			as_string_builder_append_uint(&sb, i);
+			as_string_builder_append_newline(&sb);
+			as_counters_tostring(&sb, &ev_stats->counters);
+			as_string_builder_append(&sb, "delay queue rejects: ");
+			as_string_builder_append_uint64(&sb, ev_stats->counters.delay_queue_rejects);
+			as_string_builder_append_newline(&sb);
+			as_string_builder_append(&sb, "overload rejects: ");
+			as_string_builder_append_uint64(&sb, ev_stats->counters.overload_rejects);
+			as_string_builder_append_newline(&sb);
+			as_histogram_tostring(&sb, "lag", "(minUs:count): ", ev_stats->lag);
+			as_histogram_tostring(&sb, "callbacks", "(minUs:count): ", ev_stats->callbacks);
+		}
+	}
+
+	as_string_builder_append(&sb, "thread pool(queued,started,waitUs): ");
+	as_string_builder_append_uint(&sb, stats->thread_pool_queued_tasks);
+	as_string_builder_append_char(&sb, ',');
+	as_string_builder_append_uint64(&sb, stats->thread_pool_wait_count);
+	as_string_builder_append_char(&sb, ',');
+	as_string_builder_append_uint64(&sb, stats->thread_pool_wait_us);
+	as_string_builder_append_newline(&sb);
+
+	as_string_builder_append(&sb, "retry budget(tokens,rejects): ");
+	as_string_builder_append_uint(&sb, stats->retry_budget_tokens);
+	as_string_builder_append_char(&sb, ',');
+	as_string_builder_append_uint64(&sb, stats->retry_budget_rejects);
+	as_string_builder_append_newline(&sb);
+
+	as_string_builder_append(&sb, "startup(ms): ");
+	as_string_builder_append_uint64(&sb, stats->startup_ms);
+	as_string_builder_append_newline(&sb);
+
+	if (stats->hot_keys_size > 0) {
+		as_hot_keys_tostring(&sb, "hot keys(ns:digest,count,error,bytes): ", stats->hot_keys,
+			stats->hot_keys_size, true);
+		as_hot_keys_tostring(&sb, "hot partitions(ns:id,count,error,bytes): ",
+			stats->hot_partitions, stats->hot_partitions_size, false);
+	}
+
+	as_string_builder_append(&sb, "memory(tag:current,peak): ");
+
+	for (uint32_t i = 0; i < AS_MEMORY_MAX; i++) {
+		if (i > 0) {
+			as_string_builder_append_char(&sb, ' ');
+		}
+		as_string_builder_append(&sb, as_memory_tag_name(i));
+		as_string_builder_append_char(&sb, ':');
+		as_string_builder_append_uint64(&sb, stats->memory[i].current);
+		as_string_builder_append_char(&sb, ',');
+		as_string_builder_append_uint64(&sb, stats->memory[i].peak);
 	}
+	as_string_builder_append_newline(&sb);
 	return sb.data;
 }
+
+/******************************************************************************
+ * PROMETHEUS EXPORT
+ *****************************************************************************/
+
+typedef struct {
+	char* buf;
+	size_t size;
+	size_t len;
+} as_prom_writer;
+
+typedef struct {
+	const char* name;
+	size_t offset;
+} as_prom_counter;
+
+static const as_prom_counter as_prom_counters[] = {
+	{"commands", offsetof(as_command_counters, commands)},
+	{"retries", offsetof(as_command_counters, retries)},
+	{"socket_timeouts", offsetof(as_command_counters, socket_timeouts)},
+	{"total_timeouts", offsetof(as_command_counters, total_timeouts)},
+	{"bytes_out", offsetof(as_command_counters, bytes_out)},
+	{"bytes_in", offsetof(as_command_counters, bytes_in)},
+	{"compressed_bytes_out", offsetof(as_command_counters, compressed_out)},
+	{"uncompressed_bytes_out", offsetof(as_command_counters, uncompressed_out)},
+	{"compressed_bytes_in", offsetof(as_command_counters, compressed_in)},
+	{"uncompressed_bytes_in", offsetof(as_command_counters, uncompressed_in)}
+};
+
+#define AS_PROM_COUNTERS_SIZE (sizeof(as_prom_counters) / sizeof(as_prom_counter))
+
+static void
+as_prom_printf(as_prom_writer* w, const char* fmt, ...)
+{
+	// Keep counting after the buffer is full, so the caller learns the required size.
+	size_t avail = (w->len < w->size)? w->size - w->len : 0;
+
+	va_list args;
+	va_start(args, fmt);
+	int n = vsnprintf(avail ? w->buf + w->len : NULL, avail, fmt, args);
+	va_end(args);
+
+	if (n > 0) {
+		w->len += (size_t)n;
+	}
+}
+
+static inline uint64_t
+as_prom_counter_get(as_command_counters* c, uint32_t i)
+{
+	return *(uint64_t*)((uint8_t*)c + as_prom_counters[i].offset);
+}
+
+static bool
+as_prom_empty(uint64_t* buckets)
+{
+	for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+		if (buckets[b]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+as_prom_histogram(
+	as_prom_writer* w, const char* name, const char* labels, uint64_t* buckets
+	)
+{
+	// Bucket b holds whole microsecond values up to 2^b - 1.
+	uint64_t sum = 0;
+
+	for (uint32_t b = 0; b < AS_LATENCY_BUCKETS - 1; b++) {
+		sum += buckets[b];
+		as_prom_printf(w, "%s_bucket{%s,le=\"%" PRIu64 "\"} %" PRIu64 "\n", name, labels,
+			((uint64_t)1 << b) - 1, sum);
+	}
+	sum += buckets[AS_LATENCY_BUCKETS - 1];
+	as_prom_printf(w, "%s_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n", name, labels, sum);
+	as_prom_printf(w, "%s_count{%s} %" PRIu64 "\n", name, labels, sum);
+}
+
+static void
+as_prom_conn_stats(as_prom_writer* w, const char* node, const char* pool, as_conn_stats* cs)
+{
+	as_prom_printf(w, "aerospike_client_connections{node=\"%s\",pool=\"%s\",state=\"in_use\"} %u\n",
+		node, pool, cs->in_use);
+	as_prom_printf(w, "aerospike_client_connections{node=\"%s\",pool=\"%s\",state=\"in_pool\"} %u\n",
+		node, pool, cs->in_pool);
+}
+
+size_t
+aerospike_stats_to_prometheus(as_cluster_stats* stats, char* buf, size_t size)
+{
+	as_prom_writer w = {buf, size, 0};
+	char labels[128];
+
+	if (size > 0) {
+		buf[0] = 0;
+	}
+
+	// Connections.
+	as_prom_printf(&w, "# TYPE aerospike_client_connections gauge\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+		as_prom_conn_stats(&w, ns->node->name, "sync", &ns->sync);
+		as_prom_conn_stats(&w, ns->node->name, "async", &ns->async);
+		as_prom_conn_stats(&w, ns->node->name, "pipeline", &ns->pipeline);
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_connections_opened_total counter\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+		const char* node = ns->node->name;
+		as_prom_printf(&w, "aerospike_client_connections_opened_total{node=\"%s\",pool=\"sync\"} %u\n",
+			node, ns->sync.opened);
+		as_prom_printf(&w, "aerospike_client_connections_opened_total{node=\"%s\",pool=\"async\"} %u\n",
+			node, ns->async.opened);
+		as_prom_printf(&w, "aerospike_client_connections_opened_total{node=\"%s\",pool=\"pipeline\"} %u\n",
+			node, ns->pipeline.opened);
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_connections_closed_total counter\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+		const char* node = ns->node->name;
+		as_prom_printf(&w, "aerospike_client_connections_closed_total{node=\"%s\",pool=\"sync\"} %u\n",
+			node, ns->sync.closed);
+		as_prom_printf(&w, "aerospike_client_connections_closed_total{node=\"%s\",pool=\"async\"} %u\n",
+			node, ns->async.closed);
+		as_prom_printf(&w, "aerospike_client_connections_closed_total{node=\"%s\",pool=\"pipeline\"} %u\n",
+			node, ns->pipeline.closed);
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_sync_connections_closed_reason_total counter\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+		const char* node = ns->node->name;
+		as_prom_printf(&w,
+			"aerospike_client_sync_connections_closed_reason_total{node=\"%s\",reason=\"idle\"} %u\n",
+			node, ns->sync.closed_idle);
+		as_prom_printf(&w,
+			"aerospike_client_sync_connections_closed_reason_total{node=\"%s\",reason=\"error\"} %u\n",
+			node, ns->sync.closed_error);
+		as_prom_printf(&w,
+			"aerospike_client_sync_connections_closed_reason_total{node=\"%s\",reason=\"balance\"} %u\n",
+			node, ns->sync.closed_balance);
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_node_errors gauge\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+		as_prom_printf(&w, "aerospike_client_node_errors{node=\"%s\"} %u\n", ns->node->name,
+			ns->error_count);
+	}
+
+	// Command counters by node.
+	for (uint32_t c = 0; c < AS_PROM_COUNTERS_SIZE; c++) {
+		const char* name = as_prom_counters[c].name;
+		as_prom_printf(&w, "# TYPE aerospike_client_%s_total counter\n", name);
+
+		for (uint32_t i = 0; i < stats->nodes_size; i++) {
+			as_node_stats* ns = &stats->nodes[i];
+			as_prom_printf(&w, "aerospike_client_%s_total{node=\"%s\"} %" PRIu64 "\n", name,
+				ns->node->name, as_prom_counter_get(&ns->counters, c));
+		}
+	}
+
+	// Latency histograms by node. Empty histograms are omitted.
+	as_prom_printf(&w, "# TYPE aerospike_client_command_latency_us histogram\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+
+		for (uint32_t t = 0; t < AS_LATENCY_TYPE_MAX; t++) {
+			if (as_prom_empty(ns->latency[t])) {
+				continue;
+			}
+			snprintf(labels, sizeof(labels), "node=\"%s\",type=\"%s\"", ns->node->name,
+				as_latency_type_name((as_latency_type)t));
+			as_prom_histogram(&w, "aerospike_client_command_latency_us", labels, ns->latency[t]);
+		}
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_connection_latency_us histogram\n");
+
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		as_node_stats* ns = &stats->nodes[i];
+
+		for (uint32_t t = 0; t < AS_CONN_LATENCY_MAX; t++) {
+			if (as_prom_empty(ns->conn_latency[t])) {
+				continue;
+			}
+			snprintf(labels, sizeof(labels), "node=\"%s\",phase=\"%s\"", ns->node->name,
+				as_conn_latency_type_name((as_conn_latency_type)t));
+			as_prom_histogram(&w, "aerospike_client_connection_latency_us", labels,
+				ns->conn_latency[t]);
+		}
+	}
+
+	// Event loops.
+	if (stats->event_loops_size > 0) {
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_process_size gauge\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_prom_printf(&w, "aerospike_client_event_loop_process_size{loop=\"%u\"} %d\n", i,
+				stats->event_loops[i].process_size);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_queue_size gauge\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_prom_printf(&w, "aerospike_client_event_loop_queue_size{loop=\"%u\"} %u\n", i,
+				stats->event_loops[i].queue_size);
+		}
+
+		for (uint32_t c = 0; c < AS_PROM_COUNTERS_SIZE; c++) {
+			const char* name = as_prom_counters[c].name;
+			as_prom_printf(&w, "# TYPE aerospike_client_event_loop_%s_total counter\n", name);
+
+			for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+				as_prom_printf(&w, "aerospike_client_event_loop_%s_total{loop=\"%u\"} %" PRIu64 "\n",
+					name, i, as_prom_counter_get(&stats->event_loops[i].counters, c));
+			}
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_delay_queue_rejects_total counter\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_prom_printf(&w,
+				"aerospike_client_event_loop_delay_queue_rejects_total{loop=\"%u\"} %" PRIu64 "\n",
+				i, stats->event_loops[i].counters.delay_queue_rejects);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_overload_rejects_total counter\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			as_prom_printf(&w,
+				"aerospike_client_event_loop_overload_rejects_total{loop=\"%u\"} %" PRIu64 "\n",
+				i, stats->event_loops[i].counters.overload_rejects);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_lag_us histogram\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			if (! as_prom_empty(stats->event_loops[i].lag)) {
+				snprintf(labels, sizeof(labels), "loop=\"%u\"", i);
+				as_prom_histogram(&w, "aerospike_client_event_loop_lag_us", labels,
+					stats->event_loops[i].lag);
+			}
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_event_loop_callback_us histogram\n");
+
+		for (uint32_t i = 0; i < stats->event_loops_size; i++) {
+			if (! as_prom_empty(stats->event_loops[i].callbacks)) {
+				snprintf(labels, sizeof(labels), "loop=\"%u\"", i);
+				as_prom_histogram(&w, "aerospike_client_event_loop_callback_us", labels,
+					stats->event_loops[i].callbacks);
+			}
+		}
+	}
+
+	// Thread pool.
+	as_prom_printf(&w, "# TYPE aerospike_client_thread_pool_queued gauge\n");
+	as_prom_printf(&w, "aerospike_client_thread_pool_queued %u\n", stats->thread_pool_queued_tasks);
+	as_prom_printf(&w, "# TYPE aerospike_client_thread_pool_started_total counter\n");
+	as_prom_printf(&w, "aerospike_client_thread_pool_started_total %" PRIu64 "\n",
+		stats->thread_pool_wait_count);
+	as_prom_printf(&w, "# TYPE aerospike_client_thread_pool_wait_us_total counter\n");
+	as_prom_printf(&w, "aerospike_client_thread_pool_wait_us_total %" PRIu64 "\n",
+		stats->thread_pool_wait_us);
+
+	// Retry budget.
+	as_prom_printf(&w, "# TYPE aerospike_client_retry_budget_tokens gauge\n");
+	as_prom_printf(&w, "aerospike_client_retry_budget_tokens %u\n", stats->retry_budget_tokens);
+	as_prom_printf(&w, "# TYPE aerospike_client_retry_budget_rejects_total counter\n");
+	as_prom_printf(&w, "aerospike_client_retry_budget_rejects_total %" PRIu64 "\n",
+		stats->retry_budget_rejects);
+
+	// Startup.
+	as_prom_printf(&w, "# TYPE aerospike_client_startup_ms gauge\n");
+	as_prom_printf(&w, "aerospike_client_startup_ms %" PRIu64 "\n", stats->startup_ms);
+
+	// Hot keys and partitions.
+	if (stats->hot_keys_size > 0) {
+		as_prom_printf(&w, "# TYPE aerospike_client_hot_key_commands gauge\n");
+
+		for (uint32_t i = 0; i < stats->hot_keys_size; i++) {
+			as_hot_key* hk = &stats->hot_keys[i];
+			char hex[AS_DIGEST_VALUE_SIZE * 2 + 1];
+			as_digest_tohex(hk->digest, hex);
+			as_prom_printf(&w,
+				"aerospike_client_hot_key_commands{ns=\"%s\",digest=\"%s\",partition=\"%u\"} %"
+				PRIu64 "\n", hk->ns, hex, hk->partition_id, hk->count);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_hot_key_bytes gauge\n");
+
+		for (uint32_t i = 0; i < stats->hot_keys_size; i++) {
+			as_hot_key* hk = &stats->hot_keys[i];
+			char hex[AS_DIGEST_VALUE_SIZE * 2 + 1];
+			as_digest_tohex(hk->digest, hex);
+			as_prom_printf(&w,
+				"aerospike_client_hot_key_bytes{ns=\"%s\",digest=\"%s\",partition=\"%u\"} %"
+				PRIu64 "\n", hk->ns, hex, hk->partition_id, hk->bytes);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_hot_partition_commands gauge\n");
+
+		for (uint32_t i = 0; i < stats->hot_partitions_size; i++) {
+			as_hot_key* hp = &stats->hot_partitions[i];
+			as_prom_printf(&w,
+				"aerospike_client_hot_partition_commands{ns=\"%s\",partition=\"%u\"} %" PRIu64
+				"\n", hp->ns, hp->partition_id, hp->count);
+		}
+
+		as_prom_printf(&w, "# TYPE aerospike_client_hot_partition_bytes gauge\n");
+
+		for (uint32_t i = 0; i < stats->hot_partitions_size; i++) {
+			as_hot_key* hp = &stats->hot_partitions[i];
+			as_prom_printf(&w,
+				"aerospike_client_hot_partition_bytes{ns=\"%s\",partition=\"%u\"} %" PRIu64
+				"\n", hp->ns, hp->partition_id, hp->bytes);
+		}
+	}
+
+	// Memory.
+	as_prom_printf(&w, "# TYPE aerospike_client_memory_bytes gauge\n");
+
+	for (uint32_t i = 0; i < AS_MEMORY_MAX; i++) {
+		as_prom_printf(&w, "aerospike_client_memory_bytes{tag=\"%s\"} %" PRIu64 "\n",
+			as_memory_tag_name(i), stats->memory[i].current);
+	}
+
+	as_prom_printf(&w, "# TYPE aerospike_client_memory_peak_bytes gauge\n");
+
+	for (uint32_t i = 0; i < AS_MEMORY_MAX; i++) {
+		as_prom_printf(&w, "aerospike_client_memory_peak_bytes{tag=\"%s\"} %" PRIu64 "\n",
+			as_memory_tag_name(i), stats->memory[i].peak);
+	}
+	return w.len;
+}
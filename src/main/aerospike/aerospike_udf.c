@@ -37,8 +37,111 @@ typedef struct as_udf_file_ptr_s {
 	char* type;
 } as_udf_file_ptr;
 
+typedef struct as_udf_registration_s {
+	char name[AS_UDF_FILE_NAME_SIZE];
+	char hash[AS_UDF_FILE_HASH_SIZE + 1];
+} as_udf_registration;
+
 char* as_udf_type_str[] = {"LUA", 0};
 
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_udf_hash(const uint8_t* content, uint32_t size, char* out)
+{
+	// Same hex encoded SHA1 hash that the server returns in udf-list.
+	unsigned char hash[CF_SHA_DIGEST_LENGTH];
+#ifdef __APPLE__
+	// Openssl is deprecated on mac, but the library is still included.
+	// Save old settings and disable deprecated warnings.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+	cf_SHA1(content, size, hash);
+#ifdef __APPLE__
+	// Restore old settings.
+#pragma GCC diagnostic pop
+#endif
+	char* at = out;
+
+	for (uint32_t i = 0; i < CF_SHA_DIGEST_LENGTH; i++) {
+		at += sprintf(at, "%02x", hash[i]);
+	}
+}
+
+static int
+as_udf_registered_find(as_cluster* cluster, const char* name)
+{
+	// Must hold udf_lock.
+	as_vector* list = cluster->udf_registered;
+
+	if (! list) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_udf_registration* reg = as_vector_get(list, i);
+
+		if (strcmp(reg->name, name) == 0) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+static bool
+as_udf_registered_get(as_cluster* cluster, const char* name, const char* hash)
+{
+	pthread_mutex_lock(&cluster->udf_lock);
+
+	int index = as_udf_registered_find(cluster, name);
+	bool found = index >= 0 &&
+		strcmp(((as_udf_registration*)as_vector_get(cluster->udf_registered, index))->hash,
+			hash) == 0;
+
+	pthread_mutex_unlock(&cluster->udf_lock);
+	return found;
+}
+
+static void
+as_udf_registered_set(as_cluster* cluster, const char* name, const char* hash)
+{
+	pthread_mutex_lock(&cluster->udf_lock);
+
+	int index = as_udf_registered_find(cluster, name);
+	as_udf_registration* reg;
+
+	if (index >= 0) {
+		reg = as_vector_get(cluster->udf_registered, index);
+	}
+	else {
+		if (! cluster->udf_registered) {
+			cluster->udf_registered = as_vector_create(sizeof(as_udf_registration), 8);
+		}
+		reg = as_vector_reserve(cluster->udf_registered);
+		as_strncpy(reg->name, name, sizeof(reg->name));
+	}
+	as_strncpy(reg->hash, hash, sizeof(reg->hash));
+
+	pthread_mutex_unlock(&cluster->udf_lock);
+}
+
+static void
+as_udf_registered_remove(as_cluster* cluster, const char* name)
+{
+	pthread_mutex_lock(&cluster->udf_lock);
+
+	int index = as_udf_registered_find(cluster, name);
+
+	if (index >= 0) {
+		as_vector_remove(cluster->udf_registered, (uint32_t)index);
+	}
+
+	pthread_mutex_unlock(&cluster->udf_lock);
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -220,23 +323,7 @@ aerospike_udf_get(
 	cf_b64_validate_and_decode_in_place((uint8_t*)content, len, &size);
 
 	// Update file hash
-	unsigned char hash[CF_SHA_DIGEST_LENGTH];
-#ifdef __APPLE__
-	// Openssl is deprecated on mac, but the library is still included.
-	// Save old settings and disable deprecated warnings.
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-	cf_SHA1((uint8_t*)content, size, hash);
-#ifdef __APPLE__
-	// Restore old settings.
-#pragma GCC diagnostic pop
-#endif
-	char* at = (char*)file->hash;
-
-	for (uint32_t i = 0; i < CF_SHA_DIGEST_LENGTH; i++) {
-		at += sprintf(at, "%02x", hash[i]);
-	}
+	as_udf_hash((uint8_t*)content, size, (char*)file->hash);
 
 	file->content._free = true;
 	file->content.size = size;
@@ -374,6 +461,8 @@ aerospike_udf_remove(
 		policy = &as->config.policies.info;
 	}
 	
+	as_udf_registered_remove(as->cluster, filename);
+
 	char command[512];
 	snprintf(command, sizeof(command), "udf-remove:filename=%s;", filename);
 	
@@ -440,3 +529,68 @@ aerospike_udf_remove_wait(
 
 	return AEROSPIKE_OK;
 }
+
+as_status
+aerospike_udf_ensure(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* filename,
+	as_udf_type type, as_bytes* content, uint32_t interval_ms, bool* uploaded
+	)
+{
+	as_error_reset(err);
+
+	if (uploaded) {
+		*uploaded = false;
+	}
+
+	if (type != AS_UDF_TYPE_LUA) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid udf type: %d", type);
+	}
+
+	if (! policy) {
+		policy = &as->config.policies.info;
+	}
+
+	as_cluster* cluster = as->cluster;
+	as_string filename_string;
+	const char* filebase = as_basename(&filename_string, filename);
+
+	char name[AS_UDF_FILE_NAME_SIZE];
+	as_strncpy(name, filebase, sizeof(name));
+	as_string_destroy(&filename_string);
+
+	char hash[AS_UDF_FILE_HASH_SIZE + 1];
+	as_udf_hash(content->value, content->size, hash);
+
+	if (as_udf_registered_get(cluster, name, hash)) {
+		return AEROSPIKE_OK;
+	}
+
+	// udf-list entry := filename=<name>,hash=<hash>,type=<type>;
+	char filter[256];
+	snprintf(filter, sizeof(filter), "filename=%s,hash=%s", name, hash);
+
+	if (! aerospike_udf_put_is_done(as, err, policy, filter)) {
+		as_status status = aerospike_udf_put(as, err, policy, filename, type, content);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (uploaded) {
+			*uploaded = true;
+		}
+
+		if (! interval_ms) {
+			interval_ms = 1000;
+		}
+
+		// Wait for the new content, not just the file name, which may already exist.
+		do {
+			as_sleep(interval_ms);
+		} while (! aerospike_udf_put_is_done(as, err, policy, filter));
+	}
+
+	as_error_reset(err);
+	as_udf_registered_set(cluster, name, hash);
+	return AEROSPIKE_OK;
+}
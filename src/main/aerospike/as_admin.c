@@ -457,6 +457,7 @@ as_cluster_login(
 
 	as_session* session = NULL;
 	uint64_t expiration = 0;
+	uint64_t refresh = 0;
 	int len;
 	uint8_t id;
 	p = buffer;
@@ -481,10 +482,25 @@ as_cluster_login(
 		}
 		else if (id == SESSION_TTL) {
 			// Subtract 60 seconds from ttl so client session expires before server session.
-			int64_t seconds = (int64_t)cf_swap_from_be32(*(uint32_t*)p) - 60;
+			int64_t ttl = (int64_t)cf_swap_from_be32(*(uint32_t*)p);
+			int64_t seconds = ttl - 60;
 
 			if (seconds > 0) {
-				expiration = cf_getns() + (seconds * 1000 * 1000 * 1000);
+				uint64_t now = cf_getns();
+				expiration = now + (seconds * 1000 * 1000 * 1000);
+
+				// Refresh ahead of expiration, but not more often than every half ttl.
+				int64_t margin_ms = cluster->session_refresh_ms;
+
+				if (margin_ms > ttl * 1000 / 2) {
+					margin_ms = ttl * 1000 / 2;
+				}
+
+				refresh = now + (ttl * 1000 - margin_ms) * 1000 * 1000;
+
+				if (refresh > expiration) {
+					refresh = expiration;
+				}
 			}
 			else {
 				as_log_warn("Invalid session TTL: %" PRIi64, seconds);
@@ -498,6 +514,7 @@ as_cluster_login(
 	}
 
 	session->expiration = expiration;
+	session->refresh = refresh;
 	node_info->session = session;
 	return AEROSPIKE_OK;
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_aggregate.h>
+#include <aerospike/as_udf.h>
+#include <aerospike/as_vector.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	char module[AS_UDF_MODULE_MAX_SIZE];
+	char function[AS_UDF_FUNCTION_MAX_SIZE];
+	as_aggregate_merge_fn merge;
+	void* udata;
+} as_aggregate_entry;
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+static pthread_mutex_t as_aggregate_lock = PTHREAD_MUTEX_INITIALIZER;
+static as_vector* as_aggregate_entries = NULL;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static int32_t
+as_aggregate_index(const char* module, const char* function)
+{
+	if (! as_aggregate_entries) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < as_aggregate_entries->size; i++) {
+		as_aggregate_entry* e = as_vector_get(as_aggregate_entries, i);
+
+		if (strcmp(e->module, module) == 0 && strcmp(e->function, function) == 0) {
+			return (int32_t)i;
+		}
+	}
+	return -1;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_aggregate_register(
+	const char* module, const char* function, as_aggregate_merge_fn merge, void* udata
+	)
+{
+	pthread_mutex_lock(&as_aggregate_lock);
+
+	int32_t index = as_aggregate_index(module, function);
+	as_aggregate_entry* e;
+
+	if (index >= 0) {
+		e = as_vector_get(as_aggregate_entries, index);
+	}
+	else {
+		if (! as_aggregate_entries) {
+			as_aggregate_entries = as_vector_create(sizeof(as_aggregate_entry), 8);
+		}
+		e = as_vector_reserve(as_aggregate_entries);
+		as_strncpy(e->module, module, sizeof(e->module));
+		as_strncpy(e->function, function, sizeof(e->function));
+	}
+	e->merge = merge;
+	e->udata = udata;
+	pthread_mutex_unlock(&as_aggregate_lock);
+}
+
+void
+as_aggregate_unregister(const char* module, const char* function)
+{
+	pthread_mutex_lock(&as_aggregate_lock);
+
+	int32_t index = as_aggregate_index(module, function);
+
+	if (index >= 0) {
+		as_vector_remove(as_aggregate_entries, index);
+	}
+	pthread_mutex_unlock(&as_aggregate_lock);
+}
+
+bool
+as_aggregate_find(
+	const char* module, const char* function, as_aggregate_merge_fn* merge, void** udata
+	)
+{
+	pthread_mutex_lock(&as_aggregate_lock);
+
+	int32_t index = as_aggregate_index(module, function);
+
+	if (index >= 0) {
+		as_aggregate_entry* e = as_vector_get(as_aggregate_entries, index);
+		*merge = e->merge;
+		*udata = e->udata;
+	}
+	pthread_mutex_unlock(&as_aggregate_lock);
+	return index >= 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_allocator.h>
+#include <string.h>
+
+/******************************************************************************
+ * GLOBAL VARIABLES
+ *****************************************************************************/
+
+as_allocator as_allocator_hooks;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+bool
+as_allocator_set(const as_allocator* allocator)
+{
+	if (! allocator) {
+		memset(&as_allocator_hooks, 0, sizeof(as_allocator));
+		return true;
+	}
+
+	if (! (allocator->malloc && allocator->calloc && allocator->realloc && allocator->free)) {
+		return false;
+	}
+
+	as_allocator_hooks = *allocator;
+	return true;
+}
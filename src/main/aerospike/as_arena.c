@@ -0,0 +1,62 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_arena.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_arena_chunk*
+as_arena_chunk_create(uint32_t capacity)
+{
+	// Round up, so the data offset stays aligned when chunks are sized exactly.
+	capacity = (capacity + 7) & ~7;
+
+	as_arena_chunk* chunk = cf_malloc(sizeof(as_arena_chunk) + capacity);
+
+	if (! chunk) {
+		return NULL;
+	}
+	chunk->next = NULL;
+	chunk->capacity = capacity;
+	chunk->offset = 0;
+	return chunk;
+}
+
+void
+as_arena_push(as_arena_chunk** head, as_arena_chunk* chunk)
+{
+	// The list is only walked after all pushes completed, so the link can be stored after
+	// the swap.
+	chunk->next = as_fas_ptr(head, chunk);
+}
+
+size_t
+as_arena_destroy(as_arena_chunk* head)
+{
+	size_t size = 0;
+
+	while (head) {
+		as_arena_chunk* next = head->next;
+		size += sizeof(as_arena_chunk) + head->capacity;
+		cf_free(head);
+		head = next;
+	}
+	return size;
+}
@@ -0,0 +1,510 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_arena_msgpack.h>
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_boolean.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_geojson.h>
+#include <aerospike/as_hashmap.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_nil.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_ARENA_UNPACK_CHUNK_MIN 1024
+#define AS_ARENA_UNPACK_CHUNK_MAX (1024 * 1024)
+#define AS_ARENA_UNPACK_MAX_DEPTH 256
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_arena_unpacker_s {
+	as_arena_chunk** arena;
+	const uint8_t* p;
+	const uint8_t* end;
+	uint32_t size;
+	uint32_t depth;
+} as_arena_unpacker;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static int
+as_arena_unpack_value(as_arena_unpacker* pk, as_val** value);
+
+static void*
+as_arena_unpack_alloc(as_arena_unpacker* pk, uint32_t size)
+{
+	as_arena_chunk* chunk = *pk->arena;
+
+	if (chunk) {
+		void* p = as_arena_alloc(chunk, size);
+
+		if (p) {
+			return p;
+		}
+	}
+
+	// Deserialized values are roughly an order of magnitude larger than their msgpack
+	// encoding, so the first chunk usually holds the entire value.
+	uint64_t capacity = chunk ? (uint64_t)chunk->capacity * 2 : (uint64_t)pk->size * 16;
+
+	if (capacity < AS_ARENA_UNPACK_CHUNK_MIN) {
+		capacity = AS_ARENA_UNPACK_CHUNK_MIN;
+	}
+	else if (capacity > AS_ARENA_UNPACK_CHUNK_MAX) {
+		capacity = AS_ARENA_UNPACK_CHUNK_MAX;
+	}
+
+	if (capacity < size) {
+		capacity = size;
+	}
+
+	chunk = as_arena_chunk_create((uint32_t)capacity);
+
+	if (! chunk) {
+		return NULL;
+	}
+	as_arena_push(pk->arena, chunk);
+	return as_arena_alloc(chunk, size);
+}
+
+static inline bool
+as_arena_unpack_uint(as_arena_unpacker* pk, uint32_t n, uint64_t* v)
+{
+	if ((size_t)(pk->end - pk->p) < n) {
+		return false;
+	}
+
+	const uint8_t* p = pk->p;
+
+	switch (n) {
+		case 1:
+			*v = *p;
+			break;
+		case 2:
+			*v = cf_swap_from_be16(*(uint16_t*)p);
+			break;
+		case 4:
+			*v = cf_swap_from_be32(*(uint32_t*)p);
+			break;
+		default:
+			*v = cf_swap_from_be64(*(uint64_t*)p);
+			break;
+	}
+	pk->p += n;
+	return true;
+}
+
+static int
+as_arena_unpack_integer(as_arena_unpacker* pk, int64_t v, as_val** value)
+{
+	as_integer* i = as_arena_unpack_alloc(pk, sizeof(as_integer));
+
+	if (! i) {
+		return -1;
+	}
+	as_integer_init(i, v);
+	*value = (as_val*)i;
+	return 0;
+}
+
+static int
+as_arena_unpack_double(as_arena_unpacker* pk, double v, as_val** value)
+{
+	as_double* d = as_arena_unpack_alloc(pk, sizeof(as_double));
+
+	if (! d) {
+		return -1;
+	}
+	as_double_init(d, v);
+	*value = (as_val*)d;
+	return 0;
+}
+
+static int
+as_arena_unpack_blob(as_arena_unpacker* pk, uint32_t len, as_val** value)
+{
+	// The first byte is the particle type.  Leave empty blobs to the regular deserializer.
+	if (len == 0 || (size_t)(pk->end - pk->p) < len) {
+		return -2;
+	}
+
+	uint8_t type = *pk->p;
+	const uint8_t* src = pk->p + 1;
+	uint32_t n = len - 1;
+	pk->p += len;
+
+	switch (type) {
+		case AS_BYTES_STRING:
+		case AS_BYTES_GEOJSON: {
+			char* s = as_arena_unpack_alloc(pk, n + 1);
+			void* v = as_arena_unpack_alloc(pk, (type == AS_BYTES_STRING) ?
+				sizeof(as_string) : sizeof(as_geojson));
+
+			if (! (s && v)) {
+				return -1;
+			}
+			memcpy(s, src, n);
+			s[n] = 0;
+
+			if (type == AS_BYTES_STRING) {
+				as_string_init_wlen(v, s, n, false);
+			}
+			else {
+				as_geojson_init_wlen(v, s, n, false);
+			}
+			*value = v;
+			return 0;
+		}
+		default: {
+			uint8_t* b = as_arena_unpack_alloc(pk, n);
+			as_bytes* v = as_arena_unpack_alloc(pk, sizeof(as_bytes));
+
+			if (! (b && v)) {
+				return -1;
+			}
+			memcpy(b, src, n);
+			as_bytes_init_wrap(v, b, n, false);
+			v->type = (as_bytes_type)type;
+			*value = (as_val*)v;
+			return 0;
+		}
+	}
+}
+
+static inline bool
+as_arena_unpack_peek_ext(as_arena_unpacker* pk)
+{
+	if (pk->p >= pk->end) {
+		return false;
+	}
+
+	uint8_t t = *pk->p;
+	return (t >= 0xd4 && t <= 0xd8) || (t >= 0xc7 && t <= 0xc9);
+}
+
+static int
+as_arena_unpack_skip_ext(as_arena_unpacker* pk, uint8_t* ext_type)
+{
+	uint8_t t = *pk->p++;
+	uint64_t size;
+
+	if (t >= 0xd4 && t <= 0xd8) {
+		size = 1 << (t - 0xd4);
+	}
+	else if (! as_arena_unpack_uint(pk, 1 << (t - 0xc7), &size)) {
+		return -2;
+	}
+
+	if (pk->p >= pk->end || (uint64_t)(pk->end - pk->p) < size + 1) {
+		return -2;
+	}
+	*ext_type = *pk->p;
+	pk->p += size + 1;
+	return 0;
+}
+
+static int
+as_arena_unpack_list(as_arena_unpacker* pk, uint32_t n, as_val** value)
+{
+	if (n > 0 && as_arena_unpack_peek_ext(pk)) {
+		// Ordered lists start with a flags extension that the list type does not keep.
+		uint8_t flags;
+
+		if (as_arena_unpack_skip_ext(pk, &flags) != 0) {
+			return -2;
+		}
+		n--;
+	}
+
+	if (n > (size_t)(pk->end - pk->p)) {
+		// Each element takes at least one byte.
+		return -2;
+	}
+
+	as_val** elements = (n > 0) ? as_arena_unpack_alloc(pk, sizeof(as_val*) * n) : NULL;
+	as_arraylist* list = as_arena_unpack_alloc(pk, sizeof(as_arraylist));
+
+	if (! ((elements || n == 0) && list)) {
+		return -1;
+	}
+
+	as_arraylist_init(list, 0, 0);
+
+	if (list->free) {
+		cf_free(list->elements);
+	}
+	list->elements = elements;
+	list->capacity = n;
+	list->size = 0;
+	list->free = false;
+
+	for (uint32_t i = 0; i < n; i++) {
+		int rv = as_arena_unpack_value(pk, &elements[i]);
+
+		if (rv != 0) {
+			as_arraylist_destroy(list);
+			return rv;
+		}
+		list->size++;
+	}
+	*value = (as_val*)list;
+	return 0;
+}
+
+static int
+as_arena_unpack_map(as_arena_unpacker* pk, uint32_t n, as_val** value)
+{
+	uint32_t flags = 0;
+
+	if (n > 0 && as_arena_unpack_peek_ext(pk)) {
+		// Ordered maps start with a flags extension key and a nil value.
+		uint8_t ext_type;
+		as_val* v;
+
+		if (as_arena_unpack_skip_ext(pk, &ext_type) != 0 || as_arena_unpack_value(pk, &v) != 0) {
+			return -2;
+		}
+		as_val_destroy(v);
+		flags = ext_type;
+		n--;
+	}
+
+	if (n > (size_t)(pk->end - pk->p) / 2) {
+		return -2;
+	}
+
+	as_hashmap* map = as_arena_unpack_alloc(pk, sizeof(as_hashmap));
+
+	if (! map) {
+		return -1;
+	}
+
+	// Only the buckets are allocated on the heap.
+	as_hashmap_init(map, (n > 0) ? n : 1);
+	as_hashmap_set_flags(map, flags);
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_val* k;
+		int rv = as_arena_unpack_value(pk, &k);
+
+		if (rv != 0) {
+			as_hashmap_destroy(map);
+			return rv;
+		}
+
+		as_val* v;
+		rv = as_arena_unpack_value(pk, &v);
+
+		if (rv != 0) {
+			as_val_destroy(k);
+			as_hashmap_destroy(map);
+			return rv;
+		}
+
+		if (as_hashmap_set(map, k, v) != 0) {
+			as_val_destroy(k);
+			as_val_destroy(v);
+			as_hashmap_destroy(map);
+			return -1;
+		}
+	}
+	*value = (as_val*)map;
+	return 0;
+}
+
+static int
+as_arena_unpack_container(as_arena_unpacker* pk, bool is_map, uint32_t n, as_val** value)
+{
+	if (++pk->depth > AS_ARENA_UNPACK_MAX_DEPTH) {
+		return -2;
+	}
+
+	int rv = is_map ? as_arena_unpack_map(pk, n, value) : as_arena_unpack_list(pk, n, value);
+	pk->depth--;
+	return rv;
+}
+
+static int
+as_arena_unpack_value(as_arena_unpacker* pk, as_val** value)
+{
+	if (pk->p >= pk->end) {
+		return -2;
+	}
+
+	uint8_t type = *pk->p++;
+
+	if (type <= 0x7f) {
+		return as_arena_unpack_integer(pk, type, value);
+	}
+
+	if (type >= 0xe0) {
+		return as_arena_unpack_integer(pk, (int8_t)type, value);
+	}
+
+	if ((type & 0xe0) == 0xa0) {
+		return as_arena_unpack_blob(pk, type & 0x1f, value);
+	}
+
+	if ((type & 0xf0) == 0x90) {
+		return as_arena_unpack_container(pk, false, type & 0x0f, value);
+	}
+
+	if ((type & 0xf0) == 0x80) {
+		return as_arena_unpack_container(pk, true, type & 0x0f, value);
+	}
+
+	uint64_t v;
+
+	switch (type) {
+		case 0xc0:
+			*value = (as_val*)&as_nil;
+			return 0;
+
+		case 0xc2:
+		case 0xc3: {
+			as_boolean* b = as_arena_unpack_alloc(pk, sizeof(as_boolean));
+
+			if (! b) {
+				return -1;
+			}
+			as_boolean_init(b, type == 0xc3);
+			*value = (as_val*)b;
+			return 0;
+		}
+
+		case 0xcc:
+		case 0xcd:
+		case 0xce:
+		case 0xcf:
+			// Unsigned 64 bit values are returned as their two's complement, like the regular
+			// deserializer.
+			if (! as_arena_unpack_uint(pk, 1 << (type - 0xcc), &v)) {
+				return -2;
+			}
+			return as_arena_unpack_integer(pk, (int64_t)v, value);
+
+		case 0xd0:
+			if (! as_arena_unpack_uint(pk, 1, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_integer(pk, (int8_t)v, value);
+
+		case 0xd1:
+			if (! as_arena_unpack_uint(pk, 2, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_integer(pk, (int16_t)v, value);
+
+		case 0xd2:
+			if (! as_arena_unpack_uint(pk, 4, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_integer(pk, (int32_t)v, value);
+
+		case 0xd3:
+			if (! as_arena_unpack_uint(pk, 8, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_integer(pk, (int64_t)v, value);
+
+		case 0xca: {
+			if (! as_arena_unpack_uint(pk, 4, &v)) {
+				return -2;
+			}
+			uint32_t u = (uint32_t)v;
+			float f;
+			memcpy(&f, &u, sizeof(f));
+			return as_arena_unpack_double(pk, f, value);
+		}
+
+		case 0xcb: {
+			if (! as_arena_unpack_uint(pk, 8, &v)) {
+				return -2;
+			}
+			double d;
+			memcpy(&d, &v, sizeof(d));
+			return as_arena_unpack_double(pk, d, value);
+		}
+
+		case 0xc4:
+		case 0xd9:
+			if (! as_arena_unpack_uint(pk, 1, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_blob(pk, (uint32_t)v, value);
+
+		case 0xc5:
+		case 0xda:
+			if (! as_arena_unpack_uint(pk, 2, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_blob(pk, (uint32_t)v, value);
+
+		case 0xc6:
+		case 0xdb:
+			if (! as_arena_unpack_uint(pk, 4, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_blob(pk, (uint32_t)v, value);
+
+		case 0xdc:
+		case 0xdd:
+			if (! as_arena_unpack_uint(pk, (type == 0xdc) ? 2 : 4, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_container(pk, false, (uint32_t)v, value);
+
+		case 0xde:
+		case 0xdf:
+			if (! as_arena_unpack_uint(pk, (type == 0xde) ? 2 : 4, &v)) {
+				return -2;
+			}
+			return as_arena_unpack_container(pk, true, (uint32_t)v, value);
+
+		default:
+			// Extension values, such as wildcard and infinity, are left to the regular
+			// deserializer.
+			return -2;
+	}
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+int
+as_arena_unpack_val(as_arena_chunk** arena, const uint8_t* buf, uint32_t size, as_val** value)
+{
+	as_arena_unpacker pk;
+	pk.arena = arena;
+	pk.p = buf;
+	pk.end = buf + size;
+	pk.size = size;
+	pk.depth = 0;
+	return as_arena_unpack_value(&pk, value);
+}
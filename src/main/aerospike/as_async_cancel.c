@@ -0,0 +1,203 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_async_cancel.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_event_internal.h>
+#include <aerospike/as_info.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_node.h>
+#include <citrusleaf/alloc.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_async_cancel_unref(as_async_cancel* cancel)
+{
+	if (as_aaf_uint32(&cancel->refs, -1) == 0) {
+		cf_free(cancel);
+	}
+}
+
+static void
+as_async_cancel_run(as_event_loop* event_loop, void* udata)
+{
+	as_async_cancel* cancel = udata;
+	as_event_executor* executor = cancel->executor;
+
+	if (executor) {
+		// Abort server tasks first, so nodes stop sending records while the client
+		// discards what is already in flight.  The executor may already be invalid
+		// because commands saw the request first, but other nodes are still running.
+		if (cancel->abort_fn) {
+			cancel->abort_fn(executor);
+		}
+		as_async_cancel_executor(executor);
+	}
+	as_async_cancel_unref(cancel);
+}
+
+static void
+as_async_cancel_schedule(as_async_cancel* cancel)
+{
+	// Always cancel from the event loop queue, because the executor is only accessed
+	// in its event loop.
+	as_incr_uint32(&cancel->refs);
+
+	if (! as_event_execute(cancel->event_loop, as_async_cancel_run, cancel)) {
+		as_async_cancel_unref(cancel);
+	}
+}
+
+static void
+as_async_cancel_abort_listener(
+	as_error* err, char* response, void* udata, as_event_loop* event_loop
+	)
+{
+	// Nodes that already finished the task return an error.
+	if (err) {
+		as_log_debug("Abort failed: %d %s", err->code, err->message);
+	}
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_async_cancel*
+as_async_cancel_create(void)
+{
+	as_async_cancel* cancel = cf_malloc(sizeof(as_async_cancel));
+	cancel->executor = NULL;
+	cancel->event_loop = NULL;
+	cancel->abort_fn = NULL;
+	cancel->cancelled = 0;
+	cancel->refs = 1;
+	return cancel;
+}
+
+void
+as_async_cancel_destroy(as_async_cancel* cancel)
+{
+	as_async_cancel_unref(cancel);
+}
+
+void
+as_async_cancel_request(as_async_cancel* cancel)
+{
+	as_store_uint32(&cancel->cancelled, 1);
+	as_fence_seq();
+
+	// If the handle was never attached, the next scan/query is cancelled on attach.
+	if (as_load_ptr(&cancel->event_loop)) {
+		as_async_cancel_schedule(cancel);
+	}
+}
+
+bool
+as_async_cancel_requested(as_async_cancel* cancel)
+{
+	return as_load_uint32(&cancel->cancelled) != 0;
+}
+
+void
+as_async_cancel_attach(
+	as_async_cancel* cancel, as_event_executor* executor, as_async_abort_fn abort_fn
+	)
+{
+	as_incr_uint32(&cancel->refs);
+	cancel->abort_fn = abort_fn;
+	cancel->executor = executor;
+	as_store_ptr(&cancel->event_loop, executor->event_loop);
+	executor->cancel = cancel;
+	as_fence_seq();
+
+	// Pairs with the fence in as_async_cancel_request(), so either this thread sees the
+	// request or the requester sees the event loop.
+	if (as_load_uint32(&cancel->cancelled)) {
+		as_async_cancel_schedule(cancel);
+	}
+}
+
+void
+as_async_cancel_executor(as_event_executor* executor)
+{
+	as_error err;
+	as_error_set_message(&err, AEROSPIKE_ERR_CLIENT_ABORT, "Cancelled by application");
+	as_event_executor_abort(executor, &err);
+}
+
+void
+as_async_cancel_detach(as_async_cancel* cancel, as_event_executor* executor)
+{
+	// Partition retries attach the next executor before the previous one is destroyed.
+	if (cancel->executor == executor) {
+		cancel->executor = NULL;
+	}
+	as_async_cancel_unref(cancel);
+}
+
+void
+as_async_cancel_abort_nodes(
+	as_event_loop* event_loop, const char* module, uint64_t task_id, as_node** nodes,
+	uint32_t n_nodes
+	)
+{
+	char cmd1[128];
+	char cmd2[128];
+	char cmd3[128];
+	sprintf(cmd1, "query-abort:trid=%" PRIu64 "\n", task_id);
+	sprintf(cmd2, "%s-abort:trid=%" PRIu64 "\n", module, task_id);
+	sprintf(cmd3, "jobs:module=%s;cmd=kill-job;trid=%" PRIu64 "\n", module, task_id);
+
+	as_policy_info policy;
+	as_policy_info_init(&policy);
+
+	// Send to all nodes before waiting for any response.
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		as_node* node = nodes[i];
+		const char* command;
+
+		if (node->features & AS_FEATURES_PARTITION_QUERY) {
+			// query-abort works for both scan and query.
+			command = cmd1;
+		}
+		else if (node->features & AS_FEATURES_QUERY_SHOW) {
+			// scan-abort and query-abort are separate.
+			command = cmd2;
+		}
+		else {
+			// old job monitor syntax.
+			command = cmd3;
+		}
+
+		// The async info command releases the node when it completes.
+		as_node_reserve(node);
+
+		as_error err;
+		as_status status = as_info_command_node_async(NULL, &err, &policy, node, command,
+			as_async_cancel_abort_listener, NULL, event_loop);
+
+		if (status != AEROSPIKE_OK) {
+			as_log_debug("Abort not sent to node %s: %d %s", node->name, err.code, err.message);
+		}
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_async_flow.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_event.h>
+#include <aerospike/as_event_internal.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_async_flow_unref(as_async_flow* flow)
+{
+	if (as_aaf_uint32(&flow->refs, -1) == 0) {
+		cf_free(flow);
+	}
+}
+
+static void
+as_async_flow_resume(as_event_loop* event_loop, void* udata)
+{
+	as_async_flow* flow = udata;
+	as_event_executor* executor = flow->executor;
+
+	if (executor) {
+		// Take the whole list first. Resumed commands may pause again or complete.
+		// The executor is not freed before the last paused command completes, so
+		// do not reference the executor in the loop.
+		as_event_command* cmd = executor->paused;
+		executor->paused = NULL;
+
+		while (cmd) {
+			as_event_command* next = cmd->delay_next;
+
+			cmd->len = sizeof(as_proto);
+			cmd->pos = 0;
+			cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+			as_event_command_read_resume(cmd);
+			cmd = next;
+		}
+	}
+	as_async_flow_unref(flow);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_async_flow*
+as_async_flow_create(uint32_t low_watermark, uint32_t high_watermark)
+{
+	as_async_flow* flow = cf_malloc(sizeof(as_async_flow));
+	flow->executor = NULL;
+	flow->event_loop = NULL;
+	flow->low_watermark = low_watermark;
+	flow->high_watermark = high_watermark > low_watermark ? high_watermark : low_watermark + 1;
+	flow->buffered = 0;
+	flow->paused = 0;
+	flow->refs = 1;
+	return flow;
+}
+
+void
+as_async_flow_destroy(as_async_flow* flow)
+{
+	as_async_flow_unref(flow);
+}
+
+void
+as_async_flow_release(as_async_flow* flow, uint32_t n_records)
+{
+	uint32_t buffered = as_aaf_uint32(&flow->buffered, -(int32_t)n_records);
+
+	// Pairs with the fence in as_async_flow_pause(), so either this thread sees the pause
+	// or the event loop sees the released records.
+	if (buffered <= flow->low_watermark && as_load_uint32(&flow->paused) &&
+		as_cas_uint32(&flow->paused, 1, 0)) {
+		as_async_flow_wakeup(flow);
+	}
+}
+
+uint32_t
+as_async_flow_buffered(as_async_flow* flow)
+{
+	return as_load_uint32(&flow->buffered);
+}
+
+void
+as_async_flow_attach(as_async_flow* flow, as_event_executor* executor)
+{
+	as_incr_uint32(&flow->refs);
+	flow->event_loop = executor->event_loop;
+	flow->executor = executor;
+	executor->flow = flow;
+	executor->paused = NULL;
+}
+
+void
+as_async_flow_detach(as_async_flow* flow, as_event_executor* executor)
+{
+	// Partition retries attach the next executor before the previous one is destroyed.
+	if (flow->executor == executor) {
+		flow->executor = NULL;
+	}
+	as_async_flow_unref(flow);
+}
+
+void
+as_async_flow_pause(as_event_command* cmd)
+{
+	as_event_executor* executor = cmd->udata;
+	as_async_flow* flow = executor->flow;
+
+	if (! executor->valid) {
+		// Let command read its next block and abort.
+		return;
+	}
+
+	if (! as_event_command_read_pause(cmd)) {
+		return;
+	}
+
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_PAUSED;
+	cmd->delay_prev = NULL;
+	cmd->delay_next = executor->paused;
+
+	if (executor->paused) {
+		executor->paused->delay_prev = cmd;
+	}
+	executor->paused = cmd;
+
+	as_store_uint32(&flow->paused, 1);
+	as_fence_seq();
+
+	// Records may have been released between the watermark check and the pause.
+	if (as_load_uint32(&flow->buffered) <= flow->low_watermark &&
+		as_cas_uint32(&flow->paused, 1, 0)) {
+		as_async_flow_wakeup(flow);
+	}
+}
+
+void
+as_async_flow_remove(as_event_command* cmd)
+{
+	as_event_executor* executor = cmd->udata;
+
+	if (cmd->delay_prev) {
+		cmd->delay_prev->delay_next = cmd->delay_next;
+	}
+	else {
+		executor->paused = cmd->delay_next;
+	}
+
+	if (cmd->delay_next) {
+		cmd->delay_next->delay_prev = cmd->delay_prev;
+	}
+}
+
+void
+as_async_flow_wakeup(as_async_flow* flow)
+{
+	// Always resume from the event loop queue, so paused commands never start reading
+	// from inside a listener or another command's callback.
+	as_incr_uint32(&flow->refs);
+
+	if (! as_event_execute(flow->event_loop, as_async_flow_resume, flow)) {
+		as_async_flow_unref(flow);
+	}
+}
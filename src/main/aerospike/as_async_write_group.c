@@ -0,0 +1,135 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_async_write_group.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_event.h>
+#include <citrusleaf/alloc.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_async_write_group_notify(as_async_write_group* group, as_event_loop* event_loop)
+{
+	// Copy samples, so writes started by the listener can record new errors.
+	as_async_write_group_result result;
+
+	pthread_mutex_lock(&group->lock);
+	result.n_errors = group->n_errors;
+	result.errors = NULL;
+
+	if (result.n_errors > 0) {
+		result.errors = cf_malloc(sizeof(as_error) * result.n_errors);
+		memcpy(result.errors, group->errors, sizeof(as_error) * result.n_errors);
+		group->n_errors = 0;
+	}
+	pthread_mutex_unlock(&group->lock);
+
+	result.succeeded = as_load_uint64(&group->succeeded);
+	result.failed = as_load_uint64(&group->failed);
+
+	group->listener(group, &result, group->udata, event_loop);
+	cf_free(result.errors);
+}
+
+static inline void
+as_async_write_group_end(as_async_write_group* group, as_event_loop* event_loop)
+{
+	if (as_aaf_uint64(&group->pending, -1) == 0 && as_load_uint32(&group->flushing) &&
+		as_cas_uint32(&group->flushing, 1, 0)) {
+		as_async_write_group_notify(group, event_loop);
+	}
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_async_write_group*
+as_async_write_group_create(
+	uint32_t max_errors, as_async_write_group_listener listener, void* udata
+	)
+{
+	as_async_write_group* group = cf_malloc(sizeof(as_async_write_group));
+	pthread_mutex_init(&group->lock, NULL);
+	group->errors = (max_errors > 0) ? cf_malloc(sizeof(as_error) * max_errors) : NULL;
+	group->listener = listener;
+	group->udata = udata;
+	group->pending = 0;
+	group->succeeded = 0;
+	group->failed = 0;
+	group->max_errors = max_errors;
+	group->n_errors = 0;
+	group->flushing = 0;
+	return group;
+}
+
+void
+as_async_write_group_destroy(as_async_write_group* group)
+{
+	pthread_mutex_destroy(&group->lock);
+	cf_free(group->errors);
+	cf_free(group);
+}
+
+void
+as_async_write_group_flush(as_async_write_group* group)
+{
+	// Hold a count while the flag is set, so the last write can't complete in between
+	// without seeing the flush.
+	as_incr_uint64(&group->pending);
+	as_store_uint32(&group->flushing, 1);
+	as_async_write_group_end(group, NULL);
+}
+
+uint64_t
+as_async_write_group_pending(as_async_write_group* group)
+{
+	return as_load_uint64(&group->pending);
+}
+
+void
+as_async_write_group_begin(as_async_write_group* group)
+{
+	as_incr_uint64(&group->pending);
+}
+
+void
+as_async_write_group_complete(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	as_async_write_group* group = udata;
+
+	if (! err) {
+		as_incr_uint64(&group->succeeded);
+		as_async_write_group_end(group, event_loop);
+		return;
+	}
+
+	as_incr_uint64(&group->failed);
+
+	if (as_load_uint32(&group->n_errors) < group->max_errors) {
+		pthread_mutex_lock(&group->lock);
+
+		if (group->n_errors < group->max_errors) {
+			as_error_copy(&group->errors[group->n_errors++], err);
+		}
+		pthread_mutex_unlock(&group->lock);
+	}
+	as_async_write_group_end(group, event_loop);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_auto_batch.h>
+#include <aerospike/as_async.h>
+#include <aerospike/as_event.h>
+#include <citrusleaf/alloc.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	aerospike* as;
+	as_policy_read policy;
+	as_key key;
+	char** bins;
+	uint32_t n_bins;
+	bool read_all;
+	as_async_record_listener listener;
+	void* udata;
+} as_auto_batch_item;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static char**
+as_auto_batch_copy_bins(const char* bins[], uint32_t n_bins)
+{
+	if (n_bins == 0) {
+		return NULL;
+	}
+
+	// Store pointer array and names in one allocation, so one free releases both.
+	size_t size = sizeof(char*) * n_bins;
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		size += strlen(bins[i]) + 1;
+	}
+
+	char** names = cf_malloc(size);
+	char* p = (char*)(names + n_bins);
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		size_t len = strlen(bins[i]) + 1;
+		memcpy(p, bins[i], len);
+		names[i] = p;
+		p += len;
+	}
+	return names;
+}
+
+static inline bool
+as_auto_batch_policy_match(const as_policy_read* p1, const as_policy_read* p2)
+{
+	return p1->base.socket_timeout == p2->base.socket_timeout &&
+		p1->base.total_timeout == p2->base.total_timeout &&
+		p1->base.max_retries == p2->base.max_retries &&
+		p1->base.compress == p2->base.compress &&
+		p1->base.priority == p2->base.priority &&
+		p1->replica == p2->replica &&
+		p1->read_mode_ap == p2->read_mode_ap &&
+		p1->read_mode_sc == p2->read_mode_sc &&
+		p1->deserialize == p2->deserialize;
+}
+
+static void
+as_auto_batch_complete(
+	as_error* err, as_batch_records* records, as_auto_batch_entry* entries,
+	as_event_loop* event_loop
+	)
+{
+	as_vector* list = &records->list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_read_record* rec = as_vector_get(list, i);
+		as_auto_batch_entry* entry = &entries[i];
+
+		if (err) {
+			entry->listener(err, NULL, entry->udata, event_loop);
+		}
+		else if (rec->result == AEROSPIKE_OK) {
+			entry->listener(NULL, &rec->record, entry->udata, event_loop);
+		}
+		else {
+			as_error e;
+			as_error_set_message(&e, rec->result, as_error_string(rec->result));
+			entry->listener(&e, NULL, entry->udata, event_loop);
+		}
+		cf_free(rec->bin_names);
+	}
+	as_batch_records_destroy(records);
+	cf_free(entries);
+}
+
+static void
+as_auto_batch_listener(
+	as_error* err, as_batch_records* records, void* udata, as_event_loop* event_loop
+	)
+{
+	as_auto_batch_complete(err, records, udata, event_loop);
+}
+
+static void
+as_auto_batch_send(as_event_loop* event_loop, as_auto_batch* ab)
+{
+	as_batch_records* records = ab->records;
+	as_auto_batch_entry* entries = ab->entries;
+
+	// Detach current batch first, so listeners can start the next batch.
+	ab->records = NULL;
+	ab->entries = NULL;
+
+	if (ab->armed) {
+		as_event_timer_stop(&ab->driver);
+		ab->armed = false;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.base = ab->policy.base;
+	policy.replica = ab->policy.replica;
+	policy.read_mode_ap = ab->policy.read_mode_ap;
+	policy.read_mode_sc = ab->policy.read_mode_sc;
+	policy.deserialize = ab->policy.deserialize;
+
+	as_error err;
+	as_status status = aerospike_batch_read_async(ab->as, &err, &policy, records,
+		as_auto_batch_listener, entries, event_loop);
+
+	if (status != AEROSPIKE_OK) {
+		as_auto_batch_complete(&err, records, entries, event_loop);
+	}
+}
+
+static void
+as_auto_batch_add(as_event_loop* event_loop, as_auto_batch_item* item)
+{
+	as_auto_batch* ab = event_loop->auto_batch;
+
+	if (! ab) {
+		ab = cf_malloc(sizeof(as_auto_batch));
+		memset(ab, 0, sizeof(as_auto_batch));
+		ab->driver.event_loop = event_loop;
+		ab->driver.type = AS_ASYNC_TYPE_AUTO_BATCH;
+		event_loop->auto_batch = ab;
+	}
+
+	if (ab->records && (ab->as != item->as || ! as_auto_batch_policy_match(&ab->policy, &item->policy))) {
+		// Reads in one batch must share the same policy.
+		as_auto_batch_send(event_loop, ab);
+	}
+
+	uint32_t max = event_loop->auto_batch_max_keys;
+
+	if (! ab->records) {
+		ab->as = item->as;
+		ab->policy = item->policy;
+		ab->records = as_batch_records_create(max);
+		ab->entries = cf_malloc(sizeof(as_auto_batch_entry) * max);
+	}
+
+	as_batch_read_record* rec = as_batch_read_reserve(ab->records);
+	as_key_init_digest(&rec->key, item->key.ns, item->key.set, item->key.digest.value);
+	rec->bin_names = item->bins;
+	rec->n_bin_names = item->n_bins;
+	rec->read_all_bins = item->read_all;
+
+	as_auto_batch_entry* entry = &ab->entries[ab->records->list.size - 1];
+	entry->listener = item->listener;
+	entry->udata = item->udata;
+
+	if (ab->records->list.size >= max) {
+		as_auto_batch_send(event_loop, ab);
+	}
+	else if (! ab->armed) {
+		ab->armed = true;
+		as_event_timer_once(&ab->driver, event_loop->auto_batch_window_ms);
+	}
+}
+
+static void
+as_auto_batch_add_in_loop(as_event_loop* event_loop, as_auto_batch_item* item)
+{
+	as_auto_batch_add(event_loop, item);
+	cf_free(item);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_auto_batch_read(
+	aerospike* as, as_error* err, const as_policy_read* policy, const as_key* key,
+	const char* bins[], uint32_t n_bins, as_async_record_listener listener, void* udata,
+	as_event_loop* event_loop
+	)
+{
+	event_loop = as_event_assign(event_loop);
+
+	as_auto_batch_item local;
+	bool in_loop = pthread_equal(event_loop->thread, pthread_self());
+
+	// Reads from other threads are handed to the event loop, so the item must live on the heap.
+	as_auto_batch_item* item = in_loop ? &local : cf_malloc(sizeof(as_auto_batch_item));
+	item->as = as;
+	item->policy = *policy;
+	as_key_init_digest(&item->key, key->ns, key->set, key->digest.value);
+	item->bins = as_auto_batch_copy_bins(bins, n_bins);
+	item->n_bins = n_bins;
+	item->read_all = bins == NULL;
+	item->listener = listener;
+	item->udata = udata;
+
+	if (in_loop) {
+		as_auto_batch_add(event_loop, item);
+		return AEROSPIKE_OK;
+	}
+
+	if (! as_event_execute(event_loop, (as_event_executable)as_auto_batch_add_in_loop, item)) {
+		cf_free(item->bins);
+		cf_free(item);
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Failed to queue command");
+	}
+	return AEROSPIKE_OK;
+}
+
+void
+as_auto_batch_expire(as_event_loop* event_loop)
+{
+	as_auto_batch* ab = event_loop->auto_batch;
+
+	// Timer has already fired, so it does not need to be stopped.
+	ab->armed = false;
+
+	if (ab->records) {
+		as_auto_batch_send(event_loop, ab);
+	}
+}
+
+void
+as_auto_batch_release(as_auto_batch* ab)
+{
+	if (! ab->records) {
+		return;
+	}
+
+	as_vector* list = &ab->records->list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_read_record* rec = as_vector_get(list, i);
+		cf_free(rec->bin_names);
+	}
+	as_batch_records_destroy(ab->records);
+	cf_free(ab->entries);
+	ab->records = NULL;
+	ab->entries = NULL;
+}
+
+void
+as_auto_batch_destroy(as_event_loop* event_loop)
+{
+	as_auto_batch* ab = event_loop->auto_batch;
+
+	if (! ab) {
+		return;
+	}
+
+	if (ab->armed) {
+		as_event_lib_timer_stop(&ab->driver);
+	}
+	as_auto_batch_release(ab);
+	cf_free(ab);
+	event_loop->auto_batch = NULL;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_bin.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_BIN_HANDLE_BUCKETS 1024
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_bin_handle_entry_s {
+	struct as_bin_handle_entry_s* next;
+	as_bin_handle handle;
+} as_bin_handle_entry;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+// Entries are immutable once linked, so lookups do not take the lock.
+static as_bin_handle_entry* as_bin_handle_buckets[AS_BIN_HANDLE_BUCKETS];
+static pthread_mutex_t as_bin_handle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint32_t
+as_bin_handle_hash(const char* name, uint8_t len)
+{
+	// FNV-1a
+	uint32_t h = 2166136261u;
+
+	for (uint8_t i = 0; i < len; i++) {
+		h ^= (uint8_t)name[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static const as_bin_handle*
+as_bin_handle_find(as_bin_handle_entry* entry, const as_bin_name name, uint32_t hash)
+{
+	// Both names are null padded, so compare the full width.
+	while (entry) {
+		if (entry->handle.hash == hash &&
+			memcmp(entry->handle.name, name, AS_BIN_NAME_MAX_SIZE) == 0) {
+			return &entry->handle;
+		}
+		entry = as_load_ptr(&entry->next);
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+const as_bin_handle*
+as_bin_handle_intern(const char* name)
+{
+	size_t len = strlen(name);
+
+	if (len > AS_BIN_NAME_MAX_LEN) {
+		return NULL;
+	}
+
+	as_bin_name padded;
+	memset(padded, 0, sizeof(padded));
+	memcpy(padded, name, len);
+
+	uint32_t hash = as_bin_handle_hash(name, (uint8_t)len);
+	as_bin_handle_entry** bucket = &as_bin_handle_buckets[hash & (AS_BIN_HANDLE_BUCKETS - 1)];
+	const as_bin_handle* handle = as_bin_handle_find(as_load_ptr(bucket), padded, hash);
+
+	if (handle) {
+		return handle;
+	}
+
+	pthread_mutex_lock(&as_bin_handle_lock);
+
+	// Another thread may have added the name.
+	handle = as_bin_handle_find(*bucket, padded, hash);
+
+	if (! handle) {
+		as_bin_handle_entry* entry = cf_malloc(sizeof(as_bin_handle_entry));
+		memcpy(entry->handle.name, padded, sizeof(padded));
+		entry->handle.hash = hash;
+		entry->handle.len = (uint8_t)len;
+		entry->next = *bucket;
+		as_store_ptr(bucket, entry);
+		handle = &entry->handle;
+	}
+	pthread_mutex_unlock(&as_bin_handle_lock);
+	return handle;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_binding.h>
+#include <aerospike/as_bytes.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool
+as_binding_append(
+	as_binding* binding, const char* name, as_binding_type type, uint32_t offset, uint32_t size,
+	uint32_t len_offset
+	)
+{
+	size_t len = strlen(name);
+
+	if (len > AS_BIN_NAME_MAX_LEN || binding->n_fields >= AS_BINDING_MAX_FIELDS) {
+		return false;
+	}
+
+	as_binding_field* field = &binding->fields[binding->n_fields++];
+	memcpy(field->name, name, len + 1);
+	field->name_len = (uint8_t)len;
+	field->type = type;
+	field->offset = offset;
+	field->size = size;
+	field->len_offset = len_offset;
+	return true;
+}
+
+static int
+as_binding_find(const as_binding* binding, const as_bin_raw* bin)
+{
+	for (uint32_t i = 0; i < binding->n_fields; i++) {
+		const as_binding_field* field = &binding->fields[i];
+
+		if (field->name_len == bin->name_len &&
+			memcmp(field->name, bin->name, bin->name_len) == 0) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+// Copy string or byte array. Return true if the value was cut to the field size.
+static bool
+as_binding_copy(const as_binding_field* field, const as_bin_raw* bin, uint8_t* obj)
+{
+	uint8_t* dst = obj + field->offset;
+	bool is_str = field->type == AS_BINDING_STR;
+	uint32_t len = bin->value_size;
+	bool truncated = false;
+	uint8_t* buf;
+
+	if (field->size == 0) {
+		buf = cf_malloc(len + (is_str ? 1 : 0));
+		memcpy(dst, &buf, sizeof(buf));
+	}
+	else {
+		uint32_t max = is_str ? field->size - 1 : field->size;
+
+		if (len > max) {
+			len = max;
+			truncated = true;
+		}
+		buf = dst;
+	}
+
+	memcpy(buf, bin->value, len);
+
+	if (is_str) {
+		buf[len] = 0;
+	}
+	else {
+		memcpy(obj + field->len_offset, &len, sizeof(len));
+	}
+	return truncated;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+bool
+as_binding_add(
+	as_binding* binding, const char* name, as_binding_type type, uint32_t offset, uint32_t size
+	)
+{
+	return as_binding_append(binding, name, type, offset, size, 0);
+}
+
+bool
+as_binding_add_bytes(
+	as_binding* binding, const char* name, uint32_t offset, uint32_t size, uint32_t len_offset
+	)
+{
+	return as_binding_append(binding, name, AS_BINDING_BYTES, offset, size, len_offset);
+}
+
+void
+as_binding_decode(
+	const as_binding* binding, const as_record_raw* rec, void* obj, as_binding_status* status
+	)
+{
+	as_binding_status local;
+
+	if (! status) {
+		status = &local;
+	}
+
+	status->missing = (binding->n_fields == AS_BINDING_MAX_FIELDS) ?
+		~0ULL : ((1ULL << binding->n_fields) - 1);
+	status->mismatch = 0;
+	status->truncated = 0;
+
+	as_record_raw_iterator it;
+	as_record_raw_iterator_init(&it, rec);
+
+	as_bin_raw bin;
+
+	while (as_record_raw_iterator_next(&it, &bin)) {
+		int i = as_binding_find(binding, &bin);
+
+		if (i < 0 || bin.type == AS_BYTES_UNDEF) {
+			continue;
+		}
+
+		const as_binding_field* field = &binding->fields[i];
+		uint64_t bit = 1ULL << i;
+		uint8_t* dst = (uint8_t*)obj + field->offset;
+		bool match;
+
+		status->missing &= ~bit;
+
+		switch (field->type) {
+			case AS_BINDING_INT64:
+				match = bin.type == AS_BYTES_INTEGER && bin.value_size == 8;
+
+				if (match) {
+					int64_t v = (int64_t)cf_swap_from_be64(*(uint64_t*)bin.value);
+					memcpy(dst, &v, sizeof(v));
+				}
+				break;
+
+			case AS_BINDING_DOUBLE:
+				match = bin.type == AS_BYTES_DOUBLE && bin.value_size == 8;
+
+				if (match) {
+					double v = cf_swap_from_big_float64(*(double*)bin.value);
+					memcpy(dst, &v, sizeof(v));
+				}
+				break;
+
+			case AS_BINDING_BOOL:
+				match = bin.type == AS_BYTES_BOOL && bin.value_size == 1;
+
+				if (match) {
+					*(bool*)dst = *bin.value != 0;
+				}
+				break;
+
+			case AS_BINDING_STR:
+				match = bin.type == AS_BYTES_STRING;
+
+				if (match && as_binding_copy(field, &bin, obj)) {
+					status->truncated |= bit;
+				}
+				break;
+
+			case AS_BINDING_BYTES:
+				match = bin.type == AS_BYTES_BLOB;
+
+				if (match && as_binding_copy(field, &bin, obj)) {
+					status->truncated |= bit;
+				}
+				break;
+
+			default:
+				match = false;
+				break;
+		}
+
+		if (! match) {
+			status->mismatch |= bit;
+		}
+	}
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_buffer_pool.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_memory.h>
+#include <citrusleaf/alloc.h>
+#include <pthread.h>
+
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Every pooled buffer is preceded by a header that records its size class and size.
+// The header is 16 bytes so the returned buffer keeps malloc alignment.
+#define AS_BUFFER_POOL_HEADER_SIZE 16
+#define AS_BUFFER_POOL_UNPOOLED 0xFFFFFFFF
+
+// Buffer was mapped with mmap() instead of the allocator.
+#define AS_BUFFER_POOL_MAPPED 0x1
+
+typedef struct as_buffer_header_s {
+	uint32_t index;
+	uint32_t flags;
+	uint64_t size;
+} as_buffer_header;
+
+typedef struct as_buffer_pool_thread_s {
+	uint8_t* bufs[AS_BUFFER_POOL_CLASSES][AS_BUFFER_POOL_CLASS_SLOTS];
+	uint32_t counts[AS_BUFFER_POOL_CLASSES];
+	size_t total;
+	bool registered;
+} as_buffer_pool_thread;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static uint32_t as_buffer_pool_max = 0;
+static uint32_t as_buffer_pool_huge_min = 0;
+static uint32_t as_buffer_pool_prefault = 0;
+static pthread_key_t as_buffer_pool_key;
+static pthread_once_t as_buffer_pool_once = PTHREAD_ONCE_INIT;
+static AS_THREAD_LOCAL as_buffer_pool_thread as_buffer_pool_local;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline size_t
+as_buffer_pool_class_size(uint32_t index)
+{
+	return (size_t)1 << (index + AS_BUFFER_POOL_MIN_SHIFT);
+}
+
+static inline uint32_t
+as_buffer_pool_index(size_t size)
+{
+	uint32_t index = 0;
+
+	while (as_buffer_pool_class_size(index) < size) {
+		index++;
+	}
+	return index;
+}
+
+#if !defined(_MSC_VER)
+static uint8_t*
+as_buffer_pool_map(size_t size, size_t* map_size)
+{
+	// Align the buffer itself to a huge page boundary and keep one small page before it for
+	// the header, so a 2MB size class fits in exactly one huge page.  Over-map by one huge
+	// page, then unmap the unused head and tail.
+	size_t huge = AS_BUFFER_POOL_HUGE_PAGE_SIZE;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t data_size = (size + huge - 1) & ~(huge - 1);
+	size_t total = data_size + huge + page;
+	uint8_t* p = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (p == MAP_FAILED) {
+		return NULL;
+	}
+
+	uint8_t* buf = (uint8_t*)(((uintptr_t)p + page + huge - 1) & ~(uintptr_t)(huge - 1));
+	uint8_t* base = buf - page;
+	uint8_t* end = buf + data_size;
+
+	if (base > p) {
+		munmap(p, (size_t)(base - p));
+	}
+
+	if (p + total > end) {
+		munmap(end, (size_t)(p + total - end));
+	}
+
+#if defined(MADV_HUGEPAGE)
+	madvise(buf, data_size, MADV_HUGEPAGE);
+#endif
+
+	if (as_load_uint32(&as_buffer_pool_prefault)) {
+		// MAP_POPULATE would fault in small pages before the advice is applied, so touch
+		// pages after madvise() instead.
+		for (size_t i = 0; i < size; i += page) {
+			buf[i] = 0;
+		}
+	}
+
+	*map_size = page + data_size;
+	return buf;
+}
+
+static inline void
+as_buffer_pool_unmap(as_buffer_header* header)
+{
+	uint8_t* buf = (uint8_t*)header + sizeof(as_buffer_header);
+	munmap(buf - (size_t)sysconf(_SC_PAGESIZE), (size_t)header->size);
+}
+#endif
+
+static inline uint8_t*
+as_buffer_pool_alloc(size_t size, uint32_t index)
+{
+	size_t total = sizeof(as_buffer_header) + size;
+	as_buffer_header* header = NULL;
+	uint32_t flags = 0;
+
+#if !defined(_MSC_VER)
+	uint32_t huge_min = as_load_uint32(&as_buffer_pool_huge_min);
+
+	if (huge_min > 0 && size >= huge_min) {
+		uint8_t* buf = as_buffer_pool_map(size, &total);
+
+		if (buf) {
+			header = (as_buffer_header*)(buf - sizeof(as_buffer_header));
+			flags = AS_BUFFER_POOL_MAPPED;
+		}
+		else {
+			total = sizeof(as_buffer_header) + size;
+		}
+	}
+#endif
+
+	if (! header) {
+		header = as_alloc_malloc(total);
+	}
+	header->index = index;
+	header->flags = flags;
+	header->size = total;
+	as_memory_add(AS_MEMORY_COMMAND, total);
+	return (uint8_t*)header + sizeof(as_buffer_header);
+}
+
+static inline void
+as_buffer_pool_free(as_buffer_header* header)
+{
+	size_t size = (size_t)header->size;
+	as_memory_sub(AS_MEMORY_COMMAND, size);
+
+#if !defined(_MSC_VER)
+	if (header->flags & AS_BUFFER_POOL_MAPPED) {
+		as_buffer_pool_unmap(header);
+		return;
+	}
+#endif
+	as_alloc_free_sized(header, size);
+}
+
+static void
+as_buffer_pool_trim(as_buffer_pool_thread* tp, size_t max)
+{
+	// Free largest buffers first.
+	for (int i = AS_BUFFER_POOL_CLASSES - 1; i >= 0 && tp->total > max; i--) {
+		size_t class_size = as_buffer_pool_class_size(i);
+
+		while (tp->counts[i] > 0 && tp->total > max) {
+			uint8_t* buf = tp->bufs[i][--tp->counts[i]];
+			as_buffer_pool_free((as_buffer_header*)(buf - sizeof(as_buffer_header)));
+			tp->total -= class_size + AS_BUFFER_POOL_HEADER_SIZE;
+		}
+	}
+}
+
+static void
+as_buffer_pool_thread_exit(void* udata)
+{
+	as_buffer_pool_thread* tp = udata;
+	as_buffer_pool_trim(tp, 0);
+	tp->registered = false;
+}
+
+static void
+as_buffer_pool_create_key(void)
+{
+	pthread_key_create(&as_buffer_pool_key, as_buffer_pool_thread_exit);
+}
+
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_buffer_pool_set_max(uint32_t max_bytes)
+{
+	as_store_uint32(&as_buffer_pool_max, max_bytes);
+}
+
+uint32_t
+as_buffer_pool_get_max(void)
+{
+	return as_load_uint32(&as_buffer_pool_max);
+}
+
+void
+as_buffer_pool_set_huge_pages(uint32_t min_bytes, bool prefault)
+{
+	if (min_bytes > 0 && min_bytes < AS_BUFFER_POOL_HUGE_PAGE_SIZE) {
+		min_bytes = AS_BUFFER_POOL_HUGE_PAGE_SIZE;
+	}
+	as_store_uint32(&as_buffer_pool_prefault, prefault ? 1 : 0);
+	as_store_uint32(&as_buffer_pool_huge_min, min_bytes);
+}
+
+void
+as_buffer_pool_release_thread(void)
+{
+	as_buffer_pool_trim(&as_buffer_pool_local, 0);
+}
+
+uint8_t*
+as_buffer_pool_get(size_t size)
+{
+	if (as_load_uint32(&as_buffer_pool_max) == 0 ||
+		size > ((size_t)1 << AS_BUFFER_POOL_MAX_SHIFT)) {
+		return as_buffer_pool_alloc(size, AS_BUFFER_POOL_UNPOOLED);
+	}
+
+	uint32_t index = as_buffer_pool_index(size);
+	as_buffer_pool_thread* tp = &as_buffer_pool_local;
+
+	if (tp->counts[index] > 0) {
+		tp->total -= as_buffer_pool_class_size(index) + AS_BUFFER_POOL_HEADER_SIZE;
+		return tp->bufs[index][--tp->counts[index]];
+	}
+
+	// Allocate full class size so the buffer can be reused by any command in this class.
+	return as_buffer_pool_alloc(as_buffer_pool_class_size(index), index);
+}
+
+void
+as_buffer_pool_put(uint8_t* buf)
+{
+	as_buffer_header* header = (as_buffer_header*)(buf - sizeof(as_buffer_header));
+	uint32_t index = header->index;
+	uint32_t max = as_load_uint32(&as_buffer_pool_max);
+
+	if (index == AS_BUFFER_POOL_UNPOOLED || max == 0) {
+		as_buffer_pool_free(header);
+		return;
+	}
+
+	as_buffer_pool_thread* tp = &as_buffer_pool_local;
+	size_t size = as_buffer_pool_class_size(index) + AS_BUFFER_POOL_HEADER_SIZE;
+
+	if (tp->total > max) {
+		// High-water mark was lowered since buffers were cached.
+		as_buffer_pool_trim(tp, max);
+	}
+
+	if (tp->counts[index] >= AS_BUFFER_POOL_CLASS_SLOTS || tp->total + size > max) {
+		as_buffer_pool_free(header);
+		return;
+	}
+
+	if (! tp->registered) {
+		// Register destructor so cached buffers are freed on thread exit.
+		pthread_once(&as_buffer_pool_once, as_buffer_pool_create_key);
+		pthread_setspecific(as_buffer_pool_key, tp);
+		tp->registered = true;
+	}
+
+	tp->bufs[index][tp->counts[index]++] = buf;
+	tp->total += size;
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_capture.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_proto.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_capture_s {
+	pthread_mutex_t lock;
+	FILE* file;
+	uint64_t start_ns;
+	uint32_t sample_rate; // Zero when stopped.
+	uint32_t iter;
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_capture_classify(as_capture_record* rec, bool batch, bool task, bool index, bool udf,
+	const as_capture_op* ops
+	)
+{
+	if (batch || (rec->info1 & AS_MSG_INFO1_BATCH_INDEX)) {
+		rec->type = AS_CAPTURE_BATCH;
+		return;
+	}
+
+	if (task) {
+		rec->type = index ? AS_CAPTURE_QUERY : AS_CAPTURE_SCAN;
+		return;
+	}
+
+	if (udf) {
+		rec->type = AS_CAPTURE_UDF;
+		return;
+	}
+
+	if (rec->info2 & AS_MSG_INFO2_DELETE) {
+		rec->type = AS_CAPTURE_DELETE;
+		return;
+	}
+
+	// Commands with operations other than plain bin reads or writes are operates.
+	uint8_t plain = (rec->info2 & AS_MSG_INFO2_WRITE) ? 2 : 1;
+	bool operate = rec->n_ops > rec->n_shapes;
+
+	for (uint32_t i = 0; i < rec->n_shapes && ! operate; i++) {
+		operate = ops[i].op != plain;
+	}
+
+	if (rec->info2 & AS_MSG_INFO2_WRITE) {
+		rec->type = operate ? AS_CAPTURE_OPERATE : AS_CAPTURE_WRITE;
+	}
+	else if (rec->info1 & AS_MSG_INFO1_READ) {
+		if (operate) {
+			rec->type = AS_CAPTURE_OPERATE;
+		}
+		else {
+			rec->type = (rec->info1 & AS_MSG_INFO1_GET_NOBINDATA) ?
+				AS_CAPTURE_EXISTS : AS_CAPTURE_READ;
+		}
+	}
+	else {
+		rec->type = AS_CAPTURE_OTHER;
+	}
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+aerospike_capture_start(aerospike* as, as_error* err, const char* path, uint32_t sample_rate)
+{
+	as_error_reset(err);
+
+	if (! as->cluster) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Client is not connected");
+	}
+
+	if (sample_rate == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Capture sample_rate is zero");
+	}
+
+	as_capture* capture = as->cluster->capture;
+
+	pthread_mutex_lock(&capture->lock);
+
+	if (capture->file) {
+		pthread_mutex_unlock(&capture->lock);
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Capture is already running");
+	}
+
+	FILE* file = fopen(path, "wb");
+
+	if (! file) {
+		pthread_mutex_unlock(&capture->lock);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to create capture file: %s",
+			path);
+	}
+
+	as_capture_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, AS_CAPTURE_MAGIC, sizeof(header.magic));
+	header.sample_rate = sample_rate;
+	header.start_ms = cf_clock_getabsolute();
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1) {
+		fclose(file);
+		pthread_mutex_unlock(&capture->lock);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write capture file: %s",
+			path);
+	}
+
+	capture->file = file;
+	capture->start_ns = cf_getns();
+	capture->iter = 0;
+	capture->sample_rate = sample_rate;
+
+	pthread_mutex_unlock(&capture->lock);
+	return AEROSPIKE_OK;
+}
+
+void
+aerospike_capture_stop(aerospike* as)
+{
+	if (! as->cluster) {
+		return;
+	}
+
+	as_capture* capture = as->cluster->capture;
+
+	pthread_mutex_lock(&capture->lock);
+	capture->sample_rate = 0;
+
+	if (capture->file) {
+		fclose(capture->file);
+		capture->file = NULL;
+	}
+	pthread_mutex_unlock(&capture->lock);
+}
+
+as_capture*
+as_capture_create(void)
+{
+	as_capture* capture = cf_malloc(sizeof(as_capture));
+	pthread_mutex_init(&capture->lock, NULL);
+	capture->file = NULL;
+	capture->start_ns = 0;
+	capture->sample_rate = 0;
+	capture->iter = 0;
+	return capture;
+}
+
+void
+as_capture_destroy(as_capture* capture)
+{
+	if (capture->file) {
+		fclose(capture->file);
+	}
+	pthread_mutex_destroy(&capture->lock);
+	cf_free(capture);
+}
+
+bool
+as_capture_sample(as_capture* capture)
+{
+	uint32_t rate = capture->sample_rate;
+	return rate > 0 && capture->iter++ % rate == 0; // not atomic by design
+}
+
+as_capture_entry*
+as_capture_begin(as_capture* capture, const uint8_t* buf, size_t size, bool async)
+{
+	// Compressed commands are not inspected.
+	if (size < AS_HEADER_SIZE || buf[1] != AS_MESSAGE_TYPE || capture->sample_rate == 0) {
+		return NULL;
+	}
+
+	as_capture_entry* entry = cf_malloc(sizeof(as_capture_entry));
+	as_capture_record* rec = &entry->rec;
+	memset(rec, 0, sizeof(as_capture_record));
+	rec->flags = async ? AS_CAPTURE_FLAGS_ASYNC : 0;
+	rec->info1 = buf[9];
+	rec->info2 = buf[10];
+	rec->info3 = buf[11];
+	rec->n_ops = cf_swap_from_be16(*(uint16_t*)(buf + AS_HEADER_SIZE - 2));
+
+	uint16_t n_fields = cf_swap_from_be16(*(uint16_t*)(buf + AS_HEADER_SIZE - 4));
+	const uint8_t* p = buf + AS_HEADER_SIZE;
+	const uint8_t* end = buf + size;
+	bool batch = false;
+	bool task = false;
+	bool index = false;
+	bool udf = false;
+
+	for (uint16_t i = 0; i < n_fields && p + AS_FIELD_HEADER_SIZE <= end; i++) {
+		uint32_t len = cf_swap_from_be32(*(uint32_t*)p) - 1;
+		uint8_t type = p[4];
+		p += AS_FIELD_HEADER_SIZE;
+
+		if (p + len > end) {
+			break;
+		}
+
+		switch (type) {
+			case AS_FIELD_NAMESPACE:
+				if (len < sizeof(entry->ns)) {
+					memcpy(entry->ns, p, len);
+					rec->ns_len = (uint8_t)len;
+				}
+				break;
+
+			case AS_FIELD_SETNAME:
+				if (len < sizeof(entry->set)) {
+					memcpy(entry->set, p, len);
+					rec->set_len = (uint8_t)len;
+				}
+				break;
+
+			case AS_FIELD_DIGEST:
+				if (len == sizeof(rec->digest)) {
+					memcpy(rec->digest, p, len);
+					rec->flags |= AS_CAPTURE_FLAGS_DIGEST;
+				}
+				break;
+
+			case AS_FIELD_BATCH_INDEX:
+				batch = true;
+				break;
+
+			case AS_FIELD_TASK_ID:
+				task = true;
+				break;
+
+			case AS_FIELD_INDEX_RANGE:
+				index = true;
+				break;
+
+			case AS_FIELD_UDF_FUNCTION:
+				udf = true;
+				break;
+		}
+		p += len;
+	}
+
+	for (uint16_t i = 0; i < rec->n_ops && i < AS_CAPTURE_MAX_OPS &&
+		 p + AS_OPERATION_HEADER_SIZE <= end; i++) {
+		uint32_t op_size = cf_swap_from_be32(*(uint32_t*)p);
+		uint8_t name_len = p[7];
+
+		if (op_size < 4 + (uint32_t)name_len || p + 4 + op_size > end) {
+			break;
+		}
+
+		as_capture_op* op = &entry->ops[rec->n_shapes++];
+		op->value_size = op_size - 4 - name_len;
+		op->op = p[4];
+		op->particle_type = p[5];
+		op->name_len = (name_len < sizeof(op->name)) ? name_len : (uint8_t)sizeof(op->name);
+		memset(op->name, 0, sizeof(op->name));
+		memcpy(op->name, p + AS_OPERATION_HEADER_SIZE, op->name_len);
+		p += 4 + op_size;
+	}
+
+	as_capture_classify(rec, batch, task, index, udf, entry->ops);
+	return entry;
+}
+
+void
+as_capture_end(as_capture* capture, as_capture_entry* entry, as_trace_span* span)
+{
+	as_capture_record* rec = &entry->rec;
+	rec->latency_us = (uint32_t)((span->end_ns - span->queue_ns) / 1000);
+	rec->bytes_out = (uint32_t)span->bytes_out;
+	rec->bytes_in = (uint32_t)span->bytes_in;
+	rec->status = span->status;
+
+	pthread_mutex_lock(&capture->lock);
+
+	// Commands issued before a restart belong to the previous file.
+	if (capture->file && span->queue_ns >= capture->start_ns) {
+		rec->issue_us = (span->queue_ns - capture->start_ns) / 1000;
+		fwrite(rec, sizeof(as_capture_record), 1, capture->file);
+		fwrite(entry->ns, rec->ns_len, 1, capture->file);
+		fwrite(entry->set, rec->set_len, 1, capture->file);
+		fwrite(entry->ops, sizeof(as_capture_op), rec->n_shapes, capture->file);
+	}
+
+	pthread_mutex_unlock(&capture->lock);
+	cf_free(entry);
+}
@@ -15,7 +15,18 @@
  * the License.
  */
 #include <aerospike/as_cdt_ctx.h>
+#include <aerospike/as_cdt_internal.h>
 #include <aerospike/as_val.h>
+#include <citrusleaf/alloc.h>
+
+as_cdt_ctx*
+as_cdt_ctx_create(uint32_t capacity)
+{
+	as_cdt_ctx* ctx = cf_malloc(sizeof(as_cdt_ctx));
+	as_cdt_ctx_init(ctx, capacity);
+	ctx->_free = true;
+	return ctx;
+}
 
 void
 as_cdt_ctx_destroy(as_cdt_ctx* ctx)
@@ -31,4 +42,39 @@ as_cdt_ctx_destroy(as_cdt_ctx* ctx)
 		}
 	}
 	as_vector_destroy(list);
+	cf_free(ctx->packed);
+	ctx->packed = NULL;
+
+	if (ctx->_free) {
+		cf_free(ctx);
+	}
+}
+
+bool
+as_cdt_ctx_freeze(as_cdt_ctx* ctx)
+{
+	cf_free(ctx->packed);
+	ctx->packed = NULL;
+
+	as_packer pk = {.buffer = NULL, .capacity = UINT32_MAX};
+
+	if (as_cdt_pack_ctx_levels(&pk, ctx) != 0) {
+		return false;
+	}
+
+	uint8_t* buf = cf_malloc(pk.offset);
+	uint32_t size = pk.offset;
+
+	pk.buffer = buf;
+	pk.capacity = size;
+	pk.offset = 0;
+
+	if (as_cdt_pack_ctx_levels(&pk, ctx) != 0) {
+		cf_free(buf);
+		return false;
+	}
+	ctx->packed = buf;
+	ctx->packed_size = size;
+	ctx->packed_levels = ctx->list.size;
+	return true;
 }
@@ -15,12 +15,49 @@
  * the License.
  */
 #include <aerospike/as_cdt_internal.h>
+#include <aerospike/as_arena.h>
 #include <citrusleaf/cf_byte_order.h>
 #include "_bin.h"
 
+#define AS_CDT_CHUNK_MIN 1024
+#define AS_CDT_CHUNK_MAX (64 * 1024)
+
 as_binop*
 as_binop_forappend(as_operations* ops, as_operator operator, const as_bin_name name);
 
+uint8_t*
+as_cdt_alloc(as_operations* ops, uint32_t size)
+{
+	as_arena_chunk* chunk = ops->_arena;
+
+	if (chunk) {
+		uint8_t* p = as_arena_alloc(chunk, size);
+
+		if (p) {
+			return p;
+		}
+	}
+
+	// Chunks double in size, so operations with many arguments need few allocations.
+	uint32_t capacity = chunk ? chunk->capacity * 2 : AS_CDT_CHUNK_MIN;
+
+	if (capacity > AS_CDT_CHUNK_MAX) {
+		capacity = AS_CDT_CHUNK_MAX;
+	}
+
+	if (capacity < size) {
+		capacity = size;
+	}
+
+	chunk = as_arena_chunk_create(capacity);
+
+	if (! chunk) {
+		return NULL;
+	}
+	as_arena_push(&ops->_arena, chunk);
+	return as_arena_alloc(chunk, size);
+}
+
 void
 as_cdt_pack_header(as_packer* pk, as_cdt_ctx* ctx, uint16_t command, uint32_t count)
 {
@@ -81,29 +118,42 @@ as_cdt_pack_ctx(as_packer* pk, as_cdt_ctx* ctx)
 {
 	as_pack_list_header(pk, 3);
 	as_pack_uint64(pk, 0xff);
+	as_cdt_pack_ctx_levels(pk, ctx);
+}
+
+int
+as_cdt_pack_ctx_levels(as_packer* pk, const as_cdt_ctx* ctx)
+{
+	if (as_cdt_ctx_frozen(ctx)) {
+		return as_pack_append(pk, ctx->packed, ctx->packed_size);
+	}
+
 	as_pack_list_header(pk, ctx->list.size * 2);
 
 	for (uint32_t i = 0; i < ctx->list.size; i++) {
-		as_cdt_ctx_item* item = as_vector_get(&ctx->list, i);
+		as_cdt_ctx_item* item = as_vector_get((as_vector*)&ctx->list, i);
 		as_pack_uint64(pk, item->type);
 
 		if (item->type & AS_CDT_CTX_VALUE) {
-			as_pack_val(pk, item->val.pval);
+			if (as_pack_val(pk, item->val.pval) != 0) {
+				return -1;
+			}
 		}
 		else {
 			as_pack_int64(pk, item->val.ival);
 		}
 	}
+	return 0;
 }
 
 bool
 as_cdt_add_packed(as_packer* pk, as_operations* ops, const as_bin_name name, as_operator op_type)
 {
-	as_bytes* bytes = as_bytes_new_wrap(pk->buffer, pk->offset, true);
+	// The packed buffer is owned by the operations arena.
 	as_binop* binop = as_binop_forappend(ops, op_type, name);
 	if (! binop) {
 		return false;
 	}
-	as_bin_init(&binop->bin, name, (as_bin_value*)bytes);
+	as_bin_init_raw(&binop->bin, name, pk->buffer, pk->offset, false);
 	return true;
 }
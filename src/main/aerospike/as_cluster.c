@@ -15,25 +15,35 @@
  * the License.
  */
 #include <aerospike/as_cluster.h>
+#include <aerospike/aerospike_stats.h>
 #include <aerospike/as_address.h>
 #include <aerospike/as_admin.h>
+#include <aerospike/as_capture.h>
 #include <aerospike/as_command.h>
+#include <aerospike/as_compress_ratio.h>
 #include <aerospike/as_cpu.h>
+#include <aerospike/as_epoch.h>
+#include <aerospike/as_hot_keys.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_lookup.h>
+#include <aerospike/as_negative_cache.h>
 #include <aerospike/as_password.h>
 #include <aerospike/as_peers.h>
+#include <aerospike/as_read_coalesce.h>
+#include <aerospike/as_record_cache.h>
 #include <aerospike/as_shm_cluster.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_thread.h>
+#include <aerospike/as_topology.h>
 #include <aerospike/as_tls.h>
 #include <aerospike/as_vector.h>
 
 #include <citrusleaf/alloc.h>
 #include <citrusleaf/cf_byte_order.h>
 #include <citrusleaf/cf_clock.h>
+#include <citrusleaf/cf_queue.h>
 
 /******************************************************************************
  * Globals
@@ -43,6 +53,27 @@ extern uint32_t as_event_loop_capacity;
 extern bool as_event_single_thread;
 uint32_t as_cluster_count = 0;
 
+// One tend thread and tend pool shared by clusters created with shared_tend_thread.
+typedef struct {
+	pthread_mutex_t admin_lock; // Serializes thread start and stop.
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_cond_t done_cond;
+	as_cluster* head;
+	as_cluster* current;
+	as_thread_pool pool;
+	pthread_t thread;
+	bool running;
+	bool stop;
+} as_shared_tender;
+
+static as_shared_tender g_shared_tender = {
+	.admin_lock = PTHREAD_MUTEX_INITIALIZER,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.done_cond = PTHREAD_COND_INITIALIZER
+};
+
 /******************************************************************************
  * Function declarations
  *****************************************************************************/
@@ -59,6 +90,24 @@ as_node_refresh_partitions(as_cluster* cluster, as_error* err, as_node* node, as
 as_status
 as_node_refresh_racks(as_cluster* cluster, as_error* err, as_node* node);
 
+uint8_t*
+as_node_fetch_peers(as_cluster* cluster, as_error* err, as_node* node);
+
+as_status
+as_node_apply_peers(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf, as_peers* peers);
+
+uint8_t*
+as_node_fetch_partitions(as_cluster* cluster, as_error* err, as_node* node);
+
+as_status
+as_node_apply_partitions(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf);
+
+uint8_t*
+as_node_fetch_racks(as_cluster* cluster, as_error* err, as_node* node);
+
+as_status
+as_node_apply_racks(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf);
+
 void
 as_event_balance_connections(as_cluster* cluster);
 
@@ -112,7 +161,8 @@ as_cluster_event_notify(as_cluster* cluster, as_node* node, as_cluster_event_typ
 			.node_name = node->name,
 			.node_address = as_node_get_address_string(node),
 			.udata = cluster->event_callback_udata,
-			.type = type
+			.type = type,
+			.elapsed_ms = cf_getms() - cluster->create_ms
 		};
 		cluster->event_callback(&event);
 	}
@@ -121,7 +171,8 @@ as_cluster_event_notify(as_cluster* cluster, as_node* node, as_cluster_event_typ
 			.node_name = "",
 			.node_address = "",
 			.udata = cluster->event_callback_udata,
-			.type = type
+			.type = type,
+			.elapsed_ms = cf_getms() - cluster->create_ms
 		};
 		cluster->event_callback(&event);
 	}
@@ -147,6 +198,8 @@ as_cluster_has_partition_query(as_nodes* nodes)
 as_status
 as_cluster_reserve_all_nodes(as_cluster* cluster, as_error* err, as_nodes** nodes)
 {
+	as_cluster_wait_connected(cluster);
+
 	as_nodes* nds = as_nodes_reserve(cluster);
 
 	if (nds->size == 0) {
@@ -178,6 +231,8 @@ as_cluster_release_all_nodes(as_nodes* nodes)
 as_status
 as_cluster_validate_size(as_cluster* cluster, as_error* err, uint32_t* size)
 {
+	as_cluster_wait_connected(cluster);
+
 	as_nodes* nodes = as_nodes_reserve(cluster);
 	*size = nodes->size;
 	as_nodes_release(nodes);
@@ -189,6 +244,228 @@ as_cluster_validate_size(as_cluster* cluster, as_error* err, uint32_t* size)
 	return AEROSPIKE_OK;
 }
 
+typedef enum as_tend_phase_e {
+	AS_TEND_CONNECT,
+	AS_TEND_REFRESH,
+	AS_TEND_PEERS,
+	AS_TEND_PARTITIONS
+} as_tend_phase;
+
+typedef struct as_tend_task_s {
+	as_cluster* cluster;
+	as_node* node;
+	cf_queue* complete_q;
+	uint8_t* buf;
+	uint8_t* racks_buf;
+	as_tend_phase phase;
+	bool partitions;
+	bool racks;
+	as_status status;
+	as_error err;
+	as_error racks_err;
+	// Only refresh_count and gen_changed are used by as_node_refresh().
+	as_peers peers;
+} as_tend_task;
+
+/**
+ * Send tend info request on a tend pool thread. Only the node's own state is touched
+ * here. Shared cluster state is updated when the tend thread processes the response.
+ */
+static void
+as_tend_worker(void* data)
+{
+	as_tend_task* task = data;
+	as_cluster* cluster = task->cluster;
+	as_node* node = task->node;
+
+	switch (task->phase) {
+		case AS_TEND_CONNECT:
+			if (node->info_socket.fd < 0) {
+				// Nodes restored from a topology snapshot login here.
+				task->status = as_node_create_tend_connection(&task->err, node);
+			}
+			as_node_create_min_connections(node);
+			break;
+
+		case AS_TEND_REFRESH:
+			task->status = as_node_refresh(cluster, &task->err, node, &task->peers);
+			break;
+
+		case AS_TEND_PEERS:
+			task->buf = as_node_fetch_peers(cluster, &task->err, node);
+			break;
+
+		case AS_TEND_PARTITIONS:
+			if (task->partitions) {
+				task->buf = as_node_fetch_partitions(cluster, &task->err, node);
+
+				if (! task->buf) {
+					// Racks are not refreshed after a partition failure.
+					break;
+				}
+			}
+
+			if (task->racks) {
+				task->racks_buf = as_node_fetch_racks(cluster, &task->racks_err, node);
+			}
+			break;
+	}
+
+	if (task->complete_q) {
+		cf_queue_push(task->complete_q, &task);
+	}
+}
+
+static void
+as_tend_complete(as_tend_task* task, as_peers* peers, bool* rebalance)
+{
+	as_cluster* cluster = task->cluster;
+	as_node* node = task->node;
+	as_status status;
+
+	switch (task->phase) {
+		case AS_TEND_CONNECT:
+			if (task->status != AEROSPIKE_OK) {
+				as_log_info("Node %s connect failed: %s %s",
+					node->name, as_error_string(task->status), task->err.message);
+			}
+			break;
+
+		case AS_TEND_REFRESH:
+			peers->refresh_count += task->peers.refresh_count;
+
+			if (task->peers.gen_changed) {
+				peers->gen_changed = true;
+			}
+
+			if (task->status != AEROSPIKE_OK) {
+				// Use info level so aql doesn't see message by default.
+				as_log_info("Node %s refresh failed: %s %s",
+					node->name, as_error_string(task->status), task->err.message);
+				peers->gen_changed = true;
+				as_cluster_node_failure(node);
+			}
+			break;
+
+		case AS_TEND_PEERS:
+			status = task->buf ?
+				as_node_apply_peers(cluster, &task->err, node, task->buf, peers) : task->err.code;
+
+			if (status != AEROSPIKE_OK) {
+				as_log_warn("Node %s peers refresh failed: %s %s",
+					node->name, as_error_string(status), task->err.message);
+				as_cluster_node_failure(node);
+			}
+			break;
+
+		case AS_TEND_PARTITIONS:
+			if (task->partitions) {
+				status = task->buf ?
+					as_node_apply_partitions(cluster, &task->err, node, task->buf) : task->err.code;
+
+				if (status == AEROSPIKE_OK) {
+					cluster->topology_changed = true;
+				}
+				else {
+					as_log_warn("Node %s partition refresh failed: %s %s",
+						node->name, as_error_string(status), task->err.message);
+					as_cluster_node_failure(node);
+				}
+			}
+
+			if (! task->racks) {
+				break;
+			}
+
+			if (node->failures > 0) {
+				break;
+			}
+
+			status = task->racks_buf ?
+				as_node_apply_racks(cluster, &task->racks_err, node, task->racks_buf) :
+				task->racks_err.code;
+
+			if (status == AEROSPIKE_OK) {
+				if (cluster->shm_info && node->racks && node->racks->size > 0) {
+					*rebalance = true;
+				}
+			}
+			else {
+				as_log_warn("Node %s rack refresh failed: %s %s",
+					node->name, as_error_string(status), task->racks_err.message);
+				as_cluster_node_failure(node);
+			}
+			break;
+	}
+}
+
+/**
+ * Run tend phase for tasks. Info requests are sent to all nodes in parallel on the tend
+ * pool and responses are processed on the tend thread in the order they arrive.
+ */
+static void
+as_tend_run(as_cluster* cluster, as_tend_task* tasks, uint32_t n_tasks, as_peers* peers,
+	bool* rebalance)
+{
+	if (n_tasks == 0) {
+		return;
+	}
+
+	if (n_tasks == 1 || cluster->tend_workers->thread_size == 0) {
+		for (uint32_t i = 0; i < n_tasks; i++) {
+			as_tend_worker(&tasks[i]);
+			as_tend_complete(&tasks[i], peers, rebalance);
+		}
+		return;
+	}
+
+	cf_queue* complete_q = cf_queue_create(sizeof(as_tend_task*), true);
+	uint32_t n_queued = 0;
+
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		as_tend_task* task = &tasks[i];
+		task->complete_q = complete_q;
+
+		if (as_thread_pool_queue_task(cluster->tend_workers, as_tend_worker, task) == 0) {
+			n_queued++;
+		}
+		else {
+			// Run on tend thread if the pool rejects the task.
+			task->complete_q = NULL;
+			as_tend_worker(task);
+			as_tend_complete(task, peers, rebalance);
+		}
+	}
+
+	for (uint32_t i = 0; i < n_queued; i++) {
+		as_tend_task* task;
+		cf_queue_pop(complete_q, &task, CF_QUEUE_FOREVER);
+		as_tend_complete(task, peers, rebalance);
+	}
+	cf_queue_destroy(complete_q);
+}
+
+static inline as_tend_task*
+as_tend_task_add(as_tend_task* tasks, uint32_t* n_tasks, as_cluster* cluster, as_node* node,
+	as_tend_phase phase)
+{
+	as_tend_task* task = &tasks[(*n_tasks)++];
+	task->cluster = cluster;
+	task->node = node;
+	task->complete_q = NULL;
+	task->buf = NULL;
+	task->racks_buf = NULL;
+	task->phase = phase;
+	task->partitions = false;
+	task->racks = false;
+	task->status = AEROSPIKE_OK;
+	as_error_init(&task->err);
+	as_error_init(&task->racks_err);
+	task->peers.refresh_count = 0;
+	task->peers.gen_changed = false;
+	return task;
+}
+
 /**
  * Add nodes using copy on write semantics.
  */
@@ -219,16 +496,25 @@ as_cluster_add_nodes_copy(as_cluster* cluster, as_vector* /* <as_node*> */ nodes
 	cluster->has_partition_query = as_cluster_has_partition_query(nodes_new);
 
 	// Put old nodes on garbage collector stack.
-	as_gc_item item;
-	item.data = nodes_old;
-	item.release_fn = (as_release_fn)release_nodes;
-	as_vector_append(cluster->gc, &item);
+	as_cluster_add_gc(cluster, nodes_old, (as_release_fn)release_nodes);
 }
 
 static void
 as_cluster_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 {
+	// Create minimum connections to all new nodes in parallel before commands can use them.
+	as_tend_task* tasks = cf_malloc(sizeof(as_tend_task) * nodes_to_add->size);
+	uint32_t n_tasks = 0;
+
+	for (uint32_t i = 0; i < nodes_to_add->size; i++) {
+		as_node* node = as_vector_get_ptr(nodes_to_add, i);
+		as_tend_task_add(tasks, &n_tasks, cluster, node, AS_TEND_CONNECT);
+	}
+	as_tend_run(cluster, tasks, n_tasks, NULL, NULL);
+	cf_free(tasks);
+
 	as_cluster_add_nodes_copy(cluster, nodes_to_add);
+	cluster->topology_changed = true;
 
 	// Update shared memory nodes.
 	if (cluster->shm_info) {
@@ -262,7 +548,6 @@ as_cluster_get_alternate_host(as_cluster* cluster, const char* hostname)
 static void
 as_cluster_refresh_peers(as_cluster* cluster, as_peers* peers)
 {
-	as_error error_local;
 	as_vector* peer_nodes = &peers->nodes;
 
 	as_vector nodes;
@@ -281,16 +566,16 @@ as_cluster_refresh_peers(as_cluster* cluster, as_peers* peers)
 
 		// Refresh peers of peers in order retrieve the node's peers_count which is
 		// used in as_node_refresh_partitions(). This call might add even more peers.
+		// Peers requests are sent in parallel.
+		as_tend_task* tasks = cf_malloc(sizeof(as_tend_task) * nodes.size);
+		uint32_t n_tasks = 0;
+
 		for (uint32_t i = 0; i < nodes.size; i++) {
 			as_node* node = as_vector_get_ptr(&nodes, i);
-			as_status status = as_node_refresh_peers(cluster, &error_local, node, peers);
-
-			if (status != AEROSPIKE_OK) {
-				as_log_warn("Node %s peers refresh failed: %s %s",
-					node->name, as_error_string(status), error_local.message);
-				as_cluster_node_failure(node);
-			}
+			as_tend_task_add(tasks, &n_tasks, cluster, node, AS_TEND_PEERS);
 		}
+		as_tend_run(cluster, tasks, n_tasks, peers, NULL);
+		cf_free(tasks);
 
 		if (peer_nodes->size > 0) {
 			// Add new peer nodes to cluster.
@@ -304,105 +589,262 @@ as_cluster_refresh_peers(as_cluster* cluster, as_peers* peers)
 	as_vector_destroy(&nodes);
 }
 
+typedef struct as_seed_ctx_s {
+	cf_queue* complete_q;
+	uint32_t ref_count;
+} as_seed_ctx;
+
+typedef struct as_seed_task_s {
+	as_cluster* cluster;
+	as_seed_ctx* ctx;
+	as_host host;
+	as_node_info node_info;
+	as_error err;
+	as_status status;
+	bool resolved;
+	bool is_alias;
+	bool enable_warnings;
+} as_seed_task;
+
+static void
+as_seed_task_destroy(as_seed_task* task)
+{
+	if (task->status == AEROSPIKE_OK) {
+		as_node_info_destroy(&task->node_info);
+	}
+	as_host_destroy(&task->host);
+	cf_free(task);
+}
+
+static void
+as_seed_ctx_release(as_seed_ctx* ctx)
+{
+	if (as_aaf_uint32(&ctx->ref_count, -1) != 0) {
+		return;
+	}
+
+	// Destroy results that arrived after a seed node was chosen.
+	as_seed_task* task;
+
+	while (cf_queue_pop(ctx->complete_q, &task, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+		as_seed_task_destroy(task);
+	}
+	cf_queue_destroy(ctx->complete_q);
+	cf_free(ctx);
+}
+
+/**
+ * Resolve seed and validate the first reachable address. Runs on a tend pool thread
+ * when seeds are tried in parallel, so only task memory is written.
+ */
+static void
+as_seed_worker(void* data)
+{
+	as_seed_task* task = data;
+	as_host* host = &task->host;
+
+	as_address_iterator iter;
+	task->status = as_lookup_host(task->cluster->dns_cache, &iter, &task->err, host->name,
+		host->port);
+
+	if (task->status != AEROSPIKE_OK) {
+		if (task->enable_warnings) {
+			as_log_warn("Failed to lookup %s %d. %s %s", host->name, host->port,
+				as_error_string(task->status), task->err.message);
+		}
+	}
+	else {
+		task->status = AEROSPIKE_ERR_CLIENT;
+		task->resolved = true;
+		task->is_alias = iter.hostname_is_alias;
+
+		struct sockaddr* addr;
+
+		while (as_lookup_next(&iter, &addr)) {
+			task->status = as_lookup_node(task->cluster, &task->err, host, addr, true,
+				&task->node_info);
+
+			if (task->status == AEROSPIKE_OK) {
+				break;
+			}
+
+			if (task->enable_warnings) {
+				as_log_warn("Failed to connect to seed %s %d. %s %s", host->name, host->port,
+					as_error_string(task->status), task->err.message);
+			}
+		}
+		as_lookup_end(&iter);
+	}
+
+	as_seed_ctx* ctx = task->ctx;
+
+	if (ctx) {
+		cf_queue_push(ctx->complete_q, &task);
+		as_seed_ctx_release(ctx);
+	}
+}
+
+/**
+ * Create seed node from a validated seed and retrieve its peers. Runs on the tend thread.
+ * Return true when a seed node with peers was found.
+ */
+static bool
+as_seed_complete(
+	as_cluster* cluster, as_seed_task* task, as_peers* peers, as_node** node_out,
+	as_node** fallback, as_status* conn_status
+	)
+{
+	as_host* host = &task->host;
+
+	if (task->status != AEROSPIKE_OK) {
+		if (task->resolved) {
+			*conn_status = task->status;
+		}
+		as_peers_add_invalid_host(peers, host);
+		return false;
+	}
+
+	// Node owns the validated connection now.
+	as_node* node = as_node_create(cluster, &task->node_info);
+	task->status = AEROSPIKE_ERR_CLIENT;
+
+	if (task->is_alias) {
+		as_node_add_alias(node, host->name, host->port);
+	}
+
+	peers->refresh_count = 0;
+	as_status status = as_node_refresh_peers(cluster, &task->err, node, peers);
+
+	if (status != AEROSPIKE_OK) {
+		if (task->enable_warnings) {
+			as_log_warn("Failed to refresh seed node peers %s %d. %s %s",
+				host->name, host->port, as_error_string(status), task->err.message);
+		}
+		*conn_status = status;
+		as_node_destroy(node);
+		as_peers_add_invalid_host(peers, host);
+		return false;
+	}
+
+	if (node->peers_count == 0) {
+		// Node is suspect because it does not have any peers.
+		if (! *fallback) {
+			*fallback = node;
+		}
+		else {
+			as_node_destroy(node);
+		}
+		return false;
+	}
+
+	// Node is valid. Drop fallback if it exists.
+	if (*fallback) {
+		as_log_info("Skip orphan node: %s", as_node_get_address_string(*fallback));
+		as_node_destroy(*fallback);
+		*fallback = NULL;
+	}
+	*node_out = node;
+	return true;
+}
+
+static as_seed_task*
+as_seed_task_create(as_cluster* cluster, as_host* seed, bool enable_warnings)
+{
+	as_host host;
+	host.name = (char*)as_cluster_get_alternate_host(cluster, seed->name);
+	host.tls_name = seed->tls_name;
+	host.port = seed->port;
+
+	// Copy host because seeds can change after the seed lock is released.
+	as_seed_task* task = cf_malloc(sizeof(as_seed_task));
+	task->cluster = cluster;
+	task->ctx = NULL;
+	as_host_copy(&host, &task->host);
+	as_error_init(&task->err);
+	task->status = AEROSPIKE_ERR_CLIENT;
+	task->resolved = false;
+	task->is_alias = false;
+	task->enable_warnings = enable_warnings;
+	return task;
+}
+
 static as_status
 as_cluster_seed_node(as_cluster* cluster, as_error* err, as_peers* peers, bool enable_warnings)
 {
 	as_node* node = NULL;
 	as_node* fallback = NULL;
-	as_node_info node_info;
-	as_error error_local;
-	as_error_init(&error_local);
 	as_status conn_status = AEROSPIKE_ERR_CLIENT;
 	
 	pthread_mutex_lock(&cluster->seed_lock);
 	as_vector* seeds = cluster->seeds;
+	uint32_t n_tasks = 0;
+	as_seed_task** tasks = cf_malloc(sizeof(as_seed_task*) * seeds->size);
 
-	for (uint32_t i = 0; i < seeds->size && node == NULL; i++) {
-		as_host* seed = as_vector_get(seeds, i);
-
-		as_host host;
-		host.name = (char*)as_cluster_get_alternate_host(cluster, seed->name);
-		host.tls_name = seed->tls_name;
-		host.port = seed->port;
+	for (uint32_t i = 0; i < seeds->size; i++) {
+		as_seed_task* task = as_seed_task_create(cluster, as_vector_get(seeds, i),
+			enable_warnings);
 
-		if (as_peers_find_invalid_host(peers, &host)) {
+		if (as_peers_find_invalid_host(peers, &task->host)) {
+			as_seed_task_destroy(task);
 			continue;
 		}
+		tasks[n_tasks++] = task;
+	}
+	pthread_mutex_unlock(&cluster->seed_lock);
 
-		as_address_iterator iter;
-		as_status status = as_lookup_host(&iter, &error_local, host.name, host.port);
-		
-		if (status != AEROSPIKE_OK) {
-			as_peers_add_invalid_host(peers, &host);
+	if (n_tasks == 1 || cluster->tend_pool.thread_size == 0) {
+		// Try seeds in order.
+		for (uint32_t i = 0; i < n_tasks; i++) {
+			as_seed_task* task = tasks[i];
 
-			if (enable_warnings) {
-				as_log_warn("Failed to lookup %s %d. %s %s", host.name, host.port, as_error_string(status), error_local.message);
+			if (! node) {
+				as_seed_worker(task);
+				as_seed_complete(cluster, task, peers, &node, &fallback, &conn_status);
 			}
-			continue;
+			as_seed_task_destroy(task);
 		}
+	}
+	else if (n_tasks > 0) {
+		// Try all seeds in parallel. DNS resolution and connection timeouts of unreachable
+		// seeds overlap, and the first seed node with peers wins.
+		as_seed_ctx* ctx = cf_malloc(sizeof(as_seed_ctx));
+		ctx->complete_q = cf_queue_create(sizeof(as_seed_task*), true);
+		ctx->ref_count = 1;
 
-		struct sockaddr* addr;
-		bool found_node = false;
-
-		while (as_lookup_next(&iter, &addr)) {
-			status = as_lookup_node(cluster, &error_local, &host, addr, true, &node_info);
-			
-			if (status == AEROSPIKE_OK) {
-				node = as_node_create(cluster, &node_info);
+		uint32_t n_queued = 0;
 
-				if (iter.hostname_is_alias) {
-					as_node_add_alias(node, host.name, host.port);
-				}
+		for (uint32_t i = 0; i < n_tasks; i++) {
+			as_seed_task* task = tasks[i];
+			task->ctx = ctx;
+			as_incr_uint32(&ctx->ref_count);
 
-				peers->refresh_count = 0;
-				status = as_node_refresh_peers(cluster, &error_local, node, peers);
-
-				if (status != AEROSPIKE_OK) {
-					if (enable_warnings) {
-						as_log_warn("Failed to refresh seed node peers %s %d. %s %s",
-							host.name, host.port, as_error_string(status), error_local.message);
-					}
-					conn_status = status;
-					as_node_destroy(node);
-					node = NULL;
-					continue;
-				}
-				found_node = true;
-
-				if (node->peers_count == 0) {
-					// Node is suspect because it does not have any peers.
-					if (! fallback) {
-						fallback = node;
-					}
-					else {
-						as_node_destroy(node);
-					}
-					node = NULL;
-					continue;
-				}
-
-				// Node is valid. Drop fallback if it exists.
-				if (fallback) {
-					as_log_info("Skip orphan node: %s", as_node_get_address_string(fallback));
-					as_node_destroy(fallback);
-					fallback = NULL;
-				}
-				break;
+			if (as_thread_pool_queue_task(&cluster->tend_pool, as_seed_worker, task) == 0) {
+				n_queued++;
 			}
 			else {
-				if (enable_warnings) {
-					as_log_warn("Failed to connect to seed %s %d. %s %s", host.name, host.port, as_error_string(status), error_local.message);
+				// Run on tend thread if the pool rejects the task.
+				task->ctx = NULL;
+				as_decr_uint32(&ctx->ref_count);
+
+				if (! node) {
+					as_seed_worker(task);
+					as_seed_complete(cluster, task, peers, &node, &fallback, &conn_status);
 				}
-				conn_status = status;
+				as_seed_task_destroy(task);
 			}
 		}
-		as_lookup_end(&iter);
 
-		if (! found_node) {
-			as_peers_add_invalid_host(peers, &host);
+		for (uint32_t i = 0; i < n_queued && ! node; i++) {
+			as_seed_task* task;
+			cf_queue_pop(ctx->complete_q, &task, CF_QUEUE_FOREVER);
+			as_seed_complete(cluster, task, peers, &node, &fallback, &conn_status);
+			as_seed_task_destroy(task);
 		}
+
+		// Remaining seeds are destroyed when their workers finish.
+		as_seed_ctx_release(ctx);
 	}
-	pthread_mutex_unlock(&cluster->seed_lock);
+	cf_free(tasks);
 
 	if (! node && fallback) {
 		node = fallback;
@@ -415,7 +857,7 @@ as_cluster_seed_node(as_cluster* cluster, as_error* err, as_peers* peers, bool e
 		return as_error_set_message(err, conn_status, "Failed to connect");
 	}
 
-	as_node_create_min_connections(node);
+	as_cluster_event_notify(cluster, node, AS_CLUSTER_SEED_NODE);
 
 	// Add seed and peer nodes to cluster.
 	as_vector nodes_to_add;
@@ -452,10 +894,11 @@ as_cluster_find_nodes_to_remove(as_cluster* cluster, uint32_t refresh_count, as_
 			continue;
 		}
 
-		if (refresh_count == 0 && node->failures >= 5) {
+		if (refresh_count == 0 && (node->failures >= 5 || cluster->warm_start)) {
 			// All node info requests failed and this node had 5 consecutive failures.
 			// Remove node.  If no nodes are left, seeds will be tried in next cluster
-			// tend iteration.
+			// tend iteration.  Nodes restored from a topology snapshot are removed
+			// on the first failure, so seeds are tried without delay.
 			as_vector_append(nodes_to_remove, &node);
 			continue;
 		}
@@ -547,10 +990,7 @@ as_cluster_remove_nodes_copy(as_cluster* cluster, as_vector* /* <as_node*> */ no
 	}
 
 	// Put old nodes on garbage collector stack.
-	as_gc_item item;
-	item.data = nodes_old;
-	item.release_fn = (as_release_fn)release_nodes;
-	as_vector_append(cluster->gc, &item);
+	as_cluster_add_gc(cluster, nodes_old, (as_release_fn)release_nodes);
 }
 
 static void
@@ -568,6 +1008,7 @@ as_cluster_remove_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_t
 			
 	// Remove all nodes at once to avoid copying entire array multiple times.
 	as_cluster_remove_nodes_copy(cluster, nodes_to_remove);
+	cluster->topology_changed = true;
 	
 	// Update shared memory nodes.
 	if (cluster->shm_info) {
@@ -639,10 +1080,41 @@ as_cluster_reset_error_count(as_cluster* cluster)
 	as_nodes* nodes = cluster->nodes;
 
 	for (uint32_t i = 0; i < nodes->size; i++) {
-		as_node_reset_error_count(nodes->array[i]);
+		as_node_error_window_end(nodes->array[i]);
+	}
+}
+
+static void
+as_cluster_update_timeouts(as_cluster* cluster)
+{
+	as_nodes* nodes = cluster->nodes;
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_node_update_timeout(nodes->array[i]);
 	}
 }
 
+static void
+as_cluster_report_metrics(as_cluster* cluster)
+{
+	as_cluster_stats* stats = cluster->metrics;
+
+	if (! stats) {
+		stats = cf_malloc(sizeof(as_cluster_stats));
+		memset(stats, 0, sizeof(as_cluster_stats));
+		cluster->metrics = stats;
+	}
+
+	aerospike_cluster_stats_update(cluster, stats);
+	cluster->metrics_callback(stats, cluster->metrics_udata);
+
+	// Do not hold node references between callbacks. Arrays are kept for the next call.
+	for (uint32_t i = 0; i < stats->nodes_size; i++) {
+		aerospike_node_stats_destroy(&stats->nodes[i]);
+	}
+	stats->nodes_size = 0;
+}
+
 void
 as_cluster_manage(as_cluster* cluster)
 {
@@ -652,24 +1124,79 @@ as_cluster_manage(as_cluster* cluster)
 	if (cluster->tend_count % 30 == 0) {
 		as_cluster_balance_connections(cluster);
 	}
+	else if (cluster->async_conn_prewarm > 0 && as_event_loop_capacity > 0 &&
+		!as_event_single_thread) {
+		// Adaptive pre-warming follows async demand on every tend.
+		as_event_balance_connections(cluster);
+	}
 
-	// Reset connection error window for all nodes every error_rate_window tend iterations.
-	if (cluster->max_error_rate > 0 && cluster->tend_count % cluster->error_rate_window == 0) {
+	if (cluster->shm_info) {
+		// Processes sharing cluster memory follow the tend master's error window.
+		as_shm_update_health(cluster);
+		as_shm_update_conns(cluster);
+	}
+	else if (cluster->max_error_rate > 0 && cluster->tend_count % cluster->error_rate_window == 0) {
+		// Reset connection error window for all nodes every error_rate_window tend iterations.
 		as_cluster_reset_error_count(cluster);
 	}
+
+	if (cluster->adaptive_timeout_factor > 0) {
+		as_cluster_update_timeouts(cluster);
+	}
+
+	if (cluster->metrics_callback) {
+		uint64_t now = cf_getms();
+
+		if (now >= cluster->metrics_next_ms) {
+			cluster->metrics_next_ms = now + cluster->metrics_interval_ms;
+			as_cluster_report_metrics(cluster);
+		}
+	}
 }
 
 /**
  * Release data structures schuleduled for removal in previous cluster tend.
+ * Data is kept until threads that entered an epoch before removal have exited.
  */
 static void
-as_cluster_gc(as_vector* /* <as_gc_item> */ vector)
+as_cluster_gc(as_vector* /* <as_gc_item> */ vector, bool force)
 {
+	uint64_t epoch = as_epoch_advance();
+	uint64_t min = force ? UINT64_MAX : as_epoch_min_active();
+	uint32_t size = 0;
+
 	for (uint32_t i = 0; i < vector->size; i++) {
 		as_gc_item* item = as_vector_get(vector, i);
-		item->release_fn(item->data);
+
+		if (item->epoch == 0) {
+			item->epoch = epoch;
+		}
+
+		if (item->epoch < min) {
+			item->release_fn(item->data);
+		}
+		else {
+			// Retry on next tend.
+			if (size != i) {
+				*(as_gc_item*)as_vector_get(vector, size) = *item;
+			}
+			size++;
+		}
 	}
-	as_vector_clear(vector);
+	vector->size = size;
+}
+
+void
+as_cluster_add_gc(as_cluster* cluster, void* data, as_release_fn release_fn)
+{
+	as_gc_item item;
+	item.data = data;
+	item.release_fn = release_fn;
+	item.epoch = 0;
+
+	pthread_mutex_lock(&cluster->gc_lock);
+	as_vector_append(cluster->gc, &item);
+	pthread_mutex_unlock(&cluster->gc_lock);
 }
 
 static void
@@ -697,10 +1224,11 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 	// This tend interval delay substantially reduces the chance of
 	// deleting a ref counted data structure when other threads
 	// are stuck between assignment and incrementing the ref count.
-	as_cluster_gc(cluster->gc);
+	pthread_mutex_lock(&cluster->gc_lock);
+	as_cluster_gc(cluster->gc, false);
+	pthread_mutex_unlock(&cluster->gc_lock);
 
 	// Initialize tend iteration node statistics.
-	as_error error_local;
 	as_peers peers;
 	as_vector_inita(&peers.nodes, sizeof(as_node*), 16);
 	as_vector_inita(&peers.invalid_hosts, sizeof(as_host), 4);
@@ -708,6 +1236,9 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 	peers.gen_changed = false;
 
 	as_nodes* nodes = cluster->nodes;
+	as_nodes* nodes_begin = nodes;
+	as_tend_task* tasks = NULL;
+	uint32_t n_tasks;
 	bool rebalance = false;
 	
 	for (uint32_t i = 0; i < nodes->size; i++) {
@@ -750,41 +1281,33 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 		}
 
 		// Refresh all known nodes.
+		tasks = cf_malloc(sizeof(as_tend_task) * nodes->size);
+		n_tasks = 0;
+
 		for (uint32_t i = 0; i < nodes->size; i++) {
 			as_node* node = nodes->array[i];
 
 			if (node->active) {
-				as_status status = as_node_refresh(cluster, &error_local, node, &peers);
-
-				if (status != AEROSPIKE_OK) {
-					// Use info level so aql doesn't see message by default.
-					as_log_info("Node %s refresh failed: %s %s",
-						node->name, as_error_string(status), error_local.message);
-					peers.gen_changed = true;
-					as_cluster_node_failure(node);
-				}
+				as_tend_task_add(tasks, &n_tasks, cluster, node, AS_TEND_REFRESH);
 			}
 		}
+		as_tend_run(cluster, tasks, n_tasks, &peers, &rebalance);
 
 		// Refresh peers when necessary.
 		if (peers.gen_changed) {
 			// Refresh peers for all nodes that responded the first time even if only one node's
 			// peers changed.
 			peers.refresh_count = 0;
+			n_tasks = 0;
 
 			for (uint32_t i = 0; i < nodes->size; i++) {
 				as_node* node = nodes->array[i];
 
 				if (node->failures == 0 && node->active) {
-					as_status status = as_node_refresh_peers(cluster, &error_local, node, &peers);
-	
-					if (status != AEROSPIKE_OK) {
-						as_log_warn("Node %s peers refresh failed: %s %s",
-							node->name, as_error_string(status), error_local.message);
-						as_cluster_node_failure(node);
-					}
+					as_tend_task_add(tasks, &n_tasks, cluster, node, AS_TEND_PEERS);
 				}
 			}
+			as_tend_run(cluster, tasks, n_tasks, &peers, &rebalance);
 
 			// Remove nodes determined by refreshed peers.
 			as_vector nodes_to_remove;
@@ -810,37 +1333,45 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 
 	cluster->invalid_node_count = as_peers_invalid_count(&peers);
 
-	// Refresh partition map when necessary.
+	// Refresh partition map when necessary. Nodes may have been added or removed above.
+	cf_free(tasks);
+	tasks = cf_malloc(sizeof(as_tend_task) * (nodes->size + 1));
+	n_tasks = 0;
+
 	for (uint32_t i = 0; i < nodes->size; i++) {
 		as_node* node = nodes->array[i];
-		
+
+		if (node->failures != 0 || ! node->active) {
+			continue;
+		}
+
 		// Avoid "split cluster" case where this node thinks it's a 1-node cluster.
 		// Unchecked, such a node can dominate the partition map and cause all other
 		// nodes to be dropped.
-		if (node->partition_changed && node->failures == 0 && node->active &&
-		   (node->peers_count > 0 || peers.refresh_count == 1)) {
-			as_status status = as_node_refresh_partitions(cluster, &error_local, node, &peers);
-			
-			if (status != AEROSPIKE_OK) {
-				as_log_warn("Node %s partition refresh failed: %s %s",
-							node->name, as_error_string(status), error_local.message);
-				as_cluster_node_failure(node);
-			}
+		bool partitions = node->partition_changed &&
+			(node->peers_count > 0 || peers.refresh_count == 1);
+
+		if (partitions || node->rebalance_changed) {
+			as_tend_task* task = as_tend_task_add(tasks, &n_tasks, cluster, node,
+				AS_TEND_PARTITIONS);
+			task->partitions = partitions;
+			task->racks = node->rebalance_changed;
 		}
+	}
+	as_tend_run(cluster, tasks, n_tasks, &peers, &rebalance);
+	cf_free(tasks);
 
-		if (node->rebalance_changed && node->failures == 0 && node->active) {
-			as_status status = as_node_refresh_racks(cluster, &error_local, node);
+	// The replaced nodes array is not garbage collected until the next tend, so the pointer
+	// comparison is valid.
+	cluster->tend_changed = n_tasks > 0 || cluster->nodes != nodes_begin;
 
-			if (status == AEROSPIKE_OK) {
-				if (cluster->shm_info && node->racks && node->racks->size > 0) {
-					rebalance = true;
-				}
-			}
-			else {
-				as_log_warn("Node %s rack refresh failed: %s %s",
-							node->name, as_error_string(status), error_local.message);
-				as_cluster_node_failure(node);
-			}
+	if (cluster->tend_changed) {
+		// Notify partition route users that cached routes may be stale.
+		if (cluster->shm_info) {
+			as_incr_uint32(&cluster->shm_info->cluster_shm->partition_gen);
+		}
+		else {
+			as_incr_uint32(&cluster->partition_gen);
 		}
 	}
 
@@ -850,6 +1381,20 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 	}
 
 	as_cluster_destroy_peers(&peers);
+
+	if (cluster->topology_changed && cluster->topology_file && ! cluster->shm_info) {
+		cluster->topology_changed = false;
+
+		as_error error_local;
+		as_status status = as_topology_save(cluster, &error_local);
+
+		if (status != AEROSPIKE_OK) {
+			as_log_warn("Topology save failed: %s %s", as_error_string(status),
+				error_local.message);
+		}
+	}
+	cluster->warm_start = false;
+
 	as_cluster_manage(cluster);
 	return AEROSPIKE_OK;
 }
@@ -876,6 +1421,64 @@ as_wait_till_stabilized(as_cluster* cluster, as_error* err)
 	return AEROSPIKE_OK;
 }
 
+static uint32_t
+as_cluster_next_tend_interval(as_cluster* cluster, uint32_t interval, bool fast)
+{
+	if (fast || cluster->tend_changed) {
+		// Refresh partition maps quickly while the cluster is changing.
+		return cluster->tend_interval;
+	}
+
+	// Back off geometrically while the cluster is stable.
+	uint64_t next = (uint64_t)interval * 2;
+	return (next < cluster->tend_interval_max)? (uint32_t)next : cluster->tend_interval_max;
+}
+
+static void
+as_cluster_tend_tick(as_cluster* cluster)
+{
+	// Must hold tend_lock. Adaptive tending wakes up every tend_interval, but only tends
+	// when the current interval has elapsed or commands reported routing errors.
+	as_tend_state* ts = &cluster->tend_state;
+	bool fast = false;
+
+	if (cluster->tend_interval_max) {
+		uint32_t errors = as_load_uint32(&cluster->route_errors);
+
+		if (errors != ts->route_errors) {
+			ts->route_errors = errors;
+			fast = true;
+		}
+	}
+
+	if (fast || ts->elapsed >= ts->interval) {
+		as_error err;
+		as_status status = as_cluster_tend(cluster, &err, false);
+
+		if (status != AEROSPIKE_OK) {
+			as_log_warn("Tend error: %s %s", as_error_string(status), err.message);
+		}
+
+		if (cluster->tend_interval_max) {
+			ts->interval = as_cluster_next_tend_interval(cluster, ts->interval,
+				fast || status != AEROSPIKE_OK);
+		}
+		ts->elapsed = 0;
+
+		if (cluster->connecting) {
+			// First tend of an asynchronously connected cluster.  Release waiting commands
+			// whether or not seeds responded.
+			if (cluster->nodes->size > 0) {
+				as_cluster_event_notify(cluster, NULL, AS_CLUSTER_CONNECTED);
+			}
+			cluster->startup_ms = cf_getms() - cluster->create_ms;
+			as_store_uint8(&cluster->connecting, 0);
+			pthread_cond_broadcast(&cluster->connect_cond);
+		}
+	}
+	ts->elapsed += cluster->tend_interval;
+}
+
 static void*
 as_cluster_tender(void* data)
 {
@@ -894,17 +1497,10 @@ as_cluster_tender(void* data)
 	
 	struct timespec abstime;
 	
-	as_status status;
-	as_error err;
-	
 	pthread_mutex_lock(&cluster->tend_lock);
 
 	while (cluster->valid) {
-		status = as_cluster_tend(cluster, &err, false);
-		
-		if (status != AEROSPIKE_OK) {
-			as_log_warn("Tend error: %s %s", as_error_string(status), err.message);
-		}
+		as_cluster_tend_tick(cluster);
 		
 		// Convert tend interval into absolute timeout.
 		cf_clock_current_add(&delta, &abstime);
@@ -919,6 +1515,156 @@ as_cluster_tender(void* data)
 	return NULL;
 }
 
+static void*
+as_shared_tender_run(void* data)
+{
+	as_thread_set_name("tend");
+
+	as_shared_tender* st = &g_shared_tender;
+	struct timespec delta;
+	struct timespec abstime;
+
+	pthread_mutex_lock(&st->lock);
+
+	while (! st->stop) {
+		uint64_t now = cf_getms();
+		uint64_t wake = now + 1000;
+		as_cluster* cluster = st->head;
+
+		while (cluster) {
+			if (now >= cluster->shared_tend_ms) {
+				// Cluster can't be removed while current, so its next link stays valid.
+				st->current = cluster;
+				pthread_mutex_unlock(&st->lock);
+
+				pthread_mutex_lock(&cluster->tend_lock);
+
+				if (cluster->valid) {
+					as_cluster_tend_tick(cluster);
+				}
+				pthread_mutex_unlock(&cluster->tend_lock);
+
+				now = cf_getms();
+				pthread_mutex_lock(&st->lock);
+				cluster->shared_tend_ms = now + cluster->tend_interval;
+				st->current = NULL;
+				pthread_cond_broadcast(&st->done_cond);
+			}
+
+			if (cluster->shared_tend_ms < wake) {
+				wake = cluster->shared_tend_ms;
+			}
+			cluster = cluster->shared_tend_next;
+		}
+
+		if (wake > now && ! st->stop) {
+			cf_clock_set_timespec_ms((uint32_t)(wake - now), &delta);
+			cf_clock_current_add(&delta, &abstime);
+			pthread_cond_timedwait(&st->cond, &st->lock, &abstime);
+		}
+	}
+	pthread_mutex_unlock(&st->lock);
+
+	as_tls_thread_cleanup();
+	return NULL;
+}
+
+static as_status
+as_shared_tender_add(as_cluster* cluster, as_error* err, uint32_t pool_size)
+{
+	as_shared_tender* st = &g_shared_tender;
+	as_status status = AEROSPIKE_OK;
+
+	pthread_mutex_lock(&st->admin_lock);
+	pthread_mutex_lock(&st->lock);
+
+	if (! st->running) {
+		if (as_thread_pool_init(&st->pool, pool_size) != 0) {
+			as_log_warn("Failed to initialize shared tend pool of size %u", pool_size);
+			as_thread_pool_init(&st->pool, 0);
+		}
+		st->pool.fini_fn = as_tls_thread_cleanup;
+		st->stop = false;
+
+		if (pthread_create(&st->thread, NULL, as_shared_tender_run, NULL) != 0) {
+			as_thread_pool_destroy(&st->pool);
+			status = as_error_update(err, AEROSPIKE_ERR_CLIENT,
+				"Failed to create shared tend thread: %s", strerror(errno));
+			goto done;
+		}
+		st->running = true;
+	}
+
+	// Cluster is only tended by the shared thread from now on.
+	cluster->tend_workers = &st->pool;
+	cluster->shared_tend_ms = cf_getms() + cluster->tend_interval;
+	cluster->shared_tend_next = st->head;
+	st->head = cluster;
+	pthread_cond_signal(&st->cond);
+
+done:
+	pthread_mutex_unlock(&st->lock);
+	pthread_mutex_unlock(&st->admin_lock);
+	return status;
+}
+
+static void
+as_shared_tender_remove(as_cluster* cluster)
+{
+	as_shared_tender* st = &g_shared_tender;
+
+	pthread_mutex_lock(&st->admin_lock);
+	pthread_mutex_lock(&st->lock);
+
+	as_cluster** pp = &st->head;
+
+	while (*pp && *pp != cluster) {
+		pp = &(*pp)->shared_tend_next;
+	}
+
+	if (*pp) {
+		*pp = cluster->shared_tend_next;
+	}
+
+	// Wait till shared thread stops tending this cluster.
+	while (st->current == cluster) {
+		pthread_cond_wait(&st->done_cond, &st->lock);
+	}
+
+	if (st->running && ! st->head) {
+		// Last shared cluster. Stop thread, so it does not outlive the clients.
+		st->stop = true;
+		pthread_cond_signal(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+
+		pthread_join(st->thread, NULL);
+		as_thread_pool_destroy(&st->pool);
+
+		pthread_mutex_lock(&st->lock);
+		st->running = false;
+	}
+	pthread_mutex_unlock(&st->lock);
+	pthread_mutex_unlock(&st->admin_lock);
+}
+
+void
+as_cluster_wake_tend(as_cluster* cluster)
+{
+	if (cluster->shared_tend) {
+		as_shared_tender* st = &g_shared_tender;
+
+		pthread_mutex_lock(&st->lock);
+		cluster->shared_tend_ms = 0;
+		pthread_cond_signal(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+		return;
+	}
+
+	pthread_mutex_lock(&cluster->tend_lock);
+	pthread_cond_signal(&cluster->tend_cond);
+	pthread_mutex_unlock(&cluster->tend_lock);
+}
+
 static int
 as_cluster_find_seed(as_vector* seeds, const char* hostname, uint16_t port) {
 	for (uint32_t i = 0; i < seeds->size; i++) {
@@ -1002,9 +1748,51 @@ as_cluster_add_seeds(as_cluster* cluster)
 	}
 }
 
+/**
+ * Restore nodes and partition maps from topology snapshot. The restored view is verified
+ * by the first cluster tend.
+ */
+static as_status
+as_cluster_warm_start(as_cluster* cluster, as_error* err)
+{
+	as_vector nodes;
+	as_vector_inita(&nodes, sizeof(as_node*), 16);
+
+	as_status status = as_topology_load(cluster, err, &nodes);
+
+	if (status == AEROSPIKE_OK) {
+		as_cluster_add_nodes(cluster, &nodes);
+		cluster->topology_changed = false;
+		cluster->warm_start = true;
+	}
+	as_vector_destroy(&nodes);
+	return status;
+}
+
 as_status
 as_cluster_init(as_cluster* cluster, as_error* err, bool fail_if_not_connected)
 {
+	if (cluster->topology_file && ! cluster->shm_info) {
+		as_error error_local;
+
+		if (as_cluster_warm_start(cluster, &error_local) == AEROSPIKE_OK) {
+			as_cluster_event_notify(cluster, NULL, AS_CLUSTER_CONNECTED);
+			as_cluster_add_seeds(cluster);
+			cluster->startup_ms = cf_getms() - cluster->create_ms;
+			cluster->connecting = 0;
+			cluster->valid = true;
+			return AEROSPIKE_OK;
+		}
+		as_log_info("Topology snapshot not used: %s", error_local.message);
+	}
+
+	if (cluster->connecting) {
+		// Tend thread runs the first tend immediately.
+		as_cluster_add_seeds(cluster);
+		cluster->valid = true;
+		return AEROSPIKE_OK;
+	}
+
 	// Tend cluster until all nodes identified.
 	as_status status = as_wait_till_stabilized(cluster, err);
 	
@@ -1017,14 +1805,35 @@ as_cluster_init(as_cluster* cluster, as_error* err, bool fail_if_not_connected)
 			as_error_reset(err);
 		}
 	}
+	else {
+		as_cluster_event_notify(cluster, NULL, AS_CLUSTER_CONNECTED);
+	}
 	as_cluster_add_seeds(cluster);
+	cluster->startup_ms = cf_getms() - cluster->create_ms;
 	cluster->valid = true;
 	return AEROSPIKE_OK;
 }
 
+void
+as_cluster_wait_connected(as_cluster* cluster)
+{
+	if (! as_load_uint8(&cluster->connecting)) {
+		return;
+	}
+
+	pthread_mutex_lock(&cluster->tend_lock);
+
+	while (cluster->connecting && cluster->valid) {
+		pthread_cond_wait(&cluster->connect_cond, &cluster->tend_lock);
+	}
+	pthread_mutex_unlock(&cluster->tend_lock);
+}
+
 as_node*
 as_node_get_random(as_cluster* cluster)
 {
+	as_cluster_wait_connected(cluster);
+
 	as_nodes* nodes = as_nodes_reserve(cluster);
 	uint32_t size = nodes->size;
 
@@ -1161,6 +1970,67 @@ as_cluster_set_max_socket_idle(as_cluster* cluster, uint32_t max_socket_idle_sec
 	}
 }
 
+as_status
+as_cluster_set_conns_per_node(
+	as_cluster* cluster, as_error* err, uint32_t min_conns, uint32_t max_conns
+	)
+{
+	if (min_conns > max_conns) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid connection range: %u - %u",
+			min_conns, max_conns);
+	}
+
+	if (max_conns < cluster->conn_pools_per_node) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"max_conns_per_node %u is less than conn_pools_per_node %u", max_conns,
+			cluster->conn_pools_per_node);
+	}
+
+	if (cluster->lock_free_conn_pools) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Lock free connection pools can't be resized");
+	}
+
+	// The tend thread resizes node pools when it sees the new generation.
+	as_store_uint32(&cluster->min_conns_per_node, min_conns);
+	as_store_uint32(&cluster->max_conns_per_node, max_conns);
+	as_incr_uint32(&cluster->conn_limits_gen);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_cluster_set_async_conns_per_node(
+	as_cluster* cluster, as_error* err, uint32_t min_conns, uint32_t max_conns
+	)
+{
+	if (min_conns > max_conns) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid async connection range: %u - %u",
+			min_conns, max_conns);
+	}
+
+	// Each event loop applies the new limits to its own pools in the next cluster tend.
+	as_store_uint32(&cluster->async_min_conns_per_node, min_conns);
+	as_store_uint32(&cluster->async_max_conns_per_node, max_conns);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_cluster_set_thread_pool_size(as_cluster* cluster, as_error* err, uint32_t size)
+{
+	if (cluster->task_gate.work_pool || cluster->task_gate.pool != &cluster->thread_pool) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Only the default client thread pool can be resized");
+	}
+
+	int rc = as_thread_pool_resize(&cluster->thread_pool, size);
+
+	if (rc) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to resize thread pool to %u: %d",
+			size, rc);
+	}
+	return AEROSPIKE_OK;
+}
+
 as_status
 as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 {
@@ -1199,6 +2069,7 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 	
 	as_cluster* cluster = cf_malloc(sizeof(as_cluster));
 	memset(cluster, 0, sizeof(as_cluster));
+	cluster->create_ms = cf_getms();
 	cluster->auth_mode = config->auth_mode;
 
 	if (config->auth_mode == AS_AUTH_PKI) {
@@ -1218,24 +2089,72 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 	// Heap allocated cluster_name continues to be owned by as->config.
 	// Make a reference copy here.
 	cluster->cluster_name = config->cluster_name;
+	cluster->topology_file = config->topology_file;
 	cluster->event_callback = config->event_callback;
 	cluster->event_callback_udata = config->event_callback_udata;
 
 	// Initialize cluster tend and node parameters
 	cluster->max_error_rate = config->max_error_rate;
+	cluster->max_conn_open_rate = config->max_conn_open_rate;
 	cluster->error_rate_window = config->error_rate_window;
+	cluster->error_rate_backoff_max = config->error_rate_backoff_max;
+	cluster->error_rate_probe_interval = (config->error_rate_probe_interval > 0) ?
+		config->error_rate_probe_interval : 1;
+	cluster->error_rate_read_replica = config->error_rate_read_replica;
+	cluster->retry_tokens_per_command = config->retry_budget_percent * 10;
+	cluster->retry_tokens_max = (uint64_t)config->retry_budget_max * 1000;
+	cluster->retry_tokens = cluster->retry_tokens_max;
+	cluster->retry_budget_rejects = 0;
+	cluster->adaptive_timeout_factor = config->adaptive_timeout_factor;
+	cluster->adaptive_timeout_min = config->adaptive_timeout_min;
+	cluster->latency_stats = config->latency_stats;
+	cluster->metrics_callback = config->metrics_callback;
+	cluster->metrics_udata = config->metrics_udata;
+	cluster->metrics_interval_ms = (uint64_t)(config->metrics_interval ?
+		config->metrics_interval : 1) * 1000;
+	cluster->metrics_next_ms = cf_getms() + cluster->metrics_interval_ms;
+	cluster->metrics = NULL;
+	cluster->trace = config->trace;
+	cluster->trace_iter = 0;
+	cluster->hot_key_sample_rate = (config->hot_key_capacity > 0) ?
+		config->hot_key_sample_rate : 0;
+	cluster->hot_key_iter = 0;
+	cluster->hot_keys = (cluster->hot_key_sample_rate > 0) ?
+		as_hot_keys_create(config->hot_key_capacity, cluster->hot_key_sample_rate) : NULL;
+	cluster->capture = as_capture_create();
 	cluster->tend_interval = (config->tender_interval < 250)? 250 : config->tender_interval;
+	cluster->tend_interval_max = (config->tender_interval_max > cluster->tend_interval &&
+		! config->use_shm)? config->tender_interval_max : 0;
+	cluster->route_errors = 0;
+	cluster->tend_state.interval = cluster->tend_interval;
+	cluster->tend_state.elapsed = cluster->tend_interval;
+	cluster->tend_state.route_errors = 0;
+	cluster->shared_tend = config->shared_tend_thread && ! config->use_shm;
+	cluster->tend_changed = false;
 	cluster->min_conns_per_node = config->min_conns_per_node;
 	cluster->max_conns_per_node = config->max_conns_per_node;
 	cluster->async_min_conns_per_node = config->async_min_conns_per_node;
 	cluster->async_max_conns_per_node = config->async_max_conns_per_node;
+	cluster->async_conn_prewarm = config->async_conn_prewarm;
+	cluster->async_max_bytes_per_node = config->async_max_bytes_per_node;
 	cluster->pipe_max_conns_per_node = config->pipe_max_conns_per_node;
+	cluster->pipe_max_depth = config->pipe_max_depth;
 	cluster->conn_timeout_ms = (config->conn_timeout_ms == 0) ? 1000 : config->conn_timeout_ms;
 	cluster->login_timeout_ms = (config->login_timeout_ms == 0) ? 5000 : config->login_timeout_ms;
+	cluster->session_refresh_ms = config->session_refresh_ms;
 	cluster->tend_thread_cpu = config->tend_thread_cpu;
 	cluster->conn_pools_per_node = config->conn_pools_per_node;
+	cluster->lock_free_conn_pools = config->lock_free_conn_pools;
+	cluster->conn_pool_affinity = config->conn_pool_affinity;
+	cluster->socket_busy_poll = config->socket_busy_poll;
+	cluster->socket_read_buffer = config->socket_read_buffer;
+	cluster->point_socket_profile = config->point_socket_profile;
+	cluster->bulk_socket_profile = config->bulk_socket_profile;
+	cluster->bulk_max_conns_per_node = config->bulk_max_conns_per_node;
 	cluster->use_services_alternate = config->use_services_alternate;
 	cluster->rack_aware = config->rack_aware;
+	cluster->epoch_reclaim = config->epoch_reclaim;
+	cluster->lazy_error_messages = config->lazy_error_messages;
 
 	if (config->rack_ids) {
 		cluster->rack_ids_size = config->rack_ids->size;
@@ -1261,6 +2180,19 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 	}
 	cluster->seeds = trg;
 	pthread_mutex_init(&cluster->seed_lock, NULL);
+	pthread_mutex_init(&cluster->udf_lock, NULL);
+	cluster->udf_registered = NULL;
+	cluster->dns_cache = (config->dns_cache_ttl > 0) ?
+		as_dns_cache_create(config->dns_cache_ttl * 1000) : NULL;
+	cluster->record_cache = (config->record_cache_max > 0) ?
+		as_record_cache_create(config->record_cache_max, config->record_cache_ttl_ms) : NULL;
+	cluster->negative_cache = (config->negative_cache_max > 0) ?
+		as_negative_cache_create(config->negative_cache_max, config->negative_cache_ttl_ms,
+			config->negative_cache_fpr) : NULL;
+	cluster->read_coalesce = as_read_coalesce_create();
+	cluster->compress_ratio = (config->compress_skip_ratio > 0) ?
+		as_compress_ratio_create(config->compress_skip_ratio,
+			config->compress_sample_interval) : NULL;
 
 	// Initialize IP map translation if provided.
 	if (config->ip_map && config->ip_map_size > 0) {
@@ -1283,18 +2215,59 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 	// Initialize tend lock and condition.
 	pthread_mutex_init(&cluster->tend_lock, NULL);
 	pthread_cond_init(&cluster->tend_cond, NULL);
+	pthread_cond_init(&cluster->connect_cond, NULL);
+	cluster->connecting = (config->connect_async && ! config->use_shm) ? 1 : 0;
+	pthread_mutex_init(&cluster->login_lock, NULL);
+	pthread_cond_init(&cluster->login_cond, NULL);
 
 	// Initialize empty nodes.
 	cluster->nodes = as_nodes_create(0);
 
 	// Initialize garbage collection array.
 	cluster->gc = as_vector_create(sizeof(as_gc_item), 8);
+	pthread_mutex_init(&cluster->gc_lock, NULL);
 	
-	// Initialize thread pool.
-	int rc = as_thread_pool_init(&cluster->thread_pool, config->thread_pool_size);
+	// Initialize tend pool. Failure falls back to tending one node at a time. Shared tend
+	// clusters only seed on this pool, so it has no threads.
+	uint32_t tend_pool_size = cluster->shared_tend ? 0 : config->tend_thread_pool_size;
+
+	if (as_thread_pool_init(&cluster->tend_pool, tend_pool_size) != 0) {
+		as_log_warn("Failed to initialize tend pool of size %u", tend_pool_size);
+		as_thread_pool_init(&cluster->tend_pool, 0);
+	}
+	cluster->tend_pool.fini_fn = as_tls_thread_cleanup;
+	cluster->tend_workers = &cluster->tend_pool;
+
+	// Initialize async TLS handshake pool. Only event libraries that use ordinary TLS
+	// sockets can adopt connections established on another thread.
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+	uint32_t tls_threads = config->tls.enable ? config->async_tls_threads : 0;
+#else
+	uint32_t tls_threads = 0;
+#endif
+
+	if (as_thread_pool_init(&cluster->tls_pool, tls_threads) != 0) {
+		as_log_warn("Failed to initialize async TLS pool of size %u", tls_threads);
+		as_thread_pool_init(&cluster->tls_pool, 0);
+	}
+	cluster->tls_pool.fini_fn = as_tls_thread_cleanup;
+
+	// Initialize thread pool. The work stealing pool or an externally owned pool runs the
+	// tasks instead when configured.
+	as_thread_pool* shared_pool = config->shared_thread_pool;
+	bool work_stealing = config->thread_pool_work_stealing && ! shared_pool;
+	uint32_t thread_pool_size = (work_stealing || shared_pool)? 0 : config->thread_pool_size;
+	int rc = as_thread_pool_init(&cluster->thread_pool, thread_pool_size);
 
 	// Setup per-thread TLS cleanup function.
 	cluster->thread_pool.fini_fn = as_tls_thread_cleanup;
+
+	if (rc == 0 && work_stealing) {
+		rc = as_work_pool_init(&cluster->work_pool, config->thread_pool_size,
+			config->thread_pool_spin_us, config->thread_pool_cpu, as_tls_thread_cleanup);
+	}
+	as_task_gate_init(&cluster->task_gate, shared_pool ? shared_pool : &cluster->thread_pool,
+		&cluster->work_pool, config->thread_pool_adaptive);
 	
 	if (rc) {
 		as_status status = as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to initialize thread pool of size %u: %d",
@@ -1345,6 +2318,20 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 			*cluster_out = 0;
 			return status;
 		}
+		if (cluster->shared_tend) {
+			status = as_shared_tender_add(cluster, err, config->tend_thread_pool_size);
+
+			if (status != AEROSPIKE_OK) {
+				// Not linked, so destroy must not unlink or join.
+				cluster->valid = false;
+				as_cluster_destroy(cluster);
+				*cluster_out = 0;
+				return status;
+			}
+			*cluster_out = cluster;
+			return AEROSPIKE_OK;
+		}
+
 		// Run cluster tend thread.
 		pthread_attr_t attr;
 		pthread_attr_init(&attr);
@@ -1377,10 +2364,16 @@ as_cluster_destroy(as_cluster* cluster)
 		
 		// Signal tend thread to wake up from sleep and stop.
 		pthread_cond_signal(&cluster->tend_cond);
+		pthread_cond_broadcast(&cluster->connect_cond);
 		pthread_mutex_unlock(&cluster->tend_lock);
 		
 		// Wait for tend thread to finish.
-		pthread_join(cluster->tend_thread, NULL);
+		if (cluster->shared_tend) {
+			as_shared_tender_remove(cluster);
+		}
+		else {
+			pthread_join(cluster->tend_thread, NULL);
+		}
 		
 		if (cluster->shm_info) {
 			as_shm_destroy(cluster);
@@ -1390,16 +2383,29 @@ as_cluster_destroy(as_cluster* cluster)
 		pthread_mutex_unlock(&cluster->tend_lock);
 	}
 
+	// Tend thread has stopped, so no tend tasks are queued.
+	as_thread_pool_destroy(&cluster->tend_pool);
+
+	// Balancer runs from the tend thread, so no async TLS tasks are queued either.
+	as_thread_pool_destroy(&cluster->tls_pool);
+
+	if (cluster->metrics) {
+		aerospike_stats_destroy(cluster->metrics);
+		cf_free(cluster->metrics);
+	}
+
 	// Shutdown thread pool.
 	int rc = as_thread_pool_destroy(&cluster->thread_pool);
 	
 	if (rc) {
 		as_log_warn("Failed to destroy thread pool: %d", rc);
 	}
+	as_work_pool_destroy(&cluster->work_pool);
 
 	// Release everything in garbage collector.
-	as_cluster_gc(cluster->gc);
+	as_cluster_gc(cluster->gc, true);
 	as_vector_destroy(cluster->gc);
+	pthread_mutex_destroy(&cluster->gc_lock);
 		
 	// Destroy partition tables.
 	as_partition_tables_destroy(&cluster->partition_tables);
@@ -1439,6 +2445,39 @@ as_cluster_destroy(as_cluster* cluster)
 	// Destroy tend lock and condition.
 	pthread_mutex_destroy(&cluster->tend_lock);
 	pthread_cond_destroy(&cluster->tend_cond);
+	pthread_cond_destroy(&cluster->connect_cond);
+	pthread_mutex_destroy(&cluster->login_lock);
+	pthread_cond_destroy(&cluster->login_cond);
+
+	pthread_mutex_destroy(&cluster->udf_lock);
+
+	if (cluster->udf_registered) {
+		as_vector_destroy(cluster->udf_registered);
+	}
+
+	if (cluster->dns_cache) {
+		as_dns_cache_release(cluster->dns_cache);
+	}
+
+	if (cluster->record_cache) {
+		as_record_cache_destroy(cluster->record_cache);
+	}
+
+	if (cluster->negative_cache) {
+		as_negative_cache_destroy(cluster->negative_cache);
+	}
+
+	as_read_coalesce_destroy(cluster->read_coalesce);
+
+	if (cluster->hot_keys) {
+		as_hot_keys_destroy(cluster->hot_keys);
+	}
+
+	as_capture_destroy(cluster->capture);
+
+	if (cluster->compress_ratio) {
+		as_compress_ratio_destroy(cluster->compress_ratio);
+	}
 
 	cf_free(cluster->event_state);
 	cf_free(cluster->user);
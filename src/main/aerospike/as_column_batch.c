@@ -0,0 +1,295 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_column_batch.h>
+#include <aerospike/as_bytes.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline bool
+as_column_var_width(const as_column* col)
+{
+	return col->type == AS_COLUMN_STRING || col->type == AS_COLUMN_BLOB;
+}
+
+static inline bool
+as_column_match(const as_column* col, uint8_t type)
+{
+	switch (col->type) {
+		case AS_COLUMN_INT64:
+			return type == AS_BYTES_INTEGER;
+		case AS_COLUMN_DOUBLE:
+			return type == AS_BYTES_DOUBLE;
+		case AS_COLUMN_STRING:
+			return type == AS_BYTES_STRING;
+		case AS_COLUMN_BLOB:
+			return type == AS_BYTES_BLOB;
+		default:
+			return false;
+	}
+}
+
+static as_column*
+as_column_find(as_column_batch* batch, const as_bin_raw* bin)
+{
+	for (uint32_t i = 0; i < batch->n_columns; i++) {
+		as_column* col = &batch->columns[i];
+
+		if (col->name_len == bin->name_len && memcmp(col->name, bin->name, bin->name_len) == 0) {
+			return as_column_match(col, bin->type) ? col : NULL;
+		}
+	}
+	return NULL;
+}
+
+static void
+as_column_batch_reset(as_column_batch* batch)
+{
+	uint32_t bitmap_size = (batch->capacity + 7) / 8;
+
+	for (uint32_t i = 0; i < batch->n_columns; i++) {
+		as_column* col = &batch->columns[i];
+
+		if (col->validity) {
+			memset(col->validity, 0, bitmap_size);
+		}
+
+		if (as_column_var_width(col)) {
+			col->offsets[0] = 0;
+		}
+	}
+	batch->size = 0;
+}
+
+static bool
+as_column_batch_flush(as_column_batch* batch)
+{
+	bool rv = batch->callback(batch, batch->udata);
+	as_column_batch_reset(batch);
+
+	if (! rv) {
+		as_error_set_message(&batch->err, AEROSPIKE_ERR_CLIENT_ABORT, "");
+	}
+	return rv;
+}
+
+static bool
+as_column_batch_fits(as_column_batch* batch, const as_record_raw* rec)
+{
+	uint32_t row = batch->size;
+	as_record_raw_iterator it;
+	as_record_raw_iterator_init(&it, rec);
+	as_bin_raw bin;
+
+	while (as_record_raw_iterator_next(&it, &bin)) {
+		as_column* col = as_column_find(batch, &bin);
+
+		if (col && as_column_var_width(col) &&
+			(uint64_t)col->offsets[row] + bin.value_size > col->data_capacity) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool
+as_column_batch_add(as_column_batch* batch, const as_record_raw* rec)
+{
+	if (! as_column_batch_fits(batch, rec)) {
+		// Deliver filled rows to make room for this record.
+		if (batch->size == 0) {
+			as_error_set_message(&batch->err, AEROSPIKE_ERR_CLIENT,
+				"Record value exceeds column data_capacity");
+			return false;
+		}
+
+		if (! as_column_batch_flush(batch)) {
+			return false;
+		}
+
+		if (! as_column_batch_fits(batch, rec)) {
+			as_error_set_message(&batch->err, AEROSPIKE_ERR_CLIENT,
+				"Record value exceeds column data_capacity");
+			return false;
+		}
+	}
+
+	uint32_t row = batch->size;
+
+	for (uint32_t i = 0; i < batch->n_columns; i++) {
+		as_column* col = &batch->columns[i];
+
+		if (as_column_var_width(col)) {
+			col->offsets[row + 1] = col->offsets[row];
+		}
+		else {
+			((int64_t*)col->values)[row] = 0;
+		}
+	}
+
+	as_record_raw_iterator it;
+	as_record_raw_iterator_init(&it, rec);
+	as_bin_raw bin;
+
+	while (as_record_raw_iterator_next(&it, &bin)) {
+		as_column* col = as_column_find(batch, &bin);
+
+		if (! col) {
+			continue;
+		}
+
+		switch (col->type) {
+			case AS_COLUMN_INT64:
+				((int64_t*)col->values)[row] = (int64_t)cf_swap_from_be64(*(uint64_t*)bin.value);
+				break;
+			case AS_COLUMN_DOUBLE:
+				((double*)col->values)[row] = cf_swap_from_big_float64(*(double*)bin.value);
+				break;
+			default:
+				memcpy(col->data + col->offsets[row], bin.value, bin.value_size);
+				col->offsets[row + 1] += bin.value_size;
+				break;
+		}
+
+		if (col->validity) {
+			col->validity[row >> 3] |= (uint8_t)(1 << (row & 7));
+		}
+	}
+
+	if (++batch->size == batch->capacity) {
+		return as_column_batch_flush(batch);
+	}
+	return true;
+}
+
+static bool
+as_column_batch_raw_callback(const as_record_raw* rec, void* udata)
+{
+	as_column_batch* batch = udata;
+	bool rv = true;
+
+	// Node commands deliver records concurrently.
+	pthread_mutex_lock(&batch->lock);
+
+	if (batch->err.code != AEROSPIKE_OK) {
+		rv = false;
+	}
+	else if (rec) {
+		rv = as_column_batch_add(batch, rec);
+	}
+	else if (batch->size > 0) {
+		rv = as_column_batch_flush(batch);
+	}
+
+	pthread_mutex_unlock(&batch->lock);
+	return rv;
+}
+
+static void
+as_column_batch_start(as_column_batch* batch, as_column_batch_callback callback, void* udata)
+{
+	batch->callback = callback;
+	batch->udata = udata;
+	as_error_reset(&batch->err);
+	as_column_batch_reset(batch);
+}
+
+static as_status
+as_column_batch_end(as_column_batch* batch, as_error* err, as_status status)
+{
+	// Sink errors replace the generic abort status.
+	if (batch->err.code != AEROSPIKE_OK) {
+		as_error_copy(err, &batch->err);
+		return batch->err.code;
+	}
+	return status;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_column_batch_init(
+	as_column_batch* batch, as_error* err, as_column* columns, uint32_t n_columns,
+	uint32_t capacity
+	)
+{
+	as_error_reset(err);
+
+	if (capacity == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Column capacity is zero");
+	}
+
+	for (uint32_t i = 0; i < n_columns; i++) {
+		as_column* col = &columns[i];
+		size_t len = col->name ? strlen(col->name) : 0;
+
+		if (len == 0 || len >= AS_BIN_NAME_MAX_SIZE) {
+			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid column name at %u", i);
+		}
+
+		if (as_column_var_width(col) ? ! (col->offsets && col->data) : ! col->values) {
+			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Column %s buffers not set",
+				col->name);
+		}
+		col->name_len = (uint32_t)len;
+	}
+
+	batch->columns = columns;
+	batch->n_columns = n_columns;
+	batch->capacity = capacity;
+	batch->size = 0;
+	batch->callback = NULL;
+	batch->udata = NULL;
+	as_error_init(&batch->err);
+	pthread_mutex_init(&batch->lock, NULL);
+	return AEROSPIKE_OK;
+}
+
+void
+as_column_batch_destroy(as_column_batch* batch)
+{
+	pthread_mutex_destroy(&batch->lock);
+}
+
+as_status
+aerospike_scan_columns(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	as_column_batch* batch, as_column_batch_callback callback, void* udata
+	)
+{
+	as_column_batch_start(batch, callback, udata);
+	as_status status = aerospike_scan_foreach_raw(as, err, policy, scan,
+		as_column_batch_raw_callback, batch);
+	return as_column_batch_end(batch, err, status);
+}
+
+as_status
+aerospike_query_columns(
+	aerospike* as, as_error* err, const as_policy_query* policy, as_query* query,
+	as_column_batch* batch, as_column_batch_callback callback, void* udata
+	)
+{
+	as_column_batch_start(batch, callback, udata);
+	as_status status = aerospike_query_foreach_raw(as, err, policy, query,
+		as_column_batch_raw_callback, batch);
+	return as_column_batch_end(batch, err, status);
+}
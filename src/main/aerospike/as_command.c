@@ -15,12 +15,21 @@
  * the License.
  */
 #include <aerospike/as_command.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_arena_msgpack.h>
+#include <aerospike/as_binding.h>
+#include <aerospike/as_capture.h>
 #include <aerospike/as_cluster.h>
+#include <aerospike/as_compress.h>
+#include <aerospike/as_epoch.h>
 #include <aerospike/as_event.h>
+#include <aerospike/as_hot_keys.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_memory.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_partition_tracker.h>
+#include <aerospike/as_poll.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_sleep.h>
@@ -30,7 +39,6 @@
 #include <citrusleaf/cf_digest.h>
 #include <stdlib.h>
 #include <string.h>
-#include <zlib.h>
 
 /******************************************************************************
  * STATIC VARIABLES
@@ -46,6 +54,15 @@ static uint8_t as_protocol_types[] = {1, 2, 3, 4, 3, 4, 5, 7, 8, 9, 10, 11, 12,
 static as_status
 as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_node* node);
 
+static inline void
+as_command_trace_read(as_trace_span* span, size_t size)
+{
+	if (! span->first_byte_ns) {
+		span->first_byte_ns = cf_getns();
+	}
+	span->bytes_in += sizeof(as_proto) + size;
+}
+
 static as_status
 as_command_read_message(as_error* err, as_command* cmd, as_socket* sock, as_node* node);
 
@@ -136,13 +153,11 @@ as_command_value_size(as_val* val, as_queue* buffers)
 		}
 		case AS_LIST:
 		case AS_MAP: {
-			as_buffer buffer;
-			as_serializer ser;
-			as_msgpack_init(&ser);
-			as_serializer_serialize(&ser, val, &buffer);
-			as_serializer_destroy(&ser);
-			as_queue_push(buffers, &buffer);
-			return buffer.size;
+			// Size pass.  A packer without a buffer only counts bytes.  The value is packed
+			// directly into the command buffer by as_command_write_bin().
+			as_packer pk = {.head = NULL, .tail = NULL, .buffer = NULL, .offset = 0, .capacity = 0};
+			as_pack_val(&pk, val);
+			return pk.offset;
 		}
 		default: {
 			return 0;
@@ -449,24 +464,16 @@ as_command_write_bin(uint8_t* begin, as_operator op_type, const as_bin* bin, as_
 			val_type = v->type;
 			break;
 		}
-		case AS_LIST: {
-			as_buffer buffer;
-			as_queue_pop(buffers, &buffer);
-			memcpy(p, buffer.data, buffer.size);
-			p += buffer.size;
-			val_len = buffer.size;
-			val_type = AS_BYTES_LIST;
-			cf_free(buffer.data);
-			break;
-		}
+		case AS_LIST:
 		case AS_MAP: {
-			as_buffer buffer;
-			as_queue_pop(buffers, &buffer);
-			memcpy(p, buffer.data, buffer.size);
-			p += buffer.size;
-			val_len = buffer.size;
-			val_type = AS_BYTES_MAP;
-			cf_free(buffer.data);
+			// Pack in place.  The command buffer was sized by as_command_value_size(), which
+			// packs the same value to the same number of bytes.
+			as_packer pk = {.head = NULL, .tail = NULL, .buffer = p, .offset = 0,
+				.capacity = UINT32_MAX};
+			as_pack_val(&pk, val);
+			p += pk.offset;
+			val_len = pk.offset;
+			val_type = (val->type == AS_LIST) ? AS_BYTES_LIST : AS_BYTES_MAP;
 			break;
 		}
 	}
@@ -479,24 +486,63 @@ as_command_write_bin(uint8_t* begin, as_operator op_type, const as_bin* bin, as_
 	return p;
 }
 
+uint8_t*
+as_command_write_bin_gather(
+	uint8_t* begin, as_operator op_type, const as_bin* bin, as_command_gather* gather
+	)
+{
+	uint8_t* p = begin + AS_OPERATION_HEADER_SIZE;
+	const char* name = bin->name;
+
+	// Copy string, but do not transfer null byte.
+	while (*name) {
+		*p++ = *name++;
+	}
+	uint8_t name_len = (uint8_t)(p - begin - AS_OPERATION_HEADER_SIZE);
+	as_val* val = (as_val*)bin->valuep;
+	uint8_t val_type;
+
+	if (val->type == AS_STRING) {
+		as_string* v = as_string_fromval(val);
+		// v->len should have been already set by as_command_bin_gather_size().
+		gather->data = (const uint8_t*)v->value;
+		gather->size = (uint32_t)v->len;
+		val_type = AS_BYTES_STRING;
+	}
+	else {
+		as_bytes* v = as_bytes_fromval(val);
+		gather->data = v->value;
+		gather->size = v->size;
+		val_type = v->type;
+	}
+
+	*(uint32_t*)begin = cf_swap_to_be32(name_len + gather->size + 4);
+	begin += 4;
+	*begin++ = as_protocol_types[op_type];
+	*begin++ = val_type;
+	*begin++ = 0;
+	*begin++ = name_len;
+	return p;
+}
+
 size_t
 as_command_compress_max_size(size_t cmd_sz)
 {
-	return compressBound((uLong)cmd_sz) + sizeof(as_compressed_proto);
+	return as_compress_bound(AS_COMPRESS_ZLIB, cmd_sz) + sizeof(as_compressed_proto);
 }
 
 as_status
 as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd, size_t* compressed_size)
 {
 	*compressed_size -= sizeof(as_compressed_proto);
-	int ret_val = compress2(compressed_cmd + sizeof(as_compressed_proto), (uLongf*)compressed_size,
-							cmd, (uLong)cmd_sz, Z_BEST_SPEED);
-	
-	if (ret_val) {
-		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Compress failed: %d", ret_val);
+	as_status status = as_compress(err, AS_COMPRESS_ZLIB, compressed_cmd + sizeof(as_compressed_proto),
+								   compressed_size, cmd, cmd_sz);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
 	}
-	
-	// compressed_size will now have to actual compressed size from compress2()
+
+	// compressed_size will now have to actual compressed size from as_compress()
 	as_command_compress_write_end(compressed_cmd, compressed_cmd + sizeof(as_compressed_proto) +
 								  *compressed_size, cmd_sz);
 	
@@ -507,14 +553,16 @@ as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compres
 
 as_status
 as_command_send(
-	as_command* cmd, as_error* err, uint32_t comp_threshold, as_write_fn write_fn, void* udata
+	as_command* cmd, as_error* err, uint32_t comp_threshold, const char* set,
+	as_write_fn write_fn, void* udata
 	)
 {
 	size_t capacity = cmd->buf_size;
 	cmd->buf = as_command_buffer_init(capacity);
 	cmd->buf_size = write_fn(udata, cmd->buf);
 
-	if (comp_threshold > 0 && cmd->buf_size > comp_threshold) {
+	if (comp_threshold > 0 && cmd->buf_size > comp_threshold &&
+		as_command_compress_use(cmd->cluster, cmd->ns, set)) {
 		// Compress command.
 		size_t comp_capacity = as_command_compress_max_size(cmd->buf_size);
 		size_t comp_size = comp_capacity;
@@ -526,6 +574,7 @@ as_command_send(
 			as_command_buffer_free(comp_buf, comp_capacity);
 			return status;
 		}
+		as_command_compress_add(cmd->cluster, cmd->ns, set, cmd->buf_size, comp_size);
 		capacity = comp_capacity;
 		cmd->buf = comp_buf;
 		cmd->buf_size = comp_size;
@@ -538,27 +587,215 @@ as_command_send(
 	return status;
 }
 
+// How the command keeps its target node alive.
+#define AS_NODE_REF_NONE 0
+#define AS_NODE_REF_COUNT 1
+#define AS_NODE_REF_EPOCH 2
+
+static inline void
+as_command_release_node(as_node* node, uint8_t node_ref)
+{
+	if (node_ref == AS_NODE_REF_COUNT) {
+		as_node_release(node);
+	}
+	else if (node_ref == AS_NODE_REF_EPOCH) {
+		as_epoch_exit();
+	}
+}
+
 static inline bool
 is_server_timeout(as_error* err)
 {
 	// Server timeouts have a message.  Client timeouts do not have a message.
-	return err->message[0];
+	return err->message[0] || err->lazy;
 }
 
-as_status
-as_command_execute(as_command* cmd, as_error* err)
+static uint32_t
+as_command_remaining(as_command* cmd)
+{
+	uint32_t timeout = cmd->socket_timeout;
+
+	if (cmd->deadline_ms > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= cmd->deadline_ms) {
+			return 0;
+		}
+
+		uint32_t remaining = (uint32_t)(cmd->deadline_ms - now);
+
+		if (timeout == 0 || remaining < timeout) {
+			timeout = remaining;
+		}
+	}
+	return timeout;
+}
+
+// If the node has not started responding within the hedge delay, send the same read to the
+// next replica and wait for whichever node responds first.  On return, node and socket
+// reference the connection that should be read.  The losing connection is closed and its
+// node released.
+static void
+as_command_hedge(as_command* cmd, as_node** node, as_socket* socket)
+{
+	uint32_t remaining = as_command_remaining(cmd);
+
+	if (remaining > 0 && remaining <= cmd->hedge_delay) {
+		// Not enough time left for the hedge to help.
+		return;
+	}
+
+	as_poll poll;
+	as_poll_init(&poll, socket->fd);
+	int rv = as_poll_socket(&poll, socket->fd, cmd->hedge_delay, true);
+	as_poll_destroy(&poll);
+
+	if (rv != 0) {
+		// Response has started or socket failed.  Let normal read handle it.
+		return;
+	}
+
+	as_node* primary = *node;
+	as_node* alt = as_partition_get_node(cmd->cluster, cmd->ns, cmd->partition, primary,
+										 cmd->replica, !cmd->master);
+
+	if (! alt || alt == primary) {
+		return;
+	}
+
+	// Enforce per node hedge budget.
+	if (as_faa_uint32(&alt->hedge_count, 1) >= cmd->hedge_max ||
+		! as_node_valid_error_count(alt)) {
+		as_decr_uint32(&alt->hedge_count);
+		return;
+	}
+
+	as_node_reserve(alt);
+
+	as_error err;
+	as_socket alt_socket;
+	as_status status = as_node_get_connection(&err, alt, cmd->socket_timeout, cmd->deadline_ms,
+											  &alt_socket);
+
+	if (status != AEROSPIKE_OK) {
+		goto Release;
+	}
+
+	status = as_socket_write_deadline(&err, &alt_socket, alt, cmd->buf, cmd->buf_size,
+									  cmd->socket_timeout, cmd->deadline_ms);
+
+	if (status != AEROSPIKE_OK) {
+		as_node_close_conn_error(alt, &alt_socket, alt_socket.pool);
+		goto Release;
+	}
+
+	as_socket_fd max = (socket->fd > alt_socket.fd)? socket->fd : alt_socket.fd;
+	as_poll_init(&poll, max);
+
+	do {
+		remaining = as_command_remaining(cmd);
+
+		if (cmd->deadline_ms > 0 && remaining == 0) {
+			rv = 0;
+			break;
+		}
+		rv = as_poll_sockets_read(&poll, socket->fd, alt_socket.fd, remaining);
+	} while (rv < 0 && as_last_error() == EINTR);
+
+	as_poll_destroy(&poll);
+
+	if (rv > 0 && ! (rv & 1)) {
+		// Replica responded first.  Discard original connection.
+		as_node_close_connection(primary, socket, socket->pool);
+		as_node_release(primary);
+		*socket = alt_socket;
+		*node = alt;
+		cmd->master = !cmd->master;
+		as_decr_uint32(&alt->hedge_count);
+		return;
+	}
+
+	// Original node responded first, or neither responded and the original read will
+	// time out normally.  Discard hedge connection.
+	as_node_close_connection(alt, &alt_socket, alt_socket.pool);
+
+Release:
+	as_decr_uint32(&alt->hedge_count);
+	as_node_release(alt);
+}
+
+static as_status
+as_command_run(as_command* cmd, as_error* err)
 {
 	as_node* node = NULL;
 	as_status status;
-	bool release_node;
+	uint8_t node_ref;
+	as_trace_span* trace = cmd->trace;
+
+	// Hedged reads swap reserved nodes, so they always use reference counts.
+	bool epoch = cmd->cluster->epoch_reclaim && !(cmd->flags & AS_COMMAND_FLAGS_HEDGE);
+
+	// Hedged reads may release the original node before the response, so they are not
+	// measured.
+	bool measure = cmd->replica == AS_POLICY_REPLICA_LOWEST_LATENCY && ! cmd->node &&
+		!(cmd->flags & AS_COMMAND_FLAGS_HEDGE);
+	uint64_t latency_begin = 0;
+
+	// Reads may be redirected once to another replica when the node breaker is not closed.
+	bool redirect = cmd->cluster->error_rate_read_replica && ! cmd->node &&
+		(cmd->flags & AS_COMMAND_FLAGS_READ) && !(cmd->flags & AS_COMMAND_FLAGS_LINEARIZE) &&
+		cmd->replica != AS_POLICY_REPLICA_MASTER;
+
+	// Single record commands may shorten each attempt's socket timeout to the node's observed
+	// latency. The configured timeout is the upper bound.
+	bool adaptive = cmd->cluster->adaptive_timeout_factor > 0 && ! cmd->node &&
+		!(cmd->flags & AS_COMMAND_FLAGS_HEDGE);
+	uint32_t socket_timeout = cmd->socket_timeout;
+
+	as_socket_iov* iov = NULL;
+	uint32_t iov_count = 0;
+
+	if (cmd->flags & AS_COMMAND_FLAGS_GATHER) {
+		// Interleave command buffer segments with bin values that are sent from user memory.
+		iov = alloca(sizeof(as_socket_iov) * (cmd->n_gathers * 2 + 1));
+		uint32_t offset = 0;
+
+		for (uint32_t i = 0; i < cmd->n_gathers; i++) {
+			as_command_gather* g = &cmd->gathers[i];
+			iov[iov_count].data = cmd->buf + offset;
+			iov[iov_count++].len = g->offset - offset;
+			iov[iov_count].data = g->data;
+			iov[iov_count++].len = g->size;
+			offset = g->offset;
+		}
+		iov[iov_count].data = cmd->buf + offset;
+		iov[iov_count++].len = cmd->buf_size - offset;
+	}
+
+	// Bytes sent per attempt. Gathered bin values are sent in addition to the buffer.
+	uint64_t bytes_out = cmd->buf_size;
+	uint64_t uncompressed_out = 0;
+
+	for (uint32_t i = 0; i < cmd->n_gathers && iov; i++) {
+		bytes_out += cmd->gathers[i].size;
+	}
+
+	if (! iov && cmd->buf[1] == AS_COMPRESSED_MESSAGE_TYPE) {
+		uncompressed_out = cf_swap_from_be64(*(uint64_t*)(cmd->buf + sizeof(as_proto)));
+	}
 
 	// Execute command until successful, timed out or maximum iterations have been reached.
 	while (true) {
 		if (cmd->node) {
 			node = cmd->node;
-			release_node = false;
+			node_ref = AS_NODE_REF_NONE;
 		}
 		else {
+			if (epoch) {
+				// Node can't be freed until this thread exits the epoch.
+				as_epoch_enter();
+			}
+
 			// node might already be destroyed on retry and is still set as the previous node.
 			// This works because the previous node is only used for pointer comparison
 			// and the previous node's contents are not examined during this call.
@@ -566,46 +803,126 @@ as_command_execute(as_command* cmd, as_error* err)
 										 cmd->master);
 
 			if (! node) {
+				if (epoch) {
+					as_epoch_exit();
+				}
+				as_cluster_incr_route_errors(cmd->cluster);
 				return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
 									   "Node not found for partition %s:%u",
 									   cmd->ns, cmd->partition_id);
 			}
-			as_node_reserve(node);
-			release_node = true;
+
+			if (epoch) {
+				node_ref = AS_NODE_REF_EPOCH;
+			}
+			else {
+				as_node_reserve(node);
+				node_ref = AS_NODE_REF_COUNT;
+			}
+		}
+
+		if (trace) {
+			as_command_trace_attempt(trace, node->name);
+		}
+
+		if (adaptive) {
+			uint32_t max = (cmd->total_timeout > 0 && socket_timeout > cmd->total_timeout) ?
+				cmd->total_timeout : socket_timeout;
+			cmd->socket_timeout = as_node_adaptive_timeout(node, max);
 		}
 
-		if (! as_node_valid_error_count(node)) {
+		if (! as_node_breaker_allow(node)) {
+			if (redirect) {
+				// Try another replica without consuming a retry.
+				redirect = false;
+				cmd->master = !cmd->master;
+				as_command_release_node(node, node_ref);
+				continue;
+			}
 			status = as_error_set_message(err, AEROSPIKE_MAX_ERROR_RATE, "Max error rate exceeded");
 			goto Retry;
 		}
 
 		as_socket socket;
-		status = as_node_get_connection(err, node, cmd->socket_timeout, cmd->deadline_ms, &socket);
+
+		if (cmd->flags & (AS_COMMAND_FLAGS_SCAN | AS_COMMAND_FLAGS_QUERY)) {
+			// Record streams use their own pool so they do not hold point read connections.
+			status = as_node_get_bulk_connection(err, node, cmd->socket_timeout,
+												 cmd->deadline_ms, &socket);
+		}
+		else {
+			status = as_node_get_connection(err, node, cmd->socket_timeout, cmd->deadline_ms,
+											&socket);
+		}
 		
 		if (status != AEROSPIKE_OK) {
 			// Do not retry on server error response such as invalid user/password.
 			if (status > 0 && status != AEROSPIKE_ERR_TIMEOUT) {
-				if (release_node) {
-					as_node_release(node);
-				}
+				as_command_release_node(node, node_ref);
 				as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
 				return status;
 			}
 			goto Retry;
 		}
+
+		if (trace) {
+			trace->connect_ns = cf_getns();
+		}
 		
+		if (measure || node->latency || (adaptive && node->timeout_hist)) {
+			latency_begin = cf_getns();
+		}
+
+		if (measure) {
+			as_node_latency_begin(node);
+		}
+
 		// Send command.
-		status = as_socket_write_deadline(err, &socket, node, cmd->buf, cmd->buf_size,
-										  cmd->socket_timeout, cmd->deadline_ms);
+		if (iov) {
+			status = as_socket_writev_deadline(err, &socket, node, iov, iov_count,
+											   cmd->socket_timeout, cmd->deadline_ms);
+		}
+		else if (cmd->flags & AS_COMMAND_FLAGS_HEDGE) {
+			// Hedged reads poll the socket for the response, so it can't be prefetched.
+			status = as_socket_write_deadline(err, &socket, node, cmd->buf, cmd->buf_size,
+											  cmd->socket_timeout, cmd->deadline_ms);
+		}
+		else {
+			status = as_socket_write_prefetch_deadline(err, &socket, node, cmd->buf,
+													   cmd->buf_size, cmd->socket_timeout,
+													   cmd->deadline_ms);
+		}
 		
 		if (status != AEROSPIKE_OK) {
 			// Socket errors are considered temporary anomalies.  Retry.
 			// Close socket to flush out possible garbage.	Do not put back in pool.
 			as_node_close_conn_error(node, &socket, socket.pool);
+
+			if (measure) {
+				as_node_latency_end(node, latency_begin, true);
+			}
 			goto Retry;
 		}
 		cmd->sent++;
 
+		if (trace) {
+			trace->send_ns = cf_getns();
+			trace->bytes_out = bytes_out;
+		}
+
+		as_command_counters* counters = as_node_get_counters(node);
+		as_incr_uint64(&counters->commands);
+		as_faa_uint64(&counters->bytes_out, bytes_out);
+
+		if (uncompressed_out) {
+			as_faa_uint64(&counters->compressed_out, bytes_out);
+			as_faa_uint64(&counters->uncompressed_out, uncompressed_out);
+		}
+
+		if (cmd->flags & AS_COMMAND_FLAGS_HEDGE) {
+			as_command_hedge(cmd, &node, &socket);
+		}
+
 		// Parse results returned by server.
 		if (cmd->node) {
 			status = as_command_read_messages(err, cmd, &socket, node);
@@ -614,6 +931,22 @@ as_command_execute(as_command* cmd, as_error* err)
 			status = as_command_read_message(err, cmd, &socket, node);
 		}
 
+		if (measure) {
+			as_node_latency_end(node, latency_begin, status == AEROSPIKE_ERR_TIMEOUT ||
+				status == AEROSPIKE_ERR_CONNECTION || status == AEROSPIKE_ERR_DEVICE_OVERLOAD);
+		}
+
+		// Histograms only count commands that received a response.
+		if (node->latency && status != AEROSPIKE_ERR_TIMEOUT &&
+			status != AEROSPIKE_ERR_CONNECTION) {
+			as_node_record_latency(node, as_command_latency_type(cmd->flags), latency_begin);
+		}
+
+		if (adaptive && node->timeout_hist && status != AEROSPIKE_ERR_TIMEOUT &&
+			status != AEROSPIKE_ERR_CONNECTION) {
+			as_node_record_timeout_latency(node, latency_begin);
+		}
+
 		if (status == AEROSPIKE_OK) {
 			// Reset error code if retry had occurred.
 			if (cmd->iteration > 0) {
@@ -649,9 +982,7 @@ as_command_execute(as_command* cmd, as_error* err)
 				case AEROSPIKE_ERR_CLIENT_ABORT:
 				case AEROSPIKE_ERR_CLIENT:
 					as_node_close_conn_error(node, &socket, socket.pool);
-					if (release_node) {
-						as_node_release(node);
-					}
+					as_command_release_node(node, node_ref);
 					as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
 					return status;
 				
@@ -663,19 +994,31 @@ as_command_execute(as_command* cmd, as_error* err)
 		
 		// Put connection back in pool.
 		as_node_put_connection(node, &socket);
+		as_cluster_retry_deposit(cmd->cluster);
 		
 		// Release resources.
-		if (release_node) {
-			as_node_release(node);
-		}
+		as_command_release_node(node, node_ref);
 		return status;
 
 Retry:
+		if (status == AEROSPIKE_ERR_TIMEOUT || status == AEROSPIKE_ERR_CONNECTION) {
+			as_cluster_incr_route_errors(cmd->cluster);
+		}
+
+		if (status == AEROSPIKE_ERR_TIMEOUT && ! is_server_timeout(err)) {
+			as_incr_uint64(&as_node_get_counters(node)->socket_timeouts);
+		}
+
 		// Check if max retries reached.
 		if (++cmd->iteration > cmd->max_retries) {
 			break;
 		}
 
+		// Check cluster wide retry budget.
+		if (! as_cluster_retry_acquire(cmd->cluster)) {
+			break;
+		}
+
 		uint32_t sleep_between_retries;
 
 		// Alternate between master and prole on socket errors or database reads.
@@ -701,6 +1044,7 @@ Retry:
 			int64_t remaining = cmd->deadline_ms - cf_getms() - sleep_between_retries;
 
 			if (remaining <= 0) {
+				as_incr_uint64(&as_node_get_counters(node)->total_timeouts);
 				break;
 			}
 
@@ -714,9 +1058,8 @@ Retry:
 		}
 
 		// Prepare for retry.
-		if (release_node) {
-			as_node_release(node);
-		}
+		as_incr_uint64(&as_node_get_counters(node)->retries);
+		as_command_release_node(node, node_ref);
 
 		if (sleep_between_retries > 0) {
 			// Sleep before trying again.
@@ -743,13 +1086,707 @@ Retry:
 			as_node_get_address_string(node));
 	}
 
-	if (release_node) {
-		as_node_release(node);
-	}
+	as_command_release_node(node, node_ref);
 	as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
 	return err->code;
 }
 
+void
+as_command_trace_init(
+	as_trace_span* span, as_cluster* cluster, const char* ns, const uint8_t* buf, size_t size,
+	bool async
+	)
+{
+	memset(span, 0, sizeof(as_trace_span));
+	span->queue_ns = cf_getns();
+	span->async = async;
+
+	// Compressed commands are not inspected.
+	if (size >= AS_HEADER_SIZE && buf[1] == AS_MESSAGE_TYPE) {
+		uint16_t n_fields = cf_swap_from_be16(*(uint16_t*)(buf + AS_HEADER_SIZE - 4));
+		const uint8_t* p = buf + AS_HEADER_SIZE;
+		const uint8_t* end = buf + size;
+
+		for (uint16_t i = 0; i < n_fields && p + AS_FIELD_HEADER_SIZE <= end; i++) {
+			uint32_t len = cf_swap_from_be32(*(uint32_t*)p) - 1;
+			uint8_t type = p[4];
+			p += AS_FIELD_HEADER_SIZE;
+
+			if (p + len > end) {
+				break;
+			}
+
+			if (type == AS_FIELD_NAMESPACE && len < sizeof(span->ns)) {
+				memcpy(span->ns, p, len);
+				span->ns[len] = 0;
+			}
+			else if (type == AS_FIELD_DIGEST && len == AS_DIGEST_VALUE_SIZE) {
+				memcpy(span->digest, p, AS_DIGEST_VALUE_SIZE);
+				span->partition_id = as_partition_getid(span->digest, cluster->n_partitions);
+				span->has_digest = true;
+			}
+			p += len;
+		}
+	}
+
+	if (! span->ns[0] && ns) {
+		as_strncpy(span->ns, ns, sizeof(span->ns));
+	}
+}
+
+void
+as_command_trace_hot_key(as_cluster* cluster, as_trace_span* span)
+{
+	if (span->has_digest) {
+		as_hot_keys_add(cluster->hot_keys, span->ns, span->digest, span->partition_id,
+			span->bytes_out + span->bytes_in);
+	}
+}
+
+as_status
+as_command_execute(as_command* cmd, as_error* err)
+{
+	bool trace = as_cluster_trace_sample(cmd->cluster);
+	bool hot_key = as_cluster_hot_key_sample(cmd->cluster);
+	bool capture = as_capture_sample(cmd->cluster->capture);
+
+	if (! trace && ! hot_key && ! capture) {
+		cmd->trace = NULL;
+		return as_command_run(cmd, err);
+	}
+
+	as_trace_hooks* hooks = &cmd->cluster->trace;
+	as_trace_span span;
+	as_command_trace_init(&span, cmd->cluster, cmd->ns, cmd->buf, cmd->buf_size, false);
+	span.hooks = trace;
+	span.hot_key = hot_key;
+	span.capture = capture ?
+		as_capture_begin(cmd->cluster->capture, cmd->buf, cmd->buf_size, false) : NULL;
+	cmd->trace = &span;
+
+	if (trace && hooks->begin) {
+		hooks->begin(&span, hooks->udata);
+	}
+
+	as_status status = as_command_run(cmd, err);
+
+	span.status = status;
+	span.end_ns = cf_getns();
+	cmd->trace = NULL;
+
+	if (hot_key) {
+		as_command_trace_hot_key(cmd->cluster, &span);
+	}
+
+	if (span.capture) {
+		as_capture_end(cmd->cluster->capture, span.capture, &span);
+	}
+
+	if (trace && hooks->end) {
+		hooks->end(&span, hooks->udata);
+	}
+	return status;
+}
+
+typedef struct as_command_mux_s {
+	as_node* node;
+	as_socket socket;
+	uint64_t begin_ns;
+	uint64_t expire_ms;
+} as_command_mux;
+
+static as_node*
+as_command_mux_node(as_command* cmd)
+{
+	// Reserve node while inside the epoch, so it can be held across the wait.
+	bool epoch = cmd->cluster->epoch_reclaim;
+
+	if (epoch) {
+		as_epoch_enter();
+	}
+
+	as_node* node = as_partition_get_node(cmd->cluster, cmd->ns, cmd->partition, NULL,
+										  cmd->replica, cmd->master);
+
+	if (node) {
+		as_node_reserve(node);
+	}
+
+	if (epoch) {
+		as_epoch_exit();
+	}
+
+	if (node && ! as_node_breaker_allow(node)) {
+		as_node_release(node);
+		return NULL;
+	}
+	return node;
+}
+
+static bool
+as_command_mux_send(as_command* cmd, as_command_mux* mux, as_error* err)
+{
+	// Routing errors, open breakers and connection failures are handled by normal execution.
+	as_node* node = as_command_mux_node(cmd);
+
+	if (! node) {
+		return false;
+	}
+
+	as_status status = as_node_get_connection(err, node, cmd->socket_timeout, cmd->deadline_ms,
+											  &mux->socket);
+
+	if (status != AEROSPIKE_OK) {
+		as_node_release(node);
+		return false;
+	}
+
+	// Responses are polled, so they can't be prefetched.
+	status = as_socket_write_deadline(err, &mux->socket, node, cmd->buf, cmd->buf_size,
+									  cmd->socket_timeout, cmd->deadline_ms);
+
+	if (status != AEROSPIKE_OK) {
+		as_node_close_conn_error(node, &mux->socket, mux->socket.pool);
+		as_node_release(node);
+		return false;
+	}
+	cmd->sent++;
+
+	as_command_counters* counters = as_node_get_counters(node);
+	as_incr_uint64(&counters->commands);
+	as_faa_uint64(&counters->bytes_out, cmd->buf_size);
+
+	uint64_t now = cf_getms();
+	mux->node = node;
+	mux->begin_ns = cf_getns();
+	mux->expire_ms = (cmd->socket_timeout > 0) ? now + cmd->socket_timeout : 0;
+
+	if (cmd->deadline_ms > 0 && (mux->expire_ms == 0 || cmd->deadline_ms < mux->expire_ms)) {
+		mux->expire_ms = cmd->deadline_ms;
+	}
+	return true;
+}
+
+static as_status
+as_command_mux_retry(as_command* cmd, as_node* node, as_error* err, as_status status)
+{
+	if (status == AEROSPIKE_ERR_TIMEOUT || status == AEROSPIKE_ERR_CONNECTION) {
+		as_cluster_incr_route_errors(cmd->cluster);
+	}
+
+	if (status == AEROSPIKE_ERR_TIMEOUT && ! is_server_timeout(err)) {
+		as_incr_uint64(&as_node_get_counters(node)->socket_timeouts);
+	}
+
+	if (++cmd->iteration > cmd->max_retries || ! as_cluster_retry_acquire(cmd->cluster)) {
+		as_node_release(node);
+		as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+		return status;
+	}
+
+	// Same replica selection as as_command_run().
+	if (cmd->replica != AS_POLICY_REPLICA_MASTER && (
+		((cmd->flags & AS_COMMAND_FLAGS_READ) && !(cmd->flags & AS_COMMAND_FLAGS_LINEARIZE)) ||
+		(status != AEROSPIKE_ERR_TIMEOUT && status != AEROSPIKE_ERR_NO_MORE_CONNECTIONS)
+		)) {
+		cmd->master = !cmd->master;
+	}
+
+	if (cmd->deadline_ms > 0 && cf_getms() >= cmd->deadline_ms) {
+		as_incr_uint64(&as_node_get_counters(node)->total_timeouts);
+		as_node_release(node);
+		as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+		return status;
+	}
+
+	as_incr_uint64(&as_node_get_counters(node)->retries);
+	as_node_release(node);
+
+	// Remaining attempts run one at a time.
+	as_error_reset(err);
+	return as_command_execute(cmd, err);
+}
+
+static as_status
+as_command_mux_read(as_command* cmd, as_command_mux* mux, as_error* err)
+{
+	as_node* node = mux->node;
+	as_socket* socket = &mux->socket;
+	as_status status = as_command_read_message(err, cmd, socket, node);
+
+	// Histograms only count commands that received a response.
+	if (node->latency && status != AEROSPIKE_ERR_TIMEOUT &&
+		status != AEROSPIKE_ERR_CONNECTION) {
+		as_node_record_latency(node, as_command_latency_type(cmd->flags), mux->begin_ns);
+	}
+
+	switch (status) {
+		case AEROSPIKE_OK:
+			break;
+
+		case AEROSPIKE_ERR_DEVICE_OVERLOAD:
+			as_node_put_conn_error(node, socket);
+			return as_command_mux_retry(cmd, node, err, status);
+
+		case AEROSPIKE_ERR_CONNECTION:
+			as_node_close_conn_error(node, socket, socket->pool);
+			return as_command_mux_retry(cmd, node, err, status);
+
+		case AEROSPIKE_ERR_TIMEOUT:
+			if (is_server_timeout(err)) {
+				as_node_put_conn_error(node, socket);
+			}
+			else {
+				as_node_close_conn_error(node, socket, socket->pool);
+			}
+			return as_command_mux_retry(cmd, node, err, status);
+
+		case AEROSPIKE_NOT_AUTHENTICATED:
+		case AEROSPIKE_ERR_TLS_ERROR:
+		case AEROSPIKE_ERR_CLIENT:
+			as_node_close_conn_error(node, socket, socket->pool);
+			as_node_release(node);
+			as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+			return status;
+
+		default:
+			as_error_set_in_doubt(err, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+			break;
+	}
+
+	as_node_put_connection(node, socket);
+	as_cluster_retry_deposit(cmd->cluster);
+	as_node_release(node);
+	return status;
+}
+
+static void
+as_command_mux_group(as_command* cmds, uint32_t n_cmds, as_error* errs, as_status* statuses)
+{
+	as_command_mux muxes[AS_COMMAND_MUX_MAX];
+	as_socket_fd fds[AS_COMMAND_MUX_MAX];
+	bool wait[AS_COMMAND_MUX_MAX];
+	bool ready[AS_COMMAND_MUX_MAX];
+	as_socket_fd max_fd = 0;
+	uint32_t pending = 0;
+
+	// Send all commands before reading any response.
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_command* cmd = &cmds[i];
+		as_error_init(&errs[i]);
+		fds[i] = 0;
+		wait[i] = false;
+
+		if (cmd->node || (cmd->flags & (AS_COMMAND_FLAGS_HEDGE | AS_COMMAND_FLAGS_GATHER)) ||
+			! as_command_mux_send(cmd, &muxes[i], &errs[i])) {
+			continue;
+		}
+
+		fds[i] = muxes[i].socket.fd;
+		wait[i] = true;
+		pending++;
+
+		if (fds[i] > max_fd) {
+			max_fd = fds[i];
+		}
+	}
+
+	// Commands that could not be sent run normally while the others are in flight.
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		if (! wait[i]) {
+			as_error_reset(&errs[i]);
+			statuses[i] = as_command_execute(&cmds[i], &errs[i]);
+		}
+	}
+
+	if (pending == 0) {
+		return;
+	}
+
+	as_poll poll;
+	as_poll_init(&poll, max_fd);
+
+	while (pending > 0) {
+		uint64_t next = 0;
+
+		for (uint32_t i = 0; i < n_cmds; i++) {
+			uint64_t expire = muxes[i].expire_ms;
+
+			if (wait[i] && expire > 0 && (next == 0 || expire < next)) {
+				next = expire;
+			}
+		}
+
+		// Zero timeout waits forever, so expired commands are polled once more for 1ms.
+		uint64_t now = cf_getms();
+		uint32_t timeout = (next == 0) ? 0 : (next > now) ? (uint32_t)(next - now) : 1;
+		int rv = as_poll_sockets_read_many(&poll, fds, wait, ready, n_cmds, timeout);
+
+		if (rv > 0) {
+			for (uint32_t i = 0; i < n_cmds; i++) {
+				if (ready[i]) {
+					wait[i] = false;
+					pending--;
+					statuses[i] = as_command_mux_read(&cmds[i], &muxes[i], &errs[i]);
+				}
+			}
+			continue;
+		}
+
+		int e = (rv < 0) ? as_last_error() : 0;
+
+		if (e == EINTR) {
+			continue;
+		}
+
+		// Timed out or poll failed.  No response is pending on the remaining sockets.
+		now = cf_getms();
+
+		for (uint32_t i = 0; i < n_cmds; i++) {
+			as_command_mux* mux = &muxes[i];
+
+			if (! wait[i] || (rv == 0 && (mux->expire_ms == 0 || now < mux->expire_ms))) {
+				continue;
+			}
+
+			wait[i] = false;
+			pending--;
+
+			as_status status;
+
+			if (rv == 0) {
+				status = as_error_set_message(&errs[i], AEROSPIKE_ERR_TIMEOUT, "");
+			}
+			else {
+				status = as_error_update(&errs[i], AEROSPIKE_ERR_CONNECTION, "Poll failed: %d", e);
+			}
+
+			as_node_close_conn_error(mux->node, &mux->socket, mux->socket.pool);
+			statuses[i] = as_command_mux_retry(&cmds[i], mux->node, &errs[i], status);
+		}
+	}
+	as_poll_destroy(&poll);
+}
+
+as_status
+as_command_execute_many(as_command* cmds, uint32_t n_cmds, as_status* statuses, as_error* err)
+{
+	as_error errs[AS_COMMAND_MUX_MAX];
+	as_status status = AEROSPIKE_OK;
+
+	for (uint32_t offset = 0; offset < n_cmds; offset += AS_COMMAND_MUX_MAX) {
+		uint32_t n = n_cmds - offset;
+
+		if (n > AS_COMMAND_MUX_MAX) {
+			n = AS_COMMAND_MUX_MAX;
+		}
+
+		as_command_mux_group(cmds + offset, n, errs, statuses + offset);
+
+		for (uint32_t i = 0; i < n; i++) {
+			as_status s = statuses[offset + i];
+
+			if (status == AEROSPIKE_OK && s != AEROSPIKE_OK &&
+				s != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+				as_error_copy(err, &errs[i]);
+				status = s;
+			}
+		}
+	}
+	return status;
+}
+
+typedef struct as_command_pipe_s {
+	as_node* node;
+	as_socket socket;
+	uint32_t* order; // Command offsets routed to node in send order.
+	uint32_t n_cmds;
+	uint32_t sent;
+	uint32_t read;
+} as_command_pipe;
+
+static void
+as_command_pipe_fail(
+	as_command* cmds, as_command_pipe* pipe, as_error* errs, as_status* statuses,
+	as_error* cause, as_status status
+	)
+{
+	// Connection is unusable.  Retry commands that were sent and run the rest normally.
+	as_node* node = pipe->node;
+	as_node_close_conn_error(node, &pipe->socket, pipe->socket.pool);
+
+	for (uint32_t i = pipe->read; i < pipe->n_cmds; i++) {
+		uint32_t offset = pipe->order[i];
+		as_error* e = &errs[offset];
+
+		if (i < pipe->sent) {
+			if (e != cause) {
+				as_error_copy(e, cause);
+			}
+			as_node_reserve(node);
+			statuses[offset] = as_command_mux_retry(&cmds[offset], node, e, status);
+		}
+		else {
+			as_error_reset(e);
+			statuses[offset] = as_command_execute(&cmds[offset], e);
+		}
+	}
+	pipe->read = pipe->sent = pipe->n_cmds;
+	as_node_release(node);
+	pipe->node = NULL;
+}
+
+static bool
+as_command_pipe_write(
+	as_command* cmds, as_command_pipe* pipe, uint32_t window, as_error* errs,
+	as_status* statuses, uint64_t* begin
+	)
+{
+	as_node* node = pipe->node;
+	as_command_counters* counters = as_node_get_counters(node);
+
+	while (pipe->sent < pipe->n_cmds && pipe->sent - pipe->read < window) {
+		uint32_t offset = pipe->order[pipe->sent];
+		as_command* cmd = &cmds[offset];
+		as_error* e = &errs[offset];
+
+		// Responses are read in order, so they can't be prefetched.
+		as_status status = as_socket_write_deadline(e, &pipe->socket, node, cmd->buf,
+			cmd->buf_size, cmd->socket_timeout, cmd->deadline_ms);
+
+		if (status != AEROSPIKE_OK) {
+			// The command was not sent, so it runs normally with the rest.
+			as_error e2;
+			as_error_copy(&e2, e);
+			as_command_pipe_fail(cmds, pipe, errs, statuses, &e2, status);
+			return false;
+		}
+		cmd->sent++;
+		begin[offset] = cf_getns();
+		as_incr_uint64(&counters->commands);
+		as_faa_uint64(&counters->bytes_out, cmd->buf_size);
+		pipe->sent++;
+	}
+	return true;
+}
+
+static void
+as_command_pipe_read(
+	as_command* cmds, as_command_pipe* pipe, as_error* errs, as_status* statuses,
+	uint64_t* begin
+	)
+{
+	as_node* node = pipe->node;
+	uint32_t offset = pipe->order[pipe->read];
+	as_command* cmd = &cmds[offset];
+	as_error* e = &errs[offset];
+	as_status status = as_command_read_message(e, cmd, &pipe->socket, node);
+
+	if (node->latency && status != AEROSPIKE_ERR_TIMEOUT &&
+		status != AEROSPIKE_ERR_CONNECTION) {
+		as_node_record_latency(node, as_command_latency_type(cmd->flags), begin[offset]);
+	}
+
+	switch (status) {
+		case AEROSPIKE_OK:
+			break;
+
+		case AEROSPIKE_ERR_TIMEOUT:
+			if (! is_server_timeout(e)) {
+				as_command_pipe_fail(cmds, pipe, errs, statuses, e, status);
+				return;
+			}
+			// Server responded, so the connection is still in sync.
+			// Fall through.
+
+		case AEROSPIKE_ERR_DEVICE_OVERLOAD:
+			as_node_incr_error_count(node);
+			pipe->read++;
+			as_node_reserve(node);
+			statuses[offset] = as_command_mux_retry(cmd, node, e, status);
+			return;
+
+		case AEROSPIKE_ERR_CONNECTION:
+		case AEROSPIKE_NOT_AUTHENTICATED:
+		case AEROSPIKE_ERR_TLS_ERROR:
+		case AEROSPIKE_ERR_CLIENT:
+			if (status != AEROSPIKE_ERR_CONNECTION) {
+				// Not retryable.  Remaining commands are retried as connection errors.
+				as_error_set_in_doubt(e, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+				statuses[offset] = status;
+				pipe->read++;
+
+				as_error e2;
+				as_error_init(&e2);
+				as_error_update(&e2, AEROSPIKE_ERR_CONNECTION, "Pipeline aborted: %s",
+					e->message);
+				as_command_pipe_fail(cmds, pipe, errs, statuses, &e2, AEROSPIKE_ERR_CONNECTION);
+				return;
+			}
+			as_command_pipe_fail(cmds, pipe, errs, statuses, e, status);
+			return;
+
+		default:
+			as_error_set_in_doubt(e, cmd->flags & AS_COMMAND_FLAGS_READ, cmd->sent);
+			break;
+	}
+
+	statuses[offset] = status;
+	as_cluster_retry_deposit(cmd->cluster);
+	pipe->read++;
+}
+
+as_status
+as_command_execute_pipeline(
+	as_command* cmds, uint32_t n_cmds, uint32_t window, as_status* statuses, as_error* err
+	)
+{
+	if (window == 0) {
+		window = AS_COMMAND_PIPELINE_WINDOW;
+	}
+
+	as_error* errs = cf_malloc(sizeof(as_error) * n_cmds);
+	uint64_t* begin = cf_malloc(sizeof(uint64_t) * n_cmds);
+	uint32_t* pipe_of = cf_malloc(sizeof(uint32_t) * n_cmds);
+	uint32_t* order = cf_malloc(sizeof(uint32_t) * n_cmds);
+	as_vector pipes;
+	as_vector_init(&pipes, sizeof(as_command_pipe), 8);
+
+	// Group commands by node.  Routing errors and open breakers are handled by normal execution.
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_command* cmd = &cmds[i];
+		as_error_init(&errs[i]);
+		pipe_of[i] = UINT32_MAX;
+
+		if (cmd->node || (cmd->flags & (AS_COMMAND_FLAGS_HEDGE | AS_COMMAND_FLAGS_GATHER))) {
+			continue;
+		}
+
+		as_node* node = as_command_mux_node(cmd);
+
+		if (! node) {
+			continue;
+		}
+
+		uint32_t p = 0;
+
+		while (p < pipes.size && ((as_command_pipe*)as_vector_get(&pipes, p))->node != node) {
+			p++;
+		}
+
+		if (p == pipes.size) {
+			as_command_pipe* pipe = as_vector_reserve(&pipes);
+			pipe->node = node;
+			pipe->n_cmds = 0;
+			pipe->sent = 0;
+			pipe->read = 0;
+		}
+		else {
+			as_node_release(node);
+		}
+
+		as_command_pipe* pipe = as_vector_get(&pipes, p);
+		pipe->n_cmds++;
+		pipe_of[i] = p;
+	}
+
+	uint32_t n = 0;
+
+	for (uint32_t p = 0; p < pipes.size; p++) {
+		as_command_pipe* pipe = as_vector_get(&pipes, p);
+		pipe->order = order + n;
+		n += pipe->n_cmds;
+		pipe->n_cmds = 0;
+	}
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		if (pipe_of[i] != UINT32_MAX) {
+			as_command_pipe* pipe = as_vector_get(&pipes, pipe_of[i]);
+			pipe->order[pipe->n_cmds++] = i;
+		}
+	}
+
+	// Open one connection per node.  Connection failures run that node's commands normally.
+	for (uint32_t p = 0; p < pipes.size; p++) {
+		as_command_pipe* pipe = as_vector_get(&pipes, p);
+		as_command* cmd = &cmds[pipe->order[0]];
+		as_error* e = &errs[pipe->order[0]];
+		as_status status = as_node_get_connection(e, pipe->node, cmd->socket_timeout,
+			cmd->deadline_ms, &pipe->socket);
+
+		if (status != AEROSPIKE_OK) {
+			for (uint32_t i = 0; i < pipe->n_cmds; i++) {
+				pipe_of[pipe->order[i]] = UINT32_MAX;
+			}
+			as_node_release(pipe->node);
+			pipe->node = NULL;
+			pipe->read = pipe->sent = pipe->n_cmds;
+		}
+	}
+
+	// Commands that can't be pipelined run while the pipelines are idle.
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		if (pipe_of[i] == UINT32_MAX) {
+			as_error_reset(&errs[i]);
+			statuses[i] = as_command_execute(&cmds[i], &errs[i]);
+		}
+	}
+
+	// Fill every window before blocking on a response, so all nodes work in parallel.
+	uint32_t pending = (uint32_t)pipes.size;
+
+	while (pending > 0) {
+		pending = 0;
+
+		for (uint32_t p = 0; p < pipes.size; p++) {
+			as_command_pipe* pipe = as_vector_get(&pipes, p);
+
+			if (pipe->node) {
+				as_command_pipe_write(cmds, pipe, window, errs, statuses, begin);
+			}
+		}
+
+		for (uint32_t p = 0; p < pipes.size; p++) {
+			as_command_pipe* pipe = as_vector_get(&pipes, p);
+
+			if (pipe->node && pipe->read < pipe->sent) {
+				as_command_pipe_read(cmds, pipe, errs, statuses, begin);
+			}
+
+			if (! pipe->node) {
+				continue;
+			}
+
+			if (pipe->read == pipe->n_cmds) {
+				as_node_put_connection(pipe->node, &pipe->socket);
+				as_node_release(pipe->node);
+				pipe->node = NULL;
+				continue;
+			}
+			pending++;
+		}
+	}
+
+	as_status status = AEROSPIKE_OK;
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_status s = statuses[i];
+
+		if (s != AEROSPIKE_OK && s != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+			as_error_copy(err, &errs[i]);
+			status = s;
+			break;
+		}
+	}
+
+	as_vector_destroy(&pipes);
+	cf_free(order);
+	cf_free(pipe_of);
+	cf_free(begin);
+	cf_free(errs);
+	return status;
+}
+
 static as_status
 as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_node* node)
 {
@@ -764,8 +1801,9 @@ as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_nod
 
 	while (true) {
 		// Read header
-		status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto),
-										 cmd->socket_timeout, cmd->deadline_ms);
+		status = as_socket_read_spin_deadline(err, sock, node, (uint8_t*)&proto,
+											  sizeof(as_proto), cmd->policy->read_spin_us,
+											  cmd->socket_timeout, cmd->deadline_ms);
 		
 		if (status != AEROSPIKE_OK) {
 			break;
@@ -779,6 +1817,10 @@ as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_nod
 
 		size = proto.sz;
 
+		if (cmd->trace) {
+			as_command_trace_read(cmd->trace, size);
+		}
+
 		if (size == 0) {
 			continue;
 		}
@@ -797,6 +1839,9 @@ as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_nod
 		if (status != AEROSPIKE_OK) {
 			break;
 		}
+
+		as_command_counters* counters = as_node_get_counters(node);
+		as_faa_uint64(&counters->bytes_in, sizeof(as_proto) + size);
 		
 		if (proto.type == AS_MESSAGE_TYPE) {
 			status = cmd->parse_results_fn(err, cmd, node, buf, size);
@@ -808,6 +1853,9 @@ as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_nod
 				break;
 			}
 
+			as_faa_uint64(&counters->compressed_in, sizeof(as_proto) + size);
+			as_faa_uint64(&counters->uncompressed_in, size2);
+
 			if (size2 > capacity2) {
 				as_command_buffer_free(buf2, capacity2);
 				capacity2 = (size2 + 16383) & ~16383; // Round up in 16KB increments.
@@ -840,12 +1888,180 @@ as_command_read_messages(as_error* err, as_command* cmd, as_socket* sock, as_nod
 	return status;
 }
 
+// Bytes read from the socket per listener call.
+#define AS_STREAM_CHUNK_SIZE (1024 * 16)
+
+static as_status
+as_command_stream_read(
+	as_error* err, as_command* cmd, as_socket* sock, as_node* node, uint8_t* buf, size_t len,
+	size_t* remain
+	)
+{
+	if (len > *remain) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid stream response size: %zu",
+			len);
+	}
+	*remain -= len;
+	return as_socket_read_deadline(err, sock, node, buf, len, cmd->socket_timeout,
+		cmd->deadline_ms);
+}
+
+static as_status
+as_command_stream_skip(
+	as_error* err, as_command* cmd, as_socket* sock, as_node* node, uint8_t* chunk, size_t len,
+	size_t* remain
+	)
+{
+	while (len > 0) {
+		size_t n = (len < AS_STREAM_CHUNK_SIZE) ? len : AS_STREAM_CHUNK_SIZE;
+		as_status status = as_command_stream_read(err, cmd, sock, node, chunk, n, remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+		len -= n;
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_command_stream_value(
+	as_error* err, as_command* cmd, as_socket* sock, as_node* node, uint8_t* chunk,
+	uint32_t value_size, size_t* remain
+	)
+{
+	as_stream_bin* stream = cmd->udata;
+
+	if (stream->buf) {
+		if (value_size > stream->capacity) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+				"Bin %s size %u exceeds buffer capacity %u", stream->bin, value_size,
+				stream->capacity);
+		}
+		return as_command_stream_read(err, cmd, sock, node, stream->buf, value_size, remain);
+	}
+
+	while (value_size > 0) {
+		uint32_t n = (value_size < AS_STREAM_CHUNK_SIZE) ? value_size : AS_STREAM_CHUNK_SIZE;
+		as_status status = as_command_stream_read(err, cmd, sock, node, chunk, n, remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		// The listener has seen data, so a retry would deliver it twice.
+		cmd->max_retries = cmd->iteration;
+
+		if (! stream->listener(chunk, n, stream->udata)) {
+			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT_ABORT,
+				"Stream listener aborted read");
+		}
+		value_size -= n;
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_command_read_stream(as_error* err, as_command* cmd, as_socket* sock, as_node* node, size_t size)
+{
+	as_stream_bin* stream = cmd->udata;
+	uint8_t chunk[AS_STREAM_CHUNK_SIZE];
+	size_t remain = size;
+	as_msg msg;
+	as_status status = as_command_stream_read(err, cmd, sock, node, (uint8_t*)&msg,
+		sizeof(as_msg), &remain);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_msg_swap_header_from_be(&msg);
+	status = msg.result_code;
+
+	if (status != AEROSPIKE_OK) {
+		// Drain error response, so the connection can be reused.
+		as_status s = as_command_stream_skip(err, cmd, sock, node, chunk, remain, &remain);
+
+		if (s != AEROSPIKE_OK) {
+			return s;
+		}
+		as_error_update_status(err, status, as_node_get_address_string(node),
+							   cmd->cluster->lazy_error_messages);
+		return status;
+	}
+
+	stream->gen = msg.generation;
+	stream->ttl = cf_server_void_time_to_ttl(msg.record_ttl);
+
+	for (uint16_t i = 0; i < msg.n_fields; i++) {
+		uint32_t field_size;
+		status = as_command_stream_read(err, cmd, sock, node, (uint8_t*)&field_size,
+			sizeof(field_size), &remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		status = as_command_stream_skip(err, cmd, sock, node, chunk,
+			cf_swap_from_be32(field_size), &remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+
+	size_t bin_len = strlen(stream->bin);
+
+	for (uint16_t i = 0; i < msg.n_ops; i++) {
+		// Op size, op, particle type, version and name size.
+		uint8_t op[8];
+		status = as_command_stream_read(err, cmd, sock, node, op, sizeof(op), &remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		uint32_t op_size = cf_swap_from_be32(*(uint32_t*)op);
+		uint8_t type = op[5];
+		uint8_t name_size = op[7];
+
+		if (op_size < (uint32_t)name_size + 4) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid bin op size: %u",
+				op_size);
+		}
+
+		status = as_command_stream_read(err, cmd, sock, node, chunk, name_size, &remain);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		uint32_t value_size = op_size - (name_size + 4);
+
+		if (name_size == bin_len && memcmp(chunk, stream->bin, bin_len) == 0) {
+			stream->found = true;
+			stream->type = type;
+			stream->size = value_size;
+			status = as_command_stream_value(err, cmd, sock, node, chunk, value_size, &remain);
+		}
+		else {
+			status = as_command_stream_skip(err, cmd, sock, node, chunk, value_size, &remain);
+		}
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+	return as_command_stream_skip(err, cmd, sock, node, chunk, remain, &remain);
+}
+
 static as_status
 as_command_read_message(as_error* err, as_command* cmd, as_socket* sock, as_node* node)
 {
 	as_proto proto;
-	as_status status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto),
-											   cmd->socket_timeout, cmd->deadline_ms);
+	as_status status = as_socket_read_spin_deadline(err, sock, node, (uint8_t*)&proto,
+													sizeof(as_proto), cmd->policy->read_spin_us,
+													cmd->socket_timeout, cmd->deadline_ms);
 
 	if (status != AEROSPIKE_OK) {
 		return status;
@@ -859,21 +2075,37 @@ as_command_read_message(as_error* err, as_command* cmd, as_socket* sock, as_node
 
 	size_t size = proto.sz;
 
+	if (cmd->trace) {
+		as_command_trace_read(cmd->trace, size);
+	}
+
 	if (size == 0) {
 		return as_proto_size_error(err, size);
 	}
 
-	uint8_t* buf = as_command_buffer_init(size);
+	as_command_counters* counters = as_node_get_counters(node);
+
+	if ((cmd->flags & AS_COMMAND_FLAGS_STREAM) && proto.type == AS_MESSAGE_TYPE) {
+		// Read bin value straight into the caller's destination.
+		as_faa_uint64(&counters->bytes_in, sizeof(as_proto) + size);
+		return as_command_read_stream(err, cmd, sock, node, size);
+	}
+
+	uint8_t* buf = as_command_response_init(cmd, size);
 	status = as_socket_read_deadline(err, sock, node, buf, size, cmd->socket_timeout, cmd->deadline_ms);
 
 	if (status != AEROSPIKE_OK) {
-		as_command_buffer_free(buf, size);
+		as_command_response_free(cmd, buf, size);
 		return status;
 	}
 
+	as_faa_uint64(&counters->bytes_in, sizeof(as_proto) + size);
+
 	if (proto.type == AS_MESSAGE_TYPE) {
+		// Parser clears response if it takes ownership of the buffer.
+		cmd->response = buf;
 		status = cmd->parse_results_fn(err, cmd, node, buf, size);
-		as_command_buffer_free(buf, size);
+		as_command_response_free(cmd, cmd->response, size);
 		return status;
 	}
 	else if (proto.type == AS_COMPRESSED_MESSAGE_TYPE) {
@@ -881,25 +2113,31 @@ as_command_read_message(as_error* err, as_command* cmd, as_socket* sock, as_node
 		status = as_compressed_size_parse(err, buf, &size2);
 
 		if (status != AEROSPIKE_OK) {
-			as_command_buffer_free(buf, size);
+			as_command_response_free(cmd, buf, size);
 			return status;
 		}
 
-		uint8_t* buf2 = as_command_buffer_init(size2);
+		as_faa_uint64(&counters->compressed_in, sizeof(as_proto) + size);
+		as_faa_uint64(&counters->uncompressed_in, size2);
+
+		uint8_t* buf2 = as_command_response_init(cmd, size2);
 		status = as_proto_decompress(err, buf2, size2, buf, size);
-		as_command_buffer_free(buf, size);
+		as_command_response_free(cmd, buf, size);
 
 		if (status != AEROSPIKE_OK) {
-			as_command_buffer_free(buf2, size2);
+			as_command_response_free(cmd, buf2, size2);
 			return status;
 		}
+
+		// Parser clears response if it takes ownership of the buffer.
+		cmd->response = buf2;
 		status = cmd->parse_results_fn(err, cmd, node, buf2 + sizeof(as_proto),
 									   size2 - sizeof(as_proto));
-		as_command_buffer_free(buf2, size2);
+		as_command_response_free(cmd, cmd->response, size2);
 		return status;
 	}
 	else {
-		as_command_buffer_free(buf, size);
+		as_command_response_free(cmd, buf, size);
 		return as_proto_type_error(err, &proto, AS_MESSAGE_TYPE);
 	}
 }
@@ -915,7 +2153,8 @@ as_command_parse_header(as_error* err, as_command* cmd, as_node* node, uint8_t*
 	}
 
 	if (msg->result_code) {
-		return as_error_set_message(err, msg->result_code, as_error_string(msg->result_code));
+		return as_error_update_status(err, msg->result_code, NULL,
+									  cmd->cluster->lazy_error_messages);
 	}
 
 	as_record** rec = cmd->udata;
@@ -1000,7 +2239,60 @@ as_command_ignore_bins(uint8_t* p, uint32_t n_bins)
 }
 
 uint8_t*
-as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval)
+as_command_parse_digest(uint8_t* p, uint32_t n_fields, as_digest* digest, uint64_t* bval)
+{
+	uint32_t len;
+	uint32_t size;
+
+	for (uint32_t i = 0; i < n_fields; i++) {
+		len = cf_swap_from_be32(*(uint32_t*)p) - 1;
+		p += 4;
+
+		switch (*p++) {
+			case AS_FIELD_DIGEST:
+				size = (len < AS_DIGEST_VALUE_SIZE) ? len : AS_DIGEST_VALUE_SIZE;
+				digest->init = true;
+				memcpy(digest->value, p, size);
+				break;
+
+			case AS_FIELD_BVAL_ARRAY:
+				*bval = cf_swap_from_le64(*(uint64_t*)p);
+				break;
+		}
+		p += len;
+	}
+	return p;
+}
+
+uint8_t*
+as_command_parse_record_raw(uint8_t* p, as_msg* msg, as_record_raw* rec, uint64_t* bval)
+{
+	rec->digest.init = false;
+	rec->gen = msg->generation;
+	rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+	rec->n_bins = msg->n_ops;
+
+	p = as_command_parse_digest(p, msg->n_fields, &rec->digest, bval);
+	rec->bins = p;
+	return as_command_ignore_bins(p, msg->n_ops);
+}
+
+static inline char*
+as_command_value_alloc(as_record_reuse* reuse, size_t size)
+{
+	if (reuse) {
+		// Buffer was sized for the whole record before parsing.
+		char* v = (char*)reuse->buf + reuse->offset;
+		reuse->offset += (uint32_t)size;
+		return v;
+	}
+	return cf_malloc(size);
+}
+
+static uint8_t*
+as_command_parse_key_buf(
+	uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval, as_record_reuse* reuse
+	)
 {
 	uint32_t len;
 	uint32_t size;
@@ -1020,6 +2312,7 @@ as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval)
 				size = (len < (AS_NAMESPACE_MAX_SIZE-1)) ? len : (AS_NAMESPACE_MAX_SIZE-1);
 				memcpy(key->ns, p, size);
 				key->ns[size] = 0;
+				key->ns_id = 0;
 				break;
 				
 			case AS_FIELD_SETNAME:
@@ -1048,14 +2341,21 @@ as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval)
 						break;
 					}
 					case AS_BYTES_STRING: {
-						char* value = cf_malloc(len+1);
+						char* value = as_command_value_alloc(reuse, len+1);
 						memcpy(value, p, len);
 						value[len] = 0;
-						as_string_init_wlen((as_string*)&key->value, value, len, true);
+						as_string_init_wlen((as_string*)&key->value, value, len, ! reuse);
 						key->valuep = &key->value;
 						break;
 					}
 					case AS_BYTES_BLOB: {
+						if (reuse) {
+							// Reference key in response buffer.
+							as_bytes_init_wrap((as_bytes*)&key->value, p, len, false);
+							key->valuep = &key->value;
+							break;
+						}
+
 						void* value = cf_malloc(len);
 						memcpy(value, p, len);
 						as_bytes_init_wrap((as_bytes*)&key->value, (uint8_t*)value, len, true);
@@ -1078,7 +2378,13 @@ as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval)
 	return p;
 }
 
-static void
+uint8_t*
+as_command_parse_key(uint8_t* p, uint32_t n_fields, as_key* key, uint64_t* bval)
+{
+	return as_command_parse_key_buf(p, n_fields, key, bval, NULL);
+}
+
+void
 as_command_parse_value(uint8_t* p, uint8_t type, uint32_t value_size, as_val** value)
 {
 	// Allocate values on heap.
@@ -1274,8 +2580,11 @@ abort_record_memory(as_error* err, as_record* rec, size_t size)
 	return as_error_update(err, AEROSPIKE_ERR_CLIENT, "malloc failure: %zu", size);
 }
 
-as_status
-as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize)
+static as_status
+as_command_parse_bins_buf(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize, bool zero_copy,
+	as_record_reuse* reuse, bool arena
+	)
 {
 	uint8_t* p = *pp;
 	as_bin* bin = rec->bins.entries;
@@ -1324,14 +2633,14 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 				break;
 			}
 			case AS_BYTES_STRING: {
-				char* value = cf_malloc(value_size + 1);
+				char* value = as_command_value_alloc(reuse, value_size + 1);
 
 				if (! value) {
 					return abort_record_memory(err, rec, value_size + 1);
 				}
 				memcpy(value, p, value_size);
 				value[value_size] = 0;
-				as_string_init_wlen((as_string*)&bin->value, (char*)value, value_size, true);
+				as_string_init_wlen((as_string*)&bin->value, (char*)value, value_size, ! reuse);
 				bin->valuep = &bin->value;
 				break;
 			}
@@ -1350,7 +2659,7 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 
 				// Use the json bytes.
 				size_t jsonsz = value_size - 1 - 2 - (ncells * sizeof(uint64_t));
-				char* v = cf_malloc(jsonsz + 1);
+				char* v = as_command_value_alloc(reuse, jsonsz + 1);
 
 				if (! v) {
 					return abort_record_memory(err, rec, jsonsz + 1);
@@ -1358,7 +2667,7 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 				memcpy(v, ptr, jsonsz);
 				v[jsonsz] = 0;
 				as_geojson_init_wlen((as_geojson*)&bin->value,
-									 (char*)v, jsonsz, true);
+									 (char*)v, jsonsz, ! reuse);
 				bin->valuep = &bin->value;
 				break;
 			}
@@ -1366,6 +2675,12 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 			case AS_BYTES_MAP: {
 				if (deserialize) {
 					as_val* value = 0;
+
+					// Fall back to the heap when the arena unpacker does not support the value.
+					if (arena && as_arena_unpack_val(&rec->arena, p, value_size, &value) == 0) {
+						bin->valuep = (as_bin_value*)value;
+						break;
+					}
 					
 					as_buffer buffer;
 					buffer.data = p;
@@ -1381,27 +2696,40 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 					}
 					bin->valuep = (as_bin_value*)value;
 				}
+				else if (zero_copy) {
+					as_bytes_init_wrap((as_bytes*)&bin->value, p, value_size, false);
+					bin->value.bytes.type = (as_bytes_type)type;
+					bin->valuep = &bin->value;
+				}
 				else {
-					void* value = cf_malloc(value_size);
+					void* value = as_command_value_alloc(reuse, value_size);
 
 					if (! value) {
 						return abort_record_memory(err, rec, value_size);
 					}
 					memcpy(value, p, value_size);
-					as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, true);
+					as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, ! reuse);
 					bin->value.bytes.type = (as_bytes_type)type;
 					bin->valuep = &bin->value;
 				}
 				break;
 			}
 			default: {
-				void* value = cf_malloc(value_size);
+				if (zero_copy) {
+					// Reference value in response buffer.
+					as_bytes_init_wrap((as_bytes*)&bin->value, p, value_size, false);
+					bin->value.bytes.type = (as_bytes_type)type;
+					bin->valuep = &bin->value;
+					break;
+				}
+
+				void* value = as_command_value_alloc(reuse, value_size);
 
 				if (! value) {
 					return abort_record_memory(err, rec, value_size);
 				}
 				memcpy(value, p, value_size);
-				as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, true);
+				as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, ! reuse);
 				bin->value.bytes.type = (as_bytes_type)type;
 				bin->valuep = &bin->value;
 				break;
@@ -1414,6 +2742,101 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 	return AEROSPIKE_OK;
 }
 
+as_status
+as_command_parse_bins(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize, bool zero_copy
+	)
+{
+	return as_command_parse_bins_buf(pp, err, rec, n_bins, deserialize, zero_copy, NULL, false);
+}
+
+as_status
+as_command_parse_bins_arena(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize,
+	as_arena_chunk* chunk
+	)
+{
+	// Copy values to the free part of the chunk.  Only the value buffer of the reuse
+	// structure is used.
+	as_record_reuse reuse;
+	reuse.buf = chunk->data + chunk->offset;
+	reuse.capacity = chunk->capacity - chunk->offset;
+	reuse.offset = 0;
+
+	as_status status = as_command_parse_bins_buf(pp, err, rec, n_bins, deserialize, false, &reuse,
+		false);
+	chunk->offset += reuse.offset;
+	return status;
+}
+
+void
+as_record_reuse_init(as_record_reuse* reuse)
+{
+	as_record_init(&reuse->rec, 0);
+	reuse->buf = NULL;
+	reuse->capacity = 0;
+	reuse->offset = 0;
+}
+
+void
+as_record_reuse_destroy(as_record_reuse* reuse)
+{
+	as_record_destroy(&reuse->rec);
+	as_memory_sub(AS_MEMORY_QUERY, reuse->capacity);
+	cf_free(reuse->buf);
+}
+
+as_status
+as_command_parse_record_reuse(
+	uint8_t** pp, as_error* err, as_msg* msg, as_record_reuse* reuse, bool deserialize,
+	uint64_t* bval
+	)
+{
+	as_record* rec = &reuse->rec;
+
+	// Release values of the previous record. Only deserialized lists/maps own memory.
+	for (uint16_t i = 0; i < rec->bins.size; i++) {
+		as_val_destroy((as_val*)rec->bins.entries[i].valuep);
+	}
+	rec->bins.size = 0;
+
+	as_val_destroy((as_val*)rec->key.valuep);
+	rec->key.valuep = NULL;
+	rec->key.ns[0] = '\0';
+	rec->key.set[0] = '\0';
+	rec->key.digest.init = false;
+
+	if (msg->n_ops > rec->bins.capacity) {
+		as_record_free_entries(rec);
+		rec->bins.entries = cf_malloc(sizeof(as_bin) * msg->n_ops);
+		rec->bins.capacity = msg->n_ops;
+		rec->bins._free = true;
+	}
+
+	// Copied strings never exceed the record's wire size, because each field and bin
+	// header is larger than the added null terminator.
+	uint8_t* p = *pp;
+	uint8_t* end = as_command_ignore_bins(as_command_ignore_fields(p, msg->n_fields), msg->n_ops);
+	uint32_t size = (uint32_t)(end - p);
+
+	if (size > reuse->capacity) {
+		as_memory_sub(AS_MEMORY_QUERY, reuse->capacity);
+		cf_free(reuse->buf);
+		reuse->capacity = (size + 16383) & ~16383; // Round up in 16KB increments.
+		reuse->buf = cf_malloc(reuse->capacity);
+		as_memory_add(AS_MEMORY_QUERY, reuse->capacity);
+	}
+	reuse->offset = 0;
+
+	rec->gen = msg->generation;
+	rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+
+	*pp = as_command_parse_key_buf(p, msg->n_fields, &rec->key, bval, reuse);
+
+	// Other values reference the response buffer.
+	return as_command_parse_bins_buf(pp, err, rec, msg->n_ops, deserialize, true, reuse, false);
+}
+
 as_status
 as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
 {
@@ -1442,12 +2865,20 @@ as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t*
 						bin->valuep = NULL;
 					}
 
+					if (rec->buffer) {
+						// Old bin values referenced previous response buffer.
+						cf_free(rec->buffer);
+						rec->buffer = NULL;
+					}
+
+					if (rec->arena) {
+						as_arena_destroy(rec->arena);
+						rec->arena = NULL;
+					}
+
 					if (msg->n_ops > rec->bins.capacity) {
-						if (rec->bins._free) {
-							cf_free(rec->bins.entries);
-						}
+						as_record_free_entries(rec);
 						rec->bins.capacity = msg->n_ops;
-						rec->bins.size = 0;
 						rec->bins.entries = cf_malloc(sizeof(as_bin) * msg->n_ops);
 						rec->bins._free = true;
 					}
@@ -1460,9 +2891,21 @@ as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t*
 				}
 				rec->gen = msg->generation;
 				rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+				rec->lazy = data->lazy;
 				
 				p = as_command_ignore_fields(p, msg->n_fields);
-				status = as_command_parse_bins(&p, err, rec, msg->n_ops, data->deserialize);
+
+				bool zero_copy = (cmd->flags & AS_COMMAND_FLAGS_ZERO_COPY) && cmd->response;
+
+				if (zero_copy) {
+					// Record takes ownership of response buffer on success or failure.
+					rec->buffer = cmd->response;
+					cmd->response = NULL;
+				}
+
+				// Lazy records keep lists/maps as raw bytes until they are read.
+				status = as_command_parse_bins_buf(&p, err, rec, msg->n_ops,
+					data->deserialize && ! data->lazy, zero_copy, NULL, data->arena);
 
 				if (status != AEROSPIKE_OK && free_on_error) {
 					as_record_destroy(rec);
@@ -1477,13 +2920,109 @@ as_command_parse_result(as_error* err, as_command* cmd, as_node* node, uint8_t*
 		}
 			
 		default:
-			as_error_update(err, status, "%s %s", as_node_get_address_string(node),
-							as_error_string(status));
+			as_error_update_status(err, status, as_node_get_address_string(node),
+								   cmd->cluster->lazy_error_messages);
+			break;
+	}
+	return status;
+}
+
+as_status
+as_command_parse_bound(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+{
+	as_command_parse_bound_data* data = cmd->udata;
+	as_msg* msg = (as_msg*)buf;
+	as_status status = as_msg_parse(err, msg, size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+	status = msg->result_code;
+
+	uint8_t* p = buf + sizeof(as_msg);
+
+	switch (status) {
+		case AEROSPIKE_OK: {
+			// Values are decoded straight from the response buffer into the user struct.
+			as_record_raw rec;
+			uint64_t bval = 0;
+			as_command_parse_record_raw(p, msg, &rec, &bval);
+			as_binding_decode(data->binding, &rec, data->obj, data->status);
+			break;
+		}
+
+		case AEROSPIKE_ERR_UDF: {
+			status = as_command_parse_udf_failure(p, err, msg, status);
+			break;
+		}
+
+		default:
+			as_error_update_status(err, status, as_node_get_address_string(node),
+								   cmd->cluster->lazy_error_messages);
 			break;
 	}
 	return status;
 }
 
+as_status
+as_command_parse_stream(as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size)
+{
+	// Only compressed responses are buffered. Deliver the value from the response.
+	as_stream_bin* stream = cmd->udata;
+	as_msg* msg = (as_msg*)buf;
+	as_status status = as_msg_parse(err, msg, size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+	status = msg->result_code;
+
+	if (status != AEROSPIKE_OK) {
+		as_error_update_status(err, status, as_node_get_address_string(node),
+							   cmd->cluster->lazy_error_messages);
+		return status;
+	}
+
+	stream->gen = msg->generation;
+	stream->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
+
+	uint8_t* p = as_command_ignore_fields(buf + sizeof(as_msg), msg->n_fields);
+	size_t bin_len = strlen(stream->bin);
+
+	for (uint16_t i = 0; i < msg->n_ops; i++) {
+		uint32_t op_size = cf_swap_from_be32(*(uint32_t*)p);
+		uint8_t type = p[5];
+		uint8_t name_size = p[7];
+		uint8_t* name = p + 8;
+		uint32_t value_size = op_size - (name_size + 4);
+		uint8_t* value = name + name_size;
+		p = value + value_size;
+
+		if (name_size != bin_len || memcmp(name, stream->bin, bin_len) != 0) {
+			continue;
+		}
+
+		stream->found = true;
+		stream->type = type;
+		stream->size = value_size;
+
+		if (stream->buf) {
+			if (value_size > stream->capacity) {
+				return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+					"Bin %s size %u exceeds buffer capacity %u", stream->bin, value_size,
+					stream->capacity);
+			}
+			memcpy(stream->buf, value, value_size);
+		}
+		else if (value_size > 0 && ! stream->listener(value, value_size, stream->udata)) {
+			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT_ABORT,
+				"Stream listener aborted read");
+		}
+		break;
+	}
+	return AEROSPIKE_OK;
+}
+
 as_status
 as_command_parse_success_failure(
 	as_error* err, as_command* cmd, as_node* node, uint8_t* buf, size_t size
@@ -1521,8 +3060,8 @@ as_command_parse_success_failure(
 		}
 
 		default:
-			as_error_update(err, status, "%s %s", as_node_get_address_string(node),
-							as_error_string(status));
+			as_error_update_status(err, status, as_node_get_address_string(node),
+								   cmd->cluster->lazy_error_messages);
 			if (val) {
 				*val = 0;
 			}
@@ -0,0 +1,338 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_completion_queue.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_cq_cell_s {
+	uint64_t seq;
+	as_completion completion;
+} as_cq_cell;
+
+typedef struct as_cq_overflow_s {
+	struct as_cq_overflow_s* next;
+	as_completion completion;
+} as_cq_overflow;
+
+struct as_completion_queue_s {
+	as_cq_cell* cells;
+	uint64_t mask;
+
+	// Producer and consumer positions are on separate cache lines.
+	uint8_t pad1[64];
+	uint64_t head;
+	uint8_t pad2[64];
+	uint64_t tail;
+	uint8_t pad3[64];
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	as_cq_overflow* overflow_head;
+	as_cq_overflow* overflow_tail;
+	uint32_t overflow_size;
+	uint32_t waiters;
+	uint32_t wait_min;
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool
+as_cq_ring_push(as_completion_queue* cq, const as_completion* completion)
+{
+	// Bounded multi-producer, multi-consumer ring. Each cell's sequence tells whether the
+	// cell is free for position pos (seq == pos) or holds the completion for pos (seq == pos + 1).
+	uint64_t pos = as_load_uint64(&cq->head);
+
+	while (true) {
+		as_cq_cell* cell = &cq->cells[pos & cq->mask];
+		uint64_t seq = as_load_uint64(&cell->seq);
+		int64_t dif = (int64_t)(seq - pos);
+
+		if (dif == 0) {
+			if (as_cas_uint64(&cq->head, pos, pos + 1)) {
+				cell->completion = *completion;
+				as_store_uint64(&cell->seq, pos + 1);
+				return true;
+			}
+			pos = as_load_uint64(&cq->head);
+		}
+		else if (dif < 0) {
+			// Ring is full.
+			return false;
+		}
+		else {
+			pos = as_load_uint64(&cq->head);
+		}
+	}
+}
+
+static bool
+as_cq_ring_pop(as_completion_queue* cq, as_completion* completion)
+{
+	uint64_t pos = as_load_uint64(&cq->tail);
+
+	while (true) {
+		as_cq_cell* cell = &cq->cells[pos & cq->mask];
+		uint64_t seq = as_load_uint64(&cell->seq);
+		int64_t dif = (int64_t)(seq - (pos + 1));
+
+		if (dif == 0) {
+			if (as_cas_uint64(&cq->tail, pos, pos + 1)) {
+				*completion = cell->completion;
+				as_store_uint64(&cell->seq, pos + cq->mask + 1);
+				return true;
+			}
+			pos = as_load_uint64(&cq->tail);
+		}
+		else if (dif < 0) {
+			// Ring is empty.
+			return false;
+		}
+		else {
+			pos = as_load_uint64(&cq->tail);
+		}
+	}
+}
+
+static uint32_t
+as_cq_collect(as_completion_queue* cq, as_completion* completions, uint32_t max)
+{
+	uint32_t n = 0;
+
+	while (n < max && as_cq_ring_pop(cq, &completions[n])) {
+		n++;
+	}
+
+	if (n < max && as_load_uint32(&cq->overflow_size) > 0) {
+		pthread_mutex_lock(&cq->lock);
+
+		while (n < max && cq->overflow_head) {
+			as_cq_overflow* item = cq->overflow_head;
+			cq->overflow_head = item->next;
+			completions[n++] = item->completion;
+			as_store_uint32(&cq->overflow_size, cq->overflow_size - 1);
+			cf_free(item);
+		}
+
+		if (! cq->overflow_head) {
+			cq->overflow_tail = NULL;
+		}
+		pthread_mutex_unlock(&cq->lock);
+	}
+	return n;
+}
+
+static inline void
+as_cq_post(as_completion_queue* cq, void* udata, void* result, as_error* err)
+{
+	as_completion completion = {
+		.udata = udata,
+		.result = result,
+		.status = err ? err->code : AEROSPIKE_OK,
+		.in_doubt = err ? err->in_doubt : false
+	};
+	as_completion_queue_push(cq, &completion);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_completion_queue*
+as_completion_queue_create(uint32_t capacity)
+{
+	uint64_t size = 2;
+
+	while (size < capacity) {
+		size <<= 1;
+	}
+
+	// Align queue so producer and consumer positions really are on separate cache lines.
+	as_completion_queue* cq = as_alloc_aligned(64, sizeof(as_completion_queue));
+	cq->cells = cf_malloc(sizeof(as_cq_cell) * size);
+	cq->mask = size - 1;
+
+	for (uint64_t i = 0; i < size; i++) {
+		cq->cells[i].seq = i;
+	}
+
+	cq->head = 0;
+	cq->tail = 0;
+	pthread_mutex_init(&cq->lock, NULL);
+	pthread_cond_init(&cq->cond, NULL);
+	cq->overflow_head = NULL;
+	cq->overflow_tail = NULL;
+	cq->overflow_size = 0;
+	cq->waiters = 0;
+	cq->wait_min = 1;
+	return cq;
+}
+
+void
+as_completion_queue_destroy(as_completion_queue* cq)
+{
+	as_cq_overflow* item = cq->overflow_head;
+
+	while (item) {
+		as_cq_overflow* next = item->next;
+		cf_free(item);
+		item = next;
+	}
+
+	pthread_cond_destroy(&cq->cond);
+	pthread_mutex_destroy(&cq->lock);
+	cf_free(cq->cells);
+	as_alloc_aligned_free(cq);
+}
+
+void
+as_completion_queue_push(as_completion_queue* cq, const as_completion* completion)
+{
+	if (! as_cq_ring_push(cq, completion)) {
+		// Event loops must not block, so keep completions that do not fit in the ring.
+		as_cq_overflow* item = cf_malloc(sizeof(as_cq_overflow));
+		item->next = NULL;
+		item->completion = *completion;
+
+		pthread_mutex_lock(&cq->lock);
+
+		if (cq->overflow_tail) {
+			cq->overflow_tail->next = item;
+		}
+		else {
+			cq->overflow_head = item;
+		}
+		cq->overflow_tail = item;
+		as_store_uint32(&cq->overflow_size, cq->overflow_size + 1);
+		pthread_mutex_unlock(&cq->lock);
+	}
+
+	// Pairs with the fence in as_completion_queue_wait(), so either this thread sees the
+	// waiter or the waiter sees the completion.
+	as_fence_seq();
+
+	if (as_load_uint32(&cq->waiters) > 0 &&
+		as_completion_queue_size(cq) >= as_load_uint32(&cq->wait_min)) {
+		pthread_mutex_lock(&cq->lock);
+		pthread_cond_broadcast(&cq->cond);
+		pthread_mutex_unlock(&cq->lock);
+	}
+}
+
+uint32_t
+as_completion_queue_poll(as_completion_queue* cq, as_completion* completions, uint32_t max)
+{
+	return as_cq_collect(cq, completions, max);
+}
+
+uint32_t
+as_completion_queue_wait(
+	as_completion_queue* cq, as_completion* completions, uint32_t max, uint32_t min,
+	uint32_t timeout_ms
+	)
+{
+	if (min == 0) {
+		min = 1;
+	}
+
+	if (min > max) {
+		min = max;
+	}
+
+	if (as_completion_queue_size(cq) < min) {
+		struct timespec abstime;
+
+		if (timeout_ms > 0) {
+			struct timespec delta;
+			cf_clock_set_timespec_ms(timeout_ms, &delta);
+			cf_clock_current_add(&delta, &abstime);
+		}
+
+		pthread_mutex_lock(&cq->lock);
+
+		// The smallest request of all waiting threads decides when producers wake them.
+		if (cq->waiters == 0 || min < cq->wait_min) {
+			as_store_uint32(&cq->wait_min, min);
+		}
+		as_store_uint32(&cq->waiters, cq->waiters + 1);
+		as_fence_seq();
+
+		while (as_completion_queue_size(cq) < min) {
+			if (timeout_ms > 0) {
+				if (pthread_cond_timedwait(&cq->cond, &cq->lock, &abstime) != 0) {
+					break;
+				}
+			}
+			else {
+				pthread_cond_wait(&cq->cond, &cq->lock);
+			}
+		}
+
+		as_store_uint32(&cq->waiters, cq->waiters - 1);
+
+		if (cq->waiters == 0) {
+			as_store_uint32(&cq->wait_min, 1);
+		}
+		pthread_mutex_unlock(&cq->lock);
+	}
+	return as_cq_collect(cq, completions, max);
+}
+
+uint32_t
+as_completion_queue_size(as_completion_queue* cq)
+{
+	uint64_t tail = as_load_uint64(&cq->tail);
+	uint64_t head = as_load_uint64(&cq->head);
+	uint64_t size = (head > tail) ? head - tail : 0;
+	return (uint32_t)size + as_load_uint32(&cq->overflow_size);
+}
+
+void
+as_completion_queue_write_listener(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	as_completion_tag* tag = udata;
+	as_cq_post(tag->queue, tag->udata, NULL, err);
+}
+
+void
+as_completion_queue_record_listener(
+	as_error* err, as_record* record, void* udata, as_event_loop* event_loop
+	)
+{
+	// Record is on the heap when async_heap_rec is true, so the receiver owns it.
+	as_completion_tag* tag = udata;
+	as_cq_post(tag->queue, tag->udata, record, err);
+}
+
+void
+as_completion_queue_value_listener(
+	as_error* err, as_val* val, void* udata, as_event_loop* event_loop
+	)
+{
+	// Value is destroyed after the listener returns, so keep a reference for the receiver.
+	as_completion_tag* tag = udata;
+	as_cq_post(tag->queue, tag->udata, val ? as_val_reserve(val) : NULL, err);
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_compress.h>
+#include <aerospike/as_atomic.h>
+#include <pthread.h>
+#include <string.h>
+#include <zlib.h>
+
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_compress_ctx_s {
+	z_stream deflate;
+	z_stream inflate;
+	// Written only by the owning thread and summed by as_compress_get_stats().
+	as_compress_stats stats;
+	struct as_compress_ctx_s* prev;
+	struct as_compress_ctx_s* next;
+	bool deflate_ready;
+	bool inflate_ready;
+	bool registered;
+} as_compress_ctx;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+// Registered thread contexts and counters of threads that exited.  Protected by lock.
+static as_compress_ctx* as_compress_threads;
+static as_compress_stats as_compress_retired;
+static pthread_mutex_t as_compress_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t as_compress_key;
+static pthread_once_t as_compress_once = PTHREAD_ONCE_INIT;
+static AS_THREAD_LOCAL as_compress_ctx as_compress_local;
+
+/******************************************************************************
+ * CONTEXT
+ *****************************************************************************/
+
+static void
+as_compress_ctx_destroy(as_compress_ctx* ctx)
+{
+	if (ctx->deflate_ready) {
+		deflateEnd(&ctx->deflate);
+		ctx->deflate_ready = false;
+	}
+
+	if (ctx->inflate_ready) {
+		inflateEnd(&ctx->inflate);
+		ctx->inflate_ready = false;
+	}
+}
+
+static inline void
+as_compress_stats_add(as_compress_stats* trg, as_compress_stats* src)
+{
+	trg->deflate_created += as_load_uint64(&src->deflate_created);
+	trg->deflate_reused += as_load_uint64(&src->deflate_reused);
+	trg->inflate_created += as_load_uint64(&src->inflate_created);
+	trg->inflate_reused += as_load_uint64(&src->inflate_reused);
+}
+
+static inline void
+as_compress_count(uint64_t* counter)
+{
+	// Only the owning thread writes its counters, so no atomic read-modify-write is needed.
+	as_store_uint64(counter, *counter + 1);
+}
+
+static void
+as_compress_thread_exit(void* udata)
+{
+	as_compress_ctx* ctx = udata;
+	as_compress_ctx_destroy(ctx);
+
+	pthread_mutex_lock(&as_compress_lock);
+	as_compress_stats_add(&as_compress_retired, &ctx->stats);
+
+	if (ctx->prev) {
+		ctx->prev->next = ctx->next;
+	}
+	else {
+		as_compress_threads = ctx->next;
+	}
+
+	if (ctx->next) {
+		ctx->next->prev = ctx->prev;
+	}
+	pthread_mutex_unlock(&as_compress_lock);
+
+	ctx->registered = false;
+}
+
+static void
+as_compress_create_key(void)
+{
+	pthread_key_create(&as_compress_key, as_compress_thread_exit);
+}
+
+static inline void
+as_compress_register(as_compress_ctx* ctx)
+{
+	if (! ctx->registered) {
+		// Register destructor so contexts are freed on thread exit.
+		pthread_once(&as_compress_once, as_compress_create_key);
+		pthread_setspecific(as_compress_key, ctx);
+
+		pthread_mutex_lock(&as_compress_lock);
+		ctx->prev = NULL;
+		ctx->next = as_compress_threads;
+
+		if (as_compress_threads) {
+			as_compress_threads->prev = ctx;
+		}
+		as_compress_threads = ctx;
+		pthread_mutex_unlock(&as_compress_lock);
+
+		ctx->registered = true;
+	}
+}
+
+/******************************************************************************
+ * ZLIB
+ *****************************************************************************/
+
+static size_t
+as_zlib_bound(size_t src_sz)
+{
+	return compressBound((uLong)src_sz);
+}
+
+static int
+as_zlib_deflate(
+	uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz, const uint8_t* dict,
+	size_t dict_sz
+	)
+{
+	as_compress_ctx* ctx = &as_compress_local;
+	z_stream* zs = &ctx->deflate;
+	int rv;
+
+	if (ctx->deflate_ready) {
+		rv = deflateReset(zs);
+		as_compress_count(&ctx->stats.deflate_reused);
+	}
+	else {
+		memset(zs, 0, sizeof(z_stream));
+		rv = deflateInit(zs, Z_BEST_SPEED);
+
+		if (rv == Z_OK) {
+			ctx->deflate_ready = true;
+			as_compress_register(ctx);
+			as_compress_count(&ctx->stats.deflate_created);
+		}
+	}
+
+	if (rv != Z_OK) {
+		return rv;
+	}
+
+	if (dict) {
+		// Reset clears the previous dictionary, so it must be set on every call.
+		rv = deflateSetDictionary(zs, dict, (uInt)dict_sz);
+
+		if (rv != Z_OK) {
+			return rv;
+		}
+	}
+
+	zs->next_in = (Bytef*)src;
+	zs->avail_in = (uInt)src_sz;
+	zs->next_out = trg;
+	zs->avail_out = (uInt)*trg_sz;
+
+	// Single pass is sufficient because trg capacity is at least compressBound(src_sz).
+	rv = deflate(zs, Z_FINISH);
+	*trg_sz = (size_t)zs->total_out;
+	return (rv == Z_STREAM_END)? Z_OK : (rv == Z_OK)? Z_BUF_ERROR : rv;
+}
+
+static int
+as_zlib_inflate(
+	uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz, const uint8_t* dict,
+	size_t dict_sz
+	)
+{
+	as_compress_ctx* ctx = &as_compress_local;
+	z_stream* zs = &ctx->inflate;
+	int rv;
+
+	if (ctx->inflate_ready) {
+		rv = inflateReset(zs);
+		as_compress_count(&ctx->stats.inflate_reused);
+	}
+	else {
+		memset(zs, 0, sizeof(z_stream));
+		rv = inflateInit(zs);
+
+		if (rv == Z_OK) {
+			ctx->inflate_ready = true;
+			as_compress_register(ctx);
+			as_compress_count(&ctx->stats.inflate_created);
+		}
+	}
+
+	if (rv != Z_OK) {
+		return rv;
+	}
+
+	zs->next_in = (Bytef*)src;
+	zs->avail_in = (uInt)src_sz;
+	zs->next_out = trg;
+	zs->avail_out = (uInt)*trg_sz;
+
+	rv = inflate(zs, Z_FINISH);
+
+	if (rv == Z_NEED_DICT && dict) {
+		// Stream header carries the dictionary checksum, so a wrong dictionary is rejected.
+		rv = inflateSetDictionary(zs, dict, (uInt)dict_sz);
+
+		if (rv == Z_OK) {
+			rv = inflate(zs, Z_FINISH);
+		}
+	}
+	*trg_sz = (size_t)zs->total_out;
+
+	if (rv == Z_STREAM_END) {
+		return Z_OK;
+	}
+
+	// Match uncompress() error codes for truncated or corrupt input.
+	if (rv == Z_NEED_DICT || (rv == Z_BUF_ERROR && zs->avail_in == 0)) {
+		return Z_DATA_ERROR;
+	}
+	return (rv == Z_OK)? Z_BUF_ERROR : rv;
+}
+
+static int
+as_zlib_compress(uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz)
+{
+	return as_zlib_deflate(trg, trg_sz, src, src_sz, NULL, 0);
+}
+
+static int
+as_zlib_decompress(uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz)
+{
+	return as_zlib_inflate(trg, trg_sz, src, src_sz, NULL, 0);
+}
+
+/******************************************************************************
+ * CODECS
+ *****************************************************************************/
+
+// Indexed by as_compress_codec.
+static const as_compress_ops as_compress_codecs[] = {
+	{"zlib", as_zlib_bound, as_zlib_compress, as_zlib_decompress}
+};
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_compress_get_stats(as_compress_stats* stats)
+{
+	// Counters are kept per thread, so commands do not contend on shared cache lines.
+	memset(stats, 0, sizeof(as_compress_stats));
+
+	pthread_mutex_lock(&as_compress_lock);
+	as_compress_stats_add(stats, &as_compress_retired);
+
+	for (as_compress_ctx* ctx = as_compress_threads; ctx; ctx = ctx->next) {
+		as_compress_stats_add(stats, &ctx->stats);
+	}
+	pthread_mutex_unlock(&as_compress_lock);
+}
+
+void
+as_compress_release_thread(void)
+{
+	as_compress_ctx_destroy(&as_compress_local);
+}
+
+const as_compress_ops*
+as_compress_get_ops(as_compress_codec codec)
+{
+	return &as_compress_codecs[codec];
+}
+
+as_status
+as_compress(
+	as_error* err, as_compress_codec codec, uint8_t* trg, size_t* trg_sz, const uint8_t* src,
+	size_t src_sz
+	)
+{
+	const as_compress_ops* ops = &as_compress_codecs[codec];
+	int rv = ops->compress(trg, trg_sz, src, src_sz);
+
+	if (rv) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Compress failed: %d", rv);
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_decompress(
+	as_error* err, as_compress_codec codec, uint8_t* trg, size_t* trg_sz, const uint8_t* src,
+	size_t src_sz
+	)
+{
+	const as_compress_ops* ops = &as_compress_codecs[codec];
+	int rv = ops->decompress(trg, trg_sz, src, src_sz);
+
+	if (rv) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Decompress failed: %d", rv);
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_compress_with_dict(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz,
+	const uint8_t* dict, size_t dict_sz
+	)
+{
+	int rv = as_zlib_deflate(trg, trg_sz, src, src_sz, dict, dict_sz);
+
+	if (rv) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Compress failed: %d", rv);
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_decompress_with_dict(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz,
+	const uint8_t* dict, size_t dict_sz
+	)
+{
+	int rv = as_zlib_inflate(trg, trg_sz, src, src_sz, dict, dict_sz);
+
+	if (rv) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Decompress failed: %d", rv);
+	}
+	return AEROSPIKE_OK;
+}
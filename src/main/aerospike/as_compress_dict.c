@@ -0,0 +1,496 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_compress_dict.h>
+#include <aerospike/aerospike_scan.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_compress.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+// Length of segments counted by the trainer and distance between counted segments.
+#define AS_DICT_SEGMENT 16
+#define AS_DICT_STEP 4
+
+// Bound trainer memory on very large sample sets.
+#define AS_DICT_MAX_SEGMENTS (1024 * 1024)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_dict_s {
+	uint32_t id;
+	uint32_t ref_count;
+	uint32_t size;
+	uint8_t data[];
+} as_dict;
+
+typedef struct as_dict_segment_s {
+	uint64_t hash; // Zero means empty slot.
+	const uint8_t* data;
+	uint32_t count;
+} as_dict_segment;
+
+typedef struct as_dict_sampler_s {
+	pthread_mutex_t lock;
+	const char* bin;
+	uint8_t** samples;
+	size_t* sizes;
+	uint32_t n_samples;
+	uint32_t max_samples;
+} as_dict_sampler;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static as_dict* as_dicts[AS_COMPRESS_DICT_MAX];
+static pthread_mutex_t as_dicts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline void
+as_dict_release(as_dict* dict)
+{
+	if (as_aaf_uint32(&dict->ref_count, -1) == 0) {
+		cf_free(dict);
+	}
+}
+
+static as_dict*
+as_dict_reserve(uint32_t id)
+{
+	as_dict* dict = NULL;
+
+	pthread_mutex_lock(&as_dicts_lock);
+
+	for (uint32_t i = 0; i < AS_COMPRESS_DICT_MAX; i++) {
+		if (as_dicts[i] && as_dicts[i]->id == id) {
+			dict = as_dicts[i];
+			as_incr_uint32(&dict->ref_count);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&as_dicts_lock);
+	return dict;
+}
+
+static inline uint64_t
+as_dict_hash(const uint8_t* p)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for (uint32_t i = 0; i < AS_DICT_SEGMENT; i++) {
+		h = (h ^ p[i]) * 0x100000001b3ULL;
+	}
+	return h | 1;
+}
+
+static int
+as_dict_segment_compare(const void* v1, const void* v2)
+{
+	const as_dict_segment* s1 = v1;
+	const as_dict_segment* s2 = v2;
+
+	// Descending count.
+	if (s1->count != s2->count) {
+		return (s1->count < s2->count) ? 1 : -1;
+	}
+	return 0;
+}
+
+static bool
+as_dict_sample_callback(const as_val* val, void* udata)
+{
+	if (! val) {
+		return true;
+	}
+
+	as_dict_sampler* sampler = udata;
+	as_record* rec = as_record_fromval(val);
+
+	if (! rec) {
+		return true;
+	}
+
+	as_bin_value* v = as_record_get(rec, sampler->bin);
+	const uint8_t* data;
+	size_t size;
+
+	switch (as_val_type((as_val*)v)) {
+		case AS_STRING: {
+			as_string* s = (as_string*)v;
+			data = (const uint8_t*)as_string_get(s);
+			size = as_string_len(s);
+			break;
+		}
+		case AS_BYTES: {
+			as_bytes* b = (as_bytes*)v;
+			data = as_bytes_get(b);
+			size = as_bytes_size(b);
+			break;
+		}
+		default:
+			return true;
+	}
+
+	pthread_mutex_lock(&sampler->lock);
+
+	if (sampler->n_samples < sampler->max_samples) {
+		uint8_t* copy = cf_malloc(size);
+		memcpy(copy, data, size);
+		sampler->samples[sampler->n_samples] = copy;
+		sampler->sizes[sampler->n_samples] = size;
+		sampler->n_samples++;
+	}
+
+	bool more = sampler->n_samples < sampler->max_samples;
+	pthread_mutex_unlock(&sampler->lock);
+	return more;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_compress_dict_register(as_error* err, uint32_t id, const uint8_t* dict, uint32_t size)
+{
+	as_error_reset(err);
+
+	if (id == 0 || size == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Dictionary ID and size must be greater than zero");
+	}
+
+	if (size > AS_COMPRESS_DICT_MAX_SIZE) {
+		// Deflate only uses the end of the dictionary.
+		dict += size - AS_COMPRESS_DICT_MAX_SIZE;
+		size = AS_COMPRESS_DICT_MAX_SIZE;
+	}
+
+	as_dict* d = cf_malloc(sizeof(as_dict) + size);
+	d->id = id;
+	d->ref_count = 1;
+	d->size = size;
+	memcpy(d->data, dict, size);
+
+	as_dict* old = NULL;
+	int32_t slot = -1;
+
+	pthread_mutex_lock(&as_dicts_lock);
+
+	for (uint32_t i = 0; i < AS_COMPRESS_DICT_MAX; i++) {
+		if (as_dicts[i] && as_dicts[i]->id == id) {
+			old = as_dicts[i];
+			slot = (int32_t)i;
+			break;
+		}
+
+		if (! as_dicts[i] && slot < 0) {
+			slot = (int32_t)i;
+		}
+	}
+
+	if (slot >= 0) {
+		as_dicts[slot] = d;
+	}
+
+	pthread_mutex_unlock(&as_dicts_lock);
+
+	if (slot < 0) {
+		cf_free(d);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+			"Dictionary limit %u reached", AS_COMPRESS_DICT_MAX);
+	}
+
+	if (old) {
+		as_dict_release(old);
+	}
+	return AEROSPIKE_OK;
+}
+
+void
+as_compress_dict_unregister(uint32_t id)
+{
+	as_dict* old = NULL;
+
+	pthread_mutex_lock(&as_dicts_lock);
+
+	for (uint32_t i = 0; i < AS_COMPRESS_DICT_MAX; i++) {
+		if (as_dicts[i] && as_dicts[i]->id == id) {
+			old = as_dicts[i];
+			as_dicts[i] = NULL;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&as_dicts_lock);
+
+	if (old) {
+		as_dict_release(old);
+	}
+}
+
+size_t
+as_compress_dict_bound(size_t src_sz)
+{
+	return AS_COMPRESS_DICT_HEADER_SIZE + as_compress_bound(AS_COMPRESS_ZLIB, src_sz);
+}
+
+as_status
+as_compress_dict_compress(
+	as_error* err, uint32_t id, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz
+	)
+{
+	if (src_sz > UINT32_MAX) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Value size %zu too large", src_sz);
+	}
+
+	if (*trg_sz < as_compress_dict_bound(src_sz)) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Buffer capacity %zu less than compress bound", *trg_sz);
+	}
+
+	as_dict* dict = as_dict_reserve(id);
+
+	if (! dict) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Dictionary %u not registered", id);
+	}
+
+	uint32_t v = cf_swap_to_be32(id);
+	memcpy(trg, &v, sizeof(v));
+	v = cf_swap_to_be32((uint32_t)src_sz);
+	memcpy(trg + 4, &v, sizeof(v));
+
+	size_t size = *trg_sz - AS_COMPRESS_DICT_HEADER_SIZE;
+	as_status status = as_compress_with_dict(err, trg + AS_COMPRESS_DICT_HEADER_SIZE, &size,
+		src, src_sz, dict->data, dict->size);
+
+	as_dict_release(dict);
+	*trg_sz = AS_COMPRESS_DICT_HEADER_SIZE + size;
+	return status;
+}
+
+as_status
+as_compress_dict_info(
+	as_error* err, const uint8_t* src, size_t src_sz, uint32_t* id, size_t* size
+	)
+{
+	if (src_sz < AS_COMPRESS_DICT_HEADER_SIZE) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+			"Invalid dictionary compressed size: %zu", src_sz);
+	}
+
+	uint32_t v;
+	memcpy(&v, src, sizeof(v));
+	*id = cf_swap_from_be32(v);
+	memcpy(&v, src + 4, sizeof(v));
+	*size = cf_swap_from_be32(v);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_compress_dict_decompress(
+	as_error* err, uint8_t* trg, size_t* trg_sz, const uint8_t* src, size_t src_sz
+	)
+{
+	uint32_t id;
+	size_t size;
+	as_status status = as_compress_dict_info(err, src, src_sz, &id, &size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (size > *trg_sz) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Buffer capacity %zu less than decompressed size %zu", *trg_sz, size);
+	}
+
+	as_dict* dict = as_dict_reserve(id);
+
+	if (! dict) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Dictionary %u not registered", id);
+	}
+
+	status = as_decompress_with_dict(err, trg, trg_sz, src + AS_COMPRESS_DICT_HEADER_SIZE,
+		src_sz - AS_COMPRESS_DICT_HEADER_SIZE, dict->data, dict->size);
+
+	as_dict_release(dict);
+	return status;
+}
+
+uint32_t
+as_compress_dict_train(
+	const uint8_t** samples, const size_t* sizes, uint32_t n_samples, uint8_t* dict,
+	uint32_t capacity
+	)
+{
+	if (capacity > AS_COMPRESS_DICT_MAX_SIZE) {
+		capacity = AS_COMPRESS_DICT_MAX_SIZE;
+	}
+
+	uint64_t n_segments = 0;
+
+	for (uint32_t i = 0; i < n_samples; i++) {
+		if (sizes[i] >= AS_DICT_SEGMENT) {
+			n_segments += (sizes[i] - AS_DICT_SEGMENT) / AS_DICT_STEP + 1;
+		}
+	}
+
+	if (n_segments > AS_DICT_MAX_SEGMENTS) {
+		n_segments = AS_DICT_MAX_SEGMENTS;
+	}
+
+	// Open addressing table at most half full.
+	uint32_t table_size = 16;
+
+	while (table_size < n_segments * 2) {
+		table_size <<= 1;
+	}
+
+	as_dict_segment* table = cf_calloc(table_size, sizeof(as_dict_segment));
+	uint32_t n_entries = 0;
+
+	for (uint32_t i = 0; i < n_samples; i++) {
+		const uint8_t* p = samples[i];
+
+		for (size_t off = 0; off + AS_DICT_SEGMENT <= sizes[i]; off += AS_DICT_STEP) {
+			uint64_t h = as_dict_hash(p + off);
+			uint32_t slot = (uint32_t)h & (table_size - 1);
+
+			while (true) {
+				as_dict_segment* s = &table[slot];
+
+				if (s->hash == 0) {
+					if (n_entries < n_segments) {
+						s->hash = h;
+						s->data = p + off;
+						s->count = 1;
+						n_entries++;
+					}
+					break;
+				}
+
+				if (s->hash == h && memcmp(s->data, p + off, AS_DICT_SEGMENT) == 0) {
+					s->count++;
+					break;
+				}
+				slot = (slot + 1) & (table_size - 1);
+			}
+		}
+	}
+
+	// Keep segments that repeat.
+	uint32_t n_repeat = 0;
+
+	for (uint32_t i = 0; i < table_size; i++) {
+		if (table[i].count > 1) {
+			table[n_repeat++] = table[i];
+		}
+	}
+
+	qsort(table, n_repeat, sizeof(as_dict_segment), as_dict_segment_compare);
+
+	// Most frequent segments go last, closest to the data being compressed.
+	uint32_t pos = capacity;
+
+	for (uint32_t i = 0; i < n_repeat && pos >= AS_DICT_SEGMENT; i++) {
+		pos -= AS_DICT_SEGMENT;
+		memcpy(dict + pos, table[i].data, AS_DICT_SEGMENT);
+	}
+	cf_free(table);
+
+	// Fill remaining space with sample data.
+	uint32_t front = 0;
+
+	for (uint32_t i = 0; i < n_samples && front < pos; i++) {
+		size_t n = sizes[i];
+
+		if (n > pos - front) {
+			n = pos - front;
+		}
+		memcpy(dict + front, samples[i], n);
+		front += (uint32_t)n;
+	}
+
+	if (front < pos) {
+		memmove(dict + front, dict + pos, capacity - pos);
+	}
+	return front + (capacity - pos);
+}
+
+as_status
+as_compress_dict_train_scan(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	const char* bin, uint32_t max_samples, uint8_t* dict, uint32_t capacity,
+	uint32_t* dict_size
+	)
+{
+	as_policy_scan p;
+	as_policy_scan_copy(policy ? policy : &as->config.policies.scan, &p);
+
+	if (p.max_records == 0 || p.max_records > max_samples) {
+		p.max_records = max_samples;
+	}
+
+	as_dict_sampler sampler;
+	pthread_mutex_init(&sampler.lock, NULL);
+	sampler.bin = bin;
+	sampler.samples = cf_malloc(sizeof(uint8_t*) * max_samples);
+	sampler.sizes = cf_malloc(sizeof(size_t) * max_samples);
+	sampler.n_samples = 0;
+	sampler.max_samples = max_samples;
+
+	as_status status = aerospike_scan_foreach(as, err, &p, scan, as_dict_sample_callback,
+		&sampler);
+
+	if (status == AEROSPIKE_ERR_CLIENT_ABORT) {
+		// Callback stopped the scan after enough samples.
+		as_error_reset(err);
+		status = AEROSPIKE_OK;
+	}
+
+	*dict_size = 0;
+
+	if (status == AEROSPIKE_OK) {
+		*dict_size = as_compress_dict_train((const uint8_t**)sampler.samples, sampler.sizes,
+			sampler.n_samples, dict, capacity);
+	}
+
+	for (uint32_t i = 0; i < sampler.n_samples; i++) {
+		cf_free(sampler.samples[i]);
+	}
+	cf_free(sampler.samples);
+	cf_free(sampler.sizes);
+	pthread_mutex_destroy(&sampler.lock);
+	return status;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_compress_ratio.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+// Ratios are kept in 1/1024 units so zero can mean unknown.
+#define AS_COMPRESS_RATIO_ONE 1024
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_compress_slot_s {
+	uint32_t ratio;
+	uint32_t skipped;
+} as_compress_slot;
+
+struct as_compress_ratio_s {
+	as_compress_slot slots[AS_COMPRESS_RATIO_SLOTS];
+	uint32_t max_ratio;
+	uint32_t sample_interval;
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline as_compress_slot*
+as_compress_slot_get(as_compress_ratio* stats, const char* ns, const char* set)
+{
+	uint32_t h = 0x811c9dc5;
+
+	for (const char* p = ns; *p; p++) {
+		h = (h ^ (uint8_t)*p) * 0x01000193;
+	}
+
+	// Separate namespace from set, so "ab" + "" and "a" + "b" differ.
+	h = (h ^ 0xff) * 0x01000193;
+
+	if (set) {
+		for (const char* p = set; *p; p++) {
+			h = (h ^ (uint8_t)*p) * 0x01000193;
+		}
+	}
+	return &stats->slots[h & (AS_COMPRESS_RATIO_SLOTS - 1)];
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_compress_ratio*
+as_compress_ratio_create(uint32_t max_ratio, uint32_t sample_interval)
+{
+	as_compress_ratio* stats = cf_calloc(1, sizeof(as_compress_ratio));
+	stats->max_ratio = max_ratio * AS_COMPRESS_RATIO_ONE / 100;
+	stats->sample_interval = (sample_interval > 0) ? sample_interval : 1;
+	return stats;
+}
+
+void
+as_compress_ratio_destroy(as_compress_ratio* stats)
+{
+	cf_free(stats);
+}
+
+bool
+as_compress_ratio_use(as_compress_ratio* stats, const char* ns, const char* set)
+{
+	as_compress_slot* slot = as_compress_slot_get(stats, ns, set);
+	uint32_t ratio = as_load_uint32(&slot->ratio);
+
+	if (ratio == 0 || ratio <= stats->max_ratio) {
+		return true;
+	}
+
+	// Compress one of every sample_interval commands, so the ratio can recover.
+	return (as_faa_uint32(&slot->skipped, 1) + 1) % stats->sample_interval == 0;
+}
+
+void
+as_compress_ratio_add(
+	as_compress_ratio* stats, const char* ns, const char* set, size_t size, size_t comp_size
+	)
+{
+	if (size == 0) {
+		return;
+	}
+
+	as_compress_slot* slot = as_compress_slot_get(stats, ns, set);
+	uint64_t r = (uint64_t)comp_size * AS_COMPRESS_RATIO_ONE / size;
+	uint32_t sample = (r == 0) ? 1 : (r > UINT32_MAX / 4) ? UINT32_MAX / 4 : (uint32_t)r;
+	uint32_t ratio = as_load_uint32(&slot->ratio);
+
+	// Moving average weighted 3:1 towards history.
+	ratio = (ratio == 0) ? sample : (ratio * 3 + sample) / 4;
+	as_store_uint32(&slot->ratio, ratio);
+}
+
+uint32_t
+as_compress_ratio_get(as_compress_ratio* stats, const char* ns, const char* set)
+{
+	uint32_t ratio = as_load_uint32(&as_compress_slot_get(stats, ns, set)->ratio);
+	return (ratio == 0) ? 0 : (uint32_t)(((uint64_t)ratio * 100 + 512) / AS_COMPRESS_RATIO_ONE);
+}
@@ -33,6 +33,7 @@ as_config_init(as_config* c)
 	memset(c->user, 0, sizeof(c->user));
 	memset(c->password, 0, sizeof(c->password));
 	c->cluster_name = NULL;
+	c->topology_file = NULL;
 	c->event_callback = NULL;
 	c->event_callback_udata = NULL;
 	c->ip_map = NULL;
@@ -41,22 +42,71 @@ as_config_init(as_config* c)
 	c->max_conns_per_node = 300;
 	c->async_min_conns_per_node = 0;
 	c->async_max_conns_per_node = 300;
+	c->async_conn_prewarm = 0;
+	c->async_max_bytes_per_node = 0;
+	c->async_tls_threads = 0;
 	c->pipe_max_conns_per_node = 64;
+	c->pipe_max_depth = 0;
 	c->conn_pools_per_node = 1;
+	c->lock_free_conn_pools = false;
+	c->conn_pool_affinity = AS_CONN_POOL_AFFINITY_NONE;
+	c->socket_busy_poll = 0;
+	c->socket_read_buffer = 0;
+	memset(&c->point_socket_profile, 0, sizeof(as_socket_profile));
+	memset(&c->bulk_socket_profile, 0, sizeof(as_socket_profile));
+	c->bulk_max_conns_per_node = 0;
 	c->conn_timeout_ms = 1000;
 	c->login_timeout_ms = 5000;
+	c->session_refresh_ms = 120000;
+	c->dns_cache_ttl = 0;
+	c->record_cache_max = 0;
+	c->record_cache_ttl_ms = 1000;
+	c->negative_cache_max = 0;
+	c->negative_cache_ttl_ms = 1000;
+	c->negative_cache_fpr = 0.001;
+	c->compress_skip_ratio = 0;
+	c->compress_sample_interval = 100;
 	c->max_socket_idle = 55;
 	c->max_error_rate = 0;
+	c->max_conn_open_rate = 0;
 	c->error_rate_window = 1;
+	c->error_rate_backoff_max = 32;
+	c->error_rate_probe_interval = 10;
+	c->error_rate_read_replica = false;
+	c->retry_budget_percent = 0;
+	c->retry_budget_max = 100;
+	c->adaptive_timeout_factor = 0;
+	c->adaptive_timeout_min = 10;
+	c->latency_stats = false;
+	c->metrics_callback = NULL;
+	c->metrics_udata = NULL;
+	c->metrics_interval = 10;
+	c->trace.begin = NULL;
+	c->trace.end = NULL;
+	c->trace.udata = NULL;
+	c->trace.sample_rate = 0;
+	c->hot_key_sample_rate = 0;
+	c->hot_key_capacity = 128;
 	c->tender_interval = 1000;
+	c->tender_interval_max = 0;
 	c->thread_pool_size = 16;
+	c->thread_pool_adaptive = false;
+	c->thread_pool_work_stealing = false;
+	c->thread_pool_spin_us = 0;
+	c->thread_pool_cpu = -1;
 	c->tend_thread_cpu = -1;
+	c->tend_thread_pool_size = 8;
+	c->shared_tend_thread = false;
+	c->shared_thread_pool = NULL;
 	as_policies_init(&c->policies);
 	as_config_lua_init(&c->lua);
 	memset(&c->tls, 0, sizeof(as_config_tls));
 	c->auth_mode = AS_AUTH_INTERNAL;
 	c->fail_if_not_connected = true;
+	c->connect_async = false;
 	c->use_services_alternate = false;
+	c->epoch_reclaim = false;
+	c->lazy_error_messages = false;
 	c->rack_aware = false;
 	c->rack_id = 0;
 	c->rack_ids = NULL;
@@ -65,6 +115,8 @@ as_config_init(as_config* c)
 	c->shm_max_nodes = 16;
 	c->shm_max_namespaces = 8;
 	c->shm_takeover_threshold_sec = 30;
+	c->shm_huge_pages = false;
+	c->shm_max_conns_per_node = 0;
 	return c;
 }
 
@@ -92,6 +144,10 @@ as_config_destroy(as_config* config) {
 		cf_free(config->cluster_name);
 	}
 
+	if (config->topology_file) {
+		cf_free(config->topology_file);
+	}
+
 	as_policies_destroy(&config->policies);
 
 	as_config_tls* tls = &config->tls;
@@ -0,0 +1,399 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_conn_pool.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_CONN_STACK_NIL 0xFFFFFFFF
+
+#define as_conn_stack_index(_head) ((uint32_t)(_head))
+#define as_conn_stack_head(_tag, _index) (((uint64_t)(_tag) << 32) | (_index))
+#define as_conn_stack_tag(_head) ((uint32_t)((_head) >> 32))
+#define as_conn_stack_next(_old, _index) as_conn_stack_head(as_conn_stack_tag(_old) + 1, _index)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_conn_walk_entry_s {
+	uint32_t index;
+	uint64_t next;
+} as_conn_walk_entry;
+
+// Validated walk of the connection stack from head to tail.  The last ring_size entries are
+// kept in ring, where the entry at position pos (1 based) is ring[pos % ring_size].
+typedef struct as_conn_walk_s {
+	as_conn_walk_entry* ring;
+	uint32_t ring_size;
+	uint32_t len;
+	uint32_t current;
+	uint64_t head;
+	uint64_t first_next;
+} as_conn_walk;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+// Every change to a slot link increments the link tag, so a slot link compare and swap fails
+// if the slot was unlinked or relinked since its link was read.
+
+static void
+as_conn_stack_set_next(as_conn_stack* stack, uint32_t index, uint32_t next)
+{
+	uint64_t* link = &stack->slots[index].next;
+
+	while (true) {
+		uint64_t old = as_load_uint64(link);
+
+		if (as_cas_uint64(link, old, as_conn_stack_next(old, next))) {
+			return;
+		}
+	}
+}
+
+static uint32_t
+as_conn_stack_pop_index(as_conn_stack* stack, uint64_t* head)
+{
+	while (true) {
+		uint64_t old = as_load_uint64(head);
+		uint32_t index = as_conn_stack_index(old);
+
+		if (index == AS_CONN_STACK_NIL) {
+			return AS_CONN_STACK_NIL;
+		}
+
+		// Slots are never freed while the stack exists, so reading next is safe even if the
+		// slot was popped concurrently.  The tag causes the swap to fail in that case.
+		// Increment the slot link tag before unlinking the slot, so the tend thread can not
+		// unlink the slots after it while it is being popped.
+		uint64_t* link = &stack->slots[index].next;
+		uint64_t next = as_load_uint64(link);
+
+		if (! as_cas_uint64(link, next, as_conn_stack_next(next, as_conn_stack_index(next)))) {
+			continue;
+		}
+
+		if (as_cas_uint64(head, old, as_conn_stack_next(old, as_conn_stack_index(next)))) {
+			return index;
+		}
+	}
+}
+
+static void
+as_conn_stack_push_chain(as_conn_stack* stack, uint64_t* head, uint32_t first, uint32_t last)
+{
+	while (true) {
+		uint64_t old = as_load_uint64(head);
+
+		as_conn_stack_set_next(stack, last, as_conn_stack_index(old));
+
+		if (as_cas_uint64(head, old, as_conn_stack_next(old, first))) {
+			return;
+		}
+	}
+}
+
+static void
+as_conn_stack_walk(as_conn_stack* stack, as_conn_walk* walk, uint64_t max_socket_idle_ns)
+{
+	// Walk the stack while it stays linked.  A slot below the head can only be unlinked after
+	// its link tag changes, so each link read is validated by rereading the link that points
+	// to the slot (or the head for the first two slots).  Restart when validation fails.
+	while (true) {
+		walk->len = 0;
+		walk->current = 0;
+		walk->head = as_load_uint64(&stack->head);
+
+		uint32_t index = as_conn_stack_index(walk->head);
+		uint64_t* prev_link = &stack->head;
+		uint64_t prev_value = walk->head;
+		bool valid = true;
+
+		while (index != AS_CONN_STACK_NIL) {
+			uint64_t next = as_load_uint64(&stack->slots[index].next);
+			uint64_t last_used = stack->slots[index].sock.last_used;
+
+			if (walk->len == 0) {
+				walk->first_next = next;
+			}
+
+			// The first two slots are validated against the head, which changes whenever the
+			// first slot is popped.
+			uint64_t* check = walk->len <= 1 ? &stack->head : prev_link;
+			uint64_t expected = walk->len <= 1 ? walk->head : prev_value;
+
+			if (as_load_uint64(check) != expected) {
+				valid = false;
+				break;
+			}
+
+			walk->len++;
+
+			as_conn_walk_entry* entry = &walk->ring[walk->len % walk->ring_size];
+			entry->index = index;
+			entry->next = next;
+
+			if (max_socket_idle_ns && as_socket_current_trim(last_used, max_socket_idle_ns)) {
+				walk->current = walk->len;
+			}
+
+			prev_link = &stack->slots[index].next;
+			prev_value = next;
+			index = as_conn_stack_index(next);
+		}
+
+		if (valid) {
+			return;
+		}
+	}
+}
+
+static bool
+as_conn_stack_detach_walk(as_conn_stack* stack, as_conn_walk* walk)
+{
+	// Detach the whole stack only if it has not changed since it was walked.  This is used
+	// when the slot to unlink is the first slot, which poppers also unlink.
+	uint32_t first = as_conn_stack_index(walk->head);
+
+	while (true) {
+		uint64_t old = as_load_uint64(&stack->head);
+
+		if (as_conn_stack_index(old) != first ||
+			as_load_uint64(&stack->slots[first].next) != walk->first_next) {
+			return false;
+		}
+
+		if (as_cas_uint64(&stack->head, old, as_conn_stack_next(old, AS_CONN_STACK_NIL))) {
+			return true;
+		}
+	}
+}
+
+static bool
+as_conn_stack_split(as_conn_stack* stack, as_conn_walk* walk, uint32_t keep)
+{
+	// Unlink all slots after position keep.
+	if (keep <= 1) {
+		if (! as_conn_stack_detach_walk(stack, walk)) {
+			return false;
+		}
+
+		if (keep == 1) {
+			uint32_t first = as_conn_stack_index(walk->head);
+			as_conn_stack_push_chain(stack, &stack->head, first, first);
+		}
+		return true;
+	}
+
+	// The slot at position keep is below the head, so its link only changes when it is
+	// popped or relinked.
+	as_conn_walk_entry* entry = &walk->ring[keep % walk->ring_size];
+	uint64_t* link = &stack->slots[entry->index].next;
+
+	return as_cas_uint64(link, entry->next, as_conn_stack_next(entry->next, AS_CONN_STACK_NIL));
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_conn_stack*
+as_conn_stack_create(uint32_t capacity)
+{
+	as_conn_stack* stack = cf_malloc(sizeof(as_conn_stack));
+	stack->slots = capacity > 0 ? cf_malloc(sizeof(as_conn_slot) * capacity) : NULL;
+	stack->head = as_conn_stack_head(0, AS_CONN_STACK_NIL);
+	stack->free = as_conn_stack_head(0, capacity > 0 ? 0 : AS_CONN_STACK_NIL);
+	stack->size = 0;
+	stack->total = 0;
+	stack->capacity = capacity;
+
+	for (uint32_t i = 0; i < capacity; i++) {
+		stack->slots[i].next = (i + 1 < capacity) ? i + 1 : AS_CONN_STACK_NIL;
+	}
+	return stack;
+}
+
+void
+as_conn_stack_destroy(as_conn_stack* stack)
+{
+	as_socket sock;
+
+	while (as_conn_stack_pop_head(stack, &sock)) {
+		as_socket_close(&sock);
+	}
+
+	cf_free(stack->slots);
+	cf_free(stack);
+}
+
+bool
+as_conn_stack_pop_head(as_conn_stack* stack, as_socket* sock)
+{
+	uint32_t index = as_conn_stack_pop_index(stack, &stack->head);
+
+	if (index == AS_CONN_STACK_NIL) {
+		return false;
+	}
+
+	*sock = stack->slots[index].sock;
+	as_decr_uint32(&stack->size);
+	as_conn_stack_push_chain(stack, &stack->free, index, index);
+	return true;
+}
+
+bool
+as_conn_stack_pop_tail(as_conn_stack* stack, as_socket* sock)
+{
+	as_conn_walk_entry ring[2];
+	as_conn_walk walk = {.ring = ring, .ring_size = 2};
+
+	while (true) {
+		as_conn_stack_walk(stack, &walk, 0);
+
+		if (walk.len == 0) {
+			return false;
+		}
+
+		if (as_conn_stack_split(stack, &walk, walk.len - 1)) {
+			break;
+		}
+	}
+
+	uint32_t last = ring[walk.len % 2].index;
+
+	*sock = stack->slots[last].sock;
+	as_decr_uint32(&stack->size);
+	as_conn_stack_push_chain(stack, &stack->free, last, last);
+	return true;
+}
+
+uint32_t
+as_conn_stack_trim(
+	as_conn_stack* stack, uint64_t max_socket_idle_ns, as_socket* socks, uint32_t max
+	)
+{
+	// Walk the stack once.  Connections are in last used order, so the idle connections are
+	// the chain after the last current connection.  Only the last max + 1 slots are needed
+	// to unlink and copy the idle connections.
+	if (max > AS_CONN_TRIM_MAX) {
+		max = AS_CONN_TRIM_MAX;
+	}
+
+	uint32_t ring_size = max + 1;
+	as_conn_walk_entry ring[AS_CONN_TRIM_MAX + 1];
+	as_conn_walk walk = {.ring = ring, .ring_size = ring_size};
+	uint32_t n;
+
+	while (true) {
+		as_conn_stack_walk(stack, &walk, max_socket_idle_ns);
+
+		n = walk.len - walk.current;
+
+		if (n > max) {
+			n = max;
+		}
+
+		if (n == 0) {
+			return 0;
+		}
+
+		if (as_conn_stack_split(stack, &walk, walk.len - n)) {
+			break;
+		}
+	}
+
+	// Copy least recently used connections first.
+	uint32_t first = ring[(walk.len - n + 1) % ring_size].index;
+	uint32_t last = ring[walk.len % ring_size].index;
+
+	for (uint32_t k = 0; k < n; k++) {
+		socks[k] = stack->slots[ring[(walk.len - k) % ring_size].index].sock;
+	}
+
+	as_aaf_uint32(&stack->size, -n);
+	as_conn_stack_push_chain(stack, &stack->free, first, last);
+	return n;
+}
+
+bool
+as_conn_stack_push_head(as_conn_stack* stack, as_socket* sock)
+{
+	uint32_t index = as_conn_stack_pop_index(stack, &stack->free);
+
+	if (index == AS_CONN_STACK_NIL) {
+		return false;
+	}
+
+	stack->slots[index].sock = *sock;
+	as_incr_uint32(&stack->size);
+	as_conn_stack_push_chain(stack, &stack->head, index, index);
+	return true;
+}
+
+bool
+as_conn_stack_push_tail(as_conn_stack* stack, as_socket* sock)
+{
+	uint32_t index = as_conn_stack_pop_index(stack, &stack->free);
+
+	if (index == AS_CONN_STACK_NIL) {
+		return false;
+	}
+
+	stack->slots[index].sock = *sock;
+	as_conn_stack_set_next(stack, index, AS_CONN_STACK_NIL);
+	as_incr_uint32(&stack->size);
+
+	as_conn_walk_entry ring[1];
+	as_conn_walk walk = {.ring = ring, .ring_size = 1};
+
+	while (true) {
+		as_conn_stack_walk(stack, &walk, 0);
+
+		if (walk.len == 0) {
+			uint64_t empty = walk.head;
+
+			if (as_cas_uint64(&stack->head, empty, as_conn_stack_next(empty, index))) {
+				return true;
+			}
+			continue;
+		}
+
+		if (walk.len == 1) {
+			// The only slot is the first slot, which poppers also unlink.
+			if (as_conn_stack_detach_walk(stack, &walk)) {
+				uint32_t first = as_conn_stack_index(walk.head);
+
+				as_conn_stack_set_next(stack, first, index);
+				as_conn_stack_push_chain(stack, &stack->head, first, index);
+				return true;
+			}
+			continue;
+		}
+
+		uint64_t* link = &stack->slots[ring[0].index].next;
+
+		if (as_cas_uint64(link, ring[0].next, as_conn_stack_next(ring[0].next, index))) {
+			return true;
+		}
+	}
+}
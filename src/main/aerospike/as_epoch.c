@@ -0,0 +1,161 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_epoch.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_atomic.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Each slot occupies its own cache line, so threads only write lines they own.
+typedef struct as_epoch_slot_s {
+	uint64_t epoch;
+	struct as_epoch_slot_s* next;
+	uint32_t depth;
+	bool in_use;
+	uint8_t pad[64 - sizeof(uint64_t) - sizeof(void*) - sizeof(uint32_t) - sizeof(bool)];
+} as_epoch_slot;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+// Zero means not in a critical section, so the global epoch starts at one.
+static uint64_t as_epoch_global = 1;
+static as_epoch_slot* as_epoch_slots = NULL;
+static pthread_mutex_t as_epoch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t as_epoch_key;
+static pthread_once_t as_epoch_once = PTHREAD_ONCE_INIT;
+static AS_THREAD_LOCAL as_epoch_slot* as_epoch_local;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_epoch_thread_exit(void* udata)
+{
+	// Slots are never freed because the tend thread may be scanning them.
+	// Mark slot free for reuse by the next new thread.
+	as_epoch_slot* slot = udata;
+	slot->depth = 0;
+	as_store_uint64(&slot->epoch, 0);
+
+	pthread_mutex_lock(&as_epoch_lock);
+	slot->in_use = false;
+	pthread_mutex_unlock(&as_epoch_lock);
+}
+
+static void
+as_epoch_create_key(void)
+{
+	pthread_key_create(&as_epoch_key, as_epoch_thread_exit);
+}
+
+static as_epoch_slot*
+as_epoch_register(void)
+{
+	pthread_once(&as_epoch_once, as_epoch_create_key);
+	pthread_mutex_lock(&as_epoch_lock);
+
+	as_epoch_slot* slot = as_epoch_slots;
+
+	while (slot && slot->in_use) {
+		slot = slot->next;
+	}
+
+	if (! slot) {
+		slot = as_alloc_aligned(64, sizeof(as_epoch_slot));
+		memset(slot, 0, sizeof(as_epoch_slot));
+		slot->next = as_epoch_slots;
+		as_store_ptr(&as_epoch_slots, slot);
+	}
+	slot->in_use = true;
+	pthread_mutex_unlock(&as_epoch_lock);
+
+	pthread_setspecific(as_epoch_key, slot);
+	as_epoch_local = slot;
+	return slot;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_epoch_enter(void)
+{
+	as_epoch_slot* slot = as_epoch_local;
+
+	if (! slot) {
+		slot = as_epoch_register();
+	}
+
+	if (slot->depth++ == 0) {
+		as_store_uint64(&slot->epoch, as_load_uint64(&as_epoch_global));
+
+		// The epoch store must be visible before shared pointers are read.
+		as_fence_seq();
+	}
+}
+
+void
+as_epoch_exit(void)
+{
+	as_epoch_slot* slot = as_epoch_local;
+
+	if (--slot->depth == 0) {
+		as_store_uint64(&slot->epoch, 0);
+	}
+}
+
+uint64_t
+as_epoch_advance(void)
+{
+	uint64_t epoch = as_faa_uint64(&as_epoch_global, 1);
+
+	// Pair with the fence in as_epoch_enter().
+	as_fence_seq();
+	return epoch;
+}
+
+uint64_t
+as_epoch_min_active(void)
+{
+	uint64_t min = UINT64_MAX;
+	as_epoch_slot* slot = as_load_ptr(&as_epoch_slots);
+
+	while (slot) {
+		uint64_t epoch = as_load_uint64(&slot->epoch);
+
+		if (epoch != 0 && epoch < min) {
+			min = epoch;
+		}
+		slot = slot->next;
+	}
+	return min;
+}
@@ -15,6 +15,7 @@
  * the License.
  */
 #include <aerospike/as_error.h>
+#include <stdio.h>
 
 /******************************************************************************
  * FUNCTIONS
@@ -33,6 +34,7 @@ as_error_string(as_status status)
 		CASE_ASSIGN(AEROSPIKE_OK);
 		CASE_ASSIGN(AEROSPIKE_QUERY_END);
 
+		CASE_ASSIGN(AEROSPIKE_ERR_ASYNC_OVERLOAD);
 		CASE_ASSIGN(AEROSPIKE_BATCH_FAILED);
 		CASE_ASSIGN(AEROSPIKE_NO_RESPONSE);
 		CASE_ASSIGN(AEROSPIKE_MAX_ERROR_RATE);
@@ -125,3 +127,20 @@ as_error_string(as_status status)
 			}
 	}
 }
+
+const char*
+as_error_message(as_error* err)
+{
+	if (err->lazy) {
+		const char* str = as_error_string(err->code);
+
+		if (err->lazy_address[0]) {
+			snprintf(err->message, sizeof(err->message), "%s %s", err->lazy_address, str);
+		}
+		else {
+			as_strncpy(err->message, str, sizeof(err->message));
+		}
+		err->lazy = false;
+	}
+	return err->message;
+}
@@ -17,15 +17,20 @@
 #include <aerospike/as_event.h>
 #include <aerospike/as_event_internal.h>
 #include <aerospike/as_admin.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_capture.h>
 #include <aerospike/as_command.h>
+#include <aerospike/as_cpu.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_memory.h>
 #include <aerospike/as_monitor.h>
 #include <aerospike/as_pipe.h>
 #include <aerospike/as_proto.h>
 #include <aerospike/as_query_validate.h>
 #include <aerospike/as_shm_cluster.h>
 #include <citrusleaf/alloc.h>
+#include <inttypes.h>
 #include <pthread.h>
 
 /******************************************************************************
@@ -40,6 +45,12 @@
 #define as_in_event_loop(_t1) ((_t1).p == pthread_self().p)
 #endif
 
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
+
 /******************************************************************************
  * GLOBALS
  *****************************************************************************/
@@ -53,6 +64,11 @@ int as_event_recv_buffer_size = 0;
 bool as_event_threads_created = false;
 bool as_event_single_thread = false;
 static pthread_mutex_t as_event_lock = PTHREAD_MUTEX_INITIALIZER;
+as_event_loop_select as_event_loop_select_mode = AS_EVENT_LOOP_SELECT_ROUND_ROBIN;
+
+// Random state for least loaded selection and thread affinity event loop (index + 1).
+static AS_THREAD_LOCAL uint64_t as_event_select_seed = 0;
+static AS_THREAD_LOCAL uint32_t as_event_select_affinity = 0;
 
 as_status aerospike_library_init(as_error* err);
 int as_batch_retry_async(as_event_command* cmd, bool timeout);
@@ -67,27 +83,76 @@ as_event_validate_policy(as_error* err, as_policy_event* policy)
 	if (policy->max_commands_in_process < 0 || (policy->max_commands_in_process > 0 && policy->max_commands_in_process < 5)) {
 		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "max_commands_in_process %u must be 0 or >= 5", policy->max_commands_in_process);
 	}
+
+	if (policy->auto_batch_max_keys == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "auto_batch_max_keys must be > 0");
+	}
+
+	if (policy->cpus_size > 0 && ! policy->cpus) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "cpus must be set when cpus_size > 0");
+	}
 	return AEROSPIKE_OK;
 }
 
 static void
 as_event_initialize_loop(as_policy_event* policy, as_event_loop* event_loop, uint32_t index)
 {
-	pthread_mutex_init(&event_loop->lock, 0);
-	as_queue_init(&event_loop->queue, sizeof(as_event_commander), AS_EVENT_QUEUE_INITIAL_CAPACITY);
+	as_mpsc_queue_init(&event_loop->queue, sizeof(as_event_commander));
 
-	if (policy->max_commands_in_process > 0) {
-		as_queue_init(&event_loop->delay_queue, sizeof(as_event_command*), policy->queue_initial_capacity);
-	}
-	else {
-		memset(&event_loop->delay_queue, 0, sizeof(as_queue));
-	}
+	memset(event_loop->delay_queue, 0, sizeof(event_loop->delay_queue));
+	event_loop->delay_size = 0;
+	event_loop->delay_cursor = 0;
+	event_loop->delay_interval_ns = 0;
+	event_loop->delay_pop_ns = 0;
+	event_loop->deadline_admission = policy->deadline_admission;
+	event_loop->deadline_order = policy->deadline_order;
+	event_loop->delay_backlog = false;
 	as_queue_init(&event_loop->pipe_cb_queue, sizeof(as_queued_pipe_cb), AS_EVENT_QUEUE_INITIAL_CAPACITY);
 	event_loop->index = index;
 	event_loop->max_commands_in_queue = policy->max_commands_in_queue;
 	event_loop->max_commands_in_process = policy->max_commands_in_process;
 	event_loop->pending = 0;
 	event_loop->errors = 0;
+	event_loop->wakeup_pending = 0;
+	memset(&event_loop->counters, 0, sizeof(as_command_counters));
+	memset(&event_loop->slab, 0, sizeof(as_event_slab));
+	event_loop->slab.max_size = policy->command_cache_size;
+	memset(&event_loop->buffer_pool, 0, sizeof(as_event_buffer_pool));
+	event_loop->buffer_pool.max_resident = policy->read_buffer_cache_size;
+
+	if (policy->timer_wheel) {
+		as_event_wheel* wheel = cf_malloc(sizeof(as_event_wheel));
+		memset(wheel, 0, sizeof(as_event_wheel));
+		wheel->driver.event_loop = event_loop;
+		wheel->driver.type = AS_ASYNC_TYPE_WHEEL;
+		event_loop->wheel = wheel;
+	}
+	else {
+		event_loop->wheel = NULL;
+	}
+
+	if (policy->lag_interval_ms > 0) {
+		as_event_lag* lag = cf_malloc(sizeof(as_event_lag));
+		memset(lag, 0, sizeof(as_event_lag));
+		lag->driver.event_loop = event_loop;
+		lag->driver.type = AS_ASYNC_TYPE_LAG;
+		lag->interval_ms = policy->lag_interval_ms;
+		event_loop->lag = lag;
+	}
+	else {
+		event_loop->lag = NULL;
+	}
+	memset(event_loop->lag_hist, 0, sizeof(event_loop->lag_hist));
+	memset(event_loop->callback_hist, 0, sizeof(event_loop->callback_hist));
+	event_loop->slow_callback_us = policy->slow_callback_us;
+	event_loop->busy_poll_us = policy->busy_poll_us;
+	event_loop->socket_busy_poll = policy->socket_busy_poll;
+	event_loop->callback_stats = policy->callback_stats || policy->slow_callback_us > 0;
+	event_loop->auto_batch = NULL;
+	event_loop->pipe_gather = NULL;
+	event_loop->auto_batch_window_ms = policy->auto_batch_window_us / 1000;
+	event_loop->auto_batch_max_keys = policy->auto_batch_max_keys;
+	event_loop->cpu = -1;
 	event_loop->using_delay_queue = false;
 	event_loop->pipe_cb_calling = false;
 }
@@ -187,6 +252,10 @@ as_create_event_loops(as_error* err, as_policy_event* policy, uint32_t capacity,
 		memset(&event_loop->thread, 0, sizeof(pthread_t));
 #endif
 
+		if (policy->cpus_size > 0) {
+			event_loop->cpu = policy->cpus[i % policy->cpus_size];
+		}
+
 		if (! as_event_create_loop(event_loop)) {
 			as_event_close_loops();
 			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to create event_loop: %u", i);
@@ -306,6 +375,87 @@ as_event_loop_find(void* loop)
 	return NULL;
 }
 
+static inline uint32_t
+as_event_loop_load(as_event_loop* event_loop)
+{
+	// Warning: cross-thread references without a lock.
+	return (uint32_t)event_loop->pending + as_mpsc_queue_size(&event_loop->queue) +
+		event_loop->delay_size;
+}
+
+static inline uint32_t
+as_event_select_random(void)
+{
+	// xorshift64* seeded from the thread's stack address.
+	uint64_t x = as_event_select_seed;
+
+	if (x == 0) {
+		x = (uint64_t)(uintptr_t)&x | 1;
+	}
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	as_event_select_seed = x;
+	return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+as_event_loop*
+as_event_loop_get_least_loaded(void)
+{
+	uint32_t size = as_event_loop_size;
+
+	if (size <= 1) {
+		return as_event_loops;
+	}
+
+	// Power of two choices: sample two distinct event loops and keep the less loaded one.
+	uint32_t r = as_event_select_random();
+	uint32_t i1 = r % size;
+	uint32_t i2 = (i1 + 1 + (r >> 16) % (size - 1)) % size;
+	as_event_loop* e1 = &as_event_loops[i1];
+	as_event_loop* e2 = &as_event_loops[i2];
+
+	return as_event_loop_load(e2) < as_event_loop_load(e1) ? e2 : e1;
+}
+
+void
+as_event_set_loop_select(as_event_loop_select mode)
+{
+	as_event_loop_select_mode = mode;
+}
+
+as_event_loop*
+as_event_loop_select_next(void)
+{
+	if (as_event_loop_select_mode == AS_EVENT_LOOP_SELECT_THREAD_AFFINITY) {
+		uint32_t index = as_event_select_affinity;
+
+		// Event loops may have been closed and recreated with fewer loops.
+		if (index == 0 || index > as_event_loop_size) {
+			as_event_loop* event_loop = as_event_loop_get_least_loaded();
+			as_event_select_affinity = event_loop->index + 1;
+			return event_loop;
+		}
+		return &as_event_loops[index - 1];
+	}
+	return as_event_loop_get_least_loaded();
+}
+
+bool
+as_event_can_block(void)
+{
+	if (as_event_loop_size == 0) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < as_event_loop_size; i++) {
+		if (as_in_event_loop(as_event_loops[i].thread)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 bool
 as_event_close_loops()
 {
@@ -362,12 +512,276 @@ as_event_destroy_loops()
 static void as_event_command_execute_in_loop(as_event_loop* event_loop, as_event_command* cmd);
 static void as_event_command_begin(as_event_loop* event_loop, as_event_command* cmd);
 static void as_event_execute_from_delay_queue(as_event_loop* event_loop);
+static void as_event_delay_expire(as_event_command* cmd);
 static void connector_error(as_event_command* cmd, as_error* err);
 
+bool
+as_event_process_queue(as_event_loop* event_loop)
+{
+	// Clear wakeup flag before draining.  A command queued while the queue is drained then
+	// sends a new wakeup instead of waiting for an unrelated one.
+	as_fas_uint32(&event_loop->wakeup_pending, 0);
+
+	// Only process original size of queue.  Recursive pre-registration errors can
+	// result in new commands being added while the loop is in process.  If we process
+	// them, we could end up in an infinite loop.
+	uint32_t size = as_mpsc_queue_size(&event_loop->queue);
+	as_event_commander cmd;
+
+	for (uint32_t i = 0; i < size && as_mpsc_queue_pop(&event_loop->queue, &cmd); i++) {
+		if (! cmd.executable) {
+			// Received stop signal.
+			return false;
+		}
+		cmd.executable(event_loop, cmd.udata);
+	}
+	return true;
+}
+
+bool
+as_event_thread_create(as_event_loop* event_loop, void* (*worker)(void*), void* udata)
+{
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+
+	if (event_loop->cpu >= 0 && as_cpu_assign_thread_attr(&attr, event_loop->cpu) != 0) {
+		as_log_warn("Failed to assign event loop %u to cpu %d", event_loop->index, event_loop->cpu);
+	}
+
+	if (pthread_create(&event_loop->thread, &attr, worker, udata) != 0) {
+		pthread_attr_destroy(&attr);
+		return false;
+	}
+	pthread_attr_destroy(&attr);
+
+	if (event_loop->cpu >= 0 && as_cpu_assign_thread(event_loop->thread, event_loop->cpu) != 0) {
+		as_log_warn("Failed to assign event loop %u to cpu %d", event_loop->index, event_loop->cpu);
+	}
+	return true;
+}
+
+void*
+as_event_slab_alloc(as_event_loop* event_loop, size_t* size, uint8_t* slab_class)
+{
+	as_event_slab* slab = &event_loop->slab;
+	size_t s = *size;
+
+	if (slab->max_size == 0 || s > (1024 << (AS_EVENT_SLAB_CLASSES - 1))) {
+		*slab_class = AS_EVENT_SLAB_NONE;
+		return as_alloc_malloc(s);
+	}
+
+	uint8_t c = 0;
+
+	while (((size_t)1024 << c) < s) {
+		c++;
+	}
+
+	*size = (size_t)1024 << c;
+	*slab_class = c;
+
+	if (! as_in_event_loop(event_loop->thread)) {
+		// Free lists are owned by the event loop thread.  Allocate full class size, so the
+		// memory can still be cached when the command completes.
+		as_incr_uint64(&slab->remote);
+		as_memory_add(AS_MEMORY_EVENT, *size);
+		return as_alloc_malloc(*size);
+	}
+
+	void* ptr = slab->free[c];
+
+	if (! ptr) {
+		slab->misses++;
+		as_memory_add(AS_MEMORY_EVENT, *size);
+		return as_alloc_malloc(*size);
+	}
+
+	// First word of a free allocation links to the next free allocation.
+	slab->free[c] = *(void**)ptr;
+	slab->size[c]--;
+	slab->resident -= *size;
+	slab->hits++;
+	return ptr;
+}
+
+void
+as_event_slab_free(as_event_loop* event_loop, void* ptr, uint8_t slab_class)
+{
+	as_event_slab* slab = &event_loop->slab;
+
+	if (slab->size[slab_class] >= slab->max_size || ! as_in_event_loop(event_loop->thread)) {
+		as_memory_sub(AS_MEMORY_EVENT, (size_t)1024 << slab_class);
+		as_alloc_free_sized(ptr, (size_t)1024 << slab_class);
+		return;
+	}
+
+	*(void**)ptr = slab->free[slab_class];
+	slab->free[slab_class] = ptr;
+	slab->size[slab_class]++;
+	slab->resident += (uint64_t)1024 << slab_class;
+}
+
+void
+as_event_slab_destroy(as_event_slab* slab)
+{
+	for (uint32_t i = 0; i < AS_EVENT_SLAB_CLASSES; i++) {
+		void* ptr = slab->free[i];
+
+		while (ptr) {
+			void* next = *(void**)ptr;
+			as_memory_sub(AS_MEMORY_EVENT, (size_t)1024 << i);
+			as_alloc_free_sized(ptr, (size_t)1024 << i);
+			ptr = next;
+		}
+		slab->free[i] = NULL;
+		slab->size[i] = 0;
+	}
+	slab->resident = 0;
+}
+
+#define AS_EVENT_BUFFER_MIN ((size_t)16 * 1024)
+#define AS_EVENT_BUFFER_MAX (AS_EVENT_BUFFER_MIN << (AS_EVENT_BUFFER_CLASSES - 1))
+
+uint8_t*
+as_event_buffer_alloc(as_event_loop* event_loop, size_t* size)
+{
+	as_event_buffer_pool* pool = &event_loop->buffer_pool;
+	size_t s = *size;
+
+	if (pool->max_resident == 0 || s > AS_EVENT_BUFFER_MAX) {
+		as_memory_add(AS_MEMORY_EVENT, s);
+		return as_alloc_malloc(s);
+	}
+
+	uint32_t c = 0;
+
+	while ((AS_EVENT_BUFFER_MIN << c) < s) {
+		c++;
+	}
+
+	*size = AS_EVENT_BUFFER_MIN << c;
+
+	void* ptr = pool->free[c];
+
+	if (! ptr || ! as_in_event_loop(event_loop->thread)) {
+		as_memory_add(AS_MEMORY_EVENT, *size);
+		return as_alloc_malloc(*size);
+	}
+
+	// First word of a free buffer links to the next free buffer.
+	pool->free[c] = *(void**)ptr;
+	pool->resident -= *size;
+	return ptr;
+}
+
+void
+as_event_buffer_free(as_event_loop* event_loop, uint8_t* buf, size_t capacity)
+{
+	as_event_buffer_pool* pool = &event_loop->buffer_pool;
+
+	// Only class sized buffers are pooled.  Other capacities are exact heap allocations.
+	if (capacity < AS_EVENT_BUFFER_MIN || capacity > AS_EVENT_BUFFER_MAX ||
+		(capacity & (capacity - 1)) != 0 || pool->resident + capacity > pool->max_resident ||
+		! as_in_event_loop(event_loop->thread)) {
+		as_memory_sub(AS_MEMORY_EVENT, capacity);
+		as_alloc_free_sized(buf, capacity);
+		return;
+	}
+
+	uint32_t c = 0;
+
+	while ((AS_EVENT_BUFFER_MIN << c) < capacity) {
+		c++;
+	}
+
+	*(void**)buf = pool->free[c];
+	pool->free[c] = buf;
+	pool->resident += capacity;
+}
+
+void
+as_event_buffer_pool_destroy(as_event_buffer_pool* pool)
+{
+	for (uint32_t i = 0; i < AS_EVENT_BUFFER_CLASSES; i++) {
+		void* ptr = pool->free[i];
+
+		while (ptr) {
+			void* next = *(void**)ptr;
+			as_memory_sub(AS_MEMORY_EVENT, AS_EVENT_BUFFER_MIN << i);
+			as_alloc_free_sized(ptr, AS_EVENT_BUFFER_MIN << i);
+			ptr = next;
+		}
+		pool->free[i] = NULL;
+	}
+	pool->resident = 0;
+}
+
+static void
+as_event_trace_begin(as_event_command* cmd)
+{
+	bool trace = as_cluster_trace_sample(cmd->cluster);
+	bool hot_key = as_cluster_hot_key_sample(cmd->cluster);
+	bool capture = as_capture_sample(cmd->cluster->capture);
+
+	if (! trace && ! hot_key && ! capture) {
+		cmd->trace = NULL;
+		return;
+	}
+
+	// The write buffer starts at cmd->buf until the command is executed in the event loop.
+	as_trace_hooks* hooks = &cmd->cluster->trace;
+	as_trace_span* span = cf_malloc(sizeof(as_trace_span));
+	as_command_trace_init(span, cmd->cluster, cmd->ns, cmd->buf, cmd->write_len, true);
+	span->hooks = trace;
+	span->hot_key = hot_key;
+	span->capture = capture ?
+		as_capture_begin(cmd->cluster->capture, cmd->buf, cmd->write_len, true) : NULL;
+	cmd->trace = span;
+
+	if (trace && hooks->begin) {
+		hooks->begin(span, hooks->udata);
+	}
+}
+
+static void
+as_event_trace_end(as_event_command* cmd)
+{
+	as_trace_hooks* hooks = &cmd->cluster->trace;
+	as_trace_span* span = cmd->trace;
+	span->end_ns = cf_getns();
+	cmd->trace = NULL;
+
+	if (span->hot_key) {
+		as_command_trace_hot_key(cmd->cluster, span);
+	}
+
+	if (span->capture) {
+		as_capture_end(cmd->cluster->capture, span->capture, span);
+	}
+
+	if (span->hooks && hooks->end) {
+		hooks->end(span, hooks->udata);
+	}
+	cf_free(span);
+}
+
+static inline void
+as_event_trace_status(as_event_command* cmd, as_status status)
+{
+	if (cmd->trace) {
+		cmd->trace->status = status;
+	}
+}
+
+static void
+as_event_command_schedule_in_loop(as_event_command* cmd);
+
 as_status
 as_event_command_execute(as_event_command* cmd, as_error* err)
 {
 	cmd->command_sent_counter = 0;
+	cmd->node_bytes = false;
+	as_event_trace_begin(cmd);
 
 	as_event_loop* event_loop = cmd->event_loop;
 
@@ -380,7 +794,7 @@ as_event_command_execute(as_event_command* cmd, as_error* err)
 		else {
 			// Avoid recursive error death spiral by giving other commands
 			// a chance to run first.
-			as_event_command_schedule(cmd);
+			as_event_command_schedule_in_loop(cmd);
 		}
 	}
 	else {
@@ -399,7 +813,12 @@ as_event_command_execute(as_event_command* cmd, as_error* err)
 			if (cmd->node) {
 				as_node_release(cmd->node);
 			}
-			cf_free(cmd);
+
+			if (cmd->trace) {
+				as_event_trace_status(cmd, AEROSPIKE_ERR_CLIENT);
+				as_event_trace_end(cmd);
+			}
+			as_event_command_dealloc(cmd);
 			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Failed to queue command");
 		}
 	}
@@ -408,6 +827,13 @@ as_event_command_execute(as_event_command* cmd, as_error* err)
 
 void
 as_event_command_schedule(as_event_command* cmd)
+{
+	as_event_trace_begin(cmd);
+	as_event_command_schedule_in_loop(cmd);
+}
+
+static void
+as_event_command_schedule_in_loop(as_event_command* cmd)
 {
 	// Schedule command to execute in next event loop iteration.
 	// Must be run in event loop thread.
@@ -421,6 +847,28 @@ as_event_command_schedule(as_event_command* cmd)
 	as_event_timer_once(cmd, 0);
 }
 
+void
+as_event_command_schedule_delay(as_event_command* cmd, uint32_t delay_ms)
+{
+	// Schedule command to execute after delay. Must be run in event loop thread.
+	cmd->node_bytes = false;
+	as_event_trace_begin(cmd);
+
+	if (cmd->total_deadline > 0) {
+		// Total timeout starts after the delay.
+		cmd->total_deadline += cf_getms() + delay_ms;
+	}
+
+	// Count sleeping command as pending, so the cluster is not destroyed before the timer
+	// fires.  The count is moved to the running command in as_event_process_timer().
+	cmd->event_state = &cmd->cluster->event_state[cmd->event_loop->index];
+	cmd->event_state->pending++;
+
+	// Callback is as_event_process_timer().
+	cmd->state = AS_ASYNC_STATE_SLEEP;
+	as_event_timer_once(cmd, delay_ms);
+}
+
 static inline void
 as_event_prequeue_error(as_event_loop* event_loop, as_event_command* cmd, as_error* err)
 {
@@ -429,6 +877,45 @@ as_event_prequeue_error(as_event_loop* event_loop, as_event_command* cmd, as_err
 	as_event_error_callback(cmd, err);
 }
 
+static inline void
+as_event_delay_sample(as_event_loop* event_loop)
+{
+	// Only measure removals that followed a removal that left commands queued.  The interval
+	// is then the time for one command in process to complete and free a slot.
+	uint64_t now = cf_getns();
+
+	if (event_loop->delay_backlog) {
+		uint64_t sample = now - event_loop->delay_pop_ns;
+		uint64_t avg = event_loop->delay_interval_ns;
+
+		event_loop->delay_interval_ns = (avg == 0) ? sample : avg - (avg >> 3) + (sample >> 3);
+	}
+	event_loop->delay_pop_ns = now;
+	event_loop->delay_backlog = event_loop->delay_size > 0;
+}
+
+static inline uint64_t
+as_event_delay_wait(as_event_loop* event_loop)
+{
+	// Return estimated milliseconds a new command waits in the delay queue.  Zero until the
+	// removal rate has been measured.
+	uint64_t interval = event_loop->delay_interval_ns;
+
+	if (interval == 0) {
+		return 0;
+	}
+
+	if (event_loop->delay_backlog) {
+		// Queue is stalled longer than the average interval.
+		uint64_t since = cf_getns() - event_loop->delay_pop_ns;
+
+		if (since > interval) {
+			interval = since;
+		}
+	}
+	return (event_loop->delay_size + 1) * interval / (1000 * 1000);
+}
+
 void
 as_event_command_execute_in_loop(as_event_loop* event_loop, as_event_command* cmd)
 {
@@ -439,6 +926,10 @@ as_event_command_execute_in_loop(as_event_loop* event_loop, as_event_command* cm
 	cmd->proto_type_rcv = 0;
 	cmd->event_state = &cmd->cluster->event_state[event_loop->index];
 
+	if (event_loop->lag && ! event_loop->lag->running) {
+		as_event_lag_start(event_loop);
+	}
+
 	if (cmd->event_state->closed) {
 		as_error err;
 		as_error_set_message(&err, AEROSPIKE_ERR_CLIENT, "Cluster has been closed");
@@ -475,31 +966,34 @@ as_event_command_execute_in_loop(as_event_loop* event_loop, as_event_command* cm
 
 		// Handle new command.
 		if (event_loop->pending >= event_loop->max_commands_in_process) {
-			// Pending queue full. Append new command to delay queue.
-			bool status;
-
-			if (event_loop->max_commands_in_queue > 0) {
-				uint32_t size = as_queue_size(&event_loop->delay_queue);
-
-				if (size < event_loop->max_commands_in_queue) {
-					status = as_queue_push(&event_loop->delay_queue, &cmd);
-				}
-				else {
-					status = false;
-				}
-			}
-			else {
-				status = as_queue_push(&event_loop->delay_queue, &cmd);
-			}
-
-			if (! status) {
+			// Pending queue full. Append new command to its priority lane in the delay queue.
+			// The queue limit applies to all lanes combined.
+			if (event_loop->max_commands_in_queue > 0 &&
+				event_loop->delay_size >= event_loop->max_commands_in_queue) {
 				as_error err;
 				as_error_update(&err, AEROSPIKE_ERR_ASYNC_QUEUE_FULL, "Async delay queue full: %u",
 								event_loop->max_commands_in_queue);
+				event_loop->counters.delay_queue_rejects++;
 				as_event_prequeue_error(event_loop, cmd, &err);
 				return;
 			}
 
+			if (event_loop->deadline_admission && total_timeout > 0) {
+				uint64_t wait = as_event_delay_wait(event_loop);
+
+				if (wait >= total_timeout) {
+					// Command would time out before leaving the delay queue.
+					as_error err;
+					as_error_update(&err, AEROSPIKE_ERR_ASYNC_OVERLOAD,
+						"Estimated delay queue wait %" PRIu64 "ms exceeds timeout %" PRIu64 "ms",
+						wait, total_timeout);
+					event_loop->counters.overload_rejects++;
+					as_event_prequeue_error(event_loop, cmd, &err);
+					return;
+				}
+			}
+
+			as_event_delay_push(event_loop, cmd);
 			cmd->state = AS_ASYNC_STATE_DELAY_QUEUE;
 
 			if (total_timeout > 0) {
@@ -539,14 +1033,20 @@ as_event_execute_from_delay_queue(as_event_loop* event_loop)
 	as_event_command* cmd;
 
 	while (event_loop->pending < event_loop->max_commands_in_process &&
-		   as_queue_pop(&event_loop->delay_queue, &cmd)) {
+		   (cmd = as_event_delay_pop(event_loop))) {
 
-		if (cmd->state == AS_ASYNC_STATE_QUEUE_ERROR) {
-			// Command timed out and user has already been notified.
-			as_event_command_release(cmd);
+		if (event_loop->deadline_order && cmd->total_deadline > 0 &&
+			cf_getms() >= cmd->total_deadline) {
+			// Drop expired command without starting I/O, even if its timer has not fired yet.
+			as_event_timer_stop(cmd);
+			as_event_delay_expire(cmd);
 			continue;
 		}
 
+		if (event_loop->deadline_admission) {
+			as_event_delay_sample(event_loop);
+		}
+
 		if (cmd->socket_timeout > 0) {
 			if (cmd->total_deadline > 0) {
 				if (cmd->socket_timeout < cmd->total_deadline - cf_getms()) {
@@ -580,14 +1080,173 @@ as_event_create_connection(as_event_command* cmd, as_async_conn_pool* pool)
 	as_event_connect(cmd, pool);
 }
 
+static inline void
+as_event_latency_end(as_event_command* cmd, bool failed)
+{
+	if (cmd->latency_begin) {
+		as_node_latency_end(cmd->node, cmd->latency_begin, failed);
+		cmd->latency_begin = 0;
+	}
+}
+
+static inline uint64_t
+as_event_callback_begin(as_event_loop* event_loop)
+{
+	return event_loop->callback_stats ? cf_getns() : 0;
+}
+
+static void
+as_event_callback_end(as_event_loop* event_loop, const char* type, uint64_t begin)
+{
+	if (! begin) {
+		return;
+	}
+
+	uint64_t us = (cf_getns() - begin) / 1000;
+	event_loop->callback_hist[as_latency_bucket(us)]++;
+
+	if (event_loop->slow_callback_us > 0 && us >= event_loop->slow_callback_us) {
+		as_log_warn("Slow %s listener on event loop %u: %" PRIu64 " us", type,
+			event_loop->index, us);
+	}
+}
+
+static void
+as_event_count_command(as_event_loop* event_loop, as_event_command* cmd)
+{
+	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
+	uint64_t uncompressed = (buf[1] == AS_COMPRESSED_MESSAGE_TYPE)?
+		cf_swap_from_be64(*(uint64_t*)(buf + sizeof(as_proto))) : 0;
+
+	as_command_counters* counters = as_node_get_counters(cmd->node);
+	as_incr_uint64(&counters->commands);
+	as_faa_uint64(&counters->bytes_out, cmd->write_len);
+
+	event_loop->counters.commands++;
+	event_loop->counters.bytes_out += cmd->write_len;
+
+	if (uncompressed) {
+		as_faa_uint64(&counters->compressed_out, cmd->write_len);
+		as_faa_uint64(&counters->uncompressed_out, uncompressed);
+		event_loop->counters.compressed_out += cmd->write_len;
+		event_loop->counters.uncompressed_out += uncompressed;
+	}
+}
+
+static inline void
+as_event_record_latency(as_event_command* cmd)
+{
+	if (! cmd->stats_begin) {
+		return;
+	}
+
+	if (cmd->partition && cmd->node->timeout_hist) {
+		as_node_record_timeout_latency(cmd->node, cmd->stats_begin);
+	}
+
+	if (! cmd->node->latency) {
+		cmd->stats_begin = 0;
+		return;
+	}
+
+	as_latency_type type;
+
+	switch (cmd->type) {
+		case AS_ASYNC_TYPE_BATCH:
+		case AS_ASYNC_TYPE_AUTO_BATCH:
+			type = AS_LATENCY_TYPE_BATCH;
+			break;
+
+		case AS_ASYNC_TYPE_SCAN:
+		case AS_ASYNC_TYPE_SCAN_PARTITION:
+			type = AS_LATENCY_TYPE_SCAN;
+			break;
+
+		case AS_ASYNC_TYPE_QUERY:
+		case AS_ASYNC_TYPE_QUERY_PARTITION:
+			type = AS_LATENCY_TYPE_QUERY;
+			break;
+
+		case AS_ASYNC_TYPE_WRITE:
+		case AS_ASYNC_TYPE_RECORD:
+		case AS_ASYNC_TYPE_VALUE:
+			type = (cmd->flags & AS_ASYNC_FLAGS_READ)? AS_LATENCY_TYPE_READ :
+				AS_LATENCY_TYPE_WRITE;
+			break;
+
+		default:
+			cmd->stats_begin = 0;
+			return;
+	}
+	as_node_record_latency(cmd->node, type, cmd->stats_begin);
+	cmd->stats_begin = 0;
+}
+
+static void
+as_event_adaptive_timer(as_event_command* cmd)
+{
+	// Configured socket timeout or remaining total timeout is the upper bound.
+	uint32_t max = cmd->socket_timeout;
+
+	if (cmd->total_deadline > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= cmd->total_deadline) {
+			return;
+		}
+
+		uint64_t remaining = cmd->total_deadline - now;
+
+		if (max == 0 || max > remaining) {
+			max = (uint32_t)remaining;
+		}
+	}
+
+	uint32_t timeout = as_node_adaptive_timeout(cmd->node, max);
+
+	if (timeout < max) {
+		// Replace the configured timer for this attempt.
+		as_event_timer_stop(cmd);
+		as_event_timer_repeat(cmd, timeout);
+	}
+}
+
+static inline bool
+as_event_node_bytes_acquire(as_event_command* cmd, uint32_t limit)
+{
+	uint64_t bytes = as_aaf_uint64(&cmd->node->async_bytes, cmd->write_len);
+
+	// Always admit a command when nothing else is in flight, so commands larger than the
+	// limit can still run.
+	if (bytes > limit && bytes != cmd->write_len) {
+		as_add_uint64(&cmd->node->async_bytes, -(int64_t)cmd->write_len);
+		return false;
+	}
+	cmd->node_bytes = true;
+	return true;
+}
+
+static inline void
+as_event_node_bytes_release(as_event_command* cmd)
+{
+	if (cmd->node_bytes) {
+		as_add_uint64(&cmd->node->async_bytes, -(int64_t)cmd->write_len);
+		cmd->node_bytes = false;
+	}
+}
+
 static void
 as_event_command_begin(as_event_loop* event_loop, as_event_command* cmd)
 {
 	cmd->state = AS_ASYNC_STATE_CONNECT;
 
+	// Release bytes counted against the node of the prior attempt.
+	as_event_node_bytes_release(cmd);
+
 	if (cmd->partition) {
 		// If in retry, need to release node from prior attempt.
 		if (cmd->node) {
+			as_event_latency_end(cmd, true);
 			as_node_release(cmd->node);
 		}
 
@@ -599,6 +1258,7 @@ as_event_command_begin(as_event_loop* event_loop, as_event_command* cmd)
 
 		if (! cmd->node) {
 			event_loop->errors++;
+			as_cluster_incr_route_errors(cmd->cluster);
 
 			as_error err;
 			as_error_update(&err, AEROSPIKE_ERR_INVALID_NODE, "Node not found for partition %s",
@@ -608,24 +1268,72 @@ as_event_command_begin(as_event_loop* event_loop, as_event_command* cmd)
 			as_event_error_callback(cmd, &err);
 			return;
 		}
+
+		if (cmd->cluster->error_rate_read_replica && (cmd->flags & AS_ASYNC_FLAGS_READ) &&
+			!(cmd->flags & AS_ASYNC_FLAGS_LINEARIZE) && cmd->replica != AS_POLICY_REPLICA_MASTER &&
+			as_load_uint8(&cmd->node->breaker_state) == AS_NODE_BREAKER_OPEN) {
+			// Node breaker is open. Redirect read to another replica for this attempt.
+			// Half-open nodes are admitted below, so they still receive probes.
+			cmd->flags ^= AS_ASYNC_FLAGS_MASTER;
+
+			as_node* node = as_partition_get_node(cmd->cluster, cmd->ns, cmd->partition,
+				cmd->node, cmd->replica, cmd->flags & AS_ASYNC_FLAGS_MASTER);
+
+			if (node) {
+				cmd->node = node;
+			}
+		}
 		as_node_reserve(cmd->node);
+
+		if (cmd->node->timeout_hist && ! cmd->pipe_listener) {
+			as_event_adaptive_timer(cmd);
+		}
+
+		if (cmd->replica == AS_POLICY_REPLICA_LOWEST_LATENCY && ! cmd->pipe_listener) {
+			cmd->latency_begin = cf_getns();
+			as_node_latency_begin(cmd->node);
+		}
+	}
+
+	// Pipelined responses are not recorded.
+	cmd->stats_begin = ((cmd->node->latency || (cmd->partition && cmd->node->timeout_hist)) &&
+		! cmd->pipe_listener)? cf_getns() : 0;
+
+	if (cmd->trace) {
+		as_command_trace_attempt(cmd->trace, cmd->node->name);
+	}
+
+	if (! as_node_breaker_allow(cmd->node)) {
+		event_loop->errors++;
+
+		if (as_event_command_retry(cmd, true)) {
+			return;
+		}
+
+		as_error err;
+		as_error_set_message(&err, AEROSPIKE_MAX_ERROR_RATE, "Max error rate exceeded");
+
+		as_event_timer_stop(cmd);
+		as_event_error_callback(cmd, &err);
+		return;
 	}
 
-	if (! as_node_valid_error_count(cmd->node)) {
-		event_loop->errors++;
+	uint32_t max_bytes = cmd->cluster->async_max_bytes_per_node;
 
-		if (as_event_command_retry(cmd, true)) {
-			return;
-		}
+	if (max_bytes > 0 && ! as_event_node_bytes_acquire(cmd, max_bytes)) {
+		event_loop->counters.overload_rejects++;
 
 		as_error err;
-		as_error_set_message(&err, AEROSPIKE_MAX_ERROR_RATE, "Max error rate exceeded");
+		as_error_update(&err, AEROSPIKE_ERR_ASYNC_OVERLOAD,
+			"Node %s async bytes in flight limit reached: %u", cmd->node->name, max_bytes);
 
 		as_event_timer_stop(cmd);
 		as_event_error_callback(cmd, &err);
 		return;
 	}
 
+	as_event_count_command(event_loop, cmd);
+
 	if (cmd->pipe_listener) {
 		as_pipe_get_connection(cmd);
 		return;
@@ -655,14 +1363,20 @@ as_event_command_begin(as_event_loop* event_loop, as_event_command* cmd)
 		conn->cmd = cmd;
 		cmd->conn = (as_event_connection*)conn;
 		event_loop->errors = 0;  // Reset errors on valid connection.
+		as_async_conn_pool_track_demand(pool);
 		as_event_command_write_start(cmd);
 		return;
 	}
 
 	// Create connection only when connection count within limit.
 	if (as_async_conn_pool_incr_total(pool)) {
-		as_event_create_connection(cmd, pool);
-		return;
+		if (as_node_reserve_conn_open(cmd->node)) {
+			as_async_conn_pool_track_demand(pool);
+			as_event_create_connection(cmd, pool);
+			return;
+		}
+		// Connection open rate exceeded.
+		as_queue_decr_total(&pool->queue);
 	}
 
 	event_loop->errors++;
@@ -708,6 +1422,18 @@ as_event_proto_parse(as_event_command* cmd, as_proto* proto)
 		as_event_parse_error(cmd, &err);
 		return false;
 	}
+
+	uint64_t bytes_in = sizeof(as_proto) + proto->sz;
+	as_faa_uint64(&as_node_get_counters(cmd->node)->bytes_in, bytes_in);
+	cmd->event_loop->counters.bytes_in += bytes_in;
+
+	if (cmd->trace) {
+		if (! cmd->trace->first_byte_ns) {
+			cmd->trace->first_byte_ns = cf_getns();
+		}
+		cmd->trace->bytes_in += bytes_in;
+		cmd->trace->bytes_out = cmd->write_len;
+	}
 	return true;
 }
 
@@ -751,21 +1477,29 @@ as_event_decompress(as_event_command* cmd)
 		return false;
 	}
 
-	uint8_t* buf = cf_malloc(size);
+	size_t capacity = size;
+	uint8_t* buf = as_event_buffer_alloc(cmd->event_loop, &capacity);
 
 	if (as_proto_decompress(&err, buf, size, cmd->buf, cmd->len) != AEROSPIKE_OK) {
-		cf_free(buf);
+		as_event_buffer_free(cmd->event_loop, buf, capacity);
 		as_event_parse_error(cmd, &err);
 		return false;
 	}
 
+	// cmd->len excludes the proto header that was already read.
+	as_command_counters* counters = as_node_get_counters(cmd->node);
+	as_faa_uint64(&counters->compressed_in, sizeof(as_proto) + cmd->len);
+	as_faa_uint64(&counters->uncompressed_in, size);
+	cmd->event_loop->counters.compressed_in += sizeof(as_proto) + cmd->len;
+	cmd->event_loop->counters.uncompressed_in += size;
+
 	if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-		cf_free(cmd->buf);
+		as_event_buffer_free(cmd->event_loop, cmd->buf, cmd->read_capacity);
 	}
 	cmd->buf = buf;
 	cmd->len = (uint32_t)size;
 	cmd->pos = sizeof(as_proto);
-	cmd->read_capacity = cmd->len;
+	cmd->read_capacity = (uint32_t)capacity;
 	cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
 	return true;
 }
@@ -773,8 +1507,32 @@ as_event_decompress(as_event_command* cmd)
 void
 as_event_socket_timeout(as_event_command* cmd)
 {
-	if (cmd->flags & AS_ASYNC_FLAGS_EVENT_RECEIVED) {
-		// Event(s) received within socket timeout period.
+	if (cmd->type == AS_ASYNC_TYPE_WHEEL) {
+		// Backend timer that drives the event loop's timer wheel.
+		as_event_wheel_tick(cmd->event_loop->wheel);
+		return;
+	}
+
+	if (cmd->type == AS_ASYNC_TYPE_LAG) {
+		// Backend timer that measures event loop lag.
+		as_event_lag* lag = cmd->event_loop->lag;
+		uint64_t now = cf_getns();
+
+		if (now > lag->expected_ns) {
+			uint64_t us = (now - lag->expected_ns) / 1000;
+			cmd->event_loop->lag_hist[as_latency_bucket(us)]++;
+		}
+		else {
+			cmd->event_loop->lag_hist[0]++;
+		}
+		lag->expected_ns = now + (uint64_t)lag->interval_ms * 1000 * 1000;
+		return;
+	}
+
+	if ((cmd->flags & AS_ASYNC_FLAGS_EVENT_RECEIVED) ||
+		cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+		// Event(s) received within socket timeout period or reads are paused by
+		// flow control.  Only total timeout applies to paused commands.
 		cmd->flags &= ~AS_ASYNC_FLAGS_EVENT_RECEIVED;
 
 		if (cmd->total_deadline > 0) {
@@ -789,7 +1547,8 @@ as_event_socket_timeout(as_event_command* cmd)
 
 			uint64_t remaining = cmd->total_deadline - now;
 
-			if (remaining <= cmd->socket_timeout) {
+			// Adaptive timeouts may use a socket timer without a configured socket timeout.
+			if (remaining <= cmd->socket_timeout || cmd->socket_timeout == 0) {
 				// Transition to total timer.
 				cmd->flags &= ~AS_ASYNC_FLAGS_USING_SOCKET_TIMER;
 				as_event_timer_stop(cmd);
@@ -812,6 +1571,8 @@ as_event_socket_timeout(as_event_command* cmd)
 
 	// Node should not be null at this point.
 	as_event_connection_timeout(cmd, &cmd->node->async_conn_pools[cmd->event_loop->index]);
+	as_incr_uint64(&as_node_get_counters(cmd->node)->socket_timeouts);
+	cmd->event_loop->counters.socket_timeouts++;
 
 	if (! as_event_command_retry(cmd, true)) {
 		as_event_timer_stop(cmd);
@@ -827,24 +1588,49 @@ as_event_socket_timeout(as_event_command* cmd)
 static void
 as_event_delay_timeout(as_event_command* cmd)
 {
+	// Unlink from the delay queue lane so the stale command is dropped now instead of
+	// being skipped when its turn comes.
+	as_event_delay_remove(cmd->event_loop, cmd);
+	as_event_delay_expire(cmd);
+}
+
+static void
+as_event_delay_expire(as_event_command* cmd)
+{
+	// Fail command that expired while in the delay queue. Command is already unlinked.
 	cmd->state = AS_ASYNC_STATE_QUEUE_ERROR;
 
+	cmd->event_loop->counters.total_timeouts++;
+
 	as_error err;
 	as_error_set_message(&err, AEROSPIKE_ERR_TIMEOUT, "Delay queue timeout");
 
-	// Notify user, but do not destroy command.
 	as_event_notify_error(cmd, &err);
+	as_event_command_release(cmd);
 }
 
 void
 as_event_process_timer(as_event_command* cmd)
 {
+	if (cmd->type == AS_ASYNC_TYPE_AUTO_BATCH) {
+		// Auto batch window expired.
+		as_auto_batch_expire(cmd->event_loop);
+		return;
+	}
+
 	switch (cmd->state) {
 		case AS_ASYNC_STATE_REGISTERED:
 			// Start command from the beginning.
 			as_event_command_execute_in_loop(cmd->event_loop, cmd);
 			break;
 
+		case AS_ASYNC_STATE_SLEEP:
+			// Delay expired.
+			cmd->event_state->pending--;
+			cmd->state = AS_ASYNC_STATE_REGISTERED;
+			as_event_command_execute_in_loop(cmd->event_loop, cmd);
+			break;
+
 		case AS_ASYNC_STATE_DELAY_QUEUE:
 			// Command timed out in delay queue.
 			as_event_delay_timeout(cmd);
@@ -870,8 +1656,15 @@ as_event_total_timeout(as_event_command* cmd)
 		return;
 	}
 
+	if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+		// Unlink before the executor can be destroyed by the error callback.
+		as_async_flow_remove(cmd);
+	}
+
 	// Node should not be null at this point.
 	as_event_connection_timeout(cmd, &cmd->node->async_conn_pools[cmd->event_loop->index]);
+	as_incr_uint64(&as_node_get_counters(cmd->node)->total_timeouts);
+	cmd->event_loop->counters.total_timeouts++;
 
 	as_error err;
 	as_error_update(&err, AEROSPIKE_ERR_TIMEOUT, "Client timeout: iterations=%u lastNode=%s",
@@ -882,11 +1675,23 @@ as_event_total_timeout(as_event_command* cmd)
 bool
 as_event_command_retry(as_event_command* cmd, bool timeout)
 {
+	as_cluster_incr_route_errors(cmd->cluster);
+
 	// Check max retries.
 	if (++(cmd->iteration) > cmd->max_retries) {
 		return false;
 	}
 
+	// Check cluster wide retry budget.
+	if (! as_cluster_retry_acquire(cmd->cluster)) {
+		return false;
+	}
+
+	if (cmd->node) {
+		as_incr_uint64(&as_node_get_counters(cmd->node)->retries);
+	}
+	cmd->event_loop->counters.retries++;
+
 	// Alternate between master and prole on socket errors or database reads.
 	// Timeouts are not a good indicator of impending data migration.
 	if (! timeout || ((cmd->flags & AS_ASYNC_FLAGS_READ) &&
@@ -939,7 +1744,7 @@ as_event_execute_retry(as_event_command* cmd)
 		uint64_t remaining = cmd->total_deadline - now;
 
 		if (cmd->flags & AS_ASYNC_FLAGS_USING_SOCKET_TIMER) {
-			if (remaining <= cmd->socket_timeout) {
+			if (remaining <= cmd->socket_timeout || cmd->socket_timeout == 0) {
 				// Restore total timer.
 				cmd->flags &= ~AS_ASYNC_FLAGS_USING_SOCKET_TIMER;
 				as_event_timer_once(cmd, remaining);
@@ -978,11 +1783,15 @@ as_event_put_connection(as_event_command* cmd, as_async_conn_pool* pool)
 static inline void
 as_event_response_complete(as_event_command* cmd)
 {
+	as_cluster_retry_deposit(cmd->cluster);
+
 	if (cmd->pipe_listener != NULL) {
 		as_pipe_response_complete(cmd);
 		return;
 	}
-	
+
+	as_event_latency_end(cmd, false);
+	as_event_record_latency(cmd);
 	as_event_timer_stop(cmd);
 	as_event_stop_watcher(cmd, cmd->conn);
 
@@ -1012,10 +1821,40 @@ as_event_executor_destroy(as_event_executor* executor)
 	if (executor->ns) {
 		cf_free(executor->ns);
 	}
+
+	if (executor->flow) {
+		as_async_flow_detach(executor->flow, executor);
+	}
+
+	if (executor->cancel) {
+		as_async_cancel_detach(executor->cancel, executor);
+	}
 	
 	cf_free(executor);
 }
 
+static void
+as_event_executor_finish(as_event_executor* executor)
+{
+	uint64_t begin = as_event_callback_begin(executor->event_loop);
+	executor->complete_fn(executor);
+	as_event_callback_end(executor->event_loop, "complete", begin);
+	as_event_executor_destroy(executor);
+}
+
+static void
+as_event_executor_handoff(as_event_executor* executor)
+{
+	// Commands of a spread executor complete on different event loops. Run the completion
+	// on the assigned event loop, so the listener always sees the same thread and every
+	// record callback has returned.
+	if (as_in_event_loop(executor->event_loop->thread) ||
+		! as_event_execute(executor->event_loop, (as_event_executable)as_event_executor_finish,
+			executor)) {
+		as_event_executor_finish(executor);
+	}
+}
+
 void
 as_event_executor_error(as_event_executor* executor, as_error* err, uint32_t command_count)
 {
@@ -1024,9 +1863,19 @@ as_event_executor_error(as_event_executor* executor, as_error* err, uint32_t com
 	executor->valid = false;
 	executor->count += command_count;
 	bool complete = executor->count == executor->max;
+
+	if (first_error && (executor->spread || ! complete)) {
+		// Save first error only. Save under lock, because commands of a spread executor
+		// may complete the executor on another thread.
+		executor->err = cf_malloc(sizeof(as_error));
+		as_error_copy(executor->err, err);
+	}
 	pthread_mutex_unlock(&executor->lock);
 
-	if (complete) {
+	if (complete && executor->spread) {
+		as_event_executor_handoff(executor);
+	}
+	else if (complete) {
 		// All commands have completed.
 		if (first_error) {
 			// Original error can be used directly.
@@ -1041,10 +1890,38 @@ as_event_executor_error(as_event_executor* executor, as_error* err, uint32_t com
 		as_event_executor_destroy(executor);
 	}
 	else if (first_error) {
-		// Save first error only.
+		if (executor->paused) {
+			// Commands paused by flow control must read again to see the abort.
+			as_async_flow_wakeup(executor->flow);
+		}
+	}
+}
+
+void
+as_event_executor_abort(as_event_executor* executor, as_error* err)
+{
+	// Stop running commands without completing them.  Each command ends with the saved
+	// error when it reads its next block.  Commands that were never queued will not start,
+	// so count them as complete.  Must be called in the executor's event loop.
+	pthread_mutex_lock(&executor->lock);
+	bool first_error = executor->valid;
+	executor->valid = false;
+
+	if (first_error) {
+		executor->count += executor->max - executor->queued;
 		executor->err = cf_malloc(sizeof(as_error));
 		as_error_copy(executor->err, err);
 	}
+	pthread_mutex_unlock(&executor->lock);
+
+	if (! first_error) {
+		return;
+	}
+
+	if (executor->paused) {
+		// Commands paused by flow control must read again to see the abort.
+		as_async_flow_wakeup(executor->flow);
+	}
 }
 
 void
@@ -1083,8 +1960,12 @@ as_event_executor_complete(as_event_executor* executor)
 
 	if (complete) {
 		// All commands completed.
-		executor->complete_fn(executor);
-		as_event_executor_destroy(executor);
+		if (executor->spread) {
+			as_event_executor_handoff(executor);
+		}
+		else {
+			as_event_executor_finish(executor);
+		}
 	}
 	else {
 		// Determine if a new command needs to be started.
@@ -1143,6 +2024,8 @@ bool as_async_query_should_retry(as_event_command* cmd, as_status status);
 void
 as_event_error_callback(as_event_command* cmd, as_error* err)
 {
+	as_event_trace_status(cmd, err->code);
+
 	if ((cmd->type == AS_ASYNC_TYPE_SCAN_PARTITION &&
 		as_async_scan_should_retry(cmd, err->code)) ||
 	    (cmd->type == AS_ASYNC_TYPE_QUERY_PARTITION &&
@@ -1158,11 +2041,41 @@ as_event_error_callback(as_event_command* cmd, as_error* err)
 
 void as_async_batch_error(as_event_command* cmd, as_error* err);
 
+static const char*
+as_event_type_name(uint8_t type)
+{
+	switch (type) {
+		case AS_ASYNC_TYPE_WRITE:
+			return "write";
+		case AS_ASYNC_TYPE_RECORD:
+			return "record";
+		case AS_ASYNC_TYPE_VALUE:
+			return "value";
+		case AS_ASYNC_TYPE_BATCH:
+			return "batch";
+		case AS_ASYNC_TYPE_SCAN:
+		case AS_ASYNC_TYPE_SCAN_PARTITION:
+			return "scan";
+		case AS_ASYNC_TYPE_QUERY:
+		case AS_ASYNC_TYPE_QUERY_PARTITION:
+			return "query";
+		case AS_ASYNC_TYPE_INFO:
+			return "info";
+		default:
+			return "other";
+	}
+}
+
 void
 as_event_notify_error(as_event_command* cmd, as_error* err)
 {
+	as_event_trace_status(cmd, err->code);
 	as_error_set_in_doubt(err, cmd->flags & AS_ASYNC_FLAGS_READ, cmd->command_sent_counter);
 
+	as_event_loop* event_loop = cmd->event_loop;
+	uint8_t type = cmd->type;
+	uint64_t begin = as_event_callback_begin(event_loop);
+
 	switch (cmd->type) {
 		case AS_ASYNC_TYPE_WRITE:
 			((as_async_write_command*)cmd)->listener(err, cmd->udata, cmd->event_loop);
@@ -1188,6 +2101,7 @@ as_event_notify_error(as_event_command* cmd, as_error* err)
 			as_event_executor_error(cmd->udata, err, 1);
 			break;
 	}
+	as_event_callback_end(event_loop, as_event_type_name(type), begin);
 }
 
 void
@@ -1232,6 +2146,8 @@ as_event_response_error(as_event_command* cmd, as_error* err)
 	
 	// Server sent back error.
 	// Release resources, make callback and free command.
+	as_event_latency_end(cmd, err->code == AEROSPIKE_ERR_DEVICE_OVERLOAD);
+	as_event_record_latency(cmd);
 	as_event_timer_stop(cmd);
 	as_event_stop_watcher(cmd, cmd->conn);
 	
@@ -1270,7 +2186,9 @@ as_event_command_parse_header(as_event_command* cmd)
 	
 	if (msg->result_code == AEROSPIKE_OK) {
 		as_event_response_complete(cmd);
+		uint64_t begin = as_event_callback_begin(cmd->event_loop);
 		((as_async_write_command*)cmd)->listener(0, cmd->udata, cmd->event_loop);
+		as_event_callback_end(cmd->event_loop, "write", begin);
 		as_event_command_release(cmd);
 	}
 	else {
@@ -1303,11 +2221,13 @@ as_event_command_parse_result(as_event_command* cmd)
 
 				p = as_command_ignore_fields(p, msg->n_fields);
 				status = as_command_parse_bins(&p, &err, rec, msg->n_ops,
-											   cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
+											   cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE, false);
 
 				if (status == AEROSPIKE_OK) {
 					as_event_response_complete(cmd);
+					uint64_t begin = as_event_callback_begin(cmd->event_loop);
 					((as_async_record_command*)cmd)->listener(0, rec, cmd->udata, cmd->event_loop);
+					as_event_callback_end(cmd->event_loop, "record", begin);
 					as_event_command_release(cmd);
 				}
 				else {
@@ -1331,11 +2251,13 @@ as_event_command_parse_result(as_event_command* cmd)
 				
 				p = as_command_ignore_fields(p, msg->n_fields);
 				status = as_command_parse_bins(&p, &err, &rec, msg->n_ops,
-											   cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE);
+											   cmd->flags2 & AS_ASYNC_FLAGS2_DESERIALIZE, false);
 
 				if (status == AEROSPIKE_OK) {
 					as_event_response_complete(cmd);
+					uint64_t begin = as_event_callback_begin(cmd->event_loop);
 					((as_async_record_command*)cmd)->listener(0, &rec, cmd->udata, cmd->event_loop);
+					as_event_callback_end(cmd->event_loop, "record", begin);
 					as_event_command_release(cmd);
 				}
 				else {
@@ -1353,7 +2275,8 @@ as_event_command_parse_result(as_event_command* cmd)
 		}
 			
 		default: {
-			as_error_update(&err, status, "%s %s", as_node_get_address_string(cmd->node), as_error_string(status));
+			as_error_update_status(&err, status, as_node_get_address_string(cmd->node),
+								   cmd->cluster->lazy_error_messages);
 			as_event_response_error(cmd, &err);
 			break;
 		}
@@ -1379,7 +2302,9 @@ as_event_command_parse_success_failure(as_event_command* cmd)
 			
 			if (status == AEROSPIKE_OK) {
 				as_event_response_complete(cmd);
+				uint64_t begin = as_event_callback_begin(cmd->event_loop);
 				((as_async_value_command*)cmd)->listener(0, val, cmd->udata, cmd->event_loop);
+				as_event_callback_end(cmd->event_loop, "value", begin);
 				as_event_command_release(cmd);
 				as_val_destroy(val);
 			}
@@ -1398,7 +2323,8 @@ as_event_command_parse_success_failure(as_event_command* cmd)
 			
 		default: {
 			as_error err;
-			as_error_update(&err, status, "%s %s", as_node_get_address_string(cmd->node), as_error_string(status));
+			as_error_update_status(&err, status, as_node_get_address_string(cmd->node),
+								   cmd->cluster->lazy_error_messages);
 			as_event_response_error(cmd, &err);
 			break;
 		}
@@ -1418,7 +2344,9 @@ as_event_command_parse_info(as_event_command* cmd)
 
 	if (status == AEROSPIKE_OK) {
 		as_event_response_complete(cmd);
+		uint64_t begin = as_event_callback_begin(cmd->event_loop);
 		((as_async_info_command*)cmd)->listener(NULL, response, cmd->udata, cmd->event_loop);
+		as_event_callback_end(cmd->event_loop, "info", begin);
 		as_event_command_release(cmd);
 	}
 	else {
@@ -1440,14 +2368,20 @@ as_event_command_free(as_event_command* cmd)
 	}
 
 	if (cmd->node) {
+		// Commands that end without a response count as a failed attempt.
+		as_event_latency_end(cmd, true);
+		as_event_node_bytes_release(cmd);
 		as_node_release(cmd->node);
 	}
 
 	if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-		cf_free(cmd->buf);
+		as_event_buffer_free(event_loop, cmd->buf, cmd->read_capacity);
 	}
 
-	cf_free(cmd);
+	if (cmd->trace) {
+		as_event_trace_end(cmd);
+	}
+	as_event_command_dealloc(cmd);
 
 	if (event_loop->max_commands_in_process > 0 && ! event_loop->using_delay_queue) {
 		// Try executing commands from the delay queue.
@@ -1455,6 +2389,170 @@ as_event_command_free(as_event_command* cmd)
 	}
 }
 
+/******************************************************************************
+ * TIMER WHEEL
+ *****************************************************************************/
+
+static inline as_event_command**
+as_event_wheel_head(as_event_wheel* wheel, as_event_command* cmd)
+{
+	return (cmd->wheel_slot == AS_EVENT_WHEEL_SLOTS) ? &wheel->expired : &wheel->slots[cmd->wheel_slot];
+}
+
+static inline void
+as_event_wheel_link(as_event_wheel* wheel, as_event_command* cmd, uint32_t slot)
+{
+	cmd->wheel_slot = slot;
+
+	as_event_command** head = as_event_wheel_head(wheel, cmd);
+
+	cmd->wheel_prev = NULL;
+	cmd->wheel_next = *head;
+
+	if (*head) {
+		(*head)->wheel_prev = cmd;
+	}
+	*head = cmd;
+}
+
+static inline void
+as_event_wheel_unlink(as_event_wheel* wheel, as_event_command* cmd)
+{
+	if (cmd->wheel_prev) {
+		cmd->wheel_prev->wheel_next = cmd->wheel_next;
+	}
+	else {
+		*as_event_wheel_head(wheel, cmd) = cmd->wheel_next;
+	}
+
+	if (cmd->wheel_next) {
+		cmd->wheel_next->wheel_prev = cmd->wheel_prev;
+	}
+}
+
+void
+as_event_wheel_add(as_event_wheel* wheel, as_event_command* cmd, uint64_t timeout, uint64_t repeat)
+{
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_WHEEL) {
+		as_event_wheel_unlink(wheel, cmd);
+	}
+	else {
+		wheel->size++;
+		cmd->flags2 |= AS_ASYNC_FLAGS2_WHEEL;
+	}
+
+	if (! wheel->running) {
+		// Start the driver.  The wheel only ticks while it has timers.
+		wheel->tick = cf_getms();
+		wheel->running = true;
+		as_event_lib_timer_repeat(&wheel->driver, 1);
+	}
+
+	cmd->wheel_expire = wheel->tick + timeout;
+	cmd->wheel_repeat = (uint32_t)repeat;
+	as_event_wheel_link(wheel, cmd, (uint32_t)(cmd->wheel_expire & (AS_EVENT_WHEEL_SLOTS - 1)));
+}
+
+void
+as_event_wheel_remove(as_event_wheel* wheel, as_event_command* cmd)
+{
+	as_event_wheel_unlink(wheel, cmd);
+	cmd->flags2 &= ~AS_ASYNC_FLAGS2_WHEEL;
+	wheel->size--;
+}
+
+void
+as_event_wheel_tick(as_event_wheel* wheel)
+{
+	uint64_t now = cf_getms();
+	uint64_t tick = wheel->tick;
+
+	// Visit each slot at most once if the loop fell far behind.
+	if (now - tick > AS_EVENT_WHEEL_SLOTS) {
+		tick = now - AS_EVENT_WHEEL_SLOTS;
+	}
+
+	// Move expired timers to the expired list first, so callbacks that start or stop other
+	// timers never modify a slot while it is being scanned.
+	while (tick < now) {
+		tick++;
+
+		as_event_command* cmd = wheel->slots[tick & (AS_EVENT_WHEEL_SLOTS - 1)];
+
+		while (cmd) {
+			as_event_command* next = cmd->wheel_next;
+
+			if (cmd->wheel_expire <= now) {
+				as_event_wheel_unlink(wheel, cmd);
+				as_event_wheel_link(wheel, cmd, AS_EVENT_WHEEL_SLOTS);
+			}
+			cmd = next;
+		}
+	}
+	wheel->tick = now;
+
+	as_event_command* cmd;
+
+	while ((cmd = wheel->expired)) {
+		as_event_wheel_remove(wheel, cmd);
+
+		if (cmd->wheel_repeat > 0) {
+			// Socket timers repeat until stopped.
+			as_event_wheel_add(wheel, cmd, cmd->wheel_repeat, cmd->wheel_repeat);
+			as_event_socket_timeout(cmd);
+		}
+		else {
+			as_event_process_timer(cmd);
+		}
+	}
+
+	if (wheel->size == 0 && wheel->running) {
+		wheel->running = false;
+		as_event_lib_timer_stop(&wheel->driver);
+	}
+}
+
+void
+as_event_lag_start(as_event_loop* event_loop)
+{
+	as_event_lag* lag = event_loop->lag;
+	lag->running = true;
+	lag->expected_ns = cf_getns() + (uint64_t)lag->interval_ms * 1000 * 1000;
+	as_event_lib_timer_repeat(&lag->driver, lag->interval_ms);
+}
+
+void
+as_event_lag_destroy(as_event_loop* event_loop)
+{
+	as_event_lag* lag = event_loop->lag;
+
+	if (! lag) {
+		return;
+	}
+
+	if (lag->running) {
+		as_event_lib_timer_stop(&lag->driver);
+	}
+	cf_free(lag);
+	event_loop->lag = NULL;
+}
+
+void
+as_event_wheel_destroy(as_event_loop* event_loop)
+{
+	as_event_wheel* wheel = event_loop->wheel;
+
+	if (! wheel) {
+		return;
+	}
+
+	if (wheel->running) {
+		as_event_lib_timer_stop(&wheel->driver);
+	}
+	cf_free(wheel);
+	event_loop->wheel = NULL;
+}
+
 /******************************************************************************
  * CONNECTION CREATE
  *****************************************************************************/
@@ -1532,7 +2630,9 @@ connector_error(as_event_command* cmd, as_error* err)
 	// Connection failed.  Highly unlikely other connections will succeed.
 	// Stop executing new commands. Command is released by calling function.
 	as_log_debug("Async min connection failed: %d %s", err->code, err->message);
-	connector_abort(cmd->event_loop, cmd->udata);
+	connector_shared* cs = cmd->udata;
+	cs->pool->connecting--;
+	connector_abort(cmd->event_loop, cs);
 }
 
 void
@@ -1540,6 +2640,7 @@ as_event_connector_success(as_event_command* cmd)
 {
 	as_event_loop* event_loop = cmd->event_loop;
 	connector_shared* cs = cmd->udata;
+	cs->pool->connecting--;
 
 	as_event_response_complete(cmd);
 	as_event_command_release(cmd);
@@ -1555,6 +2656,7 @@ connector_execute_command(as_event_loop* event_loop, connector_shared* cs)
 		connector_abort(event_loop, cs);
 		return;
 	}
+	cs->pool->connecting++;
 
 	as_node* node = cs->node;
 	as_node_reserve(node);
@@ -1565,7 +2667,7 @@ connector_execute_command(as_event_loop* event_loop, connector_shared* cs)
 	cluster->event_state[event_loop->index].pending++;
 
 	size_t s = (sizeof(connector_command) + AS_AUTHENTICATION_MAX_SIZE + 1023) & ~1023;
-	as_event_command* cmd = (as_event_command*)cf_malloc(s);
+	as_event_command* cmd = (as_event_command*)as_alloc_malloc(s);
 	connector_command* cc = (connector_command*)cmd;
 
 	cmd->socket_timeout = 0;
@@ -1577,6 +2679,9 @@ connector_execute_command(as_event_loop* event_loop, connector_shared* cs)
 	cmd->node = node;
 	cmd->ns = NULL;
 	cmd->partition = NULL;
+	cmd->latency_begin = 0;
+	cmd->stats_begin = 0;
+	cmd->trace = NULL;
 	cmd->udata = cs;
 	cmd->parse_results = NULL;
 	cmd->pipe_listener = NULL;
@@ -1591,6 +2696,8 @@ connector_execute_command(as_event_loop* event_loop, connector_shared* cs)
 	cmd->state = AS_ASYNC_STATE_CONNECT;
 	cmd->flags = AS_ASYNC_FLAGS_MASTER;
 	cmd->flags2 = 0;
+	cmd->priority = AS_POLICY_PRIORITY_NORMAL;
+	cmd->node_bytes = false;
 
 	cmd->total_deadline = cf_getms() + cs->timeout_ms;
 	as_event_timer_once(cmd, cs->timeout_ms);
@@ -1729,6 +2836,98 @@ create_connections(as_event_loop* event_loop, as_node* node, as_async_conn_pool*
 	connector_create_commands(event_loop, cs);
 }
 
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+
+typedef struct {
+	as_event_loop* event_loop;
+	as_node* node;
+	as_async_conn_pool* pool;
+	as_socket socket;
+	as_status status;
+} tls_connector;
+
+static void
+tls_connector_adopt(as_event_loop* event_loop, tls_connector* tc)
+{
+	as_async_conn_pool* pool = tc->pool;
+	pool->connecting--;
+
+	if (tc->status == AEROSPIKE_OK) {
+		as_async_connection* conn = cf_malloc(sizeof(as_async_connection));
+		conn->base.pipeline = false;
+		conn->cmd = NULL;
+		as_event_adopt_connection(event_loop, &conn->base, &tc->socket);
+		as_event_set_conn_last_used(&conn->base);
+		pool->opened++;
+
+		if (! as_async_conn_pool_push_head(pool, &conn->base)) {
+			as_event_release_connection(&conn->base, pool);
+		}
+	}
+	else {
+		as_queue_decr_total(&pool->queue);
+	}
+	as_node_release(tc->node);
+	cf_free(tc);
+}
+
+static void
+tls_connector_run(void* udata)
+{
+	// Runs on cluster tls_pool thread.
+	tls_connector* tc = udata;
+	as_node* node = tc->node;
+	as_error err;
+
+	uint64_t deadline_ms = as_socket_deadline(node->cluster->conn_timeout_ms);
+	tc->status = as_node_create_async_socket(&err, node, deadline_ms, &tc->socket);
+
+	if (tc->status != AEROSPIKE_OK) {
+		as_log_debug("Async TLS connection failed: %d %s", err.code, err.message);
+	}
+
+	if (! as_event_execute(tc->event_loop, (as_event_executable)tls_connector_adopt, tc)) {
+		// Event loop is closed, so its pool counters are no longer used.
+		if (tc->status == AEROSPIKE_OK) {
+			as_socket_close(&tc->socket);
+		}
+		as_node_release(node);
+		cf_free(tc);
+	}
+}
+
+static void
+create_tls_connections(as_event_loop* event_loop, as_node* node, as_async_conn_pool* pool, int count)
+{
+	as_cluster* cluster = node->cluster;
+
+	for (int i = 0; i < count; i++) {
+		if (! as_async_conn_pool_incr_total(pool)) {
+			// We are already at max connections.
+			return;
+		}
+		pool->connecting++;
+		as_node_reserve(node);
+
+		tls_connector* tc = cf_malloc(sizeof(tls_connector));
+		tc->event_loop = event_loop;
+		tc->node = node;
+		tc->pool = pool;
+
+		if (as_thread_pool_queue_task(&cluster->tls_pool, tls_connector_run, tc) != 0) {
+			// Fall back to handshakes on the event loop.
+			pool->connecting--;
+			as_queue_decr_total(&pool->queue);
+			as_node_release(node);
+			cf_free(tc);
+			create_connections(event_loop, node, pool, count - i);
+			return;
+		}
+	}
+}
+
+#endif
+
 /******************************************************************************
  * CONNECTION BALANCE
  *****************************************************************************/
@@ -1750,29 +2949,82 @@ balancer_release(balancer_shared* bs)
 static void
 close_idle_connections(as_async_conn_pool* pool, uint64_t max_socket_idle_ns, int count)
 {
+	// Connections are in last used order, so stop at the first current connection instead
+	// of popping it and pushing it back.  Large excesses are trimmed over several passes.
+	as_queue* q = &pool->queue;
+	uint32_t max = (count < AS_CONN_TRIM_MAX) ? (uint32_t)count : AS_CONN_TRIM_MAX;
 	as_event_connection* conn;
 
-	while (count > 0) {
-		if (! as_queue_pop_tail(&pool->queue, &conn)) {
-			break;
-		}
+	for (uint32_t n = 0; n < max && ! as_queue_empty(q); n++) {
+		conn = *(as_event_connection**)as_queue_get(q, (q->tail - 1) % q->capacity);
 
 		if (as_event_conn_current_trim(conn, max_socket_idle_ns)) {
-			if (! as_queue_push_limit(&pool->queue, &conn)) {
-				as_event_release_connection(conn, pool);
-			}
 			break;
 		}
+		as_queue_pop_tail(q, &conn);
 		as_event_release_connection(conn, pool);
-		count--;
 	}
 }
 
+static uint32_t
+as_event_prewarm_target(as_async_conn_pool* pool, uint32_t headroom)
+{
+	uint32_t peak = pool->peak;
+	uint32_t growth = (peak > pool->last_peak)? peak - pool->last_peak : 0;
+
+	// Cover the recent peak plus its latest growth, so a ramp finds connections ready.
+	uint32_t demand = peak + growth;
+	demand += (demand * headroom + 99) / 100;
+
+	if (demand >= pool->target) {
+		pool->target = demand;
+	}
+	else {
+		// Shrink gradually when load drops.
+		pool->target -= (pool->target - demand + 7) / 8;
+	}
+
+	if (pool->target > pool->limit) {
+		pool->target = pool->limit;
+	}
+
+	// Start next sample with connections currently in use.
+	pool->last_peak = peak;
+	pool->peak = as_async_conn_pool_in_use(pool);
+	return pool->target;
+}
+
+static inline uint32_t
+as_event_loop_share(uint32_t total, uint32_t index)
+{
+	// Distribute connections over event loops the same way as as_node_create().
+	uint32_t n = total / as_event_loop_capacity;
+	return (index < total - (n * as_event_loop_capacity))? n + 1 : n;
+}
+
 void
 as_event_balance_connections_node(as_event_loop* event_loop, as_cluster* cluster, as_node* node)
 {
 	as_async_conn_pool* pool = &node->async_conn_pools[event_loop->index];
-	int excess = pool->queue.total - pool->min_size;
+
+	// Apply limits changed by as_cluster_set_async_conns_per_node(). Connections above the
+	// new limit are closed when they are idle or returned to the pool.
+	pool->min_size = as_event_loop_share(as_load_uint32(&cluster->async_min_conns_per_node),
+		event_loop->index);
+	pool->limit = as_event_loop_share(as_load_uint32(&cluster->async_max_conns_per_node),
+		event_loop->index);
+
+	uint32_t min_size = pool->min_size;
+
+	if (cluster->async_conn_prewarm > 0) {
+		uint32_t target = as_event_prewarm_target(pool, cluster->async_conn_prewarm);
+
+		if (target > min_size) {
+			min_size = target;
+		}
+	}
+
+	int excess = pool->queue.total - min_size;
 
 	if (excess > 0) {
 		close_idle_connections(pool, cluster->max_socket_idle_ns_trim, excess);
@@ -1780,6 +3032,12 @@ as_event_balance_connections_node(as_event_loop* event_loop, as_cluster* cluster
 		// number of connections.
 	}
 	else if (excess < 0 && as_node_valid_error_count(node)) {
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+		if (cluster->tls_pool.thread_size > 0) {
+			create_tls_connections(event_loop, node, pool, -excess);
+			return;
+		}
+#endif
 		create_connections(event_loop, node, pool, -excess);
 	}
 }
@@ -1937,6 +3195,8 @@ as_event_close_cluster_cb(as_event_loop* event_loop, as_event_close_state* state
 		return;
 	}
 
+	event_state->closing = true;
+
 	if (event_state->pending > 0) {
 		// Cluster has pending commands.
 		// Check again after all other commands run.
@@ -50,6 +50,7 @@ as_event_close_loop(as_event_loop* event_loop)
 	
 	// Only stop event loop if client created event loop.
 	if (as_event_threads_created) {
+		event_loop->busy_poll_us = 0;
 		ev_unloop(event_loop->loop, EVUNLOOP_ALL);
 	}
 	
@@ -60,34 +61,29 @@ as_event_close_loop(as_event_loop* event_loop)
 static void
 as_ev_wakeup(struct ev_loop* loop, ev_async* wakeup, int revents)
 {
-	// Read command pointers from queue.
+	// Run commands queued by other threads.
 	as_event_loop* event_loop = wakeup->data;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_event_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(event_loop, cmd.udata);
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_event_close_loop(event_loop);
+		return;
+	}
+}
+
+static void
+as_ev_busy_loop(as_event_loop* event_loop, struct ev_loop* loop)
+{
+	uint64_t activity = 0;
+	uint64_t idle_begin = cf_getns();
 
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
+	// busy_poll_us is cleared when the event loop is closed.
+	while (event_loop->busy_poll_us > 0) {
+		if (as_event_busy_poll(event_loop, &activity, &idle_begin)) {
+			ev_loop(loop, EVLOOP_NONBLOCK);
 		}
 		else {
-			break;
+			ev_loop(loop, EVLOOP_ONESHOT);
+			idle_begin = cf_getns();
 		}
 	}
 }
@@ -100,7 +96,13 @@ as_ev_worker(void* udata)
 	as_thread_set_name_index("ev", event_loop->index);
 
 	struct ev_loop* loop = event_loop->loop;
-	ev_loop(loop, 0);
+
+	if (event_loop->busy_poll_us > 0) {
+		as_ev_busy_loop(event_loop, loop);
+	}
+	else {
+		ev_loop(loop, 0);
+	}
 	ev_loop_destroy(loop);
 	as_tls_thread_cleanup();
 	return NULL;
@@ -124,7 +126,7 @@ as_event_create_loop(as_event_loop* event_loop)
 	}
 	as_ev_init_loop(event_loop);
 	
-	return pthread_create(&event_loop->thread, NULL, as_ev_worker, event_loop) == 0;
+	return as_event_thread_create(event_loop, as_ev_worker, event_loop);
 }
 
 void
@@ -138,12 +140,9 @@ bool
 as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
 {
 	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
+	bool queued = as_event_queue_command(event_loop, executable, udata);
 
-	if (queued) {
+	if (queued && as_event_wakeup_needed(event_loop)) {
 		ev_async_send(event_loop->loop, &event_loop->wakeup);
 	}
 	return queued;
@@ -196,10 +195,12 @@ as_ev_watch_read(as_event_command* cmd)
 
 #define AS_EVENT_COMMAND_DONE 8
 
+#define AS_EVENT_READ_PAUSED 9
+
 static int
 as_ev_write(as_event_command* cmd)
 {
-	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
+	uint8_t* buf = as_event_write_buffer(cmd);
 
 	if (cmd->conn->socket.ctx) {
 		do {
@@ -359,6 +360,7 @@ static inline void
 as_ev_command_read_start(as_event_command* cmd)
 {
 	cmd->command_sent_counter++;
+	as_event_trace_sent(cmd);
 	cmd->len = sizeof(as_proto);
 	cmd->pos = 0;
 	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
@@ -373,7 +375,11 @@ as_ev_command_read_start(as_event_command* cmd)
 static inline void
 as_ev_command_write(as_event_command* cmd)
 {
-	as_ev_watch_write(cmd);
+	// Send non-TLS commands directly.  The socket buffer usually has room for the whole
+	// command, so write events are only watched when the write would block.
+	if (cmd->conn->socket.ctx) {
+		as_ev_watch_write(cmd);
+	}
 
 	if (as_ev_write(cmd) == AS_EVENT_WRITE_COMPLETE) {
 		// Done with write. Register for read.
@@ -463,6 +469,10 @@ as_ev_command_peek_block(as_event_command* cmd)
 		cmd->pos = 0;
 
 		if (! cmd->parse_results(cmd)) {
+			if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+				return AS_EVENT_READ_PAUSED;
+			}
+
 			// We did not finish after all. Prepare to read next header.
 			cmd->len = sizeof(as_proto);
 			cmd->pos = 0;
@@ -476,12 +486,7 @@ as_ev_command_peek_block(as_event_command* cmd)
 		// Received normal data block.  Stop reading for fairness reasons and wait
 		// till next iteration.
 		if (cmd->len > cmd->read_capacity) {
-			if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-				cf_free(cmd->buf);
-			}
-			cmd->buf = cf_malloc(size);
-			cmd->read_capacity = cmd->len;
-			cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+			as_event_command_read_buffer(cmd, size);
 		}
 	}
 
@@ -562,12 +567,7 @@ as_ev_command_read(as_event_command* cmd)
 		cmd->state = AS_ASYNC_STATE_COMMAND_READ_BODY;
 		
 		if (cmd->len > cmd->read_capacity) {
-			if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-				cf_free(cmd->buf);
-			}
-			cmd->buf = cf_malloc(size);
-			cmd->read_capacity = cmd->len;
-			cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+			as_event_command_read_buffer(cmd, size);
 		}
 	}
 	
@@ -585,6 +585,11 @@ as_ev_command_read(as_event_command* cmd)
 	}
 
 	if (! cmd->parse_results(cmd)) {
+		if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+			// Flow control stopped reading. Next block is read on resume.
+			return AS_EVENT_READ_PAUSED;
+		}
+
 		// Batch, scan, query is not finished.
 		return as_ev_command_peek_block(cmd);
 	}
@@ -689,6 +694,10 @@ as_ev_callback_common(as_event_command* cmd, as_event_connection* conn) {
 			case AS_EVENT_READ_ERROR:
 				// Do not touch cmd again because it's been deallocated.
 				return;
+
+			case AS_EVENT_READ_PAUSED:
+				// Leave data in TLS buffer until resume.
+				return;
 			
 			case AS_EVENT_READ_COMPLETE:
 				as_ev_watch_read(cmd);
@@ -756,6 +765,28 @@ as_ev_callback(struct ev_loop* loop, ev_io* watcher, int revents)
 	}
 }
 
+bool
+as_event_command_read_pause(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+
+	if (conn->pipeline) {
+		return false;
+	}
+
+	ev_io_stop(cmd->event_loop->loop, &conn->watcher);
+	conn->watching = 0;
+	return true;
+}
+
+void
+as_event_command_read_resume(as_event_command* cmd)
+{
+	// Read directly instead of waiting for a read event, because TLS may already hold
+	// decrypted data that will not trigger another event.
+	as_ev_callback_common(cmd, cmd->conn);
+}
+
 static void
 as_ev_watcher_init(as_event_command* cmd, as_socket* sock)
 {
@@ -775,6 +806,16 @@ as_ev_watcher_init(as_event_command* cmd, as_socket* sock)
 	ev_io_start(cmd->event_loop->loop, &conn->watcher);
 }
 
+void
+as_event_adopt_connection(as_event_loop* event_loop, as_event_connection* conn, as_socket* sock)
+{
+	memcpy(&conn->socket, sock, sizeof(as_socket));
+	conn->watching = 0;
+
+	ev_io_init(&conn->watcher, as_ev_callback, conn->socket.fd, EV_WRITE);
+	conn->watcher.data = conn;
+}
+
 static int
 as_ev_try_connections(int fd, as_address* addresses, socklen_t size, int i, int max)
 {
@@ -797,6 +838,7 @@ as_ev_try_family_connections(as_event_command* cmd, int family, int begin, int e
 	if (rv < 0) {
 		return rv;
 	}
+	as_event_set_busy_poll(cmd->event_loop, fd);
 
 	if (cmd->pipe_listener && ! as_pipe_modify_fd(fd)) {
 		return -1000;
@@ -845,6 +887,7 @@ as_ev_connect_error(as_event_command* cmd, as_address* primary, int rv)
 	cf_free(cmd->conn);
 	as_event_decr_conn(cmd);
 	cmd->event_loop->errors++;
+	as_node_set_suspect(cmd->node);
 
 	if (as_event_command_retry(cmd, false)) {
 		return;
@@ -63,6 +63,7 @@ as_event_close_loop(as_event_loop* event_loop)
 
 	// Only stop event loop if client created event loop.
 	if (as_event_threads_created) {
+		event_loop->busy_poll_us = 0;
 		event_base_loopbreak(event_loop->loop);
 	}
 	
@@ -73,36 +74,35 @@ as_event_close_loop(as_event_loop* event_loop)
 static void
 as_event_wakeup(evutil_socket_t socket, short revents, void* udata)
 {
-	// Read command pointers from queue.
+	// Run commands queued by other threads.
 	as_event_loop* event_loop = udata;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_event_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(event_loop, cmd.udata);
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_event_close_loop(event_loop);
+		return;
+	}
+}
+
+static int
+as_event_busy_loop(as_event_loop* event_loop, struct event_base* loop)
+{
+	uint64_t activity = 0;
+	uint64_t idle_begin = cf_getns();
+
+	// busy_poll_us is cleared when the event loop is closed.
+	while (event_loop->busy_poll_us > 0) {
+		int flags = as_event_busy_poll(event_loop, &activity, &idle_begin) ?
+			EVLOOP_NONBLOCK : EVLOOP_ONCE;
 
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
+		if (event_base_loop(loop, flags) < 0) {
+			return -1;
 		}
-		else {
-			break;
+
+		if (flags == EVLOOP_ONCE) {
+			idle_begin = cf_getns();
 		}
 	}
+	return 0;
 }
 
 static void*
@@ -124,12 +124,18 @@ as_event_worker(void* udata)
 	as_thread_set_name_index("event", event_loop->index);
 
 	struct event_base* loop = event_loop->loop;
+	int status;
 
+	if (event_loop->busy_poll_us > 0) {
+		status = as_event_busy_loop(event_loop, loop);
+	}
+	else {
 #if LIBEVENT_VERSION_NUMBER < 0x02010000
-	int status = event_base_dispatch(loop);
+		status = event_base_dispatch(loop);
 #else
-	int status = event_base_loop(loop, EVLOOP_NO_EXIT_ON_EMPTY);
+		status = event_base_loop(loop, EVLOOP_NO_EXIT_ON_EMPTY);
 #endif
+	}
 
 	if (status) {
 		as_log_error("event_base_dispatch failed: %d", status);
@@ -192,7 +198,7 @@ as_event_create_loop(as_event_loop* event_loop)
 
 	as_event_init_loop(event_loop);
 
-	return pthread_create(&event_loop->thread, NULL, as_event_worker, event_loop) == 0;
+	return as_event_thread_create(event_loop, as_event_worker, event_loop);
 }
 
 void
@@ -212,12 +218,9 @@ as_event_execute(as_event_loop* event_loop, as_event_executable executable, void
 	}
 
 	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
+	bool queued = as_event_queue_command(event_loop, executable, udata);
 
-	if (queued) {
+	if (queued && as_event_wakeup_needed(event_loop)) {
 		if (! evtimer_pending(&event_loop->wakeup, NULL)) {
 			event_del(&event_loop->wakeup);
 			evtimer_add(&event_loop->wakeup, &as_immediate_tv);
@@ -272,10 +275,12 @@ as_event_watch_read(as_event_command* cmd)
 
 #define AS_EVENT_COMMAND_DONE 8
 
+#define AS_EVENT_READ_PAUSED 9
+
 static int
 as_event_write(as_event_command* cmd)
 {
-	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
+	uint8_t* buf = as_event_write_buffer(cmd);
 
 	if (cmd->conn->socket.ctx) {
 		do {
@@ -439,6 +444,7 @@ static inline void
 as_event_command_read_start(as_event_command* cmd)
 {
 	cmd->command_sent_counter++;
+	as_event_trace_sent(cmd);
 	cmd->len = sizeof(as_proto);
 	cmd->pos = 0;
 	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
@@ -453,7 +459,11 @@ as_event_command_read_start(as_event_command* cmd)
 static inline void
 as_event_command_write(as_event_command* cmd)
 {
-	as_event_watch_write(cmd);
+	// Send non-TLS commands directly.  The socket buffer usually has room for the whole
+	// command, so write events are only watched when the write would block.
+	if (cmd->conn->socket.ctx) {
+		as_event_watch_write(cmd);
+	}
 
 	if (as_event_write(cmd) == AS_EVENT_WRITE_COMPLETE) {
 		// Done with write. Register for read.
@@ -543,6 +553,10 @@ as_event_command_peek_block(as_event_command* cmd)
 		cmd->pos = 0;
 
 		if (! cmd->parse_results(cmd)) {
+			if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+				return AS_EVENT_READ_PAUSED;
+			}
+
 			// We did not finish after all. Prepare to read next header.
 			cmd->len = sizeof(as_proto);
 			cmd->pos = 0;
@@ -556,12 +570,7 @@ as_event_command_peek_block(as_event_command* cmd)
 		// Received normal data block.  Stop reading for fairness reasons and wait
 		// till next iteration.
 		if (cmd->len > cmd->read_capacity) {
-			if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-				cf_free(cmd->buf);
-			}
-			cmd->buf = cf_malloc(size);
-			cmd->read_capacity = cmd->len;
-			cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+			as_event_command_read_buffer(cmd, size);
 		}
 	}
 
@@ -642,12 +651,7 @@ as_event_command_read(as_event_command* cmd)
 		cmd->state = AS_ASYNC_STATE_COMMAND_READ_BODY;
 		
 		if (cmd->len > cmd->read_capacity) {
-			if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-				cf_free(cmd->buf);
-			}
-			cmd->buf = cf_malloc(size);
-			cmd->read_capacity = cmd->len;
-			cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+			as_event_command_read_buffer(cmd, size);
 		}
 	}
 	
@@ -665,6 +669,11 @@ as_event_command_read(as_event_command* cmd)
 	}
 
 	if (! cmd->parse_results(cmd)) {
+		if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+			// Flow control stopped reading. Next block is read on resume.
+			return AS_EVENT_READ_PAUSED;
+		}
+
 		// Batch, scan, query is not finished.
 		return as_event_command_peek_block(cmd);
 	}
@@ -769,6 +778,10 @@ as_event_callback_common(as_event_command* cmd, as_event_connection* conn) {
 			case AS_EVENT_READ_ERROR:
 				// Do not touch cmd again because it's been deallocated.
 				return;
+
+			case AS_EVENT_READ_PAUSED:
+				// Leave data in TLS buffer until resume.
+				return;
 			
 			case AS_EVENT_READ_COMPLETE:
 				as_event_watch_read(cmd);
@@ -833,6 +846,28 @@ as_event_callback(evutil_socket_t sock, short revents, void* udata)
 	}
 }
 
+bool
+as_event_command_read_pause(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+
+	if (conn->pipeline) {
+		return false;
+	}
+
+	event_del(&conn->watcher);
+	conn->watching = 0;
+	return true;
+}
+
+void
+as_event_command_read_resume(as_event_command* cmd)
+{
+	// Read directly instead of waiting for a read event, because TLS may already hold
+	// decrypted data that will not trigger another event.
+	as_event_callback_common(cmd, cmd->conn);
+}
+
 static void
 as_event_watcher_init(as_event_command* cmd, as_socket* sock)
 {
@@ -854,6 +889,16 @@ as_event_watcher_init(as_event_command* cmd, as_socket* sock)
 	}
 }
 
+void
+as_event_adopt_connection(as_event_loop* event_loop, as_event_connection* conn, as_socket* sock)
+{
+	memcpy(&conn->socket, sock, sizeof(as_socket));
+	conn->watching = 0;
+
+	// Assign watcher, so the first as_event_watch() can safely delete it.
+	event_assign(&conn->watcher, event_loop->loop, conn->socket.fd, EV_WRITE | EV_PERSIST, as_event_callback, conn);
+}
+
 static int
 as_event_try_connections(as_socket_fd fd, as_address* addresses, socklen_t size, int i, int max)
 {
@@ -876,6 +921,7 @@ as_event_try_family_connections(as_event_command* cmd, int family, int begin, in
 	if (rv < 0) {
 		return rv;
 	}
+	as_event_set_busy_poll(cmd->event_loop, fd);
 
 	if (cmd->pipe_listener && ! as_pipe_modify_fd(fd)) {
 		return -1000;
@@ -924,6 +970,7 @@ as_event_connect_error(as_event_command* cmd, as_address* primary, int rv)
 	cf_free(cmd->conn);
 	as_event_decr_conn(cmd);
 	cmd->event_loop->errors++;
+	as_node_set_suspect(cmd->node);
 
 	if (as_event_command_retry(cmd, false)) {
 		return;
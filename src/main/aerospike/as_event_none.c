@@ -45,6 +45,17 @@ as_event_command_write_start(as_event_command* cmd)
 {
 }
 
+bool
+as_event_command_read_pause(as_event_command* cmd)
+{
+	return false;
+}
+
+void
+as_event_command_read_resume(as_event_command* cmd)
+{
+}
+
 void
 as_event_connect(as_event_command* cmd, as_async_conn_pool* pool)
 {
@@ -0,0 +1,1421 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_event.h>
+#include <aerospike/as_event_internal.h>
+#include <aerospike/as_admin.h>
+#include <aerospike/as_async.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_pipe.h>
+#include <aerospike/as_proto.h>
+#include <aerospike/as_socket.h>
+#include <aerospike/as_status.h>
+#include <aerospike/as_thread.h>
+#include <aerospike/as_tls.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+extern bool as_event_threads_created;
+extern uint32_t as_event_loop_capacity;
+
+/******************************************************************************
+ * LIBURING FUNCTIONS
+ *****************************************************************************/
+
+#if defined(AS_USE_LIBURING)
+
+#include <liburing.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+// Submission queue size. Submissions are flushed once per loop iteration or when full.
+#define AS_URING_ENTRIES 1024
+
+// Provided receive buffers shared by all plain connections on a loop.
+#define AS_URING_BUF_COUNT 256
+#define AS_URING_BUF_SIZE (16 * 1024)
+#define AS_URING_BUF_GROUP 0
+
+// Fixed file table size.  Connections beyond this count use their raw fd.
+#define AS_URING_FILES 4096
+
+#define AS_URING_TIMER_NONE 0xFFFFFFFF
+
+// Operation type is stored in the low bits of the (8 byte aligned) user_data pointer.
+#define AS_URING_OP_NONE 0
+#define AS_URING_OP_WAKEUP 1
+#define AS_URING_OP_RECV 2
+#define AS_URING_OP_SEND 3
+#define AS_URING_OP_POLL 4
+#define AS_URING_OP_POLL_READ 5
+#define AS_URING_OP_MASK 7
+
+#define AS_URING_READ_CONTINUE 0
+#define AS_URING_READ_DONE 1
+
+typedef struct as_uring_loop_s {
+	struct io_uring ring;
+	struct io_uring_buf_ring* buf_ring;
+	uint8_t* bufs;
+	as_uring_timer** timers;
+	uint32_t timers_size;
+	uint32_t timers_capacity;
+	int* files;
+	uint32_t files_size;
+	uint64_t wakeup_value;
+	bool stop;
+} as_uring_loop;
+
+/******************************************************************************
+ * TIMERS
+ *****************************************************************************/
+
+static inline void
+as_uring_timer_set(as_uring_loop* ul, uint32_t i, as_uring_timer* t)
+{
+	ul->timers[i] = t;
+	t->index = i;
+}
+
+static void
+as_uring_timer_up(as_uring_loop* ul, uint32_t i)
+{
+	as_uring_timer* t = ul->timers[i];
+
+	while (i > 0) {
+		uint32_t parent = (i - 1) / 2;
+
+		if (ul->timers[parent]->deadline <= t->deadline) {
+			break;
+		}
+		as_uring_timer_set(ul, i, ul->timers[parent]);
+		i = parent;
+	}
+	as_uring_timer_set(ul, i, t);
+}
+
+static void
+as_uring_timer_down(as_uring_loop* ul, uint32_t i)
+{
+	as_uring_timer* t = ul->timers[i];
+
+	while (true) {
+		uint32_t child = i * 2 + 1;
+
+		if (child >= ul->timers_size) {
+			break;
+		}
+
+		if (child + 1 < ul->timers_size &&
+			ul->timers[child + 1]->deadline < ul->timers[child]->deadline) {
+			child++;
+		}
+
+		if (t->deadline <= ul->timers[child]->deadline) {
+			break;
+		}
+		as_uring_timer_set(ul, i, ul->timers[child]);
+		i = child;
+	}
+	as_uring_timer_set(ul, i, t);
+}
+
+static void
+as_uring_timer_insert(as_uring_loop* ul, as_uring_timer* t)
+{
+	if (ul->timers_size == ul->timers_capacity) {
+		ul->timers_capacity = ul->timers_capacity ? ul->timers_capacity * 2 : 256;
+		ul->timers = cf_realloc(ul->timers, sizeof(as_uring_timer*) * ul->timers_capacity);
+	}
+	ul->timers[ul->timers_size] = t;
+	as_uring_timer_up(ul, ul->timers_size++);
+}
+
+static void
+as_uring_timer_remove(as_uring_loop* ul, as_uring_timer* t)
+{
+	uint32_t i = t->index;
+	uint32_t last = --ul->timers_size;
+
+	if (i != last) {
+		as_uring_timer_set(ul, i, ul->timers[last]);
+		as_uring_timer_down(ul, i);
+		as_uring_timer_up(ul, ul->timers[i]->index);
+	}
+	t->index = AS_URING_TIMER_NONE;
+}
+
+void
+as_uring_timer_start(as_event_command* cmd, uint64_t timeout, uint64_t repeat)
+{
+	as_uring_loop* ul = cmd->event_loop->loop;
+	as_uring_timer* t = &cmd->timer;
+
+	if (! (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
+		t->index = AS_URING_TIMER_NONE;
+	}
+	else if (t->index != AS_URING_TIMER_NONE) {
+		as_uring_timer_remove(ul, t);
+	}
+
+	t->deadline = cf_getms() + timeout;
+	t->repeat = repeat;
+	as_uring_timer_insert(ul, t);
+}
+
+void
+as_uring_timer_stop(as_event_command* cmd)
+{
+	as_uring_timer* t = &cmd->timer;
+
+	if (t->index != AS_URING_TIMER_NONE) {
+		as_uring_timer_remove(cmd->event_loop->loop, t);
+	}
+}
+
+static void
+as_uring_process_timers(as_uring_loop* ul)
+{
+	uint64_t now = cf_getms();
+
+	while (ul->timers_size > 0 && ul->timers[0]->deadline <= now) {
+		as_uring_timer* t = ul->timers[0];
+		as_event_command* cmd = (as_event_command*)((uint8_t*)t - offsetof(as_event_command, timer));
+
+		as_uring_timer_remove(ul, t);
+
+		if (t->repeat > 0) {
+			// Socket timers repeat until stopped.
+			t->deadline = now + t->repeat;
+			as_uring_timer_insert(ul, t);
+			as_event_socket_timeout(cmd);
+		}
+		else {
+			as_event_process_timer(cmd);
+		}
+	}
+}
+
+/******************************************************************************
+ * SUBMISSIONS
+ *****************************************************************************/
+
+static inline struct io_uring_sqe*
+as_uring_get_sqe(as_uring_loop* ul)
+{
+	struct io_uring_sqe* sqe = io_uring_get_sqe(&ul->ring);
+
+	while (! sqe) {
+		// Submission queue is full. Flush it now instead of waiting for next loop iteration.
+		io_uring_submit(&ul->ring);
+		sqe = io_uring_get_sqe(&ul->ring);
+	}
+	return sqe;
+}
+
+static inline uint64_t
+as_uring_data(void* ptr, uint32_t op)
+{
+	return (uint64_t)(uintptr_t)ptr | op;
+}
+
+static inline void
+as_uring_conn_sqe(struct io_uring_sqe* sqe, as_event_connection* conn, uint32_t op)
+{
+	if (conn->fixed >= 0 && op != AS_URING_OP_POLL && op != AS_URING_OP_POLL_READ) {
+		sqe->flags |= IOSQE_FIXED_FILE;
+	}
+	io_uring_sqe_set_data64(sqe, as_uring_data(conn, op));
+	conn->inflight++;
+}
+
+static inline int
+as_uring_fd(as_event_connection* conn)
+{
+	return conn->fixed >= 0 ? conn->fixed : conn->socket.fd;
+}
+
+static inline void
+as_uring_conn_release(as_event_connection* conn)
+{
+	// Connection memory is freed only after its last operation completes.
+	if (--conn->inflight == 0 && conn->closed) {
+		cf_free(conn);
+	}
+}
+
+static void
+as_uring_cancel(as_uring_loop* ul, as_event_connection* conn, uint32_t op)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(ul);
+	io_uring_prep_cancel64(sqe, as_uring_data(conn, op), IORING_ASYNC_CANCEL_ALL);
+	io_uring_sqe_set_data64(sqe, AS_URING_OP_NONE);
+}
+
+static void
+as_uring_poll(as_event_connection* conn, uint32_t mask)
+{
+	as_uring_loop* ul = conn->event_loop->loop;
+	struct io_uring_sqe* sqe = as_uring_get_sqe(ul);
+	io_uring_prep_poll_add(sqe, conn->socket.fd, mask);
+	as_uring_conn_sqe(sqe, conn, AS_URING_OP_POLL);
+	conn->polls++;
+}
+
+static void
+as_uring_arm_read(as_event_connection* conn)
+{
+	as_uring_loop* ul = conn->event_loop->loop;
+	struct io_uring_sqe* sqe = as_uring_get_sqe(ul);
+
+	if (conn->socket.ctx) {
+		// TLS library reads the socket itself, so only wait for readiness.
+		io_uring_prep_poll_multishot(sqe, conn->socket.fd, POLLIN);
+		as_uring_conn_sqe(sqe, conn, AS_URING_OP_POLL_READ);
+	}
+	else {
+		// Kernel picks a buffer from the loop's ring for each received chunk, which avoids
+		// a separate readiness wait and read call per response.
+		io_uring_prep_recv_multishot(sqe, as_uring_fd(conn), NULL, 0, 0);
+		sqe->flags |= IOSQE_BUFFER_SELECT;
+		sqe->buf_group = AS_URING_BUF_GROUP;
+		as_uring_conn_sqe(sqe, conn, AS_URING_OP_RECV);
+	}
+	conn->recv_armed = true;
+}
+
+static void
+as_uring_register_file(as_uring_loop* ul, as_event_connection* conn)
+{
+	if (ul->files_size == 0) {
+		return;
+	}
+
+	int index = ul->files[ul->files_size - 1];
+
+	if (io_uring_register_files_update(&ul->ring, index, &conn->socket.fd, 1) == 1) {
+		ul->files_size--;
+		conn->fixed = index;
+	}
+}
+
+void
+as_event_close_connection(as_event_connection* conn)
+{
+	as_uring_loop* ul = conn->event_loop->loop;
+
+	if (conn->inflight > 0) {
+		if (conn->recv_armed) {
+			as_uring_cancel(ul, conn, conn->socket.ctx ? AS_URING_OP_POLL_READ : AS_URING_OP_RECV);
+		}
+
+		if (conn->polls > 0) {
+			as_uring_cancel(ul, conn, AS_URING_OP_POLL);
+		}
+
+		if (conn->sender) {
+			as_uring_cancel(ul, conn, AS_URING_OP_SEND);
+		}
+	}
+
+	if (conn->fixed >= 0) {
+		// In-flight requests hold their own file reference, so the slot can be reused now.
+		int fd = -1;
+		io_uring_register_files_update(&ul->ring, conn->fixed, &fd, 1);
+		ul->files[ul->files_size++] = conn->fixed;
+		conn->fixed = -1;
+	}
+
+	as_socket_close(&conn->socket);
+	conn->closed = true;
+
+	if (conn->inflight == 0) {
+		cf_free(conn);
+	}
+}
+
+void
+as_event_command_release(as_event_command* cmd)
+{
+	as_event_timer_stop(cmd);
+
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_SENDING) {
+		// Kernel still references the command's write buffer. Free on send completion.
+		cmd->flags2 |= AS_ASYNC_FLAGS2_RELEASE;
+		return;
+	}
+	as_event_command_free(cmd);
+}
+
+/******************************************************************************
+ * EVENT LOOP
+ *****************************************************************************/
+
+static void
+as_uring_arm_wakeup(as_event_loop* event_loop)
+{
+	as_uring_loop* ul = event_loop->loop;
+	struct io_uring_sqe* sqe = as_uring_get_sqe(ul);
+	io_uring_prep_read(sqe, event_loop->wakeup, &ul->wakeup_value, sizeof(uint64_t), 0);
+	io_uring_sqe_set_data64(sqe, as_uring_data(event_loop, AS_URING_OP_WAKEUP));
+}
+
+static void
+as_uring_loop_destroy(as_uring_loop* ul)
+{
+	if (ul->buf_ring) {
+		io_uring_free_buf_ring(&ul->ring, ul->buf_ring, AS_URING_BUF_COUNT, AS_URING_BUF_GROUP);
+	}
+	io_uring_queue_exit(&ul->ring);
+	cf_free(ul->bufs);
+	cf_free(ul->timers);
+	cf_free(ul->files);
+	cf_free(ul);
+}
+
+static as_uring_loop*
+as_uring_loop_create(uint32_t busy_poll_us)
+{
+	as_uring_loop* ul = cf_malloc(sizeof(as_uring_loop));
+	memset(ul, 0, sizeof(as_uring_loop));
+
+	int rv = -EINVAL;
+
+	if (busy_poll_us > 0) {
+		// Let a kernel thread poll the submission queue, so submits do not need a system
+		// call while the loop is spinning.
+		struct io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = busy_poll_us >= 2000 ? busy_poll_us / 1000 : 1;
+		rv = io_uring_queue_init_params(AS_URING_ENTRIES, &ul->ring, &params);
+
+		if (rv < 0) {
+			as_log_info("io_uring SQPOLL not available: %d", rv);
+		}
+	}
+
+	if (rv < 0) {
+		rv = io_uring_queue_init(AS_URING_ENTRIES, &ul->ring, IORING_SETUP_COOP_TASKRUN);
+	}
+
+	if (rv == -EINVAL) {
+		// Kernel predates cooperative task running.
+		rv = io_uring_queue_init(AS_URING_ENTRIES, &ul->ring, 0);
+	}
+
+	if (rv < 0) {
+		as_log_error("io_uring_queue_init failed: %d", rv);
+		cf_free(ul);
+		return NULL;
+	}
+
+	ul->buf_ring = io_uring_setup_buf_ring(&ul->ring, AS_URING_BUF_COUNT, AS_URING_BUF_GROUP, 0,
+										   &rv);
+
+	if (! ul->buf_ring) {
+		as_log_error("io_uring provided buffer ring not supported: %d", rv);
+		as_uring_loop_destroy(ul);
+		return NULL;
+	}
+
+	ul->bufs = cf_malloc((size_t)AS_URING_BUF_COUNT * AS_URING_BUF_SIZE);
+	int mask = io_uring_buf_ring_mask(AS_URING_BUF_COUNT);
+
+	for (uint32_t i = 0; i < AS_URING_BUF_COUNT; i++) {
+		io_uring_buf_ring_add(ul->buf_ring, ul->bufs + (size_t)i * AS_URING_BUF_SIZE,
+							  AS_URING_BUF_SIZE, i, mask, i);
+	}
+	io_uring_buf_ring_advance(ul->buf_ring, AS_URING_BUF_COUNT);
+
+	if (io_uring_register_files_sparse(&ul->ring, AS_URING_FILES) == 0) {
+		ul->files = cf_malloc(sizeof(int) * AS_URING_FILES);
+
+		// Pop lowest indexes first.
+		for (uint32_t i = 0; i < AS_URING_FILES; i++) {
+			ul->files[i] = AS_URING_FILES - 1 - i;
+		}
+		ul->files_size = AS_URING_FILES;
+	}
+	else {
+		as_log_info("io_uring fixed files not supported. Using raw socket descriptors.");
+	}
+	return ul;
+}
+
+void
+as_event_close_loop(as_event_loop* event_loop)
+{
+	event_loop->loop->stop = true;
+
+	// Cleanup event loop resources.
+	as_event_loop_destroy(event_loop);
+}
+
+static void
+as_uring_wakeup(as_event_loop* event_loop)
+{
+	// Run commands queued by other threads.
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_event_close_loop(event_loop);
+		return;
+	}
+	as_uring_arm_wakeup(event_loop);
+}
+
+static void as_uring_recv(as_uring_loop* ul, as_event_connection* conn, int32_t res, uint32_t flags);
+static void as_uring_send_complete(as_event_connection* conn, int32_t res);
+static void as_uring_poll_complete(as_event_connection* conn);
+static void as_uring_poll_read(as_event_connection* conn, uint32_t flags);
+
+static void
+as_uring_process_cqes(as_uring_loop* ul)
+{
+	struct io_uring_cqe* cqe;
+
+	while (! ul->stop && io_uring_peek_cqe(&ul->ring, &cqe) == 0) {
+		uint64_t data = cqe->user_data;
+		int32_t res = cqe->res;
+		uint32_t flags = cqe->flags;
+		void* ptr = (void*)(uintptr_t)(data & ~(uint64_t)AS_URING_OP_MASK);
+
+		io_uring_cqe_seen(&ul->ring, cqe);
+
+		switch (data & AS_URING_OP_MASK) {
+			case AS_URING_OP_WAKEUP:
+				as_uring_wakeup(ptr);
+				break;
+
+			case AS_URING_OP_RECV:
+				as_uring_recv(ul, ptr, res, flags);
+				break;
+
+			case AS_URING_OP_SEND:
+				as_uring_send_complete(ptr, res);
+				break;
+
+			case AS_URING_OP_POLL:
+				as_uring_poll_complete(ptr);
+				break;
+
+			case AS_URING_OP_POLL_READ:
+				as_uring_poll_read(ptr, flags);
+				break;
+
+			default:
+				// Cancel completions are ignored.
+				break;
+		}
+	}
+}
+
+static void*
+as_uring_worker(void* udata)
+{
+	as_event_loop* event_loop = udata;
+	as_uring_loop* ul = event_loop->loop;
+
+	as_thread_set_name_index("uring", event_loop->index);
+	as_uring_arm_wakeup(event_loop);
+
+	uint64_t activity = 0;
+	uint64_t idle_begin = cf_getns();
+
+	while (! ul->stop) {
+		if (event_loop->busy_poll_us > 0 &&
+			as_event_busy_poll(event_loop, &activity, &idle_begin)) {
+			// Recent activity. Submit without waiting and reap whatever has completed.
+			io_uring_submit(&ul->ring);
+			as_uring_process_cqes(ul);
+
+			if (! ul->stop) {
+				as_uring_process_timers(ul);
+			}
+			continue;
+		}
+
+		struct __kernel_timespec ts;
+		struct __kernel_timespec* pts = NULL;
+
+		if (ul->timers_size > 0) {
+			uint64_t now = cf_getms();
+			uint64_t deadline = ul->timers[0]->deadline;
+			uint64_t ms = deadline > now ? deadline - now : 0;
+
+			ts.tv_sec = ms / 1000;
+			ts.tv_nsec = (ms % 1000) * 1000 * 1000;
+			pts = &ts;
+		}
+
+		// Submit all operations queued during the previous iteration and wait for
+		// completions in a single system call.
+		struct io_uring_cqe* cqe;
+		io_uring_submit_and_wait_timeout(&ul->ring, &cqe, 1, pts, NULL);
+
+		as_uring_process_cqes(ul);
+
+		if (! ul->stop) {
+			as_uring_process_timers(ul);
+		}
+		idle_begin = cf_getns();
+	}
+
+	close(event_loop->wakeup);
+	as_uring_loop_destroy(ul);
+	as_tls_thread_cleanup();
+	return NULL;
+}
+
+bool
+as_event_create_loop(as_event_loop* event_loop)
+{
+	as_uring_loop* ul = as_uring_loop_create(event_loop->busy_poll_us);
+
+	if (! ul) {
+		return false;
+	}
+
+	event_loop->wakeup = eventfd(0, EFD_CLOEXEC);
+
+	if (event_loop->wakeup < 0) {
+		as_uring_loop_destroy(ul);
+		return false;
+	}
+	event_loop->loop = ul;
+
+	return as_event_thread_create(event_loop, as_uring_worker, event_loop);
+}
+
+void
+as_event_register_external_loop(as_event_loop* event_loop)
+{
+	// The client must own the ring to submit and reap operations.
+	as_log_error("External event loops are not supported with io_uring");
+}
+
+bool
+as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+{
+	// Send command through queue so it can be executed in event loop thread.
+	bool queued = as_event_queue_command(event_loop, executable, udata);
+
+	if (queued && as_event_wakeup_needed(event_loop)) {
+		eventfd_write(event_loop->wakeup, 1);
+	}
+	return queued;
+}
+
+/******************************************************************************
+ * COMMAND STATE MACHINE
+ *****************************************************************************/
+
+static as_event_command*
+as_uring_command(as_event_connection* conn)
+{
+	if (conn->pipeline) {
+		as_pipe_connection* pipe = (as_pipe_connection*)conn;
+
+		if (pipe->writer) {
+			return pipe->writer;
+		}
+
+		cf_ll_element* link = cf_ll_get_head(&pipe->readers);
+		return link ? as_pipe_link_to_command(link) : NULL;
+	}
+	return conn->watching ? ((as_async_connection*)conn)->cmd : NULL;
+}
+
+static as_event_command*
+as_uring_reader(as_event_connection* conn)
+{
+	as_event_command* cmd;
+
+	if (conn->pipeline) {
+		as_pipe_connection* pipe = (as_pipe_connection*)conn;
+
+		if (pipe->writer && cf_ll_size(&pipe->readers) == 0) {
+			// Authentication response will only have a writer.
+			cmd = pipe->writer;
+		}
+		else {
+			// Next response is at head of reader linked list.
+			cf_ll_element* link = cf_ll_get_head(&pipe->readers);
+
+			if (! link) {
+				return NULL;
+			}
+			cmd = as_pipe_link_to_command(link);
+		}
+	}
+	else {
+		if (! conn->watching) {
+			return NULL;
+		}
+		cmd = ((as_async_connection*)conn)->cmd;
+	}
+
+	switch (cmd->state) {
+		case AS_ASYNC_STATE_AUTH_READ_HEADER:
+		case AS_ASYNC_STATE_AUTH_READ_BODY:
+		case AS_ASYNC_STATE_COMMAND_READ_HEADER:
+		case AS_ASYNC_STATE_COMMAND_READ_BODY:
+			return cmd;
+
+		default:
+			return NULL;
+	}
+}
+
+static void
+as_uring_write_complete(as_event_command* cmd)
+{
+	// Socket timeout applies only to read events.
+	// Reset event received because we are switching from a write to a read state.
+	cmd->flags &= ~AS_ASYNC_FLAGS_EVENT_RECEIVED;
+
+	if (cmd->state == AS_ASYNC_STATE_AUTH_WRITE) {
+		as_event_set_auth_read_header(cmd);
+		return;
+	}
+
+	// Receive is already armed, so response data is delivered as soon as it arrives.
+	cmd->command_sent_counter++;
+	as_event_trace_sent(cmd);
+	cmd->len = sizeof(as_proto);
+	cmd->pos = 0;
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+
+	if (cmd->pipe_listener != NULL) {
+		as_pipe_read_start(cmd);
+	}
+}
+
+static void
+as_uring_tls_write(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+	uint8_t* buf = as_event_write_buffer(cmd);
+
+	while (cmd->pos < cmd->len) {
+		int rv = as_tls_write_once(&conn->socket, buf + cmd->pos, cmd->len - cmd->pos);
+
+		if (rv > 0) {
+			cmd->pos += rv;
+			continue;
+		}
+
+		if (rv == -1) {
+			// TLS sometimes need to read even when we are writing.
+			as_uring_poll(conn, POLLIN);
+			return;
+		}
+
+		if (rv == -2) {
+			as_uring_poll(conn, POLLOUT);
+			return;
+		}
+
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_socket_error(conn->socket.fd, cmd->node, &err, AEROSPIKE_ERR_TLS_ERROR, "TLS write failed", rv);
+			as_event_socket_error(cmd, &err);
+		}
+		return;
+	}
+	as_uring_write_complete(cmd);
+}
+
+static void
+as_uring_write(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+
+	if (conn->socket.ctx) {
+		as_uring_tls_write(cmd);
+		return;
+	}
+
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_SENDING) {
+		// Send on the connection this command was retried from is still in flight.
+		// Write will start when that send completes.
+		cmd->flags2 |= AS_ASYNC_FLAGS2_WRITE_PENDING;
+		return;
+	}
+
+	uint8_t* buf = as_event_write_buffer(cmd);
+	as_uring_loop* ul = cmd->event_loop->loop;
+	struct io_uring_sqe* sqe = as_uring_get_sqe(ul);
+
+	io_uring_prep_send(sqe, as_uring_fd(conn), buf + cmd->pos, cmd->len - cmd->pos, MSG_NOSIGNAL);
+	as_uring_conn_sqe(sqe, conn, AS_URING_OP_SEND);
+	conn->sender = cmd;
+	cmd->flags2 |= AS_ASYNC_FLAGS2_SENDING;
+}
+
+static void
+as_uring_send_complete(as_event_connection* conn, int32_t res)
+{
+	as_event_command* cmd = conn->sender;
+
+	conn->sender = NULL;
+	cmd->flags2 &= ~AS_ASYNC_FLAGS2_SENDING;
+
+	if (cmd->flags2 & AS_ASYNC_FLAGS2_RELEASE) {
+		// Command was released while send was in flight.
+		as_event_command_free(cmd);
+	}
+	else if (conn->closed || cmd->conn != conn) {
+		// Connection was closed underneath the send.  If the command has already been
+		// retried on another connection, start that write now.
+		if (cmd->flags2 & AS_ASYNC_FLAGS2_WRITE_PENDING) {
+			cmd->flags2 &= ~AS_ASYNC_FLAGS2_WRITE_PENDING;
+			as_uring_write(cmd);
+		}
+	}
+	else if (res <= 0) {
+		int fd = conn->socket.fd;
+
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+
+			if (res == 0) {
+				as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket write closed by peer", 0);
+			}
+			else {
+				as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket write failed", -res);
+			}
+			as_event_socket_error(cmd, &err);
+		}
+	}
+	else {
+		cmd->pos += res;
+
+		if (cmd->pos < cmd->len) {
+			as_uring_write(cmd);
+		}
+		else {
+			as_uring_write_complete(cmd);
+		}
+	}
+	as_uring_conn_release(conn);
+}
+
+void
+as_event_command_write_start(as_event_command* cmd)
+{
+	cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+	cmd->conn->watching = 1;
+	as_event_set_write(cmd);
+	as_uring_write(cmd);
+}
+
+bool
+as_event_command_read_pause(as_event_command* cmd)
+{
+	// Multishot receive delivers data in kernel selected chunks that may hold several
+	// blocks, so reads can not be paused at a block boundary.
+	return false;
+}
+
+void
+as_event_command_read_resume(as_event_command* cmd)
+{
+}
+
+static void
+as_uring_command_start(as_event_command* cmd)
+{
+	if (cmd->cluster->auth_enabled) {
+		as_session* session = (as_session*)as_load_ptr(&cmd->node->session);
+
+		if (session) {
+			as_incr_uint32(&session->ref_count);
+			as_event_set_auth_write(cmd, session);
+			as_session_release(session);
+
+			cmd->state = AS_ASYNC_STATE_AUTH_WRITE;
+			as_uring_write(cmd);
+		}
+		else {
+			as_event_command_write_start(cmd);
+		}
+	}
+	else if (cmd->type == AS_ASYNC_TYPE_CONNECTOR) {
+		as_event_connector_success(cmd);
+	}
+	else {
+		as_event_command_write_start(cmd);
+	}
+}
+
+static int
+as_uring_read_complete(as_event_command* cmd)
+{
+	switch (cmd->state) {
+		case AS_ASYNC_STATE_AUTH_READ_HEADER: {
+			if (! as_event_set_auth_parse_header(cmd)) {
+				return AS_URING_READ_DONE;
+			}
+
+			if (cmd->len > cmd->read_capacity) {
+				as_error err;
+				as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Authenticate response size is corrupt: %u", cmd->len);
+				as_event_parse_error(cmd, &err);
+				return AS_URING_READ_DONE;
+			}
+			return AS_URING_READ_CONTINUE;
+		}
+
+		case AS_ASYNC_STATE_AUTH_READ_BODY: {
+			// Parse authentication response.
+			uint8_t code = cmd->buf[AS_ASYNC_AUTH_RETURN_CODE];
+
+			if (code && code != AEROSPIKE_SECURITY_NOT_ENABLED) {
+				// Can't authenticate socket, so must close it.
+				as_node_signal_login(cmd->node);
+				as_error err;
+				as_error_update(&err, code, "Authentication failed: %s", as_error_string(code));
+				as_event_parse_error(cmd, &err);
+				return AS_URING_READ_DONE;
+			}
+
+			if (cmd->type == AS_ASYNC_TYPE_CONNECTOR) {
+				as_event_connector_success(cmd);
+				return AS_URING_READ_DONE;
+			}
+
+			as_event_command_write_start(cmd);
+			return AS_URING_READ_DONE;
+		}
+
+		case AS_ASYNC_STATE_COMMAND_READ_HEADER: {
+			as_proto* proto = (as_proto*)cmd->buf;
+
+			if (! as_event_proto_parse(cmd, proto)) {
+				return AS_URING_READ_DONE;
+			}
+
+			size_t size = proto->sz;
+
+			cmd->len = (uint32_t)size;
+			cmd->pos = 0;
+			cmd->state = AS_ASYNC_STATE_COMMAND_READ_BODY;
+
+			if (cmd->len > cmd->read_capacity) {
+				as_event_command_read_buffer(cmd, size);
+			}
+			return AS_URING_READ_CONTINUE;
+		}
+
+		case AS_ASYNC_STATE_COMMAND_READ_BODY: {
+			cmd->pos = 0;
+
+			if (cmd->proto_type_rcv == AS_COMPRESSED_MESSAGE_TYPE) {
+				if (! as_event_decompress(cmd)) {
+					return AS_URING_READ_DONE;
+				}
+			}
+
+			if (! cmd->parse_results(cmd)) {
+				// Batch, scan, query is not finished. Prepare to read next header.
+				cmd->len = sizeof(as_proto);
+				cmd->pos = 0;
+				cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+				return AS_URING_READ_CONTINUE;
+			}
+			return AS_URING_READ_DONE;
+		}
+
+		default:
+			as_log_error("unexpected cmd state %d", cmd->state);
+			return AS_URING_READ_DONE;
+	}
+}
+
+static void
+as_uring_feed(as_event_connection* conn, uint8_t* data, uint32_t size)
+{
+	// Deliver received bytes to the pending command(s).  A chunk may complete several
+	// message blocks, or several pipelined responses.
+	while (! conn->closed) {
+		as_event_command* cmd = as_uring_reader(conn);
+
+		if (! cmd) {
+			if (size > 0) {
+				// Data arrived for no pending command. Connection can't be reused.
+				as_log_debug("Unexpected data on async connection: %u", size);
+				conn->invalid = true;
+			}
+			return;
+		}
+
+		uint32_t avail = cmd->len - cmd->pos;
+
+		if (avail > 0) {
+			if (size == 0) {
+				return;
+			}
+
+			uint32_t n = size < avail ? size : avail;
+
+			memcpy(cmd->buf + cmd->pos, data, n);
+			cmd->pos += n;
+			cmd->flags |= AS_ASYNC_FLAGS_EVENT_RECEIVED;
+			data += n;
+			size -= n;
+
+			if (cmd->pos < cmd->len) {
+				return;
+			}
+		}
+
+		if (as_uring_read_complete(cmd) == AS_URING_READ_DONE && size == 0) {
+			return;
+		}
+	}
+}
+
+static void
+as_uring_read_error(as_event_connection* conn, as_status status, const char* msg, int code)
+{
+	as_event_command* cmd = as_uring_reader(conn);
+
+	if (! cmd) {
+		// Idle connection was closed by peer or failed.
+		conn->invalid = true;
+		return;
+	}
+
+	int fd = conn->socket.fd;
+
+	if (! as_event_socket_retry(cmd)) {
+		as_error err;
+		as_socket_error(fd, cmd->node, &err, status, msg, code);
+		as_event_socket_error(cmd, &err);
+	}
+}
+
+static void
+as_uring_recv(as_uring_loop* ul, as_event_connection* conn, int32_t res, uint32_t flags)
+{
+	bool more = flags & IORING_CQE_F_MORE;
+
+	if (! more) {
+		conn->recv_armed = false;
+	}
+
+	if (flags & IORING_CQE_F_BUFFER) {
+		uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+		uint8_t* buf = ul->bufs + (size_t)bid * AS_URING_BUF_SIZE;
+
+		if (res > 0 && ! conn->closed) {
+			as_uring_feed(conn, buf, (uint32_t)res);
+		}
+
+		// Return buffer to the ring.
+		io_uring_buf_ring_add(ul->buf_ring, buf, AS_URING_BUF_SIZE, bid,
+							  io_uring_buf_ring_mask(AS_URING_BUF_COUNT), 0);
+		io_uring_buf_ring_advance(ul->buf_ring, 1);
+	}
+	else if (! conn->closed && res != -ENOBUFS && res != -ECANCELED) {
+		if (res == 0) {
+			as_uring_read_error(conn, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket read closed by peer", 0);
+		}
+		else {
+			as_uring_read_error(conn, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket read failed", -res);
+		}
+	}
+
+	// Multishot receive stops when the buffer ring runs dry. Data is still queued in the
+	// socket, so rearm.
+	if (! more && ! conn->closed && ! conn->invalid && (res > 0 || res == -ENOBUFS)) {
+		as_uring_arm_read(conn);
+	}
+
+	// A multishot request holds one in-flight reference until its final completion.
+	if (! more) {
+		as_uring_conn_release(conn);
+	}
+}
+
+static void
+as_uring_tls_read(as_event_connection* conn)
+{
+	while (! conn->closed) {
+		as_event_command* cmd = as_uring_reader(conn);
+
+		if (! cmd) {
+			// Leave data in socket so pool validation detects it.
+			return;
+		}
+
+		if (cmd->pos < cmd->len) {
+			int rv = as_tls_read_once(&conn->socket, cmd->buf + cmd->pos, cmd->len - cmd->pos);
+
+			if (rv > 0) {
+				cmd->pos += rv;
+				cmd->flags |= AS_ASYNC_FLAGS_EVENT_RECEIVED;
+
+				if (cmd->pos < cmd->len) {
+					continue;
+				}
+			}
+			else if (rv == -1) {
+				// TLS wants a read.
+				return;
+			}
+			else if (rv == -2) {
+				// TLS sometimes needs to write, even when the app is reading.
+				as_uring_poll(conn, POLLOUT);
+				return;
+			}
+			else {
+				as_uring_read_error(conn, AEROSPIKE_ERR_TLS_ERROR, "TLS read failed", rv);
+				return;
+			}
+		}
+		as_uring_read_complete(cmd);
+	}
+}
+
+static void
+as_uring_poll_read(as_event_connection* conn, uint32_t flags)
+{
+	bool more = flags & IORING_CQE_F_MORE;
+
+	if (! more) {
+		conn->recv_armed = false;
+	}
+
+	if (! conn->closed) {
+		as_uring_tls_read(conn);
+
+		if (! conn->closed && ! conn->recv_armed) {
+			as_uring_arm_read(conn);
+		}
+	}
+
+	// A multishot request holds one in-flight reference until its final completion.
+	if (! more) {
+		as_uring_conn_release(conn);
+	}
+}
+
+static void
+as_uring_tls_connect(as_event_command* cmd, as_event_connection* conn)
+{
+	int rv = as_tls_connect_once(&conn->socket);
+
+	if (rv < -2) {
+		if (! as_event_socket_retry(cmd)) {
+			// Failed, error has been logged.
+			as_error err;
+			as_error_set_message(&err, AEROSPIKE_ERR_TLS_ERROR, "TLS connection failed");
+			as_event_socket_error(cmd, &err);
+		}
+		return;
+	}
+
+	if (rv == -1) {
+		// TLS needs a read.
+		as_uring_poll(conn, POLLIN);
+		return;
+	}
+
+	if (rv == -2) {
+		// TLS needs a write.
+		as_uring_poll(conn, POLLOUT);
+		return;
+	}
+
+	if (rv == 0) {
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_error_set_message(&err, AEROSPIKE_ERR_TLS_ERROR, "TLS connection shutdown");
+			as_event_socket_error(cmd, &err);
+		}
+		return;
+	}
+
+	// TLS connection established.
+	as_uring_arm_read(conn);
+	as_uring_command_start(cmd);
+}
+
+static void
+as_uring_poll_complete(as_event_connection* conn)
+{
+	conn->polls--;
+
+	as_event_command* cmd = conn->closed ? NULL : as_uring_command(conn);
+
+	if (cmd) {
+		switch (cmd->state) {
+			case AS_ASYNC_STATE_CONNECT:
+				// Plain socket connected.
+				as_uring_register_file(conn->event_loop->loop, conn);
+				as_uring_arm_read(conn);
+				as_uring_command_start(cmd);
+				break;
+
+			case AS_ASYNC_STATE_TLS_CONNECT:
+				as_uring_tls_connect(cmd, conn);
+				break;
+
+			case AS_ASYNC_STATE_AUTH_WRITE:
+			case AS_ASYNC_STATE_COMMAND_WRITE:
+				as_uring_tls_write(cmd);
+				break;
+
+			case AS_ASYNC_STATE_AUTH_READ_HEADER:
+			case AS_ASYNC_STATE_AUTH_READ_BODY:
+			case AS_ASYNC_STATE_COMMAND_READ_HEADER:
+			case AS_ASYNC_STATE_COMMAND_READ_BODY:
+				as_uring_tls_read(conn);
+				break;
+
+			default:
+				as_log_error("unexpected cmd state %d", cmd->state);
+				break;
+		}
+	}
+	as_uring_conn_release(conn);
+}
+
+/******************************************************************************
+ * CONNECT
+ *****************************************************************************/
+
+static void
+as_uring_watcher_init(as_event_command* cmd, as_socket* sock)
+{
+	as_event_connection* conn = cmd->conn;
+	memcpy(&conn->socket, sock, sizeof(as_socket));
+
+	// Change state if using TLS.
+	if (as_socket_use_tls(cmd->cluster->tls_ctx)) {
+		cmd->state = AS_ASYNC_STATE_TLS_CONNECT;
+	}
+
+	// Wait for non-blocking connect to complete.
+	conn->watching = 1;
+	as_uring_poll(conn, POLLOUT);
+}
+
+static int
+as_uring_try_connections(int fd, as_address* addresses, socklen_t size, int i, int max)
+{
+	while (i < max) {
+		if (as_socket_connect_fd(fd, (struct sockaddr*)&addresses[i].addr, size)) {
+			return i;
+		}
+		i++;
+	}
+	return -1;
+}
+
+static int
+as_uring_try_family_connections(as_event_command* cmd, int family, int begin, int end, int index, as_address* primary, as_socket* sock)
+{
+	// Create a non-blocking socket.
+	as_socket_fd fd;
+	int rv = as_socket_create_fd(family, &fd);
+
+	if (rv < 0) {
+		return rv;
+	}
+	as_event_set_busy_poll(cmd->event_loop, fd);
+
+	if (cmd->pipe_listener && ! as_pipe_modify_fd(fd)) {
+		return -1000;
+	}
+
+	as_tls_context* ctx = as_socket_get_tls_context(cmd->cluster->tls_ctx);
+
+	if (! as_socket_wrap(sock, family, fd, ctx, cmd->node->tls_name)) {
+		return -1001;
+	}
+
+	// Try addresses.
+	as_address* addresses = cmd->node->addresses;
+	socklen_t size = (family == AF_INET)? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+
+	if (index >= 0) {
+		// Try primary address.
+		if (as_socket_connect_fd(fd, (struct sockaddr*)&primary->addr, size)) {
+			return index;
+		}
+
+		// Start from current index + 1 to end.
+		rv = as_uring_try_connections(fd, addresses, size, index + 1, end);
+
+		if (rv < 0) {
+			// Start from begin to index.
+			rv = as_uring_try_connections(fd, addresses, size, begin, index);
+		}
+	}
+	else {
+		rv = as_uring_try_connections(fd, addresses, size, begin, end);
+	}
+
+	if (rv < 0) {
+		// Couldn't start a connection on any socket address - close the socket.
+		as_socket_close(sock);
+		return -1002;
+	}
+	return rv;
+}
+
+static void
+as_uring_connect_error(as_event_command* cmd, as_address* primary, int rv)
+{
+	// Socket has already been closed. Release connection.
+	cf_free(cmd->conn);
+	as_event_decr_conn(cmd);
+	cmd->event_loop->errors++;
+	as_node_set_suspect(cmd->node);
+
+	if (as_event_command_retry(cmd, false)) {
+		return;
+	}
+
+	as_error err;
+	as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Connect failed: %d %s %s", rv, cmd->node->name, primary->name);
+
+	// Only timer needs to be released on socket connection failure.
+	// No operation has been submitted yet.
+	as_event_timer_stop(cmd);
+	as_event_error_callback(cmd, &err);
+}
+
+void
+as_event_connect(as_event_command* cmd, as_async_conn_pool* pool)
+{
+	as_event_connection* conn = cmd->conn;
+	conn->event_loop = cmd->event_loop;
+	conn->sender = NULL;
+	conn->inflight = 0;
+	conn->polls = 0;
+	conn->fixed = -1;
+	conn->recv_armed = false;
+	conn->invalid = false;
+	conn->closed = false;
+
+	// Try addresses.
+	as_socket sock;
+	as_node* node = cmd->node;
+	uint32_t index = node->address_index;
+	as_address* primary = &node->addresses[index];
+	int rv;
+	int first_rv;
+
+	if (primary->addr.ss_family == AF_INET) {
+		// Try IPv4 addresses first.
+		rv = as_uring_try_family_connections(cmd, AF_INET, 0, node->address4_size, index, primary, &sock);
+
+		if (rv < 0) {
+			// Try IPv6 addresses.
+			first_rv = rv;
+			rv = as_uring_try_family_connections(cmd, AF_INET6, AS_ADDRESS4_MAX, AS_ADDRESS4_MAX + node->address6_size, -1, NULL, &sock);
+		}
+	}
+	else {
+		// Try IPv6 addresses first.
+		rv = as_uring_try_family_connections(cmd, AF_INET6, AS_ADDRESS4_MAX, AS_ADDRESS4_MAX + node->address6_size, index, primary, &sock);
+
+		if (rv < 0) {
+			// Try IPv4 addresses.
+			first_rv = rv;
+			rv = as_uring_try_family_connections(cmd, AF_INET, 0, node->address4_size, -1, NULL, &sock);
+		}
+	}
+
+	if (rv < 0) {
+		as_uring_connect_error(cmd, primary, first_rv);
+		return;
+	}
+
+	if (rv != index) {
+		// Replace invalid primary address with valid alias.
+		// Other threads may not see this change immediately.
+		// It's just a hint, not a requirement to try this new address first.
+		as_store_uint32(&node->address_index, rv);
+		as_log_debug("Change node address %s %s", node->name, as_node_get_address_string(node));
+	}
+
+	pool->opened++;
+	as_uring_watcher_init(cmd, &sock);
+	cmd->event_loop->errors = 0; // Reset errors on valid connection.
+}
+
+/******************************************************************************
+ * NODE DESTROY
+ *****************************************************************************/
+
+static void
+as_uring_close_connection_cb(as_event_loop* event_loop, as_event_connection* conn)
+{
+	as_event_close_connection(conn);
+}
+
+static bool
+as_uring_queue_close_connections(as_node* node, as_async_conn_pool* pool, as_event_loop* event_loop)
+{
+	as_event_connection* conn;
+
+	// Connections must be closed in their event loop thread because closing submits
+	// cancellations on the loop's ring.
+	while (as_queue_pop(&pool->queue, &conn)) {
+		if (! as_event_execute(event_loop, (as_event_executable)as_uring_close_connection_cb, conn)) {
+			as_log_error("Failed to queue connection close");
+			return false;
+		}
+
+		// Connection counts are decremented before the connection is closed because the
+		// node will be invalid when the deferred connection close occurs.
+		as_queue_decr_total(&pool->queue);
+	}
+	return true;
+}
+
+void
+as_event_node_destroy(as_node* node)
+{
+	// Send close connection commands to event loops.
+	for (uint32_t i = 0; i < as_event_loop_size; i++) {
+		as_event_loop* event_loop = &as_event_loops[i];
+
+		as_uring_queue_close_connections(node, &node->async_conn_pools[i], event_loop);
+		as_uring_queue_close_connections(node, &node->pipe_conn_pools[i], event_loop);
+	}
+
+	// Destroy all queues.
+	for (uint32_t i = 0; i < as_event_loop_capacity; i++) {
+		as_queue_destroy(&node->async_conn_pools[i].queue);
+		as_queue_destroy(&node->pipe_conn_pools[i].queue);
+	}
+	cf_free(node->async_conn_pools);
+	cf_free(node->pipe_conn_pools);
+}
+
+#endif
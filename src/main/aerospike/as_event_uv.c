@@ -17,6 +17,7 @@
 #include <aerospike/as_event.h>
 #include <aerospike/as_event_internal.h>
 #include <aerospike/as_async.h>
+#include <aerospike/as_auto_batch.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_monitor.h>
 #include <aerospike/as_pipe.h>
@@ -78,6 +79,13 @@ as_uv_wakeup_closed(uv_handle_t* handle)
 	cf_free(handle);
 }
 
+static void
+as_uv_driver_closed(uv_handle_t* handle)
+{
+	// Driver command is the first field of the timer wheel, lag timer and auto batch.
+	cf_free(handle->data);
+}
+
 static void
 as_uv_connection_closed(uv_handle_t* socket)
 {
@@ -99,9 +107,34 @@ void
 as_event_close_loop(as_event_loop* event_loop)
 {
 	uv_close((uv_handle_t*)event_loop->wakeup, as_uv_wakeup_closed);
+
+	as_event_wheel* wheel = event_loop->wheel;
+
+	if (wheel && (wheel->driver.flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
+		// libuv requires that the wheel can't be freed until its timer is closed.
+		uv_close((uv_handle_t*)&wheel->driver.timer, as_uv_driver_closed);
+		event_loop->wheel = NULL;
+	}
+
+	as_event_lag* lag = event_loop->lag;
+
+	if (lag && (lag->driver.flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
+		uv_close((uv_handle_t*)&lag->driver.timer, as_uv_driver_closed);
+		event_loop->lag = NULL;
+	}
+
+	as_auto_batch* ab = event_loop->auto_batch;
+
+	if (ab && (ab->driver.flags & AS_ASYNC_FLAGS_HAS_TIMER)) {
+		// Same for the auto batch.  Reads that were never sent are dropped.
+		as_auto_batch_release(ab);
+		uv_close((uv_handle_t*)&ab->driver.timer, as_uv_driver_closed);
+		event_loop->auto_batch = NULL;
+	}
 	
 	// Only stop event loop if client created event loop.
 	if (as_event_threads_created) {
+		event_loop->busy_poll_us = 0;
 		uv_stop(event_loop->loop);
 	}
 	
@@ -112,35 +145,12 @@ as_event_close_loop(as_event_loop* event_loop)
 static void
 as_uv_wakeup(uv_async_t* wakeup)
 {
-	// Read command pointers from queue.
+	// Run commands queued by other threads.
 	as_event_loop* event_loop = wakeup->data;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_event_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(event_loop, cmd.udata);
-
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
-		}
-		else {
-			break;
-		}
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_event_close_loop(event_loop);
+		return;
 	}
 }
 
@@ -161,6 +171,24 @@ as_uv_close_walk(uv_handle_t* handle, void* arg)
 	}
 }
 
+static void
+as_uv_busy_loop(as_event_loop* event_loop)
+{
+	uint64_t activity = 0;
+	uint64_t idle_begin = cf_getns();
+
+	// busy_poll_us is cleared when the event loop is closed.
+	while (event_loop->busy_poll_us > 0) {
+		if (as_event_busy_poll(event_loop, &activity, &idle_begin)) {
+			uv_run(event_loop->loop, UV_RUN_NOWAIT);
+		}
+		else {
+			uv_run(event_loop->loop, UV_RUN_ONCE);
+			idle_begin = cf_getns();
+		}
+	}
+}
+
 static void*
 as_uv_worker(void* udata)
 {
@@ -189,7 +217,12 @@ as_uv_worker(void* udata)
 	uv_async_init(event_loop->loop, event_loop->wakeup, as_uv_wakeup);
 	as_monitor_notify(&data->monitor);
 	
-	uv_run(event_loop->loop, UV_RUN_DEFAULT);
+	if (event_loop->busy_poll_us > 0) {
+		as_uv_busy_loop(event_loop);
+	}
+	else {
+		uv_run(event_loop->loop, UV_RUN_DEFAULT);
+	}
 	
 	uv_walk(event_loop->loop, as_uv_close_walk, NULL);
 	uv_run(event_loop->loop, UV_RUN_DEFAULT);
@@ -212,7 +245,7 @@ as_event_create_loop(as_event_loop* event_loop)
 	thread_data.event_loop = event_loop;
 	as_monitor_init(&thread_data.monitor);
 	
-	if (pthread_create(&event_loop->thread, NULL, as_uv_worker, &thread_data) != 0) {
+	if (! as_event_thread_create(event_loop, as_uv_worker, &thread_data)) {
 		return false;
 	}
 	
@@ -237,12 +270,9 @@ bool
 as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
 {
 	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
+	bool queued = as_event_queue_command(event_loop, executable, udata);
 
-	if (queued) {
+	if (queued && as_event_wakeup_needed(event_loop)) {
 		uv_async_send(event_loop->wakeup);
 	}
 	return queued;
@@ -337,12 +367,7 @@ as_uv_command_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
 		}
 		
 		if (cmd->len > cmd->read_capacity) {
-			if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-				cf_free(cmd->buf);
-			}
-			cmd->buf = cf_malloc(size);
-			cmd->read_capacity = cmd->len;
-			cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+			as_event_command_read_buffer(cmd, size);
 		}
 		return;
 	}
@@ -355,6 +380,11 @@ as_uv_command_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
 	}
 
 	if (! cmd->parse_results(cmd)) {
+		if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_PAUSED) {
+			// Flow control stopped reading. Next block is read on resume.
+			return;
+		}
+
 		// Batch, scan, query is not finished.
 		cmd->len = sizeof(as_proto);
 		cmd->pos = 0;
@@ -362,6 +392,70 @@ as_uv_command_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
 	}
 }
 
+static void
+as_uv_command_read_start(as_event_command* cmd, uv_stream_t* stream)
+{
+	cmd->command_sent_counter++;
+	as_event_trace_sent(cmd);
+	cmd->len = sizeof(as_proto);
+	cmd->pos = 0;
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+
+	if (cmd->pipe_listener != NULL) {
+		as_pipe_connection* conn = (as_pipe_connection*)cmd->conn;
+
+		// Check before read start, which also adds gathered commands and runs listeners.
+		bool reading = cf_ll_size(&conn->readers) > 0;
+
+		as_pipe_read_start(cmd);
+
+		// There already was an active reader for a previous command.
+		if (reading) {
+			return;
+		}
+	}
+	
+	int status = uv_read_start(stream, as_uv_command_buffer, as_uv_command_read);
+	
+	if (status) {
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION,
+							"uv_read_start failed: %s", uv_strerror(status));
+			as_event_socket_error(cmd, &err);
+		}
+	}
+}
+
+bool
+as_event_command_read_pause(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+
+	// TLS reads are driven by the TLS buffer, which is not paused.
+	if (conn->pipeline || conn->tls) {
+		return false;
+	}
+
+	uv_read_stop((uv_stream_t*)conn);
+	return true;
+}
+
+void
+as_event_command_read_resume(as_event_command* cmd)
+{
+	int status = uv_read_start((uv_stream_t*)cmd->conn, as_uv_command_buffer, as_uv_command_read);
+
+	if (status) {
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION,
+							"uv_read_start failed: %s", uv_strerror(status));
+			as_event_socket_error(cmd, &err);
+		}
+	}
+}
+
 static void
 as_uv_command_write_complete(uv_write_t* req, int status)
 {
@@ -372,31 +466,7 @@ as_uv_command_write_complete(uv_write_t* req, int status)
 	as_event_command* cmd = req->data;
 	
 	if (status == 0) {
-		cmd->command_sent_counter++;
-		cmd->len = sizeof(as_proto);
-		cmd->pos = 0;
-		cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
-
-		if (cmd->pipe_listener != NULL) {
-			as_pipe_read_start(cmd);
-			as_pipe_connection* conn = (as_pipe_connection*)cmd->conn;
-
-			// There already was an active reader for a previous command.
-			if (cf_ll_size(&conn->readers) > 1) {
-				return;
-			}
-		}
-		
-		status = uv_read_start(req->handle, as_uv_command_buffer, as_uv_command_read);
-		
-		if (status) {
-			if (! as_event_socket_retry(cmd)) {
-				as_error err;
-				as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION,
-								"uv_read_start failed: %s", uv_strerror(status));
-				as_event_socket_error(cmd, &err);
-			}
-		}
+		as_uv_command_read_start(cmd, req->handle);
 	}
 	else if (status != UV_ECANCELED) {
 		if (! as_event_socket_retry(cmd)) {
@@ -415,11 +485,35 @@ as_uv_command_write_start(as_event_command* cmd, uv_stream_t* stream)
 	cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
 	cmd->flags &= ~AS_ASYNC_FLAGS_EVENT_RECEIVED;
 
+	uv_buf_t buf = uv_buf_init((char*)as_event_write_buffer(cmd), cmd->len);
+
+	// The socket buffer usually has room for the whole command, so try writing it now
+	// and skip the write request callback.
+	int status = uv_try_write(stream, &buf, 1);
+
+	if (status == (int)cmd->len) {
+		as_uv_command_read_start(cmd, stream);
+		return;
+	}
+
+	if (status > 0) {
+		// Partial write.  Queue the remainder.
+		buf = uv_buf_init(buf.base + status, cmd->len - status);
+	}
+	else if (status != UV_EAGAIN && status != UV_ENOSYS) {
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION,
+							"uv_try_write failed: %s", uv_strerror(status));
+			as_event_socket_error(cmd, &err);
+		}
+		return;
+	}
+
 	uv_write_t* write_req = &cmd->conn->req.write;
 	write_req->data = cmd;
-	uv_buf_t buf = uv_buf_init((char*)cmd + cmd->write_offset, cmd->len);
 
-	int status = uv_write(write_req, stream, &buf, 1, as_uv_command_write_complete);
+	status = uv_write(write_req, stream, &buf, 1, as_uv_command_write_complete);
 
 	if (status) {
 		if (! as_event_socket_retry(cmd)) {
@@ -844,7 +938,7 @@ static void
 as_uv_tls_write(as_event_command* cmd)
 {
 	as_event_connection* conn = cmd->conn;
-	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
+	uint8_t* buf = as_event_write_buffer(cmd);
 
 	as_uv_tls* tls = conn->tls;
 	tls->error = 0;
@@ -895,16 +989,21 @@ static void
 as_uv_tls_command_write_complete(as_event_command* cmd)
 {
 	cmd->command_sent_counter++;
+	as_event_trace_sent(cmd);
 	cmd->len = sizeof(as_proto);
 	cmd->pos = 0;
 	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
 
 	if (cmd->pipe_listener != NULL) {
-		as_pipe_read_start(cmd);
 		as_pipe_connection* conn = (as_pipe_connection*)cmd->conn;
 
+		// Check before read start, which also adds gathered commands and runs listeners.
+		bool reading = cf_ll_size(&conn->readers) > 0;
+
+		as_pipe_read_start(cmd);
+
 		// There already was an active reader for a previous command.
-		if (cf_ll_size(&conn->readers) > 1) {
+		if (reading) {
 			return;
 		}
 	}
@@ -1055,12 +1154,7 @@ as_uv_tls_read(as_event_command* cmd)
 				}
 
 				if (cmd->len > cmd->read_capacity) {
-					if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
-						cf_free(cmd->buf);
-					}
-					cmd->buf = cf_malloc(size);
-					cmd->read_capacity = cmd->len;
-					cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+					as_event_command_read_buffer(cmd, size);
 				}
 				break;
 			}
@@ -1382,6 +1476,7 @@ as_uv_connected(uv_connect_t* req, int status)
 		as_error err;
 		as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Failed to connect: %s %s",
 						node->name, as_node_get_address_string(node));
+		as_node_set_suspect(node);
 		as_uv_connect_error(cmd, &err);
 	}
 }
@@ -1401,6 +1496,7 @@ as_event_connect(as_event_command* cmd, as_async_conn_pool* pool)
 		as_uv_fd_error(cmd, &err);
 		return;
 	}
+	as_event_set_busy_poll(cmd->event_loop, fd);
 
 	if (cmd->pipe_listener && ! as_pipe_modify_fd(fd)) {
 		// as_pipe_modify_fd() will close fd on error.
@@ -1476,18 +1572,13 @@ as_event_close_connection_cb(as_event_loop* event_loop, as_event_connection* con
 }
 
 static bool
-as_uv_queue_close_connections(as_node* node, as_async_conn_pool* pool, as_queue* cmd_queue)
+as_uv_queue_close_connections(as_node* node, as_async_conn_pool* pool, as_event_loop* event_loop)
 {
-	as_event_commander qcmd;
-	qcmd.executable = (as_event_executable)as_event_close_connection_cb;
-	
 	as_event_connection* conn;
 	
 	// Queue connection commands to event loops.
 	while (as_queue_pop(&pool->queue, &conn)) {
-		qcmd.udata = conn;
-		
-		if (! as_queue_push(cmd_queue, &qcmd)) {
+		if (! as_event_execute(event_loop, (as_event_executable)as_event_close_connection_cb, conn)) {
 			as_log_error("Failed to queue connection close");
 			return false;
 		}
@@ -1508,12 +1599,8 @@ as_event_node_destroy(as_node* node)
 	for (uint32_t i = 0; i < as_event_loop_size; i++) {
 		as_event_loop* event_loop = &as_event_loops[i];
 		
-		pthread_mutex_lock(&event_loop->lock);
-		as_uv_queue_close_connections(node, &node->async_conn_pools[i], &event_loop->queue);
-		as_uv_queue_close_connections(node, &node->pipe_conn_pools[i], &event_loop->queue);
-		pthread_mutex_unlock(&event_loop->lock);
-		
-		uv_async_send(event_loop->wakeup);
+		as_uv_queue_close_connections(node, &node->async_conn_pools[i], event_loop);
+		as_uv_queue_close_connections(node, &node->pipe_conn_pools[i], event_loop);
 	}
 		
 	// Destroy all queues.
@@ -20,12 +20,15 @@
 #include <citrusleaf/cf_b64.h>
 
 #include <aerospike/aerospike_index.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_cdt_internal.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_msgpack.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <pthread.h>
 
 typedef enum {
 	CALL_CDT = 0,
@@ -35,10 +38,49 @@ typedef enum {
 
 #define AS_CDT_OP_CONTEXT_EVAL 0xff
 
-as_exp*
-as_exp_compile(as_exp_entry* table, uint32_t n)
+// Placeholders are packed as fixed width msgpack int64 and float64.
+#define AS_EXP_PARAM_SZ 9
+
+#define AS_EXP_CACHE_BUCKETS 256
+#define AS_EXP_CACHE_MAX 4096
+
+typedef struct {
+	uint32_t offset;
+	uint32_t index;
+	bool is_float;
+} as_exp_slot;
+
+// Reference count that precedes expressions returned by as_exp_compile_cached().
+typedef struct {
+	uint32_t ref_count;
+	uint32_t pad;
+} as_exp_shared;
+
+struct as_exp_template_s {
+	as_exp* exp;
+	uint32_t n_slots;
+	as_exp_slot slots[];
+};
+
+typedef struct as_exp_cache_entry_s {
+	struct as_exp_cache_entry_s* next;
+	as_exp* exp;
+	as_exp_slot* slots;
+	uint64_t hash;
+	uint32_t n_slots;
+	uint32_t key_sz;
+	uint8_t key[];
+} as_exp_cache_entry;
+
+static as_exp_cache_entry* as_exp_cache[AS_EXP_CACHE_BUCKETS];
+static pthread_mutex_t as_exp_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t as_exp_cache_size;
+
+static bool
+as_exp_size(as_exp_entry* table, uint32_t n, uint32_t* size, uint32_t* n_slots)
 {
 	uint32_t total_sz = 0;
+	uint32_t slots = 0;
 	as_serializer s;
 	int32_t prev_va_args = -1;
 
@@ -133,21 +175,21 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 			}
 
 			if ((sz = as_serializer_serialize_getsize(&s, entry->v.val)) == 0) {
-				return NULL;
+				return false;
 			}
 
 			total_sz += sz;
 			break;
 		case _AS_EXP_CODE_VAL_GEO:
 			if ((sz = as_serializer_serialize_getsize(&s, entry->v.val)) == 0) {
-				return NULL;
+				return false;
 			}
 
 			total_sz += sz;
 			break;
 		case _AS_EXP_CODE_VAL_RTYPE:
 			if (entry->v.int_val == AS_EXP_TYPE_ERROR) {
-				return NULL;
+				return false;
 			}
 			// no break
 		case _AS_EXP_CODE_VAL_INT:
@@ -162,6 +204,11 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 		case _AS_EXP_CODE_VAL_BOOL:
 			total_sz += as_pack_bool_size();
 			break;
+		case _AS_EXP_CODE_VAL_PARAM_INT:
+		case _AS_EXP_CODE_VAL_PARAM_FLOAT:
+			total_sz += AS_EXP_PARAM_SZ;
+			slots++;
+			break;
 		case _AS_EXP_CODE_VAL_STR:
 			entry->sz = (uint32_t)strlen(entry->v.str_val);
 			total_sz += as_pack_str_size(entry->sz + 1); // +1 for AS_BYTES type
@@ -175,7 +222,7 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 			break;
 		case _AS_EXP_CODE_END_OF_VA_ARGS:
 			if (prev_va_args == -1) {
-				return NULL;
+				return false;
 			}
 
 			entry = &table[prev_va_args];
@@ -190,42 +237,29 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 
 			if (entry->v.ctx != NULL) {
 				if (entry->v.ctx->list.size == 0) {
-					return NULL;
+					return false;
 				}
 
 				if (i == 0 || table[i - 1].op != _AS_EXP_CODE_VAL_INT ||
 						(table[i - 1].v.int_val &
 								~_AS_EXP_SYS_FLAG_MODIFY_LOCAL) !=
 										_AS_EXP_SYS_CALL_CDT) {
-					return NULL;
+					return false;
 				}
 
 				total_sz += as_pack_list_header_get_size(3);
 				total_sz += as_pack_int64_size(AS_CDT_OP_CONTEXT_EVAL);
-				total_sz +=
-						as_pack_list_header_get_size(entry->v.ctx->list.size * 2);
-
-				for (uint32_t j = 0; j < entry->v.ctx->list.size; j++) {
-					as_cdt_ctx_item* item = as_vector_get(&entry->v.ctx->list, j);
 
-					total_sz += as_pack_uint64_size(item->type);
+				as_packer pk = {
+						.buffer = NULL,
+						.capacity = UINT32_MAX
+				};
 
-					if (item->type & AS_CDT_CTX_VALUE) {
-						as_packer pk = {
-								.buffer = NULL,
-								.capacity = UINT32_MAX
-						};
-
-						if (as_pack_val(&pk, item->val.pval) != 0) {
-							return NULL;
-						}
-
-						total_sz += pk.offset;
-					}
-					else {
-						total_sz += as_pack_int64_size(item->val.ival);
-					}
+				if (as_cdt_pack_ctx_levels(&pk, entry->v.ctx) != 0) {
+					return false;
 				}
+
+				total_sz += pk.offset;
 			}
 
 			break;
@@ -256,13 +290,24 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 		}
 	}
 
-	as_exp* p2 = cf_malloc(sizeof(as_exp) + total_sz);
+	*size = total_sz;
+	*n_slots = slots;
+	return true;
+}
 
-	p2->packed_sz = total_sz;
+static void
+as_exp_pack_param(as_packer* pk, uint8_t type)
+{
+	uint8_t buf[AS_EXP_PARAM_SZ] = {type};
+	as_pack_append(pk, buf, sizeof(buf));
+}
 
+static void
+as_exp_pack(as_exp_entry* table, uint32_t n, as_exp* p2, as_exp_slot* slots)
+{
 	as_packer pk = {
 			.buffer = p2->packed,
-			.capacity = total_sz
+			.capacity = p2->packed_sz
 	};
 
 	for (uint32_t i = 0; i < n; i++) {
@@ -332,6 +377,21 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 		case _AS_EXP_CODE_VAL_BOOL:
 			as_pack_bool(&pk, entry->v.bool_val);
 			break;
+		case _AS_EXP_CODE_VAL_PARAM_INT:
+		case _AS_EXP_CODE_VAL_PARAM_FLOAT: {
+			bool is_float = entry->op == _AS_EXP_CODE_VAL_PARAM_FLOAT;
+
+			if (slots) {
+				slots->offset = pk.offset + 1;
+				slots->index = entry->sz;
+				slots->is_float = is_float;
+				slots++;
+			}
+
+			// Zero int64 and zero float64 are both all zero bits after the type byte.
+			as_exp_pack_param(&pk, is_float ? 0xcb : 0xd3);
+			break;
+		}
 		case _AS_EXP_CODE_VAL_STR: {
 			as_string temp;
 			as_string_init_wlen(&temp, (char*)entry->v.str_val, entry->sz, false);
@@ -353,21 +413,7 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 			if (entry->v.ctx != NULL) {
 				as_pack_list_header(&pk, 3);
 				as_pack_int64(&pk, AS_CDT_OP_CONTEXT_EVAL);
-
-				as_pack_list_header(&pk, entry->v.ctx->list.size * 2);
-
-				for (uint32_t j = 0; j < entry->v.ctx->list.size; j++) {
-					as_cdt_ctx_item* item = as_vector_get(&entry->v.ctx->list, j);
-
-					as_pack_uint64(&pk, item->type);
-
-					if (item->type & AS_CDT_CTX_VALUE) {
-						as_pack_val(&pk, item->val.pval);
-					}
-					else {
-						as_pack_int64(&pk, item->val.ival);
-					}
-				}
+				as_cdt_pack_ctx_levels(&pk, entry->v.ctx);
 			}
 
 			as_pack_list_header(&pk, entry->count);
@@ -382,10 +428,420 @@ as_exp_compile(as_exp_entry* table, uint32_t n)
 			break;
 		}
 	}
+}
 
+as_exp*
+as_exp_compile(as_exp_entry* table, uint32_t n)
+{
+	uint32_t total_sz;
+	uint32_t n_slots;
+
+	if (! as_exp_size(table, n, &total_sz, &n_slots)) {
+		return NULL;
+	}
+
+	as_exp* p2 = cf_malloc(sizeof(as_exp) + total_sz);
+
+	p2->packed_sz = total_sz;
+	as_exp_pack(table, n, p2, NULL);
 	return p2;
 }
 
+static inline as_exp_shared*
+as_exp_shared_get(as_exp* exp)
+{
+	return (as_exp_shared*)exp - 1;
+}
+
+static as_exp*
+as_exp_shared_create(uint32_t packed_sz)
+{
+	as_exp_shared* shared = cf_malloc(sizeof(as_exp_shared) + sizeof(as_exp) + packed_sz);
+	shared->ref_count = 1;
+
+	as_exp* exp = (as_exp*)(shared + 1);
+	exp->packed_sz = packed_sz;
+	return exp;
+}
+
+static void
+as_exp_key_pack(as_packer* pk, as_exp_entry* table, uint32_t n)
+{
+	// The key holds every entry field that affects the packed expression, except the values
+	// of parameter placeholders. Entries are read before as_exp_size() modifies counts.
+	for (uint32_t i = 0; i < n; i++) {
+		as_exp_entry* entry = &table[i];
+
+		as_pack_int64(pk, (int64_t)entry->op);
+		as_pack_uint64(pk, entry->count);
+
+		switch (entry->op) {
+		case _AS_EXP_CODE_CDT_LIST_CRMOD:
+		case _AS_EXP_CODE_CDT_LIST_MOD:
+			if (entry->v.list_pol != NULL) {
+				as_pack_uint64(pk, (uint64_t)entry->v.list_pol->order);
+				as_pack_uint64(pk, (uint64_t)entry->v.list_pol->flags);
+			}
+			else {
+				as_pack_nil(pk);
+			}
+			break;
+		case _AS_EXP_CODE_CDT_MAP_CRMOD:
+		case _AS_EXP_CODE_CDT_MAP_CR:
+		case _AS_EXP_CODE_CDT_MAP_MOD:
+			if (entry->v.map_pol != NULL) {
+				as_pack_uint64(pk, (uint64_t)entry->v.map_pol->attributes);
+				as_pack_uint64(pk, (uint64_t)entry->v.map_pol->flags);
+			}
+			else {
+				as_pack_nil(pk);
+			}
+			break;
+		case _AS_EXP_CODE_AS_VAL:
+		case _AS_EXP_CODE_VAL_GEO:
+			as_pack_val(pk, entry->v.val);
+			break;
+		case _AS_EXP_CODE_VAL_RTYPE:
+		case _AS_EXP_CODE_VAL_INT:
+			as_pack_int64(pk, entry->v.int_val);
+			break;
+		case _AS_EXP_CODE_VAL_UINT:
+			as_pack_uint64(pk, entry->v.uint_val);
+			break;
+		case _AS_EXP_CODE_VAL_FLOAT:
+			as_pack_double(pk, entry->v.float_val);
+			break;
+		case _AS_EXP_CODE_VAL_BOOL:
+			as_pack_bool(pk, entry->v.bool_val);
+			break;
+		case _AS_EXP_CODE_VAL_STR:
+		case _AS_EXP_CODE_VAL_RAWSTR:
+			as_pack_str(pk, (const uint8_t*)entry->v.str_val,
+				(uint32_t)strlen(entry->v.str_val));
+			break;
+		case _AS_EXP_CODE_VAL_BYTES:
+			as_pack_str(pk, entry->v.bytes_val, entry->sz);
+			break;
+		case _AS_EXP_CODE_VAL_PARAM_INT:
+		case _AS_EXP_CODE_VAL_PARAM_FLOAT:
+			as_pack_uint64(pk, entry->sz);
+			break;
+		case _AS_EXP_CODE_CALL_VOP_START:
+			if (entry->v.ctx == NULL) {
+				as_pack_nil(pk);
+				break;
+			}
+
+			as_pack_list_header(pk, entry->v.ctx->list.size);
+
+			for (uint32_t j = 0; j < entry->v.ctx->list.size; j++) {
+				as_cdt_ctx_item* item = as_vector_get(&entry->v.ctx->list, j);
+
+				as_pack_uint64(pk, item->type);
+
+				if (item->type & AS_CDT_CTX_VALUE) {
+					as_pack_val(pk, item->val.pval);
+				}
+				else {
+					as_pack_int64(pk, item->val.ival);
+				}
+			}
+			break;
+		case _AS_EXP_CODE_MERGE:
+			as_pack_str(pk, entry->v.expr->packed, entry->v.expr->packed_sz);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static uint64_t
+as_exp_key_hash(const uint8_t* key, uint32_t len)
+{
+	// Multiply and xor shift hash over 8 byte words.
+	const uint64_t m = 0x9E3779B97F4A7C15ULL;
+	uint64_t h = len * m;
+	uint32_t i = 0;
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t v;
+		memcpy(&v, key + i, sizeof(v));
+		h = (h ^ v) * m;
+		h ^= h >> 29;
+	}
+
+	if (i < len) {
+		uint64_t v = 0;
+		memcpy(&v, key + i, len - i);
+		h = (h ^ v) * m;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+static bool
+as_exp_slots_valid(const as_exp_slot* slots, uint32_t n_slots, uint32_t n_params)
+{
+	for (uint32_t i = 0; i < n_slots; i++) {
+		if (slots[i].index >= n_params) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+as_exp_slots_patch(
+	uint8_t* packed, const as_exp_slot* slots, uint32_t n_slots, const as_exp_param* params
+	)
+{
+	for (uint32_t i = 0; i < n_slots; i++) {
+		const as_exp_slot* slot = &slots[i];
+		const as_exp_param* param = &params[slot->index];
+		uint64_t bits;
+
+		if (slot->is_float) {
+			memcpy(&bits, &param->float_val, sizeof(bits));
+		}
+		else {
+			bits = (uint64_t)param->int_val;
+		}
+
+		bits = cf_swap_to_be64(bits);
+		memcpy(packed + slot->offset, &bits, sizeof(bits));
+	}
+}
+
+static as_exp_cache_entry*
+as_exp_cache_find(uint64_t hash, const uint8_t* key, uint32_t key_sz)
+{
+	as_exp_cache_entry* ce = as_exp_cache[hash % AS_EXP_CACHE_BUCKETS];
+
+	while (ce) {
+		if (ce->hash == hash && ce->key_sz == key_sz && memcmp(ce->key, key, key_sz) == 0) {
+			return ce;
+		}
+		ce = ce->next;
+	}
+	return NULL;
+}
+
+static void
+as_exp_cache_entry_destroy(as_exp_cache_entry* ce)
+{
+	as_exp_release(ce->exp);
+	cf_free(ce->slots);
+	cf_free(ce);
+}
+
+static as_exp*
+as_exp_cache_take(as_exp_cache_entry* ce, const as_exp_param* params, uint32_t n_params)
+{
+	if (ce->n_slots == 0) {
+		as_incr_uint32(&as_exp_shared_get(ce->exp)->ref_count);
+		return ce->exp;
+	}
+
+	if (! as_exp_slots_valid(ce->slots, ce->n_slots, n_params)) {
+		return NULL;
+	}
+
+	as_exp* exp = as_exp_shared_create(ce->exp->packed_sz);
+	memcpy(exp->packed, ce->exp->packed, exp->packed_sz);
+	as_exp_slots_patch(exp->packed, ce->slots, ce->n_slots, params);
+	return exp;
+}
+
+as_exp*
+as_exp_compile_cached(
+	as_exp_entry* table, uint32_t n, const as_exp_param* params, uint32_t n_params
+	)
+{
+	as_packer pk = {
+			.buffer = NULL,
+			.capacity = UINT32_MAX
+	};
+
+	as_exp_key_pack(&pk, table, n);
+
+	uint8_t stack_key[1024];
+	uint32_t key_sz = pk.offset;
+	uint8_t* key = (key_sz <= sizeof(stack_key)) ? stack_key : cf_malloc(key_sz);
+
+	pk.buffer = key;
+	pk.offset = 0;
+	pk.capacity = key_sz;
+	as_exp_key_pack(&pk, table, n);
+
+	uint64_t hash = as_exp_key_hash(key, key_sz);
+	as_exp* exp = NULL;
+
+	pthread_mutex_lock(&as_exp_cache_lock);
+	as_exp_cache_entry* ce = as_exp_cache_find(hash, key, key_sz);
+
+	if (ce) {
+		exp = as_exp_cache_take(ce, params, n_params);
+	}
+	pthread_mutex_unlock(&as_exp_cache_lock);
+
+	if (ce) {
+		// Destroy geo values because they were created internally.
+		for (uint32_t i = 0; i < n; i++) {
+			if (table[i].op == _AS_EXP_CODE_VAL_GEO) {
+				as_val_destroy(table[i].v.val);
+			}
+		}
+
+		if (key != stack_key) {
+			cf_free(key);
+		}
+		return exp;
+	}
+
+	uint32_t total_sz;
+	uint32_t n_slots;
+
+	if (! as_exp_size(table, n, &total_sz, &n_slots)) {
+		if (key != stack_key) {
+			cf_free(key);
+		}
+		return NULL;
+	}
+
+	ce = cf_malloc(sizeof(as_exp_cache_entry) + key_sz);
+	ce->next = NULL;
+	ce->exp = as_exp_shared_create(total_sz);
+	ce->slots = n_slots ? cf_malloc(sizeof(as_exp_slot) * n_slots) : NULL;
+	ce->hash = hash;
+	ce->n_slots = n_slots;
+	ce->key_sz = key_sz;
+	memcpy(ce->key, key, key_sz);
+
+	if (key != stack_key) {
+		cf_free(key);
+	}
+
+	as_exp_pack(table, n, ce->exp, ce->slots);
+
+	pthread_mutex_lock(&as_exp_cache_lock);
+	as_exp_cache_entry* found = as_exp_cache_find(hash, ce->key, key_sz);
+
+	if (found) {
+		// Another thread compiled the same expression first.
+		exp = as_exp_cache_take(found, params, n_params);
+	}
+	else {
+		exp = as_exp_cache_take(ce, params, n_params);
+
+		if (as_exp_cache_size < AS_EXP_CACHE_MAX) {
+			as_exp_cache_entry** bucket = &as_exp_cache[hash % AS_EXP_CACHE_BUCKETS];
+			ce->next = *bucket;
+			*bucket = ce;
+			as_exp_cache_size++;
+			ce = NULL;
+		}
+	}
+	pthread_mutex_unlock(&as_exp_cache_lock);
+
+	if (ce) {
+		as_exp_cache_entry_destroy(ce);
+	}
+	return exp;
+}
+
+void
+as_exp_release(as_exp* exp)
+{
+	if (exp == NULL) {
+		return;
+	}
+
+	as_exp_shared* shared = as_exp_shared_get(exp);
+
+	if (as_aaf_uint32(&shared->ref_count, -1) == 0) {
+		cf_free(shared);
+	}
+}
+
+as_exp_template*
+as_exp_compile_template(as_exp_entry* table, uint32_t n)
+{
+	uint32_t total_sz;
+	uint32_t n_slots;
+
+	if (! as_exp_size(table, n, &total_sz, &n_slots)) {
+		return NULL;
+	}
+
+	as_exp_template* tmpl = cf_malloc(sizeof(as_exp_template) + sizeof(as_exp_slot) * n_slots);
+	tmpl->exp = cf_malloc(sizeof(as_exp) + total_sz);
+	tmpl->exp->packed_sz = total_sz;
+	tmpl->n_slots = n_slots;
+	as_exp_pack(table, n, tmpl->exp, tmpl->slots);
+	return tmpl;
+}
+
+as_exp*
+as_exp_bind(const as_exp_template* tmpl, const as_exp_param* params, uint32_t n_params)
+{
+	if (! as_exp_slots_valid(tmpl->slots, tmpl->n_slots, n_params)) {
+		return NULL;
+	}
+
+	uint32_t sz = tmpl->exp->packed_sz;
+	as_exp* exp = cf_malloc(sizeof(as_exp) + sz);
+
+	exp->packed_sz = sz;
+	memcpy(exp->packed, tmpl->exp->packed, sz);
+	as_exp_slots_patch(exp->packed, tmpl->slots, tmpl->n_slots, params);
+	return exp;
+}
+
+bool
+as_exp_rebind(
+	const as_exp_template* tmpl, as_exp* exp, const as_exp_param* params, uint32_t n_params
+	)
+{
+	if (exp->packed_sz != tmpl->exp->packed_sz ||
+		! as_exp_slots_valid(tmpl->slots, tmpl->n_slots, n_params)) {
+		return false;
+	}
+
+	as_exp_slots_patch(exp->packed, tmpl->slots, tmpl->n_slots, params);
+	return true;
+}
+
+void
+as_exp_template_destroy(as_exp_template* tmpl)
+{
+	if (tmpl == NULL) {
+		return;
+	}
+
+	cf_free(tmpl->exp);
+	cf_free(tmpl);
+}
+
+void
+as_exp_cache_clear(void)
+{
+	pthread_mutex_lock(&as_exp_cache_lock);
+
+	for (uint32_t i = 0; i < AS_EXP_CACHE_BUCKETS; i++) {
+		as_exp_cache_entry* ce = as_exp_cache[i];
+
+		while (ce) {
+			as_exp_cache_entry* next = ce->next;
+			as_exp_cache_entry_destroy(ce);
+			ce = next;
+		}
+		as_exp_cache[i] = NULL;
+	}
+	as_exp_cache_size = 0;
+	pthread_mutex_unlock(&as_exp_cache_lock);
+}
+
 char*
 as_exp_compile_b64(as_exp* exp)
 {
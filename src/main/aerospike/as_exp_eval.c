@@ -0,0 +1,1407 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_exp_eval.h>
+#include <aerospike/as_boolean.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_cdt_ctx.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_geojson.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_nil.h>
+#include <aerospike/as_string.h>
+#include <math.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_EXP_EVAL_MAX_DEPTH 64
+#define AS_EXP_EVAL_MAX_VARS 16
+#define AS_EXP_EVAL_MAX_CTX 8
+#define AS_EXP_EVAL_CDT_CONTEXT 0xff
+#define AS_EXP_EVAL_CTX_TYPE_MASK 0x3f
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_exp_var_s {
+	const uint8_t* name;
+	uint32_t name_sz;
+	as_val* val; // NULL if unknown.
+} as_exp_var;
+
+typedef struct as_exp_eval_ctx_s {
+	as_unpacker pk;
+	as_error* err;
+	const as_record* rec;
+	as_exp_var vars[AS_EXP_EVAL_MAX_VARS];
+	uint32_t n_vars;
+	uint32_t depth;
+} as_exp_eval_ctx;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_status
+as_exp_eval_next(as_exp_eval_ctx* ctx, as_val** out);
+
+static inline as_val*
+as_exp_val_reserve(as_val* v)
+{
+	// Nil is a static singleton.
+	return (as_val_type(v) == AS_NIL) ? v : as_val_reserve(v);
+}
+
+static inline void
+as_exp_val_release(as_val* v)
+{
+	if (v) {
+		as_val_destroy(v);
+	}
+}
+
+static inline as_val*
+as_exp_val_bool(bool b)
+{
+	return (as_val*)as_boolean_new(b);
+}
+
+static inline as_val*
+as_exp_val_int(int64_t i)
+{
+	return (as_val*)as_integer_new(i);
+}
+
+static inline as_val*
+as_exp_val_float(double d)
+{
+	return (as_val*)as_double_new(d);
+}
+
+static as_status
+as_exp_invalid(as_exp_eval_ctx* ctx)
+{
+	return as_error_update(ctx->err, AEROSPIKE_ERR_PARAM, "Invalid expression at offset %u",
+		ctx->pk.offset);
+}
+
+static as_status
+as_exp_unsupported(as_exp_eval_ctx* ctx, int64_t op)
+{
+	return as_error_update(ctx->err, AEROSPIKE_ERR_UNSUPPORTED_FEATURE,
+		"Expression op %d must be evaluated by the server", (int)op);
+}
+
+static as_status
+as_exp_skip(as_exp_eval_ctx* ctx, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		if (as_unpack_size(&ctx->pk) < 0) {
+			return as_exp_invalid(ctx);
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_args(as_exp_eval_ctx* ctx, uint32_t n, uint32_t expected, as_val** vals)
+{
+	// Evaluate fixed number of arguments. Unknown arguments are returned as NULL.
+	if (n != expected) {
+		return as_exp_invalid(ctx);
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_status status = as_exp_eval_next(ctx, &vals[i]);
+
+		if (status != AEROSPIKE_OK) {
+			for (uint32_t j = 0; j < i; j++) {
+				as_exp_val_release(vals[j]);
+			}
+			return status;
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+static void
+as_exp_release_args(as_val** vals, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		as_exp_val_release(vals[i]);
+	}
+}
+
+static inline bool
+as_exp_args_known(as_val** vals, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		if (! vals[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static inline bool
+as_exp_args_type(as_val** vals, uint32_t n, as_val_t type)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		if (as_val_type(vals[i]) != type) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int
+as_exp_mem_compare(const void* a, size_t a_sz, const void* b, size_t b_sz)
+{
+	int rv = memcmp(a, b, (a_sz < b_sz) ? a_sz : b_sz);
+
+	if (rv != 0) {
+		return rv;
+	}
+	return (a_sz < b_sz) ? -1 : (a_sz > b_sz) ? 1 : 0;
+}
+
+static bool
+as_exp_compare(const as_val* a, const as_val* b, int* cmp)
+{
+	// Only values of the same scalar type are compared locally. Mixed types and
+	// collections are compared by the server's msgpack ordering.
+	if (as_val_type(a) != as_val_type(b)) {
+		return false;
+	}
+
+	switch (as_val_type(a)) {
+		case AS_NIL:
+			*cmp = 0;
+			return true;
+
+		case AS_BOOLEAN: {
+			bool x = as_boolean_get((as_boolean*)a);
+			bool y = as_boolean_get((as_boolean*)b);
+			*cmp = (int)x - (int)y;
+			return true;
+		}
+
+		case AS_INTEGER: {
+			int64_t x = as_integer_get((as_integer*)a);
+			int64_t y = as_integer_get((as_integer*)b);
+			*cmp = (x < y) ? -1 : (x > y) ? 1 : 0;
+			return true;
+		}
+
+		case AS_DOUBLE: {
+			double x = as_double_get((as_double*)a);
+			double y = as_double_get((as_double*)b);
+
+			if (isnan(x) || isnan(y)) {
+				return false;
+			}
+			*cmp = (x < y) ? -1 : (x > y) ? 1 : 0;
+			return true;
+		}
+
+		case AS_STRING: {
+			as_string* x = (as_string*)a;
+			as_string* y = (as_string*)b;
+			*cmp = as_exp_mem_compare(x->value, as_string_len(x), y->value, as_string_len(y));
+			return true;
+		}
+
+		case AS_BYTES: {
+			as_bytes* x = (as_bytes*)a;
+			as_bytes* y = (as_bytes*)b;
+
+			if (x->type != y->type) {
+				return false;
+			}
+			*cmp = as_exp_mem_compare(x->value, x->size, y->value, y->size);
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+static as_status
+as_exp_eval_cmp(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	as_val* vals[2];
+	as_status status = as_exp_eval_args(ctx, n, 2, vals);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (! as_exp_args_known(vals, 2)) {
+		as_exp_release_args(vals, 2);
+		*out = NULL;
+		return AEROSPIKE_OK;
+	}
+
+	int cmp;
+	bool ok = as_exp_compare(vals[0], vals[1], &cmp);
+	as_exp_release_args(vals, 2);
+
+	if (! ok) {
+		return as_exp_unsupported(ctx, op);
+	}
+
+	bool b;
+
+	switch (op) {
+		case _AS_EXP_CODE_CMP_EQ:
+			b = cmp == 0;
+			break;
+		case _AS_EXP_CODE_CMP_NE:
+			b = cmp != 0;
+			break;
+		case _AS_EXP_CODE_CMP_GT:
+			b = cmp > 0;
+			break;
+		case _AS_EXP_CODE_CMP_GE:
+			b = cmp >= 0;
+			break;
+		case _AS_EXP_CODE_CMP_LT:
+			b = cmp < 0;
+			break;
+		default:
+			b = cmp <= 0;
+			break;
+	}
+	*out = as_exp_val_bool(b);
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_bool(as_exp_eval_ctx* ctx, int64_t op, bool* b, bool* known)
+{
+	as_val* v;
+	as_status status = as_exp_eval_next(ctx, &v);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (! v) {
+		*known = false;
+		return AEROSPIKE_OK;
+	}
+
+	if (as_val_type(v) != AS_BOOLEAN) {
+		as_val_destroy(v);
+		return as_exp_unsupported(ctx, op);
+	}
+
+	*b = as_boolean_get((as_boolean*)v);
+	*known = true;
+	as_val_destroy(v);
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_logic(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	// A false "and" argument or a true "or" argument decides the result even when other
+	// arguments are unknown.
+	bool decisive = (op == _AS_EXP_CODE_OR);
+	bool unknown = false;
+
+	for (uint32_t i = 0; i < n; i++) {
+		bool b;
+		bool known;
+		as_status status = as_exp_eval_bool(ctx, op, &b, &known);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (! known) {
+			unknown = true;
+			continue;
+		}
+
+		if (b == decisive) {
+			status = as_exp_skip(ctx, n - i - 1);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+			*out = as_exp_val_bool(decisive);
+			return AEROSPIKE_OK;
+		}
+	}
+
+	*out = unknown ? NULL : as_exp_val_bool(! decisive);
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_not(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	if (n != 1) {
+		return as_exp_invalid(ctx);
+	}
+
+	bool b;
+	bool known;
+	as_status status = as_exp_eval_bool(ctx, _AS_EXP_CODE_NOT, &b, &known);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	*out = known ? as_exp_val_bool(! b) : NULL;
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_exclusive(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	uint32_t n_true = 0;
+	bool unknown = false;
+
+	for (uint32_t i = 0; i < n; i++) {
+		bool b;
+		bool known;
+		as_status status = as_exp_eval_bool(ctx, _AS_EXP_CODE_EXCLUSIVE, &b, &known);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (! known) {
+			unknown = true;
+		}
+		else if (b) {
+			n_true++;
+		}
+	}
+
+	*out = unknown ? NULL : as_exp_val_bool(n_true == 1);
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_fold(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	// Variable argument arithmetic, min/max and integer bitwise operators.
+	bool int_only = (op == _AS_EXP_CODE_INT_AND || op == _AS_EXP_CODE_INT_OR ||
+		op == _AS_EXP_CODE_INT_XOR);
+	as_val_t type = AS_UNDEF;
+	bool unknown = false;
+	uint64_t iv = 0;
+	uint64_t iprod = 1;
+	double dv = 0.0;
+	double dprod = 1.0;
+
+	if (n == 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_val* v;
+		as_status status = as_exp_eval_next(ctx, &v);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (! v) {
+			unknown = true;
+			continue;
+		}
+
+		as_val_t t = as_val_type(v);
+
+		if (! (t == AS_INTEGER || (t == AS_DOUBLE && ! int_only)) ||
+			(type != AS_UNDEF && t != type)) {
+			as_val_destroy(v);
+			return as_exp_unsupported(ctx, op);
+		}
+		type = t;
+
+		uint64_t x = 0;
+		double d = 0.0;
+
+		if (t == AS_INTEGER) {
+			x = (uint64_t)as_integer_get((as_integer*)v);
+		}
+		else {
+			d = as_double_get((as_double*)v);
+		}
+		as_val_destroy(v);
+
+		if (i == 0) {
+			iv = x;
+			dv = d;
+			continue;
+		}
+
+		// Integer arithmetic wraps like the server.
+		switch (op) {
+			case _AS_EXP_CODE_ADD:
+				iv += x;
+				dv += d;
+				break;
+			case _AS_EXP_CODE_SUB:
+				iv -= x;
+				dv -= d;
+				break;
+			case _AS_EXP_CODE_MUL:
+				iv *= x;
+				dv *= d;
+				break;
+			case _AS_EXP_CODE_DIV:
+				iprod *= x;
+				dprod *= d;
+				break;
+			case _AS_EXP_CODE_MIN:
+				if ((int64_t)x < (int64_t)iv) {
+					iv = x;
+				}
+				if (d < dv) {
+					dv = d;
+				}
+				break;
+			case _AS_EXP_CODE_MAX:
+				if ((int64_t)x > (int64_t)iv) {
+					iv = x;
+				}
+				if (d > dv) {
+					dv = d;
+				}
+				break;
+			case _AS_EXP_CODE_INT_AND:
+				iv &= x;
+				break;
+			case _AS_EXP_CODE_INT_OR:
+				iv |= x;
+				break;
+			default:
+				iv ^= x;
+				break;
+		}
+	}
+
+	if (unknown) {
+		*out = NULL;
+		return AEROSPIKE_OK;
+	}
+
+	if (n == 1) {
+		if (op == _AS_EXP_CODE_SUB) {
+			iv = 0 - iv;
+			dv = -dv;
+		}
+		else if (op == _AS_EXP_CODE_DIV) {
+			// Reciprocal.
+			iprod = iv;
+			iv = 1;
+			dprod = dv;
+			dv = 1.0;
+		}
+	}
+
+	if (op == _AS_EXP_CODE_DIV) {
+		if (type == AS_INTEGER) {
+			if (iprod == 0 || ((int64_t)iprod == -1 && (int64_t)iv == INT64_MIN)) {
+				return as_exp_unsupported(ctx, op);
+			}
+			iv = (uint64_t)((int64_t)iv / (int64_t)iprod);
+		}
+		else {
+			dv /= dprod;
+		}
+	}
+
+	*out = (type == AS_INTEGER) ? as_exp_val_int((int64_t)iv) : as_exp_val_float(dv);
+	return AEROSPIKE_OK;
+}
+
+static int64_t
+as_exp_bit_scan(uint64_t v, bool search, bool from_left)
+{
+	// Bit index 0 is the most significant bit.
+	if (! search) {
+		v = ~v;
+	}
+
+	if (v == 0) {
+		return -1;
+	}
+
+	if (from_left) {
+		int64_t i = 0;
+
+		while (! (v & 0x8000000000000000ULL)) {
+			v <<= 1;
+			i++;
+		}
+		return i;
+	}
+
+	int64_t i = 63;
+
+	while (! (v & 1)) {
+		v >>= 1;
+		i--;
+	}
+	return i;
+}
+
+static as_status
+as_exp_eval_num(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	// Fixed argument numeric operators.
+	uint32_t expected;
+
+	switch (op) {
+		case _AS_EXP_CODE_POW:
+		case _AS_EXP_CODE_LOG:
+		case _AS_EXP_CODE_MOD:
+		case _AS_EXP_CODE_INT_LSHIFT:
+		case _AS_EXP_CODE_INT_RSHIFT:
+		case _AS_EXP_CODE_INT_ARSHIFT:
+		case _AS_EXP_CODE_INT_LSCAN:
+		case _AS_EXP_CODE_INT_RSCAN:
+			expected = 2;
+			break;
+		default:
+			expected = 1;
+			break;
+	}
+
+	as_val* vals[2] = {NULL, NULL};
+	as_status status = as_exp_eval_args(ctx, n, expected, vals);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (! as_exp_args_known(vals, n)) {
+		as_exp_release_args(vals, n);
+		*out = NULL;
+		return AEROSPIKE_OK;
+	}
+
+	as_val* a = vals[0];
+	as_val* b = vals[1]; // Only valid when n == 2.
+	as_val* result = NULL;
+
+	switch (op) {
+		case _AS_EXP_CODE_POW:
+		case _AS_EXP_CODE_LOG:
+			if (as_exp_args_type(vals, n, AS_DOUBLE)) {
+				double x = as_double_get((as_double*)a);
+				double y = as_double_get((as_double*)b);
+				result = as_exp_val_float((op == _AS_EXP_CODE_POW) ? pow(x, y) :
+					log(x) / log(y));
+			}
+			break;
+
+		case _AS_EXP_CODE_MOD:
+			if (as_exp_args_type(vals, n, AS_INTEGER)) {
+				int64_t x = as_integer_get((as_integer*)a);
+				int64_t y = as_integer_get((as_integer*)b);
+
+				if (y != 0) {
+					result = as_exp_val_int((y == -1) ? 0 : x % y);
+				}
+			}
+			break;
+
+		case _AS_EXP_CODE_ABS:
+			if (as_val_type(a) == AS_INTEGER) {
+				int64_t x = as_integer_get((as_integer*)a);
+
+				if (x != INT64_MIN) {
+					result = as_exp_val_int((x < 0) ? -x : x);
+				}
+			}
+			else if (as_val_type(a) == AS_DOUBLE) {
+				result = as_exp_val_float(fabs(as_double_get((as_double*)a)));
+			}
+			break;
+
+		case _AS_EXP_CODE_FLOOR:
+		case _AS_EXP_CODE_CEIL:
+			if (as_val_type(a) == AS_DOUBLE) {
+				double x = as_double_get((as_double*)a);
+				result = as_exp_val_float((op == _AS_EXP_CODE_FLOOR) ? floor(x) : ceil(x));
+			}
+			break;
+
+		case _AS_EXP_CODE_TO_INT:
+			if (as_val_type(a) == AS_DOUBLE) {
+				double x = as_double_get((as_double*)a);
+
+				if (x >= -9223372036854775808.0 && x < 9223372036854775808.0) {
+					result = as_exp_val_int((int64_t)x);
+				}
+			}
+			break;
+
+		case _AS_EXP_CODE_TO_FLOAT:
+			if (as_val_type(a) == AS_INTEGER) {
+				result = as_exp_val_float((double)as_integer_get((as_integer*)a));
+			}
+			break;
+
+		case _AS_EXP_CODE_INT_NOT:
+			if (as_val_type(a) == AS_INTEGER) {
+				result = as_exp_val_int(~as_integer_get((as_integer*)a));
+			}
+			break;
+
+		case _AS_EXP_CODE_INT_COUNT:
+			if (as_val_type(a) == AS_INTEGER) {
+				uint64_t x = (uint64_t)as_integer_get((as_integer*)a);
+				int64_t count = 0;
+
+				while (x) {
+					x &= x - 1;
+					count++;
+				}
+				result = as_exp_val_int(count);
+			}
+			break;
+
+		case _AS_EXP_CODE_INT_LSHIFT:
+		case _AS_EXP_CODE_INT_RSHIFT:
+		case _AS_EXP_CODE_INT_ARSHIFT:
+			if (as_exp_args_type(vals, n, AS_INTEGER)) {
+				int64_t x = as_integer_get((as_integer*)a);
+				int64_t s = as_integer_get((as_integer*)b);
+
+				if (s < 0 || s > 63) {
+					break;
+				}
+
+				if (op == _AS_EXP_CODE_INT_LSHIFT) {
+					result = as_exp_val_int((int64_t)((uint64_t)x << s));
+				}
+				else if (op == _AS_EXP_CODE_INT_RSHIFT || x >= 0) {
+					result = as_exp_val_int((int64_t)((uint64_t)x >> s));
+				}
+				else {
+					result = as_exp_val_int((int64_t)~(~(uint64_t)x >> s));
+				}
+			}
+			break;
+
+		case _AS_EXP_CODE_INT_LSCAN:
+		case _AS_EXP_CODE_INT_RSCAN:
+			if (as_val_type(a) == AS_INTEGER && as_val_type(b) == AS_BOOLEAN) {
+				uint64_t x = (uint64_t)as_integer_get((as_integer*)a);
+				bool search = as_boolean_get((as_boolean*)b);
+				result = as_exp_val_int(as_exp_bit_scan(x, search, op == _AS_EXP_CODE_INT_LSCAN));
+			}
+			break;
+	}
+
+	as_exp_release_args(vals, n);
+
+	if (! result) {
+		// Type mismatch, division by zero or out of range operand.
+		return as_exp_unsupported(ctx, op);
+	}
+	*out = result;
+	return AEROSPIKE_OK;
+}
+
+static bool
+as_exp_val_is(const as_val* v, int64_t type)
+{
+	as_val_t t = as_val_type(v);
+
+	switch (type) {
+		case AS_EXP_TYPE_NIL:
+			return t == AS_NIL;
+		case AS_EXP_TYPE_BOOL:
+			return t == AS_BOOLEAN;
+		case AS_EXP_TYPE_INT:
+			return t == AS_INTEGER;
+		case AS_EXP_TYPE_STR:
+			return t == AS_STRING;
+		case AS_EXP_TYPE_LIST:
+			return t == AS_LIST;
+		case AS_EXP_TYPE_MAP:
+			return t == AS_MAP;
+		case AS_EXP_TYPE_BLOB:
+			return t == AS_BYTES && ((as_bytes*)v)->type != AS_BYTES_HLL;
+		case AS_EXP_TYPE_FLOAT:
+			return t == AS_DOUBLE;
+		case AS_EXP_TYPE_GEOJSON:
+			return t == AS_GEOJSON;
+		case AS_EXP_TYPE_HLL:
+			return t == AS_BYTES && ((as_bytes*)v)->type == AS_BYTES_HLL;
+		default:
+			return false;
+	}
+}
+
+static int64_t
+as_exp_particle_type(const as_val* v)
+{
+	if (! v) {
+		return AS_BYTES_UNDEF;
+	}
+
+	switch (as_val_type(v)) {
+		case AS_INTEGER:
+			return AS_BYTES_INTEGER;
+		case AS_DOUBLE:
+			return AS_BYTES_DOUBLE;
+		case AS_STRING:
+			return AS_BYTES_STRING;
+		case AS_BYTES:
+			return ((as_bytes*)v)->type;
+		case AS_BOOLEAN:
+			return AS_BYTES_BOOL;
+		case AS_MAP:
+			return AS_BYTES_MAP;
+		case AS_LIST:
+			return AS_BYTES_LIST;
+		case AS_GEOJSON:
+			return AS_BYTES_GEOJSON;
+		default:
+			return AS_BYTES_UNDEF;
+	}
+}
+
+static as_status
+as_exp_unpack_name(as_exp_eval_ctx* ctx, const uint8_t** name, uint32_t* name_sz)
+{
+	*name = as_unpack_str(&ctx->pk, name_sz);
+	return *name ? AEROSPIKE_OK : as_exp_invalid(ctx);
+}
+
+static as_val*
+as_exp_bin_get(as_exp_eval_ctx* ctx, const uint8_t* name, uint32_t name_sz)
+{
+	if (name_sz >= AS_BIN_NAME_MAX_SIZE) {
+		return NULL;
+	}
+
+	as_bin_name bin_name;
+	memcpy(bin_name, name, name_sz);
+	bin_name[name_sz] = 0;
+	return (as_val*)as_record_get(ctx->rec, bin_name);
+}
+
+static as_status
+as_exp_eval_bin(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	int64_t type = AS_EXP_TYPE_AUTO;
+
+	if (op == _AS_EXP_CODE_BIN) {
+		if (n != 2 || as_unpack_int64(&ctx->pk, &type) != 0) {
+			return as_exp_invalid(ctx);
+		}
+	}
+	else if (n != 1) {
+		return as_exp_invalid(ctx);
+	}
+
+	const uint8_t* name;
+	uint32_t name_sz;
+	as_status status = as_exp_unpack_name(ctx, &name, &name_sz);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_val* v = as_exp_bin_get(ctx, name, name_sz);
+
+	if (op == _AS_EXP_CODE_BIN_TYPE) {
+		*out = as_exp_val_int(as_exp_particle_type(v));
+		return AEROSPIKE_OK;
+	}
+
+	// Missing bins and bins of another type are unknown.
+	*out = (v && as_exp_val_is(v, type)) ? as_exp_val_reserve(v) : NULL;
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_exp_eval_meta(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	const as_record* rec = ctx->rec;
+
+	switch (op) {
+		case _AS_EXP_CODE_KEY: {
+			int64_t type;
+
+			if (n != 1 || as_unpack_int64(&ctx->pk, &type) != 0) {
+				return as_exp_invalid(ctx);
+			}
+
+			// Records are often returned without the user key even when it is stored.
+			as_val* v = (as_val*)rec->key.valuep;
+
+			if (! v) {
+				return as_exp_unsupported(ctx, op);
+			}
+			*out = as_exp_val_is(v, type) ? as_exp_val_reserve(v) : NULL;
+			return AEROSPIKE_OK;
+		}
+
+		case _AS_EXP_CODE_KEY_EXIST:
+			if (! rec->key.valuep) {
+				return as_exp_unsupported(ctx, op);
+			}
+			*out = as_exp_val_bool(true);
+			return AEROSPIKE_OK;
+
+		case _AS_EXP_CODE_SET_NAME:
+			if (rec->key.set[0] == 0) {
+				return as_exp_unsupported(ctx, op);
+			}
+			*out = (as_val*)as_string_new_strdup(rec->key.set);
+			return AEROSPIKE_OK;
+
+		case _AS_EXP_CODE_TTL:
+			*out = as_exp_val_int((rec->ttl == AS_RECORD_NO_EXPIRE_TTL) ? -1 : rec->ttl);
+			return AEROSPIKE_OK;
+
+		case _AS_EXP_CODE_IS_TOMBSTONE:
+			// Client records are always live.
+			*out = as_exp_val_bool(false);
+			return AEROSPIKE_OK;
+
+		default:
+			return as_exp_unsupported(ctx, op);
+	}
+}
+
+static as_status
+as_exp_eval_cond(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	// [cond1, action1, cond2, action2, ..., default]
+	if (n < 3 || (n & 1) == 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	as_status status;
+
+	for (uint32_t i = 0; i + 1 < n; i += 2) {
+		bool b;
+		bool known;
+		status = as_exp_eval_bool(ctx, _AS_EXP_CODE_COND, &b, &known);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (! known) {
+			*out = NULL;
+			return as_exp_skip(ctx, n - i - 1);
+		}
+
+		if (b) {
+			status = as_exp_eval_next(ctx, out);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+
+			status = as_exp_skip(ctx, n - i - 2);
+
+			if (status != AEROSPIKE_OK) {
+				as_exp_val_release(*out);
+			}
+			return status;
+		}
+
+		status = as_exp_skip(ctx, 1);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+	return as_exp_eval_next(ctx, out);
+}
+
+static as_status
+as_exp_eval_let(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	// [name1, exp1, name2, exp2, ..., scope]
+	if ((n & 1) == 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	uint32_t base = ctx->n_vars;
+	as_status status = AEROSPIKE_OK;
+
+	for (uint32_t i = 0; i + 1 < n; i += 2) {
+		if (ctx->n_vars >= AS_EXP_EVAL_MAX_VARS) {
+			status = as_exp_unsupported(ctx, _AS_EXP_CODE_LET);
+			break;
+		}
+
+		as_exp_var* var = &ctx->vars[ctx->n_vars];
+		status = as_exp_unpack_name(ctx, &var->name, &var->name_sz);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+
+		status = as_exp_eval_next(ctx, &var->val);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+		ctx->n_vars++;
+	}
+
+	if (status == AEROSPIKE_OK) {
+		status = as_exp_eval_next(ctx, out);
+	}
+
+	while (ctx->n_vars > base) {
+		as_exp_val_release(ctx->vars[--ctx->n_vars].val);
+	}
+	return status;
+}
+
+static as_status
+as_exp_eval_var(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	if (n != 1) {
+		return as_exp_invalid(ctx);
+	}
+
+	const uint8_t* name;
+	uint32_t name_sz;
+	as_status status = as_exp_unpack_name(ctx, &name, &name_sz);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	// Inner scopes shadow outer scopes.
+	for (uint32_t i = ctx->n_vars; i > 0; i--) {
+		as_exp_var* var = &ctx->vars[i - 1];
+
+		if (var->name_sz == name_sz && memcmp(var->name, name, name_sz) == 0) {
+			*out = var->val ? as_exp_val_reserve(var->val) : NULL;
+			return AEROSPIKE_OK;
+		}
+	}
+	return as_exp_invalid(ctx);
+}
+
+static as_val*
+as_exp_list_at(as_val* v, const as_val* index)
+{
+	if (as_val_type(v) != AS_LIST || as_val_type(index) != AS_INTEGER) {
+		return NULL;
+	}
+
+	as_list* list = (as_list*)v;
+	int64_t size = as_list_size(list);
+	int64_t i = as_integer_get((as_integer*)index);
+
+	if (i < 0) {
+		i += size;
+	}
+
+	if (i < 0 || i >= size) {
+		return NULL;
+	}
+	return as_list_get(list, (uint32_t)i);
+}
+
+static as_status
+as_exp_cdt_apply(
+	as_exp_eval_ctx* ctx, int64_t op, as_val** levels, uint32_t n_levels, as_val** args,
+	as_val* bin, as_val** out
+	)
+{
+	// Walk context path. Elements are owned by the bin value.
+	as_val* v = bin;
+
+	for (uint32_t i = 0; i < n_levels && v; i += 2) {
+		if (as_val_type(levels[i]) != AS_INTEGER) {
+			return as_exp_invalid(ctx);
+		}
+
+		int64_t type = as_integer_get((as_integer*)levels[i]) & AS_EXP_EVAL_CTX_TYPE_MASK;
+
+		if (type == AS_CDT_CTX_LIST_INDEX) {
+			v = as_exp_list_at(v, levels[i + 1]);
+		}
+		else if (type == AS_CDT_CTX_MAP_KEY) {
+			v = (as_val_type(v) == AS_MAP) ? as_map_get((as_map*)v, levels[i + 1]) : NULL;
+		}
+		else {
+			return as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+		}
+	}
+
+	if (! v) {
+		*out = NULL;
+		return AEROSPIKE_OK;
+	}
+
+	switch (op) {
+		case AS_CDT_OP_LIST_SIZE:
+			*out = (as_val_type(v) == AS_LIST) ?
+				as_exp_val_int(as_list_size((as_list*)v)) : NULL;
+			return AEROSPIKE_OK;
+
+		case AS_CDT_OP_MAP_SIZE:
+			*out = (as_val_type(v) == AS_MAP) ? as_exp_val_int(as_map_size((as_map*)v)) : NULL;
+			return AEROSPIKE_OK;
+
+		case AS_CDT_OP_LIST_GET_BY_INDEX:
+		case AS_CDT_OP_MAP_GET_BY_KEY: {
+			if (! args[0] || ! args[1]) {
+				*out = NULL;
+				return AEROSPIKE_OK;
+			}
+
+			int64_t rtype = (as_val_type(args[0]) == AS_INTEGER) ?
+				as_integer_get((as_integer*)args[0]) : -1;
+			int64_t value_rtype = (op == AS_CDT_OP_LIST_GET_BY_INDEX) ?
+				AS_LIST_RETURN_VALUE : AS_MAP_RETURN_VALUE;
+
+			// Other return types depend on server side ordering.
+			if (rtype != value_rtype) {
+				return as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+			}
+
+			as_val* elem;
+
+			if (op == AS_CDT_OP_LIST_GET_BY_INDEX) {
+				elem = as_exp_list_at(v, args[1]);
+			}
+			else if (as_val_type(v) == AS_MAP) {
+				// Missing key returns nil.
+				elem = as_map_get((as_map*)v, args[1]);
+
+				if (! elem) {
+					elem = (as_val*)&as_nil;
+				}
+			}
+			else {
+				elem = NULL;
+			}
+			*out = elem ? as_exp_val_reserve(elem) : NULL;
+			return AEROSPIKE_OK;
+		}
+
+		default:
+			return as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+	}
+}
+
+static as_status
+as_exp_eval_call(as_exp_eval_ctx* ctx, uint32_t n, as_val** out)
+{
+	// [rtype, module, [op, args...] or [0xff, ctx, [op, args...]], bin]
+	int64_t rtype;
+	int64_t module;
+
+	if (n != 4 || as_unpack_int64(&ctx->pk, &rtype) != 0 ||
+		as_unpack_int64(&ctx->pk, &module) != 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	// Bit and hll modules and CDT modify are left to the server.
+	if (module != _AS_EXP_SYS_CALL_CDT) {
+		return as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+	}
+
+	int64_t count = as_unpack_list_header_element_count(&ctx->pk);
+	int64_t op;
+
+	if (count < 1 || as_unpack_int64(&ctx->pk, &op) != 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	as_val* levels[AS_EXP_EVAL_MAX_CTX * 2];
+	uint32_t n_levels = 0;
+	as_val* args[2] = {NULL, NULL};
+	uint32_t n_args = 0;
+	as_val* bin = NULL;
+	as_status status = AEROSPIKE_OK;
+
+	if (op == AS_EXP_EVAL_CDT_CONTEXT) {
+		int64_t n_items = as_unpack_list_header_element_count(&ctx->pk);
+
+		if (count != 3 || n_items < 0 || (n_items & 1) != 0) {
+			return as_exp_invalid(ctx);
+		}
+
+		if (n_items > AS_EXP_EVAL_MAX_CTX * 2) {
+			return as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+		}
+
+		for (; n_levels < (uint32_t)n_items; n_levels++) {
+			if (as_unpack_val(&ctx->pk, &levels[n_levels]) != 0) {
+				status = as_exp_invalid(ctx);
+				goto done;
+			}
+		}
+
+		count = as_unpack_list_header_element_count(&ctx->pk);
+
+		if (count < 1 || as_unpack_int64(&ctx->pk, &op) != 0) {
+			status = as_exp_invalid(ctx);
+			goto done;
+		}
+	}
+
+	switch (op) {
+		case AS_CDT_OP_LIST_SIZE:
+		case AS_CDT_OP_MAP_SIZE:
+			if (count != 1) {
+				status = as_exp_invalid(ctx);
+				goto done;
+			}
+			break;
+
+		case AS_CDT_OP_LIST_GET_BY_INDEX:
+		case AS_CDT_OP_MAP_GET_BY_KEY:
+			if (count != 3) {
+				status = as_exp_invalid(ctx);
+				goto done;
+			}
+			break;
+
+		default:
+			status = as_exp_unsupported(ctx, _AS_EXP_CODE_CALL);
+			goto done;
+	}
+
+	for (; n_args < (uint32_t)count - 1; n_args++) {
+		status = as_exp_eval_next(ctx, &args[n_args]);
+
+		if (status != AEROSPIKE_OK) {
+			goto done;
+		}
+	}
+
+	status = as_exp_eval_next(ctx, &bin);
+
+	if (status != AEROSPIKE_OK) {
+		goto done;
+	}
+
+	if (! bin) {
+		*out = NULL;
+		goto done;
+	}
+
+	status = as_exp_cdt_apply(ctx, op, levels, n_levels, args, bin, out);
+
+done:
+	as_exp_release_args(levels, n_levels);
+	as_exp_release_args(args, n_args);
+	as_exp_val_release(bin);
+	return status;
+}
+
+static as_status
+as_exp_eval_op(as_exp_eval_ctx* ctx, int64_t op, uint32_t n, as_val** out)
+{
+	switch (op) {
+		case _AS_EXP_CODE_CMP_EQ:
+		case _AS_EXP_CODE_CMP_NE:
+		case _AS_EXP_CODE_CMP_GT:
+		case _AS_EXP_CODE_CMP_GE:
+		case _AS_EXP_CODE_CMP_LT:
+		case _AS_EXP_CODE_CMP_LE:
+			return as_exp_eval_cmp(ctx, op, n, out);
+
+		case _AS_EXP_CODE_AND:
+		case _AS_EXP_CODE_OR:
+			return as_exp_eval_logic(ctx, op, n, out);
+
+		case _AS_EXP_CODE_NOT:
+			return as_exp_eval_not(ctx, n, out);
+
+		case _AS_EXP_CODE_EXCLUSIVE:
+			return as_exp_eval_exclusive(ctx, n, out);
+
+		case _AS_EXP_CODE_ADD:
+		case _AS_EXP_CODE_SUB:
+		case _AS_EXP_CODE_MUL:
+		case _AS_EXP_CODE_DIV:
+		case _AS_EXP_CODE_MIN:
+		case _AS_EXP_CODE_MAX:
+		case _AS_EXP_CODE_INT_AND:
+		case _AS_EXP_CODE_INT_OR:
+		case _AS_EXP_CODE_INT_XOR:
+			return as_exp_eval_fold(ctx, op, n, out);
+
+		case _AS_EXP_CODE_POW:
+		case _AS_EXP_CODE_LOG:
+		case _AS_EXP_CODE_MOD:
+		case _AS_EXP_CODE_ABS:
+		case _AS_EXP_CODE_FLOOR:
+		case _AS_EXP_CODE_CEIL:
+		case _AS_EXP_CODE_TO_INT:
+		case _AS_EXP_CODE_TO_FLOAT:
+		case _AS_EXP_CODE_INT_NOT:
+		case _AS_EXP_CODE_INT_LSHIFT:
+		case _AS_EXP_CODE_INT_RSHIFT:
+		case _AS_EXP_CODE_INT_ARSHIFT:
+		case _AS_EXP_CODE_INT_COUNT:
+		case _AS_EXP_CODE_INT_LSCAN:
+		case _AS_EXP_CODE_INT_RSCAN:
+			return as_exp_eval_num(ctx, op, n, out);
+
+		case _AS_EXP_CODE_KEY:
+		case _AS_EXP_CODE_KEY_EXIST:
+		case _AS_EXP_CODE_SET_NAME:
+		case _AS_EXP_CODE_TTL:
+		case _AS_EXP_CODE_IS_TOMBSTONE:
+			return as_exp_eval_meta(ctx, op, n, out);
+
+		case _AS_EXP_CODE_BIN:
+		case _AS_EXP_CODE_BIN_TYPE:
+			return as_exp_eval_bin(ctx, op, n, out);
+
+		case _AS_EXP_CODE_COND:
+			return as_exp_eval_cond(ctx, n, out);
+
+		case _AS_EXP_CODE_LET:
+			return as_exp_eval_let(ctx, n, out);
+
+		case _AS_EXP_CODE_VAR:
+			return as_exp_eval_var(ctx, n, out);
+
+		case _AS_EXP_CODE_QUOTE:
+			if (n != 1 || as_unpack_val(&ctx->pk, out) != 0) {
+				return as_exp_invalid(ctx);
+			}
+			return AEROSPIKE_OK;
+
+		case _AS_EXP_CODE_CALL:
+			return as_exp_eval_call(ctx, n, out);
+
+		default:
+			// Regex, geo, record storage and update time metadata.
+			return as_exp_unsupported(ctx, op);
+	}
+}
+
+static as_status
+as_exp_eval_next(as_exp_eval_ctx* ctx, as_val** out)
+{
+	*out = NULL;
+
+	if (as_unpack_peek_type(&ctx->pk) != AS_LIST) {
+		// Literal value. Lists are always operations, because list literals are quoted.
+		if (as_unpack_val(&ctx->pk, out) != 0 || ! *out) {
+			*out = NULL;
+			return as_exp_invalid(ctx);
+		}
+		return AEROSPIKE_OK;
+	}
+
+	int64_t count = as_unpack_list_header_element_count(&ctx->pk);
+	int64_t op;
+
+	if (count < 1 || as_unpack_int64(&ctx->pk, &op) != 0) {
+		return as_exp_invalid(ctx);
+	}
+
+	if (ctx->depth >= AS_EXP_EVAL_MAX_DEPTH) {
+		return as_exp_unsupported(ctx, op);
+	}
+
+	ctx->depth++;
+	as_status status = as_exp_eval_op(ctx, op, (uint32_t)(count - 1), out);
+	ctx->depth--;
+
+	if (status != AEROSPIKE_OK) {
+		*out = NULL;
+	}
+	return status;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_exp_eval(as_error* err, const as_exp* exp, const as_record* rec, as_val** result)
+{
+	as_error_reset(err);
+
+	as_exp_eval_ctx ctx;
+	ctx.pk.buffer = exp->packed;
+	ctx.pk.offset = 0;
+	ctx.pk.length = exp->packed_sz;
+	ctx.err = err;
+	ctx.rec = rec;
+	ctx.n_vars = 0;
+	ctx.depth = 0;
+
+	as_status status = as_exp_eval_next(&ctx, result);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (ctx.pk.offset != ctx.pk.length) {
+		as_exp_val_release(*result);
+		*result = NULL;
+		return as_exp_invalid(&ctx);
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_exp_eval_filter(as_error* err, const as_exp* exp, const as_record* rec, bool* match)
+{
+	as_val* v;
+	as_status status = as_exp_eval(err, exp, rec, &v);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	if (! v) {
+		*match = false;
+		return AEROSPIKE_OK;
+	}
+
+	if (as_val_type(v) != AS_BOOLEAN) {
+		as_val_destroy(v);
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Filter expression does not return a boolean");
+	}
+
+	*match = as_boolean_get((as_boolean*)v);
+	as_val_destroy(v);
+	return AEROSPIKE_OK;
+}
@@ -44,7 +44,7 @@ as_operations_exp_op(
 	as_pack_list_header(&pk, 2);
 	pack_exp(&pk, exp);
 	as_pack_uint64(&pk, flags);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 
 	return as_cdt_add_packed(&pk, ops, name, command);
 }
@@ -0,0 +1,755 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_export.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_compress.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_partition_filter.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define EXPORT_MAGIC "ASEX"
+#define EXPORT_VERSION 1
+#define EXPORT_COMPRESS 0x1
+
+// Header: magic(4) version(1) flags(1) reserved(2)
+#define EXPORT_HEADER_SIZE 8
+
+// Block: stored_size(4) raw_size(4)
+#define EXPORT_BLOCK_HEADER_SIZE 8
+
+// Record: size(4) digest(20) gen(2) ttl(4) n_bins(2)
+#define EXPORT_RECORD_HEADER_SIZE (4 + AS_DIGEST_VALUE_SIZE + 8)
+
+#define MANIFEST_MAGIC "ASEM"
+#define MANIFEST_VERSION 1
+#define MANIFEST_DONE 0x1
+
+// Manifest: magic(4) version(1) flags(1) reserved(2) size(8) records(8) partitions status
+#define MANIFEST_HEADER_SIZE 24
+
+#define EXPORT_ALIGN 4096
+#define EXPORT_PATH_SIZE 1024
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_export_buf_s {
+	uint8_t* mem;
+	uint8_t* data;
+	size_t capacity;
+} as_export_buf;
+
+typedef struct as_export_writer_s {
+	aerospike* as;
+	as_policy_scan policy;
+	as_scan scan;
+	as_export_buf block;
+	as_export_buf zblock;
+	as_partitions_status* parts;
+	FILE* fp;
+	uint64_t size;
+	uint64_t records;
+	uint32_t block_len;
+	uint32_t block_records;
+	as_error err;
+	as_error io_err;
+	as_status status;
+	pthread_t thread;
+	bool compress;
+	bool done;
+	bool running;
+	char path[EXPORT_PATH_SIZE];
+	char manifest[EXPORT_PATH_SIZE];
+} as_export_writer;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_export_buf_reserve(as_export_buf* buf, size_t size)
+{
+	if (buf->capacity >= size) {
+		return;
+	}
+
+	// Existing content is not preserved.
+	size = (size + EXPORT_ALIGN - 1) & ~(size_t)(EXPORT_ALIGN - 1);
+	cf_free(buf->mem);
+	buf->mem = cf_malloc(size + EXPORT_ALIGN);
+	buf->data = (uint8_t*)(((uintptr_t)buf->mem + EXPORT_ALIGN - 1) &
+		~(uintptr_t)(EXPORT_ALIGN - 1));
+	buf->capacity = size;
+}
+
+static int
+as_export_sync(FILE* fp)
+{
+	int rc = fflush(fp);
+
+#if !defined(_MSC_VER)
+	if (rc == 0) {
+		rc = fsync(fileno(fp));
+	}
+#endif
+	return rc;
+}
+
+static as_status
+as_export_manifest_write(as_export_writer* w, as_error* err, bool done)
+{
+	uint8_t* parts;
+	uint32_t parts_size;
+	as_partitions_status_to_bytes(w->parts, &parts, &parts_size);
+
+	uint8_t header[MANIFEST_HEADER_SIZE];
+	uint8_t* p = header;
+
+	memcpy(p, MANIFEST_MAGIC, 4);
+	p += 4;
+	*p++ = MANIFEST_VERSION;
+	*p++ = done ? MANIFEST_DONE : 0;
+	*p++ = 0;
+	*p++ = 0;
+	*(uint64_t*)p = cf_swap_to_be64(w->size);
+	p += sizeof(uint64_t);
+	*(uint64_t*)p = cf_swap_to_be64(w->records);
+
+	// Write temporary file and rename, so resume never sees a partial manifest.
+	char tmp[EXPORT_PATH_SIZE + 4];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", w->manifest);
+
+	FILE* fp = fopen(tmp, "wb");
+
+	if (! fp) {
+		cf_free(parts);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", tmp, errno);
+	}
+
+	bool ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header) &&
+		fwrite(parts, 1, parts_size, fp) == parts_size;
+	cf_free(parts);
+
+	if (as_export_sync(fp) != 0) {
+		ok = false;
+	}
+
+	if (fclose(fp) != 0) {
+		ok = false;
+	}
+
+	if (! ok) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write %s: %d", tmp, errno);
+	}
+
+#if defined(_MSC_VER)
+	// Windows rename() does not replace an existing file.
+	remove(w->manifest);
+#endif
+
+	if (rename(tmp, w->manifest) != 0) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to rename %s: %d", tmp, errno);
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_export_manifest_load(as_export_writer* w, as_error* err, bool* found)
+{
+	FILE* fp = fopen(w->manifest, "rb");
+
+	if (! fp) {
+		if (errno == ENOENT) {
+			*found = false;
+			return AEROSPIKE_OK;
+		}
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d",
+			w->manifest, errno);
+	}
+
+	// Largest valid manifest has all 4096 partitions with digest cursors.
+	uint32_t capacity = MANIFEST_HEADER_SIZE + 10 + (4096 * (3 + AS_DIGEST_VALUE_SIZE + 8));
+	uint8_t* bytes = cf_malloc(capacity + 1);
+	size_t size = fread(bytes, 1, capacity + 1, fp);
+	fclose(fp);
+
+	as_partitions_status* parts = NULL;
+	const uint8_t* p = bytes;
+
+	if (size > MANIFEST_HEADER_SIZE && size <= capacity && memcmp(p, MANIFEST_MAGIC, 4) == 0 &&
+		p[4] == MANIFEST_VERSION) {
+		parts = as_partitions_status_from_bytes(p + MANIFEST_HEADER_SIZE,
+			(uint32_t)size - MANIFEST_HEADER_SIZE);
+	}
+
+	if (! parts) {
+		cf_free(bytes);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid export manifest: %s",
+			w->manifest);
+	}
+
+	if (parts->part_begin != w->parts->part_begin || parts->part_count != w->parts->part_count) {
+		cf_free(bytes);
+		cf_free(parts);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Export manifest %s does not match writer partitions. n_writers changed?",
+			w->manifest);
+	}
+
+	w->done = (p[5] & MANIFEST_DONE) != 0;
+	w->size = cf_swap_from_be64(*(uint64_t*)(p + 8));
+	w->records = cf_swap_from_be64(*(uint64_t*)(p + 16));
+	cf_free(bytes);
+
+	cf_free(w->parts);
+	w->parts = parts;
+	*found = true;
+	return AEROSPIKE_OK;
+}
+
+static as_partitions_status*
+as_export_parts_create(uint16_t part_begin, uint16_t part_count)
+{
+	as_partitions_status* parts = cf_malloc(sizeof(as_partitions_status) +
+		(sizeof(as_partition_status) * part_count));
+
+	parts->ref_count = 1;
+	parts->part_begin = part_begin;
+	parts->part_count = part_count;
+	parts->done = false;
+	parts->retry = true;
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		as_partition_status* ps = &parts->parts[i];
+		ps->part_id = part_begin + i;
+		ps->retry = true;
+		ps->digest.init = false;
+		ps->bval = 0;
+	}
+	return parts;
+}
+
+static as_status
+as_export_truncate(FILE* fp, uint64_t size)
+{
+#if defined(_MSC_VER)
+	return _chsize_s(_fileno(fp), (__int64)size) == 0 ? AEROSPIKE_OK : AEROSPIKE_ERR_CLIENT;
+#else
+	return ftruncate(fileno(fp), (off_t)size) == 0 ? AEROSPIKE_OK : AEROSPIKE_ERR_CLIENT;
+#endif
+}
+
+static as_status
+as_export_writer_open(
+	as_export_writer* w, as_error* err, const as_export_config* config, uint32_t index,
+	uint16_t part_begin, uint16_t part_count
+	)
+{
+	if (snprintf(w->path, sizeof(w->path), "%s/export-%03u.dat", config->dir, index) >=
+			(int)sizeof(w->path) ||
+		snprintf(w->manifest, sizeof(w->manifest), "%s/export-%03u.manifest", config->dir,
+			index) >= (int)sizeof(w->manifest)) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Export path too long: %s",
+			config->dir);
+	}
+
+	w->parts = as_export_parts_create(part_begin, part_count);
+	w->compress = config->compress;
+
+	bool found = false;
+
+	if (config->resume) {
+		as_status status = as_export_manifest_load(w, err, &found);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+
+	if (found) {
+		if (w->done) {
+			return AEROSPIKE_OK;
+		}
+
+		w->fp = fopen(w->path, "r+b");
+
+		if (! w->fp) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d",
+				w->path, errno);
+		}
+
+		// The file header decides compression, so blocks of one file are consistent.
+		uint8_t header[EXPORT_HEADER_SIZE];
+
+		if (fread(header, 1, sizeof(header), w->fp) != sizeof(header) ||
+			memcmp(header, EXPORT_MAGIC, 4) != 0 || w->size < EXPORT_HEADER_SIZE) {
+			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid export file: %s",
+				w->path);
+		}
+		w->compress = (header[5] & EXPORT_COMPRESS) != 0;
+
+		// Drop blocks written after the last manifest.
+		if (as_export_truncate(w->fp, w->size) != AEROSPIKE_OK ||
+			fseek(w->fp, 0, SEEK_END) != 0) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to truncate %s: %d",
+				w->path, errno);
+		}
+	}
+	else {
+		w->fp = fopen(w->path, "wb");
+
+		if (! w->fp) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d",
+				w->path, errno);
+		}
+
+		uint8_t header[EXPORT_HEADER_SIZE] = {0};
+		memcpy(header, EXPORT_MAGIC, 4);
+		header[4] = EXPORT_VERSION;
+		header[5] = w->compress ? EXPORT_COMPRESS : 0;
+
+		if (fwrite(header, 1, sizeof(header), w->fp) != sizeof(header)) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write %s: %d",
+				w->path, errno);
+		}
+		w->size = EXPORT_HEADER_SIZE;
+		w->records = 0;
+	}
+
+	// Blocks are written directly with one call, so disable stdio buffering.
+	setvbuf(w->fp, NULL, _IONBF, 0);
+	w->block_len = EXPORT_BLOCK_HEADER_SIZE;
+	return AEROSPIKE_OK;
+}
+
+static void
+as_export_writer_close(as_export_writer* w)
+{
+	if (w->fp) {
+		fclose(w->fp);
+	}
+	cf_free(w->block.mem);
+	cf_free(w->zblock.mem);
+	cf_free(w->parts);
+}
+
+static as_status
+as_export_flush(as_export_writer* w, as_error* err)
+{
+	uint32_t raw_size = w->block_len - EXPORT_BLOCK_HEADER_SIZE;
+	uint32_t stored_size = raw_size;
+	uint8_t* block = w->block.data;
+
+	if (w->compress) {
+		size_t bound = as_compress_bound(AS_COMPRESS_ZLIB, raw_size);
+		as_export_buf_reserve(&w->zblock, EXPORT_BLOCK_HEADER_SIZE + bound);
+
+		size_t zsize = w->zblock.capacity - EXPORT_BLOCK_HEADER_SIZE;
+		as_status status = as_compress(err, AS_COMPRESS_ZLIB,
+			w->zblock.data + EXPORT_BLOCK_HEADER_SIZE, &zsize,
+			w->block.data + EXPORT_BLOCK_HEADER_SIZE, raw_size);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+		block = w->zblock.data;
+		stored_size = (uint32_t)zsize;
+	}
+
+	*(uint32_t*)block = cf_swap_to_be32(stored_size);
+	*(uint32_t*)(block + 4) = cf_swap_to_be32(raw_size);
+
+	size_t n = EXPORT_BLOCK_HEADER_SIZE + stored_size;
+
+	if (fwrite(block, 1, n, w->fp) != n || as_export_sync(w->fp) != 0) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write %s: %d",
+			w->path, errno);
+	}
+
+	w->size += n;
+	w->records += w->block_records;
+	w->block_len = EXPORT_BLOCK_HEADER_SIZE;
+	w->block_records = 0;
+
+	// Cursors only cover records in flushed blocks.
+	return as_export_manifest_write(w, err, false);
+}
+
+static bool
+as_export_write_record(const as_record_raw* rec, void* udata)
+{
+	as_export_writer* w = udata;
+
+	if (! rec) {
+		return true;
+	}
+
+	const uint8_t* end = rec->bins;
+
+	for (uint16_t i = 0; i < rec->n_bins; i++) {
+		end += cf_swap_from_be32(*(uint32_t*)end) + 4;
+	}
+
+	uint32_t bins_size = (uint32_t)(end - rec->bins);
+	uint32_t size = EXPORT_RECORD_HEADER_SIZE + bins_size;
+
+	if (w->block_len + size > w->block.capacity) {
+		if (w->block_records > 0 && as_export_flush(w, &w->io_err) != AEROSPIKE_OK) {
+			return false;
+		}
+		// Block is empty here, so growing it does not lose records.
+		as_export_buf_reserve(&w->block, EXPORT_BLOCK_HEADER_SIZE + size);
+	}
+
+	uint8_t* p = w->block.data + w->block_len;
+
+	*(uint32_t*)p = cf_swap_to_be32(size - 4);
+	p += sizeof(uint32_t);
+	memcpy(p, rec->digest.value, AS_DIGEST_VALUE_SIZE);
+	p += AS_DIGEST_VALUE_SIZE;
+	*(uint16_t*)p = cf_swap_to_be16(rec->gen);
+	p += sizeof(uint16_t);
+	*(uint32_t*)p = cf_swap_to_be32(rec->ttl);
+	p += sizeof(uint32_t);
+	*(uint16_t*)p = cf_swap_to_be16(rec->n_bins);
+	p += sizeof(uint16_t);
+	memcpy(p, rec->bins, bins_size);
+
+	w->block_len += size;
+	w->block_records++;
+
+	uint32_t part_id = as_partition_getid(rec->digest.value, 4096);
+	as_partition_status* ps = &w->parts->parts[part_id - w->parts->part_begin];
+	ps->digest = rec->digest;
+	ps->digest.init = true;
+	return true;
+}
+
+static void*
+as_export_writer_run(void* data)
+{
+	as_export_writer* w = data;
+
+	// The scan updates its own copy of partition status as records arrive. The manifest
+	// must only see cursors of flushed records.
+	size_t parts_size = sizeof(as_partitions_status) +
+		(sizeof(as_partition_status) * w->parts->part_count);
+	as_partitions_status* parts = cf_malloc(parts_size);
+	memcpy(parts, w->parts, parts_size);
+	parts->ref_count = 1;
+	parts->retry = true;
+
+	as_partition_filter pf;
+	as_partition_filter_set_partitions(&pf, parts);
+
+	w->status = aerospike_scan_partitions_raw(w->as, &w->err, &w->policy, &w->scan, &pf,
+		as_export_write_record, w);
+
+	if (w->io_err.code != AEROSPIKE_OK) {
+		as_error_copy(&w->err, &w->io_err);
+		w->status = w->io_err.code;
+	}
+
+	if (w->scan.parts_all) {
+		as_partitions_status_release(w->scan.parts_all);
+	}
+	as_partitions_status_release(parts);
+
+	// Flush delivered records even when the scan failed, so resume does not repeat them.
+	if (w->block_records > 0) {
+		as_error err;
+		as_error_init(&err);
+
+		if (as_export_flush(w, &err) != AEROSPIKE_OK && w->status == AEROSPIKE_OK) {
+			as_error_copy(&w->err, &err);
+			w->status = err.code;
+		}
+	}
+
+	if (w->status == AEROSPIKE_OK) {
+		w->status = as_export_manifest_write(w, &w->err, true);
+		w->done = w->status == AEROSPIKE_OK;
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+aerospike_scan_export(
+	aerospike* as, as_error* err, const as_policy_scan* policy, as_scan* scan,
+	const as_export_config* config, as_export_stats* stats
+	)
+{
+	as_error_reset(err);
+
+	if (! config->dir || ! config->dir[0]) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Export dir not set");
+	}
+
+	if (scan->apply_each.function[0] || scan->ops) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Export scan does not support apply_each or ops");
+	}
+
+	if (! policy) {
+		policy = &as->config.policies.scan;
+	}
+
+	uint32_t n_writers = config->n_writers;
+
+	if (n_writers == 0) {
+		as_nodes* nodes = as_nodes_reserve(as->cluster);
+		n_writers = nodes->size;
+		as_nodes_release(nodes);
+
+		if (n_writers == 0) {
+			return as_error_set_message(err, AEROSPIKE_ERR_CLUSTER, "Cluster is empty");
+		}
+	}
+
+	if (n_writers > 4096) {
+		n_writers = 4096;
+	}
+
+	uint32_t block_size = config->block_size < EXPORT_ALIGN ? EXPORT_ALIGN : config->block_size;
+	as_export_writer* writers = cf_calloc(n_writers, sizeof(as_export_writer));
+	as_status status = AEROSPIKE_OK;
+
+	for (uint32_t i = 0; i < n_writers; i++) {
+		as_export_writer* w = &writers[i];
+		uint16_t begin = (uint16_t)(i * 4096 / n_writers);
+		uint16_t end = (uint16_t)((i + 1) * 4096 / n_writers);
+
+		w->as = as;
+		w->policy = *policy;
+		w->policy.checkpoint_file = NULL;
+		w->policy.parse_threads = 0;
+
+		// Each writer runs its own scan. Nodes of the range are scanned in sequence, so
+		// one writer never receives records concurrently.
+		w->scan = *scan;
+		w->scan.parts_all = NULL;
+		w->scan.paginate = false;
+		w->scan.concurrent = false;
+		w->scan._free = false;
+		as_error_init(&w->err);
+		as_error_init(&w->io_err);
+
+		status = as_export_writer_open(w, err, config, i, begin, end - begin);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+		as_export_buf_reserve(&w->block, block_size);
+	}
+
+	if (status == AEROSPIKE_OK) {
+		for (uint32_t i = 0; i < n_writers; i++) {
+			as_export_writer* w = &writers[i];
+
+			if (w->done) {
+				continue;
+			}
+
+			if (pthread_create(&w->thread, NULL, as_export_writer_run, w) != 0) {
+				status = as_error_update(err, AEROSPIKE_ERR_CLIENT,
+					"Failed to create export thread: %d", errno);
+				break;
+			}
+			w->running = true;
+		}
+
+		for (uint32_t i = 0; i < n_writers; i++) {
+			as_export_writer* w = &writers[i];
+
+			if (! w->running) {
+				continue;
+			}
+
+			pthread_join(w->thread, NULL);
+
+			if (w->status != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+				as_error_copy(err, &w->err);
+				status = w->status;
+			}
+		}
+	}
+
+	if (stats) {
+		stats->records = 0;
+		stats->bytes = 0;
+
+		for (uint32_t i = 0; i < n_writers; i++) {
+			stats->records += writers[i].records;
+			stats->bytes += writers[i].size;
+		}
+	}
+
+	for (uint32_t i = 0; i < n_writers; i++) {
+		as_export_writer_close(&writers[i]);
+	}
+	cf_free(writers);
+	return status;
+}
+
+as_status
+as_export_read(
+	const char* path, as_error* err, aerospike_scan_foreach_raw_callback callback, void* udata
+	)
+{
+	as_error_reset(err);
+
+	FILE* fp = fopen(path, "rb");
+
+	if (! fp) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", path, errno);
+	}
+
+	uint8_t header[EXPORT_HEADER_SIZE];
+
+	if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+		memcmp(header, EXPORT_MAGIC, 4) != 0 || header[4] != EXPORT_VERSION) {
+		fclose(fp);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid export file: %s", path);
+	}
+
+	bool compress = (header[5] & EXPORT_COMPRESS) != 0;
+	as_export_buf stored = {0};
+	as_export_buf raw = {0};
+	as_status status = AEROSPIKE_OK;
+
+	while (status == AEROSPIKE_OK) {
+		uint8_t bh[EXPORT_BLOCK_HEADER_SIZE];
+		size_t n = fread(bh, 1, sizeof(bh), fp);
+
+		if (n == 0) {
+			break;
+		}
+
+		if (n != sizeof(bh)) {
+			status = as_error_update(err, AEROSPIKE_ERR_PARAM, "Truncated export file: %s",
+				path);
+			break;
+		}
+
+		uint32_t stored_size = cf_swap_from_be32(*(uint32_t*)bh);
+		uint32_t raw_size = cf_swap_from_be32(*(uint32_t*)(bh + 4));
+
+		as_export_buf_reserve(&stored, stored_size);
+
+		if (fread(stored.data, 1, stored_size, fp) != stored_size) {
+			status = as_error_update(err, AEROSPIKE_ERR_PARAM, "Truncated export file: %s",
+				path);
+			break;
+		}
+
+		const uint8_t* p = stored.data;
+
+		if (compress) {
+			as_export_buf_reserve(&raw, raw_size);
+
+			size_t size = raw.capacity;
+			status = as_decompress(err, AS_COMPRESS_ZLIB, raw.data, &size, stored.data,
+				stored_size);
+
+			if (status != AEROSPIKE_OK) {
+				break;
+			}
+
+			if (size != raw_size) {
+				status = as_error_update(err, AEROSPIKE_ERR_PARAM,
+					"Invalid export block size: %s", path);
+				break;
+			}
+			p = raw.data;
+		}
+		else if (raw_size != stored_size) {
+			status = as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid export block size: %s",
+				path);
+			break;
+		}
+
+		const uint8_t* end = p + raw_size;
+
+		while (p < end) {
+			if (end - p < EXPORT_RECORD_HEADER_SIZE) {
+				status = as_error_update(err, AEROSPIKE_ERR_PARAM,
+					"Invalid export record: %s", path);
+				break;
+			}
+
+			uint32_t size = cf_swap_from_be32(*(uint32_t*)p);
+
+			if (size < EXPORT_RECORD_HEADER_SIZE - 4 || (size_t)(end - p - 4) < size) {
+				status = as_error_update(err, AEROSPIKE_ERR_PARAM,
+					"Invalid export record: %s", path);
+				break;
+			}
+
+			const uint8_t* next = p + 4 + size;
+			p += 4;
+
+			as_record_raw rec;
+			rec.digest.init = true;
+			memcpy(rec.digest.value, p, AS_DIGEST_VALUE_SIZE);
+			p += AS_DIGEST_VALUE_SIZE;
+			rec.gen = cf_swap_from_be16(*(uint16_t*)p);
+			p += sizeof(uint16_t);
+			rec.ttl = cf_swap_from_be32(*(uint32_t*)p);
+			p += sizeof(uint32_t);
+			rec.n_bins = cf_swap_from_be16(*(uint16_t*)p);
+			p += sizeof(uint16_t);
+			rec.bins = p;
+
+			if (! callback(&rec, udata)) {
+				status = as_error_set_message(err, AEROSPIKE_ERR_CLIENT_ABORT, "");
+				break;
+			}
+			p = next;
+		}
+	}
+
+	fclose(fp);
+	cf_free(stored.mem);
+	cf_free(raw.mem);
+
+	if (status == AEROSPIKE_OK) {
+		callback(NULL, udata);
+	}
+	return status;
+}
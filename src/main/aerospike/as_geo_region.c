@@ -0,0 +1,215 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_geo_region.h>
+#include <aerospike/as_bytes.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_GEO_MAX_DEPTH 64
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline const char*
+as_geo_skip_ws(const char* p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+		p++;
+	}
+	return p;
+}
+
+static const char*
+as_geo_skip_str(const char* p)
+{
+	// p points after the opening quote.
+	while (*p && *p != '"') {
+		if (*p == '\\' && p[1]) {
+			p++;
+		}
+		p++;
+	}
+	return *p ? p + 1 : NULL;
+}
+
+static bool
+as_geo_type_valid(const char* s, size_t len)
+{
+	static const char* types[] = {"Point", "Polygon", "MultiPolygon", "AeroCircle"};
+
+	for (uint32_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+		if (strlen(types[i]) == len && memcmp(types[i], s, len) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static as_status
+as_geo_validate(as_error* err, const char* json)
+{
+	const char* p = as_geo_skip_ws(json);
+
+	if (*p != '{') {
+		return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+			"GeoJSON is not an object");
+	}
+
+	// Check that brackets are balanced and find the top level "type" member.
+	char stack[AS_GEO_MAX_DEPTH];
+	uint32_t depth = 0;
+	bool has_type = false;
+	bool has_coords = false;
+
+	while (*p) {
+		char c = *p;
+
+		if (c == '{' || c == '[') {
+			if (depth >= AS_GEO_MAX_DEPTH) {
+				return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+					"GeoJSON nested too deep");
+			}
+			stack[depth++] = (c == '{') ? '}' : ']';
+			p++;
+		}
+		else if (c == '}' || c == ']') {
+			if (depth == 0 || stack[--depth] != c) {
+				return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+					"GeoJSON brackets are not balanced");
+			}
+			p++;
+
+			if (depth == 0) {
+				break;
+			}
+		}
+		else if (c == '"') {
+			const char* s = p + 1;
+			p = as_geo_skip_str(s);
+
+			if (! p) {
+				return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+					"GeoJSON string is not terminated");
+			}
+
+			if (depth != 1) {
+				continue;
+			}
+
+			size_t len = (size_t)(p - s - 1);
+			const char* v = as_geo_skip_ws(p);
+
+			if (*v != ':') {
+				continue;
+			}
+			v = as_geo_skip_ws(v + 1);
+
+			if (len == 4 && memcmp(s, "type", 4) == 0) {
+				const char* t = (*v == '"') ? as_geo_skip_str(v + 1) : NULL;
+
+				if (! t || ! as_geo_type_valid(v + 1, (size_t)(t - v - 2))) {
+					return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+						"GeoJSON type must be Point, Polygon, MultiPolygon or AeroCircle");
+				}
+				has_type = true;
+			}
+			else if (len == 11 && memcmp(s, "coordinates", 11) == 0) {
+				has_coords = *v == '[';
+			}
+		}
+		else {
+			p++;
+		}
+	}
+
+	if (depth != 0 || *as_geo_skip_ws(p) != 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+			"GeoJSON is not a single object");
+	}
+
+	if (! has_type || ! has_coords) {
+		return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+			"GeoJSON requires type and coordinates");
+	}
+	return AEROSPIKE_OK;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_geo_region_init(as_geo_region* region, as_error* err, const char* json)
+{
+	as_error_reset(err);
+
+	if (! json) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "GeoJSON is null");
+	}
+
+	as_status status = as_geo_validate(err, json);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	size_t len = strlen(json);
+
+	if (len > UINT32_MAX / 4) {
+		return as_error_set_message(err, AEROSPIKE_ERR_GEO_INVALID_GEOJSON,
+			"GeoJSON is too large");
+	}
+
+	// Query filter ranges send the region as both begin and end.  Append a null
+	// terminated copy for the geojson value.
+	uint32_t range_size = 1 + (4 + (uint32_t)len) * 2;
+	uint8_t* buf = cf_malloc(range_size + len + 1);
+	uint8_t* p = buf;
+
+	*p++ = AS_BYTES_GEOJSON;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		*(uint32_t*)p = cf_swap_to_be32((uint32_t)len);
+		p += 4;
+		memcpy(p, json, len);
+		p += len;
+	}
+
+	char* str = (char*)p;
+	memcpy(str, json, len + 1);
+
+	as_geojson_init_wlen(&region->geojson, str, len, false);
+	region->range = buf;
+	region->range_size = range_size;
+	region->len = (uint32_t)len;
+	return AEROSPIKE_OK;
+}
+
+void
+as_geo_region_destroy(as_geo_region* region)
+{
+	cf_free(region->range);
+	region->range = NULL;
+	region->range_size = 0;
+	region->len = 0;
+}
@@ -0,0 +1,386 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_hll.h>
+#include <citrusleaf/alloc.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AS_HLL_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AS_HLL_NEON
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Wire layout: flags(1) n_index_bits(1) n_minhash_bits(1) ... registers. Registers are at
+// the end of the value and each holds a 6 bit HLL value followed by the min hash bits,
+// packed most significant bit first.
+#define AS_HLL_HEADER_MIN 3
+#define AS_HLL_VALUE_BITS 6
+
+typedef struct {
+	const uint8_t* regs;
+	uint32_t n_index_bits;
+	uint32_t n_mh_bits;
+	uint32_t n_registers;
+} as_hll_sketch;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_status
+as_hll_parse(as_error* err, const as_bytes* hll, as_hll_sketch* sk)
+{
+	if (! hll || hll->size < AS_HLL_HEADER_MIN) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Invalid HLL value");
+	}
+
+	uint32_t n_index_bits = hll->value[1];
+	uint32_t n_mh_bits = hll->value[2];
+
+	if (n_index_bits < 4 || n_index_bits > 16 || n_mh_bits > 51 ||
+		n_index_bits + n_mh_bits > 64) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid HLL bit counts: %u,%u",
+			n_index_bits, n_mh_bits);
+	}
+
+	uint32_t n_registers = 1 << n_index_bits;
+	uint64_t n_bits = (uint64_t)n_registers * (AS_HLL_VALUE_BITS + n_mh_bits);
+	uint32_t size = (uint32_t)((n_bits + 7) / 8);
+
+	if (hll->size < AS_HLL_HEADER_MIN + size) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid HLL size: %u", hll->size);
+	}
+
+	sk->regs = hll->value + hll->size - size;
+	sk->n_index_bits = n_index_bits;
+	sk->n_mh_bits = n_mh_bits;
+	sk->n_registers = n_registers;
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_hll_parse_all(as_error* err, const as_bytes** hlls, uint32_t n_hlls, as_hll_sketch* sketches)
+{
+	for (uint32_t i = 0; i < n_hlls; i++) {
+		as_status status = as_hll_parse(err, hlls[i], &sketches[i]);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		if (sketches[i].n_index_bits != sketches[0].n_index_bits ||
+			sketches[i].n_mh_bits != sketches[0].n_mh_bits) {
+			return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "HLL bit counts differ");
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+// Read full register (HLL value and min hash bits).
+static inline uint64_t
+as_hll_register(const as_hll_sketch* sk, uint32_t index)
+{
+	uint32_t n_bits = AS_HLL_VALUE_BITS + sk->n_mh_bits;
+	uint64_t bit = (uint64_t)index * n_bits;
+	const uint8_t* p = sk->regs + (bit >> 3);
+	uint32_t need = (uint32_t)(bit & 7) + n_bits;
+	uint32_t n_bytes = (need + 7) >> 3;
+	uint64_t v = 0;
+
+	for (uint32_t i = 0; i < n_bytes; i++) {
+		v = (v << 8) | p[i];
+	}
+	v >>= (n_bytes << 3) - need;
+	return (n_bits == 64) ? v : v & ((1ULL << n_bits) - 1);
+}
+
+// Decode the HLL value of every register.
+static void
+as_hll_values(const as_hll_sketch* sk, uint8_t* vals)
+{
+	if (sk->n_mh_bits == 0) {
+		// Four 6 bit registers in every three bytes.
+		const uint8_t* p = sk->regs;
+
+		for (uint32_t i = 0; i < sk->n_registers; i += 4, p += 3) {
+			vals[i] = p[0] >> 2;
+			vals[i + 1] = (uint8_t)(((p[0] & 0x03) << 4) | (p[1] >> 4));
+			vals[i + 2] = (uint8_t)(((p[1] & 0x0f) << 2) | (p[2] >> 6));
+			vals[i + 3] = p[2] & 0x3f;
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < sk->n_registers; i++) {
+		vals[i] = (uint8_t)(as_hll_register(sk, i) >> sk->n_mh_bits);
+	}
+}
+
+static void
+as_hll_max(uint8_t* dst, const uint8_t* src, uint32_t n)
+{
+	uint32_t i = 0;
+
+#if defined(AS_HLL_SSE2)
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_max_epu8(a, b));
+	}
+#elif defined(AS_HLL_NEON)
+	for (; i + 16 <= n; i += 16) {
+		vst1q_u8(dst + i, vmaxq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+	}
+#endif
+
+	for (; i < n; i++) {
+		if (src[i] > dst[i]) {
+			dst[i] = src[i];
+		}
+	}
+}
+
+static double
+as_hll_sigma(double x)
+{
+	if (x == 1.0) {
+		return INFINITY;
+	}
+
+	double y = 1.0;
+	double z = x;
+	double z_prev;
+
+	do {
+		x *= x;
+		z_prev = z;
+		z += x * y;
+		y += y;
+	} while (z != z_prev);
+	return z;
+}
+
+static double
+as_hll_tau(double x)
+{
+	if (x == 0.0 || x == 1.0) {
+		return 0.0;
+	}
+
+	double y = 1.0;
+	double z = 1.0 - x;
+	double z_prev;
+
+	do {
+		x = sqrt(x);
+		z_prev = z;
+		y *= 0.5;
+		z -= (1.0 - x) * (1.0 - x) * y;
+	} while (z != z_prev);
+	return z / 3.0;
+}
+
+// Improved raw estimator from Ertl, "New cardinality estimation algorithms for HyperLogLog
+// sketches". It needs no bias tables or range corrections.
+static double
+as_hll_estimate(const uint8_t* vals, uint32_t n_index_bits)
+{
+	uint32_t m = 1 << n_index_bits;
+	uint32_t q = 64 - n_index_bits;
+	uint32_t counts[66];
+
+	memset(counts, 0, sizeof(counts));
+
+	for (uint32_t i = 0; i < m; i++) {
+		uint32_t v = vals[i];
+		counts[v <= q + 1 ? v : q + 1]++;
+	}
+
+	double z = m * as_hll_tau((double)(m - counts[q + 1]) / m);
+
+	for (uint32_t k = q; k >= 1; k--) {
+		z += counts[k];
+		z *= 0.5;
+	}
+	z += m * as_hll_sigma((double)counts[0] / m);
+
+	return (0.5 / log(2.0)) * m * m / z;
+}
+
+static inline uint64_t
+as_hll_round(double v)
+{
+	return v > 0.0 ? (uint64_t)(v + 0.5) : 0;
+}
+
+static double
+as_hll_union_estimate(const as_hll_sketch* sketches, uint32_t n_hlls)
+{
+	uint32_t m = sketches[0].n_registers;
+	uint8_t* vals = cf_malloc(m * 2);
+	uint8_t* tmp = vals + m;
+
+	as_hll_values(&sketches[0], vals);
+
+	for (uint32_t i = 1; i < n_hlls; i++) {
+		as_hll_values(&sketches[i], tmp);
+		as_hll_max(vals, tmp, m);
+	}
+
+	double estimate = as_hll_estimate(vals, sketches[0].n_index_bits);
+	cf_free(vals);
+	return estimate;
+}
+
+// Estimate intersection and union. Min hash registers that are equal and set in every
+// sketch estimate the Jaccard index.
+static as_status
+as_hll_intersect_estimate(
+	as_error* err, const as_bytes** hlls, uint32_t n_hlls, double* intersect, double* uni
+	)
+{
+	if (n_hlls < 2) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "At least two HLL values required");
+	}
+
+	as_hll_sketch* sketches = cf_malloc(sizeof(as_hll_sketch) * n_hlls);
+	as_status status = as_hll_parse_all(err, hlls, n_hlls, sketches);
+
+	if (status != AEROSPIKE_OK) {
+		cf_free(sketches);
+		return status;
+	}
+
+	*uni = as_hll_union_estimate(sketches, n_hlls);
+
+	uint32_t n_mh_bits = sketches[0].n_mh_bits;
+
+	if (n_mh_bits == 0) {
+		if (n_hlls != 2) {
+			cf_free(sketches);
+			return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+				"HLL values without min hash bits support two values only");
+		}
+
+		double a = as_hll_union_estimate(&sketches[0], 1);
+		double b = as_hll_union_estimate(&sketches[1], 1);
+		double v = a + b - *uni;
+		*intersect = v > 0.0 ? v : 0.0;
+		cf_free(sketches);
+		return AEROSPIKE_OK;
+	}
+
+	uint32_t n_matches = 0;
+	uint32_t n_set = 0;
+
+	for (uint32_t r = 0; r < sketches[0].n_registers; r++) {
+		uint64_t first = as_hll_register(&sketches[0], r);
+		bool any = (first >> n_mh_bits) != 0;
+		bool all = any;
+
+		for (uint32_t i = 1; i < n_hlls; i++) {
+			uint64_t reg = as_hll_register(&sketches[i], r);
+
+			if ((reg >> n_mh_bits) != 0) {
+				any = true;
+			}
+
+			if (reg != first) {
+				all = false;
+			}
+		}
+
+		if (any) {
+			n_set++;
+		}
+
+		if (all) {
+			n_matches++;
+		}
+	}
+
+	*intersect = n_set ? *uni * n_matches / n_set : 0.0;
+	cf_free(sketches);
+	return AEROSPIKE_OK;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_hll_count(as_error* err, const as_bytes* hll, uint64_t* count)
+{
+	return as_hll_union_count(err, &hll, 1, count);
+}
+
+as_status
+as_hll_union_count(as_error* err, const as_bytes** hlls, uint32_t n_hlls, uint64_t* count)
+{
+	as_error_reset(err);
+
+	if (n_hlls == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "No HLL values");
+	}
+
+	as_hll_sketch* sketches = cf_malloc(sizeof(as_hll_sketch) * n_hlls);
+	as_status status = as_hll_parse_all(err, hlls, n_hlls, sketches);
+
+	if (status == AEROSPIKE_OK) {
+		*count = as_hll_round(as_hll_union_estimate(sketches, n_hlls));
+	}
+	cf_free(sketches);
+	return status;
+}
+
+as_status
+as_hll_intersect_count(as_error* err, const as_bytes** hlls, uint32_t n_hlls, uint64_t* count)
+{
+	as_error_reset(err);
+
+	double intersect;
+	double uni;
+	as_status status = as_hll_intersect_estimate(err, hlls, n_hlls, &intersect, &uni);
+
+	if (status == AEROSPIKE_OK) {
+		*count = as_hll_round(intersect);
+	}
+	return status;
+}
+
+as_status
+as_hll_similarity(as_error* err, const as_bytes** hlls, uint32_t n_hlls, double* similarity)
+{
+	as_error_reset(err);
+
+	double intersect;
+	double uni;
+	as_status status = as_hll_intersect_estimate(err, hlls, n_hlls, &intersect, &uni);
+
+	if (status == AEROSPIKE_OK) {
+		double v = uni > 0.0 ? intersect / uni : 0.0;
+		*similarity = v < 1.0 ? v : 1.0;
+	}
+	return status;
+}
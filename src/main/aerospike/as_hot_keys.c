@@ -0,0 +1,223 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_hot_keys.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_HOT_KEYS_DECAY_MS 60000
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_hot_sketch_s {
+	as_hot_key* entries; // Counts are in samples.
+	uint32_t size;
+} as_hot_sketch;
+
+struct as_hot_keys_s {
+	pthread_mutex_t lock;
+	as_hot_sketch keys;
+	as_hot_sketch partitions;
+	uint64_t decay_at;
+	uint32_t capacity;
+	uint32_t sample_rate;
+};
+
+static const as_digest_value as_hot_no_digest = {0};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_hot_sketch_add(
+	as_hot_sketch* sketch, uint32_t capacity, const char* ns, const uint8_t* digest,
+	uint32_t partition_id, uint64_t bytes
+	)
+{
+	as_hot_key* min = NULL;
+
+	for (uint32_t i = 0; i < sketch->size; i++) {
+		as_hot_key* e = &sketch->entries[i];
+
+		if (e->partition_id == partition_id &&
+			memcmp(e->digest, digest, AS_DIGEST_VALUE_SIZE) == 0 && strcmp(e->ns, ns) == 0) {
+			e->count++;
+			e->bytes += bytes;
+			return;
+		}
+
+		if (! min || e->count < min->count) {
+			min = e;
+		}
+	}
+
+	as_hot_key* e;
+
+	if (sketch->size < capacity) {
+		e = &sketch->entries[sketch->size++];
+		e->count = 1;
+		e->error = 0;
+	}
+	else {
+		// Replace the smallest counter. Its count bounds how much the new key is overestimated.
+		e = min;
+		e->error = e->count;
+		e->count++;
+	}
+	as_strncpy(e->ns, ns, sizeof(e->ns));
+	memcpy(e->digest, digest, AS_DIGEST_VALUE_SIZE);
+	e->partition_id = partition_id;
+	e->bytes = bytes;
+}
+
+static void
+as_hot_sketch_decay(as_hot_sketch* sketch)
+{
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < sketch->size; i++) {
+		as_hot_key* e = &sketch->entries[i];
+		e->count >>= 1;
+		e->error >>= 1;
+		e->bytes >>= 1;
+
+		if (e->count > 0) {
+			sketch->entries[n++] = *e;
+		}
+	}
+	sketch->size = n;
+}
+
+static inline bool
+as_hot_key_greater(const as_hot_key* e1, const as_hot_key* e2)
+{
+	return e1->count > e2->count || (e1->count == e2->count && e1->bytes > e2->bytes);
+}
+
+static uint32_t
+as_hot_sketch_top(as_hot_keys* hk, as_hot_sketch* sketch, as_hot_key* out, uint32_t max)
+{
+	if (max == 0) {
+		return 0;
+	}
+
+	// Insertion select into the caller's array, so stats refreshes do not allocate.
+	uint32_t n = 0;
+
+	pthread_mutex_lock(&hk->lock);
+
+	for (uint32_t i = 0; i < sketch->size; i++) {
+		as_hot_key* e = &sketch->entries[i];
+		uint32_t j;
+
+		if (n < max) {
+			j = n++;
+		}
+		else if (as_hot_key_greater(e, &out[max - 1])) {
+			j = max - 1;
+		}
+		else {
+			continue;
+		}
+
+		while (j > 0 && as_hot_key_greater(e, &out[j - 1])) {
+			out[j] = out[j - 1];
+			j--;
+		}
+		out[j] = *e;
+	}
+
+	pthread_mutex_unlock(&hk->lock);
+
+	for (uint32_t i = 0; i < n; i++) {
+		out[i].count *= hk->sample_rate;
+		out[i].error *= hk->sample_rate;
+		out[i].bytes *= hk->sample_rate;
+	}
+	return n;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_hot_keys*
+as_hot_keys_create(uint32_t capacity, uint32_t sample_rate)
+{
+	as_hot_keys* hk = cf_malloc(sizeof(as_hot_keys));
+	pthread_mutex_init(&hk->lock, NULL);
+	hk->keys.entries = cf_malloc(sizeof(as_hot_key) * capacity);
+	hk->keys.size = 0;
+	hk->partitions.entries = cf_malloc(sizeof(as_hot_key) * capacity);
+	hk->partitions.size = 0;
+	hk->decay_at = cf_getms() + AS_HOT_KEYS_DECAY_MS;
+	hk->capacity = capacity;
+	hk->sample_rate = sample_rate;
+	return hk;
+}
+
+void
+as_hot_keys_destroy(as_hot_keys* hk)
+{
+	cf_free(hk->keys.entries);
+	cf_free(hk->partitions.entries);
+	pthread_mutex_destroy(&hk->lock);
+	cf_free(hk);
+}
+
+void
+as_hot_keys_add(
+	as_hot_keys* hk, const char* ns, const uint8_t* digest, uint32_t partition_id,
+	uint64_t bytes
+	)
+{
+	uint64_t now = cf_getms();
+
+	pthread_mutex_lock(&hk->lock);
+
+	if (now >= hk->decay_at) {
+		as_hot_sketch_decay(&hk->keys);
+		as_hot_sketch_decay(&hk->partitions);
+		hk->decay_at = now + AS_HOT_KEYS_DECAY_MS;
+	}
+
+	as_hot_sketch_add(&hk->keys, hk->capacity, ns, digest, partition_id, bytes);
+	as_hot_sketch_add(&hk->partitions, hk->capacity, ns, as_hot_no_digest, partition_id, bytes);
+
+	pthread_mutex_unlock(&hk->lock);
+}
+
+uint32_t
+as_hot_keys_top(as_hot_keys* hk, as_hot_key* keys, uint32_t max)
+{
+	return as_hot_sketch_top(hk, &hk->keys, keys, max);
+}
+
+uint32_t
+as_hot_keys_top_partitions(as_hot_keys* hk, as_hot_key* partitions, uint32_t max)
+{
+	return as_hot_sketch_top(hk, &hk->partitions, partitions, max);
+}
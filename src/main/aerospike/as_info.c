@@ -104,6 +104,25 @@ as_info_keep_connection(as_status status)
 	}
 }
 
+static as_event_command*
+as_info_async_create(
+	const as_policy_info* policy, as_node* node, const char* command,
+	as_async_info_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	size_t size = strlen(command);
+	as_event_command* cmd = as_async_info_command_create(node, policy, listener, udata, event_loop, size);
+	uint8_t* p = cmd->buf + sizeof(uint64_t);
+
+	memcpy(p, command, size);
+	p += size;
+	size = p - cmd->buf;
+	uint64_t proto = (size - 8) | ((uint64_t)AS_PROTO_VERSION << 56) | ((uint64_t)AS_INFO_MESSAGE_TYPE << 48);
+	*(uint64_t*)cmd->buf = cf_swap_to_be64(proto);
+	cmd->write_len = (uint32_t)size;
+	return cmd;
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -154,20 +173,24 @@ as_info_command_node_async(
 		policy = &as->config.policies.info;
 	}
 
-	size_t size = strlen(command);
-	as_event_command* cmd = as_async_info_command_create(node, policy, listener, udata, event_loop, size);
-	uint8_t* p = cmd->buf + sizeof(uint64_t);
-
-	memcpy(p, command, size);
-	p += size;
-	size = p - cmd->buf;
-	uint64_t proto = (size - 8) | ((uint64_t)AS_PROTO_VERSION << 56) | ((uint64_t)AS_INFO_MESSAGE_TYPE << 48);
-	*(uint64_t*)cmd->buf = cf_swap_to_be64(proto);
-	cmd->write_len = (uint32_t)size;
+	as_event_command* cmd = as_info_async_create(policy, node, command, listener, udata,
+		event_loop);
 
 	return as_event_command_execute(cmd, err);
 }
 
+void
+as_info_command_node_async_delay(
+	const as_policy_info* policy, as_node* node, const char* command,
+	as_async_info_listener listener, void* udata, as_event_loop* event_loop, uint32_t delay_ms
+	)
+{
+	as_event_command* cmd = as_info_async_create(policy, node, command, listener, udata,
+		event_loop);
+
+	as_event_command_schedule_delay(cmd, delay_ms);
+}
+
 as_status
 as_info_command_random_node(aerospike* as, as_error* err, as_policy_info* policy, char* command)
 {
@@ -461,3 +484,91 @@ as_info_parse_multi_response(char* buf, as_vector* /* <as_name_value> */ values)
 		as_vector_append(values, &nv);
 	}
 }
+
+bool
+as_info_reader_next(as_info_reader* reader, as_info_slice* name, as_info_slice* value)
+{
+	// Info buffer format: name1\tvalue1\nname2\tvalue2\n...
+	const char* p = reader->p;
+	const char* end = reader->end;
+
+	while (p < end && *p) {
+		if (*p == '\n') {
+			// Skip empty line.
+			p++;
+			continue;
+		}
+
+		const char* eol = memchr(p, '\n', end - p);
+
+		if (! eol) {
+			eol = end;
+		}
+
+		const char* tab = memchr(p, '\t', eol - p);
+
+		name->ptr = p;
+
+		if (tab) {
+			name->len = (uint32_t)(tab - p);
+			value->ptr = tab + 1;
+			value->len = (uint32_t)(eol - tab - 1);
+		}
+		else {
+			// Name returned without value.
+			name->len = (uint32_t)(eol - p);
+			value->ptr = eol;
+			value->len = 0;
+		}
+		reader->p = (eol < end) ? eol + 1 : end;
+		return true;
+	}
+	reader->p = end;
+	return false;
+}
+
+bool
+as_info_slice_next(as_info_slice* slice, char delim, as_info_slice* token)
+{
+	if (slice->len == 0) {
+		return false;
+	}
+
+	const char* p = slice->ptr;
+	const char* d = memchr(p, delim, slice->len);
+
+	token->ptr = p;
+
+	if (d) {
+		token->len = (uint32_t)(d - p);
+		slice->len -= token->len + 1;
+		slice->ptr = d + 1;
+	}
+	else {
+		token->len = slice->len;
+		slice->ptr = p + slice->len;
+		slice->len = 0;
+	}
+	return true;
+}
+
+bool
+as_info_slice_to_uint64(const as_info_slice* slice, uint64_t* value)
+{
+	if (slice->len == 0 || slice->len > 20) {
+		return false;
+	}
+
+	uint64_t v = 0;
+
+	for (uint32_t i = 0; i < slice->len; i++) {
+		uint32_t d = (uint8_t)slice->ptr[i] - '0';
+
+		if (d > 9 || v > (UINT64_MAX - d) / 10) {
+			return false;
+		}
+		v = v * 10 + d;
+	}
+	*value = v;
+	return true;
+}
@@ -15,12 +15,41 @@
  * the License.
  */
 #include <aerospike/as_job.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_event_internal.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_sleep.h>
 #include <aerospike/as_socket.h>
 #include <citrusleaf/alloc.h>
 #include <stdlib.h>
 
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+// Async poll interval doubles while the job runs, up to this multiple of the first interval.
+#define AS_JOB_WAIT_MAX_BACKOFF 16
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_job_wait_s {
+	as_policy_info policy;
+	as_error err;
+	as_job_info info;
+	aerospike* as;
+	as_async_write_listener listener;
+	void* udata;
+	as_event_loop* event_loop;
+	uint32_t interval_ms;
+	uint32_t max_interval_ms;
+	uint32_t pending;
+	char cmd1[128];
+	char cmd2[128];
+	char cmd3[128];
+} as_job_wait;
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -101,6 +130,114 @@ as_job_process(char* response, as_job_info* info)
 	}
 }
 
+static void
+as_job_commands_init(const char* module, uint64_t job_id, char* cmd1, char* cmd2, char* cmd3)
+{
+	sprintf(cmd1, "query-show:trid=%" PRIu64 "\n", job_id);
+	sprintf(cmd2, "%s-show:trid=%" PRIu64 "\n", module, job_id);
+	sprintf(cmd3, "jobs:module=%s;cmd=get-job;trid=%" PRIu64 "\n", module, job_id);
+}
+
+static inline char*
+as_job_command(as_node* node, char* cmd1, char* cmd2, char* cmd3)
+{
+	if (node->features & AS_FEATURES_PARTITION_QUERY) {
+		// query-show works for both scan and query.
+		return cmd1;
+	}
+
+	if (node->features & AS_FEATURES_QUERY_SHOW) {
+		// scan-show and query-show are separate.
+		return cmd2;
+	}
+
+	// old job monitor syntax.
+	return cmd3;
+}
+
+static void
+as_job_wait_round(as_job_wait* jw);
+
+static void
+as_job_wait_complete(as_job_wait* jw)
+{
+	if (jw->err.code == AEROSPIKE_OK && jw->info.status == AS_JOB_STATUS_INPROGRESS) {
+		as_event_state* event_state = &jw->as->cluster->event_state[jw->event_loop->index];
+
+		if (! event_state->closing) {
+			// Back off while the job is still running.
+			jw->interval_ms *= 2;
+
+			if (jw->interval_ms > jw->max_interval_ms) {
+				jw->interval_ms = jw->max_interval_ms;
+			}
+			as_job_wait_round(jw);
+			return;
+		}
+		as_error_set_message(&jw->err, AEROSPIKE_ERR_CLIENT, "Cluster is closing");
+	}
+
+	jw->listener(jw->err.code == AEROSPIKE_OK ? NULL : &jw->err, jw->udata, jw->event_loop);
+	cf_free(jw);
+}
+
+static void
+as_job_wait_listener(as_error* err, char* response, void* udata, as_event_loop* event_loop)
+{
+	as_job_wait* jw = udata;
+
+	if (err) {
+		if (err->code == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+			if (jw->info.status == AS_JOB_STATUS_UNDEF) {
+				jw->info.status = AS_JOB_STATUS_COMPLETED;
+			}
+		}
+		else if (jw->err.code == AEROSPIKE_OK) {
+			as_error_copy(&jw->err, err);
+		}
+	}
+	else {
+		as_job_process(response, &jw->info);
+	}
+
+	// All commands run in the same event loop, so no atomics are needed.
+	if (--jw->pending == 0) {
+		as_job_wait_complete(jw);
+	}
+}
+
+static void
+as_job_wait_round(as_job_wait* jw)
+{
+	// Must be run in event loop thread.
+	as_nodes* nodes = as_nodes_reserve(jw->as->cluster);
+
+	if (nodes->size == 0) {
+		as_nodes_release(nodes);
+		as_error_set_message(&jw->err, AEROSPIKE_ERR_CLUSTER, "Cluster is empty");
+		as_job_wait_complete(jw);
+		return;
+	}
+
+	jw->info.status = AS_JOB_STATUS_UNDEF;
+	jw->info.progress_pct = 0;
+	jw->info.records_read = 0;
+	jw->pending = nodes->size;
+
+	// Poll all nodes in parallel.  Responses can not arrive before this loop is done,
+	// because commands start after the delay in this event loop.
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_node* node = nodes->array[i];
+		char* command = as_job_command(node, jw->cmd1, jw->cmd2, jw->cmd3);
+
+		// The async info command releases the node when it completes.
+		as_node_reserve(node);
+		as_info_command_node_async_delay(&jw->policy, node, command, as_job_wait_listener, jw,
+			jw->event_loop, jw->interval_ms);
+	}
+	as_nodes_release(nodes);
+}
+
 /******************************************************************************
  * PUBLIC FUNCTIONS
  *****************************************************************************/
@@ -126,6 +263,44 @@ aerospike_job_wait(
 	return status;
 }
 
+as_status
+aerospike_job_wait_async(
+	aerospike* as, as_error* err, const as_policy_info* policy, const char* module, uint64_t job_id,
+	uint32_t interval_ms, as_async_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.info;
+	}
+
+	if (!interval_ms) {
+		interval_ms = 1000;
+	}
+
+	as_job_wait* jw = cf_malloc(sizeof(as_job_wait));
+	jw->policy = *policy;
+	as_error_init(&jw->err);
+	jw->info.status = AS_JOB_STATUS_UNDEF;
+	jw->info.progress_pct = 0;
+	jw->info.records_read = 0;
+	jw->as = as;
+	jw->listener = listener;
+	jw->udata = udata;
+	jw->event_loop = as_event_assign(event_loop);
+	jw->interval_ms = interval_ms;
+	jw->max_interval_ms = interval_ms * AS_JOB_WAIT_MAX_BACKOFF;
+	jw->pending = 0;
+	as_job_commands_init(module, job_id, jw->cmd1, jw->cmd2, jw->cmd3);
+
+	if (! as_event_execute(jw->event_loop, (as_event_executable)as_job_wait_round, jw)) {
+		cf_free(jw);
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Failed to queue job wait");
+	}
+	return AEROSPIKE_OK;
+}
+
 as_status
 aerospike_job_info(
 	aerospike* as, as_error* err, const as_policy_info* policy, const char* module, uint64_t job_id,
@@ -140,9 +315,7 @@ aerospike_job_info(
 	char cmd1[128];
 	char cmd2[128];
 	char cmd3[128];
-	sprintf(cmd1, "query-show:trid=%" PRIu64 "\n", job_id);
-	sprintf(cmd2, "%s-show:trid=%" PRIu64 "\n", module, job_id);
-	sprintf(cmd3, "jobs:module=%s;cmd=get-job;trid=%" PRIu64 "\n", module, job_id);
+	as_job_commands_init(module, job_id, cmd1, cmd2, cmd3);
 
 	info->status = AS_JOB_STATUS_UNDEF;
 	info->progress_pct = 0;
@@ -155,21 +328,7 @@ aerospike_job_info(
 	
 	for (uint32_t i = 0; i < nodes->size; i++) {
 		as_node* node = nodes->array[i];
-		char* command;
-
-		if (node->features & AS_FEATURES_PARTITION_QUERY) {
-			// query-show works for both scan and query.
-			command = cmd1;
-		}
-		else if (node->features & AS_FEATURES_QUERY_SHOW) {
-			// scan-show and query-show are separate.
-			command = cmd2;
-		}
-		else {
-			// old job monitor syntax.
-			command = cmd3;
-		}
-
+		char* command = as_job_command(node, cmd1, cmd2, cmd3);
 		char* response = 0;
 		
 		status = as_info_command_node(err, node, command, true, deadline, &response);
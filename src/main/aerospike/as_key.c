@@ -17,6 +17,7 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_double.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_ripemd160.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_bytes.h>
 
@@ -46,6 +47,7 @@ as_key_cons(
 
 	key->_free = free;
 	key->valuep = (as_key_value *) valuep;
+	key->ns_id = 0;
 	
 	if (digest == NULL) {
 		key->digest.init = false;
@@ -237,17 +239,13 @@ as_key_digest(as_key* key)
 	}
 }
 
-as_status
-as_key_set_digest(as_error* err, as_key* key)
+static as_status
+as_key_value_digest(as_error* err, const char* set, const as_key_value* valuep, uint8_t* digest)
 {
-	if (key->digest.init) {
-		return AEROSPIKE_OK;
-	}
-	
-	size_t set_len = strlen(key->set);
+	size_t set_len = strlen(set);
 	size_t size;
 	
-	as_val* val = (as_val*)key->valuep;
+	as_val* val = (as_val*)valuep;
 	uint8_t* buf;
 	
 	switch (val->type) {
@@ -292,7 +290,129 @@ as_key_set_digest(as_error* err, as_key* key)
 		}
 	}
 		
-	cf_digest_compute2(key->set, set_len, buf, size, (cf_digest*)key->digest.value);
+	cf_digest_compute2(set, set_len, buf, size, (cf_digest*)digest);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_key_set_digest(as_error* err, as_key* key)
+{
+	if (key->digest.init) {
+		return AEROSPIKE_OK;
+	}
+
+	as_status status = as_key_value_digest(err, key->set, key->valuep, key->digest.value);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
 	key->digest.init = true;
 	return AEROSPIKE_OK;
 }
+
+as_status
+as_key_view_digest(as_error* err, const as_key_view* view, as_digest_value digest)
+{
+	if (view->digest) {
+		memcpy(digest, view->digest, AS_DIGEST_VALUE_SIZE);
+		return AEROSPIKE_OK;
+	}
+
+	if (! view->valuep) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Key view has no value or digest");
+	}
+	return as_key_value_digest(err, view->set, view->valuep, digest);
+}
+
+// Number of keys whose digests are computed in one multi-lane call.
+#define AS_KEY_DIGEST_CHUNK 32
+
+static inline void
+as_key_digest_flush(as_ripemd160_msg* msgs, as_key** pending, uint32_t n)
+{
+	as_ripemd160_multi(msgs, n);
+
+	for (uint32_t i = 0; i < n; i++) {
+		pending[i]->digest.init = true;
+	}
+}
+
+as_status
+as_key_set_digests(as_error* err, as_key* keys, uint32_t n_keys, size_t stride)
+{
+	as_ripemd160_msg msgs[AS_KEY_DIGEST_CHUNK];
+	as_key* pending[AS_KEY_DIGEST_CHUNK];
+	uint8_t prefix[AS_KEY_DIGEST_CHUNK][9];
+	uint8_t* p = (uint8_t*)keys;
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < n_keys; i++, p += stride) {
+		as_key* key = (as_key*)p;
+
+		if (key->digest.init) {
+			continue;
+		}
+
+		// Digest is computed over set name, particle type and key value.
+		as_ripemd160_msg* m = &msgs[n];
+		uint8_t* buf = prefix[n];
+		as_val* val = (as_val*)key->valuep;
+
+		m->seg[0] = (const uint8_t*)key->set;
+		m->len[0] = strlen(key->set);
+		m->seg[1] = buf;
+
+		switch (val->type) {
+			case AS_INTEGER: {
+				as_integer* v = as_integer_fromval(val);
+				buf[0] = AS_BYTES_INTEGER;
+				*(uint64_t*)&buf[1] = cf_swap_to_be64(v->value);
+				m->len[1] = 9;
+				m->seg[2] = NULL;
+				m->len[2] = 0;
+				break;
+			}
+			case AS_DOUBLE: {
+				as_double* v = as_double_fromval(val);
+				buf[0] = AS_BYTES_DOUBLE;
+				*(double*)&buf[1] = cf_swap_to_big_float64(v->value);
+				m->len[1] = 9;
+				m->seg[2] = NULL;
+				m->len[2] = 0;
+				break;
+			}
+			case AS_STRING: {
+				as_string* v = as_string_fromval(val);
+				buf[0] = AS_BYTES_STRING;
+				m->len[1] = 1;
+				m->seg[2] = (const uint8_t*)v->value;
+				m->len[2] = as_string_len(v);
+				break;
+			}
+			case AS_BYTES: {
+				as_bytes* v = as_bytes_fromval(val);
+				// Note: v->type must be a blob type. See as_key_set_digest().
+				buf[0] = v->type;
+				m->len[1] = 1;
+				m->seg[2] = v->value;
+				m->len[2] = v->size;
+				break;
+			}
+			default: {
+				as_key_digest_flush(msgs, pending, n);
+				return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid key type: %d", val->type);
+			}
+		}
+
+		m->out = key->digest.value;
+		pending[n++] = key;
+
+		if (n == AS_KEY_DIGEST_CHUNK) {
+			as_key_digest_flush(msgs, pending, n);
+			n = 0;
+		}
+	}
+
+	as_key_digest_flush(msgs, pending, n);
+	return AEROSPIKE_OK;
+}
@@ -79,7 +79,7 @@ as_list_range(
 	if (end) {
 		as_pack_val(&pk, end);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(begin);
 	as_val_destroy(end);
 	return as_cdt_add_packed(&pk, ops, name, op_type);
@@ -100,7 +100,7 @@ as_operations_list_create(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header_flag(&pk, ctx, SET_TYPE, 1, flag);
 	as_pack_uint64(&pk, (uint64_t)order);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -112,7 +112,7 @@ as_operations_list_set_order(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, SET_TYPE, 1);
 	as_pack_uint64(&pk, (uint64_t)order);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -124,7 +124,7 @@ as_operations_list_sort(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, SORT, 1);
 	as_pack_uint64(&pk, (uint64_t)flags);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -143,7 +143,7 @@ as_operations_list_append(
 		as_pack_uint64(&pk, (uint64_t)policy->order);
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(val);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -163,7 +163,7 @@ as_operations_list_append_items(
 		as_pack_uint64(&pk, (uint64_t)policy->order);
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(list);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -184,7 +184,7 @@ as_operations_list_insert(
 		// as_list_policy.order is not sent because inserts are not allowed on sorted lists.
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(val);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -205,7 +205,7 @@ as_operations_list_insert_items(
 		// as_list_policy.order is not sent because inserts are not allowed on sorted lists.
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(list);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -234,7 +234,7 @@ as_operations_list_increment(
 		as_pack_uint64(&pk, (uint64_t)policy->order);
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(incr);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -254,7 +254,7 @@ as_operations_list_set(
 	if (policy) {
 		as_pack_uint64(&pk, (uint64_t)policy->flags);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(val);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -265,7 +265,7 @@ as_operations_list_pop(as_operations* ops, const as_bin_name name, as_cdt_ctx* c
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, POP, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -278,7 +278,7 @@ as_operations_list_pop_range(as_operations* ops, const as_bin_name name, as_cdt_
 	as_cdt_pack_header(&pk, ctx, POP_RANGE, 2);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -290,7 +290,7 @@ as_operations_list_pop_range_from(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, POP_RANGE, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -302,7 +302,7 @@ as_operations_list_remove(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, REMOVE, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -315,7 +315,7 @@ as_operations_list_remove_range(
 	as_cdt_pack_header(&pk, ctx, REMOVE_RANGE, 2);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -327,7 +327,7 @@ as_operations_list_remove_range_from(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, REMOVE_RANGE, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -341,7 +341,7 @@ as_operations_list_remove_by_value(
 	as_cdt_pack_header(&pk, ctx, REMOVE_ALL_BY_VALUE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, value);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -356,7 +356,7 @@ as_operations_list_remove_by_value_list(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_VALUE_LIST, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, (as_val*)values);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(values);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -382,7 +382,7 @@ as_operations_list_remove_by_value_rel_rank_range_to_end(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -399,7 +399,7 @@ as_operations_list_remove_by_value_rel_rank_range(
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
@@ -414,7 +414,7 @@ as_operations_list_remove_by_index(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_INDEX, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -428,7 +428,7 @@ as_operations_list_remove_by_index_range_to_end(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_INDEX_RANGE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -443,7 +443,7 @@ as_operations_list_remove_by_index_range(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -457,7 +457,7 @@ as_operations_list_remove_by_rank(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_RANK, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -471,7 +471,7 @@ as_operations_list_remove_by_rank_range_to_end(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_RANK_RANGE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -486,7 +486,7 @@ as_operations_list_remove_by_rank_range(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -499,7 +499,7 @@ as_operations_list_trim(
 	as_cdt_pack_header(&pk, ctx, TRIM, 2);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -508,7 +508,7 @@ as_operations_list_clear(as_operations* ops, const as_bin_name name, as_cdt_ctx*
 {
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, CLEAR, 0);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_MODIFY);
 }
 
@@ -517,7 +517,7 @@ as_operations_list_size(as_operations* ops, const as_bin_name name, as_cdt_ctx*
 {
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, SIZE, 0);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -527,7 +527,7 @@ as_operations_list_get(as_operations* ops, const as_bin_name name, as_cdt_ctx* c
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, GET, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -540,7 +540,7 @@ as_operations_list_get_range(
 	as_cdt_pack_header(&pk, ctx, GET_RANGE, 2);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -552,7 +552,7 @@ as_operations_list_get_range_from(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, GET_RANGE, 1);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -566,7 +566,7 @@ as_operations_list_get_by_value(
 	as_cdt_pack_header(&pk, ctx, GET_ALL_BY_VALUE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, value);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
@@ -591,7 +591,7 @@ as_operations_list_get_by_value_list(
 	as_cdt_pack_header(&pk, ctx, GET_BY_VALUE_LIST, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, (as_val*)values);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(values);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
@@ -607,7 +607,7 @@ as_operations_list_get_by_value_rel_rank_range_to_end(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
@@ -624,7 +624,7 @@ as_operations_list_get_by_value_rel_rank_range(
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
@@ -639,7 +639,7 @@ as_operations_list_get_by_index(
 	as_cdt_pack_header(&pk, ctx, GET_BY_INDEX, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -653,7 +653,7 @@ as_operations_list_get_by_index_range_to_end(
 	as_cdt_pack_header(&pk, ctx, GET_BY_INDEX_RANGE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -668,7 +668,7 @@ as_operations_list_get_by_index_range(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -682,7 +682,7 @@ as_operations_list_get_by_rank(
 	as_cdt_pack_header(&pk, ctx, GET_BY_RANK, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -696,7 +696,7 @@ as_operations_list_get_by_rank_range_to_end(
 	as_cdt_pack_header(&pk, ctx, GET_BY_RANK_RANGE, 2);
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
 
@@ -711,6 +711,6 @@ as_operations_list_get_by_rank_range(
 	as_pack_uint64(&pk, (uint64_t)return_type);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_CDT_READ);
 }
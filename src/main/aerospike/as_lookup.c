@@ -16,10 +16,13 @@
  */
 #include <aerospike/as_lookup.h>
 #include <aerospike/as_admin.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_string_builder.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
 
 /******************************************************************************
  * Declarations
@@ -69,7 +72,7 @@ as_switch_to_clear_socket(as_cluster* cluster, as_error* err, as_node_info* node
 	for (uint32_t i = 0; i < hosts.size; i++) {
 		host = as_vector_get(&hosts, i);
 		hostname = as_cluster_get_alternate_host(cluster, host->name);
-		status = as_lookup_host(&iter, &error_local, hostname, host->port);
+		status = as_lookup_host(cluster->dns_cache, &iter, &error_local, hostname, host->port);
 
 		if (status) {
 			continue;
@@ -156,7 +159,7 @@ as_set_node_address(as_cluster* cluster, as_error* err, char* response, char* tl
 	for (uint32_t i = 0; i < hosts.size; i++) {
 		host = as_vector_get(&hosts, i);
 		hostname = as_cluster_get_alternate_host(cluster, host->name);
-		status = as_lookup_host(&iter, &error_local, hostname, host->port);
+		status = as_lookup_host(cluster->dns_cache, &iter, &error_local, hostname, host->port);
 
 		if (status != AEROSPIKE_OK) {
 			continue;
@@ -218,14 +221,264 @@ as_set_node_address(as_cluster* cluster, as_error* err, char* response, char* tl
 	return AEROSPIKE_OK;
 }
 
+/******************************************************************************
+ * DNS Cache
+ *****************************************************************************/
+
+typedef struct as_dns_entry_s {
+	char* hostname;
+	struct sockaddr_storage* addrs;
+	uint64_t expiration;
+	uint32_t size;
+	bool refreshing;
+} as_dns_entry;
+
+struct as_dns_cache_s {
+	pthread_mutex_t lock;
+	as_vector entries;
+	uint64_t ttl_ms;
+	uint32_t ref_count;
+};
+
+typedef struct as_dns_refresh_s {
+	as_dns_cache* cache;
+	char* hostname;
+} as_dns_refresh;
+
+static as_status
+as_dns_resolve(
+	as_error* err, const char* hostname, struct sockaddr_storage** addrs, uint32_t* size
+	)
+{
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	struct addrinfo* addresses;
+	int ret = getaddrinfo(hostname, NULL, &hints, &addresses);
+
+	if (ret) {
+		return as_error_update(err, AEROSPIKE_ERR_INVALID_HOST, "Invalid hostname %s: %s",
+							   hostname, gai_strerror(ret));
+	}
+
+	uint32_t n = 0;
+
+	for (struct addrinfo* ai = addresses; ai; ai = ai->ai_next) {
+		n++;
+	}
+
+	struct sockaddr_storage* list = cf_malloc(sizeof(struct sockaddr_storage) * (n ? n : 1));
+	uint32_t count = 0;
+
+	for (struct addrinfo* ai = addresses; ai; ai = ai->ai_next) {
+		if (ai->ai_family == AF_INET || ai->ai_family == AF_INET6) {
+			memset(&list[count], 0, sizeof(struct sockaddr_storage));
+			memcpy(&list[count], ai->ai_addr, ai->ai_addrlen);
+			count++;
+		}
+	}
+	freeaddrinfo(addresses);
+
+	if (count == 0) {
+		cf_free(list);
+		return as_error_update(err, AEROSPIKE_ERR_INVALID_HOST,
+							   "Invalid hostname %s: no IP addresses", hostname);
+	}
+
+	*addrs = list;
+	*size = count;
+	return AEROSPIKE_OK;
+}
+
+static as_dns_entry*
+as_dns_cache_find(as_dns_cache* cache, const char* hostname)
+{
+	// Must hold cache lock.
+	for (uint32_t i = 0; i < cache->entries.size; i++) {
+		as_dns_entry* entry = as_vector_get(&cache->entries, i);
+
+		if (strcmp(entry->hostname, hostname) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void
+as_dns_cache_store(
+	as_dns_cache* cache, const char* hostname, struct sockaddr_storage* addrs, uint32_t size
+	)
+{
+	// Must hold cache lock. Takes ownership of addrs.
+	as_dns_entry* entry = as_dns_cache_find(cache, hostname);
+
+	if (entry) {
+		cf_free(entry->addrs);
+	}
+	else {
+		entry = as_vector_reserve(&cache->entries);
+		entry->hostname = cf_strdup(hostname);
+	}
+	entry->addrs = addrs;
+	entry->size = size;
+	entry->expiration = cf_getms() + cache->ttl_ms;
+	entry->refreshing = false;
+}
+
+static void
+as_dns_iter_set(as_address_iterator* iter, struct sockaddr_storage* addrs, uint32_t size)
+{
+	// Give iterator its own copy, because as_lookup_next() writes the port.
+	iter->cached = cf_malloc(sizeof(struct sockaddr_storage) * size);
+	memcpy(iter->cached, addrs, sizeof(struct sockaddr_storage) * size);
+	iter->cached_size = size;
+}
+
+static void*
+as_dns_refresh_run(void* data)
+{
+	as_dns_refresh* refresh = data;
+	as_dns_cache* cache = refresh->cache;
+
+	as_error err;
+	struct sockaddr_storage* addrs;
+	uint32_t size;
+	as_status status = as_dns_resolve(&err, refresh->hostname, &addrs, &size);
+
+	pthread_mutex_lock(&cache->lock);
+
+	if (status == AEROSPIKE_OK) {
+		as_dns_cache_store(cache, refresh->hostname, addrs, size);
+	}
+	else {
+		// Keep last known addresses and try again after another ttl.
+		as_dns_entry* entry = as_dns_cache_find(cache, refresh->hostname);
+
+		if (entry) {
+			entry->expiration = cf_getms() + cache->ttl_ms;
+			entry->refreshing = false;
+		}
+		as_log_warn("Failed to refresh %s: %s", refresh->hostname, err.message);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	cf_free(refresh->hostname);
+	cf_free(refresh);
+	as_dns_cache_release(cache);
+	return NULL;
+}
+
+static bool
+as_dns_refresh_start(as_dns_cache* cache, const char* hostname)
+{
+	as_dns_refresh* refresh = cf_malloc(sizeof(as_dns_refresh));
+	refresh->cache = cache;
+	refresh->hostname = cf_strdup(hostname);
+	as_incr_uint32(&cache->ref_count);
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_t thread;
+	int rv = pthread_create(&thread, &attr, as_dns_refresh_run, refresh);
+	pthread_attr_destroy(&attr);
+
+	if (rv != 0) {
+		cf_free(refresh->hostname);
+		cf_free(refresh);
+		as_aaf_uint32(&cache->ref_count, -1);
+		return false;
+	}
+	return true;
+}
+
+static as_status
+as_dns_cache_lookup(
+	as_dns_cache* cache, as_address_iterator* iter, as_error* err, const char* hostname
+	)
+{
+	pthread_mutex_lock(&cache->lock);
+
+	as_dns_entry* entry = as_dns_cache_find(cache, hostname);
+
+	if (entry) {
+		// Expired addresses are still returned while they are resolved again in the
+		// background, so callers never wait on DNS for a known hostname.
+		if (! entry->refreshing && cf_getms() >= entry->expiration) {
+			entry->refreshing = as_dns_refresh_start(cache, hostname);
+		}
+		as_dns_iter_set(iter, entry->addrs, entry->size);
+		pthread_mutex_unlock(&cache->lock);
+		return AEROSPIKE_OK;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	// First lookup of this hostname must resolve in the calling thread.
+	struct sockaddr_storage* addrs;
+	uint32_t size;
+	as_status status = as_dns_resolve(err, hostname, &addrs, &size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_dns_iter_set(iter, addrs, size);
+
+	pthread_mutex_lock(&cache->lock);
+	as_dns_cache_store(cache, hostname, addrs, size);
+	pthread_mutex_unlock(&cache->lock);
+	return AEROSPIKE_OK;
+}
+
 /******************************************************************************
  * Functions
  *****************************************************************************/
 
+as_dns_cache*
+as_dns_cache_create(uint32_t ttl_ms)
+{
+	as_dns_cache* cache = cf_malloc(sizeof(as_dns_cache));
+	pthread_mutex_init(&cache->lock, NULL);
+	as_vector_init(&cache->entries, sizeof(as_dns_entry), 8);
+	cache->ttl_ms = ttl_ms;
+	cache->ref_count = 1;
+	return cache;
+}
+
+void
+as_dns_cache_release(as_dns_cache* cache)
+{
+	if (as_aaf_uint32(&cache->ref_count, -1) != 0) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < cache->entries.size; i++) {
+		as_dns_entry* entry = as_vector_get(&cache->entries, i);
+		cf_free(entry->hostname);
+		cf_free(entry->addrs);
+	}
+	as_vector_destroy(&cache->entries);
+	pthread_mutex_destroy(&cache->lock);
+	cf_free(cache);
+}
+
 as_status
-as_lookup_host(as_address_iterator* iter, as_error* err, const char* hostname, uint16_t port)
+as_lookup_host(
+	as_dns_cache* cache, as_address_iterator* iter, as_error* err, const char* hostname,
+	uint16_t port
+	)
 {
 	iter->hostname_is_alias = true;
+	iter->addresses = NULL;
+	iter->cached = NULL;
+	iter->cached_size = 0;
+	iter->cached_index = 0;
+	iter->port_be = cf_swap_to_be16(port);
 
 	struct addrinfo hints;
 	memset(&hints, 0, sizeof(hints));
@@ -250,6 +503,10 @@ as_lookup_host(as_address_iterator* iter, as_error* err, const char* hostname, u
 			iter->hostname_is_alias = false;
 		}
 	}
+
+	if (cache && iter->hostname_is_alias) {
+		return as_dns_cache_lookup(cache, iter, err, hostname);
+	}
 	
 	int ret = getaddrinfo(hostname, NULL, &hints, &iter->addresses);
 	
@@ -259,7 +516,6 @@ as_lookup_host(as_address_iterator* iter, as_error* err, const char* hostname, u
 	}
 	
 	iter->current = iter->addresses;
-	iter->port_be = cf_swap_to_be16(port);
 	return AEROSPIKE_OK;
 }
 
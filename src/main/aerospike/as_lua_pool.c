@@ -0,0 +1,307 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_lua_pool.h>
+#include <aerospike/aerospike.h>
+#include <aerospike/as_aerospike.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_udf.h>
+#include <aerospike/mod_lua.h>
+#include <citrusleaf/alloc.h>
+#include <pthread.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	char module[AS_UDF_MODULE_MAX_SIZE];
+	char function[AS_UDF_FUNCTION_MAX_SIZE];
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint32_t n_threads;
+	uint32_t arrived;
+	uint32_t errors;
+} as_lua_warm;
+
+typedef struct {
+	as_lua_warm* warm;
+	bool arrived;
+} as_lua_warm_thread;
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+static as_lua_pool_stats as_lua_stats = {0, 0, 0, 0};
+static uint32_t as_lua_running = 0;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static uint32_t
+as_lua_cpu_count(void)
+{
+#if defined(_MSC_VER)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (uint32_t)n : 1;
+#endif
+}
+
+static void
+as_lua_warm_arrive(as_lua_warm_thread* t)
+{
+	as_lua_warm* warm = t->warm;
+
+	pthread_mutex_lock(&warm->lock);
+
+	if (! t->arrived) {
+		t->arrived = true;
+		warm->arrived++;
+		pthread_cond_broadcast(&warm->cond);
+	}
+	pthread_mutex_unlock(&warm->lock);
+}
+
+static as_val*
+as_lua_warm_read(const as_stream* s)
+{
+	as_lua_warm_thread* t = as_stream_source(s);
+	as_lua_warm* warm = t->warm;
+
+	as_lua_warm_arrive(t);
+
+	// Hold this lua state until every warm up call holds its own state, so the cache
+	// ends up with n_threads states.
+	pthread_mutex_lock(&warm->lock);
+
+	while (warm->arrived < warm->n_threads) {
+		pthread_cond_wait(&warm->cond, &warm->lock);
+	}
+	pthread_mutex_unlock(&warm->lock);
+	return NULL;
+}
+
+static as_stream_status
+as_lua_warm_write(const as_stream* s, as_val* val)
+{
+	as_val_destroy(val);
+	return AS_STREAM_OK;
+}
+
+static int
+as_lua_warm_destroy(as_stream* s)
+{
+	return 0;
+}
+
+static const as_stream_hooks as_lua_warm_hooks = {
+	.destroy  = as_lua_warm_destroy,
+	.read     = as_lua_warm_read,
+	.write    = as_lua_warm_write
+};
+
+static const as_aerospike_hooks as_lua_warm_aerospike_hooks = {
+	.destroy = NULL,
+	.rec_create = NULL,
+	.rec_update = NULL,
+	.rec_remove = NULL,
+	.rec_exists = NULL,
+	.log = NULL,
+};
+
+static void*
+as_lua_warm_run(void* data)
+{
+	as_lua_warm_thread* t = data;
+	as_lua_warm* warm = t->warm;
+
+	as_aerospike as;
+	as_aerospike_init(&as, NULL, &as_lua_warm_aerospike_hooks);
+
+	as_udf_context ctx = {
+		.as = &as,
+		.timer = NULL,
+		.memtracker = NULL
+	};
+
+	as_stream istream;
+	as_stream_init(&istream, t, &as_lua_warm_hooks);
+
+	as_stream ostream;
+	as_stream_init(&ostream, t, &as_lua_warm_hooks);
+
+	as_result res;
+	as_result_init(&res);
+
+	int rc = as_module_apply_stream(&mod_lua, &ctx, warm->module, warm->function, &istream,
+		NULL, &ostream, &res);
+
+	if (rc) {
+		char* rs = as_module_err_string(rc);
+		as_log_warn("Lua warm up %s.%s failed: %s", warm->module, warm->function, rs);
+		cf_free(rs);
+		as_incr_uint32(&warm->errors);
+	}
+	as_result_destroy(&res);
+
+	// Release other calls if this call failed before reading the stream.
+	as_lua_warm_arrive(t);
+	return NULL;
+}
+
+static void
+as_lua_warm_function(const char* name, uint32_t n_threads)
+{
+	const char* dot = strchr(name, '.');
+
+	if (! dot || dot == name || (size_t)(dot - name) >= AS_UDF_MODULE_MAX_SIZE) {
+		as_log_warn("Invalid lua warm up function: %s", name);
+		as_incr_uint32(&as_lua_stats.warm_errors);
+		return;
+	}
+
+	as_lua_warm warm;
+	memcpy(warm.module, name, dot - name);
+	warm.module[dot - name] = 0;
+	as_strncpy(warm.function, dot + 1, sizeof(warm.function));
+	pthread_mutex_init(&warm.lock, NULL);
+	pthread_cond_init(&warm.cond, NULL);
+	warm.n_threads = n_threads;
+	warm.arrived = 0;
+	warm.errors = 0;
+
+	pthread_t* threads = cf_malloc(sizeof(pthread_t) * n_threads);
+	as_lua_warm_thread* ts = cf_malloc(sizeof(as_lua_warm_thread) * n_threads);
+	uint32_t started = 0;
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		ts[i].warm = &warm;
+		ts[i].arrived = false;
+
+		if (pthread_create(&threads[i], NULL, as_lua_warm_run, &ts[i]) != 0) {
+			break;
+		}
+		started++;
+	}
+
+	if (started < n_threads) {
+		// Threads that could not be created never arrive.
+		pthread_mutex_lock(&warm.lock);
+		warm.n_threads = started;
+		pthread_cond_broadcast(&warm.cond);
+		pthread_mutex_unlock(&warm.lock);
+	}
+
+	for (uint32_t i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	// Each module has its own cached states, so count states of the largest warm up.
+	uint32_t states = started - warm.errors;
+
+	if (states > as_lua_stats.warm_states) {
+		as_store_uint32(&as_lua_stats.warm_states, states);
+	}
+	as_store_uint32(&as_lua_stats.warm_errors, as_lua_stats.warm_errors + warm.errors);
+
+	cf_free(ts);
+	cf_free(threads);
+	pthread_cond_destroy(&warm.cond);
+	pthread_mutex_destroy(&warm.lock);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_lua_pool_get_stats(as_lua_pool_stats* stats)
+{
+	stats->warm_states = as_load_uint32(&as_lua_stats.warm_states);
+	stats->warm_errors = as_load_uint32(&as_lua_stats.warm_errors);
+	stats->hits = as_load_uint64(&as_lua_stats.hits);
+	stats->misses = as_load_uint64(&as_lua_stats.misses);
+}
+
+void
+as_lua_pool_warm(as_config_lua* config)
+{
+	if (! config->cache_enabled || ! config->warm_functions[0]) {
+		return;
+	}
+
+	uint32_t n_threads = config->warm_states > 0 ? config->warm_states : as_lua_cpu_count();
+
+	char list[AS_CONFIG_LUA_WARM_MAX_SIZE];
+	as_strncpy(list, config->warm_functions, sizeof(list));
+
+	char* p = list;
+
+	while (p) {
+		char* next = strchr(p, ',');
+
+		if (next) {
+			*next++ = 0;
+		}
+
+		while (*p == ' ') {
+			p++;
+		}
+
+		if (*p) {
+			as_lua_warm_function(p, n_threads);
+		}
+		p = next;
+	}
+}
+
+int
+as_lua_pool_apply_stream(
+	as_udf_context* ctx, const char* filename, const char* function, as_stream* istream,
+	as_list* args, as_stream* ostream, as_result* res
+	)
+{
+	aerospike_init_lua_deferred();
+
+	uint32_t running = as_aaf_uint32(&as_lua_running, 1);
+
+	if (running <= as_load_uint32(&as_lua_stats.warm_states)) {
+		as_incr_uint64(&as_lua_stats.hits);
+	}
+	else {
+		as_incr_uint64(&as_lua_stats.misses);
+	}
+
+	int rc = as_module_apply_stream(&mod_lua, ctx, filename, function, istream, args, ostream,
+		res);
+
+	as_decr_uint32(&as_lua_running);
+	return rc;
+}
@@ -81,7 +81,7 @@ as_map_range(
 	if (end) {
 		as_pack_val(&pk, end);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(begin);
 	as_val_destroy(end);
 	return as_cdt_add_packed(&pk, ops, name, op_type);
@@ -147,7 +147,7 @@ as_operations_map_create(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header_flag(&pk, ctx, SET_TYPE, 1, flag);
 	as_pack_uint64(&pk, (uint64_t)order);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -159,7 +159,7 @@ as_operations_map_set_policy(
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, SET_TYPE, 1);
 	as_pack_uint64(&pk, policy->attributes);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -195,7 +195,7 @@ as_operations_map_put(
 		as_pack_val(&pk, value);
 		as_pack_uint64(&pk, policy->attributes);
 	}
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
@@ -231,7 +231,7 @@ as_operations_map_put_items(
 		as_pack_uint64(&pk, policy->attributes);
 	}
 
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_map_destroy(items);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -249,7 +249,7 @@ as_operations_map_increment(
 	as_pack_val(&pk, key);
 	as_pack_val(&pk, val);
 	as_pack_uint64(&pk, policy->attributes);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
@@ -268,7 +268,7 @@ as_operations_map_decrement(
 	as_pack_val(&pk, key);
 	as_pack_val(&pk, val);
 	as_pack_uint64(&pk, policy->attributes);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
@@ -279,7 +279,7 @@ as_operations_map_clear(as_operations* ops, const as_bin_name name, as_cdt_ctx*
 {
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, CLEAR, 0);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -293,7 +293,7 @@ as_operations_map_remove_by_key(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_KEY, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, key);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -308,7 +308,7 @@ as_operations_map_remove_by_key_list(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_KEY_LIST, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, (as_val*)keys);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(keys);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -334,7 +334,7 @@ as_operations_map_remove_by_key_rel_index_range_to_end(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, key);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -351,7 +351,7 @@ as_operations_map_remove_by_key_rel_index_range(
 	as_pack_val(&pk, key);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -366,7 +366,7 @@ as_operations_map_remove_by_value(
 	as_cdt_pack_header(&pk, ctx, REMOVE_ALL_BY_VALUE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, value);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -381,7 +381,7 @@ as_operations_map_remove_by_value_list(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_VALUE_LIST, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, (as_val*)values);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(values);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -407,7 +407,7 @@ as_operations_map_remove_by_value_rel_rank_range_to_end(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -424,7 +424,7 @@ as_operations_map_remove_by_value_rel_rank_range(
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
@@ -439,7 +439,7 @@ as_operations_map_remove_by_index(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_INDEX, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -453,7 +453,7 @@ as_operations_map_remove_by_index_range_to_end(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_INDEX_RANGE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -468,7 +468,7 @@ as_operations_map_remove_by_index_range(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -482,7 +482,7 @@ as_operations_map_remove_by_rank(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_RANK, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -496,7 +496,7 @@ as_operations_map_remove_by_rank_range_to_end(
 	as_cdt_pack_header(&pk, ctx, REMOVE_BY_RANK_RANGE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -511,7 +511,7 @@ as_operations_map_remove_by_rank_range(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_MODIFY);
 }
 
@@ -520,7 +520,7 @@ as_operations_map_size(as_operations* ops, const as_bin_name name, as_cdt_ctx* c
 {
 	as_packer pk = as_cdt_begin();
 	as_cdt_pack_header(&pk, ctx, SIZE, 0);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -534,7 +534,7 @@ as_operations_map_get_by_key(
 	as_cdt_pack_header(&pk, ctx, GET_BY_KEY, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, key);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -559,7 +559,7 @@ as_operations_map_get_by_key_list(
 	as_cdt_pack_header(&pk, ctx, GET_BY_KEY_LIST, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, (as_val*)keys);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(keys);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -575,7 +575,7 @@ as_operations_map_get_by_key_rel_index_range_to_end(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, key);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -592,7 +592,7 @@ as_operations_map_get_by_key_rel_index_range(
 	as_pack_val(&pk, key);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(key);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -607,7 +607,7 @@ as_operations_map_get_by_value(
 	as_cdt_pack_header(&pk, ctx, GET_ALL_BY_VALUE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, value);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -632,7 +632,7 @@ as_operations_map_get_by_value_list(
 	as_cdt_pack_header(&pk, ctx, GET_BY_VALUE_LIST, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, (as_val*)values);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_list_destroy(values);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -648,7 +648,7 @@ as_operations_map_get_by_value_rel_rank_range_to_end(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -665,7 +665,7 @@ as_operations_map_get_by_value_rel_rank_range(
 	as_pack_val(&pk, value);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	as_val_destroy(value);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -680,7 +680,7 @@ as_operations_map_get_by_index(
 	as_cdt_pack_header(&pk, ctx, GET_BY_INDEX, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -694,7 +694,7 @@ as_operations_map_get_by_index_range_to_end(
 	as_cdt_pack_header(&pk, ctx, GET_BY_INDEX_RANGE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -709,7 +709,7 @@ as_operations_map_get_by_index_range(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, index);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -723,7 +723,7 @@ as_operations_map_get_by_rank(
 	as_cdt_pack_header(&pk, ctx, GET_BY_RANK, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -737,7 +737,7 @@ as_operations_map_get_by_rank_range_to_end(
 	as_cdt_pack_header(&pk, ctx, GET_BY_RANK_RANGE, 2);
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
 
@@ -752,6 +752,6 @@ as_operations_map_get_by_rank_range(
 	as_pack_int64(&pk, (int64_t)return_type);
 	as_pack_int64(&pk, rank);
 	as_pack_uint64(&pk, count);
-	as_cdt_end(&pk);
+	as_cdt_end(&pk, ops);
 	return as_cdt_add_packed(&pk, ops, name, AS_OPERATOR_MAP_READ);
 }
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_memory.h>
+
+/******************************************************************************
+ * GLOBAL VARIABLES
+ *****************************************************************************/
+
+as_memory_counter as_memory_counters[AS_MEMORY_MAX];
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+const char*
+as_memory_tag_name(as_memory_tag tag)
+{
+	switch (tag) {
+		case AS_MEMORY_COMMAND:
+			return "command";
+		case AS_MEMORY_EVENT:
+			return "event";
+		case AS_MEMORY_BATCH:
+			return "batch";
+		case AS_MEMORY_QUERY:
+			return "query";
+		case AS_MEMORY_TEND:
+			return "tend";
+		case AS_MEMORY_CACHE:
+			return "cache";
+		default:
+			return "unknown";
+	}
+}
+
+void
+as_memory_get_usage(as_memory_usage* usage)
+{
+	for (uint32_t i = 0; i < AS_MEMORY_MAX; i++) {
+		as_memory_usage* u = &as_memory_counters[i].usage;
+		usage[i].current = as_load_uint64(&u->current);
+		usage[i].peak = as_load_uint64(&u->peak);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_mpsc_queue.h>
+#include <citrusleaf/alloc.h>
+#include <string.h>
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_mpsc_queue_init(as_mpsc_queue* queue, uint32_t item_size)
+{
+	as_mpsc_node* stub = cf_malloc(sizeof(as_mpsc_node) + item_size);
+	stub->next = NULL;
+	queue->head = stub;
+	queue->tail = stub;
+	queue->item_size = item_size;
+	queue->size = 0;
+}
+
+void
+as_mpsc_queue_destroy(as_mpsc_queue* queue)
+{
+	as_mpsc_node* node = queue->head;
+
+	while (node) {
+		as_mpsc_node* next = node->next;
+		cf_free(node);
+		node = next;
+	}
+	queue->head = NULL;
+	queue->tail = NULL;
+	queue->size = 0;
+}
+
+bool
+as_mpsc_queue_push(as_mpsc_queue* queue, const void* ptr)
+{
+	as_mpsc_node* node = cf_malloc(sizeof(as_mpsc_node) + queue->item_size);
+
+	if (! node) {
+		return false;
+	}
+
+	node->next = NULL;
+	memcpy(node->data, ptr, queue->item_size);
+	as_incr_uint32(&queue->size);
+
+	// Swap tail first, then link previous tail to the new node.  The consumer can not see
+	// this node (or nodes pushed after it) until the link is stored.
+	as_mpsc_node* prev = as_fas_ptr(&queue->tail, node);
+	as_store_ptr(&prev->next, node);
+	return true;
+}
+
+bool
+as_mpsc_queue_pop(as_mpsc_queue* queue, void* ptr)
+{
+	as_mpsc_node* head = queue->head;
+	as_mpsc_node* next = as_load_ptr(&head->next);
+
+	if (! next) {
+		return false;
+	}
+
+	// The next node becomes the new stub.  Its data is consumed here and never read again.
+	memcpy(ptr, next->data, queue->item_size);
+	queue->head = next;
+	as_decr_uint32(&queue->size);
+	cf_free(head);
+	return true;
+}
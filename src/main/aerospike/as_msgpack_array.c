@@ -0,0 +1,383 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_msgpack_array.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define AS_ARRAY_SSSE3
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AS_ARRAY_NEON
+#endif
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool
+as_msgpack_array_header(const uint8_t** pp, const uint8_t* end, uint32_t* count)
+{
+	const uint8_t* p = *pp;
+
+	if (p >= end) {
+		return false;
+	}
+
+	uint8_t t = *p++;
+	uint32_t n;
+
+	if ((t & 0xf0) == 0x90) {
+		n = t & 0x0f;
+	}
+	else if (t == 0xdc && end - p >= 2) {
+		n = cf_swap_from_be16(*(uint16_t*)p);
+		p += 2;
+	}
+	else if (t == 0xdd && end - p >= 4) {
+		n = cf_swap_from_be32(*(uint32_t*)p);
+		p += 4;
+	}
+	else {
+		return false;
+	}
+
+	// Ordered lists start with a flags extension.
+	if (n > 0 && p < end && ((*p >= 0xd4 && *p <= 0xd8) || (*p >= 0xc7 && *p <= 0xc9))) {
+		uint8_t e = *p++;
+		uint64_t size;
+
+		if (e >= 0xd4) {
+			size = 1 << (e - 0xd4);
+		}
+		else if (e == 0xc7 && end - p >= 1) {
+			size = *p++;
+		}
+		else if (e == 0xc8 && end - p >= 2) {
+			size = cf_swap_from_be16(*(uint16_t*)p);
+			p += 2;
+		}
+		else if (e == 0xc9 && end - p >= 4) {
+			size = cf_swap_from_be32(*(uint32_t*)p);
+			p += 4;
+		}
+		else {
+			return false;
+		}
+
+		// Skip extension type and data.
+		if ((uint64_t)(end - p) < size + 1) {
+			return false;
+		}
+		p += size + 1;
+		n--;
+	}
+	*pp = p;
+	*count = n;
+	return true;
+}
+
+static const uint8_t*
+as_msgpack_swap_run(
+	const uint8_t* p, const uint8_t* end, uint8_t tag, uint8_t* out, uint32_t* index,
+	uint32_t count
+	)
+{
+	// 8 byte values of the same type are 9 bytes apart.
+	uint32_t i = *index;
+
+#if defined(AS_ARRAY_SSSE3)
+	const __m128i mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+	while (i + 2 <= count && end - p >= 18 && p[0] == tag && p[9] == tag) {
+		__m128i a = _mm_loadl_epi64((const __m128i*)(p + 1));
+		__m128i b = _mm_loadl_epi64((const __m128i*)(p + 10));
+		__m128i v = _mm_shuffle_epi8(_mm_unpacklo_epi64(a, b), mask);
+		_mm_storeu_si128((__m128i*)(out + (size_t)i * 8), v);
+		p += 18;
+		i += 2;
+	}
+#elif defined(AS_ARRAY_NEON)
+	while (i + 2 <= count && end - p >= 18 && p[0] == tag && p[9] == tag) {
+		uint8x16_t v = vcombine_u8(vld1_u8(p + 1), vld1_u8(p + 10));
+		vst1q_u8(out + (size_t)i * 8, vrev64q_u8(v));
+		p += 18;
+		i += 2;
+	}
+#endif
+
+	while (i < count && end - p >= 9 && p[0] == tag) {
+		uint64_t v = cf_swap_from_be64(*(uint64_t*)(p + 1));
+		memcpy(out + (size_t)i * 8, &v, 8);
+		p += 9;
+		i++;
+	}
+	*index = i;
+	return p;
+}
+
+static const uint8_t*
+as_msgpack_fixint_run(
+	const uint8_t* p, const uint8_t* end, int64_t* values, uint32_t* index, uint32_t count
+	)
+{
+	// Small non-negative integers are packed in one byte each.
+	uint32_t i = *index;
+
+#if defined(AS_ARRAY_SSSE3)
+	const __m128i zero = _mm_setzero_si128();
+
+	while (i + 16 <= count && end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+
+		if (_mm_movemask_epi8(v) != 0) {
+			break;
+		}
+
+		__m128i* out = (__m128i*)(values + i);
+		__m128i w[2] = {_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)};
+
+		for (uint32_t h = 0; h < 2; h++) {
+			__m128i d0 = _mm_unpacklo_epi16(w[h], zero);
+			__m128i d1 = _mm_unpackhi_epi16(w[h], zero);
+			_mm_storeu_si128(out++, _mm_unpacklo_epi32(d0, zero));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi32(d0, zero));
+			_mm_storeu_si128(out++, _mm_unpacklo_epi32(d1, zero));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi32(d1, zero));
+		}
+		p += 16;
+		i += 16;
+	}
+#elif defined(AS_ARRAY_NEON)
+	while (i + 16 <= count && end - p >= 16) {
+		uint8x16_t v = vld1q_u8(p);
+
+		if (vmaxvq_u8(v) >= 0x80) {
+			break;
+		}
+
+		uint16x8_t w[2] = {vmovl_u8(vget_low_u8(v)), vmovl_u8(vget_high_u8(v))};
+		uint64_t* out = (uint64_t*)(values + i);
+
+		for (uint32_t h = 0; h < 2; h++) {
+			uint32x4_t d0 = vmovl_u16(vget_low_u16(w[h]));
+			uint32x4_t d1 = vmovl_u16(vget_high_u16(w[h]));
+			vst1q_u64(out, vmovl_u32(vget_low_u32(d0)));
+			vst1q_u64(out + 2, vmovl_u32(vget_high_u32(d0)));
+			vst1q_u64(out + 4, vmovl_u32(vget_low_u32(d1)));
+			vst1q_u64(out + 6, vmovl_u32(vget_high_u32(d1)));
+			out += 8;
+		}
+		p += 16;
+		i += 16;
+	}
+#endif
+
+	while (i < count && p < end && *p <= 0x7f) {
+		values[i++] = *p++;
+	}
+	*index = i;
+	return p;
+}
+
+static bool
+as_msgpack_int64(const uint8_t** pp, const uint8_t* end, int64_t* v)
+{
+	const uint8_t* p = *pp;
+	uint8_t t = *p++;
+	size_t avail = end - p;
+
+	if (t <= 0x7f || t >= 0xe0) {
+		*v = (int8_t)t;
+	}
+	else if ((t == 0xcc || t == 0xd0) && avail >= 1) {
+		*v = (t == 0xcc) ? (int64_t)*p : (int64_t)(int8_t)*p;
+		p += 1;
+	}
+	else if ((t == 0xcd || t == 0xd1) && avail >= 2) {
+		uint16_t u = cf_swap_from_be16(*(uint16_t*)p);
+		*v = (t == 0xcd) ? (int64_t)u : (int64_t)(int16_t)u;
+		p += 2;
+	}
+	else if ((t == 0xce || t == 0xd2) && avail >= 4) {
+		uint32_t u = cf_swap_from_be32(*(uint32_t*)p);
+		*v = (t == 0xce) ? (int64_t)u : (int64_t)(int32_t)u;
+		p += 4;
+	}
+	else if ((t == 0xcf || t == 0xd3) && avail >= 8) {
+		*v = (int64_t)cf_swap_from_be64(*(uint64_t*)p);
+		p += 8;
+	}
+	else {
+		return false;
+	}
+	*pp = p;
+	return true;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_msgpack_array_status
+as_msgpack_unpack_int64_array(
+	const uint8_t* buf, uint32_t buf_size, int64_t* values, uint32_t capacity, uint32_t* size
+	)
+{
+	const uint8_t* p = buf;
+	const uint8_t* end = buf + buf_size;
+	uint32_t count;
+
+	if (! as_msgpack_array_header(&p, end, &count)) {
+		*size = 0;
+		return AS_MSGPACK_ARRAY_TYPE;
+	}
+	*size = count;
+
+	if (count > capacity) {
+		return AS_MSGPACK_ARRAY_CAPACITY;
+	}
+
+	uint32_t i = 0;
+
+	while (i < count) {
+		if (p >= end) {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+
+		uint8_t t = *p;
+
+		// Runs of values with the same encoding are decoded in bulk.
+		if (t <= 0x7f) {
+			p = as_msgpack_fixint_run(p, end, values, &i, count);
+		}
+		else if ((t == 0xcf || t == 0xd3) && end - p >= 9) {
+			p = as_msgpack_swap_run(p, end, t, (uint8_t*)values, &i, count);
+		}
+		else if (as_msgpack_int64(&p, end, &values[i])) {
+			i++;
+		}
+		else {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+	}
+	return AS_MSGPACK_ARRAY_OK;
+}
+
+as_msgpack_array_status
+as_msgpack_unpack_double_array(
+	const uint8_t* buf, uint32_t buf_size, double* values, uint32_t capacity, uint32_t* size
+	)
+{
+	const uint8_t* p = buf;
+	const uint8_t* end = buf + buf_size;
+	uint32_t count;
+
+	if (! as_msgpack_array_header(&p, end, &count)) {
+		*size = 0;
+		return AS_MSGPACK_ARRAY_TYPE;
+	}
+	*size = count;
+
+	if (count > capacity) {
+		return AS_MSGPACK_ARRAY_CAPACITY;
+	}
+
+	uint32_t i = 0;
+
+	while (i < count) {
+		if (p >= end) {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+
+		if (*p == 0xcb && end - p >= 9) {
+			p = as_msgpack_swap_run(p, end, 0xcb, (uint8_t*)values, &i, count);
+		}
+		else if (*p == 0xca && end - p >= 5) {
+			uint32_t u = cf_swap_from_be32(*(uint32_t*)(p + 1));
+			float f;
+			memcpy(&f, &u, sizeof(f));
+			values[i++] = f;
+			p += 5;
+		}
+		else {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+	}
+	return AS_MSGPACK_ARRAY_OK;
+}
+
+as_msgpack_array_status
+as_msgpack_unpack_bytes_array(
+	const uint8_t* buf, uint32_t buf_size, as_bytes_view* values, uint32_t capacity,
+	uint32_t* size
+	)
+{
+	const uint8_t* p = buf;
+	const uint8_t* end = buf + buf_size;
+	uint32_t count;
+
+	if (! as_msgpack_array_header(&p, end, &count)) {
+		*size = 0;
+		return AS_MSGPACK_ARRAY_TYPE;
+	}
+	*size = count;
+
+	if (count > capacity) {
+		return AS_MSGPACK_ARRAY_CAPACITY;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (p >= end) {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+
+		uint8_t t = *p++;
+		size_t avail = end - p;
+		uint32_t len;
+
+		if ((t & 0xe0) == 0xa0) {
+			len = t & 0x1f;
+		}
+		else if ((t == 0xc4 || t == 0xd9) && avail >= 1) {
+			len = *p;
+			p += 1;
+		}
+		else if ((t == 0xc5 || t == 0xda) && avail >= 2) {
+			len = cf_swap_from_be16(*(uint16_t*)p);
+			p += 2;
+		}
+		else if ((t == 0xc6 || t == 0xdb) && avail >= 4) {
+			len = cf_swap_from_be32(*(uint32_t*)p);
+			p += 4;
+		}
+		else {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+
+		// The first byte is the particle type.
+		if (len == 0 || (size_t)(end - p) < len) {
+			return AS_MSGPACK_ARRAY_TYPE;
+		}
+		values[i].type = (as_bytes_type)*p;
+		values[i].value = p + 1;
+		values[i].size = len - 1;
+		p += len;
+	}
+	return AS_MSGPACK_ARRAY_OK;
+}
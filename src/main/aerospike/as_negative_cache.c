@@ -0,0 +1,323 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_negative_cache.h>
+#include <aerospike/as_memory.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_NEG_SLOTS 4
+#define AS_NEG_MAX_KICKS 500
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_neg_shard_s {
+	pthread_mutex_t lock;
+	uint32_t* slots[2]; // Zero means empty slot.
+	uint64_t rotate_at;
+	uint64_t version;
+	uint32_t random;
+	uint32_t current;
+} as_neg_shard;
+
+struct as_negative_cache_s {
+	as_neg_shard shards[AS_NEGATIVE_CACHE_SHARDS];
+	uint64_t half_ttl_ms;
+	uint32_t n_buckets;
+	uint32_t fp_mask;
+};
+
+typedef struct as_neg_key_s {
+	as_neg_shard* shard;
+	uint32_t b1;
+	uint32_t b2;
+	uint32_t fp;
+} as_neg_key;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint32_t
+as_neg_alt(as_negative_cache* cache, uint32_t b, uint32_t fp)
+{
+	return (b ^ (fp * 0x5bd1e995)) & (cache->n_buckets - 1);
+}
+
+static void
+as_neg_key_init(as_negative_cache* cache, const char* ns, const uint8_t* digest, as_neg_key* k)
+{
+	// Same digest may exist in multiple namespaces, so mix in the namespace.
+	uint64_t nh = 0xcbf29ce484222325ULL;
+
+	for (const char* p = ns; *p; p++) {
+		nh = (nh ^ (uint8_t)*p) * 0x100000001b3ULL;
+	}
+
+	uint64_t a;
+	uint64_t b;
+	memcpy(&a, digest, sizeof(a));
+	memcpy(&b, digest + 8, sizeof(b));
+	a ^= nh;
+	b ^= nh >> 32;
+
+	k->shard = &cache->shards[a & (AS_NEGATIVE_CACHE_SHARDS - 1)];
+	k->fp = (uint32_t)b & cache->fp_mask;
+
+	if (k->fp == 0) {
+		k->fp = 1;
+	}
+	k->b1 = (uint32_t)(a / AS_NEGATIVE_CACHE_SHARDS) & (cache->n_buckets - 1);
+	k->b2 = as_neg_alt(cache, k->b1, k->fp);
+}
+
+static inline bool
+as_neg_bucket_has(uint32_t* slots, uint32_t b, uint32_t fp)
+{
+	uint32_t* s = slots + b * AS_NEG_SLOTS;
+	return s[0] == fp || s[1] == fp || s[2] == fp || s[3] == fp;
+}
+
+static inline bool
+as_neg_bucket_insert(uint32_t* slots, uint32_t b, uint32_t fp)
+{
+	uint32_t* s = slots + b * AS_NEG_SLOTS;
+
+	for (uint32_t i = 0; i < AS_NEG_SLOTS; i++) {
+		if (s[i] == 0) {
+			s[i] = fp;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline void
+as_neg_bucket_remove(uint32_t* slots, uint32_t b, uint32_t fp)
+{
+	// Remove all copies. Removing a colliding key only causes an extra server read.
+	uint32_t* s = slots + b * AS_NEG_SLOTS;
+
+	for (uint32_t i = 0; i < AS_NEG_SLOTS; i++) {
+		if (s[i] == fp) {
+			s[i] = 0;
+		}
+	}
+}
+
+static inline uint32_t
+as_neg_random(as_neg_shard* shard)
+{
+	uint32_t x = shard->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	shard->random = x;
+	return x;
+}
+
+static void
+as_neg_rotate(as_negative_cache* cache, as_neg_shard* shard)
+{
+	// Must hold shard lock.
+	uint64_t now = cf_getms();
+
+	if (now < shard->rotate_at) {
+		return;
+	}
+
+	size_t size = sizeof(uint32_t) * AS_NEG_SLOTS * cache->n_buckets;
+
+	if (now >= shard->rotate_at + cache->half_ttl_ms) {
+		// Both generations expired.
+		memset(shard->slots[0], 0, size);
+		memset(shard->slots[1], 0, size);
+	}
+	else {
+		shard->current ^= 1;
+		memset(shard->slots[shard->current], 0, size);
+	}
+	shard->rotate_at = now + cache->half_ttl_ms;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_negative_cache*
+as_negative_cache_create(uint32_t capacity, uint32_t ttl_ms, double fpr)
+{
+	as_negative_cache* cache = cf_malloc(sizeof(as_negative_cache));
+	cache->half_ttl_ms = (ttl_ms > 1) ? ttl_ms / 2 : 1;
+
+	// Size buckets for 90% load.
+	uint64_t per_shard = ((uint64_t)capacity + AS_NEGATIVE_CACHE_SHARDS - 1) /
+		AS_NEGATIVE_CACHE_SHARDS;
+	uint64_t min_buckets = (per_shard * 10 / 9 + AS_NEG_SLOTS - 1) / AS_NEG_SLOTS;
+	uint32_t n_buckets = 4;
+
+	while (n_buckets < min_buckets) {
+		n_buckets <<= 1;
+	}
+	cache->n_buckets = n_buckets;
+
+	// A lookup compares up to 2 generations * 2 buckets * 4 slots fingerprints, so each
+	// fingerprint bit halves the false positive rate starting from 16.
+	uint32_t bits = 4;
+
+	while (bits < 32 && 16.0 / (double)(1ULL << bits) > fpr) {
+		bits++;
+	}
+	cache->fp_mask = (bits == 32) ? 0xFFFFFFFF : (uint32_t)((1ULL << bits) - 1);
+
+	size_t size = sizeof(uint32_t) * AS_NEG_SLOTS * n_buckets;
+	uint64_t now = cf_getms();
+
+	for (uint32_t i = 0; i < AS_NEGATIVE_CACHE_SHARDS; i++) {
+		as_neg_shard* shard = &cache->shards[i];
+		pthread_mutex_init(&shard->lock, NULL);
+		shard->slots[0] = cf_calloc(1, size);
+		shard->slots[1] = cf_calloc(1, size);
+		shard->rotate_at = now + cache->half_ttl_ms;
+		shard->version = 0;
+		shard->random = 0x9E3779B9 + i;
+		shard->current = 0;
+	}
+	as_memory_add(AS_MEMORY_CACHE, size * 2 * AS_NEGATIVE_CACHE_SHARDS);
+	return cache;
+}
+
+void
+as_negative_cache_destroy(as_negative_cache* cache)
+{
+	size_t size = sizeof(uint32_t) * AS_NEG_SLOTS * cache->n_buckets;
+
+	for (uint32_t i = 0; i < AS_NEGATIVE_CACHE_SHARDS; i++) {
+		as_neg_shard* shard = &cache->shards[i];
+		cf_free(shard->slots[0]);
+		cf_free(shard->slots[1]);
+		pthread_mutex_destroy(&shard->lock);
+	}
+	as_memory_sub(AS_MEMORY_CACHE, size * 2 * AS_NEGATIVE_CACHE_SHARDS);
+	cf_free(cache);
+}
+
+uint64_t
+as_negative_cache_version(as_negative_cache* cache, const char* ns, const uint8_t* digest)
+{
+	as_neg_key k;
+	as_neg_key_init(cache, ns, digest, &k);
+
+	pthread_mutex_lock(&k.shard->lock);
+	uint64_t version = k.shard->version;
+	pthread_mutex_unlock(&k.shard->lock);
+	return version;
+}
+
+bool
+as_negative_cache_contains(as_negative_cache* cache, const char* ns, const uint8_t* digest)
+{
+	as_neg_key k;
+	as_neg_key_init(cache, ns, digest, &k);
+	as_neg_shard* shard = k.shard;
+
+	pthread_mutex_lock(&shard->lock);
+	as_neg_rotate(cache, shard);
+
+	bool found = false;
+
+	for (uint32_t g = 0; g < 2 && ! found; g++) {
+		found = as_neg_bucket_has(shard->slots[g], k.b1, k.fp) ||
+			as_neg_bucket_has(shard->slots[g], k.b2, k.fp);
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+	return found;
+}
+
+void
+as_negative_cache_add(
+	as_negative_cache* cache, const char* ns, const uint8_t* digest, uint64_t version
+	)
+{
+	as_neg_key k;
+	as_neg_key_init(cache, ns, digest, &k);
+	as_neg_shard* shard = k.shard;
+
+	pthread_mutex_lock(&shard->lock);
+
+	if (shard->version != version) {
+		// A local write to this shard started after the read was sent.
+		pthread_mutex_unlock(&shard->lock);
+		return;
+	}
+
+	as_neg_rotate(cache, shard);
+
+	uint32_t* slots = shard->slots[shard->current];
+
+	// Never store duplicates, because removal must find every copy within two buckets.
+	if (as_neg_bucket_has(slots, k.b1, k.fp) || as_neg_bucket_has(slots, k.b2, k.fp) ||
+		as_neg_bucket_insert(slots, k.b1, k.fp) || as_neg_bucket_insert(slots, k.b2, k.fp)) {
+		pthread_mutex_unlock(&shard->lock);
+		return;
+	}
+
+	// Both buckets are full. Relocate existing fingerprints to their alternate buckets.
+	uint32_t b = (as_neg_random(shard) & 1) ? k.b1 : k.b2;
+	uint32_t fp = k.fp;
+
+	for (uint32_t n = 0; n < AS_NEG_MAX_KICKS; n++) {
+		uint32_t* s = slots + b * AS_NEG_SLOTS + (as_neg_random(shard) & (AS_NEG_SLOTS - 1));
+		uint32_t victim = *s;
+		*s = fp;
+		fp = victim;
+		b = as_neg_alt(cache, b, fp);
+
+		if (as_neg_bucket_has(slots, b, fp) || as_neg_bucket_insert(slots, b, fp)) {
+			break;
+		}
+	}
+	// If the filter is still full, the last victim is forgotten. That only causes an
+	// extra server read for that key.
+	pthread_mutex_unlock(&shard->lock);
+}
+
+void
+as_negative_cache_remove(as_negative_cache* cache, const char* ns, const uint8_t* digest)
+{
+	as_neg_key k;
+	as_neg_key_init(cache, ns, digest, &k);
+	as_neg_shard* shard = k.shard;
+
+	pthread_mutex_lock(&shard->lock);
+	shard->version++;
+
+	for (uint32_t g = 0; g < 2; g++) {
+		as_neg_bucket_remove(shard->slots[g], k.b1, k.fp);
+		as_neg_bucket_remove(shard->slots[g], k.b2, k.fp);
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+}
@@ -23,13 +23,27 @@
 #include <aerospike/as_event_internal.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_memory.h>
+#include <aerospike/as_partition_bitmap.h>
 #include <aerospike/as_peers.h>
+#include <aerospike/as_poll.h>
 #include <aerospike/as_queue.h>
 #include <aerospike/as_shm_cluster.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_tls.h>
 #include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
 
 // Replicas take ~2K per namespace, so this will cover most deployments:
 #define INFO_STACK_BUF_SIZE (16 * 1024)
@@ -52,6 +66,14 @@ as_event_node_balance_connections(as_cluster* cluster, as_node* node);
 
 extern uint32_t as_event_loop_capacity;
 
+/******************************************************************************
+ * Static variables.
+ *****************************************************************************/
+
+static uint32_t as_node_thread_iter = 0;
+static AS_THREAD_LOCAL uint32_t as_node_thread_id = 0;
+static AS_THREAD_LOCAL uint32_t as_node_latency_iter = 0;
+
 /******************************************************************************
  * Functions.
  *****************************************************************************/
@@ -112,6 +134,11 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 	as_node_add_address(node, (struct sockaddr*)&node_info->addr);
 	
 	as_vector_init(&node->aliases, sizeof(as_alias), 2);
+	as_vector_init(&node->partition_bitmaps, sizeof(as_partition_bitmap*), 4);
+	node->tend_buf.data = NULL;
+	node->tend_buf.capacity = 0;
+	node->racks_buf.data = NULL;
+	node->racks_buf.capacity = 0;
 
 	memcpy(&node->info_socket, &node_info->socket, sizeof(as_socket));
 	node->tls_name = node_info->host.tls_name ? cf_strdup(node_info->host.tls_name) : NULL;
@@ -126,6 +153,9 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 	node->friends = 0;
 	node->failures = 0;
 	node->index = 0;
+	node->login_count = 0;
+	node->conn_open_window = 0;
+	node->conn_open_count = 0;
 	node->perform_login = 0;
 	node->active = true;
 	node->partition_changed = true;
@@ -135,8 +165,32 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 	node->sync_conn_pools = cf_malloc(sizeof(as_conn_pool) * cluster->conn_pools_per_node);
 	node->sync_conns_opened = 1;
 	node->sync_conns_closed = 0;
+	node->sync_conns_closed_idle = 0;
+	node->sync_conns_closed_error = 0;
+	node->sync_conns_closed_balance = 0;
+	node->sync_conns_ktls = 0;
 	node->error_count = 0;
+	node->error_rate_exceeded = 0;
+	node->breaker_state = AS_NODE_BREAKER_CLOSED;
+	node->breaker_backoff = 1;
+	node->breaker_remaining = 0;
+	node->breaker_probes = 0;
+	node->conns_published = 0;
+	node->idle_published = 0;
+	node->hedge_count = 0;
+	node->async_bytes = 0;
+	node->latency_us = 0;
+	node->latency_in_flight = 0;
+	node->latency = cluster->latency_stats ?
+		cf_calloc(AS_LATENCY_SHARDS, sizeof(as_latency_shard)) : NULL;
+	node->timeout_hist = (cluster->adaptive_timeout_factor > 0) ?
+		cf_calloc(AS_LATENCY_SHARDS, sizeof(as_timeout_shard)) : NULL;
+	memset(node->timeout_prev, 0, sizeof(node->timeout_prev));
+	node->timeout_p99_us = 0;
+	node->suspect = 0;
+	node->counters = cf_calloc(AS_COMMAND_COUNTER_SHARDS, sizeof(as_command_counter_shard));
 	node->conn_iter = 0;
+	node->conn_limits_gen = as_load_uint32(&cluster->conn_limits_gen);
 
 	uint32_t min = cluster->min_conns_per_node / cluster->conn_pools_per_node;
 	uint32_t rem_min = cluster->min_conns_per_node - (min * cluster->conn_pools_per_node);
@@ -147,7 +201,13 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 		as_conn_pool* pool = &node->sync_conn_pools[i];
 		uint32_t min_size = i < rem_min ? min + 1 : min;
 		uint32_t max_size = i < rem_max ? max + 1 : max;
-		as_conn_pool_init(pool, sizeof(as_socket), min_size, max_size);
+		as_conn_pool_init(pool, sizeof(as_socket), min_size, max_size,
+			cluster->lock_free_conn_pools);
+	}
+
+	if (cluster->bulk_max_conns_per_node > 0) {
+		as_conn_pool_init(&node->bulk_conn_pool, sizeof(as_socket), 0,
+			cluster->bulk_max_conns_per_node, cluster->lock_free_conn_pools);
 	}
 
 	if (as_event_loop_capacity == 0) {
@@ -180,6 +240,10 @@ as_node_destroy(as_node* node)
 	}
 	cf_free(node->sync_conn_pools);
 
+	if (node->cluster->bulk_max_conns_per_node > 0) {
+		as_conn_pool_destroy(&node->bulk_conn_pool);
+	}
+
 	// Drain async connection pools.
 	if (as_event_loop_capacity > 0) {
 		// Close async and pipeline connections.
@@ -189,6 +253,19 @@ as_node_destroy(as_node* node)
 	// Release memory.
 	cf_free(node->addresses);
 	as_vector_destroy(&node->aliases);
+	as_partition_bitmaps_destroy(&node->partition_bitmaps);
+	as_memory_sub(AS_MEMORY_TEND, node->tend_buf.capacity + node->racks_buf.capacity);
+	cf_free(node->tend_buf.data);
+	cf_free(node->racks_buf.data);
+
+	if (node->latency) {
+		cf_free(node->latency);
+	}
+
+	if (node->timeout_hist) {
+		cf_free(node->timeout_hist);
+	}
+	cf_free(node->counters);
 
 	if (node->tls_name) {
 		cf_free(node->tls_name);
@@ -256,10 +333,7 @@ release_node(as_node* node)
 void
 as_node_release_delayed(as_node* node)
 {
-	as_gc_item item;
-	item.data = node;
-	item.release_fn = (as_release_fn)release_node;
-	as_vector_append(node->cluster->gc, &item);
+	as_cluster_add_gc(node->cluster, node, (as_release_fn)release_node);
 }
 
 void
@@ -326,11 +400,57 @@ as_node_add_alias(as_node* node, const char* hostname, uint16_t port)
 	}
 }
 
+static bool
+as_node_start_connect(as_node* node, as_socket* sock, struct sockaddr* addr, uint64_t deadline_ms)
+{
+	if (! node->latency) {
+		return as_socket_start_connect(sock, addr, deadline_ms);
+	}
+
+	// Same as as_socket_start_connect(), but wait for the non-blocking connect to complete,
+	// so connect and TLS handshake times can be measured separately.
+	uint64_t begin = cf_getns();
+
+	if (! as_socket_connect_fd(sock->fd, addr, as_address_size(addr))) {
+		return false;
+	}
+
+	uint32_t timeout = 0;
+
+	if (deadline_ms > 0) {
+		uint64_t now = cf_getms();
+		timeout = (deadline_ms > now)? (uint32_t)(deadline_ms - now) : 1;
+	}
+
+	as_poll poll;
+	as_poll_init(&poll, sock->fd);
+	int rv = as_poll_socket(&poll, sock->fd, timeout, false);
+	as_poll_destroy(&poll);
+
+	if (rv <= 0) {
+		return false;
+	}
+	as_node_record_conn_latency(node, AS_CONN_LATENCY_CONNECT, begin);
+
+	if (sock->ctx) {
+		begin = cf_getns();
+		as_tls_resume_session(sock, addr);
+
+		if (as_tls_connect(sock, deadline_ms)) {
+			return false;
+		}
+		as_node_record_conn_latency(node, AS_CONN_LATENCY_TLS, begin);
+	}
+	return true;
+}
+
 static int
-as_node_try_connections(as_socket* sock, as_address* addresses, int i, int max, uint64_t deadline_ms)
+as_node_try_connections(
+	as_node* node, as_socket* sock, as_address* addresses, int i, int max, uint64_t deadline_ms
+	)
 {
 	while (i < max) {
-		if (as_socket_start_connect(sock, (struct sockaddr*)&addresses[i].addr, deadline_ms)) {
+		if (as_node_start_connect(node, sock, (struct sockaddr*)&addresses[i].addr, deadline_ms)) {
 			return i;
 		}
 		i++;
@@ -354,20 +474,20 @@ as_node_try_family_connections(as_node* node, int family, int begin, int end, in
 	
 	if (index >= 0) {
 		// Try primary address.
-		if (as_socket_start_connect(sock, (struct sockaddr*)&primary->addr, deadline_ms)) {
+		if (as_node_start_connect(node, sock, (struct sockaddr*)&primary->addr, deadline_ms)) {
 			return index;
 		}
 		
 		// Start from current index + 1 to end.
-		rv = as_node_try_connections(sock, addresses, index + 1, end, deadline_ms);
+		rv = as_node_try_connections(node, sock, addresses, index + 1, end, deadline_ms);
 
 		if (rv < 0) {
 			// Start from begin to index.
-			rv = as_node_try_connections(sock, addresses, begin, index, deadline_ms);
+			rv = as_node_try_connections(node, sock, addresses, begin, index, deadline_ms);
 		}
 	}
 	else {
-		rv = as_node_try_connections(sock, addresses, begin, end, deadline_ms);
+		rv = as_node_try_connections(node, sock, addresses, begin, end, deadline_ms);
 	}
 	
 	if (rv < 0) {
@@ -379,9 +499,7 @@ as_node_try_family_connections(as_node* node, int family, int begin, int end, in
 }
 
 static as_status
-as_node_create_socket(
-	as_error* err, as_node* node, as_conn_pool* pool, as_socket* sock, uint64_t deadline_ms
-	)
+as_node_open_socket(as_error* err, as_node* node, as_socket* sock, uint64_t deadline_ms)
 {
 	// Try addresses.
 	uint32_t index = node->address_index;
@@ -408,9 +526,15 @@ as_node_create_socket(
 	}
 	
 	if (rv < 0) {
+		as_node_set_suspect(node);
 		return as_error_update(err, AEROSPIKE_ERR_CONNECTION, "Failed to connect: %s %s", node->name, primary->name);
 	}
-	sock->pool = pool;
+	as_socket_set_read_buffer(sock, node->cluster->socket_read_buffer);
+
+	if (node->cluster->socket_busy_poll > 0 &&
+		! as_socket_set_busy_poll(sock->fd, node->cluster->socket_busy_poll)) {
+		as_log_debug("Failed to set SO_BUSY_POLL on %s", node->name);
+	}
 
 	if (rv != index) {
 		// Replace invalid primary address with valid alias.
@@ -419,24 +543,43 @@ as_node_create_socket(
 		as_store_uint32(&node->address_index, rv);
 		as_log_debug("Change node address %s %s", node->name, as_node_get_address_string(node));
 	}
-	as_incr_uint32(&node->sync_conns_opened);
 	return AEROSPIKE_OK;
 }
 
 static as_status
-as_node_create_connection(
-	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_conn_pool* pool,
-	as_socket* sock
+as_node_create_socket(
+	as_error* err, as_node* node, as_conn_pool* pool, as_socket* sock, uint64_t deadline_ms
 	)
 {
-	as_status status = as_node_create_socket(err, node, pool, sock, deadline_ms);
+	as_status status = as_node_open_socket(err, node, sock, deadline_ms);
 
 	if (status) {
 		return status;
 	}
+	sock->pool = pool;
+	as_incr_uint32(&node->sync_conns_opened);
+
+	as_cluster* cluster = node->cluster;
+	as_socket_profile* profile = (pool == &node->bulk_conn_pool) ?
+		&cluster->bulk_socket_profile : &cluster->point_socket_profile;
+
+	as_socket_set_profile(sock, profile->recv_buffer_size, profile->send_buffer_size,
+		profile->quickack);
+
+	if (sock->ktls) {
+		as_incr_uint32(&node->sync_conns_ktls);
+	}
+	return AEROSPIKE_OK;
+}
 
+static as_status
+as_node_login_socket(
+	as_error* err, as_node* node, as_socket* sock, uint32_t socket_timeout, uint64_t deadline_ms
+	)
+{
 	// Authenticate connection.
 	as_cluster* cluster = node->cluster;
+	as_status status = AEROSPIKE_OK;
 
 	if (cluster->auth_enabled) {
 		// Must reserve session because not called from cluster tend thread.
@@ -444,16 +587,61 @@ as_node_create_connection(
 
 		if (session) {
 			as_incr_uint32(&session->ref_count);
+			uint64_t begin = node->latency ? cf_getns() : 0;
 			status = as_authenticate(cluster, err, sock, node, session, socket_timeout, deadline_ms);
 			as_session_release(session);
 
+			if (begin && status == AEROSPIKE_OK) {
+				as_node_record_conn_latency(node, AS_CONN_LATENCY_LOGIN, begin);
+			}
+
 			if (status) {
 				as_node_signal_login(node);
-				as_node_close_socket(node, sock);
-				return status;
 			}
 		}
 	}
+	return status;
+}
+
+static as_status
+as_node_create_connection(
+	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_conn_pool* pool,
+	as_socket* sock
+	)
+{
+	as_status status = as_node_create_socket(err, node, pool, sock, deadline_ms);
+
+	if (status) {
+		return status;
+	}
+
+	status = as_node_login_socket(err, node, sock, socket_timeout, deadline_ms);
+
+	if (status) {
+		as_node_close_socket(node, sock);
+		return status;
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_node_create_async_socket(as_error* err, as_node* node, uint64_t deadline_ms, as_socket* sock)
+{
+	// Blocking connect, TLS handshake and login on a helper thread. Connection stats are
+	// counted by the event loop that adopts the socket.
+	as_status status = as_node_open_socket(err, node, sock, deadline_ms);
+
+	if (status) {
+		return status;
+	}
+
+	status = as_node_login_socket(err, node, sock, 0, deadline_ms);
+
+	if (status) {
+		as_socket_close(sock);
+		return status;
+	}
+	sock->pool = NULL;
 	return AEROSPIKE_OK;
 }
 
@@ -509,8 +697,148 @@ as_node_authenticate_connection(as_cluster* cluster, uint64_t deadline_ms)
 	return status;
 }
 
-as_status
-as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock)
+static uint32_t
+as_node_affinity_index(as_conn_pool_affinity affinity, uint32_t max)
+{
+#if defined(__linux__)
+	if (affinity == AS_CONN_POOL_AFFINITY_CPU) {
+		int cpu = sched_getcpu();
+
+		if (cpu >= 0) {
+			return (uint32_t)cpu % max;
+		}
+	}
+#endif
+
+	if (as_node_thread_id == 0) {
+		as_node_thread_id = as_faa_uint32(&as_node_thread_iter, 1) + 1;
+	}
+	return (as_node_thread_id - 1) % max;
+}
+
+static bool
+as_node_pop_connection(as_node* node, as_conn_pool* pool, as_socket* sock)
+{
+	as_socket s;
+
+	while (as_conn_pool_pop_head(pool, &s)) {
+		// Found socket. Verify that socket is active.
+		if (! as_socket_current_tran(s.last_used, node->cluster->max_socket_idle_ns_tran)) {
+			as_node_close_connection(node, &s, pool);
+			as_incr_uint32(&node->sync_conns_closed_idle);
+			continue;
+		}
+
+		// Verify that socket receive buffer is empty.
+		int len = as_socket_validate_fd(s.fd);
+
+		if (len != 0) {
+			as_log_debug("Invalid socket %d from pool: %d", s.fd, len);
+			as_node_close_conn_error(node, &s, pool);
+			continue;
+		}
+
+		*sock = s;
+		sock->pool = pool;
+		return true;
+	}
+	return false;
+}
+
+static void
+as_node_wait_login(as_node* node, uint64_t deadline_ms)
+{
+	// A connection was rejected and the tend thread logs in again. Wait for that single login
+	// instead of authenticating with a token that the server is likely to reject.
+	as_cluster* cluster = node->cluster;
+	uint64_t limit = cf_getms() + cluster->login_timeout_ms;
+
+	if (deadline_ms > 0 && deadline_ms < limit) {
+		limit = deadline_ms;
+	}
+
+	pthread_mutex_lock(&cluster->login_lock);
+
+	uint32_t count = node->login_count;
+
+	while (node->login_count == count && as_load_uint8(&node->perform_login)) {
+		uint64_t now = cf_getms();
+
+		if (now >= limit) {
+			break;
+		}
+
+		struct timespec delta;
+		struct timespec abstime;
+		cf_clock_set_timespec_ms(limit - now, &delta);
+		cf_clock_current_add(&delta, &abstime);
+		pthread_cond_timedwait(&cluster->login_cond, &cluster->login_lock, &abstime);
+	}
+	pthread_mutex_unlock(&cluster->login_lock);
+}
+
+static as_status
+as_node_open_pool_connection(
+	as_error* err, as_node* node, as_conn_pool* pool, uint32_t socket_timeout,
+	uint64_t deadline_ms, as_socket* sock
+	)
+{
+	// Pool total was already incremented.  Decrement on failure.
+	as_cluster* cluster = node->cluster;
+
+	if (! as_node_reserve_conn_open(node)) {
+		as_conn_pool_decr(pool);
+		return as_error_update(err, AEROSPIKE_ERR_NO_MORE_CONNECTIONS,
+							   "Max node %s connection open rate would be exceeded: %u",
+							   node->name, cluster->max_conn_open_rate);
+	}
+
+	if (cluster->shm_info && ! as_shm_reserve_connection(cluster, node)) {
+		// Other processes hold the host's connections to this node.
+		as_conn_pool_decr(pool);
+		return as_error_update(err, AEROSPIKE_ERR_NO_MORE_CONNECTIONS,
+							   "Max host node %s connections would be exceeded: %u",
+							   node->name, cluster->shm_info->max_conns_per_node);
+	}
+
+	if (cluster->auth_enabled && as_load_uint8(&node->perform_login)) {
+		as_node_wait_login(node, deadline_ms);
+	}
+
+	as_status status = as_node_create_connection(err, node, socket_timeout, deadline_ms,
+												 pool, sock);
+
+	if (status != AEROSPIKE_OK) {
+		as_conn_pool_decr(pool);
+	}
+	return status;
+}
+
+static as_status
+as_node_acquire_bulk_connection(
+	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock
+	)
+{
+	as_conn_pool* pool = &node->bulk_conn_pool;
+
+	if (as_node_pop_connection(node, pool, sock)) {
+		return AEROSPIKE_OK;
+	}
+
+	if (as_conn_pool_incr(pool)) {
+		return as_node_open_pool_connection(err, node, pool, socket_timeout, deadline_ms, sock);
+	}
+
+	as_conn_pool_decr(pool);
+	return as_error_update(err, AEROSPIKE_ERR_NO_MORE_CONNECTIONS,
+						   "Max node %s scan/query connections would be exceeded: %u",
+						   node->name, node->cluster->bulk_max_conns_per_node);
+}
+
+static as_status
+as_node_acquire_connection(
+	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock
+	)
 {
 	as_conn_pool* pools = node->sync_conn_pools;
 	as_cluster* cluster = node->cluster;
@@ -522,47 +850,41 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 		initial_index = 0;
 		backward = false;
 	}
+	else if (cluster->conn_pool_affinity != AS_CONN_POOL_AFFINITY_NONE) {
+		initial_index = as_node_affinity_index(cluster->conn_pool_affinity, max);
+
+		if (as_node_pop_connection(node, &pools[initial_index], sock)) {
+			return AEROSPIKE_OK;
+		}
+
+		// Preferred pool is empty.  Take an idle connection from another pool before
+		// opening a new connection.
+		for (uint32_t i = 1; i < max; i++) {
+			uint32_t index = (initial_index + i) % max;
+
+			if (as_node_pop_connection(node, &pools[index], sock)) {
+				return AEROSPIKE_OK;
+			}
+		}
+		backward = true;
+	}
 	else {
 		uint32_t iter = node->conn_iter++; // not atomic by design
 		initial_index = iter % max;
 		backward = true;
 	}
 
-	as_socket s;
 	as_conn_pool* pool = &pools[initial_index];
 	uint32_t pool_index = initial_index;
 
 	while (true) {
-		if (as_conn_pool_pop_head(pool, &s)) {
-			// Found socket. Verify that socket is active.
-			if (! as_socket_current_tran(s.last_used, cluster->max_socket_idle_ns_tran)) {
-				as_node_close_connection(node, &s, pool);
-				continue;
-			}
-
-			// Verify that socket receive buffer is empty.
-			int len = as_socket_validate_fd(s.fd);
-
-			if (len != 0) {
-				as_log_debug("Invalid socket %d from pool: %d", s.fd, len);
-				as_node_close_conn_error(node, &s, pool);
-				continue;
-			}
-
-			*sock = s;
-			sock->pool = pool;
+		if (as_node_pop_connection(node, pool, sock)) {
 			return AEROSPIKE_OK;
 		}
 		else if (as_conn_pool_incr(pool)) {
 			// Socket not found and queue has available slot.
-			// Create new connection.
-			as_status status = as_node_create_connection(err, node, socket_timeout, deadline_ms,
-														 pool, sock);
-
-			if (status != AEROSPIKE_OK) {
-				as_conn_pool_decr(pool);
-			}
-			return status;
+			return as_node_open_pool_connection(err, node, pool, socket_timeout, deadline_ms,
+												sock);
 		}
 		else {
 			// Socket not found and queue is full.  Try another queue.
@@ -584,7 +906,7 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 			else if (++pool_index >= max) {
 				break;
 			}
-			pool = &pool[pool_index];
+			pool = &pools[pool_index];
 		}
 	}
 	// All queues full.
@@ -593,25 +915,111 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 						   node->name, cluster->max_conns_per_node);
 }
 
+as_status
+as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock)
+{
+	if (! node->latency) {
+		return as_node_acquire_connection(err, node, socket_timeout, deadline_ms, sock);
+	}
+
+	uint64_t begin = cf_getns();
+	as_status status = as_node_acquire_connection(err, node, socket_timeout, deadline_ms, sock);
+
+	if (status == AEROSPIKE_OK) {
+		as_node_record_conn_latency(node, AS_CONN_LATENCY_ACQUIRE, begin);
+	}
+	return status;
+}
+
+as_status
+as_node_get_bulk_connection(
+	as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock
+	)
+{
+	if (node->cluster->bulk_max_conns_per_node == 0) {
+		return as_node_get_connection(err, node, socket_timeout, deadline_ms, sock);
+	}
+
+	if (! node->latency) {
+		return as_node_acquire_bulk_connection(err, node, socket_timeout, deadline_ms, sock);
+	}
+
+	uint64_t begin = cf_getns();
+	as_status status = as_node_acquire_bulk_connection(err, node, socket_timeout, deadline_ms,
+													   sock);
+
+	if (status == AEROSPIKE_OK) {
+		as_node_record_conn_latency(node, AS_CONN_LATENCY_ACQUIRE, begin);
+	}
+	return status;
+}
+
 static void
 as_node_close_idle_connections(as_node* node, as_conn_pool* pool, int count)
 {
-	uint64_t max_socket_idle_ns = node->cluster->max_socket_idle_ns_trim;
-	as_socket s;
+	// Large excesses are trimmed in increments over several balance passes, so one pass
+	// does not stall on closing thousands of connections.
+	as_socket socks[AS_CONN_TRIM_MAX];
+	uint32_t max = (count < AS_CONN_TRIM_MAX) ? (uint32_t)count : AS_CONN_TRIM_MAX;
+	uint32_t n = as_conn_pool_trim(pool, node->cluster->max_socket_idle_ns_trim, socks, max);
 
-	while (count > 0) {
-		if (! as_conn_pool_pop_tail(pool, &s)) {
-			break;
-		}
+	for (uint32_t i = 0; i < n; i++) {
+		as_node_close_connection(node, &socks[i], pool);
+	}
+	as_add_uint32(&node->sync_conns_closed_balance, n);
+}
 
-		if (as_socket_current_trim(s.last_used, max_socket_idle_ns)) {
-			if (! as_conn_pool_push_tail(pool, &s)) {
-				as_node_close_connection(node, &s, pool);
-			}
-			break;
-		}
-		as_node_close_connection(node, &s, pool);
-		count--;
+static void
+as_node_resize_pool(as_node* node, as_conn_pool* pool, uint32_t min_size, uint32_t max_size)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	as_queue* q = &pool->queue;
+	as_socket sock;
+
+	// Close least recently used idle connections that no longer fit.
+	while (as_queue_size(q) > max_size && as_queue_pop_tail(q, &sock)) {
+		as_node_close_connection(node, &sock, pool);
+	}
+
+	// Move remaining connections to storage of the new capacity. Total is updated outside
+	// the lock, so it is left in place.
+	as_queue tmp;
+	as_queue_init(&tmp, q->item_size, max_size);
+
+	while (as_queue_pop(q, &sock)) {
+		as_queue_push(&tmp, &sock);
+	}
+	as_queue_destroy(q);
+
+	q->data = tmp.data;
+	q->head = tmp.head;
+	q->tail = tmp.tail;
+	q->flags = tmp.flags;
+	as_store_uint32(&q->capacity, tmp.capacity);
+	pool->min_size = min_size;
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void
+as_node_resize_pools(as_node* node, uint32_t min_conns, uint32_t max_conns)
+{
+	// Idle connections above the new limits are closed now. Connections in use above the
+	// new limits are closed when they are returned.
+	as_conn_pool* pools = node->sync_conn_pools;
+	uint32_t n_pools = node->cluster->conn_pools_per_node;
+
+	// Distribute connections over pools the same way as as_node_create().
+	uint32_t min = min_conns / n_pools;
+	uint32_t rem_min = min_conns - (min * n_pools);
+	uint32_t max = max_conns / n_pools;
+	uint32_t rem_max = max_conns - (max * n_pools);
+
+	for (uint32_t i = 0; i < n_pools; i++) {
+		uint32_t min_size = i < rem_min ? min + 1 : min;
+		uint32_t max_size = i < rem_max ? max + 1 : max;
+		as_node_resize_pool(node, &pools[i], min_size, max_size);
 	}
 }
 
@@ -622,6 +1030,15 @@ as_node_balance_connections(as_node* node)
 	as_cluster* cluster = node->cluster;
 	uint32_t max = cluster->conn_pools_per_node;
 	uint32_t timeout_ms = cluster->conn_timeout_ms;
+	uint32_t gen = as_load_uint32(&cluster->conn_limits_gen);
+
+	if (node->conn_limits_gen != gen) {
+		// Limits were changed by as_cluster_set_conns_per_node().
+		as_fence_acquire();
+		node->conn_limits_gen = gen;
+		as_node_resize_pools(node, as_load_uint32(&cluster->min_conns_per_node),
+			as_load_uint32(&cluster->max_conns_per_node));
+	}
 
 	for (uint32_t i = 0; i < max; i++) {
 		as_conn_pool* pool = &pools[i];
@@ -630,10 +1047,64 @@ as_node_balance_connections(as_node* node)
 		if (excess > 0) {
 			as_node_close_idle_connections(node, pool, excess);
 		}
-		else if (excess < 0 && as_node_valid_error_count(node)) {
+		else if (excess < 0 && as_node_valid_error_count(node) &&
+			(! cluster->shm_info || as_shm_reserve_connection(cluster, node))) {
 			as_node_create_connections(node, pool, timeout_ms, -excess);
 		}
 	}
+
+	if (cluster->bulk_max_conns_per_node > 0) {
+		// Scan and query pool has no minimum, so only idle connections are trimmed.
+		int excess = as_conn_pool_excess(&node->bulk_conn_pool);
+
+		if (excess > 0) {
+			as_node_close_idle_connections(node, &node->bulk_conn_pool, excess);
+		}
+	}
+}
+
+void
+as_node_sync_conns(as_node* node, uint32_t* total, uint32_t* idle)
+{
+	as_conn_pool* pools = node->sync_conn_pools;
+	uint32_t max = node->cluster->conn_pools_per_node;
+	uint32_t t = 0;
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < max; i++) {
+		t += as_conn_pool_total(&pools[i]);
+		n += as_conn_pool_size(&pools[i]);
+	}
+
+	if (node->cluster->bulk_max_conns_per_node > 0) {
+		t += as_conn_pool_total(&node->bulk_conn_pool);
+		n += as_conn_pool_size(&node->bulk_conn_pool);
+	}
+	*total = t;
+	*idle = n;
+}
+
+uint32_t
+as_node_release_idle_connections(as_node* node, uint32_t count)
+{
+	as_conn_pool* pools = node->sync_conn_pools;
+	uint32_t max = node->cluster->conn_pools_per_node;
+	uint32_t closed = 0;
+	as_socket s;
+
+	for (uint32_t i = 0; i < max && closed < count; i++) {
+		as_conn_pool* pool = &pools[i];
+
+		while (closed < count && as_conn_pool_excess(pool) > 0) {
+			if (! as_conn_pool_pop_tail(pool, &s)) {
+				break;
+			}
+			as_node_close_connection(node, &s, pool);
+			as_incr_uint32(&node->sync_conns_closed_balance);
+			closed++;
+		}
+	}
+	return closed;
 }
 
 void
@@ -642,12 +1113,40 @@ as_node_signal_login(as_node* node)
 	// Only login when login not already been requested.
 	if (as_cas_uint8(&node->perform_login, 0, 1)) {
 		// Signal tend thread to wake up from sleep, so node tend will occur faster.
-		as_cluster* cluster = node->cluster;
+		as_cluster_wake_tend(node->cluster);
+	}
+}
+
+bool
+as_node_reserve_conn_open(as_node* node)
+{
+	uint32_t max = node->cluster->max_conn_open_rate;
+
+	if (max == 0) {
+		return true;
+	}
+
+	uint32_t window = (uint32_t)(cf_getms() / 1000);
 
-		pthread_mutex_lock(&cluster->tend_lock);
-		pthread_cond_signal(&cluster->tend_cond);
-		pthread_mutex_unlock(&cluster->tend_lock);
+	if (as_load_uint32(&node->conn_open_window) != window) {
+		// First open of a new second resets the count. Racing threads may reset it more
+		// than once, which only admits a few extra connections.
+		as_store_uint32(&node->conn_open_window, window);
+		as_store_uint32(&node->conn_open_count, 0);
 	}
+	return as_faa_uint32(&node->conn_open_count, 1) < max;
+}
+
+static void
+as_node_login_complete(as_node* node)
+{
+	// Wake connections waiting for this login, whether it succeeded or not.
+	as_cluster* cluster = node->cluster;
+
+	pthread_mutex_lock(&cluster->login_lock);
+	node->login_count++;
+	pthread_cond_broadcast(&cluster->login_cond);
+	pthread_mutex_unlock(&cluster->login_lock);
 }
 
 /**
@@ -671,6 +1170,7 @@ as_node_login(as_error* err, as_node* node, as_socket* sock)
 	if (status) {
 		as_fence_store();
 		as_store_uint8(&node->perform_login, 1);
+		as_node_login_complete(node);
 		as_error_append(err, as_node_get_address_string(node));
 		return status;
 	}
@@ -680,22 +1180,29 @@ as_node_login(as_error* err, as_node* node, as_socket* sock)
 	as_fence_store();
 	as_store_ptr(&node->session, node_info.session);
 	as_store_uint8(&node->perform_login, 0);
+	as_node_login_complete(node);
 
 	if (old) {
 		// Put old session on garbage collector stack.
-		as_gc_item item;
-		item.data = old;
-		item.release_fn = (as_release_fn)release_session;
-		as_vector_append(cluster->gc, &item);
+		as_cluster_add_gc(cluster, old, (as_release_fn)release_session);
 	}
 	return AEROSPIKE_OK;
 }
 
+static bool
+as_node_should_login(as_node* node)
+{
+	// Return true if previous user authentication failed or session token is due for refresh.
+	// The refresh time precedes expiration, so commands keep a valid token while the tend
+	// thread logs in.
+	return as_load_uint8(&node->perform_login) ||
+		(node->session && node->session->refresh > 0 && cf_getns() >= node->session->refresh);
+}
+
 as_status
 as_node_ensure_login_shm(as_error* err, as_node* node)
 {
-	if (as_load_uint8(&node->perform_login) ||
-		(node->session && node->session->expiration > 0 && cf_getns() >= node->session->expiration)) {
+	if (as_node_should_login(node)) {
 		as_socket sock;
 		uint64_t deadline_ms = as_socket_deadline(node->cluster->conn_timeout_ms);
 		as_status status = as_node_create_socket(err, node, NULL, &sock, deadline_ms);
@@ -718,12 +1225,143 @@ as_node_ensure_login_shm(as_error* err, as_node* node)
 	return AEROSPIKE_OK;
 }
 
-static bool
-as_node_should_login(as_node* node)
+
+void
+as_node_record_latency(as_node* node, as_latency_type type, uint64_t begin_ns)
 {
-	// Return true if previous user authentication failed or session token expired.
-	return as_load_uint8(&node->perform_login) ||
-		(node->session && node->session->expiration > 0 && cf_getns() >= node->session->expiration);
+	if (as_node_thread_id == 0) {
+		as_node_thread_id = as_faa_uint32(&as_node_thread_iter, 1) + 1;
+	}
+
+	as_latency_shard* shard = &node->latency[(as_node_thread_id - 1) % AS_LATENCY_SHARDS];
+	uint32_t bucket = as_latency_bucket((cf_getns() - begin_ns) / 1000);
+	as_incr_uint64(&shard->buckets[type][bucket]);
+}
+
+void
+as_node_record_conn_latency(as_node* node, as_conn_latency_type type, uint64_t begin_ns)
+{
+	if (as_node_thread_id == 0) {
+		as_node_thread_id = as_faa_uint32(&as_node_thread_iter, 1) + 1;
+	}
+
+	as_latency_shard* shard = &node->latency[(as_node_thread_id - 1) % AS_LATENCY_SHARDS];
+	uint32_t bucket = as_latency_bucket((cf_getns() - begin_ns) / 1000);
+	as_incr_uint64(&shard->conn[type][bucket]);
+}
+
+void
+as_node_set_suspect(as_node* node)
+{
+	if (! as_load_uint8(&node->suspect)) {
+		as_store_uint8(&node->suspect, 1);
+		as_log_debug("Node %s connect failed. Route to other replicas until next tend",
+			node->name);
+	}
+}
+
+void
+as_node_record_timeout_latency(as_node* node, uint64_t begin_ns)
+{
+	if (as_node_thread_id == 0) {
+		as_node_thread_id = as_faa_uint32(&as_node_thread_iter, 1) + 1;
+	}
+
+	as_timeout_shard* shard = &node->timeout_hist[(as_node_thread_id - 1) % AS_LATENCY_SHARDS];
+	uint32_t bucket = as_latency_bucket((cf_getns() - begin_ns) / 1000);
+	as_incr_uint64(&shard->buckets[bucket]);
+}
+
+void
+as_node_update_timeout(as_node* node)
+{
+	uint64_t delta[AS_LATENCY_BUCKETS];
+	uint64_t total[AS_LATENCY_BUCKETS];
+	uint64_t count = 0;
+
+	for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+		total[b] = 0;
+
+		for (uint32_t s = 0; s < AS_LATENCY_SHARDS; s++) {
+			total[b] += as_load_uint64(&node->timeout_hist[s].buckets[b]);
+		}
+		delta[b] = total[b] - node->timeout_prev[b];
+		count += delta[b];
+	}
+
+	// Keep accumulating until there are enough samples for a meaningful 99th percentile.
+	if (count < AS_NODE_TIMEOUT_MIN_SAMPLES) {
+		return;
+	}
+	memcpy(node->timeout_prev, total, sizeof(total));
+
+	uint64_t target = count - count / 100;
+	uint64_t sum = 0;
+	uint64_t p99 = 0;
+
+	for (uint32_t b = 0; b < AS_LATENCY_BUCKETS; b++) {
+		if (sum + delta[b] >= target) {
+			// Interpolate within bucket [2^(b-1), 2^b).
+			uint64_t low = b ? (1ULL << (b - 1)) : 0;
+			uint64_t high = 1ULL << b;
+			p99 = low + (high - low) * (target - sum) / delta[b];
+			break;
+		}
+		sum += delta[b];
+	}
+
+	if (p99 == 0) {
+		p99 = 1;
+	}
+	else if (p99 > UINT32_MAX) {
+		p99 = UINT32_MAX;
+	}
+
+	// Follow latency increases immediately, but decay slowly so one quiet window does not
+	// cause spurious timeouts.
+	uint32_t prev = node->timeout_p99_us;
+
+	if (prev > p99) {
+		p99 = prev - (prev - p99) / 4;
+	}
+	as_store_uint32(&node->timeout_p99_us, (uint32_t)p99);
+}
+
+as_command_counters*
+as_node_get_counters(as_node* node)
+{
+	if (as_node_thread_id == 0) {
+		as_node_thread_id = as_faa_uint32(&as_node_thread_iter, 1) + 1;
+	}
+	return &node->counters[(as_node_thread_id - 1) % AS_COMMAND_COUNTER_SHARDS].counters;
+}
+
+as_node*
+as_node_lowest_latency(as_node* n1, as_node* n2)
+{
+	uint32_t lat1 = as_load_uint32(&n1->latency_us);
+	uint32_t lat2 = as_load_uint32(&n2->latency_us);
+
+	// Measure nodes without samples first.
+	if (lat1 == 0) {
+		return n1;
+	}
+
+	if (lat2 == 0) {
+		return n2;
+	}
+
+	// Expected latency grows with the commands already queued on the node.
+	uint64_t cost1 = (uint64_t)lat1 * (as_load_uint32(&n1->latency_in_flight) + 1);
+	uint64_t cost2 = (uint64_t)lat2 * (as_load_uint32(&n2->latency_in_flight) + 1);
+	as_node* best = (cost1 <= cost2)? n1 : n2;
+
+	// Explore the other node once every 32 commands per thread. A thread local counter
+	// avoids contention on a shared cache line.
+	if ((++as_node_latency_iter & 31) == 0) {
+		return (best == n1)? n2 : n1;
+	}
+	return best;
 }
 
 bool
@@ -815,8 +1453,37 @@ as_node_get_tend_connection(as_error* err, as_node* node)
 	return status;
 }
 
+as_status
+as_node_create_tend_connection(as_error* err, as_node* node)
+{
+	return as_node_get_tend_connection(err, node);
+}
+
+static uint8_t*
+as_tend_buffer_reserve(as_tend_buffer* tb, size_t size)
+{
+	if (tb->capacity < size) {
+		// Leave room for growth, so a slowly growing response does not reallocate every tend.
+		size_t capacity = (size + (size >> 2) + 4095) & ~(size_t)4095;
+
+		as_memory_sub(AS_MEMORY_TEND, tb->capacity);
+		cf_free(tb->data);
+		tb->data = cf_malloc(capacity);
+		tb->capacity = (uint32_t)capacity;
+		as_memory_add(AS_MEMORY_TEND, capacity);
+	}
+	return tb->data;
+}
+
+/**
+ * Send info request on the node's tend connection and read the null terminated response into
+ * the reusable tend buffer. The response is valid until the next request that uses the buffer.
+ */
 static uint8_t*
-as_node_get_info(as_error* err, as_node* node, const char* names, size_t names_len, uint64_t deadline_ms, uint8_t* stack_buf)
+as_node_get_info(
+	as_error* err, as_node* node, const char* names, size_t names_len, uint64_t deadline_ms,
+	uint8_t* stack_buf, as_tend_buffer* tb
+	)
 {
 	as_socket* sock = &node->info_socket;
 	
@@ -855,22 +1522,11 @@ as_node_get_info(as_error* err, as_node* node, const char* names, size_t names_l
 		return 0;
 	}
 	
-	// Allocate a buffer if the response is bigger than the stack buffer -
-	// caller must free it if this call succeeds. Note that proto is overwritten
-	// if stack_buf is used, so we save the sz field here.
 	size_t proto_sz = proto->sz;
-	uint8_t* rbuf = proto_sz >= INFO_STACK_BUF_SIZE ? (uint8_t*)cf_malloc(proto_sz + 1) : stack_buf;
-	
-	if (! rbuf) {
-		as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Allocation failed for info response");
-		return 0;
-	}
-	
+	uint8_t* rbuf = as_tend_buffer_reserve(tb, proto_sz + 1);
+
 	// Read the response body.
 	if (as_socket_read_deadline(err, sock, node, rbuf, proto_sz, 0, deadline_ms) != AEROSPIKE_OK) {
-		if (rbuf != stack_buf) {
-			cf_free(rbuf);
-		}
 		return 0;
 	}
 	
@@ -879,27 +1535,118 @@ as_node_get_info(as_error* err, as_node* node, const char* names, size_t names_l
 	return rbuf;
 }
 
+/**
+ * Request info from the node's tend connection. The response is in the node's tend buffer,
+ * so it can be processed after this call returns. The caller does not free it.
+ */
+static uint8_t*
+as_node_fetch_info(
+	as_cluster* cluster, as_error* err, as_node* node, const char* command, size_t command_len,
+	as_tend_buffer* tb
+	)
+{
+	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
+
+	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
+	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf, tb);
+
+	if (! buf) {
+		as_node_close_socket(node, &node->info_socket);
+		return NULL;
+	}
+	return buf;
+}
+
 static as_status
-as_node_verify_name(as_error* err, as_node* node, const char* name)
+as_node_verify_name(as_error* err, as_node* node, const as_info_slice* name)
 {
-	if (name == 0 || *name == 0) {
+	if (name->len == 0) {
 		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Node name not returned from info request.");
 	}
 	
-	if (strcmp(node->name, name) != 0) {
+	if (! as_info_slice_eq(name, node->name)) {
 		// Set node to inactive immediately.
 		// Make volatile write so changes are reflected in other threads.
 		as_store_uint8(&node->active, false);
-		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Node name has changed. Old=%s New=%s", node->name, name);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Node name has changed. Old=%s New=%.*s",
+			node->name, (int)name->len, name->ptr);
 	}
 	return AEROSPIKE_OK;
 }
 
+static void
+as_node_breaker_open(as_node* node)
+{
+	as_cluster* cluster = node->cluster;
+
+	node->breaker_remaining = node->breaker_backoff;
+	as_log_warn("Node %s error rate exceeded. Reject commands for %u error windows",
+				node->name, node->breaker_remaining);
+
+	// Exponential backoff while probes keep failing.
+	uint32_t backoff = node->breaker_backoff * 2;
+	node->breaker_backoff = (backoff < cluster->error_rate_backoff_max) ?
+		backoff : cluster->error_rate_backoff_max;
+	as_store_uint8(&node->breaker_state, AS_NODE_BREAKER_OPEN);
+}
+
+void
+as_node_error_window_end(as_node* node)
+{
+	as_cluster* cluster = node->cluster;
+
+	if (cluster->error_rate_backoff_max == 0) {
+		// Breaker disabled. Node is fully available again in the next window.
+		as_node_reset_error_count(node);
+		return;
+	}
+
+	bool exceeded = as_load_uint32(&node->error_count) > cluster->max_error_rate ||
+		as_load_uint8(&node->error_rate_exceeded);
+
+	switch (as_load_uint8(&node->breaker_state)) {
+		case AS_NODE_BREAKER_CLOSED:
+			if (exceeded) {
+				as_node_breaker_open(node);
+			}
+			break;
+
+		case AS_NODE_BREAKER_OPEN:
+			if (node->breaker_remaining > 0) {
+				node->breaker_remaining--;
+			}
+
+			if (node->breaker_remaining == 0) {
+				as_store_uint32(&node->breaker_probes, 0);
+				as_store_uint8(&node->breaker_state, AS_NODE_BREAKER_HALF_OPEN);
+			}
+			break;
+
+		case AS_NODE_BREAKER_HALF_OPEN:
+			// Probes are a fraction of normal traffic, so scale the error limit.
+			if (exceeded ||
+				as_load_uint32(&node->error_count) > as_cluster_probe_max_errors(cluster)) {
+				as_node_breaker_open(node);
+			}
+			else {
+				as_log_info("Node %s error rate recovered", node->name);
+				node->breaker_backoff = 1;
+				as_store_uint8(&node->breaker_state, AS_NODE_BREAKER_CLOSED);
+			}
+			break;
+	}
+	as_node_reset_error_count(node);
+}
+
 static void
 as_node_restart(as_cluster* cluster, as_node* node)
 {
 	if (cluster->max_error_rate > 0) {
+		// Restarted node starts with a closed breaker.
 		as_node_reset_error_count(node);
+		node->breaker_backoff = 1;
+		node->breaker_remaining = 0;
+		as_store_uint8(&node->breaker_state, AS_NODE_BREAKER_CLOSED);
 	}
 
 	// Balance sync connections.
@@ -913,22 +1660,35 @@ as_node_restart(as_cluster* cluster, as_node* node)
 static const char INFO_STR_CHECK_RACK[] = "node\npeers-generation\npartition-generation\nrebalance-generation\n";
 static const char INFO_STR_CHECK_PEERS[] = "node\npeers-generation\npartition-generation\n";
 
+static inline uint32_t
+as_node_slice_to_gen(const as_info_slice* slice)
+{
+	uint64_t gen = 0;
+	as_info_slice_to_uint64(slice, &gen);
+	return (uint32_t)gen;
+}
+
 static as_status
-as_node_process_response(as_cluster* cluster, as_error* err, as_node* node, as_vector* values,
+as_node_process_response(as_cluster* cluster, as_error* err, as_node* node, const char* buf,
 						 as_peers* peers)
 {
-	for (uint32_t i = 0; i < values->size; i++) {
-		as_name_value* nv = as_vector_get(values, i);
-		
-		if (strcmp(nv->name, "node") == 0) {
-			as_status status = as_node_verify_name(err, node, nv->value);
+	// Read response in place. This runs for every node on every tend.
+	as_info_reader reader;
+	as_info_reader_init(&reader, buf, strlen(buf));
+
+	as_info_slice name;
+	as_info_slice value;
+
+	while (as_info_reader_next(&reader, &name, &value)) {
+		if (as_info_slice_eq(&name, "node")) {
+			as_status status = as_node_verify_name(err, node, &value);
 			
 			if (status != AEROSPIKE_OK) {
 				return status;
 			}
 		}
-		else if (strcmp(nv->name, "peers-generation") == 0) {
-			uint32_t gen = (uint32_t)strtoul(nv->value, NULL, 10);
+		else if (as_info_slice_eq(&name, "peers-generation")) {
+			uint32_t gen = as_node_slice_to_gen(&value);
 			if (node->peers_generation != gen) {
 				peers->gen_changed = true;
 
@@ -940,20 +1700,21 @@ as_node_process_response(as_cluster* cluster, as_error* err, as_node* node, as_v
 				}
 			}
 		}
-		else if (strcmp(nv->name, "partition-generation") == 0) {
-			uint32_t gen = (uint32_t)strtoul(nv->value, NULL, 10);
+		else if (as_info_slice_eq(&name, "partition-generation")) {
+			uint32_t gen = as_node_slice_to_gen(&value);
 			if (node->partition_generation != gen) {
 				node->partition_changed = true;
 			}
 		}
-		else if (strcmp(nv->name, "rebalance-generation") == 0) {
-			uint32_t gen = (uint32_t)strtoul(nv->value, NULL, 10);
+		else if (as_info_slice_eq(&name, "rebalance-generation")) {
+			uint32_t gen = as_node_slice_to_gen(&value);
 			if (node->rebalance_generation != gen) {
 				node->rebalance_changed = true;
 			}
 		}
 		else {
-			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Node %s did not request info '%s'", node->name, nv->name);
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Node %s did not request info '%.*s'",
+				node->name, (int)name.len, name.ptr);
 		}
 	}
 	return AEROSPIKE_OK;
@@ -987,29 +1748,19 @@ as_node_refresh(as_cluster* cluster, as_error* err, as_node* node, as_peers* pee
 	}
 
 	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
+	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf,
+		&node->tend_buf);
 	
 	if (! buf) {
 		as_node_close_socket(node, &node->info_socket);
 		return err->code;
 	}
 	
-	as_vector values;
-	as_vector_inita(&values, sizeof(as_name_value), 4);
-	
-	as_info_parse_multi_response((char*)buf, &values);
-
-	status = as_node_process_response(cluster, err, node, &values, peers);
+	status = as_node_process_response(cluster, err, node, (const char*)buf, peers);
 
 	if (status == AEROSPIKE_ERR_CLIENT) {
 		as_node_close_socket(node, &node->info_socket);
 	}
-		
-	if (buf != stack_buf) {
-		cf_free(buf);
-	}
-
-	as_vector_destroy(&values);
 
 	if (status == AEROSPIKE_OK) {
 		peers->refresh_count++;
@@ -1021,6 +1772,11 @@ as_node_refresh(as_cluster* cluster, as_error* err, as_node* node, as_peers* pee
 			node->rebalance_changed = cluster->rack_aware;
 		}
 		node->failures = 0;
+
+		if (as_load_uint8(&node->suspect)) {
+			// Tend reached the node, so let commands route to it again.
+			as_store_uint8(&node->suspect, 0);
+		}
 	}
 	return status;
 }
@@ -1054,12 +1810,11 @@ as_node_process_peers(as_cluster* cluster, as_error* err, as_node* node, as_vect
 	return AEROSPIKE_OK;
 }
 
-as_status
-as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+uint8_t*
+as_node_fetch_peers(as_cluster* cluster, as_error* err, as_node* node)
 {
 	as_log_debug("Update peers for node %s", as_node_get_address_string(node));
 
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
 	const char* command;
 	size_t command_len;
 
@@ -1083,25 +1838,18 @@ as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peer
 			command_len = sizeof(INFO_STR_PEERS_CLEAR_STD) - 1;
 		}
 	}
-	
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
-	
-	if (! buf) {
-		as_node_close_socket(node, &node->info_socket);
-		return err->code;
-	}
-	
+	return as_node_fetch_info(cluster, err, node, command, command_len, &node->tend_buf);
+}
+
+as_status
+as_node_apply_peers(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf, as_peers* peers)
+{
 	as_vector values;
 	as_vector_inita(&values, sizeof(as_name_value), 4);
 	
 	as_info_parse_multi_response((char*)buf, &values);
 	as_status status = as_node_process_peers(cluster, err, node, &values, peers);
 	
-	if (buf != stack_buf) {
-		cf_free(buf);
-	}
-	
 	as_vector_destroy(&values);
 
 	if (status == AEROSPIKE_OK) {
@@ -1110,6 +1858,17 @@ as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peer
 	return status;
 }
 
+as_status
+as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+{
+	uint8_t* buf = as_node_fetch_peers(cluster, err, node);
+
+	if (! buf) {
+		return err->code;
+	}
+	return as_node_apply_peers(cluster, err, node, buf, peers);
+}
+
 static const char INFO_STR_GET_REPLICAS_REGIME[] = "partition-generation\nreplicas\n";
 
 static as_status
@@ -1134,37 +1893,39 @@ as_node_process_partitions(as_cluster* cluster, as_error* err, as_node* node, as
 	return AEROSPIKE_OK;
 }
 
-as_status
-as_node_refresh_partitions(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+uint8_t*
+as_node_fetch_partitions(as_cluster* cluster, as_error* err, as_node* node)
 {
 	as_log_debug("Update partition map for node %s", as_node_get_address_string(node));
 
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
-	const char* command = INFO_STR_GET_REPLICAS_REGIME;
-	size_t command_len = sizeof(INFO_STR_GET_REPLICAS_REGIME) - 1;
-
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
-
-	if (! buf) {
-		as_node_close_socket(node, &node->info_socket);
-		return err->code;
-	}
+	return as_node_fetch_info(cluster, err, node, INFO_STR_GET_REPLICAS_REGIME,
+		sizeof(INFO_STR_GET_REPLICAS_REGIME) - 1, &node->tend_buf);
+}
 
+as_status
+as_node_apply_partitions(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf)
+{
 	as_vector values;
 	as_vector_inita(&values, sizeof(as_name_value), 4);
 
 	as_info_parse_multi_response((char*)buf, &values);
 	as_status status = as_node_process_partitions(cluster, err, node, &values);
 
-	if (buf != stack_buf) {
-		cf_free(buf);
-	}
-
 	as_vector_destroy(&values);
 	return status;
 }
 
+as_status
+as_node_refresh_partitions(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+{
+	uint8_t* buf = as_node_fetch_partitions(cluster, err, node);
+
+	if (! buf) {
+		return err->code;
+	}
+	return as_node_apply_partitions(cluster, err, node, buf);
+}
+
 /**
  * Use non-inline function for garbarge collector function pointer reference.
  * Forward to inlined release.
@@ -1192,10 +1953,7 @@ as_node_replace_racks(as_cluster* cluster, as_node* node, as_racks* racks)
 
 	if (old) {
 		// Put old racks on garbage collector stack.
-		as_gc_item item;
-		item.data = old;
-		item.release_fn = (as_release_fn)release_racks;
-		as_vector_append(cluster->gc, &item);
+		as_cluster_add_gc(cluster, old, (as_release_fn)release_racks);
 	}
 }
 
@@ -1312,31 +2070,35 @@ as_node_process_racks(as_cluster* cluster, as_error* err, as_node* node, as_vect
 
 static const char INFO_STR_GET_RACKS[] = "rebalance-generation\nrack-ids\n";
 
-as_status
-as_node_refresh_racks(as_cluster* cluster, as_error* err, as_node* node)
+uint8_t*
+as_node_fetch_racks(as_cluster* cluster, as_error* err, as_node* node)
 {
 	as_log_debug("Update racks for node %s", as_node_get_address_string(node));
 
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
-
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, INFO_STR_GET_RACKS, sizeof(INFO_STR_GET_RACKS) - 1, deadline_ms, stack_buf);
-
-	if (! buf) {
-		as_node_close_socket(node, &node->info_socket);
-		return err->code;
-	}
+	return as_node_fetch_info(cluster, err, node, INFO_STR_GET_RACKS,
+		sizeof(INFO_STR_GET_RACKS) - 1, &node->racks_buf);
+}
 
+as_status
+as_node_apply_racks(as_cluster* cluster, as_error* err, as_node* node, uint8_t* buf)
+{
 	as_vector values;
 	as_vector_inita(&values, sizeof(as_name_value), 4);
 
 	as_info_parse_multi_response((char*)buf, &values);
 	as_status status = as_node_process_racks(cluster, err, node, &values);
 
-	if (buf != stack_buf) {
-		cf_free(buf);
-	}
-
 	as_vector_destroy(&values);
 	return status;
 }
+
+as_status
+as_node_refresh_racks(as_cluster* cluster, as_error* err, as_node* node)
+{
+	uint8_t* buf = as_node_fetch_racks(cluster, err, node);
+
+	if (! buf) {
+		return err->code;
+	}
+	return as_node_apply_racks(cluster, err, node, buf);
+}
@@ -15,7 +15,9 @@
  * the License.
  */
 #include <aerospike/as_operations.h>
+#include <aerospike/as_arena.h>
 #include <aerospike/as_bin.h>
+#include <aerospike/as_nil.h>
 #include <citrusleaf/alloc.h>
 
 #include "_bin.h"
@@ -32,6 +34,7 @@ as_operations_default(as_operations* ops, bool free, uint16_t nops)
 	ops->_free = free;
 	ops->gen = 0;
 	ops->ttl = 0;
+	ops->_arena = NULL;
 
 	as_binop * entries = NULL;
 	if ( nops > 0 ) {
@@ -114,6 +117,10 @@ as_operations_destroy(as_operations* ops)
 	ops->binops.size = 0;
 	ops->binops.entries = NULL;
 
+	// free packed operation arguments
+	as_arena_destroy(ops->_arena);
+	ops->_arena = NULL;
+
 	if ( ops->_free ) {
 		cf_free(ops);
 	}
@@ -182,6 +189,20 @@ as_operations_add_write_rawp(as_operations* ops, const as_bin_name name, const u
 	return true;
 }
 
+bool
+as_operations_add_packed(
+	as_operations* ops, const as_bin_name name, as_operator op_type, const uint8_t* packed,
+	uint32_t size
+	)
+{
+	as_binop* binop = as_binop_forappend(ops, op_type, name);
+	if (! binop) {
+		return false;
+	}
+	as_bin_init_raw(&binop->bin, name, packed, size, false);
+	return true;
+}
+
 bool
 as_operations_add_read(as_operations* ops, const as_bin_name name)
 {
@@ -191,6 +212,39 @@ as_operations_add_read(as_operations* ops, const as_bin_name name)
 	return true;
 }
 
+bool
+as_operations_add_write_handle(
+	as_operations* ops, const as_bin_handle* handle, as_bin_value* value
+	)
+{
+	if ( ! (ops && handle && ops->binops.size < ops->binops.capacity) ) {
+		return false;
+	}
+
+	as_binop * binop = &ops->binops.entries[ops->binops.size++];
+	binop->op = AS_OPERATOR_WRITE;
+	as_bin_init_handle(&binop->bin, handle, value);
+	return true;
+}
+
+bool
+as_operations_add_read_handle(as_operations* ops, const as_bin_handle* handle)
+{
+	if ( ! (ops && handle && ops->binops.size < ops->binops.capacity) ) {
+		return false;
+	}
+
+	as_binop * binop = &ops->binops.entries[ops->binops.size++];
+	binop->op = AS_OPERATOR_READ;
+	as_bin_init_handle(&binop->bin, handle, &binop->bin.value);
+
+	as_val * nil = (as_val *) &binop->bin.value;
+	nil->type = as_nil.type;
+	nil->free = as_nil.free;
+	nil->count = as_nil.count;
+	return true;
+}
+
 bool
 as_operations_add_incr(as_operations* ops, const as_bin_name name, int64_t value)
 {
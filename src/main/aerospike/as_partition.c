@@ -19,7 +19,9 @@
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_memory.h>
 #include <aerospike/as_node.h>
+#include <aerospike/as_partition_bitmap.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_shm_cluster.h>
 #include <aerospike/as_string.h>
@@ -120,6 +122,7 @@ as_partition_table_create(const char* ns, uint32_t capacity, bool sc_mode)
 	size_t len = sizeof(as_partition_table) + (sizeof(as_partition) * capacity);
 	as_partition_table* table = cf_malloc(len);
 	memset(table, 0, len);
+	as_memory_add(AS_MEMORY_TEND, len);
 	as_strncpy(table->ns, ns, AS_MAX_NAMESPACE_SIZE);
 	table->size = capacity;
 	table->sc_mode = sc_mode;
@@ -140,6 +143,7 @@ as_partition_table_destroy(as_partition_table* table)
 			as_partition_release_node_now(p->prole);
 		}
 	}
+	as_memory_sub(AS_MEMORY_TEND, sizeof(as_partition_table) + sizeof(as_partition) * table->size);
 	cf_free(table);
 }
 
@@ -178,6 +182,15 @@ static as_node*
 try_node_alternate(as_cluster* cluster, as_node* chosen, as_node* alternate)
 {
 	// Make volatile reference so changes to tend thread will be reflected in this thread.
+	if (! as_node_avoid(chosen)) {
+		return chosen;
+	}
+
+	// Chosen node is inactive or suspect. Fall back to it only if alternate is not usable.
+	if (! as_node_avoid(alternate)) {
+		return alternate;
+	}
+
 	if (as_load_uint8(&chosen->active)) {
 		return chosen;
 	}
@@ -235,7 +248,8 @@ prefer_rack_node(
 				// only one on the same rack. The contents of prev_node may have
 				// already been destroyed, so just use pointer comparison and never
 				// examine the contents of prev_node!
-				if (node != prev_node) {
+				// Suspect nodes are treated like the previous node.
+				if (node != prev_node && ! as_load_uint8(&node->suspect)) {
 					if (as_node_has_rack(node, ns, rack_id)) {
 						if (as_load_uint8(&node->active)) {
 							return node;
@@ -266,6 +280,41 @@ prefer_rack_node(
 	return NULL;
 }
 
+static as_node*
+lowest_latency_node(as_cluster* cluster, as_partition* p, as_node* prev_node, bool use_master)
+{
+	as_node* master = (as_node*)as_load_ptr(&p->master);
+	as_node* prole = (as_node*)as_load_ptr(&p->prole);
+
+	if (! prole || ! master) {
+		return get_sequence_node(cluster, p, use_master);
+	}
+
+	if (! as_load_uint8(&master->active)) {
+		return try_node(cluster, prole);
+	}
+
+	if (! as_load_uint8(&prole->active)) {
+		return master;
+	}
+
+	// Avoid a suspect replica when the other one is not suspect.
+	if (as_load_uint8(&master->suspect) != as_load_uint8(&prole->suspect)) {
+		return as_load_uint8(&master->suspect) ? prole : master;
+	}
+
+	// On retry, use the other node. Only compare prev_node pointer because its contents
+	// may have already been destroyed.
+	if (prev_node == master) {
+		return prole;
+	}
+
+	if (prev_node == prole) {
+		return master;
+	}
+	return as_node_lowest_latency(master, prole);
+}
+
 static uint32_t g_randomizer = 0;
 
 as_node*
@@ -296,6 +345,10 @@ as_partition_reg_get_node(
 		case AS_POLICY_REPLICA_PREFER_RACK: {
 			return prefer_rack_node(cluster, ns, p, prev_node, use_master);
 		}
+
+		case AS_POLICY_REPLICA_LOWEST_LATENCY: {
+			return lowest_latency_node(cluster, p, prev_node, use_master);
+		}
 	}
 }
 
@@ -304,7 +357,8 @@ as_partition_info_init(as_partition_info* pi, as_cluster* cluster, as_error* err
 {
 	if (cluster->shm_info) {
 		as_cluster_shm* cluster_shm = cluster->shm_info->cluster_shm;
-		as_partition_table_shm* table = as_shm_find_partition_table(cluster_shm, key->ns);
+		as_partition_table_shm* table = as_shm_find_partition_table_id(cluster_shm, key->ns_id,
+			key->ns);
 
 		if (! table) {
 			as_nodes* nodes = as_nodes_reserve(cluster);
@@ -322,7 +376,14 @@ as_partition_info_init(as_partition_info* pi, as_cluster* cluster, as_error* err
 		pi->sc_mode = table->sc_mode;
 	}
 	else {
-		as_partition_table* table = as_partition_tables_get(&cluster->partition_tables, key->ns);
+		as_partition_table* table = as_partition_tables_get_id(&cluster->partition_tables,
+			key->ns_id, key->ns);
+
+		if (! table && as_load_uint8(&cluster->connecting)) {
+			// Partition maps of an asynchronously connected cluster have not arrived yet.
+			as_cluster_wait_connected(cluster);
+			table = as_partition_tables_get_id(&cluster->partition_tables, key->ns_id, key->ns);
+		}
 
 		if (! table) {
 			as_nodes* nodes = as_nodes_reserve(cluster);
@@ -357,74 +418,143 @@ as_partition_tables_get(as_partition_tables* tables, const char* ns)
 	return NULL;
 }
 
+as_status
+as_partition_namespace_id(as_cluster* cluster, as_error* err, const char* ns, uint32_t* ns_id)
+{
+	if (cluster->shm_info) {
+		as_cluster_shm* cluster_shm = cluster->shm_info->cluster_shm;
+		as_partition_table_shm* table = as_shm_get_partition_tables(cluster_shm);
+		uint32_t max = cluster_shm->partition_tables_size;
+
+		for (uint32_t i = 0; i < max; i++) {
+			if (strcmp(table->ns, ns) == 0) {
+				*ns_id = i + 1;
+				return AEROSPIKE_OK;
+			}
+			table = as_shm_next_partition_table(cluster_shm, table);
+		}
+	}
+	else {
+		as_partition_tables* tables = &cluster->partition_tables;
+		uint32_t max = as_load_uint32(&tables->size);
+
+		for (uint32_t i = 0; i < max; i++) {
+			if (strcmp(tables->tables[i]->ns, ns) == 0) {
+				*ns_id = i + 1;
+				return AEROSPIKE_OK;
+			}
+		}
+	}
+	return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid namespace: %s", ns);
+}
+
 static inline void
 force_replicas_refresh(as_node* node)
 {
 	node->partition_generation = (uint32_t)-1;
 }
 
+static void
+update_partition(
+	as_partition_table* table, uint32_t i, as_node* node, bool master, uint32_t regime,
+	bool* regime_error
+	)
+{
+	// This node claims ownership of partition.
+	// as_log_debug("Set partition %s:%s:%u:%s", master? "master" : "prole", table->ns, i,
+	//				node->name);
+
+	// Volatile reads are not necessary because the tend thread exclusively modifies
+	// partition.  Volatile writes are used so other threads can view change.
+	as_partition* p = &table->partitions[i];
+
+	if (regime >= p->regime) {
+		if (regime > p->regime) {
+			p->regime = regime;
+		}
+
+		if (master) {
+			if (node != p->master) {
+				as_node* tmp = p->master;
+				as_partition_reserve_node(node);
+				set_node(&p->master, node);
+
+				if (tmp) {
+					as_partition_bitmap_clear(&tmp->partition_bitmaps, table, true, i);
+					force_replicas_refresh(tmp);
+					as_partition_release_node_delayed(tmp);
+				}
+			}
+		}
+		else {
+			if (node != p->prole) {
+				as_node* tmp = p->prole;
+				as_partition_reserve_node(node);
+				set_node(&p->prole, node);
+
+				if (tmp) {
+					as_partition_bitmap_clear(&tmp->partition_bitmaps, table, false, i);
+					force_replicas_refresh(tmp);
+					as_partition_release_node_delayed(tmp);
+				}
+			}
+		}
+	}
+	else {
+		if (!(*regime_error)) {
+			as_log_info("%s regime(%u) < old regime(%u)",
+						as_node_get_address_string(node), regime, p->regime);
+			*regime_error = true;
+		}
+	}
+}
+
 static void
 decode_and_update(
 	char* bitmap_b64, uint32_t len, as_partition_table* table, as_node* node, bool master,
 	uint32_t regime, bool* regime_error
 	)
 {
-	// Size allows for padding - is actual size rounded up to multiple of 3.
-	uint8_t* bitmap = (uint8_t*)alloca(cf_b64_decoded_buf_size(len));
+	uint32_t n_words = AS_PARTITION_BITMAP_WORDS(table->size);
+	as_partition_bitmap* prev = as_partition_bitmap_get(&node->partition_bitmaps, table, master,
+		n_words);
+	uint64_t hash = as_partition_bitmap_hash(bitmap_b64, len);
+
+	// Partitions in the previously applied bitmap still reference this node, because
+	// partitions taken by other nodes are removed from that bitmap. Only partitions
+	// newly claimed by this node need to be updated.
+	bool skip_prev = prev->applied && prev->regime == regime;
+
+	if (skip_prev && prev->hash == hash) {
+		// Namespace bitmap did not change.
+		return;
+	}
+
+	uint64_t* bitmap = (uint64_t*)alloca(sizeof(uint64_t) * n_words);
 
 	// For now - for speed - trust validity of encoded characters.
-	cf_b64_decode(bitmap_b64, len, bitmap, NULL);
+	as_partition_bitmap_decode(bitmap_b64, len, bitmap, n_words);
 
-	// Expand the bitmap.
-	for (uint32_t i = 0; i < table->size; i++) {
-		if ((bitmap[i >> 3] & (0x80 >> (i & 7))) != 0) {
-			// This node claims ownership of partition.
-			// as_log_debug("Set partition %s:%s:%u:%s", master? "master" : "prole", table->ns, i,
-			//				node->name);
-
-			// Volatile reads are not necessary because the tend thread exclusively modifies
-			// partition.  Volatile writes are used so other threads can view change.
-			as_partition* p = &table->partitions[i];
-
-			if (regime >= p->regime) {
-				if (regime > p->regime) {
-					p->regime = regime;
-				}
+	// Expand the bitmap. Skip words without partitions to update.
+	for (uint32_t w = 0; w < n_words; w++) {
+		uint64_t bits = skip_prev ? bitmap[w] & ~prev->words[w] : bitmap[w];
 
-				if (master) {
-					if (node != p->master) {
-						as_node* tmp = p->master;
-						as_partition_reserve_node(node);
-						set_node(&p->master, node);
+		while (bits) {
+			uint32_t offset = as_partition_bitmap_first(bits);
+			uint32_t i = (w << 6) + offset;
 
-						if (tmp) {
-							force_replicas_refresh(tmp);
-							as_partition_release_node_delayed(tmp);
-						}
-					}
-				}
-				else {
-					if (node != p->prole) {
-						as_node* tmp = p->prole;
-						as_partition_reserve_node(node);
-						set_node(&p->prole, node);
-
-						if (tmp) {
-							force_replicas_refresh(tmp);
-							as_partition_release_node_delayed(tmp);
-						}
-					}
-				}
-			}
-			else {
-				if (!(*regime_error)) {
-					as_log_info("%s regime(%u) < old regime(%u)",
-								as_node_get_address_string(node), regime, p->regime);
-					*regime_error = true;
-				}
+			if (i >= table->size) {
+				break;
 			}
+			bits &= ~(0x8000000000000000ULL >> offset);
+			update_partition(table, i, node, master, regime, regime_error);
 		}
 	}
+
+	memcpy(prev->words, bitmap, sizeof(uint64_t) * n_words);
+	prev->hash = hash;
+	prev->regime = regime;
+	prev->applied = true;
 }
 
 bool
@@ -547,6 +677,42 @@ as_partition_tables_update_all(as_cluster* cluster, as_node* node, char* buf, bo
 	return true;
 }
 
+bool
+as_partition_tables_restore(
+	as_cluster* cluster, const char* ns, bool sc_mode, const as_partition* partitions
+	)
+{
+	as_partition_tables* tables = &cluster->partition_tables;
+
+	if (tables->size >= AS_MAX_NAMESPACES || as_partition_tables_get(tables, ns)) {
+		return false;
+	}
+
+	as_partition_table* table = as_partition_table_create(ns, cluster->n_partitions, sc_mode);
+
+	for (uint32_t i = 0; i < table->size; i++) {
+		const as_partition* src = &partitions[i];
+		as_partition* p = &table->partitions[i];
+
+		// Leave regime at zero, so the first partition refresh always replaces the
+		// snapshot's owners.
+		if (src->master) {
+			as_partition_reserve_node(src->master);
+			p->master = src->master;
+		}
+
+		if (src->prole) {
+			as_partition_reserve_node(src->prole);
+			p->prole = src->prole;
+		}
+	}
+
+	tables->tables[tables->size] = table;
+	as_fence_store();
+	tables->size++;
+	return true;
+}
+
 void
 as_partition_tables_dump(as_cluster* cluster)
 {
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_partition_bitmap.h>
+#include <aerospike/as_memory.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AS_BITMAP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AS_BITMAP_NEON
+#endif
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint32_t
+as_b64_value(uint8_t c)
+{
+	if (c >= 'A' && c <= 'Z') {
+		return c - 'A';
+	}
+
+	if (c >= 'a' && c <= 'z') {
+		return c - 'a' + 26;
+	}
+
+	if (c >= '0' && c <= '9') {
+		return c - '0' + 52;
+	}
+
+	if (c == '+') {
+		return 62;
+	}
+
+	if (c == '/') {
+		return 63;
+	}
+	// Padding.
+	return 0;
+}
+
+#if defined(AS_BITMAP_SSE2) || defined(AS_BITMAP_NEON)
+
+// Decode 16 characters into four 24 bit groups. Each group is returned in the low
+// three bytes of a host order 32 bit value.
+static inline void
+as_b64_decode16(const uint8_t* in, uint32_t* q)
+{
+#if defined(AS_BITMAP_SSE2)
+	__m128i c = _mm_loadu_si128((const __m128i*)in);
+
+	// Translate characters to 6 bit values by adding a per range offset.
+	__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)),
+		_mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+	__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)),
+		_mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+		_mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+	__m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+	__m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+
+	__m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-65));
+	shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+	shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(4)));
+	shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(19)));
+	shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(16)));
+	__m128i v = _mm_add_epi8(c, shift);
+
+	// Merge value pairs into 12 bits, then 12 bit pairs into 24 bits.
+	__m128i t = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 6),
+		_mm_srli_epi16(v, 8));
+	__m128i u = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(t, _mm_set1_epi32(0xFFFF)), 12),
+		_mm_srli_epi32(t, 16));
+	_mm_storeu_si128((__m128i*)q, u);
+#else
+	uint8x16_t c = vld1q_u8(in);
+
+	// Translate characters to 6 bit values by adding a per range offset.
+	uint8x16_t upper = vandq_u8(vcgeq_u8(c, vdupq_n_u8('A')), vcleq_u8(c, vdupq_n_u8('Z')));
+	uint8x16_t lower = vandq_u8(vcgeq_u8(c, vdupq_n_u8('a')), vcleq_u8(c, vdupq_n_u8('z')));
+	uint8x16_t digit = vandq_u8(vcgeq_u8(c, vdupq_n_u8('0')), vcleq_u8(c, vdupq_n_u8('9')));
+	uint8x16_t plus = vceqq_u8(c, vdupq_n_u8('+'));
+	uint8x16_t slash = vceqq_u8(c, vdupq_n_u8('/'));
+
+	uint8x16_t shift = vandq_u8(upper, vdupq_n_u8((uint8_t)-65));
+	shift = vorrq_u8(shift, vandq_u8(lower, vdupq_n_u8((uint8_t)-71)));
+	shift = vorrq_u8(shift, vandq_u8(digit, vdupq_n_u8(4)));
+	shift = vorrq_u8(shift, vandq_u8(plus, vdupq_n_u8(19)));
+	shift = vorrq_u8(shift, vandq_u8(slash, vdupq_n_u8(16)));
+	uint16x8_t v = vreinterpretq_u16_u8(vaddq_u8(c, shift));
+
+	// Merge value pairs into 12 bits, then 12 bit pairs into 24 bits.
+	uint32x4_t t = vreinterpretq_u32_u16(vorrq_u16(
+		vshlq_n_u16(vandq_u16(v, vdupq_n_u16(0x00FF)), 6), vshrq_n_u16(v, 8)));
+	uint32x4_t u = vorrq_u32(vshlq_n_u32(vandq_u32(t, vdupq_n_u32(0xFFFF)), 12),
+		vshrq_n_u32(t, 16));
+	vst1q_u32(q, u);
+#endif
+}
+
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_partition_bitmap_decode(const char* b64, uint32_t len, uint64_t* words, uint32_t n_words)
+{
+	const uint8_t* in = (const uint8_t*)b64;
+	uint8_t* out = (uint8_t*)words;
+	uint32_t cap = n_words * sizeof(uint64_t);
+	uint32_t i = 0;
+	uint32_t o = 0;
+
+	memset(words, 0, cap);
+
+#if defined(AS_BITMAP_SSE2) || defined(AS_BITMAP_NEON)
+	// Leave the last group for the scalar loop, because it may contain padding.
+	while (i + 20 <= len && o + 12 <= cap) {
+		uint32_t q[4];
+		as_b64_decode16(in + i, q);
+
+		for (uint32_t j = 0; j < 4; j++) {
+			out[o++] = (uint8_t)(q[j] >> 16);
+			out[o++] = (uint8_t)(q[j] >> 8);
+			out[o++] = (uint8_t)q[j];
+		}
+		i += 16;
+	}
+#endif
+
+	while (i + 4 <= len && o < cap) {
+		uint32_t q = (as_b64_value(in[i]) << 18) | (as_b64_value(in[i + 1]) << 12) |
+			(as_b64_value(in[i + 2]) << 6) | as_b64_value(in[i + 3]);
+
+		out[o++] = (uint8_t)(q >> 16);
+
+		if (o < cap) {
+			out[o++] = (uint8_t)(q >> 8);
+		}
+
+		if (o < cap) {
+			out[o++] = (uint8_t)q;
+		}
+		i += 4;
+	}
+
+	// Convert big endian bitmap to host order words.
+	for (uint32_t w = 0; w < n_words; w++) {
+		words[w] = cf_swap_from_be64(words[w]);
+	}
+}
+
+uint64_t
+as_partition_bitmap_hash(const char* b64, uint32_t len)
+{
+	// Multiply and xor shift hash over 8 byte words.
+	const uint64_t m = 0x9E3779B97F4A7C15ULL;
+	uint64_t h = len * m;
+	uint32_t i = 0;
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t v;
+		memcpy(&v, b64 + i, sizeof(v));
+		h = (h ^ v) * m;
+		h ^= h >> 29;
+	}
+
+	if (i < len) {
+		uint64_t v = 0;
+		memcpy(&v, b64 + i, len - i);
+		h = (h ^ v) * m;
+		h ^= h >> 29;
+	}
+	return h ? h : 1;
+}
+
+as_partition_bitmap*
+as_partition_bitmap_get(as_vector* bitmaps, const void* table, bool master, uint32_t n_words)
+{
+	for (uint32_t i = 0; i < bitmaps->size; i++) {
+		as_partition_bitmap* bitmap = as_vector_get_ptr(bitmaps, i);
+
+		if (bitmap->table == table && bitmap->master == master) {
+			return bitmap;
+		}
+	}
+
+	size_t size = sizeof(as_partition_bitmap) + sizeof(uint64_t) * n_words;
+	as_partition_bitmap* bitmap = cf_malloc(size);
+	as_memory_add(AS_MEMORY_TEND, size);
+	bitmap->table = table;
+	bitmap->hash = 0;
+	bitmap->regime = 0;
+	bitmap->n_words = n_words;
+	bitmap->master = master;
+	bitmap->applied = false;
+	as_vector_append(bitmaps, &bitmap);
+	return bitmap;
+}
+
+void
+as_partition_bitmap_clear(as_vector* bitmaps, const void* table, bool master, uint32_t index)
+{
+	for (uint32_t i = 0; i < bitmaps->size; i++) {
+		as_partition_bitmap* bitmap = as_vector_get_ptr(bitmaps, i);
+
+		if (bitmap->table == table && bitmap->master == master) {
+			bitmap->words[index >> 6] &= ~(0x8000000000000000ULL >> (index & 63));
+			bitmap->hash = 0;
+			return;
+		}
+	}
+}
+
+void
+as_partition_bitmaps_destroy(as_vector* bitmaps)
+{
+	for (uint32_t i = 0; i < bitmaps->size; i++) {
+		as_partition_bitmap* bitmap = as_vector_get_ptr(bitmaps, i);
+		as_memory_sub(AS_MEMORY_TEND, sizeof(as_partition_bitmap) +
+			sizeof(uint64_t) * bitmap->n_words);
+		cf_free(bitmap);
+	}
+	as_vector_destroy(bitmaps);
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_partition_filter.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define PARTS_MAGIC "ASPS"
+#define PARTS_VERSION 1
+
+// Header: magic(4) version(1) flags(1) part_begin(2) part_count(2)
+#define PARTS_HEADER_SIZE 10
+
+// Partition: part_id(2) flags(1) [digest(20) bval(8)]
+#define PART_HEADER_SIZE 3
+#define PART_CURSOR_SIZE (AS_DIGEST_VALUE_SIZE + 8)
+
+#define PARTS_DONE 0x1
+#define PARTS_RETRY 0x2
+
+#define PART_RETRY 0x1
+#define PART_DIGEST 0x2
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_partitions_status_to_bytes(
+	const as_partitions_status* parts_all, uint8_t** bytes, uint32_t* bytes_size
+	)
+{
+	uint32_t size = PARTS_HEADER_SIZE;
+
+	for (uint16_t i = 0; i < parts_all->part_count; i++) {
+		size += PART_HEADER_SIZE;
+
+		if (parts_all->parts[i].digest.init) {
+			size += PART_CURSOR_SIZE;
+		}
+	}
+
+	uint8_t* buf = cf_malloc(size);
+	uint8_t* p = buf;
+
+	memcpy(p, PARTS_MAGIC, 4);
+	p += 4;
+	*p++ = PARTS_VERSION;
+	*p++ = (parts_all->done ? PARTS_DONE : 0) | (parts_all->retry ? PARTS_RETRY : 0);
+	*(uint16_t*)p = cf_swap_to_be16(parts_all->part_begin);
+	p += sizeof(uint16_t);
+	*(uint16_t*)p = cf_swap_to_be16(parts_all->part_count);
+	p += sizeof(uint16_t);
+
+	for (uint16_t i = 0; i < parts_all->part_count; i++) {
+		const as_partition_status* ps = &parts_all->parts[i];
+
+		*(uint16_t*)p = cf_swap_to_be16(ps->part_id);
+		p += sizeof(uint16_t);
+		*p++ = (ps->retry ? PART_RETRY : 0) | (ps->digest.init ? PART_DIGEST : 0);
+
+		if (ps->digest.init) {
+			memcpy(p, ps->digest.value, AS_DIGEST_VALUE_SIZE);
+			p += AS_DIGEST_VALUE_SIZE;
+			*(uint64_t*)p = cf_swap_to_be64(ps->bval);
+			p += sizeof(uint64_t);
+		}
+	}
+
+	*bytes = buf;
+	*bytes_size = size;
+}
+
+uint32_t
+as_partitions_status_bytes_max(uint32_t part_count)
+{
+	return PARTS_HEADER_SIZE + (part_count * (PART_HEADER_SIZE + PART_CURSOR_SIZE));
+}
+
+as_partitions_status*
+as_partitions_status_from_bytes(const uint8_t* bytes, uint32_t bytes_size)
+{
+	if (bytes_size < PARTS_HEADER_SIZE || memcmp(bytes, PARTS_MAGIC, 4) != 0 ||
+		bytes[4] != PARTS_VERSION) {
+		return NULL;
+	}
+
+	const uint8_t* p = bytes + 5;
+	const uint8_t* end = bytes + bytes_size;
+	uint8_t flags = *p++;
+	uint16_t part_begin = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+	uint16_t part_count = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+
+	if (part_count == 0 || (uint32_t)part_begin + part_count > 4096) {
+		return NULL;
+	}
+
+	as_partitions_status* parts_all = cf_malloc(sizeof(as_partitions_status) +
+		(sizeof(as_partition_status) * part_count));
+
+	parts_all->ref_count = 1;
+	parts_all->part_begin = part_begin;
+	parts_all->part_count = part_count;
+	parts_all->done = (flags & PARTS_DONE) != 0;
+	parts_all->retry = (flags & PARTS_RETRY) != 0;
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		as_partition_status* ps = &parts_all->parts[i];
+
+		if (end - p < PART_HEADER_SIZE) {
+			cf_free(parts_all);
+			return NULL;
+		}
+
+		ps->part_id = cf_swap_from_be16(*(uint16_t*)p);
+		p += sizeof(uint16_t);
+		uint8_t part_flags = *p++;
+
+		if (ps->part_id != part_begin + i) {
+			cf_free(parts_all);
+			return NULL;
+		}
+
+		ps->retry = (part_flags & PART_RETRY) != 0;
+
+		if (part_flags & PART_DIGEST) {
+			if (end - p < PART_CURSOR_SIZE) {
+				cf_free(parts_all);
+				return NULL;
+			}
+
+			ps->digest.init = true;
+			memcpy(ps->digest.value, p, AS_DIGEST_VALUE_SIZE);
+			p += AS_DIGEST_VALUE_SIZE;
+			ps->bval = cf_swap_from_be64(*(uint64_t*)p);
+			p += sizeof(uint64_t);
+		}
+		else {
+			ps->digest.init = false;
+			ps->bval = 0;
+		}
+	}
+
+	if (p != end) {
+		cf_free(parts_all);
+		return NULL;
+	}
+	return parts_all;
+}
+
+as_status
+as_partitions_status_save(const as_partitions_status* parts_all, const char* path, as_error* err)
+{
+	uint8_t* bytes;
+	uint32_t size;
+	as_partitions_status_to_bytes(parts_all, &bytes, &size);
+
+	// Write temporary file and rename, so readers never see a partial checkpoint.
+	char tmp[1024];
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+		cf_free(bytes);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Checkpoint path too long: %s", path);
+	}
+
+	FILE* fp = fopen(tmp, "wb");
+
+	if (! fp) {
+		cf_free(bytes);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", tmp, errno);
+	}
+
+	size_t n = fwrite(bytes, 1, size, fp);
+	cf_free(bytes);
+
+	int rc = fflush(fp);
+
+#if !defined(_MSC_VER)
+	if (rc == 0) {
+		rc = fsync(fileno(fp));
+	}
+#endif
+
+	if (fclose(fp) != 0) {
+		rc = -1;
+	}
+
+	if (n != size || rc != 0) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write %s: %d", tmp, errno);
+	}
+
+#if defined(_MSC_VER)
+	// Windows rename() does not replace an existing file.
+	remove(path);
+#endif
+
+	if (rename(tmp, path) != 0) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to rename %s: %d", tmp, errno);
+	}
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_partitions_status_load(as_partitions_status** parts_all, const char* path, as_error* err)
+{
+	FILE* fp = fopen(path, "rb");
+
+	if (! fp) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", path, errno);
+	}
+
+	// Largest valid file has all 4096 partitions with digest cursors.
+	uint32_t capacity = PARTS_HEADER_SIZE + (4096 * (PART_HEADER_SIZE + PART_CURSOR_SIZE));
+	uint8_t* bytes = cf_malloc(capacity + 1);
+	size_t size = fread(bytes, 1, capacity + 1, fp);
+	fclose(fp);
+
+	as_partitions_status* pa = NULL;
+
+	if (size <= capacity) {
+		pa = as_partitions_status_from_bytes(bytes, (uint32_t)size);
+	}
+	cf_free(bytes);
+
+	if (! pa) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid partitions status file: %s",
+			path);
+	}
+
+	*parts_all = pa;
+	return AEROSPIKE_OK;
+}
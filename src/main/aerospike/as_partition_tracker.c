@@ -16,13 +16,88 @@
  */
 #include <aerospike/as_partition_tracker.h>
 #include <aerospike/as_cluster.h>
+#include <aerospike/as_log_macros.h>
 #include <aerospike/as_shm_cluster.h>
 #include <aerospike/as_string_builder.h>
+#include <citrusleaf/cf_clock.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /******************************************************************************
  * Static Functions
  *****************************************************************************/
 
+static inline uint32_t
+bit_first(uint64_t bits)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(bits);
+#endif
+}
+
+static inline bool
+retry_get(as_partition_tracker* pt, uint32_t index)
+{
+	return (pt->retry_bits[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void
+retry_clear(as_partition_tracker* pt, uint32_t index)
+{
+	pt->retry_bits[index >> 6] &= ~(1ULL << (index & 63));
+}
+
+static bool
+retry_next(as_partition_tracker* pt, uint32_t n_words, uint32_t* word, uint32_t* index)
+{
+	// Skip whole words of partitions that do not need to be assigned.
+	while (*word < n_words) {
+		uint64_t bits = pt->retry_bits[*word];
+
+		if (bits) {
+			*index = (*word << 6) + bit_first(bits);
+			return true;
+		}
+		(*word)++;
+	}
+	return false;
+}
+
+static void
+retry_load(as_partition_tracker* pt)
+{
+	as_partitions_status* parts_all = pt->parts_all;
+	uint16_t part_count = parts_all->part_count;
+
+	memset(pt->retry_bits, 0, sizeof(pt->retry_bits));
+
+	if (parts_all->retry) {
+		// First iteration assigns all partitions.
+		uint32_t n_full = part_count >> 6;
+
+		for (uint32_t i = 0; i < n_full; i++) {
+			pt->retry_bits[i] = ~0ULL;
+		}
+
+		if (part_count & 63) {
+			pt->retry_bits[n_full] = (1ULL << (part_count & 63)) - 1;
+		}
+		return;
+	}
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		if (parts_all->parts[i].retry) {
+			pt->retry_bits[i >> 6] |= 1ULL << (i & 63);
+		}
+	}
+}
+
 static as_partitions_status*
 parts_create(uint16_t part_begin, uint16_t part_count, const as_digest* digest)
 {
@@ -77,9 +152,11 @@ tracker_init(
 	}
 
 	pthread_mutex_init(&pt->lock, NULL);
+	retry_load(pt);
 
 	as_vector_init(&pt->node_parts, sizeof(as_node_partitions), pt->node_capacity);
 	pt->errors = NULL;
+	pt->checkpoint = NULL;
 	pt->max_records = max_records;
 
 	pt->sleep_between_retries = policy->sleep_between_retries;
@@ -141,18 +218,17 @@ assign_partition(as_partition_tracker* pt, as_partition_status* ps, as_node* nod
 static void
 mark_retry(as_partition_tracker* pt, as_node_partitions* np)
 {
+	uint16_t part_begin = pt->parts_all->part_begin;
 	as_vector* list = &np->parts_full;
 
 	for (uint32_t i = 0; i < list->size; i++) {
-		as_partition_status* ps = as_partition_tracker_get_status(pt, list, i);
-		ps->retry = true;
+		as_partition_tracker_set_retry(pt, as_partition_tracker_get_id(list, i) - part_begin);
 	}
 
 	list = &np->parts_partial;
 
 	for (uint32_t i = 0; i < list->size; i++) {
-		as_partition_status* ps = as_partition_tracker_get_status(pt, list, i);
-		ps->retry = true;
+		as_partition_tracker_set_retry(pt, as_partition_tracker_get_id(list, i) - part_begin);
 	}
 }
 
@@ -164,6 +240,114 @@ release_np(as_node_partitions* np)
 	as_node_release(np->node);
 }
 
+static uint32_t
+chunk_take(as_vector* src, uint32_t* next, as_vector* dst, uint32_t max)
+{
+	uint32_t n = 0;
+
+	while (*next < src->size && n < max) {
+		as_vector_append(dst, as_vector_get(src, *next));
+		(*next)++;
+		n++;
+	}
+	return n;
+}
+
+static uint32_t
+steal_list(
+	as_partition_table* table, as_vector* src, uint32_t next, as_vector* dst, as_node* node,
+	uint32_t max
+	)
+{
+	uint32_t n = 0;
+
+	// Take partitions from the end of the list, so the owner keeps its issue order.
+	for (uint32_t i = src->size; i > next && n < max; i--) {
+		uint16_t part_id = as_partition_tracker_get_id(src, i - 1);
+
+		if (table->partitions[part_id].prole == node) {
+			as_vector_append(dst, &part_id);
+			as_vector_remove(src, i - 1);
+			n++;
+		}
+	}
+	return n;
+}
+
+static uint32_t
+steal_np(
+	as_partition_table* table, as_node_partitions* victim, as_node_partitions* np, uint32_t max
+	)
+{
+	uint32_t n = steal_list(table, &victim->parts_partial, victim->partial_next,
+		&np->parts_partial, np->node, max);
+
+	if (n < max) {
+		n += steal_list(table, &victim->parts_full, victim->full_next, &np->parts_full,
+			np->node, max - n);
+	}
+	return n;
+}
+
+static uint32_t
+steal_partitions(
+	as_partition_tracker* pt, as_cluster* cluster, const char* ns, as_node_partitions* np,
+	uint32_t max
+	)
+{
+	// Only the first iteration reassigns partitions.  A replica may not serve partition
+	// scans, so retried partitions always return to their master.
+	if (pt->iteration > 1 || pt->node_filter || cluster->shm_info) {
+		return 0;
+	}
+
+	as_partition_table* table = as_partition_tables_get(&cluster->partition_tables, ns);
+
+	if (! table || table->sc_mode) {
+		return 0;
+	}
+
+	as_vector* list = &pt->node_parts;
+	as_node_partitions* victim = NULL;
+	uint32_t most = 0;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_node_partitions* other = as_vector_get(list, i);
+
+		if (other == np) {
+			continue;
+		}
+
+		uint32_t left = (other->parts_full.size - other->full_next) +
+			(other->parts_partial.size - other->partial_next);
+
+		if (left > most) {
+			most = left;
+			victim = other;
+		}
+	}
+
+	if (! victim) {
+		return 0;
+	}
+
+	uint32_t n = steal_np(table, victim, np, max);
+
+	if (n > 0) {
+		return n;
+	}
+
+	// Most lagging node does not share partitions with this node.  Try the others.
+	for (uint32_t i = 0; i < list->size && n == 0; i++) {
+		as_node_partitions* other = as_vector_get(list, i);
+
+		if (other != np && other != victim) {
+			n = steal_np(table, other, np, max);
+		}
+	}
+	return n;
+}
+
 static void
 release_node_partitions(as_vector* list)
 {
@@ -245,7 +429,9 @@ as_partition_tracker_assign(
     //printf("Round %u\n", pt->iteration);
 
 	as_partitions_status* parts_all = pt->parts_all;
-	bool retry = parts_all->retry && pt->iteration == 1;
+	uint32_t n_words = (parts_all->part_count + 63) >> 6;
+	uint32_t word = 0;
+	uint32_t index;
 
 	if (!cluster->shm_info) {
 		as_partition_table* table = as_partition_tables_get(&cluster->partition_tables, ns);
@@ -254,28 +440,25 @@ as_partition_tracker_assign(
 			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid namespace: %s", ns);
 		}
 
-		for (uint16_t i = 0; i < parts_all->part_count; i++) {
-			as_partition_status* ps = &parts_all->parts[i];
+		while (retry_next(pt, n_words, &word, &index)) {
+			as_partition_status* ps = &parts_all->parts[index];
+			as_node* node = table->partitions[ps->part_id].master;
 
-			if (retry || ps->retry) {
-				as_node* node = table->partitions[ps->part_id].master;
-
-				if (! node) {
-					return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
-										   "Node not found for partition %u", ps->part_id);
-				}
-
-				ps->retry = false;
+			if (! node) {
+				return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
+									   "Node not found for partition %u", ps->part_id);
+			}
 
-				// Use node name to check for single node equality because
-				// partition map may be in transitional state between
-				// the old and new node with the same name.
-				if (pt->node_filter && strcmp(pt->node_filter->name, node->name) != 0) {
-					continue;
-				}
+			retry_clear(pt, index);
 
-				assign_partition(pt, ps, node);
+			// Use node name to check for single node equality because
+			// partition map may be in transitional state between
+			// the old and new node with the same name.
+			if (pt->node_filter && strcmp(pt->node_filter->name, node->name) != 0) {
+				continue;
 			}
+
+			assign_partition(pt, ps, node);
 		}
 	}
 	else {
@@ -288,36 +471,33 @@ as_partition_tracker_assign(
 
 		as_node** local_nodes = cluster->shm_info->local_nodes;
 
-		for (uint16_t i = 0; i < parts_all->part_count; i++) {
-			as_partition_status* ps = &parts_all->parts[i];
-
-			if (retry || ps->retry) {
-				uint32_t master = as_load_uint32(&table->partitions[ps->part_id].master);
+		while (retry_next(pt, n_words, &word, &index)) {
+			as_partition_status* ps = &parts_all->parts[index];
+			uint32_t master = as_load_uint32(&table->partitions[ps->part_id].master);
 
-				// node index zero indicates unset.
-				if (master == 0) {
-					return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
-										   "Node not found for partition %u", ps->part_id);
-				}
+			// node index zero indicates unset.
+			if (master == 0) {
+				return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
+									   "Node not found for partition %u", ps->part_id);
+			}
 
-				as_node* node = (as_node*)as_load_ptr(&local_nodes[master-1]);
+			as_node* node = (as_node*)as_load_ptr(&local_nodes[master-1]);
 
-				if (! node) {
-					return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
-										   "Node not found for partition %u", ps->part_id);
-				}
-
-				ps->retry = false;
+			if (! node) {
+				return as_error_update(err, AEROSPIKE_ERR_INVALID_NODE,
+									   "Node not found for partition %u", ps->part_id);
+			}
 
-				// Use node name to check for single node equality because
-				// partition map may be in transitional state between
-				// the old and new node with the same name.
-				if (pt->node_filter && strcmp(pt->node_filter->name, node->name) != 0) {
-					continue;
-				}
+			retry_clear(pt, index);
 
-				assign_partition(pt, ps, node);
+			// Use node name to check for single node equality because
+			// partition map may be in transitional state between
+			// the old and new node with the same name.
+			if (pt->node_filter && strcmp(pt->node_filter->name, node->name) != 0) {
+				continue;
 			}
+
+			assign_partition(pt, ps, node);
 		}
 	}
 
@@ -485,6 +665,152 @@ as_partition_tracker_is_complete(as_partition_tracker* pt, as_cluster* cluster,
 	return AEROSPIKE_ERR_CLIENT;
 }
 
+void
+as_partition_tracker_checkpoint_init(
+	as_partition_tracker* pt, const char* path, uint32_t records, uint32_t interval
+	)
+{
+	as_partition_checkpoint* cp = cf_malloc(sizeof(as_partition_checkpoint));
+	cp->path = cf_strdup(path);
+	cp->seqs = cf_calloc(pt->parts_all->part_count, sizeof(uint32_t));
+	cp->count = 0;
+	cp->next_count = records;
+	cp->deadline = interval > 0 ? cf_getms() + interval : 0;
+	cp->records = records;
+	cp->interval = interval;
+	cp->busy = 0;
+	pt->checkpoint = cp;
+}
+
+void
+as_partition_tracker_checkpoint_set(
+	as_partition_tracker* pt, as_partition_status* p, as_digest* digest, uint64_t bval
+	)
+{
+	as_partition_checkpoint* cp = pt->checkpoint;
+	uint32_t* seq = &cp->seqs[p - pt->parts_all->parts];
+
+	// Only one node command updates a partition at a time.  Odd sequence means the
+	// cursor is being written.
+	as_store_uint32(seq, *seq + 1);
+	as_fence_seq();
+	p->digest = *digest;
+	p->bval = bval;
+	as_fence_seq();
+	as_store_uint32(seq, *seq + 1);
+
+	uint64_t count = as_aaf_uint64(&cp->count, 1);
+
+	if (! ((cp->records > 0 && count >= as_load_uint64(&cp->next_count)) ||
+		   (cp->interval > 0 && cf_getms() >= as_load_uint64(&cp->deadline)))) {
+		return;
+	}
+
+	// Let one node thread write the checkpoint while the others keep reading records.
+	if (! as_cas_uint32(&cp->busy, 0, 1)) {
+		return;
+	}
+
+	as_error err;
+	as_error_init(&err);
+
+	if (as_partition_tracker_checkpoint_write(pt, false, &err) != AEROSPIKE_OK) {
+		as_log_warn("Checkpoint failed: %s", err.message);
+	}
+
+	as_store_uint64(&cp->next_count, count + cp->records);
+
+	if (cp->interval > 0) {
+		as_store_uint64(&cp->deadline, cf_getms() + cp->interval);
+	}
+	as_store_uint32(&cp->busy, 0);
+}
+
+as_status
+as_partition_tracker_checkpoint_write(as_partition_tracker* pt, bool final, as_error* err)
+{
+	as_partition_checkpoint* cp = pt->checkpoint;
+	as_partitions_status* src = pt->parts_all;
+	uint16_t part_count = src->part_count;
+
+	as_partitions_status* dst = cf_malloc(sizeof(as_partitions_status) +
+		(sizeof(as_partition_status) * part_count));
+
+	dst->ref_count = 1;
+	dst->part_begin = src->part_begin;
+	dst->part_count = part_count;
+	dst->done = final ? src->done : false;
+	dst->retry = final ? src->retry : true;
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		uint32_t* seq = &cp->seqs[i];
+		uint32_t begin;
+
+		do {
+			begin = as_load_uint32(seq);
+			as_fence_seq();
+			dst->parts[i] = src->parts[i];
+			as_fence_seq();
+		} while ((begin & 1) || begin != as_load_uint32(seq));
+
+		// Node threads may set retry bits of other partitions in the same word.
+		dst->parts[i].retry = final ?
+			((as_load_uint64(&pt->retry_bits[i >> 6]) >> (i & 63)) & 1) : true;
+	}
+
+	as_status status = as_partitions_status_save(dst, cp->path, err);
+	cf_free(dst);
+	return status;
+}
+
+void
+as_partition_tracker_chunk_init(
+	as_partition_tracker* pt, as_node_partitions* chunk, as_node_partitions* np
+	)
+{
+	// The chunk borrows the node reference of np.
+	memset(chunk, 0, sizeof(as_node_partitions));
+	chunk->node = np->node;
+	as_vector_init(&chunk->parts_full, sizeof(uint16_t), pt->parts_capacity);
+	as_vector_init(&chunk->parts_partial, sizeof(uint16_t), pt->parts_capacity);
+}
+
+bool
+as_partition_tracker_next_chunk(
+	as_partition_tracker* pt, as_cluster* cluster, const char* ns, as_node_partitions* np,
+	as_node_partitions* chunk, uint32_t chunk_size
+	)
+{
+	as_vector_clear(&chunk->parts_full);
+	as_vector_clear(&chunk->parts_partial);
+	chunk->record_count = 0;
+	chunk->parts_unavailable = 0;
+
+	// Other node threads may steal from np's unissued partitions.
+	pthread_mutex_lock(&pt->lock);
+
+	if (np->full_next == np->parts_full.size && np->partial_next == np->parts_partial.size) {
+		steal_partitions(pt, cluster, ns, np, chunk_size);
+	}
+
+	// Resume partially scanned partitions first.
+	uint32_t n = chunk_take(&np->parts_partial, &np->partial_next, &chunk->parts_partial,
+		chunk_size);
+
+	if (n < chunk_size) {
+		n += chunk_take(&np->parts_full, &np->full_next, &chunk->parts_full, chunk_size - n);
+	}
+	pthread_mutex_unlock(&pt->lock);
+	return n > 0;
+}
+
+void
+as_partition_tracker_chunk_destroy(as_node_partitions* chunk)
+{
+	as_vector_destroy(&chunk->parts_full);
+	as_vector_destroy(&chunk->parts_partial);
+}
+
 bool
 as_partition_tracker_should_retry(
 	as_partition_tracker* pt, as_node_partitions* np, as_status status
@@ -517,6 +843,13 @@ as_partition_tracker_should_retry(
 void
 as_partition_tracker_destroy(as_partition_tracker* pt)
 {
+	// Store retry flags, so parts_all can be resumed in the next page or scan/query.
+	as_partitions_status* parts_all = pt->parts_all;
+
+	for (uint16_t i = 0; i < parts_all->part_count; i++) {
+		parts_all->parts[i].retry = retry_get(pt, i);
+	}
+
 	release_node_partitions(&pt->node_parts);
 	as_vector_destroy(&pt->node_parts);
 	as_partitions_status_release(pt->parts_all);
@@ -525,5 +858,12 @@ as_partition_tracker_destroy(as_partition_tracker* pt)
 		as_vector_destroy(pt->errors);
 		pt->errors = NULL;
 	}
+
+	if (pt->checkpoint) {
+		cf_free(pt->checkpoint->path);
+		cf_free(pt->checkpoint->seqs);
+		cf_free(pt->checkpoint);
+		pt->checkpoint = NULL;
+	}
 	pthread_mutex_destroy(&pt->lock);
 }
@@ -103,8 +103,8 @@ as_peers_create_node(
 	)
 {
 	// Create node.
+	// Minimum connections are created when the node is added to the cluster.
 	as_node* node = as_node_create(cluster, node_info);
-	as_node_create_min_connections(node);
 
 	if (is_alias) {
 		as_node_add_alias(node, host->name, host->port);
@@ -125,7 +125,7 @@ as_peers_validate_node(
 	as_error_init(&err);
 
 	as_address_iterator iter;
-	as_status status = as_lookup_host(&iter, &err, host->name, host->port);
+	as_status status = as_lookup_host(cluster->dns_cache, &iter, &err, host->name, host->port);
 	
 	if (status != AEROSPIKE_OK) {
 		as_log_warn("%s %s", as_error_string(status), err.message);
@@ -17,6 +17,7 @@
 
 #include <aerospike/as_pipe.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(__linux__)
 #define PIPE_WRITE_BUFFER_SIZE (5 * 1024 * 1024)
@@ -44,6 +45,82 @@ write_start(as_event_command* cmd)
 	conn->writer = cmd;
 }
 
+static bool
+gather_append(as_event_command* cmd)
+{
+	// Append command to a connection whose write for the same node is deferred.
+	for (as_pipe_connection* conn = cmd->event_loop->pipe_gather; conn; conn = conn->gather_next) {
+		as_event_command* writer = conn->writer;
+
+		if (writer->node != cmd->node) {
+			continue;
+		}
+
+		uint32_t len = conn->base.gather_len;
+
+		if (len == 0) {
+			// First gathered command.  Writer's command goes first.
+			if (writer->write_len + cmd->write_len > AS_PIPE_GATHER_SIZE) {
+				continue;
+			}
+			memcpy(conn->gather_space, (uint8_t*)writer + writer->write_offset, writer->write_len);
+			len = writer->write_len;
+		}
+		else if (len + cmd->write_len > AS_PIPE_GATHER_SIZE) {
+			continue;
+		}
+
+		memcpy(conn->gather_space + len, (uint8_t*)cmd + cmd->write_offset, cmd->write_len);
+		conn->base.gather_len = len + cmd->write_len;
+
+		as_log_trace("Gathering command %p behind writer %p, pipeline connection %p", cmd, writer, conn);
+		cmd->conn = &conn->base;
+		cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+		cf_ll_append(&conn->gathered, &cmd->pipe_link);
+		return true;
+	}
+	return false;
+}
+
+static void
+gather_remove(as_pipe_connection* conn, as_event_loop* loop)
+{
+	if (! conn->gathering) {
+		return;
+	}
+
+	as_pipe_connection** p = &loop->pipe_gather;
+
+	while (*p != conn) {
+		p = &(*p)->gather_next;
+	}
+	*p = conn->gather_next;
+	conn->gather_next = NULL;
+	conn->gathering = false;
+}
+
+static void
+gather_flush(as_event_loop* loop)
+{
+	// Detach list first.  Writes that complete immediately run pipeline listeners again,
+	// which may defer writes on a new list.
+	as_pipe_connection* conn = loop->pipe_gather;
+	loop->pipe_gather = NULL;
+
+	while (conn) {
+		as_pipe_connection* next = conn->gather_next;
+		conn->gather_next = NULL;
+		conn->gathering = false;
+
+		if (conn->base.gather_len > 0) {
+			conn->base.gather = conn->gather_space;
+		}
+		as_log_trace("Writing deferred writer %p, pipeline connection %p", conn->writer, conn);
+		as_event_command_write_start(conn->writer);
+		conn = next;
+	}
+}
+
 static void
 next_reader(as_event_command* reader)
 {
@@ -124,11 +201,24 @@ cancel_connection(as_event_command* cmd, as_error* err, int32_t source, bool ret
 	as_log_trace("Stopping watcher");
 	as_event_stop_watcher(cmd, &conn->base);
 
+	gather_remove(conn, loop);
+	conn->base.gather = NULL;
+	conn->base.gather_len = 0;
+
 	if (conn->writer != NULL) {
 		as_log_trace("Canceling writer %p on %p", conn->writer, conn);
 		cancel_command(conn->writer, err, retry, timeout);
 	}
 
+	while (cf_ll_size(&conn->gathered) > 0) {
+		cf_ll_element* link = cf_ll_get_head(&conn->gathered);
+		as_event_command* walker = as_pipe_link_to_command(link);
+
+		as_log_trace("Canceling gathered command %p on %p", walker, conn);
+		cf_ll_delete(&conn->gathered, link);
+		cancel_command(walker, err, retry, timeout);
+	}
+
 	bool is_reader = false;
 
 	while (cf_ll_size(&conn->readers) > 0) {
@@ -198,6 +288,74 @@ put_connection(as_event_command* cmd)
 	release_connection(cmd, conn, pool);
 }
 
+static uint32_t
+select_connection(as_async_conn_pool* pool)
+{
+	// Move the pooled connection with the fewest in-flight commands to the queue head.
+	// Scan from the tail, so ties go to the most recently used connection and connections
+	// that are not needed age out.
+	as_queue* queue = &pool->queue;
+	uint32_t best = queue->tail;
+	uint32_t best_depth = UINT32_MAX;
+
+	for (uint32_t i = queue->tail; i != queue->head; ) {
+		i--;
+		as_pipe_connection* conn = *(as_pipe_connection**)as_queue_get(queue, i % queue->capacity);
+		uint32_t depth = cf_ll_size(&conn->readers);
+
+		if (depth < best_depth) {
+			best = i;
+			best_depth = depth;
+
+			if (depth == 0) {
+				break;
+			}
+		}
+	}
+
+	if (best != queue->head) {
+		as_pipe_connection** head = as_queue_get(queue, queue->head % queue->capacity);
+		as_pipe_connection** conn = as_queue_get(queue, best % queue->capacity);
+		as_pipe_connection* tmp = *head;
+		*head = *conn;
+		*conn = tmp;
+	}
+	return best_depth;
+}
+
+static void
+trim_connection(as_event_command* cmd, as_async_conn_pool* pool)
+{
+	// Close one pooled connection that has no in-flight commands and has not been used
+	// within max_socket_idle.  Keep at least one pooled connection.
+	as_queue* queue = &pool->queue;
+
+	if (as_queue_size(queue) <= 1) {
+		return;
+	}
+
+	for (uint32_t i = queue->head; i != queue->tail; i++) {
+		as_pipe_connection** entry = as_queue_get(queue, i % queue->capacity);
+		as_pipe_connection* conn = *entry;
+
+		if (conn->canceling || conn->canceled || conn->writer != NULL ||
+			cf_ll_size(&conn->readers) > 0 ||
+			as_event_conn_current_trim(&conn->base, cmd->cluster->max_socket_idle_ns_trim)) {
+			continue;
+		}
+
+		// Fill the slot with the head entry and pop the head.
+		as_pipe_connection* head;
+		*entry = *(as_pipe_connection**)as_queue_get(queue, queue->head % queue->capacity);
+		as_queue_pop(queue, &head);
+
+		as_log_trace("Trimming idle pipeline connection %p", conn);
+		conn->in_pool = false;
+		release_connection(cmd, conn, pool);
+		return;
+	}
+}
+
 #if defined(__linux__)
 static bool
 read_file(const char* path, char* buffer, size_t size)
@@ -309,16 +467,35 @@ void
 as_pipe_get_connection(as_event_command* cmd)
 {
 	as_log_trace("Getting pipeline connection for command %p", cmd);
+
+	if (cmd->event_loop->pipe_cb_calling && gather_append(cmd)) {
+		return;
+	}
+
 	as_async_conn_pool* pool = &cmd->node->pipe_conn_pools[cmd->event_loop->index];
 	as_pipe_connection* conn;
 
-	// Prefer to open new connections, as long as we are below pool capacity. This is to
-	// make sure that we fully use the allowed number of connections. Pipelining otherwise
-	// tends to open very few connections, which isn't good for write parallelism on the
-	// server. The server processes all commands from the same connection sequentially.
-	// More connections thus mean more parallelism.
-	if (pool->queue.total >= pool->limit) {
-		while (as_queue_pop(&pool->queue, &conn)) {
+	uint32_t max_depth = cmd->cluster->pipe_max_depth;
+
+	if (max_depth > 0) {
+		trim_connection(cmd, pool);
+	}
+
+	// Without a depth limit, prefer to open new connections, as long as we are below pool
+	// capacity. This is to make sure that we fully use the allowed number of connections.
+	// Pipelining otherwise tends to open very few connections, which isn't good for write
+	// parallelism on the server. The server processes all commands from the same connection
+	// sequentially. More connections thus mean more parallelism.
+	if (max_depth > 0 || pool->queue.total >= pool->limit) {
+		while (as_queue_size(&pool->queue) > 0) {
+			uint32_t depth = select_connection(pool);
+
+			if (depth >= max_depth && max_depth > 0 && pool->queue.total < pool->limit) {
+				// Every pooled connection is at the depth limit.  Open another connection.
+				break;
+			}
+
+			as_queue_pop(&pool->queue, &conn);
 			as_log_trace("Checking pipeline connection %p", conn);
 
 			if (conn->canceling) {
@@ -355,6 +532,16 @@ as_pipe_get_connection(as_event_command* cmd)
 			as_log_trace("Validation OK");
 			cmd->conn = (as_event_connection*)conn;
 			write_start(cmd);
+
+			if (cmd->event_loop->pipe_cb_calling) {
+				// Pipeline listeners are issuing their next commands.  Defer write until
+				// they finish, so commands for this node can be sent in the same write.
+				as_event_loop* loop = cmd->event_loop;
+				conn->gather_next = loop->pipe_gather;
+				conn->gathering = true;
+				loop->pipe_gather = conn;
+				return;
+			}
 			as_event_command_write_start(cmd);
 			return;
 		}
@@ -367,16 +554,21 @@ as_pipe_get_connection(as_event_command* cmd)
 		conn = cf_malloc(sizeof(as_pipe_connection));
 		assert(conn != NULL);
 
-#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT) || defined(AS_USE_LIBURING)
 		as_socket_init(&conn->base.socket);
 #endif
+		conn->base.gather = NULL;
+		conn->base.gather_len = 0;
 		conn->base.watching = 0;
 		conn->base.pipeline = true;
 		conn->writer = NULL;
 		cf_ll_init(&conn->readers, NULL, false);
+		cf_ll_init(&conn->gathered, NULL, false);
+		conn->gather_next = NULL;
 		conn->canceling = false;
 		conn->canceled = false;
 		conn->in_pool = false;
+		conn->gathering = false;
 		
 		cmd->conn = (as_event_connection*)conn;
 		write_start(cmd);
@@ -505,9 +697,6 @@ as_pipe_read_start(as_event_command* cmd)
 
 	conn->writer = NULL;
 	cf_ll_append(&conn->readers, &cmd->pipe_link);
-	as_log_trace("Pipeline connection %p has %d reader(s)", conn, cf_ll_size(&conn->readers));
-
-	put_connection(cmd);
 
 	as_event_loop* loop = cmd->event_loop;
 	as_queue* q = &loop->pipe_cb_queue;
@@ -516,6 +705,28 @@ as_pipe_read_start(as_event_command* cmd)
 		as_queue_push(q, &(as_queued_pipe_cb){ cmd->pipe_listener, cmd->udata });
 	}
 
+	// Gathered commands were sent in the same write and are read in the same order.
+	while (cf_ll_size(&conn->gathered) > 0) {
+		cf_ll_element* link = cf_ll_get_head(&conn->gathered);
+		as_event_command* gathered = as_pipe_link_to_command(link);
+
+		cf_ll_delete(&conn->gathered, link);
+		gathered->command_sent_counter++;
+		gathered->len = sizeof(as_proto);
+		gathered->pos = 0;
+		gathered->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+		cf_ll_append(&conn->readers, link);
+
+		if (gathered->pipe_listener != NULL) {
+			as_queue_push(q, &(as_queued_pipe_cb){ gathered->pipe_listener, gathered->udata });
+		}
+	}
+	conn->base.gather = NULL;
+	conn->base.gather_len = 0;
+	as_log_trace("Pipeline connection %p has %d reader(s)", conn, cf_ll_size(&conn->readers));
+
+	put_connection(cmd);
+
 	if (loop->pipe_cb_calling) {
 		return;
 	}
@@ -528,4 +739,5 @@ as_pipe_read_start(as_event_command* cmd)
 	}
 
 	loop->pipe_cb_calling = false;
+	gather_flush(loop);
 }
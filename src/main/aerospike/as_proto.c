@@ -15,9 +15,20 @@
  * the License.
  */
 #include <aerospike/as_proto.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_compress.h>
+#include <aerospike/as_memory.h>
+#include <citrusleaf/alloc.h>
 #include <citrusleaf/cf_byte_order.h>
 #include <string.h>
-#include <zlib.h>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define AS_MSG_SWAP_SSSE3
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AS_MSG_SWAP_NEON
+#endif
 
 // Byte swap proto from current machine byte order to network byte order (big endian).
 void
@@ -54,6 +65,106 @@ as_msg_swap_header_from_be(as_msg *m)
 	m->n_ops= cf_swap_from_be16(m->n_ops);
 }
 
+// Swap header with one 16 byte shuffle. Bytes 6 through 21 hold generation, record_ttl,
+// transaction_ttl, n_fields and n_ops.
+static inline void
+as_msg_swap_header_fast(as_msg* m)
+{
+#if defined(AS_MSG_SWAP_SSSE3)
+	uint8_t* p = (uint8_t*)m + 6;
+	__m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 13, 12, 15, 14);
+	__m128i v = _mm_loadu_si128((const __m128i*)p);
+	_mm_storeu_si128((__m128i*)p, _mm_shuffle_epi8(v, mask));
+#elif defined(AS_MSG_SWAP_NEON)
+	static const uint8_t mask[16] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 13, 12, 15, 14};
+	uint8_t* p = (uint8_t*)m + 6;
+	vst1q_u8(p, vqtbl1q_u8(vld1q_u8(p), vld1q_u8(mask)));
+#else
+	as_msg_swap_header_from_be(m);
+#endif
+}
+
+static void
+as_msg_index_grow(as_msg_index* index)
+{
+	uint32_t capacity = index->capacity * 2;
+	as_msg** msgs = cf_malloc(sizeof(as_msg*) * capacity);
+	memcpy(msgs, index->msgs, sizeof(as_msg*) * index->size);
+	as_memory_add(AS_MEMORY_COMMAND, sizeof(as_msg*) * capacity);
+	as_msg_index_destroy(index);
+	index->msgs = msgs;
+	index->capacity = capacity;
+}
+
+// Index all records of a multi-record response block before they are decoded. Records are
+// found with one pass over the field and bin sizes, which fields and bins share, so decoders
+// can skip the header swap and boundary checks. The index also gives decoders the number of
+// records and bins up front and lets records be handed to other threads by position.
+as_status
+as_msg_index_build(as_error* err, as_msg_index* index, uint8_t* buf, size_t size)
+{
+	index->msgs = index->inline_msgs;
+	index->size = 0;
+	index->capacity = AS_MSG_INDEX_INLINE;
+	index->n_records = 0;
+	index->n_bins = 0;
+
+	uint8_t* p = buf;
+	uint8_t* end = buf + size;
+
+	while (p < end) {
+		if (p + sizeof(as_msg) > end) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Truncated record header at %u",
+				(uint32_t)(p - buf));
+		}
+
+		as_msg* msg = (as_msg*)p;
+		as_msg_swap_header_fast(msg);
+
+		uint32_t n = (uint32_t)msg->n_fields + msg->n_ops;
+		size_t remaining = end - msg->data;
+		size_t len = 0;
+
+		for (uint32_t i = 0; i < n && len <= remaining; i++) {
+			if (len + 4 > remaining) {
+				len = remaining + 1;
+				break;
+			}
+			len += (size_t)cf_swap_from_be32(*(uint32_t*)(msg->data + len)) + 4;
+		}
+		if (len > remaining) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Truncated record at %u",
+				(uint32_t)((uint8_t*)msg - buf));
+		}
+		p = msg->data + len;
+
+		if (index->size == index->capacity) {
+			as_msg_index_grow(index);
+		}
+		index->msgs[index->size++] = msg;
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			break;
+		}
+
+		if (msg->n_ops > 0) {
+			index->n_records++;
+			index->n_bins += msg->n_ops;
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+void
+as_msg_index_destroy(as_msg_index* index)
+{
+	if (index->msgs != index->inline_msgs) {
+		as_memory_sub(AS_MEMORY_COMMAND, sizeof(as_msg*) * index->capacity);
+		cf_free(index->msgs);
+		index->msgs = index->inline_msgs;
+	}
+}
+
 as_status
 as_proto_version_error(as_error* err, as_proto* proto)
 {
@@ -98,11 +209,12 @@ as_proto_parse(as_error* err, as_proto* proto)
 as_status
 as_proto_decompress(as_error* err, uint8_t* trg, size_t trg_sz, uint8_t* src, size_t src_sz)
 {
-	uLongf sz = (uLongf)trg_sz;
-	int rv = uncompress(trg, &sz, src + sizeof(uint64_t), (uLong)(src_sz - sizeof(uint64_t)));
+	size_t sz = trg_sz;
+	as_status status = as_decompress(err, AS_COMPRESS_ZLIB, trg, &sz, src + sizeof(uint64_t),
+									 src_sz - sizeof(uint64_t));
 
-	if (rv != Z_OK) {
-		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Decompress failed: %d", rv);
+	if (status != AEROSPIKE_OK) {
+		return status;
 	}
 
 	if (sz != trg_sz) {
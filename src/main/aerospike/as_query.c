@@ -218,6 +218,15 @@ as_query_where(as_query* query, const char * bin, as_predicate_type type, as_ind
 			status = false;
 		}
 		break;
+	case AS_PREDICATE_GEO_REGION:
+		if (dtype == AS_INDEX_GEO2DSPHERE) {
+			p->value.geo_region = va_arg(ap, struct as_geo_region_s*);
+			status = p->value.geo_region != NULL;
+		}
+		else {
+			status = false;
+		}
+		break;
 	}
 
 	va_end(ap);
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_query_pager.h>
+#include <aerospike/as_record.h>
+#include <citrusleaf/alloc.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_record*
+as_query_pager_take(as_record* src)
+{
+	// Take ownership of the parsed values instead of copying them. The parser destroys
+	// the source record after the callback returns.
+	uint16_t n_bins = src->bins.size;
+	as_record* rec = as_record_new(n_bins);
+
+	rec->gen = src->gen;
+	rec->ttl = src->ttl;
+
+	as_key* dkey = &rec->key;
+	as_key* skey = &src->key;
+	memcpy(dkey->ns, skey->ns, sizeof(dkey->ns));
+	memcpy(dkey->set, skey->set, sizeof(dkey->set));
+	dkey->digest = skey->digest;
+
+	// Values embedded in the source are moved with their heap pointers.
+	if (skey->valuep == &skey->value) {
+		dkey->value = skey->value;
+		dkey->valuep = &dkey->value;
+	}
+	else {
+		dkey->valuep = skey->valuep;
+	}
+	skey->valuep = NULL;
+
+	for (uint16_t i = 0; i < n_bins; i++) {
+		as_bin* s = &src->bins.entries[i];
+		as_bin* d = &rec->bins.entries[i];
+
+		memcpy(d->name, s->name, sizeof(d->name));
+
+		if (s->valuep == &s->value) {
+			d->value = s->value;
+			d->valuep = &d->value;
+		}
+		else {
+			d->valuep = s->valuep;
+		}
+		s->valuep = NULL;
+	}
+	rec->bins.size = n_bins;
+	return rec;
+}
+
+static bool
+as_query_pager_collect(const as_val* val, void* udata)
+{
+	if (! val) {
+		return true;
+	}
+
+	as_query_pager* pager = udata;
+	as_record* rec = as_query_pager_take(as_record_fromval(val));
+
+	// Node threads deliver records concurrently.
+	pthread_mutex_lock(&pager->lock);
+	as_vector_append(&pager->records, &rec);
+	pthread_mutex_unlock(&pager->lock);
+	return true;
+}
+
+static as_status
+as_query_pager_fetch(as_query_pager* pager)
+{
+	as_error_reset(&pager->err);
+	pager->status = aerospike_query_partitions(pager->as, &pager->err, &pager->policy,
+		pager->query, &pager->pf, as_query_pager_collect, pager);
+	return pager->status;
+}
+
+static void*
+as_query_pager_run(void* data)
+{
+	as_query_pager_fetch(data);
+	return NULL;
+}
+
+static void
+as_query_pager_clear(as_vector* records)
+{
+	for (uint32_t i = 0; i < records->size; i++) {
+		as_record* rec = *(as_record**)as_vector_get(records, i);
+		as_record_destroy(rec);
+	}
+	as_vector_clear(records);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_query_pager_init(
+	as_query_pager* pager, aerospike* as, as_error* err, const as_policy_query* policy,
+	as_query* query, const as_partition_filter* pf
+	)
+{
+	as_error_reset(err);
+
+	if (query->max_records == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"Query pager requires max_records");
+	}
+
+	if (! policy) {
+		policy = &as->config.policies.query;
+	}
+
+	pager->as = as;
+	pager->query = query;
+	pager->policy = *policy;
+
+	// Buffered records outlive the response buffer and the parse callback.
+	pager->policy.zero_copy = false;
+	pager->policy.reuse_record = false;
+
+	if (pf) {
+		pager->pf = *pf;
+
+		if (pf->parts_all && ! query->parts_all) {
+			as_query_set_partitions(query, pf->parts_all);
+		}
+		pager->pf.parts_all = NULL;
+	}
+	else {
+		as_partition_filter_set_all(&pager->pf);
+	}
+
+	as_query_set_paginate(query, true);
+	as_vector_init(&pager->records, sizeof(as_record*), (uint32_t)query->max_records);
+	pthread_mutex_init(&pager->lock, NULL);
+	as_error_init(&pager->err);
+	pager->status = AEROSPIKE_OK;
+	pager->running = false;
+	pager->done = false;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_query_pager_next(
+	as_query_pager* pager, as_error* err, aerospike_query_foreach_callback callback, void* udata
+	)
+{
+	as_error_reset(err);
+
+	if (pager->done) {
+		callback(NULL, udata);
+		return AEROSPIKE_OK;
+	}
+
+	as_status status;
+
+	if (pager->running) {
+		pthread_join(pager->thread, NULL);
+		pager->running = false;
+		status = pager->status;
+	}
+	else {
+		status = as_query_pager_fetch(pager);
+	}
+
+	if (status != AEROSPIKE_OK) {
+		// Partial page is discarded. The query's partition status is marked for retry.
+		as_error_copy(err, &pager->err);
+		as_query_pager_clear(&pager->records);
+		return status;
+	}
+
+	// Take the page, so the prefetch can fill a new buffer.
+	as_vector page = pager->records;
+	as_vector_init(&pager->records, sizeof(as_record*), page.capacity);
+
+	pager->done = as_query_is_done(pager->query);
+
+	if (! pager->done &&
+		pthread_create(&pager->thread, NULL, as_query_pager_run, pager) == 0) {
+		pager->running = true;
+	}
+
+	bool rv = true;
+
+	for (uint32_t i = 0; i < page.size; i++) {
+		as_record* rec = *(as_record**)as_vector_get(&page, i);
+
+		// Records after a callback abort are only released.
+		if (rv) {
+			rv = callback((as_val*)rec, udata);
+		}
+		as_record_destroy(rec);
+	}
+	as_vector_destroy(&page);
+
+	callback(NULL, udata);
+	return AEROSPIKE_OK;
+}
+
+void
+as_query_pager_destroy(as_query_pager* pager)
+{
+	if (pager->running) {
+		pthread_join(pager->thread, NULL);
+		pager->running = false;
+	}
+	as_query_pager_clear(&pager->records);
+	as_vector_destroy(&pager->records);
+	pthread_mutex_destroy(&pager->lock);
+}
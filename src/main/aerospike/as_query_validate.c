@@ -16,14 +16,38 @@
  */
 #include <aerospike/as_query_validate.h>
 #include <aerospike/as_async.h>
+#include <aerospike/as_cluster.h>
 #include <aerospike/as_event.h>
 #include <aerospike/as_event_internal.h>
 #include <aerospike/as_info.h>
 #include <aerospike/as_node.h>
+#include <aerospike/as_proto.h>
+#include <citrusleaf/cf_byte_order.h>
 
 uint32_t
 as_query_get_info_timeout(as_event_executor* executor);
 
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_validate_begin_s;
+
+typedef struct as_validate_slot_s {
+	struct as_validate_begin_s* vb;
+	uint64_t cluster_key;
+} as_validate_slot;
+
+// Cluster-stable checks of all nodes sent in parallel when an async query starts.
+typedef struct as_validate_begin_s {
+	as_event_executor* executor;
+	as_error err;
+	uint32_t pending;
+	uint32_t failed;
+	uint32_t n_slots;
+	as_validate_slot slots[];
+} as_validate_begin;
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -68,43 +92,125 @@ as_parse_cluster_key(char* response, uint64_t* cluster_key)
 	return true;
 }
 
-static void
-as_validate_begin_listener(as_error* err, char* response, void* udata, as_event_loop* event_loop)
+static as_status
+as_validate_read(as_error* err, as_socket* sock, as_node* node, uint64_t deadline, char** response)
 {
-	as_event_command* cmd = udata;
-	as_event_executor* executor = cmd->udata;
+	as_proto proto;
+	as_status status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto),
+		0, deadline);
 
-	if (err) {
-		as_event_command_destroy(cmd);
-		as_event_executor_error(executor, err, executor->max);
-		return;
+	if (status) {
+		return status;
 	}
 
-	as_error e;
+	status = as_proto_parse_type(err, &proto, AS_INFO_MESSAGE_TYPE);
 
-	if (! as_parse_cluster_key(response, &executor->cluster_key)) {
-		as_parse_error(&e, response);
-		as_event_command_destroy(cmd);
-		as_event_executor_error(executor, &e, executor->max);
-		return;
+	if (status) {
+		return status;
 	}
 
-	uint32_t max_concurrent = executor->max_concurrent;
-	as_status status = as_event_command_execute(cmd, &e);
+	char* buf = cf_malloc(proto.sz + 1);
+	status = as_socket_read_deadline(err, sock, node, (uint8_t*)buf, proto.sz, 0, deadline);
 
-	if (status != AEROSPIKE_OK) {
-		// Command already destroyed.
-		as_event_executor_error(executor, &e, executor->max);
+	if (status) {
+		cf_free(buf);
+		return status;
+	}
+	buf[proto.sz] = 0;
+
+	char* message = NULL;
+	status = as_info_validate(buf, &message);
+
+	if (status) {
+		as_error_set_message(err, status, message);
+		cf_free(buf);
+		return status;
+	}
+
+	*response = buf;
+	return status;
+}
+
+static void
+as_validate_begin_error(as_validate_begin* vb, as_error* err)
+{
+	// Keep first error only.
+	if (as_fas_uint32(&vb->failed, 1) == 0) {
+		as_error_copy(&vb->err, err);
+	}
+}
+
+static void
+as_validate_begin_finish(as_validate_begin* vb)
+{
+	as_event_executor* executor = vb->executor;
+
+	if (! vb->failed) {
+		uint64_t cluster_key = vb->slots[0].cluster_key;
+
+		for (uint32_t i = 1; i < vb->n_slots; i++) {
+			if (vb->slots[i].cluster_key != cluster_key) {
+				as_cluster_key_error(&vb->err, cluster_key, vb->slots[i].cluster_key);
+				vb->failed = 1;
+				break;
+			}
+		}
+		executor->cluster_key = cluster_key;
+	}
+
+	if (vb->failed) {
+		as_error err;
+		as_error_copy(&err, &vb->err);
+		cf_free(vb);
+		// First command was counted as queued when validation started.
+		as_event_command_destroy(executor->commands[0]);
+		as_event_executor_error(executor, &err, executor->max);
 		return;
 	}
+	cf_free(vb);
+
+	// All nodes agree on the cluster key, so start commands without validating each node again.
+	uint32_t max_concurrent = executor->max_concurrent;
+	as_error err;
+
+	for (uint32_t i = 0; i < max_concurrent; i++) {
+		if (i > 0) {
+			executor->queued++;
+		}
 
-	for (uint32_t i = 1; i < max_concurrent; i++) {
-		if (as_query_validate_next_async(executor, i) != AEROSPIKE_OK) {
+		if (as_event_command_execute(executor->commands[i], &err) != AEROSPIKE_OK) {
+			// Command already destroyed.
+			as_event_executor_error(executor, &err, executor->max - i);
 			return;
 		}
 	}
 }
 
+static inline void
+as_validate_begin_release(as_validate_begin* vb)
+{
+	if (as_aaf_uint32(&vb->pending, -1) == 0) {
+		as_validate_begin_finish(vb);
+	}
+}
+
+static void
+as_validate_begin_listener(as_error* err, char* response, void* udata, as_event_loop* event_loop)
+{
+	as_validate_slot* slot = udata;
+	as_validate_begin* vb = slot->vb;
+
+	if (err) {
+		as_validate_begin_error(vb, err);
+	}
+	else if (! as_parse_cluster_key(response, &slot->cluster_key)) {
+		as_error e;
+		as_parse_error(&e, response);
+		as_validate_begin_error(vb, &e);
+	}
+	as_validate_begin_release(vb);
+}
+
 static void
 as_validate_next_listener(as_error* err, char* response, void* udata, as_event_loop* event_loop)
 {
@@ -201,6 +307,93 @@ as_query_validate_begin(
 	return status;
 }
 
+as_status
+as_query_validate_begin_nodes(
+	as_error* err, as_nodes* nodes, const as_namespace ns, uint32_t timeout,
+	uint64_t* cluster_key
+	)
+{
+	char cmd[256];
+	as_write_cluster_stable(cmd, sizeof(cmd), ns);
+
+	uint8_t buf[sizeof(as_proto) + sizeof(cmd)];
+	size_t len = strlen(cmd);
+	size_t size = sizeof(as_proto) + len;
+	uint64_t proto = len | ((uint64_t)AS_PROTO_VERSION << 56) |
+		((uint64_t)AS_INFO_MESSAGE_TYPE << 48);
+	*(uint64_t*)buf = cf_swap_to_be64(proto);
+	memcpy(buf + sizeof(as_proto), cmd, len);
+
+	// Send request to every node before reading any response, so all checks complete in
+	// about one round trip.
+	uint64_t deadline = as_socket_deadline(timeout);
+	as_socket* sockets = alloca(sizeof(as_socket) * nodes->size);
+	as_status status = AEROSPIKE_OK;
+	uint32_t n_sent = 0;
+
+	*cluster_key = 0;
+
+	for (; n_sent < nodes->size; n_sent++) {
+		as_node* node = nodes->array[n_sent];
+		status = as_node_get_connection(err, node, 0, deadline, &sockets[n_sent]);
+
+		if (status) {
+			break;
+		}
+
+		status = as_socket_write_deadline(err, &sockets[n_sent], node, buf, size, 0, deadline);
+
+		if (status) {
+			as_node_close_conn_error(node, &sockets[n_sent], sockets[n_sent].pool);
+			break;
+		}
+	}
+
+	// Read all sent requests, even after an error, so their connections can be reused.
+	for (uint32_t i = 0; i < n_sent; i++) {
+		as_node* node = nodes->array[i];
+		as_error e;
+		char* response = NULL;
+		as_status s = as_validate_read(&e, &sockets[i], node, deadline, &response);
+
+		if (s != AEROSPIKE_OK) {
+			as_node_close_conn_error(node, &sockets[i], sockets[i].pool);
+
+			if (status == AEROSPIKE_OK) {
+				as_error_copy(err, &e);
+
+				char str[512];
+				snprintf(str, sizeof(str), " from %s", as_node_get_address_string(node));
+				as_error_append(err, str);
+				status = s;
+			}
+			continue;
+		}
+
+		as_node_put_connection(node, &sockets[i]);
+
+		if (status == AEROSPIKE_OK) {
+			uint64_t key;
+
+			if (! as_parse_cluster_key(response, &key)) {
+				status = as_parse_error(err, response);
+			}
+			else if (*cluster_key == 0) {
+				*cluster_key = key;
+			}
+			else if (key != *cluster_key) {
+				status = as_cluster_key_error(err, *cluster_key, key);
+			}
+		}
+		cf_free(response);
+	}
+
+	if (status) {
+		*cluster_key = 0;
+	}
+	return status;
+}
+
 as_status
 as_query_validate(
 	as_error* err, as_node* node, const as_namespace ns, uint32_t timeout, uint64_t expected_key
@@ -237,20 +430,52 @@ as_query_validate_begin_async(as_event_executor* executor, const as_namespace ns
 	char info_cmd[256];
 	as_write_cluster_stable(info_cmd, sizeof(info_cmd), ns);
 
-	as_event_command* cmd = executor->commands[0];
-
-	// Reserve node again because the node will be released at end of async info processing.
-	// Node must be available for query.
-	as_node_reserve(cmd->node);
-
-	as_status status = as_info_command_node_async(NULL, err, &policy, cmd->node, info_cmd,
-												  as_validate_begin_listener, cmd, cmd->event_loop);
+	// Check all nodes in parallel.  Hold one extra reference while sending, so the checks
+	// can not finish before every request was sent.
+	uint32_t n = executor->max;
+	as_validate_begin* vb = cf_malloc(sizeof(as_validate_begin) + sizeof(as_validate_slot) * n);
+	vb->executor = executor;
+	vb->pending = n + 1;
+	vb->failed = 0;
+	vb->n_slots = n;
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_event_command* cmd = executor->commands[i];
+		as_validate_slot* slot = &vb->slots[i];
+		slot->vb = vb;
+		slot->cluster_key = 0;
+
+		// Reserve node again because the node will be released at end of async info
+		// processing. Node must be available for query.
+		as_node_reserve(cmd->node);
 
-	if (status != AEROSPIKE_OK) {
-		as_event_command_destroy(cmd);
-		as_event_executor_cancel(executor, 0);
+		as_error e;
+		as_status status = as_info_command_node_async(NULL, &e, &policy, cmd->node, info_cmd,
+			as_validate_begin_listener, slot, cmd->event_loop);
+
+		if (status != AEROSPIKE_OK) {
+			if (i == 0) {
+				// Nothing was sent, so fail the query call directly.
+				as_error_copy(err, &e);
+				cf_free(vb);
+				as_event_command_destroy(cmd);
+				as_event_executor_cancel(executor, 0);
+				return status;
+			}
+
+			// Requests that were not sent will never call the listener.  Release them
+			// together with the sender's reference.
+			as_validate_begin_error(vb, &e);
+
+			if (as_aaf_uint32(&vb->pending, -(int32_t)(n - i + 1)) == 0) {
+				as_validate_begin_finish(vb);
+			}
+			return AEROSPIKE_OK;
+		}
 	}
-	return status;
+
+	as_validate_begin_release(vb);
+	return AEROSPIKE_OK;
 }
 
 as_status
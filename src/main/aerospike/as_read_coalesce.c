@@ -0,0 +1,330 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_read_coalesce.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_FLIGHT_BUCKETS 64
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_flight_listener_s {
+	struct as_flight_listener_s* next;
+	as_read_flight_listener listener;
+	void* udata;
+} as_flight_listener;
+
+typedef struct as_flight_shard_s {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	as_read_flight* buckets[AS_FLIGHT_BUCKETS];
+	uint32_t size;
+} as_flight_shard;
+
+struct as_read_flight_s {
+	struct as_read_flight_s* next;
+	as_flight_shard* shard;
+	as_flight_listener* listeners;
+	uint8_t* response;
+	uint8_t* cmd;
+	uint64_t hash;
+	size_t cmd_size;
+	as_error err;
+	uint32_t response_size;
+	uint32_t ref_count; // Protected by shard lock.
+	as_status status;
+	bool done;
+};
+
+struct as_read_coalesce_s {
+	as_flight_shard shards[AS_READ_COALESCE_SHARDS];
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint64_t
+as_flight_hash(const uint8_t* cmd, size_t size)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < size; i++) {
+		h = (h ^ cmd[i]) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static inline as_read_flight**
+as_flight_bucket(as_flight_shard* shard, uint64_t hash)
+{
+	return &shard->buckets[(hash / AS_READ_COALESCE_SHARDS) & (AS_FLIGHT_BUCKETS - 1)];
+}
+
+static void
+as_flight_free(as_read_flight* flight)
+{
+	cf_free(flight->response);
+	cf_free(flight->cmd);
+	cf_free(flight);
+}
+
+static void
+as_flight_release(as_read_flight* flight, uint32_t n)
+{
+	as_flight_shard* shard = flight->shard;
+
+	pthread_mutex_lock(&shard->lock);
+	flight->ref_count -= n;
+	bool last = flight->ref_count == 0;
+	pthread_mutex_unlock(&shard->lock);
+
+	if (last) {
+		as_flight_free(flight);
+	}
+}
+
+static uint8_t*
+as_flight_response_copy(as_read_flight* flight)
+{
+	// Flight is done, so the response is no longer modified.
+	if (! flight->response) {
+		return NULL;
+	}
+
+	uint8_t* buf = cf_malloc(flight->response_size);
+	memcpy(buf, flight->response, flight->response_size);
+	return buf;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_read_coalesce*
+as_read_coalesce_create(void)
+{
+	as_read_coalesce* rc = cf_malloc(sizeof(as_read_coalesce));
+
+	for (uint32_t i = 0; i < AS_READ_COALESCE_SHARDS; i++) {
+		as_flight_shard* shard = &rc->shards[i];
+		pthread_mutex_init(&shard->lock, NULL);
+		pthread_cond_init(&shard->cond, NULL);
+		memset(shard->buckets, 0, sizeof(shard->buckets));
+		shard->size = 0;
+	}
+	return rc;
+}
+
+void
+as_read_coalesce_destroy(as_read_coalesce* rc)
+{
+	for (uint32_t i = 0; i < AS_READ_COALESCE_SHARDS; i++) {
+		as_flight_shard* shard = &rc->shards[i];
+		pthread_cond_destroy(&shard->cond);
+		pthread_mutex_destroy(&shard->lock);
+	}
+	cf_free(rc);
+}
+
+as_read_flight*
+as_read_coalesce_join(as_read_coalesce* rc, const uint8_t* cmd, size_t size, bool* leader)
+{
+	uint64_t hash = as_flight_hash(cmd, size);
+	as_flight_shard* shard = &rc->shards[hash & (AS_READ_COALESCE_SHARDS - 1)];
+	as_read_flight** pp = as_flight_bucket(shard, hash);
+
+	pthread_mutex_lock(&shard->lock);
+
+	for (as_read_flight* f = *pp; f; f = f->next) {
+		if (f->hash == hash && f->cmd_size == size && memcmp(f->cmd, cmd, size) == 0) {
+			f->ref_count++;
+			pthread_mutex_unlock(&shard->lock);
+			*leader = false;
+			return f;
+		}
+	}
+
+	as_read_flight* flight = cf_malloc(sizeof(as_read_flight));
+	flight->next = *pp;
+	flight->shard = shard;
+	flight->listeners = NULL;
+	flight->response = NULL;
+	flight->cmd = cf_malloc(size);
+	memcpy(flight->cmd, cmd, size);
+	flight->hash = hash;
+	flight->cmd_size = size;
+	as_error_init(&flight->err);
+	flight->response_size = 0;
+	flight->ref_count = 1;
+	flight->status = AEROSPIKE_OK;
+	flight->done = false;
+	*pp = flight;
+	shard->size++;
+
+	pthread_mutex_unlock(&shard->lock);
+	*leader = true;
+	return flight;
+}
+
+void
+as_read_flight_set_response(as_read_flight* flight, const uint8_t* buf, size_t size)
+{
+	// Retries may parse more than one response. Keep the last one.
+	cf_free(flight->response);
+	flight->response = cf_malloc(size);
+	memcpy(flight->response, buf, size);
+	flight->response_size = (uint32_t)size;
+}
+
+void
+as_read_flight_complete(as_read_flight* flight, as_error* err, as_status status)
+{
+	as_flight_shard* shard = flight->shard;
+
+	if (status != AEROSPIKE_OK && ! flight->response) {
+		as_error_copy(&flight->err, err);
+	}
+	flight->status = status;
+
+	pthread_mutex_lock(&shard->lock);
+
+	as_read_flight** pp = as_flight_bucket(shard, flight->hash);
+
+	while (*pp != flight) {
+		pp = &(*pp)->next;
+	}
+	*pp = flight->next;
+	shard->size--;
+	flight->done = true;
+
+	as_flight_listener* listeners = flight->listeners;
+	flight->listeners = NULL;
+
+	pthread_mutex_unlock(&shard->lock);
+	pthread_cond_broadcast(&shard->cond);
+
+	// Listeners hold a reference until they are called.
+	uint32_t n = 1;
+
+	while (listeners) {
+		as_flight_listener* next = listeners->next;
+		as_error e;
+		as_error_copy(&e, &flight->err);
+		listeners->listener(&e, flight->status, as_flight_response_copy(flight),
+			flight->response_size, listeners->udata);
+		cf_free(listeners);
+		listeners = next;
+		n++;
+	}
+	as_flight_release(flight, n);
+}
+
+as_status
+as_read_flight_wait(
+	as_read_flight* flight, as_error* err, uint32_t timeout_ms, uint8_t** buf, uint32_t* size
+	)
+{
+	as_flight_shard* shard = flight->shard;
+	struct timespec abstime;
+
+	if (timeout_ms > 0) {
+		struct timespec delta;
+		cf_clock_set_timespec_ms(timeout_ms, &delta);
+		cf_clock_current_add(&delta, &abstime);
+	}
+
+	pthread_mutex_lock(&shard->lock);
+
+	while (! flight->done) {
+		if (timeout_ms > 0) {
+			if (pthread_cond_timedwait(&shard->cond, &shard->lock, &abstime) != 0 &&
+				! flight->done) {
+				pthread_mutex_unlock(&shard->lock);
+
+				// The leader still owns the flight and completes it without this follower.
+				*buf = NULL;
+				*size = 0;
+				as_flight_release(flight, 1);
+				return as_error_update(err, AEROSPIKE_ERR_TIMEOUT,
+					"Client timeout waiting for coalesced read: timeout=%u", timeout_ms);
+			}
+		}
+		else {
+			pthread_cond_wait(&shard->cond, &shard->lock);
+		}
+	}
+	pthread_mutex_unlock(&shard->lock);
+
+	*buf = as_flight_response_copy(flight);
+	*size = flight->response_size;
+
+	as_status status = flight->status;
+
+	if (! *buf && status != AEROSPIKE_OK) {
+		as_error_copy(err, &flight->err);
+	}
+	as_flight_release(flight, 1);
+	return status;
+}
+
+void
+as_read_flight_listen(as_read_flight* flight, as_read_flight_listener listener, void* udata)
+{
+	as_flight_shard* shard = flight->shard;
+
+	pthread_mutex_lock(&shard->lock);
+
+	if (! flight->done) {
+		as_flight_listener* fl = cf_malloc(sizeof(as_flight_listener));
+		fl->next = flight->listeners;
+		fl->listener = listener;
+		fl->udata = udata;
+		flight->listeners = fl;
+		pthread_mutex_unlock(&shard->lock);
+		return;
+	}
+	pthread_mutex_unlock(&shard->lock);
+
+	as_error err;
+	as_error_copy(&err, &flight->err);
+	listener(&err, flight->status, as_flight_response_copy(flight), flight->response_size, udata);
+	as_flight_release(flight, 1);
+}
+
+uint32_t
+as_read_coalesce_size(as_read_coalesce* rc)
+{
+	uint32_t size = 0;
+
+	for (uint32_t i = 0; i < AS_READ_COALESCE_SHARDS; i++) {
+		as_flight_shard* shard = &rc->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		size += shard->size;
+		pthread_mutex_unlock(&shard->lock);
+	}
+	return size;
+}
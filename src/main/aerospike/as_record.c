@@ -14,6 +14,8 @@
  * License for the specific language governing permissions and limitations under
  * the License.
  */
+#include <aerospike/as_arena.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_bytes.h>
 #include <aerospike/as_double.h>
@@ -21,8 +23,10 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
 #include <aerospike/as_nil.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_serializer.h>
 #include <aerospike/as_string.h>
 #include <citrusleaf/alloc.h>
 #include <stdlib.h>
@@ -67,6 +71,7 @@ as_record_defaults(as_record* rec, bool free, uint16_t nbins)
 
 	rec->key._free = false;
 	rec->key.ns[0] = '\0';
+	rec->key.ns_id = 0;
 	rec->key.set[0] = '\0';
 	rec->key.valuep = NULL;
 
@@ -75,6 +80,10 @@ as_record_defaults(as_record* rec, bool free, uint16_t nbins)
 
 	rec->gen = 0;
 	rec->ttl = 0;
+	rec->buffer = NULL;
+	rec->lazy = false;
+	rec->arena = NULL;
+	rec->bins._block = false;
 
 	if ( nbins > 0 ) {
 		rec->bins._free = true;
@@ -122,10 +131,51 @@ as_record_bin_forupdate(as_record* rec, const as_bin_name name)
 	return NULL;
 }
 
+static as_bin*
+as_record_bin_forupdate_handle(as_record* rec, const as_bin_handle* handle)
+{
+	if ( ! (rec && handle) ) {
+		return NULL;
+	}
+
+	// Compare the name and its null terminator.
+	for(int i = 0; i < rec->bins.size; i++) {
+		if ( memcmp(rec->bins.entries[i].name, handle->name, handle->len + 1) == 0 ) {
+			as_val_destroy(rec->bins.entries[i].valuep);
+			rec->bins.entries[i].valuep = NULL;
+			return &rec->bins.entries[i];
+		}
+	}
+
+	if ( rec->bins.size < rec->bins.capacity ) {
+		return &rec->bins.entries[rec->bins.size++];
+	}
+
+	return NULL;
+}
+
 /******************************************************************************
  * INSTANCE FUNCTIONS
  *****************************************************************************/
 
+void
+as_record_free_entries(as_record* rec)
+{
+	if ( rec->bins.entries ) {
+		if ( rec->bins._free ) {
+			cf_free(rec->bins.entries);
+		}
+		else if ( rec->bins._block ) {
+			as_bin_block_release(((as_bin_block**)rec->bins.entries)[-1]);
+		}
+	}
+	rec->bins.entries = NULL;
+	rec->bins.capacity = 0;
+	rec->bins.size = 0;
+	rec->bins._free = false;
+	rec->bins._block = false;
+}
+
 void
 as_record_release(as_record* rec)
 {
@@ -136,13 +186,19 @@ as_record_release(as_record* rec)
 				as_val_destroy((as_val *) rec->bins.entries[i].valuep);
 				rec->bins.entries[i].valuep = NULL;
 			}
-			if ( rec->bins._free ) {
-				cf_free(rec->bins.entries);
-			}
 		}
-		rec->bins.entries = NULL;
-		rec->bins.capacity = 0;
-		rec->bins.size = 0;
+		as_record_free_entries(rec);
+
+		// Free response buffer and arena after bin values that may reference them.
+		if ( rec->buffer ) {
+			cf_free(rec->buffer);
+			rec->buffer = NULL;
+		}
+
+		if ( rec->arena ) {
+			as_arena_destroy(rec->arena);
+			rec->arena = NULL;
+		}
 
 		rec->key.ns[0] = '\0';
 		rec->key.set[0] = '\0';
@@ -157,9 +213,16 @@ as_record_release(as_record* rec)
 as_record*
 as_record_new(uint16_t nbins)
 {
-	as_record* rec = (as_record *) cf_malloc(sizeof(as_record));
+	// Bins are allocated together with the record and freed with it.
+	as_record* rec = (as_record *) cf_malloc(sizeof(as_record) + sizeof(as_bin) * nbins);
 	if ( !rec ) return rec;
-	return as_record_defaults(rec, true, nbins);
+	as_record_defaults(rec, true, 0);
+
+	if ( nbins > 0 ) {
+		rec->bins.capacity = nbins;
+		rec->bins.entries = (as_bin *) (rec + 1);
+	}
+	return rec;
 }
 
 as_record*
@@ -169,12 +232,74 @@ as_record_init(as_record* rec, uint16_t nbins)
 	return as_record_defaults(rec, false, nbins);
 }
 
+as_bin_block*
+as_bin_block_create(uint32_t n_records, uint32_t n_bins)
+{
+	// Reserve a back pointer before each record's bins.
+	size_t capacity = sizeof(as_bin_block*) * n_records + sizeof(as_bin) * n_bins;
+	as_bin_block* block = (as_bin_block *) cf_malloc(sizeof(as_bin_block) + capacity);
+	if ( !block ) return block;
+	block->ref_count = 1;
+	block->capacity = (uint32_t)capacity;
+	block->size = 0;
+	block->confined = false;
+	return block;
+}
+
+void
+as_bin_block_release(as_bin_block* block)
+{
+	uint32_t count = block->confined ? --block->ref_count : as_aaf_uint32(&block->ref_count, -1);
+
+	if ( count == 0 ) {
+		cf_free(block);
+	}
+}
+
+as_record*
+as_record_init_block(as_record* rec, as_bin_block* block, uint16_t nbins)
+{
+	size_t size = sizeof(as_bin_block*) + sizeof(as_bin) * nbins;
+
+	if ( !block || nbins == 0 || block->size + size > block->capacity ) {
+		return as_record_init(rec, nbins);
+	}
+
+	as_record_defaults(rec, false, 0);
+
+	uint8_t* p = (uint8_t *) (block + 1) + block->size;
+	*(as_bin_block**)p = block;
+	block->size += (uint32_t)size;
+
+	if ( block->confined ) {
+		block->ref_count++;
+	}
+	else {
+		as_incr_uint32(&block->ref_count);
+	}
+
+	rec->bins._block = true;
+	rec->bins.capacity = nbins;
+	rec->bins.entries = (as_bin *) (p + sizeof(as_bin_block*));
+	return rec;
+}
+
 void
 as_record_destroy(as_record* rec)
 {
 	as_rec_destroy((as_rec *) rec);
 }
 
+void
+as_record_share(as_record* rec)
+{
+	// Switch all records of the block to atomic reference counts. The caller publishes the
+	// change when it hands the record to the other thread.
+	if ( rec->bins._block ) {
+		((as_bin_block**)rec->bins.entries)[-1]->confined = false;
+	}
+}
+
 /******************************************************************************
  * VALUE FUNCTIONS
  *****************************************************************************/
@@ -198,6 +323,15 @@ as_record_set(as_record* rec, const as_bin_name name, as_bin_value* value)
 	return true;
 }
 
+bool
+as_record_set_handle(as_record* rec, const as_bin_handle* handle, as_bin_value* value)
+{
+	as_bin* bin = as_record_bin_forupdate_handle(rec, handle);
+	if ( !bin ) return false;
+	as_bin_init_handle(bin, handle, value);
+	return true;
+}
+
 bool
 as_record_set_bool(as_record* rec, const as_bin_name name, bool value)
 {
@@ -336,12 +470,58 @@ as_record_set_nil(as_record* rec, const as_bin_name name)
  * GETTER FUNCTIONS
  *****************************************************************************/
 
+as_bin_value*
+as_record_bin_value(const as_record* rec, as_bin* bin)
+{
+	if (! (rec->lazy && bin->valuep == &bin->value &&
+		as_val_type((as_val*)&bin->value) == AS_BYTES)) {
+		return bin->valuep;
+	}
+
+	as_bytes* bytes = &bin->value.bytes;
+
+	if (bytes->type != AS_BYTES_LIST && bytes->type != AS_BYTES_MAP) {
+		return bin->valuep;
+	}
+
+	as_buffer buffer;
+	buffer.data = bytes->value;
+	buffer.size = bytes->size;
+
+	as_val* value = NULL;
+	as_serializer ser;
+	as_msgpack_init(&ser);
+	int rv = as_serializer_deserialize(&ser, &buffer, &value);
+	as_serializer_destroy(&ser);
+
+	if (rv != 0) {
+		// Leave raw bytes in place.
+		return bin->valuep;
+	}
+
+	// Raw bytes are either copied or reference the record's response buffer.
+	as_val_destroy((as_val*)bytes);
+	bin->valuep = (as_bin_value*)value;
+	return bin->valuep;
+}
+
 as_bin_value*
 as_record_get(const as_record* rec, const as_bin_name name)
 {
 	for(int i=0; i<rec->bins.size; i++) {
 		if ( strcmp(rec->bins.entries[i].name, name) == 0 ) {
-			return (as_bin_value *) rec->bins.entries[i].valuep;
+			return as_record_bin_value(rec, &rec->bins.entries[i]);
+		}
+	}
+	return NULL;
+}
+
+as_bin_value*
+as_record_get_handle(const as_record* rec, const as_bin_handle* handle)
+{
+	for(int i=0; i<rec->bins.size; i++) {
+		if ( memcmp(rec->bins.entries[i].name, handle->name, handle->len + 1) == 0 ) {
+			return as_record_bin_value(rec, &rec->bins.entries[i]);
 		}
 	}
 	return NULL;
@@ -439,6 +619,131 @@ as_record_get_map(const as_record* rec, const as_bin_name name)
 	return as_map_fromval((as_val *) as_record_get(rec, name));
 }
 
+static as_list*
+as_record_get_array(const as_record* rec, const as_bin_name name, as_bytes** raw)
+{
+	// Do not deserialize lazy bins. Raw list bytes are decoded by the caller.
+	*raw = NULL;
+
+	for (int i = 0; i < rec->bins.size; i++) {
+		if (strcmp(rec->bins.entries[i].name, name) == 0) {
+			as_val* v = (as_val*)rec->bins.entries[i].valuep;
+
+			if (v && as_val_type(v) == AS_BYTES && ((as_bytes*)v)->type == AS_BYTES_LIST) {
+				*raw = (as_bytes*)v;
+				return NULL;
+			}
+			return as_list_fromval(v);
+		}
+	}
+	return NULL;
+}
+
+bool
+as_record_get_int64_array(
+	const as_record* rec, const as_bin_name name, int64_t* values, uint32_t capacity,
+	uint32_t* size
+	)
+{
+	as_bytes* raw;
+	as_list* list = as_record_get_array(rec, name, &raw);
+
+	if (raw) {
+		return as_msgpack_unpack_int64_array(raw->value, raw->size, values, capacity, size) ==
+			AS_MSGPACK_ARRAY_OK;
+	}
+
+	*size = list ? as_list_size(list) : 0;
+
+	if (! list || *size > capacity) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < *size; i++) {
+		as_integer* v = as_integer_fromval(as_list_get(list, i));
+
+		if (! v) {
+			return false;
+		}
+		values[i] = v->value;
+	}
+	return true;
+}
+
+bool
+as_record_get_double_array(
+	const as_record* rec, const as_bin_name name, double* values, uint32_t capacity,
+	uint32_t* size
+	)
+{
+	as_bytes* raw;
+	as_list* list = as_record_get_array(rec, name, &raw);
+
+	if (raw) {
+		return as_msgpack_unpack_double_array(raw->value, raw->size, values, capacity, size) ==
+			AS_MSGPACK_ARRAY_OK;
+	}
+
+	*size = list ? as_list_size(list) : 0;
+
+	if (! list || *size > capacity) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < *size; i++) {
+		as_double* v = as_double_fromval(as_list_get(list, i));
+
+		if (! v) {
+			return false;
+		}
+		values[i] = v->value;
+	}
+	return true;
+}
+
+bool
+as_record_get_bytes_array(
+	const as_record* rec, const as_bin_name name, as_bytes_view* values, uint32_t capacity,
+	uint32_t* size
+	)
+{
+	as_bytes* raw;
+	as_list* list = as_record_get_array(rec, name, &raw);
+
+	if (raw) {
+		return as_msgpack_unpack_bytes_array(raw->value, raw->size, values, capacity, size) ==
+			AS_MSGPACK_ARRAY_OK;
+	}
+
+	*size = list ? as_list_size(list) : 0;
+
+	if (! list || *size > capacity) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < *size; i++) {
+		as_val* v = as_list_get(list, i);
+		as_val_t type = v ? as_val_type(v) : AS_UNDEF;
+
+		if (type == AS_STRING) {
+			as_string* s = (as_string*)v;
+			values[i].value = (const uint8_t*)s->value;
+			values[i].size = (uint32_t)as_string_len(s);
+			values[i].type = AS_BYTES_STRING;
+		}
+		else if (type == AS_BYTES) {
+			as_bytes* b = (as_bytes*)v;
+			values[i].value = b->value;
+			values[i].size = b->size;
+			values[i].type = b->type;
+		}
+		else {
+			return false;
+		}
+	}
+	return true;
+}
+
 as_val*
 as_record_get_udf_result(const as_record* rec)
 {
@@ -460,7 +765,9 @@ as_record_foreach(const as_record* rec, as_rec_foreach_callback callback, void*
 {
 	if ( rec->bins.entries ) {
 		for ( int i = 0; i < rec->bins.size; i++ ) {
-			if ( callback(rec->bins.entries[i].name, (as_val *) rec->bins.entries[i].valuep, udata) == false ) {
+			as_val* value = (as_val *) as_record_bin_value(rec, &rec->bins.entries[i]);
+
+			if ( callback(rec->bins.entries[i].name, value, udata) == false ) {
 				return false;
 			}
 		}
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_record_cache.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_memory.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_cache_entry_s {
+	struct as_cache_entry_s* next;
+	struct as_cache_entry_s* lru_prev;
+	struct as_cache_entry_s* lru_next;
+	uint64_t expiration;
+	uint32_t size;
+	uint32_t gen;
+	as_digest_value digest;
+	as_namespace ns;
+	uint8_t data[];
+} as_cache_entry;
+
+typedef struct as_cache_shard_s {
+	pthread_mutex_t lock;
+	as_cache_entry** buckets;
+	as_cache_entry* lru_head; // Most recently used.
+	as_cache_entry* lru_tail; // Least recently used.
+	uint64_t version;
+	uint32_t n_buckets;
+	uint32_t size;
+	uint32_t max_size;
+} as_cache_shard;
+
+struct as_record_cache_s {
+	as_cache_shard shards[AS_RECORD_CACHE_SHARDS];
+	uint64_t ttl_ms;
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint64_t
+as_cache_hash(const uint8_t* digest)
+{
+	// Digests are already uniformly distributed.
+	uint64_t h;
+	memcpy(&h, digest, sizeof(h));
+	return h;
+}
+
+static inline as_cache_shard*
+as_cache_shard_get(as_record_cache* cache, const uint8_t* digest)
+{
+	return &cache->shards[as_cache_hash(digest) & (AS_RECORD_CACHE_SHARDS - 1)];
+}
+
+static inline as_cache_entry**
+as_cache_bucket(as_cache_shard* shard, const uint8_t* digest)
+{
+	uint64_t h = as_cache_hash(digest) / AS_RECORD_CACHE_SHARDS;
+	return &shard->buckets[h & (shard->n_buckets - 1)];
+}
+
+static as_cache_entry**
+as_cache_find(as_cache_shard* shard, const char* ns, const uint8_t* digest)
+{
+	as_cache_entry** pp = as_cache_bucket(shard, digest);
+
+	while (*pp) {
+		as_cache_entry* e = *pp;
+
+		if (memcmp(e->digest, digest, AS_DIGEST_VALUE_SIZE) == 0 && strcmp(e->ns, ns) == 0) {
+			return pp;
+		}
+		pp = &e->next;
+	}
+	return pp;
+}
+
+static inline void
+as_cache_lru_unlink(as_cache_shard* shard, as_cache_entry* e)
+{
+	if (e->lru_prev) {
+		e->lru_prev->lru_next = e->lru_next;
+	}
+	else {
+		shard->lru_head = e->lru_next;
+	}
+
+	if (e->lru_next) {
+		e->lru_next->lru_prev = e->lru_prev;
+	}
+	else {
+		shard->lru_tail = e->lru_prev;
+	}
+}
+
+static inline void
+as_cache_lru_push(as_cache_shard* shard, as_cache_entry* e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = shard->lru_head;
+
+	if (shard->lru_head) {
+		shard->lru_head->lru_prev = e;
+	}
+	else {
+		shard->lru_tail = e;
+	}
+	shard->lru_head = e;
+}
+
+static inline void
+as_cache_entry_free(as_cache_entry* e)
+{
+	as_memory_sub(AS_MEMORY_CACHE, sizeof(as_cache_entry) + e->size);
+	cf_free(e);
+}
+
+static void
+as_cache_unlink(as_cache_shard* shard, as_cache_entry** pp)
+{
+	as_cache_entry* e = *pp;
+	*pp = e->next;
+	as_cache_lru_unlink(shard, e);
+	shard->size--;
+	as_cache_entry_free(e);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_record_cache*
+as_record_cache_create(uint32_t max_records, uint32_t ttl_ms)
+{
+	as_record_cache* cache = cf_malloc(sizeof(as_record_cache));
+	cache->ttl_ms = ttl_ms;
+
+	uint32_t max_size = (max_records + AS_RECORD_CACHE_SHARDS - 1) / AS_RECORD_CACHE_SHARDS;
+	uint32_t n_buckets = 16;
+
+	if (max_size == 0) {
+		max_size = 1;
+	}
+
+	while (n_buckets < max_size) {
+		n_buckets <<= 1;
+	}
+
+	for (uint32_t i = 0; i < AS_RECORD_CACHE_SHARDS; i++) {
+		as_cache_shard* shard = &cache->shards[i];
+		pthread_mutex_init(&shard->lock, NULL);
+		shard->buckets = cf_calloc(n_buckets, sizeof(as_cache_entry*));
+		shard->lru_head = NULL;
+		shard->lru_tail = NULL;
+		shard->version = 0;
+		shard->n_buckets = n_buckets;
+		shard->size = 0;
+		shard->max_size = max_size;
+	}
+	return cache;
+}
+
+void
+as_record_cache_destroy(as_record_cache* cache)
+{
+	for (uint32_t i = 0; i < AS_RECORD_CACHE_SHARDS; i++) {
+		as_cache_shard* shard = &cache->shards[i];
+		as_cache_entry* e = shard->lru_head;
+
+		while (e) {
+			as_cache_entry* next = e->lru_next;
+			as_cache_entry_free(e);
+			e = next;
+		}
+		cf_free(shard->buckets);
+		pthread_mutex_destroy(&shard->lock);
+	}
+	cf_free(cache);
+}
+
+uint64_t
+as_record_cache_version(as_record_cache* cache, const uint8_t* digest)
+{
+	as_cache_shard* shard = as_cache_shard_get(cache, digest);
+
+	pthread_mutex_lock(&shard->lock);
+	uint64_t version = shard->version;
+	pthread_mutex_unlock(&shard->lock);
+	return version;
+}
+
+bool
+as_record_cache_get(
+	as_record_cache* cache, const char* ns, const uint8_t* digest, uint8_t** buf,
+	uint32_t* size, uint32_t* gen
+	)
+{
+	as_cache_shard* shard = as_cache_shard_get(cache, digest);
+
+	pthread_mutex_lock(&shard->lock);
+
+	as_cache_entry** pp = as_cache_find(shard, ns, digest);
+	as_cache_entry* e = *pp;
+
+	if (! e) {
+		pthread_mutex_unlock(&shard->lock);
+		return false;
+	}
+
+	if (cf_getms() >= e->expiration) {
+		as_cache_unlink(shard, pp);
+		pthread_mutex_unlock(&shard->lock);
+		return false;
+	}
+
+	as_cache_lru_unlink(shard, e);
+	as_cache_lru_push(shard, e);
+
+	*buf = cf_malloc(e->size);
+	memcpy(*buf, e->data, e->size);
+	*size = e->size;
+	*gen = e->gen;
+
+	pthread_mutex_unlock(&shard->lock);
+	return true;
+}
+
+void
+as_record_cache_put(
+	as_record_cache* cache, const char* ns, const uint8_t* digest, const uint8_t* buf,
+	uint32_t size, uint32_t gen, uint64_t version
+	)
+{
+	as_cache_shard* shard = as_cache_shard_get(cache, digest);
+
+	// Copy response before taking the lock.
+	as_cache_entry* e = cf_malloc(sizeof(as_cache_entry) + size);
+	as_memory_add(AS_MEMORY_CACHE, sizeof(as_cache_entry) + size);
+	e->expiration = cf_getms() + cache->ttl_ms;
+	e->size = size;
+	e->gen = gen;
+	memcpy(e->digest, digest, AS_DIGEST_VALUE_SIZE);
+	as_strncpy(e->ns, ns, sizeof(e->ns));
+	memcpy(e->data, buf, size);
+
+	pthread_mutex_lock(&shard->lock);
+
+	if (shard->version != version) {
+		// A local write to this shard started after the read was sent.
+		pthread_mutex_unlock(&shard->lock);
+		as_cache_entry_free(e);
+		return;
+	}
+
+	as_cache_entry** pp = as_cache_find(shard, ns, digest);
+
+	if (*pp) {
+		as_cache_unlink(shard, pp);
+		pp = as_cache_find(shard, ns, digest);
+	}
+	else if (shard->size >= shard->max_size) {
+		// Evict least recently used record.
+		as_cache_entry* lru = shard->lru_tail;
+		as_cache_unlink(shard, as_cache_find(shard, lru->ns, lru->digest));
+		pp = as_cache_find(shard, ns, digest);
+	}
+
+	e->next = NULL;
+	*pp = e;
+	as_cache_lru_push(shard, e);
+	shard->size++;
+
+	pthread_mutex_unlock(&shard->lock);
+}
+
+void
+as_record_cache_touch(as_record_cache* cache, const char* ns, const uint8_t* digest)
+{
+	as_cache_shard* shard = as_cache_shard_get(cache, digest);
+
+	pthread_mutex_lock(&shard->lock);
+
+	as_cache_entry* e = *as_cache_find(shard, ns, digest);
+
+	if (e) {
+		e->expiration = cf_getms() + cache->ttl_ms;
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+}
+
+void
+as_record_cache_remove(as_record_cache* cache, const char* ns, const uint8_t* digest)
+{
+	as_cache_shard* shard = as_cache_shard_get(cache, digest);
+
+	pthread_mutex_lock(&shard->lock);
+
+	shard->version++;
+
+	as_cache_entry** pp = as_cache_find(shard, ns, digest);
+
+	if (*pp) {
+		as_cache_unlink(shard, pp);
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+}
+
+uint32_t
+as_record_cache_size(as_record_cache* cache)
+{
+	uint32_t size = 0;
+
+	for (uint32_t i = 0; i < AS_RECORD_CACHE_SHARDS; i++) {
+		as_cache_shard* shard = &cache->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		size += shard->size;
+		pthread_mutex_unlock(&shard->lock);
+	}
+	return size;
+}
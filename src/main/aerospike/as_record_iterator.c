@@ -80,8 +80,11 @@ as_record_iterator_has_next(const as_record_iterator* iterator)
 as_bin*
 as_record_iterator_next(as_record_iterator* iterator)
 {
-	return iterator && 
-		iterator->record && 
-		iterator->record->bins.size > iterator->pos ? 
-		&iterator->record->bins.entries[iterator->pos++] : NULL;
+	if ( ! (iterator && iterator->record && iterator->record->bins.size > iterator->pos) ) {
+		return NULL;
+	}
+
+	as_bin* bin = &iterator->record->bins.entries[iterator->pos++];
+	as_record_bin_value(iterator->record, bin);
+	return bin;
 }
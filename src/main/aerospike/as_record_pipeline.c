@@ -0,0 +1,243 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_record_pipeline.h>
+#include <citrusleaf/alloc.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	as_record_pipeline_block* block;
+	as_msg* msg;
+} as_record_pipeline_item;
+
+typedef struct {
+	as_record_pipeline* pl;
+	cf_queue* queue;
+} as_record_pipeline_thread;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_record_pipeline_fail(as_record_pipeline* pl, as_status status, as_error* err)
+{
+	if (as_fas_uint32(&pl->error, 1) == 0) {
+		pl->status = status;
+
+		if (err->code == status) {
+			as_error_copy(&pl->err, err);
+		}
+	}
+}
+
+static void*
+as_record_pipeline_run(void* data)
+{
+	as_record_pipeline_thread* thread = data;
+	as_record_pipeline* pl = thread->pl;
+	cf_queue* queue = thread->queue;
+	cf_free(thread);
+
+	as_record_pipeline_item item;
+	as_error err;
+
+	while (cf_queue_pop(queue, &item, CF_QUEUE_FOREVER) == CF_QUEUE_OK) {
+		if (! item.block) {
+			// Shutdown.
+			break;
+		}
+
+		// Skip remaining records after the first failure.
+		if (! as_record_pipeline_failed(pl)) {
+			as_error_reset(&err);
+			as_status status = pl->parse_fn(pl->udata, item.msg, (uint8_t*)item.msg + sizeof(as_msg),
+				&err);
+
+			if (status != AEROSPIKE_OK) {
+				as_record_pipeline_fail(pl, status, &err);
+			}
+		}
+		as_record_pipeline_release(pl, item.block);
+	}
+	return NULL;
+}
+
+static void
+as_record_pipeline_stop(as_record_pipeline* pl, uint32_t n_threads)
+{
+	as_record_pipeline_item item = {NULL, NULL};
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		cf_queue_push(pl->queues[i], &item);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		pthread_join(pl->threads[i], NULL);
+	}
+
+	for (uint32_t i = 0; i < pl->n_threads; i++) {
+		cf_queue_destroy(pl->queues[i]);
+	}
+
+	for (uint32_t i = 0; i < pl->n_blocks; i++) {
+		cf_free(pl->blocks[i].buf);
+	}
+
+	cf_free(pl->threads);
+	cf_free(pl->queues);
+	cf_free(pl->blocks);
+	cf_free(pl->free_blocks);
+	pthread_cond_destroy(&pl->cond);
+	pthread_mutex_destroy(&pl->lock);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+int
+as_record_pipeline_init(
+	as_record_pipeline* pl, uint32_t n_threads, as_record_pipeline_parse_fn parse_fn, void* udata
+	)
+{
+	pl->parse_fn = parse_fn;
+	pl->udata = udata;
+	pl->n_threads = n_threads;
+	pl->n_blocks = n_threads * AS_RECORD_PIPELINE_BLOCKS_PER_THREAD;
+	pl->n_free = pl->n_blocks;
+	pl->status = AEROSPIKE_OK;
+	pl->error = 0;
+	as_error_init(&pl->err);
+	pthread_mutex_init(&pl->lock, NULL);
+	pthread_cond_init(&pl->cond, NULL);
+
+	pl->blocks = cf_malloc(sizeof(as_record_pipeline_block) * pl->n_blocks);
+	pl->free_blocks = cf_malloc(sizeof(as_record_pipeline_block*) * pl->n_blocks);
+
+	for (uint32_t i = 0; i < pl->n_blocks; i++) {
+		as_record_pipeline_block* block = &pl->blocks[i];
+		block->buf = NULL;
+		block->capacity = 0;
+		block->refs = 0;
+		pl->free_blocks[i] = block;
+	}
+
+	pl->threads = cf_malloc(sizeof(pthread_t) * n_threads);
+	pl->queues = cf_malloc(sizeof(cf_queue*) * n_threads);
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		pl->queues[i] = cf_queue_create(sizeof(as_record_pipeline_item), true);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		as_record_pipeline_thread* thread = cf_malloc(sizeof(as_record_pipeline_thread));
+		thread->pl = pl;
+		thread->queue = pl->queues[i];
+
+		int rc = pthread_create(&pl->threads[i], NULL, as_record_pipeline_run, thread);
+
+		if (rc) {
+			cf_free(thread);
+			as_record_pipeline_stop(pl, i);
+			return rc;
+		}
+	}
+	return 0;
+}
+
+void
+as_record_pipeline_destroy(as_record_pipeline* pl)
+{
+	as_record_pipeline_stop(pl, pl->n_threads);
+}
+
+as_record_pipeline_block*
+as_record_pipeline_copy(as_record_pipeline* pl, const uint8_t* buf, size_t size)
+{
+	// Block reader until parse threads free a block.  This bounds memory and applies
+	// back pressure to the server when callbacks are slow.
+	pthread_mutex_lock(&pl->lock);
+
+	while (pl->n_free == 0) {
+		pthread_cond_wait(&pl->cond, &pl->lock);
+	}
+
+	as_record_pipeline_block* block = pl->free_blocks[--pl->n_free];
+	pthread_mutex_unlock(&pl->lock);
+
+	if (size > block->capacity) {
+		cf_free(block->buf);
+		block->capacity = (size + 16383) & ~16383; // Round up in 16KB increments.
+		block->buf = cf_malloc(block->capacity);
+	}
+
+	memcpy(block->buf, buf, size);
+	block->refs = 1;
+	return block;
+}
+
+void
+as_record_pipeline_push(
+	as_record_pipeline* pl, as_record_pipeline_block* block, as_msg* msg, uint32_t part_id
+	)
+{
+	as_incr_uint32(&block->refs);
+
+	as_record_pipeline_item item = {block, msg};
+	cf_queue_push(pl->queues[part_id % pl->n_threads], &item);
+}
+
+void
+as_record_pipeline_release(as_record_pipeline* pl, as_record_pipeline_block* block)
+{
+	if (as_aaf_uint32(&block->refs, -1) != 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&pl->lock);
+	pl->free_blocks[pl->n_free++] = block;
+	pthread_cond_broadcast(&pl->cond);
+	pthread_mutex_unlock(&pl->lock);
+}
+
+void
+as_record_pipeline_drain(as_record_pipeline* pl)
+{
+	pthread_mutex_lock(&pl->lock);
+
+	while (pl->n_free < pl->n_blocks) {
+		pthread_cond_wait(&pl->cond, &pl->lock);
+	}
+	pthread_mutex_unlock(&pl->lock);
+}
+
+as_status
+as_record_pipeline_status(as_record_pipeline* pl, as_error* err)
+{
+	if (! as_record_pipeline_failed(pl)) {
+		return AEROSPIKE_OK;
+	}
+
+	if (pl->err.code == pl->status) {
+		as_error_copy(err, &pl->err);
+	}
+	return pl->status;
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_record_raw.h>
+#include <aerospike/as_command.h>
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_val*
+as_bin_raw_to_val(const as_bin_raw* bin)
+{
+	as_val* val = NULL;
+	as_command_parse_value((uint8_t*)bin->value, bin->type, bin->value_size, &val);
+	return val;
+}
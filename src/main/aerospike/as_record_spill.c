@@ -0,0 +1,347 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_record_spill.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(_MSC_VER)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_SPILL_MIN_CAPACITY (64 * 1024)
+
+// File mappings grow in large steps, because each step remaps the file.
+#define AS_SPILL_FILE_STEP (64 * 1024 * 1024)
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint64_t
+as_spill_next_capacity(uint64_t capacity, uint64_t needed, uint64_t min)
+{
+	uint64_t cap = (capacity > min) ? capacity : min;
+
+	while (cap < needed) {
+		cap *= 2;
+	}
+	return cap;
+}
+
+#if !defined(_MSC_VER)
+
+static as_status
+as_spill_map(as_record_spill* spill, as_error* err, uint64_t needed)
+{
+	// Must hold lock.
+	uint64_t capacity = as_spill_next_capacity(spill->spilled ? spill->capacity : 0, needed,
+		AS_SPILL_FILE_STEP);
+
+	if (! spill->spilled) {
+		char path[sizeof(spill->dir) + 32];
+		snprintf(path, sizeof(path), "%s/aerospike-spill-XXXXXX", spill->dir);
+
+		int fd = mkstemp(path);
+
+		if (fd < 0) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to create %s: %s",
+				path, strerror(errno));
+		}
+
+		// File is removed when the last descriptor is closed.
+		unlink(path);
+		spill->fd = fd;
+	}
+
+	if (ftruncate(spill->fd, (off_t)capacity) != 0) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to grow spill file: %s",
+			strerror(errno));
+	}
+
+	uint8_t* data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, spill->fd, 0);
+
+	if (data == MAP_FAILED) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to map spill file: %s",
+			strerror(errno));
+	}
+
+	if (spill->spilled) {
+		munmap(spill->data, spill->capacity);
+	}
+	else {
+		// Move heap records to the file and release the heap buffer.
+		if (spill->size > 0) {
+			memcpy(data, spill->data, spill->size);
+		}
+		cf_free(spill->data);
+		spill->spilled = true;
+	}
+
+	spill->data = data;
+	spill->capacity = capacity;
+	return AEROSPIKE_OK;
+}
+
+#endif
+
+static as_status
+as_spill_reserve(as_record_spill* spill, as_error* err, uint64_t size)
+{
+	// Must hold lock.
+	uint64_t needed = spill->size + size;
+
+	if (needed <= spill->capacity) {
+		return AEROSPIKE_OK;
+	}
+
+#if !defined(_MSC_VER)
+	if (spill->spilled || needed > spill->memory_limit) {
+		return as_spill_map(spill, err, needed);
+	}
+#endif
+
+	uint64_t capacity = as_spill_next_capacity(spill->capacity, needed, AS_SPILL_MIN_CAPACITY);
+	spill->data = cf_realloc(spill->data, capacity);
+	spill->capacity = capacity;
+	return AEROSPIKE_OK;
+}
+
+static inline uint8_t*
+as_spill_write_header(
+	uint8_t* p, uint32_t size, const uint8_t* digest, uint16_t gen, uint32_t ttl,
+	uint16_t n_bins
+	)
+{
+	*(uint32_t*)p = cf_swap_to_be32(size - 4);
+	p += sizeof(uint32_t);
+	memcpy(p, digest, AS_DIGEST_VALUE_SIZE);
+	p += AS_DIGEST_VALUE_SIZE;
+	*(uint16_t*)p = cf_swap_to_be16(gen);
+	p += sizeof(uint16_t);
+	*(uint32_t*)p = cf_swap_to_be32(ttl);
+	p += sizeof(uint32_t);
+	*(uint16_t*)p = cf_swap_to_be16(n_bins);
+	p += sizeof(uint16_t);
+	return p;
+}
+
+static as_status
+as_spill_add_record(
+	as_record_spill* spill, as_error* err, const uint8_t* digest, const as_record* rec
+	)
+{
+	const as_bins* bins = &rec->bins;
+	as_queue buffers;
+	as_queue_inita(&buffers, sizeof(as_buffer), bins->size);
+
+	size_t bins_size = 0;
+
+	for (uint16_t i = 0; i < bins->size; i++) {
+		bins_size += as_command_bin_size(&bins->entries[i], &buffers);
+	}
+
+	uint32_t size = AS_RECORD_SPILL_HEADER_SIZE + (uint32_t)bins_size;
+
+	pthread_mutex_lock(&spill->lock);
+
+	as_status status = as_spill_reserve(spill, err, size);
+
+	if (status == AEROSPIKE_OK) {
+		uint8_t* p = as_spill_write_header(spill->data + spill->size, size, digest, rec->gen,
+			rec->ttl, bins->size);
+
+		for (uint16_t i = 0; i < bins->size; i++) {
+			p = as_command_write_bin(p, AS_OPERATOR_READ, &bins->entries[i], &buffers);
+		}
+		spill->size += size;
+		spill->n_records++;
+	}
+
+	pthread_mutex_unlock(&spill->lock);
+	as_buffers_destroy(&buffers);
+	return status;
+}
+
+static bool
+as_spill_failed(as_record_spill* spill, as_error* err)
+{
+	pthread_mutex_lock(&spill->lock);
+
+	bool first = spill->err.code == AEROSPIKE_OK;
+
+	if (first) {
+		as_error_copy(&spill->err, err);
+	}
+
+	pthread_mutex_unlock(&spill->lock);
+	return first;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_record_spill_init(as_record_spill* spill, const char* dir, uint64_t memory_limit)
+{
+	if (! dir) {
+		dir = getenv("TMPDIR");
+
+		if (! dir || ! *dir) {
+			dir = "/tmp";
+		}
+	}
+
+	as_error_init(&spill->err);
+	spill->n_records = 0;
+	spill->size = 0;
+	spill->spilled = false;
+	pthread_mutex_init(&spill->lock, NULL);
+	spill->data = NULL;
+	spill->capacity = 0;
+	spill->memory_limit = memory_limit;
+	spill->fd = -1;
+	as_strncpy(spill->dir, dir, sizeof(spill->dir));
+}
+
+void
+as_record_spill_destroy(as_record_spill* spill)
+{
+#if !defined(_MSC_VER)
+	if (spill->spilled) {
+		munmap(spill->data, spill->capacity);
+		close(spill->fd);
+	}
+	else {
+		cf_free(spill->data);
+	}
+#else
+	cf_free(spill->data);
+#endif
+	pthread_mutex_destroy(&spill->lock);
+}
+
+as_status
+as_record_spill_add_raw(as_record_spill* spill, as_error* err, const as_record_raw* rec)
+{
+	const uint8_t* end = rec->bins;
+
+	for (uint16_t i = 0; i < rec->n_bins; i++) {
+		end += cf_swap_from_be32(*(uint32_t*)end) + 4;
+	}
+
+	uint32_t bins_size = (uint32_t)(end - rec->bins);
+	uint32_t size = AS_RECORD_SPILL_HEADER_SIZE + bins_size;
+
+	pthread_mutex_lock(&spill->lock);
+
+	as_status status = as_spill_reserve(spill, err, size);
+
+	if (status == AEROSPIKE_OK) {
+		uint8_t* p = as_spill_write_header(spill->data + spill->size, size, rec->digest.value,
+			rec->gen, rec->ttl, rec->n_bins);
+		memcpy(p, rec->bins, bins_size);
+		spill->size += size;
+		spill->n_records++;
+	}
+
+	pthread_mutex_unlock(&spill->lock);
+	return status;
+}
+
+as_status
+as_record_spill_add(as_record_spill* spill, as_error* err, as_record* rec)
+{
+	as_status status = as_key_set_digest(err, &rec->key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+	return as_spill_add_record(spill, err, rec->key.digest.value, rec);
+}
+
+bool
+as_record_spill_scan_callback(const as_record_raw* rec, void* udata)
+{
+	if (! rec) {
+		return true;
+	}
+
+	as_record_spill* spill = udata;
+	as_error err;
+
+	if (as_record_spill_add_raw(spill, &err, rec) != AEROSPIKE_OK) {
+		as_spill_failed(spill, &err);
+		return false;
+	}
+	return true;
+}
+
+void
+as_record_spill_batch_listener(as_batch_base_record* record, uint32_t index, void* udata)
+{
+	(void)index;
+
+	if (record->result != AEROSPIKE_OK) {
+		return;
+	}
+
+	as_record_spill* spill = udata;
+
+	if (as_load_uint32((uint32_t*)&spill->err.code) != AEROSPIKE_OK) {
+		return;
+	}
+
+	// Batch records hold the key separately from the record.
+	as_error err;
+	as_status status = as_key_set_digest(&err, &record->key);
+
+	if (status == AEROSPIKE_OK) {
+		status = as_spill_add_record(spill, &err, record->key.digest.value, &record->record);
+	}
+
+	if (status != AEROSPIKE_OK) {
+		as_spill_failed(spill, &err);
+	}
+}
+
+void
+as_record_spill_iterator_init(as_record_spill_iterator* it, as_record_spill* spill)
+{
+	pthread_mutex_lock(&spill->lock);
+	it->p = spill->data;
+	it->end = spill->data + spill->size;
+
+#if !defined(_MSC_VER)
+	if (spill->spilled) {
+		madvise(spill->data, spill->capacity, MADV_SEQUENTIAL);
+	}
+#endif
+
+	pthread_mutex_unlock(&spill->lock);
+}
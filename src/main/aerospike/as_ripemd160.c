@@ -0,0 +1,415 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_ripemd160.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AS_RIPEMD160_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AS_RIPEMD160_NEON
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_RIPEMD160_LANES 4
+#define AS_RIPEMD160_BLOCK 64
+
+#if defined(AS_RIPEMD160_SSE2)
+
+typedef __m128i as_v4;
+#define V_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define V_STORE(p, x) _mm_storeu_si128((__m128i*)(p), x)
+#define V_SET1(n) _mm_set1_epi32((int)(n))
+#define V_ADD(a, b) _mm_add_epi32(a, b)
+#define V_XOR(a, b) _mm_xor_si128(a, b)
+#define V_OR(a, b) _mm_or_si128(a, b)
+#define V_AND(a, b) _mm_and_si128(a, b)
+#define V_ANDNOT(a, b) _mm_andnot_si128(a, b) // ~a & b
+#define V_NOT(a) _mm_xor_si128(a, _mm_set1_epi32(-1))
+#define V_ROL(x, n) _mm_or_si128(_mm_sll_epi32(x, _mm_cvtsi32_si128(n)), \
+	_mm_srl_epi32(x, _mm_cvtsi32_si128(32 - (n))))
+
+#elif defined(AS_RIPEMD160_NEON)
+
+typedef uint32x4_t as_v4;
+#define V_LOAD(p) vld1q_u32(p)
+#define V_STORE(p, x) vst1q_u32(p, x)
+#define V_SET1(n) vdupq_n_u32(n)
+#define V_ADD(a, b) vaddq_u32(a, b)
+#define V_XOR(a, b) veorq_u32(a, b)
+#define V_OR(a, b) vorrq_u32(a, b)
+#define V_AND(a, b) vandq_u32(a, b)
+#define V_ANDNOT(a, b) vbicq_u32(b, a) // ~a & b
+#define V_NOT(a) vmvnq_u32(a)
+#define V_ROL(x, n) vorrq_u32(vshlq_u32(x, vdupq_n_s32(n)), vshlq_u32(x, vdupq_n_s32((n) - 32)))
+
+#endif
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static const uint32_t as_ripemd160_iv[5] = {
+	0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+static const uint32_t as_ripemd160_kl[5] = {
+	0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E
+};
+
+static const uint32_t as_ripemd160_kr[5] = {
+	0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000
+};
+
+static const uint8_t as_ripemd160_rl[80] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+
+static const uint8_t as_ripemd160_rr[80] = {
+	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+
+static const uint8_t as_ripemd160_sl[80] = {
+	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+
+static const uint8_t as_ripemd160_sr[80] = {
+	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline size_t
+as_ripemd160_msg_len(const as_ripemd160_msg* m)
+{
+	size_t len = 0;
+
+	for (int i = 0; i < AS_RIPEMD160_SEGMENTS; i++) {
+		len += m->len[i];
+	}
+	return len;
+}
+
+static inline uint64_t
+as_ripemd160_n_blocks(size_t len)
+{
+	// Message, 0x80 pad byte and 8 byte length must fit.
+	return (len + 8) / AS_RIPEMD160_BLOCK + 1;
+}
+
+// Extract padded block at given index from the concatenated message segments.
+static void
+as_ripemd160_get_block(
+	const as_ripemd160_msg* m, size_t len, uint64_t index, uint64_t n_blocks, uint32_t* w
+	)
+{
+	uint8_t block[AS_RIPEMD160_BLOCK];
+	size_t off = (size_t)index * AS_RIPEMD160_BLOCK;
+	size_t pos = 0;
+	size_t seg_off = 0;
+
+	for (int i = 0; i < AS_RIPEMD160_SEGMENTS && pos < AS_RIPEMD160_BLOCK; i++) {
+		size_t seg_len = m->len[i];
+
+		if (off + pos < seg_off + seg_len) {
+			size_t start = off + pos - seg_off;
+			size_t n = seg_len - start;
+
+			if (n > AS_RIPEMD160_BLOCK - pos) {
+				n = AS_RIPEMD160_BLOCK - pos;
+			}
+			memcpy(block + pos, m->seg[i] + start, n);
+			pos += n;
+		}
+		seg_off += seg_len;
+	}
+
+	if (pos < AS_RIPEMD160_BLOCK) {
+		memset(block + pos, 0, AS_RIPEMD160_BLOCK - pos);
+
+		if (off + pos == len) {
+			block[pos] = 0x80;
+		}
+
+		if (index == n_blocks - 1) {
+			uint64_t bits = (uint64_t)len << 3;
+
+			for (int i = 0; i < 8; i++) {
+				block[56 + i] = (uint8_t)(bits >> (i * 8));
+			}
+		}
+	}
+
+	for (int i = 0; i < 16; i++) {
+		const uint8_t* b = block + i * 4;
+		w[i] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+			((uint32_t)b[3] << 24);
+	}
+}
+
+static void
+as_ripemd160_put_digest(const uint32_t* h, uint8_t* out)
+{
+	for (int i = 0; i < 5; i++) {
+		out[i * 4] = (uint8_t)h[i];
+		out[i * 4 + 1] = (uint8_t)(h[i] >> 8);
+		out[i * 4 + 2] = (uint8_t)(h[i] >> 16);
+		out[i * 4 + 3] = (uint8_t)(h[i] >> 24);
+	}
+}
+
+static inline uint32_t
+as_ripemd160_f(int round, uint32_t x, uint32_t y, uint32_t z)
+{
+	switch (round) {
+		case 0: return x ^ y ^ z;
+		case 1: return (x & y) | (~x & z);
+		case 2: return (x | ~y) ^ z;
+		case 3: return (x & z) | (y & ~z);
+		default: return x ^ (y | ~z);
+	}
+}
+
+static void
+as_ripemd160_compress(uint32_t* h, const uint32_t* x)
+{
+	uint32_t al = h[0], bl = h[1], cl = h[2], dl = h[3], el = h[4];
+	uint32_t ar = al, br = bl, cr = cl, dr = dl, er = el;
+
+	for (int j = 0; j < 80; j++) {
+		int round = j >> 4;
+		uint32_t t = al + as_ripemd160_f(round, bl, cl, dl) + x[as_ripemd160_rl[j]] +
+			as_ripemd160_kl[round];
+		t = ROL(t, as_ripemd160_sl[j]) + el;
+		al = el; el = dl; dl = ROL(cl, 10); cl = bl; bl = t;
+
+		t = ar + as_ripemd160_f(4 - round, br, cr, dr) + x[as_ripemd160_rr[j]] +
+			as_ripemd160_kr[round];
+		t = ROL(t, as_ripemd160_sr[j]) + er;
+		ar = er; er = dr; dr = ROL(cr, 10); cr = br; br = t;
+	}
+
+	uint32_t t = h[1] + cl + dr;
+	h[1] = h[2] + dl + er;
+	h[2] = h[3] + el + ar;
+	h[3] = h[4] + al + br;
+	h[4] = h[0] + bl + cr;
+	h[0] = t;
+}
+
+static void
+as_ripemd160_single(as_ripemd160_msg* m)
+{
+	uint32_t h[5];
+	uint32_t w[16];
+
+	memcpy(h, as_ripemd160_iv, sizeof(h));
+
+	size_t len = as_ripemd160_msg_len(m);
+	uint64_t n_blocks = as_ripemd160_n_blocks(len);
+
+	for (uint64_t i = 0; i < n_blocks; i++) {
+		as_ripemd160_get_block(m, len, i, n_blocks, w);
+		as_ripemd160_compress(h, w);
+	}
+	as_ripemd160_put_digest(h, m->out);
+}
+
+#if defined(AS_RIPEMD160_SSE2) || defined(AS_RIPEMD160_NEON)
+
+#define F1(x, y, z) V_XOR(V_XOR(x, y), z)
+#define F2(x, y, z) V_OR(V_AND(x, y), V_ANDNOT(x, z))
+#define F3(x, y, z) V_XOR(V_OR(x, V_NOT(y)), z)
+#define F4(x, y, z) V_OR(V_AND(x, z), V_ANDNOT(z, y))
+#define F5(x, y, z) V_XOR(x, V_OR(y, V_NOT(z)))
+
+// Run 16 steps of both lines with fixed boolean functions so the compiler does not
+// need to branch on the round inside the step loop.
+#define AS_RIPEMD160_ROUND(_r, _fl, _fr) \
+	for (int j = (_r) * 16; j < (_r) * 16 + 16; j++) { \
+		as_v4 t = V_ADD(V_ADD(al, _fl(bl, cl, dl)), V_ADD(w[as_ripemd160_rl[j]], kl)); \
+		t = V_ADD(V_ROL(t, as_ripemd160_sl[j]), el); \
+		al = el; el = dl; dl = V_ROL(cl, 10); cl = bl; bl = t; \
+		t = V_ADD(V_ADD(ar, _fr(br, cr, dr)), V_ADD(w[as_ripemd160_rr[j]], kr)); \
+		t = V_ADD(V_ROL(t, as_ripemd160_sr[j]), er); \
+		ar = er; er = dr; dr = V_ROL(cr, 10); cr = br; br = t; \
+	}
+
+// Compress one block in each of four lanes.  State and message words are stored
+// transposed: h[i][lane] and x[i][lane].
+static void
+as_ripemd160_compress4(uint32_t h[5][AS_RIPEMD160_LANES], uint32_t x[16][AS_RIPEMD160_LANES])
+{
+	as_v4 w[16];
+
+	for (int i = 0; i < 16; i++) {
+		w[i] = V_LOAD(x[i]);
+	}
+
+	as_v4 h0 = V_LOAD(h[0]), h1 = V_LOAD(h[1]), h2 = V_LOAD(h[2]), h3 = V_LOAD(h[3]),
+		h4 = V_LOAD(h[4]);
+	as_v4 al = h0, bl = h1, cl = h2, dl = h3, el = h4;
+	as_v4 ar = h0, br = h1, cr = h2, dr = h3, er = h4;
+	as_v4 kl, kr;
+
+	kl = V_SET1(as_ripemd160_kl[0]); kr = V_SET1(as_ripemd160_kr[0]);
+	AS_RIPEMD160_ROUND(0, F1, F5);
+	kl = V_SET1(as_ripemd160_kl[1]); kr = V_SET1(as_ripemd160_kr[1]);
+	AS_RIPEMD160_ROUND(1, F2, F4);
+	kl = V_SET1(as_ripemd160_kl[2]); kr = V_SET1(as_ripemd160_kr[2]);
+	AS_RIPEMD160_ROUND(2, F3, F3);
+	kl = V_SET1(as_ripemd160_kl[3]); kr = V_SET1(as_ripemd160_kr[3]);
+	AS_RIPEMD160_ROUND(3, F4, F2);
+	kl = V_SET1(as_ripemd160_kl[4]); kr = V_SET1(as_ripemd160_kr[4]);
+	AS_RIPEMD160_ROUND(4, F5, F1);
+
+	V_STORE(h[0], V_ADD(V_ADD(h1, cl), dr));
+	V_STORE(h[1], V_ADD(V_ADD(h2, dl), er));
+	V_STORE(h[2], V_ADD(V_ADD(h3, el), ar));
+	V_STORE(h[3], V_ADD(V_ADD(h4, al), br));
+	V_STORE(h[4], V_ADD(V_ADD(h0, bl), cr));
+}
+
+typedef struct as_ripemd160_lane_s {
+	as_ripemd160_msg* msg;
+	size_t len;
+	uint64_t block;
+	uint64_t n_blocks;
+} as_ripemd160_lane;
+
+static void
+as_ripemd160_lanes(as_ripemd160_msg* msgs, uint32_t n_msgs)
+{
+	as_ripemd160_lane lanes[AS_RIPEMD160_LANES];
+	uint32_t h[5][AS_RIPEMD160_LANES];
+	uint32_t x[16][AS_RIPEMD160_LANES];
+	uint32_t w[16];
+	uint32_t next = 0;
+	uint32_t active = 0;
+
+	memset(x, 0, sizeof(x));
+
+	// Each lane hashes one message at a time. When a lane's message is finished,
+	// the lane is refilled with the next message so lanes with short messages do
+	// not wait for lanes with long messages.
+	for (int i = 0; i < AS_RIPEMD160_LANES; i++) {
+		as_ripemd160_lane* lane = &lanes[i];
+
+		if (next < n_msgs) {
+			lane->msg = &msgs[next++];
+			lane->len = as_ripemd160_msg_len(lane->msg);
+			lane->block = 0;
+			lane->n_blocks = as_ripemd160_n_blocks(lane->len);
+			active++;
+		}
+		else {
+			lane->msg = NULL;
+		}
+
+		for (int k = 0; k < 5; k++) {
+			h[k][i] = as_ripemd160_iv[k];
+		}
+	}
+
+	while (active > 0) {
+		for (int i = 0; i < AS_RIPEMD160_LANES; i++) {
+			as_ripemd160_lane* lane = &lanes[i];
+
+			if (lane->msg) {
+				as_ripemd160_get_block(lane->msg, lane->len, lane->block, lane->n_blocks, w);
+
+				for (int k = 0; k < 16; k++) {
+					x[k][i] = w[k];
+				}
+			}
+		}
+
+		as_ripemd160_compress4(h, x);
+
+		for (int i = 0; i < AS_RIPEMD160_LANES; i++) {
+			as_ripemd160_lane* lane = &lanes[i];
+
+			if (! lane->msg || ++lane->block < lane->n_blocks) {
+				continue;
+			}
+
+			uint32_t digest[5];
+
+			for (int k = 0; k < 5; k++) {
+				digest[k] = h[k][i];
+				h[k][i] = as_ripemd160_iv[k];
+			}
+			as_ripemd160_put_digest(digest, lane->msg->out);
+
+			if (next < n_msgs) {
+				lane->msg = &msgs[next++];
+				lane->len = as_ripemd160_msg_len(lane->msg);
+				lane->block = 0;
+				lane->n_blocks = as_ripemd160_n_blocks(lane->len);
+			}
+			else {
+				lane->msg = NULL;
+				active--;
+			}
+		}
+	}
+}
+
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_ripemd160_multi(as_ripemd160_msg* msgs, uint32_t n_msgs)
+{
+#if defined(AS_RIPEMD160_SSE2) || defined(AS_RIPEMD160_NEON)
+	if (n_msgs > 1) {
+		as_ripemd160_lanes(msgs, n_msgs);
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < n_msgs; i++) {
+		as_ripemd160_single(&msgs[i]);
+	}
+}
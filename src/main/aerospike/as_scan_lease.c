@@ -0,0 +1,293 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_scan_lease.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_partition_filter.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <errno.h>
+#include <string.h>
+
+#if !defined(_MSC_VER)
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_LEASE_FREE 0
+#define AS_LEASE_LEASED 1
+#define AS_LEASE_DONE 2
+
+#define AS_LEASE_PARTITIONS 4096
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Shared memory slot for one chunk.  Protected by lock.
+typedef struct as_lease_slot_s {
+	uint8_t lock;
+	uint8_t state;
+	uint16_t pad;
+	uint32_t cursor_size;
+	uint64_t token;
+	uint64_t expiration;
+	uint8_t cursor[];
+} as_lease_slot;
+
+// Shared memory header followed by slots.  Zero filled memory is a valid empty store.
+typedef struct as_lease_shm_s {
+	uint32_t chunk_size;
+	uint32_t pad;
+	uint64_t token;
+	uint8_t slots[];
+} as_lease_shm;
+
+typedef struct as_lease_local_s {
+	as_lease_shm* shm;
+	int shm_id;
+	uint32_t chunk_size;
+	uint32_t n_chunks;
+	uint32_t slot_size;
+	uint32_t iter;
+} as_lease_local;
+
+#if !defined(_MSC_VER)
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline as_lease_slot*
+as_lease_slot_get(as_lease_local* ll, uint32_t chunk)
+{
+	return (as_lease_slot*)(ll->shm->slots + (size_t)ll->slot_size * chunk);
+}
+
+static inline void
+as_lease_slot_lock(as_lease_slot* slot)
+{
+	// Held only while copying a cursor, so spinning is cheaper than a process shared mutex.
+	while (! as_cas_uint8(&slot->lock, 0, 1)) {
+		while (as_load_uint8(&slot->lock)) {
+		}
+	}
+}
+
+static inline void
+as_lease_slot_unlock(as_lease_slot* slot)
+{
+	as_fence_release();
+	as_store_uint8(&slot->lock, 0);
+}
+
+static as_scan_lease_result
+as_lease_shm_acquire(void* udata, uint32_t lease_ms, as_scan_lease* lease)
+{
+	as_lease_local* ll = udata;
+	uint64_t now = cf_getms();
+	bool wait = false;
+
+	// Start at a different chunk in each call, so workers rarely contend for one slot.
+	uint32_t begin = ll->iter++;
+
+	for (uint32_t i = 0; i < ll->n_chunks; i++) {
+		uint32_t chunk = (begin + i) % ll->n_chunks;
+		as_lease_slot* slot = as_lease_slot_get(ll, chunk);
+		uint8_t state = as_load_uint8(&slot->state);
+
+		if (state == AS_LEASE_DONE) {
+			continue;
+		}
+
+		as_lease_slot_lock(slot);
+
+		if (slot->state == AS_LEASE_DONE) {
+			as_lease_slot_unlock(slot);
+			continue;
+		}
+
+		if (slot->state == AS_LEASE_LEASED && slot->expiration > now) {
+			as_lease_slot_unlock(slot);
+			wait = true;
+			continue;
+		}
+
+		// Free or expired.
+		slot->state = AS_LEASE_LEASED;
+		slot->token = as_faa_uint64(&ll->shm->token, 1) + 1;
+		slot->expiration = now + lease_ms;
+
+		lease->token = slot->token;
+		lease->chunk = chunk;
+		lease->part_begin = (uint16_t)(chunk * ll->chunk_size);
+		lease->part_count = (uint16_t)((chunk + 1 == ll->n_chunks) ?
+			AS_LEASE_PARTITIONS - lease->part_begin : ll->chunk_size);
+
+		if (slot->cursor_size > 0) {
+			lease->cursor = cf_malloc(slot->cursor_size);
+			memcpy(lease->cursor, slot->cursor, slot->cursor_size);
+			lease->cursor_size = slot->cursor_size;
+		}
+		else {
+			lease->cursor = NULL;
+			lease->cursor_size = 0;
+		}
+		as_lease_slot_unlock(slot);
+		return AS_SCAN_LEASE_GRANTED;
+	}
+	return wait ? AS_SCAN_LEASE_WAIT : AS_SCAN_LEASE_DONE;
+}
+
+static bool
+as_lease_shm_renew(void* udata, const as_scan_lease* lease, uint32_t lease_ms)
+{
+	as_lease_local* ll = udata;
+	as_lease_slot* slot = as_lease_slot_get(ll, lease->chunk);
+
+	as_lease_slot_lock(slot);
+
+	bool valid = slot->token == lease->token && slot->state == AS_LEASE_LEASED;
+
+	if (valid) {
+		slot->expiration = cf_getms() + lease_ms;
+	}
+	as_lease_slot_unlock(slot);
+	return valid;
+}
+
+static bool
+as_lease_shm_release(
+	void* udata, const as_scan_lease* lease, const uint8_t* cursor, uint32_t cursor_size,
+	bool done
+	)
+{
+	as_lease_local* ll = udata;
+	as_lease_slot* slot = as_lease_slot_get(ll, lease->chunk);
+	uint32_t max = ll->slot_size - sizeof(as_lease_slot);
+
+	as_lease_slot_lock(slot);
+
+	bool valid = slot->token == lease->token && slot->state == AS_LEASE_LEASED;
+
+	if (valid) {
+		if (done) {
+			slot->state = AS_LEASE_DONE;
+			slot->cursor_size = 0;
+		}
+		else {
+			slot->state = AS_LEASE_FREE;
+
+			// Cursor is bounded by the chunk size. Drop it rather than overflow, which only
+			// restarts the chunk.
+			if (cursor && cursor_size <= max) {
+				memcpy(slot->cursor, cursor, cursor_size);
+				slot->cursor_size = cursor_size;
+			}
+			else {
+				slot->cursor_size = 0;
+			}
+		}
+	}
+	as_lease_slot_unlock(slot);
+	return valid;
+}
+
+static void
+as_lease_shm_destroy(void* udata)
+{
+	as_lease_local* ll = udata;
+
+	shmdt(ll->shm);
+
+	// Removal fails while other processes are attached, which is expected.
+	shmctl(ll->shm_id, IPC_RMID, 0);
+	cf_free(ll);
+}
+
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_scan_lease_store_shm(as_error* err, as_scan_lease_store* store, int key, uint32_t chunk_size)
+{
+	as_error_reset(err);
+
+	if (chunk_size == 0 || chunk_size > AS_LEASE_PARTITIONS) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid chunk_size: %u", chunk_size);
+	}
+
+#if !defined(_MSC_VER)
+	uint32_t n_chunks = (AS_LEASE_PARTITIONS + chunk_size - 1) / chunk_size;
+	uint32_t slot_size = sizeof(as_lease_slot) + as_partitions_status_bytes_max(chunk_size);
+
+	// Keep slots 8 byte aligned.
+	slot_size = (slot_size + 7) & ~7u;
+
+	size_t size = sizeof(as_lease_shm) + (size_t)slot_size * n_chunks;
+
+	// Shared memory create initializes memory to zero, which is an empty store.
+	int id = shmget(key, size, IPC_CREAT | 0666);
+
+	if (id < 0) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Shared memory get failed: %s",
+			strerror(errno));
+	}
+
+	as_lease_shm* shm = shmat(id, NULL, 0);
+
+	if (shm == (void*)-1) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+			"Error attaching to shared memory: %s", strerror(errno));
+	}
+
+	// First process records the chunk size. Others must match it.
+	if (! as_cas_uint32(&shm->chunk_size, 0, chunk_size) &&
+		as_load_uint32(&shm->chunk_size) != chunk_size) {
+		uint32_t other = as_load_uint32(&shm->chunk_size);
+		shmdt(shm);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Lease store chunk_size %u does not match existing chunk_size %u", chunk_size,
+			other);
+	}
+
+	as_lease_local* ll = cf_malloc(sizeof(as_lease_local));
+	ll->shm = shm;
+	ll->shm_id = id;
+	ll->chunk_size = chunk_size;
+	ll->n_chunks = n_chunks;
+	ll->slot_size = slot_size;
+	ll->iter = (uint32_t)getpid();
+
+	store->acquire = as_lease_shm_acquire;
+	store->renew = as_lease_shm_renew;
+	store->release = as_lease_shm_release;
+	store->destroy = as_lease_shm_destroy;
+	store->udata = ll;
+	return AEROSPIKE_OK;
+#else
+	return as_error_set_message(err, AEROSPIKE_ERR_CLIENT,
+		"Shared memory lease store not supported on this platform");
+#endif
+}
@@ -20,11 +20,11 @@
 #include <aerospike/as_cpu.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_node.h>
+#include <aerospike/as_partition_bitmap.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_sleep.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_thread.h>
-#include <citrusleaf/cf_b64.h>
 #include <citrusleaf/cf_byte_order.h>
 #include <citrusleaf/cf_clock.h>
 #include <errno.h>
@@ -44,6 +44,24 @@
 #include <sys/sysctl.h>
 #endif
 
+/******************************************************************************
+ * MACROS
+ ******************************************************************************/
+
+#define AS_SHM_CACHE_LINE 64
+
+// Default huge page size on x86_64 and arm64 Linux.
+#define AS_SHM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Tend iterations between resets of shared node connection counts.
+#define AS_SHM_CONNS_WINDOW 30
+
+#define AS_SHM_ALIGN(_size, _align) (((_size) + (_align) - 1) & ~((_align) - 1))
+
+// TLS session slots per node and slots probed for each session key.
+#define AS_SHM_TLS_SESSIONS_PER_NODE 4
+#define AS_SHM_TLS_SESSION_PROBES 4
+
 /******************************************************************************
  * DECLARATIONS
  ******************************************************************************/
@@ -168,8 +186,8 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 			// Node already exists.  Activate node.
 			as_node_shm* node_shm = &cluster_shm->nodes[node_index];
 			
-			// Update shared memory node in write lock.
-			as_swlock_write_lock(&node_shm->lock);
+			// Update shared memory node under sequence lock.
+			as_shm_write_begin(&node_shm->seq);
 			memcpy(&node_shm->addr, &address->addr, sizeof(struct sockaddr_storage));
 			if (node_to_add->tls_name) {
 				strcpy(node_shm->tls_name, node_to_add->tls_name);
@@ -178,8 +196,10 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 				node_shm->tls_name[0] = 0;
 			}
 			node_shm->features = node_to_add->features;
+			node_shm->error_rate_exceeded = false;
+			node_shm->latency_us = 0;
 			node_shm->active = true;
-			as_swlock_write_unlock(&node_shm->lock);
+			as_shm_write_end(&node_shm->seq);
 			
 			// Set shared memory node array index.
 			// Only referenced by shared memory tending thread, so volatile write not necessary.
@@ -190,8 +210,8 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 			if (cluster_shm->nodes_size < cluster_shm->nodes_capacity) {
 				as_node_shm* node_shm = &cluster_shm->nodes[cluster_shm->nodes_size];
 				
-				// Update shared memory node in write lock.
-				as_swlock_write_lock(&node_shm->lock);
+				// Update shared memory node under sequence lock.
+				as_shm_write_begin(&node_shm->seq);
 				memcpy(node_shm->name, node_to_add->name, AS_NODE_NAME_SIZE);
 				memcpy(&node_shm->addr, &address->addr, sizeof(struct sockaddr_storage));
 				if (node_to_add->tls_name) {
@@ -202,7 +222,7 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 				}
 				node_shm->features = node_to_add->features;
 				node_shm->active = true;
-				as_swlock_write_unlock(&node_shm->lock);
+				as_shm_write_end(&node_shm->seq);
 				
 				// Set shared memory node array index.
 				// Only referenced by shared memory tending thread, so volatile write not necessary.
@@ -233,10 +253,10 @@ as_shm_remove_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_re
 		as_node* node_to_remove = as_vector_get_ptr(nodes_to_remove, i);
 		as_node_shm* node_shm = &cluster_shm->nodes[node_to_remove->index];
 		
-		// Update shared memory node in write lock.
-		as_swlock_write_lock(&node_shm->lock);
+		// Update shared memory node under sequence lock.
+		as_shm_write_begin(&node_shm->seq);
 		node_shm->active = false;
-		as_swlock_write_unlock(&node_shm->lock);
+		as_shm_write_end(&node_shm->seq);
 
 		// Set local node pointer to null, but do not decrement cluster_shm->nodes_size
 		// because nodes are stored in a fixed array.
@@ -268,9 +288,7 @@ as_shm_ensure_login(as_cluster* cluster, as_error* err)
 	for (uint32_t i = 0; i < max; i++) {
 		as_node_shm* node_shm = &nodes_shm[i];
 
-		as_swlock_read_lock(&node_shm->lock);
-		uint8_t active = node_shm->active;
-		as_swlock_read_unlock(&node_shm->lock);
+		uint8_t active = as_load_uint8(&node_shm->active);
 
 		if (active) {
 			as_node* node = shm_info->local_nodes[i];
@@ -303,10 +321,13 @@ as_shm_reset_nodes(as_cluster* cluster)
 		as_node_shm* node_shm = &nodes_shm[i];
 		as_node* node = shm_info->local_nodes[i];
 
-		// Make copy of shared memory node under a read lock.
-		as_swlock_read_lock(&node_shm->lock);
-		memcpy(&node_tmp, node_shm, sizeof(as_node_shm));
-		as_swlock_read_unlock(&node_shm->lock);
+		// Make consistent copy of shared memory node.
+		uint32_t seq;
+
+		do {
+			seq = as_shm_read_begin(&node_shm->seq);
+			memcpy(&node_tmp, node_shm, sizeof(as_node_shm));
+		} while (as_shm_read_retry(&node_shm->seq, seq));
 		
 		if (node_tmp.active) {
 			if (! node) {
@@ -391,10 +412,13 @@ as_shm_reset_racks(as_cluster* cluster, as_shm_info* shm_info, as_cluster_shm* c
 	for (uint32_t i = 0; i < max; i++) {
 		as_node_shm* node_shm = &nodes_shm[i];
 
-		as_swlock_read_lock(&node_shm->lock);
-		rack_id = node_shm->rack_id;
-		active = node_shm->active;
-		as_swlock_read_unlock(&node_shm->lock);
+		uint32_t seq;
+
+		do {
+			seq = as_shm_read_begin(&node_shm->seq);
+			rack_id = as_load_int32(&node_shm->rack_id);
+			active = as_load_uint8(&node_shm->active);
+		} while (as_shm_read_retry(&node_shm->seq, seq));
 
 		// Retrieve racks only when different rack ids per namespace (rack_id == -1).
 		if (rack_id == -1 && active) {
@@ -418,11 +442,11 @@ as_shm_node_replace_racks(as_cluster_shm* cluster_shm, as_node* node, as_racks*
 	as_node_shm* node_shm = &cluster_shm->nodes[node->index];
 	int rack_id = (racks->size == 0)? racks->rack_id : -1;
 
-	// Update shared memory node in write lock.
-	as_swlock_write_lock(&node_shm->lock);
+	// Update shared memory node under sequence lock.
+	as_shm_write_begin(&node_shm->seq);
 	node_shm->rebalance_generation = node->rebalance_generation;
 	node_shm->rack_id = rack_id;
-	as_swlock_write_unlock(&node_shm->lock);
+	as_shm_write_end(&node_shm->seq);
 }
 
 as_partition_table_shm*
@@ -474,43 +498,51 @@ as_shm_force_replicas_refresh(as_shm_info* shm_info, uint32_t node_index)
 static void
 as_shm_decode_and_update(as_shm_info* shm_info, char* bitmap_b64, int64_t len, as_partition_table_shm* table, uint32_t node_index, bool master, uint32_t regime)
 {
-	// Size allows for padding - is actual size rounded up to multiple of 3.
-	uint8_t* bitmap = (uint8_t*)alloca(cf_b64_decoded_buf_size((uint32_t)len));
-	
-	// For now - for speed - trust validity of encoded characters.
-	cf_b64_decode(bitmap_b64, (uint32_t)len, bitmap, NULL);
-	
-	// Expand the bitmap.
 	uint32_t max = shm_info->cluster_shm->n_partitions;
+	uint32_t n_words = AS_PARTITION_BITMAP_WORDS(max);
+	uint64_t* bitmap = (uint64_t*)alloca(sizeof(uint64_t) * n_words);
+
+	// For now - for speed - trust validity of encoded characters.
+	as_partition_bitmap_decode(bitmap_b64, (uint32_t)len, bitmap, n_words);
+
+	// Expand the bitmap. Skip words without partitions.
+	for (uint32_t w = 0; w < n_words; w++) {
+		uint64_t bits = bitmap[w];
+
+		while (bits) {
+			uint32_t offset = as_partition_bitmap_first(bits);
+			uint32_t i = (w << 6) + offset;
+
+			if (i >= max) {
+				break;
+			}
+			bits &= ~(0x8000000000000000ULL >> offset);
 
-	for (uint32_t i = 0; i < max; i++) {
-		if ((bitmap[i >> 3] & (0x80 >> (i & 7))) != 0) {
 			// This node claims ownership of partition.
 			as_partition_shm* p = &table->partitions[i];
 
-			if (regime >= as_load_uint32(&p->regime)) {
-				if (regime > p->regime) {
-					as_store_uint32(&p->regime, regime);
-				}
+			// Only the tend master writes partitions, so fields can be read without
+			// the sequence lock here.
+			if (regime < p->regime) {
+				continue;
+			}
 
-				if (master) {
-					// node_index starts at one (zero indicates unset).
-					if (node_index != p->master) {
-						if (p->master) {
-							as_shm_force_replicas_refresh(shm_info, p->master);
-						}
-						as_store_uint32(&p->master, node_index);
-					}
-				}
-				else {
-					if (node_index != p->prole) {
-						if (p->prole) {
-							as_shm_force_replicas_refresh(shm_info, p->prole);
-						}
-						as_store_uint32(&p->prole, node_index);
-					}
-				}
+			uint32_t* owner = master ? &p->master : &p->prole;
+
+			// node_index starts at one (zero indicates unset).
+			if (regime == p->regime && node_index == *owner) {
+				continue;
+			}
+
+			if (*owner && node_index != *owner) {
+				as_shm_force_replicas_refresh(shm_info, *owner);
 			}
+
+			// Readers retry while the partition is being updated.
+			as_shm_write_begin(&p->seq);
+			as_store_uint32(&p->regime, regime);
+			as_store_uint32(owner, node_index);
+			as_shm_write_end(&p->seq);
 		}
 	}
 }
@@ -568,10 +600,21 @@ as_shm_try_node_alternate(
 	as_node* chosen = (as_node*)as_load_ptr(&local_nodes[chosen_index-1]);
 	
 	// Make volatile reference so changes to tend thread will be reflected in this thread.
+	if (chosen && ! as_node_avoid(chosen)) {
+		return chosen;
+	}
+
+	// Chosen node is inactive or suspect. Fall back to it only if alternate is not usable.
+	as_node* alternate = as_shm_try_node(cluster, local_nodes, alternate_index);
+
+	if (alternate && ! as_load_uint8(&alternate->suspect)) {
+		return alternate;
+	}
+
 	if (chosen && as_load_uint8(&chosen->active)) {
 		return chosen;
 	}
-	return as_shm_try_node(cluster, local_nodes, alternate_index);
+	return alternate;
 }
 
 static as_node*
@@ -579,8 +622,9 @@ shm_get_sequence_node(
 	as_cluster* cluster, as_node** local_nodes, as_partition_shm* p, bool use_master
 	)
 {
-	uint32_t master = as_load_uint32(&p->master);
-	uint32_t prole = as_load_uint32(&p->prole);
+	uint32_t master;
+	uint32_t prole;
+	as_partition_shm_read(p, &master, &prole);
 
 	if (! prole) {
 		return as_shm_try_node(cluster, local_nodes, master);
@@ -606,12 +650,10 @@ shm_prefer_rack_node(
 	uint32_t node_indexes[2];
 
 	if (use_master) {
-		node_indexes[0] = as_load_uint32(&p->master);
-		node_indexes[1] = as_load_uint32(&p->prole);
+		as_partition_shm_read(p, &node_indexes[0], &node_indexes[1]);
 	}
 	else {
-		node_indexes[0] = as_load_uint32(&p->prole);
-		node_indexes[1] = as_load_uint32(&p->master);
+		as_partition_shm_read(p, &node_indexes[1], &node_indexes[0]);
 	}
 
 	as_node* fallback1 = NULL;
@@ -634,10 +676,13 @@ shm_prefer_rack_node(
 			int rack_id;
 			uint8_t active;
 
-			as_swlock_read_lock(&node_shm->lock);
-			rack_id = node_shm->rack_id;
-			active = node_shm->active;
-			as_swlock_read_unlock(&node_shm->lock);
+			uint32_t seq;
+
+			do {
+				seq = as_shm_read_begin(&node_shm->seq);
+				rack_id = as_load_int32(&node_shm->rack_id);
+				active = as_load_uint8(&node_shm->active);
+			} while (as_shm_read_retry(&node_shm->seq, seq));
 
 			if (! active) {
 				continue;
@@ -649,8 +694,8 @@ shm_prefer_rack_node(
 			// only one on the same rack. The contents of prev_node may have
 			// already been destroyed, so just use pointer comparison and never
 			// examine the contents of prev_node!
-			if (node == prev_node) {
-				// Previous node is the least desirable fallback.
+			if (node == prev_node || (node && as_load_uint8(&node->suspect))) {
+				// Previous and suspect nodes are the least desirable fallback.
 				if (! fallback2) {
 					fallback2 = node;
 				}
@@ -684,6 +729,221 @@ shm_prefer_rack_node(
 	return NULL;
 }
 
+static as_node*
+shm_lowest_latency_node(
+	as_cluster* cluster, as_node** local_nodes, as_partition_shm* p, as_node* prev_node,
+	bool use_master
+	)
+{
+	uint32_t master_index;
+	uint32_t prole_index;
+	as_partition_shm_read(p, &master_index, &prole_index);
+
+	if (! master_index || ! prole_index) {
+		return shm_get_sequence_node(cluster, local_nodes, p, use_master);
+	}
+
+	as_node* master = as_shm_try_node(cluster, local_nodes, master_index);
+	as_node* prole = as_shm_try_node(cluster, local_nodes, prole_index);
+
+	if (! master || ! prole) {
+		return master ? master : prole;
+	}
+
+	// Avoid a suspect replica when the other one is not suspect.
+	if (as_load_uint8(&master->suspect) != as_load_uint8(&prole->suspect)) {
+		return as_load_uint8(&master->suspect) ? prole : master;
+	}
+
+	// On retry, use the other node. Only compare prev_node pointer because its contents
+	// may have already been destroyed.
+	if (prev_node == master) {
+		return prole;
+	}
+
+	if (prev_node == prole) {
+		return master;
+	}
+	return as_node_lowest_latency(master, prole);
+}
+
+void
+as_shm_node_error_rate_exceeded(as_cluster* cluster, as_node* node)
+{
+	as_shm_info* shm_info = cluster->shm_info;
+
+	// Nodes that did not fit in shared memory are not shared.
+	if (node->index < shm_info->cluster_shm->nodes_capacity &&
+		as_load_ptr(&shm_info->local_nodes[node->index]) == node) {
+		as_store_uint8(&shm_info->cluster_shm->nodes[node->index].error_rate_exceeded, true);
+	}
+}
+
+void
+as_shm_update_health(as_cluster* cluster)
+{
+	as_shm_info* shm_info = cluster->shm_info;
+	as_cluster_shm* cluster_shm = shm_info->cluster_shm;
+	as_node_shm* nodes_shm = cluster_shm->nodes;
+	uint32_t max = as_load_uint32(&cluster_shm->nodes_size);
+	bool reset = false;
+
+	if (cluster->max_error_rate > 0) {
+		if (shm_info->is_tend_master &&
+			cluster->tend_count % cluster->error_rate_window == 0) {
+			// Clear shared error state before other processes see the new window.
+			for (uint32_t i = 0; i < max; i++) {
+				as_store_uint8(&nodes_shm[i].error_rate_exceeded, false);
+			}
+			as_incr_uint32(&cluster_shm->error_window);
+		}
+
+		uint32_t window = as_load_uint32(&cluster_shm->error_window);
+
+		if (window != shm_info->error_window) {
+			shm_info->error_window = window;
+			reset = true;
+		}
+	}
+
+	for (uint32_t i = 0; i < max; i++) {
+		as_node* node = shm_info->local_nodes[i];
+
+		if (! node) {
+			continue;
+		}
+
+		as_node_shm* node_shm = &nodes_shm[i];
+
+		if (! shm_info->is_tend_master && as_load_uint8(&node->suspect)) {
+			// Only the tend master refreshes nodes. The node is still listed in shared memory,
+			// so let commands route to it again.
+			as_store_uint8(&node->suspect, 0);
+		}
+
+		if (cluster->max_error_rate > 0) {
+			if (reset) {
+				as_node_error_window_end(node);
+			}
+			as_store_uint8(&node->error_rate_exceeded,
+				as_load_uint8(&node_shm->error_rate_exceeded));
+		}
+
+		// Blend local latency average with the average of other processes, so a process
+		// learns about a slow node without sending its own share of commands first.
+		uint32_t latency = as_load_uint32(&node->latency_us);
+		uint32_t shared = as_load_uint32(&node_shm->latency_us);
+
+		if (! latency) {
+			latency = shared;
+		}
+		else if (shared) {
+			latency = (uint32_t)(((uint64_t)latency * 3 + shared) / 4);
+		}
+
+		if (latency) {
+			as_store_uint32(&node->latency_us, latency);
+			as_store_uint32(&node_shm->latency_us, latency);
+		}
+	}
+}
+
+void
+as_shm_update_conns(as_cluster* cluster)
+{
+	as_shm_info* shm_info = cluster->shm_info;
+	as_cluster_shm* cluster_shm = shm_info->cluster_shm;
+	as_node_shm* nodes_shm = cluster_shm->nodes;
+	uint32_t max = as_load_uint32(&cluster_shm->nodes_size);
+
+	if (shm_info->is_tend_master && cluster->tend_count % AS_SHM_CONNS_WINDOW == 0) {
+		// Reset counts before other processes see the new window. Processes republish
+		// their full counts, so counts of processes that exited expire.
+		for (uint32_t i = 0; i < max; i++) {
+			as_store_uint32(&nodes_shm[i].conns_total, 0);
+			as_store_uint32(&nodes_shm[i].conns_idle, 0);
+			as_store_uint32(&nodes_shm[i].conns_refused, 0);
+		}
+		as_incr_uint32(&cluster_shm->conns_window);
+	}
+
+	uint32_t window = as_load_uint32(&cluster_shm->conns_window);
+	bool reset = window != shm_info->conns_window;
+	shm_info->conns_window = window;
+
+	for (uint32_t i = 0; i < max; i++) {
+		as_node* node = shm_info->local_nodes[i];
+
+		if (! node) {
+			continue;
+		}
+
+		as_node_shm* node_shm = &nodes_shm[i];
+		uint32_t total;
+		uint32_t idle;
+
+		if (shm_info->max_conns_per_node > 0 && as_load_uint32(&node_shm->conns_refused) > 0) {
+			// Other processes were refused connections. Give them this process's idle
+			// connections above pool minimums.
+			as_node_sync_conns(node, &total, &idle);
+
+			uint32_t host_total = as_load_uint32(&node_shm->conns_total);
+			uint32_t host_max = shm_info->max_conns_per_node;
+			uint32_t count = (host_total >= host_max)? host_total - host_max + 1 : 1;
+
+			as_node_release_idle_connections(node, count);
+		}
+		as_node_sync_conns(node, &total, &idle);
+
+		// Unsigned differences wrap correctly when counts decreased.
+		if (reset) {
+			as_faa_uint32(&node_shm->conns_total, total);
+			as_faa_uint32(&node_shm->conns_idle, idle);
+		}
+		else {
+			as_faa_uint32(&node_shm->conns_total, total - node->conns_published);
+			as_faa_uint32(&node_shm->conns_idle, idle - node->idle_published);
+		}
+		node->conns_published = total;
+		node->idle_published = idle;
+	}
+}
+
+bool
+as_shm_reserve_connection(as_cluster* cluster, as_node* node)
+{
+	as_shm_info* shm_info = cluster->shm_info;
+	uint32_t max = shm_info->max_conns_per_node;
+
+	if (max == 0) {
+		return true;
+	}
+
+	// Nodes that did not fit in shared memory are not shared.
+	if (node->index >= shm_info->cluster_shm->nodes_capacity ||
+		as_load_ptr(&shm_info->local_nodes[node->index]) != node) {
+		return true;
+	}
+
+	as_node_shm* node_shm = &shm_info->cluster_shm->nodes[node->index];
+
+	// Include connections this process opened since its last publish.
+	uint32_t total;
+	uint32_t idle;
+	as_node_sync_conns(node, &total, &idle);
+
+	uint32_t host_total = as_load_uint32(&node_shm->conns_total) + total -
+		as_load_uint32(&node->conns_published);
+
+	if (host_total <= max) {
+		return true;
+	}
+
+	// Ask other processes to release idle connections.
+	as_incr_uint32(&node_shm->conns_refused);
+	return false;
+}
+
 static uint32_t g_shm_randomizer = 0;
 
 as_node*
@@ -716,6 +976,10 @@ as_partition_shm_get_node(
 		case AS_POLICY_REPLICA_PREFER_RACK: {
 			return shm_prefer_rack_node(cluster, local_nodes, ns, p, prev_node, use_master);
 		}
+
+		case AS_POLICY_REPLICA_LOWEST_LATENCY: {
+			return shm_lowest_latency_node(cluster, local_nodes, p, prev_node, use_master);
+		}
 	}
 }
 
@@ -730,9 +994,7 @@ as_shm_reset_rebalance_gen(as_shm_info* shm_info, as_cluster_shm* cluster_shm)
 	for (uint32_t i = 0; i < max; i++) {
 		as_node_shm* node_shm = &nodes_shm[i];
 
-		as_swlock_read_lock(&node_shm->lock);
-		gen = node_shm->rebalance_generation;
-		as_swlock_read_unlock(&node_shm->lock);
+		gen = as_load_uint32(&node_shm->rebalance_generation);
 
 		as_node* node = shm_info->local_nodes[i];
 
@@ -758,7 +1020,8 @@ static bool
 as_process_exists(uint32_t pid)
 {
 #if !defined(_MSC_VER)
-	return kill(pid, 0) == 0;
+	// EPERM means the process exists, but is owned by another user.
+	return kill(pid, 0) == 0 || errno == EPERM;
 #else
 	HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
 
@@ -819,6 +1082,26 @@ as_shm_tender(void* userdata)
 				as_shm_takeover_cluster(cluster, shm_info, cluster_shm, pid);
 				continue;
 			}
+
+			// Check if tend owner process exited without releasing lock. This is checked
+			// every tend, so followers do not wait for the takeover threshold when the
+			// owner crashed. The timestamp check below still covers a hung owner.
+			uint32_t owner_pid = as_load_uint32(&cluster_shm->owner_pid);
+
+			if (owner_pid != 0 && owner_pid != pid && !as_process_exists(owner_pid)) {
+				as_spinlock_lock(&cluster_shm->take_over_lock);
+
+				// Another follower may have taken over already.
+				if (as_load_uint32(&cluster_shm->owner_pid) == owner_pid) {
+					as_store_uint64(&cluster_shm->timestamp, cf_getms());
+					as_store_uint32(&cluster_shm->owner_pid, pid);
+					as_store_uint8(&cluster_shm->lock, 1);
+					as_spinlock_unlock(&cluster_shm->take_over_lock);
+					as_shm_takeover_cluster(cluster, shm_info, cluster_shm, pid);
+					continue;
+				}
+				as_spinlock_unlock(&cluster_shm->take_over_lock);
+			}
 			
 			// Check if tend owner died without releasing lock.
 			uint64_t now = cf_getms();
@@ -827,7 +1110,7 @@ as_shm_tender(void* userdata)
 				
 				// Check if cluster hasn't been tended within threshold.
 				if (now - ts >= threshold) {
-					uint32_t owner_pid = as_load_uint32(&cluster_shm->owner_pid);
+					owner_pid = as_load_uint32(&cluster_shm->owner_pid);
 					
 					// Check if owner process id is invalid or does not exist.
 					if (owner_pid == 0 || !as_process_exists(owner_pid)) {
@@ -893,6 +1176,110 @@ as_shm_tender(void* userdata)
 	return 0;
 }
 
+static inline uint64_t
+as_shm_tls_session_hash(const char* key)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for (const char* p = key; *p; p++) {
+		h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
+	}
+	// Zero marks an empty slot.
+	return h ? h : 1;
+}
+
+static inline as_tls_session_shm*
+as_shm_tls_sessions(as_shm_info* shm_info)
+{
+	return (as_tls_session_shm*)((uint8_t*)shm_info->cluster_shm +
+		shm_info->tls_sessions_offset);
+}
+
+static inline void
+as_shm_tls_session_lock(as_tls_session_shm* s)
+{
+	while (! as_cas_uint8(&s->lock, 0, 1)) {
+		while (as_load_uint8(&s->lock)) {
+		}
+	}
+}
+
+static inline void
+as_shm_tls_session_unlock(as_tls_session_shm* s)
+{
+	as_fence_release();
+	as_store_uint8(&s->lock, 0);
+}
+
+static bool
+as_shm_tls_session_load(void* udata, const char* key, uint8_t* buf, uint32_t* size)
+{
+	as_shm_info* shm_info = udata;
+	as_tls_session_shm* sessions = as_shm_tls_sessions(shm_info);
+	uint32_t n = shm_info->tls_sessions_size;
+	uint64_t h = as_shm_tls_session_hash(key);
+
+	for (uint32_t i = 0; i < AS_SHM_TLS_SESSION_PROBES; i++) {
+		as_tls_session_shm* s = &sessions[(h + i) % n];
+
+		if (as_load_uint64(&s->key_hash) != h) {
+			continue;
+		}
+
+		as_shm_tls_session_lock(s);
+
+		bool found = s->key_hash == h && s->size > 0 && s->size <= *size;
+
+		if (found) {
+			memcpy(buf, s->data, s->size);
+			*size = s->size;
+		}
+		as_shm_tls_session_unlock(s);
+
+		if (found) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+as_shm_tls_session_save(void* udata, const char* key, const uint8_t* buf, uint32_t size)
+{
+	as_shm_info* shm_info = udata;
+	as_tls_session_shm* sessions = as_shm_tls_sessions(shm_info);
+	uint32_t n = shm_info->tls_sessions_size;
+	uint64_t h = as_shm_tls_session_hash(key);
+
+	// Use the slot that holds this key, else an empty slot, else the oldest probed slot.
+	as_tls_session_shm* target = NULL;
+	uint64_t oldest = UINT64_MAX;
+
+	for (uint32_t i = 0; i < AS_SHM_TLS_SESSION_PROBES; i++) {
+		as_tls_session_shm* s = &sessions[(h + i) % n];
+		uint64_t kh = as_load_uint64(&s->key_hash);
+
+		if (kh == h || kh == 0) {
+			target = s;
+			break;
+		}
+
+		uint64_t updated = as_load_uint64(&s->updated);
+
+		if (updated < oldest) {
+			oldest = updated;
+			target = s;
+		}
+	}
+
+	as_shm_tls_session_lock(target);
+	memcpy(target->data, buf, size);
+	target->size = size;
+	target->updated = cf_getms();
+	as_store_uint64(&target->key_hash, h);
+	as_shm_tls_session_unlock(target);
+}
+
 static void
 as_shm_wait_till_ready(as_cluster* cluster, as_cluster_shm* cluster_shm, uint32_t pid)
 {
@@ -920,14 +1307,46 @@ as_shm_create(as_cluster* cluster, as_error* err, as_config* config)
 	// Hard code value for now.
 	cluster->n_partitions = 4096;
 	
-	uint32_t size = sizeof(as_cluster_shm) + (sizeof(as_node_shm) * config->shm_max_nodes) +
-		((sizeof(as_partition_table_shm) + (sizeof(as_partition_shm) * cluster->n_partitions)) * config->shm_max_namespaces);
+	// Start each partition table on a cache line, so each line holds four whole partitions.
+	uint32_t tables_offset = AS_SHM_ALIGN(sizeof(as_cluster_shm) +
+		(sizeof(as_node_shm) * config->shm_max_nodes), AS_SHM_CACHE_LINE);
+	uint32_t table_size = AS_SHM_ALIGN(sizeof(as_partition_table_shm) +
+		(sizeof(as_partition_shm) * cluster->n_partitions), AS_SHM_CACHE_LINE);
+	uint32_t size = tables_offset + (table_size * config->shm_max_namespaces);
+
+	// TLS sessions follow the partition tables. All processes must agree on the session
+	// cache setting, because it changes the segment size.
+	uint32_t tls_sessions_offset = AS_SHM_ALIGN(size, AS_SHM_CACHE_LINE);
+	uint32_t tls_sessions_size = (cluster->tls_ctx && cluster->tls_ctx->session_cache) ?
+		config->shm_max_nodes * AS_SHM_TLS_SESSIONS_PER_NODE : 0;
+
+	if (tls_sessions_size > 0) {
+		size = tls_sessions_offset + (tls_sessions_size * sizeof(as_tls_session_shm));
+	}
 	
 	uint32_t pid = getpid();
 
 #if !defined(_MSC_VER)
 	// Create shared memory segment.  Only one process will succeed.
-	int id = shmget(config->shm_key, size, IPC_CREAT | IPC_EXCL | 0666);
+	int id = -1;
+
+#if defined(SHM_HUGETLB)
+	if (config->shm_huge_pages) {
+		// Huge page segments must be a multiple of the huge page size. Processes that
+		// attach later request the unrounded size, which is always within the segment.
+		uint32_t huge_size = AS_SHM_ALIGN(size, AS_SHM_HUGE_PAGE_SIZE);
+		id = shmget(config->shm_key, huge_size, IPC_CREAT | IPC_EXCL | SHM_HUGETLB | 0666);
+
+		if (id < 0 && errno != EEXIST) {
+			as_log_warn("Shared memory huge pages unavailable: %s. Use standard pages.",
+				strerror(errno));
+		}
+	}
+#endif
+
+	if (id < 0) {
+		id = shmget(config->shm_key, size, IPC_CREAT | IPC_EXCL | 0666);
+	}
 
 	if (id >= 0) {
 		// Exclusive shared memory lock succeeded.
@@ -1020,16 +1439,32 @@ as_shm_create(as_cluster* cluster, as_error* err, as_config* config)
 	shm_info->shm_id = id;
 	shm_info->takeover_threshold_ms = config->shm_takeover_threshold_sec * 1000;
 	shm_info->is_tend_master = as_cas_uint8(&cluster_shm->lock, 0, 1);
+	shm_info->error_window = as_load_uint32(&cluster_shm->error_window);
+	// Force first tend to publish connection counts.
+	shm_info->conns_window = as_load_uint32(&cluster_shm->conns_window) - 1;
+	shm_info->max_conns_per_node = config->shm_max_conns_per_node;
+	shm_info->tls_sessions_offset = tls_sessions_offset;
+	shm_info->tls_sessions_size = tls_sessions_size;
 	cluster->shm_info = shm_info;
 
+	if (tls_sessions_size > 0) {
+		// Share sessions before the first node connections are opened.
+		as_tls_context* ctx = cluster->tls_ctx;
+		pthread_mutex_lock(&ctx->lock);
+		ctx->session_load = as_shm_tls_session_load;
+		ctx->session_save = as_shm_tls_session_save;
+		ctx->session_udata = shm_info;
+		pthread_mutex_unlock(&ctx->lock);
+	}
+
 	if (shm_info->is_tend_master) {
 		as_log_info("Take over shared memory cluster: %d", pid);
 		as_fence_lock();
 		cluster_shm->n_partitions = cluster->n_partitions;
 		cluster_shm->nodes_capacity = config->shm_max_nodes;
 		cluster_shm->partition_tables_capacity = config->shm_max_namespaces;
-		cluster_shm->partition_tables_offset = sizeof(as_cluster_shm) + (sizeof(as_node_shm) * config->shm_max_nodes);
-		cluster_shm->partition_table_byte_size = sizeof(as_partition_table_shm) + (sizeof(as_partition_shm) * cluster->n_partitions);
+		cluster_shm->partition_tables_offset = tables_offset;
+		cluster_shm->partition_table_byte_size = table_size;
 		cluster_shm->timestamp = cf_getms();
 
 		as_store_uint32(&cluster_shm->owner_pid, pid);
@@ -1098,6 +1533,16 @@ as_shm_destroy(as_cluster* cluster)
 		return;
 	}
 
+	if (shm_info->tls_sessions_size > 0) {
+		// Connections may still receive sessions until they are closed.
+		as_tls_context* ctx = cluster->tls_ctx;
+		pthread_mutex_lock(&ctx->lock);
+		ctx->session_load = NULL;
+		ctx->session_save = NULL;
+		ctx->session_udata = NULL;
+		pthread_mutex_unlock(&ctx->lock);
+	}
+
 #if !defined(_MSC_VER)
 	// Detach shared memory.
 	shmdt(shm_info->cluster_shm);
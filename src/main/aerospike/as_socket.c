@@ -18,6 +18,7 @@
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_node.h>
 #include <aerospike/as_poll.h>
+#include <aerospike/as_socket_uring.h>
 #include <aerospike/as_tls.h>
 #include <citrusleaf/alloc.h>
 #include <fcntl.h>
@@ -29,9 +30,13 @@
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #define AS_EINTR EINTR
 
+// Maximum segments passed to a single writev/sendmsg call.
+#define AS_SOCKET_IOV_MAX 64
+
 static inline bool
 as_socket_is_error(int e)
 {
@@ -152,6 +157,75 @@ as_socket_create(as_socket* sock, int family, as_tls_context* ctx, const char* t
 	return 0;
 }
 
+void
+as_socket_set_read_buffer(as_socket* sock, uint32_t size)
+{
+	if (sock->ctx || size == 0) {
+		// OpenSSL already buffers TLS records.
+		return;
+	}
+	sock->rbuf = cf_malloc(size);
+	sock->rbuf_size = size;
+	sock->rbuf_pos = 0;
+	sock->rbuf_len = 0;
+}
+
+bool
+as_socket_set_busy_poll(as_socket_fd fd, uint32_t busy_poll_us)
+{
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+	int v = (int)busy_poll_us;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &v, sizeof(v)) < 0) {
+		return false;
+	}
+
+#if defined(SO_PREFER_BUSY_POLL)
+	// Kernel 5.11+.  Failure is not an error because busy poll is already enabled.
+	int f = 1;
+	setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &f, sizeof(f));
+#endif
+	return true;
+#else
+	return false;
+#endif
+}
+
+static inline void
+as_socket_set_quickack(as_socket* sock)
+{
+#if defined(__linux__) && defined(TCP_QUICKACK)
+	int f = 1;
+	setsockopt(sock->fd, IPPROTO_TCP, TCP_QUICKACK, &f, sizeof(f));
+#endif
+}
+
+void
+as_socket_set_profile(
+	as_socket* sock, uint32_t recv_buffer_size, uint32_t send_buffer_size, bool quickack
+	)
+{
+	if (recv_buffer_size > 0) {
+		int v = (int)recv_buffer_size;
+		setsockopt(sock->fd, SOL_SOCKET, SO_RCVBUF, (const char*)&v, sizeof(v));
+	}
+
+	if (send_buffer_size > 0) {
+		int v = (int)send_buffer_size;
+		setsockopt(sock->fd, SOL_SOCKET, SO_SNDBUF, (const char*)&v, sizeof(v));
+	}
+
+#if defined(__linux__) && defined(TCP_QUICKACK)
+	sock->quickack = quickack;
+
+	if (quickack) {
+		as_socket_set_quickack(sock);
+	}
+#else
+	(void)quickack;
+#endif
+}
+
 bool
 as_socket_wrap(as_socket* sock, int family, as_socket_fd fd, as_tls_context* ctx, const char* tls_name)
 {
@@ -160,6 +234,12 @@ as_socket_wrap(as_socket* sock, int family, as_socket_fd fd, as_tls_context* ctx
 	sock->family = family;
 #endif
 	sock->last_used = 0;
+	sock->rbuf = NULL;
+	sock->rbuf_size = 0;
+	sock->rbuf_pos = 0;
+	sock->rbuf_len = 0;
+	sock->ktls = false;
+	sock->quickack = false;
 
 	if (ctx) {
 		if (as_tls_wrap(ctx, sock, tls_name) < 0) {
@@ -186,6 +266,8 @@ as_socket_start_connect(as_socket* sock, struct sockaddr* addr, uint64_t deadlin
 	}
 
 	if (sock->ctx) {
+		as_tls_resume_session(sock, addr);
+
 		if (as_tls_connect(sock, deadline_ms)) {
 			return false;
 		}
@@ -221,13 +303,19 @@ as_socket_close(as_socket* sock)
 	if (sock->ctx) {
 		SSL_shutdown(sock->ssl);
 		shutdown(sock->fd, SHUT_RDWR);
-		SSL_free(sock->ssl);
+		as_tls_release(sock->ctx, sock->ssl);
 	}
 	else {
 		shutdown(sock->fd, SHUT_RDWR);
+		as_socket_uring_discard(sock->fd);
 	}
 	as_close(sock->fd);
 	sock->fd = -1;
+
+	if (sock->rbuf) {
+		cf_free(sock->rbuf);
+		sock->rbuf = NULL;
+	}
 }
 
 as_status
@@ -303,7 +391,7 @@ as_socket_write_deadline(
 	uint32_t socket_timeout, uint64_t deadline
 	)
 {
-	if (sock->ctx) {
+	if (sock->ctx && ! sock->ktls) {
 		as_status status = AEROSPIKE_OK;
 		int rv = as_tls_write(sock, buf, buf_len, socket_timeout, deadline);
 
@@ -320,6 +408,10 @@ as_socket_write_deadline(
 		return status;
 	}
 
+	if (as_socket_uring_active()) {
+		return as_socket_uring_write(err, sock, node, buf, buf_len, socket_timeout, deadline);
+	}
+
 	as_poll poll;
 	as_poll_init(&poll, sock->fd);
 
@@ -400,6 +492,147 @@ as_socket_write_deadline(
 	return status;
 }
 
+as_status
+as_socket_write_prefetch_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint8_t *buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	if (! sock->ctx && as_socket_uring_active()) {
+		return as_socket_uring_write_prefetch(err, sock, node, buf, buf_len, socket_timeout,
+											  deadline);
+	}
+	return as_socket_write_deadline(err, sock, node, buf, buf_len, socket_timeout, deadline);
+}
+
+as_status
+as_socket_writev_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, const as_socket_iov* iov,
+	uint32_t iov_count, uint32_t socket_timeout, uint64_t deadline
+	)
+{
+#if !defined(_MSC_VER)
+	if (! sock->ctx || sock->ktls) {
+		// Copy segments so partial writes can advance the iovec without modifying
+		// the caller's segments.  The caller may need to resend them on retry.
+		struct iovec* vec = alloca(sizeof(struct iovec) * iov_count);
+		size_t buf_len = 0;
+
+		for (uint32_t i = 0; i < iov_count; i++) {
+			vec[i].iov_base = (void*)iov[i].data;
+			vec[i].iov_len = iov[i].len;
+			buf_len += iov[i].len;
+		}
+
+		as_poll poll;
+		as_poll_init(&poll, sock->fd);
+
+		struct iovec* cur = vec;
+		int count = (int)iov_count;
+		size_t pos = 0;
+		as_status status = AEROSPIKE_OK;
+		uint32_t timeout;
+
+		do {
+			if (deadline > 0) {
+				uint64_t now = cf_getms();
+
+				if (now >= deadline) {
+					// Timeout.  Do not set error string to avoid affecting performance.
+					// Calling functions usually retry, so the error string is not used anyway.
+					status = err->code = AEROSPIKE_ERR_TIMEOUT;
+					err->message[0] = 0;
+					break;
+				}
+
+				timeout = (uint32_t)(deadline - now);
+
+				if (socket_timeout > 0 && socket_timeout < timeout) {
+					timeout = socket_timeout;
+				}
+			}
+			else {
+				timeout = socket_timeout;
+			}
+
+			int rv = as_poll_socket(&poll, sock->fd, timeout, false);
+
+			if (rv > 0) {
+				int n = count < AS_SOCKET_IOV_MAX ? count : AS_SOCKET_IOV_MAX;
+#if defined(__linux__)
+				struct msghdr msg;
+				memset(&msg, 0, sizeof(msg));
+				msg.msg_iov = cur;
+				msg.msg_iovlen = n;
+
+				ssize_t w_bytes = sendmsg(sock->fd, &msg, MSG_NOSIGNAL);
+#else
+				ssize_t w_bytes = writev(sock->fd, cur, n);
+#endif
+
+				if (w_bytes > 0) {
+					pos += w_bytes;
+
+					// Skip fully written segments and trim the partially written one.
+					size_t w = (size_t)w_bytes;
+
+					while (count > 0 && w >= cur->iov_len) {
+						w -= cur->iov_len;
+						cur++;
+						count--;
+					}
+
+					if (w > 0) {
+						cur->iov_base = (uint8_t*)cur->iov_base + w;
+						cur->iov_len -= w;
+					}
+				}
+				else if (w_bytes == 0) {
+					// We shouldn't see 0 returned unless we try to write 0 bytes, which we don't.
+					status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+					break;
+				}
+				else {
+					int e = as_last_error();
+					if (as_socket_is_error(e)) {
+						status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
+						break;
+					}
+				}
+			}
+			else if (rv == 0) {
+				// Timeout.  Do not set error string to avoid affecting performance.
+				// Calling functions usually retry, so the error string is not used anyway.
+				status = err->code = AEROSPIKE_ERR_TIMEOUT;
+				err->message[0] = 0;
+				break;
+			}
+			else if (rv == -1) {
+				int e = as_last_error();
+				if (e != AS_EINTR || as_socket_stop_on_interrupt) {
+					status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
+					break;
+				}
+			}
+		} while (pos < buf_len);
+
+		as_poll_destroy(&poll);
+		return status;
+	}
+#endif
+
+	// User-space TLS and windows sockets write each segment in turn.
+	for (uint32_t i = 0; i < iov_count; i++) {
+		as_status status = as_socket_write_deadline(err, sock, node, (uint8_t*)iov[i].data,
+			iov[i].len, socket_timeout, deadline);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
 as_status
 as_socket_read_deadline(
 	as_error* err, as_socket* sock, as_node* node, uint8_t *buf, size_t buf_len,
@@ -423,10 +656,28 @@ as_socket_read_deadline(
 		return status;
 	}
 
+	size_t pos = 0;
+
+	if (sock->rbuf_pos < sock->rbuf_len) {
+		// Serve from data already read ahead.
+		size_t avail = sock->rbuf_len - sock->rbuf_pos;
+		pos = (buf_len < avail) ? buf_len : avail;
+		memcpy(buf, sock->rbuf + sock->rbuf_pos, pos);
+		sock->rbuf_pos += (uint32_t)pos;
+
+		if (pos == buf_len) {
+			return AEROSPIKE_OK;
+		}
+	}
+
+	if (as_socket_uring_active()) {
+		return as_socket_uring_read(err, sock, node, buf + pos, buf_len - pos, socket_timeout,
+									deadline);
+	}
+
 	as_poll poll;
 	as_poll_init(&poll, sock->fd);
 
-	size_t pos = 0;
 	as_status status = AEROSPIKE_OK;
 	uint32_t timeout;
 	int try = 0;
@@ -456,14 +707,38 @@ as_socket_read_deadline(
 		int rv = as_poll_socket(&poll, sock->fd, timeout, true);
 
 		if (rv > 0) {
+			size_t remaining = buf_len - pos;
+			int r_bytes;
+
+			if (remaining < sock->rbuf_size) {
+				// Read ahead so following header/body reads do not need a system call.
 #if !defined(_MSC_VER)
-			int r_bytes = (int)read(sock->fd, buf + pos, buf_len - pos);
+				r_bytes = (int)read(sock->fd, sock->rbuf, sock->rbuf_size);
 #else
-			int r_bytes = (int)recv(sock->fd, buf + pos, (int)(buf_len - pos), 0);
+				r_bytes = (int)recv(sock->fd, sock->rbuf, (int)sock->rbuf_size, 0);
 #endif
 
+				if (r_bytes > 0) {
+					size_t n = ((size_t)r_bytes < remaining) ? (size_t)r_bytes : remaining;
+					memcpy(buf + pos, sock->rbuf, n);
+					sock->rbuf_pos = (uint32_t)n;
+					sock->rbuf_len = (uint32_t)r_bytes;
+				}
+			}
+			else {
+#if !defined(_MSC_VER)
+				r_bytes = (int)read(sock->fd, buf + pos, remaining);
+#else
+				r_bytes = (int)recv(sock->fd, buf + pos, (int)remaining, 0);
+#endif
+			}
+
 			if (r_bytes > 0) {
-				pos += r_bytes;
+				pos += (remaining < (size_t)r_bytes) ? remaining : (size_t)r_bytes;
+
+				if (sock->quickack) {
+					as_socket_set_quickack(sock);
+				}
 			}
 			else if (r_bytes == 0) {
 				// We believe this means that the server has closed this socket.
@@ -500,3 +775,51 @@ as_socket_read_deadline(
 	as_poll_destroy(&poll);
 	return status;
 }
+
+as_status
+as_socket_read_spin_deadline(
+	as_error* err, as_socket* sock, as_node* node, uint8_t *buf, size_t buf_len,
+	uint32_t spin_us, uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	// TLS may buffer decrypted data internally, and read-ahead or io_uring may already hold
+	// the response, so only spin when nothing is buffered.
+	if (spin_us == 0 || sock->ctx || sock->rbuf_pos < sock->rbuf_len ||
+		as_socket_uring_active()) {
+		return as_socket_read_deadline(err, sock, node, buf, buf_len, socket_timeout, deadline);
+	}
+
+	uint64_t limit = cf_getns() + (uint64_t)spin_us * 1000;
+	size_t pos = 0;
+
+	do {
+#if !defined(_MSC_VER)
+		int r_bytes = (int)recv(sock->fd, buf + pos, buf_len - pos, MSG_DONTWAIT);
+#else
+		int r_bytes = (int)recv(sock->fd, buf + pos, (int)(buf_len - pos), 0);
+#endif
+
+		if (r_bytes > 0) {
+			pos += r_bytes;
+
+			if (pos == buf_len) {
+				return AEROSPIKE_OK;
+			}
+		}
+		else if (r_bytes == 0) {
+			// We believe this means that the server has closed this socket.
+			return as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+		}
+		else {
+			int e = as_last_error();
+
+			if (as_socket_is_error(e) && e != AS_EINTR) {
+				return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket read error", e);
+			}
+		}
+	} while (cf_getns() < limit);
+
+	// Spin budget exhausted.  Wait in poll for the remainder.
+	return as_socket_read_deadline(err, sock, node, buf + pos, buf_len - pos, socket_timeout,
+								   deadline);
+}
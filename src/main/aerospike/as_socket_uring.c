@@ -0,0 +1,508 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_socket_uring.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_node.h>
+#include <citrusleaf/alloc.h>
+
+#if defined(AS_HAVE_LIBURING)
+
+#include <liburing.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Each call submits at most one send, one receive and one timeout.
+#define AS_SOCKET_URING_ENTRIES 8
+
+#define AS_SOCKET_URING_SEND 0
+#define AS_SOCKET_URING_RECV 1
+#define AS_SOCKET_URING_TIMEOUT 2
+
+// Prefetch result when the receive timed out.
+#define AS_SOCKET_URING_TIMED_OUT INT32_MIN
+
+typedef struct as_socket_uring_thread_s {
+	struct io_uring ring;
+	as_socket_fd fd;
+	int32_t res;
+	uint32_t pos;
+	uint32_t size;
+	uint8_t buf[AS_SOCKET_URING_PREFETCH_SIZE];
+} as_socket_uring_thread;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static uint8_t as_socket_uring_on = false;
+static pthread_key_t as_socket_uring_key;
+static pthread_once_t as_socket_uring_once = PTHREAD_ONCE_INIT;
+static __thread as_socket_uring_thread* as_socket_uring_local;
+static __thread bool as_socket_uring_failed;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_socket_uring_thread_exit(void* udata)
+{
+	as_socket_uring_thread* t = udata;
+	io_uring_queue_exit(&t->ring);
+	cf_free(t);
+}
+
+static void
+as_socket_uring_create_key(void)
+{
+	pthread_key_create(&as_socket_uring_key, as_socket_uring_thread_exit);
+}
+
+static as_socket_uring_thread*
+as_socket_uring_thread_create(void)
+{
+	as_socket_uring_thread* t = cf_malloc(sizeof(as_socket_uring_thread));
+
+	// Only the owning thread submits and waits, so task work can be deferred until the wait.
+	int rv = io_uring_queue_init(AS_SOCKET_URING_ENTRIES, &t->ring,
+								 IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN);
+
+	if (rv == -EINVAL) {
+		rv = io_uring_queue_init(AS_SOCKET_URING_ENTRIES, &t->ring, 0);
+	}
+
+	if (rv < 0) {
+		as_log_warn("io_uring_queue_init failed: %d. Using poll based socket I/O.", rv);
+		cf_free(t);
+		as_socket_uring_failed = true;
+		return NULL;
+	}
+
+	t->fd = -1;
+	t->res = 0;
+	t->pos = 0;
+	t->size = 0;
+
+	// Register destructor so the ring is closed on thread exit.
+	pthread_once(&as_socket_uring_once, as_socket_uring_create_key);
+	pthread_setspecific(as_socket_uring_key, t);
+	as_socket_uring_local = t;
+	return t;
+}
+
+static inline void
+as_socket_uring_reset(as_socket_uring_thread* t)
+{
+	t->fd = -1;
+	t->res = 0;
+	t->pos = 0;
+	t->size = 0;
+}
+
+static inline as_status
+as_socket_uring_timeout_error(as_error* err)
+{
+	// Do not set error string to avoid affecting performance.
+	// Calling functions usually retry, so the error string is not used anyway.
+	err->code = AEROSPIKE_ERR_TIMEOUT;
+	err->message[0] = 0;
+	return AEROSPIKE_ERR_TIMEOUT;
+}
+
+static inline bool
+as_socket_uring_timeout(uint32_t socket_timeout, uint64_t deadline, uint32_t* timeout)
+{
+	if (deadline > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= deadline) {
+			return false;
+		}
+
+		*timeout = (uint32_t)(deadline - now);
+
+		if (socket_timeout > 0 && socket_timeout < *timeout) {
+			*timeout = socket_timeout;
+		}
+	}
+	else {
+		*timeout = socket_timeout;
+	}
+	return true;
+}
+
+static inline void
+as_socket_uring_link_timeout(as_socket_uring_thread* t, struct io_uring_sqe* prev,
+	struct __kernel_timespec* ts, uint32_t timeout)
+{
+	ts->tv_sec = timeout / 1000;
+	ts->tv_nsec = (timeout % 1000) * 1000 * 1000;
+
+	prev->flags |= IOSQE_IO_LINK;
+
+	struct io_uring_sqe* sqe = io_uring_get_sqe(&t->ring);
+	io_uring_prep_link_timeout(sqe, ts, 0);
+	io_uring_sqe_set_data64(sqe, AS_SOCKET_URING_TIMEOUT);
+}
+
+static int
+as_socket_uring_wait(as_socket_uring_thread* t, uint32_t count, int32_t* res)
+{
+	// Submit and wait for all completions in one system call.  Every submitted request
+	// posts a completion (cancelled requests included), so the ring is empty on return.
+	int rv = io_uring_submit_and_wait(&t->ring, count);
+
+	if (rv < 0 && rv != -EINTR) {
+		return rv;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct io_uring_cqe* cqe;
+
+		while ((rv = io_uring_wait_cqe(&t->ring, &cqe)) == -EINTR) {
+		}
+
+		if (rv < 0) {
+			return rv;
+		}
+
+		res[io_uring_cqe_get_data64(cqe)] = cqe->res;
+		io_uring_cqe_seen(&t->ring, cqe);
+	}
+	return 0;
+}
+
+static as_status
+as_socket_uring_io(
+	as_socket_uring_thread* t, as_error* err, as_socket* sock, as_node* node, bool write,
+	uint8_t* buf, size_t buf_len, uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	const char* msg = write ? "Socket write error" : "Socket read error";
+	size_t pos = 0;
+
+	while (pos < buf_len) {
+		uint32_t timeout;
+
+		if (! as_socket_uring_timeout(socket_timeout, deadline, &timeout)) {
+			return as_socket_uring_timeout_error(err);
+		}
+
+		struct io_uring_sqe* sqe = io_uring_get_sqe(&t->ring);
+		uint32_t op;
+
+		if (write) {
+			io_uring_prep_send(sqe, sock->fd, buf + pos, buf_len - pos, MSG_NOSIGNAL);
+			op = AS_SOCKET_URING_SEND;
+		}
+		else {
+			io_uring_prep_recv(sqe, sock->fd, buf + pos, buf_len - pos, 0);
+			op = AS_SOCKET_URING_RECV;
+		}
+		io_uring_sqe_set_data64(sqe, op);
+
+		struct __kernel_timespec ts;
+		uint32_t count = 1;
+		int32_t res[3] = {0, 0, 0};
+
+		if (timeout > 0) {
+			as_socket_uring_link_timeout(t, sqe, &ts, timeout);
+			count++;
+		}
+
+		int rv = as_socket_uring_wait(t, count, res);
+
+		if (rv < 0) {
+			return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, msg, -rv);
+		}
+
+		int32_t r = res[op];
+
+		if (r > 0) {
+			pos += r;
+		}
+		else if (r == 0) {
+			// Peer closed the socket.
+			return as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+		}
+		else if (r == -ECANCELED && res[AS_SOCKET_URING_TIMEOUT] == -ETIME) {
+			return as_socket_uring_timeout_error(err);
+		}
+		else if (r != -EINTR && r != -EAGAIN) {
+			return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, msg, -r);
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+bool
+as_socket_uring_enable(bool enable)
+{
+	as_store_uint8(&as_socket_uring_on, enable);
+	return true;
+}
+
+bool
+as_socket_uring_enabled(void)
+{
+	return as_load_uint8(&as_socket_uring_on);
+}
+
+void
+as_socket_uring_release_thread(void)
+{
+	as_socket_uring_thread* t = as_socket_uring_local;
+
+	if (t) {
+		pthread_setspecific(as_socket_uring_key, NULL);
+		as_socket_uring_thread_exit(t);
+		as_socket_uring_local = NULL;
+	}
+	as_socket_uring_failed = false;
+}
+
+bool
+as_socket_uring_active(void)
+{
+	if (! as_load_uint8(&as_socket_uring_on)) {
+		return false;
+	}
+
+	if (as_socket_uring_local) {
+		return true;
+	}
+	return ! as_socket_uring_failed && as_socket_uring_thread_create() != NULL;
+}
+
+as_status
+as_socket_uring_write(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	as_socket_uring_thread* t = as_socket_uring_local;
+
+	if (t->fd == sock->fd) {
+		// A new request invalidates any unread prefetch data.
+		as_socket_uring_reset(t);
+	}
+	return as_socket_uring_io(t, err, sock, node, true, buf, buf_len, socket_timeout, deadline);
+}
+
+as_status
+as_socket_uring_write_prefetch(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	as_socket_uring_thread* t = as_socket_uring_local;
+	as_socket_uring_reset(t);
+
+	uint32_t timeout;
+
+	if (! as_socket_uring_timeout(socket_timeout, deadline, &timeout)) {
+		return as_socket_uring_timeout_error(err);
+	}
+
+	if (timeout == 0) {
+		// The linked receive must be bounded in case the send is short.
+		return as_socket_uring_io(t, err, sock, node, true, buf, buf_len, socket_timeout, deadline);
+	}
+
+	// Link the send to a receive into the prefetch buffer.  The send does not wait for
+	// socket buffer space and must send everything, otherwise the link is broken and the
+	// receive is cancelled.
+	struct io_uring_sqe* sqe = io_uring_get_sqe(&t->ring);
+	io_uring_prep_send(sqe, sock->fd, buf, buf_len, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_WAITALL);
+	io_uring_sqe_set_data64(sqe, AS_SOCKET_URING_SEND);
+	sqe->flags |= IOSQE_IO_LINK;
+
+	sqe = io_uring_get_sqe(&t->ring);
+	io_uring_prep_recv(sqe, sock->fd, t->buf, sizeof(t->buf), 0);
+	io_uring_sqe_set_data64(sqe, AS_SOCKET_URING_RECV);
+
+	struct __kernel_timespec ts;
+	as_socket_uring_link_timeout(t, sqe, &ts, timeout);
+
+	int32_t res[3] = {0, 0, 0};
+	int rv = as_socket_uring_wait(t, 3, res);
+
+	if (rv < 0) {
+		return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", -rv);
+	}
+
+	int32_t sent = res[AS_SOCKET_URING_SEND];
+
+	if (sent == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+	}
+
+	if (sent < 0) {
+		if (sent != -EAGAIN && sent != -EINTR) {
+			return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", -sent);
+		}
+		sent = 0;
+	}
+
+	if ((size_t)sent < buf_len) {
+		// Socket buffer was full.  Send the rest normally.
+		return as_socket_uring_io(t, err, sock, node, true, buf + sent, buf_len - sent,
+								  socket_timeout, deadline);
+	}
+
+	int32_t r = res[AS_SOCKET_URING_RECV];
+
+	if (r == -ECANCELED) {
+		if (res[AS_SOCKET_URING_TIMEOUT] != -ETIME) {
+			// Receive did not run.  Next read receives directly.
+			return AEROSPIKE_OK;
+		}
+		r = AS_SOCKET_URING_TIMED_OUT;
+	}
+
+	// Save receive result for the next read on this socket.
+	t->fd = sock->fd;
+	t->res = r;
+	t->size = r > 0 ? (uint32_t)r : 0;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_socket_uring_read(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	as_socket_uring_thread* t = as_socket_uring_local;
+
+	if (t->fd == sock->fd) {
+		if (t->size > 0) {
+			size_t avail = t->size - t->pos;
+			size_t n = (buf_len < avail) ? buf_len : avail;
+
+			memcpy(buf, t->buf + t->pos, n);
+			t->pos += (uint32_t)n;
+
+			if (t->pos == t->size) {
+				as_socket_uring_reset(t);
+			}
+
+			if (n == buf_len) {
+				return AEROSPIKE_OK;
+			}
+			buf += n;
+			buf_len -= n;
+		}
+		else {
+			// Prefetch receive failed.  Report that failure now.
+			int32_t r = t->res;
+			as_socket_uring_reset(t);
+
+			if (r == AS_SOCKET_URING_TIMED_OUT) {
+				return as_socket_uring_timeout_error(err);
+			}
+
+			if (r == 0) {
+				return as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+			}
+
+			if (r != -EINTR && r != -EAGAIN) {
+				return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket read error", -r);
+			}
+		}
+	}
+	return as_socket_uring_io(t, err, sock, node, false, buf, buf_len, socket_timeout, deadline);
+}
+
+void
+as_socket_uring_discard(as_socket_fd fd)
+{
+	as_socket_uring_thread* t = as_socket_uring_local;
+
+	if (t && t->fd == fd) {
+		as_socket_uring_reset(t);
+	}
+}
+
+#else // AS_HAVE_LIBURING
+
+bool
+as_socket_uring_enable(bool enable)
+{
+	return false;
+}
+
+bool
+as_socket_uring_enabled(void)
+{
+	return false;
+}
+
+void
+as_socket_uring_release_thread(void)
+{
+}
+
+bool
+as_socket_uring_active(void)
+{
+	return false;
+}
+
+as_status
+as_socket_uring_write(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "io_uring not supported");
+}
+
+as_status
+as_socket_uring_write_prefetch(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "io_uring not supported");
+}
+
+as_status
+as_socket_uring_read(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "io_uring not supported");
+}
+
+void
+as_socket_uring_discard(as_socket_fd fd)
+{
+}
+
+#endif // AS_HAVE_LIBURING
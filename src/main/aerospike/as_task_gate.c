@@ -0,0 +1,162 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_task_gate.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <citrusleaf/cf_queue.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	as_task_fn task_fn;
+	void* task;
+	as_task_caller* caller;
+	uint64_t queued_us;
+} as_task_gate_item;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_task_gate_run(void* data)
+{
+	as_task_gate_item* item = data;
+	as_task_gate* gate = item->caller->gate;
+	uint64_t wait_us = cf_getus() - item->queued_us;
+
+	as_incr_uint64(&gate->wait_count);
+	as_add_uint64(&gate->wait_us, wait_us);
+	as_store_uint32(&item->caller->last_wait_us,
+		wait_us > UINT32_MAX ? UINT32_MAX : (uint32_t)wait_us);
+
+	as_task_fn task_fn = item->task_fn;
+	void* task = item->task;
+	cf_free(item);
+
+	// The caller may return as soon as the task signals completion, so do not reference
+	// the caller after this point.
+	task_fn(task);
+	as_decr_uint32(&gate->tasks);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_task_gate_init(
+	as_task_gate* gate, as_thread_pool* pool, as_work_pool* work_pool, bool adaptive
+	)
+{
+	gate->pool = pool;
+	gate->work_pool = (work_pool && work_pool->thread_size > 0)? work_pool : NULL;
+	gate->wait_count = 0;
+	gate->wait_us = 0;
+	gate->callers = 0;
+	gate->tasks = 0;
+	gate->adaptive = adaptive;
+}
+
+int
+as_task_gate_queue(as_task_gate* gate, as_task_fn task_fn, void* task)
+{
+	if (gate->work_pool) {
+		return as_work_pool_queue_task(gate->work_pool, task_fn, task);
+	}
+	return as_thread_pool_queue_task(gate->pool, task_fn, task);
+}
+
+uint32_t
+as_task_gate_queued(as_task_gate* gate)
+{
+	if (gate->work_pool) {
+		return as_work_pool_queued(gate->work_pool);
+	}
+	return cf_queue_sz(gate->pool->dispatch_queue);
+}
+
+void
+as_task_caller_init(as_task_caller* caller, as_task_gate* gate)
+{
+	caller->gate = gate;
+	caller->queued = 0;
+	caller->completed = 0;
+	caller->last_wait_us = 0;
+
+	if (gate->adaptive) {
+		as_incr_uint32(&gate->callers);
+	}
+}
+
+void
+as_task_caller_destroy(as_task_caller* caller)
+{
+	if (caller->gate->adaptive) {
+		as_decr_uint32(&caller->gate->callers);
+	}
+}
+
+bool
+as_task_caller_admit(as_task_caller* caller)
+{
+	as_task_gate* gate = caller->gate;
+	uint32_t pending = as_task_caller_pending(caller);
+
+	if (! gate->adaptive || pending == 0) {
+		return true;
+	}
+
+	uint32_t size = as_task_gate_threads(gate);
+	uint32_t callers = as_load_uint32(&gate->callers);
+	uint32_t share = callers > 0 ? size / callers : size;
+
+	if (pending < share) {
+		return true;
+	}
+
+	// Borrow idle threads only when this call's tasks are not waiting in the queue.
+	return as_load_uint32(&gate->tasks) < size &&
+		as_load_uint32(&caller->last_wait_us) < AS_TASK_GATE_MAX_WAIT_US;
+}
+
+int
+as_task_caller_queue(as_task_caller* caller, as_task_fn task_fn, void* task)
+{
+	as_task_gate* gate = caller->gate;
+
+	as_task_gate_item* item = cf_malloc(sizeof(as_task_gate_item));
+	item->task_fn = task_fn;
+	item->task = task;
+	item->caller = caller;
+	item->queued_us = cf_getus();
+
+	as_incr_uint32(&gate->tasks);
+
+	int rc = as_task_gate_queue(gate, as_task_gate_run, item);
+
+	if (rc) {
+		as_decr_uint32(&gate->tasks);
+		cf_free(item);
+		return rc;
+	}
+	caller->queued++;
+	return 0;
+}
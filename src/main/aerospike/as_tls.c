@@ -19,6 +19,7 @@
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_poll.h>
 #include <aerospike/ssl_util.h>
+#include <citrusleaf/alloc.h>
 #include <citrusleaf/cf_clock.h>
 #include <openssl/conf.h>
 #include <openssl/crypto.h>
@@ -41,6 +42,15 @@ static bool s_tls_inited = false;
 static pthread_mutex_t s_tls_init_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int s_ex_name_index = -1;
 static int s_ex_ctxt_index = -1;
+static int s_ex_session_index = -1;
+static int s_ex_generation_index = -1;
+
+// Cached client session for one node address and tls_name.
+typedef struct as_tls_session_s {
+	struct as_tls_session_s* next;
+	SSL_SESSION* session;
+	char key[];
+} as_tls_session;
 
 typedef enum as_tls_protocol_e {
 	// SSLv2 is always disabled per RFC 6176, we maintain knowledge of
@@ -259,6 +269,8 @@ as_tls_check_init()
 
 		s_ex_name_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
 		s_ex_ctxt_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+		s_ex_session_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+		s_ex_generation_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
 		
 		as_fence_memory();
 		
@@ -415,6 +427,74 @@ password_cb(char* buf, int size, int rwflag, void* udata)
 	return pw_len;
 }
 
+static int
+new_session_cb(SSL* ssl, SSL_SESSION* session)
+{
+	as_tls_session* entry = SSL_get_ex_data(ssl, s_ex_session_index);
+	as_tls_context* ctx = SSL_get_ex_data(ssl, s_ex_ctxt_index);
+
+	if (! entry || ! ctx) {
+		// Connection was not opened with a cache key.  Let OpenSSL free the session.
+		return 0;
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	SSL_SESSION* old = entry->session;
+	entry->session = session;
+
+	if (ctx->session_save) {
+		// Publish session, so other processes can resume it.
+		uint8_t buf[AS_TLS_SESSION_MAX];
+		int len = i2d_SSL_SESSION(session, NULL);
+
+		if (len > 0 && len <= (int)sizeof(buf)) {
+			uint8_t* p = buf;
+			i2d_SSL_SESSION(session, &p);
+			ctx->session_save(ctx->session_udata, entry->key, buf, (uint32_t)len);
+		}
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
+	if (old) {
+		SSL_SESSION_free(old);
+	}
+	// Keep session reference.
+	return 1;
+}
+
+static void
+sessions_clear(as_tls_context* ctx, bool destroy)
+{
+	as_tls_session* entry = ctx->sessions;
+
+	while (entry) {
+		as_tls_session* next = entry->next;
+
+		if (entry->session) {
+			SSL_SESSION_free(entry->session);
+			entry->session = NULL;
+		}
+
+		if (destroy) {
+			cf_free(entry);
+		}
+		entry = next;
+	}
+
+	if (destroy) {
+		ctx->sessions = NULL;
+	}
+}
+
+static void
+ssl_pool_clear(as_tls_context* ctx)
+{
+	for (uint32_t i = 0; i < ctx->ssl_pool_size; i++) {
+		SSL_free(ctx->ssl_pool[i]);
+	}
+	ctx->ssl_pool_size = 0;
+}
+
 as_status
 as_tls_context_setup(as_config_tls* tlscfg, as_tls_context* ctx, as_error* errp)
 {
@@ -424,6 +504,14 @@ as_tls_context_setup(as_config_tls* tlscfg, as_tls_context* ctx, as_error* errp)
 	ctx->cert_blacklist = NULL;
 	ctx->log_session_info = tlscfg->log_session_info;
 	ctx->for_login_only = tlscfg->for_login_only;
+	ctx->ktls = false;
+	ctx->sessions = NULL;
+	ctx->session_cache = tlscfg->session_cache;
+	ctx->session_load = NULL;
+	ctx->session_save = NULL;
+	ctx->session_udata = NULL;
+	ctx->ssl_pool_size = 0;
+	ctx->ssl_generation = 0;
 
 	as_tls_check_init();
 	pthread_mutex_init(&ctx->lock, NULL);
@@ -504,6 +592,23 @@ as_tls_context_setup(as_config_tls* tlscfg, as_tls_context* ctx, as_error* errp)
 	if (! (protocols & AS_TLS_PROTOCOL_TLSV1_2)) {
         SSL_CTX_set_options(ctx->ssl_ctx, SSL_OP_NO_TLSv1_2);
     }
+
+	if (tlscfg->session_cache) {
+		// Sessions are stored in as_tls_context, keyed by node address, when the server
+		// issues them.  TLS 1.3 tickets arrive after the handshake completes.
+		SSL_CTX_set_session_cache_mode(ctx->ssl_ctx,
+			SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx->ssl_ctx, new_session_cb);
+	}
+
+	if (tlscfg->enable_ktls) {
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+		SSL_CTX_set_options(ctx->ssl_ctx, SSL_OP_ENABLE_KTLS);
+		ctx->ktls = true;
+#else
+		as_log_warn("kTLS not supported by this OpenSSL build. Using user-space TLS.");
+#endif
+	}
 	
 	if (tlscfg->cafile || tlscfg->capath) {
 		int rv = SSL_CTX_load_verify_locations(ctx->ssl_ctx, tlscfg->cafile, tlscfg->capath);
@@ -651,6 +756,10 @@ as_tls_context_destroy(as_tls_context* ctx)
 		EVP_PKEY_free(ctx->pkey);
 	}
 	
+	// Free cached sessions and SSL objects before the SSL_CTX they reference.
+	sessions_clear(ctx, true);
+	ssl_pool_clear(ctx);
+
 	if (ctx->ssl_ctx) {
 		SSL_CTX_free(ctx->ssl_ctx);
 	}
@@ -709,6 +818,14 @@ as_tls_config_reload(as_config_tls* tlscfg, as_tls_context* ctx,
 		ctx->cert_blacklist = new_cbl;
 	}
 
+	// Sessions were established and SSL objects copied the previous certificates.
+	sessions_clear(ctx, false);
+	ssl_pool_clear(ctx);
+
+	// SSL objects still in use were created from the previous certificates.  Free them
+	// when they are released instead of returning them to the pool.
+	ctx->ssl_generation++;
+
 	pthread_mutex_unlock(&ctx->lock);
 	return AEROSPIKE_OK;
 }
@@ -720,7 +837,18 @@ as_tls_wrap(as_tls_context* ctx, as_socket* sock, const char* tls_name)
 	sock->tls_name = tls_name;
 
 	pthread_mutex_lock(&ctx->lock);
-	sock->ssl = SSL_new(ctx->ssl_ctx);
+
+	if (ctx->ssl_pool_size > 0) {
+		sock->ssl = ctx->ssl_pool[--ctx->ssl_pool_size];
+	}
+	else {
+		sock->ssl = SSL_new(ctx->ssl_ctx);
+
+		if (sock->ssl) {
+			SSL_set_ex_data(sock->ssl, s_ex_generation_index,
+				(void*)(uintptr_t)ctx->ssl_generation);
+		}
+	}
 	pthread_mutex_unlock(&ctx->lock);
 
 	if (sock->ssl == NULL)
@@ -739,6 +867,32 @@ as_tls_wrap(as_tls_context* ctx, as_socket* sock, const char* tls_name)
 	return 0;
 }
 
+void
+as_tls_release(as_tls_context* ctx, SSL* ssl)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+	// SSL_clear() keeps the handshake buffers and the settings copied from the SSL_CTX,
+	// which SSL_new() would otherwise allocate and copy again for the next connection.
+	if (SSL_clear(ssl) == 1) {
+		// Do not offer this connection's session to a different node.
+		SSL_set_session(ssl, NULL);
+		SSL_set_ex_data(ssl, s_ex_session_index, NULL);
+
+		uint32_t generation = (uint32_t)(uintptr_t)SSL_get_ex_data(ssl, s_ex_generation_index);
+
+		pthread_mutex_lock(&ctx->lock);
+
+		if (generation == ctx->ssl_generation && ctx->ssl_pool_size < AS_TLS_SSL_POOL_MAX) {
+			ctx->ssl_pool[ctx->ssl_pool_size++] = ssl;
+			pthread_mutex_unlock(&ctx->lock);
+			return;
+		}
+		pthread_mutex_unlock(&ctx->lock);
+	}
+#endif
+	SSL_free(ssl);
+}
+
 void
 as_tls_set_name(as_socket* sock, const char* tls_name)
 {
@@ -753,6 +907,59 @@ as_tls_set_context_name(struct ssl_st* ssl, as_tls_context* ctx, const char* tls
 	SSL_set_ex_data(ssl, s_ex_ctxt_index, ctx);
 }
 
+void
+as_tls_resume_session(as_socket* sock, struct sockaddr* addr)
+{
+	as_tls_context* ctx = sock->ctx;
+
+	if (! ctx->session_cache) {
+		return;
+	}
+
+	char name[AS_IP_ADDRESS_SIZE];
+	as_address_name(addr, name, sizeof(name));
+
+	char key[AS_IP_ADDRESS_SIZE + 256];
+	snprintf(key, sizeof(key), "%s/%s", sock->tls_name ? sock->tls_name : "", name);
+
+	pthread_mutex_lock(&ctx->lock);
+
+	as_tls_session* entry = ctx->sessions;
+
+	while (entry && strcmp(entry->key, key) != 0) {
+		entry = entry->next;
+	}
+
+	if (! entry) {
+		// Entries are only freed on context destroy, so connections can reference them.
+		size_t len = strlen(key) + 1;
+		entry = cf_malloc(sizeof(as_tls_session) + len);
+		entry->session = NULL;
+		memcpy(entry->key, key, len);
+		entry->next = ctx->sessions;
+		ctx->sessions = entry;
+	}
+
+	if (! entry->session && ctx->session_load) {
+		// Resume a session negotiated by another process.
+		uint8_t buf[AS_TLS_SESSION_MAX];
+		uint32_t size = sizeof(buf);
+
+		if (ctx->session_load(ctx->session_udata, key, buf, &size)) {
+			const uint8_t* p = buf;
+			entry->session = d2i_SSL_SESSION(NULL, &p, (long)size);
+		}
+	}
+
+	if (entry->session) {
+		SSL_set_session(sock->ssl, entry->session);
+	}
+
+	pthread_mutex_unlock(&ctx->lock);
+
+	SSL_set_ex_data(sock->ssl, s_ex_session_index, entry);
+}
+
 static void
 log_session_info(as_socket* sock)
 {
@@ -767,13 +974,26 @@ log_session_info(as_socket* sock)
 		if (len > 0) {
 			desc[len-1] = '\0';	// Trim trailing \n
 		}
-		as_log_info("TLS cipher: %s", desc);
+		as_log_info("TLS cipher: %s%s", desc,
+					SSL_session_reused(sock->ssl) ? " (resumed)" : "");
 	}
 	else {
 		as_log_warn("TLS no current cipher");
 	}
 }
 
+static void
+check_ktls(as_socket* sock)
+{
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	// OpenSSL enables kTLS during the handshake if the kernel supports the negotiated
+	// cipher.  Otherwise, the connection silently stays in user-space TLS.
+	if (sock->ctx->ktls && BIO_get_ktls_send(SSL_get_wbio(sock->ssl))) {
+		sock->ktls = true;
+	}
+#endif
+}
+
 static void
 log_verify_details(as_socket* sock)
 {
@@ -789,6 +1009,7 @@ as_tls_connect_once(as_socket* sock)
 	int rv = SSL_connect(sock->ssl);
 	if (rv == 1) {
 		log_session_info(sock);
+		check_ktls(sock);
 		return 1;
 	}
 
@@ -848,6 +1069,7 @@ as_tls_connect(as_socket* sock, uint64_t deadline)
 		rv = SSL_connect(sock->ssl);
 		if (rv == 1) {
 			log_session_info(sock);
+			check_ktls(sock);
 			return 0;
 		}
 
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_topology.h>
+#include <aerospike/as_address.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_node.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_socket.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define TOPOLOGY_MAGIC "ASTP"
+#define TOPOLOGY_VERSION 1
+
+// Header: magic(4) version(1) reserved(1) n_partitions(2) n_nodes(2) n_tables(2)
+//         cluster_name_len(1) cluster_name
+#define TOPOLOGY_HEADER_SIZE 13
+
+// Node: name_len(1) name tls_name_len(1) tls_name features(4) addr_len(1) addr
+// Table: ns_len(1) ns sc_mode(1) [master(2) prole(2)] * n_partitions
+#define TOPOLOGY_NODE_MAX (1 + AS_NODE_NAME_SIZE + 1 + 255 + 4 + 1 + \
+	sizeof(struct sockaddr_storage))
+#define TOPOLOGY_TABLE_HEADER_MAX (1 + AS_MAX_NAMESPACE_SIZE + 1)
+
+// Node index for partitions without a node.
+#define TOPOLOGY_NO_NODE 0xFFFF
+
+// Largest valid file.
+#define TOPOLOGY_FILE_MAX (16 * 1024 * 1024)
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint8_t*
+as_topology_write_str(uint8_t* p, const char* str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	if (len > 255) {
+		len = 255;
+	}
+	*p++ = (uint8_t)len;
+	memcpy(p, str, len);
+	return p + len;
+}
+
+static inline const uint8_t*
+as_topology_read_str(const uint8_t* p, const uint8_t* end, char* str, size_t size)
+{
+	if (p >= end) {
+		return NULL;
+	}
+
+	uint8_t len = *p++;
+
+	if (len >= size || p + len > end) {
+		return NULL;
+	}
+	memcpy(str, p, len);
+	str[len] = 0;
+	return p + len;
+}
+
+static uint16_t
+as_topology_node_index(as_nodes* nodes, as_node* node)
+{
+	if (! node) {
+		return TOPOLOGY_NO_NODE;
+	}
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		if (nodes->array[i] == node) {
+			return (uint16_t)i;
+		}
+	}
+	// Node was removed from the cluster, but is still referenced by the partition map.
+	return TOPOLOGY_NO_NODE;
+}
+
+static as_status
+as_topology_write(const char* path, uint8_t* bytes, size_t size, as_error* err)
+{
+	// Write temporary file and rename, so readers never see a partial snapshot.
+	char tmp[1024];
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Topology path too long: %s", path);
+	}
+
+	FILE* fp = fopen(tmp, "wb");
+
+	if (! fp) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", tmp, errno);
+	}
+
+	size_t n = fwrite(bytes, 1, size, fp);
+	int rc = fflush(fp);
+
+#if !defined(_MSC_VER)
+	if (rc == 0) {
+		rc = fsync(fileno(fp));
+	}
+#endif
+
+	if (fclose(fp) != 0) {
+		rc = -1;
+	}
+
+	if (n != size || rc != 0) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to write %s: %d", tmp, errno);
+	}
+
+#if defined(_MSC_VER)
+	// Windows rename() does not replace an existing file.
+	remove(path);
+#endif
+
+	if (rename(tmp, path) != 0) {
+		remove(tmp);
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to rename %s: %d", tmp, errno);
+	}
+	return AEROSPIKE_OK;
+}
+
+static uint8_t*
+as_topology_read(const char* path, as_error* err, size_t* size)
+{
+	FILE* fp = fopen(path, "rb");
+
+	if (! fp) {
+		as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to open %s: %d", path, errno);
+		return NULL;
+	}
+
+	uint8_t* bytes = cf_malloc(TOPOLOGY_FILE_MAX + 1);
+	*size = fread(bytes, 1, TOPOLOGY_FILE_MAX + 1, fp);
+	fclose(fp);
+
+	if (*size < TOPOLOGY_HEADER_SIZE || *size > TOPOLOGY_FILE_MAX) {
+		cf_free(bytes);
+		as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid topology file size: %s", path);
+		return NULL;
+	}
+	return bytes;
+}
+
+static void
+as_topology_destroy_nodes(as_vector* nodes, uint32_t offset)
+{
+	for (uint32_t i = offset; i < nodes->size; i++) {
+		as_node* node = as_vector_get_ptr(nodes, i);
+		as_node_destroy(node);
+	}
+	nodes->size = offset;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_topology_save(as_cluster* cluster, as_error* err)
+{
+	as_nodes* nodes = cluster->nodes;
+	as_partition_tables* tables = &cluster->partition_tables;
+	uint32_t n_partitions = cluster->n_partitions;
+
+	if (nodes->size >= TOPOLOGY_NO_NODE) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Too many nodes for topology: %u",
+			nodes->size);
+	}
+
+	size_t capacity = TOPOLOGY_HEADER_SIZE + 255 + (TOPOLOGY_NODE_MAX * nodes->size) +
+		((TOPOLOGY_TABLE_HEADER_MAX + (4 * n_partitions)) * tables->size);
+	uint8_t* bytes = cf_malloc(capacity);
+	uint8_t* p = bytes;
+
+	memcpy(p, TOPOLOGY_MAGIC, 4);
+	p += 4;
+	*p++ = TOPOLOGY_VERSION;
+	*p++ = 0;
+	*(uint16_t*)p = cf_swap_to_be16((uint16_t)n_partitions);
+	p += 2;
+	*(uint16_t*)p = cf_swap_to_be16((uint16_t)nodes->size);
+	p += 2;
+	*(uint16_t*)p = cf_swap_to_be16((uint16_t)tables->size);
+	p += 2;
+	p = as_topology_write_str(p, cluster->cluster_name);
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_node* node = nodes->array[i];
+		struct sockaddr* addr = (struct sockaddr*)&as_node_get_address(node)->addr;
+		socklen_t addr_len = as_address_size(addr);
+
+		p = as_topology_write_str(p, node->name);
+		p = as_topology_write_str(p, node->tls_name);
+		*(uint32_t*)p = cf_swap_to_be32(node->features);
+		p += 4;
+
+		// Socket address is stored in host format. Snapshots are not portable.
+		*p++ = (uint8_t)addr_len;
+		memcpy(p, addr, addr_len);
+		p += addr_len;
+	}
+
+	for (uint32_t i = 0; i < tables->size; i++) {
+		as_partition_table* table = tables->tables[i];
+
+		p = as_topology_write_str(p, table->ns);
+		*p++ = table->sc_mode ? 1 : 0;
+
+		for (uint32_t j = 0; j < table->size; j++) {
+			as_partition* part = &table->partitions[j];
+			*(uint16_t*)p = cf_swap_to_be16(as_topology_node_index(nodes, part->master));
+			p += 2;
+			*(uint16_t*)p = cf_swap_to_be16(as_topology_node_index(nodes, part->prole));
+			p += 2;
+		}
+	}
+
+	as_status status = as_topology_write(cluster->topology_file, bytes, p - bytes, err);
+	cf_free(bytes);
+	return status;
+}
+
+as_status
+as_topology_load(as_cluster* cluster, as_error* err, as_vector* nodes)
+{
+	const char* path = cluster->topology_file;
+	size_t size;
+	uint8_t* bytes = as_topology_read(path, err, &size);
+
+	if (! bytes) {
+		return err->code;
+	}
+
+	const uint8_t* p = bytes;
+	const uint8_t* end = bytes + size;
+	as_partition_tables* tables = &cluster->partition_tables;
+	uint32_t n_partitions_prev = cluster->n_partitions;
+	uint32_t offset = nodes->size;
+	as_partition* parts = NULL;
+
+	if (tables->size > 0) {
+		cf_free(bytes);
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT,
+			"Topology can't be loaded into a tended cluster");
+	}
+
+	if (memcmp(p, TOPOLOGY_MAGIC, 4) != 0 || p[4] != TOPOLOGY_VERSION) {
+		goto Invalid;
+	}
+	p += 6;
+
+	uint16_t n_partitions = cf_swap_from_be16(*(uint16_t*)p);
+	p += 2;
+	uint16_t n_nodes = cf_swap_from_be16(*(uint16_t*)p);
+	p += 2;
+	uint16_t n_tables = cf_swap_from_be16(*(uint16_t*)p);
+	p += 2;
+
+	if (n_partitions == 0 || n_partitions > 4096 || (n_partitions & (n_partitions - 1)) != 0 ||
+		(n_partitions_prev != 0 && n_partitions_prev != n_partitions) ||
+		n_nodes == 0 || n_tables > AS_MAX_NAMESPACES) {
+		goto Invalid;
+	}
+
+	char cluster_name[256];
+	p = as_topology_read_str(p, end, cluster_name, sizeof(cluster_name));
+
+	if (! p) {
+		goto Invalid;
+	}
+
+	if (strcmp(cluster_name, cluster->cluster_name ? cluster->cluster_name : "") != 0) {
+		cf_free(bytes);
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Topology file %s is for cluster '%s'", path, cluster_name);
+	}
+
+	for (uint16_t i = 0; i < n_nodes; i++) {
+		char tls_name[256];
+		as_node_info node_info;
+		memset(&node_info, 0, sizeof(as_node_info));
+
+		p = as_topology_read_str(p, end, node_info.name, sizeof(node_info.name));
+
+		if (p) {
+			p = as_topology_read_str(p, end, tls_name, sizeof(tls_name));
+		}
+
+		if (! p || p + 5 > end) {
+			goto Invalid;
+		}
+
+		node_info.features = cf_swap_from_be32(*(uint32_t*)p);
+		p += 4;
+
+		uint8_t addr_len = *p++;
+
+		if (addr_len < sizeof(struct sockaddr) || addr_len > sizeof(struct sockaddr_storage) ||
+			p + addr_len > end) {
+			goto Invalid;
+		}
+		memcpy(&node_info.addr, p, addr_len);
+		p += addr_len;
+
+		struct sockaddr* addr = (struct sockaddr*)&node_info.addr;
+
+		if ((addr->sa_family != AF_INET && addr->sa_family != AF_INET6) ||
+			addr_len != as_address_size(addr)) {
+			goto Invalid;
+		}
+
+		// The tend connection is opened and authenticated when the node is added.
+		node_info.host.tls_name = tls_name[0] ? tls_name : NULL;
+		as_socket_init(&node_info.socket);
+		node_info.session = NULL;
+
+		as_node* node = as_node_create(cluster, &node_info);
+		as_vector_append(nodes, &node);
+	}
+
+	cluster->n_partitions = n_partitions;
+
+	parts = cf_malloc(sizeof(as_partition) * n_partitions);
+
+	for (uint16_t i = 0; i < n_tables; i++) {
+		char ns[AS_MAX_NAMESPACE_SIZE];
+		p = as_topology_read_str(p, end, ns, sizeof(ns));
+
+		if (! p || p + 1 + (4 * n_partitions) > end) {
+			goto Invalid;
+		}
+
+		bool sc_mode = *p++ != 0;
+
+		for (uint16_t j = 0; j < n_partitions; j++) {
+			uint16_t master = cf_swap_from_be16(*(uint16_t*)p);
+			p += 2;
+			uint16_t prole = cf_swap_from_be16(*(uint16_t*)p);
+			p += 2;
+
+			if ((master != TOPOLOGY_NO_NODE && master >= n_nodes) ||
+				(prole != TOPOLOGY_NO_NODE && prole >= n_nodes)) {
+				goto Invalid;
+			}
+
+			as_partition* part = &parts[j];
+			part->master = (master == TOPOLOGY_NO_NODE) ? NULL :
+				as_vector_get_ptr(nodes, offset + master);
+			part->prole = (prole == TOPOLOGY_NO_NODE) ? NULL :
+				as_vector_get_ptr(nodes, offset + prole);
+			part->regime = 0;
+		}
+
+		if (! as_partition_tables_restore(cluster, ns, sc_mode, parts)) {
+			goto Invalid;
+		}
+	}
+
+	if (p != end) {
+		goto Invalid;
+	}
+
+	cf_free(parts);
+	cf_free(bytes);
+	return AEROSPIKE_OK;
+
+Invalid:
+	// Partition maps hold node references, so drop tables before nodes.
+	as_partition_tables_destroy(tables);
+	tables->size = 0;
+	cluster->n_partitions = n_partitions_prev;
+	as_topology_destroy_nodes(nodes, offset);
+	cf_free(parts);
+	cf_free(bytes);
+	return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid topology file: %s", path);
+}
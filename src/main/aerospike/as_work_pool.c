@@ -0,0 +1,341 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_work_pool.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_cpu.h>
+#include <aerospike/as_log_macros.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <string.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_WORK_DEQUE_INITIAL_CAPACITY 64
+
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+// Pool worker running on the current thread.  Tasks queued from a worker thread are pushed
+// to that worker's own deque.
+static AS_THREAD_LOCAL as_work_worker* as_work_current = NULL;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_work_deque_init(as_work_deque* dq)
+{
+	pthread_mutex_init(&dq->lock, NULL);
+	dq->items = cf_malloc(sizeof(as_work_item) * AS_WORK_DEQUE_INITIAL_CAPACITY);
+	dq->capacity = AS_WORK_DEQUE_INITIAL_CAPACITY;
+	dq->head = 0;
+	dq->size = 0;
+}
+
+static void
+as_work_deque_destroy(as_work_deque* dq)
+{
+	cf_free(dq->items);
+	pthread_mutex_destroy(&dq->lock);
+}
+
+static void
+as_work_deque_push(as_work_deque* dq, const as_work_item* item)
+{
+	pthread_mutex_lock(&dq->lock);
+
+	if (dq->size == dq->capacity) {
+		// Unwrap ring into a buffer twice the size.
+		uint32_t capacity = dq->capacity * 2;
+		as_work_item* items = cf_malloc(sizeof(as_work_item) * capacity);
+		uint32_t first = dq->capacity - dq->head;
+
+		memcpy(items, &dq->items[dq->head], sizeof(as_work_item) * first);
+		memcpy(&items[first], dq->items, sizeof(as_work_item) * dq->head);
+		cf_free(dq->items);
+		dq->items = items;
+		dq->capacity = capacity;
+		dq->head = 0;
+	}
+
+	dq->items[(dq->head + dq->size) % dq->capacity] = *item;
+	as_store_uint32(&dq->size, dq->size + 1);
+	pthread_mutex_unlock(&dq->lock);
+}
+
+static bool
+as_work_deque_pop(as_work_deque* dq, as_work_item* item, bool steal)
+{
+	// Skip empty deques without taking the lock.
+	if (as_load_uint32(&dq->size) == 0) {
+		return false;
+	}
+
+	pthread_mutex_lock(&dq->lock);
+
+	if (dq->size == 0) {
+		pthread_mutex_unlock(&dq->lock);
+		return false;
+	}
+
+	if (steal) {
+		// Thieves take from the tail, away from the owner.
+		*item = dq->items[(dq->head + dq->size - 1) % dq->capacity];
+	}
+	else {
+		*item = dq->items[dq->head];
+		dq->head = (dq->head + 1) % dq->capacity;
+	}
+	as_store_uint32(&dq->size, dq->size - 1);
+	pthread_mutex_unlock(&dq->lock);
+	return true;
+}
+
+static bool
+as_work_pool_take(as_work_worker* worker, as_work_item* item)
+{
+	if (as_work_deque_pop(&worker->deque, item, false)) {
+		return true;
+	}
+
+	as_work_pool* pool = worker->pool;
+
+	for (uint32_t i = 1; i < pool->thread_size; i++) {
+		as_work_worker* victim = &pool->workers[(worker->index + i) % pool->thread_size];
+
+		if (as_work_deque_pop(&victim->deque, item, true)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+as_work_pool_spin(as_work_pool* pool)
+{
+	if (pool->spin_us == 0) {
+		return false;
+	}
+
+	uint64_t limit = cf_getus() + pool->spin_us;
+
+	do {
+		if (as_load_uint32(&pool->pending) > 0) {
+			return true;
+		}
+	} while (cf_getus() < limit);
+
+	return false;
+}
+
+static bool
+as_work_pool_park(as_work_pool* pool)
+{
+	pthread_mutex_lock(&pool->park_lock);
+	as_incr_uint32(&pool->sleepers);
+
+	// Pairs with the fence in as_work_pool_queue_task(), so either this thread sees the new
+	// task or the producer sees this sleeper and signals.
+	as_fence_seq();
+
+	while (as_load_uint32(&pool->pending) == 0 && ! as_load_uint8(&pool->shutdown)) {
+		pthread_cond_wait(&pool->park_cond, &pool->park_lock);
+	}
+
+	as_decr_uint32(&pool->sleepers);
+
+	// Keep running until tasks queued before shutdown have been taken.
+	bool run = as_load_uint32(&pool->pending) > 0 || ! as_load_uint8(&pool->shutdown);
+	pthread_mutex_unlock(&pool->park_lock);
+	return run;
+}
+
+static void*
+as_work_pool_run(void* data)
+{
+	as_work_worker* worker = data;
+	as_work_pool* pool = worker->pool;
+	as_work_item item;
+
+	as_work_current = worker;
+
+	while (true) {
+		if (as_work_pool_take(worker, &item)) {
+			as_decr_uint32(&pool->pending);
+			item.task_fn(item.task);
+			continue;
+		}
+
+		if (as_work_pool_spin(pool)) {
+			continue;
+		}
+
+		if (! as_work_pool_park(pool)) {
+			break;
+		}
+	}
+
+	if (pool->fini_fn) {
+		pool->fini_fn();
+	}
+	return NULL;
+}
+
+static int
+as_work_thread_create(as_work_worker* worker, int cpu)
+{
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+
+	if (cpu >= 0 && as_cpu_assign_thread_attr(&attr, cpu) != 0) {
+		as_log_warn("Failed to assign thread pool thread %u to cpu %d", worker->index, cpu);
+	}
+
+	int rc = pthread_create(&worker->thread, &attr, as_work_pool_run, worker);
+	pthread_attr_destroy(&attr);
+
+	if (rc) {
+		return rc;
+	}
+
+	if (cpu >= 0 && as_cpu_assign_thread(worker->thread, cpu) != 0) {
+		as_log_warn("Failed to assign thread pool thread %u to cpu %d", worker->index, cpu);
+	}
+	return 0;
+}
+
+static void
+as_work_pool_stop(as_work_pool* pool, uint32_t n_threads)
+{
+	pthread_mutex_lock(&pool->park_lock);
+	as_store_uint8(&pool->shutdown, 1);
+	pthread_cond_broadcast(&pool->park_cond);
+	pthread_mutex_unlock(&pool->park_lock);
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	for (uint32_t i = 0; i < pool->thread_size; i++) {
+		as_work_deque_destroy(&pool->workers[i].deque);
+	}
+
+	cf_free(pool->workers);
+	pool->workers = NULL;
+	pool->thread_size = 0;
+	pthread_cond_destroy(&pool->park_cond);
+	pthread_mutex_destroy(&pool->park_lock);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+int
+as_work_pool_init(
+	as_work_pool* pool, uint32_t thread_size, uint32_t spin_us, int cpu, as_fini_fn fini_fn
+	)
+{
+	memset(pool, 0, sizeof(as_work_pool));
+
+	if (thread_size == 0) {
+		return 0;
+	}
+
+	pthread_mutex_init(&pool->park_lock, NULL);
+	pthread_cond_init(&pool->park_cond, NULL);
+	pool->fini_fn = fini_fn;
+	pool->thread_size = thread_size;
+	pool->spin_us = spin_us;
+	pool->workers = cf_malloc(sizeof(as_work_worker) * thread_size);
+
+	// Create all deques before any thread can steal from them.
+	for (uint32_t i = 0; i < thread_size; i++) {
+		as_work_worker* worker = &pool->workers[i];
+		worker->pool = pool;
+		worker->index = i;
+		as_work_deque_init(&worker->deque);
+	}
+
+	for (uint32_t i = 0; i < thread_size; i++) {
+		int rc = as_work_thread_create(&pool->workers[i], cpu >= 0 ? cpu + (int)i : -1);
+
+		if (rc) {
+			as_work_pool_stop(pool, i);
+			return rc;
+		}
+	}
+	return 0;
+}
+
+int
+as_work_pool_queue_task(as_work_pool* pool, as_task_fn task_fn, void* task)
+{
+	if (pool->thread_size == 0) {
+		return -1;
+	}
+
+	if (as_load_uint8(&pool->shutdown)) {
+		return -2;
+	}
+
+	as_work_worker* worker = as_work_current;
+
+	if (! worker || worker->pool != pool) {
+		worker = &pool->workers[as_faa_uint32(&pool->next, 1) % pool->thread_size];
+	}
+
+	as_work_item item = {task_fn, task};
+
+	// Count task before it becomes visible, so a worker that takes it never sees a
+	// negative pending count.
+	as_incr_uint32(&pool->pending);
+	as_work_deque_push(&worker->deque, &item);
+	as_fence_seq();
+
+	if (as_load_uint32(&pool->sleepers) > 0) {
+		pthread_mutex_lock(&pool->park_lock);
+		pthread_cond_signal(&pool->park_cond);
+		pthread_mutex_unlock(&pool->park_lock);
+	}
+	return 0;
+}
+
+void
+as_work_pool_destroy(as_work_pool* pool)
+{
+	if (pool->thread_size == 0) {
+		return;
+	}
+	as_work_pool_stop(pool, pool->thread_size);
+}
+
+uint32_t
+as_work_pool_queued(as_work_pool* pool)
+{
+	return as_load_uint32(&pool->pending);
+}
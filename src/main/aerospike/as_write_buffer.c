@@ -0,0 +1,594 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_write_buffer.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_geojson.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_thread.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <errno.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static uint32_t
+as_write_buffer_value_size(as_val* val)
+{
+	// Rough estimate of the value's wire size.  Only used to bound buffer memory.
+	if (! val) {
+		return 0;
+	}
+
+	switch (as_val_type(val)) {
+		case AS_STRING:
+			return (uint32_t)as_string_len((as_string*)val);
+		case AS_BYTES:
+			return as_bytes_size((as_bytes*)val);
+		case AS_GEOJSON:
+			return (uint32_t)as_geojson_len((as_geojson*)val);
+		case AS_LIST:
+			return as_list_size((as_list*)val) * 16;
+		case AS_MAP:
+			return as_map_size((as_map*)val) * 32;
+		default:
+			return 8;
+	}
+}
+
+static uint32_t
+as_write_buffer_ops_size(as_operations* ops)
+{
+	uint32_t size = sizeof(as_batch_record) + sizeof(as_write_buffer_entry);
+
+	for (uint16_t i = 0; i < ops->binops.size; i++) {
+		as_bin* bin = &ops->binops.entries[i].bin;
+		size += sizeof(as_binop) + as_write_buffer_value_size((as_val*)bin->valuep);
+	}
+	return size;
+}
+
+static void
+as_write_buffer_copy_key(as_key* trg, const as_key* src)
+{
+	// The buffered key must not reference caller memory.
+	as_val* val = (as_val*)src->valuep;
+
+	if (! val) {
+		as_key_init_digest(trg, src->ns, src->set, src->digest.value);
+		return;
+	}
+
+	switch (as_val_type(val)) {
+		case AS_INTEGER:
+			as_key_init_int64(trg, src->ns, src->set, as_integer_get((as_integer*)val));
+			break;
+
+		case AS_STRING:
+			as_key_init_strp(trg, src->ns, src->set, cf_strdup(as_string_get((as_string*)val)),
+				true);
+			break;
+
+		case AS_BYTES: {
+			as_bytes* b = (as_bytes*)val;
+			uint8_t* bytes = cf_malloc(b->size);
+			memcpy(bytes, b->value, b->size);
+			as_key_init_rawp(trg, src->ns, src->set, bytes, b->size, true);
+			break;
+		}
+
+		default:
+			as_key_init_digest(trg, src->ns, src->set, src->digest.value);
+			return;
+	}
+	memcpy(trg->digest.value, src->digest.value, AS_DIGEST_VALUE_SIZE);
+	trg->digest.init = true;
+}
+
+static void
+as_write_buffer_entry_destroy(as_write_buffer_entry* entry, as_operations* ops)
+{
+	if (entry->rec) {
+		// Put operations reference the record's bin values, so only the record destroys them.
+		ops->binops.size = 0;
+		as_operations_destroy(ops);
+		as_record_destroy(entry->rec);
+	}
+	else {
+		as_operations_destroy(ops);
+	}
+}
+
+static void
+as_write_buffer_send(as_write_buffer* wb, as_write_buffer_node* batch)
+{
+	as_error err;
+	as_status status = aerospike_batch_write(wb->as, &err, &wb->policy.batch, batch->records);
+
+	as_vector* list = &batch->records->list;
+	uint64_t bytes = 0;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_write_record* rec = as_vector_get(list, i);
+		as_write_buffer_entry* entry = &batch->entries[i];
+
+		if (entry->listener) {
+			if (rec->result == AEROSPIKE_OK) {
+				entry->listener(NULL, entry->udata);
+			}
+			else if (rec->result == AEROSPIKE_NO_RESPONSE && status != AEROSPIKE_OK) {
+				// Batch failed before this record was processed.
+				entry->listener(&err, entry->udata);
+			}
+			else {
+				as_error e;
+				as_error_set_message(&e, rec->result, as_error_string(rec->result));
+				e.in_doubt = rec->in_doubt;
+				entry->listener(&e, entry->udata);
+			}
+		}
+		as_write_buffer_entry_destroy(entry, rec->ops);
+		bytes += entry->bytes;
+	}
+	as_batch_records_destroy(batch->records);
+	cf_free(batch->entries);
+	cf_free(batch->key_slots);
+
+	pthread_mutex_lock(&wb->lock);
+	wb->bytes -= bytes;
+	pthread_cond_broadcast(&wb->space_cond);
+	pthread_mutex_unlock(&wb->lock);
+}
+
+static void
+as_write_buffer_detach(as_write_buffer* wb, as_vector* ready, uint64_t now, bool all)
+{
+	// Must hold lock.
+	for (uint32_t i = 0; i < wb->nodes.size; i++) {
+		as_write_buffer_node* bn = as_vector_get(&wb->nodes, i);
+
+		if (bn->records && (all || now - bn->first_ms >= wb->policy.flush_interval_ms)) {
+			as_vector_append(ready, bn);
+			bn->records = NULL;
+			bn->entries = NULL;
+			bn->key_slots = NULL;
+		}
+	}
+}
+
+static void
+as_write_buffer_send_ready(as_write_buffer* wb, as_vector* ready)
+{
+	// Must not hold lock.
+	for (uint32_t i = 0; i < ready->size; i++) {
+		as_write_buffer_send(wb, as_vector_get(ready, i));
+	}
+	ready->size = 0;
+}
+
+static void*
+as_write_buffer_run(void* udata)
+{
+	as_thread_set_name("wbuffer");
+
+	as_write_buffer* wb = udata;
+
+	struct timespec delta;
+	cf_clock_set_timespec_ms(wb->policy.flush_interval_ms, &delta);
+
+	struct timespec abstime;
+
+	as_vector ready;
+	as_vector_init(&ready, sizeof(as_write_buffer_node), 8);
+
+	pthread_mutex_lock(&wb->lock);
+
+	while (wb->valid) {
+		// Convert flush interval into absolute timeout.
+		cf_clock_current_add(&delta, &abstime);
+		pthread_cond_timedwait(&wb->flush_cond, &wb->lock, &abstime);
+
+		as_write_buffer_detach(wb, &ready, cf_getms(), false);
+
+		if (ready.size > 0) {
+			pthread_mutex_unlock(&wb->lock);
+			as_write_buffer_send_ready(wb, &ready);
+			pthread_mutex_lock(&wb->lock);
+		}
+	}
+	pthread_mutex_unlock(&wb->lock);
+	as_vector_destroy(&ready);
+	return NULL;
+}
+
+static void
+as_write_buffer_drain(as_write_buffer* wb)
+{
+	as_vector ready;
+	as_vector_init(&ready, sizeof(as_write_buffer_node), 8);
+
+	pthread_mutex_lock(&wb->lock);
+	as_write_buffer_detach(wb, &ready, 0, true);
+	pthread_mutex_unlock(&wb->lock);
+
+	as_write_buffer_send_ready(wb, &ready);
+	as_vector_destroy(&ready);
+
+	// Wait for batches sent by other threads.
+	pthread_mutex_lock(&wb->lock);
+
+	while (wb->bytes > 0) {
+		pthread_cond_wait(&wb->space_cond, &wb->lock);
+	}
+	pthread_mutex_unlock(&wb->lock);
+}
+
+static as_write_buffer_node*
+as_write_buffer_node_find(as_write_buffer* wb, as_node* node)
+{
+	// Must hold lock.  Node count is small, so use linear search.
+	for (uint32_t i = 0; i < wb->nodes.size; i++) {
+		as_write_buffer_node* bn = as_vector_get(&wb->nodes, i);
+
+		if (bn->node == node) {
+			return bn;
+		}
+	}
+	return NULL;
+}
+
+static as_write_buffer_node*
+as_write_buffer_node_get(as_write_buffer* wb, as_node* node)
+{
+	// Must hold lock.
+	as_write_buffer_node* bn = as_write_buffer_node_find(wb, node);
+
+	if (! bn) {
+		bn = as_vector_reserve(&wb->nodes);
+		bn->node = node;
+	}
+	return bn;
+}
+
+static inline uint32_t
+as_write_buffer_key_mask(as_write_buffer* wb)
+{
+	// Keep key table at most half full.
+	uint32_t n = 2;
+
+	while (n < wb->policy.max_node_records * 2) {
+		n <<= 1;
+	}
+	return n - 1;
+}
+
+static uint32_t*
+as_write_buffer_key_find(as_write_buffer* wb, as_write_buffer_node* bn, const as_key* key)
+{
+	// Must hold lock.  Return matching slot or the empty slot where the key belongs.
+	uint32_t mask = as_write_buffer_key_mask(wb);
+	uint32_t h;
+	memcpy(&h, key->digest.value, sizeof(h));
+
+	for (uint32_t i = h & mask; ; i = (i + 1) & mask) {
+		uint32_t* slot = &bn->key_slots[i];
+
+		if (*slot == 0) {
+			return slot;
+		}
+
+		as_batch_write_record* r = as_vector_get(&bn->records->list, *slot - 1);
+
+		if (memcmp(r->key.digest.value, key->digest.value, AS_DIGEST_VALUE_SIZE) == 0 &&
+			strcmp(r->key.ns, key->ns) == 0) {
+			return slot;
+		}
+	}
+}
+
+static bool
+as_write_buffer_touch_merge(
+	as_write_buffer* wb, as_write_buffer_node* bn, const as_key* key, as_operations* ops
+	)
+{
+	// Must hold lock.  A key appears at most once in a node batch, so a waiting touch is
+	// never followed by another write of the same key and can take the latest TTL.
+	if (! bn || ! bn->records) {
+		return false;
+	}
+
+	uint32_t* slot = as_write_buffer_key_find(wb, bn, key);
+
+	if (*slot == 0 || ! bn->entries[*slot - 1].touch) {
+		return false;
+	}
+
+	as_batch_write_record* prev = as_vector_get(&bn->records->list, *slot - 1);
+	prev->ops->ttl = ops->ttl;
+	return true;
+}
+
+static as_status
+as_write_buffer_add(
+	as_write_buffer* wb, as_error* err, const as_key* key, as_operations* ops, as_record* rec,
+	as_write_buffer_listener listener, void* udata, bool touch
+	)
+{
+	as_error_reset(err);
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_cluster* cluster = wb->as->cluster;
+	as_partition_info pi;
+	status = as_partition_info_init(&pi, cluster, err, key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	// Node is only used to group writes.  The batch maps keys to nodes again when it is sent.
+	// A key without a node is grouped with other unmapped keys and fails in the batch.
+	as_node* node = as_partition_get_node(cluster, pi.ns, pi.partition, NULL,
+		AS_POLICY_REPLICA_MASTER, true);
+
+	uint32_t bytes = as_write_buffer_ops_size(ops);
+	uint32_t max = wb->policy.max_node_records;
+
+	pthread_mutex_lock(&wb->lock);
+
+	// A coalesced touch adds no bytes, so do not wait for space.
+	if (touch && wb->valid && as_write_buffer_touch_merge(wb,
+		as_write_buffer_node_find(wb, node), key, ops)) {
+		pthread_mutex_unlock(&wb->lock);
+		as_operations_destroy(ops);
+		return AEROSPIKE_OK;
+	}
+
+	// Block until earlier batches complete.  A write is always accepted into an empty buffer,
+	// so a single write larger than max_bytes can not block forever.
+	while (wb->valid && wb->bytes > 0 && wb->bytes + bytes > wb->policy.max_bytes) {
+		pthread_cond_wait(&wb->space_cond, &wb->lock);
+	}
+
+	if (! wb->valid) {
+		pthread_mutex_unlock(&wb->lock);
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Write buffer is closed");
+	}
+
+	as_write_buffer_node* bn;
+	uint32_t* slot;
+
+	while (true) {
+		bn = as_write_buffer_node_get(wb, node);
+
+		if (! bn->records) {
+			bn->records = as_batch_records_create(max);
+			bn->entries = cf_malloc(sizeof(as_write_buffer_entry) * max);
+			bn->key_slots = cf_calloc(as_write_buffer_key_mask(wb) + 1, sizeof(uint32_t));
+			bn->first_ms = cf_getms();
+		}
+
+		slot = as_write_buffer_key_find(wb, bn, key);
+
+		if (*slot == 0) {
+			break;
+		}
+
+		if (touch && as_write_buffer_touch_merge(wb, bn, key, ops)) {
+			// Another thread buffered a touch of the key while this touch waited for space.
+			pthread_mutex_unlock(&wb->lock);
+			as_operations_destroy(ops);
+			return AEROSPIKE_OK;
+		}
+
+		// The server does not order records within a batch, so a second write of a key
+		// waits until the batch holding the first write completes.
+		as_write_buffer_node ready = *bn;
+		bn->records = NULL;
+		bn->entries = NULL;
+		bn->key_slots = NULL;
+		pthread_mutex_unlock(&wb->lock);
+
+		as_write_buffer_send(wb, &ready);
+
+		pthread_mutex_lock(&wb->lock);
+
+		if (! wb->valid) {
+			pthread_mutex_unlock(&wb->lock);
+			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Write buffer is closed");
+		}
+	}
+
+	as_batch_write_record* r = as_batch_write_reserve(bn->records);
+	as_write_buffer_copy_key(&r->key, key);
+	r->ops = ops;
+
+	as_write_buffer_entry* entry = &bn->entries[bn->records->list.size - 1];
+	entry->listener = listener;
+	entry->udata = udata;
+	entry->rec = rec;
+	entry->bytes = bytes;
+	entry->touch = touch;
+	wb->bytes += bytes;
+	*slot = bn->records->list.size;
+
+	as_write_buffer_node ready;
+	bool full = bn->records->list.size >= max;
+
+	if (full) {
+		ready = *bn;
+		bn->records = NULL;
+		bn->entries = NULL;
+		bn->key_slots = NULL;
+	}
+	pthread_mutex_unlock(&wb->lock);
+
+	if (full) {
+		// Send in the writer's thread, which also throttles the writer.
+		as_write_buffer_send(wb, &ready);
+	}
+	return AEROSPIKE_OK;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_write_buffer*
+as_write_buffer_create(aerospike* as, as_error* err, const as_write_buffer_policy* policy)
+{
+	as_error_reset(err);
+
+	as_write_buffer_policy pol_local;
+
+	if (! policy) {
+		as_write_buffer_policy_init(&pol_local);
+		policy = &pol_local;
+	}
+
+	if (policy->max_node_records == 0 || policy->flush_interval_ms == 0) {
+		as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+			"max_node_records and flush_interval_ms must be > 0");
+		return NULL;
+	}
+
+	as_write_buffer* wb = cf_malloc(sizeof(as_write_buffer));
+	wb->as = as;
+	wb->policy = *policy;
+	as_vector_init(&wb->nodes, sizeof(as_write_buffer_node), 8);
+	pthread_mutex_init(&wb->lock, NULL);
+	pthread_cond_init(&wb->space_cond, NULL);
+	pthread_cond_init(&wb->flush_cond, NULL);
+	wb->bytes = 0;
+	wb->valid = true;
+
+	if (pthread_create(&wb->flush_thread, NULL, as_write_buffer_run, wb) != 0) {
+		as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to create write buffer thread: %s",
+			strerror(errno));
+		pthread_cond_destroy(&wb->flush_cond);
+		pthread_cond_destroy(&wb->space_cond);
+		pthread_mutex_destroy(&wb->lock);
+		as_vector_destroy(&wb->nodes);
+		cf_free(wb);
+		return NULL;
+	}
+	return wb;
+}
+
+as_status
+as_write_buffer_put(
+	as_write_buffer* wb, as_error* err, const as_key* key, as_record* rec,
+	as_write_buffer_listener listener, void* udata
+	)
+{
+	as_operations* ops = as_operations_new(rec->bins.size);
+
+	for (uint16_t i = 0; i < rec->bins.size; i++) {
+		as_bin* bin = &rec->bins.entries[i];
+		as_operations_add_write(ops, bin->name, bin->valuep);
+	}
+	ops->ttl = rec->ttl;
+	ops->gen = rec->gen;
+
+	as_status status = as_write_buffer_add(wb, err, key, ops, rec, listener, udata, false);
+
+	if (status != AEROSPIKE_OK) {
+		// Record remains owned by caller.
+		ops->binops.size = 0;
+		as_operations_destroy(ops);
+	}
+	return status;
+}
+
+as_status
+as_write_buffer_operate(
+	as_write_buffer* wb, as_error* err, const as_key* key, as_operations* ops,
+	as_write_buffer_listener listener, void* udata
+	)
+{
+	return as_write_buffer_add(wb, err, key, ops, NULL, listener, udata, false);
+}
+
+as_status
+as_write_buffer_touch(as_write_buffer* wb, as_error* err, const as_key* key, uint32_t ttl)
+{
+	as_operations* ops = as_operations_new(1);
+	as_operations_add_touch(ops);
+	ops->ttl = ttl;
+
+	as_status status = as_write_buffer_add(wb, err, key, ops, NULL, NULL, NULL, true);
+
+	if (status != AEROSPIKE_OK) {
+		as_operations_destroy(ops);
+	}
+	return status;
+}
+
+as_status
+as_write_buffer_get_touch(
+	as_write_buffer* wb, as_error* err, const as_policy_read* policy, const as_key* key,
+	as_record** rec, uint32_t ttl
+	)
+{
+	as_status status = aerospike_key_get(wb->as, err, policy, key, rec);
+
+	if (status == AEROSPIKE_OK) {
+		// The read already succeeded, so a rejected touch is not reported.
+		as_error terr;
+		as_write_buffer_touch(wb, &terr, key, ttl);
+	}
+	return status;
+}
+
+void
+as_write_buffer_flush(as_write_buffer* wb)
+{
+	as_write_buffer_drain(wb);
+}
+
+void
+as_write_buffer_destroy(as_write_buffer* wb)
+{
+	pthread_mutex_lock(&wb->lock);
+	wb->valid = false;
+	pthread_cond_broadcast(&wb->flush_cond);
+	pthread_cond_broadcast(&wb->space_cond);
+	pthread_mutex_unlock(&wb->lock);
+
+	pthread_join(wb->flush_thread, NULL);
+
+	// Writes accepted before the buffer was closed are still sent.
+	as_write_buffer_drain(wb);
+
+	pthread_cond_destroy(&wb->flush_cond);
+	pthread_cond_destroy(&wb->space_cond);
+	pthread_mutex_destroy(&wb->lock);
+	as_vector_destroy(&wb->nodes);
+	cf_free(wb);
+}
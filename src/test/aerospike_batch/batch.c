@@ -16,6 +16,7 @@
  */
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_bulk.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_atomic.h>
@@ -32,6 +33,8 @@
 #include <aerospike/as_string.h>
 #include <aerospike/as_tls.h>
 #include <aerospike/as_val.h>
+#include <aerospike/as_write_buffer.h>
+#include <citrusleaf/cf_clock.h>
 #include <pthread.h>
 #include "../test.h"
 #include "../util/log_helper.h"
@@ -735,6 +738,714 @@ TEST(batch_remove, "Batch remove")
 	assert_int_eq(errors, 0);
 }
 
+static void
+write_buffer_cb(as_error* err, void* udata)
+{
+	if (! err) {
+		as_incr_uint32((uint32_t*)udata);
+	}
+}
+
+TEST(batch_write_buffer, "Write buffer")
+{
+	as_error err;
+	as_write_buffer_policy p;
+	as_write_buffer_policy_init(&p);
+	p.max_node_records = 8;
+
+	as_write_buffer* wb = as_write_buffer_create(as, &err, &p);
+	assert_not_null(wb);
+
+	uint32_t success = 0;
+
+	for (uint32_t i = 0; i < 20; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, 20000 + i);
+
+		as_record* rec = as_record_new(1);
+		as_record_set_int64(rec, bin1, i);
+
+		as_status status = as_write_buffer_put(wb, &err, &key, rec, write_buffer_cb, &success);
+		assert_int_eq(status, AEROSPIKE_OK);
+	}
+
+	as_write_buffer_flush(wb);
+	assert_int_eq(as_load_uint32(&success), 20);
+	as_write_buffer_destroy(wb);
+
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 20019);
+
+	as_record* rec = NULL;
+	as_status status = aerospike_key_get(as, &err, NULL, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(rec, bin1, -1), 19);
+	as_record_destroy(rec);
+}
+
+TEST(batch_write_buffer_order, "Write buffer keeps order of writes to one key")
+{
+	as_error err;
+	as_write_buffer_policy p;
+	as_write_buffer_policy_init(&p);
+	p.flush_interval_ms = 10000;
+
+	as_write_buffer* wb = as_write_buffer_create(as, &err, &p);
+	assert_not_null(wb);
+
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 20050);
+
+	uint32_t success = 0;
+
+	for (uint32_t i = 0; i < 5; i++) {
+		as_record* rec = as_record_new(1);
+		as_record_set_int64(rec, bin1, i);
+
+		as_status status = as_write_buffer_put(wb, &err, &key, rec, write_buffer_cb, &success);
+		assert_int_eq(status, AEROSPIKE_OK);
+	}
+
+	// Each write after the first sends the batch that holds the previous write.
+	assert_int_eq(as_load_uint32(&success), 4);
+
+	as_write_buffer_flush(wb);
+	assert_int_eq(as_load_uint32(&success), 5);
+	as_write_buffer_destroy(wb);
+
+	as_record* rec = NULL;
+	as_status status = aerospike_key_get(as, &err, NULL, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(rec, bin1, -1), 4);
+	as_record_destroy(rec);
+}
+
+TEST(batch_write_buffer_touch, "Write buffer coalesced touch")
+{
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 20100);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, bin1, 1);
+
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(&rec);
+
+	as_write_buffer_policy p;
+	as_write_buffer_policy_init(&p);
+	p.flush_interval_ms = 10000;
+
+	as_write_buffer* wb = as_write_buffer_create(as, &err, &p);
+	assert_not_null(wb);
+
+	as_record* r = NULL;
+	status = aerospike_key_get(as, &err, NULL, &key, &r);
+	assert_int_eq(status, AEROSPIKE_OK);
+	uint16_t gen = r->gen;
+	as_record_destroy(r);
+
+	for (uint32_t i = 0; i < 10; i++) {
+		r = NULL;
+		status = as_write_buffer_get_touch(wb, &err, NULL, &key, &r, 0);
+		assert_int_eq(status, AEROSPIKE_OK);
+		as_record_destroy(r);
+	}
+
+	// All reads happened before the flush interval, so the record is touched once.
+	as_write_buffer_flush(wb);
+	as_write_buffer_destroy(wb);
+
+	r = NULL;
+	status = aerospike_key_get(as, &err, NULL, &key, &r);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(r->gen, gen + 1);
+	as_record_destroy(r);
+}
+
+TEST(batch_write_buffer_touch_order, "Write buffer touch after put is not coalesced")
+{
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 20101);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, bin1, 1);
+
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(&rec);
+
+	as_record* r = NULL;
+	status = aerospike_key_get(as, &err, NULL, &key, &r);
+	assert_int_eq(status, AEROSPIKE_OK);
+	uint16_t gen = r->gen;
+	as_record_destroy(r);
+
+	as_write_buffer_policy p;
+	as_write_buffer_policy_init(&p);
+	p.flush_interval_ms = 10000;
+	p.max_bytes = 1;
+
+	as_write_buffer* wb = as_write_buffer_create(as, &err, &p);
+	assert_not_null(wb);
+
+	status = as_write_buffer_touch(wb, &err, &key, 0);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	// The buffer is over max_bytes, but a coalesced touch does not wait for space.
+	uint64_t begin = cf_getms();
+	status = as_write_buffer_touch(wb, &err, &key, 0);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(cf_getms() - begin < 1000);
+
+	as_record* put = as_record_new(1);
+	as_record_set_int64(put, bin1, 2);
+	status = as_write_buffer_put(wb, &err, &key, put, NULL, NULL);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	// This touch follows the put, so it must not be merged into the first touch.
+	status = as_write_buffer_touch(wb, &err, &key, 0);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_write_buffer_flush(wb);
+	as_write_buffer_destroy(wb);
+
+	r = NULL;
+	status = aerospike_key_get(as, &err, NULL, &key, &r);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(r, bin1, -1), 2);
+	assert_int_eq(r->gen, gen + 3);
+	as_record_destroy(r);
+}
+
+static void
+batch_stream_cb(as_batch_base_record* record, uint32_t index, void* udata)
+{
+	batch_stats* data = udata;
+
+	if (record->result == AEROSPIKE_OK) {
+		if (as_record_get_int64(&record->record, bin1, -1) != (int64_t)index) {
+			as_incr_uint32(&data->errors);
+		}
+		as_incr_uint32(&data->found);
+	}
+	else if (record->result != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+		as_incr_uint32(&data->errors);
+	}
+	as_incr_uint32(&data->total);
+}
+
+TEST(batch_read_stream, "Batch read stream")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	batch_stats data = {0};
+	as_error err;
+
+	as_status status = aerospike_batch_read_stream(as, &err, NULL, &records, batch_stream_cb,
+		&data);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(data.total, N_KEYS);
+	assert_int_eq(data.found, N_KEYS - N_KEYS/20);
+	assert_int_eq(data.errors, 0);
+
+	// Bins are released after each listener call.
+	as_batch_read_record* record = as_vector_get(&records.list, 1);
+	assert_int_eq(record->result, AEROSPIKE_OK);
+	assert_int_eq(record->record.bins.size, 0);
+
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_read_split, "Batch read split into sub-commands")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.concurrent = true;
+	policy.max_keys_per_command = 7;
+	policy.max_bytes_per_command = 1024;
+
+	as_error err;
+	as_status status = aerospike_batch_read(as, &err, &policy, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_vector_get(&records.list, i);
+
+		if (record->result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&record->record, bin1, -1), i);
+			found++;
+		}
+		else {
+			assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_read_spread, "Batch read spread across replicas")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.replica_spread = true;
+
+	as_error err;
+	as_status status = aerospike_batch_read(as, &err, &policy, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_vector_get(&records.list, i);
+
+		if (record->result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&record->record, bin1, -1), i);
+			found++;
+		}
+		else {
+			assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_read_grouped, "Batch read with interleaved bin selections")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	// Alternate bin selections, so the client groups records by selection per node.
+	const char* bins_a[] = {bin1};
+	const char* bins_b[] = {bin2};
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+
+		if (i % 2 == 0) {
+			record->bin_names = (char**)bins_a;
+		}
+		else {
+			record->bin_names = (char**)bins_b;
+		}
+		record->n_bin_names = 1;
+	}
+
+	as_error err;
+	as_status status = aerospike_batch_read(as, &err, NULL, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_vector_get(&records.list, i);
+
+		if (record->result == AEROSPIKE_OK) {
+			const char* bin = (i % 2 == 0) ? bin1 : bin2;
+			const char* other = (i % 2 == 0) ? bin2 : bin1;
+
+			if (i % 25 != 0 || i % 2 == 0) {
+				assert_int_eq(as_record_get_int64(&record->record, bin, -1), i);
+			}
+			assert_int_eq(as_record_get_int64(&record->record, other, -1), -1);
+			found++;
+		}
+		else {
+			assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_get_digests, "Batch get digests")
+{
+	as_digest_value digests[N_KEYS];
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+
+		as_error err;
+		as_key_set_digest(&err, &key);
+		memcpy(digests[i], key.digest.value, AS_DIGEST_VALUE_SIZE);
+	}
+
+	as_batch_digests batch = {
+		.ns = NAMESPACE,
+		.set = SET,
+		.digests = digests,
+		.n_digests = N_KEYS
+	};
+
+	as_batch_digest_result results[N_KEYS];
+	const char* bins[] = {bin1};
+
+	as_error err;
+	as_status status = aerospike_batch_get_digests(as, &err, NULL, &batch, bins, 1, results);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		if (results[i].result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&results[i].record, bin1, -1), i);
+			assert_int_eq(results[i].record.bins.size, 1);
+			found++;
+		}
+		else {
+			assert_int_eq(results[i].result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	as_batch_digest_results_destroy(results, N_KEYS);
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+}
+
+TEST(batch_get_views, "Batch get key views")
+{
+	as_integer values[N_KEYS];
+	as_key_view views[N_KEYS];
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_integer_init(&values[i], i);
+		views[i].ns = NAMESPACE;
+		views[i].set = SET;
+		views[i].valuep = (as_key_value*)&values[i];
+		views[i].digest = NULL;
+	}
+
+	// Precomputed digest takes precedence over the value.
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 1);
+	as_error err;
+	as_key_set_digest(&err, &key);
+	views[1].valuep = NULL;
+	views[1].digest = key.digest.value;
+
+	// Equal set name from another string is matched by value.
+	char set[] = SET;
+	for (uint32_t i = N_KEYS / 2; i < N_KEYS; i++) {
+		views[i].set = set;
+	}
+
+	as_batch_digest_result results[N_KEYS];
+	as_status status = aerospike_batch_get_views(as, &err, NULL, views, N_KEYS, NULL, 0, results);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		if (results[i].result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&results[i].record, bin1, -1), i);
+			found++;
+		}
+		else {
+			assert_int_eq(results[i].result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	as_batch_digest_results_destroy(results, N_KEYS);
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+}
+
+TEST(batch_read_multiplex, "Batch read multiplexed on event loop")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.concurrent = true;
+	policy.multiplex = true;
+
+	as_error err;
+	as_status status = aerospike_batch_read(as, &err, &policy, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_vector_get(&records.list, i);
+
+		if (record->result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&record->record, bin1, -1), i);
+			found++;
+		}
+		else {
+			assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_read_confined, "Batch read with thread confined bin storage")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.thread_confined = true;
+
+	as_error err;
+	as_status status = aerospike_batch_read(as, &err, &policy, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_vector_get(&records.list, i);
+
+		if (record->result == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(&record->record, bin1, -1), i);
+			found++;
+		}
+		else {
+			assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		}
+	}
+	assert_int_eq(found, N_KEYS - N_KEYS/20);
+
+	// Shared records switch the whole block back to atomic reference counts.
+	as_batch_read_record* record = as_vector_get(&records.list, 1);
+	as_record_share(&record->record);
+	as_batch_records_destroy(&records);
+}
+
+TEST(batch_read_prepared, "Batch read with prepared node commands")
+{
+	as_batch_records records;
+	as_batch_records_init(&records, N_KEYS);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_batch_read_record* record = as_batch_read_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->read_all_bins = true;
+	}
+
+	as_error err;
+	as_batch_prepared* prepared;
+	as_status status = aerospike_batch_prepare(as, &err, NULL, &records, &prepared);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(prepared->rebuilt_nodes > 0);
+
+	for (uint32_t n = 0; n < 3; n++) {
+		if (n == 2) {
+			// Simulate a partition map change.  Keys did not move, so no node is rebuilt.
+			prepared->partition_gen ^= 1;
+		}
+
+		status = aerospike_batch_prepared_execute(as, &err, prepared);
+		assert_int_eq(status, AEROSPIKE_OK);
+
+		uint32_t found = 0;
+
+		for (uint32_t i = 0; i < N_KEYS; i++) {
+			as_batch_read_record* record = as_vector_get(&records.list, i);
+
+			if (record->result == AEROSPIKE_OK) {
+				assert_int_eq(as_record_get_int64(&record->record, bin1, -1), i);
+				found++;
+			}
+			else {
+				assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+			}
+		}
+		assert_int_eq(found, N_KEYS - N_KEYS/20);
+	}
+	assert_int_eq(prepared->rebuilt_nodes, 0);
+
+	as_batch_prepared_destroy(prepared);
+	as_batch_records_destroy(&records);
+}
+
+typedef struct bulk_source_s {
+	uint32_t next;
+	uint32_t rejected;
+} bulk_source;
+
+static bool
+bulk_produce(uint32_t producer_id, void* udata, as_key* key, as_record* rec)
+{
+	bulk_source* src = udata;
+	uint32_t i = as_faa_uint32(&src->next, 1);
+
+	if (i > N_KEYS) {
+		return false;
+	}
+
+	// One record has a namespace that does not exist.
+	as_key_init_int64(key, (i == N_KEYS) ? "invalid" : NAMESPACE, SET, 10000 + i);
+	as_record_init(rec, 2);
+	as_record_set_int64(rec, bin1, i);
+	as_record_set_strp(rec, bin2, strdup("bulk"), true);
+	return true;
+}
+
+static void
+bulk_reject(const as_key* key, const as_record* rec, const as_error* err, void* udata)
+{
+	bulk_source* src = udata;
+	as_incr_uint32(&src->rejected);
+}
+
+TEST(batch_bulk_load, "Bulk load with batch writes and single puts")
+{
+	uint32_t batch_sizes[] = {32, 1};
+
+	for (uint32_t b = 0; b < 2; b++) {
+		bulk_source src = {0, 0};
+
+		as_bulk_config config;
+		as_bulk_config_init(&config);
+		config.n_producers = 3;
+		config.batch_size = batch_sizes[b];
+		config.max_in_flight = 4;
+		config.reject_listener = bulk_reject;
+		config.reject_udata = &src;
+
+		as_error err;
+		as_bulk_stats stats;
+		as_status status = aerospike_bulk_load(as, &err, &config, bulk_produce, &src, &stats);
+		assert_int_eq(status, AEROSPIKE_OK);
+		assert_int_eq(stats.produced, N_KEYS + 1);
+		assert_int_eq(stats.written, N_KEYS);
+		assert_int_eq(stats.rejected, 1);
+		assert_int_eq(src.rejected, 1);
+
+		for (uint32_t i = 0; i < N_KEYS; i++) {
+			as_key key;
+			as_key_init_int64(&key, NAMESPACE, SET, 10000 + i);
+
+			as_record* rec = NULL;
+			status = aerospike_key_get(as, &err, NULL, &key, &rec);
+			assert_int_eq(status, AEROSPIKE_OK);
+			assert_int_eq(as_record_get_int64(rec, bin1, -1), i);
+			assert_string_eq(as_record_get_str(rec, bin2), "bulk");
+			as_record_destroy(rec);
+
+			status = aerospike_key_remove(as, &err, NULL, &key);
+			assert_int_eq(status, AEROSPIKE_OK);
+		}
+	}
+}
+
+TEST(batch_write_status, "Batch write, remove and exists with compact results")
+{
+	uint32_t n_keys = 50;
+
+	as_batch batch;
+	as_batch_init(&batch, n_keys);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_init_int64(as_batch_keyat(&batch, i), NAMESPACE, SET, 30000 + i);
+	}
+
+	as_operations ops;
+	as_operations_inita(&ops, 1);
+	as_operations_add_write_int64(&ops, bin1, 7);
+
+	as_batch_status bs;
+	as_batch_status_init(&bs, n_keys);
+
+	as_error err;
+	as_status status = aerospike_batch_write_status(as, &err, NULL, NULL, &batch, &ops, &bs);
+	as_operations_destroy(&ops);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(bs.n_keys, n_keys);
+	assert_int_eq(bs.n_errors, 0);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		assert_int_eq(bs.results[i], AEROSPIKE_OK);
+	}
+
+	// Remove even keys only.
+	as_batch even;
+	as_batch_init(&even, n_keys / 2);
+
+	for (uint32_t i = 0; i < n_keys / 2; i++) {
+		as_key_init_int64(as_batch_keyat(&even, i), NAMESPACE, SET, 30000 + i * 2);
+	}
+
+	status = aerospike_batch_remove_status(as, &err, NULL, NULL, &even, &bs);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(bs.n_keys, n_keys / 2);
+	assert_int_eq(bs.n_errors, 0);
+
+	uint8_t bitmap[(50 + 7) / 8];
+	status = aerospike_batch_exists_bitmap(as, &err, NULL, &batch, bitmap);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		bool exists = (bitmap[i / 8] & (1 << (i % 8))) != 0;
+		assert_true(exists == (i % 2 == 1));
+	}
+
+	// Not found is not a batch failure, but every key is listed in errors.
+	status = aerospike_batch_remove_status(as, &err, NULL, NULL, &even, &bs);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(bs.n_errors, n_keys / 2);
+
+	for (uint32_t i = 0; i < bs.n_errors; i++) {
+		assert_int_eq(bs.errors[i], i);
+		assert_int_eq(bs.results[i], AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		assert_false(bs.in_doubt[i]);
+	}
+
+	status = aerospike_batch_remove_status(as, &err, NULL, NULL, &batch, &bs);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(bs.n_errors, n_keys / 2);
+
+	as_batch_status_destroy(&bs);
+	as_batch_destroy(&even);
+	as_batch_destroy(&batch);
+}
+
 //---------------------------------
 // Test Suite
 //---------------------------------
@@ -751,4 +1462,19 @@ SUITE(batch, "aerospike batch tests")
 	suite_add(batch_write_list_operate);
 	suite_add(batch_write_complex);
 	suite_add(batch_remove);
+	suite_add(batch_write_buffer);
+	suite_add(batch_write_buffer_order);
+	suite_add(batch_write_buffer_touch);
+	suite_add(batch_write_buffer_touch_order);
+	suite_add(batch_read_stream);
+	suite_add(batch_read_split);
+	suite_add(batch_read_spread);
+	suite_add(batch_read_grouped);
+	suite_add(batch_get_digests);
+	suite_add(batch_get_views);
+	suite_add(batch_read_multiplex);
+	suite_add(batch_read_confined);
+	suite_add(batch_read_prepared);
+	suite_add(batch_bulk_load);
+	suite_add(batch_write_status);
 }
@@ -23,6 +23,7 @@
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_exp.h>
+#include <aerospike/as_geo_region.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_list.h>
@@ -347,6 +348,60 @@ TEST( filter_points_within_region, "filter_points_within_region" ) {
 	remove_points(SET2);
 }
 
+TEST( filter_points_within_prepared_region, "filter_points_within_prepared_region" ) {
+
+	as_error err;
+	as_geo_region region;
+
+	// Invalid regions are rejected before they reach the server.
+	assert_int_eq( as_geo_region_init(&region, &err,
+		"{ \"type\": \"XPolygon\", \"coordinates\": [] }"), AEROSPIKE_ERR_GEO_INVALID_GEOJSON );
+	assert_int_eq( as_geo_region_init(&region, &err,
+		"{ \"type\": \"Polygon\", \"coordinates\": [ [ }"), AEROSPIKE_ERR_GEO_INVALID_GEOJSON );
+
+	assert_int_eq( as_geo_region_init(&region, &err,
+		"{ "
+		"    \"type\": \"Polygon\", "
+		"    \"coordinates\": [ "
+		"        [[-122.500000, 37.000000],[-121.000000, 37.000000], "
+		"         [-121.000000, 38.080000],[-122.500000, 38.080000], "
+		"         [-122.500000, 37.000000]] "
+		"    ] "
+		" } "), AEROSPIKE_OK );
+
+	if (! insert_points(SET2)) {
+		as_geo_region_destroy(&region);
+		assert_true(false);
+	}
+
+	as_query query;
+	as_query_init(&query, NAMESPACE, SET2);
+
+	as_policy_query p;
+	as_policy_query_init(&p);
+
+	// Reuse the region for multiple expressions and queries.
+	for (uint32_t i = 0; i < 2; i++) {
+		as_exp_build(filter,
+			as_exp_cmp_geo(as_exp_bin_geo("loc"), as_exp_geo_region(&region)));
+
+		p.base.filter_exp = filter;
+
+		filter_points_within_region_udata udata = { 0, PTHREAD_MUTEX_INITIALIZER };
+		aerospike_query_foreach(as, &err, &p, &query,
+				filter_points_within_region_callback, &udata);
+		assert_int_eq( err.code, AEROSPIKE_OK );
+		assert_int_eq( udata.count, 6 );
+
+		as_exp_destroy(filter);
+	}
+
+	as_query_destroy(&query);
+	as_geo_region_destroy(&region);
+
+	remove_points(SET2);
+}
+
 TEST( filter_pir_rchild_wrong_type, "filter_pir_rchild_wrong_type" ) {
 
 	if (! insert_points(SET2)) {
@@ -1183,6 +1238,7 @@ SUITE( query_geospatial, "aerospike_query_geospatial tests" ) {
 	suite_add( invalid_geojson );
 	suite_add( valid_geojson );
 	suite_add( filter_points_within_region );
+	suite_add( filter_points_within_prepared_region );
 	suite_add( filter_pir_rchild_wrong_type );
 	suite_add( filter_pir_lchild_wrong_type );
 	suite_add( filter_pir_rchild_not_immed );
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_bin.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_string.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(bin_handle_intern, "equal bin names share one handle")
+{
+	char name[16];
+	strcpy(name, "bin1");
+
+	const as_bin_handle* a = as_bin_handle_intern("bin1");
+	const as_bin_handle* b = as_bin_handle_intern(name);
+	const as_bin_handle* c = as_bin_handle_intern("bin2");
+
+	assert_not_null(a);
+	assert_true(a == b);
+	assert_true(a != c);
+	assert_int_eq(a->len, 4);
+	assert_string_eq(a->name, "bin1");
+	assert_null(as_bin_handle_intern("name_is_too_long"));
+}
+
+TEST(bin_handle_record, "records are set and read by bin handle")
+{
+	const as_bin_handle* h1 = as_bin_handle_intern("a");
+	const as_bin_handle* h2 = as_bin_handle_intern("ab");
+
+	as_record rec;
+	as_record_inita(&rec, 2);
+	as_record_set_int64(&rec, "ab", 1);
+	assert_true(as_record_set_handle(&rec, h1, (as_bin_value*)as_integer_new(2)));
+
+	// Update existing bin.
+	assert_true(as_record_set_handle(&rec, h2, (as_bin_value*)as_integer_new(3)));
+	assert_int_eq(as_record_numbins(&rec), 2);
+
+	as_integer* v1 = as_integer_fromval((as_val*)as_record_get_handle(&rec, h1));
+	as_integer* v2 = as_integer_fromval((as_val*)as_record_get_handle(&rec, h2));
+	assert_not_null(v1);
+	assert_not_null(v2);
+	assert_int_eq(v1->value, 2);
+	assert_int_eq(v2->value, 3);
+	assert_int_eq(as_record_get_int64(&rec, "a", 0), 2);
+	assert_null(as_record_get_handle(&rec, as_bin_handle_intern("abc")));
+
+	as_record_destroy(&rec);
+}
+
+TEST(bin_handle_operations, "operations are added by bin handle")
+{
+	const as_bin_handle* h = as_bin_handle_intern("op");
+
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+	assert_true(as_operations_add_write_handle(&ops, h, (as_bin_value*)as_string_new("v", false)));
+	assert_true(as_operations_add_read_handle(&ops, h));
+	assert_false(as_operations_add_read_handle(&ops, h));
+
+	assert_int_eq(ops.binops.entries[0].op, AS_OPERATOR_WRITE);
+	assert_string_eq(ops.binops.entries[0].bin.name, "op");
+	assert_int_eq(ops.binops.entries[1].op, AS_OPERATOR_READ);
+	assert_string_eq(ops.binops.entries[1].bin.name, "op");
+	assert_int_eq(as_bin_get_type(&ops.binops.entries[1].bin), AS_NIL);
+
+	as_operations_destroy(&ops);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(bin_handle, "interned bin names")
+{
+	suite_add(bin_handle_intern);
+	suite_add(bin_handle_record);
+	suite_add(bin_handle_operations);
+}
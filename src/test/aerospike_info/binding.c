@@ -0,0 +1,165 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_binding.h>
+#include <aerospike/as_bytes.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	int64_t id;
+	double score;
+	bool active;
+	char name[8];
+	uint8_t blob[4];
+	uint32_t blob_len;
+	char* note;
+} user_obj;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+// Append bin in response wire format. Layout: op_size(4) op(1) type(1) version(1)
+// name_len(1) name value
+static uint8_t*
+put_bin(uint8_t* p, const char* name, uint8_t type, const void* value, uint32_t size)
+{
+	uint8_t name_len = (uint8_t)strlen(name);
+	*(uint32_t*)p = cf_swap_to_be32(4 + name_len + size);
+	p[4] = 1;
+	p[5] = type;
+	p[6] = 0;
+	p[7] = name_len;
+	memcpy(p + 8, name, name_len);
+	memcpy(p + 8 + name_len, value, size);
+	return p + 8 + name_len + size;
+}
+
+static void
+init_binding(as_binding* b)
+{
+	as_binding_init(b);
+	as_binding_add(b, "id", AS_BINDING_INT64, offsetof(user_obj, id), 0);
+	as_binding_add(b, "score", AS_BINDING_DOUBLE, offsetof(user_obj, score), 0);
+	as_binding_add(b, "active", AS_BINDING_BOOL, offsetof(user_obj, active), 0);
+	as_binding_add(b, "name", AS_BINDING_STR, offsetof(user_obj, name),
+		sizeof(((user_obj*)0)->name));
+	as_binding_add_bytes(b, "blob", offsetof(user_obj, blob), sizeof(((user_obj*)0)->blob),
+		offsetof(user_obj, blob_len));
+	as_binding_add(b, "note", AS_BINDING_STR, offsetof(user_obj, note), 0);
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(binding_decode, "raw bins are decoded into struct fields")
+{
+	as_binding b;
+	init_binding(&b);
+	assert_int_eq(b.n_fields, 6);
+	assert_false(as_binding_add(&b, "name_is_too_long", AS_BINDING_INT64, 0, 0));
+
+	uint8_t buf[512];
+	uint8_t* p = buf;
+	uint64_t id = cf_swap_to_be64(77);
+	double score = cf_swap_to_big_float64(2.5);
+	uint8_t active = 1;
+	uint8_t blob[6] = {1, 2, 3, 4, 5, 6};
+
+	p = put_bin(p, "other", AS_BYTES_INTEGER, &id, sizeof(id));
+	p = put_bin(p, "id", AS_BYTES_INTEGER, &id, sizeof(id));
+	p = put_bin(p, "score", AS_BYTES_DOUBLE, &score, sizeof(score));
+	p = put_bin(p, "active", AS_BYTES_BOOL, &active, sizeof(active));
+	p = put_bin(p, "name", AS_BYTES_STRING, "abcdefghij", 10);
+	p = put_bin(p, "blob", AS_BYTES_BLOB, blob, sizeof(blob));
+	p = put_bin(p, "note", AS_BYTES_STRING, "hello", 5);
+
+	as_record_raw rec;
+	rec.digest.init = false;
+	rec.gen = 1;
+	rec.ttl = 100;
+	rec.n_bins = 7;
+	rec.bins = buf;
+
+	user_obj u;
+	memset(&u, 0, sizeof(u));
+	as_binding_status status;
+	as_binding_decode(&b, &rec, &u, &status);
+
+	assert_int_eq(status.missing, 0);
+	assert_int_eq(status.mismatch, 0);
+	assert_int_eq(status.truncated, (1ULL << 3) | (1ULL << 4));
+	assert_int_eq(u.id, 77);
+	assert_true(u.score == 2.5);
+	assert_true(u.active);
+	assert_string_eq(u.name, "abcdefg");
+	assert_int_eq(u.blob_len, 4);
+	assert_int_eq(memcmp(u.blob, blob, 4), 0);
+	assert_string_eq(u.note, "hello");
+	cf_free(u.note);
+}
+
+TEST(binding_status, "missing and mismatched bins are reported")
+{
+	as_binding b;
+	init_binding(&b);
+
+	uint8_t buf[256];
+	uint8_t* p = buf;
+	uint64_t id = cf_swap_to_be64(5);
+
+	p = put_bin(p, "id", AS_BYTES_STRING, "5", 1);
+	p = put_bin(p, "score", AS_BYTES_INTEGER, &id, sizeof(id));
+	p = put_bin(p, "active", AS_BYTES_UNDEF, NULL, 0);
+
+	as_record_raw rec;
+	rec.digest.init = false;
+	rec.gen = 1;
+	rec.ttl = 0;
+	rec.n_bins = 3;
+	rec.bins = buf;
+
+	user_obj u;
+	memset(&u, 0, sizeof(u));
+	as_binding_status status;
+	as_binding_decode(&b, &rec, &u, &status);
+
+	assert_int_eq(status.mismatch, (1ULL << 0) | (1ULL << 1));
+	assert_int_eq(status.missing, (1ULL << 2) | (1ULL << 3) | (1ULL << 4) | (1ULL << 5));
+	assert_int_eq(status.truncated, 0);
+	assert_int_eq(u.id, 0);
+	assert_null(u.note);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(binding, "schema bound record decode")
+{
+	suite_add(binding_decode);
+	suite_add(binding_status);
+}
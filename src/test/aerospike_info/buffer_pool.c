@@ -0,0 +1,241 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_allocator.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_buffer_pool.h>
+#include <aerospike/as_record.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * GLOBAL VARS
+ *****************************************************************************/
+
+extern aerospike* as;
+
+static uint32_t alloc_count;
+static uint32_t free_sized_count;
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define NAMESPACE "test"
+#define SET "test_buffer_pool"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void*
+test_malloc(size_t size)
+{
+	as_incr_uint32(&alloc_count);
+	return malloc(size);
+}
+
+static void*
+test_calloc(size_t n, size_t size)
+{
+	as_incr_uint32(&alloc_count);
+	return calloc(n, size);
+}
+
+static void*
+test_realloc(void* ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+static void
+test_free_sized(void* ptr, size_t size)
+{
+	as_incr_uint32(&free_sized_count);
+	free(ptr);
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(buffer_pool_thread, "put/get large records with thread buffer pool")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t max = as_buffer_pool_get_max();
+	as_buffer_pool_set_max(1024 * 1024);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "pool");
+
+	// Sizes span multiple buffer size classes and repeat so cached buffers are reused.
+	uint32_t sizes[] = {20000, 100000, 20000, 200000, 100000};
+
+	for (uint32_t i = 0; i < sizeof(sizes) / sizeof(uint32_t); i++) {
+		uint32_t size = sizes[i];
+		uint8_t* bytes = malloc(size);
+		memset(bytes, i + 1, size);
+
+		as_record rec;
+		as_record_init(&rec, 1);
+		as_record_set_raw(&rec, "a", bytes, size);
+
+		as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+		as_record_destroy(&rec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+
+		as_bytes* b = as_record_get_bytes(prec, "a");
+		assert_not_null(b);
+		assert_int_eq(b->size, size);
+		assert_true(memcmp(b->value, bytes, size) == 0);
+		as_record_destroy(prec);
+		free(bytes);
+	}
+
+	as_buffer_pool_release_thread();
+	as_buffer_pool_set_max(max);
+	as_key_destroy(&key);
+}
+
+TEST(buffer_pool_huge, "put/get large records with huge page buffers")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t max = as_buffer_pool_get_max();
+	as_buffer_pool_set_max(8 * 1024 * 1024);
+	as_buffer_pool_set_huge_pages(AS_BUFFER_POOL_HUGE_PAGE_SIZE, true);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "pool_huge");
+
+	// Command buffers fall in the 2MB size class, which is mapped and then reused.
+	uint32_t size = 1500000;
+	uint8_t* bytes = malloc(size);
+	as_status rc = AEROSPIKE_OK;
+
+	for (uint32_t i = 0; i < 2 && rc == AEROSPIKE_OK; i++) {
+		memset(bytes, i + 1, size);
+
+		as_record rec;
+		as_record_init(&rec, 1);
+		as_record_set_raw(&rec, "a", bytes, size);
+
+		rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+		as_record_destroy(&rec);
+
+		if (rc == AEROSPIKE_ERR_RECORD_TOO_BIG) {
+			// Server write block size is too small for this test.
+			break;
+		}
+		assert_int_eq(rc, AEROSPIKE_OK);
+
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+
+		as_bytes* b = as_record_get_bytes(prec, "a");
+		assert_not_null(b);
+		assert_int_eq(b->size, size);
+		assert_true(memcmp(b->value, bytes, size) == 0);
+		as_record_destroy(prec);
+	}
+
+	free(bytes);
+	as_buffer_pool_release_thread();
+	as_buffer_pool_set_huge_pages(0, false);
+	as_buffer_pool_set_max(max);
+	as_key_destroy(&key);
+}
+
+TEST(buffer_pool_allocator, "put/get large records with custom allocator")
+{
+	as_allocator bad = {0};
+	bad.malloc = test_malloc;
+	assert_false(as_allocator_set(&bad));
+
+	as_allocator allocator = {0};
+	allocator.malloc = test_malloc;
+	allocator.calloc = test_calloc;
+	allocator.realloc = test_realloc;
+	allocator.free = free;
+	allocator.free_sized = test_free_sized;
+
+	// Custom allocator uses the same heap as the default allocator, so memory allocated
+	// before the switch can still be released.
+	uint32_t max = as_buffer_pool_get_max();
+	as_buffer_pool_set_max(0);
+	assert_true(as_allocator_set(&allocator));
+	alloc_count = 0;
+	free_sized_count = 0;
+
+	as_error err;
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "allocator");
+
+	// Command buffer does not fit on the stack.
+	uint32_t size = 100000;
+	uint8_t* bytes = malloc(size);
+	memset(bytes, 3, size);
+
+	as_record rec;
+	as_record_init(&rec, 1);
+	as_record_set_raw(&rec, "a", bytes, size);
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+
+	as_record* prec = NULL;
+
+	if (rc == AEROSPIKE_OK) {
+		rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+	}
+	as_allocator_set(NULL);
+	as_buffer_pool_set_max(max);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_bytes* b = as_record_get_bytes(prec, "a");
+	assert_not_null(b);
+	assert_int_eq(b->size, size);
+	assert_true(memcmp(b->value, bytes, size) == 0);
+	as_record_destroy(prec);
+	free(bytes);
+	as_key_destroy(&key);
+
+	assert_true(as_load_uint32(&alloc_count) >= 2);
+	assert_true(as_load_uint32(&free_sized_count) >= 2);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(buffer_pool, "command buffer pool and allocator")
+{
+	suite_add(buffer_pool_thread);
+	suite_add(buffer_pool_huge);
+	suite_add(buffer_pool_allocator);
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_compress.h>
+#include <aerospike/as_compress_dict.h>
+#include <aerospike/as_compress_ratio.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define NAMESPACE "test"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void*
+compression_worker(void* udata)
+{
+	uint8_t src[1000];
+	uint8_t comp[2000];
+	as_error err;
+
+	memset(src, 7, sizeof(src));
+
+	for (int i = 0; i < 2; i++) {
+		size_t comp_size = sizeof(comp);
+		*(as_status*)udata = as_compress(&err, AS_COMPRESS_ZLIB, comp, &comp_size, src,
+			sizeof(src));
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(compression_reuse, "compression contexts are reused")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t size = 4000;
+	uint8_t* src = malloc(size);
+
+	for (uint32_t i = 0; i < size; i++) {
+		src[i] = (uint8_t)(i % 17);
+	}
+
+	size_t capacity = as_compress_bound(AS_COMPRESS_ZLIB, size);
+	uint8_t* comp = malloc(capacity);
+	uint8_t* trg = malloc(size);
+
+	as_compress_stats before;
+	as_compress_get_stats(&before);
+
+	for (int i = 0; i < 3; i++) {
+		size_t comp_size = capacity;
+		as_status rc = as_compress(&err, AS_COMPRESS_ZLIB, comp, &comp_size, src, size);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_true(comp_size < size);
+
+		size_t trg_size = size;
+		rc = as_decompress(&err, AS_COMPRESS_ZLIB, trg, &trg_size, comp, comp_size);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(trg_size, size);
+		assert_true(memcmp(trg, src, size) == 0);
+	}
+
+	as_compress_stats after;
+	as_compress_get_stats(&after);
+	assert_true(after.deflate_reused - before.deflate_reused >= 2);
+	assert_true(after.inflate_reused - before.inflate_reused >= 2);
+
+	as_compress_release_thread();
+	free(trg);
+	free(comp);
+	free(src);
+}
+
+TEST(compression_thread_stats, "compression stats keep counts of exited threads")
+{
+	as_compress_stats before;
+	as_compress_get_stats(&before);
+
+	as_status rc = AEROSPIKE_ERR;
+	pthread_t thread;
+	assert_int_eq(pthread_create(&thread, NULL, compression_worker, &rc), 0);
+	pthread_join(thread, NULL);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	// Thread counters are folded into the totals when the thread exits.
+	as_compress_stats after;
+	as_compress_get_stats(&after);
+	assert_true(after.deflate_created - before.deflate_created >= 1);
+	assert_true(after.deflate_reused - before.deflate_reused >= 1);
+}
+
+TEST(compression_ratio, "compression is skipped for sets that do not compress")
+{
+	as_compress_ratio* cr = as_compress_ratio_create(90, 10);
+
+	// Unknown sets are compressed.
+	assert_true(as_compress_ratio_use(cr, NAMESPACE, "images"));
+	assert_true(as_compress_ratio_use(cr, NAMESPACE, "json"));
+
+	as_compress_ratio_add(cr, NAMESPACE, "images", 1000, 1010);
+	as_compress_ratio_add(cr, NAMESPACE, "json", 1000, 200);
+	assert_int_eq(as_compress_ratio_get(cr, NAMESPACE, "images"), 101);
+	assert_int_eq(as_compress_ratio_get(cr, NAMESPACE, "json"), 20);
+
+	// One of every 10 commands of the incompressible set is sampled.
+	uint32_t used = 0;
+
+	for (uint32_t i = 0; i < 100; i++) {
+		if (as_compress_ratio_use(cr, NAMESPACE, "images")) {
+			used++;
+		}
+		assert_true(as_compress_ratio_use(cr, NAMESPACE, "json"));
+	}
+	assert_int_eq(used, 10);
+
+	// Samples that compress well bring the set back.
+	for (uint32_t i = 0; i < 10; i++) {
+		as_compress_ratio_add(cr, NAMESPACE, "images", 1000, 300);
+	}
+	assert_true(as_compress_ratio_get(cr, NAMESPACE, "images") < 90);
+	assert_true(as_compress_ratio_use(cr, NAMESPACE, "images"));
+	as_compress_ratio_destroy(cr);
+}
+
+TEST(compression_dict, "small values compress better with a trained dictionary")
+{
+	char samples[50][128];
+	const uint8_t* ptrs[50];
+	size_t sizes[50];
+
+	for (uint32_t i = 0; i < 50; i++) {
+		sizes[i] = (size_t)snprintf(samples[i], sizeof(samples[i]),
+			"{\"user_id\":%u,\"status\":\"active\",\"country\":\"US\",\"plan\":\"premium\"}",
+			i * 7919);
+		ptrs[i] = (const uint8_t*)samples[i];
+	}
+
+	uint8_t dict[4096];
+	uint32_t dict_size = as_compress_dict_train(ptrs, sizes, 50, dict, sizeof(dict));
+	assert_true(dict_size > 0);
+
+	as_error err;
+	as_status rc = as_compress_dict_register(&err, 77, dict, dict_size);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	char value[128];
+	size_t size = (size_t)snprintf(value, sizeof(value),
+		"{\"user_id\":%u,\"status\":\"active\",\"country\":\"US\",\"plan\":\"premium\"}",
+		123456);
+
+	uint8_t plain[512];
+	size_t plain_size = sizeof(plain);
+	rc = as_compress(&err, AS_COMPRESS_ZLIB, plain, &plain_size, (uint8_t*)value, size);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	uint8_t comp[512];
+	size_t comp_size = sizeof(comp);
+	rc = as_compress_dict_compress(&err, 77, comp, &comp_size, (uint8_t*)value, size);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	info("plain %zu dict %zu original %zu", plain_size, comp_size, size);
+	assert_true(comp_size < plain_size);
+
+	uint32_t id;
+	size_t orig_size;
+	rc = as_compress_dict_info(&err, comp, comp_size, &id, &orig_size);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_int_eq(id, 77);
+	assert_int_eq(orig_size, size);
+
+	uint8_t trg[128];
+	size_t trg_size = sizeof(trg);
+	rc = as_compress_dict_decompress(&err, trg, &trg_size, comp, comp_size);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_int_eq(trg_size, size);
+	assert_true(memcmp(trg, value, size) == 0);
+
+	// Values can't be read once their dictionary is unregistered.
+	as_compress_dict_unregister(77);
+	trg_size = sizeof(trg);
+	rc = as_compress_dict_decompress(&err, trg, &trg_size, comp, comp_size);
+	assert_int_ne(rc, AEROSPIKE_OK);
+
+	comp_size = sizeof(comp);
+	rc = as_compress_dict_compress(&err, 77, comp, &comp_size, (uint8_t*)value, size);
+	assert_int_eq(rc, AEROSPIKE_ERR_PARAM);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(compression, "compression contexts, ratios and dictionaries")
+{
+	suite_add(compression_reuse);
+	suite_add(compression_thread_stats);
+	suite_add(compression_ratio);
+	suite_add(compression_dict);
+}
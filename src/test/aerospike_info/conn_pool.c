@@ -0,0 +1,110 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_conn_pool.h>
+#include <citrusleaf/cf_clock.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(conn_pool_lock_free, "lock free connection stack order and capacity")
+{
+	as_conn_stack* stack = as_conn_stack_create(3);
+	as_socket sock;
+
+	for (int i = 0; i < 3; i++) {
+		memset(&sock, 0, sizeof(as_socket));
+		sock.fd = 100 + i;
+		assert_true(as_conn_stack_push_head(stack, &sock));
+	}
+
+	// Stack is full.
+	sock.fd = 200;
+	assert_false(as_conn_stack_push_head(stack, &sock));
+	assert_int_eq(stack->size, 3);
+
+	// Most recently used at head, least recently used at tail.
+	assert_true(as_conn_stack_pop_head(stack, &sock));
+	assert_int_eq(sock.fd, 102);
+	assert_true(as_conn_stack_pop_tail(stack, &sock));
+	assert_int_eq(sock.fd, 100);
+
+	sock.fd = 300;
+	assert_true(as_conn_stack_push_tail(stack, &sock));
+	assert_true(as_conn_stack_pop_head(stack, &sock));
+	assert_int_eq(sock.fd, 101);
+	assert_true(as_conn_stack_pop_head(stack, &sock));
+	assert_int_eq(sock.fd, 300);
+	assert_false(as_conn_stack_pop_head(stack, &sock));
+	assert_int_eq(stack->size, 0);
+
+	as_conn_stack_destroy(stack);
+}
+
+TEST(conn_pool_trim, "idle connections trimmed in last used order")
+{
+	as_conn_pool pools[2];
+	as_conn_pool_init(&pools[0], sizeof(as_socket), 0, 6, false);
+	as_conn_pool_init(&pools[1], sizeof(as_socket), 0, 6, true);
+
+	for (int p = 0; p < 2; p++) {
+		as_conn_pool* pool = &pools[p];
+		as_socket sock;
+
+		// Four idle connections, then two recently used ones.
+		for (int i = 0; i < 6; i++) {
+			memset(&sock, 0, sizeof(as_socket));
+			sock.fd = 100 + i;
+			sock.last_used = (i < 4) ? 0 : cf_getns();
+			assert_true(as_conn_pool_push_head(pool, &sock));
+		}
+
+		uint64_t max_idle_ns = 1000 * 1000 * 1000ULL;
+		as_socket socks[AS_CONN_TRIM_MAX];
+
+		// Least recently used first, limited per call.
+		assert_int_eq(as_conn_pool_trim(pool, max_idle_ns, socks, 3), 3);
+		assert_int_eq(socks[0].fd, 100);
+		assert_int_eq(socks[1].fd, 101);
+		assert_int_eq(socks[2].fd, 102);
+
+		assert_int_eq(as_conn_pool_trim(pool, max_idle_ns, socks, AS_CONN_TRIM_MAX), 1);
+		assert_int_eq(socks[0].fd, 103);
+		assert_int_eq(as_conn_pool_trim(pool, max_idle_ns, socks, AS_CONN_TRIM_MAX), 0);
+		assert_int_eq(as_conn_pool_size(pool), 2);
+
+		assert_true(as_conn_pool_pop_head(pool, &sock));
+		assert_int_eq(sock.fd, 105);
+		assert_true(as_conn_pool_pop_head(pool, &sock));
+		assert_int_eq(sock.fd, 104);
+		assert_false(as_conn_pool_pop_head(pool, &sock));
+		as_conn_pool_destroy(pool);
+	}
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(conn_pool, "sync connection pools")
+{
+	suite_add(conn_pool_lock_free);
+	suite_add(conn_pool_trim);
+}
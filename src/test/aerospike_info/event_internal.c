@@ -0,0 +1,283 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_event_internal.h>
+#include <aerospike/as_mpsc_queue.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define MPSC_PRODUCERS 4
+#define MPSC_ITEMS 10000
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	as_mpsc_queue* queue;
+	uint32_t id;
+} mpsc_producer_data;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void*
+mpsc_producer(void* udata)
+{
+	mpsc_producer_data* data = udata;
+
+	for (uint32_t i = 0; i < MPSC_ITEMS; i++) {
+		uint32_t v = (data->id << 16) | i;
+		as_mpsc_queue_push(data->queue, &v);
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(event_mpsc_queue, "lock free submission queue keeps per-producer order")
+{
+	as_mpsc_queue queue;
+	as_mpsc_queue_init(&queue, sizeof(uint32_t));
+
+	uint32_t v;
+	assert_false(as_mpsc_queue_pop(&queue, &v));
+
+	pthread_t threads[MPSC_PRODUCERS];
+	mpsc_producer_data data[MPSC_PRODUCERS];
+
+	for (uint32_t i = 0; i < MPSC_PRODUCERS; i++) {
+		data[i].queue = &queue;
+		data[i].id = i;
+		pthread_create(&threads[i], NULL, mpsc_producer, &data[i]);
+	}
+
+	for (uint32_t i = 0; i < MPSC_PRODUCERS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	assert_int_eq(as_mpsc_queue_size(&queue), MPSC_PRODUCERS * MPSC_ITEMS);
+
+	// Items from producers are interleaved, but each producer's items arrive in order.
+	uint32_t next[MPSC_PRODUCERS] = {0};
+	uint32_t total = 0;
+
+	while (as_mpsc_queue_pop(&queue, &v)) {
+		uint32_t id = v >> 16;
+		assert_true(id < MPSC_PRODUCERS);
+		assert_int_eq(v & 0xFFFF, next[id]);
+		next[id]++;
+		total++;
+	}
+
+	assert_int_eq(total, MPSC_PRODUCERS * MPSC_ITEMS);
+	assert_int_eq(as_mpsc_queue_size(&queue), 0);
+	as_mpsc_queue_destroy(&queue);
+}
+
+TEST(event_command_slab, "event loop caches freed command allocations by size class")
+{
+	as_event_loop event_loop;
+	memset(&event_loop, 0, sizeof(as_event_loop));
+	event_loop.thread = pthread_self();
+	event_loop.slab.max_size = 1;
+
+	size_t size = 3000;
+	uint8_t slab_class;
+	void* p1 = as_event_slab_alloc(&event_loop, &size, &slab_class);
+	assert_int_eq(size, 4096);
+	assert_int_eq(slab_class, 2);
+	assert_int_eq(event_loop.slab.misses, 1);
+
+	size = 1000;
+	void* p2 = as_event_slab_alloc(&event_loop, &size, &slab_class);
+	assert_int_eq(size, 1024);
+
+	// Only one allocation per class is cached.
+	void* p3 = as_event_slab_alloc(&event_loop, &size, &slab_class);
+	as_event_slab_free(&event_loop, p2, slab_class);
+	as_event_slab_free(&event_loop, p3, slab_class);
+	as_event_slab_free(&event_loop, p1, 2);
+	assert_int_eq(event_loop.slab.resident, 1024 + 4096);
+
+	size = 4000;
+	void* p4 = as_event_slab_alloc(&event_loop, &size, &slab_class);
+	assert_true(p4 == p1);
+	assert_int_eq(event_loop.slab.hits, 1);
+	assert_int_eq(event_loop.slab.resident, 1024);
+
+	// Large allocations bypass the cache.
+	size = 20000;
+	void* p5 = as_event_slab_alloc(&event_loop, &size, &slab_class);
+	assert_int_eq(slab_class, AS_EVENT_SLAB_NONE);
+	assert_int_eq(size, 20000);
+	cf_free(p5);
+
+	as_event_slab_free(&event_loop, p4, 2);
+	as_event_slab_destroy(&event_loop.slab);
+	assert_int_eq(event_loop.slab.resident, 0);
+}
+
+TEST(event_loop_select, "least loaded event loop selection avoids busiest loop")
+{
+	as_event_loop* save_loops = as_event_loops;
+	uint32_t save_size = as_event_loop_size;
+
+	as_event_loop loops[3];
+	memset(loops, 0, sizeof(loops));
+
+	for (uint32_t i = 0; i < 3; i++) {
+		loops[i].index = i;
+	}
+	loops[0].pending = 5;
+	loops[1].pending = 0;
+	loops[2].pending = 9;
+
+	as_event_loops = loops;
+	as_event_loop_size = 3;
+
+	// Two distinct loops are sampled, so the busiest loop always loses.
+	for (uint32_t i = 0; i < 100; i++) {
+		as_event_loop* event_loop = as_event_loop_get_least_loaded();
+		assert_true(event_loop != &loops[2]);
+	}
+
+	// Thread affinity keeps returning the first loop chosen.
+	as_event_set_loop_select(AS_EVENT_LOOP_SELECT_THREAD_AFFINITY);
+	as_event_loop* first = as_event_assign(NULL);
+
+	for (uint32_t i = 0; i < 10; i++) {
+		assert_true(as_event_assign(NULL) == first);
+	}
+
+	as_event_set_loop_select(AS_EVENT_LOOP_SELECT_ROUND_ROBIN);
+	as_event_loops = save_loops;
+	as_event_loop_size = save_size;
+}
+
+TEST(event_delay_priority, "delay queue drains priority lanes by weight")
+{
+	as_event_loop event_loop;
+	memset(&event_loop, 0, sizeof(as_event_loop));
+
+	as_event_command cmds[12];
+	memset(cmds, 0, sizeof(cmds));
+
+	// Queue 4 commands on each lane.
+	for (uint32_t i = 0; i < 12; i++) {
+		cmds[i].priority = (uint8_t)(i % AS_POLICY_PRIORITY_MAX);
+		as_event_delay_push(&event_loop, &cmds[i]);
+	}
+	assert_int_eq(as_event_loop_get_queue_size(&event_loop), 12);
+
+	// A stale command is unlinked from the middle of its lane.
+	as_event_delay_remove(&event_loop, &cmds[4]);
+	assert_int_eq(event_loop.delay_queue[AS_POLICY_PRIORITY_INTERACTIVE].size, 3);
+
+	// Pops follow the interactive, normal, interactive, bulk lane schedule.
+	as_event_command* expect[] = {
+		&cmds[1], &cmds[0], &cmds[7], &cmds[2], &cmds[10], &cmds[3]
+	};
+
+	for (uint32_t i = 0; i < 6; i++) {
+		assert_true(as_event_delay_pop(&event_loop) == expect[i]);
+	}
+
+	// Interactive lane is empty, so its turn falls through to the next lane.
+	as_event_command* cmd = as_event_delay_pop(&event_loop);
+	assert_int_ne(cmd->priority, AS_POLICY_PRIORITY_INTERACTIVE);
+
+	uint32_t count = 7;
+
+	while (as_event_delay_pop(&event_loop)) {
+		count++;
+	}
+	assert_int_eq(count, 11);
+	assert_int_eq(as_event_loop_get_queue_size(&event_loop), 0);
+}
+
+TEST(event_delay_deadline, "delay queue lanes are ordered by deadline")
+{
+	as_event_loop event_loop;
+	memset(&event_loop, 0, sizeof(as_event_loop));
+	event_loop.deadline_order = true;
+
+	as_event_command cmds[6];
+	memset(cmds, 0, sizeof(cmds));
+
+	// Zero means no deadline.
+	uint64_t deadlines[] = {500, 0, 200, 700, 200, 100};
+
+	for (uint32_t i = 0; i < 6; i++) {
+		cmds[i].priority = AS_POLICY_PRIORITY_NORMAL;
+		cmds[i].total_deadline = deadlines[i];
+		as_event_delay_push(&event_loop, &cmds[i]);
+	}
+
+	// Equal deadlines keep arrival order and commands without a deadline are last.
+	as_event_command* expect[] = {&cmds[5], &cmds[2], &cmds[4], &cmds[0], &cmds[3], &cmds[1]};
+
+	for (uint32_t i = 0; i < 6; i++) {
+		assert_true(as_event_delay_pop(&event_loop) == expect[i]);
+	}
+	assert_null(as_event_delay_pop(&event_loop));
+	assert_int_eq(as_event_loop_get_queue_size(&event_loop), 0);
+}
+
+TEST(event_busy_poll, "busy polling stops after idle window")
+{
+	as_event_loop event_loop;
+	memset(&event_loop, 0, sizeof(as_event_loop));
+	event_loop.busy_poll_us = 1000;
+
+	uint64_t activity = 0;
+	uint64_t idle_begin = cf_getns();
+	assert_true(as_event_busy_poll(&event_loop, &activity, &idle_begin));
+
+	// Idle window expired.
+	idle_begin -= 2000 * 1000;
+	assert_false(as_event_busy_poll(&event_loop, &activity, &idle_begin));
+
+	// New activity restarts the window.
+	event_loop.counters.commands++;
+	assert_true(as_event_busy_poll(&event_loop, &activity, &idle_begin));
+	assert_int_eq(activity, 1);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(event_internal, "event loop queues and allocation")
+{
+	suite_add(event_mpsc_queue);
+	suite_add(event_command_slab);
+	suite_add(event_loop_select);
+	suite_add(event_delay_priority);
+	suite_add(event_delay_deadline);
+	suite_add(event_busy_poll);
+}
@@ -29,6 +29,7 @@
 #include <aerospike/as_map.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_val.h>
+#include <aerospike/as_monitor.h>
 
 #include "../test.h"
 #include "../aerospike_test.h"
@@ -51,6 +52,13 @@ struct info_data_s {
 
 typedef struct info_data_s info_data;
 
+typedef struct {
+	as_monitor monitor;
+	uint32_t count;
+	uint32_t ok;
+	uint32_t calls;
+} info_all_data;
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -74,6 +82,36 @@ static bool info_compare(const as_error * err, const as_node * node, const char
 	return true;
 }
 
+static void
+info_all_count(info_all_data* data, as_info_node_result* results, uint32_t n_results)
+{
+	data->calls++;
+	data->count = n_results;
+
+	for (uint32_t i = 0; i < n_results; i++) {
+		if (results[i].err.code == AEROSPIKE_OK && results[i].response &&
+			results[i].node) {
+			data->ok++;
+		}
+	}
+}
+
+static void
+info_all_callback(as_info_node_result* results, uint32_t n_results, void* udata)
+{
+	info_all_count(udata, results, n_results);
+}
+
+static void
+info_all_listener(
+	as_info_node_result* results, uint32_t n_results, void* udata, as_event_loop* event_loop
+	)
+{
+	info_all_data* data = udata;
+	info_all_count(data, results, n_results);
+	as_monitor_notify(&data->monitor);
+}
+
 /******************************************************************************
  * TEST CASES
  *****************************************************************************/
@@ -148,6 +186,82 @@ TEST( info_basics_features , "features" ) {
 	}
 }
 
+TEST( info_basics_reader , "zero-copy info response reader" ) {
+
+	const char* res = "node\tBB9\n\nfeatures\n"
+		"namespace/test\tobjects=12;ttl=0;\npartition-generation\t42\n";
+	size_t len = strlen(res);
+
+	as_info_reader reader;
+	as_info_reader_init(&reader, res, len);
+
+	as_info_slice name;
+	as_info_slice value;
+
+	assert_true( as_info_reader_next(&reader, &name, &value) );
+	assert_true( as_info_slice_eq(&name, "node") );
+	assert_true( as_info_slice_eq(&value, "BB9") );
+
+	assert_true( as_info_reader_next(&reader, &name, &value) );
+	assert_true( as_info_slice_eq(&name, "features") );
+	assert_int_eq( value.len, 0 );
+
+	assert_true( as_info_reader_next(&reader, &name, &value) );
+	assert_true( as_info_slice_eq(&name, "namespace/test") );
+
+	as_info_slice token;
+	assert_true( as_info_slice_next(&value, ';', &token) );
+	assert_true( as_info_slice_eq(&token, "objects=12") );
+	assert_true( as_info_slice_next(&value, ';', &token) );
+	assert_true( as_info_slice_eq(&token, "ttl=0") );
+	assert_false( as_info_slice_next(&value, ';', &token) );
+
+	assert_true( as_info_reader_next(&reader, &name, &value) );
+	assert_true( as_info_slice_eq(&name, "partition-generation") );
+
+	uint64_t gen = 0;
+	assert_true( as_info_slice_to_uint64(&value, &gen) );
+	assert_int_eq( gen, 42 );
+	assert_false( as_info_slice_to_uint64(&name, &gen) );
+
+	assert_false( as_info_reader_next(&reader, &name, &value) );
+
+	// Response is not modified.
+	assert_int_eq( strlen(res), len );
+}
+
+TEST( info_basics_all , "info request to all nodes in parallel" ) {
+
+	as_error err;
+	info_all_data data = {.count = 0, .ok = 0, .calls = 0};
+
+	as_status rc = aerospike_info_all(as, &err, NULL, "build", info_all_callback, &data);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( data.calls, 1 );
+	assert( data.count > 0 );
+	assert_int_eq( data.ok, data.count );
+}
+
+TEST( info_basics_all_async , "async info request to all nodes in parallel" ) {
+
+	as_error err;
+	info_all_data data = {.count = 0, .ok = 0, .calls = 0};
+	as_monitor_init(&data.monitor);
+	as_monitor_begin(&data.monitor);
+
+	as_status rc = aerospike_info_all_async(as, &err, NULL, "build", info_all_listener, &data,
+		NULL);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	as_monitor_wait(&data.monitor);
+	as_monitor_destroy(&data.monitor);
+
+	assert_int_eq( data.calls, 1 );
+	assert( data.count > 0 );
+	assert_int_eq( data.ok, data.count );
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -155,4 +269,7 @@ TEST( info_basics_features , "features" ) {
 SUITE( info_basics, "aerospike_info basic tests" ) {
 	suite_add( info_basics_help );
 	suite_add( info_basics_features );
+	suite_add( info_basics_reader );
+	suite_add( info_basics_all );
+	suite_add( info_basics_all_async );
 }
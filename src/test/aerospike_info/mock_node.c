@@ -0,0 +1,515 @@
+/*
+ * Copyright 2008-2016 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_batch.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_stats.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_sleep.h>
+#include <aerospike/as_thread_pool.h>
+#include <citrusleaf/cf_clock.h>
+
+#include "../test.h"
+#include "../util/mock_server.h"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool
+mock_connect(aerospike* client, mock_cluster* mock)
+{
+	as_config config;
+	as_config_init(&config);
+	as_config_add_host(&config, "127.0.0.1", mock_cluster_port(mock, 0));
+	aerospike_init(client, &config);
+
+	as_error err;
+	return aerospike_connect(client, &err) == AEROSPIKE_OK;
+}
+
+static uint32_t
+mock_node_count(aerospike* client)
+{
+	as_nodes* nodes = as_nodes_reserve(client->cluster);
+	uint32_t size = nodes->size;
+	as_nodes_release(nodes);
+	return size;
+}
+
+static bool
+mock_wait_nodes(aerospike* client, uint32_t size)
+{
+	// Wait for the tend thread.
+	for (uint32_t i = 0; i < 100; i++) {
+		if (mock_node_count(client) == size) {
+			return true;
+		}
+		as_sleep(100);
+	}
+	return false;
+}
+
+static void
+mock_close(aerospike* client, mock_cluster* mock)
+{
+	as_error err;
+	aerospike_close(client, &err);
+	aerospike_destroy(client);
+	mock_cluster_stop(mock);
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(mock_node_tend, "client discovers all mock nodes and partitions")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 3;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_nodes* nodes = as_nodes_reserve(client.cluster);
+	uint32_t size = nodes->size;
+	as_nodes_release(nodes);
+	assert_int_eq(size, 3);
+
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_key, "single record commands against mock nodes")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 2;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, "test", "mock", 1);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "bin", 5);
+	assert_int_eq(aerospike_key_put(&client, &err, NULL, &key, &rec), AEROSPIKE_OK);
+	as_record_destroy(&rec);
+
+	as_record* result = NULL;
+	assert_int_eq(aerospike_key_get(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(result, "bin", 0), 1);
+	as_record_destroy(result);
+
+	result = NULL;
+	assert_int_eq(aerospike_key_exists(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	assert_int_eq(result->bins.size, 0);
+	as_record_destroy(result);
+
+	assert_true(mock_cluster_requests(mock) > 0);
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_batch, "batch reads and writes fan out to mock nodes")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 3;
+	config.value_size = 100;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_batch_records records;
+	as_batch_records_inita(&records, 50);
+
+	as_operations ops;
+	as_operations_inita(&ops, 1);
+	as_operations_add_write_int64(&ops, "bin", 1);
+
+	for (uint32_t i = 0; i < 50; i++) {
+		if (i % 2 == 0) {
+			as_batch_read_record* r = as_batch_read_reserve(&records);
+			as_key_init_int64(&r->key, "test", "mock", i);
+			r->read_all_bins = true;
+		}
+		else {
+			as_batch_write_record* r = as_batch_write_reserve(&records);
+			as_key_init_int64(&r->key, "test", "mock", i);
+			r->ops = &ops;
+		}
+	}
+
+	as_error err;
+	assert_int_eq(aerospike_batch_write(&client, &err, NULL, &records), AEROSPIKE_OK);
+
+	as_vector* list = &records.list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_base_record* r = as_vector_get(list, i);
+		assert_int_eq(r->result, AEROSPIKE_OK);
+
+		if (i % 2 == 0) {
+			as_bytes* bytes = as_record_get_bytes(&r->record, "bin");
+			assert_not_null(bytes);
+			assert_int_eq(as_bytes_size(bytes), 100);
+
+			// Bins of records parsed from one response share one allocation.
+			assert_true(r->record.bins._block);
+		}
+	}
+
+	as_batch_records_destroy(&records);
+	as_operations_destroy(&ops);
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_batch_arena, "batch record values are allocated from arena")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 3;
+	config.value_size = 100;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_batch_records records;
+	as_batch_records_inita(&records, 50);
+
+	for (uint32_t i = 0; i < 50; i++) {
+		as_batch_read_record* r = as_batch_read_reserve(&records);
+		as_key_init_int64(&r->key, "test", "mock", i);
+		r->read_all_bins = true;
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.concurrent = true;
+	policy.arena = true;
+
+	as_error err;
+	assert_int_eq(aerospike_batch_read(&client, &err, &policy, &records), AEROSPIKE_OK);
+	assert_not_null(records.arena);
+
+	as_vector* list = &records.list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_read_record* r = as_vector_get(list, i);
+		assert_int_eq(r->result, AEROSPIKE_OK);
+
+		as_bytes* bytes = as_record_get_bytes(&r->record, "bin");
+		assert_not_null(bytes);
+		assert_int_eq(as_bytes_size(bytes), 100);
+
+		// Bins and values are owned by the arena.
+		assert_false(r->record.bins._free);
+		assert_false(r->record.bins._block);
+		assert_false(bytes->free);
+	}
+
+	as_batch_records_destroy(&records);
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_latency, "mock nodes delay responses")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.latency_us = 20000;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, "test", "mock", 1);
+
+	as_record* result = NULL;
+	uint64_t begin = cf_getms();
+	assert_int_eq(aerospike_key_get(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	assert_true(cf_getms() - begin >= 20);
+	as_record_destroy(result);
+
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_fault, "injected faults cause retries and timeouts")
+{
+	mock_config config;
+	mock_config_init(&config);
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, "test", "mock", 1);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.base.socket_timeout = 50;
+	policy.base.total_timeout = 1000;
+	policy.base.max_retries = 2;
+	policy.base.sleep_between_retries = 0;
+
+	// Every attempt is reset, so the command is sent three times.
+	mock_fault fault;
+	mock_fault_init(&fault);
+	fault.reset_rate = 1.0;
+	mock_cluster_set_fault(mock, 0, &fault);
+
+	as_record* result = NULL;
+	uint64_t commands = mock_cluster_commands(mock);
+	assert_int_ne(aerospike_key_get(&client, &err, &policy, &key, &result), AEROSPIKE_OK);
+	assert_int_eq(mock_cluster_commands(mock) - commands, 3);
+
+	// Lost responses time out.
+	mock_fault_init(&fault);
+	fault.drop_rate = 1.0;
+	mock_cluster_set_fault(mock, 0, &fault);
+
+	assert_int_eq(aerospike_key_get(&client, &err, &policy, &key, &result), AEROSPIKE_ERR_TIMEOUT);
+
+	// Partial responses are reassembled.
+	mock_fault_init(&fault);
+	fault.partial_rate = 1.0;
+	fault.partial_delay_us = 10000;
+	mock_cluster_set_fault(mock, 0, &fault);
+
+	uint64_t begin = cf_getms();
+	assert_int_eq(aerospike_key_get(&client, &err, &policy, &key, &result), AEROSPIKE_OK);
+	assert_true(cf_getms() - begin >= 10);
+	assert_int_eq(as_record_get_int64(result, "bin", 0), 1);
+	as_record_destroy(result);
+
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_topology, "client follows mock node churn and migrations")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 3;
+	config.n_namespaces = 4;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+	assert_int_eq(client.cluster->partition_tables.size, 4);
+	assert_not_null(as_partition_tables_get(&client.cluster->partition_tables, "test3"));
+
+	assert_true(mock_cluster_set_node_down(mock, 2, true));
+	assert_true(mock_wait_nodes(&client, 2));
+
+	mock_cluster_migrate(mock, 1000);
+
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, "test2", "mock", 1);
+
+	as_record* result = NULL;
+	assert_int_eq(aerospike_key_get(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	as_record_destroy(result);
+
+	assert_true(mock_cluster_set_node_down(mock, 2, false));
+	assert_true(mock_wait_nodes(&client, 3));
+
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_shared_tend, "clients share one tend thread and thread pool")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 2;
+
+	mock_cluster* mocks[2];
+	aerospike clients[2];
+
+	as_thread_pool pool;
+	assert_int_eq(as_thread_pool_init(&pool, 4), 0);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		mocks[i] = mock_cluster_start(&config);
+		assert_not_null(mocks[i]);
+
+		as_config cfg;
+		as_config_init(&cfg);
+		as_config_add_host(&cfg, "127.0.0.1", mock_cluster_port(mocks[i], 0));
+		cfg.shared_tend_thread = true;
+		cfg.shared_thread_pool = &pool;
+		aerospike_init(&clients[i], &cfg);
+
+		as_error err;
+		assert_int_eq(aerospike_connect(&clients[i], &err), AEROSPIKE_OK);
+		assert_true(clients[i].cluster->shared_tend);
+	}
+
+	for (uint32_t i = 0; i < 2; i++) {
+		// Batch node tasks run on the shared pool.
+		as_batch_records records;
+		as_batch_records_inita(&records, 10);
+
+		for (uint32_t j = 0; j < 10; j++) {
+			as_batch_read_record* r = as_batch_read_reserve(&records);
+			as_key_init_int64(&r->key, "test", "mock", j);
+			r->read_all_bins = true;
+		}
+
+		as_error err;
+		assert_int_eq(aerospike_batch_read(&clients[i], &err, NULL, &records), AEROSPIKE_OK);
+		as_batch_records_destroy(&records);
+	}
+
+	// Second cluster is still tended after the first client closes.
+	mock_close(&clients[0], mocks[0]);
+
+	assert_true(mock_cluster_set_node_down(mocks[1], 1, true));
+	assert_true(mock_wait_nodes(&clients[1], 1));
+
+	mock_close(&clients[1], mocks[1]);
+	as_thread_pool_destroy(&pool);
+}
+
+TEST(mock_node_resize, "pool limits and thread pool size change at runtime")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 2;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	aerospike client;
+	assert_true(mock_connect(&client, mock));
+
+	as_error err;
+	assert_int_eq(aerospike_set_conns_per_node(&client, &err, 5, 2), AEROSPIKE_ERR_PARAM);
+	assert_int_eq(aerospike_set_conns_per_node(&client, &err, 2, 8), AEROSPIKE_OK);
+
+	as_nodes* nodes = as_nodes_reserve(client.cluster);
+	as_node* node = nodes->array[0];
+	as_node_reserve(node);
+	as_nodes_release(nodes);
+
+	// Tend thread resizes the pools.
+	bool resized = false;
+
+	for (uint32_t i = 0; i < 100 && ! resized; i++) {
+		resized = as_load_uint32(&node->sync_conn_pools[0].queue.capacity) == 8;
+
+		if (! resized) {
+			as_sleep(100);
+		}
+	}
+	as_node_release(node);
+	assert_true(resized);
+
+	as_key key;
+	as_key_init_int64(&key, "test", "mock", 1);
+
+	as_record* result = NULL;
+	assert_int_eq(aerospike_key_get(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	as_record_destroy(result);
+
+	assert_int_eq(aerospike_set_thread_pool_size(&client, &err, 3), AEROSPIKE_OK);
+	assert_int_eq(client.cluster->thread_pool.thread_size, 3);
+	assert_int_eq(aerospike_set_async_conns_per_node(&client, &err, 0, 10), AEROSPIKE_OK);
+	assert_int_eq(client.config.async_max_conns_per_node, 10);
+
+	mock_close(&client, mock);
+}
+
+TEST(mock_node_connect_async, "commands wait for the first tend of an async connect")
+{
+	mock_config config;
+	mock_config_init(&config);
+	config.n_nodes = 2;
+
+	mock_cluster* mock = mock_cluster_start(&config);
+	assert_not_null(mock);
+
+	as_config cfg;
+	as_config_init(&cfg);
+	as_config_add_host(&cfg, "127.0.0.1", mock_cluster_port(mock, 0));
+	cfg.connect_async = true;
+
+	aerospike client;
+	aerospike_init(&client, &cfg);
+
+	as_error err;
+	assert_int_eq(aerospike_connect(&client, &err), AEROSPIKE_OK);
+
+	// First command is routed after the tend thread delivers the partition map.
+	as_key key;
+	as_key_init_int64(&key, "test", "mock", 1);
+
+	as_record* result = NULL;
+	assert_int_eq(aerospike_key_get(&client, &err, NULL, &key, &result), AEROSPIKE_OK);
+	as_record_destroy(result);
+	assert_int_eq(mock_node_count(&client), 2);
+
+	as_cluster_stats stats;
+	aerospike_cluster_stats(client.cluster, &stats);
+	info("startup ms: %" PRIu64, stats.startup_ms);
+	assert_int_eq(client.cluster->connecting, 0);
+	aerospike_stats_destroy(&stats);
+
+	mock_close(&client, mock);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(mock_node, "mock server nodes")
+{
+	suite_add(mock_node_tend);
+	suite_add(mock_node_key);
+	suite_add(mock_node_batch);
+	suite_add(mock_node_batch_arena);
+	suite_add(mock_node_latency);
+	suite_add(mock_node_fault);
+	suite_add(mock_node_topology);
+	suite_add(mock_node_shared_tend);
+	suite_add(mock_node_resize);
+	suite_add(mock_node_connect_async);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_command.h>
+#include <aerospike/as_proto.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+// Append record header and empty fields/bins of the given sizes in network byte order.
+static uint8_t*
+put_msg(uint8_t* p, uint8_t info3, uint32_t gen, uint16_t n_fields, uint16_t n_ops)
+{
+	as_msg* msg = (as_msg*)p;
+	memset(msg, 0, sizeof(as_msg));
+	msg->header_sz = sizeof(as_msg);
+	msg->info3 = info3;
+	msg->generation = cf_swap_to_be32(gen);
+	msg->record_ttl = cf_swap_to_be32(1000);
+	msg->transaction_ttl = cf_swap_to_be32(gen + 1);
+	msg->n_fields = cf_swap_to_be16(n_fields);
+	msg->n_ops = cf_swap_to_be16(n_ops);
+	p += sizeof(as_msg);
+
+	for (uint32_t i = 0; i < (uint32_t)n_fields + n_ops; i++) {
+		*(uint32_t*)p = cf_swap_to_be32(3);
+		memset(p + 4, 0, 3);
+		p += 7;
+	}
+	return p;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(msg_index_build, "record boundaries are indexed and headers swapped")
+{
+	uint8_t* buf = malloc(64 * 1024);
+	uint8_t* p = buf;
+	uint32_t n = 300;
+
+	for (uint32_t i = 0; i < n; i++) {
+		p = put_msg(p, 0, i, 1, (uint16_t)(i % 3));
+	}
+	p = put_msg(p, AS_MSG_INFO3_LAST, 0, 0, 0);
+
+	as_error err;
+	as_msg_index index;
+	as_status status = as_msg_index_build(&err, &index, buf, p - buf);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(index.size, n + 1);
+
+	uint32_t n_records = 0;
+	uint32_t n_bins = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_msg* msg = index.msgs[i];
+		assert_int_eq(msg->generation, i);
+		assert_int_eq(msg->record_ttl, 1000);
+		assert_int_eq(msg->transaction_ttl, i + 1);
+		assert_int_eq(msg->n_fields, 1);
+		assert_int_eq(msg->n_ops, i % 3);
+
+		if (msg->n_ops > 0) {
+			n_records++;
+			n_bins += msg->n_ops;
+		}
+	}
+	assert_true(index.msgs[n]->info3 & AS_MSG_INFO3_LAST);
+	assert_int_eq(index.n_records, n_records);
+	assert_int_eq(index.n_bins, n_bins);
+
+	as_msg_index_destroy(&index);
+	free(buf);
+}
+
+TEST(msg_index_truncated, "truncated records are rejected")
+{
+	uint8_t buf[256];
+	uint8_t* p = put_msg(buf, 0, 1, 1, 2);
+	p = put_msg(p, 0, 2, 1, 2);
+
+	as_error err;
+	as_msg_index index;
+	as_status status = as_msg_index_build(&err, &index, buf, p - buf - 1);
+	assert_int_eq(status, AEROSPIKE_ERR_CLIENT);
+	as_msg_index_destroy(&index);
+
+	p = put_msg(buf, 0, 1, 1, 2);
+	status = as_msg_index_build(&err, &index, buf, sizeof(as_msg) - 1);
+	assert_int_eq(status, AEROSPIKE_ERR_CLIENT);
+	as_msg_index_destroy(&index);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(msg_index, "response record index")
+{
+	suite_add(msg_index_build);
+	suite_add(msg_index_truncated);
+}
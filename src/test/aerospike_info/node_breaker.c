@@ -0,0 +1,178 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_node.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_node*
+breaker_node_create(uint32_t backoff_max)
+{
+	as_cluster* cluster = calloc(1, sizeof(as_cluster));
+	cluster->max_error_rate = 100;
+	cluster->error_rate_window = 1;
+	cluster->error_rate_backoff_max = backoff_max;
+	cluster->error_rate_probe_interval = 10;
+
+	as_node* node = calloc(1, sizeof(as_node));
+	strcpy(node->name, "BB9000000000000");
+	node->cluster = cluster;
+	node->breaker_state = AS_NODE_BREAKER_CLOSED;
+	node->breaker_backoff = 1;
+	return node;
+}
+
+static void
+breaker_node_destroy(as_node* node)
+{
+	free(node->cluster);
+	free(node);
+}
+
+static void
+breaker_window(as_node* node, uint32_t errors)
+{
+	for (uint32_t i = 0; i < errors; i++) {
+		as_node_incr_error_count(node);
+	}
+	as_node_error_window_end(node);
+}
+
+static uint32_t
+breaker_admitted(as_node* node, uint32_t n)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		if (as_node_breaker_allow(node)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(node_breaker_backoff, "breaker backs off exponentially while probes fail")
+{
+	as_node* node = breaker_node_create(4);
+
+	assert_int_eq(breaker_admitted(node, 100), 100);
+
+	// Exceed error rate. Breaker stays open for 1 window.
+	breaker_window(node, 101);
+	assert_int_eq(node->breaker_state, AS_NODE_BREAKER_OPEN);
+	assert_int_eq(breaker_admitted(node, 100), 0);
+
+	breaker_window(node, 0);
+	assert_int_eq(node->breaker_state, AS_NODE_BREAKER_HALF_OPEN);
+	assert_int_eq(breaker_admitted(node, 100), 10);
+
+	// Failed probes open the breaker for 2, then 4, then at most 4 windows.
+	uint32_t expect[] = {2, 4, 4};
+
+	for (uint32_t i = 0; i < 3; i++) {
+		breaker_window(node, 11);
+		assert_int_eq(node->breaker_state, AS_NODE_BREAKER_OPEN);
+
+		for (uint32_t j = 1; j < expect[i]; j++) {
+			breaker_window(node, 0);
+			assert_int_eq(node->breaker_state, AS_NODE_BREAKER_OPEN);
+		}
+		breaker_window(node, 0);
+		assert_int_eq(node->breaker_state, AS_NODE_BREAKER_HALF_OPEN);
+	}
+
+	// Successful probes close the breaker and reset backoff.
+	breaker_window(node, 10);
+	assert_int_eq(node->breaker_state, AS_NODE_BREAKER_CLOSED);
+	assert_int_eq(node->breaker_backoff, 1);
+	assert_int_eq(breaker_admitted(node, 100), 100);
+
+	breaker_node_destroy(node);
+}
+
+TEST(node_breaker_disabled, "zero backoff max keeps per window reset")
+{
+	as_node* node = breaker_node_create(0);
+
+	for (uint32_t i = 0; i < 101; i++) {
+		as_node_incr_error_count(node);
+	}
+	assert_false(as_node_breaker_allow(node));
+
+	as_node_error_window_end(node);
+	assert_int_eq(node->breaker_state, AS_NODE_BREAKER_CLOSED);
+	assert_int_eq(breaker_admitted(node, 100), 100);
+
+	breaker_node_destroy(node);
+}
+
+TEST(node_breaker_retry_budget, "retry budget refills from completed commands")
+{
+	as_cluster cluster;
+	memset(&cluster, 0, sizeof(cluster));
+
+	// 10% budget with a burst of 2 retries.
+	cluster.retry_tokens_per_command = 100;
+	cluster.retry_tokens_max = 2000;
+	cluster.retry_tokens = cluster.retry_tokens_max;
+
+	assert_true(as_cluster_retry_acquire(&cluster));
+	assert_true(as_cluster_retry_acquire(&cluster));
+	assert_false(as_cluster_retry_acquire(&cluster));
+	assert_int_eq(cluster.retry_budget_rejects, 1);
+
+	for (uint32_t i = 0; i < 9; i++) {
+		as_cluster_retry_deposit(&cluster);
+	}
+	assert_false(as_cluster_retry_acquire(&cluster));
+
+	as_cluster_retry_deposit(&cluster);
+	assert_true(as_cluster_retry_acquire(&cluster));
+	assert_int_eq(cluster.retry_budget_rejects, 2);
+
+	// Bucket does not grow past its maximum.
+	for (uint32_t i = 0; i < 1000; i++) {
+		as_cluster_retry_deposit(&cluster);
+	}
+	assert_int_eq(cluster.retry_tokens, cluster.retry_tokens_max);
+
+	// Disabled budget never rejects.
+	cluster.retry_tokens_per_command = 0;
+	cluster.retry_tokens = 0;
+	assert_true(as_cluster_retry_acquire(&cluster));
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(node_breaker, "node circuit breaker and retry budget")
+{
+	suite_add(node_breaker_backoff);
+	suite_add(node_breaker_disabled);
+	suite_add(node_breaker_retry_budget);
+}
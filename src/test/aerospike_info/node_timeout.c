@@ -0,0 +1,103 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_node.h>
+#include <stdlib.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_node*
+timeout_node_create(uint32_t factor)
+{
+	as_cluster* cluster = calloc(1, sizeof(as_cluster));
+	cluster->adaptive_timeout_factor = factor;
+	cluster->adaptive_timeout_min = 10;
+
+	as_node* node = calloc(1, sizeof(as_node));
+	node->cluster = cluster;
+	node->timeout_hist = calloc(AS_LATENCY_SHARDS, sizeof(as_timeout_shard));
+	return node;
+}
+
+static void
+timeout_node_destroy(as_node* node)
+{
+	free(node->timeout_hist);
+	free(node->cluster);
+	free(node);
+}
+
+static void
+timeout_samples(as_node* node, uint32_t bucket, uint32_t count)
+{
+	// Spread samples over shards like multiple threads would.
+	for (uint32_t i = 0; i < count; i++) {
+		node->timeout_hist[i % AS_LATENCY_SHARDS].buckets[bucket]++;
+	}
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(node_timeout_p99, "adaptive timeout follows node p99 latency")
+{
+	as_node* node = timeout_node_create(40);
+
+	// No estimate yet. Configured timeout applies.
+	assert_int_eq(as_node_adaptive_timeout(node, 1000), 1000);
+
+	// Too few samples.
+	timeout_samples(node, 10, 50);
+	as_node_update_timeout(node);
+	assert_int_eq(node->timeout_p99_us, 0);
+
+	// 99 samples in [512, 1024) microseconds and one slow outlier.
+	timeout_samples(node, 10, 49);
+	timeout_samples(node, 16, 1);
+	as_node_update_timeout(node);
+	assert_int_eq(node->timeout_p99_us, 1024);
+
+	// 40 * 1024us rounded up to milliseconds, then clamped by configured timeout.
+	assert_int_eq(as_node_adaptive_timeout(node, 1000), 41);
+	assert_int_eq(as_node_adaptive_timeout(node, 20), 20);
+	assert_int_eq(as_node_adaptive_timeout(node, 0), 0);
+
+	// Lower bound applies.
+	node->cluster->adaptive_timeout_factor = 4;
+	assert_int_eq(as_node_adaptive_timeout(node, 1000), 10);
+
+	// Estimate decays slowly when latency drops.
+	timeout_samples(node, 1, 100);
+	as_node_update_timeout(node);
+	assert_int_eq(node->timeout_p99_us, 1024 - (1024 - 1) / 4);
+
+	timeout_node_destroy(node);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(node_timeout, "latency adaptive socket timeouts")
+{
+	suite_add(node_timeout_p99);
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_node.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_partition_bitmap.h>
+#include <citrusleaf/cf_b64.h>
+#include <citrusleaf/cf_clock.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define N_NODES 8
+#define N_NAMESPACES 16
+#define N_PARTITIONS 4096
+#define N_ROUNDS 50
+#define N_MOVES 64
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	as_cluster cluster;
+	as_node* nodes[N_NODES];
+	uint8_t master[N_NAMESPACES][N_PARTITIONS];
+	uint8_t prole[N_NAMESPACES][N_PARTITIONS];
+} sim_cluster;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+bool
+as_partition_tables_update_all(as_cluster* cluster, as_node* node, char* buf, bool has_regime);
+
+static sim_cluster*
+sim_create(void)
+{
+	sim_cluster* sim = calloc(1, sizeof(sim_cluster));
+	sim->cluster.n_partitions = N_PARTITIONS;
+	sim->cluster.gc = as_vector_create(sizeof(as_gc_item), 8);
+
+	for (uint32_t i = 0; i < N_NODES; i++) {
+		as_node* node = calloc(1, sizeof(as_node));
+		sprintf(node->name, "BB9%u", i);
+		node->cluster = &sim->cluster;
+		// Partition maps never release the last reference of simulated nodes.
+		node->ref_count = 1000000;
+		as_vector_init(&node->partition_bitmaps, sizeof(as_partition_bitmap*), 4);
+		sim->nodes[i] = node;
+	}
+
+	for (uint32_t n = 0; n < N_NAMESPACES; n++) {
+		for (uint32_t p = 0; p < N_PARTITIONS; p++) {
+			sim->master[n][p] = p % N_NODES;
+			sim->prole[n][p] = (p + 1) % N_NODES;
+		}
+	}
+	return sim;
+}
+
+static void
+sim_destroy(sim_cluster* sim)
+{
+	as_partition_tables_destroy(&sim->cluster.partition_tables);
+	as_vector_destroy(sim->cluster.gc);
+
+	for (uint32_t i = 0; i < N_NODES; i++) {
+		as_partition_bitmaps_destroy(&sim->nodes[i]->partition_bitmaps);
+		free(sim->nodes[i]);
+	}
+	free(sim);
+}
+
+static void
+sim_encode(uint8_t owners[N_PARTITIONS], uint32_t node_index, char* out)
+{
+	uint8_t bitmap[N_PARTITIONS / 8];
+	memset(bitmap, 0, sizeof(bitmap));
+
+	for (uint32_t p = 0; p < N_PARTITIONS; p++) {
+		if (owners[p] == node_index) {
+			bitmap[p >> 3] |= 0x80 >> (p & 7);
+		}
+	}
+	cf_b64_encode(bitmap, sizeof(bitmap), out);
+	out[cf_b64_encoded_len(sizeof(bitmap))] = 0;
+}
+
+static void
+sim_replicas(sim_cluster* sim, uint32_t node_index, char* buf)
+{
+	// Same format as the server's "replicas" info response without regime.
+	char* p = buf;
+
+	for (uint32_t n = 0; n < N_NAMESPACES; n++) {
+		p += sprintf(p, "ns%u:2,", n);
+		sim_encode(sim->master[n], node_index, p);
+		p += strlen(p);
+		*p++ = ',';
+		sim_encode(sim->prole[n], node_index, p);
+		p += strlen(p);
+		*p++ = ';';
+	}
+	*p = 0;
+}
+
+static uint64_t
+sim_tend(sim_cluster* sim, char* buf)
+{
+	uint64_t elapsed = 0;
+
+	for (uint32_t i = 0; i < N_NODES; i++) {
+		sim_replicas(sim, i, buf);
+
+		uint64_t begin = cf_getns();
+		as_partition_tables_update_all(&sim->cluster, sim->nodes[i], buf, false);
+		elapsed += cf_getns() - begin;
+	}
+	return elapsed;
+}
+
+static bool
+sim_verify(sim_cluster* sim)
+{
+	as_partition_tables* tables = &sim->cluster.partition_tables;
+
+	if (tables->size != N_NAMESPACES) {
+		return false;
+	}
+
+	for (uint32_t n = 0; n < N_NAMESPACES; n++) {
+		char ns[16];
+		sprintf(ns, "ns%u", n);
+		as_partition_table* table = as_partition_tables_get(tables, ns);
+
+		if (! table) {
+			return false;
+		}
+
+		for (uint32_t p = 0; p < N_PARTITIONS; p++) {
+			if (table->partitions[p].master != sim->nodes[sim->master[n][p]] ||
+				table->partitions[p].prole != sim->nodes[sim->prole[n][p]]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(partition_update_migrate, "incremental partition map updates during migrations")
+{
+	sim_cluster* sim = sim_create();
+	char* buf = malloc(N_NAMESPACES * 2 * 1024);
+
+	uint64_t full = sim_tend(sim, buf);
+	assert_true(sim_verify(sim));
+
+	// Each round, one namespace migrates a batch of partitions to the next node while the
+	// other namespaces are unchanged. Every node still reports all namespaces.
+	uint64_t incremental = 0;
+	uint32_t base = 0;
+
+	for (uint32_t r = 0; r < N_ROUNDS; r++) {
+		uint32_t n = r % N_NAMESPACES;
+
+		for (uint32_t i = 0; i < N_MOVES; i++) {
+			uint32_t p = (base + i * 61) % N_PARTITIONS;
+			uint8_t master = sim->master[n][p];
+			sim->master[n][p] = sim->prole[n][p];
+			sim->prole[n][p] = master;
+		}
+		base += 7;
+
+		incremental += sim_tend(sim, buf);
+		assert_true(sim_verify(sim));
+	}
+
+	info("full update: %" PRIu64 " us, incremental update: %" PRIu64 " us per round",
+		full / 1000, incremental / N_ROUNDS / 1000);
+
+	free(buf);
+	sim_destroy(sim);
+}
+
+TEST(partition_update_steal, "partitions taken by another node are restored")
+{
+	sim_cluster* sim = sim_create();
+	char* buf = malloc(N_NAMESPACES * 2 * 1024);
+
+	sim_tend(sim, buf);
+	assert_true(sim_verify(sim));
+
+	// Node 1 claims partition 0, which node 0 also still claims.
+	sim->master[0][0] = 1;
+	sim_replicas(sim, 1, buf);
+	as_partition_tables_update_all(&sim->cluster, sim->nodes[1], buf, false);
+
+	// Node 1 drops partition 0 again. Node 0 reports an unchanged bitmap, so partition 0
+	// must be restored from node 0's claim even though its bitmap hash did not change.
+	sim->master[0][0] = 0;
+	sim_tend(sim, buf);
+	assert_true(sim_verify(sim));
+
+	free(buf);
+	sim_destroy(sim);
+}
+
+TEST(partition_update_suspect, "commands avoid replicas that failed to connect")
+{
+	sim_cluster* sim = sim_create();
+	as_node* n0 = sim->nodes[0];
+	as_node* n1 = sim->nodes[1];
+	n0->active = true;
+	n1->active = true;
+
+	as_partition p = {.master = n0, .prole = n1, .regime = 0};
+	as_cluster* c = &sim->cluster;
+
+	assert_true(as_partition_reg_get_node(c, "test", &p, NULL, AS_POLICY_REPLICA_SEQUENCE, true)
+		== n0);
+
+	as_node_set_suspect(n0);
+	assert_true(as_partition_reg_get_node(c, "test", &p, NULL, AS_POLICY_REPLICA_SEQUENCE, true)
+		== n1);
+	assert_true(as_partition_reg_get_node(c, "test", &p, NULL,
+		AS_POLICY_REPLICA_LOWEST_LATENCY, true) == n1);
+
+	// Master only commands still go to the suspect master.
+	assert_true(as_partition_reg_get_node(c, "test", &p, NULL, AS_POLICY_REPLICA_MASTER, true)
+		== n0);
+
+	// Suspect node is still used when no other replica is usable.
+	n1->active = false;
+	assert_true(as_partition_reg_get_node(c, "test", &p, NULL, AS_POLICY_REPLICA_SEQUENCE, true)
+		== n0);
+
+	sim_destroy(sim);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(partition_update, "partition map updates")
+{
+	suite_add(partition_update_migrate);
+	suite_add(partition_update_steal);
+	suite_add(partition_update_suspect);
+}
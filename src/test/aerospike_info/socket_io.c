@@ -0,0 +1,200 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_socket.h>
+#include <aerospike/as_socket_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * GLOBAL VARS
+ *****************************************************************************/
+
+extern aerospike* as;
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define NAMESPACE "test"
+#define SET "test_socket_io"
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(socket_io_uring, "put and get with io_uring socket I/O")
+{
+	if (! as_socket_uring_enable(true)) {
+		info("io_uring socket I/O not supported");
+		return;
+	}
+
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "uring");
+
+	// Value larger than the prefetch buffer forces a direct receive after prefetched data.
+	uint32_t size = AS_SOCKET_URING_PREFETCH_SIZE * 2;
+	uint8_t* bytes = malloc(size);
+
+	for (uint32_t i = 0; i < size; i++) {
+		bytes[i] = (uint8_t)i;
+	}
+
+	as_record rec;
+	as_record_inita(&rec, 2);
+	as_record_set_int64(&rec, "a", 123);
+	as_record_set_raw(&rec, "b", bytes, size);
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	for (int i = 0; i < 10; i++) {
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(prec, "a", 0), 123);
+
+		as_bytes* b = as_record_get_bytes(prec, "b");
+		assert_not_null(b);
+		assert_int_eq(as_bytes_size(b), size);
+		assert_true(memcmp(as_bytes_get(b), bytes, size) == 0);
+		as_record_destroy(prec);
+	}
+
+	as_socket_uring_enable(false);
+	as_socket_uring_release_thread();
+	free(bytes);
+	as_key_destroy(&key);
+}
+
+TEST(socket_io_read_spin, "get with busy poll read spin")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "spin");
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 456);
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.base.read_spin_us = 50;
+
+	for (int i = 0; i < 20; i++) {
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(prec, "a", 0), 456);
+		as_record_destroy(prec);
+	}
+
+	as_key_destroy(&key);
+}
+
+TEST(socket_io_read_ahead, "socket read-ahead buffer serves header and body reads")
+{
+	int fds[2];
+	assert_int_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+	as_socket sock;
+	as_socket_init(&sock);
+	assert_true(as_socket_wrap(&sock, AF_UNIX, fds[0], NULL, NULL));
+	as_socket_set_read_buffer(&sock, 64);
+
+	// Two messages written at once are received with one read.
+	uint8_t data[48];
+
+	for (uint32_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)i;
+	}
+	assert_int_eq(write(fds[1], data, sizeof(data)), sizeof(data));
+
+	as_error err;
+	uint8_t buf[128];
+	uint64_t deadline = as_socket_deadline(1000);
+
+	assert_int_eq(as_socket_read_deadline(&err, &sock, NULL, buf, 8, 0, deadline), AEROSPIKE_OK);
+	assert_int_eq(sock.rbuf_len, sizeof(data));
+	assert_int_eq(sock.rbuf_pos, 8);
+	assert_int_eq(as_socket_read_deadline(&err, &sock, NULL, buf + 8, 40, 0, deadline), AEROSPIKE_OK);
+	assert_int_eq(sock.rbuf_pos, sock.rbuf_len);
+	assert_true(memcmp(buf, data, sizeof(data)) == 0);
+
+	// Reads larger than the buffer go directly to the destination.
+	uint8_t big[100];
+	memset(big, 7, sizeof(big));
+	assert_int_eq(write(fds[1], big, sizeof(big)), sizeof(big));
+	assert_int_eq(as_socket_read_deadline(&err, &sock, NULL, buf, sizeof(big), 0, deadline), AEROSPIKE_OK);
+	assert_true(memcmp(buf, big, sizeof(big)) == 0);
+
+	as_socket_close(&sock);
+	assert_null(sock.rbuf);
+	close(fds[1]);
+}
+
+TEST(socket_io_profile, "socket profile sets kernel buffer sizes")
+{
+	as_socket_fd fd;
+	assert_int_eq(as_socket_create_fd(AF_INET, &fd), 0);
+
+	as_socket sock;
+	as_socket_init(&sock);
+	assert_true(as_socket_wrap(&sock, AF_INET, fd, NULL, NULL));
+
+	int before = 0;
+	socklen_t len = sizeof(before);
+	assert_int_eq(getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &before, &len), 0);
+
+	// Kernel may round or cap the size, so only check that it grew.
+	as_socket_set_profile(&sock, (uint32_t)before * 4, 0, true);
+
+	int after = 0;
+	len = sizeof(after);
+	assert_int_eq(getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &after, &len), 0);
+	assert_true(after > before);
+	as_socket_close(&sock);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(socket_io, "socket I/O")
+{
+	suite_add(socket_io_uring);
+	suite_add(socket_io_read_spin);
+	suite_add(socket_io_read_ahead);
+	suite_add(socket_io_profile);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike_stats.h>
+#include <aerospike/as_node.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+stats_init(as_cluster_stats* stats, as_node_stats* ns, as_node* node)
+{
+	memset(stats, 0, sizeof(as_cluster_stats));
+	memset(ns, 0, sizeof(as_node_stats));
+	memset(node, 0, sizeof(as_node));
+	strcpy(node->name, "BB9000000000001");
+
+	ns->node = node;
+	ns->sync.in_use = 3;
+	ns->counters.commands = 42;
+	ns->latency[AS_LATENCY_TYPE_READ][0] = 1;
+	ns->latency[AS_LATENCY_TYPE_READ][3] = 2;
+	stats->nodes = ns;
+	stats->nodes_size = 1;
+	stats->memory[AS_MEMORY_TEND].current = 4096;
+	stats->memory[AS_MEMORY_TEND].peak = 8192;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(stats_export_prometheus, "render stats in prometheus text format")
+{
+	as_cluster_stats stats;
+	as_node_stats ns;
+	as_node node;
+	stats_init(&stats, &ns, &node);
+
+	char buf[16384];
+	size_t len = aerospike_stats_to_prometheus(&stats, buf, sizeof(buf));
+	assert_true(len < sizeof(buf));
+	assert_int_eq(strlen(buf), len);
+
+	assert_not_null(strstr(buf,
+		"aerospike_client_connections{node=\"BB9000000000001\",pool=\"sync\",state=\"in_use\"} 3\n"));
+	assert_not_null(strstr(buf, "aerospike_client_commands_total{node=\"BB9000000000001\"} 42\n"));
+
+	// Histogram buckets are cumulative.
+	const char* prefix = "aerospike_client_command_latency_us_bucket{node=\"BB9000000000001\",type=\"read\",";
+	char line[256];
+	sprintf(line, "%sle=\"0\"} 1\n", prefix);
+	assert_not_null(strstr(buf, line));
+	sprintf(line, "%sle=\"3\"} 1\n", prefix);
+	assert_not_null(strstr(buf, line));
+	sprintf(line, "%sle=\"7\"} 3\n", prefix);
+	assert_not_null(strstr(buf, line));
+	sprintf(line, "%sle=\"+Inf\"} 3\n", prefix);
+	assert_not_null(strstr(buf, line));
+
+	// Empty histograms are omitted.
+	assert_null(strstr(buf, "type=\"write\""));
+
+	assert_not_null(strstr(buf, "aerospike_client_memory_bytes{tag=\"tend\"} 4096\n"));
+	assert_not_null(strstr(buf, "aerospike_client_memory_peak_bytes{tag=\"tend\"} 8192\n"));
+}
+
+TEST(stats_export_memory, "memory accounting tracks current and peak bytes")
+{
+	as_memory_usage before[AS_MEMORY_MAX];
+	as_memory_get_usage(before);
+
+	as_memory_add(AS_MEMORY_QUERY, 1000);
+	as_memory_add(AS_MEMORY_QUERY, 500);
+	as_memory_sub(AS_MEMORY_QUERY, 1500);
+
+	as_memory_usage after[AS_MEMORY_MAX];
+	as_memory_get_usage(after);
+
+	assert_int_eq(after[AS_MEMORY_QUERY].current, before[AS_MEMORY_QUERY].current);
+	assert_true(after[AS_MEMORY_QUERY].peak >= before[AS_MEMORY_QUERY].current + 1500);
+	assert_string_eq(as_memory_tag_name(AS_MEMORY_QUERY), "query");
+}
+
+TEST(stats_export_truncate, "prometheus output reports required size when truncated")
+{
+	as_cluster_stats stats;
+	as_node_stats ns;
+	as_node node;
+	stats_init(&stats, &ns, &node);
+
+	size_t full = aerospike_stats_to_prometheus(&stats, NULL, 0);
+
+	char buf[64];
+	size_t len = aerospike_stats_to_prometheus(&stats, buf, sizeof(buf));
+	assert_int_eq(len, full);
+	assert_int_eq(strlen(buf), sizeof(buf) - 1);
+}
+
+TEST(stats_export_hot_keys, "hot key sketch reports heavy hitters")
+{
+	// Four counters, ten commands per sample.
+	as_hot_keys* hk = as_hot_keys_create(4, 10);
+	as_digest_value hot;
+	memset(hot, 0xAB, sizeof(hot));
+
+	for (uint32_t i = 0; i < 100; i++) {
+		as_hot_keys_add(hk, "test", hot, 7, 50);
+
+		// Many keys that are accessed once must not displace the hot key.
+		as_digest_value cold;
+		memset(cold, 0, sizeof(cold));
+		memcpy(cold, &i, sizeof(i));
+		as_hot_keys_add(hk, "test", cold, 100 + (i % 2), 10);
+	}
+
+	as_cluster_stats stats;
+	as_node_stats ns;
+	as_node node;
+	stats_init(&stats, &ns, &node);
+
+	stats.hot_keys_size = as_hot_keys_top(hk, stats.hot_keys, AS_HOT_KEYS_TOP);
+	assert_int_eq(stats.hot_keys_size, 4);
+	assert_true(memcmp(stats.hot_keys[0].digest, hot, sizeof(hot)) == 0);
+	assert_int_eq(stats.hot_keys[0].count, 1000);
+	assert_int_eq(stats.hot_keys[0].error, 0);
+	assert_int_eq(stats.hot_keys[0].bytes, 50000);
+
+	stats.hot_partitions_size = as_hot_keys_top_partitions(hk, stats.hot_partitions, 2);
+	assert_int_eq(stats.hot_partitions_size, 2);
+	assert_int_eq(stats.hot_partitions[0].partition_id, 7);
+	assert_int_eq(stats.hot_partitions[0].count, 1000);
+	as_hot_keys_destroy(hk);
+
+	char buf[16384];
+	aerospike_stats_to_prometheus(&stats, buf, sizeof(buf));
+	assert_not_null(strstr(buf, "aerospike_client_hot_key_commands{ns=\"test\",digest=\""
+		"abababababababababababababababababababab\",partition=\"7\"} 1000\n"));
+	assert_not_null(strstr(buf,
+		"aerospike_client_hot_partition_commands{ns=\"test\",partition=\"7\"} 1000\n"));
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(stats_export, "cluster stats export")
+{
+	suite_add(stats_export_prometheus);
+	suite_add(stats_export_truncate);
+	suite_add(stats_export_memory);
+	suite_add(stats_export_hot_keys);
+}
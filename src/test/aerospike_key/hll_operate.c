@@ -18,6 +18,7 @@
 #include <aerospike/aerospike_key.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_exp.h>
+#include <aerospike/as_hll.h>
 #include <aerospike/as_hll_operations.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_list_operations.h>
@@ -324,6 +325,68 @@ TEST(hll_read_write, "hll read write")
 	as_record_destroy(prec);
 }
 
+TEST(hll_local, "hll client side estimates")
+{
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 103);
+
+	as_error err;
+	as_status status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_true(status == AEROSPIKE_OK || status == AEROSPIKE_ERR_RECORD_NOT_FOUND);
+
+	// h1 = [0, 1000), h2 = [500, 1500).
+	as_arraylist list1;
+	as_arraylist_init(&list1, 1000, 0);
+	as_arraylist list2;
+	as_arraylist_init(&list2, 1000, 0);
+
+	for (int64_t i = 0; i < 1000; i++) {
+		as_arraylist_append_int64(&list1, i);
+		as_arraylist_append_int64(&list2, i + 500);
+	}
+
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+	as_operations_hll_add_mh(&ops, "h1", NULL, NULL, (as_list*)&list1, 12, 16);
+	as_operations_hll_add_mh(&ops, "h2", NULL, NULL, (as_list*)&list2, 12, 16);
+
+	status = aerospike_key_operate(as, &err, NULL, &key, &ops, NULL);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_operations_destroy(&ops);
+	as_arraylist_destroy(&list1);
+	as_arraylist_destroy(&list2);
+
+	as_record* prec = 0;
+	status = aerospike_key_get(as, &err, NULL, &key, &prec);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	const as_bytes* hlls[2];
+	hlls[0] = as_record_get_bytes(prec, "h1");
+	hlls[1] = as_record_get_bytes(prec, "h2");
+	assert_not_null(hlls[0]);
+	assert_not_null(hlls[1]);
+
+	uint64_t count;
+	status = as_hll_count(&err, hlls[0], &count);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(count > 900 && count < 1100);
+
+	status = as_hll_union_count(&err, hlls, 2, &count);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(count > 1350 && count < 1650);
+
+	status = as_hll_intersect_count(&err, hlls, 2, &count);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(count > 375 && count < 625);
+
+	double similarity;
+	status = as_hll_similarity(&err, hlls, 2, &similarity);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_true(similarity > 0.25 && similarity < 0.42);
+
+	as_record_destroy(prec);
+}
+
 TEST(hll_filter_call_read_count, "HLL filter call read count")
 {
 	as_exp_build(filter1,
@@ -857,6 +920,7 @@ SUITE(hll, "HLL tests")
 	suite_add(hll_init);
 	suite_add(hll_ops);
 	suite_add(hll_read_write);
+	suite_add(hll_local);
 
 	suite_add(hll_filter_call_read_count);
 	suite_add(hll_filter_call_read_union);
@@ -16,21 +16,29 @@
  */
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_partition.h>
 #include <aerospike/aerospike_scan.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_buffer.h>
+#include <aerospike/as_capture.h>
+#include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
+#include <aerospike/as_exp.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_map.h>
 #include <aerospike/as_msgpack_serializer.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_record_iterator.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_status.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_stringmap.h>
 #include <aerospike/as_val.h>
+#include <citrusleaf/alloc.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "../test.h"
 
@@ -264,6 +272,40 @@ TEST( key_basics_exists , "exists: (test,test,foo)" ) {
 	as_record_destroy(rec);
 }
 
+TEST( key_basics_exists_namespace_id , "exists with namespace id: (test,test,foo)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t ns_id = 0;
+	as_status rc = aerospike_namespace_id(as, &err, NAMESPACE, &ns_id);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_true( ns_id > 0 );
+
+	rc = aerospike_namespace_id(as, &err, "ns_not_found", &ns_id);
+	assert_int_eq( rc, AEROSPIKE_ERR_CLIENT );
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo");
+	aerospike_namespace_id(as, &err, NAMESPACE, &ns_id);
+	as_key_set_namespace_id(&key, ns_id);
+
+	as_record * rec = NULL;
+	rc = aerospike_key_exists(as, &err, NULL, &key, &rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_not_null( rec );
+	as_record_destroy(rec);
+
+	// Mismatched ID falls back to the namespace name.
+	as_key_set_namespace_id(&key, ns_id + 1000);
+	rec = NULL;
+	rc = aerospike_key_exists(as, &err, NULL, &key, &rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	as_record_destroy(rec);
+
+	as_key_destroy(&key);
+}
+
 TEST( key_basics_notexists , "not exists: (test,test,foozoo)" ) {
 
 	as_error err;
@@ -792,6 +834,914 @@ TEST(key_basics_bool, "bool")
 
 }
 
+TEST(key_basics_zero_copy, "get with zero copy read policy")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "zcopy");
+
+	uint32_t size = 100000;
+	uint8_t* bytes = malloc(size);
+	memset(bytes, 7, size);
+
+	as_record rec;
+	as_record_init(&rec, 2);
+	as_record_set_raw(&rec, "a", bytes, size);
+	as_record_set_str(&rec, "b", "abc");
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.zero_copy = true;
+
+	as_record* prec = NULL;
+	rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_not_null(prec->buffer);
+	assert_string_eq(as_record_get_str(prec, "b"), "abc");
+
+	as_bytes* b = as_record_get_bytes(prec, "a");
+	assert_not_null(b);
+	assert_int_eq(b->size, size);
+	assert_false(b->free);
+	assert_true(memcmp(b->value, bytes, size) == 0);
+
+	// Reuse record for a second read.
+	rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	b = as_record_get_bytes(prec, "a");
+	assert_not_null(b);
+	assert_true(memcmp(b->value, bytes, size) == 0);
+
+	as_record_destroy(prec);
+	free(bytes);
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_gather, "put with gather write policy")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "gather");
+
+	uint32_t size = 100000;
+	uint8_t* bytes = malloc(size);
+	memset(bytes, 9, size);
+
+	as_record rec;
+	as_record_init(&rec, 4);
+	as_record_set_raw(&rec, "a", bytes, size);
+	as_record_set_int64(&rec, "b", 55);
+	as_record_set_str(&rec, "c", "abcdefghijklmnopqrstuvwxyz");
+	as_record_set_raw(&rec, "d", bytes, size / 2);
+
+	as_policy_write policy;
+	as_policy_write_init(&policy);
+	policy.gather_threshold = 16;
+
+	as_status rc = aerospike_key_put(as, &err, &policy, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_record* prec = NULL;
+	rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(prec, "b", 0), 55);
+	assert_string_eq(as_record_get_str(prec, "c"), "abcdefghijklmnopqrstuvwxyz");
+
+	as_bytes* b = as_record_get_bytes(prec, "a");
+	assert_not_null(b);
+	assert_int_eq(b->size, size);
+	assert_true(memcmp(b->value, bytes, size) == 0);
+
+	b = as_record_get_bytes(prec, "d");
+	assert_not_null(b);
+	assert_int_eq(b->size, size / 2);
+	assert_true(memcmp(b->value, bytes, size / 2) == 0);
+
+	as_record_destroy(prec);
+	free(bytes);
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_digests, "multi-key digests match single key digests")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t n_keys = 77;
+	as_key* keys = malloc(sizeof(as_key) * n_keys);
+	as_key* expect = malloc(sizeof(as_key) * n_keys);
+	char* long_str = malloc(300);
+	memset(long_str, 'x', 299);
+	long_str[299] = 0;
+	uint8_t blob[100];
+	memset(blob, 3, sizeof(blob));
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		switch (i % 4) {
+			case 0:
+				as_key_init_int64(&keys[i], NAMESPACE, SET, i);
+				as_key_init_int64(&expect[i], NAMESPACE, SET, i);
+				break;
+			case 1:
+				as_key_init_str(&keys[i], NAMESPACE, SET, "digest");
+				as_key_init_str(&expect[i], NAMESPACE, SET, "digest");
+				break;
+			case 2:
+				as_key_init_str(&keys[i], NAMESPACE, SET, long_str);
+				as_key_init_str(&expect[i], NAMESPACE, SET, long_str);
+				break;
+			default:
+				as_key_init_raw(&keys[i], NAMESPACE, SET, blob, i);
+				as_key_init_raw(&expect[i], NAMESPACE, SET, blob, i);
+				break;
+		}
+	}
+
+	as_status rc = as_key_set_digests(&err, keys, n_keys, sizeof(as_key));
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		rc = as_key_set_digest(&err, &expect[i]);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_true(keys[i].digest.init);
+		assert_true(memcmp(keys[i].digest.value, expect[i].digest.value, AS_DIGEST_VALUE_SIZE) == 0);
+		as_key_destroy(&keys[i]);
+		as_key_destroy(&expect[i]);
+	}
+
+	free(long_str);
+	free(expect);
+	free(keys);
+}
+
+TEST(key_basics_hedge, "get with hedged read policy")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "hedge");
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 123);
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.replica = AS_POLICY_REPLICA_SEQUENCE;
+	policy.hedge_delay = 1;
+
+	// Response is correct regardless of which replica answers first.
+	for (int i = 0; i < 20; i++) {
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(prec, "a", 0), 123);
+		as_record_destroy(prec);
+	}
+
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_get_many, "get multiple keys with responses read as they arrive")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	// More keys than one poll group, so multiple groups are executed.
+	uint32_t n_keys = AS_COMMAND_MUX_MAX + 6;
+	as_key* keys = cf_malloc(sizeof(as_key) * n_keys);
+	as_record** recs = cf_calloc(n_keys, sizeof(as_record*));
+	as_status* statuses = cf_malloc(sizeof(as_status) * n_keys);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_init_int64(&keys[i], NAMESPACE, SET, 9000 + i);
+
+		// Every fifth key does not exist.
+		if (i % 5 == 4) {
+			aerospike_key_remove(as, &err, NULL, &keys[i]);
+			continue;
+		}
+
+		as_record rec;
+		as_record_inita(&rec, 1);
+		as_record_set_int64(&rec, "a", i);
+		as_status rc = aerospike_key_put(as, &err, NULL, &keys[i], &rec);
+		as_record_destroy(&rec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+	}
+
+	as_status rc = aerospike_key_get_many(as, &err, NULL, keys, n_keys, recs, statuses);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		if (i % 5 == 4) {
+			assert_int_eq(statuses[i], AEROSPIKE_ERR_RECORD_NOT_FOUND);
+			assert_null(recs[i]);
+			continue;
+		}
+
+		assert_int_eq(statuses[i], AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(recs[i], "a", -1), i);
+		as_record_destroy(recs[i]);
+	}
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		aerospike_key_remove(as, &err, NULL, &keys[i]);
+		as_key_destroy(&keys[i]);
+	}
+	cf_free(statuses);
+	cf_free(recs);
+	cf_free(keys);
+}
+
+TEST(key_basics_put_many, "put multiple keys pipelined on one connection per node")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	// Window smaller than the keys per node, so the window is refilled many times.
+	uint32_t n_keys = 300;
+	as_key* keys = cf_malloc(sizeof(as_key) * n_keys);
+	as_record* recs = cf_malloc(sizeof(as_record) * n_keys);
+	as_record** ptrs = cf_malloc(sizeof(as_record*) * n_keys);
+	as_status* statuses = cf_malloc(sizeof(as_status) * n_keys);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_init_int64(&keys[i], NAMESPACE, SET, 9500 + i);
+		as_record_init(&recs[i], 2);
+		as_record_set_int64(&recs[i], "a", i);
+		as_record_set_str(&recs[i], "b", "pipe");
+		ptrs[i] = &recs[i];
+	}
+
+	as_status rc = aerospike_key_put_many(as, &err, NULL, keys, n_keys, ptrs, 8, statuses);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		assert_int_eq(statuses[i], AEROSPIKE_OK);
+
+		as_record* rec = NULL;
+		rc = aerospike_key_get(as, &err, NULL, &keys[i], &rec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(rec, "a", -1), i);
+		assert_string_eq(as_record_get_str(rec, "b"), "pipe");
+		as_record_destroy(rec);
+	}
+
+	// Create only policy fails every key, but every response is still read in order.
+	as_policy_write policy;
+	as_policy_write_init(&policy);
+	policy.exists = AS_POLICY_EXISTS_CREATE;
+
+	rc = aerospike_key_put_many(as, &err, &policy, keys, n_keys, ptrs, 0, statuses);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_EXISTS);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		assert_int_eq(statuses[i], AEROSPIKE_ERR_RECORD_EXISTS);
+		aerospike_key_remove(as, &err, NULL, &keys[i]);
+		as_record_destroy(&recs[i]);
+		as_key_destroy(&keys[i]);
+	}
+	cf_free(statuses);
+	cf_free(ptrs);
+	cf_free(recs);
+	cf_free(keys);
+}
+
+typedef struct {
+	const uint8_t* expected;
+	uint32_t offset;
+	uint32_t calls;
+	bool ok;
+} stream_check;
+
+static bool
+stream_listener(const uint8_t* chunk, uint32_t size, void* udata)
+{
+	stream_check* sc = udata;
+
+	if (memcmp(chunk, sc->expected + sc->offset, size) != 0) {
+		sc->ok = false;
+	}
+	sc->offset += size;
+	sc->calls++;
+	return true;
+}
+
+TEST(key_basics_get_stream, "stream large blob bin into caller buffer")
+{
+	uint32_t blob_size = 1024 * 1024;
+	uint8_t* blob = cf_malloc(blob_size);
+
+	for (uint32_t i = 0; i < blob_size; i++) {
+		blob[i] = (uint8_t)(i * 31 + 7);
+	}
+
+	as_key key;
+	as_key_init_str(&key, NAMESPACE, SET, "stream1");
+
+	as_record rec;
+	as_record_inita(&rec, 2);
+	as_record_set_raw(&rec, "blob", blob, blob_size);
+	as_record_set_int64(&rec, "a", 1);
+
+	as_error err;
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	uint8_t* buf = cf_malloc(blob_size);
+	as_stream_bin stream = {.buf = buf, .capacity = blob_size};
+
+	rc = aerospike_key_get_stream(as, &err, NULL, &key, "blob", &stream);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_true(stream.found);
+	assert_int_eq(stream.size, blob_size);
+	assert_int_eq(stream.type, AS_BYTES_BLOB);
+	assert_true(memcmp(buf, blob, blob_size) == 0);
+
+	// Value does not fit.
+	stream.capacity = blob_size - 1;
+	rc = aerospike_key_get_stream(as, &err, NULL, &key, "blob", &stream);
+	assert_int_eq(rc, AEROSPIKE_ERR_CLIENT);
+	cf_free(buf);
+
+	stream_check sc = {.expected = blob, .ok = true};
+	as_stream_bin stream2 = {.listener = stream_listener, .udata = &sc};
+
+	rc = aerospike_key_get_stream(as, &err, NULL, &key, "blob", &stream2);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_true(sc.ok);
+	assert_int_eq(sc.offset, blob_size);
+	assert_true(sc.calls > 1);
+
+	rc = aerospike_key_get_stream(as, &err, NULL, &key, "missing", &stream2);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_false(stream2.found);
+
+	aerospike_key_remove(as, &err, NULL, &key);
+
+	rc = aerospike_key_get_stream(as, &err, NULL, &key, "blob", &stream2);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	cf_free(blob);
+}
+
+TEST(key_basics_get_session, "get with reusable read context")
+{
+	as_error err;
+	as_error_init(&err);
+
+	as_key key1;
+	as_key_init_str(&key1, NAMESPACE, SET, "session1");
+	as_key key2;
+	as_key_init_str(&key2, NAMESPACE, SET, "session2");
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 2);
+	as_status rc = aerospike_key_put(as, &err, NULL, &key1, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	aerospike_key_remove(as, &err, NULL, &key2);
+	as_error_reset(&err);
+
+	as_session_ctx ctx;
+	as_session_ctx_init(as, &ctx, NULL);
+
+	// Second read of the same key reuses the partition.
+	for (uint32_t i = 0; i < 2; i++) {
+		as_record* r = NULL;
+		rc = aerospike_key_get_session(as, &err, &ctx, &key1, &r);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(r, "a", -1), 2);
+		as_record_destroy(r);
+	}
+
+	as_record* r = NULL;
+	rc = aerospike_key_get_session(as, &err, &ctx, &key2, &r);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_int_eq(err.code, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+
+	// Error from the previous call is reset.
+	rc = aerospike_key_get_session(as, &err, &ctx, &key1, &r);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_int_eq(err.code, AEROSPIKE_OK);
+	as_record_destroy(r);
+	as_session_ctx_destroy(&ctx);
+
+	// Filter expression is serialized at init.
+	as_exp_build(filter, as_exp_cmp_eq(as_exp_bin_int("a"), as_exp_int(1)));
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.base.filter_exp = filter;
+	as_session_ctx_init(as, &ctx, &policy);
+	as_exp_destroy(filter);
+
+	r = NULL;
+	rc = aerospike_key_get_session(as, &err, &ctx, &key1, &r);
+	assert_int_eq(rc, AEROSPIKE_FILTERED_OUT);
+	as_session_ctx_destroy(&ctx);
+
+	aerospike_key_remove(as, &err, NULL, &key1);
+}
+
+TEST(key_basics_lowest_latency, "get and put with lowest latency replica policy")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "lowlat");
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 456);
+
+	as_policy_write wpol;
+	as_policy_write_init(&wpol);
+	wpol.replica = AS_POLICY_REPLICA_LOWEST_LATENCY;
+
+	as_status rc = aerospike_key_put(as, &err, &wpol, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.replica = AS_POLICY_REPLICA_LOWEST_LATENCY;
+
+	// Enough reads to measure both replicas and explore the slower one.
+	for (int i = 0; i < 100; i++) {
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(prec, "a", 0), 456);
+		as_record_destroy(prec);
+	}
+
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_lazy_error, "not found error message is formatted on demand")
+{
+	as_error err;
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foozoo");
+
+	as->cluster->lazy_error_messages = true;
+
+	as_record* rec = NULL;
+	as_status rc = aerospike_key_get(as, &err, NULL, &key, &rec);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_true(err.lazy);
+	assert_int_eq(err.message[0], 0);
+	assert_not_null(strstr(as_error_message(&err), "AEROSPIKE_ERR_RECORD_NOT_FOUND"));
+	assert_false(err.lazy);
+
+	rc = aerospike_key_exists(as, &err, NULL, &key, &rec);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_true(err.lazy);
+	assert_string_eq(as_error_message(&err), "AEROSPIKE_ERR_RECORD_NOT_FOUND");
+
+	as->cluster->lazy_error_messages = false;
+
+	rc = aerospike_key_get(as, &err, NULL, &key, &rec);
+	assert_int_eq(rc, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_false(err.lazy);
+	assert_not_null(strstr(err.message, "AEROSPIKE_ERR_RECORD_NOT_FOUND"));
+
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_lazy, "get with lazy list/map deserialization")
+{
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "lazy");
+
+	as_arraylist list;
+	as_arraylist_init(&list, 3, 0);
+	as_arraylist_append_int64(&list, 1);
+	as_arraylist_append_int64(&list, 2);
+	as_arraylist_append_int64(&list, 3);
+
+	as_hashmap map;
+	as_hashmap_init(&map, 1);
+	as_stringmap_set_int64((as_map*)&map, "x", 7);
+
+	as_record rec;
+	as_record_init(&rec, 3);
+	as_record_set_int64(&rec, "i", 5);
+	as_record_set_list(&rec, "l", (as_list*)&list);
+	as_record_set_map(&rec, "m", (as_map*)&map);
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.lazy_deserialize = true;
+
+	for (int i = 0; i < 2; i++) {
+		// Second read references the response buffer.
+		policy.zero_copy = i == 1;
+
+		as_record* prec = NULL;
+		rc = aerospike_key_get(as, &err, &policy, &key, &prec);
+		assert_int_eq(rc, AEROSPIKE_OK);
+		assert_true(prec->lazy);
+
+		// Lists and maps stay raw until they are read.
+		for (uint16_t j = 0; j < prec->bins.size; j++) {
+			as_bin* bin = &prec->bins.entries[j];
+
+			if (strcmp(bin->name, "i") != 0) {
+				assert_int_eq(as_val_type((as_val*)bin->valuep), AS_BYTES);
+			}
+		}
+
+		assert_int_eq(as_record_get_int64(prec, "i", 0), 5);
+
+		as_list* l = as_record_get_list(prec, "l");
+		assert_not_null(l);
+		assert_int_eq(as_list_size(l), 3);
+		assert_int_eq(as_list_get_int64(l, 2), 3);
+
+		as_record_iterator it;
+		as_record_iterator_init(&it, prec);
+
+		while (as_record_iterator_has_next(&it)) {
+			as_bin* bin = as_record_iterator_next(&it);
+
+			if (strcmp(bin->name, "m") == 0) {
+				as_map* m = as_map_fromval((as_val*)as_bin_get_value(bin));
+				assert_not_null(m);
+				assert_int_eq(as_stringmap_get_int64(m, "x"), 7);
+			}
+		}
+		as_record_iterator_destroy(&it);
+		as_record_destroy(prec);
+	}
+	as_key_destroy(&key);
+}
+
+TEST(key_basics_partition_route, "partition routes match command node selection")
+{
+	as_error err;
+	as_digest_value digests[8];
+
+	for (uint32_t i = 0; i < 8; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+		as_key_digest(&key);
+		memcpy(digests[i], key.digest.value, AS_DIGEST_VALUE_SIZE);
+		as_key_destroy(&key);
+	}
+
+	as_partition_route routes[8];
+	uint32_t gen;
+	as_status status = aerospike_partition_routes(as, &err, NAMESPACE, digests, 8, routes, &gen);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < 8; i++) {
+		assert_int_eq(routes[i].partition_id, as_partition_getid(digests[i],
+			as->cluster->n_partitions));
+		assert_not_null(routes[i].master);
+		assert_true(routes[i].master != routes[i].replica);
+	}
+	as_partition_routes_release(routes, 8);
+
+	// Map does not change without cluster changes.
+	assert_int_eq(aerospike_partition_generation(as), gen);
+
+	as_partition_route route;
+	status = aerospike_partition_route(as, &err, "no_such_ns", digests[0], &route, NULL);
+	assert_int_eq(status, AEROSPIKE_ERR_CLIENT);
+}
+
+TEST(key_basics_multiplex, "sync key commands multiplexed on event loop")
+{
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "mux");
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_int64(&r, "a", 1);
+
+	as_policy_write wp;
+	as_policy_write_init(&wp);
+	wp.multiplex = true;
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, &wp, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_policy_read rp;
+	as_policy_read_init(&rp);
+	rp.multiplex = true;
+
+	as_record* rec = NULL;
+	status = aerospike_key_get(as, &err, &rp, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(rec, "a", 0), 1);
+	as_record_destroy(rec);
+
+	status = aerospike_key_exists(as, &err, &rp, &key, NULL);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+	as_operations_add_incr(&ops, "a", 1);
+	as_operations_add_read(&ops, "a");
+
+	as_policy_operate op;
+	as_policy_operate_init(&op);
+	op.multiplex = true;
+
+	rec = NULL;
+	status = aerospike_key_operate(as, &err, &op, &key, &ops, &rec);
+	as_operations_destroy(&ops);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(rec, "a", 0), 2);
+	as_record_destroy(rec);
+
+	as_policy_remove mp;
+	as_policy_remove_init(&mp);
+	mp.multiplex = true;
+
+	status = aerospike_key_remove(as, &err, &mp, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	rec = NULL;
+	status = aerospike_key_get(as, &err, &rp, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_null(rec);
+}
+
+TEST(key_basics_arena, "list and map bins deserialized into record arena")
+{
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "arena");
+
+	as_hashmap map;
+	as_hashmap_init(&map, 100);
+
+	for (int64_t i = 0; i < 100; i++) {
+		char name[16];
+		sprintf(name, "k%d", (int)i);
+
+		as_arraylist* list = as_arraylist_new(3, 0);
+		as_arraylist_append_int64(list, i);
+		as_arraylist_append_str(list, name);
+		as_arraylist_append_double(list, i + 0.5);
+		as_stringmap_set((as_map*)&map, name, (as_val*)list);
+	}
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_map(&r, "m", (as_map*)&map);
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.arena_deserialize = true;
+
+	as_record* rec = NULL;
+	status = aerospike_key_get(as, &err, &policy, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_not_null(rec->arena);
+
+	as_map* m = as_record_get_map(rec, "m");
+	assert_not_null(m);
+	assert_int_eq(as_map_size(m), 100);
+
+	for (int64_t i = 0; i < 100; i++) {
+		char name[16];
+		sprintf(name, "k%d", (int)i);
+
+		as_list* list = as_list_fromval(as_stringmap_get(m, name));
+		assert_not_null(list);
+		assert_int_eq(as_list_get_int64(list, 0), i);
+		assert_string_eq(as_list_get_str(list, 1), name);
+		assert_double_eq(as_list_get_double(list, 2), i + 0.5);
+	}
+	as_record_destroy(rec);
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+}
+
+TEST(key_basics_array, "list bins copied into typed arrays")
+{
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "array");
+
+	// Mix encodings so both bulk and single element paths are used.
+	int64_t ints[100];
+
+	for (int64_t i = 0; i < 100; i++) {
+		ints[i] = (i < 40) ? i : (i % 3 == 0) ? -i * 1000 : i << 40;
+	}
+
+	as_arraylist ilist;
+	as_arraylist_init(&ilist, 100, 0);
+
+	as_arraylist dlist;
+	as_arraylist_init(&dlist, 20, 0);
+
+	as_arraylist slist;
+	as_arraylist_init(&slist, 20, 0);
+
+	for (uint32_t i = 0; i < 100; i++) {
+		as_arraylist_append_int64(&ilist, ints[i]);
+	}
+
+	for (uint32_t i = 0; i < 20; i++) {
+		char name[16];
+		sprintf(name, "s%u", i);
+		as_arraylist_append_double(&dlist, i * 0.25);
+		as_arraylist_append_str(&slist, name);
+	}
+
+	as_record r;
+	as_record_inita(&r, 3);
+	as_record_set_list(&r, "i", (as_list*)&ilist);
+	as_record_set_list(&r, "d", (as_list*)&dlist);
+	as_record_set_list(&r, "s", (as_list*)&slist);
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+
+	// Decode raw bytes first, then deserialized lists.
+	for (uint32_t n = 0; n < 2; n++) {
+		policy.lazy_deserialize = (n == 0);
+
+		as_record* rec = NULL;
+		status = aerospike_key_get(as, &err, &policy, &key, &rec);
+		assert_int_eq(status, AEROSPIKE_OK);
+
+		int64_t iv[100];
+		uint32_t size;
+		assert_false(as_record_get_int64_array(rec, "i", iv, 10, &size));
+		assert_int_eq(size, 100);
+		assert_true(as_record_get_int64_array(rec, "i", iv, 100, &size));
+		assert_int_eq(size, 100);
+
+		for (uint32_t i = 0; i < 100; i++) {
+			assert_int_eq(iv[i], ints[i]);
+		}
+
+		double dv[20];
+		assert_true(as_record_get_double_array(rec, "d", dv, 20, &size));
+		assert_int_eq(size, 20);
+
+		for (uint32_t i = 0; i < 20; i++) {
+			assert_double_eq(dv[i], i * 0.25);
+		}
+
+		as_bytes_view sv[20];
+		assert_true(as_record_get_bytes_array(rec, "s", sv, 20, &size));
+		assert_int_eq(size, 20);
+
+		for (uint32_t i = 0; i < 20; i++) {
+			char name[16];
+			sprintf(name, "s%u", i);
+			assert_int_eq(sv[i].type, AS_BYTES_STRING);
+			assert_int_eq(sv[i].size, strlen(name));
+			assert_true(memcmp(sv[i].value, name, sv[i].size) == 0);
+		}
+
+		// Element type mismatch.
+		assert_false(as_record_get_int64_array(rec, "d", iv, 100, &size));
+		assert_false(as_record_get_int64_array(rec, "x", iv, 100, &size));
+		as_record_destroy(rec);
+	}
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+}
+
+TEST(key_basics_capture, "sampled commands written to capture file")
+{
+	char path[] = "/tmp/key_basics_capture_XXXXXX";
+	int fd = mkstemp(path);
+	assert_true(fd >= 0);
+	close(fd);
+
+	as_error err;
+	as_status status = aerospike_capture_start(as, &err, path, 1);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	status = aerospike_capture_start(as, &err, path, 1);
+	assert_int_eq(status, AEROSPIKE_ERR_CLIENT);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "capture");
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_int64(&r, "a", 123);
+	status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	const char* bins[] = {"a", NULL};
+	as_record* rec = NULL;
+	status = aerospike_key_select(as, &err, NULL, &key, bins, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(rec);
+
+	rec = NULL;
+	status = aerospike_key_exists(as, &err, NULL, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(rec);
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	aerospike_capture_stop(as);
+
+	// Commands after stop are not captured.
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+
+	FILE* fp = fopen(path, "rb");
+	assert_not_null(fp);
+
+	as_capture_header header;
+	assert_int_eq(fread(&header, sizeof(header), 1, fp), 1);
+	assert_true(memcmp(header.magic, AS_CAPTURE_MAGIC, sizeof(header.magic)) == 0);
+	assert_int_eq(header.sample_rate, 1);
+
+	uint8_t types[] = {AS_CAPTURE_WRITE, AS_CAPTURE_READ, AS_CAPTURE_EXISTS, AS_CAPTURE_DELETE};
+	uint64_t last_us = 0;
+
+	for (uint32_t i = 0; i < sizeof(types); i++) {
+		as_capture_entry e;
+		assert_int_eq(fread(&e.rec, sizeof(e.rec), 1, fp), 1);
+		assert_int_eq(e.rec.type, types[i]);
+		assert_true(e.rec.flags & AS_CAPTURE_FLAGS_DIGEST);
+		assert_true(memcmp(e.rec.digest, as_key_digest(&key)->value, AS_DIGEST_VALUE_SIZE) == 0);
+		assert_true(e.rec.issue_us >= last_us);
+		assert_true(e.rec.bytes_out > 0);
+		last_us = e.rec.issue_us;
+
+		assert_int_eq(e.rec.ns_len, strlen(NAMESPACE));
+		assert_int_eq(e.rec.set_len, strlen(SET));
+		assert_int_eq(fread(e.ns, e.rec.ns_len + e.rec.set_len, 1, fp), 1);
+		assert_true(memcmp(e.ns, NAMESPACE SET, e.rec.ns_len + e.rec.set_len) == 0);
+
+		if (e.rec.n_shapes) {
+			assert_int_eq(fread(e.ops, sizeof(as_capture_op), e.rec.n_shapes, fp),
+				e.rec.n_shapes);
+		}
+
+		if (types[i] == AS_CAPTURE_WRITE || types[i] == AS_CAPTURE_READ) {
+			assert_int_eq(e.rec.n_shapes, 1);
+			assert_int_eq(e.ops[0].name_len, 1);
+			assert_int_eq(e.ops[0].name[0], 'a');
+		}
+
+		if (types[i] == AS_CAPTURE_WRITE) {
+			assert_int_eq(e.ops[0].op, 2);
+			assert_int_eq(e.ops[0].value_size, 8);
+		}
+	}
+
+	// No records after stop.
+	as_capture_record extra;
+	assert_int_eq(fread(&extra, sizeof(extra), 1, fp), 0);
+	fclose(fp);
+	remove(path);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -802,6 +1752,7 @@ SUITE(key_basics, "aerospike_key basic tests") {
     suite_add(key_basics_remove);
 	suite_add(key_basics_put);
 	suite_add(key_basics_exists);
+	suite_add(key_basics_exists_namespace_id);
 	suite_add(key_basics_notexists);
 	suite_add(key_basics_remove_generation);
 	suite_add(key_basics_put_generation);
@@ -819,6 +1770,22 @@ SUITE(key_basics, "aerospike_key basic tests") {
 	suite_add(key_basics_list_map_double);
 	suite_add(key_basics_storekey);
 	suite_add(key_basics_bool);
+	suite_add(key_basics_zero_copy);
+	suite_add(key_basics_gather);
+	suite_add(key_basics_digests);
+	suite_add(key_basics_hedge);
+	suite_add(key_basics_get_many);
+	suite_add(key_basics_put_many);
+	suite_add(key_basics_get_session);
+	suite_add(key_basics_get_stream);
+	suite_add(key_basics_lowest_latency);
+	suite_add(key_basics_lazy);
+	suite_add(key_basics_lazy_error);
+	suite_add(key_basics_partition_route);
+	suite_add(key_basics_multiplex);
+	suite_add(key_basics_arena);
+	suite_add(key_basics_array);
+	suite_add(key_basics_capture);
 
 	if (g_enterprise_server) {
 		suite_add(key_basics_compression);
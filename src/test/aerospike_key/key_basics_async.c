@@ -17,7 +17,10 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/as_arraylist.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_buffer.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_completion_queue.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_integer.h>
@@ -450,6 +453,227 @@ TEST(key_basics_async_operate_heap, "async operate with record on heap")
 	as_monitor_wait(&monitor);
 }
 
+#define AUTO_BATCH_READS 10
+
+static void
+as_get_callback_auto_batch(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	counter_data* cdata = udata;
+	assert_success_async(&monitor, err, cdata->result);
+
+	assert_int_eq_async(&monitor, as_record_get_int64(rec, "a", 0), 246);
+
+	cdata->counter++;
+	if (cdata->counter == AUTO_BATCH_READS + 1) {
+		as_monitor_notify(&monitor);
+	}
+}
+
+static void
+as_get_callback_auto_batch_missing(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	counter_data* cdata = udata;
+	atf_test_result* __result__ = cdata->result;
+	assert_async(&monitor, err && err->code == AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_async(&monitor, !rec);
+
+	cdata->counter++;
+	if (cdata->counter == AUTO_BATCH_READS + 1) {
+		as_monitor_notify(&monitor);
+	}
+}
+
+static void
+as_put_callback_auto_batch(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	counter_data* cdata = udata;
+	assert_success_async(&monitor, err, cdata->result);
+
+	as_policy_read p;
+	as_policy_read_init(&p);
+	p.auto_batch = true;
+
+	// Reads issued from the event loop thread in one callback are merged into one batch.
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "paab1");
+
+	as_error e;
+	as_status status;
+
+	for (uint32_t i = 0; i < AUTO_BATCH_READS; i++) {
+		status = aerospike_key_get_async(as, &e, &p, &key, as_get_callback_auto_batch, udata,
+			event_loop, NULL);
+		assert_status_async(&monitor, status, &e);
+	}
+
+	as_key_init(&key, NAMESPACE, SET, "paabnotfound");
+
+	status = aerospike_key_get_async(as, &e, &p, &key, as_get_callback_auto_batch_missing, udata,
+		event_loop, NULL);
+	assert_status_async(&monitor, status, &e);
+}
+
+TEST(key_basics_async_auto_batch, "async get merged into batch")
+{
+	as_monitor_begin(&monitor);
+
+	// udata can exist on stack only because this function doesn't exit until the test is completed.
+	counter_data udata;
+	udata.result = __result__;
+	udata.counter = 0;
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "paab1");
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 246);
+
+	as_error err;
+	as_status status = aerospike_key_put_async(as, &err, NULL, &key, &rec, as_put_callback_auto_batch, &udata, 0, NULL);
+	as_key_destroy(&key);
+	as_record_destroy(&rec);
+
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_monitor_wait(&monitor);
+}
+
+#define CQ_KEYS 100
+
+static uint32_t
+cq_collect(as_completion_queue* cq, as_completion* completions, uint32_t n)
+{
+	uint32_t count = 0;
+
+	while (count < n) {
+		uint32_t rv = as_completion_queue_wait(cq, completions + count, n - count, 16, 5000);
+
+		if (rv == 0) {
+			break;
+		}
+		count += rv;
+	}
+	return count;
+}
+
+TEST(key_basics_async_completion_queue, "async commands posted to completion queue")
+{
+	// Small ring, so some completions go to the overflow list.
+	as_completion_queue* cq = as_completion_queue_create(16);
+	as_completion_tag tags[CQ_KEYS];
+	as_completion completions[CQ_KEYS];
+
+	for (uint32_t i = 0; i < CQ_KEYS; i++) {
+		tags[i].queue = cq;
+		tags[i].udata = (void*)(uintptr_t)i;
+
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, 5000 + i);
+
+		as_record rec;
+		as_record_inita(&rec, 1);
+		as_record_set_int64(&rec, "a", i);
+
+		as_error err;
+		as_status status = aerospike_key_put_async(as, &err, NULL, &key, &rec,
+			as_completion_queue_write_listener, &tags[i], NULL, NULL);
+		as_record_destroy(&rec);
+		assert_int_eq(status, AEROSPIKE_OK);
+	}
+
+	uint32_t n = cq_collect(cq, completions, CQ_KEYS);
+	assert_int_eq(n, CQ_KEYS);
+
+	for (uint32_t i = 0; i < n; i++) {
+		assert_int_eq(completions[i].status, AEROSPIKE_OK);
+		assert_null(completions[i].result);
+	}
+
+	as_policy_read p;
+	as_policy_read_init(&p);
+	p.async_heap_rec = true;
+
+	for (uint32_t i = 0; i < CQ_KEYS; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, 5000 + i);
+
+		as_error err;
+		as_status status = aerospike_key_get_async(as, &err, &p, &key,
+			as_completion_queue_record_listener, &tags[i], NULL, NULL);
+		assert_int_eq(status, AEROSPIKE_OK);
+	}
+
+	n = cq_collect(cq, completions, CQ_KEYS);
+	assert_int_eq(n, CQ_KEYS);
+
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t id = (uint32_t)(uintptr_t)completions[i].udata;
+		as_record* rec = completions[i].result;
+
+		assert_int_eq(completions[i].status, AEROSPIKE_OK);
+		assert_not_null(rec);
+		assert_int_eq(as_record_get_int64(rec, "a", -1), id);
+		as_record_destroy(rec);
+	}
+
+	assert_int_eq(as_completion_queue_poll(cq, completions, CQ_KEYS), 0);
+	as_completion_queue_destroy(cq);
+}
+
+static void
+node_bytes_add(int64_t bytes)
+{
+	as_nodes* nodes = as_nodes_reserve(as->cluster);
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_add_uint64(&nodes->array[i]->async_bytes, bytes);
+	}
+	as_nodes_release(nodes);
+}
+
+TEST(key_basics_async_overload, "async command rejected by node bytes in flight limit")
+{
+	as_completion_queue* cq = as_completion_queue_create(16);
+	as_completion_tag tag = {.queue = cq, .udata = NULL};
+	as_completion completion;
+
+	// Pretend other commands are in flight to every node.
+	uint32_t max_bytes = as->cluster->async_max_bytes_per_node;
+	as->cluster->async_max_bytes_per_node = 1;
+	node_bytes_add(1);
+
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 6000);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_int64(&rec, "a", 1);
+
+	as_error err;
+	as_status status = aerospike_key_put_async(as, &err, NULL, &key, &rec,
+		as_completion_queue_write_listener, &tag, NULL, NULL);
+
+	uint32_t n = (status == AEROSPIKE_OK) ? cq_collect(cq, &completion, 1) : 0;
+
+	node_bytes_add(-1);
+	as->cluster->async_max_bytes_per_node = max_bytes;
+
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(n, 1);
+	assert_int_eq(completion.status, AEROSPIKE_ERR_ASYNC_OVERLOAD);
+
+	// Same command is admitted without the limit.
+	status = aerospike_key_put_async(as, &err, NULL, &key, &rec,
+		as_completion_queue_write_listener, &tag, NULL, NULL);
+	as_record_destroy(&rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	n = cq_collect(cq, &completion, 1);
+	assert_int_eq(n, 1);
+	assert_int_eq(completion.status, AEROSPIKE_OK);
+	as_completion_queue_destroy(cq);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -466,4 +690,7 @@ SUITE(key_basics_async, "aerospike_key basic tests")
 	suite_add(key_basics_async_remove);
 	suite_add(key_basics_async_operate);
 	suite_add(key_basics_async_operate_heap);
+	suite_add(key_basics_async_auto_batch);
+	suite_add(key_basics_async_completion_queue);
+	suite_add(key_basics_async_overload);
 }
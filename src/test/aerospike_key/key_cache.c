@@ -0,0 +1,438 @@
+/*
+ * Copyright 2008-2022 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_negative_cache.h>
+#include <aerospike/as_read_coalesce.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_record_cache.h>
+#include <citrusleaf/alloc.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * GLOBAL VARS
+ *****************************************************************************/
+
+extern aerospike* as;
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define NAMESPACE "test"
+#define SET "test_cache"
+#define COALESCE_THREADS 8
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+cache_digest(uint32_t i, uint8_t* digest)
+{
+	// Low byte selects the shard. Remaining bytes are spread like real digests.
+	uint32_t x = i * 2654435761u + 1;
+
+	digest[0] = (uint8_t)i;
+	digest[1] = (uint8_t)(i >> 8);
+
+	for (uint32_t j = 2; j < AS_DIGEST_VALUE_SIZE; j++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		digest[j] = (uint8_t)(x >> 24);
+	}
+}
+
+typedef struct {
+	uint32_t calls;
+	uint32_t size;
+	as_status status;
+} flight_result;
+
+static void
+flight_listener(as_error* err, as_status status, uint8_t* buf, uint32_t size, void* udata)
+{
+	flight_result* fr = udata;
+	fr->calls++;
+	fr->status = status;
+	fr->size = buf ? size : 0;
+	cf_free(buf);
+}
+
+static void*
+coalesce_get(void* udata)
+{
+	as_key key;
+	as_key_init_str(&key, NAMESPACE, SET, "coalesce1");
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.coalesce = true;
+
+	uintptr_t failed = 0;
+
+	for (uint32_t i = 0; i < 100; i++) {
+		as_error err;
+		as_record* rec = NULL;
+		as_status status = aerospike_key_get(as, &err, &policy, &key, &rec);
+
+		if (status != AEROSPIKE_OK || as_record_get_int64(rec, "a", 0) != 7) {
+			failed++;
+		}
+
+		if (rec) {
+			as_record_destroy(rec);
+		}
+	}
+	return (void*)failed;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(key_cache_lru, "record cache evicts least recently used records")
+{
+	// One record per shard.
+	as_record_cache* cache = as_record_cache_create(AS_RECORD_CACHE_SHARDS, 60000);
+	uint8_t data[] = {1, 2, 3, 4};
+	uint8_t d1[AS_DIGEST_VALUE_SIZE];
+	uint8_t d2[AS_DIGEST_VALUE_SIZE];
+
+	// Both digests map to the same shard.
+	cache_digest(0, d1);
+	cache_digest(AS_RECORD_CACHE_SHARDS, d2);
+
+	as_record_cache_put(cache, NAMESPACE, d1, data, sizeof(data), 7,
+		as_record_cache_version(cache, d1));
+
+	uint8_t* buf;
+	uint32_t size;
+	uint32_t gen;
+	assert_true(as_record_cache_get(cache, NAMESPACE, d1, &buf, &size, &gen));
+	assert_int_eq(size, sizeof(data));
+	assert_int_eq(gen, 7);
+	assert_true(memcmp(buf, data, size) == 0);
+	cf_free(buf);
+
+	// Same digest in another namespace is a different record.
+	assert_false(as_record_cache_get(cache, "other", d1, &buf, &size, &gen));
+
+	as_record_cache_put(cache, NAMESPACE, d2, data, sizeof(data), 1,
+		as_record_cache_version(cache, d2));
+	assert_int_eq(as_record_cache_size(cache), 1);
+	assert_false(as_record_cache_get(cache, NAMESPACE, d1, &buf, &size, &gen));
+	assert_true(as_record_cache_get(cache, NAMESPACE, d2, &buf, &size, &gen));
+	cf_free(buf);
+
+	as_record_cache_destroy(cache);
+}
+
+TEST(key_cache_version, "record cache drops reads that raced with writes")
+{
+	as_record_cache* cache = as_record_cache_create(1000, 60000);
+	uint8_t data[] = {1, 2, 3, 4};
+	uint8_t digest[AS_DIGEST_VALUE_SIZE];
+	cache_digest(5, digest);
+
+	// Read is sent, then a local write removes the record before the response arrives.
+	uint64_t version = as_record_cache_version(cache, digest);
+	as_record_cache_remove(cache, NAMESPACE, digest);
+	as_record_cache_put(cache, NAMESPACE, digest, data, sizeof(data), 1, version);
+
+	uint8_t* buf;
+	uint32_t size;
+	uint32_t gen;
+	assert_false(as_record_cache_get(cache, NAMESPACE, digest, &buf, &size, &gen));
+
+	as_record_cache_put(cache, NAMESPACE, digest, data, sizeof(data), 2,
+		as_record_cache_version(cache, digest));
+	assert_true(as_record_cache_get(cache, NAMESPACE, digest, &buf, &size, &gen));
+	assert_int_eq(gen, 2);
+	cf_free(buf);
+
+	as_record_cache_remove(cache, NAMESPACE, digest);
+	assert_int_eq(as_record_cache_size(cache), 0);
+	as_record_cache_destroy(cache);
+}
+
+TEST(key_cache_get, "cached get, select and write invalidation")
+{
+	if (! as->cluster->record_cache) {
+		info("record cache disabled");
+		return;
+	}
+
+	as_key key;
+	as_key_init_str(&key, NAMESPACE, SET, "cache1");
+
+	as_record r;
+	as_record_inita(&r, 2);
+	as_record_set_int64(&r, "a", 1);
+	as_record_set_str(&r, "b", "one");
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.cache = AS_POLICY_CACHE_VALIDATE;
+
+	// First read populates the cache and second read is served from it.
+	for (uint32_t i = 0; i < 2; i++) {
+		as_record* rec = NULL;
+		status = aerospike_key_get(as, &err, &policy, &key, &rec);
+		assert_int_eq(status, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(rec, "a", 0), 1);
+		assert_int_eq(as_record_numbins(rec), 2);
+		as_record_destroy(rec);
+	}
+
+	const char* bins[] = {"b", NULL};
+	as_record* rec = NULL;
+	status = aerospike_key_select(as, &err, &policy, &key, bins, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_numbins(rec), 1);
+	assert_string_eq(as_record_get_str(rec, "b"), "one");
+	as_record_destroy(rec);
+
+	// Local write must be visible on the next cached read.
+	as_record_inita(&r, 1);
+	as_record_set_int64(&r, "a", 2);
+	status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	policy.cache = AS_POLICY_CACHE_TTL;
+	rec = NULL;
+	status = aerospike_key_get(as, &err, &policy, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_record_get_int64(rec, "a", 0), 2);
+	as_record_destroy(rec);
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	rec = NULL;
+	status = aerospike_key_get(as, &err, &policy, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+}
+
+TEST(key_cache_negative_filter, "negative cache remembers and forgets misses")
+{
+	as_negative_cache* cache = as_negative_cache_create(1000, 60000, 0.001);
+	uint8_t digest[AS_DIGEST_VALUE_SIZE];
+	uint32_t fp = 0;
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		cache_digest(i, digest);
+		as_negative_cache_add(cache, NAMESPACE, digest,
+			as_negative_cache_version(cache, NAMESPACE, digest));
+	}
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		cache_digest(i, digest);
+		assert_true(as_negative_cache_contains(cache, NAMESPACE, digest));
+	}
+
+	for (uint32_t i = 1000; i < 11000; i++) {
+		cache_digest(i, digest);
+
+		if (as_negative_cache_contains(cache, NAMESPACE, digest)) {
+			fp++;
+		}
+	}
+	info("false positives: %u of 10000", fp);
+	assert_true(fp < 50);
+
+	// Removed keys are never reported, even when a miss raced with the write.
+	cache_digest(3, digest);
+	uint64_t version = as_negative_cache_version(cache, NAMESPACE, digest);
+	as_negative_cache_remove(cache, NAMESPACE, digest);
+	assert_false(as_negative_cache_contains(cache, NAMESPACE, digest));
+	as_negative_cache_add(cache, NAMESPACE, digest, version);
+	assert_false(as_negative_cache_contains(cache, NAMESPACE, digest));
+
+	as_negative_cache_destroy(cache);
+}
+
+TEST(key_cache_negative, "negative cache is invalidated by local writes")
+{
+	if (! as->cluster->negative_cache) {
+		info("negative cache disabled");
+		return;
+	}
+
+	as_key key;
+	as_key_init_str(&key, NAMESPACE, SET, "negative1");
+
+	as_error err;
+	aerospike_key_remove(as, &err, NULL, &key);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.negative_cache = true;
+
+	// Second miss is answered by the client.
+	for (uint32_t i = 0; i < 2; i++) {
+		as_record* rec = NULL;
+		as_status status = aerospike_key_exists(as, &err, &policy, &key, &rec);
+		assert_int_eq(status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+		assert_null(rec);
+	}
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_int64(&r, "a", 1);
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_record* rec = NULL;
+	status = aerospike_key_get(as, &err, &policy, &key, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(rec);
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+}
+
+TEST(key_cache_flight, "identical reads in flight share one response")
+{
+	as_read_coalesce* rc = as_read_coalesce_create();
+	uint8_t cmd1[] = {1, 2, 3, 4, 5};
+	uint8_t cmd2[] = {1, 2, 3, 4, 6};
+	uint8_t data[] = {9, 8, 7};
+	bool leader;
+
+	as_read_flight* f1 = as_read_coalesce_join(rc, cmd1, sizeof(cmd1), &leader);
+	assert_true(leader);
+
+	as_read_flight* f2 = as_read_coalesce_join(rc, cmd1, sizeof(cmd1), &leader);
+	assert_false(leader);
+	assert_true(f1 == f2);
+
+	// Different command bytes never join.
+	as_read_flight* f3 = as_read_coalesce_join(rc, cmd2, sizeof(cmd2), &leader);
+	assert_true(leader);
+	assert_int_eq(as_read_coalesce_size(rc), 2);
+
+	flight_result fr = {0};
+	as_read_flight_listen(f2, flight_listener, &fr);
+	assert_int_eq(fr.calls, 0);
+
+	as_error err;
+	as_error_init(&err);
+	as_read_flight_set_response(f1, data, sizeof(data));
+	as_read_flight_complete(f1, &err, AEROSPIKE_OK);
+	assert_int_eq(fr.calls, 1);
+	assert_int_eq(fr.size, sizeof(data));
+
+	// Reads that arrive after completion start a new flight.
+	as_read_flight* f4 = as_read_coalesce_join(rc, cmd1, sizeof(cmd1), &leader);
+	assert_true(leader);
+	as_error_set_message(&err, AEROSPIKE_ERR_TIMEOUT, "timeout");
+	as_read_flight_complete(f4, &err, AEROSPIKE_ERR_TIMEOUT);
+
+	// Errors without a response are passed to followers that were already waiting.
+	as_read_flight* f5 = as_read_coalesce_join(rc, cmd2, sizeof(cmd2), &leader);
+	assert_false(leader);
+	as_error_set_message(&err, AEROSPIKE_ERR_TIMEOUT, "timeout");
+	as_read_flight_complete(f3, &err, AEROSPIKE_ERR_TIMEOUT);
+
+	uint8_t* buf;
+	uint32_t size;
+	as_error_reset(&err);
+	assert_int_eq(as_read_flight_wait(f5, &err, 0, &buf, &size), AEROSPIKE_ERR_TIMEOUT);
+	assert_null(buf);
+	assert_int_eq(err.code, AEROSPIKE_ERR_TIMEOUT);
+
+	// A follower stops waiting at its own timeout while the leader is still in flight.
+	as_read_flight* f6 = as_read_coalesce_join(rc, cmd1, sizeof(cmd1), &leader);
+	assert_true(leader);
+	as_read_flight* f7 = as_read_coalesce_join(rc, cmd1, sizeof(cmd1), &leader);
+	assert_false(leader);
+
+	as_error_reset(&err);
+	assert_int_eq(as_read_flight_wait(f7, &err, 20, &buf, &size), AEROSPIKE_ERR_TIMEOUT);
+	assert_null(buf);
+	assert_int_eq(as_read_coalesce_size(rc), 1);
+
+	as_error_reset(&err);
+	as_read_flight_set_response(f6, data, sizeof(data));
+	as_read_flight_complete(f6, &err, AEROSPIKE_OK);
+
+	assert_int_eq(as_read_coalesce_size(rc), 0);
+	as_read_coalesce_destroy(rc);
+}
+
+TEST(key_cache_coalesce, "concurrent identical gets are coalesced")
+{
+	as_key key;
+	as_key_init_str(&key, NAMESPACE, SET, "coalesce1");
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_int64(&r, "a", 7);
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	pthread_t threads[COALESCE_THREADS];
+
+	for (uint32_t i = 0; i < COALESCE_THREADS; i++) {
+		pthread_create(&threads[i], NULL, coalesce_get, NULL);
+	}
+
+	uintptr_t failed = 0;
+
+	for (uint32_t i = 0; i < COALESCE_THREADS; i++) {
+		void* result;
+		pthread_join(threads[i], &result);
+		failed += (uintptr_t)result;
+	}
+	assert_int_eq(failed, 0);
+	assert_int_eq(as_read_coalesce_size(as->cluster->read_coalesce), 0);
+
+	status = aerospike_key_remove(as, &err, NULL, &key);
+	assert_int_eq(status, AEROSPIKE_OK);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(key_cache, "client-side record cache")
+{
+	suite_add(key_cache_lru);
+	suite_add(key_cache_version);
+	suite_add(key_cache_get);
+	suite_add(key_cache_negative_filter);
+	suite_add(key_cache_negative);
+	suite_add(key_cache_flight);
+	suite_add(key_cache_coalesce);
+}
@@ -342,6 +342,46 @@ TEST(key_operate_bool , "operate bool")
 	as_record_destroy(prec);
 }
 
+TEST(key_operate_prepared , "operate prepared operations on multiple keys")
+{
+	as_error err;
+
+	as_operations ops;
+	as_operations_inita(&ops, 3);
+	as_operations_add_incr(&ops, "i", 5);
+	as_operations_add_write_str(&ops, "s", "prepared");
+	as_operations_add_read(&ops, "i");
+
+	as_prepared_operate prep;
+	as_status status = as_prepared_operate_init(as, &err, &prep, NULL, &ops);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	// Operations are serialized, so they can be destroyed before use.
+	as_operations_destroy(&ops);
+
+	for (int i = 0; i < 10; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, 1000 + i);
+		aerospike_key_remove(as, &err, NULL, &key);
+
+		as_record* prec = NULL;
+		status = aerospike_key_operate_prepared(as, &err, &prep, &key, AS_RECORD_DEFAULT_TTL, 0,
+			&prec);
+		assert_int_eq(status, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(prec, "i", 0), 5);
+		as_record_destroy(prec);
+
+		prec = NULL;
+		status = aerospike_key_get(as, &err, NULL, &key, &prec);
+		assert_int_eq(status, AEROSPIKE_OK);
+		assert_string_eq(as_record_get_str(prec, "s"), "prepared");
+		as_record_destroy(prec);
+		as_key_destroy(&key);
+	}
+
+	as_prepared_operate_destroy(&prep);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -354,4 +394,5 @@ SUITE(key_operate, "aerospike_key_operate tests")
 	suite_add(key_operate_float);
 	suite_add(key_operate_delete);
 	suite_add(key_operate_bool);
+	suite_add(key_operate_prepared);
 }
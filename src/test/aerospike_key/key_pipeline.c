@@ -279,6 +279,60 @@ TEST(key_pipeline_put, "pipeline puts")
 	as_monitor_wait(&monitor);
 }
 
+typedef struct {
+	atf_test_result* result;
+	uint64_t succeeded;
+	uint64_t failed;
+} group_counter;
+
+static void
+group_listener(
+	as_async_write_group* group, as_async_write_group_result* result, void* udata,
+	as_event_loop* event_loop
+	)
+{
+	group_counter* gc = udata;
+	gc->succeeded = result->succeeded;
+	gc->failed = result->failed;
+
+	if (result->n_errors > 0) {
+		set_error(&result->errors[0], gc->result);
+	}
+	as_monitor_notify(&monitor);
+}
+
+TEST(key_pipeline_put_group, "pipeline puts with aggregated completion")
+{
+	as_monitor_begin(&monitor);
+
+	group_counter gc = {.result = __result__};
+	as_async_write_group* group = as_async_write_group_create(5, group_listener, &gc);
+	as_event_loop* event_loop = as_event_loop_get();
+
+	as_key key;
+	char key_buf[64];
+	as_record rec;
+	as_error err;
+
+	for (uint32_t i = 0; i < 10; i++) {
+		sprintf(key_buf, "pgroup%u", i);
+		as_key_init(&key, NAMESPACE, SET, key_buf);
+
+		as_record_inita(&rec, 1);
+		as_record_set_int64(&rec, "a", i);
+		aerospike_key_put_group_async(as, &err, NULL, &key, &rec, group, event_loop,
+			pipeline_noop);
+		as_record_destroy(&rec);
+	}
+	as_async_write_group_flush(group);
+
+	as_monitor_wait(&monitor);
+	assert_int_eq(as_async_write_group_pending(group), 0);
+	as_async_write_group_destroy(group);
+	assert_int_eq(gc.succeeded, 10);
+	assert_int_eq(gc.failed, 0);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -289,4 +343,5 @@ SUITE(key_pipeline, "aerospike pipeline tests")
 	suite_after(after);
 
     suite_add(key_pipeline_put);
+    suite_add(key_pipeline_put_group);
 }
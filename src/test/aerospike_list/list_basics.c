@@ -1660,6 +1660,78 @@ TEST(list_nested_map, "Nested List Map")
 	as_record_destroy(prec);
 }
 
+TEST(list_ctx_freeze, "Frozen Nested List ctx")
+{
+	as_key rkey;
+	as_key_init_int64(&rkey, NAMESPACE, SET, 110);
+
+	as_arraylist l1;
+	as_arraylist_inita(&l1, 2);
+	as_arraylist_append_int64(&l1, 1);
+	as_arraylist_append_int64(&l1, 2);
+
+	as_arraylist l2;
+	as_arraylist_inita(&l2, 3);
+	as_arraylist_append_int64(&l2, 3);
+	as_arraylist_append_int64(&l2, 4);
+	as_arraylist_append_int64(&l2, 5);
+
+	as_arraylist item_list;
+	as_arraylist_inita(&item_list, 2);
+	as_arraylist_append(&item_list, (as_val*)&l1);
+	as_arraylist_append(&item_list, (as_val*)&l2);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_list(&rec, BIN_NAME, (as_list*)&item_list);
+
+	as_error err;
+	as_status status = aerospike_key_put(as, &err, NULL, &rkey, &rec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(&rec);
+
+	as_cdt_ctx ctx;
+	as_cdt_ctx_inita(&ctx, 1);
+	as_cdt_ctx_add_list_index(&ctx, -1);
+	assert_true(as_cdt_ctx_freeze(&ctx));
+
+	// Same frozen context is used by operations and expressions.
+	as_operations ops;
+	as_operations_inita(&ops, 3);
+
+	as_integer v;
+	as_integer_init(&v, 6);
+	as_operations_list_append(&ops, BIN_NAME, &ctx, NULL, (as_val*)&v);
+	as_operations_list_size(&ops, BIN_NAME, &ctx);
+	as_operations_list_get_by_index(&ops, BIN_NAME, &ctx, 0, AS_LIST_RETURN_VALUE);
+
+	as_record* prec = NULL;
+	status = aerospike_key_operate(as, &err, NULL, &rkey, &ops, &prec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_operations_destroy(&ops);
+
+	as_bin* results = prec->bins.entries;
+	assert_int_eq(results[0].valuep->integer.value, 4);
+	assert_int_eq(results[1].valuep->integer.value, 4);
+	assert_int_eq(results[2].valuep->integer.value, 3);
+	as_record_destroy(prec);
+
+	as_exp_build(filter,
+		as_exp_cmp_eq(as_exp_list_size(&ctx, as_exp_bin_list(BIN_NAME)), as_exp_int(4)));
+	assert_not_null(filter);
+	as_cdt_ctx_destroy(&ctx);
+
+	as_policy_read p;
+	as_policy_read_init(&p);
+	p.base.filter_exp = filter;
+
+	prec = NULL;
+	status = aerospike_key_get(as, &err, &p, &rkey, &prec);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_record_destroy(prec);
+	as_exp_destroy(filter);
+}
+
 TEST(list_ctx_create_noop, "Nested List ctx")
 {
 	as_key rkey;
@@ -2874,6 +2946,7 @@ SUITE(list_basics, "aerospike list basic tests")
 	suite_add(list_partial);
 	suite_add(list_nested);
 	suite_add(list_nested_map);
+	suite_add(list_ctx_freeze);
 	suite_add(list_ctx_create_noop);
 	suite_add(list_ctx_create);
 	suite_add(list_ctx_create_order);
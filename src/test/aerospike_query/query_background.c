@@ -29,6 +29,7 @@
 #include <aerospike/as_list.h>
 #include <aerospike/as_query.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_monitor.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_status.h>
 #include <aerospike/as_string.h>
@@ -45,6 +46,7 @@
  *****************************************************************************/
 
 extern aerospike* as;
+static as_monitor monitor;
 
 /******************************************************************************
  * MACROS
@@ -92,6 +94,8 @@ write_recs()
 static bool
 before(atf_suite * suite)
 {
+	as_monitor_init(&monitor);
+
 	if (! udf_put(LUA_FILE)) {
 		error("failure while uploading: %s", LUA_FILE);
 		return false;
@@ -122,6 +126,8 @@ before(atf_suite * suite)
 static bool
 after(atf_suite * suite)
 {
+	as_monitor_destroy(&monitor);
+
 	as_error err;
 	as_error_reset(&err);
 
@@ -177,6 +183,49 @@ TEST(query_background1, "query background1")
 	as_query_destroy(&q);
 }
 
+static void
+query_wait_listener(as_error* err, void* udata, as_event_loop* event_loop)
+{
+	assert_success_async(&monitor, err, udata);
+	as_monitor_notify(&monitor);
+}
+
+TEST(query_background_wait_async, "query background wait async")
+{
+	as_monitor_begin(&monitor);
+
+	as_query q;
+	as_query_init(&q, NAMESPACE, SET);
+
+	as_query_where_inita(&q, 1);
+	as_query_where(&q, "qebin1", as_integer_range(3, 9));
+
+	as_string str;
+	as_string_init(&str, "wait", false);
+
+	as_operations ops;
+	as_operations_inita(&ops, 1);
+	as_operations_add_write(&ops, "qebin3", (as_bin_value*)&str);
+	q.ops = &ops;
+
+	as_error err;
+	uint64_t query_id = 0;
+	as_status status = aerospike_query_background(as, &err, NULL, &q, &query_id);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	status = aerospike_query_wait_async(as, &err, NULL, &q, query_id, 50, query_wait_listener,
+		__result__, NULL);
+	as_query_destroy(&q);
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_monitor_wait(&monitor);
+
+	// Job must be done on all nodes.
+	as_job_info info;
+	status = aerospike_job_info(as, &err, NULL, "query", query_id, false, &info);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_ne(info.status, AS_JOB_STATUS_INPROGRESS);
+}
+
 static int expected_list[10] = {1,2,3,104,5,106,7,108,-1,10};
 
 typedef struct qdata_s {
@@ -490,6 +539,7 @@ SUITE(query_background, "aerospike_query_background tests")
 	suite_after(after);
 
 	suite_add(query_background1);
+	suite_add(query_background_wait_async);
 	suite_add(query_validate1);
 	suite_add(query_aggregation_double);
 	suite_add(query_operate);
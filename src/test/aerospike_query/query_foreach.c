@@ -24,6 +24,7 @@
 #include <aerospike/aerospike_key.h>
 #include <aerospike/aerospike_index.h>
 #include <aerospike/aerospike_query.h>
+#include <aerospike/as_aggregate.h>
 #include <aerospike/as_atomic.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_cluster.h>
@@ -34,6 +35,7 @@
 #include <aerospike/as_list.h>
 #include <aerospike/as_list_operations.h>
 #include <aerospike/as_query.h>
+#include <aerospike/as_query_pager.h>
 #include <aerospike/as_map.h>
 #include <aerospike/as_map_operations.h>
 #include <aerospike/as_record.h>
@@ -391,6 +393,46 @@ TEST( query_foreach_1, "count(*) where a == 'abc' (non-aggregating)" ) {
 	as_query_destroy(&q);
 }
 
+TEST( query_foreach_1_pager, "count(*) where a == 'abc' (query pager)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t count = 0;
+	uint32_t pages = 0;
+
+	as_query q;
+	as_query_init(&q, NAMESPACE, SET);
+
+	as_query_select_inita(&q, 1);
+	as_query_select(&q, "c");
+
+	as_query_where_inita(&q, 1);
+	as_query_where(&q, "a", as_string_equals("abc"));
+
+	q.max_records = 30;
+
+	as_query_pager pager;
+	as_status status = as_query_pager_init(&pager, as, &err, NULL, &q, NULL);
+	assert_int_eq( status, AEROSPIKE_OK );
+
+	while (! as_query_pager_done(&pager)) {
+		status = as_query_pager_next(&pager, &err, query_foreach_count_callback, &count);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+		pages++;
+	}
+	as_query_pager_destroy(&pager);
+
+	assert_int_eq( status, AEROSPIKE_OK );
+	assert_int_eq( count, 100 );
+	assert_true( pages >= 4 );
+
+	as_query_destroy(&q);
+}
+
 static bool query_foreach_2_callback(const as_val * v, void * udata) {
 	if ( v != NULL ) {
 		as_integer * i = as_integer_fromval(v);
@@ -429,6 +471,35 @@ TEST( query_foreach_2, "count(*) where a == 'abc' (aggregating)" ) {
 	as_query_destroy(&q);
 }
 
+TEST( query_foreach_2_validate, "count(*) where a == 'abc' (aggregating, fail on cluster change)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	int64_t count = 0;
+
+	as_query q;
+	as_query_init(&q, NAMESPACE, SET);
+
+	as_query_where_inita(&q, 1);
+	as_query_where(&q, "a", as_string_equals("abc"));
+
+	as_query_apply(&q, UDF_FILE, "count", NULL);
+
+	// Cluster stability is checked on all nodes before and on each node after the query.
+	as_policy_query p;
+	as_policy_query_init(&p);
+	p.fail_on_cluster_change = true;
+
+	if ( aerospike_query_foreach(as, &err, &p, &q, query_foreach_2_callback, &count) != AEROSPIKE_OK ) {
+		error("%s (%d) [%s:%d]", err.message, err.code, err.file, err.line);
+	}
+
+	assert_int_eq( err.code, 0 );
+	assert_int_eq( count, 100 );
+
+	as_query_destroy(&q);
+}
 
 static bool query_foreach_3_callback(const as_val * v, void * udata) {
 	if ( v != NULL ) {
@@ -471,6 +542,77 @@ TEST( query_foreach_3, "sum(e) where a == 'abc'" ) {
 	as_query_destroy(&q);
 }
 
+TEST( query_foreach_3_parallel, "sum(e) where a == 'abc' with parallel reduce" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	int64_t value = 0;
+
+	as_policy_query p;
+	as_policy_query_init(&p);
+	p.aggregate_threads = 4;
+
+	as_query q;
+	as_query_init(&q, NAMESPACE, SET);
+
+	as_query_where_inita(&q, 1);
+	as_query_where(&q, "a", as_string_equals("abc"));
+
+	as_query_apply(&q, UDF_FILE, "sum", NULL);
+
+	aerospike_query_foreach(as, &err, &p, &q, query_foreach_3_callback, &value);
+
+	if ( err.code != AEROSPIKE_OK ) {
+		 fprintf(stderr, "error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+	}
+
+	info("value: %ld", value);
+
+	assert_int_eq( err.code, AEROSPIKE_OK );
+	assert_int_eq( value, 24275 );
+
+	as_query_destroy(&q);
+}
+
+static as_val* query_foreach_sum_merge(as_val * v1, as_val * v2, void * udata) {
+	int64_t sum = as_integer_get(as_integer_fromval(v1)) + as_integer_get(as_integer_fromval(v2));
+	as_val_destroy(v1);
+	as_val_destroy(v2);
+	return (as_val *) as_integer_new(sum);
+}
+
+TEST( query_foreach_3_native, "sum(e) where a == 'abc' with native merge" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	int64_t value = 0;
+
+	as_query q;
+	as_query_init(&q, NAMESPACE, SET);
+
+	as_query_where_inita(&q, 1);
+	as_query_where(&q, "a", as_string_equals("abc"));
+
+	as_query_apply(&q, UDF_FILE, "sum", NULL);
+
+	as_aggregate_register(UDF_FILE, "sum", query_foreach_sum_merge, NULL);
+	aerospike_query_foreach(as, &err, NULL, &q, query_foreach_3_callback, &value);
+	as_aggregate_unregister(UDF_FILE, "sum");
+
+	if ( err.code != AEROSPIKE_OK ) {
+		 fprintf(stderr, "error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+	}
+
+	info("value: %ld", value);
+
+	assert_int_eq( err.code, AEROSPIKE_OK );
+	assert_int_eq( value, 24275 );
+
+	as_query_destroy(&q);
+}
+
 static bool query_foreach_4_callback(const as_val * v, void * udata) {
 	if ( v != NULL ) {
 		as_integer * result = as_integer_fromval(v);
@@ -1518,6 +1660,25 @@ TEST( query_foreach_int_with_double_bin, "test query on double behavior" ) {
 
 	pthread_mutex_destroy(&udata.lock);
 
+	// Aggregate more values than fit in one stream batch, on one and several reducers.
+	for ( uint32_t threads = 1; threads <= 4; threads += 3 ) {
+		as_policy_query p;
+		as_policy_query_init(&p);
+		p.aggregate_threads = threads;
+
+		as_query_init(&q, NAMESPACE, SET);
+		as_query_where_inita(&q, 1);
+		as_query_where(&q, int_bin, as_integer_range(1, n_recs));
+		as_query_apply(&q, UDF_FILE, "count", NULL);
+
+		int64_t count = 0;
+		aerospike_query_foreach(as, &err, &p, &q, query_foreach_2_callback, &count);
+		as_query_destroy(&q);
+
+		assert_int_eq( err.code, AEROSPIKE_OK );
+		assert_int_eq( count, n_recs );
+	}
+
 	aerospike_index_remove(as, &err, NULL, NAMESPACE, "idx_test_int_bin");
 	if ( err.code != AEROSPIKE_OK ) {
 		info("error(%d): %s", err.code, err.message);
@@ -1558,8 +1719,12 @@ SUITE( query_foreach, "aerospike_query_foreach tests" ) {
 	}
 
 	suite_add( query_foreach_1 );
+	suite_add( query_foreach_1_pager );
 	suite_add( query_foreach_2 );
+	suite_add( query_foreach_2_validate );
 	suite_add( query_foreach_3 );
+	suite_add( query_foreach_3_parallel );
+	suite_add( query_foreach_3_native );
 	suite_add( query_foreach_4 );
 	suite_add( query_foreach_5 );
 	suite_add( query_foreach_6 );
@@ -17,6 +17,9 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/aerospike_scan.h>
+#include <aerospike/as_async_cancel.h>
+#include <aerospike/as_async_flow.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_cluster.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_monitor.h>
@@ -458,6 +461,175 @@ TEST(scan_async_set1_concurrent, "async scan "SET1" concurrently")
 	info("Got %d records in the concurrent scan. Expected %d", check.count, NUM_RECS_SET1);
 }
 
+TEST(scan_async_set1_flow, "async scan "SET1" with flow control")
+{
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL },
+	};
+
+	as_async_flow* flow = as_async_flow_create(2, 10);
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.flow = flow;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_monitor_begin(&monitor);
+	
+	as_error err;
+	as_status status = aerospike_scan_async(as, &err, &p, &scan, 0, scan_listener, &check, 0);
+	as_scan_destroy(&scan);
+
+	if (status != AEROSPIKE_OK) {
+		as_async_flow_destroy(flow);
+	}
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	// Consume records slowly from this thread, so the scan pauses at the high watermark.
+	while (as_load_uint32((uint32_t*)&check.count) < NUM_RECS_SET1 && ! check.failed) {
+		as_sleep(10);
+		as_async_flow_release(flow, as_async_flow_buffered(flow));
+	}
+
+	// Release remaining records, so paused commands can read the end of scan.
+	as_async_flow_release(flow, as_async_flow_buffered(flow));
+	as_monitor_wait(&monitor);
+	as_async_flow_destroy(flow);
+
+	assert_false(check.failed);
+	assert_int_eq( check.count, NUM_RECS_SET1);
+	info("Got %d records in the flow controlled scan. Expected %d", check.count, NUM_RECS_SET1);
+}
+
+typedef struct scan_cancel_s {
+	as_async_cancel* cancel;
+	as_status status;
+	uint32_t count;
+	uint32_t ends;
+} scan_cancel;
+
+static bool
+scan_cancel_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	scan_cancel* sc = udata;
+
+	if (err || ! rec) {
+		sc->status = err ? err->code : AEROSPIKE_OK;
+		sc->ends++;
+		as_monitor_notify(&monitor);
+		return false;
+	}
+
+	if (++sc->count == 1) {
+		as_async_cancel_request(sc->cancel);
+	}
+	return true;
+}
+
+TEST(scan_async_set1_cancel, "async scan "SET1" cancelled by application")
+{
+	scan_cancel sc = {
+		.cancel = as_async_cancel_create(),
+		.status = AEROSPIKE_OK,
+		.count = 0,
+		.ends = 0,
+	};
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.cancel = sc.cancel;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_monitor_begin(&monitor);
+
+	as_error err;
+	as_status status = aerospike_scan_async(as, &err, &p, &scan, 0, scan_cancel_listener, &sc, 0);
+	as_scan_destroy(&scan);
+
+	if (status != AEROSPIKE_OK) {
+		as_async_cancel_destroy(sc.cancel);
+	}
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_monitor_wait(&monitor);
+
+	assert_true(as_async_cancel_requested(sc.cancel));
+	as_async_cancel_destroy(sc.cancel);
+
+	// Listener is called once with the abort, and records in flight are discarded.
+	assert_int_eq(sc.ends, 1);
+	assert_int_eq(sc.status, AEROSPIKE_ERR_CLIENT_ABORT);
+	assert_true(sc.count < NUM_RECS_SET1);
+	info("Got %u records before the scan was cancelled", sc.count);
+}
+
+typedef struct {
+	uint32_t count;
+	uint32_t ends;
+	as_status status;
+	bool same_thread;
+} scan_spread;
+
+static bool
+scan_spread_listener(as_error* err, as_record* rec, void* udata, as_event_loop* event_loop)
+{
+	scan_spread* ss = udata;
+
+	if (err || ! rec) {
+		ss->status = err ? err->code : AEROSPIKE_OK;
+		ss->ends++;
+		// Final call runs on the event loop assigned to the scan.
+		ss->same_thread = pthread_equal(pthread_self(), event_loop->thread);
+		as_monitor_notify(&monitor);
+		return false;
+	}
+
+	// Records may arrive on any event loop.
+	as_incr_uint32(&ss->count);
+	return true;
+}
+
+TEST(scan_async_set1_spread, "async scan "SET1" spread across event loops")
+{
+	scan_spread ss = {
+		.count = 0,
+		.ends = 0,
+		.status = AEROSPIKE_OK,
+		.same_thread = false
+	};
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.spread_loops = true;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_monitor_begin(&monitor);
+
+	as_error err;
+	as_status status = aerospike_scan_async(as, &err, &p, &scan, 0, scan_spread_listener, &ss, 0);
+	as_scan_destroy(&scan);
+
+	assert_int_eq(status, AEROSPIKE_OK);
+	as_monitor_wait(&monitor);
+
+	assert_int_eq(ss.status, AEROSPIKE_OK);
+	assert_int_eq(ss.ends, 1);
+	assert_true(ss.same_thread);
+	assert_int_eq(as_load_uint32(&ss.count), NUM_RECS_SET1);
+}
+
 TEST(scan_async_set1_select, "scan "SET1" and select 'bin1'")
 {
 	scan_check check = {
@@ -550,6 +722,9 @@ SUITE(scan_async, "Scan Async Tests")
 	suite_add(scan_async_null_set);
 	suite_add(scan_async_set1);
 	suite_add(scan_async_set1_concurrent);
+	suite_add(scan_async_set1_flow);
+	suite_add(scan_async_set1_cancel);
+	suite_add(scan_async_set1_spread);
 	suite_add(scan_async_set1_select);
 	suite_add(scan_async_set1_nodata);
 	suite_add(scan_async_single_node);
@@ -19,7 +19,10 @@
 #include <aerospike/aerospike_key.h>
 #include <aerospike/aerospike_info.h>
 
+#include <aerospike/as_column_batch.h>
 #include <aerospike/as_error.h>
+#include <aerospike/as_export.h>
+#include <aerospike/as_record_spill.h>
 #include <aerospike/as_status.h>
 
 #include <aerospike/as_exp.h>
@@ -30,6 +33,7 @@
 #include <aerospike/as_list.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_partition_filter.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_sleep.h>
 #include <aerospike/as_stringmap.h>
@@ -37,6 +41,8 @@
 
 #include <aerospike/as_cluster.h>
 
+#include <unistd.h>
+
 #include "../test.h"
 #include "../util/udf.h"
 
@@ -580,6 +586,513 @@ TEST( scan_basics_set1_concurrent , "scan "SET1" concurrently" ) {
 	as_scan_destroy(&scan);
 }
 
+TEST( scan_basics_set1_parse_threads , "scan "SET1" concurrently with parse threads" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.parse_threads = 2;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_status rc = aerospike_scan_foreach(as, &err, &p, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the parse threads scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+}
+
+TEST( scan_basics_set1_partition_chunk , "scan "SET1" concurrently in partition chunks" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.partition_chunk = 64;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_status rc = aerospike_scan_foreach(as, &err, &p, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the partition chunk scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+}
+
+TEST( scan_basics_set1_streams , "scan "SET1" with multiple streams per node" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.streams_per_node = 4;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	as_status rc = aerospike_scan_foreach(as, &err, &p, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the multiple stream scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+}
+
+TEST( scan_basics_lease_store , "shared memory lease store hands out and takes back chunks" ) {
+
+	as_error err;
+	as_scan_lease_store store;
+	as_status rc = as_scan_lease_store_shm(&err, &store, 0x7A5E0000 + (getpid() & 0xFFFF), 2048);
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_scan_lease a;
+	as_scan_lease b;
+	as_scan_lease c;
+	assert_int_eq( store.acquire(store.udata, 60000, &a), AS_SCAN_LEASE_GRANTED );
+	assert_int_eq( store.acquire(store.udata, 50, &b), AS_SCAN_LEASE_GRANTED );
+	assert_int_ne( a.chunk, b.chunk );
+	assert_int_eq( a.part_count, 2048 );
+	assert_null( a.cursor );
+	assert_int_eq( store.acquire(store.udata, 60000, &c), AS_SCAN_LEASE_WAIT );
+
+	// Released cursor is handed to the next holder.
+	uint8_t cursor[] = {1, 2, 3};
+	assert_true( store.release(store.udata, &a, cursor, sizeof(cursor), false) );
+	assert_int_eq( store.acquire(store.udata, 60000, &c), AS_SCAN_LEASE_GRANTED );
+	assert_int_eq( c.chunk, a.chunk );
+	assert_int_eq( c.cursor_size, sizeof(cursor) );
+	assert_true( memcmp(c.cursor, cursor, sizeof(cursor)) == 0 );
+	cf_free(c.cursor);
+	assert_false( store.renew(store.udata, &a, 60000) );
+
+	// Expired lease is taken over and the old holder can no longer release it.
+	as_sleep(100);
+	as_scan_lease d;
+	assert_int_eq( store.acquire(store.udata, 60000, &d), AS_SCAN_LEASE_GRANTED );
+	assert_int_eq( d.chunk, b.chunk );
+	assert_false( store.release(store.udata, &b, NULL, 0, true) );
+
+	assert_true( store.release(store.udata, &c, NULL, 0, true) );
+	assert_true( store.release(store.udata, &d, NULL, 0, true) );
+	assert_int_eq( store.acquire(store.udata, 60000, &a), AS_SCAN_LEASE_DONE );
+
+	as_scan_lease_store_destroy(&store);
+}
+
+TEST( scan_basics_set1_leased , "scan "SET1" in leased partition chunks" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+	as_scan_lease_store store;
+	as_status rc = as_scan_lease_store_shm(&err, &store, 0x7A5F0000 + (getpid() & 0xFFFF), 256);
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	rc = aerospike_scan_leased(as, &err, NULL, &scan, &store, 30000, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the leased scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+	as_scan_lease_store_destroy(&store);
+}
+
+TEST( scan_basics_set1_reuse_record , "scan "SET1" with reused record" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.reuse_record = true;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_status rc = aerospike_scan_foreach(as, &err, &p, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the reused record scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+}
+
+typedef struct {
+	uint32_t count;
+	uint32_t bin1_count;
+	bool failed;
+	bool done;
+} scan_raw_check;
+
+static bool
+scan_raw_callback(const as_record_raw* rec, void* udata)
+{
+	scan_raw_check* check = udata;
+
+	if (! rec) {
+		check->done = true;
+		return true;
+	}
+
+	if (! rec->digest.init) {
+		error("Expected digest in raw record");
+		check->failed = true;
+		return false;
+	}
+
+	check->count++;
+
+	as_record_raw_iterator it;
+	as_record_raw_iterator_init(&it, rec);
+
+	as_bin_raw bin;
+
+	while (as_record_raw_iterator_next(&it, &bin)) {
+		if (bin.name_len == 4 && memcmp(bin.name, "bin1", 4) == 0) {
+			as_val* val = as_bin_raw_to_val(&bin);
+
+			if (! val || as_val_type(val) != AS_INTEGER) {
+				error("Expected integer in raw bin('%s')", "bin1");
+				check->failed = true;
+			}
+			as_val_destroy(val);
+			check->bin1_count++;
+		}
+	}
+	return true;
+}
+
+TEST( scan_basics_set1_raw , "scan "SET1" with raw record callback" ) {
+
+	scan_raw_check check = {
+		.count = 0,
+		.bin1_count = 0,
+		.failed = false,
+		.done = false
+	};
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_status rc = aerospike_scan_foreach_raw(as, &err, NULL, &scan, scan_raw_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_true( check.done );
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	assert_int_eq( check.bin1_count, NUM_RECS_SET1 );
+
+	as_scan_destroy(&scan);
+}
+
+typedef struct {
+	uint32_t count;
+	uint32_t chunks;
+	bool failed;
+} scan_columns_check;
+
+static bool
+scan_columns_callback(const as_column_batch* batch, void* udata)
+{
+	scan_columns_check* check = udata;
+	const as_column* bin1 = &batch->columns[0];
+	const as_column* bin2 = &batch->columns[1];
+
+	for (uint32_t i = 0; i < batch->size; i++) {
+		if (! as_column_is_valid(bin1, i) || ! as_column_is_valid(bin2, i)) {
+			error("Expected values in row %u", i);
+			check->failed = true;
+			continue;
+		}
+
+		char expected[64];
+		int len = sprintf(expected, "str-%s-%" PRId64, SET1, ((int64_t*)bin1->values)[i]);
+		uint32_t size = bin2->offsets[i + 1] - bin2->offsets[i];
+
+		if (size != (uint32_t)len || memcmp(bin2->data + bin2->offsets[i], expected, len) != 0) {
+			error("Expected '%s' in column('%s')", expected, "bin2");
+			check->failed = true;
+		}
+	}
+	check->count += batch->size;
+	check->chunks++;
+	return true;
+}
+
+TEST( scan_basics_set1_columns , "scan "SET1" into column chunks" ) {
+
+	int64_t bin1_values[32];
+	uint8_t bin1_valid[4];
+	uint8_t bin2_valid[4];
+	uint32_t bin2_offsets[33];
+	// Small enough to deliver some chunks before they are full.
+	uint8_t bin2_data[256];
+
+	as_column columns[2] = {
+		{ .name = "bin1", .type = AS_COLUMN_INT64, .validity = bin1_valid, .values = bin1_values },
+		{ .name = "bin2", .type = AS_COLUMN_STRING, .validity = bin2_valid,
+		  .offsets = bin2_offsets, .data = bin2_data, .data_capacity = sizeof(bin2_data) }
+	};
+
+	as_error err;
+	as_column_batch batch;
+	as_status rc = as_column_batch_init(&batch, &err, columns, 2, 32);
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	scan_columns_check check = {
+		.count = 0,
+		.chunks = 0,
+		.failed = false
+	};
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	rc = aerospike_scan_columns(as, &err, NULL, &scan, &batch, scan_columns_callback, &check);
+
+	as_scan_destroy(&scan);
+	as_column_batch_destroy(&batch);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	assert_true( check.chunks >= NUM_RECS_SET1 / 32 );
+}
+
+static bool
+scan_export_read_callback(const as_record_raw* rec, void* udata)
+{
+	if (rec) {
+		(*(uint32_t*)udata)++;
+	}
+	return true;
+}
+
+TEST( scan_basics_set1_export , "export "SET1" to compressed files" ) {
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_export_config config;
+	as_export_config_init(&config, ".");
+	config.n_writers = 2;
+	config.compress = true;
+
+	as_export_stats stats;
+	as_status rc = aerospike_scan_export(as, &err, NULL, &scan, &config, &stats);
+	as_scan_destroy(&scan);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( stats.records, NUM_RECS_SET1 );
+
+	uint32_t count = 0;
+	rc = as_export_read("./export-000.dat", &err, scan_export_read_callback, &count);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	rc = as_export_read("./export-001.dat", &err, scan_export_read_callback, &count);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( count, NUM_RECS_SET1 );
+
+	remove("./export-000.dat");
+	remove("./export-000.manifest");
+	remove("./export-001.dat");
+	remove("./export-001.manifest");
+}
+
+TEST( scan_basics_set1_spill , "scan "SET1" into memory mapped spill file" ) {
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	// Small limit so records move to the file early.
+	as_record_spill spill;
+	as_record_spill_init(&spill, ".", 1024);
+
+	as_status rc = aerospike_scan_foreach_raw(as, &err, NULL, &scan,
+		as_record_spill_scan_callback, &spill);
+	as_scan_destroy(&scan);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( spill.err.code, AEROSPIKE_OK );
+	assert_int_eq( spill.n_records, NUM_RECS_SET1 );
+	assert_true( spill.spilled );
+
+	// Parsed records are encoded in the same format.
+	as_record r;
+	as_record_inita(&r, 1);
+	as_key_init_int64(&r.key, NS, SET1, 99999);
+	as_record_set_int64(&r, "bin1", 99999);
+	rc = as_record_spill_add(&spill, &err, &r);
+	as_record_destroy(&r);
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_record_spill_iterator it;
+	as_record_spill_iterator_init(&it, &spill);
+
+	as_record_raw rec;
+	uint32_t count = 0;
+	uint32_t found = 0;
+
+	while (as_record_spill_iterator_next(&it, &rec)) {
+		as_record_raw_iterator bit;
+		as_record_raw_iterator_init(&bit, &rec);
+
+		as_bin_raw bin;
+
+		while (as_record_raw_iterator_next(&bit, &bin)) {
+			if (bin.name_len == 4 && memcmp(bin.name, "bin1", 4) == 0) {
+				as_val* val = as_bin_raw_to_val(&bin);
+				assert_int_eq( as_val_type(val), AS_INTEGER );
+
+				if (as_integer_get((as_integer*)val) == 99999) {
+					found++;
+				}
+				as_val_destroy(val);
+			}
+		}
+		count++;
+	}
+	as_record_spill_destroy(&spill);
+
+	assert_int_eq( count, NUM_RECS_SET1 + 1 );
+	assert_int_eq( found, 1 );
+}
+
+TEST( scan_basics_set1_checkpoint , "scan "SET1" partitions with checkpoint file" ) {
+
+	const char* path = "scan_basics_checkpoint.bin";
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_policy_scan p;
+	as_policy_scan_init(&p);
+	p.checkpoint_file = path;
+	p.checkpoint_records = 10;
+
+	as_partition_filter pf;
+	as_partition_filter_set_all(&pf);
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_status rc = aerospike_scan_partitions(as, &err, &p, &scan, &pf, scan_check_callback,
+		&check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	as_scan_destroy(&scan);
+
+	as_partitions_status* parts_all;
+	rc = as_partitions_status_load(&parts_all, path, &err);
+	remove(path);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_true( parts_all->done );
+	assert_int_eq( parts_all->part_count, 4096 );
+
+	uint8_t* bytes;
+	uint32_t size;
+	as_partitions_status_to_bytes(parts_all, &bytes, &size);
+
+	as_partitions_status* copy = as_partitions_status_from_bytes(bytes, size);
+	cf_free(bytes);
+
+	assert_not_null( copy );
+	assert_int_eq( copy->part_count, parts_all->part_count );
+
+	for (uint32_t i = 0; i < copy->part_count; i++) {
+		as_digest* d1 = &copy->parts[i].digest;
+		as_digest* d2 = &parts_all->parts[i].digest;
+
+		assert_int_eq( d1->init, d2->init );
+
+		if (d1->init) {
+			assert_int_eq( memcmp(d1->value, d2->value, AS_DIGEST_VALUE_SIZE), 0 );
+		}
+	}
+
+	as_partitions_status_release(copy);
+	as_partitions_status_release(parts_all);
+}
+
 TEST( scan_basics_set1_select , "scan "SET1" and select 'bin1'" ) {
 
 	scan_check check = {
@@ -1381,6 +1894,17 @@ SUITE( scan_basics, "aerospike_scan basic tests" ) {
 	suite_add( scan_basics_set1 );
 	suite_add( scan_filter_set1 );
 	suite_add( scan_basics_set1_concurrent );
+	suite_add( scan_basics_set1_parse_threads );
+	suite_add( scan_basics_set1_partition_chunk );
+	suite_add( scan_basics_set1_streams );
+	suite_add( scan_basics_lease_store );
+	suite_add( scan_basics_set1_leased );
+	suite_add( scan_basics_set1_checkpoint );
+	suite_add( scan_basics_set1_reuse_record );
+	suite_add( scan_basics_set1_raw );
+	suite_add( scan_basics_set1_columns );
+	suite_add( scan_basics_set1_export );
+	suite_add( scan_basics_set1_spill );
 	suite_add( scan_basics_set1_select );
 	suite_add( scan_basics_set1_nodata );
 	suite_add( scan_basics_background );
@@ -314,6 +314,10 @@ static bool before(atf_plan* plan)
 	memcpy(&config.tls, &g_tls, sizeof(as_config_tls));
 	config.auth_mode = g_auth_mode;
 
+	// Reads only use the record and negative caches when their policy asks for it.
+	config.record_cache_max = 1000;
+	config.negative_cache_max = 1000;
+
 	as_error err;
 	as_error_reset(&err);
 
@@ -386,6 +390,7 @@ PLAN(aerospike_test)
 	plan_add(key_apply);
 	plan_add(key_apply2);
 	plan_add(key_operate);
+	plan_add(key_cache);
 	plan_add(list_basics);
 	plan_add(map_basics);
 	plan_add(map_udf);
@@ -396,6 +401,21 @@ PLAN(aerospike_test)
 	plan_add(filter_exp);
 	plan_add(exp_operate);
 	plan_add(info_basics);
+	plan_add(partition_update);
+	plan_add(node_breaker);
+	plan_add(node_timeout);
+	plan_add(bin_handle);
+	plan_add(binding);
+	plan_add(msg_index);
+	plan_add(buffer_pool);
+	plan_add(compression);
+	plan_add(conn_pool);
+	plan_add(event_internal);
+	plan_add(stats_export);
+#if !defined(_MSC_VER)
+	plan_add(socket_io);
+	plan_add(mock_node);
+#endif
 	plan_add(udf_basics);
 	plan_add(udf_types);
 	plan_add(udf_record);
@@ -153,10 +153,53 @@ TEST( udf_basics_1 , "manage udf_basics.lua" ) {
 	as_bytes_destroy(&content);
 }
 
+TEST( udf_basics_ensure , "ensure udf_basics.lua is registered" ) {
+
+	const char * filename = UDF_FILE".lua";
+
+	as_error err;
+	aerospike_udf_remove(as, &err, NULL, filename);
+	aerospike_udf_remove_wait(as, &err, NULL, filename, 100);
+
+	as_bytes content;
+	bool b = udf_readfile(LUA_FILE, &content);
+	assert_true(b);
+
+	// First call uploads.
+	bool uploaded = false;
+	as_status status = aerospike_udf_ensure(as, &err, NULL, filename, AS_UDF_TYPE_LUA, &content,
+		100, &uploaded);
+
+	assert_int_eq( status, AEROSPIKE_OK );
+	assert_true( uploaded );
+
+	// Same content is not uploaded again.
+	status = aerospike_udf_ensure(as, &err, NULL, filename, AS_UDF_TYPE_LUA, &content, 100,
+		&uploaded);
+
+	assert_int_eq( status, AEROSPIKE_OK );
+	assert_false( uploaded );
+
+	// Remove forgets the file, and the server hash is compared again.
+	aerospike_udf_remove(as, &err, NULL, filename);
+	aerospike_udf_remove_wait(as, &err, NULL, filename, 100);
+
+	status = aerospike_udf_ensure(as, &err, NULL, filename, AS_UDF_TYPE_LUA, &content, 100,
+		&uploaded);
+
+	assert_int_eq( status, AEROSPIKE_OK );
+	assert_true( uploaded );
+
+	aerospike_udf_remove(as, &err, NULL, filename);
+	aerospike_udf_remove_wait(as, &err, NULL, filename, 100);
+	as_bytes_destroy(&content);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
 
 SUITE( udf_basics, "aerospike_udf basic tests" ) {
 	suite_add( udf_basics_1 );
+	suite_add( udf_basics_ensure );
 }
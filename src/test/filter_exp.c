@@ -18,6 +18,7 @@
 #include <aerospike/aerospike_batch.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/as_exp.h>
+#include <aerospike/as_exp_eval.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_map_operations.h>
@@ -231,6 +232,187 @@ TEST(filter_get, "filter get")
 	as_exp_destroy(filter);
 }
 
+TEST(filter_cached, "filter cached")
+{
+	as_key keyA;
+	as_key keyB;
+	bool b = filter_prepare(&keyA, &keyB);
+	assert_true(b);
+
+	as_policy_read p;
+	as_policy_read_init(&p);
+
+	as_error err;
+	as_record* prec = NULL;
+
+	// Same table content returns the shared expression.
+	as_exp_build_cached(f1, NULL, 0,
+		as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_int(1)));
+	as_exp_build_cached(f2, NULL, 0,
+		as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_int(1)));
+	assert_not_null(f1);
+	assert_true(f1 == f2);
+	as_exp_release(f2);
+
+	p.base.filter_exp = f1;
+	as_status rc = aerospike_key_get(as, &err, &p, &keyA, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	as_record_destroy(prec);
+	as_exp_release(f1);
+
+	// Parameter placeholders are patched in a copy of the cached expression.
+	for (int64_t i = 1; i <= 2; i++) {
+		as_exp_param params[2] = {{.int_val = i}, {.float_val = 1.5}};
+
+		as_exp_build_cached(filter, params, 2,
+			as_exp_and(
+				as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_param_int(0)),
+				as_exp_cmp_ge(as_exp_bin_float(BString), as_exp_param_float(1))));
+		assert_not_null(filter);
+
+		p.base.filter_exp = filter;
+		prec = NULL;
+		rc = aerospike_key_get(as, &err, &p, &keyA, &prec);
+		assert_int_eq(rc, AEROSPIKE_FILTERED_OUT);
+
+		prec = NULL;
+		rc = aerospike_key_get(as, &err, &p, &keyB, &prec);
+		assert_int_eq(rc, i == 2 ? AEROSPIKE_OK : AEROSPIKE_FILTERED_OUT);
+
+		if (rc == AEROSPIKE_OK) {
+			assert_int_eq(as_record_get_int64(prec, AString, 0), 2);
+			as_record_destroy(prec);
+		}
+		as_exp_release(filter);
+	}
+
+	// Missing parameter.
+	as_exp_build_cached(f3, NULL, 0,
+		as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_param_int(0)));
+	assert_null(f3);
+}
+
+TEST(filter_client_eval, "filter evaluated by client")
+{
+	as_arraylist list;
+	as_arraylist_init(&list, 3, 0);
+	as_arraylist_append_int64(&list, 1);
+	as_arraylist_append_int64(&list, 2);
+	as_arraylist_append_int64(&list, 3);
+
+	as_hashmap map;
+	as_hashmap_init(&map, 4);
+	as_stringmap_set_int64((as_map*)&map, "k", 5);
+
+	as_record rec;
+	as_record_inita(&rec, 5);
+	as_record_set_int64(&rec, AString, 1);
+	as_record_set_double(&rec, BString, 1.1);
+	as_record_set_strp(&rec, CString, "abcde", false);
+	as_record_set_list(&rec, DString, (as_list*)&list);
+	as_record_set_map(&rec, EString, (as_map*)&map);
+	rec.ttl = AS_RECORD_NO_EXPIRE_TTL;
+
+	as_error err;
+	bool match = false;
+
+	as_exp_build(f1,
+		as_exp_and(
+			as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_int(1)),
+			as_exp_cmp_gt(as_exp_bin_float(BString), as_exp_float(1.0)),
+			as_exp_cmp_eq(as_exp_bin_str(CString), as_exp_str("abcde")),
+			as_exp_cmp_eq(as_exp_ttl(), as_exp_int(-1))));
+	assert_int_eq(as_exp_eval_filter(&err, f1, &rec, &match), AEROSPIKE_OK);
+	assert_true(match);
+	as_exp_destroy(f1);
+
+	as_exp_build(f2,
+		as_exp_cmp_eq(
+			as_exp_cond(
+				as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_int(2)), as_exp_int(10),
+				as_exp_add(as_exp_bin_int(AString), as_exp_int(2))),
+			as_exp_int(3)));
+	assert_int_eq(as_exp_eval_filter(&err, f2, &rec, &match), AEROSPIKE_OK);
+	assert_true(match);
+	as_exp_destroy(f2);
+
+	as_exp_build(f3,
+		as_exp_and(
+			as_exp_cmp_eq(as_exp_list_size(NULL, as_exp_bin_list(DString)), as_exp_int(3)),
+			as_exp_cmp_eq(
+				as_exp_list_get_by_index(NULL, AS_LIST_RETURN_VALUE, AS_EXP_TYPE_INT,
+					as_exp_int(-1), as_exp_bin_list(DString)),
+				as_exp_int(3)),
+			as_exp_cmp_eq(
+				as_exp_map_get_by_key(NULL, AS_MAP_RETURN_VALUE, AS_EXP_TYPE_INT,
+					as_exp_str("k"), as_exp_bin_map(EString)),
+				as_exp_int(5))));
+	assert_int_eq(as_exp_eval_filter(&err, f3, &rec, &match), AEROSPIKE_OK);
+	assert_true(match);
+	as_exp_destroy(f3);
+
+	// Missing bin is unknown. Unknown filters do not match unless "or" is decided.
+	as_exp_build(f4,
+		as_exp_cmp_eq(as_exp_bin_int("missing"), as_exp_int(1)));
+	assert_int_eq(as_exp_eval_filter(&err, f4, &rec, &match), AEROSPIKE_OK);
+	assert_false(match);
+	as_exp_destroy(f4);
+
+	as_exp_build(f5,
+		as_exp_or(
+			as_exp_cmp_eq(as_exp_bin_int("missing"), as_exp_int(1)),
+			as_exp_cmp_eq(as_exp_bin_int(AString), as_exp_int(1))));
+	assert_int_eq(as_exp_eval_filter(&err, f5, &rec, &match), AEROSPIKE_OK);
+	assert_true(match);
+	as_exp_destroy(f5);
+
+	// Regex must be evaluated by the server.
+	as_exp_build(f6,
+		as_exp_cmp_regex(0, "ab.*", as_exp_bin_str(CString)));
+	assert_int_eq(as_exp_eval_filter(&err, f6, &rec, &match),
+		AEROSPIKE_ERR_UNSUPPORTED_FEATURE);
+	as_exp_destroy(f6);
+
+	as_record_destroy(&rec);
+}
+
+TEST(filter_template, "filter template")
+{
+	as_key keyA;
+	as_key keyB;
+	bool b = filter_prepare(&keyA, &keyB);
+	assert_true(b);
+
+	as_exp_build_template(tmpl,
+		as_exp_cmp_gt(as_exp_bin_int(AString), as_exp_param_int(0)));
+	assert_not_null(tmpl);
+
+	as_exp_param params[1] = {{.int_val = 1}};
+	as_exp* filter = as_exp_bind(tmpl, params, 1);
+	assert_not_null(filter);
+	assert_null(as_exp_bind(tmpl, NULL, 0));
+
+	as_policy_read p;
+	as_policy_read_init(&p);
+	p.base.filter_exp = filter;
+
+	as_error err;
+	as_record* prec = NULL;
+	as_status rc = aerospike_key_get(as, &err, &p, &keyB, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	as_record_destroy(prec);
+
+	params[0].int_val = 2;
+	assert_true(as_exp_rebind(tmpl, filter, params, 1));
+
+	prec = NULL;
+	rc = aerospike_key_get(as, &err, &p, &keyB, &prec);
+	assert_int_eq(rc, AEROSPIKE_FILTERED_OUT);
+
+	as_exp_destroy(filter);
+	as_exp_template_destroy(tmpl);
+}
+
 TEST(filter_batch, "filter batch")
 {
 	as_exp_build(filter,
@@ -2803,6 +2985,9 @@ SUITE(filter_exp, "filter expression tests")
 
 	suite_add(filter_put);
 	suite_add(filter_get);
+	suite_add(filter_cached);
+	suite_add(filter_client_eval);
+	suite_add(filter_template);
 	suite_add(filter_batch);
 	suite_add(filter_delete);
 	suite_add(filter_operate);
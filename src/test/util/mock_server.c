@@ -0,0 +1,1175 @@
+/*
+ * Copyright 2008-2016 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include "mock_server.h"
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_proto.h>
+#include <aerospike/as_record.h>
+#include <citrusleaf/cf_b64.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define MOCK_PARTITIONS 4096
+#define MOCK_READ_SIZE (64 * 1024)
+
+#define BATCH_MSG_READ 0x0
+#define BATCH_MSG_REPEAT 0x1
+#define BATCH_MSG_INFO 0x2
+#define BATCH_MSG_WRITE 0xe
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct {
+	uint8_t* data;
+	size_t off;
+	size_t size;
+	size_t capacity;
+} mock_buf;
+
+typedef struct {
+	uint64_t due_ns;
+	size_t size;
+} mock_pending;
+
+typedef struct {
+	int fd;
+	bool reset;
+	mock_buf in;
+	mock_buf out;
+	mock_buf delayed;
+	mock_pending* pending;
+	uint32_t pending_head;
+	uint32_t pending_size;
+	uint32_t pending_capacity;
+} mock_conn;
+
+typedef struct mock_node_s mock_node;
+
+typedef struct {
+	mock_node* node;
+	pthread_t thread;
+	mock_conn** conns;
+	uint32_t conns_size;
+	uint32_t conns_capacity;
+	mock_fault fault;
+	uint32_t fault_gen;
+	uint64_t seed;
+} mock_worker;
+
+struct mock_node_s {
+	mock_cluster* cluster;
+	char name[20];
+	char* replicas;
+	int listener;
+	uint16_t port;
+	mock_worker* workers;
+	pthread_mutex_t fault_lock;
+	mock_fault fault;
+	uint32_t fault_gen;
+	uint32_t down;
+};
+
+struct mock_cluster_s {
+	mock_config config;
+	mock_node* nodes;
+	uint8_t* bins;
+	uint32_t bins_size;
+	uint64_t requests;
+	uint64_t commands;
+	uint64_t start_ns;
+
+	// Topology.  Partition p is owned by live node (p + offsets[p]) % n_live.
+	pthread_mutex_t topology_lock;
+	uint32_t* live;
+	uint32_t n_live;
+	uint32_t offsets[MOCK_PARTITIONS];
+	uint32_t migrate_cursor;
+	uint32_t partition_gen;
+	uint32_t peers_gen;
+
+	volatile bool running;
+};
+
+/******************************************************************************
+ * BUFFERS
+ *****************************************************************************/
+
+// Offsets stay valid until the next compaction.
+static uint8_t*
+mock_buf_reserve(mock_buf* b, size_t size)
+{
+	if (b->size + size > b->capacity) {
+		size_t capacity = b->capacity ? b->capacity : 4096;
+
+		while (capacity < b->size + size) {
+			capacity *= 2;
+		}
+		b->data = realloc(b->data, capacity);
+		b->capacity = capacity;
+	}
+	return b->data + b->size;
+}
+
+static void
+mock_buf_compact(mock_buf* b)
+{
+	if (b->off > 0) {
+		memmove(b->data, b->data + b->off, b->size - b->off);
+		b->size -= b->off;
+		b->off = 0;
+	}
+}
+
+static void
+mock_buf_append(mock_buf* b, const void* src, size_t size)
+{
+	memcpy(mock_buf_reserve(b, size), src, size);
+	b->size += size;
+}
+
+static void
+mock_buf_append_str(mock_buf* b, const char* s)
+{
+	mock_buf_append(b, s, strlen(s));
+}
+
+static size_t
+mock_proto_begin(mock_buf* b)
+{
+	size_t begin = b->size;
+	mock_buf_reserve(b, 8);
+	b->size += 8;
+	return begin;
+}
+
+static void
+mock_proto_end(mock_buf* b, size_t begin, uint8_t type)
+{
+	uint64_t proto = (b->size - begin - 8) | ((uint64_t)AS_PROTO_VERSION << 56) |
+		((uint64_t)type << 48);
+	*(uint64_t*)(b->data + begin) = cf_swap_to_be64(proto);
+}
+
+static void
+mock_msg_write(
+	mock_buf* b, uint8_t info3, uint8_t result_code, uint32_t index, const uint8_t* bins,
+	uint16_t n_bins, uint32_t bins_size
+	)
+{
+	uint8_t* p = mock_buf_reserve(b, sizeof(as_msg) + bins_size);
+	as_msg* m = (as_msg*)p;
+	m->header_sz = sizeof(as_msg);
+	m->info1 = 0;
+	m->info2 = 0;
+	m->info3 = info3;
+	m->unused = 0;
+	m->result_code = result_code;
+	m->generation = cf_swap_to_be32(1);
+	m->record_ttl = 0;
+	m->transaction_ttl = cf_swap_to_be32(index);
+	m->n_fields = 0;
+	m->n_ops = cf_swap_to_be16(n_bins);
+
+	if (bins_size) {
+		memcpy(p + sizeof(as_msg), bins, bins_size);
+	}
+	b->size += sizeof(as_msg) + bins_size;
+}
+
+/******************************************************************************
+ * INFO
+ *****************************************************************************/
+
+static void
+mock_info_value(mock_node* node, const char* name, mock_buf* b)
+{
+	mock_cluster* cluster = node->cluster;
+	char tmp[64];
+
+	if (strcmp(name, "node") == 0) {
+		mock_buf_append_str(b, node->name);
+	}
+	else if (strcmp(name, "features") == 0) {
+		mock_buf_append_str(b, "pscans;query-show;batch-any;pquery");
+	}
+	else if (strcmp(name, "partition-generation") == 0 ||
+			 strcmp(name, "rebalance-generation") == 0) {
+		snprintf(tmp, sizeof(tmp), "%u", cluster->partition_gen);
+		mock_buf_append_str(b, tmp);
+	}
+	else if (strcmp(name, "peers-generation") == 0) {
+		snprintf(tmp, sizeof(tmp), "%u", cluster->peers_gen);
+		mock_buf_append_str(b, tmp);
+	}
+	else if (strcmp(name, "partitions") == 0) {
+		snprintf(tmp, sizeof(tmp), "%u", MOCK_PARTITIONS);
+		mock_buf_append_str(b, tmp);
+	}
+	else if (strcmp(name, "replicas") == 0) {
+		mock_buf_append_str(b, node->replicas);
+	}
+	else if (strcmp(name, "build") == 0 || strcmp(name, "version") == 0) {
+		mock_buf_append_str(b, "6.0.0.0");
+	}
+	else if (strcmp(name, "cluster-name") == 0) {
+		mock_buf_append_str(b, "mock");
+	}
+	else if (strncmp(name, "service-", 8) == 0) {
+		snprintf(tmp, sizeof(tmp), "127.0.0.1:%u", node->port);
+		mock_buf_append_str(b, tmp);
+	}
+	else if (strncmp(name, "peers-", 6) == 0) {
+		mock_buf_append_str(b, "1,,[");
+		bool first = true;
+
+		for (uint32_t i = 0; i < cluster->config.n_nodes; i++) {
+			mock_node* peer = &cluster->nodes[i];
+
+			if (peer == node || peer->down) {
+				continue;
+			}
+			snprintf(tmp, sizeof(tmp), "%s[%s,,[127.0.0.1:%u]]", first ? "" : ",", peer->name,
+				peer->port);
+			mock_buf_append_str(b, tmp);
+			first = false;
+		}
+		mock_buf_append_str(b, "]");
+	}
+	// Unknown names return an empty value.
+}
+
+static void
+mock_info(mock_node* node, const char* body, size_t size, mock_buf* b)
+{
+	mock_cluster* cluster = node->cluster;
+	pthread_mutex_lock(&cluster->topology_lock);
+
+	size_t begin = mock_proto_begin(b);
+	const char* end = body + size;
+	const char* p = body;
+
+	while (p < end) {
+		const char* name = p;
+
+		while (p < end && *p != '\n') {
+			p++;
+		}
+
+		size_t len = p - name;
+		p++;
+
+		if (len == 0 || len >= 256) {
+			continue;
+		}
+
+		char tmp[256];
+		memcpy(tmp, name, len);
+		tmp[len] = 0;
+
+		mock_buf_append_str(b, tmp);
+		mock_buf_append_str(b, "\t");
+		mock_info_value(node, tmp, b);
+		mock_buf_append_str(b, "\n");
+	}
+	mock_proto_end(b, begin, AS_INFO_MESSAGE_TYPE);
+	pthread_mutex_unlock(&cluster->topology_lock);
+}
+
+/******************************************************************************
+ * MESSAGES
+ *****************************************************************************/
+
+static inline bool
+mock_returns_bins(uint8_t read_attr)
+{
+	return (read_attr & AS_MSG_INFO1_READ) && ! (read_attr & AS_MSG_INFO1_GET_NOBINDATA);
+}
+
+static const uint8_t*
+mock_skip(const uint8_t* p, const uint8_t* end, uint16_t n)
+{
+	// Skip fields or operations. Both start with a 4 byte size.
+	for (uint16_t i = 0; i < n; i++) {
+		if (! p || p + 4 > end) {
+			return NULL;
+		}
+		p += 4 + cf_swap_from_be32(*(uint32_t*)p);
+	}
+	return p <= end ? p : NULL;
+}
+
+static bool
+mock_batch(mock_cluster* cluster, const uint8_t* p, const uint8_t* end, mock_buf* b)
+{
+	// Batch field: <count:4><flags:1> then rows of <index:4><digest:20><type:1>...
+	if (p + 5 > end) {
+		return false;
+	}
+
+	uint32_t n_rows = cf_swap_from_be32(*(uint32_t*)p);
+	p += 5;
+
+	size_t begin = mock_proto_begin(b);
+	bool bins = false;
+
+	for (uint32_t i = 0; i < n_rows; i++) {
+		if (p + 25 > end) {
+			return false;
+		}
+
+		uint32_t index = cf_swap_from_be32(*(uint32_t*)p);
+		p += 24;
+		uint8_t type = *p++;
+
+		switch (type) {
+			case BATCH_MSG_REPEAT:
+				break;
+
+			case BATCH_MSG_READ:
+				if (p + 5 > end) {
+					return false;
+				}
+				bins = mock_returns_bins(p[0]);
+				p += 1;
+				break;
+
+			case BATCH_MSG_INFO:
+				if (p + 7 > end) {
+					return false;
+				}
+				bins = mock_returns_bins(p[0]);
+				p += 3;
+				break;
+
+			case BATCH_MSG_WRITE:
+				if (p + 13 > end) {
+					return false;
+				}
+				bins = mock_returns_bins(p[0]);
+				p += 9;
+				break;
+
+			default:
+				return false;
+		}
+
+		if (type != BATCH_MSG_REPEAT) {
+			uint16_t n_fields = cf_swap_from_be16(*(uint16_t*)p);
+			uint16_t n_ops = cf_swap_from_be16(*(uint16_t*)(p + 2));
+			p = mock_skip(p + 4, end, n_fields);
+			p = mock_skip(p, end, n_ops);
+
+			if (! p) {
+				return false;
+			}
+		}
+
+		if (bins) {
+			mock_msg_write(b, 0, AEROSPIKE_OK, index, cluster->bins, 1, cluster->bins_size);
+		}
+		else {
+			mock_msg_write(b, 0, AEROSPIKE_OK, index, NULL, 0, 0);
+		}
+	}
+
+	mock_msg_write(b, AS_MSG_INFO3_LAST, AEROSPIKE_OK, 0, NULL, 0, 0);
+	mock_proto_end(b, begin, AS_MESSAGE_TYPE);
+	return true;
+}
+
+static bool
+mock_message(mock_cluster* cluster, const uint8_t* body, size_t size, mock_buf* b)
+{
+	if (size < sizeof(as_msg)) {
+		return false;
+	}
+
+	const as_msg* m = (const as_msg*)body;
+	const uint8_t* end = body + size;
+	const uint8_t* p = body + m->header_sz;
+	uint16_t n_fields = cf_swap_from_be16(m->n_fields);
+	bool has_digest = false;
+
+	for (uint16_t i = 0; i < n_fields; i++) {
+		if (p + 5 > end) {
+			return false;
+		}
+
+		uint32_t field_size = cf_swap_from_be32(*(uint32_t*)p);
+		uint8_t type = p[4];
+
+		if (field_size == 0 || p + 4 + field_size > end) {
+			return false;
+		}
+
+		if (type == AS_FIELD_BATCH_INDEX) {
+			return mock_batch(cluster, p + 5, p + 4 + field_size, b);
+		}
+
+		if (type == AS_FIELD_DIGEST) {
+			has_digest = true;
+		}
+		p += 4 + field_size;
+	}
+
+	size_t begin = mock_proto_begin(b);
+
+	if (! has_digest) {
+		// Scans, queries and other multi-record commands are not supported.
+		mock_msg_write(b, AS_MSG_INFO3_LAST, AEROSPIKE_ERR_UNSUPPORTED_FEATURE, 0, NULL, 0, 0);
+	}
+	else if (mock_returns_bins(m->info1)) {
+		mock_msg_write(b, 0, AEROSPIKE_OK, 0, cluster->bins, 1, cluster->bins_size);
+	}
+	else {
+		mock_msg_write(b, 0, AEROSPIKE_OK, 0, NULL, 0, 0);
+	}
+	mock_proto_end(b, begin, AS_MESSAGE_TYPE);
+	return true;
+}
+
+/******************************************************************************
+ * FAULTS
+ *****************************************************************************/
+
+static inline bool
+mock_fault_active(const mock_fault* fault)
+{
+	return fault->delay_us || fault->stall_ms || fault->drop_rate > 0.0 ||
+		fault->reset_rate > 0.0 || fault->partial_rate > 0.0;
+}
+
+// Return uniform random number in [0, 1).
+static inline double
+mock_random(mock_worker* worker)
+{
+	uint64_t x = worker->seed;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	worker->seed = x;
+	return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline bool
+mock_fault_hit(mock_worker* worker, double rate)
+{
+	return rate > 0.0 && mock_random(worker) < rate;
+}
+
+// Move due time to the end of a stall window.
+static uint64_t
+mock_fault_stall(const mock_fault* fault, uint64_t start_ns, uint64_t due)
+{
+	if (! fault->stall_ms || fault->stall_period_ms <= fault->stall_ms) {
+		return due;
+	}
+
+	uint64_t period = (uint64_t)fault->stall_period_ms * 1000000;
+	uint64_t stall = (uint64_t)fault->stall_ms * 1000000;
+	uint64_t phase = (due - start_ns) % period;
+	return phase >= period - stall ? due + period - phase : due;
+}
+
+static void
+mock_worker_refresh_fault(mock_worker* worker)
+{
+	mock_node* node = worker->node;
+	uint32_t gen = as_load_uint32(&node->fault_gen);
+
+	if (gen == worker->fault_gen) {
+		return;
+	}
+
+	pthread_mutex_lock(&node->fault_lock);
+	worker->fault = node->fault;
+	worker->fault_gen = node->fault_gen;
+	pthread_mutex_unlock(&node->fault_lock);
+}
+
+/******************************************************************************
+ * CONNECTIONS
+ *****************************************************************************/
+
+static void
+mock_conn_destroy(mock_conn* conn)
+{
+	if (conn->reset) {
+		// Close with RST instead of FIN.
+		struct linger linger = {1, 0};
+		setsockopt(conn->fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+	}
+	close(conn->fd);
+	free(conn->in.data);
+	free(conn->out.data);
+	free(conn->delayed.data);
+	free(conn->pending);
+	free(conn);
+}
+
+static void
+mock_conn_delay(mock_conn* conn, uint64_t due_ns, size_t size)
+{
+	if (conn->pending_size == conn->pending_capacity) {
+		// Compact and grow ring.
+		uint32_t capacity = conn->pending_capacity ? conn->pending_capacity * 2 : 64;
+		mock_pending* pending = malloc(sizeof(mock_pending) * capacity);
+
+		for (uint32_t i = 0; i < conn->pending_size; i++) {
+			pending[i] = conn->pending[(conn->pending_head + i) % conn->pending_capacity];
+		}
+		free(conn->pending);
+		conn->pending = pending;
+		conn->pending_head = 0;
+		conn->pending_capacity = capacity;
+	}
+
+	uint32_t i = (conn->pending_head + conn->pending_size) % conn->pending_capacity;
+	conn->pending[i].due_ns = due_ns;
+	conn->pending[i].size = size;
+	conn->pending_size++;
+}
+
+// Move responses whose latency expired to the output buffer. Return due time of the next
+// pending response or zero.
+static uint64_t
+mock_conn_release(mock_conn* conn, uint64_t now)
+{
+	while (conn->pending_size > 0) {
+		mock_pending* pending = &conn->pending[conn->pending_head];
+
+		if (pending->due_ns > now) {
+			return pending->due_ns;
+		}
+
+		mock_buf_append(&conn->out, conn->delayed.data + conn->delayed.off, pending->size);
+		conn->delayed.off += pending->size;
+		conn->pending_head = (conn->pending_head + 1) % conn->pending_capacity;
+		conn->pending_size--;
+	}
+	return 0;
+}
+
+static bool
+mock_conn_process(mock_worker* worker, mock_conn* conn)
+{
+	mock_node* node = worker->node;
+	mock_cluster* cluster = node->cluster;
+	const mock_fault* fault = &worker->fault;
+	uint64_t latency_ns = (uint64_t)cluster->config.latency_us * 1000;
+	bool delayed = latency_ns || mock_fault_active(fault);
+	mock_buf* in = &conn->in;
+
+	while (in->size - in->off >= sizeof(as_proto)) {
+		as_proto proto = *(as_proto*)(in->data + in->off);
+		as_proto_swap_from_be(&proto);
+
+		if (proto.version != AS_PROTO_VERSION || proto.sz > PROTO_SIZE_MAX) {
+			return false;
+		}
+
+		size_t total = sizeof(as_proto) + (size_t)proto.sz;
+
+		if (in->size - in->off < total) {
+			break;
+		}
+
+		uint8_t* body = in->data + in->off + sizeof(as_proto);
+		bool command = proto.type == AS_MESSAGE_TYPE;
+
+		if (command) {
+			as_incr_uint64(&cluster->commands);
+
+			if (mock_fault_hit(worker, fault->reset_rate)) {
+				conn->reset = true;
+				return false;
+			}
+
+			if (mock_fault_hit(worker, fault->drop_rate)) {
+				in->off += total;
+				as_incr_uint64(&cluster->requests);
+				continue;
+			}
+		}
+
+		mock_buf* b = delayed ? &conn->delayed : &conn->out;
+		mock_buf_compact(b);
+		size_t before = b->size;
+		bool ok;
+
+		switch (proto.type) {
+			case AS_INFO_MESSAGE_TYPE:
+				mock_info(node, (const char*)body, (size_t)proto.sz, b);
+				ok = true;
+				break;
+
+			case AS_MESSAGE_TYPE:
+				ok = mock_message(cluster, body, (size_t)proto.sz, b);
+				break;
+
+			default:
+				ok = false;
+				break;
+		}
+
+		if (! ok) {
+			return false;
+		}
+
+		if (delayed) {
+			uint64_t due = cf_getns() + latency_ns;
+			size_t size = b->size - before;
+
+			if (command) {
+				due = mock_fault_stall(fault, cluster->start_ns,
+					due + (uint64_t)fault->delay_us * 1000);
+
+				if (size > 1 && mock_fault_hit(worker, fault->partial_rate)) {
+					mock_conn_delay(conn, due, size / 2);
+					due += (uint64_t)fault->partial_delay_us * 1000;
+					size -= size / 2;
+				}
+			}
+			mock_conn_delay(conn, due, size);
+		}
+		in->off += total;
+		as_incr_uint64(&cluster->requests);
+	}
+	return true;
+}
+
+static bool
+mock_conn_read(mock_worker* worker, mock_conn* conn)
+{
+	mock_buf_compact(&conn->in);
+
+	while (true) {
+		uint8_t* p = mock_buf_reserve(&conn->in, MOCK_READ_SIZE);
+		ssize_t rv = recv(conn->fd, p, MOCK_READ_SIZE, 0);
+
+		if (rv > 0) {
+			conn->in.size += rv;
+			continue;
+		}
+
+		if (rv == 0) {
+			return false;
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		}
+
+		if (errno != EINTR) {
+			return false;
+		}
+	}
+	return mock_conn_process(worker, conn);
+}
+
+static bool
+mock_conn_write(mock_conn* conn)
+{
+	mock_buf* out = &conn->out;
+
+	while (out->off < out->size) {
+		ssize_t rv = send(conn->fd, out->data + out->off, out->size - out->off, MSG_NOSIGNAL);
+
+		if (rv > 0) {
+			out->off += rv;
+			continue;
+		}
+
+		if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			mock_buf_compact(out);
+			return true;
+		}
+
+		if (rv < 0 && errno == EINTR) {
+			continue;
+		}
+		return false;
+	}
+	out->off = out->size = 0;
+	return true;
+}
+
+/******************************************************************************
+ * WORKERS
+ *****************************************************************************/
+
+static void
+mock_worker_accept(mock_worker* worker)
+{
+	while (true) {
+		int fd = accept(worker->node->listener, NULL, NULL);
+
+		if (fd < 0) {
+			// Other workers of the node may accept the same connection first.
+			return;
+		}
+
+		if (as_load_uint32(&worker->node->down)) {
+			close(fd);
+			continue;
+		}
+
+		int flag = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+		mock_conn* conn = calloc(1, sizeof(mock_conn));
+		conn->fd = fd;
+
+		if (worker->conns_size == worker->conns_capacity) {
+			worker->conns_capacity = worker->conns_capacity ? worker->conns_capacity * 2 : 64;
+			worker->conns = realloc(worker->conns, sizeof(mock_conn*) * worker->conns_capacity);
+		}
+		worker->conns[worker->conns_size++] = conn;
+	}
+}
+
+static void*
+mock_worker_run(void* udata)
+{
+	mock_worker* worker = udata;
+	mock_node* node = worker->node;
+	mock_cluster* cluster = node->cluster;
+	struct pollfd* fds = NULL;
+	uint32_t fds_capacity = 0;
+
+	while (cluster->running) {
+		mock_worker_refresh_fault(worker);
+
+		// A node that is down closes its connections and refuses new ones.
+		if (as_load_uint32(&node->down)) {
+			for (uint32_t i = 0; i < worker->conns_size; i++) {
+				mock_conn_destroy(worker->conns[i]);
+			}
+			worker->conns_size = 0;
+		}
+
+		uint64_t now = cf_getns();
+		uint64_t next_due = 0;
+
+		if (fds_capacity < worker->conns_size + 1) {
+			fds_capacity = (worker->conns_size + 1) * 2;
+			fds = realloc(fds, sizeof(struct pollfd) * fds_capacity);
+		}
+
+		fds[0].fd = node->listener;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+
+		for (uint32_t i = 0; i < worker->conns_size; i++) {
+			mock_conn* conn = worker->conns[i];
+			uint64_t due = mock_conn_release(conn, now);
+
+			if (due && (next_due == 0 || due < next_due)) {
+				next_due = due;
+			}
+
+			fds[i + 1].fd = conn->fd;
+			fds[i + 1].events = POLLIN | (conn->out.off < conn->out.size ? POLLOUT : 0);
+			fds[i + 1].revents = 0;
+		}
+
+		// Wake up for the next delayed response or to check for shutdown.
+		int timeout_ms = 100;
+
+		if (next_due) {
+			timeout_ms = (int)((next_due - now + 999999) / 1000000);
+		}
+
+		uint32_t n_fds = worker->conns_size + 1;
+
+		if (poll(fds, n_fds, timeout_ms) < 0 && errno != EINTR) {
+			break;
+		}
+
+		// Iterate backwards, so closed connections can be replaced by the last connection.
+		for (uint32_t i = n_fds - 1; i > 0; i--) {
+			mock_conn* conn = worker->conns[i - 1];
+			bool ok = true;
+
+			if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+				ok = mock_conn_read(worker, conn);
+			}
+
+			if (ok) {
+				mock_conn_release(conn, cf_getns());
+				ok = mock_conn_write(conn);
+			}
+
+			if (! ok) {
+				mock_conn_destroy(conn);
+				worker->conns[i - 1] = worker->conns[--worker->conns_size];
+			}
+		}
+
+		if (fds[0].revents & POLLIN) {
+			mock_worker_accept(worker);
+		}
+	}
+
+	for (uint32_t i = 0; i < worker->conns_size; i++) {
+		mock_conn_destroy(worker->conns[i]);
+	}
+	free(worker->conns);
+	free(fds);
+	return NULL;
+}
+
+/******************************************************************************
+ * NODES
+ *****************************************************************************/
+
+static int
+mock_listen(uint16_t port, uint16_t* actual)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	int flag = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t len = sizeof(addr);
+
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 1024) < 0 ||
+		getsockname(fd, (struct sockaddr*)&addr, &len) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	*actual = ntohs(addr.sin_port);
+	return fd;
+}
+
+static void
+mock_bitmap_encode(mock_cluster* cluster, uint32_t live_index, uint32_t replica, char* out)
+{
+	// Partition p is owned by live node (p + offsets[p] + replica) % n_live.
+	uint8_t bitmap[MOCK_PARTITIONS / 8];
+	memset(bitmap, 0, sizeof(bitmap));
+
+	for (uint32_t p = 0; p < MOCK_PARTITIONS; p++) {
+		if ((p + cluster->offsets[p] + replica) % cluster->n_live == live_index) {
+			bitmap[p >> 3] |= 0x80 >> (p & 7);
+		}
+	}
+
+	cf_b64_encode(bitmap, sizeof(bitmap), out);
+	out[cf_b64_encoded_len(sizeof(bitmap))] = 0;
+}
+
+static void
+mock_ns_name(const mock_config* config, uint32_t index, char* ns, size_t size)
+{
+	// The first namespace keeps the configured name.
+	if (index == 0) {
+		snprintf(ns, size, "%s", config->ns);
+	}
+	else {
+		snprintf(ns, size, "%s%u", config->ns, index);
+	}
+}
+
+static char*
+mock_replicas_create(mock_cluster* cluster, uint32_t live_index)
+{
+	// <ns>:<regime>,<count>,<master bitmap>[,<prole bitmap>]; with the same ownership in
+	// every namespace.
+	char master[cf_b64_encoded_len(MOCK_PARTITIONS / 8) + 1];
+	char prole[sizeof(master)];
+	uint32_t count = cluster->n_live > 1 ? 2 : 1;
+
+	mock_bitmap_encode(cluster, live_index, 0, master);
+
+	if (count > 1) {
+		mock_bitmap_encode(cluster, live_index, 1, prole);
+	}
+
+	mock_buf b = {0};
+
+	for (uint32_t n = 0; n < cluster->config.n_namespaces; n++) {
+		char ns[64];
+		char tmp[96];
+		mock_ns_name(&cluster->config, n, ns, sizeof(ns));
+		snprintf(tmp, sizeof(tmp), "%s:0,%u,", ns, count);
+		mock_buf_append_str(&b, tmp);
+		mock_buf_append_str(&b, master);
+
+		if (count > 1) {
+			mock_buf_append_str(&b, ",");
+			mock_buf_append_str(&b, prole);
+		}
+		mock_buf_append_str(&b, ";");
+	}
+	mock_buf_append(&b, "", 1);
+	return (char*)b.data;
+}
+
+// Rebuild partition maps of all nodes. Called with topology lock held.
+static void
+mock_topology_update(mock_cluster* cluster)
+{
+	cluster->n_live = 0;
+
+	for (uint32_t i = 0; i < cluster->config.n_nodes; i++) {
+		if (! cluster->nodes[i].down) {
+			cluster->live[cluster->n_live++] = i;
+		}
+	}
+
+	for (uint32_t i = 0; i < cluster->config.n_nodes; i++) {
+		free(cluster->nodes[i].replicas);
+		cluster->nodes[i].replicas = NULL;
+	}
+
+	for (uint32_t k = 0; k < cluster->n_live; k++) {
+		mock_node* node = &cluster->nodes[cluster->live[k]];
+		node->replicas = mock_replicas_create(cluster, k);
+	}
+
+	// Down nodes report empty partition maps if they are still reached.
+	for (uint32_t i = 0; i < cluster->config.n_nodes; i++) {
+		if (! cluster->nodes[i].replicas) {
+			cluster->nodes[i].replicas = strdup("");
+		}
+	}
+	cluster->partition_gen++;
+}
+
+static void
+mock_bins_create(mock_cluster* cluster)
+{
+	// Reads return one bin in wire format.
+	as_record rec;
+	as_record_inita(&rec, 1);
+
+	uint8_t* blob = NULL;
+
+	if (cluster->config.value_size) {
+		blob = calloc(1, cluster->config.value_size);
+		as_record_set_raw(&rec, "bin", blob, cluster->config.value_size);
+	}
+	else {
+		as_record_set_int64(&rec, "bin", 1);
+	}
+
+	as_bin* bin = &rec.bins.entries[0];
+	size_t size = as_command_bin_size(bin, NULL);
+	cluster->bins = malloc(size);
+
+	uint8_t* p = as_command_write_bin(cluster->bins, AS_OPERATOR_READ, bin, NULL);
+	cluster->bins_size = (uint32_t)(p - cluster->bins);
+
+	as_record_destroy(&rec);
+	free(blob);
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+mock_config_init(mock_config* config)
+{
+	config->n_nodes = 1;
+	config->port = 0;
+	config->threads_per_node = 1;
+	config->latency_us = 0;
+	config->value_size = 0;
+	config->n_namespaces = 1;
+	strcpy(config->ns, "test");
+}
+
+void
+mock_fault_init(mock_fault* fault)
+{
+	memset(fault, 0, sizeof(mock_fault));
+	fault->partial_delay_us = 1000;
+}
+
+mock_cluster*
+mock_cluster_start(const mock_config* config)
+{
+	if (config->n_nodes == 0 || config->threads_per_node == 0 || config->n_namespaces == 0) {
+		return NULL;
+	}
+
+	mock_cluster* cluster = calloc(1, sizeof(mock_cluster));
+	cluster->config = *config;
+	cluster->nodes = calloc(config->n_nodes, sizeof(mock_node));
+	cluster->start_ns = cf_getns();
+	cluster->live = calloc(config->n_nodes, sizeof(uint32_t));
+	cluster->peers_gen = 1;
+	pthread_mutex_init(&cluster->topology_lock, NULL);
+	cluster->running = true;
+	mock_bins_create(cluster);
+
+	// Create all listeners first, so peers can be reported with their ports.
+	for (uint32_t i = 0; i < config->n_nodes; i++) {
+		mock_node* node = &cluster->nodes[i];
+		node->cluster = cluster;
+		snprintf(node->name, sizeof(node->name), "MOCK%03u", i);
+		pthread_mutex_init(&node->fault_lock, NULL);
+		mock_fault_init(&node->fault);
+		node->listener = mock_listen(config->port ? config->port + i : 0, &node->port);
+
+		if (node->listener < 0) {
+			cluster->config.n_nodes = i + 1;
+			mock_cluster_stop(cluster);
+			return NULL;
+		}
+	}
+	mock_topology_update(cluster);
+
+	for (uint32_t i = 0; i < config->n_nodes; i++) {
+		mock_node* node = &cluster->nodes[i];
+		node->workers = calloc(config->threads_per_node, sizeof(mock_worker));
+
+		for (uint32_t t = 0; t < config->threads_per_node; t++) {
+			node->workers[t].node = node;
+			node->workers[t].fault = node->fault;
+			node->workers[t].seed = ((uint64_t)(i + 1) << 32) | (t + 1);
+			pthread_create(&node->workers[t].thread, NULL, mock_worker_run, &node->workers[t]);
+		}
+	}
+	return cluster;
+}
+
+uint16_t
+mock_cluster_port(mock_cluster* cluster, uint32_t index)
+{
+	return cluster->nodes[index].port;
+}
+
+uint64_t
+mock_cluster_requests(mock_cluster* cluster)
+{
+	return as_load_uint64(&cluster->requests);
+}
+
+uint64_t
+mock_cluster_commands(mock_cluster* cluster)
+{
+	return as_load_uint64(&cluster->commands);
+}
+
+void
+mock_cluster_migrate(mock_cluster* cluster, uint32_t count)
+{
+	pthread_mutex_lock(&cluster->topology_lock);
+
+	// Move partitions to the next live node in a round robin over all partitions.
+	for (uint32_t i = 0; i < count; i++) {
+		cluster->offsets[cluster->migrate_cursor]++;
+		cluster->migrate_cursor = (cluster->migrate_cursor + 1) % MOCK_PARTITIONS;
+	}
+	mock_topology_update(cluster);
+	pthread_mutex_unlock(&cluster->topology_lock);
+}
+
+bool
+mock_cluster_set_node_down(mock_cluster* cluster, uint32_t index, bool down)
+{
+	pthread_mutex_lock(&cluster->topology_lock);
+
+	mock_node* node = &cluster->nodes[index];
+
+	// Keep at least one live node.
+	if (down && ! node->down && cluster->n_live == 1) {
+		pthread_mutex_unlock(&cluster->topology_lock);
+		return false;
+	}
+
+	if (node->down != (uint32_t)down) {
+		as_store_uint32(&node->down, down);
+		cluster->peers_gen++;
+		mock_topology_update(cluster);
+	}
+	pthread_mutex_unlock(&cluster->topology_lock);
+	return true;
+}
+
+void
+mock_cluster_set_fault(mock_cluster* cluster, uint32_t index, const mock_fault* fault)
+{
+	mock_node* node = &cluster->nodes[index];
+	pthread_mutex_lock(&node->fault_lock);
+	node->fault = *fault;
+	as_incr_uint32(&node->fault_gen);
+	pthread_mutex_unlock(&node->fault_lock);
+}
+
+void
+mock_cluster_stop(mock_cluster* cluster)
+{
+	cluster->running = false;
+
+	for (uint32_t i = 0; i < cluster->config.n_nodes; i++) {
+		mock_node* node = &cluster->nodes[i];
+
+		if (node->workers) {
+			for (uint32_t t = 0; t < cluster->config.threads_per_node; t++) {
+				pthread_join(node->workers[t].thread, NULL);
+			}
+			free(node->workers);
+		}
+
+		if (node->listener >= 0) {
+			close(node->listener);
+		}
+		pthread_mutex_destroy(&node->fault_lock);
+		free(node->replicas);
+	}
+	pthread_mutex_destroy(&cluster->topology_lock);
+	free(cluster->live);
+	free(cluster->nodes);
+	free(cluster->bins);
+	free(cluster);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2008-2016 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * In-process mock cluster for benchmarking and testing the client I/O stack without a server.
+ * Each node listens on 127.0.0.1 and answers the info commands used by cluster tend (node,
+ * features, peers, replicas, generations) and single record, operate and batch commands
+ * with canned responses after a configurable latency. Reads return one bin named "bin".
+ * Writes and deletes succeed without storing anything. Scans, queries, UDFs, compression,
+ * TLS and security are not supported.
+ *
+ * Faults can be injected per node to measure timeouts, retries and circuit breaking. Faults
+ * only apply to database commands, so cluster tend is not disturbed.
+ */
+
+/*****************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct mock_config_s {
+	/**
+	 * Number of nodes.
+	 */
+	uint32_t n_nodes;
+
+	/**
+	 * Port of the first node. Node i listens on port + i. Zero assigns ephemeral ports.
+	 */
+	uint16_t port;
+
+	/**
+	 * I/O threads per node.
+	 */
+	uint32_t threads_per_node;
+
+	/**
+	 * Delay before each response is sent in microseconds.
+	 */
+	uint32_t latency_us;
+
+	/**
+	 * Size of the blob value returned by reads. Zero returns an integer value.
+	 */
+	uint32_t value_size;
+
+	/**
+	 * Number of namespaces reported in the partition map. The first namespace is ns and the
+	 * others are ns1, ns2 and so on.
+	 */
+	uint32_t n_namespaces;
+
+	/**
+	 * Namespace reported in the partition map.
+	 */
+	char ns[32];
+} mock_config;
+
+/**
+ * Faults injected into the database command responses of one node.
+ */
+typedef struct mock_fault_s {
+	/**
+	 * Delay added to each response in microseconds.
+	 */
+	uint32_t delay_us;
+
+	/**
+	 * The node stops responding for stall_ms at the end of every stall_period_ms, like a
+	 * garbage collection pause. Responses due during a stall are sent when it ends.
+	 */
+	uint32_t stall_ms;
+	uint32_t stall_period_ms;
+
+	/**
+	 * Delay between the first and second half of partially sent responses in microseconds.
+	 */
+	uint32_t partial_delay_us;
+
+	/**
+	 * Fraction of commands that are never answered, like lost packets.
+	 */
+	double drop_rate;
+
+	/**
+	 * Fraction of commands answered by resetting the connection.
+	 */
+	double reset_rate;
+
+	/**
+	 * Fraction of responses that are sent in two parts, partial_delay_us apart.
+	 */
+	double partial_rate;
+} mock_fault;
+
+typedef struct mock_cluster_s mock_cluster;
+
+/*****************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+mock_config_init(mock_config* config);
+
+/**
+ * Initialize fault to no faults.
+ */
+void
+mock_fault_init(mock_fault* fault);
+
+/**
+ * Start mock nodes. Return NULL if a listener could not be created.
+ */
+mock_cluster*
+mock_cluster_start(const mock_config* config);
+
+/**
+ * Return port of node.
+ */
+uint16_t
+mock_cluster_port(mock_cluster* cluster, uint32_t index);
+
+/**
+ * Return number of info and database requests answered by all nodes.
+ */
+uint64_t
+mock_cluster_requests(mock_cluster* cluster);
+
+/**
+ * Return number of database commands received by all nodes, including dropped and reset
+ * commands. Compared with the commands issued, this is the retry amplification.
+ */
+uint64_t
+mock_cluster_commands(mock_cluster* cluster);
+
+/**
+ * Move count partitions to the next live node and increment the partition generation, like
+ * a migration. Successive calls move successive partitions.
+ */
+void
+mock_cluster_migrate(mock_cluster* cluster, uint32_t count);
+
+/**
+ * Take node down or bring it back up. A node that is down closes its connections, refuses
+ * new ones and is removed from peers and partition maps. Return false if the last live node
+ * would be taken down.
+ */
+bool
+mock_cluster_set_node_down(mock_cluster* cluster, uint32_t index, bool down);
+
+/**
+ * Replace faults of node. May be called while the cluster is running.
+ */
+void
+mock_cluster_set_fault(mock_cluster* cluster, uint32_t index, const mock_fault* fault);
+
+/**
+ * Stop nodes, close connections and free cluster.
+ */
+void
+mock_cluster_stop(mock_cluster* cluster);